@@ -0,0 +1,114 @@
+#include <cmath>
+#include <random>
+#include <benchmark/benchmark.h>
+#include <sofa/linearalgebra/FullMatrix.h>
+#include <sofa/linearalgebra/FullVector.h>
+
+#include <SoftRobots.Inverse/component/solver/modules/LCPPGSSolver.h>
+#include <SoftRobots.Inverse/component/solver/modules/LCPQPSolver.h>
+#include <SoftRobots.Inverse/component/solver/modules/NLCPSolver.h>
+
+using softrobotsinverse::solver::module::LCPPGSSolver;
+using softrobotsinverse::solver::module::LCPQPSolver;
+using softrobotsinverse::solver::module::NLCPSolver;
+using sofa::linearalgebra::FullVector;
+using sofa::linearalgebra::LPtrFullMatrix;
+
+
+namespace softrobotsinverse::benchmarks
+{
+
+/// Random contact problem of dimension dim: symmetric positive definite M = B*B^T/dim + I, and a q
+/// with negative entries (penetrations) one in two, so that about half of the contacts are active
+void setContactProblem(const unsigned int& dim, LPtrFullMatrix<double>& M, FullVector<double>& q)
+{
+    std::mt19937 generator(dim);
+    std::uniform_real_distribution<double> distribution(-1., 1.);
+
+    std::vector<double> B(dim*dim);
+    for(double& b : B)
+        b = distribution(generator);
+
+    M.resize(dim, dim);
+    q.resize(dim);
+    for(unsigned int i=0; i<dim; i++)
+    {
+        for(unsigned int j=0; j<=i; j++)
+        {
+            double m = (i==j)? 1. : 0.;
+            for(unsigned int k=0; k<dim; k++)
+                m += B[i*dim+k]*B[j*dim+k]/dim;
+            M[i][j] = m;
+            M[j][i] = m;
+        }
+        q[i] = (i%2)? std::fabs(distribution(generator)) : -std::fabs(distribution(generator));
+    }
+}
+
+
+void setContactSizes(::benchmark::internal::Benchmark* b)
+{
+    b->ArgNames({"contacts"});
+    for(int nbContacts : {4, 16, 64, 256})
+        b->Args({nbContacts});
+}
+
+
+void NLCPSolverSolve(::benchmark::State& state)
+{
+    const unsigned int dim = 3*state.range(0); // normal and two tangential directions
+    LPtrFullMatrix<double> W;
+    FullVector<double> dFree, f(dim);
+    setContactProblem(dim, W, dFree);
+
+    NLCPSolver solver;
+    solver.setAllowSliding(true);
+    for(auto _ : state)
+    {
+        f.clear();
+        solver.solve(dim, dFree.ptr(), W.lptr(), f.ptr(), 0.5, 1e-10, 1000, false);
+        ::benchmark::DoNotOptimize(f.ptr());
+    }
+}
+BENCHMARK(NLCPSolverSolve)->Apply(setContactSizes)->Unit(::benchmark::kMicrosecond);
+
+
+void LCPQPSolverSolve(::benchmark::State& state)
+{
+    const unsigned int dim = state.range(0);
+    LPtrFullMatrix<double> M;
+    FullVector<double> q, f(dim);
+    setContactProblem(dim, M, q);
+
+    LCPQPSolver solver;
+    solver.setHotStart(state.range(1));
+    for(auto _ : state)
+    {
+        solver.solve(dim, q.ptr(), M.lptr(), f.ptr());
+        ::benchmark::DoNotOptimize(f.ptr());
+    }
+}
+BENCHMARK(LCPQPSolverSolve)->ArgsProduct({{4, 16, 64, 256}, {0, 1}})->ArgNames({"contacts", "hotStart"})->Unit(::benchmark::kMicrosecond);
+
+
+void LCPPGSSolverSolve(::benchmark::State& state)
+{
+    const unsigned int dim = state.range(0);
+    LPtrFullMatrix<double> M;
+    FullVector<double> q, f(dim);
+    setContactProblem(dim, M, q);
+
+    LCPPGSSolver solver;
+    solver.setTolerance(1e-10);
+    solver.setMaxIterations(1000);
+    for(auto _ : state)
+    {
+        f.clear();
+        solver.solve(dim, q.ptr(), M.lptr(), f.ptr());
+        ::benchmark::DoNotOptimize(f.ptr());
+    }
+    state.counters["iterations"] = solver.getNbIterations();
+}
+BENCHMARK(LCPPGSSolverSolve)->Apply(setContactSizes)->Unit(::benchmark::kMicrosecond);
+
+} // namespace
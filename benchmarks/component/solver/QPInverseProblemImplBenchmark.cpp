@@ -0,0 +1,315 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <sstream>
+#include <tuple>
+#include <utility>
+#include <benchmark/benchmark.h>
+
+#include "SyntheticInverseProblem.h"
+
+
+namespace softrobotsinverse::benchmarks
+{
+
+void setCounters(::benchmark::State& state, SyntheticInverseProblem& problem)
+{
+    state.counters["dim"] = problem.getQPSystem()->dim;
+    state.counters["rows"] = problem.getNbRows();
+}
+
+
+void buildQPMatrices(::benchmark::State& state)
+{
+    SyntheticInverseProblem problem;
+    problem.set(state.range(0), state.range(1), state.range(2));
+
+    for(auto _ : state)
+    {
+        problem.buildQPMatrices();
+        ::benchmark::DoNotOptimize(problem.getQPSystem()->Q.data());
+    }
+    setCounters(state, problem);
+}
+BENCHMARK(buildQPMatrices)->Apply(setProblemSizes);
+
+
+void computeEnergyWeight(::benchmark::State& state)
+{
+    SyntheticInverseProblem problem;
+    problem.set(state.range(0), state.range(1), state.range(2));
+    problem.buildQPMatrices();
+
+    double weight = 0.;
+    for(auto _ : state)
+    {
+        problem.computeEnergyWeight(weight);
+        ::benchmark::DoNotOptimize(weight);
+    }
+    setCounters(state, problem);
+}
+BENCHMARK(computeEnergyWeight)->Apply(setProblemSizes);
+
+
+void buildInequalityConstraintMatrices(::benchmark::State& state)
+{
+    SyntheticInverseProblem problem;
+    problem.set(state.range(0), state.range(1), state.range(2));
+    problem.buildQPMatrices();
+
+    for(auto _ : state)
+    {
+        problem.buildInequalityConstraintMatrices();
+        ::benchmark::DoNotOptimize(problem.getQPSystem()->A.data());
+    }
+    setCounters(state, problem);
+    state.counters["inequalities"] = problem.getQPSystem()->A.size();
+}
+BENCHMARK(buildInequalityConstraintMatrices)->Apply(setProblemSizes);
+
+
+void buildEqualityConstraintMatrices(::benchmark::State& state)
+{
+    SyntheticInverseProblem problem;
+    problem.set(state.range(0), state.range(1), state.range(2));
+    problem.buildQPMatrices();
+
+    for(auto _ : state)
+    {
+        problem.buildEqualityConstraintMatrices();
+        ::benchmark::DoNotOptimize(problem.getQPSystem()->Aeq.data());
+    }
+    setCounters(state, problem);
+    state.counters["equalities"] = problem.getQPSystem()->Aeq.size();
+}
+BENCHMARK(buildEqualityConstraintMatrices)->Apply(setProblemSizes);
+
+
+void solveInverseProblem(::benchmark::State& state)
+{
+    SyntheticInverseProblem problem;
+    problem.set(state.range(0), state.range(1), state.range(2));
+    problem.buildSystem();
+
+    double objective = 0.;
+    vector<double> result, dual;
+    for(auto _ : state)
+    {
+        problem.solveQP(objective, result, dual);
+        ::benchmark::DoNotOptimize(result.data());
+    }
+    setCounters(state, problem);
+    state.counters["iterations"] = problem.getNbQPIterations();
+}
+BENCHMARK(solveInverseProblem)->Apply(setProblemSizes)->Unit(::benchmark::kMicrosecond);
+
+
+/// Arguments of the energy approximation benchmark: {actuators, effectors, contacts, approximation}
+void setEnergyApproximationSizes(::benchmark::internal::Benchmark* b)
+{
+    b->ArgNames({"actuators", "effectors", "contacts", "approximation"});
+    for(int approximation : {0, 1, 2})
+    {
+        b->Args({8, 8, 0, approximation});
+        b->Args({32, 32, 0, approximation});
+        b->Args({32, 32, 64, approximation});
+        b->Args({128, 128, 0, approximation});
+    }
+}
+
+
+/// Assembly of Q with the energy term approximated (0 Full, 1 BlockDiagonal, 2 Diagonal), with the
+/// density of Q and the relative distance of the QP solution to the one with the full energy term
+void energyApproximation(::benchmark::State& state)
+{
+    static const char* names[] = {"Full", "BlockDiagonal", "Diagonal"};
+    const std::string name = names[state.range(3)];
+
+    double objective = 0.;
+    vector<double> reference, result, dual;
+    SyntheticInverseProblem fullProblem;
+    fullProblem.set(state.range(0), state.range(1), state.range(2));
+    fullProblem.setEpsilon(1e-3);
+    fullProblem.buildSystem();
+    fullProblem.solveQP(objective, reference, dual);
+
+    SyntheticInverseProblem problem;
+    problem.set(state.range(0), state.range(1), state.range(2));
+    problem.setEpsilon(1e-3);
+    problem.setEnergyApproximation(name);
+    for(auto _ : state)
+    {
+        problem.buildQPMatrices();
+        ::benchmark::DoNotOptimize(problem.getQPSystem()->Q.data());
+    }
+
+    problem.buildSystem();
+    problem.solveQP(objective, result, dual);
+    double error = 0., norm = 0.;
+    for(unsigned int i=0; i<result.size() && i<reference.size(); i++)
+    {
+        error += (result[i]-reference[i])*(result[i]-reference[i]);
+        norm += reference[i]*reference[i];
+    }
+
+    const unsigned int dim = problem.getQPSystem()->dim;
+    unsigned int nbNonZeros = 0;
+    for(unsigned int i=0; i<dim*dim; i++)
+        nbNonZeros += (problem.getQPSystem()->Q.data()[i] != 0.);
+
+    setCounters(state, problem);
+    state.counters["QDensity"] = (dim>0)? double(nbNonZeros)/(dim*dim) : 0.;
+    state.counters["relativeError"] = (norm>0.)? std::sqrt(error/norm) : std::sqrt(error);
+    state.SetLabel(name);
+}
+BENCHMARK(energyApproximation)->Apply(setEnergyApproximationSizes);
+
+
+/// Arguments of the storage policy benchmark: {actuators, effectors, contacts, policy}, the largest
+/// problems having a QP matrix and a block of the compliance of several huge pages
+void setStoragePolicySizes(::benchmark::internal::Benchmark* b)
+{
+    b->ArgNames({"actuators", "effectors", "contacts", "policy"});
+    for(int policy : {0, 1, 2, 3})
+    {
+        b->Args({32, 32, 64, policy});
+        b->Args({128, 128, 256, policy});
+        b->Args({256, 256, 512, policy});
+    }
+}
+
+
+/// Assembly of Q, W(x, x) being gathered at each call, with the dense buffers allocated with the storage
+/// policy (0 Default, 1 Aligned, 2 TransparentHugePages, 3 HugePages)
+void storagePolicy(::benchmark::State& state)
+{
+    static const char* names[] = {"Default", "Aligned", "TransparentHugePages", "HugePages"};
+    const std::string name = names[state.range(3)];
+    const unsigned int nbFallbacks = solver::module::QPStorage::getNbHugePageFallbacks();
+
+    SyntheticInverseProblem problem;
+    problem.set(state.range(0), state.range(1), state.range(2));
+    problem.setStoragePolicy(name);
+
+    for(auto _ : state)
+    {
+        problem.buildQPMatrices();
+        ::benchmark::DoNotOptimize(problem.getQPSystem()->Q.data());
+    }
+
+    setCounters(state, problem);
+    state.counters["QAligned"] = (reinterpret_cast<std::uintptr_t>(problem.getQPSystem()->Q.data()) % 64 == 0);
+    state.counters["hugePageFallbacks"] = solver::module::QPStorage::getNbHugePageFallbacks() - nbFallbacks;
+    state.SetLabel(name);
+}
+BENCHMARK(storagePolicy)->Apply(setStoragePolicySizes)->Unit(::benchmark::kMicrosecond);
+
+
+/// Arguments of the cost model benchmark: {backend, actuators, effectors, contacts}, the backend in the order of
+/// QPBackendSelector::Backend, its sizes being run in increasing order
+void setBackendCostModelSizes(::benchmark::internal::Benchmark* b)
+{
+    b->ArgNames({"backend", "actuators", "effectors", "contacts"});
+    for(int backend=0; backend<solver::module::QPBackendSelector::NbBackends; backend++)
+    {
+        b->Args({backend, 2, 2, 0});
+        b->Args({backend, 4, 4, 0});
+        b->Args({backend, 8, 8, 0});
+        b->Args({backend, 16, 16, 0});
+        b->Args({backend, 32, 32, 0});
+        b->Args({backend, 32, 32, 64});
+        b->Args({backend, 128, 128, 0});
+    }
+}
+
+
+/// Resolution of the QP by one method of the adaptive QP solver, with its flop estimate (see QPBackendSelector).
+/// The cases that the method did not solve itself (no interior minimizer, kernel not applicable) are skipped. The
+/// time per resolution of the solved cases of a backend is fitted as a + b*work by least squares: the label of
+/// the last size of each backend gives its coefficients, to be given in order to backendCostModel.
+void backendCostModel(::benchmark::State& state)
+{
+    typedef solver::module::QPBackendSelector QPBackendSelector;
+    // {work, time in us} by backend and size, the benchmark running a case several times
+    static std::map<int, std::map<std::tuple<int64_t, int64_t, int64_t>, std::pair<double, double>>> samples;
+    const QPBackendSelector::Backend backend = QPBackendSelector::Backend(state.range(0));
+
+    SyntheticInverseProblem problem;
+    problem.set(state.range(1), state.range(2), state.range(3));
+    problem.setInteriorFastPath(backend == QPBackendSelector::Interior);
+    problem.setSmallProblemKernel(backend == QPBackendSelector::SmallKernel);
+    problem.setQPSolver((backend == QPBackendSelector::ADMM)? "ADMM" : "qpOASES");
+    problem.buildSystem();
+
+    double objective = 0.;
+    vector<double> result, dual;
+    unsigned int nbResolutions = 0;
+    const unsigned int nbSolves = problem.getNbInteriorSolves() + problem.getNbSmallProblemSolves();
+    const auto start = std::chrono::steady_clock::now();
+    for(auto _ : state)
+    {
+        problem.solveQP(objective, result, dual);
+        ::benchmark::DoNotOptimize(result.data());
+        nbResolutions++;
+    }
+    const double time = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count()/std::max(nbResolutions, 1u);
+
+    const auto* qpSystem = problem.getQPSystem();
+    QPBackendSelector::Features features;
+    features.dim = qpSystem->dim;
+    features.nbConstraints = qpSystem->A.size() + qpSystem->Aeq.size();
+    features.nbEqualities = qpSystem->Aeq.size();
+    const size_t nbEntries = size_t(features.nbConstraints)*features.dim;
+    if(nbEntries > 0)
+    {
+        const size_t nbZeros = std::count(qpSystem->A.data(), qpSystem->A.data() + qpSystem->A.size()*qpSystem->dim, 0.)
+                               + std::count(qpSystem->Aeq.data(), qpSystem->Aeq.data() + qpSystem->Aeq.size()*qpSystem->dim, 0.);
+        features.density = double(nbEntries - nbZeros)/nbEntries;
+    }
+    const double work = QPBackendSelector::getWork(backend, features, std::max(problem.getNbQPIterations(), 1));
+
+    const bool isSolvedByFallback = (backend == QPBackendSelector::Interior || backend == QPBackendSelector::SmallKernel)
+                                    && problem.getNbInteriorSolves() + problem.getNbSmallProblemSolves() == nbSolves;
+    auto& cases = samples[backend];
+    const auto size = std::make_tuple(state.range(1), state.range(2), state.range(3));
+    if(isSolvedByFallback)
+        cases.erase(size);
+    else
+        cases[size] = std::make_pair(work, time);
+    vector<std::pair<double, double>> points;
+    for(const auto& point : cases)
+        points.push_back(point.second);
+
+    // Least squares of time = a + b*work over the cases of the backend so far
+    double meanWork = 0., meanTime = 0.;
+    for(const auto& point : points)
+    {
+        meanWork += point.first/points.size();
+        meanTime += point.second/points.size();
+    }
+    double covariance = 0., variance = 0.;
+    for(const auto& point : points)
+    {
+        covariance += (point.first - meanWork)*(point.second - meanTime);
+        variance += (point.first - meanWork)*(point.first - meanWork);
+    }
+    const double b = (variance > 0.)? std::max(covariance/variance, 0.) : 0.;
+    const double a = std::max(meanTime - b*meanWork, 0.);
+
+    std::ostringstream label;
+    label << QPBackendSelector::getName(backend);
+    if(isSolvedByFallback)
+        label << " (solved by the fallback, skipped)";
+    else if(points.size() > 1)
+        label << " a=" << a << " b=" << b;
+
+    setCounters(state, problem);
+    state.counters["work"] = work;
+    state.counters["iterations"] = problem.getNbQPIterations();
+    state.SetLabel(label.str());
+}
+BENCHMARK(backendCostModel)->Apply(setBackendCostModelSizes)->Unit(::benchmark::kMicrosecond);
+
+} // namespace
@@ -0,0 +1,13 @@
+
+list(APPEND HEADER_FILES
+
+    component/solver/SyntheticInverseProblem.h
+
+    )
+
+list(APPEND SOURCE_FILES
+
+    component/solver/LCPSolverBenchmark.cpp
+    component/solver/QPInverseProblemImplBenchmark.cpp
+
+    )
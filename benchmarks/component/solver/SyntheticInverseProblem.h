@@ -0,0 +1,151 @@
+#pragma once
+
+#include <random>
+#include <benchmark/benchmark.h>
+#include <sofa/core/objectmodel/BaseObject.h>
+#include <sofa/defaulttype/VecTypes.h>
+#include <sofa/linearalgebra/FullMatrix.h>
+#include <sofa/linearalgebra/FullVector.h>
+
+#include <SoftRobots.Inverse/component/constraint/CableActuator.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPInverseProblemImpl.h>
+
+
+namespace softrobotsinverse::benchmarks
+{
+
+using sofa::type::vector;
+using sofa::defaulttype::Vec3Types;
+
+/// Cable actuator whose limits are set directly, without scene
+class SyntheticCableActuator : public constraint::CableActuator<Vec3Types>
+{
+public:
+    SOFA_CLASS(SyntheticCableActuator, SOFA_TEMPLATE(constraint::CableActuator, Vec3Types));
+
+    void setLimits(const double& minForce, const double& maxForce, const double& maxDisplacement)
+    {
+        m_hasLambdaMin = true;
+        m_lambdaMin[0] = minForce;
+        m_hasLambdaMax = true;
+        m_lambdaMax[0] = maxForce;
+        m_hasDeltaMax = true;
+        m_deltaMax[0] = maxDisplacement;
+    }
+};
+
+
+/// Inverse problem with nbActuators cable actuators, nbEffectors effector rows and nbContacts frictionless
+/// contacts (one in two active), on a random symmetric positive definite compliance W. The problems
+/// are reproducible: the random generator is seeded with the sizes.
+class SyntheticInverseProblem : public solver::module::QPInverseProblemImpl
+{
+public:
+    using QPInverseProblemImpl::buildQPMatrices;
+    using QPInverseProblemImpl::computeEnergyWeight;
+    using QPInverseProblemImpl::solveInverseProblem;
+
+    void set(const unsigned int& nbActuators, const unsigned int& nbEffectors, const unsigned int& nbContacts)
+    {
+        const unsigned int nbRows = nbActuators + nbEffectors + nbContacts;
+        std::mt19937 generator(nbActuators*10007u + nbEffectors*101u + nbContacts);
+        std::uniform_real_distribution<double> distribution(-1., 1.);
+
+        // W = B*B^T/nbRows + I, dense as the compliance of a deformable robot
+        clear(nbRows);
+        vector<double> B(nbRows*nbRows);
+        for(double& b : B)
+            b = distribution(generator);
+        for(unsigned int i=0; i<nbRows; i++)
+        {
+            for(unsigned int j=0; j<=i; j++)
+            {
+                double w = (i==j)? 1. : 0.;
+                for(unsigned int k=0; k<nbRows; k++)
+                    w += B[i*nbRows+k]*B[j*nbRows+k]/nbRows;
+                W[i][j] = w;
+                W[j][i] = w;
+            }
+            dFree[i] = distribution(generator);
+        }
+
+        clearProblem();
+        m_actuators.clear();
+        for(unsigned int i=0; i<nbActuators; i++)
+        {
+            m_actuators.push_back(sofa::core::objectmodel::New<SyntheticCableActuator>());
+            m_actuators.back()->setLimits(0., 10., 1.);
+            m_qpCLists->actuators.push_back(m_actuators.back().get());
+            m_qpCLists->actuatorRowIds.push_back(i);
+        }
+        for(unsigned int i=0; i<nbEffectors; i++)
+            m_qpCLists->effectorRowIds.push_back(nbActuators + i);
+        for(unsigned int i=0; i<nbContacts; i++)
+            m_qpCLists->contactRowIds.push_back(nbActuators + nbEffectors + i);
+
+        m_qpCParams->mu = 0.;
+        m_qpCParams->contactNbLines = 1;
+        m_qpCParams->nbContactPoints = nbContacts;
+        m_qpCParams->contactStates.clear();
+        for(unsigned int i=0; i<nbContacts; i++)
+        {
+            if(i%2) m_qpCParams->contactStates.push_back(&m_qpCParams->inactiveContact);
+            else    m_qpCParams->contactStates.push_back(&m_qpCParams->activeContact);
+        }
+
+        m_qpSystem->dim = nbActuators + nbContacts;
+        m_qpSystem->W = getW();
+        m_qpSystem->dFree = getDfree();
+        m_qpSystem->hasBothSideInequalityConstraint = false;
+        m_qpCLists->updateVariableRows();
+        m_result.assign(m_qpSystem->dim, 0.);
+    }
+
+    /// Builds the QP matrices and the constraints, as solve() before the QP resolution
+    void buildSystem()
+    {
+        buildQPMatrices();
+        buildInequalityConstraintMatrices();
+        buildEqualityConstraintMatrices();
+        m_constraintHandler->getConstraintOnLambda(m_result, m_qpSystem, m_qpCLists);
+    }
+
+    void buildInequalityConstraintMatrices()
+    {
+        m_qpCParams->constraintsId.clear();
+        m_constraintHandler->buildInequalityConstraintMatrices(m_result, m_qpSystem, m_qpCLists);
+    }
+
+    void buildEqualityConstraintMatrices()
+    {
+        m_constraintHandler->buildEqualityConstraintMatrices(m_result, m_qpSystem, m_qpCLists);
+    }
+
+    void solveQP(double& objective, vector<double>& result, vector<double>& dual)
+    {
+        result = m_result;
+        solveInverseProblem(objective, result, dual);
+    }
+
+    /// Dimension of the constraint space (rows of W)
+    unsigned int getNbRows() const {return m_actuators.size() + m_qpCLists->effectorRowIds.size() + m_qpCLists->contactRowIds.size();}
+
+protected:
+    vector<sofa::core::sptr<SyntheticCableActuator>> m_actuators;
+    vector<double> m_result;
+};
+
+
+/// Arguments of the benchmarks: {actuators, effectors, contacts}
+inline void setProblemSizes(::benchmark::internal::Benchmark* b)
+{
+    b->ArgNames({"actuators", "effectors", "contacts"});
+    for(int nbActuators : {2, 8, 32})
+        for(int nbContacts : {0, 16, 64})
+            b->Args({nbActuators, nbActuators, nbContacts});
+    b->Args({128, 128, 0});
+    b->Args({400, 400, 0});
+    b->Args({32, 32, 256});
+}
+
+} // namespace
@@ -0,0 +1,160 @@
+# -*- coding: utf-8 -*-
+"""
+Parameterized scene to measure how QPInverseProblemSolver scales with the size of the robot.
+
+A beam clamped at one end, controlled to bring its tip to a goal, with:
+    - resolution: number of cells across the beam section (the beam has 4 times more cells along its length)
+    - nbActuators: number of CableActuator (along the beam, around its axis) or of ForceSurfaceActuator spheres
+      (on the top face), depending on actuatorType ('cable' or 'surface')
+    - nbContacts: number of points of the bottom face in contact with the floor
+    - nbEffectors: number of points of the tip face brought to their goal (3 effector rows each)
+    - mu: friction coefficient of the contacts (0 for frictionless contacts)
+
+Can be loaded in runSofa with the default parameters, and is used by runScalingBenchmark.py.
+"""
+import math
+
+length = 100.
+width = 20.
+
+
+def beamPoints(nbPoints, y, margin):
+    """nbPoints on the face at height y, spread on a grid"""
+    nbRows = max(1, int(math.sqrt(nbPoints/4.)))
+    nbColumns = int(math.ceil(nbPoints/float(nbRows)))
+    points = []
+    for i in range(nbPoints):
+        row = i // nbColumns
+        column = i % nbColumns
+        x = margin + (length - 2*margin) * (column + 0.5) / nbColumns
+        z = -width/2. + margin/4. + (width - margin/2.) * (row + 0.5) / nbRows
+        points.append([x, y, z])
+    return points
+
+
+def addCables(node, nbActuators, resolution):
+    nbCablePoints = 4*resolution
+    for i in range(nbActuators):
+        angle = 2.*math.pi*i/nbActuators
+        y = 0.35*width*math.cos(angle)
+        z = 0.35*width*math.sin(angle)
+        points = [[length*(k+1)/(nbCablePoints+1), y, z] for k in range(nbCablePoints)]
+
+        cable = node.addChild('cable' + str(i))
+        cable.addObject('MechanicalObject', position=points)
+        cable.addObject('CableActuator', template='Vec3', indices=list(range(nbCablePoints)), pullPoint=[0., y, z],
+                        maxPositiveDisp=20, minForce=0, maxForce=1e4)
+        cable.addObject('BarycentricMapping')
+
+
+def addSurfaceActuators(node, nbActuators, resolution):
+    # Quads of the top face, on which the spheres select the points where the forces are applied
+    nx = 4*resolution
+    nz = resolution
+    y = width/2.
+    positions = [[length*i/nx, y, -width/2. + width*k/nz] for i in range(nx+1) for k in range(nz+1)]
+    quads = [[i*(nz+1)+k, (i+1)*(nz+1)+k, (i+1)*(nz+1)+k+1, i*(nz+1)+k+1] for i in range(nx) for k in range(nz)]
+
+    centers = [[length*(i+1)/(nbActuators+1), y, 0.] for i in range(nbActuators)]
+    radius = max(length/(2.*(nbActuators+1)), 1.5*length/nx)
+
+    actuation = node.addChild('actuation')
+    actuation.addObject('MechanicalObject', position=positions)
+    actuation.addObject('ForceSurfaceActuator', quads=quads, centers=centers, radii=[radius]*nbActuators,
+                        directions=[[0, -1, 0]]*nbActuators, maxForce=1e3, minForce=0)
+    actuation.addObject('BarycentricMapping')
+
+
+def addContacts(rootNode, node, nbContacts):
+    floorHeight = -width/2. - 0.5
+
+    contact = node.addChild('contact')
+    contact.addObject('MechanicalObject', position=beamPoints(nbContacts, -width/2., length/10.))
+    contact.addObject('PointCollisionModel', group=1)
+    contact.addObject('BarycentricMapping')
+
+    floor = rootNode.addChild('floor')
+    floor.addObject('MechanicalObject', position=[[-length, floorHeight, -length], [2*length, floorHeight, -length],
+                                                  [2*length, floorHeight, length], [-length, floorHeight, length]])
+    floor.addObject('MeshTopology', triangles=[[0, 2, 1], [0, 3, 2]])
+    floor.addObject('TriangleCollisionModel', group=2, moving=False, simulated=False)
+
+
+def effectorPoints(nbEffectors):
+    """Points of the tip face, the first one on the axis of the beam"""
+    points = [[length, 0., 0.]]
+    for i in range(1, nbEffectors):
+        angle = 2.*math.pi*(i-1)/(nbEffectors-1)
+        points.append([length, 0.3*width*math.cos(angle), 0.3*width*math.sin(angle)])
+    return points
+
+
+def createScene(rootNode, resolution=3, nbActuators=4, actuatorType='cable', nbContacts=16, mu=0.,
+                qpSolverParams=None, nbEffectors=1):
+    rootNode.addObject('RequiredPlugin', pluginName=['SoftRobots', 'SoftRobots.Inverse',
+                                                     'Sofa.Component.AnimationLoop',
+                                                     'Sofa.Component.Collision.Detection.Algorithm',
+                                                     'Sofa.Component.Collision.Detection.Intersection',
+                                                     'Sofa.Component.Collision.Geometry',
+                                                     'Sofa.Component.Collision.Response.Contact',
+                                                     'Sofa.Component.Constraint.Lagrangian.Correction',
+                                                     'Sofa.Component.Engine.Select',
+                                                     'Sofa.Component.LinearSolver.Direct',
+                                                     'Sofa.Component.Mapping.Linear',
+                                                     'Sofa.Component.Mass',
+                                                     'Sofa.Component.ODESolver.Backward',
+                                                     'Sofa.Component.SolidMechanics.FEM.Elastic',
+                                                     'Sofa.Component.SolidMechanics.Spring',
+                                                     'Sofa.Component.StateContainer',
+                                                     'Sofa.Component.Topology.Container.Constant',
+                                                     'Sofa.Component.Topology.Container.Grid'])
+
+    rootNode.gravity = [0, -9810, 0]
+    rootNode.dt = 0.01
+
+    rootNode.addObject('FreeMotionAnimationLoop')
+    params = dict(epsilon=1e-3, maxIterations=1000, tolerance=1e-8, computeTimings=True)
+    if qpSolverParams:
+        params.update(qpSolverParams)
+    rootNode.addObject('QPInverseProblemSolver', name='QPInverseProblemSolver', **params)
+
+    if nbContacts > 0:
+        rootNode.addObject('DefaultPipeline')
+        rootNode.addObject('BruteForceBroadPhase')
+        rootNode.addObject('BVHNarrowPhase')
+        rootNode.addObject('DefaultContactManager', response='FrictionContactConstraint', responseParams='mu='+str(mu))
+        rootNode.addObject('LocalMinDistance', alarmDistance=3, contactDistance=1)
+
+    points = effectorPoints(max(1, nbEffectors))
+    goal = rootNode.addChild('goal')
+    goal.addObject('MechanicalObject', name='goalMO',
+                   position=[[x - 0.1*length, y + width/2., z + width/4.] for x, y, z in points])
+
+    n = max(1, resolution)
+    beam = rootNode.addChild('beam')
+    beam.addObject('EulerImplicitSolver', firstOrder=True)
+    beam.addObject('SparseLDLSolver', template='CompressedRowSparseMatrixMat3x3d')
+    beam.addObject('RegularGridTopology', name='grid', n=[4*n+1, n+1, n+1], min=[0., -width/2., -width/2.],
+                   max=[length, width/2., width/2.])
+    beam.addObject('MechanicalObject', name='dofs', template='Vec3')
+    beam.addObject('UniformMass', totalMass=0.1)
+    beam.addObject('HexahedronFEMForceField', method='large', poissonRatio=0.3, youngModulus=5e3)
+    beam.addObject('BoxROI', name='clamped', box=[-1, -width, -width, 1, width, width])
+    beam.addObject('RestShapeSpringsForceField', points='@clamped.indices', stiffness=1e12)
+    beam.addObject('LinearSolverConstraintCorrection')
+
+    effector = beam.addChild('effector')
+    effector.addObject('MechanicalObject', position=points)
+    effector.addObject('PositionEffector', template='Vec3', indices=list(range(len(points))),
+                       effectorGoal='@../../goal/goalMO.position')
+    effector.addObject('BarycentricMapping', mapForces=False, mapMasses=False)
+
+    if actuatorType == 'surface':
+        addSurfaceActuators(beam, nbActuators, n)
+    else:
+        addCables(beam, nbActuators, n)
+
+    if nbContacts > 0:
+        addContacts(rootNode, beam, nbContacts)
+
+    return rootNode
@@ -0,0 +1,243 @@
+# -*- coding: utf-8 -*-
+"""
+Runs ScalingScene.py for a long horizon and reports the distribution of the latency of each phase of
+QPInverseProblemSolver (data timings) and of the whole step: p50, p99, p99.9 and max, with an optional
+histogram on log-spaced bins. The mean hides the steps that miss a real-time deadline, the tail is what matters.
+
+The outliers (steps above a quantile of the step latency, or above the deadline when given) are correlated with
+the events of their step, read from the outputs of the solver:
+    - contact change: the number of contact rows changed, or new contacts were tracked
+    - infeasibility retry: qpRecovery is not None
+    - reallocation: the peak of memoryUsage grew
+    - cold start: qpOASES factorized a problem from scratch (#Factorizations)
+    - deadline hit: deadlineHit (with a timeBudget)
+For each event, its rate among the outliers is compared to its rate over all the steps.
+
+To reduce the noise of the machine, the process can be pinned on isolated cores (--cpus, best with the kernel
+parameter isolcpus), run with the SCHED_FIFO policy (--fifo) and have its memory locked (--mlock, no page faults
+once the buffers are allocated). These need the corresponding privileges, a warning is printed when they fail.
+
+Usage (with SofaPython3 in the PYTHONPATH and SoftRobots, SoftRobots.Inverse in the plugins):
+    python3 runLatencyBenchmark.py --steps 100000 --contacts 64 --cpus 3 --fifo 80 --mlock
+    python3 runLatencyBenchmark.py --option timeBudget=2 --deadline 2 --check --histogram latency.csv
+
+With --check, the exit code is 1 when a step exceeds the deadline in the checked phase (Solve by default).
+This is the acceptance test of the deadline mode (timeBudget).
+"""
+import argparse
+import ast
+import csv
+import ctypes
+import ctypes.util
+import gc
+import math
+import os
+import sys
+import time
+
+import Sofa
+import Sofa.Simulation
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import runScalingBenchmark
+import ScalingScene
+
+events = ['contact change', 'infeasibility retry', 'reallocation', 'cold start', 'deadline hit']
+quantiles = [('p50', 0.5), ('p99', 0.99), ('p99.9', 0.999)]
+
+MCL_CURRENT = 1
+MCL_FUTURE = 2
+
+
+def isolate(args):
+    """Pins the process, sets its scheduling policy and locks its memory, as requested"""
+    if args.cpus:
+        try:
+            os.sched_setaffinity(0, args.cpus)
+        except (AttributeError, OSError) as error:
+            print('Warning: cannot pin the process on the cpus {}: {}'.format(args.cpus, error), file=sys.stderr)
+    if args.fifo:
+        try:
+            os.sched_setscheduler(0, os.SCHED_FIFO, os.sched_param(args.fifo))
+        except (AttributeError, OSError) as error:
+            print('Warning: cannot set SCHED_FIFO with priority {}: {}'.format(args.fifo, error), file=sys.stderr)
+    if args.mlock:
+        libc = ctypes.CDLL(ctypes.util.find_library('c'), use_errno=True)
+        if libc.mlockall(MCL_CURRENT | MCL_FUTURE) != 0:
+            print('Warning: cannot lock the memory: {}'.format(os.strerror(ctypes.get_errno())), file=sys.stderr)
+
+
+def parseOption(option):
+    """name=value of a solver attribute, the value being a Python literal or a string"""
+    name, _, value = option.partition('=')
+    try:
+        return name, ast.literal_eval(value)
+    except (ValueError, SyntaxError):
+        return name, value
+
+
+def percentile(sortedValues, q):
+    """Nearest-rank percentile of sorted values"""
+    if not sortedValues:
+        return 0.
+    return sortedValues[max(0, min(len(sortedValues) - 1, int(math.ceil(q*len(sortedValues))) - 1))]
+
+
+def histogram(values, nbBinsPerDecade):
+    """Counts of the values in log-spaced bins, as (low, high, count), the empty bins being skipped"""
+    counts = {}
+    for value in values:
+        if value > 0.:
+            index = int(math.floor(math.log10(value)*nbBinsPerDecade))
+            counts[index] = counts.get(index, 0) + 1
+    return [(10.**(index/nbBinsPerDecade), 10.**((index + 1)/nbBinsPerDecade), count)
+            for index, count in sorted(counts.items())]
+
+
+def runSteps(args):
+    """Latencies per phase (ms) and events of each timed step"""
+    root = Sofa.Core.Node('root')
+    params = dict(parseOption(option) for option in args.option)
+    ScalingScene.createScene(root, resolution=args.resolution, nbActuators=args.actuators, nbEffectors=args.effectors,
+                             nbContacts=args.contacts, mu=args.mu, qpSolverParams=params)
+    Sofa.Simulation.init(root)
+    solver = root.QPInverseProblemSolver
+
+    for _ in range(args.warmup):
+        Sofa.Simulation.animate(root, root.dt.value)
+
+    latencies = {'step': []}
+    stepEvents = []
+    contactRows = runScalingBenchmark.parseMap(solver.graph).get('#Contacts:', [0])[0]
+    peakMemory = runScalingBenchmark.parseMap(solver.memoryUsage).get('peak', [0.]*4)[-1]
+
+    # The collector would add its pauses to the steps
+    gc.collect()
+    gc.disable()
+    for step in range(args.steps):
+        start = time.perf_counter()
+        Sofa.Simulation.animate(root, root.dt.value)
+        latencies['step'].append(1e3*(time.perf_counter() - start))
+
+        for phase, values in runScalingBenchmark.parseMap(solver.timings).items():
+            if values:
+                latencies.setdefault(phase, [0.]*step).append(values[0])
+        for values in latencies.values():
+            if len(values) == step: # phase not measured during this step
+                values.append(0.)
+
+        graph = runScalingBenchmark.parseMap(solver.graph)
+        memory = runScalingBenchmark.parseMap(solver.memoryUsage).get('peak', [0.]*4)[-1]
+        rows = graph.get('#Contacts:', [0])[0]
+        stepEvents.append({'contact change': rows != contactRows or graph.get('#New contacts:', [0])[0] > 0,
+                           'infeasibility retry': solver.qpRecovery.value != 'None',
+                           'reallocation': memory > peakMemory,
+                           'cold start': graph.get('#Factorizations:', [0])[0] > 0,
+                           'deadline hit': bool(solver.deadlineHit.value)})
+        contactRows, peakMemory = rows, memory
+    gc.enable()
+
+    Sofa.Simulation.unload(root)
+    return latencies, stepEvents
+
+
+def correlate(latencies, stepEvents, threshold):
+    """Number of outliers and, for each event, its rate among the outliers and over all the steps"""
+    outliers = [i for i, latency in enumerate(latencies) if latency > threshold]
+    rates = {}
+    for event in events:
+        total = sum(1 for e in stepEvents if e[event])
+        inOutliers = sum(1 for i in outliers if stepEvents[i][event])
+        rates[event] = (inOutliers/len(outliers) if outliers else 0., total/len(stepEvents) if stepEvents else 0.)
+    unexplained = sum(1 for i in outliers if not any(stepEvents[i].values()))
+    return outliers, rates, unexplained
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--resolution', type=int, default=4)
+    parser.add_argument('--actuators', type=int, default=4)
+    parser.add_argument('--effectors', type=int, default=1)
+    parser.add_argument('--contacts', type=int, default=16)
+    parser.add_argument('--mu', type=float, default=0.)
+    parser.add_argument('--option', nargs='*', default=[], help='Attributes of the solver, as name=value')
+    parser.add_argument('--steps', type=int, default=10000)
+    parser.add_argument('--warmup', type=int, default=100)
+    parser.add_argument('--cpus', type=int, nargs='*', default=[], help='Cores the process is pinned on')
+    parser.add_argument('--fifo', type=int, default=0, help='Priority of the SCHED_FIFO policy, 0 to keep the default')
+    parser.add_argument('--mlock', action='store_true', help='Locks the current and future memory of the process')
+    parser.add_argument('--outlierQuantile', type=float, default=0.99,
+                        help='Quantile of the step latency above which a step is an outlier, without deadline')
+    parser.add_argument('--deadline', type=float, default=0., help='Deadline in ms, 0 for none')
+    parser.add_argument('--deadlinePhase', default='Solve', help='Phase compared to the deadline, or step')
+    parser.add_argument('--check', action='store_true', help='Exit with 1 when the deadline is exceeded')
+    parser.add_argument('--binsPerDecade', type=int, default=20)
+    parser.add_argument('--histogram', help='CSV file of the histograms of the phases')
+    parser.add_argument('--trace', help='CSV file of the latencies and events of each step')
+    parser.add_argument('--output', help='CSV file of the percentiles, printed on the standard output if not set')
+    args = parser.parse_args()
+
+    isolate(args)
+    latencies, stepEvents = runSteps(args)
+
+    results = []
+    for phase, values in sorted(latencies.items()):
+        sortedValues = sorted(values)
+        result = {'phase': phase, 'steps': len(values), 'mean': sum(values)/len(values) if values else 0.}
+        for name, q in quantiles:
+            result[name] = percentile(sortedValues, q)
+        result['max'] = sortedValues[-1] if sortedValues else 0.
+        if args.deadline > 0.:
+            result['over deadline'] = sum(1 for value in values if value > args.deadline)
+        results.append(result)
+        print('{}: p50 {:.3f} ms, p99 {:.3f} ms, p99.9 {:.3f} ms, max {:.3f} ms'.format(
+            phase, result['p50'], result['p99'], result['p99.9'], result['max']), file=sys.stderr)
+
+    if args.deadline > 0.:
+        checked = latencies.get(args.deadlinePhase, latencies['step'])
+        threshold = args.deadline
+    else:
+        checked = latencies['step']
+        threshold = percentile(sorted(checked), args.outlierQuantile)
+    outliers, rates, unexplained = correlate(checked, stepEvents, threshold)
+    print('{} outliers above {:.3f} ms, {} without any event'.format(len(outliers), threshold, unexplained),
+          file=sys.stderr)
+    for event, (inOutliers, overall) in rates.items():
+        print('    {}: {:.1f}% of the outliers, {:.1f}% of the steps'.format(event, 100.*inOutliers, 100.*overall),
+              file=sys.stderr)
+
+    columns = []
+    for result in results:
+        columns += [key for key in result if key not in columns]
+    output = open(args.output, 'w', newline='') if args.output else sys.stdout
+    writer = csv.DictWriter(output, fieldnames=columns, restval=0.)
+    writer.writeheader()
+    for result in results:
+        writer.writerow(result)
+    if args.output:
+        output.close()
+
+    if args.histogram:
+        with open(args.histogram, 'w', newline='') as file:
+            writer = csv.writer(file)
+            writer.writerow(['phase', 'low (ms)', 'high (ms)', 'count'])
+            for phase, values in sorted(latencies.items()):
+                for low, high, count in histogram(values, args.binsPerDecade):
+                    writer.writerow([phase, low, high, count])
+
+    if args.trace:
+        with open(args.trace, 'w', newline='') as file:
+            phases = sorted(latencies)
+            writer = csv.writer(file)
+            writer.writerow(['step'] + [phase + ' (ms)' for phase in phases] + events)
+            for i, stepEvent in enumerate(stepEvents):
+                writer.writerow([i] + [latencies[phase][i] for phase in phases] + [int(stepEvent[e]) for e in events])
+
+    if args.check and args.deadline > 0. and len(outliers) > 0:
+        print('Deadline of {} ms exceeded by {} steps in {}'.format(args.deadline, len(outliers), args.deadlinePhase),
+              file=sys.stderr)
+        sys.exit(1)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,206 @@
+# -*- coding: utf-8 -*-
+"""
+Runs ScalingScene.py over a sweep of numbers of actuators, effectors and contacts, and reports how the memory
+of QPInverseProblemSolver scales: the peak RSS of the process and the bytes per structure of its memoryUsage
+output (compliance, QP system, resolution buffers, for each allocated problem and their high-water mark).
+
+Each case runs in its own (spawned) process, so that its peak RSS is not hidden by the previous cases.
+
+The options changing the memory are run on the same sweep (variants). For each variant, the growth of the peak
+of each structure with the contact rows is reported as the exponent of a fitted power law (about 2 for the
+dense compliance). The expected curves are checked against the default solver:
+    - lazyProblems: problem2 and problem3 are not allocated, the peak is below the default one
+    - partialCompliance: the compliance is not above the default one
+    - sparseContacts (with friction, mu 0.3 for all the variants): the resolution buffers grow slower than the
+      default ones
+    - mixedPrecision (same friction): the float copy of the contact compliance is at most half of it
+
+Usage (with SofaPython3 in the PYTHONPATH and SoftRobots, SoftRobots.Inverse in the plugins):
+    python3 runMemoryBenchmark.py --actuators 1 16 --effectors 1 8 --contacts 0 16 64 --steps 20
+    python3 runMemoryBenchmark.py --variants default lazyProblems sparseContacts --check --output memory.csv
+
+With --check, the exit code is 1 when one of the expected curves is not found.
+"""
+import argparse
+import csv
+import itertools
+import math
+import multiprocessing
+import os
+import queue
+import resource
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import runScalingBenchmark
+
+variants = {'default': {},
+            'lazyProblems': {'lazyProblems': True},
+            'partialCompliance': {'partialCompliance': True},
+            'sparseContacts': {'sparseContacts': True},
+            'mixedPrecision': {'mixedPrecision': True}}
+
+structures = ['compliance', 'qp system', 'solvers', 'total']
+
+
+def peakRSS():
+    """Peak resident set size of the process in bytes (ru_maxrss is in bytes on macOS, in kB elsewhere)"""
+    maxrss = resource.getrusage(resource.RUSAGE_SELF).ru_maxrss
+    return maxrss if sys.platform == 'darwin' else 1024*maxrss
+
+
+def runCase(nbActuators, nbEffectors, nbContacts, variant, args, results):
+    import Sofa
+    import Sofa.Simulation
+    import ScalingScene
+
+    root = Sofa.Core.Node('root')
+    ScalingScene.createScene(root, resolution=args.resolution, nbActuators=nbActuators, nbEffectors=nbEffectors,
+                             nbContacts=nbContacts, mu=args.mu, qpSolverParams=variants[variant])
+    Sofa.Simulation.init(root)
+    solver = root.QPInverseProblemSolver
+
+    contactRows = 0.
+    for _ in range(args.steps):
+        Sofa.Simulation.animate(root, root.dt.value)
+        contactRows = max(contactRows, runScalingBenchmark.parseMap(solver.graph).get('#Contacts:', [0])[0])
+
+    result = {'variant': variant, 'actuators': nbActuators, 'effectors': nbEffectors, 'contacts': nbContacts,
+              'contact rows': contactRows, 'peak RSS': peakRSS()}
+    for problem, values in runScalingBenchmark.parseMap(solver.memoryUsage).items():
+        for structure, value in zip(structures, values):
+            result[problem + ' ' + structure] = value
+
+    Sofa.Simulation.unload(root)
+    results.put(result)
+
+
+def runIsolated(nbActuators, nbEffectors, nbContacts, variant, args):
+    """Result of the case run in a new process, None if it failed or timed out"""
+    context = multiprocessing.get_context('spawn')
+    results = context.Queue()
+    process = context.Process(target=runCase, args=(nbActuators, nbEffectors, nbContacts, variant, args, results))
+    process.start()
+    try:
+        result = results.get(timeout=args.timeout)
+    except queue.Empty:
+        result = None
+        process.terminate()
+    process.join()
+    return result
+
+
+def fitExponent(points):
+    """Exponent b of y = a*x^b, by least squares in log-log over the points with x, y > 0"""
+    points = [(math.log(x), math.log(y)) for x, y in points if x > 0 and y > 0]
+    if len(points) < 2:
+        return None
+    mx = sum(x for x, _ in points)/len(points)
+    my = sum(y for _, y in points)/len(points)
+    sxx = sum((x - mx)**2 for x, _ in points)
+    if sxx == 0.:
+        return None
+    return sum((x - mx)*(y - my) for x, y in points)/sxx
+
+
+def checkCurves(results):
+    """Messages of the expected curves that are not found"""
+    failures = []
+    byCase = {}
+    for result in results:
+        byCase.setdefault((result['actuators'], result['effectors'], result['contacts']), {})[result['variant']] = result
+
+    for case, caseResults in sorted(byCase.items()):
+        default = caseResults.get('default')
+        if not default:
+            continue
+        lazy = caseResults.get('lazyProblems')
+        if lazy:
+            if 'problem2 total' in lazy or 'problem3 total' in lazy:
+                failures.append('lazyProblems {}: problem2 or problem3 allocated'.format(case))
+            if lazy.get('peak total', 0.) >= default.get('peak total', 0.) > 0.:
+                failures.append('lazyProblems {}: peak {} not below the default one {}'.format(
+                    case, lazy['peak total'], default['peak total']))
+        partial = caseResults.get('partialCompliance')
+        if partial and partial.get('peak compliance', 0.) > default.get('peak compliance', 0.):
+            failures.append('partialCompliance {}: compliance {} above the default one {}'.format(
+                case, partial['peak compliance'], default['peak compliance']))
+        mixed = caseResults.get('mixedPrecision')
+        if mixed and case[2] > 0:
+            copy = mixed.get('peak solvers', 0.) - default.get('peak solvers', 0.)
+            if copy > 0.5*default.get('peak compliance', 0.):
+                failures.append('mixedPrecision {}: {} more bytes, above half of the compliance {}'.format(
+                    case, copy, default['peak compliance']))
+
+    # Growth with the contact rows, at the largest numbers of actuators and effectors
+    exponents = {}
+    for variant in sorted(set(result['variant'] for result in results)):
+        points = {}
+        for result in results:
+            if result['variant'] == variant:
+                points.setdefault((result['actuators'], result['effectors']), []).append(result)
+        largest = points[max(points)]
+        exponents[variant] = {}
+        for structure in structures:
+            exponent = fitExponent([(result['contact rows'], result.get('peak ' + structure, 0.)) for result in largest])
+            if exponent is not None:
+                exponents[variant][structure] = exponent
+        print('{}: '.format(variant) + ', '.join('{} ~ contact rows^{:.2f}'.format(structure, exponent)
+                                                for structure, exponent in exponents[variant].items()), file=sys.stderr)
+
+    default = exponents.get('default', {}).get('solvers')
+    sparse = exponents.get('sparseContacts', {}).get('solvers')
+    if default is not None and sparse is not None and sparse >= default:
+        failures.append('sparseContacts: resolution buffers grow as contact rows^{:.2f}, not below the default ^{:.2f}'
+                        .format(sparse, default))
+    return failures
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--resolution', type=int, default=4)
+    parser.add_argument('--actuators', type=int, nargs='+', default=[1, 4, 16])
+    parser.add_argument('--effectors', type=int, nargs='+', default=[1, 8])
+    parser.add_argument('--contacts', type=int, nargs='+', default=[0, 16, 64, 256])
+    parser.add_argument('--variants', nargs='+', choices=sorted(variants), default=sorted(variants))
+    parser.add_argument('--mu', type=float, default=0.3)
+    parser.add_argument('--steps', type=int, default=20)
+    parser.add_argument('--timeout', type=float, default=600., help='Time limit of a case in s')
+    parser.add_argument('--check', action='store_true', help='Exit with 1 when an expected curve is not found')
+    parser.add_argument('--output', help='CSV file, printed on the standard output if not set')
+    args = parser.parse_args()
+
+    results = []
+    for variant, nbActuators, nbEffectors, nbContacts in itertools.product(args.variants, args.actuators,
+                                                                          args.effectors, args.contacts):
+        result = runIsolated(nbActuators, nbEffectors, nbContacts, variant, args)
+        if result is None:
+            print('{} actuators {} effectors {} contacts {}: failed'.format(
+                variant, nbActuators, nbEffectors, nbContacts), file=sys.stderr)
+            continue
+        results.append(result)
+        print('{} actuators {} effectors {} contacts {}: peak RSS {:.1f} MB, solver peak {:.1f} MB'.format(
+            variant, nbActuators, nbEffectors, nbContacts, result['peak RSS']/2.**20,
+            result.get('peak total', 0.)/2.**20), file=sys.stderr)
+
+    columns = []
+    for result in results:
+        columns += [key for key in result if key not in columns]
+
+    output = open(args.output, 'w', newline='') if args.output else sys.stdout
+    writer = csv.DictWriter(output, fieldnames=columns, restval=0.)
+    writer.writeheader()
+    for result in results:
+        writer.writerow(result)
+    if args.output:
+        output.close()
+
+    failures = checkCurves(results)
+    for failure in failures:
+        print('Unexpected curve: ' + failure, file=sys.stderr)
+    if args.check and failures:
+        sys.exit(1)
+
+
+if __name__ == '__main__':
+    main()
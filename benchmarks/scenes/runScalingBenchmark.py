@@ -0,0 +1,116 @@
+# -*- coding: utf-8 -*-
+"""
+Runs ScalingScene.py over a sweep of mesh resolutions, numbers of actuators and numbers of contacts,
+and reports the steps per second and the per-phase breakdown of QPInverseProblemSolver (data timings).
+
+Usage (with SofaPython3 in the PYTHONPATH and SoftRobots, SoftRobots.Inverse in the plugins):
+    python3 runScalingBenchmark.py --resolutions 2 4 8 --actuators 1 4 16 --contacts 0 16 64 --steps 100
+    python3 runScalingBenchmark.py --actuatorType surface --output scaling.csv
+
+The phases are reported as their mean duration per step in ms, measured over the timed steps.
+"""
+import argparse
+import csv
+import itertools
+import os
+import sys
+import time
+
+import Sofa
+import Sofa.Simulation
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import ScalingScene
+
+
+def parseMap(data):
+    """Values of a map<string, vector<SReal>> data (timings or graph), as a dict of lists"""
+    value = data.value
+    if isinstance(value, dict):
+        return {key: list(values) for key, values in value.items()}
+
+    # The text form has one entry per line: the key (which can contain spaces) then the values
+    result = {}
+    for line in data.getValueString().splitlines():
+        tokens = line.split()
+        values = []
+        while tokens:
+            try:
+                values.insert(0, float(tokens[-1]))
+            except ValueError:
+                break
+            tokens.pop()
+        if tokens:
+            result[' '.join(tokens)] = values
+    return result
+
+
+def runCase(resolution, nbActuators, nbContacts, args):
+    root = Sofa.Core.Node('root')
+    ScalingScene.createScene(root, resolution=resolution, nbActuators=nbActuators, actuatorType=args.actuatorType,
+                             nbContacts=nbContacts, mu=args.mu)
+    Sofa.Simulation.init(root)
+    solver = root.QPInverseProblemSolver
+
+    for _ in range(args.warmup):
+        Sofa.Simulation.animate(root, root.dt.value)
+
+    elapsed = 0.
+    phases = {}
+    contactRows = 0.
+    for _ in range(args.steps):
+        start = time.perf_counter()
+        Sofa.Simulation.animate(root, root.dt.value)
+        elapsed += time.perf_counter() - start
+
+        for phase, values in parseMap(solver.timings).items():
+            if values:
+                phases[phase] = phases.get(phase, 0.) + values[0]
+        contactRows += parseMap(solver.graph).get('#Contacts:', [0])[0]
+
+    Sofa.Simulation.unload(root)
+
+    result = {'resolution': resolution, 'actuators': nbActuators, 'contacts': nbContacts,
+              'nodes': (4*resolution+1)*(resolution+1)**2,
+              'contact rows': contactRows/args.steps,
+              'steps/s': args.steps/elapsed if elapsed > 0. else float('inf'),
+              'step (ms)': 1e3*elapsed/args.steps}
+    for phase, total in phases.items():
+        result[phase] = total/args.steps
+    return result
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--resolutions', type=int, nargs='+', default=[2, 4, 6])
+    parser.add_argument('--actuators', type=int, nargs='+', default=[1, 4, 16])
+    parser.add_argument('--contacts', type=int, nargs='+', default=[0, 16, 64])
+    parser.add_argument('--actuatorType', choices=['cable', 'surface'], default='cable')
+    parser.add_argument('--mu', type=float, default=0.)
+    parser.add_argument('--steps', type=int, default=50)
+    parser.add_argument('--warmup', type=int, default=5)
+    parser.add_argument('--output', help='CSV file, printed on the standard output if not set')
+    args = parser.parse_args()
+
+    results = []
+    for resolution, nbActuators, nbContacts in itertools.product(args.resolutions, args.actuators, args.contacts):
+        result = runCase(resolution, nbActuators, nbContacts, args)
+        results.append(result)
+        print('resolution {} actuators {} contacts {}: {:.1f} steps/s'.format(
+            resolution, nbActuators, nbContacts, result['steps/s']), file=sys.stderr)
+
+    columns = []
+    for result in results:
+        columns += [key for key in result if key not in columns]
+
+    output = open(args.output, 'w', newline='') if args.output else sys.stdout
+    writer = csv.DictWriter(output, fieldnames=columns, restval=0.)
+    writer.writeheader()
+    for result in results:
+        writer.writerow(result)
+    if args.output:
+        output.close()
+
+
+if __name__ == '__main__':
+    main()
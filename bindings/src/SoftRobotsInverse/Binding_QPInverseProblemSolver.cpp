@@ -0,0 +1,199 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <pybind11/numpy.h>
+#include <pybind11/stl.h>
+
+#include <SofaPython3/PythonFactory.h>
+#include <SofaPython3/Sofa/Core/Binding_BaseObject.h>
+
+#include <sofa/defaulttype/AbstractTypeInfo.h>
+#include <sofa/simulation/Node.h>
+#include <sofa/simulation/Simulation.h>
+
+#include <SoftRobots.Inverse/component/solver/QPInverseProblemSolver.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPInverseProblemImpl.h>
+
+#include <SoftRobotsInverse/Binding_QPInverseProblemSolver.h>
+#include <SoftRobotsInverse/Binding_QPInverseProblemSolver_doc.h>
+
+namespace py = pybind11;
+
+
+namespace softrobotsinverse::python
+{
+
+using sofa::core::objectmodel::BaseData;
+using sofa::core::objectmodel::BaseObject;
+using sofa::simulation::Node;
+using softrobotsinverse::solver::QPInverseProblemSolver;
+using softrobotsinverse::solver::module::QPInverseProblemImpl;
+
+typedef py::array_t<double, py::array::c_style | py::array::forcecast> Schedule;
+
+namespace
+{
+
+/// Copies the rows of the steps in an array of shape (nbSteps, largest rows), zero padded
+py::array_t<double> stackRows(const std::vector<double>& values,
+                              const std::vector<size_t>& offsets,
+                              const std::vector<unsigned int>& dimensions,
+                              const unsigned int& maxDimension)
+{
+    const auto nbSteps = static_cast<py::ssize_t>(dimensions.size());
+    py::array_t<double> array({nbSteps, static_cast<py::ssize_t>(maxDimension)});
+    auto rows = array.mutable_unchecked<2>();
+    for (py::ssize_t step = 0; step < nbSteps; step++)
+    {
+        const unsigned int dimension = dimensions[step];
+        for (unsigned int i = 0; i < dimension; i++)
+            rows(step, i) = values[offsets[step] + i];
+        for (unsigned int i = dimension; i < maxDimension; i++)
+            rows(step, i) = 0.;
+    }
+    return array;
+}
+
+} // namespace
+
+py::dict batchStep(QPInverseProblemSolver& solver,
+                   Node* root,
+                   const std::vector<BaseObject*>& effectors,
+                   const Schedule& goals,
+                   double dt)
+{
+    if (root == nullptr)
+        throw py::value_error("batchStep: the root node is None");
+    if (goals.ndim() != 2)
+        throw py::value_error("batchStep: the goals must be an array of shape (nbSteps, number of goal values)");
+
+    // Data of the goals, and their number of values, resolved once with the GIL held
+    std::vector<BaseData*> goalData;
+    std::vector<size_t> goalSizes;
+    size_t nbGoalValues = 0;
+    for (BaseObject* effector: effectors)
+    {
+        BaseData* data = effector ? effector->findData("effectorGoal") : nullptr;
+        if (data == nullptr)
+            throw py::value_error("batchStep: an effector has no data effectorGoal");
+
+        const sofa::defaulttype::AbstractTypeInfo* typeInfo = data->getValueTypeInfo();
+        if (!typeInfo->ValidInfo() || !(typeInfo->Scalar() || typeInfo->Integer()))
+            throw py::value_error("batchStep: the data effectorGoal of " + effector->getName() + " is not numeric");
+
+        goalData.push_back(data);
+        goalSizes.push_back(typeInfo->size(data->getValueVoidPtr()));
+        nbGoalValues += goalSizes.back();
+    }
+
+    if (static_cast<size_t>(goals.shape(1)) != nbGoalValues)
+        throw py::value_error("batchStep: the goals have " + std::to_string(goals.shape(1)) +
+                              " columns, the effectors have " + std::to_string(nbGoalValues) + " goal values");
+
+    if (dt <= 0.)
+        dt = root->getDt();
+
+    const auto schedule = goals.unchecked<2>();
+    const auto nbSteps = static_cast<size_t>(schedule.shape(0));
+
+    std::vector<double> lambdas;
+    std::vector<double> deltas;
+    std::vector<size_t> offsets(nbSteps, 0);
+    std::vector<unsigned int> dimensions(nbSteps, 0);
+    std::vector<double> times(nbSteps, 0.);
+    unsigned int maxDimension = 0;
+
+    {
+        // The scene is only accessed from C++ until the end of the steps
+        py::gil_scoped_release release;
+
+        for (size_t step = 0; step < nbSteps; step++)
+        {
+            py::ssize_t column = 0;
+            for (size_t k = 0; k < goalData.size(); k++)
+            {
+                BaseData* data = goalData[k];
+                const sofa::defaulttype::AbstractTypeInfo* typeInfo = data->getValueTypeInfo();
+                void* value = data->beginEditVoidPtr();
+                for (size_t i = 0; i < goalSizes[k]; i++)
+                    typeInfo->setScalarValue(value, i, schedule(step, column++));
+                data->endEditVoidPtr();
+            }
+
+            const auto start = std::chrono::steady_clock::now();
+            sofa::simulation::node::animate(root, dt);
+            times[step] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            offsets[step] = lambdas.size();
+            QPInverseProblemImpl* problem = solver.getResultProblem();
+            if (problem == nullptr)
+                continue;
+
+            const auto lambda = problem->getLambda();
+            const auto delta = problem->getDelta();
+            const auto dimension = static_cast<unsigned int>(lambda.size());
+            dimensions[step] = dimension;
+            maxDimension = std::max(maxDimension, dimension);
+
+            lambdas.insert(lambdas.end(), lambda.data(), lambda.data() + dimension);
+            const auto nbDeltas = std::min<size_t>(dimension, delta.size());
+            deltas.insert(deltas.end(), delta.data(), delta.data() + nbDeltas);
+            deltas.resize(lambdas.size(), 0.);
+        }
+    }
+
+    py::dict result;
+    result["lambda"] = stackRows(lambdas, offsets, dimensions, maxDimension);
+    result["delta"] = stackRows(deltas, offsets, dimensions, maxDimension);
+    result["dimension"] = py::array_t<unsigned int>(nbSteps, dimensions.data());
+    result["time"] = py::array_t<double>(nbSteps, times.data());
+    return result;
+}
+
+void moduleAddQPInverseProblemSolver(py::module& m)
+{
+    py::class_<QPInverseProblemSolver, BaseObject, sofapython3::py_shared_ptr<QPInverseProblemSolver>>
+            c(m, "QPInverseProblemSolver", doc::QPInverseProblemSolver);
+
+    // The objects of this type created by the scene are given to Python with this binding
+    sofapython3::PythonFactory::registerType<QPInverseProblemSolver>([](sofa::core::objectmodel::Base* object)
+    {
+        return py::cast(dynamic_cast<QPInverseProblemSolver*>(object));
+    });
+
+    c.def("batchStep", &batchStep,
+          py::arg("root"), py::arg("effectors"), py::arg("goals"), py::arg("dt") = 0.,
+          doc::batchStep);
+}
+
+} // namespace
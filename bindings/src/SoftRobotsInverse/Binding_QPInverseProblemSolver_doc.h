@@ -0,0 +1,59 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+
+namespace softrobotsinverse::python::doc
+{
+
+static auto QPInverseProblemSolver =
+        R"(
+        Inverse problem solver of SoftRobots.Inverse, see the documentation of the component.
+        )";
+
+static auto batchStep =
+        R"(
+        Animates the scene nbSteps times, with the goals of the effectors taken from a schedule, and
+        returns the results of the solver at each step.
+
+        The goals are set through the data effectorGoal of the effectors, the columns of the schedule
+        are the values of all the goals, in the order of the effectors (e.g. 3 columns per position
+        of a PositionEffector). The GIL is released during the steps, the scene must not be accessed
+        from Python until the call returns (in particular from the Python controllers of the scene).
+
+        :param root: root node of the scene
+        :param effectors: effectors with a data effectorGoal
+        :param goals: schedule of the goals, array of shape (nbSteps, number of goal values)
+        :param dt: time step, 0 to use the one of the root node
+        :return: a dict of arrays: lambda and delta of shape (nbSteps, largest number of rows), zero
+                 padded past the rows of the step, dimension (nbSteps) the number of rows of each
+                 step, and time (nbSteps) the duration of each step in seconds.
+        )";
+
+} // namespace
@@ -430,6 +430,16 @@ class QProblemB
 		 *	\return SUCCESSFUL_RETURN. */
 		inline returnValue resetCounter( );
 
+		/** Returns the counters of the resolutions since the creation of the problem (not reset by resetCounter):
+		 *	bounds and constraints flipped between their limits, applications of the ramping strategy,
+		 *	factorisations computed from scratch and updates of the factorisations.
+		 *	\return SUCCESSFUL_RETURN. */
+		inline returnValue getStatistics(	uint_t& _nFlips,			/**< Output: Number of flipped bounds and constraints. */
+											uint_t& _nRampings,			/**< Output: Number of ramping strategies. */
+											uint_t& _nFactorisations,	/**< Output: Number of factorisations from scratch. */
+											uint_t& _nUpdates			/**< Output: Number of factorisation updates. */
+											) const;
+
 
 		/** Prints concise list of properties of the current QP.
 		 *	\return  SUCCESSFUL_RETURN \n */
@@ -993,6 +1003,10 @@ class QProblemB
 		real_t regVal;				/**< Holds the offset used to regularise Hessian matrix (zero by default). */
 
 		uint_t count;				/**< Counts the number of hotstart function calls. */
+		uint_t nFlips;				/**< Counts the bounds and constraints flipped between their limits. */
+		uint_t nRampings;			/**< Counts the applications of the ramping strategy. */
+		uint_t nFactorisations;		/**< Counts the factorisations computed from scratch. */
+		uint_t nUpdates;			/**< Counts the updates of the factorisations (bounds or constraints added or removed). */
 
 		real_t *delta_xFR_TMP;		/**< Temporary for determineStepDirection */
 
@@ -229,6 +229,21 @@ inline returnValue QProblemB::resetCounter( )
 }
 
 
+/*
+ *	g e t S t a t i s t i c s
+ */
+inline returnValue QProblemB::getStatistics(	uint_t& _nFlips, uint_t& _nRampings,
+												uint_t& _nFactorisations, uint_t& _nUpdates
+												) const
+{
+	_nFlips = nFlips;
+	_nRampings = nRampings;
+	_nFactorisations = nFactorisations;
+	_nUpdates = nUpdates;
+	return SUCCESSFUL_RETURN;
+}
+
+
 /*****************************************************************************
  *  P R O T E C T E D                                                        *
  *****************************************************************************/
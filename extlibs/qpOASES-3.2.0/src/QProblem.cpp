@@ -2008,6 +2008,8 @@ returnValue QProblem::setupSubjectToType(	const real_t* const lb_new, const real
  */
 returnValue QProblem::computeProjectedCholesky( )
 {
+	nFactorisations++;
+
 	int_t i, j;
 	int_t nV  = getNV( );
 	int_t nZ  = getNZ( );
@@ -2141,6 +2143,8 @@ returnValue QProblem::setupInitialCholesky( )
  */
 returnValue QProblem::setupTQfactorisation( )
 {
+	nFactorisations++;
+
 	int_t i, ii;
 	int_t nV  = getNV( );
 	int_t nFR = getNFR( );
@@ -2792,6 +2796,8 @@ returnValue QProblem::addConstraint(	int_t number, SubjectToStatus C_status,
 										BooleanType ensureLI
 										)
 {
+	nUpdates++;
+
 	int_t i, j, ii;
 
 	/* consistency checks */
@@ -3280,6 +3286,8 @@ returnValue QProblem::addBound(	int_t number, SubjectToStatus B_status,
 								BooleanType ensureLI
 								)
 {
+	nUpdates++;
+
 	int_t i, j, ii;
 
 	/* consistency checks */
@@ -3756,6 +3764,8 @@ returnValue QProblem::removeConstraint(	int_t number,
 										BooleanType ensureNZC
 										)
 {
+	nUpdates++;
+
 	int_t i, j, ii, jj;
 	returnValue returnvalue = SUCCESSFUL_RETURN;
 	BooleanType hasFlipped = BT_FALSE;
@@ -3916,6 +3926,7 @@ returnValue QProblem::removeConstraint(	int_t number,
 
 				flipper.get( &bounds,R,&constraints,Q,T );
 				constraints.flipFixed(number);
+				nFlips++;
 				tabularOutput.idxAddC = number;
 				tabularOutput.excAddC = 2;
 
@@ -3992,6 +4003,8 @@ returnValue QProblem::removeBound(	int_t number,
 									BooleanType ensureNZC
 									)
 {
+	nUpdates++;
+
 	int_t i, j, ii, jj;
 	returnValue returnvalue = SUCCESSFUL_RETURN;
 	int_t addIdx;
@@ -4168,6 +4181,7 @@ returnValue QProblem::removeBound(	int_t number,
 
 				flipper.get( &bounds,R,&constraints,Q,T );
 				bounds.flipFixed(number);
+				nFlips++;
 				tabularOutput.idxAddB = number;
 				tabularOutput.excAddB = 2;
 
@@ -5386,6 +5400,8 @@ real_t QProblem::getRelativeHomotopyLength(	const real_t* const g_new, const rea
  */
 returnValue QProblem::performRamping( )
 {
+	nRampings++;
+
 	int_t nV = getNV( ), nC = getNC( ), bstat, cstat, i, nRamp;
 	real_t tP, rampValP, tD, rampValD, sca;
 
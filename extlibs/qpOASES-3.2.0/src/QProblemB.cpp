@@ -53,7 +53,9 @@ QProblemB::QProblemB( )
 		printCopyrightNotice( );
 
 	/* reset global message handler */
+	#ifndef __SUPPRESSANYOUTPUT__
 	getGlobalMessageHandler( )->reset( );
+	#endif /* __SUPPRESSANYOUTPUT__ */
 
 	freeHessian = BT_FALSE;
 	H = 0;
@@ -79,6 +81,10 @@ QProblemB::QProblemB( )
 	status = QPS_NOTINITIALISED;
 
 	count = 0;
+	nFlips = 0;
+	nRampings = 0;
+	nFactorisations = 0;
+	nUpdates = 0;
 
 	ramp0 = options.initialRamping;
 	ramp1 = options.finalRamping;
@@ -109,7 +115,9 @@ QProblemB::QProblemB( int_t _nV, HessianType _hessianType )
 	}
 
 	/* reset global message handler */
+	#ifndef __SUPPRESSANYOUTPUT__
 	getGlobalMessageHandler( )->reset( );
+	#endif /* __SUPPRESSANYOUTPUT__ */
 
 	freeHessian = BT_FALSE;
 	H = 0;
@@ -146,6 +154,10 @@ QProblemB::QProblemB( int_t _nV, HessianType _hessianType )
 	status = QPS_NOTINITIALISED;
 
 	count = 0;
+	nFlips = 0;
+	nRampings = 0;
+	nFactorisations = 0;
+	nUpdates = 0;
 
 	ramp0 = options.initialRamping;
 	ramp1 = options.finalRamping;
@@ -179,7 +191,9 @@ QProblemB::~QProblemB( )
 	clear( );
 
 	/* reset global message handler */
+	#ifndef __SUPPRESSANYOUTPUT__
 	getGlobalMessageHandler( )->reset( );
+	#endif /* __SUPPRESSANYOUTPUT__ */
 }
 
 
@@ -827,7 +841,9 @@ returnValue QProblemB::setPrintLevel( PrintLevel _printLevel )
 	options.printLevel = PL_NONE;
 	#endif /* __SUPPRESSANYOUTPUT__ */
 
-	/* update message handler preferences */
+	/* update message handler preferences, left untouched when the output is suppressed so that
+	 * problems can be set up concurrently on several threads */
+	#ifndef __SUPPRESSANYOUTPUT__
  	switch ( options.printLevel )
  	{
  		case PL_NONE:
@@ -856,6 +872,7 @@ returnValue QProblemB::setPrintLevel( PrintLevel _printLevel )
 			getGlobalMessageHandler( )->setInfoVisibilityStatus( VS_VISIBLE );
 			break;
  	}
+	#endif /* __SUPPRESSANYOUTPUT__ */
 
 	return SUCCESSFUL_RETURN;
 }
@@ -1147,6 +1164,10 @@ returnValue QProblemB::copy(	const QProblemB& rhs
 	status = rhs.status;
 
 	count = rhs.count;
+	nFlips = rhs.nFlips;
+	nRampings = rhs.nRampings;
+	nFactorisations = rhs.nFactorisations;
+	nUpdates = rhs.nUpdates;
 
 	ramp0 = rhs.ramp0;
 	ramp1 = rhs.ramp1;
@@ -1359,6 +1380,8 @@ returnValue QProblemB::setupSubjectToType( const real_t* const lb_new, const rea
  */
 returnValue QProblemB::computeCholesky( )
 {
+	nFactorisations++;
+
 	int_t i, j;
 	int_t nV  = getNV( );
 	int_t nFR = getNFR( );
@@ -2156,6 +2179,8 @@ real_t QProblemB::getRelativeHomotopyLength(	const real_t* const g_new, const re
  */
 returnValue QProblemB::performRamping( )
 {
+	nRampings++;
+
 	int_t nV = getNV( ), bstat, i;
 	real_t t, rampVal;
 
@@ -3478,6 +3503,8 @@ returnValue QProblemB::addBound(	int_t number, SubjectToStatus B_status,
 									BooleanType updateCholesky
 									)
 {
+	nUpdates++;
+
 	int_t i, j;
 	int_t nV  = getNV( );
 	int_t nFR = getNFR( );
@@ -3548,6 +3575,8 @@ returnValue QProblemB::removeBound(	int_t number,
 									BooleanType updateCholesky
 									)
 {
+	nUpdates++;
+
 	int_t i;
 	int_t nV  = getNV( );
 	int_t nFR = getNFR( );
@@ -3634,6 +3663,7 @@ returnValue QProblemB::removeBound(	int_t number,
 
 				flipper.get( &bounds,R );
 				bounds.flipFixed(number);
+				nFlips++;
 
 				switch (bounds.getStatus(number))
 				{
@@ -3664,6 +3694,7 @@ returnValue QProblemB::removeBound(	int_t number,
 	{
 		flipper.get( &bounds,R );
 		bounds.flipFixed(number);
+		nFlips++;
 
 		switch (bounds.getStatus(number))
 		{
@@ -0,0 +1,57 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <sofa/core/ConstraintParams.h>
+#include <sofa/linearalgebra/BaseMatrix.h>
+#include <sofa/type/vector.h>
+
+namespace softrobotsinverse::behavior
+{
+
+/**
+ *  \brief Constraint correction computing its contribution J A^-1 J^T to the compliance W for a block of
+ *  rows at once, e.g. one resolution of its linear system with all the rows as right-hand sides instead of
+ *  one per row. QPInverseProblemSolver passes the rows of the problem it needs (actuators, effectors,
+ *  equality, contacts, and the sensors unless they are evaluated lazily), and calls
+ *  addComplianceInConstraintSpace() when the block is refused.
+ */
+class BatchedCompliance
+{
+public:
+    virtual ~BatchedCompliance() = default;
+
+    /// Adds into W the compliance between the given rows of the constraint matrix, in increasing order, the
+    /// other entries being left untouched. Returns false, without writing in W, when the rows can not be batched.
+    virtual bool addBatchedCompliance(const sofa::core::ConstraintParams* cParams,
+                                      sofa::linearalgebra::BaseMatrix* W,
+                                      const sofa::type::vector<unsigned int>& rows) = 0;
+};
+
+} // namespace
@@ -0,0 +1,56 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <sofa/core/ConstraintParams.h>
+#include <sofa/type/vector.h>
+
+namespace softrobotsinverse::behavior
+{
+
+/**
+ *  \brief Constraint correction applying its compliance J A^-1 J^T to a vector of constraint forces, without
+ *  forming it: one resolution of its linear system with J^T f as right-hand side. With the option matrixFree,
+ *  QPInverseProblemSolver does not assemble W when all the active constraint corrections implement it, and
+ *  solves the problem with these products only (see module::QPMatrixFreeSolver). Implemented by
+ *  constraint::MatrixFreeConstraintCorrection.
+ */
+class ComplianceOperator
+{
+public:
+    virtual ~ComplianceOperator() = default;
+
+    /// Adds J A^-1 J^T f into d, f and d having one entry per line of the constraint matrix. Returns false,
+    /// without writing in d, when the product can not be computed.
+    virtual bool addComplianceProduct(const sofa::core::ConstraintParams* cParams,
+                                      const sofa::type::vector<double>& f,
+                                      sofa::type::vector<double>& d) = 0;
+};
+
+} // namespace
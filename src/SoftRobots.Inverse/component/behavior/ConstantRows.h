@@ -0,0 +1,53 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+namespace softrobotsinverse::behavior
+{
+
+/**
+ *  \brief Rows of a constraint that do not depend on the positions, e.g. fixed weights or directions on
+ *  fixed indices. When all the constraints of the scene have constant rows and are only mapped by linear
+ *  mappings, QPInverseProblemSolver keeps the constraint matrices of the mechanical states, mapped and
+ *  projected, from one step to the next instead of building them again (see its data reuseConstantRows).
+ */
+class ConstantRows
+{
+public:
+    virtual ~ConstantRows() = default;
+
+    /// True when the rows written by the last buildConstraintMatrix() are still the rows of the constraint:
+    /// nothing they are built from (the data of the component, the size of its state) changed since
+    virtual bool hasConstantRows() const = 0;
+
+    /// Called instead of buildConstraintMatrix() at the steps the rows are kept, for what else the build updates
+    virtual void keepRows() {}
+};
+
+} // namespace
@@ -0,0 +1,169 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <sofa/simulation/MainTaskSchedulerFactory.h>
+#include <sofa/simulation/TaskScheduler.h>
+#include <sofa/type/vector.h>
+
+#include <algorithm>
+#include <functional>
+
+namespace softrobotsinverse::behavior
+{
+
+/**
+ *  \brief Rows of the constraint matrix of a component built concurrently.
+ *
+ *  The MatrixDeriv can only be written from one thread, and its new lines in order. The rows are
+ *  split in chunks of consecutive rows, each one built by a task of the task scheduler in its own
+ *  staging buffer (the columns and values of its rows), then the chunks are committed in the matrix
+ *  in the order of the rows. The buffers are kept between the steps, so that they do not allocate once
+ *  they have their size. Intended for the components knowing their number of rows ahead, with many
+ *  rows of many columns (e.g. the spheres of ForceSurfaceActuator).
+ */
+template<class DataTypes>
+class ConstraintRowsBuilder
+{
+public:
+    typedef typename DataTypes::Deriv Deriv;
+    typedef typename DataTypes::MatrixDeriv MatrixDeriv;
+    typedef typename DataTypes::MatrixDeriv::RowIterator MatrixDerivRowIterator;
+
+    /// Staging buffer of the rows [begin, end)
+    class Chunk
+    {
+    public:
+        void addCol(const sofa::Index column, const Deriv& value)
+        {
+            m_columns.push_back(column);
+            m_values.push_back(value);
+        }
+
+    protected:
+        friend class ConstraintRowsBuilder;
+
+        unsigned int                     m_begin{0};
+        unsigned int                     m_end{0};
+        sofa::type::vector<sofa::Index>  m_columns;
+        sofa::type::vector<Deriv>        m_values;
+        sofa::type::vector<unsigned int> m_rowEnds; // End of the columns of each row in m_columns
+    };
+
+    typedef std::function<void(const unsigned int row, Chunk& chunk)> RowFunction;
+
+    /// Writes the rows firstRowId+[0, nbRows) of the matrix, the columns of the row i being added by
+    /// function(i, chunk) with chunk.addCol(). With multithreading, the function is called concurrently
+    /// for rows of different chunks, so it should only read the state of the component.
+    void build(MatrixDeriv& matrix, const unsigned int firstRowId, const unsigned int nbRows,
+               const bool multithreading, const RowFunction& function)
+    {
+        sofa::simulation::TaskScheduler* taskScheduler = (multithreading && nbRows > 1)? sofa::simulation::MainTaskSchedulerFactory::createInRegistry() : nullptr;
+        const unsigned int nbThreads = (taskScheduler)? std::max(1u, taskScheduler->getThreadCount()) : 1u;
+
+        // A few chunks per thread, to balance the rows of different sizes
+        const unsigned int nbChunks = std::max(1u, std::min(nbRows, 4*nbThreads));
+        m_chunks.resize(nbChunks);
+        for(unsigned int c=0; c<nbChunks; c++)
+        {
+            m_chunks[c].m_begin = (c*nbRows)/nbChunks;
+            m_chunks[c].m_end = ((c+1)*nbRows)/nbChunks;
+        }
+
+        if(taskScheduler && nbChunks > 1)
+        {
+            sofa::simulation::CpuTask::Status status;
+
+            sofa::type::vector<BuildChunkTask> tasks;
+            tasks.resize(nbChunks, BuildChunkTask(&status));
+            for(unsigned int c=0; c<nbChunks; c++)
+            {
+                tasks[c].set(&m_chunks[c], &function);
+                taskScheduler->addTask(&tasks[c]);
+            }
+            taskScheduler->workUntilDone(&status);
+        }
+        else
+        {
+            for(Chunk& chunk : m_chunks)
+                buildChunk(chunk, function);
+        }
+
+        // Commit in order
+        for(const Chunk& chunk : m_chunks)
+        {
+            unsigned int column = 0;
+            for(unsigned int i=0; i<chunk.m_rowEnds.size(); i++)
+            {
+                MatrixDerivRowIterator rowIterator = matrix.writeLine(firstRowId + chunk.m_begin + i);
+                for(; column<chunk.m_rowEnds[i]; column++)
+                    rowIterator.addCol(chunk.m_columns[column], chunk.m_values[column]);
+            }
+        }
+    }
+
+protected:
+
+    sofa::type::vector<Chunk> m_chunks;
+
+    static void buildChunk(Chunk& chunk, const RowFunction& function)
+    {
+        chunk.m_columns.clear();
+        chunk.m_values.clear();
+        chunk.m_rowEnds.clear();
+        for(unsigned int row=chunk.m_begin; row<chunk.m_end; row++)
+        {
+            function(row, chunk);
+            chunk.m_rowEnds.push_back(chunk.m_columns.size());
+        }
+    }
+
+    class BuildChunkTask : public sofa::simulation::CpuTask
+    {
+    public:
+        BuildChunkTask(sofa::simulation::CpuTask::Status* status): CpuTask(status) {}
+        ~BuildChunkTask() override {}
+
+        MemoryAlloc run() final {
+            buildChunk(*chunk, *function);
+            return MemoryAlloc::Stack;
+        }
+
+        void set(Chunk* _chunk, const RowFunction* _function){
+            chunk = _chunk;
+            function = _function;
+        }
+
+    private:
+        Chunk* chunk{nullptr};
+        const RowFunction* function{nullptr};
+    };
+};
+
+} // namespace
@@ -0,0 +1,108 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <initializer_list>
+#include <sofa/type/Vec.h>
+#include <sofa/type/vector.h>
+
+namespace softrobotsinverse::behavior
+{
+
+/**
+ *  \brief Vertices of a draw() method, kept from one frame to the next. They are only rebuilt when one of
+ *  the versions they are computed from changed, e.g. the counters of the Data of the positions and of the
+ *  forces (see sofa::core::objectmodel::BaseData::getCounter()), and the draw tool is given the same lists
+ *  at each frame, instead of the lists being built again.
+ */
+class DrawBuffer
+{
+public:
+    /// True if the versions differ from the ones of the last call (or if the buffer was invalidated): the
+    /// vertices are cleared, to be filled again by the caller, and the versions are kept
+    bool update(std::initializer_list<int> versions)
+    {
+        if(m_isValid && m_versions.size() == versions.size() && std::equal(versions.begin(), versions.end(), m_versions.begin()))
+            return false;
+
+        m_versions.assign(versions.begin(), versions.end());
+        m_isValid = true;
+        m_nbUpdates++;
+        points.clear();
+        return true;
+    }
+
+    void invalidate() {m_isValid = false;}
+
+    /// Number of times the vertices were rebuilt
+    unsigned int getNbUpdates() const {return m_nbUpdates;}
+
+    /// Adds the segments of an arrow from `from` to `to`, for all the arrows to be drawn with a single
+    /// drawLines(): the shaft, and the two sides of the head in a plane containing the shaft. The head
+    /// is at most half of the shaft long.
+    void addArrow(const sofa::type::Vec3& from, const sofa::type::Vec3& to, const SReal& headSize)
+    {
+        points.push_back(from);
+        points.push_back(to);
+
+        const sofa::type::Vec3 shaft = to - from;
+        const SReal length = shaft.norm();
+        if(length == 0.)
+            return;
+
+        // Side of the head, orthogonal to the shaft and to the axis the least aligned with it
+        unsigned int axis = 0;
+        for(unsigned int k=1; k<3; k++)
+            if(std::abs(shaft[k]) < std::abs(shaft[axis]))
+                axis = k;
+        sofa::type::Vec3 side(0., 0., 0.);
+        side[axis] = 1.;
+        side = sofa::type::cross(shaft, side);
+
+        const SReal headLength = std::min(2*headSize, length/2);
+        const sofa::type::Vec3 base = to - shaft*(headLength/length);
+        side *= 0.5*headLength/side.norm();
+
+        points.push_back(to);
+        points.push_back(base + side);
+        points.push_back(to);
+        points.push_back(base - side);
+    }
+
+    sofa::type::vector<sofa::type::Vec3> points;
+
+protected:
+    sofa::type::vector<int> m_versions;
+    bool m_isValid{false};
+    unsigned int m_nbUpdates{0};
+};
+
+} // namespace
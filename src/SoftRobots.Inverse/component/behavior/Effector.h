@@ -29,6 +29,8 @@
 #pragma once
 
 #include <SoftRobots/component/behavior/SoftRobotsConstraint.h>
+#include <SoftRobots.Inverse/component/behavior/EffectorDeadband.h>
+#include <SoftRobots.Inverse/component/behavior/EffectorPriority.h>
 
 #include <SoftRobots.Inverse/component/config.h>
 
@@ -40,7 +42,8 @@ namespace softrobotsinverse::behavior
  */
 
 template<class DataTypes>
-class Effector : virtual public softrobots::behavior::SoftRobotsConstraint<DataTypes>
+class Effector : virtual public softrobots::behavior::SoftRobotsConstraint<DataTypes>, public EffectorPriority,
+                 public EffectorDeadband
 {
 public:
     SOFA_CLASS(SOFA_TEMPLATE(Effector,DataTypes), softrobots::behavior::SoftRobotsConstraint<DataTypes>);
@@ -50,6 +53,14 @@ public:
     Effector(sofa::core::behavior::MechanicalState<DataTypes> *mm = nullptr);
     ~Effector() override;
 
+    /////////////// Inherited from EffectorPriority ////////////
+    unsigned int getPriority() const override {return d_priority.getValue();}
+    ///////////////////////////////////////////////////////////////
+
+    /////////////// Inherited from EffectorDeadband ////////////
+    double getDeadband() const override {return d_deadband.getValue();}
+    ///////////////////////////////////////////////////////////////
+
     ////////////////////////// Inherited attributes ////////////////////////////
     /// https://gcc.gnu.org/onlinedocs/gcc/Name-lookup.html
     /// Bring inherited attributes and function in the current lookup context.
@@ -64,9 +75,28 @@ protected:
     sofa::Data<bool>   d_limitShiftToTarget;
     sofa::Data<Real>   d_maxShiftToTarget;
     sofa::Data<Real>   d_maxSpeed;
+    sofa::Data<unsigned int> d_priority;
+    sofa::Data<Real>   d_deadband;
+
+    /// Limits of the targets, read once from the Data for a whole pass over the targets of the step
+    struct TargetLimits
+    {
+        bool hasShiftLimit{false};
+        Real maxShift{0.};
+        bool hasSpeedLimit{false};
+        Real stepMaxDisplacement{0.};
+
+        bool isActive() const {return hasShiftLimit || hasSpeedLimit;}
+    };
+
+    TargetLimits getTargetLimits() const;
 
     SReal getTarget(const Real& target, const Real& current);
     Coord getTarget(const Coord& target, const Coord& current);
+
+    /// Same as above with the limits of the step, to be used in the loops over the targets
+    static Real getTarget(const TargetLimits& limits, const Real& target, const Real& current);
+    static Coord getTarget(const TargetLimits& limits, const Coord& target, const Coord& current);
 };
 
 #if !defined(SOFTROBOTS_INVERSE_EFFECTOR_CPP)
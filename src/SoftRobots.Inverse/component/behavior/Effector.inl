@@ -29,6 +29,7 @@
 #pragma once
 
 #include <SoftRobots.Inverse/component/behavior/Effector.h>
+#include <algorithm>
 
 namespace softrobotsinverse::behavior
 {
@@ -43,6 +44,16 @@ Effector<DataTypes>::Effector(sofa::core::behavior::MechanicalState<DataTypes> *
                                                                                      "is set to true."))
 
     , d_maxSpeed(initData(&d_maxSpeed, Real(0.), "maxSpeed", "Limit the effector motion to a maximum speed."))
+
+    , d_priority(initData(&d_priority, (unsigned int)0, "priority", "Priority level of the effector, 0 being the highest. \n"
+                                                                  "With several levels, the effectors of a level are only \n"
+                                                                  "minimized within the freedom left by the levels before \n"
+                                                                  "(without contact). Default value 0."))
+
+    , d_deadband(initData(&d_deadband, Real(0.), "deadband", "If greater than 0, the effector is left out of the \n"
+                                                             "objective at the steps where its distance to the goal \n"
+                                                             "at the free motion is at most this value. \n"
+                                                             "Default value 0 (always in the objective)."))
 {
     m_constraintType = EFFECTOR;
 }
@@ -53,46 +64,61 @@ Effector<DataTypes>::~Effector()
 }
 
 template<class DataTypes>
-SReal Effector<DataTypes>:: getTarget(const Real& target, const Real& current)
+typename Effector<DataTypes>::TargetLimits Effector<DataTypes>::getTargetLimits() const
 {
-    Real newTarget = target;
-    if(d_limitShiftToTarget.getValue())
-    {
-        Real shift = abs(target-current);
-        if(shift>d_maxShiftToTarget.getValue())
-        {
-            if(target>current)
-                newTarget = current + d_maxShiftToTarget.getValue();
-            else
-                newTarget = current - d_maxShiftToTarget.getValue();
-        }
-    }
+    TargetLimits limits;
+    limits.hasShiftLimit = d_limitShiftToTarget.getValue();
+    limits.maxShift = d_maxShiftToTarget.getValue();
+    limits.hasSpeedLimit = d_maxSpeed.isSet();
+    limits.stepMaxDisplacement = d_maxSpeed.getValue() * this->getContext()->getDt();
+    return limits;
+}
 
-    return newTarget;
+template<class DataTypes>
+SReal Effector<DataTypes>:: getTarget(const Real& target, const Real& current)
+{
+    return getTarget(getTargetLimits(), target, current);
 }
 
 template<class DataTypes>
 typename DataTypes::Coord Effector<DataTypes>:: getTarget(const Coord& target, const Coord& current)
 {
+    return getTarget(getTargetLimits(), target, current);
+}
+
+template<class DataTypes>
+typename DataTypes::Real Effector<DataTypes>::getTarget(const TargetLimits& limits, const Real& target, const Real& current)
+{
+    if(!limits.hasShiftLimit)
+        return target;
+
+    return current + std::min(std::max(Real(target-current), -limits.maxShift), limits.maxShift);
+}
+
+template<class DataTypes>
+typename DataTypes::Coord Effector<DataTypes>::getTarget(const TargetLimits& limits, const Coord& target, const Coord& current)
+{
+    if(!limits.isActive())
+        return target;
+
     Coord newTarget = target;
 
     auto direction = DataTypes::coordDifference(target, current);
     Real displacement = direction.norm();
-    Real stepMaxDisplacement = d_maxSpeed.getValue() * this->getContext()->getDt();
 
-    if (d_maxSpeed.isSet() && displacement > stepMaxDisplacement)
+    if (limits.hasSpeedLimit && displacement > limits.stepMaxDisplacement)
     {
         for(sofa::Size i=0; i<DataTypes::Coord::total_size; i++)
         {
-            newTarget[i] = current[i] + direction[i] / displacement * stepMaxDisplacement;
-            newTarget[i] = getTarget(newTarget[i], current[i]);
+            newTarget[i] = current[i] + direction[i] / displacement * limits.stepMaxDisplacement;
+            newTarget[i] = getTarget(limits, newTarget[i], current[i]);
         }
     }
-    else
+    else if(limits.hasShiftLimit)
     {
         for(sofa::Size i=0; i<DataTypes::Coord::total_size; i++)
         {
-            newTarget[i] = getTarget(target[i], current[i]);
+            newTarget[i] = getTarget(limits, target[i], current[i]);
         }
     }
 
@@ -0,0 +1,49 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+namespace softrobotsinverse::behavior
+{
+
+/**
+ *  \brief Deadband of an effector in the objective of QPInverseProblemSolver: at the steps where the distance
+ *  of the effector to its goal at the free motion (the norm of its rows of dfree) is at most the deadband,
+ *  its rows are left out of Q and c, as for a disabled effector, so that the assembly of the QP only visits
+ *  the effectors which are not converged.
+ */
+class EffectorDeadband
+{
+public:
+    virtual ~EffectorDeadband() = default;
+
+    /// Distance to the goal under which the effector is left out of the objective, 0 to always keep it
+    virtual double getDeadband() const = 0;
+};
+
+} // namespace
@@ -0,0 +1,52 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <sofa/type/vector.h>
+
+namespace softrobotsinverse::behavior
+{
+
+/**
+ *  \brief Weights S of the rows of an effector in the objective of QPInverseProblemSolver,
+ *  1/2 (Wea*lambda + dfree_e)^T S (Wea*lambda + dfree_e). They are applied when the QP is assembled,
+ *  Q = Wea^T S Wea and c = Wea^T S dfree_e, so changing them does not change the constraint rows
+ *  nor the compliance. S is block-diagonal, with symmetric positive semi-definite blocks.
+ */
+class EffectorWeights
+{
+public:
+    virtual ~EffectorWeights() = default;
+
+    /// Returns false when the rows are not weighted (S is the identity). Otherwise appends the blocks of S
+    /// to weights, in row-major order, one square block of blockSize per group of blockSize rows
+    virtual bool getRowWeights(unsigned int& blockSize, sofa::type::vector<double>& weights) const = 0;
+};
+
+} // namespace
@@ -0,0 +1,289 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+#include <sofa/type/Vec.h>
+#include <sofa/type/vector.h>
+
+namespace softrobotsinverse::behavior
+{
+
+/**
+ *  \brief Uniform grid over a point cloud (e.g. from a perception pipeline), to find the nearest point of the
+ *  cloud to a position without testing all of them.
+ *
+ *  The cells are hashed, only the occupied ones are stored. When the cloud changes with the same number of
+ *  points, only the points that left their cell are moved. The queries are const, they can be run concurrently
+ *  once the grid is updated.
+ */
+template<class DataTypes>
+class PointCloudGrid
+{
+public:
+    typedef typename DataTypes::VecCoord VecCoord;
+    typedef typename DataTypes::Coord Coord;
+    typedef typename DataTypes::Real Real;
+
+    static constexpr sofa::Size Dim = DataTypes::spatial_dimensions;
+    typedef sofa::type::Vec<Dim, int> Cell;
+
+    /// Updates the grid over the points, whose version is the counter of their Data. The grid is rebuilt if the
+    /// number of points or the requested cell size changed. With a cell size of 0, the size is chosen when the
+    /// grid is rebuilt, for about one point per cell in the bounding box of the points.
+    void update(const VecCoord& points, const int& counter, const Real& cellSize)
+    {
+        const bool rebuild = (cellSize != m_requestedCellSize || m_pointCells.size() != points.size());
+        if(!rebuild && counter == m_counter)
+            return;
+
+        m_requestedCellSize = cellSize;
+        m_counter = counter;
+        if(rebuild)
+        {
+            m_grid.clear();
+            m_pointCells.resize(points.size());
+            m_cellSize = (cellSize > 0)? cellSize : computeCellSize(points);
+            m_minCell.fill(std::numeric_limits<int>::max());
+            m_maxCell.fill(std::numeric_limits<int>::lowest());
+            for(unsigned int p=0; p<points.size(); p++)
+            {
+                const Cell cell = getCell(DataTypes::getCPos(points[p]));
+                extendBounds(cell);
+                m_pointCells[p] = getCellKey(cell);
+                m_grid[m_pointCells[p]].push_back(p);
+            }
+            return;
+        }
+
+        // Only move the points that changed cell
+        for(unsigned int p=0; p<points.size(); p++)
+        {
+            const Cell cell = getCell(DataTypes::getCPos(points[p]));
+            const long long key = getCellKey(cell);
+            if(key == m_pointCells[p])
+                continue;
+
+            sofa::type::vector<unsigned int>& previousCell = m_grid[m_pointCells[p]];
+            auto it = std::find(previousCell.begin(), previousCell.end(), p);
+            if(it != previousCell.end())
+            {
+                *it = previousCell.back();
+                previousCell.pop_back();
+            }
+            if(previousCell.empty())
+                m_grid.erase(m_pointCells[p]);
+
+            extendBounds(cell);
+            m_grid[key].push_back(p);
+            m_pointCells[p] = key;
+        }
+    }
+
+    /// Index of the point nearest to the position, within maxDistance if it is positive, -1 if there is none.
+    /// The points are the ones of the last update.
+    int findNearest(const Coord& position, const VecCoord& points, const Real& maxDistance = 0) const
+    {
+        if(m_grid.empty())
+            return -1;
+
+        const auto center = DataTypes::getCPos(position);
+        const Cell centerCell = getCell(center);
+
+        // The rings of cells around the cell of the position are visited outwards, from the first one reaching the
+        // occupied cells, until the points of the next ring are farther than the nearest one: a point of ring r is
+        // at least (r-1)*cellSize away
+        int minRing = 0, maxRing = 0;
+        for(sofa::Size d=0; d<Dim; d++)
+        {
+            minRing = std::max(minRing, std::max(m_minCell[d] - centerCell[d], centerCell[d] - m_maxCell[d]));
+            maxRing = std::max(maxRing, std::max(centerCell[d] - m_minCell[d], m_maxCell[d] - centerCell[d]));
+        }
+
+        int nearest = -1;
+        Real nearestDistance2 = (maxDistance > 0)? maxDistance*maxDistance : std::numeric_limits<Real>::max();
+        auto visitPoint = [&](const unsigned int& p)
+        {
+            const Real distance2 = (DataTypes::getCPos(points[p]) - center).norm2();
+            if(distance2 < nearestDistance2 || (distance2 == nearestDistance2 && nearest >= 0 && int(p) < nearest))
+            {
+                nearestDistance2 = distance2;
+                nearest = p;
+            }
+        };
+        auto visitCell = [&](const Cell& cell)
+        {
+            auto it = m_grid.find(getCellKey(cell));
+            if(it != m_grid.end())
+                for(const unsigned int& p : it->second)
+                    visitPoint(p);
+        };
+
+        for(int r=minRing; r<=maxRing; r++)
+        {
+            const Real ringDistance = (r-1)*m_cellSize;
+            if(r > 1 && ringDistance*ringDistance > nearestDistance2)
+                break;
+
+            // Far from the cloud, a ring has more cells than the grid: the points are tested directly
+            if(getNbRingCells(r) > (long long)m_grid.size())
+            {
+                for(unsigned int p=0; p<m_pointCells.size(); p++)
+                    visitPoint(p);
+                break;
+            }
+            visitRing(centerCell, r, visitCell);
+        }
+        return nearest;
+    }
+
+    Real getCellSize() const {return m_cellSize;}
+    sofa::Size getNbCells() const {return m_grid.size();}
+
+    void clear()
+    {
+        m_grid.clear();
+        m_pointCells.clear();
+        m_counter = -1;
+        m_requestedCellSize = -1;
+    }
+
+protected:
+
+    std::unordered_map<long long, sofa::type::vector<unsigned int>> m_grid;
+    sofa::type::vector<long long> m_pointCells;
+    Cell m_minCell; // bounds of the cells occupied since the last rebuild
+    Cell m_maxCell;
+    Real m_cellSize{1};
+    Real m_requestedCellSize{-1};
+    int m_counter{-1};
+
+    template<class Position>
+    Cell getCell(const Position& position) const
+    {
+        Cell cell;
+        for(sofa::Size d=0; d<Dim; d++)
+            cell[d] = int(std::floor(position[d]/m_cellSize));
+        return cell;
+    }
+
+    static long long getCellKey(const Cell& cell)
+    {
+        // 21 bits per coordinate, unique as long as the cloud spans less than a million cells per axis
+        const long long mask = (1LL<<21)-1;
+        long long key = 0;
+        for(sofa::Size d=0; d<Dim; d++)
+            key = (key << 21) | (cell[d] & mask);
+        return key;
+    }
+
+    void extendBounds(const Cell& cell)
+    {
+        for(sofa::Size d=0; d<Dim; d++)
+        {
+            m_minCell[d] = std::min(m_minCell[d], cell[d]);
+            m_maxCell[d] = std::max(m_maxCell[d], cell[d]);
+        }
+    }
+
+    static Real computeCellSize(const VecCoord& points)
+    {
+        if(points.empty())
+            return 1;
+
+        auto min = DataTypes::getCPos(points[0]);
+        auto max = min;
+        for(const Coord& point : points)
+        {
+            const auto position = DataTypes::getCPos(point);
+            for(sofa::Size d=0; d<Dim; d++)
+            {
+                min[d] = std::min(min[d], position[d]);
+                max[d] = std::max(max[d], position[d]);
+            }
+        }
+
+        Real extent = 0;
+        for(sofa::Size d=0; d<Dim; d++)
+            extent = std::max(extent, Real(max[d] - min[d]));
+        const Real cellSize = extent / std::ceil(std::pow(Real(points.size()), Real(1)/Dim));
+        return (cellSize > 0)? cellSize : 1;
+    }
+
+    static long long getNbRingCells(const int& r)
+    {
+        long long outer = 1, inner = 1;
+        for(sofa::Size d=0; d<Dim; d++)
+        {
+            outer *= 2*r+1;
+            inner *= std::max(2*r-1, 0);
+        }
+        return outer - inner;
+    }
+
+    /// Visits the cells at the Chebyshev distance r of the center
+    template<class Visitor>
+    static void visitRing(const Cell& center, const int& r, Visitor& visit)
+    {
+        Cell cell;
+        if constexpr (Dim == 2)
+        {
+            for(int dx=-r; dx<=r; dx++)
+            {
+                const int step = (dx == -r || dx == r || r == 0)? 1 : 2*r;
+                for(int dy=-r; dy<=r; dy+=step)
+                {
+                    cell[0] = center[0] + dx;
+                    cell[1] = center[1] + dy;
+                    visit(cell);
+                }
+            }
+        }
+        else
+        {
+            for(int dx=-r; dx<=r; dx++)
+                for(int dy=-r; dy<=r; dy++)
+                {
+                    const int step = (dx == -r || dx == r || dy == -r || dy == r || r == 0)? 1 : 2*r;
+                    for(int dz=-r; dz<=r; dz+=step)
+                    {
+                        cell[0] = center[0] + dx;
+                        cell[1] = center[1] + dy;
+                        cell[2] = center[2] + dz;
+                        visit(cell);
+                    }
+                }
+        }
+    }
+};
+
+} // namespace
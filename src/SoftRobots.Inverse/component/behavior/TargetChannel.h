@@ -0,0 +1,141 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <sofa/type/vector.h>
+
+namespace softrobotsinverse::behavior
+{
+
+/**
+ *  \brief Channel of targets (setpoints) from one producer thread (e.g. a teleoperation loop at 1 kHz)
+ *  to the simulation, without lock and without the Data machinery.
+ *
+ *  It is a triple buffer: write() fills the slot of the producer and swaps it with the shared slot,
+ *  read() swaps the shared slot with the one of the consumer if a new setpoint was written. Only the
+ *  latest setpoint is kept, once the buffers have their size neither side allocates nor waits.
+ *  If the setpoints are timestamped (in simulation time), read() interpolates between the last two
+ *  setpoints it received, and holds the latest one after its timestamp.
+ */
+template<class DataTypes>
+class TargetChannel
+{
+public:
+    typedef typename DataTypes::Coord Coord;
+    typedef typename DataTypes::Real Real;
+
+    /// Producer thread. A negative timestamp disables the interpolation.
+    void write(const Coord* targets, const size_t& nbTargets, const double& timestamp = -1.)
+    {
+        Setpoint& setpoint = m_slots[m_back];
+        setpoint.targets.assign(targets, targets + nbTargets);
+        setpoint.timestamp = timestamp;
+        m_back = m_shared.exchange(m_back | s_isNew, std::memory_order_acq_rel) & s_index;
+    }
+
+    void write(const sofa::type::vector<Coord>& targets, const double& timestamp = -1.)
+    {
+        write(targets.data(), targets.size(), timestamp);
+    }
+
+    /// Consumer thread. Targets at the given time, false if no setpoint was ever written.
+    bool read(const double& time, sofa::type::vector<Coord>& targets)
+    {
+        if(m_shared.load(std::memory_order_acquire) & s_isNew)
+        {
+            if(m_hasLatest)
+            {
+                std::swap(m_previous.targets, m_slots[m_front].targets);
+                m_previous.timestamp = m_slots[m_front].timestamp;
+                m_hasPrevious = true;
+            }
+            m_front = m_shared.exchange(m_front, std::memory_order_acq_rel) & s_index;
+            m_hasLatest = true;
+        }
+
+        if(!m_hasLatest)
+            return false;
+
+        const Setpoint& latest = m_slots[m_front];
+        targets.resize(latest.targets.size());
+        const bool isInterpolated = m_hasPrevious && m_previous.timestamp >= 0. && latest.timestamp > m_previous.timestamp
+                                    && time < latest.timestamp && m_previous.targets.size() == latest.targets.size();
+        if(!isInterpolated)
+        {
+            std::copy(latest.targets.begin(), latest.targets.end(), targets.begin());
+            return true;
+        }
+
+        const Real alpha = std::max(0., (time - m_previous.timestamp) / (latest.timestamp - m_previous.timestamp));
+        m_coefs.resize(2);
+        m_coefs[0] = 1 - alpha;
+        m_coefs[1] = alpha;
+        m_ancestors.resize(2);
+        for(size_t i=0; i<targets.size(); i++)
+        {
+            m_ancestors[0] = m_previous.targets[i];
+            m_ancestors[1] = latest.targets[i];
+            targets[i] = DataTypes::interpolate(m_ancestors, m_coefs);
+        }
+        return true;
+    }
+
+    /// Consumer thread. Forgets the setpoints received.
+    void clear()
+    {
+        m_hasLatest = false;
+        m_hasPrevious = false;
+    }
+
+protected:
+
+    struct Setpoint{
+        sofa::type::vector<Coord> targets;
+        double timestamp{-1.};
+    };
+
+    static constexpr unsigned int s_index{3};
+    static constexpr unsigned int s_isNew{4};
+
+    Setpoint m_slots[3];
+    std::atomic<unsigned int> m_shared{2}; // slot shared by the threads, with the flag of a new setpoint
+    unsigned int m_back{0};  // slot of the producer
+    unsigned int m_front{1}; // slot of the consumer, the latest setpoint received
+
+    // Consumer side
+    Setpoint m_previous;
+    bool m_hasLatest{false};
+    bool m_hasPrevious{false};
+    sofa::type::vector<Coord> m_ancestors;
+    sofa::type::vector<Real> m_coefs;
+};
+
+} // namespace
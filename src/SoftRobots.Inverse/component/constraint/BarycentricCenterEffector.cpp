@@ -50,35 +50,35 @@ void BarycentricCenterEffector<Rigid3Types>::buildConstraintMatrix(const Constra
 
     m_constraintId = cIndex;
 
-    const unsigned int nbp = m_state->getSize();
+    if(m_nbPoints != m_state->getSize())
+        computeWeights(m_state->getSize());
 
     MatrixDeriv& matrix = *cMatrix.beginEdit();
 
     unsigned int index = 0;
-    const Vec<3, Real> cx(1.0/Real(nbp),0,0), cy(0,1.0/Real(nbp),0), cz(0,0,1.0/Real(nbp));
     const Vec<3, Real> vZero(0,0,0);
 
     if(d_axis.getValue()[0])
     {
         MatrixDerivRowIterator rowIterator = matrix.writeLine(m_constraintId+index);
-        for (unsigned int i=0; i<nbp; i++)
-            rowIterator.setCol(i, Deriv(cx,vZero));
+        for (unsigned int k=0; k<m_indices.size(); k++)
+            rowIterator.setCol(m_indices[k], Deriv(Vec<3, Real>(m_weights[k],0,0),vZero));
         index++;
     }
 
     if(d_axis.getValue()[1])
     {
         MatrixDerivRowIterator rowIterator = matrix.writeLine(m_constraintId+index);
-        for (unsigned int i=0; i<nbp; i++)
-            rowIterator.setCol(i, Deriv(cy,vZero));
+        for (unsigned int k=0; k<m_indices.size(); k++)
+            rowIterator.setCol(m_indices[k], Deriv(Vec<3, Real>(0,m_weights[k],0),vZero));
         index++;
     }
 
     if(d_axis.getValue()[2])
     {
         MatrixDerivRowIterator rowIterator = matrix.writeLine(m_constraintId+index);
-        for (unsigned int i=0; i<nbp; i++)
-            rowIterator.setCol(i, Deriv(cz,vZero));
+        for (unsigned int k=0; k<m_indices.size(); k++)
+            rowIterator.setCol(m_indices[k], Deriv(Vec<3, Real>(0,0,m_weights[k]),vZero));
         index++;
     }
 
@@ -86,6 +86,7 @@ void BarycentricCenterEffector<Rigid3Types>::buildConstraintMatrix(const Constra
 
     cMatrix.endEdit();
     m_nbLines = cIndex - m_constraintId;
+    setRowsBuilt();
 }
 
 
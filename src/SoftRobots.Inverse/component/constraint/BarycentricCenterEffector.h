@@ -29,6 +29,9 @@
 #pragma once
 
 #include <SoftRobots.Inverse/component/behavior/Effector.h>
+#include <SoftRobots.Inverse/component/behavior/ConcurrentResults.h>
+#include <SoftRobots.Inverse/component/behavior/ConstantRows.h>
+#include <SoftRobots.Inverse/component/behavior/DrawBuffer.h>
 
 namespace softrobotsinverse::constraint
 {
@@ -45,7 +48,8 @@ namespace softrobotsinverse::constraint
  * https://softrobotscomponents.readthedocs.io
 */
 template<class DataTypes>
-class BarycentricCenterEffector : public Effector<DataTypes>
+class BarycentricCenterEffector : public Effector<DataTypes>, public softrobotsinverse::behavior::ConcurrentResults,
+                                  public softrobotsinverse::behavior::ConstantRows
 {
 public:
     SOFA_CLASS(SOFA_TEMPLATE(BarycentricCenterEffector,DataTypes),
@@ -105,6 +109,11 @@ public:
     void storeResults(sofa::type::vector<double> &delta) override;
     ///////////////////////////////////////////////////////////////////////////
 
+    /////////////// Inherited from ConstantRows ////////////////////////////
+    bool hasConstantRows() const override;
+    void keepRows() override;
+    ///////////////////////////////////////////////////////////////////////////
+
 protected:
 
     ////////////////////////// Inherited attributes ////////////////////////////
@@ -125,10 +134,28 @@ protected:
     sofa::Data<Coord >       d_barycenter;
 
     sofa::Data<sofa::type::vector<double>> d_delta;
+    sofa::Data<sofa::type::vector<unsigned int>> d_indices;
+    sofa::Data<sofa::type::vector<Real>>         d_weights;
+
+    // Points of the barycenter and their normalized weights, the only entries of the constraint rows
+    sofa::type::vector<unsigned int> m_indices;
+    sofa::type::vector<Real>         m_weights;
+    unsigned int                     m_nbPoints{0};
+
+    // Sources of the rows at their last build (see ConstantRows)
+    unsigned int                     m_nbWeightsUpdates{0};
+    unsigned int                     m_builtWeightsUpdates{0};
+    int                              m_builtAxisCounter{-1};
+    void setRowsBuilt();
+
+    // Point of the barycenter, rebuilt when d_barycenter changes
+    softrobotsinverse::behavior::DrawBuffer m_barycenterBuffer;
 
     void initData();
 
+    void computeWeights(const unsigned int nbPoints);
     void computeBarycenter();
+    Coord getBarycenter(const VecCoord& positions) const;
 };
 
 template<> SOFA_SOFTROBOTS_INVERSE_API
@@ -66,6 +66,15 @@ BarycentricCenterEffector<DataTypes>::BarycentricCenterEffector(MechanicalState*
 
     , d_delta(initData(&d_delta,"delta",
                             "Distance to target" ))
+
+    , d_indices(initData(&d_indices,"indices",
+                         "Indices of the points of the barycenter. \n"
+                         "If unspecified, all the points of the mechanical state are used."))
+
+    , d_weights(initData(&d_weights,"weights",
+                         "Weights of the points in the barycenter, one per index (or per point \n"
+                         "if no indices are given). They are normalized, and the points of  \n"
+                         "zero weight are not in the constraint. If unspecified, uniform weights."))
 {
 }
 
@@ -105,18 +114,78 @@ void BarycentricCenterEffector<DataTypes>::reset()
 }
 
 template<class DataTypes>
-void BarycentricCenterEffector<DataTypes>::computeBarycenter()
+void BarycentricCenterEffector<DataTypes>::computeWeights(const unsigned int nbPoints)
+{
+    const vector<unsigned int>& indices = d_indices.getValue();
+    const vector<Real>& weights = d_weights.getValue();
+    const unsigned int nbIndices = (indices.empty())? nbPoints : indices.size();
+
+    bool useWeights = !weights.empty();
+    if(useWeights && weights.size() != nbIndices)
+    {
+        msg_warning() << "The number of weights (" << weights.size() << ") is not the number of points ("
+                      << nbIndices << "). Set uniform weights.";
+        useWeights = false;
+    }
+
+    m_indices.clear();
+    m_weights.clear();
+    m_nbPoints = nbPoints;
+    m_nbWeightsUpdates++;
+
+    Real totalWeight = 0;
+    for (unsigned int k=0; k<nbIndices; k++)
+    {
+        unsigned int index = (indices.empty())? k : indices[k];
+        if(index >= nbPoints)
+        {
+            msg_error() << "Index " << index << " is too large regarding mechanicalState size of (" << nbPoints << ").";
+            continue;
+        }
+
+        Real weight = (useWeights)? weights[k] : Real(1);
+        if(weight == 0)
+            continue;
+
+        m_indices.push_back(index);
+        m_weights.push_back(weight);
+        totalWeight += weight;
+    }
+
+    if(totalWeight == 0)
+    {
+        if(nbIndices > 0)
+            msg_error() << "The sum of the weights is zero, the barycenter is not defined.";
+        m_indices.clear();
+        m_weights.clear();
+        return;
+    }
+
+    for (Real& weight : m_weights)
+        weight /= totalWeight;
+}
+
+template<class DataTypes>
+typename DataTypes::Coord BarycentricCenterEffector<DataTypes>::getBarycenter(const VecCoord& positions) const
 {
-    ReadAccessor<sofa::Data<VecCoord> > positions = m_state->readPositions();
-    const unsigned int nbp = m_state->getSize();
     Coord barycenter = Coord();
-    for (unsigned int i=0; i<nbp; i++)
+    for (unsigned int k=0; k<m_indices.size(); k++)
     {
-        barycenter[0] += positions[i][0]/Real(nbp);
-        barycenter[1] += positions[i][1]/Real(nbp);
-        barycenter[2] += positions[i][2]/Real(nbp);
+        const Coord& position = positions[m_indices[k]];
+        barycenter[0] += position[0]*m_weights[k];
+        barycenter[1] += position[1]*m_weights[k];
+        barycenter[2] += position[2]*m_weights[k];
     }
-    d_barycenter.setValue(barycenter);
+    return barycenter;
+}
+
+template<class DataTypes>
+void BarycentricCenterEffector<DataTypes>::computeBarycenter()
+{
+    ReadAccessor<sofa::Data<VecCoord> > positions = m_state->readPositions();
+    if(m_nbPoints != m_state->getSize())
+        computeWeights(m_state->getSize());
+    d_barycenter.setValue(getBarycenter(positions.ref()));
 }
 
 template<class DataTypes>
@@ -133,6 +202,9 @@ void BarycentricCenterEffector<DataTypes>::initData()
         d_axis.setValue(sofa::type::Vec<3,bool>(true,true,true));
         msg_warning() << "Axis = (0, 0, 0). No direction given. Set default to (1, 1, 1).";
     }
+
+    if(m_state != nullptr)
+        computeWeights(m_state->getSize());
 }
 
 template<class DataTypes>
@@ -146,7 +218,8 @@ void BarycentricCenterEffector<DataTypes>::buildConstraintMatrix(const Constrain
 
     m_constraintId = cIndex;
 
-    const unsigned int nbp = m_state->getSize();
+    if(m_nbPoints != m_state->getSize())
+        computeWeights(m_state->getSize());
 
     MatrixDeriv& matrix = *cMatrix.beginEdit();
 
@@ -155,24 +228,24 @@ void BarycentricCenterEffector<DataTypes>::buildConstraintMatrix(const Constrain
     if(d_axis.getValue()[0])
     {
         MatrixDerivRowIterator rowIterator = matrix.writeLine(m_constraintId+index);
-        for (unsigned int i=0; i<nbp; i++)
-            rowIterator.setCol(i, Deriv(1.0/Real(nbp), 0, 0));
+        for (unsigned int k=0; k<m_indices.size(); k++)
+            rowIterator.setCol(m_indices[k], Deriv(m_weights[k], 0, 0));
         index++;
     }
 
     if(d_axis.getValue()[1])
     {
         MatrixDerivRowIterator rowIterator = matrix.writeLine(m_constraintId+index);
-        for (unsigned int i=0; i<nbp; i++)
-            rowIterator.setCol(i, Deriv(0, 1.0/Real(nbp), 0));
+        for (unsigned int k=0; k<m_indices.size(); k++)
+            rowIterator.setCol(m_indices[k], Deriv(0, m_weights[k], 0));
         index++;
     }
 
     if(d_axis.getValue()[2])
     {
         MatrixDerivRowIterator rowIterator = matrix.writeLine(m_constraintId+index);
-        for (unsigned int i=0; i<nbp; i++)
-            rowIterator.setCol(i, Deriv(0, 0, 1.0/Real(nbp)));
+        for (unsigned int k=0; k<m_indices.size(); k++)
+            rowIterator.setCol(m_indices[k], Deriv(0, 0, m_weights[k]));
         index++;
     }
 
@@ -180,7 +253,29 @@ void BarycentricCenterEffector<DataTypes>::buildConstraintMatrix(const Constrain
 
     cMatrix.endEdit();
     m_nbLines = cIndex - m_constraintId;
+    setRowsBuilt();
+
+    computeBarycenter();
+}
+
+template<class DataTypes>
+void BarycentricCenterEffector<DataTypes>::setRowsBuilt()
+{
+    m_builtWeightsUpdates = m_nbWeightsUpdates;
+    m_builtAxisCounter = d_axis.getCounter();
+}
+
+template<class DataTypes>
+bool BarycentricCenterEffector<DataTypes>::hasConstantRows() const
+{
+    // The rows are the weights of the points, whatever their positions
+    return m_builtAxisCounter == d_axis.getCounter() && m_builtWeightsUpdates == m_nbWeightsUpdates
+            && m_nbPoints == m_state->getSize();
+}
 
+template<class DataTypes>
+void BarycentricCenterEffector<DataTypes>::keepRows()
+{
     computeBarycenter();
 }
 
@@ -191,16 +286,8 @@ void BarycentricCenterEffector<DataTypes>::getConstraintViolation(const Constrai
 {
     SOFA_UNUSED(cParams);
 
-    const unsigned int nbp = m_state->getSize();
     ReadAccessor<sofa::Data<VecCoord> > x = m_state->readPositions();
-
-    Coord barycenter = Coord();
-    for (unsigned int i=0; i<nbp; i++)
-    {
-        barycenter[0] += x[i][0]/Real(nbp);
-        barycenter[1] += x[i][1]/Real(nbp);
-        barycenter[2] += x[i][2]/Real(nbp);
-    }
+    Coord barycenter = getBarycenter(x.ref());
 
     Coord effectorGoal = getTarget(d_effectorGoalPosition.getValue(), barycenter);
     Coord dFree = barycenter - effectorGoal;
@@ -241,10 +328,12 @@ void BarycentricCenterEffector<DataTypes>::draw(const VisualParams* vparams)
     if (!vparams->displayFlags().getShowInteractionForceFields()) return;
     if(!d_drawBarycenter.getValue()) return;
 
-    Coord barycenter = d_barycenter.getValue();
-    vector<Vec3> points;
-    points.push_back(Vec3(barycenter[0], barycenter[1], barycenter[2]));
-    vparams->drawTool()->drawPoints(points, float(5.), RGBAColor(0.0f,0.0f,1.0f,1.0f));
+    if(m_barycenterBuffer.update({d_barycenter.getCounter()}))
+    {
+        const Coord& barycenter = d_barycenter.getValue();
+        m_barycenterBuffer.points.push_back(Vec3(barycenter[0], barycenter[1], barycenter[2]));
+    }
+    vparams->drawTool()->drawPoints(m_barycenterBuffer.points, float(5.), RGBAColor(0.0f,0.0f,1.0f,1.0f));
 }
 
 } // namespace
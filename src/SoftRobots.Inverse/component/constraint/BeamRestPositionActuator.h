@@ -110,9 +110,25 @@ protected:
     unsigned int                        m_columnId;
 
     Data<defaulttype::Vec<3,bool>>      d_actuationDirection;
+    Data<unsigned int>                  d_nbBasisFunctions;
+    Data<helper::vector<Real>>          d_basis;
 
     AdaptiveBeamForceFieldAndMass< DataTypes > * m_beamForceField;
     helper::vector<Real> m_beamLengthList;
+    helper::vector<helper::vector<Real>> m_basis;
+
+    void initBasis();
+
+    /// Writes the rows of a direction from the Jacobian of each point, from the row columnIndex: one row per
+    /// point, or one row per basis function combining the Jacobians of the points (phi_k(i) J[i])
+    void addJacobianRows(MatrixDeriv &column,
+                         unsigned int &columnIndex,
+                         const VecDeriv &J);
+
+    /// Rest rotation of the beam in a direction, from the variables of this direction starting at offset
+    Real getRestAngle(const vector<double>& lambda,
+                      const unsigned int& offset,
+                      const unsigned int& beamId);
 
     ////////////////////////// Inherited attributes ////////////////////////////
     /// https://gcc.gnu.org/onlinedocs/gcc/Name-lookup.html
@@ -126,6 +142,10 @@ private:
     void initLimit();
     void initBeamLenght();
 
+    void getJacobians(VecDeriv &J,
+                      const Vec3 &axis,
+                      const DataVecCoord &x);
+
     void getLocalJacobian(Deriv &J,
                           Deriv &dr,
                           int index,
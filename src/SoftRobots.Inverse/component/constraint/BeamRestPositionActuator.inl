@@ -30,6 +30,8 @@
 #include <sofa/helper/gl/template.h>
 #include <sofa/helper/rmath.h>
 
+#include <algorithm>
+
 
 namespace sofa
 {
@@ -62,6 +64,15 @@ BeamRestPositionActuator<DataTypes>::BeamRestPositionActuator(MechanicalState* o
 
     , d_actuationDirection(initData(&d_actuationDirection, Vec<3,bool>(1,1,1), "direction","Direction of actuation. Default y and z i.e (1,1).\n"
                                     "If no direction given i.e (0,0,0): (1,1,1) will be considered."))
+
+    , d_nbBasisFunctions(initData(&d_nbBasisFunctions, (unsigned int)0, "nbBasisFunctions","Number of basis functions of the rest curvature profile, for each direction. \n"
+                                  "The rest rotation of each node is a combination of the basis functions, with one \n"
+                                  "actuation variable per function and per direction. If 0, there is one variable per \n"
+                                  "node and per direction. Default value 0."))
+
+    , d_basis(initData(&d_basis, "basis","Weights of the basis functions at the nodes of the beam, function after function \n"
+                       "(nbBasisFunctions times the number of beams). If empty, the functions are hat functions \n"
+                       "evenly spaced along the rest length of the beam. Default value empty."))
 {
 }
 
@@ -69,6 +80,15 @@ template<class DataTypes>
 BeamRestPositionActuator<DataTypes>::BeamRestPositionActuator()
     : d_actuationDirection(initData(&d_actuationDirection, Vec<3,bool>(1,1,1), "direction","Direction of actuation. Default y and z i.e (1,1).\n"
                                     "If no direction given i.e (0,0,0): (1,1,1) will be considered."))
+
+    , d_nbBasisFunctions(initData(&d_nbBasisFunctions, (unsigned int)0, "nbBasisFunctions","Number of basis functions of the rest curvature profile, for each direction. \n"
+                                  "The rest rotation of each node is a combination of the basis functions, with one \n"
+                                  "actuation variable per function and per direction. If 0, there is one variable per \n"
+                                  "node and per direction. Default value 0."))
+
+    , d_basis(initData(&d_basis, "basis","Weights of the basis functions at the nodes of the beam, function after function \n"
+                       "(nbBasisFunctions times the number of beams). If empty, the functions are hat functions \n"
+                       "evenly spaced along the rest length of the beam. Default value empty."))
 {
 }
 
@@ -85,6 +105,7 @@ void BeamRestPositionActuator<DataTypes>::init()
     Inherit::init();
     initLimit();
     initBeamLenght();
+    initBasis();
 }
 
 
@@ -93,6 +114,7 @@ void BeamRestPositionActuator<DataTypes>::reinit()
 {
     initLimit();
     initBeamLenght();
+    initBasis();
 }
 
 
@@ -108,6 +130,7 @@ void BeamRestPositionActuator<DataTypes>::initBeamLenght()
 {
     ReadAccessor<Data<VecCoord> > restPosition = m_state->read(core::VecCoordId::restPosition());
 
+    m_beamLengthList.clear();
     for (int i=1; i<m_state->getSize(); i++)
     {
         double length = getBeamLength(restPosition[i-1], restPosition[i]);
@@ -136,6 +159,61 @@ void BeamRestPositionActuator<DataTypes>::bwdInit()
     }
 
     initBeamLenght();
+    initBasis();
+}
+
+
+template<class DataTypes>
+void BeamRestPositionActuator<DataTypes>::initBasis()
+{
+    m_basis.clear();
+
+    unsigned int nbFunctions = d_nbBasisFunctions.getValue();
+    unsigned int nbBeams = m_beamLengthList.size();
+    if(nbFunctions == 0 || nbBeams == 0)
+        return;
+
+    const helper::vector<Real>& basis = d_basis.getValue();
+    if(!basis.empty())
+    {
+        if(basis.size() == nbFunctions*nbBeams)
+        {
+            m_basis.resize(nbFunctions);
+            for (unsigned int k=0; k<nbFunctions; k++)
+                m_basis[k].assign(basis.begin()+k*nbBeams, basis.begin()+(k+1)*nbBeams);
+            return;
+        }
+
+        msg_warning(this) << "The size of basis (" << basis.size() << ") should be nbBasisFunctions times the number of beams ("
+                          << nbFunctions*nbBeams << "). Evenly spaced hat functions will be used instead.";
+    }
+
+    // Hat functions of the curvilinear abscissa of the nodes, evenly spaced from the first to the last node
+    helper::vector<Real> abscissa(nbBeams);
+    Real length = 0.;
+    for (unsigned int i=0; i<nbBeams; i++)
+    {
+        length += m_beamLengthList[i];
+        abscissa[i] = length;
+    }
+
+    m_basis.resize(nbFunctions, helper::vector<Real>(nbBeams, 0.));
+    for (unsigned int k=0; k<nbFunctions; k++)
+    {
+        if(nbFunctions == 1)
+        {
+            std::fill(m_basis[k].begin(), m_basis[k].end(), 1.);
+            continue;
+        }
+
+        Real width  = (abscissa.back()-abscissa.front())/(nbFunctions-1);
+        Real center = abscissa.front() + k*width;
+        for (unsigned int i=0; i<nbBeams; i++)
+        {
+            Real weight = (width > 0.) ? 1. - std::abs(abscissa[i]-center)/width : 1.;
+            m_basis[k][i] = std::max(weight, (Real)0.);
+        }
+    }
 }
 
 
@@ -152,62 +230,88 @@ void BeamRestPositionActuator<DataTypes>::buildConstraintMatrix(const Constraint
     MatrixDeriv& column = *column_d.beginEdit();
     column.begin();
 
-    int index = 0;
-    double eps = 0.000001;
+    // Rows in the order y, z, x
+    const int directionIds[3] = {1, 2, 0};
+    const Vec3 axes[3] = {Vec3(0.,1.,0.), Vec3(0.,0.,1.), Vec3(1.,0.,0.)};
 
-    if(d_actuationDirection.getValue()[1]) // Actuation around y axis
+    for (unsigned int d=0; d<3; d++)
     {
-        for (unsigned int i=1; i<m_state->getSize(); i++)
-        {
-            // Get the Jacobian for each point
-            Deriv dy = Deriv(Vec3(0.,0.,0.),Vec3(0.,eps,0.));
-            Deriv Jy;
-            getLocalJacobian(Jy, dy, i, eps, x);
+        if(!d_actuationDirection.getValue()[directionIds[d]])
+            continue;
 
-            // Fill the constraint matrix
-            MatrixDerivRowIterator rowIterator_dy = column.writeLine(m_columnId+index++);
-            rowIterator_dy.setCol(i, Jy);
+        // Get the Jacobian for each point
+        VecDeriv J;
+        getJacobians(J, axes[d], x);
 
-            columnIndex++;
-        }
+        // Fill the constraint matrix
+        addJacobianRows(column, columnIndex, J);
     }
 
-    if(d_actuationDirection.getValue()[2]) // Actuation around z axis
+    column_d.endEdit();
+    m_nbLines = columnIndex - m_columnId;
+}
+
+
+template<class DataTypes>
+void BeamRestPositionActuator<DataTypes>::addJacobianRows(MatrixDeriv &column,
+                                                          unsigned int &columnIndex,
+                                                          const VecDeriv &J)
+{
+    if(m_basis.empty())
     {
-        for (unsigned int i=1; i<m_state->getSize(); i++)
+        for (unsigned int i=1; i<J.size(); i++)
         {
-            // Get the Jacobian for each point
-            Deriv dz = Deriv(Vec3(0.,0.,0.),Vec3(0.,0.,eps));
-            Deriv Jz;
-            getLocalJacobian(Jz, dz, i, eps, x);
-
-            // Fill the constraint matrix
-            MatrixDerivRowIterator rowIterator_dz = column.writeLine(m_columnId+index++);
-            rowIterator_dz.setCol(i, Jz);
+            MatrixDerivRowIterator rowIterator = column.writeLine(columnIndex);
+            rowIterator.setCol(i, J[i]);
 
             columnIndex++;
         }
     }
-
-    if(d_actuationDirection.getValue()[0]) // Actuation around x axis
+    else // One row per basis function, combining the Jacobians of the nodes
     {
-        for (unsigned int i=1; i<m_state->getSize(); i++)
+        for (unsigned int k=0; k<m_basis.size(); k++)
         {
-            // Get the Jacobian for each point
-            Deriv dx = Deriv(Vec3(0.,0.,0.),Vec3(eps,0.,0.));
-            Deriv Jx;
-            getLocalJacobian(Jx, dx, i, eps, x);
-
-            // Fill the constraint matrix
-            MatrixDerivRowIterator rowIterator_dx = column.writeLine(m_columnId+index++);
-            rowIterator_dx.setCol(i, Jx);
+            MatrixDerivRowIterator rowIterator = column.writeLine(columnIndex);
+            for (unsigned int i=1; i<J.size(); i++)
+                if(m_basis[k][i-1] != 0.)
+                    rowIterator.setCol(i, J[i]*m_basis[k][i-1]);
 
             columnIndex++;
         }
     }
+}
 
-    column_d.endEdit();
-    m_nbLines = columnIndex - m_columnId;
+
+template<class DataTypes>
+typename BeamRestPositionActuator<DataTypes>::Real BeamRestPositionActuator<DataTypes>::getRestAngle(const vector<double>& lambda,
+                                                                                                     const unsigned int& offset,
+                                                                                                     const unsigned int& beamId)
+{
+    if(m_basis.empty())
+        return lambda[offset+beamId];
+
+    Real angle = 0.;
+    for (unsigned int k=0; k<m_basis.size(); k++)
+        angle += m_basis[k][beamId]*lambda[offset+k];
+    return angle;
+}
+
+
+template<class DataTypes>
+void BeamRestPositionActuator<DataTypes>::getJacobians(VecDeriv &J,
+                                                       const Vec3 &axis,
+                                                       const DataVecCoord &x)
+{
+    unsigned int nbPoints = m_state->getSize();
+    J.clear();
+    J.resize(nbPoints);
+
+    double eps = 0.000001;
+    for (unsigned int i=1; i<nbPoints; i++)
+    {
+        Deriv dr = Deriv(Vec3(0.,0.,0.),axis*eps);
+        getLocalJacobian(J[i], dr, i, eps, x);
+    }
 }
 
 
@@ -390,34 +494,25 @@ void BeamRestPositionActuator<DataTypes>::storeResults(vector<double>& lambda,
     // Update the rest position by applying lambda
     WriteAccessor<Data<VecCoord> > restPosition = m_state->write(core::VecCoordId::restPosition());
 
-    int index = 0;
+    // The rows are ordered by direction (y, z, x), then by node or basis function
+    const int directionIds[3] = {1, 2, 0};
+    const Vec3 axes[3] = {Vec3(0.,1.,0.), Vec3(0.,0.,1.), Vec3(1.,0.,0.)};
 
-    int nbBeams = m_state->getSize()-1;
+    unsigned int nbBeams = m_state->getSize()-1;
+    unsigned int nbVariables = m_basis.empty() ? nbBeams : m_basis.size();
     for (unsigned int beamId=0; beamId<nbBeams; beamId++)
     {
         int pointId = beamId+1;
-        if(d_actuationDirection.getValue()[1]) // Actuation around y axis
-        {
-            Deriv dy = Deriv(Vec3(0.,0.,0.),Vec3(0.,lambda[index],0.));
-            applyCurvingRotationToBeam(restPosition[pointId-1], restPosition[pointId], m_beamLengthList[beamId], dy);
-            //m_beamForceField->applyRotationToBeamRestPosition(pointId,dy);
-            index++;
-        }
-
-        if(d_actuationDirection.getValue()[2]) // Actuation around z axis
+        unsigned int offset = 0;
+        for (unsigned int d=0; d<3; d++)
         {
-            Deriv dz = Deriv(Vec3(0.,0.,0.),Vec3(0.,0.,lambda[index]));
-            applyCurvingRotationToBeam(restPosition[pointId-1], restPosition[pointId], m_beamLengthList[beamId], dz);
-            //m_beamForceField->applyRotationToBeamRestPosition(pointId,dz);
-            index++;
-        }
+            if(!d_actuationDirection.getValue()[directionIds[d]])
+                continue;
 
-        if(d_actuationDirection.getValue()[0]) // Actuation around x axis
-        {
-            Deriv dx = Deriv(Vec3(0.,0.,0.),Vec3(lambda[index],0.,0.));
-            applyCurvingRotationToBeam(restPosition[pointId-1], restPosition[pointId], m_beamLengthList[beamId], dx);
-            //m_beamForceField->applyRotationToBeamRestPosition(pointId,dx);
-            index++;
+            Deriv dr = Deriv(Vec3(0.,0.,0.),axes[d]*getRestAngle(lambda, offset, beamId));
+            applyCurvingRotationToBeam(restPosition[pointId-1], restPosition[pointId], m_beamLengthList[beamId], dr);
+            //m_beamForceField->applyRotationToBeamRestPosition(pointId,dr);
+            offset += nbVariables;
         }
     }
 }
@@ -29,6 +29,8 @@
 #pragma once
 
 #include <SoftRobots.Inverse/component/behavior/Actuator.h>
+#include <SoftRobots.Inverse/component/behavior/ConcurrentResults.h>
+#include <SoftRobots.Inverse/component/constraint/CableGeometries.h>
 #include <SoftRobots/component/constraint/model/CableModel.h>
 
 #include <SoftRobots.Inverse/component/config.h>
@@ -48,7 +50,7 @@ using sofa::core::ConstraintParams;
  * https://softrobotscomponents.readthedocs.io
 */
 template< class DataTypes >
-class CableActuator : public Actuator<DataTypes> , public softrobots::constraint::CableModel<DataTypes>
+class CableActuator : public Actuator<DataTypes> , public softrobots::constraint::CableModel<DataTypes> , public softrobotsinverse::behavior::ConcurrentResults
 {
 public:
     SOFA_CLASS(SOFA_TEMPLATE(CableActuator,DataTypes), SOFA_TEMPLATE(Actuator,DataTypes));
@@ -56,6 +58,10 @@ public:
     typedef typename DataTypes::Coord Coord;
     typedef typename Coord::value_type Real;
     typedef typename sofa::core::behavior::MechanicalState<DataTypes> MechanicalState;
+    typedef typename DataTypes::VecCoord VecCoord;
+    typedef typename DataTypes::MatrixDeriv MatrixDeriv;
+    typedef sofa::core::objectmodel::Data<VecCoord> DataVecCoord;
+    typedef sofa::core::objectmodel::Data<MatrixDeriv> DataMatrixDeriv;
 
 
 public:
@@ -68,6 +74,17 @@ public:
     void reset() override;
     /////////////////////////////////////////////////////////////////////////
 
+    ////////////////////////// Inherited from BaseConstraint ////////////////
+    void buildConstraintMatrix(const ConstraintParams* cParams,
+                               DataMatrixDeriv &cMatrix,
+                               unsigned int &cIndex,
+                               const DataVecCoord &x) override;
+
+    void getConstraintViolation(const ConstraintParams* cParams,
+                                sofa::linearalgebra::BaseVector *resV,
+                                const sofa::linearalgebra::BaseVector *Jdx) override;
+    /////////////////////////////////////////////////////////////////////////
+
     ////////////////////////// Inherited attributes ////////////////////////////
     /// https://gcc.gnu.org/onlinedocs/gcc/Name-lookup.html
     /// Bring inherited attributes and function in the current lookup context.
@@ -120,6 +137,23 @@ protected:
     void initLimit();
     void updateLimit();
     void updateVisualization();
+
+    sofa::Data<bool>                  d_shareGeometry;
+    sofa::Data<bool>                  d_multithreading;
+
+    std::shared_ptr<typename CableGeometries<DataTypes>::Cable> m_sharedCable; // Geometry shared with the components of the same cable
+
+    void initCable();
+
+    ////////////////////////// Inherited attributes ////////////////////////////
+    using softrobots::constraint::CableModel<DataTypes>::d_indices ;
+    using softrobots::constraint::CableModel<DataTypes>::d_pullPoint ;
+    using softrobots::constraint::CableModel<DataTypes>::d_hasPullPoint ;
+    using softrobots::constraint::CableModel<DataTypes>::d_cableInitialLength ;
+    using softrobots::constraint::CableModel<DataTypes>::d_cableLength ;
+    using softrobots::constraint::CableModel<DataTypes>::m_constraintId ;
+    using softrobots::constraint::CableModel<DataTypes>::m_nbLines ;
+    ////////////////////////////////////////////////////////////////////////////
 };
 
 #if !defined(SOFTROBOTS_INVERSE_CABLEACTUATOR_CPP)
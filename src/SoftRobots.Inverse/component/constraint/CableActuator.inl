@@ -31,6 +31,7 @@
 #include <sofa/core/visual/VisualParams.h>
 
 #include <SoftRobots.Inverse/component/constraint/CableActuator.h>
+#include <sofa/simulation/MainTaskSchedulerFactory.h>
 
 namespace softrobotsinverse::constraint
 {
@@ -54,6 +55,17 @@ CableActuator<DataTypes>::CableActuator(MechanicalState* object)
 
     , d_displayCableLimit(initData(&d_displayCableLimit,false, "displayCableLimit",
                           "Display cable in red when the limit set by user has been reach."))
+
+    , d_shareGeometry(initData(&d_shareGeometry, false, "shareGeometry",
+                               "If true, the length of the cable and the directions of its row are computed \n"
+                               "once for all the components of the same cable (same indices and pull point of the \n"
+                               "same mechanical state, see CableGeometries), instead of by each component. \n"
+                               "Default value is false."))
+
+    , d_multithreading(initData(&d_multithreading, false, "multithreading",
+                                "Update the geometries of the other cables of the same mechanical state concurrently, \n"
+                                "one cable per task, when shareGeometry is true. \n"
+                                "Default value is false."))
 {
     d_displayCableLimit.setGroup("Visualization");
     m_color = d_color.getValue();
@@ -80,6 +92,7 @@ template<class DataTypes>
 void CableActuator<DataTypes>::init()
 {
     softrobots::constraint::CableModel<DataTypes>::init();
+    initCable();
     initDatas();
     initLimit();
 }
@@ -89,6 +102,7 @@ template<class DataTypes>
 void CableActuator<DataTypes>::reinit()
 {
     softrobots::constraint::CableModel<DataTypes>::reinit();
+    initCable();
     initDatas();
     initLimit();
 }
@@ -252,5 +266,61 @@ void CableActuator<DataTypes>::storeLambda(const ConstraintParams* cParams,
     // Instead the actual delta is stored in storeResults(), which is called from QPInverseProblemSolver
 }
 
+template<class DataTypes>
+void CableActuator<DataTypes>::initCable()
+{
+    m_sharedCable.reset();
+    if(!d_shareGeometry.getValue() || m_state == nullptr)
+        return;
+
+    CableGeometries<DataTypes>::updateCable(m_sharedCable, m_state, d_indices.getValue(), d_hasPullPoint.getValue(), d_pullPoint.getValue());
+    if(d_multithreading.getValue())
+        sofa::simulation::MainTaskSchedulerFactory::createInRegistry()->init();
+}
+
+template<class DataTypes>
+void CableActuator<DataTypes>::buildConstraintMatrix(const ConstraintParams* cParams,
+                                                     DataMatrixDeriv &cMatrix,
+                                                     unsigned int &cIndex,
+                                                     const DataVecCoord &x)
+{
+    if(!m_sharedCable)
+    {
+        softrobots::constraint::CableModel<DataTypes>::buildConstraintMatrix(cParams, cMatrix, cIndex, x);
+        return;
+    }
+
+    m_constraintId = cIndex;
+
+    CableGeometries<DataTypes>::updateCable(m_sharedCable, m_state, d_indices.getValue(), d_hasPullPoint.getValue(), d_pullPoint.getValue());
+    MatrixDeriv& matrix = *cMatrix.beginEdit();
+    CableGeometries<DataTypes>::writeRow(*m_sharedCable, x, matrix, m_constraintId, d_multithreading.getValue());
+
+    cIndex++;
+    cMatrix.endEdit();
+    m_nbLines = cIndex - m_constraintId;
+}
+
+template<class DataTypes>
+void CableActuator<DataTypes>::getConstraintViolation(const ConstraintParams* cParams,
+                                                      BaseVector *resV,
+                                                      const BaseVector *Jdx)
+{
+    if(!m_sharedCable)
+    {
+        softrobots::constraint::CableModel<DataTypes>::getConstraintViolation(cParams, resV, Jdx);
+        return;
+    }
+
+    CableGeometries<DataTypes>::updateCable(m_sharedCable, m_state, d_indices.getValue(), d_hasPullPoint.getValue(), d_pullPoint.getValue());
+    d_cableLength.setValue(CableGeometries<DataTypes>::getLength(*m_sharedCable,
+                                                                 *m_state->read(sofa::core::ConstVecCoordId::position()),
+                                                                 d_multithreading.getValue()));
+    Real dfree = d_cableInitialLength.getValue() - d_cableLength.getValue();
+    if(Jdx->size()!=0)
+        dfree += Jdx->element(0);
+    resV->set(m_constraintId, dfree);
+}
+
 
 } // namespace
@@ -0,0 +1,50 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#define SOFTROBOTS_INVERSE_CONSTRAINT_CABLEACTUATORARRAY_CPP
+
+#include <sofa/defaulttype/VecTypes.h>
+#include <sofa/core/ObjectFactory.h>
+
+#include <SoftRobots.Inverse/component/constraint/CableActuatorArray.inl>
+
+namespace softrobotsinverse::constraint
+{
+
+using namespace sofa::defaulttype;
+using namespace sofa::helper;
+using namespace sofa::core;
+
+int CableActuatorArrayClass = RegisterObject("Simulate an array of cables, with one row per cable, to solve effector constraint.")
+.add< CableActuatorArray<Vec3Types> >(true)
+;
+
+template class SOFA_SOFTROBOTS_INVERSE_API CableActuatorArray<Vec3Types>;
+
+
+} // namespace
@@ -0,0 +1,179 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <SoftRobots.Inverse/component/behavior/Actuator.h>
+#include <SoftRobots.Inverse/component/behavior/ConcurrentResults.h>
+#include <sofa/type/RGBAColor.h>
+
+#include <SoftRobots.Inverse/component/config.h>
+
+namespace softrobotsinverse::constraint
+{
+
+using sofa::core::behavior::Actuator;
+using sofa::helper::ReadAccessor;
+using sofa::core::ConstraintParams;
+using sofa::core::visual::VisualParams;
+using sofa::linearalgebra::BaseVector;
+using softrobots::behavior::SoftRobotsConstraint;
+
+
+/**
+ * This component simulates the forces exerted by an array of cables to solve an effector constraint.
+ * It is equivalent to one CableActuator per cable, with one row per cable in a single block. The cables
+ * are stored in structure-of-arrays: the points of all the cables are concatenated in indices, and
+ * nbPoints gives the number of points of each cable. The limits are given once for all the cables, or
+ * with one value per cable.
+*/
+template< class DataTypes >
+class CableActuatorArray : public Actuator<DataTypes>, public softrobotsinverse::behavior::ConcurrentResults
+{
+public:
+    SOFA_CLASS(SOFA_TEMPLATE(CableActuatorArray,DataTypes), SOFA_TEMPLATE(Actuator,DataTypes));
+
+    typedef typename DataTypes::VecCoord VecCoord;
+    typedef typename DataTypes::VecDeriv VecDeriv;
+    typedef typename DataTypes::Coord Coord;
+    typedef typename DataTypes::Deriv Deriv;
+    typedef typename DataTypes::MatrixDeriv MatrixDeriv;
+    typedef typename Coord::value_type Real;
+    typedef typename sofa::core::behavior::MechanicalState<DataTypes> MechanicalState;
+
+    typedef typename DataTypes::MatrixDeriv::RowIterator MatrixDerivRowIterator;
+    typedef sofa::core::objectmodel::Data<VecCoord>		DataVecCoord;
+    typedef sofa::core::objectmodel::Data<VecDeriv>		DataVecDeriv;
+    typedef sofa::core::objectmodel::Data<MatrixDeriv>    DataMatrixDeriv;
+
+    typedef sofa::type::vector<unsigned int> SetIndexArray;
+    typedef sofa::type::vector<Real> VecReal;
+    typedef Actuator<DataTypes> Inherit;
+
+public:
+    CableActuatorArray(MechanicalState* object = nullptr);
+    ~CableActuatorArray() override;
+
+    ////////////////////////// Inherited from BaseObject ////////////////////
+    void init() override;
+    void reinit() override;
+    void reset() override;
+    void draw(const VisualParams* vparams) override;
+    /////////////////////////////////////////////////////////////////////////
+
+    //////////////// Inherited from SoftRobotsConstraint ///////////////
+    void buildConstraintMatrix(const ConstraintParams* cParams,
+                               DataMatrixDeriv &cMatrix,
+                               unsigned int &cIndex,
+                               const DataVecCoord &x) override;
+
+    void getConstraintViolation(const ConstraintParams* cParams,
+                                BaseVector *resV,
+                                const BaseVector * Jdx) override;
+    /////////////////////////////////////////////////////////////////////////
+
+    /////////////// Inherited from BaseSoftRobotsConstraint /////////////
+    void storeResults(sofa::type::vector<double> &lambda,
+                      sofa::type::vector<double> &delta) override;
+    /////////////////////////////////////////////////////////////
+
+    unsigned int getNbCables() const {return (m_firstPoints.empty())? 0 : m_firstPoints.size()-1;}
+
+    /// Length of the cable from the given positions, from its pull point if any
+    Real getCableLength(const VecCoord& positions, const unsigned int& cable) const;
+
+    /// Row of the cable in the constraint matrix: the opposite of the gradient of its length
+    void getCableDirections(const VecCoord& positions, const unsigned int& cable, sofa::type::vector<Deriv>& directions) const;
+
+protected:
+
+    ////////////////////////// Inherited attributes ////////////////////////////
+    /// https://gcc.gnu.org/onlinedocs/gcc/Name-lookup.html
+    /// Bring inherited attributes and function in the current lookup context.
+    /// otherwise any access to the base::attribute would require
+    /// the "this->" approach.
+    using Inherit::m_hasDeltaMax ;
+    using Inherit::m_hasDeltaMin ;
+    using Inherit::m_deltaMax ;
+    using Inherit::m_deltaMin ;
+
+    using Inherit::m_hasLambdaMax ;
+    using Inherit::m_hasLambdaMin ;
+    using Inherit::m_hasLambdaInit ;
+    using Inherit::m_lambdaMax ;
+    using Inherit::m_lambdaMin ;
+    using Inherit::m_lambdaInit ;
+
+    using Inherit::m_nbLines ;
+    using Inherit::m_constraintId ;
+    using Inherit::d_componentState ;
+
+    using Inherit::m_state ;
+    ////////////////////////////////////////////////////////////////////////////
+
+    sofa::Data<SetIndexArray>         d_indices;
+    sofa::Data<SetIndexArray>         d_nbPoints;
+    sofa::Data<VecCoord>              d_pullPoints;
+
+    sofa::Data<VecReal>               d_maxPositiveDisplacement;
+    sofa::Data<VecReal>               d_maxNegativeDisplacement;
+    sofa::Data<VecReal>               d_maxDispVariation;
+    sofa::Data<VecReal>               d_maxForce;
+    sofa::Data<VecReal>               d_minForce;
+    sofa::Data<VecReal>               d_initForce;
+    sofa::Data<Real>                  d_constrainAtTime;
+
+    sofa::Data<VecReal>               d_force;
+    sofa::Data<VecReal>               d_displacement;
+    sofa::Data<VecReal>               d_cableLength;
+    sofa::Data<VecReal>               d_cableInitialLength;
+
+    sofa::Data<bool>                  d_drawCables;
+    sofa::Data<sofa::type::RGBAColor> d_color;
+
+    // Layout of the cables (the points of the cable i are [m_firstPoints[i], m_firstPoints[i+1]) in indices),
+    // and their limits with one value per cable, set from the data at init
+    SetIndexArray m_firstPoints;
+    VecReal m_maxPositiveDisplacement;
+    VecReal m_maxNegativeDisplacement;
+    VecReal m_maxDispVariation;
+    sofa::type::vector<Deriv> m_directions; // scratch of buildConstraintMatrix
+
+    bool checkCables();
+    bool getPerCableValues(const sofa::Data<VecReal>& data, VecReal& values);
+    void initDatas();
+    void initLimit();
+    void updateLimit();
+    void updateDeltaLimits();
+};
+
+#if !defined(SOFTROBOTS_INVERSE_CONSTRAINT_CABLEACTUATORARRAY_CPP)
+extern template class SOFA_SOFTROBOTS_INVERSE_API CableActuatorArray<sofa::defaulttype::Vec3Types>;
+#endif
+
+} // namespace
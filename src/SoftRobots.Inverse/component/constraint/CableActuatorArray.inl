@@ -0,0 +1,556 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <sofa/core/visual/VisualParams.h>
+#include <sofa/type/Vec.h>
+
+#include <SoftRobots.Inverse/component/constraint/CableActuatorArray.h>
+
+namespace softrobotsinverse::constraint
+{
+
+using sofa::core::objectmodel::ComponentState ;
+
+using sofa::core::visual::VisualParams;
+using sofa::linearalgebra::BaseVector;
+using sofa::helper::ReadAccessor;
+using sofa::helper::WriteOnlyAccessor;
+using sofa::helper::rabs;
+using sofa::type::Vec3;
+
+template<class DataTypes>
+CableActuatorArray<DataTypes>::CableActuatorArray(MechanicalState* object)
+    : Inherit(object)
+    , d_indices(initData(&d_indices, "indices",
+                         "Indices of the points of all the cables, concatenated. The points of a cable \n"
+                         "are given from the pull point to the end of the cable."))
+
+    , d_nbPoints(initData(&d_nbPoints, "nbPoints",
+                          "Number of points of each cable in indices. \n"
+                          "If unspecified, all the indices make one cable."))
+
+    , d_pullPoints(initData(&d_pullPoints, "pullPoints",
+                            "Fixed pull point of each cable. \n"
+                            "If unspecified, the first point of each cable is its pull point."))
+
+    , d_maxPositiveDisplacement(initData(&d_maxPositiveDisplacement, "maxPositiveDisp",
+                                         "Maximum displacement of the cables, one value for all the cables or one \n"
+                                         "per cable. If unspecified no maximum value will be considered."))
+
+    , d_maxNegativeDisplacement(initData(&d_maxNegativeDisplacement, "maxNegativeDisp",
+                                         "Maximum displacement of the cables in the negative direction, one value for \n"
+                                         "all the cables or one per cable. If unspecified no maximum value will be considered."))
+
+    , d_maxDispVariation(initData(&d_maxDispVariation, "maxDispVariation",
+                                  "Maximum variation of the displacement allowed in a step, one value for all the \n"
+                                  "cables or one per cable. If unspecified no max variation will be considered."))
+
+    , d_maxForce(initData(&d_maxForce, "maxForce",
+                          "Maximum force of the cables, one value for all the cables or one per cable. \n"
+                          "If unspecified no maximum value will be considered."))
+
+    , d_minForce(initData(&d_minForce, "minForce",
+                          "Minimum force of the cables, one value for all the cables or one per cable. \n"
+                          "If unspecified no minimum value will be considered."))
+
+    , d_initForce(initData(&d_initForce, "initForce",
+                           "Initial force of the cables, one value for all the cables or one per cable. \n"
+                           "Default is 0."))
+
+    , d_constrainAtTime(initData(&d_constrainAtTime, Real(0.0), "constrainAtTime",
+                                 "No constraints will be applied before this time. \n"
+                                 "Example of use: to allow the cables to reach an \n"
+                                 "initial configuration before optimizing."))
+
+    , d_force(initData(&d_force, "force",
+                       "Output force of each cable. Warning: to get the actual force you should divide this value by dt."))
+
+    , d_displacement(initData(&d_displacement, "displacement",
+                              "Output displacement of each cable compared to its initial length."))
+
+    , d_cableLength(initData(&d_cableLength, "cableLength",
+                             "Output length of each cable."))
+
+    , d_cableInitialLength(initData(&d_cableInitialLength, "cableInitialLength",
+                                    "Output length of each cable at init."))
+
+    , d_drawCables(initData(&d_drawCables, false, "drawCables",
+                            "Draw the cables."))
+
+    , d_color(initData(&d_color, sofa::type::RGBAColor(0.4,0.4,0.4,1), "color",
+                       "Color of the cables."))
+{
+    d_indices.setGroup("Input");
+    d_nbPoints.setGroup("Input");
+    d_pullPoints.setGroup("Input");
+    d_maxPositiveDisplacement.setGroup("Input");
+    d_maxNegativeDisplacement.setGroup("Input");
+    d_maxDispVariation.setGroup("Input");
+    d_maxForce.setGroup("Input");
+    d_minForce.setGroup("Input");
+    d_initForce.setGroup("Input");
+
+    d_force.setGroup("Output");
+    d_displacement.setGroup("Output");
+    d_cableLength.setGroup("Output");
+    d_cableInitialLength.setGroup("Output");
+    d_force.setReadOnly(true);
+    d_displacement.setReadOnly(true);
+    d_cableLength.setReadOnly(true);
+    d_cableInitialLength.setReadOnly(true);
+
+    d_drawCables.setGroup("Visualization");
+    d_color.setGroup("Visualization");
+}
+
+
+template<class DataTypes>
+CableActuatorArray<DataTypes>::~CableActuatorArray()
+{
+}
+
+
+template<class DataTypes>
+void CableActuatorArray<DataTypes>::init()
+{
+    d_componentState = ComponentState::Invalid ;
+    SoftRobotsConstraint<DataTypes>::init();
+
+    if(m_state==nullptr)
+    {
+        msg_error(this) << "There is no mechanical state associated with this node. "
+                            "the object is deactivated. "
+                            "To remove this error message fix your scene possibly by "
+                            "adding a MechanicalObject." ;
+        return ;
+    }
+
+    if(!checkCables())
+        return;
+
+    initDatas();
+    initLimit();
+
+    d_componentState = ComponentState::Valid ;
+}
+
+
+template<class DataTypes>
+void CableActuatorArray<DataTypes>::reinit()
+{
+    if(d_componentState.getValue() != ComponentState::Valid)
+        return ;
+
+    if(!checkCables())
+    {
+        d_componentState = ComponentState::Invalid ;
+        return;
+    }
+
+    initDatas();
+    initLimit();
+}
+
+
+template<class DataTypes>
+void CableActuatorArray<DataTypes>::reset()
+{
+    reinit();
+}
+
+
+template<class DataTypes>
+bool CableActuatorArray<DataTypes>::checkCables()
+{
+    ReadAccessor<sofa::Data<SetIndexArray>> indices = d_indices;
+    if(indices.empty())
+    {
+        msg_error(this) << "No index given, the object is deactivated.";
+        return false;
+    }
+
+    // Without nbPoints, all the indices make one cable
+    const SetIndexArray nbPoints = (d_nbPoints.isSet())? d_nbPoints.getValue() : SetIndexArray(1, indices.size());
+    const unsigned int nbCables = nbPoints.size();
+    m_firstPoints.resize(nbCables+1);
+    m_firstPoints[0] = 0;
+    for(unsigned int i=0; i<nbCables; i++)
+        m_firstPoints[i+1] = m_firstPoints[i] + nbPoints[i];
+
+    if(m_firstPoints[nbCables] != indices.size())
+    {
+        msg_error(this) << "The number of points of the cables (" << m_firstPoints[nbCables] << ") does not match "
+                        << "the size of indices (" << indices.size() << "), the object is deactivated.";
+        m_firstPoints.clear();
+        return false;
+    }
+
+    for(unsigned int i=0; i<indices.size(); i++)
+        if(indices[i] >= m_state->getSize())
+        {
+            msg_error(this) << "Indices at index " << i << " is too large regarding mechanicalState [position] size, "
+                            << "the object is deactivated.";
+            m_firstPoints.clear();
+            return false;
+        }
+
+    if(!d_pullPoints.getValue().empty() && d_pullPoints.getValue().size() != nbCables)
+    {
+        msg_error(this) << "pullPoints should give one point per cable (" << nbCables << "), the object is deactivated.";
+        m_firstPoints.clear();
+        return false;
+    }
+
+    VecReal forces;
+    if(!getPerCableValues(d_maxPositiveDisplacement, m_maxPositiveDisplacement) ||
+       !getPerCableValues(d_maxNegativeDisplacement, m_maxNegativeDisplacement) ||
+       !getPerCableValues(d_maxDispVariation, m_maxDispVariation) ||
+       !getPerCableValues(d_maxForce, forces) ||
+       !getPerCableValues(d_minForce, forces) ||
+       !getPerCableValues(d_initForce, forces))
+    {
+        m_firstPoints.clear();
+        return false;
+    }
+
+    // QP on one value per cable
+    m_lambdaInit.resize(nbCables);
+    m_deltaMax.resize(nbCables);
+    m_deltaMin.resize(nbCables);
+    m_lambdaMax.resize(nbCables);
+    m_lambdaMin.resize(nbCables);
+
+    return true;
+}
+
+
+template<class DataTypes>
+bool CableActuatorArray<DataTypes>::getPerCableValues(const sofa::Data<VecReal>& data, VecReal& values)
+{
+    const VecReal& value = data.getValue();
+    const unsigned int nbCables = getNbCables();
+
+    if(!data.isSet() || value.empty())
+        values.clear();
+    else if(value.size() == 1)
+        values.assign(nbCables, value[0]);
+    else if(value.size() == nbCables)
+        values = value;
+    else
+    {
+        msg_error(this) << data.getName() << " should give one value, or one value per cable (" << nbCables << "), "
+                        << "the object is deactivated.";
+        return false;
+    }
+    return true;
+}
+
+
+template<class DataTypes>
+void CableActuatorArray<DataTypes>::initDatas()
+{
+    const unsigned int nbCables = getNbCables();
+
+    VecReal initForce;
+    getPerCableValues(d_initForce, initForce);
+    m_hasLambdaInit = !initForce.empty();
+    if(m_hasLambdaInit)
+        for(unsigned int i=0; i<nbCables; i++)
+            m_lambdaInit[i] = initForce[i];
+    else
+        initForce.assign(nbCables, Real(0.0));
+
+    d_force.setValue(initForce);
+    d_displacement.setValue(VecReal(nbCables, Real(0.0)));
+
+    ReadAccessor<sofa::Data<VecCoord>> positions = m_state->readPositions();
+    VecReal cableLength(nbCables);
+    for(unsigned int i=0; i<nbCables; i++)
+        cableLength[i] = getCableLength(positions.ref(), i);
+    d_cableLength.setValue(cableLength);
+    d_cableInitialLength.setValue(cableLength);
+}
+
+
+template<class DataTypes>
+void CableActuatorArray<DataTypes>::initLimit()
+{
+    Real time = this->getContext()->getTime();
+    if(time < d_constrainAtTime.getValue())
+        return;
+
+    VecReal maxForce, minForce;
+    getPerCableValues(d_maxForce, maxForce);
+    getPerCableValues(d_minForce, minForce);
+
+    m_hasLambdaMax = !maxForce.empty();
+    for(unsigned int i=0; i<maxForce.size(); i++)
+        m_lambdaMax[i] = maxForce[i];
+
+    m_hasLambdaMin = !minForce.empty();
+    bool canPush = !m_hasLambdaMin;
+    for(unsigned int i=0; i<minForce.size(); i++)
+    {
+        m_lambdaMin[i] = minForce[i];
+        canPush |= (minForce[i] < 0);
+    }
+
+    if(canPush)
+        msg_info(this) << "By not setting minForce=0 you are considering the cables as stiff rods able to push. ";
+
+    m_hasDeltaMax = !m_maxPositiveDisplacement.empty() || !m_maxDispVariation.empty();
+    m_hasDeltaMin = !m_maxNegativeDisplacement.empty() || !m_maxDispVariation.empty();
+    updateDeltaLimits();
+}
+
+
+template<class DataTypes>
+void CableActuatorArray<DataTypes>::updateLimit()
+{
+    Real time = this->getContext()->getTime();
+    if(time < d_constrainAtTime.getValue())
+        return;
+
+    if(d_constrainAtTime.getValue() == time)
+    {
+        initLimit();
+        return;
+    }
+
+    updateDeltaLimits();
+}
+
+
+template<class DataTypes>
+void CableActuatorArray<DataTypes>::updateDeltaLimits()
+{
+    // One pass over the arrays of the cables for each limit
+    const unsigned int nbCables = getNbCables();
+    ReadAccessor<sofa::Data<VecReal>> displacement = d_displacement;
+
+    if(!m_maxPositiveDisplacement.empty())
+        for(unsigned int i=0; i<nbCables; i++)
+            m_deltaMax[i] = m_maxPositiveDisplacement[i];
+
+    if(!m_maxNegativeDisplacement.empty())
+        for(unsigned int i=0; i<nbCables; i++)
+            m_deltaMin[i] = -m_maxNegativeDisplacement[i];
+
+    if(!m_maxDispVariation.empty())
+    {
+        const bool hasMaxPositive = !m_maxPositiveDisplacement.empty();
+        const bool hasMaxNegative = !m_maxNegativeDisplacement.empty();
+        for(unsigned int i=0; i<nbCables; i++)
+        {
+            const double variation = m_maxDispVariation[i];
+            if(rabs(m_deltaMin[i] - displacement[i]) >= variation || !hasMaxNegative)
+                m_deltaMin[i] = displacement[i] - variation;
+            if(rabs(m_deltaMax[i] - displacement[i]) >= variation || !hasMaxPositive)
+                m_deltaMax[i] = displacement[i] + variation;
+        }
+    }
+}
+
+
+template<class DataTypes>
+typename CableActuatorArray<DataTypes>::Real CableActuatorArray<DataTypes>::getCableLength(const VecCoord& positions,
+                                                                                            const unsigned int& cable) const
+{
+    const SetIndexArray& indices = d_indices.getValue();
+    const VecCoord& pullPoints = d_pullPoints.getValue();
+    const unsigned int first = m_firstPoints[cable];
+    const unsigned int last = m_firstPoints[cable+1];
+    if(first == last)
+        return Real(0.0);
+
+    Real length = (pullPoints.empty())? Real(0.0) : (positions[indices[first]] - pullPoints[cable]).norm();
+    for(unsigned int k=first+1; k<last; k++)
+        length += (positions[indices[k]] - positions[indices[k-1]]).norm();
+    return length;
+}
+
+
+template<class DataTypes>
+void CableActuatorArray<DataTypes>::getCableDirections(const VecCoord& positions, const unsigned int& cable,
+                                                       sofa::type::vector<Deriv>& directions) const
+{
+    const SetIndexArray& indices = d_indices.getValue();
+    const VecCoord& pullPoints = d_pullPoints.getValue();
+    const unsigned int first = m_firstPoints[cable];
+    const unsigned int nbPoints = m_firstPoints[cable+1] - first;
+
+    // Unit directions of the segments, toward the pull point
+    directions.assign(nbPoints, Deriv());
+    Deriv previousDirection;
+    if(!pullPoints.empty() && nbPoints)
+    {
+        previousDirection = pullPoints[cable] - positions[indices[first]];
+        previousDirection.normalize();
+    }
+
+    for(unsigned int k=0; k<nbPoints; k++)
+    {
+        Deriv nextDirection;
+        if(k+1 < nbPoints)
+        {
+            nextDirection = positions[indices[first+k]] - positions[indices[first+k+1]];
+            nextDirection.normalize();
+        }
+        directions[k] = previousDirection - nextDirection;
+        previousDirection = nextDirection;
+    }
+}
+
+
+template<class DataTypes>
+void CableActuatorArray<DataTypes>::buildConstraintMatrix(const ConstraintParams* cParams,
+                                                          DataMatrixDeriv &cMatrix,
+                                                          unsigned int &cIndex,
+                                                          const DataVecCoord &x)
+{
+    SOFA_UNUSED(cParams);
+
+    if(d_componentState.getValue() != ComponentState::Valid)
+        return ;
+
+    m_constraintId = cIndex;
+
+    MatrixDeriv& matrix = *cMatrix.beginEdit();
+    const VecCoord& positions = x.getValue();
+    const SetIndexArray& indices = d_indices.getValue();
+
+    // One block of rows, one row per cable
+    const unsigned int nbCables = getNbCables();
+    for(unsigned int i=0; i<nbCables; i++)
+    {
+        MatrixDerivRowIterator rowIterator = matrix.writeLine(m_constraintId+i);
+        getCableDirections(positions, i, m_directions);
+        for(unsigned int k=0; k<m_directions.size(); k++)
+            rowIterator.setCol(indices[m_firstPoints[i]+k], m_directions[k]);
+    }
+
+    cIndex += nbCables;
+    cMatrix.endEdit();
+    m_nbLines = cIndex - m_constraintId;
+}
+
+
+template<class DataTypes>
+void CableActuatorArray<DataTypes>::getConstraintViolation(const ConstraintParams* cParams,
+                                                           BaseVector *resV,
+                                                           const BaseVector *Jdx)
+{
+    SOFA_UNUSED(cParams);
+
+    if(d_componentState.getValue() != ComponentState::Valid)
+        return ;
+
+    ReadAccessor<sofa::Data<VecCoord> > positions = m_state->readPositions();
+    ReadAccessor<sofa::Data<VecReal>> cableInitialLength = d_cableInitialLength;
+    WriteOnlyAccessor<sofa::Data<VecReal>> cableLength = d_cableLength;
+
+    const unsigned int nbCables = getNbCables();
+    const bool withJdx = (Jdx->size()!=0);
+    cableLength.resize(nbCables);
+    for(unsigned int i=0; i<nbCables; i++)
+    {
+        cableLength[i] = getCableLength(positions.ref(), i);
+        Real dfree = cableInitialLength[i] - cableLength[i];
+        if(withJdx)
+            dfree += Jdx->element(i);
+        resV->set(m_constraintId+i, dfree);
+    }
+}
+
+
+template<class DataTypes>
+void CableActuatorArray<DataTypes>::storeResults(sofa::type::vector<double> &lambda,
+                                                 sofa::type::vector<double> &delta)
+{
+    if(d_componentState.getValue() != ComponentState::Valid)
+        return ;
+
+    {
+        const unsigned int nbCables = getNbCables();
+        WriteOnlyAccessor<sofa::Data<VecReal>> force = d_force;
+        WriteOnlyAccessor<sofa::Data<VecReal>> displacement = d_displacement;
+        force.resize(nbCables);
+        displacement.resize(nbCables);
+        for(unsigned int i=0; i<nbCables; i++)
+        {
+            force[i] = lambda[i];
+            displacement[i] = delta[i];
+        }
+    }
+
+    updateLimit();
+
+    Actuator<DataTypes>::storeResults(lambda, delta);
+}
+
+
+template<class DataTypes>
+void CableActuatorArray<DataTypes>::draw(const VisualParams* vparams)
+{
+    if(d_componentState.getValue() != ComponentState::Valid)
+        return ;
+
+    if (!vparams->displayFlags().getShowInteractionForceFields() || !d_drawCables.getValue())
+        return;
+
+    ReadAccessor<sofa::Data<VecCoord> > positions = m_state->readPositions();
+    const SetIndexArray& indices = d_indices.getValue();
+    const VecCoord& pullPoints = d_pullPoints.getValue();
+
+    std::vector<Vec3> points;
+    for(unsigned int i=0; i<getNbCables(); i++)
+    {
+        const unsigned int first = m_firstPoints[i];
+        const unsigned int last = m_firstPoints[i+1];
+        if(first == last)
+            continue;
+
+        if(!pullPoints.empty())
+        {
+            points.emplace_back(pullPoints[i][0], pullPoints[i][1], pullPoints[i][2]);
+            points.emplace_back(positions[indices[first]][0], positions[indices[first]][1], positions[indices[first]][2]);
+        }
+        for(unsigned int k=first+1; k<last; k++)
+        {
+            points.emplace_back(positions[indices[k-1]][0], positions[indices[k-1]][1], positions[indices[k-1]][2]);
+            points.emplace_back(positions[indices[k]][0], positions[indices[k]][1], positions[indices[k]][2]);
+        }
+    }
+
+    vparams->drawTool()->drawLines(points, 1.5, d_color.getValue());
+}
+
+
+} // namespace
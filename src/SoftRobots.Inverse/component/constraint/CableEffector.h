@@ -29,6 +29,7 @@
 #pragma once
 
 #include <SoftRobots.Inverse/component/behavior/Effector.h>
+#include <SoftRobots.Inverse/component/constraint/CableGeometries.h>
 #include <SoftRobots/component/constraint/model/CableModel.h>
 
 
@@ -54,13 +55,27 @@ public:
     typedef typename DataTypes::Coord Coord;
     typedef typename Coord::value_type Real;
     typedef typename sofa::core::behavior::MechanicalState<DataTypes> MechanicalState;
+    typedef typename DataTypes::VecCoord VecCoord;
+    typedef typename DataTypes::MatrixDeriv MatrixDeriv;
+    typedef sofa::core::objectmodel::Data<VecCoord> DataVecCoord;
+    typedef sofa::core::objectmodel::Data<MatrixDeriv> DataMatrixDeriv;
 
 
 public:
     CableEffector(MechanicalState* object = nullptr);
     ~CableEffector() override;
 
+    ////////////////////////// Inherited from BaseObject ////////////////////
+    void init() override;
+    void reinit() override;
+    /////////////////////////////////////////////////////////////////////////
+
     //////////////// Inherited from SoftRobotsConstraint ///////////////
+    void buildConstraintMatrix(const ConstraintParams* cParams,
+                               DataMatrixDeriv &cMatrix,
+                               unsigned int &cIndex,
+                               const DataVecCoord &x) override;
+
     void getConstraintViolation(const ConstraintParams* cParams,
                                 sofa::linearalgebra::BaseVector *resV,
                                 const sofa::linearalgebra::BaseVector *Jdx) override;
@@ -95,6 +110,21 @@ private:
 
     void setUpData();
 
+protected:
+    sofa::Data<bool> d_shareGeometry;
+    sofa::Data<bool> d_multithreading;
+
+    std::shared_ptr<typename CableGeometries<DataTypes>::Cable> m_sharedCable; // Geometry shared with the components of the same cable
+
+    void initCable();
+
+    ////////////////////////// Inherited attributes ////////////////////////////
+    using softrobots::constraint::CableModel<DataTypes>::d_indices ;
+    using softrobots::constraint::CableModel<DataTypes>::d_pullPoint ;
+    using softrobots::constraint::CableModel<DataTypes>::d_hasPullPoint ;
+    using softrobots::constraint::CableModel<DataTypes>::d_cableInitialLength ;
+    using softrobots::constraint::CableModel<DataTypes>::m_nbLines ;
+    ////////////////////////////////////////////////////////////////////////////
 };
 
 #if !defined(SOFTROBOTS_INVERSE_CONSTRAINT_CABLEEFFECTOR_CPP)
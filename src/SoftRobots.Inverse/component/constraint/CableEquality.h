@@ -29,6 +29,7 @@
 #pragma once
 
 #include <SoftRobots.Inverse/component/behavior/Equality.h>
+#include <SoftRobots.Inverse/component/constraint/CableGeometries.h>
 #include <SoftRobots/component/constraint/model/CableModel.h>
 
 #include <SoftRobots.Inverse/component/config.h>
@@ -56,6 +57,10 @@ public:
     typedef typename DataTypes::Coord Coord;
     typedef typename Coord::value_type Real;
     typedef typename sofa::core::behavior::MechanicalState<DataTypes> MechanicalState;
+    typedef typename DataTypes::VecCoord VecCoord;
+    typedef typename DataTypes::MatrixDeriv MatrixDeriv;
+    typedef sofa::core::objectmodel::Data<VecCoord> DataVecCoord;
+    typedef sofa::core::objectmodel::Data<MatrixDeriv> DataMatrixDeriv;
     typedef sofa::type::vector<unsigned int> SetIndexArray;
 
 public:
@@ -68,6 +73,17 @@ public:
     void reset() override;
     /////////////////////////////////////////////////////////////////////////
 
+    ////////////////////////// Inherited from BaseConstraint ////////////////
+    void buildConstraintMatrix(const ConstraintParams* cParams,
+                               DataMatrixDeriv &cMatrix,
+                               unsigned int &cIndex,
+                               const DataVecCoord &x) override;
+
+    void getConstraintViolation(const ConstraintParams* cParams,
+                                sofa::linearalgebra::BaseVector *resV,
+                                const sofa::linearalgebra::BaseVector *Jdx) override;
+    /////////////////////////////////////////////////////////////////////////
+
     ////////////////////////// Inherited attributes ////////////////////////////
     /// https://gcc.gnu.org/onlinedocs/gcc/Name-lookup.html
     /// Bring inherited attributes and function in the current lookup context.
@@ -105,6 +121,23 @@ protected:
     sofa::Data<bool>                  d_displayCableLimit;
 
     void updateConstraint();
+
+    sofa::Data<bool>                  d_shareGeometry;
+    sofa::Data<bool>                  d_multithreading;
+
+    std::shared_ptr<typename CableGeometries<DataTypes>::Cable> m_sharedCable; // Geometry shared with the components of the same cable
+
+    void initCable();
+
+    ////////////////////////// Inherited attributes ////////////////////////////
+    using softrobots::constraint::CableModel<DataTypes>::d_indices ;
+    using softrobots::constraint::CableModel<DataTypes>::d_pullPoint ;
+    using softrobots::constraint::CableModel<DataTypes>::d_hasPullPoint ;
+    using softrobots::constraint::CableModel<DataTypes>::d_cableInitialLength ;
+    using softrobots::constraint::CableModel<DataTypes>::d_cableLength ;
+    using softrobots::constraint::CableModel<DataTypes>::m_constraintId ;
+    using softrobots::constraint::CableModel<DataTypes>::m_nbLines ;
+    ////////////////////////////////////////////////////////////////////////////
 };
 
 #if !defined(SOFTROBOTS_INVERSE_CABLEEQUALITY_CPP)
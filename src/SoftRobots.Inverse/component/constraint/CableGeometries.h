@@ -0,0 +1,153 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <sofa/core/objectmodel/Data.h>
+#include <sofa/defaulttype/VecTypes.h>
+#include <sofa/simulation/TaskScheduler.h>
+#include <sofa/type/vector.h>
+
+#include <SoftRobots.Inverse/component/config.h>
+
+#include <memory>
+#include <mutex>
+
+namespace softrobotsinverse::constraint
+{
+
+/**
+ * Geometries of the cables, shared by all the components referencing the same points and pull point of the same
+ * mechanical state (actuators, sensors, equalities and effectors of a cable), so that the length of each cable and
+ * the directions of its row are computed once per change of the positions:
+ *   - the geometry is recomputed only when the counter of the Data of the positions changed since the last query,
+ *   - the first query after a change updates all the cables of the same mechanical state, one cable per task with
+ *     multithreading, as they are queried in the same step.
+ * The row of a point is the sum of the unit directions of its two segments toward its neighbours, that is
+ * the opposite of the gradient of the length. Without pull point, the first point is the end of the cable.
+*/
+template< class DataTypes >
+class CableGeometries
+{
+public:
+    typedef typename DataTypes::VecCoord                  VecCoord;
+    typedef typename DataTypes::Coord                     Coord;
+    typedef typename DataTypes::Deriv                     Deriv;
+    typedef typename DataTypes::MatrixDeriv               MatrixDeriv;
+    typedef typename Coord::value_type                    Real;
+    typedef sofa::type::vector<unsigned int>              SetIndexArray;
+
+    class Cable
+    {
+    public:
+        Real getLength() const {return m_length;}
+        const sofa::type::vector<Deriv>& getDirections() const {return m_directions;}
+
+        /// Number of updates of the geometry since the creation of the cable
+        unsigned int getNbUpdates() const {return m_nbUpdates;}
+
+    protected:
+        friend class CableGeometries;
+
+        void update(const VecCoord& positions);
+
+        const void*                m_state{nullptr};
+        SetIndexArray              m_indices;          // Key of the cable, with m_state, m_hasPullPoint and m_pullPoint
+        bool                       m_hasPullPoint{true};
+        Coord                      m_pullPoint;
+
+        Real                       m_length{0.};
+        sofa::type::vector<Deriv>  m_directions;       // Row of each point of m_indices
+        unsigned int               m_nbUpdates{0};
+
+        const void*                m_positionsData{nullptr};
+        int                        m_positionsCounter{-1};
+    };
+
+    /// Cable of the given points of a mechanical state, shared with the other components of the same cable.
+    /// It is created on the first request, and released with the last component holding it.
+    static std::shared_ptr<Cable> getCable(const void* state,
+                                           const SetIndexArray& indices,
+                                           bool hasPullPoint,
+                                           const Coord& pullPoint);
+
+    /// Keeps the cable held by a component in line with its points and pull point, which can change during the
+    /// simulation: the cable is requested again only when they differ from the ones it was created with
+    static void updateCable(std::shared_ptr<Cable>& cable,
+                            const void* state,
+                            const SetIndexArray& indices,
+                            bool hasPullPoint,
+                            const Coord& pullPoint);
+
+    /// Length of the cable at the given positions of its mechanical state
+    static Real getLength(Cable& cable,
+                          const sofa::core::objectmodel::Data<VecCoord>& positions,
+                          bool multithreading = false);
+
+    /// Writes the row of the cable at the given positions of its mechanical state in the line of the matrix
+    static void writeRow(Cable& cable,
+                         const sofa::core::objectmodel::Data<VecCoord>& positions,
+                         MatrixDeriv& matrix,
+                         unsigned int line,
+                         bool multithreading = false);
+
+protected:
+
+    static std::mutex& getMutex();
+    static sofa::type::vector<std::weak_ptr<Cable>>& getCables();
+
+    /// Updates the cable and the stale cables of the same mechanical state, the mutex being locked
+    static void update(Cable& cable, const sofa::core::objectmodel::Data<VecCoord>& positions, bool multithreading);
+
+    class UpdateCableTask : public sofa::simulation::CpuTask
+    {
+    public:
+        UpdateCableTask(sofa::simulation::CpuTask::Status* status): CpuTask(status) {}
+        ~UpdateCableTask() override {}
+
+        MemoryAlloc run() final {
+            cable->update(*positions);
+            return MemoryAlloc::Stack;
+        }
+
+        void set(Cable* _cable, const VecCoord* _positions){
+            cable = _cable;
+            positions = _positions;
+        }
+
+    private:
+        Cable* cable{nullptr};
+        const VecCoord* positions{nullptr};
+    };
+};
+
+#if !defined(SOFTROBOTS_INVERSE_CABLEGEOMETRIES_CPP)
+extern template class SOFA_SOFTROBOTS_INVERSE_API CableGeometries<sofa::defaulttype::Vec3Types>;
+#endif
+
+} // namespace
@@ -0,0 +1,215 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <SoftRobots.Inverse/component/constraint/CableGeometries.h>
+#include <sofa/simulation/MainTaskSchedulerFactory.h>
+#include <algorithm>
+
+namespace softrobotsinverse::constraint
+{
+
+using sofa::type::vector;
+
+
+template<class DataTypes>
+void CableGeometries<DataTypes>::Cable::update(const VecCoord& positions)
+{
+    const unsigned int nbPoints = m_indices.size();
+    m_directions.assign(nbPoints, Deriv());
+    m_length = 0.;
+    m_nbUpdates++;
+    if(!nbPoints)
+        return;
+
+    // Unit directions of the segments, toward the pull point
+    Deriv previousDirection;
+    if(m_hasPullPoint)
+    {
+        previousDirection = m_pullPoint - positions[m_indices[0]];
+        m_length += previousDirection.norm();
+        previousDirection.normalize();
+    }
+
+    for(unsigned int k=0; k<nbPoints; k++)
+    {
+        Deriv nextDirection;
+        if(k+1 < nbPoints)
+        {
+            nextDirection = positions[m_indices[k]] - positions[m_indices[k+1]];
+            m_length += nextDirection.norm();
+            nextDirection.normalize();
+        }
+        m_directions[k] = previousDirection - nextDirection;
+        previousDirection = nextDirection;
+    }
+}
+
+
+template<class DataTypes>
+std::mutex& CableGeometries<DataTypes>::getMutex()
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+
+template<class DataTypes>
+vector<std::weak_ptr<typename CableGeometries<DataTypes>::Cable>>& CableGeometries<DataTypes>::getCables()
+{
+    static vector<std::weak_ptr<Cable>> cables;
+    return cables;
+}
+
+
+template<class DataTypes>
+std::shared_ptr<typename CableGeometries<DataTypes>::Cable> CableGeometries<DataTypes>::getCable(const void* state,
+                                                                                               const SetIndexArray& indices,
+                                                                                               bool hasPullPoint,
+                                                                                               const Coord& pullPoint)
+{
+    std::lock_guard<std::mutex> lock(getMutex());
+
+    vector<std::weak_ptr<Cable>>& cables = getCables();
+    cables.erase(std::remove_if(cables.begin(), cables.end(),
+                                [](const std::weak_ptr<Cable>& cable){ return cable.expired(); }),
+                 cables.end());
+
+    for(const std::weak_ptr<Cable>& weakCable : cables)
+    {
+        std::shared_ptr<Cable> cable = weakCable.lock();
+        if(cable && cable->m_state == state && cable->m_indices == indices && cable->m_hasPullPoint == hasPullPoint &&
+           (!hasPullPoint || cable->m_pullPoint == pullPoint))
+            return cable;
+    }
+
+    std::shared_ptr<Cable> cable = std::make_shared<Cable>();
+    cable->m_state = state;
+    cable->m_indices = indices;
+    cable->m_hasPullPoint = hasPullPoint;
+    cable->m_pullPoint = pullPoint;
+    cables.push_back(cable);
+    return cable;
+}
+
+
+template<class DataTypes>
+void CableGeometries<DataTypes>::updateCable(std::shared_ptr<Cable>& cable,
+                                             const void* state,
+                                             const SetIndexArray& indices,
+                                             bool hasPullPoint,
+                                             const Coord& pullPoint)
+{
+    if(cable && cable->m_state == state && cable->m_indices == indices && cable->m_hasPullPoint == hasPullPoint &&
+       (!hasPullPoint || cable->m_pullPoint == pullPoint))
+        return;
+
+    cable = getCable(state, indices, hasPullPoint, pullPoint);
+}
+
+
+template<class DataTypes>
+void CableGeometries<DataTypes>::update(Cable& cable,
+                                        const sofa::core::objectmodel::Data<VecCoord>& positions,
+                                        bool multithreading)
+{
+    const int counter = positions.getCounter();
+    if(cable.m_positionsData == &positions && cable.m_positionsCounter == counter)
+        return;
+
+    // The cables of the same mechanical state whose positions changed
+    vector<std::shared_ptr<Cable>> staleCables;
+    for(const std::weak_ptr<Cable>& weakCable : getCables())
+    {
+        std::shared_ptr<Cable> other = weakCable.lock();
+        if(other && other.get() != &cable && other->m_state == cable.m_state &&
+           (other->m_positionsData != &positions || other->m_positionsCounter != counter))
+            staleCables.push_back(other);
+    }
+
+    const VecCoord& x = positions.getValue();
+    sofa::simulation::TaskScheduler* taskScheduler = (multithreading && !staleCables.empty())? sofa::simulation::MainTaskSchedulerFactory::createInRegistry() : nullptr;
+    if(taskScheduler)
+    {
+        sofa::simulation::CpuTask::Status status;
+
+        vector<UpdateCableTask> tasks;
+        tasks.resize(staleCables.size(), UpdateCableTask(&status));
+        for(unsigned int i=0; i<tasks.size(); i++)
+        {
+            tasks[i].set(staleCables[i].get(), &x);
+            taskScheduler->addTask(&tasks[i]);
+        }
+        cable.update(x);
+        taskScheduler->workUntilDone(&status);
+    }
+    else
+    {
+        cable.update(x);
+        for(const std::shared_ptr<Cable>& other : staleCables)
+            other->update(x);
+    }
+
+    cable.m_positionsData = &positions;
+    cable.m_positionsCounter = counter;
+    for(const std::shared_ptr<Cable>& other : staleCables)
+    {
+        other->m_positionsData = &positions;
+        other->m_positionsCounter = counter;
+    }
+}
+
+
+template<class DataTypes>
+typename CableGeometries<DataTypes>::Real CableGeometries<DataTypes>::getLength(Cable& cable,
+                                                                              const sofa::core::objectmodel::Data<VecCoord>& positions,
+                                                                              bool multithreading)
+{
+    std::lock_guard<std::mutex> lock(getMutex());
+    update(cable, positions, multithreading);
+    return cable.m_length;
+}
+
+
+template<class DataTypes>
+void CableGeometries<DataTypes>::writeRow(Cable& cable,
+                                          const sofa::core::objectmodel::Data<VecCoord>& positions,
+                                          MatrixDeriv& matrix,
+                                          unsigned int line,
+                                          bool multithreading)
+{
+    std::lock_guard<std::mutex> lock(getMutex());
+    update(cable, positions, multithreading);
+
+    typename MatrixDeriv::RowIterator rowIterator = matrix.writeLine(line);
+    for(unsigned int k=0; k<cable.m_indices.size(); k++)
+        rowIterator.setCol(cable.m_indices[k], cable.m_directions[k]);
+}
+
+} // namespace
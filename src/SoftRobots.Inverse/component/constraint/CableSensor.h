@@ -29,6 +29,8 @@
 #pragma once
 
 #include <SoftRobots.Inverse/component/behavior/Sensor.h>
+#include <SoftRobots.Inverse/component/behavior/ConcurrentResults.h>
+#include <SoftRobots.Inverse/component/constraint/CableGeometries.h>
 #include <SoftRobots/component/constraint/model/CableModel.h>
 
 namespace softrobotsinverse::constraint
@@ -45,18 +47,40 @@ using sofa::core::ConstraintParams;
  * https://softrobotscomponents.readthedocs.io
 */
 template< class DataTypes >
-class CableSensor : public softrobotsinverse::behavior::Sensor<DataTypes> , public softrobots::constraint::CableModel<DataTypes>
+class CableSensor : public softrobotsinverse::behavior::Sensor<DataTypes> , public softrobots::constraint::CableModel<DataTypes> , public softrobotsinverse::behavior::ConcurrentResults
 {
 public:
     SOFA_CLASS(SOFA_TEMPLATE(CableSensor,DataTypes),
                SOFA_TEMPLATE(softrobotsinverse::behavior::Sensor,DataTypes));
 
     typedef typename sofa::core::behavior::MechanicalState<DataTypes> MechanicalState;
+    typedef typename DataTypes::Coord Coord;
+    typedef typename Coord::value_type Real;
+    typedef typename DataTypes::VecCoord VecCoord;
+    typedef typename DataTypes::MatrixDeriv MatrixDeriv;
+    typedef sofa::core::objectmodel::Data<VecCoord> DataVecCoord;
+    typedef sofa::core::objectmodel::Data<MatrixDeriv> DataMatrixDeriv;
 
 public:
     CableSensor(MechanicalState* object = nullptr);
     ~CableSensor() override;
 
+    ////////////////////////// Inherited from BaseObject ////////////////////
+    void init() override;
+    void reinit() override;
+    /////////////////////////////////////////////////////////////////////////
+
+    ////////////////////////// Inherited from BaseConstraint ////////////////
+    void buildConstraintMatrix(const ConstraintParams* cParams,
+                               DataMatrixDeriv &cMatrix,
+                               unsigned int &cIndex,
+                               const DataVecCoord &x) override;
+
+    void getConstraintViolation(const ConstraintParams* cParams,
+                                sofa::linearalgebra::BaseVector *resV,
+                                const sofa::linearalgebra::BaseVector *Jdx) override;
+    /////////////////////////////////////////////////////////////////////////
+
 protected:
 
     ////////////////////////// Inherited attributes ////////////////////////////
@@ -78,6 +102,25 @@ protected:
 private:
 
     void setUpData();
+
+protected:
+    sofa::Data<bool> d_shareGeometry;
+    sofa::Data<bool> d_multithreading;
+
+    std::shared_ptr<typename CableGeometries<DataTypes>::Cable> m_sharedCable; // Geometry shared with the components of the same cable
+
+    void initCable();
+
+    ////////////////////////// Inherited attributes ////////////////////////////
+    using softrobots::constraint::CableModel<DataTypes>::d_indices ;
+    using softrobots::constraint::CableModel<DataTypes>::d_pullPoint ;
+    using softrobots::constraint::CableModel<DataTypes>::d_hasPullPoint ;
+    using softrobots::constraint::CableModel<DataTypes>::d_cableInitialLength ;
+    using softrobots::constraint::CableModel<DataTypes>::d_cableLength ;
+    using softrobots::constraint::CableModel<DataTypes>::m_constraintId ;
+    using softrobots::constraint::CableModel<DataTypes>::m_state ;
+    using softrobots::constraint::CableModel<DataTypes>::m_nbLines ;
+    ////////////////////////////////////////////////////////////////////////////
 };
 
 #if !defined(SOFTROBOTS_INVERSE_CABLESENSOR_CPP)
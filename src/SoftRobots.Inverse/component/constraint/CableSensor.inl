@@ -31,6 +31,7 @@
 #include <sofa/core/visual/VisualParams.h>
 
 #include <SoftRobots.Inverse/component/constraint/CableSensor.h>
+#include <sofa/simulation/MainTaskSchedulerFactory.h>
 
 namespace softrobotsinverse::constraint
 {
@@ -43,6 +44,16 @@ template<class DataTypes>
 CableSensor<DataTypes>::CableSensor(MechanicalState* object)
     : softrobotsinverse::behavior::Sensor<DataTypes>(object)
     , softrobots::constraint::CableModel<DataTypes>(object)
+    , d_shareGeometry(initData(&d_shareGeometry, false, "shareGeometry",
+                               "If true, the length of the cable and the directions of its row are computed \n"
+                               "once for all the components of the same cable (same indices and pull point of the \n"
+                               "same mechanical state, see CableGeometries), instead of by each component. \n"
+                               "Default value is false."))
+
+    , d_multithreading(initData(&d_multithreading, false, "multithreading",
+                                "Update the geometries of the other cables of the same mechanical state concurrently, \n"
+                                "one cable per task, when shareGeometry is true. \n"
+                                "Default value is false."))
 {
     setUpData();
 }
@@ -69,5 +80,75 @@ void CableSensor<DataTypes>::setUpData()
     d_displacement.setDisplayed(false);
 }
 
+template<class DataTypes>
+void CableSensor<DataTypes>::init()
+{
+    softrobots::constraint::CableModel<DataTypes>::init();
+    initCable();
+}
+
+template<class DataTypes>
+void CableSensor<DataTypes>::reinit()
+{
+    softrobots::constraint::CableModel<DataTypes>::reinit();
+    initCable();
+}
+
+template<class DataTypes>
+void CableSensor<DataTypes>::initCable()
+{
+    m_sharedCable.reset();
+    if(!d_shareGeometry.getValue() || m_state == nullptr)
+        return;
+
+    CableGeometries<DataTypes>::updateCable(m_sharedCable, m_state, d_indices.getValue(), d_hasPullPoint.getValue(), d_pullPoint.getValue());
+    if(d_multithreading.getValue())
+        sofa::simulation::MainTaskSchedulerFactory::createInRegistry()->init();
+}
+
+template<class DataTypes>
+void CableSensor<DataTypes>::buildConstraintMatrix(const ConstraintParams* cParams,
+                                                   DataMatrixDeriv &cMatrix,
+                                                   unsigned int &cIndex,
+                                                   const DataVecCoord &x)
+{
+    if(!m_sharedCable)
+    {
+        softrobots::constraint::CableModel<DataTypes>::buildConstraintMatrix(cParams, cMatrix, cIndex, x);
+        return;
+    }
+
+    m_constraintId = cIndex;
+
+    CableGeometries<DataTypes>::updateCable(m_sharedCable, m_state, d_indices.getValue(), d_hasPullPoint.getValue(), d_pullPoint.getValue());
+    MatrixDeriv& matrix = *cMatrix.beginEdit();
+    CableGeometries<DataTypes>::writeRow(*m_sharedCable, x, matrix, m_constraintId, d_multithreading.getValue());
+
+    cIndex++;
+    cMatrix.endEdit();
+    m_nbLines = cIndex - m_constraintId;
+}
+
+template<class DataTypes>
+void CableSensor<DataTypes>::getConstraintViolation(const ConstraintParams* cParams,
+                                                    BaseVector *resV,
+                                                    const BaseVector *Jdx)
+{
+    if(!m_sharedCable)
+    {
+        softrobots::constraint::CableModel<DataTypes>::getConstraintViolation(cParams, resV, Jdx);
+        return;
+    }
+
+    CableGeometries<DataTypes>::updateCable(m_sharedCable, m_state, d_indices.getValue(), d_hasPullPoint.getValue(), d_pullPoint.getValue());
+    d_cableLength.setValue(CableGeometries<DataTypes>::getLength(*m_sharedCable,
+                                                                 *m_state->read(sofa::core::ConstVecCoordId::position()),
+                                                                 d_multithreading.getValue()));
+    Real dfree = d_cableInitialLength.getValue() - d_cableLength.getValue();
+    if(Jdx->size()!=0)
+        dfree += Jdx->element(0);
+    resV->set(m_constraintId, dfree);
+}
+
 
 } // namespace
@@ -0,0 +1,91 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <sofa/type/config.h>
+
+#include <type_traits>
+
+namespace softrobotsinverse::constraint
+{
+
+/**
+ * Directions selected by useDirections, as a bit mask (bit j for the direction j), to run the loops over the
+ * directions of the components with a mask known at compile time for the common cases: all the directions,
+ * and for rigid frames (N = 6) the translations only or the rotations only. With the mask as a constant, the
+ * loops over the N directions are unrolled and the tests of the mask resolved by the compiler.
+*/
+template< sofa::Size N >
+struct DirectionMask
+{
+    static_assert(N > 0 && N < 32, "DirectionMask: unsupported number of directions");
+
+    static constexpr unsigned int All = (1u << N) - 1u;
+    static constexpr unsigned int Translations = (N == 6)? 0x07u : All;
+    static constexpr unsigned int Rotations = (N == 6)? 0x38u : All;
+
+    template<class UseDirections>
+    static unsigned int get(const UseDirections& useDirections)
+    {
+        unsigned int mask = 0;
+        for(sofa::Size j=0; j<N; j++)
+            if(useDirections[j])
+                mask |= (1u << j);
+        return mask;
+    }
+
+    static constexpr sofa::Size getNbDirections(unsigned int mask)
+    {
+        sofa::Size nbDirections = 0;
+        for(sofa::Size j=0; j<N; j++)
+            nbDirections += (mask >> j) & 1u;
+        return nbDirections;
+    }
+
+    /// Calls kernel(mask), with the mask as a std::integral_constant for the common masks, as an unsigned int otherwise
+    template<class Kernel>
+    static void dispatch(unsigned int mask, Kernel&& kernel)
+    {
+        if(mask == All)
+            kernel(std::integral_constant<unsigned int, All>());
+        else if constexpr (N == 6)
+        {
+            if(mask == Translations)
+                kernel(std::integral_constant<unsigned int, Translations>());
+            else if(mask == Rotations)
+                kernel(std::integral_constant<unsigned int, Rotations>());
+            else
+                kernel(mask);
+        }
+        else
+            kernel(mask);
+    }
+};
+
+} // namespace
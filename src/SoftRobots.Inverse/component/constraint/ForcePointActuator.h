@@ -29,6 +29,8 @@
 #pragma once
 
 #include <SoftRobots.Inverse/component/behavior/Actuator.h>
+#include <SoftRobots.Inverse/component/behavior/ConcurrentResults.h>
+#include <SoftRobots.Inverse/component/behavior/ConstantRows.h>
 #include <sofa/core/topology/BaseMeshTopology.h>
 
 #include <SoftRobots.Inverse/component/config.h>
@@ -49,7 +51,8 @@ namespace softrobotsinverse::constraint
  * https://softrobotscomponents.readthedocs.io
 */
 template< class DataTypes >
-class ForcePointActuator : public Actuator<DataTypes>
+class ForcePointActuator : public Actuator<DataTypes>, public softrobotsinverse::behavior::ConcurrentResults,
+                           public softrobotsinverse::behavior::ConstantRows
 {
 public:
     SOFA_CLASS(SOFA_TEMPLATE(ForcePointActuator,DataTypes), SOFA_TEMPLATE(sofa::core::behavior::Actuator,DataTypes));
@@ -95,6 +98,10 @@ public:
                       sofa::type::vector<double> &delta) override;
     ////////////////////////////////////////////////////////////////////////
 
+    /////////////// Inherited from ConstantRows ////////////////////////////
+    bool hasConstantRows() const override;
+    ////////////////////////////////////////////////////////////////////////
+
 protected:
 
     sofa::Data<sofa::type::vector<unsigned int>>  d_indices;
@@ -124,6 +131,11 @@ protected:
     void initDatas();
     void updateLimit();
 
+    // Sources of the rows at their last build (see ConstantRows)
+    int          m_builtIndicesCounter{-1};
+    int          m_builtDirectionCounter{-1};
+    unsigned int m_builtStateSize{0};
+
     ////////////////////////// Inherited attributes ////////////////////////////
     /// https://gcc.gnu.org/onlinedocs/gcc/Name-lookup.html
     /// Bring inherited attributes and function in the current lookup context.
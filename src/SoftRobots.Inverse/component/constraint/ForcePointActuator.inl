@@ -246,6 +246,18 @@ void ForcePointActuator<DataTypes>::buildConstraintMatrix(const ConstraintParams
     cMatrix.endEdit();
 
     m_nbLines = cIndex - m_constraintId;
+    m_builtIndicesCounter = d_indices.getCounter();
+    m_builtDirectionCounter = d_direction.getCounter();
+    m_builtStateSize = m_state->getSize();
+}
+
+
+template<class DataTypes>
+bool ForcePointActuator<DataTypes>::hasConstantRows() const
+{
+    // The rows are the direction (or the axes) on the points, whatever their positions
+    return m_builtIndicesCounter == d_indices.getCounter() && m_builtDirectionCounter == d_direction.getCounter()
+            && m_builtStateSize == m_state->getSize();
 }
 
 
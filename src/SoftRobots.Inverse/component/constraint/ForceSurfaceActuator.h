@@ -29,7 +29,12 @@
 #pragma once
 
 #include <SoftRobots.Inverse/component/behavior/Actuator.h>
+#include <SoftRobots.Inverse/component/behavior/ConstraintRowsBuilder.h>
+#include <SoftRobots.Inverse/component/behavior/DrawBuffer.h>
 #include <sofa/core/topology/BaseMeshTopology.h>
+#include <sofa/core/objectmodel/DataFileName.h>
+#include <sofa/simulation/TaskScheduler.h>
+#include <unordered_map>
 
 #include <SoftRobots.Inverse/component/config.h>
 
@@ -107,6 +112,10 @@ protected:
     sofa::Data<sofa::type::vector<Real>>      d_radii;
     sofa::Data<VecDeriv>                      d_directions;
     sofa::Data<bool>                          d_updateNormals;
+    sofa::Data<Real>                          d_normalsTolerance;
+    sofa::Data<bool>                          d_multithreading;
+    sofa::Data<bool>                          d_parallelConstraintMatrix;
+    sofa::core::objectmodel::DataFileName     d_membershipCache;
 
     sofa::Data<sofa::type::vector<Triangle>>      d_triangles;
     sofa::Data<sofa::type::vector<Quad>>          d_quads;
@@ -136,6 +145,79 @@ protected:
     sofa::type::vector<sofa::type::vector<unsigned int>>        m_edgesInSpheresId;
     sofa::type::vector<sofa::type::vector<Real>>                m_ratios;
 
+    // Uniform grid over the positions, with cells of the size of the largest radius, so that a sphere
+    // only visits the points of the cells it overlaps. When the positions change, only the points
+    // that left their cell are moved.
+    std::unordered_map<long long, sofa::type::vector<unsigned int>> m_grid;
+    sofa::type::vector<long long>                               m_pointCells;
+    Real                                                        m_gridCellSize{0};
+    int                                                         m_gridCounter{-1};
+
+    // Triangles, quads and edges around each point, rebuilt when the topology changes, to get the
+    // primitives of a sphere from its points
+    sofa::type::vector<sofa::type::vector<unsigned int>>        m_trianglesAroundPoint;
+    sofa::type::vector<sofa::type::vector<unsigned int>>        m_quadsAroundPoint;
+    sofa::type::vector<sofa::type::vector<unsigned int>>        m_edgesAroundPoint;
+    bool                                                        m_topologyChanged{true};
+
+    // Key of the surface and spheres of the membership lists above, with membershipCache
+    uint64_t                                                    m_membershipKey{0};
+    bool                                                        m_hasMembershipKey{false};
+    int                                                         m_edgesTrianglesCounter{-1};
+    int                                                         m_edgesQuadsCounter{-1};
+
+    // Normals (not normalized) of the triangles and quads of the spheres, stored by component,
+    // when normalsTolerance is set. A normal is shared by all the spheres of its primitive, and
+    // is only recomputed when one of its vertices moved by more than the tolerance.
+    struct NormalsBuffer{
+        sofa::type::vector<Real> x;
+        sofa::type::vector<Real> y;
+        sofa::type::vector<Real> z;
+        sofa::type::vector<bool> isValid;
+
+        unsigned int size() const {return isValid.size();}
+        void reset(const unsigned int n) {x.resize(n); y.resize(n); z.resize(n); isValid.assign(n, false);}
+        void clear() {x.clear(); y.clear(); z.clear(); isValid.clear();}
+        void set(const unsigned int i, const Deriv& normal) {x[i] = normal[0]; y[i] = normal[1]; z[i] = normal[2]; isValid[i] = true;}
+        void invalidate(const sofa::type::vector<unsigned int>& ids) {for(unsigned int i : ids) isValid[i] = false;}
+    };
+    NormalsBuffer                                               m_triangleNormals;
+    NormalsBuffer                                               m_quadNormals;
+    VecCoord                                                    m_normalsPositions; // Positions of the last update of the normals around each point
+    unsigned int                                                m_nbUpdatedNormals{0};
+
+    softrobotsinverse::behavior::ConstraintRowsBuilder<DataTypes> m_rowsBuilder;
+
+    // Vertices of the draw methods, rebuilt when the positions, the forces or the membership lists change.
+    // The forces are stored as the segments of their arrows, drawn at once.
+    unsigned int                                                m_nbMembershipUpdates{0};
+    softrobotsinverse::behavior::DrawBuffer                     m_forcesBuffer;
+    softrobotsinverse::behavior::DrawBuffer                     m_trianglesBuffer;
+    softrobotsinverse::behavior::DrawBuffer                     m_linesBuffer;
+
+    class AverageNormalTask : public sofa::simulation::CpuTask
+    {
+    public:
+        AverageNormalTask(sofa::simulation::CpuTask::Status* status): CpuTask(status) {}
+        ~AverageNormalTask() override {}
+
+        MemoryAlloc run() final {
+            actuator->averageNormal(sphereId, *direction);
+            return MemoryAlloc::Stack;
+        }
+
+        void set(const ForceSurfaceActuator* _actuator, const unsigned int _sphereId, Deriv* _direction){
+            actuator = _actuator;
+            sphereId = _sphereId;
+            direction = _direction;
+        }
+
+    private:
+        const ForceSurfaceActuator* actuator{nullptr};
+        unsigned int sphereId{0};
+        Deriv* direction{nullptr};
+    };
+
 
 
 
@@ -159,13 +241,27 @@ protected:
     bool isQuadInSphere(unsigned int quadId, unsigned int sphereId);
     bool isEdgeInSphere(unsigned int edgeId, unsigned int sphereId);
 
-    bool isIndexInPointsList(unsigned int index, unsigned int sphereId);
+    bool isIndexInPointsList(unsigned int index, unsigned int sphereId) const;
 
     void computeSurfaces();
+    uint64_t getMembershipKey() const;
+    bool readMembership(const std::string& filename, const uint64_t& key);
+    bool writeMembership(const std::string& filename, const uint64_t& key) const;
     void computePointsInSpheres();
+    void updatePointsGrid();
+    long long getCellKey(const sofa::type::Vec<3,int>& cell) const;
+    sofa::type::Vec<3,int> getCell(const Coord& position) const;
+    void computePrimitivesAroundPoints();
+    void getPrimitivesInSphere(const sofa::type::vector<sofa::type::vector<unsigned int>>& primitivesAroundPoint,
+                               unsigned int sphereId,
+                               sofa::type::vector<unsigned int>& primitivesInSphere) const;
     void computeNormals();
+    void computeCachedNormals();
+    void updatePrimitiveNormals(const VecCoord& positions);
+    void averageNormal(const unsigned int sphereId, Deriv& normal) const;
     void computeEdges();
 
+    void updateForcesBuffer();
     void drawForces(const VisualParams* vparams);
     void drawSpheres(const VisualParams* vparams);
     void drawSurfaces(const VisualParams* vparams);
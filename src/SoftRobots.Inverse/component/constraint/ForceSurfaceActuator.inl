@@ -30,6 +30,13 @@
 
 #include <SoftRobots.Inverse/component/constraint/ForceSurfaceActuator.h>
 #include <sofa/core/visual/VisualParams.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPMappedCompliance.h>
+#include <sofa/simulation/MainTaskSchedulerFactory.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 
 namespace softrobotsinverse::constraint
 {
@@ -40,6 +47,7 @@ using sofa::linearalgebra::BaseVector;
 using sofa::core::VecCoordId ;
 using sofa::type::vector;
 using sofa::type::Vec;
+using softrobotsinverse::behavior::ConstraintRowsBuilder;
 using sofa::type::Vec3;
 using sofa::type::Mat;
 using sofa::type::RGBAColor;
@@ -61,6 +69,27 @@ ForceSurfaceActuator<DataTypes>::ForceSurfaceActuator(MechanicalState* object)
     , d_updateNormals(initData(&d_updateNormals, false, "updateNormals",
                                "When considering normals as direction for actuation."))
 
+    , d_normalsTolerance(initData(&d_normalsTolerance, Real(0), "normalsTolerance",
+                                  "If positive, the normals of the triangles and quads are kept between the \n"
+                                  "updates of the normals, and only recomputed when one of their vertices moved \n"
+                                  "by more than this distance. Default value is 0, all the normals are recomputed."))
+
+    , d_multithreading(initData(&d_multithreading, false, "multithreading",
+                                "Average the normals of the spheres concurrently, when normalsTolerance is set. \n"
+                                "Default value is false."))
+
+    , d_parallelConstraintMatrix(initData(&d_parallelConstraintMatrix, false, "parallelConstraintMatrix",
+                                          "Build the rows of the spheres concurrently, in staging buffers committed in \n"
+                                          "order in the constraint matrix. Recommended with many spheres. \n"
+                                          "Default value is false."))
+
+    , d_membershipCache(initData(&d_membershipCache, "membershipCache",
+                                 "If set, binary file of the points, triangles, quads and edges in each sphere and \n"
+                                 "of the ratios of the points, keyed by a hash of the surface, centers and radii. \n"
+                                 "The lists are read from the file when the key matches (e.g. next startup of the \n"
+                                 "scene), otherwise computed and written, and then only recomputed when the \n"
+                                 "surface or the spheres change. Default value is empty (no cache)."))
+
     , d_triangles(initData(&d_triangles, "triangles",
                            "List of triangles describing the surface.\n"
                            "If no list is given, the component will \n"
@@ -146,6 +175,9 @@ void ForceSurfaceActuator<DataTypes>::init()
                            "To remove this error message fix your scene possibly by "
                            "adding a MechanicalObject." ;
 
+    if(d_multithreading.getValue() || d_parallelConstraintMatrix.getValue())
+        sofa::simulation::MainTaskSchedulerFactory::createInRegistry()->init();
+
     initData();
     initLimit();
 }
@@ -180,6 +212,7 @@ void ForceSurfaceActuator<DataTypes>::initData()
         d_triangles.setValue(topology->getTriangles());
         d_quads.setValue(topology->getQuads());
         m_edges = topology->getEdges();
+        m_topologyChanged = true;
     }
     else
     {
@@ -336,66 +369,386 @@ void ForceSurfaceActuator<DataTypes>::updateLimit()
 template<class DataTypes>
 void ForceSurfaceActuator<DataTypes>::computeSurfaces()
 {
-    ReadAccessor<sofa::Data<vector<Triangle> > >  triangles = d_triangles;
-    ReadAccessor<sofa::Data<vector<Quad> > >      quads     = d_quads;
     ReadAccessor<sofa::Data<VecCoord> >      centers     = d_centers;
 
+    if(m_topologyChanged || m_trianglesAroundPoint.size() != d_positions.getValue().size())
+        computePrimitivesAroundPoints();
+
+    // With a membership cache, the lists of the same surface and spheres are kept, or read from the file
+    const std::string& cacheFile = d_membershipCache.getFullPath();
+    const bool useCache = !d_membershipCache.getValue().empty();
+    const uint64_t key = (useCache)? getMembershipKey() : 0;
+    if(useCache && m_hasMembershipKey && key == m_membershipKey)
+        return;
+    if(useCache && !m_hasMembershipKey && readMembership(cacheFile, key))
+    {
+        msg_info(this) << "Points and primitives in the spheres read from " << cacheFile << ".";
+        m_nbMembershipUpdates++;
+        m_membershipKey = key;
+        m_hasMembershipKey = true;
+        return;
+    }
+
     computePointsInSpheres();
 
-    m_trianglesInSpheresId.clear();
+    // A primitive is in a sphere if one of its vertices is, so we only look at the primitives
+    // around the points of the sphere
     m_trianglesInSpheresId.resize(centers.size());
-    for(unsigned int i=0; i<centers.size(); i++)
-        for(unsigned int t=0; t<triangles.size(); t++)
-            if(isTriangleInSphere(t,i))
-                m_trianglesInSpheresId[i].push_back(t);
-
-    m_quadsInSpheresId.clear();
     m_quadsInSpheresId.resize(centers.size());
-    for(unsigned int i=0; i<centers.size(); i++)
-        for(unsigned int q=0; q<quads.size(); q++)
-            if(isQuadInSphere(q,i))
-                m_quadsInSpheresId[i].push_back(q);
-
-    m_edgesInSpheresId.clear();
     m_edgesInSpheresId.resize(centers.size());
     for(unsigned int i=0; i<centers.size(); i++)
-        for(unsigned int e=0; e<m_edges.size(); e++)
-            if(isEdgeInSphere(e,i))
-                m_edgesInSpheresId[i].push_back(e);
+    {
+        getPrimitivesInSphere(m_trianglesAroundPoint, i, m_trianglesInSpheresId[i]);
+        getPrimitivesInSphere(m_quadsAroundPoint, i, m_quadsInSpheresId[i]);
+        getPrimitivesInSphere(m_edgesAroundPoint, i, m_edgesInSpheresId[i]);
+    }
+
+    if(useCache)
+    {
+        if(!m_hasMembershipKey && !writeMembership(cacheFile, key))
+            msg_warning(this) << "Cannot write the points and primitives in the spheres in " << cacheFile << ".";
+        m_membershipKey = key;
+        m_hasMembershipKey = true;
+    }
+}
+
+
+template<class DataTypes>
+uint64_t ForceSurfaceActuator<DataTypes>::getMembershipKey() const
+{
+    using softrobotsinverse::solver::module::QPMappedCompliance;
+    uint64_t key = QPMappedCompliance::s_hashSeed;
+    auto hashVector = [&key](const auto& values) {
+        const uint64_t size = values.size();
+        key = QPMappedCompliance::hash(&size, sizeof(uint64_t), key);
+        key = QPMappedCompliance::hash(values.data(), values.size()*sizeof(values[0]), key);
+    };
+
+    hashVector(d_positions.getValue());
+    hashVector(d_triangles.getValue());
+    hashVector(d_quads.getValue());
+    hashVector(m_edges);
+    hashVector(d_centers.getValue());
+    hashVector(d_radii.getValue());
+    return key;
+}
+
+
+/// File format (binary, byte order of the machine): magic "SRIFSMEM", version, key, number of spheres,
+/// then the points, triangles, quads and edges of each sphere (size and ids), and the ratios of the points
+/// of each sphere (doubles)
+template<class DataTypes>
+bool ForceSurfaceActuator<DataTypes>::readMembership(const std::string& filename, const uint64_t& key)
+{
+    std::ifstream file(filename, std::ios::binary);
+    if(!file.is_open())
+        return false;
+
+    char magic[8];
+    uint32_t version = 0, nbSpheres = 0;
+    uint64_t fileKey = 0;
+    file.read(magic, 8);
+    file.read(reinterpret_cast<char*>(&version), sizeof(uint32_t));
+    file.read(reinterpret_cast<char*>(&fileKey), sizeof(uint64_t));
+    file.read(reinterpret_cast<char*>(&nbSpheres), sizeof(uint32_t));
+    if(!file.good() || std::memcmp(magic, "SRIFSMEM", 8) != 0 || version != 1 || fileKey != key
+            || nbSpheres != d_centers.getValue().size())
+        return false;
+
+    // Ids out of range (e.g. corrupted file) reject the whole file
+    auto readIds = [&file, nbSpheres](vector<vector<unsigned int>>& lists, const size_t& nbIds) {
+        lists.resize(nbSpheres);
+        for(vector<unsigned int>& ids : lists)
+        {
+            uint32_t size = 0;
+            file.read(reinterpret_cast<char*>(&size), sizeof(uint32_t));
+            if(!file.good() || size > nbIds)
+                return false;
+            ids.resize(size);
+            file.read(reinterpret_cast<char*>(ids.data()), size*sizeof(unsigned int));
+            for(unsigned int id : ids)
+                if(id >= nbIds)
+                    return false;
+        }
+        return file.good();
+    };
+
+    const bool isRead = readIds(m_pointsInSphereId, d_positions.getValue().size())
+            && readIds(m_trianglesInSpheresId, d_triangles.getValue().size())
+            && readIds(m_quadsInSpheresId, d_quads.getValue().size())
+            && readIds(m_edgesInSpheresId, m_edges.size());
+
+    bool isValid = isRead;
+    m_ratios.resize(nbSpheres);
+    vector<double> ratios;
+    for(unsigned int i=0; i<nbSpheres && isValid; i++)
+    {
+        ratios.resize(m_pointsInSphereId[i].size());
+        file.read(reinterpret_cast<char*>(ratios.data()), ratios.size()*sizeof(double));
+        isValid = file.good();
+        m_ratios[i].resize(ratios.size());
+        for(unsigned int j=0; j<ratios.size(); j++)
+            m_ratios[i][j] = Real(ratios[j]);
+    }
+
+    if(!isValid)
+    {
+        m_pointsInSphereId.clear();
+        m_trianglesInSpheresId.clear();
+        m_quadsInSpheresId.clear();
+        m_edgesInSpheresId.clear();
+        m_ratios.clear();
+    }
+    return isValid;
+}
+
+
+template<class DataTypes>
+bool ForceSurfaceActuator<DataTypes>::writeMembership(const std::string& filename, const uint64_t& key) const
+{
+    static_assert(sizeof(unsigned int) == sizeof(uint32_t), "The ids are written as 32-bit integers");
+
+    const std::string temporaryFilename = filename + ".tmp";
+    {
+        std::ofstream file(temporaryFilename, std::ios::binary | std::ios::trunc);
+        if(!file.is_open())
+            return false;
+
+        const uint32_t version = 1, nbSpheres = m_pointsInSphereId.size();
+        file.write("SRIFSMEM", 8);
+        file.write(reinterpret_cast<const char*>(&version), sizeof(uint32_t));
+        file.write(reinterpret_cast<const char*>(&key), sizeof(uint64_t));
+        file.write(reinterpret_cast<const char*>(&nbSpheres), sizeof(uint32_t));
+
+        for(const vector<vector<unsigned int>>* lists : {&m_pointsInSphereId, &m_trianglesInSpheresId,
+                                                         &m_quadsInSpheresId, &m_edgesInSpheresId})
+            for(const vector<unsigned int>& ids : *lists)
+            {
+                const uint32_t size = ids.size();
+                file.write(reinterpret_cast<const char*>(&size), sizeof(uint32_t));
+                file.write(reinterpret_cast<const char*>(ids.data()), size*sizeof(unsigned int));
+            }
+
+        vector<double> values;
+        for(const vector<Real>& ratios : m_ratios)
+        {
+            values.resize(ratios.size());
+            for(unsigned int j=0; j<ratios.size(); j++)
+                values[j] = ratios[j];
+            file.write(reinterpret_cast<const char*>(values.data()), values.size()*sizeof(double));
+        }
+
+        file.flush();
+        if(!file.good())
+        {
+            file.close();
+            std::remove(temporaryFilename.c_str());
+            return false;
+        }
+    }
+
+    // Replaces the previous file at once, another process may be reading it
+    if(std::rename(temporaryFilename.c_str(), filename.c_str()) != 0)
+    {
+        std::remove(filename.c_str());
+        if(std::rename(temporaryFilename.c_str(), filename.c_str()) != 0)
+        {
+            std::remove(temporaryFilename.c_str());
+            return false;
+        }
+    }
+    return true;
 }
 
 
 template<class DataTypes>
 void ForceSurfaceActuator<DataTypes>::computePointsInSpheres()
 {
-    ReadAccessor<sofa::Data<vector<Coord> > >     positions = d_positions;
-    ReadAccessor<sofa::Data<VecCoord> >           centers   = d_centers;
-    ReadAccessor<sofa::Data<vector<Real>>>        radii     = d_radii;
+    const VecCoord& positions = d_positions.getValue();
+    const VecCoord& centers = d_centers.getValue();
+    const vector<Real>& radii = d_radii.getValue();
+
+    m_nbMembershipUpdates++;
+    updatePointsGrid();
 
-    m_pointsInSphereId.clear();
     m_pointsInSphereId.resize(centers.size());
-    m_ratios.clear();
     m_ratios.resize(centers.size());
     for(unsigned int i=0; i<centers.size(); i++)
+    {
+        vector<unsigned int>& pointsInSphere = m_pointsInSphereId[i];
+        pointsInSphere.clear();
+
+        if(m_gridCellSize > 0)
+        {
+            // Visit the cells overlapping the bounding box of the sphere
+            Coord offset(radii[i], radii[i], radii[i]);
+            Vec<3,int> minCell = getCell(centers[i] - offset);
+            Vec<3,int> maxCell = getCell(centers[i] + offset);
+            for(int x=minCell[0]; x<=maxCell[0]; x++)
+                for(int y=minCell[1]; y<=maxCell[1]; y++)
+                    for(int z=minCell[2]; z<=maxCell[2]; z++)
+                    {
+                        auto cell = m_grid.find(getCellKey(Vec<3,int>(x,y,z)));
+                        if(cell == m_grid.end())
+                            continue;
+                        for(unsigned int p : cell->second)
+                            if(isPointInSphere(p,i))
+                                pointsInSphere.push_back(p);
+                    }
+
+            // Keep the points in increasing order, independently of the grid
+            std::sort(pointsInSphere.begin(), pointsInSphere.end());
+        }
+        else
+        {
+            for(unsigned int p=0; p<positions.size(); p++)
+                if(isPointInSphere(p,i))
+                    pointsInSphere.push_back(p);
+        }
+
+        m_ratios[i].resize(pointsInSphere.size());
+        for(unsigned int j=0; j<pointsInSphere.size(); j++)
+        {
+            double ratio = rabs((positions[pointsInSphere[j]]-centers[i]).norm() - radii[i])/radii[i];
+            m_ratios[i][j] = ratio;
+        }
+    }
+}
+
+
+template<class DataTypes>
+void ForceSurfaceActuator<DataTypes>::updatePointsGrid()
+{
+    const VecCoord& positions = d_positions.getValue();
+    const vector<Real>& radii = d_radii.getValue();
+
+    Real cellSize = 0;
+    for(const Real& radius : radii)
+        cellSize = std::max(cellSize, radius);
+
+    bool rebuild = (cellSize != m_gridCellSize || m_pointCells.size() != positions.size());
+    if(!rebuild && m_gridCounter == d_positions.getCounter())
+        return;
+
+    m_gridCellSize = cellSize;
+    m_gridCounter = d_positions.getCounter();
+    if(m_gridCellSize <= 0)
+    {
+        m_grid.clear();
+        m_pointCells.clear();
+        return;
+    }
+
+    if(rebuild)
+    {
+        m_grid.clear();
+        m_pointCells.resize(positions.size());
         for(unsigned int p=0; p<positions.size(); p++)
-            if(isPointInSphere(p,i))
-            {
-                double ratio = rabs((positions[p]-centers[i]).norm() - radii[i])/radii[i];
-                m_ratios[i].push_back(ratio);
-                m_pointsInSphereId[i].push_back(p);
-            }
+        {
+            m_pointCells[p] = getCellKey(getCell(positions[p]));
+            m_grid[m_pointCells[p]].push_back(p);
+        }
+        return;
+    }
+
+    // Only move the points that changed cell
+    for(unsigned int p=0; p<positions.size(); p++)
+    {
+        long long key = getCellKey(getCell(positions[p]));
+        if(key == m_pointCells[p])
+            continue;
+
+        vector<unsigned int>& previousCell = m_grid[m_pointCells[p]];
+        auto it = std::find(previousCell.begin(), previousCell.end(), p);
+        if(it != previousCell.end())
+        {
+            *it = previousCell.back();
+            previousCell.pop_back();
+        }
+        if(previousCell.empty())
+            m_grid.erase(m_pointCells[p]);
+
+        m_grid[key].push_back(p);
+        m_pointCells[p] = key;
+    }
 }
 
 
 template<class DataTypes>
-bool ForceSurfaceActuator<DataTypes>::isPointInSphere(unsigned int pointId, unsigned int sphereId)
+Vec<3,int> ForceSurfaceActuator<DataTypes>::getCell(const Coord& position) const
 {
-    ReadAccessor<sofa::Data<VecCoord>>  positions = d_positions;
-    ReadAccessor<sofa::Data<VecCoord>>  centers = d_centers;
-    ReadAccessor<sofa::Data<vector<Real>>>  radii = d_radii;
+    return Vec<3,int>(int(std::floor(position[0]/m_gridCellSize)),
+                      int(std::floor(position[1]/m_gridCellSize)),
+                      int(std::floor(position[2]/m_gridCellSize)));
+}
+
 
-    Coord position = positions[pointId];
-    Coord center = centers[sphereId];
+template<class DataTypes>
+long long ForceSurfaceActuator<DataTypes>::getCellKey(const Vec<3,int>& cell) const
+{
+    // 21 bits per coordinate, unique as long as the scene spans less than a million cells per axis
+    const long long mask = (1LL<<21)-1;
+    return ((cell[0] & mask) << 42) | ((cell[1] & mask) << 21) | (cell[2] & mask);
+}
+
+
+template<class DataTypes>
+void ForceSurfaceActuator<DataTypes>::computePrimitivesAroundPoints()
+{
+    ReadAccessor<sofa::Data<vector<Triangle> > >  triangles = d_triangles;
+    ReadAccessor<sofa::Data<vector<Quad> > >      quads     = d_quads;
+    unsigned int nbPoints = d_positions.getValue().size();
+
+    m_trianglesAroundPoint.clear();
+    m_trianglesAroundPoint.resize(nbPoints);
+    for(unsigned int t=0; t<triangles.size(); t++)
+        for(unsigned int j=0; j<3; j++)
+            if(triangles[t][j] < nbPoints)
+                m_trianglesAroundPoint[triangles[t][j]].push_back(t);
+
+    m_quadsAroundPoint.clear();
+    m_quadsAroundPoint.resize(nbPoints);
+    for(unsigned int q=0; q<quads.size(); q++)
+        for(unsigned int j=0; j<4; j++)
+            if(quads[q][j] < nbPoints)
+                m_quadsAroundPoint[quads[q][j]].push_back(q);
+
+    m_edgesAroundPoint.clear();
+    m_edgesAroundPoint.resize(nbPoints);
+    for(unsigned int e=0; e<m_edges.size(); e++)
+        for(unsigned int j=0; j<2; j++)
+            if(m_edges[e][j] < nbPoints)
+                m_edgesAroundPoint[m_edges[e][j]].push_back(e);
+
+    // The cached normals are indexed by primitive
+    m_triangleNormals.clear();
+    m_quadNormals.clear();
+
+    m_topologyChanged = false;
+}
+
+
+template<class DataTypes>
+void ForceSurfaceActuator<DataTypes>::getPrimitivesInSphere(const vector<vector<unsigned int>>& primitivesAroundPoint,
+                                                            unsigned int sphereId,
+                                                            vector<unsigned int>& primitivesInSphere) const
+{
+    primitivesInSphere.clear();
+    for(unsigned int p : m_pointsInSphereId[sphereId])
+        if(p < primitivesAroundPoint.size())
+            primitivesInSphere.insert(primitivesInSphere.end(), primitivesAroundPoint[p].begin(), primitivesAroundPoint[p].end());
+
+    // A primitive is listed once per vertex in the sphere, keep it once and in increasing order
+    std::sort(primitivesInSphere.begin(), primitivesInSphere.end());
+    primitivesInSphere.erase(std::unique(primitivesInSphere.begin(), primitivesInSphere.end()), primitivesInSphere.end());
+}
+
+
+template<class DataTypes>
+bool ForceSurfaceActuator<DataTypes>::isPointInSphere(unsigned int pointId, unsigned int sphereId)
+{
+    const Coord& position = d_positions.getValue()[pointId];
+    const Coord& center = d_centers.getValue()[sphereId];
     Deriv direction = position - center;
 
     double norm = direction.norm();
@@ -436,7 +789,7 @@ bool ForceSurfaceActuator<DataTypes>::isQuadInSphere(unsigned int quadId, unsign
     unsigned int id1 = quads[quadId][0];
     unsigned int id2 = quads[quadId][1];
     unsigned int id3 = quads[quadId][2];
-    unsigned int id4 = quads[quadId][2];
+    unsigned int id4 = quads[quadId][3];
 
     if(isIndexInPointsList(id1, sphereId) || isIndexInPointsList(id2, sphereId) || isIndexInPointsList(id3, sphereId) || isIndexInPointsList(id4, sphereId))
         return true;
@@ -462,15 +815,11 @@ bool ForceSurfaceActuator<DataTypes>::isEdgeInSphere(unsigned int edgeId, unsign
 
 
 template<class DataTypes>
-bool ForceSurfaceActuator<DataTypes>::isIndexInPointsList(unsigned int index, unsigned int sphereId)
+bool ForceSurfaceActuator<DataTypes>::isIndexInPointsList(unsigned int index, unsigned int sphereId) const
 {
-    vector<unsigned int> list = m_pointsInSphereId[sphereId];
-
-    for(unsigned int i=0; i<list.size(); i++)
-        if(list[i]==index)
-            return true;
-
-    return false;
+    // The points of a sphere are sorted (see computePointsInSpheres)
+    const vector<unsigned int>& list = m_pointsInSphereId[sphereId];
+    return std::binary_search(list.begin(), list.end(), index);
 }
 
 
@@ -478,6 +827,12 @@ bool ForceSurfaceActuator<DataTypes>::isIndexInPointsList(unsigned int index, un
 template<class DataTypes>
 void ForceSurfaceActuator<DataTypes>::computeNormals()
 {
+    if(d_normalsTolerance.getValue() > 0)
+    {
+        computeCachedNormals();
+        return;
+    }
+
     ReadAccessor<sofa::Data<vector<Triangle> > >  triangles = d_triangles;
     ReadAccessor<sofa::Data<vector<Quad> > >      quads     = d_quads;
     ReadAccessor<sofa::Data<VecCoord>>            centers   = d_centers;
@@ -488,35 +843,26 @@ void ForceSurfaceActuator<DataTypes>::computeNormals()
 
     for(unsigned int i=0; i<centers.size(); i++)
     {
-        int nbTrianglesInSphere = m_trianglesInSpheresId[i].size();
-        int nbQuadsInSphere = m_quadsInSpheresId[i].size();
-
         Deriv normal(0,0,0);
-        for(int t=0; t<nbTrianglesInSphere; t++)
+        for(unsigned int triangleId : m_trianglesInSpheresId[i])
         {
-            unsigned int triangleId = m_trianglesInSpheresId[i][t];
-            Triangle triangle = triangles[triangleId];
-
-            Coord p0 = positions[triangle[0]];
-            Coord p1 = positions[triangle[1]];
-            Coord p2 = positions[triangle[2]];
+            const Triangle& triangle = triangles[triangleId];
 
-            Deriv triangleNormal = cross(p1-p0, p2-p0);
+            const Coord& p0 = positions[triangle[0]];
+            const Coord& p1 = positions[triangle[1]];
+            const Coord& p2 = positions[triangle[2]];
 
-            normal += triangleNormal;
+            normal += cross(p1-p0, p2-p0);
         }
-        for(int q=0; q<nbQuadsInSphere; q++)
+        for(unsigned int quadId : m_quadsInSpheresId[i])
         {
-            unsigned int quadId = m_quadsInSpheresId[i][q];
-            Quad quad = quads[quadId];
-
-            Coord p0 = positions[quad[0]];
-            Coord p1 = positions[quad[1]];
-            Coord p2 = positions[quad[2]];
+            const Quad& quad = quads[quadId];
 
-            Deriv quadNormal = cross(p1-p0, p2-p0);
+            const Coord& p0 = positions[quad[0]];
+            const Coord& p1 = positions[quad[1]];
+            const Coord& p2 = positions[quad[2]];
 
-            normal += quadNormal;
+            normal += cross(p1-p0, p2-p0);
         }
         normal.normalize();
         directions[i] = normal;
@@ -524,6 +870,109 @@ void ForceSurfaceActuator<DataTypes>::computeNormals()
 }
 
 
+template<class DataTypes>
+void ForceSurfaceActuator<DataTypes>::computeCachedNormals()
+{
+    ReadAccessor<sofa::Data<VecCoord>>            centers   = d_centers;
+    WriteAccessor<sofa::Data<VecDeriv>>           directions= d_directions;
+    const VecCoord& positions = m_state->read(ConstVecCoordId::position())->getValue();
+
+    updatePrimitiveNormals(positions);
+
+    // The normals of the primitives are up to date, the average of each sphere only reads them
+    directions.resize(centers.size());
+    unsigned int nbSpheres = centers.size();
+    if(d_multithreading.getValue() && nbSpheres > 1)
+    {
+        sofa::simulation::TaskScheduler* taskScheduler = sofa::simulation::MainTaskSchedulerFactory::createInRegistry();
+        sofa::simulation::CpuTask::Status status;
+
+        vector<AverageNormalTask> tasks;
+        tasks.resize(nbSpheres, AverageNormalTask(&status));
+        for(unsigned int i=0; i<nbSpheres; i++)
+        {
+            tasks[i].set(this, i, &directions[i]);
+            taskScheduler->addTask(&tasks[i]);
+        }
+        taskScheduler->workUntilDone(&status);
+    }
+    else
+    {
+        for(unsigned int i=0; i<nbSpheres; i++)
+            averageNormal(i, directions[i]);
+    }
+}
+
+
+template<class DataTypes>
+void ForceSurfaceActuator<DataTypes>::updatePrimitiveNormals(const VecCoord& positions)
+{
+    ReadAccessor<sofa::Data<vector<Triangle> > >  triangles = d_triangles;
+    ReadAccessor<sofa::Data<vector<Quad> > >      quads     = d_quads;
+    const Real tolerance = d_normalsTolerance.getValue();
+
+    if(m_triangleNormals.size() != triangles.size() || m_quadNormals.size() != quads.size()
+            || m_normalsPositions.size() != positions.size())
+    {
+        m_triangleNormals.reset(triangles.size());
+        m_quadNormals.reset(quads.size());
+        m_normalsPositions = positions;
+    }
+
+    // Invalidate the normals around the points that moved by more than the tolerance
+    for(unsigned int p=0; p<positions.size(); p++)
+    {
+        if((positions[p]-m_normalsPositions[p]).norm() <= tolerance)
+            continue;
+
+        m_normalsPositions[p] = positions[p];
+        if(p < m_trianglesAroundPoint.size())
+        {
+            m_triangleNormals.invalidate(m_trianglesAroundPoint[p]);
+            m_quadNormals.invalidate(m_quadsAroundPoint[p]);
+        }
+    }
+
+    // Recompute the invalid normals of the spheres, once per primitive even if shared between spheres
+    m_nbUpdatedNormals = 0;
+    for(unsigned int i=0; i<m_trianglesInSpheresId.size(); i++)
+    {
+        for(unsigned int triangleId : m_trianglesInSpheresId[i])
+        {
+            if(m_triangleNormals.isValid[triangleId])
+                continue;
+
+            const Triangle& triangle = triangles[triangleId];
+            const Coord& p0 = positions[triangle[0]];
+            m_triangleNormals.set(triangleId, cross(positions[triangle[1]]-p0, positions[triangle[2]]-p0));
+            m_nbUpdatedNormals++;
+        }
+        for(unsigned int quadId : m_quadsInSpheresId[i])
+        {
+            if(m_quadNormals.isValid[quadId])
+                continue;
+
+            const Quad& quad = quads[quadId];
+            const Coord& p0 = positions[quad[0]];
+            m_quadNormals.set(quadId, cross(positions[quad[1]]-p0, positions[quad[2]]-p0));
+            m_nbUpdatedNormals++;
+        }
+    }
+}
+
+
+template<class DataTypes>
+void ForceSurfaceActuator<DataTypes>::averageNormal(const unsigned int sphereId, Deriv& normal) const
+{
+    normal = Deriv(0,0,0);
+    for(unsigned int triangleId : m_trianglesInSpheresId[sphereId])
+        normal += Deriv(m_triangleNormals.x[triangleId], m_triangleNormals.y[triangleId], m_triangleNormals.z[triangleId]);
+    for(unsigned int quadId : m_quadsInSpheresId[sphereId])
+        normal += Deriv(m_quadNormals.x[quadId], m_quadNormals.y[quadId], m_quadNormals.z[quadId]);
+    normal.normalize();
+}
+
+
 template<class DataTypes>
 void ForceSurfaceActuator<DataTypes>::buildConstraintMatrix(const ConstraintParams* cParams,
                                                             DataMatrixDeriv &cMatrix,
@@ -547,6 +996,7 @@ void ForceSurfaceActuator<DataTypes>::buildConstraintMatrix(const ConstraintPara
         d_triangles.setValue(topology->getTriangles());
         d_quads.setValue(topology->getQuads());
         m_edges = topology->getEdges();
+        m_topologyChanged = true;
     }
     else
     {
@@ -556,21 +1006,24 @@ void ForceSurfaceActuator<DataTypes>::buildConstraintMatrix(const ConstraintPara
 
     /// Check that the position datafield contain something, otherwise get context
     /// topology
-    WriteAccessor<sofa::Data<VecCoord> > positions = d_positions;
+    /// The accessor is only taken when filling the list, so that the grid of the spheres is not rebuilt
+    /// at each step (see updatePointsGrid)
     if(d_positions.getValue().size() == 0)
     {
         msg_info(this) <<"No positions given. Get context mechanical rest position.";
+        WriteAccessor<sofa::Data<VecCoord> > positions = d_positions;
         ReadAccessor<sofa::Data<VecCoord> > restPositions = m_state->readRestPositions();
         positions.resize(restPositions.size());
         for(unsigned int i=0; i<restPositions.size(); i++)
             positions[i] = restPositions[i];
     }
+    const VecCoord& positions = d_positions.getValue();
 
 
     /// Check that the triangles datafield does not contains indices that would crash the
     /// component.
     int numTris = d_triangles.getValue().size() ;
-    auto triangles = d_triangles.getValue() ;
+    const auto& triangles = d_triangles.getValue() ;
     for(int i=0;i<numTris;i++){
         for(int j=0;j<3;j++){
             if( triangles[i][j] >= positions.size() )
@@ -582,7 +1035,7 @@ void ForceSurfaceActuator<DataTypes>::buildConstraintMatrix(const ConstraintPara
     /// Check that the quads datafield does not contains indices that would crash the
     /// component.
     int numQuads = d_quads.getValue().size() ;
-    auto quads = d_quads.getValue() ;
+    const auto& quads = d_quads.getValue() ;
     for(int i=0;i<numQuads;i++){
         for(int j=0;j<4;j++){
             if( quads[i][j] >= positions.size() )
@@ -627,13 +1080,26 @@ void ForceSurfaceActuator<DataTypes>::buildConstraintMatrix(const ConstraintPara
     ReadAccessor<sofa::Data<VecCoord>> centers = d_centers;
 
     MatrixDeriv& matrix = *cMatrix.beginEdit();
-    for(unsigned int i=0; i<centers.size(); i++)
+    if(d_parallelConstraintMatrix.getValue())
     {
-        MatrixDerivRowIterator rowIterator = matrix.writeLine(m_constraintId+i);
-        for(unsigned int j=0; j<m_pointsInSphereId[i].size(); j++)
-            rowIterator.addCol(m_pointsInSphereId[i][j], directions[i]*m_ratios[i][j]);
+        m_rowsBuilder.build(matrix, m_constraintId, centers.size(), true,
+                            [this, &directions](const unsigned int i, typename ConstraintRowsBuilder<DataTypes>::Chunk& chunk)
+        {
+            for(unsigned int j=0; j<m_pointsInSphereId[i].size(); j++)
+                chunk.addCol(m_pointsInSphereId[i][j], directions[i]*m_ratios[i][j]);
+        });
+        cIndex += centers.size();
+    }
+    else
+    {
+        for(unsigned int i=0; i<centers.size(); i++)
+        {
+            MatrixDerivRowIterator rowIterator = matrix.writeLine(m_constraintId+i);
+            for(unsigned int j=0; j<m_pointsInSphereId[i].size(); j++)
+                rowIterator.addCol(m_pointsInSphereId[i][j], directions[i]*m_ratios[i][j]);
 
-        cIndex++;
+            cIndex++;
+        }
     }
     cMatrix.endEdit();
 
@@ -710,21 +1176,35 @@ void ForceSurfaceActuator<DataTypes>::draw(const VisualParams* vparams)
 
 
 template<class DataTypes>
-void ForceSurfaceActuator<DataTypes>::drawForces(const VisualParams* vparams)
+void ForceSurfaceActuator<DataTypes>::updateForcesBuffer()
 {
-    if(m_state == nullptr || d_force.getValue().size()==0)
+    const sofa::Data<VecCoord>* positionsData = m_state->read(ConstVecCoordId::position());
+    if(!m_forcesBuffer.update({positionsData->getCounter(), d_force.getCounter(), d_directions.getCounter(),
+                               d_visuScale.getCounter(), int(m_nbMembershipUpdates)}))
         return;
 
-    VecDeriv directions = d_directions.getValue();
-
-    ReadAccessor<sofa::Data<VecCoord> > positions = m_state->readPositions();
+    ReadAccessor<sofa::Data<VecDeriv>> directions = d_directions;
+    ReadAccessor<sofa::Data<VecCoord> > positions = *positionsData;
     ReadAccessor<sofa::Data<vector<Real>>> force = d_force;
 
-    RGBAColor color(0,1,0,1);
-    for(unsigned int i=0; i<directions.size(); i++)
+    for(unsigned int i=0; i<directions.size() && i<force.size() && i<m_pointsInSphereId.size(); i++)
         for(unsigned int j=0; j<m_pointsInSphereId[i].size(); j++)
-            if(m_pointsInSphereId[i][j]<m_state->getSize())
-                vparams->drawTool()->drawArrow(positions[m_pointsInSphereId[i][j]] - directions[i]*force[i]*m_ratios[i][j], positions[m_pointsInSphereId[i][j]], d_visuScale.getValue(), color, 4);
+            if(m_pointsInSphereId[i][j]<positions.size())
+            {
+                const Coord& position = positions[m_pointsInSphereId[i][j]];
+                m_forcesBuffer.addArrow(position - directions[i]*force[i]*m_ratios[i][j], position, d_visuScale.getValue());
+            }
+}
+
+
+template<class DataTypes>
+void ForceSurfaceActuator<DataTypes>::drawForces(const VisualParams* vparams)
+{
+    if(m_state == nullptr || d_force.getValue().size()==0)
+        return;
+
+    updateForcesBuffer();
+    vparams->drawTool()->drawLines(m_forcesBuffer.points, 2.0f, RGBAColor(0,1,0,1));
 }
 
 
@@ -753,18 +1233,22 @@ void ForceSurfaceActuator<DataTypes>::drawSurfaces(const VisualParams* vparams)
 template<class DataTypes>
 void ForceSurfaceActuator<DataTypes>::drawTriangles(const VisualParams* vparams)
 {
-    ReadAccessor<sofa::Data<VecCoord> > x = m_state->readPositions();
-    ReadAccessor<sofa::Data<vector<Triangle>>> triangles  = d_triangles;
-    vector<Vec3> points;
+    const sofa::Data<VecCoord>* positionsData = m_state->read(ConstVecCoordId::position());
+    vector<Vec3>& points = m_trianglesBuffer.points;
+    if(m_trianglesBuffer.update({positionsData->getCounter(), d_triangles.getCounter(), int(m_nbMembershipUpdates)}))
+    {
+        ReadAccessor<sofa::Data<VecCoord> > x = *positionsData;
+        ReadAccessor<sofa::Data<vector<Triangle>>> triangles  = d_triangles;
 
-    for (unsigned int i=0; i<m_trianglesInSpheresId.size(); i++)
-        for (unsigned int t=0; t<m_trianglesInSpheresId[i].size(); t++)
-        {
-            Triangle tri = triangles[m_trianglesInSpheresId[i][t]];
-            points.push_back(x[tri[0]]);
-            points.push_back(x[tri[1]]);
-            points.push_back(x[tri[2]]);
-        }
+        for (unsigned int i=0; i<m_trianglesInSpheresId.size(); i++)
+            for (unsigned int t=0; t<m_trianglesInSpheresId[i].size(); t++)
+            {
+                const Triangle& tri = triangles[m_trianglesInSpheresId[i][t]];
+                points.push_back(x[tri[0]]);
+                points.push_back(x[tri[1]]);
+                points.push_back(x[tri[2]]);
+            }
+    }
 
     vparams->drawTool()->drawTriangles(points, sofa::type::RGBAColor(0.6f,0.0f,0.0f,1.0f));
 }
@@ -772,17 +1256,22 @@ void ForceSurfaceActuator<DataTypes>::drawTriangles(const VisualParams* vparams)
 template<class DataTypes>
 void ForceSurfaceActuator<DataTypes>::drawLines(const VisualParams* vparams)
 {
-    ReadAccessor<sofa::Data<VecCoord> > x = m_state->readPositions();
-    vector<Vec3> points;
+    // The edges are computed from the triangles and the quads
+    const sofa::Data<VecCoord>* positionsData = m_state->read(ConstVecCoordId::position());
+    vector<Vec3>& points = m_linesBuffer.points;
+    if(m_linesBuffer.update({positionsData->getCounter(), d_triangles.getCounter(), d_quads.getCounter(), int(m_nbMembershipUpdates)}))
+    {
+        ReadAccessor<sofa::Data<VecCoord> > x = *positionsData;
 
-    for (unsigned int i=0; i<m_edgesInSpheresId.size(); i++)
-        for (unsigned int e=0; e<m_edgesInSpheresId[i].size(); e++)
-        {
-            Edge edge = m_edges[m_edgesInSpheresId[i][e]];
+        for (unsigned int i=0; i<m_edgesInSpheresId.size(); i++)
+            for (unsigned int e=0; e<m_edgesInSpheresId[i].size(); e++)
+            {
+                const Edge& edge = m_edges[m_edgesInSpheresId[i][e]];
 
-            points.push_back(x[edge[0]]);
-            points.push_back(x[edge[1]]);
-        }
+                points.push_back(x[edge[0]]);
+                points.push_back(x[edge[1]]);
+            }
+    }
 
     vparams->drawTool()->drawLines(points, 1.0f, sofa::type::RGBAColor(0.2f,0.0f,0.0f,1.0f));
 }
@@ -794,6 +1283,13 @@ void ForceSurfaceActuator<DataTypes>::computeEdges()
     ReadAccessor<sofa::Data<vector<Triangle>>> triList  = d_triangles;
     ReadAccessor<sofa::Data<vector<Quad>>>   quadList = d_quads;
 
+    // The edges only depend on the topology
+    if(m_edgesTrianglesCounter == d_triangles.getCounter() && m_edgesQuadsCounter == d_quads.getCounter())
+        return;
+    m_edgesTrianglesCounter = d_triangles.getCounter();
+    m_edgesQuadsCounter = d_quads.getCounter();
+    m_topologyChanged = true;
+
     std::map<Edge,unsigned int> edgeMap;
     unsigned int edgeIndex;
     m_edges.clear();
@@ -29,6 +29,7 @@
 #pragma once
 
 #include <SoftRobots.Inverse/component/behavior/Actuator.h>
+#include <SoftRobots.Inverse/component/behavior/ConcurrentResults.h>
 #include <sofa/core/topology/BaseMeshTopology.h>
 
 #include <SoftRobots.Inverse/component/config.h>
@@ -50,7 +51,7 @@ namespace softrobotsinverse::constraint
  * https://softrobotscomponents.readthedocs.io
 */
 template< class DataTypes >
-class JointActuator : public Actuator<DataTypes>
+class JointActuator : public Actuator<DataTypes>, public softrobotsinverse::behavior::ConcurrentResults
 {
 public:
     SOFA_CLASS(SOFA_TEMPLATE(JointActuator,DataTypes), SOFA_TEMPLATE(sofa::core::behavior::Actuator,DataTypes));
@@ -0,0 +1,161 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <SoftRobots.Inverse/component/behavior/Actuator.h>
+#include <SoftRobots.Inverse/component/behavior/ConcurrentResults.h>
+
+#include <SoftRobots.Inverse/component/config.h>
+
+namespace softrobotsinverse::constraint
+{
+
+using sofa::core::behavior::Actuator;
+using sofa::helper::ReadAccessor;
+using sofa::core::ConstraintParams;
+using sofa::linearalgebra::BaseVector;
+using softrobots::behavior::SoftRobotsConstraint;
+
+
+/**
+ * This component applies efforts on an array of joints (Vec1) to solve an inverse problem.
+ * It is equivalent to one JointActuator per joint, with one row per joint in a single block. The limits
+ * are given once for all the joints, or with one value per joint, and are updated in one pass over
+ * the joints for each kind of limit.
+*/
+template< class DataTypes >
+class JointActuatorArray : public Actuator<DataTypes>, public softrobotsinverse::behavior::ConcurrentResults
+{
+public:
+    SOFA_CLASS(SOFA_TEMPLATE(JointActuatorArray,DataTypes), SOFA_TEMPLATE(Actuator,DataTypes));
+
+    typedef typename DataTypes::VecCoord VecCoord;
+    typedef typename DataTypes::VecDeriv VecDeriv;
+    typedef typename DataTypes::Coord Coord;
+    typedef typename DataTypes::Deriv Deriv;
+    typedef typename DataTypes::MatrixDeriv MatrixDeriv;
+    typedef typename Coord::value_type Real;
+    typedef typename sofa::core::behavior::MechanicalState<DataTypes> MechanicalState;
+
+    typedef typename DataTypes::MatrixDeriv::RowIterator MatrixDerivRowIterator;
+    typedef sofa::core::objectmodel::Data<VecCoord>		DataVecCoord;
+    typedef sofa::core::objectmodel::Data<VecDeriv>		DataVecDeriv;
+    typedef sofa::core::objectmodel::Data<MatrixDeriv>    DataMatrixDeriv;
+
+    typedef sofa::type::vector<unsigned int> SetIndexArray;
+    typedef sofa::type::vector<Real> VecReal;
+    typedef Actuator<DataTypes> Inherit;
+
+public:
+    JointActuatorArray(MechanicalState* object = nullptr);
+    ~JointActuatorArray() override;
+
+    ////////////////////////// Inherited from BaseObject ////////////////////
+    void init() override;
+    void reinit() override;
+    void reset() override;
+    /////////////////////////////////////////////////////////////////////////
+
+    //////////////// Inherited from SoftRobotsConstraint ///////////////
+    void buildConstraintMatrix(const ConstraintParams* cParams,
+                               DataMatrixDeriv &cMatrix,
+                               unsigned int &cIndex,
+                               const DataVecCoord &x) override;
+
+    void getConstraintViolation(const ConstraintParams* cParams,
+                                BaseVector *resV,
+                                const BaseVector * Jdx) override;
+    /////////////////////////////////////////////////////////////////////////
+
+    /////////////// Inherited from BaseSoftRobotsConstraint /////////////
+    void storeResults(sofa::type::vector<double> &lambda,
+                      sofa::type::vector<double> &delta) override;
+    /////////////////////////////////////////////////////////////
+
+    unsigned int getNbJoints() const {return d_indices.getValue().size();}
+
+protected:
+
+    ////////////////////////// Inherited attributes ////////////////////////////
+    /// https://gcc.gnu.org/onlinedocs/gcc/Name-lookup.html
+    /// Bring inherited attributes and function in the current lookup context.
+    /// otherwise any access to the base::attribute would require
+    /// the "this->" approach.
+    using Inherit::m_hasDeltaMax ;
+    using Inherit::m_hasDeltaMin ;
+    using Inherit::m_deltaMax ;
+    using Inherit::m_deltaMin ;
+
+    using Inherit::m_hasLambdaMax ;
+    using Inherit::m_hasLambdaMin ;
+    using Inherit::m_lambdaMax ;
+    using Inherit::m_lambdaMin ;
+
+    using Inherit::m_nbLines ;
+    using Inherit::m_constraintId ;
+    using Inherit::d_componentState ;
+
+    using Inherit::m_state ;
+    ////////////////////////////////////////////////////////////////////////////
+
+    sofa::Data<SetIndexArray>         d_indices;
+
+    sofa::Data<VecReal>               d_initEffort;
+    sofa::Data<VecReal>               d_initAngle;
+    sofa::Data<VecReal>               d_maxEffort;
+    sofa::Data<VecReal>               d_minEffort;
+    sofa::Data<VecReal>               d_maxEffortVariation;
+    sofa::Data<VecReal>               d_maxAngle;
+    sofa::Data<VecReal>               d_minAngle;
+    sofa::Data<VecReal>               d_maxAngleVariation;
+
+    sofa::Data<VecReal>               d_effort;
+    sofa::Data<VecReal>               d_angle;
+
+    // Limits with one value per joint, set from the data at init (empty if the data is not set)
+    VecReal m_initAngle;
+    VecReal m_maxEffort;
+    VecReal m_minEffort;
+    VecReal m_maxEffortVariation;
+    VecReal m_maxAngle;
+    VecReal m_minAngle;
+    VecReal m_maxAngleVariation;
+
+    bool checkJoints();
+    bool getPerJointValues(const sofa::Data<VecReal>& data, VecReal& values);
+    void initDatas();
+    void initLimit();
+    void updateLimit();
+};
+
+#if !defined(SOFTROBOTS_INVERSE_CONSTRAINT_JOINTACTUATORARRAY_CPP)
+extern template class SOFA_SOFTROBOTS_INVERSE_API JointActuatorArray<sofa::defaulttype::Vec1Types>;
+#endif
+
+} // namespace
@@ -0,0 +1,391 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <SoftRobots.Inverse/component/constraint/JointActuatorArray.h>
+
+namespace softrobotsinverse::constraint
+{
+
+using sofa::core::objectmodel::ComponentState ;
+
+using sofa::linearalgebra::BaseVector;
+using sofa::helper::ReadAccessor;
+using sofa::helper::WriteOnlyAccessor;
+using sofa::helper::rabs;
+
+template<class DataTypes>
+JointActuatorArray<DataTypes>::JointActuatorArray(MechanicalState* object)
+    : Inherit(object)
+    , d_indices(initData(&d_indices, "indices",
+                         "Indices of the joints in the mechanical state, one row per joint. \n"
+                         "If unspecified, all the points of the mechanical state are joints."))
+
+    , d_initEffort(initData(&d_initEffort, "initEffort",
+                            "Initial effort of the joints, one value for all the joints or one per joint. \n"
+                            "Default is 0."))
+
+    , d_initAngle(initData(&d_initAngle, "initAngle",
+                           "Initial angle of the joints, one value for all the joints or one per joint. \n"
+                           "Default is 0."))
+
+    , d_maxEffort(initData(&d_maxEffort, "maxEffort",
+                           "Maximum effort of the joints, one value for all the joints or one per joint. \n"
+                           "If unspecified no maximum value will be considered."))
+
+    , d_minEffort(initData(&d_minEffort, "minEffort",
+                           "Minimum effort of the joints, one value for all the joints or one per joint. \n"
+                           "If unspecified no minimum value will be considered."))
+
+    , d_maxEffortVariation(initData(&d_maxEffortVariation, "maxEffortVariation",
+                                    "Maximum variation of the effort allowed in a step, one value for all the \n"
+                                    "joints or one per joint. If unspecified no max variation will be considered."))
+
+    , d_maxAngle(initData(&d_maxAngle, "maxAngle",
+                          "Maximum angle of the joints in radian, one value for all the joints or one per joint. \n"
+                          "If unspecified no maximum value will be considered."))
+
+    , d_minAngle(initData(&d_minAngle, "minAngle",
+                          "Minimum angle of the joints in radian, one value for all the joints or one per joint. \n"
+                          "If unspecified no minimum value will be considered."))
+
+    , d_maxAngleVariation(initData(&d_maxAngleVariation, "maxAngleVariation",
+                                   "Maximum variation of the angle allowed in a step in radian, one value for all \n"
+                                   "the joints or one per joint. If unspecified no max variation will be considered."))
+
+    , d_effort(initData(&d_effort, "effort",
+                        "Output effort of each joint. Warning: to get the actual effort you should divide this value by dt."))
+
+    , d_angle(initData(&d_angle, "angle",
+                       "Output angle of each joint."))
+{
+    d_indices.setGroup("Input");
+    d_initEffort.setGroup("Input");
+    d_initAngle.setGroup("Input");
+    d_maxEffort.setGroup("Input");
+    d_minEffort.setGroup("Input");
+    d_maxEffortVariation.setGroup("Input");
+    d_maxAngle.setGroup("Input");
+    d_minAngle.setGroup("Input");
+    d_maxAngleVariation.setGroup("Input");
+
+    d_effort.setGroup("Output");
+    d_angle.setGroup("Output");
+    d_effort.setReadOnly(true);
+    d_angle.setReadOnly(true);
+}
+
+
+template<class DataTypes>
+JointActuatorArray<DataTypes>::~JointActuatorArray()
+{
+}
+
+
+template<class DataTypes>
+void JointActuatorArray<DataTypes>::init()
+{
+    d_componentState = ComponentState::Invalid ;
+    SoftRobotsConstraint<DataTypes>::init();
+
+    if(m_state==nullptr)
+    {
+        msg_error(this) << "There is no mechanical state associated with this node. "
+                            "the object is deactivated. "
+                            "To remove this error message fix your scene possibly by "
+                            "adding a MechanicalObject." ;
+        return ;
+    }
+
+    if(!d_indices.isSet())
+    {
+        WriteOnlyAccessor<sofa::Data<SetIndexArray>> indices = d_indices;
+        indices.resize(m_state->getSize());
+        for(unsigned int i=0; i<indices.size(); i++)
+            indices[i] = i;
+    }
+
+    if(!checkJoints())
+        return;
+
+    initDatas();
+    initLimit();
+
+    d_componentState = ComponentState::Valid ;
+}
+
+
+template<class DataTypes>
+void JointActuatorArray<DataTypes>::reinit()
+{
+    if(d_componentState.getValue() != ComponentState::Valid)
+        return ;
+
+    if(!checkJoints())
+    {
+        d_componentState = ComponentState::Invalid ;
+        return;
+    }
+
+    initDatas();
+    initLimit();
+}
+
+
+template<class DataTypes>
+void JointActuatorArray<DataTypes>::reset()
+{
+    reinit();
+}
+
+
+template<class DataTypes>
+bool JointActuatorArray<DataTypes>::checkJoints()
+{
+    ReadAccessor<sofa::Data<SetIndexArray>> indices = d_indices;
+    if(indices.empty())
+    {
+        msg_error(this) << "No joint given, the object is deactivated.";
+        return false;
+    }
+
+    for(unsigned int i=0; i<indices.size(); i++)
+        if(indices[i] >= m_state->getSize())
+        {
+            msg_error(this) << "Indices at index " << i << " is too large regarding mechanicalState [position] size, "
+                            << "the object is deactivated.";
+            return false;
+        }
+
+    VecReal initEffort;
+    if(!getPerJointValues(d_initEffort, initEffort) ||
+       !getPerJointValues(d_initAngle, m_initAngle) ||
+       !getPerJointValues(d_maxEffort, m_maxEffort) ||
+       !getPerJointValues(d_minEffort, m_minEffort) ||
+       !getPerJointValues(d_maxEffortVariation, m_maxEffortVariation) ||
+       !getPerJointValues(d_maxAngle, m_maxAngle) ||
+       !getPerJointValues(d_minAngle, m_minAngle) ||
+       !getPerJointValues(d_maxAngleVariation, m_maxAngleVariation))
+        return false;
+
+    // QP on one value per joint
+    const unsigned int nbJoints = indices.size();
+    if(m_initAngle.empty())
+        m_initAngle.assign(nbJoints, Real(0.0));
+    m_deltaMax.resize(nbJoints);
+    m_deltaMin.resize(nbJoints);
+    m_lambdaMax.resize(nbJoints);
+    m_lambdaMin.resize(nbJoints);
+
+    return true;
+}
+
+
+template<class DataTypes>
+bool JointActuatorArray<DataTypes>::getPerJointValues(const sofa::Data<VecReal>& data, VecReal& values)
+{
+    const VecReal& value = data.getValue();
+    const unsigned int nbJoints = getNbJoints();
+
+    if(!data.isSet() || value.empty())
+        values.clear();
+    else if(value.size() == 1)
+        values.assign(nbJoints, value[0]);
+    else if(value.size() == nbJoints)
+        values = value;
+    else
+    {
+        msg_error(this) << data.getName() << " should give one value, or one value per joint (" << nbJoints << "), "
+                        << "the object is deactivated.";
+        return false;
+    }
+    return true;
+}
+
+
+template<class DataTypes>
+void JointActuatorArray<DataTypes>::initDatas()
+{
+    VecReal initEffort;
+    getPerJointValues(d_initEffort, initEffort);
+    if(initEffort.empty())
+        initEffort.assign(getNbJoints(), Real(0.0));
+
+    d_effort.setValue(initEffort);
+    d_angle.setValue(m_initAngle);
+}
+
+
+template<class DataTypes>
+void JointActuatorArray<DataTypes>::initLimit()
+{
+    m_hasLambdaMax = !m_maxEffort.empty() || !m_maxEffortVariation.empty();
+    m_hasLambdaMin = !m_minEffort.empty() || !m_maxEffortVariation.empty();
+    m_hasDeltaMax = !m_maxAngle.empty() || !m_maxAngleVariation.empty();
+    m_hasDeltaMin = !m_minAngle.empty() || !m_maxAngleVariation.empty();
+    updateLimit();
+}
+
+
+template<class DataTypes>
+void JointActuatorArray<DataTypes>::updateLimit()
+{
+    // One pass over the arrays of the joints for each limit
+    const unsigned int nbJoints = getNbJoints();
+
+    if(!m_maxEffort.empty())
+        for(unsigned int i=0; i<nbJoints; i++)
+            m_lambdaMax[i] = m_maxEffort[i];
+
+    if(!m_minEffort.empty())
+        for(unsigned int i=0; i<nbJoints; i++)
+            m_lambdaMin[i] = m_minEffort[i];
+
+    if(!m_maxAngle.empty())
+        for(unsigned int i=0; i<nbJoints; i++)
+            m_deltaMax[i] = m_maxAngle[i];
+
+    if(!m_minAngle.empty())
+        for(unsigned int i=0; i<nbJoints; i++)
+            m_deltaMin[i] = m_minAngle[i];
+
+    if(!m_maxEffortVariation.empty())
+    {
+        ReadAccessor<sofa::Data<VecReal>> effort = d_effort;
+        const bool hasMaxEffort = !m_maxEffort.empty();
+        const bool hasMinEffort = !m_minEffort.empty();
+        for(unsigned int i=0; i<nbJoints; i++)
+        {
+            const double variation = m_maxEffortVariation[i];
+            if(rabs(m_lambdaMin[i] - effort[i]) >= variation || !hasMinEffort)
+                m_lambdaMin[i] = effort[i] - variation;
+            if(rabs(m_lambdaMax[i] - effort[i]) >= variation || !hasMaxEffort)
+                m_lambdaMax[i] = effort[i] + variation;
+        }
+    }
+
+    if(!m_maxAngleVariation.empty())
+    {
+        ReadAccessor<sofa::Data<VecReal>> angle = d_angle;
+        const bool hasMaxAngle = !m_maxAngle.empty();
+        const bool hasMinAngle = !m_minAngle.empty();
+        for(unsigned int i=0; i<nbJoints; i++)
+        {
+            const double variation = m_maxAngleVariation[i];
+            if(rabs(m_deltaMin[i] - angle[i]) >= variation || !hasMinAngle)
+                m_deltaMin[i] = angle[i] - variation;
+            if(rabs(m_deltaMax[i] - angle[i]) >= variation || !hasMaxAngle)
+                m_deltaMax[i] = angle[i] + variation;
+        }
+    }
+}
+
+
+template<class DataTypes>
+void JointActuatorArray<DataTypes>::buildConstraintMatrix(const ConstraintParams* cParams,
+                                                          DataMatrixDeriv &cMatrix,
+                                                          unsigned int &cIndex,
+                                                          const DataVecCoord &x)
+{
+    SOFA_UNUSED(cParams);
+    SOFA_UNUSED(x);
+
+    if(d_componentState.getValue() != ComponentState::Valid)
+        return ;
+
+    m_constraintId = cIndex;
+
+    MatrixDeriv& matrix = *cMatrix.beginEdit();
+    const SetIndexArray& indices = d_indices.getValue();
+
+    // One block of rows, one row per joint
+    const unsigned int nbJoints = indices.size();
+    for(unsigned int i=0; i<nbJoints; i++)
+    {
+        MatrixDerivRowIterator rowIterator = matrix.writeLine(m_constraintId+i);
+        rowIterator.addCol(indices[i], Deriv(1.));
+    }
+
+    cIndex += nbJoints;
+    cMatrix.endEdit();
+    m_nbLines = cIndex - m_constraintId;
+}
+
+
+template<class DataTypes>
+void JointActuatorArray<DataTypes>::getConstraintViolation(const ConstraintParams* cParams,
+                                                           BaseVector *resV,
+                                                           const BaseVector *Jdx)
+{
+    SOFA_UNUSED(cParams);
+
+    if(d_componentState.getValue() != ComponentState::Valid)
+        return ;
+
+    ReadAccessor<sofa::Data<VecReal>> angle = d_angle;
+
+    const unsigned int nbJoints = getNbJoints();
+    const bool withJdx = (Jdx->size()!=0);
+    for(unsigned int i=0; i<nbJoints; i++)
+    {
+        Real dFree = angle[i] - m_initAngle[i];
+        if(withJdx)
+            dFree += Jdx->element(i);
+        resV->set(m_constraintId+i, dFree);
+    }
+}
+
+
+template<class DataTypes>
+void JointActuatorArray<DataTypes>::storeResults(sofa::type::vector<double> &lambda,
+                                                 sofa::type::vector<double> &delta)
+{
+    if(d_componentState.getValue() != ComponentState::Valid)
+        return ;
+
+    {
+        const unsigned int nbJoints = getNbJoints();
+        WriteOnlyAccessor<sofa::Data<VecReal>> effort = d_effort;
+        WriteOnlyAccessor<sofa::Data<VecReal>> angle = d_angle;
+        effort.resize(nbJoints);
+        angle.resize(nbJoints);
+        for(unsigned int i=0; i<nbJoints; i++)
+        {
+            effort[i] = lambda[i];
+            angle[i] = delta[i];
+        }
+    }
+
+    updateLimit();
+
+    Actuator<DataTypes>::storeResults(lambda, delta);
+}
+
+
+} // namespace
@@ -0,0 +1,92 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <sofa/component/constraint/lagrangian/correction/LinearSolverConstraintCorrection.h>
+#include <SoftRobots.Inverse/component/behavior/ComplianceOperator.h>
+
+#include <SoftRobots.Inverse/component/config.h>
+
+namespace softrobotsinverse::constraint
+{
+
+using sofa::component::constraint::lagrangian::correction::LinearSolverConstraintCorrection;
+using sofa::core::ConstraintParams;
+
+
+/**
+ * LinearSolverConstraintCorrection that also applies its compliance J A^-1 J^T to a vector of constraint
+ * forces (ComplianceOperator), with one resolution of the linear system of its node: with the option
+ * matrixFree of QPInverseProblemSolver, W is then not assembled for the problems without contact. The
+ * other steps assemble W as LinearSolverConstraintCorrection does.
+*/
+template< class DataTypes >
+class MatrixFreeConstraintCorrection : public LinearSolverConstraintCorrection<DataTypes>,
+                                       public softrobotsinverse::behavior::ComplianceOperator
+{
+public:
+    SOFA_CLASS(SOFA_TEMPLATE(MatrixFreeConstraintCorrection,DataTypes), SOFA_TEMPLATE(LinearSolverConstraintCorrection,DataTypes));
+
+    typedef typename DataTypes::VecDeriv VecDeriv;
+    typedef typename DataTypes::Deriv Deriv;
+    typedef typename DataTypes::MatrixDeriv MatrixDeriv;
+    typedef typename sofa::core::behavior::MechanicalState<DataTypes> MechanicalState;
+    typedef LinearSolverConstraintCorrection<DataTypes> Inherit;
+
+public:
+    MatrixFreeConstraintCorrection(MechanicalState* object = nullptr);
+    ~MatrixFreeConstraintCorrection() override;
+
+    /////////////////// Inherited from ComplianceOperator ///////////////////
+    bool addComplianceProduct(const ConstraintParams* cParams,
+                              const sofa::type::vector<double>& f,
+                              sofa::type::vector<double>& d) override;
+    /////////////////////////////////////////////////////////////////////////
+
+protected:
+
+    ////////////////////////// Inherited attributes ////////////////////////////
+    /// https://gcc.gnu.org/onlinedocs/gcc/Name-lookup.html
+    /// Bring inherited attributes and function in the current lookup context.
+    /// otherwise any access to the base::attribute would require
+    /// the "this->" approach.
+    using Inherit::mstate ;
+    using Inherit::l_linearSolver ;
+    using Inherit::l_ODESolver ;
+    ////////////////////////////////////////////////////////////////////////////
+
+    /// Factor of the compliance for the order of the constraints, as in addComplianceInConstraintSpace
+    double getComplianceFactor(const ConstraintParams* cParams) const;
+};
+
+#if !defined(SOFTROBOTS_INVERSE_CONSTRAINT_MATRIXFREECONSTRAINTCORRECTION_CPP)
+extern template class SOFA_SOFTROBOTS_INVERSE_API MatrixFreeConstraintCorrection<sofa::defaulttype::Vec3Types>;
+#endif
+
+} // namespace
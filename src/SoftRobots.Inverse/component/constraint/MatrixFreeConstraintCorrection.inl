@@ -0,0 +1,125 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <sofa/core/behavior/OdeSolver.h>
+#include <sofa/core/behavior/LinearSolver.h>
+
+#include <SoftRobots.Inverse/component/constraint/MatrixFreeConstraintCorrection.h>
+
+namespace softrobotsinverse::constraint
+{
+
+using sofa::core::VecDerivId;
+using sofa::core::ConstMatrixDerivId;
+using sofa::helper::WriteOnlyAccessor;
+using sofa::type::vector;
+
+template<class DataTypes>
+MatrixFreeConstraintCorrection<DataTypes>::MatrixFreeConstraintCorrection(MechanicalState* object)
+    : Inherit(object)
+{
+}
+
+
+template<class DataTypes>
+MatrixFreeConstraintCorrection<DataTypes>::~MatrixFreeConstraintCorrection()
+{
+}
+
+
+template<class DataTypes>
+double MatrixFreeConstraintCorrection<DataTypes>::getComplianceFactor(const ConstraintParams* cParams) const
+{
+    if (cParams->constOrder() == ConstraintParams::POS_AND_VEL || cParams->constOrder() == ConstraintParams::POS)
+        return l_ODESolver.get()->getPositionIntegrationFactor();
+    if (cParams->constOrder() == ConstraintParams::ACC || cParams->constOrder() == ConstraintParams::VEL)
+        return l_ODESolver.get()->getVelocityIntegrationFactor();
+    return 1.0;
+}
+
+
+template<class DataTypes>
+bool MatrixFreeConstraintCorrection<DataTypes>::addComplianceProduct(const ConstraintParams* cParams,
+                                                                     const vector<double>& f,
+                                                                     vector<double>& d)
+{
+    if(!mstate || !l_linearSolver.get() || !l_ODESolver.get() || d.size() != f.size())
+        return false;
+
+    const MatrixDeriv& J = mstate->read(ConstMatrixDerivId::constraintJacobian())->getValue();
+    if(J.begin() == J.end())
+        return true;
+
+    // Same vectors as applyContactForce, which writes them again after the resolution
+    const VecDerivId forceId(VecDerivId::V_FIRST_DYNAMIC_INDEX);
+    const VecDerivId dxId = VecDerivId::dx();
+    const unsigned int nbDofs = mstate->getSize();
+
+    {
+        WriteOnlyAccessor<sofa::Data<VecDeriv>> force = *mstate->write(forceId);
+        force.resize(nbDofs);
+        for(unsigned int i=0; i<nbDofs; i++)
+            force[i] = Deriv();
+
+        // J^T f
+        for(auto rowIt = J.begin(); rowIt != J.end(); ++rowIt)
+        {
+            if(std::size_t(rowIt.index()) >= f.size())
+                return false;
+            const double fi = f[rowIt.index()];
+            if(fi == 0.)
+                continue;
+            for(auto colIt = rowIt.begin(); colIt != rowIt.end(); ++colIt)
+                force[colIt.index()] += colIt.val()*fi;
+        }
+    }
+    {
+        WriteOnlyAccessor<sofa::Data<VecDeriv>> dx = *mstate->write(dxId);
+        dx.resize(nbDofs);
+    }
+
+    l_linearSolver.get()->setSystemRHVector(forceId);
+    l_linearSolver.get()->setSystemLHVector(dxId);
+    l_linearSolver.get()->solveSystem();
+
+    // d += factor J A^-1 J^T f
+    const double factor = getComplianceFactor(cParams);
+    const VecDeriv& dx = mstate->read(sofa::core::ConstVecDerivId::dx())->getValue();
+    for(auto rowIt = J.begin(); rowIt != J.end(); ++rowIt)
+    {
+        double di = 0.;
+        for(auto colIt = rowIt.begin(); colIt != rowIt.end(); ++colIt)
+            di += colIt.val()*dx[colIt.index()];
+        d[rowIt.index()] += factor*di;
+    }
+    return true;
+}
+
+} // namespace
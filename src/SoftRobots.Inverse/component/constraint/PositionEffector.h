@@ -30,6 +30,11 @@
 
 #include <SoftRobots/component/constraint/model/PositionModel.h>
 #include <SoftRobots.Inverse/component/behavior/Effector.h>
+#include <SoftRobots.Inverse/component/behavior/EffectorWeights.h>
+#include <SoftRobots.Inverse/component/behavior/PointCloudGrid.h>
+#include <SoftRobots.Inverse/component/behavior/TargetChannel.h>
+#include <SoftRobots.Inverse/component/constraint/DirectionMask.h>
+#include <sofa/simulation/TaskScheduler.h>
 
 #include <SoftRobots.Inverse/component/config.h>
 
@@ -44,7 +49,8 @@ using sofa::core::behavior::Effector ;
  * https://softrobotscomponents.readthedocs.io
 */
 template< class DataTypes >
-class PositionEffector : public Effector<DataTypes>, public softrobots::constraint::PositionModel<DataTypes>
+class PositionEffector : public Effector<DataTypes>, public softrobots::constraint::PositionModel<DataTypes>,
+                         public softrobotsinverse::behavior::EffectorWeights
 {
 public:
     SOFA_CLASS(SOFA_TEMPLATE(PositionEffector,DataTypes), SOFA_TEMPLATE(Effector,DataTypes));
@@ -68,11 +74,81 @@ public:
                                 const sofa::linearalgebra::BaseVector *Jdx) override;
     ///////////////////////////////////////////////////////////////
 
+    /////////////// Inherited from EffectorWeights ////////////
+    bool getRowWeights(unsigned int& blockSize, sofa::type::vector<double>& weights) const override;
+    ///////////////////////////////////////////////////////////////
+
     sofa::Data<VecCoord>                                d_effectorGoal;
+    sofa::Data<bool>                                    d_useTargetChannel;
+    sofa::Data<sofa::type::vector<Real> >               d_pointWeights;
+    sofa::Data<sofa::type::vector<Real> >               d_weightMatrices;
+    sofa::Data<VecCoord>                                d_targetCloud;
+    sofa::Data<Real>                                    d_cloudCellSize;
+    sofa::Data<Real>                                    d_maxCorrespondenceDistance;
+    sofa::Data<bool>                                    d_multithreading;
+    sofa::Data<sofa::type::vector<int> >                d_correspondences;
 
     void setTargetDefaultValue();
     void resizeData();
 
+    /// Channel in which an external thread writes the goals, read when useTargetChannel is true
+    softrobotsinverse::behavior::TargetChannel<DataTypes>& getTargetChannel() {return m_targetChannel;}
+
+protected:
+
+    // Buffers of the violation, kept between steps. The differences to the goals and the selected
+    // directions are stored contiguously, Deriv::total_size values per point and per direction.
+    sofa::type::vector<Real>                            m_differences;
+    sofa::type::vector<Real>                            m_selectedDirections;
+    unsigned int                                        m_directionMask{0};
+    bool                                                m_hasAxisDirections{false}; // The selected directions are the axes of Deriv
+    sofa::type::vector<SReal>                           m_violation;
+    sofa::type::vector<SReal>                           m_jdx;
+
+    softrobotsinverse::behavior::TargetChannel<DataTypes> m_targetChannel;
+    VecCoord                                            m_streamedGoal;
+
+    // Grid over targetCloud, and goals of the points of indices matched in the cloud
+    softrobotsinverse::behavior::PointCloudGrid<DataTypes> m_cloudGrid;
+    VecCoord                                            m_matchedGoal;
+
+    void computeCorrespondences(const VecCoord& x);
+    /// Nearest points of the cloud to the points [begin, end) of indices
+    void matchChunk(const VecCoord& x, sofa::Size begin, sofa::Size end, int* correspondences);
+    void computeDifferences(const VecCoord& x);
+    void computeSelectedDirections();
+    void computeViolation(const SReal* jdx, SReal* violation) const;
+
+    class MatchChunkTask : public sofa::simulation::CpuTask
+    {
+    public:
+        MatchChunkTask(sofa::simulation::CpuTask::Status* status): CpuTask(status) {}
+        ~MatchChunkTask() override {}
+
+        MemoryAlloc run() final {
+            effector->matchChunk(*x, begin, end, correspondences);
+            return MemoryAlloc::Stack;
+        }
+
+        void set(PositionEffector* _effector, const VecCoord* _x, const sofa::Size _begin, const sofa::Size _end,
+                 int* _correspondences){
+            effector = _effector;
+            x = _x;
+            begin = _begin;
+            end = _end;
+            correspondences = _correspondences;
+        }
+
+    private:
+        PositionEffector* effector{nullptr};
+        const VecCoord* x{nullptr};
+        sofa::Size begin{0};
+        sofa::Size end{0};
+        int* correspondences{nullptr};
+    };
+
+public:
+
     ////////////////////////// Inherited attributes ////////////////////////////
     using softrobots::constraint::PositionModel<DataTypes>::d_indices ;
     using softrobots::constraint::PositionModel<DataTypes>::d_directions ;
@@ -30,6 +30,8 @@
 
 #include <sofa/core/visual/VisualParams.h>
 #include <sofa/helper/logging/Messaging.h>
+#include <sofa/linearalgebra/FullVector.h>
+#include <sofa/simulation/MainTaskSchedulerFactory.h>
 
 #include <SoftRobots.Inverse/component/constraint/PositionEffector.h>
 
@@ -48,7 +50,46 @@ PositionEffector<DataTypes>::PositionEffector(MechanicalState* object)
                     "Desired positions. \n"
                     "If the size does not match with the size of indices, \n"
                     "one will resize considerering the smallest one."))
+    , d_useTargetChannel(initData(&d_useTargetChannel, false, "useTargetChannel",
+                    "If true, the goals are read from the target channel, in which an external thread \n"
+                    "(e.g. a teleoperation loop) writes them, instead of effectorGoal. If the goals are \n"
+                    "timestamped, they are interpolated at the simulation time. effectorGoal is used until \n"
+                    "enough goals are written in the channel. \n"
+                    "Default value is false."))
+    , d_pointWeights(initData(&d_pointWeights, "pointWeights",
+                    "Weight of each point of indices in the objective of the solver, on all its selected \n"
+                    "directions. The weights are applied when the QP is assembled, so changing them at \n"
+                    "runtime does not rebuild the constraint rows nor the compliance. \n"
+                    "Default value is empty (weight 1)."))
+    , d_weightMatrices(initData(&d_weightMatrices, "weightMatrices",
+                    "Symmetric positive semi-definite weight matrix of each point of indices, of the size \n"
+                    "of the selected directions, all the matrices given row by row in one list. Replaces \n"
+                    "pointWeights when set. \n"
+                    "Default value is empty."))
+    , d_targetCloud(initData(&d_targetCloud, "targetCloud",
+                    "Point cloud to track (e.g. from a camera, possibly linked to the Data of another component). \n"
+                    "When set, the goal of each point of indices is its nearest point of the cloud, instead of \n"
+                    "effectorGoal or the target channel. The nearest points are found with a uniform grid over \n"
+                    "the cloud, in which only the points that changed cell are moved when the cloud is updated. \n"
+                    "The points without a point of the cloud within maxCorrespondenceDistance have no goal (no \n"
+                    "violation). To update it at runtime, set it when the component is created, even empty. \n"
+                    "Default value is empty."))
+    , d_cloudCellSize(initData(&d_cloudCellSize, Real(0), "cloudCellSize",
+                    "Size of the cells of the grid over targetCloud. If 0, it is chosen for about one point per \n"
+                    "cell in the bounding box of the cloud, when the number of points of the cloud changes. \n"
+                    "Default value is 0."))
+    , d_maxCorrespondenceDistance(initData(&d_maxCorrespondenceDistance, Real(0), "maxCorrespondenceDistance",
+                    "Distance above which a point of the cloud is not the goal of a point of indices. \n"
+                    "0 for no limit. \n"
+                    "Default value is 0."))
+    , d_multithreading(initData(&d_multithreading, false, "multithreading",
+                    "Match the points of indices in targetCloud concurrently. \n"
+                    "Default value is false."))
+    , d_correspondences(initData(&d_correspondences, "correspondences",
+                    "Output: index in targetCloud of the goal of each point of indices, -1 for the points \n"
+                    "without goal. Empty without targetCloud."))
 {
+    d_correspondences.setReadOnly(true);
 }
 
 template<class DataTypes>
@@ -61,14 +102,60 @@ void PositionEffector<DataTypes>::init()
 {
     softrobots::constraint::PositionModel<DataTypes>::init();
 
-    if(!d_effectorGoal.isSet())
+    // The goals of a target cloud are matched at each step, whatever its size
+    m_cloudGrid.clear();
+    if(d_targetCloud.isSet())
+    {
+        if(d_multithreading.getValue())
+            sofa::simulation::MainTaskSchedulerFactory::createInRegistry()->init();
+    }
+    else if(!d_effectorGoal.isSet())
     {
         msg_warning(this) <<"TargetPosition not defined. Default value assigned  ("<<Coord()<<").";
         setTargetDefaultValue();
     }
 
-    if(d_indices.getValue().size() != d_effectorGoal.getValue().size())
+    if(!d_targetCloud.isSet() && d_indices.getValue().size() != d_effectorGoal.getValue().size())
         resizeData();
+
+    const sofa::Size nbPoints = d_indices.getValue().size();
+    const sofa::Size nbDirections = DirectionMask<Deriv::total_size>::getNbDirections(
+                DirectionMask<Deriv::total_size>::get(sofa::helper::getReadAccessor(d_useDirections)));
+    if(d_pointWeights.isSet() && d_pointWeights.getValue().size() != nbPoints)
+        msg_warning(this) << "The size of pointWeights (" << d_pointWeights.getValue().size() << ") does not match "
+                          << "the number of points (" << nbPoints << "), the weights will not be considered.";
+    if(d_weightMatrices.isSet() && d_weightMatrices.getValue().size() != nbPoints*nbDirections*nbDirections)
+        msg_warning(this) << "The size of weightMatrices (" << d_weightMatrices.getValue().size() << ") does not match "
+                          << "one matrix of " << nbDirections << "x" << nbDirections << " per point, "
+                          << "the matrices will not be considered.";
+}
+
+template<class DataTypes>
+bool PositionEffector<DataTypes>::getRowWeights(unsigned int& blockSize, sofa::type::vector<double>& weights) const
+{
+    // One line per point and per selected direction, point by point
+    const sofa::Size nbPoints = d_indices.getValue().size();
+    const sofa::Size nbDirections = DirectionMask<Deriv::total_size>::getNbDirections(
+                DirectionMask<Deriv::total_size>::get(sofa::helper::getReadAccessor(d_useDirections)));
+
+    const auto& weightMatrices = sofa::helper::getReadAccessor(d_weightMatrices);
+    if(nbDirections > 0 && !weightMatrices.empty() && weightMatrices.size() == nbPoints*nbDirections*nbDirections)
+    {
+        blockSize = nbDirections;
+        weights.insert(weights.end(), weightMatrices.begin(), weightMatrices.end());
+        return true;
+    }
+
+    const auto& pointWeights = sofa::helper::getReadAccessor(d_pointWeights);
+    if(!pointWeights.empty() && pointWeights.size() == nbPoints)
+    {
+        blockSize = 1;
+        for(const Real& weight : pointWeights)
+            weights.insert(weights.end(), nbDirections, weight);
+        return true;
+    }
+
+    return false;
 }
 
 template<class DataTypes>
@@ -94,6 +181,160 @@ void PositionEffector<DataTypes>::resizeData()
     }
 }
 
+template<class DataTypes>
+void PositionEffector<DataTypes>::computeCorrespondences(const VecCoord& x)
+{
+    const VecCoord& cloud = d_targetCloud.getValue();
+    m_cloudGrid.update(cloud, d_targetCloud.getCounter(), d_cloudCellSize.getValue());
+
+    const sofa::Size nbPoints = d_indices.getValue().size();
+    m_matchedGoal.resize(nbPoints);
+    sofa::helper::WriteOnlyAccessor<sofa::Data<sofa::type::vector<int> > > correspondences = d_correspondences;
+    correspondences.resize(nbPoints);
+
+    sofa::simulation::TaskScheduler* taskScheduler = (d_multithreading.getValue())? sofa::simulation::MainTaskSchedulerFactory::createInRegistry() : nullptr;
+    const sofa::Size nbThreads = (taskScheduler)? taskScheduler->getThreadCount() : 1;
+
+    // Chunks of at least 64 points, for the tasks to outweigh their scheduling
+    const sofa::Size nbChunks = std::max(sofa::Size(1), std::min(nbThreads, nbPoints/64));
+    if(nbChunks > 1)
+    {
+        sofa::simulation::CpuTask::Status status;
+
+        sofa::type::vector<MatchChunkTask> tasks;
+        tasks.resize(nbChunks, MatchChunkTask(&status));
+        for(sofa::Size i=0; i<nbChunks; i++)
+        {
+            tasks[i].set(this, &x, (i*nbPoints)/nbChunks, ((i+1)*nbPoints)/nbChunks, correspondences.wref().data());
+            taskScheduler->addTask(&tasks[i]);
+        }
+        taskScheduler->workUntilDone(&status);
+    }
+    else
+        matchChunk(x, 0, nbPoints, correspondences.wref().data());
+}
+
+template<class DataTypes>
+void PositionEffector<DataTypes>::matchChunk(const VecCoord& x, sofa::Size begin, sofa::Size end, int* correspondences)
+{
+    const auto& indices = sofa::helper::getReadAccessor(d_indices);
+    const VecCoord& cloud = d_targetCloud.getValue();
+    const Real maxDistance = d_maxCorrespondenceDistance.getValue();
+
+    // Without a point of the cloud, the goal is the position itself
+    for (sofa::Size i=begin; i<end; i++)
+    {
+        const Coord& pos = x[indices[i]];
+        correspondences[i] = m_cloudGrid.findNearest(pos, cloud, maxDistance);
+        m_matchedGoal[i] = (correspondences[i] >= 0)? cloud[correspondences[i]] : pos;
+    }
+}
+
+template<class DataTypes>
+void PositionEffector<DataTypes>::computeDifferences(const VecCoord& x)
+{
+    constexpr sofa::Size N = Deriv::total_size;
+    const auto& indices = sofa::helper::getReadAccessor(d_indices);
+    const sofa::Size sizeIndices = indices.size();
+
+    // The goals matched in the target cloud replace the other ones
+    const bool isMatched = d_targetCloud.isSet();
+    if(isMatched)
+        computeCorrespondences(x);
+
+    // The streamed goals bypass the Data, they are read at each step from the channel
+    const bool isStreamed = !isMatched && d_useTargetChannel.getValue()
+                            && m_targetChannel.read(this->getContext()->getTime(), m_streamedGoal)
+                            && m_streamedGoal.size() >= sizeIndices;
+    const VecCoord& effectorGoal = (isMatched)? m_matchedGoal : (isStreamed)? m_streamedGoal : d_effectorGoal.getValue();
+
+    // The limits of the targets are read once for all the points. Without limit, the goals are used as they are.
+    const typename Effector<DataTypes>::TargetLimits limits = this->getTargetLimits();
+    const bool hasTargetLimit = limits.isActive();
+
+    m_differences.resize(sizeIndices*N);
+    for (sofa::Size i=0; i<sizeIndices; i++)
+    {
+        const Coord& pos = x[indices[i]];
+        Deriv d = (hasTargetLimit)? DataTypes::coordDifference(pos, getTarget(limits, effectorGoal[i], pos))
+                                  : DataTypes::coordDifference(pos, effectorGoal[i]);
+
+        Real* difference = &m_differences[i*N];
+        for (sofa::Size c=0; c<N; c++)
+            difference[c] = d[c];
+    }
+}
+
+template<class DataTypes>
+void PositionEffector<DataTypes>::computeSelectedDirections()
+{
+    constexpr sofa::Size N = Deriv::total_size;
+    const auto& useDirections = sofa::helper::getReadAccessor(d_useDirections);
+    const auto& directions = sofa::helper::getReadAccessor(d_directions);
+
+    m_selectedDirections.clear();
+    m_hasAxisDirections = true;
+    for(sofa::Size j=0; j<N; j++)
+        if(useDirections[j])
+            for (sofa::Size c=0; c<N; c++)
+            {
+                m_selectedDirections.push_back(directions[j][c]);
+                m_hasAxisDirections &= (directions[j][c] == Real((c == j)? 1 : 0));
+            }
+    m_directionMask = DirectionMask<N>::get(useDirections);
+}
+
+template<class DataTypes>
+void PositionEffector<DataTypes>::computeViolation(const SReal* jdx, SReal* violation) const
+{
+    // The sizes are known at compile time for each DataTypes, so the inner loops are unrolled
+    constexpr sofa::Size N = Deriv::total_size;
+    const sofa::Size nbPoints = m_differences.size()/N;
+    const sofa::Size nbDirections = m_selectedDirections.size()/N;
+    const Real weight = d_weight.getValue();
+
+    const Real* differences = m_differences.data();
+
+    // With the axes as directions (the default), the projections are components of the differences, selected
+    // with a mask known at compile time for the common cases (see DirectionMask)
+    if(m_hasAxisDirections)
+    {
+        DirectionMask<N>::dispatch(m_directionMask, [&](auto mask)
+        {
+            for (sofa::Size i=0; i<nbPoints; i++)
+            {
+                const Real* difference = differences + i*N;
+                const SReal* pointJdx = jdx + i*nbDirections;
+                SReal* pointViolation = violation + i*nbDirections;
+                sofa::Size k = 0;
+                for (sofa::Size c=0; c<N; c++)
+                    if(mask & (1u << c))
+                    {
+                        pointViolation[k] = pointJdx[k] + difference[c]*weight;
+                        k++;
+                    }
+            }
+        });
+        return;
+    }
+
+    const Real* directions = m_selectedDirections.data();
+    for (sofa::Size i=0; i<nbPoints; i++)
+    {
+        const Real* difference = differences + i*N;
+        for (sofa::Size k=0; k<nbDirections; k++)
+        {
+            const Real* direction = directions + k*N;
+            Real projection = 0;
+            for (sofa::Size c=0; c<N; c++)
+                projection += difference[c]*direction[c];
+
+            const sofa::Size line = i*nbDirections + k;
+            violation[line] = jdx[line] + projection*weight;
+        }
+    }
+}
+
 template<class DataTypes>
 void PositionEffector<DataTypes>::getConstraintViolation(const sofa::core::ConstraintParams* cParams,
                                                          sofa::linearalgebra::BaseVector *resV,
@@ -105,31 +346,33 @@ void PositionEffector<DataTypes>::getConstraintViolation(const sofa::core::Const
     SOFA_UNUSED(cParams);
 
     ReadAccessor<sofa::Data<VecCoord> > x = m_state->readPositions();
-    ReadAccessor<sofa::Data<VecCoord> > effectorGoal = d_effectorGoal;
 
-    const auto& useDirections = sofa::helper::getReadAccessor(d_useDirections);
-    const auto& directions = sofa::helper::getReadAccessor(d_directions);
-    const auto& weight = sofa::helper::getReadAccessor(d_weight);
-    const auto& indices = sofa::helper::getReadAccessor(d_indices);
-    sofa::Index sizeIndices = indices.size();
+    computeDifferences(x.ref());
+    computeSelectedDirections();
 
+    const sofa::Size nbLines = d_indices.getValue().size()*(m_selectedDirections.size()/Deriv::total_size);
 
-    int index = 0;
-    for (unsigned int i=0; i<sizeIndices; i++)
+    // Contiguous vectors (the usual case in the solver) are read and written in bulk,
+    // the other ones element by element
+    typedef sofa::linearalgebra::FullVector<SReal> FullVector;
+    const FullVector* jdxVector = dynamic_cast<const FullVector*>(Jdx);
+    FullVector* resVector = dynamic_cast<FullVector*>(resV);
+    if(jdxVector && resVector && jdxVector->size() >= sofa::Index(nbLines)
+            && resVector->size() >= sofa::Index(m_constraintId+nbLines))
     {
-        Coord pos = x[indices[i]];
-        Coord goalPos = getTarget(effectorGoal[i],pos);
+        computeViolation(jdxVector->ptr(), resVector->ptr() + m_constraintId);
+        return;
+    }
 
-        Deriv d = DataTypes::coordDifference(pos,goalPos);
+    m_jdx.resize(nbLines);
+    m_violation.resize(nbLines);
+    for (sofa::Size line=0; line<nbLines; line++)
+        m_jdx[line] = Jdx->element(line);
 
-        for(sofa::Size j=0; j<DataTypes::Deriv::total_size; j++)
-            if(useDirections[j])
-            {
-                Real dfree = Jdx->element(index) + d*directions[j]*weight;
-                resV->set(m_constraintId+index, dfree);
-                index++;
-            }
-    }
+    computeViolation(m_jdx.data(), m_violation.data());
+
+    for (sofa::Size line=0; line<nbLines; line++)
+        resV->set(m_constraintId+line, m_violation[line]);
 }
 
 
@@ -30,6 +30,7 @@
 
 #include <SoftRobots.Inverse/component/behavior/Equality.h>
 #include <SoftRobots/component/constraint/model/PositionModel.h>
+#include <SoftRobots.Inverse/component/constraint/DirectionMask.h>
 #include <SoftRobots.Inverse/component/config.h>
 
 
@@ -118,6 +119,12 @@ protected:
     sofa::Data<Real>    d_eqDelta;
     sofa::Data<Real>    d_constrainAtTime;
 
+    // Buffers of the violation when the vectors are not contiguous, kept between steps
+    sofa::type::vector<SReal> m_violation;
+    sofa::type::vector<SReal> m_jdx;
+
+    void computeViolation(const VecCoord& positions, const SReal* jdx, SReal* violation) const;
+
     void updateConstraint();
 };
 
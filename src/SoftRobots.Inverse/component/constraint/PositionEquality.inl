@@ -29,6 +29,7 @@
 #pragma once
 
 #include <sofa/core/visual/VisualParams.h>
+#include <sofa/linearalgebra/FullVector.h>
 #include <sofa/type/Vec.h>
 #include <SoftRobots.Inverse/component/constraint/PositionEquality.h>
 
@@ -131,26 +132,58 @@ void PositionEquality<DataTypes>::getConstraintViolation(const ConstraintParams*
     SOFA_UNUSED(cParams);
     ReadAccessor<sofa::Data<VecCoord>> positions = m_state->readPositions();
     const auto& indices = sofa::helper::getReadAccessor(d_indices);
-    const auto& useDirections = sofa::helper::getReadAccessor(d_useDirections);
 
-    bool withJdx = (Jdx->size()!=0);
+    constexpr sofa::Size N = Deriv::total_size;
+    const sofa::Size nbLines = indices.size()*DirectionMask<N>::getNbDirections(DirectionMask<N>::get(d_useDirections.getValue()));
+    const bool withJdx = (Jdx->size()!=0);
+
+    // Contiguous vectors (the usual case in the solver) are read and written in bulk,
+    // the other ones element by element
+    typedef sofa::linearalgebra::FullVector<SReal> FullVector;
+    const FullVector* jdxVector = dynamic_cast<const FullVector*>(Jdx);
+    FullVector* resVector = dynamic_cast<FullVector*>(resV);
+    if((!withJdx || (jdxVector && jdxVector->size() >= sofa::Index(nbLines)))
+            && resVector && resVector->size() >= sofa::Index(m_constraintId+nbLines))
+    {
+        computeViolation(positions.ref(), (withJdx)? jdxVector->ptr() : nullptr, resVector->ptr() + m_constraintId);
+        return;
+    }
 
-    sofa::Index index = 0;
-    for (sofa::Index i: indices)
+    m_jdx.resize(nbLines);
+    m_violation.resize(nbLines);
+    if(withJdx)
+        for (sofa::Size line=0; line<nbLines; line++)
+            m_jdx[line] = Jdx->element(line);
+
+    computeViolation(positions.ref(), (withJdx)? m_jdx.data() : nullptr, m_violation.data());
+
+    for (sofa::Size line=0; line<nbLines; line++)
+        resV->set(m_constraintId + line, m_violation[line]);
+}
+
+
+template<class DataTypes>
+void PositionEquality<DataTypes>::computeViolation(const VecCoord& positions, const SReal* jdx, SReal* violation) const
+{
+    // The mask of the directions is known at compile time for the common cases (see DirectionMask),
+    // so that the loop over the directions is unrolled
+    constexpr sofa::Size N = Deriv::total_size;
+    const auto& indices = sofa::helper::getReadAccessor(d_indices);
+
+    DirectionMask<N>::dispatch(DirectionMask<N>::get(d_useDirections.getValue()), [&](auto mask)
     {
-        for (sofa::Index j=0; j<Coord::total_size; j++)
+        sofa::Size line = 0;
+        for (sofa::Index i: indices)
         {
-            if (useDirections[j])
-            {
-                Real dfree = positions[i][j];
-                if (withJdx)
+            const Coord& position = positions[i];
+            for (sofa::Size j=0; j<N; j++)
+                if(mask & (1u << j))
                 {
-                    dfree += Jdx->element(index);
+                    violation[line] = (jdx)? position[j] + jdx[line] : position[j];
+                    line++;
                 }
-                resV->set(m_constraintId + index++, dfree);
-            }
         }
-    }
+    });
 }
 
 template<class DataTypes>
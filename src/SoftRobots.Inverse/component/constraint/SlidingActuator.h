@@ -29,6 +29,8 @@
 #pragma once
 
 #include <SoftRobots.Inverse/component/behavior/Actuator.h>
+#include <SoftRobots.Inverse/component/behavior/ConcurrentResults.h>
+#include <SoftRobots.Inverse/component/behavior/DrawBuffer.h>
 #include <SoftRobots.Inverse/component/config.h>
 
 namespace softrobotsinverse::constraint
@@ -50,7 +52,7 @@ using softrobots::behavior::SoftRobotsConstraint;
  * https://softrobotscomponents.readthedocs.io
 */
 template< class DataTypes >
-class SlidingActuator : public Actuator<DataTypes>
+class SlidingActuator : public Actuator<DataTypes>, public softrobotsinverse::behavior::ConcurrentResults
 {
 public:
     SOFA_CLASS(SOFA_TEMPLATE(SlidingActuator,DataTypes), SOFA_TEMPLATE(Actuator,DataTypes));
@@ -143,6 +145,9 @@ protected:
     sofa::Data<bool>                  d_showDirection;
     sofa::Data<double>                d_showVisuScale;
 
+    // Ends of the arrow of the direction, rebuilt when the positions, the indices or the direction change
+    softrobotsinverse::behavior::DrawBuffer m_directionBuffer;
+
     void initDatas();
     void initLimit();
     void updateLimit();
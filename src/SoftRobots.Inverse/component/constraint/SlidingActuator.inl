@@ -403,20 +403,28 @@ void SlidingActuator<DataTypes>::draw(const VisualParams* vparams)
     if (!vparams->displayFlags().getShowInteractionForceFields()) return;
     if (!d_showDirection.getValue()) return;
 
-    ReadAccessor<sofa::Data<VecCoord> > positions = m_state->readPositions();
-    const SetIndexArray &indices = d_indices.getValue();
+    const sofa::Data<VecCoord>* positionsData = m_state->read(sofa::core::ConstVecCoordId::position());
+    auto& points = m_directionBuffer.points;
+    if(m_directionBuffer.update({positionsData->getCounter(), d_indices.getCounter(), d_direction.getCounter(), d_showVisuScale.getCounter()}))
+    {
+        ReadAccessor<sofa::Data<VecCoord> > positions = *positionsData;
+        const SetIndexArray &indices = d_indices.getValue();
 
-    Vec<3,SReal> bary(0.,0.,0.);
-    for(unsigned int i=0; i<indices.size(); i++)
+        Vec<3,SReal> bary(0.,0.,0.);
+        for(unsigned int i=0; i<indices.size(); i++)
+            for (unsigned int j=0; j<3; j++)
+                bary[j]+=positions[indices[i]][j]/indices.size();
+
+        Vec<3,SReal> baryArrow(0.,0.,0.);
         for (unsigned int j=0; j<3; j++)
-            bary[j]+=positions[indices[i]][j]/indices.size();
+            baryArrow[j] = bary[j]+d_direction.getValue()[j]*d_showVisuScale.getValue();
 
-    Vec<3,SReal> baryArrow(0.,0.,0.);
-    for (unsigned int j=0; j<3; j++)
-        baryArrow[j] = bary[j]+d_direction.getValue()[j]*d_showVisuScale.getValue();
+        points.push_back(bary);
+        points.push_back(baryArrow);
+    }
 
     vparams->drawTool()->setLightingEnabled(true);
-    vparams->drawTool()->drawArrow(bary,baryArrow,d_showVisuScale.getValue()/20.0f, RGBAColor(1,0,0,1));
+    vparams->drawTool()->drawArrow(points[0],points[1],d_showVisuScale.getValue()/20.0f, RGBAColor(1,0,0,1));
     vparams->drawTool()->restoreLastState();
 }
 
@@ -0,0 +1,64 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#define SOFTROBOTS_INVERSE_CONSTRAINT_SLIDINGACTUATORARRAY_CPP
+
+#include <sofa/defaulttype/VecTypes.h>
+#include <sofa/defaulttype/RigidTypes.h>
+#include <sofa/core/ObjectFactory.h>
+
+#include <SoftRobots.Inverse/component/constraint/SlidingActuatorArray.inl>
+
+namespace softrobotsinverse::constraint
+{
+
+using namespace sofa::defaulttype;
+using namespace sofa::helper;
+using namespace sofa::core;
+
+// The translation and the rotation parts are normalized separately
+template<>
+void SlidingActuatorArray<Rigid3Types>::normalizeDirection(Deriv& direction) const
+{
+    direction.getVCenter().normalize();
+    direction.getVOrientation().normalize();
+}
+
+
+int SlidingActuatorArrayClass = RegisterObject("Simulate an array of forces, each one exerted along its direction, with one row per slider, \n"
+                                               "to solve an inverse problem. In case of Rigid template, the forces are in translation \n"
+                                               "and in rotation, as for SlidingActuator.")
+.add< SlidingActuatorArray<Vec3Types> >(true)
+.add< SlidingActuatorArray<Rigid3Types> >()
+;
+
+template class SOFA_SOFTROBOTS_INVERSE_API SlidingActuatorArray<Vec3Types>;
+template class SOFA_SOFTROBOTS_INVERSE_API SlidingActuatorArray<Rigid3Types>;
+
+
+} // namespace
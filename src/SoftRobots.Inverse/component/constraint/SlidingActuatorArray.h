@@ -0,0 +1,174 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <SoftRobots.Inverse/component/behavior/Actuator.h>
+#include <SoftRobots.Inverse/component/behavior/ConcurrentResults.h>
+
+#include <SoftRobots.Inverse/component/config.h>
+
+namespace softrobotsinverse::constraint
+{
+
+using sofa::core::behavior::Actuator;
+using sofa::helper::ReadAccessor;
+using sofa::core::ConstraintParams;
+using sofa::core::visual::VisualParams;
+using sofa::linearalgebra::BaseVector;
+using softrobots::behavior::SoftRobotsConstraint;
+
+
+/**
+ * This component simulates the forces exerted by an array of sliding actuators, each one along its
+ * direction, to solve an inverse problem. It is equivalent to one SlidingActuator per slider, with one row
+ * per slider in a single block. The points of all the sliders are concatenated in indices, and nbPoints
+ * gives the number of points of each slider (one point per slider by default). The directions and the
+ * limits are given once for all the sliders, or with one value per slider.
+*/
+template< class DataTypes >
+class SlidingActuatorArray : public Actuator<DataTypes>, public softrobotsinverse::behavior::ConcurrentResults
+{
+public:
+    SOFA_CLASS(SOFA_TEMPLATE(SlidingActuatorArray,DataTypes), SOFA_TEMPLATE(Actuator,DataTypes));
+
+    typedef typename DataTypes::VecCoord VecCoord;
+    typedef typename DataTypes::VecDeriv VecDeriv;
+    typedef typename DataTypes::Coord Coord;
+    typedef typename DataTypes::Deriv Deriv;
+    typedef typename DataTypes::MatrixDeriv MatrixDeriv;
+    typedef typename Coord::value_type Real;
+    typedef typename sofa::core::behavior::MechanicalState<DataTypes> MechanicalState;
+
+    typedef typename DataTypes::MatrixDeriv::RowIterator MatrixDerivRowIterator;
+    typedef sofa::core::objectmodel::Data<VecCoord>		DataVecCoord;
+    typedef sofa::core::objectmodel::Data<VecDeriv>		DataVecDeriv;
+    typedef sofa::core::objectmodel::Data<MatrixDeriv>    DataMatrixDeriv;
+
+    typedef sofa::type::vector<unsigned int> SetIndexArray;
+    typedef sofa::type::vector<Real> VecReal;
+    typedef Actuator<DataTypes> Inherit;
+
+public:
+    SlidingActuatorArray(MechanicalState* object = nullptr);
+    ~SlidingActuatorArray() override;
+
+    ////////////////////////// Inherited from BaseObject ////////////////////
+    void init() override;
+    void reinit() override;
+    void reset() override;
+    void draw(const VisualParams* vparams) override;
+    /////////////////////////////////////////////////////////////////////////
+
+    //////////////// Inherited from SoftRobotsConstraint ///////////////
+    void buildConstraintMatrix(const ConstraintParams* cParams,
+                               DataMatrixDeriv &cMatrix,
+                               unsigned int &cIndex,
+                               const DataVecCoord &x) override;
+
+    void getConstraintViolation(const ConstraintParams* cParams,
+                                BaseVector *resV,
+                                const BaseVector * Jdx) override;
+    /////////////////////////////////////////////////////////////////////////
+
+    /////////////// Inherited from BaseSoftRobotsConstraint /////////////
+    void storeResults(sofa::type::vector<double> &lambda,
+                      sofa::type::vector<double> &delta) override;
+    /////////////////////////////////////////////////////////////
+
+    unsigned int getNbSliders() const {return (m_firstPoints.empty())? 0 : m_firstPoints.size()-1;}
+
+    /// Normalized direction of the slider
+    const Deriv& getDirection(const unsigned int& slider) const {return m_directions[slider];}
+
+protected:
+
+    ////////////////////////// Inherited attributes ////////////////////////////
+    /// https://gcc.gnu.org/onlinedocs/gcc/Name-lookup.html
+    /// Bring inherited attributes and function in the current lookup context.
+    /// otherwise any access to the base::attribute would require
+    /// the "this->" approach.
+    using Inherit::m_hasDeltaMax ;
+    using Inherit::m_hasDeltaMin ;
+    using Inherit::m_deltaMax ;
+    using Inherit::m_deltaMin ;
+
+    using Inherit::m_hasLambdaMax ;
+    using Inherit::m_hasLambdaMin ;
+    using Inherit::m_lambdaMax ;
+    using Inherit::m_lambdaMin ;
+
+    using Inherit::m_nbLines ;
+    using Inherit::m_constraintId ;
+    using Inherit::d_componentState ;
+
+    using Inherit::m_state ;
+    ////////////////////////////////////////////////////////////////////////////
+
+    sofa::Data<SetIndexArray>         d_indices;
+    sofa::Data<SetIndexArray>         d_nbPoints;
+    sofa::Data<VecDeriv>              d_directions;
+
+    sofa::Data<VecReal>               d_maxPositiveDisplacement;
+    sofa::Data<VecReal>               d_maxNegativeDisplacement;
+    sofa::Data<VecReal>               d_maxDispVariation;
+    sofa::Data<VecReal>               d_maxForce;
+    sofa::Data<VecReal>               d_minForce;
+    sofa::Data<VecReal>               d_initForce;
+    sofa::Data<VecReal>               d_initDisplacement;
+    sofa::Data<bool>                  d_accumulateDisp;
+
+    sofa::Data<VecReal>               d_force;
+    sofa::Data<VecReal>               d_displacement;
+
+    sofa::Data<bool>                  d_showDirection;
+    sofa::Data<double>                d_showVisuScale;
+
+    // Layout of the sliders (the points of the slider i are [m_firstPoints[i], m_firstPoints[i+1]) in indices),
+    // and their directions and limits with one value per slider, set from the data at init
+    SetIndexArray m_firstPoints;
+    VecDeriv m_directions;
+    VecReal m_maxPositiveDisplacement;
+    VecReal m_maxNegativeDisplacement;
+    VecReal m_maxDispVariation;
+
+    bool checkSliders();
+    template<class T>
+    bool getPerSliderValues(const sofa::Data<sofa::type::vector<T>>& data, sofa::type::vector<T>& values);
+    void normalizeDirection(Deriv& direction) const;
+    void initDatas();
+    void initLimit();
+    void updateLimit();
+};
+
+#if !defined(SOFTROBOTS_INVERSE_CONSTRAINT_SLIDINGACTUATORARRAY_CPP)
+extern template class SOFA_SOFTROBOTS_INVERSE_API SlidingActuatorArray<sofa::defaulttype::Vec3Types>;
+extern template class SOFA_SOFTROBOTS_INVERSE_API SlidingActuatorArray<sofa::defaulttype::Rigid3Types>;
+#endif
+
+} // namespace
@@ -0,0 +1,540 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <sofa/core/visual/VisualParams.h>
+#include <sofa/type/Vec.h>
+
+#include <SoftRobots.Inverse/component/constraint/SlidingActuatorArray.h>
+
+namespace softrobotsinverse::constraint
+{
+
+using sofa::core::objectmodel::ComponentState ;
+
+using sofa::core::visual::VisualParams;
+using sofa::linearalgebra::BaseVector;
+using sofa::helper::ReadAccessor;
+using sofa::helper::WriteOnlyAccessor;
+using sofa::helper::rabs;
+using sofa::type::RGBAColor;
+using sofa::type::Vec3;
+
+template<class DataTypes>
+SlidingActuatorArray<DataTypes>::SlidingActuatorArray(MechanicalState* object)
+    : Inherit(object)
+    , d_indices(initData(&d_indices, "indices",
+                         "Indices of the points of all the sliders, concatenated. \n"
+                         "If unspecified, one slider per point of the mechanical state."))
+
+    , d_nbPoints(initData(&d_nbPoints, "nbPoints",
+                          "Number of points of each slider in indices. \n"
+                          "If unspecified, one point per slider."))
+
+    , d_directions(initData(&d_directions, "directions",
+                            "Direction of actuation of the sliders, one for all the sliders or one per slider. \n"
+                            "If unspecified, the direction is (1 0 0)."))
+
+    , d_maxPositiveDisplacement(initData(&d_maxPositiveDisplacement, "maxPositiveDisp",
+                                         "Maximum displacement of the sliders in their direction, one value for all the \n"
+                                         "sliders or one per slider. If unspecified no maximum value will be considered."))
+
+    , d_maxNegativeDisplacement(initData(&d_maxNegativeDisplacement, "maxNegativeDisp",
+                                         "Maximum displacement of the sliders in the negative direction, one value for \n"
+                                         "all the sliders or one per slider. If unspecified no maximum value will be considered."))
+
+    , d_maxDispVariation(initData(&d_maxDispVariation, "maxDispVariation",
+                                  "Maximum variation of the displacement allowed in a step, one value for all the \n"
+                                  "sliders or one per slider. If unspecified no max variation will be considered."))
+
+    , d_maxForce(initData(&d_maxForce, "maxForce",
+                          "Maximum force of the sliders, one value for all the sliders or one per slider. \n"
+                          "If unspecified no maximum value will be considered."))
+
+    , d_minForce(initData(&d_minForce, "minForce",
+                          "Minimum force of the sliders, one value for all the sliders or one per slider. \n"
+                          "If unspecified no minimum value will be considered."))
+
+    , d_initForce(initData(&d_initForce, "initForce",
+                           "Initial force of the sliders, one value for all the sliders or one per slider. \n"
+                           "Default is 0."))
+
+    , d_initDisplacement(initData(&d_initDisplacement, "initDisplacement",
+                                  "Initial displacement of the sliders, one value for all the sliders or one per \n"
+                                  "slider. Default is 0."))
+
+    , d_accumulateDisp(initData(&d_accumulateDisp, false, "accumulateDisp",
+                                "In case of relative displacement, accumulate the displacement."))
+
+    , d_force(initData(&d_force, "force",
+                       "Output force of each slider. Warning: to get the actual force you should divide this value by dt."))
+
+    , d_displacement(initData(&d_displacement, "displacement",
+                              "Output displacement of each slider compared to the initial position."))
+
+    , d_showDirection(initData(&d_showDirection, false, "showDirection",
+                               "Draw the directions."))
+
+    , d_showVisuScale(initData(&d_showVisuScale, double(0.001), "showVisuScale",
+                               "Visualization scale."))
+{
+    d_indices.setGroup("Input");
+    d_nbPoints.setGroup("Input");
+    d_directions.setGroup("Input");
+    d_maxPositiveDisplacement.setGroup("Input");
+    d_maxNegativeDisplacement.setGroup("Input");
+    d_maxDispVariation.setGroup("Input");
+    d_maxForce.setGroup("Input");
+    d_minForce.setGroup("Input");
+    d_initForce.setGroup("Input");
+    d_initDisplacement.setGroup("Input");
+
+    d_force.setGroup("Output");
+    d_displacement.setGroup("Output");
+    d_force.setReadOnly(true);
+    d_displacement.setReadOnly(true);
+
+    d_showDirection.setGroup("Visualization");
+    d_showVisuScale.setGroup("Visualization");
+}
+
+
+template<class DataTypes>
+SlidingActuatorArray<DataTypes>::~SlidingActuatorArray()
+{
+}
+
+
+template<class DataTypes>
+void SlidingActuatorArray<DataTypes>::init()
+{
+    d_componentState = ComponentState::Invalid ;
+    SoftRobotsConstraint<DataTypes>::init();
+
+    if(m_state==nullptr)
+    {
+        msg_error(this) << "There is no mechanical state associated with this node. "
+                            "the object is deactivated. "
+                            "To remove this error message fix your scene possibly by "
+                            "adding a MechanicalObject." ;
+        return ;
+    }
+
+    if(!d_indices.isSet())
+    {
+        WriteOnlyAccessor<sofa::Data<SetIndexArray>> indices = d_indices;
+        indices.resize(m_state->getSize());
+        for(unsigned int i=0; i<indices.size(); i++)
+            indices[i] = i;
+    }
+
+    if(!checkSliders())
+        return;
+
+    initDatas();
+    initLimit();
+
+    d_componentState = ComponentState::Valid ;
+}
+
+
+template<class DataTypes>
+void SlidingActuatorArray<DataTypes>::reinit()
+{
+    if(d_componentState.getValue() != ComponentState::Valid)
+        return ;
+
+    if(!checkSliders())
+    {
+        d_componentState = ComponentState::Invalid ;
+        return;
+    }
+
+    initDatas();
+    initLimit();
+}
+
+
+template<class DataTypes>
+void SlidingActuatorArray<DataTypes>::reset()
+{
+    reinit();
+}
+
+
+template<class DataTypes>
+bool SlidingActuatorArray<DataTypes>::checkSliders()
+{
+    ReadAccessor<sofa::Data<SetIndexArray>> indices = d_indices;
+    if(indices.empty())
+    {
+        msg_error(this) << "No index given, the object is deactivated.";
+        return false;
+    }
+
+    // Without nbPoints, one point per slider
+    const SetIndexArray nbPoints = (d_nbPoints.isSet())? d_nbPoints.getValue() : SetIndexArray(indices.size(), 1);
+    const unsigned int nbSliders = nbPoints.size();
+    m_firstPoints.resize(nbSliders+1);
+    m_firstPoints[0] = 0;
+    for(unsigned int i=0; i<nbSliders; i++)
+    {
+        if(nbPoints[i] == 0)
+        {
+            msg_error(this) << "The slider " << i << " has no point, the object is deactivated.";
+            m_firstPoints.clear();
+            return false;
+        }
+        m_firstPoints[i+1] = m_firstPoints[i] + nbPoints[i];
+    }
+
+    if(m_firstPoints[nbSliders] != indices.size())
+    {
+        msg_error(this) << "The number of points of the sliders (" << m_firstPoints[nbSliders] << ") does not match "
+                        << "the size of indices (" << indices.size() << "), the object is deactivated.";
+        m_firstPoints.clear();
+        return false;
+    }
+
+    for(unsigned int i=0; i<indices.size(); i++)
+        if(indices[i] >= m_state->getSize())
+        {
+            msg_error(this) << "Indices at index " << i << " is too large regarding mechanicalState [position] size, "
+                            << "the object is deactivated.";
+            m_firstPoints.clear();
+            return false;
+        }
+
+    VecReal values;
+    if(!getPerSliderValues(d_directions, m_directions) ||
+       !getPerSliderValues(d_maxPositiveDisplacement, m_maxPositiveDisplacement) ||
+       !getPerSliderValues(d_maxNegativeDisplacement, m_maxNegativeDisplacement) ||
+       !getPerSliderValues(d_maxDispVariation, m_maxDispVariation) ||
+       !getPerSliderValues(d_maxForce, values) ||
+       !getPerSliderValues(d_minForce, values) ||
+       !getPerSliderValues(d_initForce, values) ||
+       !getPerSliderValues(d_initDisplacement, values))
+    {
+        m_firstPoints.clear();
+        return false;
+    }
+
+    if(m_directions.empty())
+    {
+        msg_warning(this) << "No direction of actuation provided by user. Default (1. 0. 0.)";
+        Deriv x;
+        x[0]=1;
+        m_directions.assign(nbSliders, x);
+    }
+    for(Deriv& direction: m_directions)
+        normalizeDirection(direction);
+
+    // QP on one value per slider
+    m_deltaMax.resize(nbSliders);
+    m_deltaMin.resize(nbSliders);
+    m_lambdaMax.resize(nbSliders);
+    m_lambdaMin.resize(nbSliders);
+
+    return true;
+}
+
+
+template<class DataTypes>
+template<class T>
+bool SlidingActuatorArray<DataTypes>::getPerSliderValues(const sofa::Data<sofa::type::vector<T>>& data,
+                                                         sofa::type::vector<T>& values)
+{
+    const sofa::type::vector<T>& value = data.getValue();
+    const unsigned int nbSliders = getNbSliders();
+
+    if(!data.isSet() || value.empty())
+        values.clear();
+    else if(value.size() == 1)
+        values.assign(nbSliders, value[0]);
+    else if(value.size() == nbSliders)
+        values = value;
+    else
+    {
+        msg_error(this) << data.getName() << " should give one value, or one value per slider (" << nbSliders << "), "
+                        << "the object is deactivated.";
+        return false;
+    }
+    return true;
+}
+
+
+// Rigid implementation in SlidingActuatorArray.cpp
+template<class DataTypes>
+void SlidingActuatorArray<DataTypes>::normalizeDirection(Deriv& direction) const
+{
+    direction.normalize();
+}
+
+
+template<class DataTypes>
+void SlidingActuatorArray<DataTypes>::initDatas()
+{
+    const unsigned int nbSliders = getNbSliders();
+
+    VecReal initForce, initDisplacement;
+    getPerSliderValues(d_initForce, initForce);
+    getPerSliderValues(d_initDisplacement, initDisplacement);
+    if(initForce.empty())
+        initForce.assign(nbSliders, Real(0.0));
+    if(initDisplacement.empty())
+        initDisplacement.assign(nbSliders, Real(0.0));
+
+    d_force.setValue(initForce);
+    d_displacement.setValue(initDisplacement);
+}
+
+
+template<class DataTypes>
+void SlidingActuatorArray<DataTypes>::initLimit()
+{
+    const unsigned int nbSliders = getNbSliders();
+
+    VecReal maxForce, minForce;
+    getPerSliderValues(d_maxForce, maxForce);
+    getPerSliderValues(d_minForce, minForce);
+
+    m_hasLambdaMax = !maxForce.empty();
+    for(unsigned int i=0; i<maxForce.size(); i++)
+        m_lambdaMax[i] = maxForce[i];
+
+    m_hasLambdaMin = !minForce.empty();
+    for(unsigned int i=0; i<minForce.size(); i++)
+        m_lambdaMin[i] = minForce[i];
+
+    m_hasDeltaMax = !m_maxPositiveDisplacement.empty() || !m_maxDispVariation.empty();
+    m_hasDeltaMin = !m_maxNegativeDisplacement.empty() || !m_maxDispVariation.empty();
+
+    if(!m_maxPositiveDisplacement.empty())
+        for(unsigned int i=0; i<nbSliders; i++)
+            m_deltaMax[i] = m_maxPositiveDisplacement[i];
+
+    if(!m_maxNegativeDisplacement.empty())
+        for(unsigned int i=0; i<nbSliders; i++)
+            m_deltaMin[i] = -m_maxNegativeDisplacement[i];
+
+    if(!m_maxDispVariation.empty())
+    {
+        ReadAccessor<sofa::Data<VecReal>> displacement = d_displacement;
+        const bool hasMaxPositive = !m_maxPositiveDisplacement.empty();
+        const bool hasMaxNegative = !m_maxNegativeDisplacement.empty();
+        for(unsigned int i=0; i<nbSliders; i++)
+        {
+            const double variation = m_maxDispVariation[i];
+            if(rabs(m_deltaMin[i] - displacement[i]) >= variation || !hasMaxNegative)
+                m_deltaMin[i] = displacement[i] - variation;
+            if(rabs(m_deltaMax[i] - displacement[i]) >= variation || !hasMaxPositive)
+                m_deltaMax[i] = displacement[i] + variation;
+        }
+    }
+}
+
+
+template<class DataTypes>
+void SlidingActuatorArray<DataTypes>::updateLimit()
+{
+    // One pass over the arrays of the sliders for each limit
+    const unsigned int nbSliders = getNbSliders();
+    const bool accumulateDisp = d_accumulateDisp.getValue();
+    ReadAccessor<sofa::Data<VecReal>> displacement = d_displacement;
+
+    if(!m_maxPositiveDisplacement.empty())
+        for(unsigned int i=0; i<nbSliders; i++)
+            m_deltaMax[i] = (accumulateDisp && displacement[i] > 0)? m_maxPositiveDisplacement[i] - displacement[i]
+                                                                   : m_maxPositiveDisplacement[i];
+
+    if(!m_maxNegativeDisplacement.empty())
+        for(unsigned int i=0; i<nbSliders; i++)
+            m_deltaMin[i] = (accumulateDisp && displacement[i] < 0)? -m_maxNegativeDisplacement[i] - displacement[i]
+                                                                   : -m_maxNegativeDisplacement[i];
+
+    if(m_maxDispVariation.empty())
+        return;
+
+    if(accumulateDisp)
+    {
+        for(unsigned int i=0; i<nbSliders; i++)
+        {
+            const double variation = m_maxDispVariation[i];
+            if(m_deltaMin[i] < -variation)
+                m_deltaMin[i] = -variation;
+            if(m_deltaMax[i] > variation)
+                m_deltaMax[i] = variation;
+        }
+    }
+    else
+    {
+        const bool hasMaxPositive = !m_maxPositiveDisplacement.empty();
+        const bool hasMaxNegative = !m_maxNegativeDisplacement.empty();
+        for(unsigned int i=0; i<nbSliders; i++)
+        {
+            const double variation = m_maxDispVariation[i];
+            if(rabs(m_deltaMin[i] - displacement[i]) >= variation || !hasMaxNegative)
+                m_deltaMin[i] = displacement[i] - variation;
+            if(rabs(m_deltaMax[i] - displacement[i]) >= variation || !hasMaxPositive)
+                m_deltaMax[i] = displacement[i] + variation;
+        }
+    }
+}
+
+
+template<class DataTypes>
+void SlidingActuatorArray<DataTypes>::buildConstraintMatrix(const ConstraintParams* cParams,
+                                                            DataMatrixDeriv &cMatrix,
+                                                            unsigned int &cIndex,
+                                                            const DataVecCoord &x)
+{
+    SOFA_UNUSED(cParams);
+    SOFA_UNUSED(x);
+
+    if(d_componentState.getValue() != ComponentState::Valid)
+        return ;
+
+    m_constraintId = cIndex;
+
+    MatrixDeriv& matrix = *cMatrix.beginEdit();
+    const SetIndexArray& indices = d_indices.getValue();
+
+    // One block of rows, one row per slider, the direction shared by its points
+    const unsigned int nbSliders = getNbSliders();
+    for(unsigned int i=0; i<nbSliders; i++)
+    {
+        MatrixDerivRowIterator rowIterator = matrix.writeLine(m_constraintId+i);
+        const unsigned int first = m_firstPoints[i];
+        const unsigned int last = m_firstPoints[i+1];
+        const Deriv ratio = m_directions[i]/(last-first);
+        for(unsigned int k=first; k<last; k++)
+            rowIterator.setCol(indices[k], ratio);
+    }
+
+    cIndex += nbSliders;
+    cMatrix.endEdit();
+    m_nbLines = cIndex - m_constraintId;
+}
+
+
+template<class DataTypes>
+void SlidingActuatorArray<DataTypes>::getConstraintViolation(const ConstraintParams* cParams,
+                                                             BaseVector *resV,
+                                                             const BaseVector *Jdx)
+{
+    SOFA_UNUSED(cParams);
+
+    if(d_componentState.getValue() != ComponentState::Valid)
+        return ;
+
+    ReadAccessor<sofa::Data<VecCoord> > positions = m_state->readPositions();
+    ReadAccessor<sofa::Data<VecCoord> > restPositions = m_state->readRestPositions();
+    const SetIndexArray& indices = d_indices.getValue();
+
+    // Projection of the displacement of the first point of each slider along its direction
+    const unsigned int nbSliders = getNbSliders();
+    const bool withJdx = (Jdx->size()!=0);
+    for(unsigned int i=0; i<nbSliders; i++)
+    {
+        const unsigned int index = indices[m_firstPoints[i]];
+        const Deriv d = DataTypes::coordDifference(positions[index], restPositions[index]);
+        const Deriv& direction = m_directions[i];
+
+        Real dFree = (withJdx)? Jdx->element(i) : Real(0.0);
+        for(unsigned int c=0; c<Deriv::total_size; c++)
+            dFree += d[c]*direction[c];
+        resV->set(m_constraintId+i, dFree);
+    }
+}
+
+
+template<class DataTypes>
+void SlidingActuatorArray<DataTypes>::storeResults(sofa::type::vector<double> &lambda,
+                                                   sofa::type::vector<double> &delta)
+{
+    if(d_componentState.getValue() != ComponentState::Valid)
+        return ;
+
+    {
+        const unsigned int nbSliders = getNbSliders();
+        WriteOnlyAccessor<sofa::Data<VecReal>> force = d_force;
+        sofa::helper::WriteAccessor<sofa::Data<VecReal>> displacement = d_displacement;
+        force.resize(nbSliders);
+        displacement.resize(nbSliders);
+        if(d_accumulateDisp.getValue())
+            for(unsigned int i=0; i<nbSliders; i++)
+                displacement[i] += delta[i];
+        else
+            for(unsigned int i=0; i<nbSliders; i++)
+                displacement[i] = delta[i];
+        for(unsigned int i=0; i<nbSliders; i++)
+            force[i] = lambda[i];
+    }
+
+    updateLimit();
+
+    Actuator<DataTypes>::storeResults(lambda, delta);
+}
+
+
+template<class DataTypes>
+void SlidingActuatorArray<DataTypes>::draw(const VisualParams* vparams)
+{
+    if(d_componentState.getValue() != ComponentState::Valid)
+        return ;
+
+    if (!vparams->displayFlags().getShowInteractionForceFields() || !d_showDirection.getValue())
+        return;
+
+    ReadAccessor<sofa::Data<VecCoord> > positions = m_state->readPositions();
+    const SetIndexArray& indices = d_indices.getValue();
+    const double scale = d_showVisuScale.getValue();
+
+    vparams->drawTool()->setLightingEnabled(true);
+    for(unsigned int i=0; i<getNbSliders(); i++)
+    {
+        const unsigned int first = m_firstPoints[i];
+        const unsigned int last = m_firstPoints[i+1];
+
+        Vec3 bary(0.,0.,0.);
+        for(unsigned int k=first; k<last; k++)
+            for (unsigned int j=0; j<3; j++)
+                bary[j] += positions[indices[k]][j]/(last-first);
+
+        Vec3 baryArrow;
+        for (unsigned int j=0; j<3; j++)
+            baryArrow[j] = bary[j] + m_directions[i][j]*scale;
+
+        vparams->drawTool()->drawArrow(bary, baryArrow, scale/20.0f, RGBAColor(1,0,0,1));
+    }
+    vparams->drawTool()->restoreLastState();
+}
+
+
+} // namespace
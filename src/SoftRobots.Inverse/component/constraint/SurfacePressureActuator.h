@@ -30,6 +30,9 @@
 
 #include <SoftRobots/component/constraint/model/SurfacePressureModel.h>
 #include <SoftRobots.Inverse/component/behavior/Actuator.h>
+#include <SoftRobots.Inverse/component/behavior/ConcurrentResults.h>
+#include <SoftRobots.Inverse/component/constraint/SurfacePressureCavity.h>
+#include <SoftRobots.Inverse/component/constraint/SurfacePressureCavityVolumes.h>
 
 #include <SoftRobots.Inverse/component/config.h>
 
@@ -46,7 +49,7 @@ namespace softrobotsinverse::constraint
  * https://softrobotscomponents.readthedocs.io
 */
 template< class DataTypes >
-class SurfacePressureActuator : public Actuator<DataTypes> , public softrobots::constraint::SurfacePressureModel<DataTypes>
+class SurfacePressureActuator : public Actuator<DataTypes> , public softrobots::constraint::SurfacePressureModel<DataTypes> , public softrobotsinverse::behavior::ConcurrentResults
 {
 public:
     SOFA_CLASS(SOFA_TEMPLATE(SurfacePressureActuator,DataTypes), SOFA_TEMPLATE(Actuator,DataTypes));
@@ -54,6 +57,11 @@ public:
     typedef typename DataTypes::Coord                       Coord;
     typedef typename Coord::value_type                      Real;
     typedef typename sofa::core::behavior::MechanicalState<DataTypes> MechanicalState;
+    typedef typename DataTypes::VecCoord                    VecCoord;
+    typedef typename DataTypes::MatrixDeriv                 MatrixDeriv;
+    typedef typename DataTypes::MatrixDeriv::RowIterator    MatrixDerivRowIterator;
+    typedef sofa::core::objectmodel::Data<VecCoord>         DataVecCoord;
+    typedef sofa::core::objectmodel::Data<MatrixDeriv>      DataMatrixDeriv;
 
 public:
     SurfacePressureActuator(MechanicalState* object = nullptr);
@@ -66,6 +74,15 @@ public:
     /////////////////////////////////////////////////////////////
 
     ////////////////////////// Inherited from BaseConstraint ////////////////
+    void buildConstraintMatrix(const ConstraintParams* cParams,
+                               DataMatrixDeriv &cMatrix,
+                               unsigned int &cIndex,
+                               const DataVecCoord &x) override;
+
+    void getConstraintViolation(const ConstraintParams* cParams,
+                                BaseVector *resV,
+                                const BaseVector *Jdx) override;
+
     void storeLambda(const ConstraintParams* cParams,
                      sofa::core::MultiVecDerivId res,
                      const BaseVector* lambda) override;
@@ -79,6 +96,11 @@ public:
 protected:
 
     sofa::Data<Real> d_initPressure;
+    sofa::Data<bool> d_precomputeCavity;
+    sofa::Data<bool> d_multithreading;
+
+    SurfacePressureCavity<DataTypes> m_cavity;
+    std::shared_ptr<typename SurfacePressureCavityVolumes<DataTypes>::Cavity> m_sharedCavity; // Volume shared with the components of the same surface
 
     ////////////////////////// Inherited attributes ////////////////////////////
     using Actuator<DataTypes>::m_state ;
@@ -93,11 +115,15 @@ protected:
     using softrobots::constraint::SurfacePressureModel<DataTypes>::d_pressure ;
     using softrobots::constraint::SurfacePressureModel<DataTypes>::d_volumeGrowth ;
     using softrobots::constraint::SurfacePressureModel<DataTypes>::d_maxVolumeGrowthVariation ;
+    using softrobots::constraint::SurfacePressureModel<DataTypes>::d_triangles;
+    using softrobots::constraint::SurfacePressureModel<DataTypes>::d_quads;
+    using softrobots::constraint::SurfacePressureModel<DataTypes>::d_flipNormal;
     using softrobots::constraint::SurfacePressureModel<DataTypes>::m_constraintId;
     ////////////////////////////////////////////////////////////////////////////
 
 private:
     void initDatas();
+    void initCavity();
     void initLimits();
     void updateLimits();
 
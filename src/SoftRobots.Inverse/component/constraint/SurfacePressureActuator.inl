@@ -31,6 +31,7 @@
 #include <SoftRobots.Inverse/component/constraint/SurfacePressureActuator.h>
 
 #include <sofa/helper/logging/Messaging.h>
+#include <sofa/simulation/MainTaskSchedulerFactory.h>
 
 namespace softrobotsinverse::constraint
 {
@@ -45,6 +46,17 @@ SurfacePressureActuator<DataTypes>::SurfacePressureActuator(MechanicalState* obj
     , softrobots::constraint::SurfacePressureModel<DataTypes>(object)
     , d_initPressure(initData(&d_initPressure,Real(0.0), "initPressure",
                           "Initial pressure if any. Default is 0."))
+    , d_precomputeCavity(initData(&d_precomputeCavity, false, "precomputeCavity",
+                                  "If true, the index buffers of the cavity surface are built on init, and the volume \n"
+                                  "and its gradient are evaluated in a single pass over them. Recommended for cavities \n"
+                                  "with many triangles. The volume is computed once for all the components of the same \n"
+                                  "surface (see SurfacePressureCavityVolumes). Call reinit() after a change of the triangles \n"
+                                  "or quads. \n"
+                                  "Default value is false."))
+    , d_multithreading(initData(&d_multithreading, false, "multithreading",
+                                "Evaluate the points of the cavity, and the volumes of the other cavities of the same \n"
+                                "mechanical state, concurrently, when precomputeCavity is true. \n"
+                                "Default value is false."))
 {
     // These datas from SurfacePressureModel have no sense for actuator
     d_eqPressure.setDisplayed(false);
@@ -68,6 +80,7 @@ void SurfacePressureActuator<DataTypes>::init()
 {
     softrobots::constraint::SurfacePressureModel<DataTypes>::init();
     initDatas();
+    initCavity();
     initLimits();
 }
 
@@ -76,6 +89,7 @@ void SurfacePressureActuator<DataTypes>::reinit()
 {
     softrobots::constraint::SurfacePressureModel<DataTypes>::reinit();
     initDatas();
+    initCavity();
     initLimits();
 }
 
@@ -84,6 +98,7 @@ void SurfacePressureActuator<DataTypes>::reset()
 {
     softrobots::constraint::SurfacePressureModel<DataTypes>::reset();
     initDatas();
+    initCavity();
     initLimits();
 }
 
@@ -99,6 +114,20 @@ void SurfacePressureActuator<DataTypes>::initDatas()
     }
 }
 
+template<class DataTypes>
+void SurfacePressureActuator<DataTypes>::initCavity()
+{
+    m_cavity.clear();
+    m_sharedCavity.reset();
+    if(!d_precomputeCavity.getValue())
+        return;
+
+    m_cavity.init(d_triangles.getValue(), d_quads.getValue(), d_flipNormal.getValue());
+    m_sharedCavity = SurfacePressureCavityVolumes<DataTypes>::getCavity(m_state, d_triangles.getValue(), d_quads.getValue(), d_flipNormal.getValue());
+    if(d_multithreading.getValue())
+        sofa::simulation::MainTaskSchedulerFactory::createInRegistry()->init();
+}
+
 template<class DataTypes>
 void SurfacePressureActuator<DataTypes>::initLimits()
 {
@@ -170,6 +199,54 @@ void SurfacePressureActuator<DataTypes>::updateLimits()
     }
 }
 
+template<class DataTypes>
+void SurfacePressureActuator<DataTypes>::buildConstraintMatrix(const ConstraintParams* cParams,
+                                                               DataMatrixDeriv &cMatrix,
+                                                               unsigned int &cIndex,
+                                                               const DataVecCoord &x)
+{
+    if(!d_precomputeCavity.getValue())
+    {
+        softrobots::constraint::SurfacePressureModel<DataTypes>::buildConstraintMatrix(cParams, cMatrix, cIndex, x);
+        return;
+    }
+
+    m_constraintId = cIndex;
+
+    MatrixDeriv& matrix = *cMatrix.beginEdit();
+    MatrixDerivRowIterator rowIterator = matrix.writeLine(m_constraintId);
+
+    m_cavity.evaluate(x.getValue(), d_multithreading.getValue());
+    const vector<unsigned int>& points = m_cavity.getPoints();
+    const auto& gradient = m_cavity.getGradient();
+    for(unsigned int i=0; i<points.size(); i++)
+        rowIterator.setCol(points[i], gradient[i]);
+
+    cIndex++;
+    cMatrix.endEdit();
+    m_nbLines = cIndex - m_constraintId;
+}
+
+template<class DataTypes>
+void SurfacePressureActuator<DataTypes>::getConstraintViolation(const ConstraintParams* cParams,
+                                                                BaseVector *resV,
+                                                                const BaseVector *Jdx)
+{
+    if(!d_precomputeCavity.getValue())
+    {
+        softrobots::constraint::SurfacePressureModel<DataTypes>::getConstraintViolation(cParams, resV, Jdx);
+        return;
+    }
+
+    d_cavityVolume.setValue(SurfacePressureCavityVolumes<DataTypes>::getVolume(*m_sharedCavity,
+                                                                               *m_state->read(sofa::core::ConstVecCoordId::position()),
+                                                                               d_multithreading.getValue()));
+    Real dfree = d_cavityVolume.getValue() - d_initialCavityVolume.getValue();
+    if(Jdx->size()!=0)
+        dfree += Jdx->element(0);
+    resV->set(m_constraintId, dfree);
+}
+
 template<class DataTypes>
 void SurfacePressureActuator<DataTypes>::storeResults(sofa::type::vector<double> &lambda,
                                                       sofa::type::vector<double> &delta)
@@ -0,0 +1,173 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <SoftRobots.Inverse/component/behavior/Actuator.h>
+#include <SoftRobots.Inverse/component/behavior/ConcurrentResults.h>
+#include <SoftRobots.Inverse/component/constraint/SurfacePressureCavity.h>
+
+#include <SoftRobots.Inverse/component/config.h>
+
+namespace softrobotsinverse::constraint
+{
+
+using softrobotsinverse::behavior::Actuator;
+using sofa::helper::ReadAccessor;
+using sofa::core::ConstraintParams;
+using sofa::linearalgebra::BaseVector;
+using softrobots::behavior::SoftRobotsConstraint;
+
+
+/**
+ * This component applies pressure in several cavities of the same mesh to solve an effector constraint.
+ * It is equivalent to one SurfacePressureActuator per cavity, with one row per cavity in a single block.
+ * The triangles and quads of all the cavities are concatenated, nbTriangles and nbQuads give the number
+ * of primitives of each cavity. The positions are read once for all the cavities, when building the
+ * rows and when computing the volumes. The limits are given once for all the cavities, or with one value
+ * per cavity.
+*/
+template< class DataTypes >
+class SurfacePressureActuatorArray : public Actuator<DataTypes>, public softrobotsinverse::behavior::ConcurrentResults
+{
+public:
+    SOFA_CLASS(SOFA_TEMPLATE(SurfacePressureActuatorArray,DataTypes), SOFA_TEMPLATE(Actuator,DataTypes));
+
+    typedef typename DataTypes::VecCoord VecCoord;
+    typedef typename DataTypes::Coord Coord;
+    typedef typename DataTypes::Deriv Deriv;
+    typedef typename DataTypes::MatrixDeriv MatrixDeriv;
+    typedef typename Coord::value_type Real;
+    typedef typename sofa::core::behavior::MechanicalState<DataTypes> MechanicalState;
+
+    typedef typename DataTypes::MatrixDeriv::RowIterator MatrixDerivRowIterator;
+    typedef sofa::core::objectmodel::Data<VecCoord>		DataVecCoord;
+    typedef sofa::core::objectmodel::Data<MatrixDeriv>    DataMatrixDeriv;
+
+    typedef sofa::core::topology::BaseMeshTopology::Triangle Triangle;
+    typedef sofa::core::topology::BaseMeshTopology::Quad Quad;
+    typedef sofa::type::vector<unsigned int> SetIndexArray;
+    typedef sofa::type::vector<Real> VecReal;
+    typedef Actuator<DataTypes> Inherit;
+
+public:
+    SurfacePressureActuatorArray(MechanicalState* object = nullptr);
+    ~SurfacePressureActuatorArray() override;
+
+
+    ////////////////////////// Inherited from BaseObject ////////////////////
+    void init() override;
+    void reinit() override;
+    void reset() override;
+    /////////////////////////////////////////////////////////////////////////
+
+    //////////////// Inherited from SoftRobotsConstraint ///////////////
+    void buildConstraintMatrix(const ConstraintParams* cParams,
+                               DataMatrixDeriv &cMatrix,
+                               unsigned int &cIndex,
+                               const DataVecCoord &x) override;
+
+    void getConstraintViolation(const ConstraintParams* cParams,
+                                BaseVector *resV,
+                                const BaseVector * Jdx) override;
+    /////////////////////////////////////////////////////////////////////////
+
+    /////////////// Inherited from BaseSoftRobotsConstraint /////////////
+    void storeResults(sofa::type::vector<double> &lambda,
+                      sofa::type::vector<double> &delta) override;
+    /////////////////////////////////////////////////////////////
+
+    unsigned int getNbCavities() const {return m_cavities.getNbCavities();}
+
+protected:
+
+    ////////////////////////// Inherited attributes ////////////////////////////
+    /// https://gcc.gnu.org/onlinedocs/gcc/Name-lookup.html
+    /// Bring inherited attributes and function in the current lookup context.
+    /// otherwise any access to the base::attribute would require
+    /// the "this->" approach.
+    using Inherit::m_hasDeltaMax ;
+    using Inherit::m_hasDeltaMin ;
+    using Inherit::m_deltaMax ;
+    using Inherit::m_deltaMin ;
+
+    using Inherit::m_hasLambdaMax ;
+    using Inherit::m_hasLambdaMin ;
+    using Inherit::m_hasLambdaInit ;
+    using Inherit::m_lambdaMax ;
+    using Inherit::m_lambdaMin ;
+    using Inherit::m_lambdaInit ;
+
+    using Inherit::m_nbLines ;
+    using Inherit::m_constraintId ;
+    using Inherit::d_componentState ;
+
+    using Inherit::m_state ;
+    ////////////////////////////////////////////////////////////////////////////
+
+    sofa::Data<sofa::type::vector<Triangle>>  d_triangles;
+    sofa::Data<SetIndexArray>                 d_nbTriangles;
+    sofa::Data<sofa::type::vector<Quad>>      d_quads;
+    sofa::Data<SetIndexArray>                 d_nbQuads;
+    sofa::Data<bool>                          d_flipNormal;
+
+    sofa::Data<VecReal>                       d_initPressure;
+    sofa::Data<VecReal>                       d_maxPressure;
+    sofa::Data<VecReal>                       d_minPressure;
+    sofa::Data<VecReal>                       d_maxVolumeGrowth;
+    sofa::Data<VecReal>                       d_minVolumeGrowth;
+    sofa::Data<VecReal>                       d_maxVolumeGrowthVariation;
+    sofa::Data<bool>                          d_multithreading;
+
+    sofa::Data<VecReal>                       d_pressure;
+    sofa::Data<VecReal>                       d_volumeGrowth;
+    sofa::Data<VecReal>                       d_cavityVolume;
+    sofa::Data<VecReal>                       d_initialCavityVolume;
+
+    // Index buffers of the cavities, and their limits on the volume growth with one value per cavity,
+    // set from the data at init
+    SurfacePressureCavity<DataTypes> m_cavities;
+    VecReal m_maxVolumeGrowth;
+    VecReal m_minVolumeGrowth;
+    VecReal m_maxVolumeGrowthVariation;
+    VecReal m_volumes; // scratch of getConstraintViolation
+
+    bool checkCavities();
+    bool getNbPrimitives(const sofa::Data<SetIndexArray>& data, unsigned int nbPrimitives,
+                         unsigned int nbCavities, SetIndexArray& values);
+    bool getPerCavityValues(const sofa::Data<VecReal>& data, VecReal& values);
+    void initDatas();
+    void initLimits();
+    void updateLimits();
+};
+
+#if !defined(SOFTROBOTS_INVERSE_CONSTRAINT_SURFACEPRESSUREACTUATORARRAY_CPP)
+extern template class SOFA_SOFTROBOTS_INVERSE_API SurfacePressureActuatorArray<sofa::defaulttype::Vec3Types>;
+#endif
+
+} // namespace
@@ -0,0 +1,479 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <sofa/simulation/MainTaskSchedulerFactory.h>
+
+#include <SoftRobots.Inverse/component/constraint/SurfacePressureActuatorArray.h>
+
+namespace softrobotsinverse::constraint
+{
+
+using sofa::core::objectmodel::ComponentState ;
+
+using sofa::linearalgebra::BaseVector;
+using sofa::helper::ReadAccessor;
+using sofa::helper::WriteOnlyAccessor;
+using sofa::helper::rabs;
+
+template<class DataTypes>
+SurfacePressureActuatorArray<DataTypes>::SurfacePressureActuatorArray(MechanicalState* object)
+    : Inherit(object)
+    , d_triangles(initData(&d_triangles, "triangles",
+                           "Triangles of all the cavities, concatenated."))
+
+    , d_nbTriangles(initData(&d_nbTriangles, "nbTriangles",
+                             "Number of triangles of each cavity in triangles. \n"
+                             "If unspecified with a single cavity, all the triangles make the cavity."))
+
+    , d_quads(initData(&d_quads, "quads",
+                       "Quads of all the cavities, concatenated."))
+
+    , d_nbQuads(initData(&d_nbQuads, "nbQuads",
+                         "Number of quads of each cavity in quads. \n"
+                         "If unspecified with a single cavity, all the quads make the cavity."))
+
+    , d_flipNormal(initData(&d_flipNormal, false, "flipNormal",
+                            "Flip the normals of the triangles and quads, to get the volumes inside the cavities. \n"
+                            "Default value is false."))
+
+    , d_initPressure(initData(&d_initPressure, "initPressure",
+                              "Initial pressure of the cavities, one value for all the cavities or one per cavity. \n"
+                              "Default is 0."))
+
+    , d_maxPressure(initData(&d_maxPressure, "maxPressure",
+                             "Maximum pressure of the cavities, one value for all the cavities or one per cavity. \n"
+                             "If unspecified no maximum value will be considered."))
+
+    , d_minPressure(initData(&d_minPressure, "minPressure",
+                             "Minimum pressure of the cavities, one value for all the cavities or one per cavity. \n"
+                             "If unspecified no minimum value will be considered."))
+
+    , d_maxVolumeGrowth(initData(&d_maxVolumeGrowth, "maxVolumeGrowth",
+                                 "Maximum volume growth of the cavities, one value for all the cavities or one per \n"
+                                 "cavity. If unspecified no maximum value will be considered."))
+
+    , d_minVolumeGrowth(initData(&d_minVolumeGrowth, "minVolumeGrowth",
+                                 "Minimum volume growth of the cavities, one value for all the cavities or one per \n"
+                                 "cavity. If unspecified no minimum value will be considered."))
+
+    , d_maxVolumeGrowthVariation(initData(&d_maxVolumeGrowthVariation, "maxVolumeGrowthVariation",
+                                          "Maximum variation of the volume growth allowed in a step, one value for all \n"
+                                          "the cavities or one per cavity. If unspecified no max variation will be considered."))
+
+    , d_multithreading(initData(&d_multithreading, false, "multithreading",
+                                "Evaluate the cavities concurrently. \n"
+                                "Default value is false."))
+
+    , d_pressure(initData(&d_pressure, "pressure",
+                          "Output pressure of each cavity. Warning: to get the actual pressure you should divide this value by dt."))
+
+    , d_volumeGrowth(initData(&d_volumeGrowth, "volumeGrowth",
+                              "Output volume growth of each cavity compared to its initial volume."))
+
+    , d_cavityVolume(initData(&d_cavityVolume, "cavityVolume",
+                              "Output volume of each cavity."))
+
+    , d_initialCavityVolume(initData(&d_initialCavityVolume, "initialCavityVolume",
+                                     "Output volume of each cavity at init."))
+{
+    d_triangles.setGroup("Input");
+    d_nbTriangles.setGroup("Input");
+    d_quads.setGroup("Input");
+    d_nbQuads.setGroup("Input");
+    d_flipNormal.setGroup("Input");
+    d_initPressure.setGroup("Input");
+    d_maxPressure.setGroup("Input");
+    d_minPressure.setGroup("Input");
+    d_maxVolumeGrowth.setGroup("Input");
+    d_minVolumeGrowth.setGroup("Input");
+    d_maxVolumeGrowthVariation.setGroup("Input");
+
+    d_pressure.setGroup("Output");
+    d_volumeGrowth.setGroup("Output");
+    d_cavityVolume.setGroup("Output");
+    d_initialCavityVolume.setGroup("Output");
+    d_pressure.setReadOnly(true);
+    d_volumeGrowth.setReadOnly(true);
+    d_cavityVolume.setReadOnly(true);
+    d_initialCavityVolume.setReadOnly(true);
+}
+
+
+template<class DataTypes>
+SurfacePressureActuatorArray<DataTypes>::~SurfacePressureActuatorArray()
+{
+}
+
+
+template<class DataTypes>
+void SurfacePressureActuatorArray<DataTypes>::init()
+{
+    d_componentState = ComponentState::Invalid ;
+    SoftRobotsConstraint<DataTypes>::init();
+
+    if(m_state==nullptr)
+    {
+        msg_error(this) << "There is no mechanical state associated with this node. "
+                            "the object is deactivated. "
+                            "To remove this error message fix your scene possibly by "
+                            "adding a MechanicalObject." ;
+        return ;
+    }
+
+    if(!checkCavities())
+        return;
+
+    if(d_multithreading.getValue())
+        sofa::simulation::MainTaskSchedulerFactory::createInRegistry()->init();
+
+    initDatas();
+    initLimits();
+
+    d_componentState = ComponentState::Valid ;
+}
+
+
+template<class DataTypes>
+void SurfacePressureActuatorArray<DataTypes>::reinit()
+{
+    if(d_componentState.getValue() != ComponentState::Valid)
+        return ;
+
+    if(!checkCavities())
+    {
+        d_componentState = ComponentState::Invalid ;
+        return;
+    }
+
+    initDatas();
+    initLimits();
+}
+
+
+template<class DataTypes>
+void SurfacePressureActuatorArray<DataTypes>::reset()
+{
+    reinit();
+}
+
+
+template<class DataTypes>
+bool SurfacePressureActuatorArray<DataTypes>::checkCavities()
+{
+    m_cavities.clear();
+
+    ReadAccessor<sofa::Data<sofa::type::vector<Triangle>>> triangles = d_triangles;
+    ReadAccessor<sofa::Data<sofa::type::vector<Quad>>> quads = d_quads;
+    if(triangles.empty() && quads.empty())
+    {
+        msg_error(this) << "No triangle nor quad given, the object is deactivated.";
+        return false;
+    }
+
+    // Without nbTriangles nor nbQuads, all the primitives make one cavity
+    const unsigned int nbCavities = (d_nbTriangles.isSet())? d_nbTriangles.getValue().size()
+                                  : (d_nbQuads.isSet())? d_nbQuads.getValue().size() : 1;
+    SetIndexArray nbTriangles, nbQuads;
+    if(nbCavities == 0 ||
+       !getNbPrimitives(d_nbTriangles, triangles.size(), nbCavities, nbTriangles) ||
+       !getNbPrimitives(d_nbQuads, quads.size(), nbCavities, nbQuads))
+    {
+        msg_error(this) << "The object is deactivated.";
+        return false;
+    }
+
+    const unsigned int size = m_state->getSize();
+    for(unsigned int i=0; i<triangles.size(); i++)
+        for(unsigned int k=0; k<3; k++)
+            if(triangles[i][k] >= size)
+            {
+                msg_error(this) << "Triangle at index " << i << " is too large regarding mechanicalState [position] size, "
+                                << "the object is deactivated.";
+                return false;
+            }
+    for(unsigned int i=0; i<quads.size(); i++)
+        for(unsigned int k=0; k<4; k++)
+            if(quads[i][k] >= size)
+            {
+                msg_error(this) << "Quad at index " << i << " is too large regarding mechanicalState [position] size, "
+                                << "the object is deactivated.";
+                return false;
+            }
+
+    m_cavities.init(triangles.ref(), nbTriangles, quads.ref(), nbQuads, d_flipNormal.getValue());
+
+    VecReal pressures;
+    if(!getPerCavityValues(d_maxVolumeGrowth, m_maxVolumeGrowth) ||
+       !getPerCavityValues(d_minVolumeGrowth, m_minVolumeGrowth) ||
+       !getPerCavityValues(d_maxVolumeGrowthVariation, m_maxVolumeGrowthVariation) ||
+       !getPerCavityValues(d_maxPressure, pressures) ||
+       !getPerCavityValues(d_minPressure, pressures) ||
+       !getPerCavityValues(d_initPressure, pressures))
+    {
+        m_cavities.clear();
+        return false;
+    }
+
+    // QP on one value per cavity
+    m_lambdaInit.resize(nbCavities);
+    m_deltaMax.resize(nbCavities);
+    m_deltaMin.resize(nbCavities);
+    m_lambdaMax.resize(nbCavities);
+    m_lambdaMin.resize(nbCavities);
+
+    return true;
+}
+
+
+template<class DataTypes>
+bool SurfacePressureActuatorArray<DataTypes>::getNbPrimitives(const sofa::Data<SetIndexArray>& data,
+                                                               unsigned int nbPrimitives,
+                                                               unsigned int nbCavities,
+                                                               SetIndexArray& values)
+{
+    if(!data.isSet())
+    {
+        if(nbPrimitives != 0 && nbCavities != 1)
+        {
+            msg_error(this) << data.getName() << " should be given for the " << nbCavities << " cavities.";
+            return false;
+        }
+        values.assign(nbCavities, 0);
+        values[0] = nbPrimitives;
+        return true;
+    }
+
+    values = data.getValue();
+    unsigned int sum = 0;
+    for(unsigned int value : values)
+        sum += value;
+
+    if(values.size() != nbCavities || sum != nbPrimitives)
+    {
+        msg_error(this) << data.getName() << " should give the number of primitives of each of the " << nbCavities
+                        << " cavities, with a sum (" << sum << ") matching the number of primitives (" << nbPrimitives << ").";
+        return false;
+    }
+    return true;
+}
+
+
+template<class DataTypes>
+bool SurfacePressureActuatorArray<DataTypes>::getPerCavityValues(const sofa::Data<VecReal>& data, VecReal& values)
+{
+    const VecReal& value = data.getValue();
+    const unsigned int nbCavities = getNbCavities();
+
+    if(!data.isSet() || value.empty())
+        values.clear();
+    else if(value.size() == 1)
+        values.assign(nbCavities, value[0]);
+    else if(value.size() == nbCavities)
+        values = value;
+    else
+    {
+        msg_error(this) << data.getName() << " should give one value, or one value per cavity (" << nbCavities << "), "
+                        << "the object is deactivated.";
+        return false;
+    }
+    return true;
+}
+
+
+template<class DataTypes>
+void SurfacePressureActuatorArray<DataTypes>::initDatas()
+{
+    const unsigned int nbCavities = getNbCavities();
+
+    VecReal initPressure;
+    getPerCavityValues(d_initPressure, initPressure);
+    m_hasLambdaInit = !initPressure.empty();
+    if(m_hasLambdaInit)
+        for(unsigned int i=0; i<nbCavities; i++)
+            m_lambdaInit[i] = initPressure[i];
+    else
+        initPressure.assign(nbCavities, Real(0.0));
+
+    d_pressure.setValue(initPressure);
+    d_volumeGrowth.setValue(VecReal(nbCavities, Real(0.0)));
+
+    ReadAccessor<sofa::Data<VecCoord>> positions = m_state->readPositions();
+    m_cavities.computeVolumes(positions.ref(), m_volumes);
+    d_cavityVolume.setValue(m_volumes);
+    d_initialCavityVolume.setValue(m_volumes);
+}
+
+
+template<class DataTypes>
+void SurfacePressureActuatorArray<DataTypes>::initLimits()
+{
+    VecReal maxPressure, minPressure;
+    getPerCavityValues(d_maxPressure, maxPressure);
+    getPerCavityValues(d_minPressure, minPressure);
+
+    m_hasLambdaMax = !maxPressure.empty();
+    for(unsigned int i=0; i<maxPressure.size(); i++)
+        m_lambdaMax[i] = maxPressure[i];
+
+    m_hasLambdaMin = !minPressure.empty();
+    bool canDrain = !m_hasLambdaMin;
+    for(unsigned int i=0; i<minPressure.size(); i++)
+    {
+        m_lambdaMin[i] = minPressure[i];
+        canDrain |= (minPressure[i] < 0);
+    }
+
+    if(canDrain)
+        msg_info(this) << "A negative pressure will empty/drain the cavities. If you do not want this feature set 'minPressure=0'.";
+
+    m_hasDeltaMax = !m_maxVolumeGrowth.empty() || !m_maxVolumeGrowthVariation.empty();
+    m_hasDeltaMin = !m_minVolumeGrowth.empty() || !m_maxVolumeGrowthVariation.empty();
+    updateLimits();
+}
+
+
+template<class DataTypes>
+void SurfacePressureActuatorArray<DataTypes>::updateLimits()
+{
+    // One pass over the arrays of the cavities for each limit
+    const unsigned int nbCavities = getNbCavities();
+    ReadAccessor<sofa::Data<VecReal>> volumeGrowth = d_volumeGrowth;
+
+    if(!m_maxVolumeGrowth.empty())
+        for(unsigned int i=0; i<nbCavities; i++)
+            m_deltaMax[i] = m_maxVolumeGrowth[i];
+
+    if(!m_minVolumeGrowth.empty())
+        for(unsigned int i=0; i<nbCavities; i++)
+            m_deltaMin[i] = m_minVolumeGrowth[i];
+
+    if(!m_maxVolumeGrowthVariation.empty())
+    {
+        const bool hasMaxVolumeGrowth = !m_maxVolumeGrowth.empty();
+        const bool hasMinVolumeGrowth = !m_minVolumeGrowth.empty();
+        for(unsigned int i=0; i<nbCavities; i++)
+        {
+            const double variation = m_maxVolumeGrowthVariation[i];
+            if(rabs(m_deltaMax[i] - volumeGrowth[i]) >= variation || !hasMaxVolumeGrowth)
+                m_deltaMax[i] = volumeGrowth[i] + variation;
+            if(rabs(m_deltaMin[i] - volumeGrowth[i]) >= variation || !hasMinVolumeGrowth)
+                m_deltaMin[i] = volumeGrowth[i] - variation;
+        }
+    }
+}
+
+
+template<class DataTypes>
+void SurfacePressureActuatorArray<DataTypes>::buildConstraintMatrix(const ConstraintParams* cParams,
+                                                                    DataMatrixDeriv &cMatrix,
+                                                                    unsigned int &cIndex,
+                                                                    const DataVecCoord &x)
+{
+    SOFA_UNUSED(cParams);
+
+    if(d_componentState.getValue() != ComponentState::Valid)
+        return ;
+
+    m_constraintId = cIndex;
+
+    MatrixDeriv& matrix = *cMatrix.beginEdit();
+
+    // One pass over the positions for all the cavities, then one row per cavity in a single block
+    m_cavities.evaluate(x.getValue(), d_multithreading.getValue());
+    const SetIndexArray& points = m_cavities.getPoints();
+    const sofa::type::vector<Deriv>& gradient = m_cavities.getGradient();
+    const unsigned int nbCavities = getNbCavities();
+    for(unsigned int i=0; i<nbCavities; i++)
+    {
+        MatrixDerivRowIterator rowIterator = matrix.writeLine(m_constraintId+i);
+        for(unsigned int e=m_cavities.getFirstEntry(i); e<m_cavities.getFirstEntry(i+1); e++)
+            rowIterator.setCol(points[e], gradient[e]);
+    }
+
+    cIndex += nbCavities;
+    cMatrix.endEdit();
+    m_nbLines = cIndex - m_constraintId;
+}
+
+
+template<class DataTypes>
+void SurfacePressureActuatorArray<DataTypes>::getConstraintViolation(const ConstraintParams* cParams,
+                                                                     BaseVector *resV,
+                                                                     const BaseVector *Jdx)
+{
+    SOFA_UNUSED(cParams);
+
+    if(d_componentState.getValue() != ComponentState::Valid)
+        return ;
+
+    ReadAccessor<sofa::Data<VecCoord> > positions = m_state->readPositions();
+    ReadAccessor<sofa::Data<VecReal>> initialCavityVolume = d_initialCavityVolume;
+    m_cavities.computeVolumes(positions.ref(), m_volumes);
+    d_cavityVolume.setValue(m_volumes);
+
+    const unsigned int nbCavities = getNbCavities();
+    const bool withJdx = (Jdx->size()!=0);
+    for(unsigned int i=0; i<nbCavities; i++)
+    {
+        Real dfree = m_volumes[i] - initialCavityVolume[i];
+        if(withJdx)
+            dfree += Jdx->element(i);
+        resV->set(m_constraintId+i, dfree);
+    }
+}
+
+
+template<class DataTypes>
+void SurfacePressureActuatorArray<DataTypes>::storeResults(sofa::type::vector<double> &lambda,
+                                                           sofa::type::vector<double> &delta)
+{
+    if(d_componentState.getValue() != ComponentState::Valid)
+        return ;
+
+    {
+        const unsigned int nbCavities = getNbCavities();
+        WriteOnlyAccessor<sofa::Data<VecReal>> pressure = d_pressure;
+        WriteOnlyAccessor<sofa::Data<VecReal>> volumeGrowth = d_volumeGrowth;
+        pressure.resize(nbCavities);
+        volumeGrowth.resize(nbCavities);
+        for(unsigned int i=0; i<nbCavities; i++)
+        {
+            pressure[i] = lambda[i];
+            volumeGrowth[i] = delta[i];
+        }
+    }
+
+    updateLimits();
+
+    Actuator<DataTypes>::storeResults(lambda, delta);
+}
+
+
+} // namespace
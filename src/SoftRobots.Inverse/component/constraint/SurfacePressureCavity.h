@@ -0,0 +1,144 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <sofa/core/topology/BaseMeshTopology.h>
+#include <sofa/defaulttype/VecTypes.h>
+#include <sofa/simulation/TaskScheduler.h>
+#include <sofa/type/vector.h>
+
+#include <SoftRobots.Inverse/component/config.h>
+
+namespace softrobotsinverse::constraint
+{
+
+/**
+ * Surface of one or several cavities of the same mesh, with index buffers precomputed once from their
+ * triangles and quads, so that the volumes of the cavities and their gradients are evaluated in a single
+ * pass over contiguous arrays. The positions of the points of all the cavities are gathered once per
+ * evaluation. The quads are split in two triangles. For each point of a cavity, the buffers list the two
+ * other corners of each triangle of the cavity around the point, in the order of the triangle:
+ *   - the gradient at the point p is the sum of the area-weighted normals (pa-p)x(pb-p)/6 of its triangles,
+ *   - the volume is the sum of p.(pa x pb)/18, each triangle being met once from each of its three corners.
+*/
+template< class DataTypes >
+class SurfacePressureCavity
+{
+public:
+    typedef typename DataTypes::VecCoord                  VecCoord;
+    typedef typename DataTypes::Coord                     Coord;
+    typedef typename DataTypes::Deriv                     Deriv;
+    typedef typename Coord::value_type                    Real;
+    typedef sofa::core::topology::BaseMeshTopology::Triangle Triangle;
+    typedef sofa::core::topology::BaseMeshTopology::Quad     Quad;
+
+    /// Builds the index buffers of one cavity, to be called on init and when the topology changes
+    void init(const sofa::type::vector<Triangle>& triangles,
+              const sofa::type::vector<Quad>& quads,
+              bool flipNormal);
+
+    /// Builds the index buffers of several cavities, the triangles and quads of the cavities being concatenated:
+    /// the cavity i has nbTriangles[i] triangles and nbQuads[i] quads
+    void init(const sofa::type::vector<Triangle>& triangles,
+              const sofa::type::vector<unsigned int>& nbTriangles,
+              const sofa::type::vector<Quad>& quads,
+              const sofa::type::vector<unsigned int>& nbQuads,
+              bool flipNormal);
+    void clear();
+
+    /// Evaluates the volumes and their gradients at each point of the cavities from the given positions.
+    /// With multithreading, the cavities (or the points of a single cavity) are evaluated concurrently.
+    void evaluate(const VecCoord& positions, bool multithreading = false);
+
+    /// Volume of a cavity only, without the gradient
+    Real computeVolume(const VecCoord& positions, unsigned int cavity = 0) const;
+
+    /// Volumes of all the cavities, from one gathering of the positions
+    void computeVolumes(const VecCoord& positions, sofa::type::vector<Real>& volumes);
+
+    unsigned int getNbCavities() const {return m_volumes.size();}
+
+    /// Points of the cavities, the entries of the cavity i being [getFirstEntry(i), getFirstEntry(i+1)).
+    /// The gradient of the last evaluation is given for each entry.
+    unsigned int getFirstEntry(unsigned int cavity) const {return m_firstEntry[cavity];}
+    const sofa::type::vector<unsigned int>& getPoints() const {return m_entryPoints;}
+    const sofa::type::vector<Deriv>& getGradient() const {return m_gradient;}
+    Real getVolume(unsigned int cavity = 0) const {return m_volumes[cavity];}
+    bool isEmpty() const {return m_points.empty();}
+
+protected:
+
+    sofa::type::vector<unsigned int> m_points;           // Points of all the cavities, each once
+    VecCoord                         m_localPositions;   // Positions of m_points, gathered contiguously
+
+    sofa::type::vector<unsigned int> m_firstEntry;       // Prefix sum, the entries of the cavity i are [m_firstEntry[i], m_firstEntry[i+1])
+    sofa::type::vector<unsigned int> m_entryPoints;      // Point of each entry
+    sofa::type::vector<unsigned int> m_entryLocalIds;    // Id of the point of each entry in m_points
+    sofa::type::vector<unsigned int> m_firstCorner;      // Prefix sum, the corners of the entry e are [m_firstCorner[e], m_firstCorner[e+1])
+    sofa::type::vector<unsigned int> m_otherCorners;     // Two ids in m_points per corner: the next corners of the triangle
+    sofa::type::vector<Deriv>        m_gradient;         // Gradient of the volume of its cavity at each entry
+    sofa::type::vector<Real>         m_volumes;
+
+    sofa::type::vector<Real>         m_chunkVolumes;
+    sofa::type::vector<unsigned int> m_chunkCavities;
+
+    /// Gradient and part of the volume of the entries [begin, end), from m_localPositions
+    Real evaluateChunk(unsigned int begin, unsigned int end);
+
+    class EvaluateChunkTask : public sofa::simulation::CpuTask
+    {
+    public:
+        EvaluateChunkTask(sofa::simulation::CpuTask::Status* status): CpuTask(status) {}
+        ~EvaluateChunkTask() override {}
+
+        MemoryAlloc run() final {
+            *volume = cavity->evaluateChunk(begin, end);
+            return MemoryAlloc::Stack;
+        }
+
+        void set(SurfacePressureCavity* _cavity, const unsigned int _begin, const unsigned int _end, Real* _volume){
+            cavity = _cavity;
+            begin = _begin;
+            end = _end;
+            volume = _volume;
+        }
+
+    private:
+        SurfacePressureCavity* cavity{nullptr};
+        unsigned int begin{0};
+        unsigned int end{0};
+        Real* volume{nullptr};
+    };
+};
+
+#if !defined(SOFTROBOTS_INVERSE_SURFACEPRESSURECAVITY_CPP)
+extern template class SOFA_SOFTROBOTS_INVERSE_API SurfacePressureCavity<sofa::defaulttype::Vec3Types>;
+#endif
+
+} // namespace
@@ -0,0 +1,278 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <SoftRobots.Inverse/component/constraint/SurfacePressureCavity.h>
+#include <sofa/simulation/MainTaskSchedulerFactory.h>
+#include <algorithm>
+
+namespace softrobotsinverse::constraint
+{
+
+using sofa::type::vector;
+
+
+template<class DataTypes>
+void SurfacePressureCavity<DataTypes>::clear()
+{
+    m_points.clear();
+    m_localPositions.clear();
+    m_firstEntry.clear();
+    m_entryPoints.clear();
+    m_entryLocalIds.clear();
+    m_firstCorner.clear();
+    m_otherCorners.clear();
+    m_gradient.clear();
+    m_volumes.clear();
+}
+
+
+template<class DataTypes>
+void SurfacePressureCavity<DataTypes>::init(const vector<Triangle>& triangles,
+                                            const vector<Quad>& quads,
+                                            bool flipNormal)
+{
+    init(triangles, vector<unsigned int>(1, triangles.size()), quads, vector<unsigned int>(1, quads.size()), flipNormal);
+}
+
+
+template<class DataTypes>
+void SurfacePressureCavity<DataTypes>::init(const vector<Triangle>& triangles,
+                                            const vector<unsigned int>& nbTriangles,
+                                            const vector<Quad>& quads,
+                                            const vector<unsigned int>& nbQuads,
+                                            bool flipNormal)
+{
+    clear();
+
+    const unsigned int nbCavities = std::min(nbTriangles.size(), nbQuads.size());
+    m_volumes.assign(nbCavities, 0.);
+    m_firstEntry.assign(nbCavities+1, 0);
+
+    // Ids of the points in m_points, in increasing order of their index in the mechanical state
+    unsigned int maxIndex = 0;
+    for(const Triangle& triangle : triangles)
+        for(unsigned int k=0; k<3; k++)
+            maxIndex = std::max(maxIndex, (unsigned int)triangle[k]);
+    for(const Quad& quad : quads)
+        for(unsigned int k=0; k<4; k++)
+            maxIndex = std::max(maxIndex, (unsigned int)quad[k]);
+
+    vector<int> localId(maxIndex+1, -1);
+    for(const Triangle& triangle : triangles)
+        for(unsigned int k=0; k<3; k++)
+            localId[triangle[k]] = 0;
+    for(const Quad& quad : quads)
+        for(unsigned int k=0; k<4; k++)
+            localId[quad[k]] = 0;
+    for(unsigned int i=0; i<localId.size(); i++)
+        if(localId[i]==0)
+        {
+            localId[i] = m_points.size();
+            m_points.push_back(i);
+        }
+    m_localPositions.resize(m_points.size());
+
+    vector<int> entryId(m_points.size(), -1);
+    vector<Triangle> surface;
+    vector<unsigned int> next;
+    unsigned int firstTriangle = 0, firstQuad = 0;
+    m_firstCorner.push_back(0);
+    for(unsigned int c=0; c<nbCavities; c++)
+    {
+        // The triangles of the cavity, the quads being split in (q0,q1,q2) and (q0,q2,q3)
+        surface.clear();
+        for(unsigned int i=firstTriangle; i<firstTriangle+nbTriangles[c] && i<triangles.size(); i++)
+            surface.push_back(triangles[i]);
+        for(unsigned int i=firstQuad; i<firstQuad+nbQuads[c] && i<quads.size(); i++)
+        {
+            surface.push_back(Triangle(quads[i][0], quads[i][1], quads[i][2]));
+            surface.push_back(Triangle(quads[i][0], quads[i][2], quads[i][3]));
+        }
+        firstTriangle += nbTriangles[c];
+        firstQuad += nbQuads[c];
+
+        // Entries of the points of the cavity, in increasing order of their index
+        const unsigned int firstEntry = m_entryLocalIds.size();
+        for(const Triangle& triangle : surface)
+            for(unsigned int k=0; k<3; k++)
+                entryId[localId[triangle[k]]] = 0;
+        for(unsigned int i=0; i<m_points.size(); i++)
+            if(entryId[i]==0)
+            {
+                entryId[i] = m_entryLocalIds.size();
+                m_entryLocalIds.push_back(i);
+                m_entryPoints.push_back(m_points[i]);
+            }
+        const unsigned int endEntry = m_entryLocalIds.size();
+        m_firstEntry[c+1] = endEntry;
+
+        // Corners sorted by entry, with a counting sort
+        m_firstCorner.resize(endEntry+1, 0);
+        for(const Triangle& triangle : surface)
+            for(unsigned int k=0; k<3; k++)
+                m_firstCorner[entryId[localId[triangle[k]]]+1]++;
+        for(unsigned int e=firstEntry; e<endEntry; e++)
+            m_firstCorner[e+1] += m_firstCorner[e];
+
+        next.assign(m_firstCorner.begin()+firstEntry, m_firstCorner.begin()+endEntry);
+        m_otherCorners.resize(2*m_firstCorner[endEntry]);
+        for(const Triangle& triangle : surface)
+        {
+            for(unsigned int k=0; k<3; k++)
+            {
+                unsigned int a = localId[triangle[(k+1)%3]];
+                unsigned int b = localId[triangle[(k+2)%3]];
+                if(flipNormal)
+                    std::swap(a, b);
+
+                const unsigned int corner = next[entryId[localId[triangle[k]]]-firstEntry]++;
+                m_otherCorners[2*corner] = a;
+                m_otherCorners[2*corner+1] = b;
+            }
+        }
+
+        for(unsigned int e=firstEntry; e<endEntry; e++)
+            entryId[m_entryLocalIds[e]] = -1;
+    }
+
+    m_gradient.resize(m_entryLocalIds.size());
+}
+
+
+template<class DataTypes>
+void SurfacePressureCavity<DataTypes>::evaluate(const VecCoord& positions, bool multithreading)
+{
+    // One pass over the positions for all the cavities
+    const unsigned int nbPoints = m_points.size();
+    for(unsigned int i=0; i<nbPoints; i++)
+        m_localPositions[i] = positions[m_points[i]];
+
+    const unsigned int nbCavities = getNbCavities();
+    sofa::simulation::TaskScheduler* taskScheduler = (multithreading)? sofa::simulation::MainTaskSchedulerFactory::createInRegistry() : nullptr;
+    const unsigned int nbThreads = (taskScheduler)? taskScheduler->getThreadCount() : 1;
+
+    // One chunk per cavity, or chunks of the points of a single cavity
+    m_chunkVolumes.clear();
+    m_chunkCavities.clear();
+    vector<unsigned int> chunkEntries(1, 0);
+    for(unsigned int c=0; c<nbCavities; c++)
+    {
+        const unsigned int nbEntries = m_firstEntry[c+1] - m_firstEntry[c];
+        const unsigned int nbChunks = (nbCavities == 1)? std::max(1u, std::min(nbEntries, nbThreads)) : 1;
+        for(unsigned int i=0; i<nbChunks; i++)
+        {
+            chunkEntries.push_back(m_firstEntry[c] + ((i+1)*nbEntries)/nbChunks);
+            m_chunkCavities.push_back(c);
+        }
+    }
+    m_chunkVolumes.assign(m_chunkCavities.size(), 0.);
+
+    if(taskScheduler && m_chunkCavities.size() > 1)
+    {
+        sofa::simulation::CpuTask::Status status;
+
+        vector<EvaluateChunkTask> tasks;
+        tasks.resize(m_chunkCavities.size(), EvaluateChunkTask(&status));
+        for(unsigned int i=0; i<tasks.size(); i++)
+        {
+            tasks[i].set(this, chunkEntries[i], chunkEntries[i+1], &m_chunkVolumes[i]);
+            taskScheduler->addTask(&tasks[i]);
+        }
+        taskScheduler->workUntilDone(&status);
+    }
+    else
+    {
+        for(unsigned int i=0; i<m_chunkCavities.size(); i++)
+            m_chunkVolumes[i] = evaluateChunk(chunkEntries[i], chunkEntries[i+1]);
+    }
+
+    m_volumes.assign(nbCavities, 0.);
+    for(unsigned int i=0; i<m_chunkCavities.size(); i++)
+        m_volumes[m_chunkCavities[i]] += m_chunkVolumes[i];
+}
+
+
+template<class DataTypes>
+typename SurfacePressureCavity<DataTypes>::Real SurfacePressureCavity<DataTypes>::evaluateChunk(unsigned int begin, unsigned int end)
+{
+    Real volume = 0.;
+    for(unsigned int e=begin; e<end; e++)
+    {
+        const Coord& p = m_localPositions[m_entryLocalIds[e]];
+        Deriv gradient;
+        for(unsigned int c=m_firstCorner[e]; c<m_firstCorner[e+1]; c++)
+        {
+            const Coord& pa = m_localPositions[m_otherCorners[2*c]];
+            const Coord& pb = m_localPositions[m_otherCorners[2*c+1]];
+            gradient += cross(pa-p, pb-p);
+            volume += p*cross(pa, pb);
+        }
+        m_gradient[e] = gradient/Real(6.);
+    }
+    return volume/Real(18.);
+}
+
+
+template<class DataTypes>
+typename SurfacePressureCavity<DataTypes>::Real SurfacePressureCavity<DataTypes>::computeVolume(const VecCoord& positions, unsigned int cavity) const
+{
+    Real volume = 0.;
+    for(unsigned int e=m_firstEntry[cavity]; e<m_firstEntry[cavity+1]; e++)
+    {
+        const Coord& p = positions[m_entryPoints[e]];
+        for(unsigned int c=m_firstCorner[e]; c<m_firstCorner[e+1]; c++)
+            volume += p*cross(positions[m_points[m_otherCorners[2*c]]], positions[m_points[m_otherCorners[2*c+1]]]);
+    }
+    return volume/Real(18.);
+}
+
+
+template<class DataTypes>
+void SurfacePressureCavity<DataTypes>::computeVolumes(const VecCoord& positions, vector<Real>& volumes)
+{
+    for(unsigned int i=0; i<m_points.size(); i++)
+        m_localPositions[i] = positions[m_points[i]];
+
+    const unsigned int nbCavities = getNbCavities();
+    volumes.assign(nbCavities, 0.);
+    for(unsigned int cavity=0; cavity<nbCavities; cavity++)
+    {
+        Real volume = 0.;
+        for(unsigned int e=m_firstEntry[cavity]; e<m_firstEntry[cavity+1]; e++)
+        {
+            const Coord& p = m_localPositions[m_entryLocalIds[e]];
+            for(unsigned int c=m_firstCorner[e]; c<m_firstCorner[e+1]; c++)
+                volume += p*cross(m_localPositions[m_otherCorners[2*c]], m_localPositions[m_otherCorners[2*c+1]]);
+        }
+        volumes[cavity] = volume/Real(18.);
+    }
+}
+
+} // namespace
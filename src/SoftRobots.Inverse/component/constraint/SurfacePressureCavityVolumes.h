@@ -0,0 +1,149 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <sofa/core/objectmodel/Data.h>
+#include <sofa/core/topology/BaseMeshTopology.h>
+#include <sofa/defaulttype/VecTypes.h>
+#include <sofa/simulation/TaskScheduler.h>
+#include <sofa/type/vector.h>
+
+#include <SoftRobots.Inverse/component/config.h>
+
+#include <memory>
+#include <mutex>
+
+namespace softrobotsinverse::constraint
+{
+
+/**
+ * Volumes of the cavities, shared by all the components referencing the same triangles and quads of the same
+ * mechanical state (actuators, sensors, equalities and effectors of a cavity), so that the volume of each cavity
+ * is computed once per change of the positions:
+ *   - the volume is recomputed only when the counter of the Data of the positions changed since the last query,
+ *   - the first query after a change updates all the cavities of the same mechanical state, concurrently with
+ *     multithreading, as they are queried in the same step,
+ *   - when only some points of a cavity moved, only the triangles around them are recomputed.
+ * The volume is the sum over the triangles (the quads being split in two) of p0.(p1 x p2)/6.
+*/
+template< class DataTypes >
+class SurfacePressureCavityVolumes
+{
+public:
+    typedef typename DataTypes::VecCoord                  VecCoord;
+    typedef typename DataTypes::Coord                     Coord;
+    typedef typename Coord::value_type                    Real;
+    typedef sofa::core::topology::BaseMeshTopology::Triangle Triangle;
+    typedef sofa::core::topology::BaseMeshTopology::Quad     Quad;
+
+    class Cavity
+    {
+    public:
+        Real getVolume() const {return m_volume;}
+        unsigned int getNbPoints() const {return m_points.size();}
+
+        /// Number of triangles recomputed by the last update
+        unsigned int getNbUpdatedTriangles() const {return m_nbUpdatedTriangles;}
+
+    protected:
+        friend class SurfacePressureCavityVolumes;
+
+        void init(const sofa::type::vector<Triangle>& triangles,
+                  const sofa::type::vector<Quad>& quads,
+                  bool flipNormal);
+        void update(const VecCoord& positions);
+        Real computeTriangle(unsigned int triangle) const;
+
+        const void*                      m_state{nullptr};
+        sofa::type::vector<Triangle>     m_surfaceTriangles; // Key of the cavity, with m_state, m_surfaceQuads and m_flipNormal
+        sofa::type::vector<Quad>         m_surfaceQuads;
+        bool                             m_flipNormal{false};
+
+        sofa::type::vector<unsigned int> m_points;           // Points of the cavity, each once
+        sofa::type::vector<unsigned int> m_triangles;        // Three ids in m_points per triangle
+        sofa::type::vector<unsigned int> m_firstTriangle;    // Prefix sum, the triangles of the point i are [m_firstTriangle[i], m_firstTriangle[i+1])
+        sofa::type::vector<unsigned int> m_pointTriangles;   // Triangles around each point
+        VecCoord                         m_positions;        // Positions of m_points at the last update
+        sofa::type::vector<Real>         m_contributions;    // Part of the volume of each triangle at the last update
+        sofa::type::vector<unsigned int> m_triangleStamps;   // Last update of each triangle
+        sofa::type::vector<unsigned int> m_movedPoints;
+        unsigned int                     m_stamp{0};
+        unsigned int                     m_nbIncrementalUpdates{0};
+        unsigned int                     m_nbUpdatedTriangles{0};
+        Real                             m_volume{0.};
+        bool                             m_isUpToDate{false};
+
+        const void*                      m_positionsData{nullptr};
+        int                              m_positionsCounter{-1};
+    };
+
+    /// Cavity of the given triangles and quads of a mechanical state, shared with the other components of the
+    /// same surface. It is created on the first request, and released with the last component holding it.
+    static std::shared_ptr<Cavity> getCavity(const void* state,
+                                             const sofa::type::vector<Triangle>& triangles,
+                                             const sofa::type::vector<Quad>& quads,
+                                             bool flipNormal);
+
+    /// Volume of the cavity at the given positions of its mechanical state
+    static Real getVolume(Cavity& cavity,
+                          const sofa::core::objectmodel::Data<VecCoord>& positions,
+                          bool multithreading = false);
+
+protected:
+
+    static std::mutex& getMutex();
+    static sofa::type::vector<std::weak_ptr<Cavity>>& getCavities();
+
+    class UpdateCavityTask : public sofa::simulation::CpuTask
+    {
+    public:
+        UpdateCavityTask(sofa::simulation::CpuTask::Status* status): CpuTask(status) {}
+        ~UpdateCavityTask() override {}
+
+        MemoryAlloc run() final {
+            cavity->update(*positions);
+            return MemoryAlloc::Stack;
+        }
+
+        void set(Cavity* _cavity, const VecCoord* _positions){
+            cavity = _cavity;
+            positions = _positions;
+        }
+
+    private:
+        Cavity* cavity{nullptr};
+        const VecCoord* positions{nullptr};
+    };
+};
+
+#if !defined(SOFTROBOTS_INVERSE_SURFACEPRESSURECAVITYVOLUMES_CPP)
+extern template class SOFA_SOFTROBOTS_INVERSE_API SurfacePressureCavityVolumes<sofa::defaulttype::Vec3Types>;
+#endif
+
+} // namespace
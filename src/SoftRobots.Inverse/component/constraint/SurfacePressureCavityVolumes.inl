@@ -0,0 +1,291 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <SoftRobots.Inverse/component/constraint/SurfacePressureCavityVolumes.h>
+#include <sofa/simulation/MainTaskSchedulerFactory.h>
+#include <algorithm>
+
+namespace softrobotsinverse::constraint
+{
+
+using sofa::type::vector;
+
+
+template<class DataTypes>
+void SurfacePressureCavityVolumes<DataTypes>::Cavity::init(const vector<Triangle>& triangles,
+                                                           const vector<Quad>& quads,
+                                                           bool flipNormal)
+{
+    m_surfaceTriangles = triangles;
+    m_surfaceQuads = quads;
+    m_flipNormal = flipNormal;
+
+    // The triangles of the cavity, the quads being split in (q0,q1,q2) and (q0,q2,q3)
+    vector<Triangle> surface(triangles.begin(), triangles.end());
+    for(const Quad& quad : quads)
+    {
+        surface.push_back(Triangle(quad[0], quad[1], quad[2]));
+        surface.push_back(Triangle(quad[0], quad[2], quad[3]));
+    }
+
+    // Ids of the points in m_points, in increasing order of their index in the mechanical state
+    unsigned int maxIndex = 0;
+    for(const Triangle& triangle : surface)
+        for(unsigned int k=0; k<3; k++)
+            maxIndex = std::max(maxIndex, (unsigned int)triangle[k]);
+
+    vector<int> localId(maxIndex+1, -1);
+    for(const Triangle& triangle : surface)
+        for(unsigned int k=0; k<3; k++)
+            localId[triangle[k]] = 0;
+    m_points.clear();
+    for(unsigned int i=0; i<localId.size(); i++)
+        if(localId[i]==0)
+        {
+            localId[i] = m_points.size();
+            m_points.push_back(i);
+        }
+
+    m_triangles.resize(3*surface.size());
+    for(unsigned int t=0; t<surface.size(); t++)
+    {
+        m_triangles[3*t] = localId[surface[t][0]];
+        m_triangles[3*t+1] = localId[surface[t][flipNormal? 2 : 1]];
+        m_triangles[3*t+2] = localId[surface[t][flipNormal? 1 : 2]];
+    }
+
+    // Triangles around each point, with a counting sort
+    m_firstTriangle.assign(m_points.size()+1, 0);
+    for(unsigned int id : m_triangles)
+        m_firstTriangle[id+1]++;
+    for(unsigned int i=0; i<m_points.size(); i++)
+        m_firstTriangle[i+1] += m_firstTriangle[i];
+
+    vector<unsigned int> next(m_firstTriangle.begin(), m_firstTriangle.end()-1);
+    m_pointTriangles.resize(m_triangles.size());
+    for(unsigned int c=0; c<m_triangles.size(); c++)
+        m_pointTriangles[next[m_triangles[c]]++] = c/3;
+
+    m_positions.resize(m_points.size());
+    m_contributions.assign(surface.size(), 0.);
+    m_triangleStamps.assign(surface.size(), 0);
+    m_stamp = 0;
+    m_nbIncrementalUpdates = 0;
+    m_nbUpdatedTriangles = 0;
+    m_volume = 0.;
+    m_isUpToDate = false;
+    m_positionsData = nullptr;
+    m_positionsCounter = -1;
+}
+
+
+template<class DataTypes>
+typename SurfacePressureCavityVolumes<DataTypes>::Real SurfacePressureCavityVolumes<DataTypes>::Cavity::computeTriangle(unsigned int triangle) const
+{
+    const Coord& p0 = m_positions[m_triangles[3*triangle]];
+    const Coord& p1 = m_positions[m_triangles[3*triangle+1]];
+    const Coord& p2 = m_positions[m_triangles[3*triangle+2]];
+    return p0*cross(p1, p2)/Real(6.);
+}
+
+
+template<class DataTypes>
+void SurfacePressureCavityVolumes<DataTypes>::Cavity::update(const VecCoord& positions)
+{
+    // The incremental updates accumulate the variations of the contributions: the volume is summed again
+    // from all the contributions once in a while, to bound the round-off errors
+    const unsigned int maxIncrementalUpdates = 100;
+    const unsigned int nbPoints = m_points.size();
+    const unsigned int nbTriangles = m_contributions.size();
+
+    if(!m_isUpToDate || m_nbIncrementalUpdates >= maxIncrementalUpdates)
+    {
+        for(unsigned int i=0; i<nbPoints; i++)
+            m_positions[i] = positions[m_points[i]];
+
+        m_volume = 0.;
+        for(unsigned int t=0; t<nbTriangles; t++)
+        {
+            m_contributions[t] = computeTriangle(t);
+            m_volume += m_contributions[t];
+        }
+        m_isUpToDate = true;
+        m_nbIncrementalUpdates = 0;
+        m_nbUpdatedTriangles = nbTriangles;
+        return;
+    }
+
+    // Only the triangles around the points that moved. Past a quarter of the points, all the triangles are
+    // recomputed instead.
+    m_movedPoints.clear();
+    for(unsigned int i=0; i<nbPoints; i++)
+    {
+        const Coord& position = positions[m_points[i]];
+        if(position == m_positions[i])
+            continue;
+
+        m_positions[i] = position;
+        m_movedPoints.push_back(i);
+        if(4*m_movedPoints.size() > nbPoints)
+        {
+            m_isUpToDate = false;
+            update(positions);
+            return;
+        }
+    }
+
+    m_stamp++;
+    m_nbUpdatedTriangles = 0;
+    Real variation = 0.;
+    for(unsigned int i : m_movedPoints)
+    {
+        for(unsigned int j=m_firstTriangle[i]; j<m_firstTriangle[i+1]; j++)
+        {
+            const unsigned int t = m_pointTriangles[j];
+            if(m_triangleStamps[t] == m_stamp)
+                continue;
+            m_triangleStamps[t] = m_stamp;
+            m_nbUpdatedTriangles++;
+
+            const Real contribution = computeTriangle(t);
+            variation += contribution - m_contributions[t];
+            m_contributions[t] = contribution;
+        }
+    }
+
+    if(!m_movedPoints.empty())
+    {
+        m_volume += variation;
+        m_nbIncrementalUpdates++;
+    }
+}
+
+
+template<class DataTypes>
+std::mutex& SurfacePressureCavityVolumes<DataTypes>::getMutex()
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+
+template<class DataTypes>
+vector<std::weak_ptr<typename SurfacePressureCavityVolumes<DataTypes>::Cavity>>& SurfacePressureCavityVolumes<DataTypes>::getCavities()
+{
+    static vector<std::weak_ptr<Cavity>> cavities;
+    return cavities;
+}
+
+
+template<class DataTypes>
+std::shared_ptr<typename SurfacePressureCavityVolumes<DataTypes>::Cavity> SurfacePressureCavityVolumes<DataTypes>::getCavity(const void* state,
+                                                                                                                          const vector<Triangle>& triangles,
+                                                                                                                          const vector<Quad>& quads,
+                                                                                                                          bool flipNormal)
+{
+    std::lock_guard<std::mutex> lock(getMutex());
+
+    vector<std::weak_ptr<Cavity>>& cavities = getCavities();
+    cavities.erase(std::remove_if(cavities.begin(), cavities.end(),
+                                  [](const std::weak_ptr<Cavity>& cavity){ return cavity.expired(); }),
+                   cavities.end());
+
+    for(const std::weak_ptr<Cavity>& weakCavity : cavities)
+    {
+        std::shared_ptr<Cavity> cavity = weakCavity.lock();
+        if(cavity && cavity->m_state == state && cavity->m_flipNormal == flipNormal &&
+           cavity->m_surfaceTriangles == triangles && cavity->m_surfaceQuads == quads)
+            return cavity;
+    }
+
+    std::shared_ptr<Cavity> cavity = std::make_shared<Cavity>();
+    cavity->m_state = state;
+    cavity->init(triangles, quads, flipNormal);
+    cavities.push_back(cavity);
+    return cavity;
+}
+
+
+template<class DataTypes>
+typename SurfacePressureCavityVolumes<DataTypes>::Real SurfacePressureCavityVolumes<DataTypes>::getVolume(Cavity& cavity,
+                                                                                                         const sofa::core::objectmodel::Data<VecCoord>& positions,
+                                                                                                         bool multithreading)
+{
+    std::lock_guard<std::mutex> lock(getMutex());
+
+    const int counter = positions.getCounter();
+    if(cavity.m_positionsData == &positions && cavity.m_positionsCounter == counter)
+        return cavity.m_volume;
+
+    // The cavities of the same mechanical state whose positions changed
+    vector<std::shared_ptr<Cavity>> staleCavities;
+    for(const std::weak_ptr<Cavity>& weakCavity : getCavities())
+    {
+        std::shared_ptr<Cavity> other = weakCavity.lock();
+        if(other && other.get() != &cavity && other->m_state == cavity.m_state &&
+           (other->m_positionsData != &positions || other->m_positionsCounter != counter))
+            staleCavities.push_back(other);
+    }
+
+    const VecCoord& x = positions.getValue();
+    sofa::simulation::TaskScheduler* taskScheduler = (multithreading && !staleCavities.empty())? sofa::simulation::MainTaskSchedulerFactory::createInRegistry() : nullptr;
+    if(taskScheduler)
+    {
+        sofa::simulation::CpuTask::Status status;
+
+        vector<UpdateCavityTask> tasks;
+        tasks.resize(staleCavities.size(), UpdateCavityTask(&status));
+        for(unsigned int i=0; i<tasks.size(); i++)
+        {
+            tasks[i].set(staleCavities[i].get(), &x);
+            taskScheduler->addTask(&tasks[i]);
+        }
+        cavity.update(x);
+        taskScheduler->workUntilDone(&status);
+    }
+    else
+    {
+        cavity.update(x);
+        for(const std::shared_ptr<Cavity>& other : staleCavities)
+            other->update(x);
+    }
+
+    cavity.m_positionsData = &positions;
+    cavity.m_positionsCounter = counter;
+    for(const std::shared_ptr<Cavity>& other : staleCavities)
+    {
+        other->m_positionsData = &positions;
+        other->m_positionsCounter = counter;
+    }
+
+    return cavity.m_volume;
+}
+
+} // namespace
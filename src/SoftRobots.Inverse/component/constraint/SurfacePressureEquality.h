@@ -30,6 +30,8 @@
 
 #include <SoftRobots/component/constraint/model/SurfacePressureModel.h>
 #include <SoftRobots.Inverse/component/behavior/Equality.h>
+#include <SoftRobots.Inverse/component/constraint/SurfacePressureCavity.h>
+#include <SoftRobots.Inverse/component/constraint/SurfacePressureCavityVolumes.h>
 
 #include <SoftRobots.Inverse/component/config.h>
 
@@ -54,6 +56,11 @@ public:
     typedef typename DataTypes::Coord                       Coord;
     typedef typename Coord::value_type                      Real;
     typedef typename sofa::core::behavior::MechanicalState<DataTypes> MechanicalState;
+    typedef typename DataTypes::VecCoord                    VecCoord;
+    typedef typename DataTypes::MatrixDeriv                 MatrixDeriv;
+    typedef typename DataTypes::MatrixDeriv::RowIterator    MatrixDerivRowIterator;
+    typedef sofa::core::objectmodel::Data<VecCoord>         DataVecCoord;
+    typedef sofa::core::objectmodel::Data<MatrixDeriv>      DataMatrixDeriv;
 
 public:
     SurfacePressureEquality(MechanicalState* object = nullptr);
@@ -66,6 +73,15 @@ public:
     /////////////////////////////////////////////////////////////
 
     ////////////////////////// Inherited from BaseConstraint ////////////////
+    void buildConstraintMatrix(const ConstraintParams* cParams,
+                               DataMatrixDeriv &cMatrix,
+                               unsigned int &cIndex,
+                               const DataVecCoord &x) override;
+
+    void getConstraintViolation(const ConstraintParams* cParams,
+                                BaseVector *resV,
+                                const BaseVector *Jdx) override;
+
     void storeLambda(const ConstraintParams* cParams,
                      sofa::core::MultiVecDerivId res,
                      const BaseVector* lambda) override;
@@ -73,6 +89,12 @@ public:
 
 protected:
 
+    sofa::Data<bool> d_precomputeCavity;
+    sofa::Data<bool> d_multithreading;
+
+    SurfacePressureCavity<DataTypes> m_cavity;
+    std::shared_ptr<typename SurfacePressureCavityVolumes<DataTypes>::Cavity> m_sharedCavity; // Volume shared with the components of the same surface
+
     ////////////////////////// Inherited attributes ////////////////////////////
     using Equality<DataTypes>::m_state ;
     using softrobots::constraint::SurfacePressureModel<DataTypes>::d_cavityVolume ;
@@ -86,11 +108,15 @@ protected:
     using softrobots::constraint::SurfacePressureModel<DataTypes>::d_volumeGrowth ;
     using softrobots::constraint::SurfacePressureModel<DataTypes>::d_eqVolumeGrowth ;
     using softrobots::constraint::SurfacePressureModel<DataTypes>::d_maxVolumeGrowthVariation ;
+    using softrobots::constraint::SurfacePressureModel<DataTypes>::d_triangles;
+    using softrobots::constraint::SurfacePressureModel<DataTypes>::d_quads;
+    using softrobots::constraint::SurfacePressureModel<DataTypes>::d_flipNormal;
     using softrobots::constraint::SurfacePressureModel<DataTypes>::m_constraintId;
     ////////////////////////////////////////////////////////////////////////////
 
 private:
     void updateConstraint();
+    void initCavity();
 
     ////////////////////////// Inherited attributes ////////////////////////////
     using Equality<DataTypes>::m_hasDeltaEqual ;
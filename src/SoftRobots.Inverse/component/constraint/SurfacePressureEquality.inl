@@ -29,6 +29,7 @@
 #pragma once
 
 #include <SoftRobots.Inverse/component/constraint/SurfacePressureEquality.h>
+#include <sofa/simulation/MainTaskSchedulerFactory.h>
 
 namespace softrobotsinverse::constraint
 {
@@ -41,6 +42,17 @@ template<class DataTypes>
 SurfacePressureEquality<DataTypes>::SurfacePressureEquality(MechanicalState* object)
     : Equality<DataTypes>(object)
     , softrobots::constraint::SurfacePressureModel<DataTypes>(object)
+    , d_precomputeCavity(initData(&d_precomputeCavity, false, "precomputeCavity",
+                                  "If true, the index buffers of the cavity surface are built on init, and the volume \n"
+                                  "and its gradient are evaluated in a single pass over them. Recommended for cavities \n"
+                                  "with many triangles. The volume is computed once for all the components of the same \n"
+                                  "surface (see SurfacePressureCavityVolumes). Call reinit() after a change of the triangles \n"
+                                  "or quads. \n"
+                                  "Default value is false."))
+    , d_multithreading(initData(&d_multithreading, false, "multithreading",
+                                "Evaluate the points of the cavity, and the volumes of the other cavities of the same \n"
+                                "mechanical state, concurrently, when precomputeCavity is true. \n"
+                                "Default value is false."))
 {
     d_maxVolumeGrowthVariation.setDisplayed(false);
     d_maxVolumeGrowth.setDisplayed(false);
@@ -63,12 +75,14 @@ void SurfacePressureEquality<DataTypes>::init()
 {
     softrobots::constraint::SurfacePressureModel<DataTypes>::init();
     updateConstraint();
+    initCavity();
 }
 
 template<class DataTypes>
 void SurfacePressureEquality<DataTypes>::reinit()
 {
     updateConstraint();
+    initCavity();
 }
 
 template<class DataTypes>
@@ -79,6 +93,21 @@ void SurfacePressureEquality<DataTypes>::reset()
     d_pressure.setValue(0.0);
 
     updateConstraint();
+    initCavity();
+}
+
+template<class DataTypes>
+void SurfacePressureEquality<DataTypes>::initCavity()
+{
+    m_cavity.clear();
+    m_sharedCavity.reset();
+    if(!d_precomputeCavity.getValue())
+        return;
+
+    m_cavity.init(d_triangles.getValue(), d_quads.getValue(), d_flipNormal.getValue());
+    m_sharedCavity = SurfacePressureCavityVolumes<DataTypes>::getCavity(m_state, d_triangles.getValue(), d_quads.getValue(), d_flipNormal.getValue());
+    if(d_multithreading.getValue())
+        sofa::simulation::MainTaskSchedulerFactory::createInRegistry()->init();
 }
 
 template<class DataTypes>
@@ -100,6 +129,54 @@ void SurfacePressureEquality<DataTypes>::updateConstraint()
     }
 }
 
+template<class DataTypes>
+void SurfacePressureEquality<DataTypes>::buildConstraintMatrix(const ConstraintParams* cParams,
+                                                               DataMatrixDeriv &cMatrix,
+                                                               unsigned int &cIndex,
+                                                               const DataVecCoord &x)
+{
+    if(!d_precomputeCavity.getValue())
+    {
+        softrobots::constraint::SurfacePressureModel<DataTypes>::buildConstraintMatrix(cParams, cMatrix, cIndex, x);
+        return;
+    }
+
+    m_constraintId = cIndex;
+
+    MatrixDeriv& matrix = *cMatrix.beginEdit();
+    MatrixDerivRowIterator rowIterator = matrix.writeLine(m_constraintId);
+
+    m_cavity.evaluate(x.getValue(), d_multithreading.getValue());
+    const vector<unsigned int>& points = m_cavity.getPoints();
+    const auto& gradient = m_cavity.getGradient();
+    for(unsigned int i=0; i<points.size(); i++)
+        rowIterator.setCol(points[i], gradient[i]);
+
+    cIndex++;
+    cMatrix.endEdit();
+    m_nbLines = cIndex - m_constraintId;
+}
+
+template<class DataTypes>
+void SurfacePressureEquality<DataTypes>::getConstraintViolation(const ConstraintParams* cParams,
+                                                                BaseVector *resV,
+                                                                const BaseVector *Jdx)
+{
+    if(!d_precomputeCavity.getValue())
+    {
+        softrobots::constraint::SurfacePressureModel<DataTypes>::getConstraintViolation(cParams, resV, Jdx);
+        return;
+    }
+
+    d_cavityVolume.setValue(SurfacePressureCavityVolumes<DataTypes>::getVolume(*m_sharedCavity,
+                                                                               *m_state->read(sofa::core::ConstVecCoordId::position()),
+                                                                               d_multithreading.getValue()));
+    Real dfree = d_cavityVolume.getValue() - d_initialCavityVolume.getValue();
+    if(Jdx->size()!=0)
+        dfree += Jdx->element(0);
+    resV->set(m_constraintId, dfree);
+}
+
 template<class DataTypes>
 void SurfacePressureEquality<DataTypes>::storeLambda(const ConstraintParams* cParams,
                                                      sofa::core::MultiVecDerivId res,
@@ -29,7 +29,10 @@
 #pragma once
 
 #include <SoftRobots.Inverse/component/behavior/Sensor.h>
+#include <SoftRobots.Inverse/component/behavior/ConcurrentResults.h>
 #include <SoftRobots/component/constraint/model/SurfacePressureModel.h>
+#include <SoftRobots.Inverse/component/constraint/SurfacePressureCavity.h>
+#include <SoftRobots.Inverse/component/constraint/SurfacePressureCavityVolumes.h>
 #include <sofa/core/behavior/ConstraintResolution.h>
 
 namespace softrobotsinverse::constraint
@@ -39,6 +42,7 @@ using softrobotsinverse::behavior::Sensor;
 using sofa::helper::ReadAccessor;
 using sofa::core::VecCoordId;
 using sofa::core::ConstraintParams;
+using sofa::linearalgebra::BaseVector;
 
 using sofa::core::behavior::ConstraintResolution ;
 
@@ -62,20 +66,43 @@ void resolution(int line, double** w, double* d, double* lambda, double* dfree);
 };
 
 template< class DataTypes >
-class SurfacePressureSensor : public Sensor<DataTypes> , public softrobots::constraint::SurfacePressureModel<DataTypes>
+class SurfacePressureSensor : public Sensor<DataTypes> , public softrobots::constraint::SurfacePressureModel<DataTypes> , public softrobotsinverse::behavior::ConcurrentResults
 {
 public:
     SOFA_CLASS(SOFA_TEMPLATE(SurfacePressureSensor,DataTypes), SOFA_TEMPLATE(Sensor,DataTypes));
 
     typedef typename sofa::core::behavior::MechanicalState<DataTypes> MechanicalState;
+    typedef typename DataTypes::Coord                       Coord;
+    typedef typename Coord::value_type                      Real;
+    typedef typename DataTypes::VecCoord                    VecCoord;
+    typedef typename DataTypes::MatrixDeriv                 MatrixDeriv;
+    typedef typename DataTypes::MatrixDeriv::RowIterator    MatrixDerivRowIterator;
+    typedef sofa::core::objectmodel::Data<VecCoord>         DataVecCoord;
+    typedef sofa::core::objectmodel::Data<MatrixDeriv>      DataMatrixDeriv;
 
 public:    
     SurfacePressureSensor(MechanicalState* object = nullptr);
     ~SurfacePressureSensor() override;
 
+    /////////////// Inherited from BaseObject ////////////////////
+    void init() override;
+    void reinit() override;
+    /////////////////////////////////////////////////////////////
+
     void getConstraintResolution(std::vector<ConstraintResolution*>& resTab,
                                  unsigned int& offset) override;
 
+    ////////////////////////// Inherited from BaseConstraint ////////////////
+    void buildConstraintMatrix(const ConstraintParams* cParams,
+                               DataMatrixDeriv &cMatrix,
+                               unsigned int &cIndex,
+                               const DataVecCoord &x) override;
+
+    void getConstraintViolation(const ConstraintParams* cParams,
+                                BaseVector *resV,
+                                const BaseVector *Jdx) override;
+    /////////////////////////////////////////////////////////////////////////
+
     ////////////////////////// Inherited attributes ////////////////////////////
     using softrobots::constraint::SurfacePressureModel<DataTypes>::d_eqPressure;
     using softrobots::constraint::SurfacePressureModel<DataTypes>::d_eqVolumeGrowth;
@@ -87,6 +114,27 @@ public:
     using softrobots::constraint::SurfacePressureModel<DataTypes>::d_maxVolumeGrowthVariation;
     ////////////////////////////////////////////////////////////////////////////
 
+protected:
+
+    sofa::Data<bool> d_precomputeCavity;
+    sofa::Data<bool> d_multithreading;
+
+    SurfacePressureCavity<DataTypes> m_cavity;
+    std::shared_ptr<typename SurfacePressureCavityVolumes<DataTypes>::Cavity> m_sharedCavity; // Volume shared with the components of the same surface
+
+    void initCavity();
+
+    ////////////////////////// Inherited attributes ////////////////////////////
+    using Sensor<DataTypes>::m_state ;
+    using softrobots::constraint::SurfacePressureModel<DataTypes>::d_cavityVolume ;
+    using softrobots::constraint::SurfacePressureModel<DataTypes>::d_initialCavityVolume;
+    using softrobots::constraint::SurfacePressureModel<DataTypes>::d_triangles;
+    using softrobots::constraint::SurfacePressureModel<DataTypes>::d_quads;
+    using softrobots::constraint::SurfacePressureModel<DataTypes>::d_flipNormal;
+    using softrobots::constraint::SurfacePressureModel<DataTypes>::m_constraintId;
+    using Sensor<DataTypes>::m_nbLines ;
+    ////////////////////////////////////////////////////////////////////////////
+
 };
 
 #if !defined(SOFTROBOTS_INVERSE_SURFACEPRESSURESENSOR_CPP)
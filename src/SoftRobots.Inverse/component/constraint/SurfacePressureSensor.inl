@@ -30,6 +30,7 @@
 #include <sofa/core/visual/VisualParams.h>
 
 #include <SoftRobots.Inverse/component/constraint/SurfacePressureSensor.h>
+#include <sofa/simulation/MainTaskSchedulerFactory.h>
 
 namespace softrobotsinverse::constraint
 {
@@ -65,6 +66,17 @@ template<class DataTypes>
 SurfacePressureSensor<DataTypes>::SurfacePressureSensor(MechanicalState* object)
     : Sensor<DataTypes>(object)
     , softrobots::constraint::SurfacePressureModel<DataTypes>(object)
+    , d_precomputeCavity(initData(&d_precomputeCavity, false, "precomputeCavity",
+                                  "If true, the index buffers of the cavity surface are built on init, and the volume \n"
+                                  "and its gradient are evaluated in a single pass over them. Recommended for cavities \n"
+                                  "with many triangles. The volume is computed once for all the components of the same \n"
+                                  "surface (see SurfacePressureCavityVolumes). Call reinit() after a change of the triangles \n"
+                                  "or quads. \n"
+                                  "Default value is false."))
+    , d_multithreading(initData(&d_multithreading, false, "multithreading",
+                                "Evaluate the points of the cavity, and the volumes of the other cavities of the same \n"
+                                "mechanical state, concurrently, when precomputeCavity is true. \n"
+                                "Default value is false."))
 {
     // These datas from SurfacePressureModel have no sense for sensor
     d_eqPressure.setDisplayed(false);
@@ -82,6 +94,34 @@ SurfacePressureSensor<DataTypes>::~SurfacePressureSensor()
 {
 }
 
+template<class DataTypes>
+void SurfacePressureSensor<DataTypes>::init()
+{
+    softrobots::constraint::SurfacePressureModel<DataTypes>::init();
+    initCavity();
+}
+
+template<class DataTypes>
+void SurfacePressureSensor<DataTypes>::reinit()
+{
+    softrobots::constraint::SurfacePressureModel<DataTypes>::reinit();
+    initCavity();
+}
+
+template<class DataTypes>
+void SurfacePressureSensor<DataTypes>::initCavity()
+{
+    m_cavity.clear();
+    m_sharedCavity.reset();
+    if(!d_precomputeCavity.getValue())
+        return;
+
+    m_cavity.init(d_triangles.getValue(), d_quads.getValue(), d_flipNormal.getValue());
+    m_sharedCavity = SurfacePressureCavityVolumes<DataTypes>::getCavity(m_state, d_triangles.getValue(), d_quads.getValue(), d_flipNormal.getValue());
+    if(d_multithreading.getValue())
+        sofa::simulation::MainTaskSchedulerFactory::createInRegistry()->init();
+}
+
 template<class DataTypes>
 void SurfacePressureSensor<DataTypes>::getConstraintResolution(std::vector<ConstraintResolution*>& resTab,unsigned int& offset)
 {
@@ -89,6 +129,54 @@ void SurfacePressureSensor<DataTypes>::getConstraintResolution(std::vector<Const
     resTab[offset++] = cr;
 }
 
+template<class DataTypes>
+void SurfacePressureSensor<DataTypes>::buildConstraintMatrix(const ConstraintParams* cParams,
+                                                             DataMatrixDeriv &cMatrix,
+                                                             unsigned int &cIndex,
+                                                             const DataVecCoord &x)
+{
+    if(!d_precomputeCavity.getValue())
+    {
+        softrobots::constraint::SurfacePressureModel<DataTypes>::buildConstraintMatrix(cParams, cMatrix, cIndex, x);
+        return;
+    }
+
+    m_constraintId = cIndex;
+
+    MatrixDeriv& matrix = *cMatrix.beginEdit();
+    MatrixDerivRowIterator rowIterator = matrix.writeLine(m_constraintId);
+
+    m_cavity.evaluate(x.getValue(), d_multithreading.getValue());
+    const vector<unsigned int>& points = m_cavity.getPoints();
+    const auto& gradient = m_cavity.getGradient();
+    for(unsigned int i=0; i<points.size(); i++)
+        rowIterator.setCol(points[i], gradient[i]);
+
+    cIndex++;
+    cMatrix.endEdit();
+    m_nbLines = cIndex - m_constraintId;
+}
+
+template<class DataTypes>
+void SurfacePressureSensor<DataTypes>::getConstraintViolation(const ConstraintParams* cParams,
+                                                              BaseVector *resV,
+                                                              const BaseVector *Jdx)
+{
+    if(!d_precomputeCavity.getValue())
+    {
+        softrobots::constraint::SurfacePressureModel<DataTypes>::getConstraintViolation(cParams, resV, Jdx);
+        return;
+    }
+
+    d_cavityVolume.setValue(SurfacePressureCavityVolumes<DataTypes>::getVolume(*m_sharedCavity,
+                                                                               *m_state->read(sofa::core::ConstVecCoordId::position()),
+                                                                               d_multithreading.getValue()));
+    Real dfree = d_cavityVolume.getValue() - d_initialCavityVolume.getValue();
+    if(Jdx->size()!=0)
+        dfree += Jdx->element(0);
+    resV->set(m_constraintId, dfree);
+}
+
 
 } // namespace
 
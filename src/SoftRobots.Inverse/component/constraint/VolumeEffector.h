@@ -29,7 +29,9 @@
 #pragma once
 
 #include <SoftRobots.Inverse/component/behavior/Effector.h>
+#include <SoftRobots.Inverse/component/behavior/ConcurrentResults.h>
 #include <SoftRobots/component/constraint/model/SurfacePressureModel.h>
+#include <SoftRobots.Inverse/component/constraint/SurfacePressureCavityVolumes.h>
 
 
 namespace softrobotsinverse::constraint
@@ -46,7 +48,7 @@ using sofa::core::ConstraintParams;
  * https://softrobotscomponents.readthedocs.io
 */
 template< class DataTypes >
-class VolumeEffector : public Effector<DataTypes> , public softrobots::constraint::SurfacePressureModel<DataTypes>
+class VolumeEffector : public Effector<DataTypes> , public softrobots::constraint::SurfacePressureModel<DataTypes> , public softrobotsinverse::behavior::ConcurrentResults
 {
 public:
     SOFA_CLASS(SOFA_TEMPLATE(VolumeEffector,DataTypes), SOFA_TEMPLATE(Effector,DataTypes));
@@ -65,6 +67,7 @@ public:
 
     ////////////////////////// Inherited from BaseObject ////////////////////
     void init() override;
+    void reinit() override;
     /////////////////////////////////////////////////////////////////////////
 
     //////////////// Inherited from SoftRobotsConstraint ///////////////
@@ -79,6 +82,9 @@ public:
     using softrobots::constraint::SurfacePressureModel<DataTypes>::m_state ;
     using softrobots::constraint::SurfacePressureModel<DataTypes>::d_initialCavityVolume ;
     using softrobots::constraint::SurfacePressureModel<DataTypes>::getCavityVolume;
+    using softrobots::constraint::SurfacePressureModel<DataTypes>::d_triangles;
+    using softrobots::constraint::SurfacePressureModel<DataTypes>::d_quads;
+    using softrobots::constraint::SurfacePressureModel<DataTypes>::d_flipNormal;
 
     using softrobots::constraint::SurfacePressureModel<DataTypes>::d_eqPressure;
     using softrobots::constraint::SurfacePressureModel<DataTypes>::d_eqVolumeGrowth;
@@ -100,6 +106,12 @@ public:
 protected:
 
     sofa::Data<Real> d_desiredVolume;
+    sofa::Data<bool> d_precomputeCavity;
+    sofa::Data<bool> d_multithreading;
+
+    std::shared_ptr<typename SurfacePressureCavityVolumes<DataTypes>::Cavity> m_sharedCavity; // Volume shared with the components of the same surface
+
+    void initCavity();
 
 };
 
@@ -31,6 +31,7 @@
 #include <sofa/core/visual/VisualParams.h>
 
 #include <SoftRobots.Inverse/component/constraint/VolumeEffector.h>
+#include <sofa/simulation/MainTaskSchedulerFactory.h>
 
 namespace softrobotsinverse::constraint
 {
@@ -43,6 +44,15 @@ VolumeEffector<DataTypes>::VolumeEffector(MechanicalState* object)
     : Effector<DataTypes>(object)
     , softrobots::constraint::SurfacePressureModel<DataTypes>(object)
     , d_desiredVolume(initData(&d_desiredVolume, "desiredVolume",""))
+    , d_precomputeCavity(initData(&d_precomputeCavity, false, "precomputeCavity",
+                                  "If true, the volume of the cavity is computed once for all the components of the same \n"
+                                  "surface (see SurfacePressureCavityVolumes), and only around the points that moved. \n"
+                                  "Call reinit() after a change of the triangles or quads. \n"
+                                  "Default value is false."))
+    , d_multithreading(initData(&d_multithreading, false, "multithreading",
+                                "Evaluate the volumes of the other cavities of the same mechanical state concurrently, \n"
+                                "when precomputeCavity is true. \n"
+                                "Default value is false."))
 {
     // These datas from SurfacePressureModel have no sense for effector
     d_maxPressure.setDisplayed(false);
@@ -67,6 +77,26 @@ void VolumeEffector<DataTypes>::init()
     softrobots::constraint::SurfacePressureModel<DataTypes>::init();
     if (!d_desiredVolume.isSet())
         d_desiredVolume.setValue(d_initialCavityVolume.getValue()); //set the desired volume to the actual value as a sensible initial state
+    initCavity();
+}
+
+template<class DataTypes>
+void VolumeEffector<DataTypes>::reinit()
+{
+    softrobots::constraint::SurfacePressureModel<DataTypes>::reinit();
+    initCavity();
+}
+
+template<class DataTypes>
+void VolumeEffector<DataTypes>::initCavity()
+{
+    m_sharedCavity.reset();
+    if(!d_precomputeCavity.getValue())
+        return;
+
+    m_sharedCavity = SurfacePressureCavityVolumes<DataTypes>::getCavity(m_state, d_triangles.getValue(), d_quads.getValue(), d_flipNormal.getValue());
+    if(d_multithreading.getValue())
+        sofa::simulation::MainTaskSchedulerFactory::createInRegistry()->init();
 }
 
 template<class DataTypes>
@@ -76,7 +106,12 @@ void VolumeEffector<DataTypes>::getConstraintViolation(const ConstraintParams* c
 {
     SOFA_UNUSED(cParams);
 
-    d_cavityVolume.setValue(getCavityVolume(m_state->readPositions().ref()));
+    if(m_sharedCavity)
+        d_cavityVolume.setValue(SurfacePressureCavityVolumes<DataTypes>::getVolume(*m_sharedCavity,
+                                                                                   *m_state->read(sofa::core::ConstVecCoordId::position()),
+                                                                                   d_multithreading.getValue()));
+    else
+        d_cavityVolume.setValue(getCavityVolume(m_state->readPositions().ref()));
     Real desiredVolume = getTarget(d_desiredVolume.getValue(), d_cavityVolume.getValue());
     Real dfree = Jdx->element(0) + d_cavityVolume.getValue() - desiredVolume;
     resV->set(m_constraintId, dfree);
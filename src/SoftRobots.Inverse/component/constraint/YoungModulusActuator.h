@@ -97,12 +97,16 @@ public:
                       type::vector<double> &delta) override;
     /////////////////////////////////////////////////////////////////////
 
+    /// Number of evaluations of the internal force normalized by the Young modulus, see forceUpdateThreshold
+    unsigned int getNbForceEvaluations() const {return m_nbForceEvaluations;}
+
 protected:
 
     Data<Real> d_minYoung;
     Data<Real> d_maxYoung;
     Data<Real> d_maxYoungVariationRatio;
     Data<bool> d_hasVolumeOptimization;
+    Data<Real> d_forceUpdateThreshold;
 
     double m_previousYoungValue;
     Real   m_previousVolumeValue;
@@ -116,11 +120,21 @@ protected:
 
     TetrahedronFEMForceField< DataTypes > * m_tetraForceField;
 
+    // Internal force normalized by the Young modulus (its derivative with respect to the Young modulus,
+    // as the force of the FEM is linear in it), and the positions it was evaluated at
+    VecDeriv     m_normalizedForce;
+    VecCoord     m_normalizedForcePositions;
+    DataVecDeriv m_force;
+    DataVecDeriv m_velocity;
+    unsigned int m_nbForceEvaluations{0};
+
 
 private:
     void initLimit();
     void updateLimit();
     void getForce(VecDeriv& force, const DataVecCoord &x);
+    void updateNormalizedForce(const DataVecCoord &x);
+    bool isNormalizedForceValid(const VecCoord& x) const;
 
     ////////////////////////// Inherited attributes ////////////////////////////
     /// https://gcc.gnu.org/onlinedocs/gcc/Name-lookup.html
@@ -53,6 +53,12 @@ YoungModulusActuator<DataTypes>::YoungModulusActuator(MechanicalState* object)
     , d_maxYoungVariationRatio(initData(&d_maxYoungVariationRatio, (Real)1.0e1, "maxYoungVariationRatio",
                                         "Maximum variation of young / its actual value. \n"
                                         "If unspecified default value 1.0e1."))
+
+    , d_forceUpdateThreshold(initData(&d_forceUpdateThreshold, (Real)0.0, "forceUpdateThreshold",
+                                      "If positive, the internal force normalized by the Young modulus \n"
+                                      "is kept between steps and only evaluated again when a position \n"
+                                      "moved by more than this distance since its last evaluation. \n"
+                                      "If unspecified default value 0, evaluated at each step."))
     , m_previousYoungValue(0.0)
     , m_previousVolumeValue(0.0)
     , m_deltaYoungModulus(0.0)
@@ -141,6 +147,7 @@ void YoungModulusActuator<DataTypes>::reset()
         return;
 
     m_youngModulus = m_initialYoungModulus;
+    m_normalizedForcePositions.clear();
     initLimit();
 }
 
@@ -160,22 +167,17 @@ void YoungModulusActuator<DataTypes>::buildConstraintMatrix(const ConstraintPara
 
     MatrixDeriv& matrix = *cMatrix.beginEdit();
 
-    VecReal youngModulus = m_tetraForceField->_youngModulus.getValue();
+    const VecReal& youngModulus = m_tetraForceField->_youngModulus.getValue();
     m_youngModulus = youngModulus[0];
 
-    // TODO(damien): this seems a bit hacky :) what are the other possibilities.
-    VecDeriv force;
-    getForce(force, x);
+    if(!isNormalizedForceValid(x.getValue()))
+        updateNormalizedForce(x);
 
     MatrixDerivRowIterator rowIterator = matrix.writeLine(m_constraintId);
 
-    for (unsigned int j=0; j<force.size(); j++)
-    {
-        force[j] = force[j]*(1.0/m_youngModulus);
-
-        if(force[j].norm() != 0.0)
-            rowIterator.setCol(j, force[j]);
-    }
+    for (unsigned int j=0; j<m_normalizedForce.size(); j++)
+        if(m_normalizedForce[j].norm() != 0.0)
+            rowIterator.setCol(j, m_normalizedForce[j]);
     cIndex++;
 
     cMatrix.endEdit();
@@ -183,14 +185,46 @@ void YoungModulusActuator<DataTypes>::buildConstraintMatrix(const ConstraintPara
 }
 
 
+template<class DataTypes>
+void YoungModulusActuator<DataTypes>::updateNormalizedForce(const DataVecCoord &x)
+{
+    // TODO(damien): this seems a bit hacky :) what are the other possibilities.
+    getForce(m_normalizedForce, x);
+
+    for (unsigned int j=0; j<m_normalizedForce.size(); j++)
+        m_normalizedForce[j] = m_normalizedForce[j]*(1.0/m_youngModulus);
+
+    m_normalizedForcePositions = x.getValue();
+    m_nbForceEvaluations++;
+}
+
+
+template<class DataTypes>
+bool YoungModulusActuator<DataTypes>::isNormalizedForceValid(const VecCoord& x) const
+{
+    // The normalized force does not depend on the Young modulus, only on the positions
+    const Real threshold = d_forceUpdateThreshold.getValue();
+    if(threshold <= 0 || x.size() != m_normalizedForcePositions.size())
+        return false;
+
+    for (unsigned int j=0; j<x.size(); j++)
+        if((x[j]-m_normalizedForcePositions[j]).norm() > threshold)
+            return false;
+
+    return true;
+}
+
+
 template<class DataTypes>
 void YoungModulusActuator<DataTypes>::getForce(VecDeriv& force,
                                                const DataVecCoord &x)
 {
-    DataVecDeriv f;
-    VecDeriv f0;
-    f0.resize(x.getValue().size());
-    f.setValue(f0);
+    // The buffers are kept between calls
+    {
+        helper::WriteOnlyAccessor<DataVecDeriv> f = m_force;
+        f.clear();
+        f.resize(x.getValue().size());
+    }
 
     // AddForce(): computes internal forces with respect to given positions and known rest positions.
     //             The velocities v are not used in the computation.
@@ -198,9 +232,8 @@ void YoungModulusActuator<DataTypes>::getForce(VecDeriv& force,
     //                                                      DataVecDeriv& d_f,
     //                                                      const DataVecCoord& d_x,
     //                                                      const DataVecDeriv& /*d_v*/)
-    DataVecDeriv v;
-    m_tetraForceField->addForce(nullptr, f, x, v);
-    force = f.getValue();
+    m_tetraForceField->addForce(nullptr, m_force, x, m_velocity);
+    force = m_force.getValue();
 }
 
 
@@ -33,6 +33,8 @@
 #include <sofa/core/ObjectFactory.h>
 #include <sofa/core/visual/VisualParams.h>
 #include <sofa/core/behavior/MultiVec.h>
+#include <sofa/core/behavior/OdeSolver.h>
+#include <sofa/core/BaseMapping.h>
 #include <sofa/simulation/BehaviorUpdatePositionVisitor.h>
 #include <sofa/simulation/MechanicalVisitor.h>
 #include <sofa/simulation/SolveVisitor.h>
@@ -41,18 +43,28 @@
 #include <sofa/simulation/mechanicalvisitor/MechanicalResetConstraintVisitor.h>
 #include <sofa/simulation/mechanicalvisitor/MechanicalVOpVisitor.h>
 #include <sofa/simulation/mechanicalvisitor/MechanicalProjectJacobianMatrixVisitor.h>
+#include <sofa/simulation/mechanicalvisitor/MechanicalPropagateOnlyPositionAndVelocityVisitor.h>
+#include <sofa/simulation/mechanicalvisitor/MechanicalPropagateOnlyPositionVisitor.h>
+#include <sofa/simulation/mechanicalvisitor/MechanicalPropagateOnlyVelocityVisitor.h>
 #include <sofa/simulation/DefaultTaskScheduler.h>
 #include <sofa/simulation/MainTaskSchedulerFactory.h>
 #include <sofa/helper/AdvancedTimer.h>
 #include <sofa/helper/ScopedAdvancedTimer.h>
 #include <sofa/helper/map.h>
 #include <sofa/helper/system/thread/CTime.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 #include <SoftRobots.Inverse/component/solver/QPInverseProblemSolver.h>
 #include <SoftRobots.Inverse/component/solver/modules/QPMechanicalSetConstraint.h>
 #include <SoftRobots.Inverse/component/solver/modules/QPMechanicalAccumulateConstraint.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPMechanicalStoreLambda.h>
 
 using sofa::simulation::mechanicalvisitor::MechanicalProjectJacobianMatrixVisitor;
+using sofa::simulation::mechanicalvisitor::MechanicalPropagateOnlyPositionAndVelocityVisitor;
+using sofa::simulation::mechanicalvisitor::MechanicalPropagateOnlyPositionVisitor;
+using sofa::simulation::mechanicalvisitor::MechanicalPropagateOnlyVelocityVisitor;
 using sofa::simulation::mechanicalvisitor::MechanicalResetConstraintVisitor;
 using sofa::component::constraint::lagrangian::solver::ConstraintStoreLambdaVisitor ;
 using sofa::simulation::common::VectorOperations;
@@ -60,10 +72,13 @@ using sofa::simulation::mechanicalvisitor::MechanicalVOpVisitor;
 using sofa::simulation::Node ;
 
 using sofa::core::behavior::BaseConstraintCorrection ;
+using sofa::core::behavior::BaseMechanicalState ;
+using sofa::core::behavior::OdeSolver ;
 using sofa::core::objectmodel::BaseContext ;
 
 using sofa::helper::system::thread::CTime ;
 using sofa::type::vector;
+using sofa::linearalgebra::BaseMatrix;
 using sofa::helper::WriteAccessor;
 using sofa::helper::AdvancedTimer ;
 
@@ -95,13 +110,115 @@ void clearMultiVecId(BaseContext* ctx, const ConstraintParams* cParams, const TM
     clearVisitor.setMapped(true);
     ctx->executeVisitor(&clearVisitor);
 }
+
+/// Adds to the states their parents through the mappings, recursively
+void addParentStates(vector<BaseMechanicalState*>& states)
+{
+    for(unsigned int i=0; i<states.size(); i++)
+    {
+        Node* node = dynamic_cast<Node*>(states[i]->getContext());
+        sofa::core::BaseMapping* mapping = (node)? node->mechanicalMapping.get() : nullptr;
+        if(!mapping)
+            continue;
+
+        for(BaseMechanicalState* parent : mapping->getMechFrom())
+            if(parent && std::find(states.begin(), states.end(), parent) == states.end())
+                states.push_back(parent);
+    }
+}
+
+/// True when the mappings from the given states to their independent states are all linear
+bool hasLinearMappings(vector<BaseMechanicalState*> states)
+{
+    addParentStates(states);
+    for(BaseMechanicalState* state : states)
+    {
+        Node* node = dynamic_cast<Node*>(state->getContext());
+        sofa::core::BaseMapping* mapping = (node)? node->mechanicalMapping.get() : nullptr;
+        if(mapping && !mapping->isLinear())
+            return false;
+    }
+    return true;
+}
+
+using module::QPTrace;
+
+/// Phases of a step, interned once for the timings and the trace
+const QPTrace::NameId s_accumulatePhase = QPTrace::intern("Accumulate constraint");
+const QPTrace::NameId s_violationPhase = QPTrace::intern("Constraint violation");
+const QPTrace::NameId s_compliancePhase = QPTrace::intern("Compliance");
+const QPTrace::NameId s_solvePhase = QPTrace::intern("Solve");
+const QPTrace::NameId s_correctionPhase = QPTrace::intern("Correction");
+const QPTrace::NameId s_lambdaStorePhase = QPTrace::intern("Lambda store");
+
+/// Phase of the records of the telemetry stream, NbPhases for the phases it does not record
+int getStreamPhase(const QPTrace::NameId& phase)
+{
+    typedef module::QPTelemetryStream Stream;
+    if(phase == s_accumulatePhase) return Stream::AccumulatePhase;
+    if(phase == s_violationPhase) return Stream::ViolationPhase;
+    if(phase == s_compliancePhase) return Stream::CompliancePhase;
+    if(phase == s_solvePhase) return Stream::SolvePhase;
+    if(phase == s_correctionPhase) return Stream::CorrectionPhase;
+    if(phase == s_lambdaStorePhase) return Stream::LambdaStorePhase;
+    return Stream::NbPhases;
+}
+
+/// Messages pending at most in the queue of asyncMessages
+constexpr unsigned int s_messageQueueSize = 256;
+
+/// Keys of the rate limited messages of the steps, see QPMessageQueue
+const char* const s_linesMessage = "lines";
+const char* const s_buildTimeMessage = "build time";
+const char* const s_complianceMessage = "compliance";
+const char* const s_solveTimeMessage = "solve time";
+const char* const s_totalTimeMessage = "total time";
+const char* const s_anomalyMessage = "anomaly";
+const char* const s_consensusMessage = "consensus";
 }
 
 QPInverseProblemSolver::QPInverseProblemSolver()
     : d_displayTime(initData(&d_displayTime, false, "displayTime",
                              "Display time for each important step of QPInverseProblemSolver."))
 
-    , d_multithreading(initData(&d_multithreading, false, "multithreading", "Build compliances concurrently"))
+    , d_multithreading(initData(&d_multithreading, false, "multithreading", "Build compliances and constraint matrices, solve the friction contacts, and apply the motion corrections \n"
+                                                                            "of the objects of different ODE solvers, concurrently"))
+
+    , d_concurrentResults(initData(&d_concurrentResults, false, "concurrentResults",
+                                   "If true (with multithreading), the results (forces, displacements) are stored into \n"
+                                   "the actuators, effectors and sensors concurrently, for the components whose \n"
+                                   "storeResults is thread-safe (CableActuator, SurfacePressureActuator, ...) and \n"
+                                   "whose Data are not linked. The others are stored on the solver thread. \n"
+                                   "Default value false."))
+    , d_deterministic(initData(&d_deterministic, false, "deterministic",
+                               "If true (with multithreading), the results are bitwise those of the sequential \n"
+                               "resolution, whatever the number of threads. The compliance of the constraint \n"
+                               "corrections is still computed concurrently, but accumulated in the sequential order, \n"
+                               "and the friction contacts are solved with the sequential Gauss-Seidel. \n"
+                               "Default value false."))
+    , d_threadCores(initData(&d_threadCores, "threadCores",
+                             "With multithreading, cores the threads running the compliance and contact tasks are \n"
+                             "pinned to (Linux only). A thread stays pinned to these cores after its first task. \n"
+                             "On a machine with several sockets, the cores of one socket keep the tasks and their \n"
+                             "buffers, allocated by the thread running the task, on the same NUMA node. \n"
+                             "Default value empty (threads not pinned)."))
+    , d_threadSocket(initData(&d_threadSocket, -1, "threadSocket",
+                              "With multithreading, NUMA node (socket) whose cores the threads running the compliance \n"
+                              "and contact tasks are pinned to (Linux only), if threadCores is empty. \n"
+                              "Default value -1 (threads not pinned)."))
+    , d_dedicatedThreadPool(initData(&d_dedicatedThreadPool, false, "dedicatedThreadPool",
+                                     "If true (with multithreading), the compliance and contact tasks run on a thread pool \n"
+                                     "owned by the solver, instead of the main task scheduler shared with the other \n"
+                                     "components (force field assembly, ...). \n"
+                                     "Default value false."))
+    , d_threadPoolSize(initData(&d_threadPoolSize, 0u, "threadPoolSize",
+                                "Number of threads of the dedicated thread pool, the simulation thread included. \n"
+                                "Default value 0 (one thread per core)."))
+    , d_threadPoolPriority(initData(&d_threadPoolPriority, 0, "threadPoolPriority",
+                                    "Nice value of the threads of the dedicated thread pool (Linux only), from -20 (highest \n"
+                                    "priority) to 19 (lowest). A negative value needs the privilege to raise the priority. \n"
+                                    "The simulation thread keeps its priority. \n"
+                                    "Default value 0 (priority unchanged)."))
 
     , d_reverseAccumulateOrder(initData(&d_reverseAccumulateOrder, false, "reverseAccumulateOrder",
                                         "True to accumulate constraints from nodes in reversed order \n"
@@ -113,10 +230,136 @@ QPInverseProblemSolver::QPInverseProblemSolver()
                                              "of the infinity norm variation of the QP matrix"))
 
     , d_saveMatrices(initData(&d_saveMatrices, false, "saveMatrices",
-                              "If true, saves problem matrices in a file."))
+                              "If true, saves problem matrices in a text file (slow on large problems, \n"
+                              "see recordFile for a binary recording)."))
+
+    , d_asyncMessages(initData(&d_asyncMessages, false, "asyncMessages",
+                               "If true, the messages of the steps (infeasible QPs, recoveries, timings) are emitted \n"
+                               "by a background thread, through a bounded queue (the messages are dropped while it \n"
+                               "is full), instead of on the simulation thread. \n"
+                               "Default value false."))
+    , d_messageInterval(initData(&d_messageInterval, 0., "messageInterval",
+                                 "Minimum time in seconds between two messages of the same kind, the repeated \n"
+                                 "messages in between are not formatted, only counted. \n"
+                                 "Default value 0 (no rate limit)."))
+
+    , d_recordFile(initData(&d_recordFile, "recordFile",
+                            "If set, the problem solved at each step (QP matrices, constraint row ids and results) \n"
+                            "is recorded in this binary file, to be replayed offline. The file is written by \n"
+                            "a background thread. \n"
+                            "Default value empty (no recording)."))
+
+    , d_recordCompression(initData(&d_recordCompression, true, "recordCompression",
+                                   "If true, the steps of the recording are compressed (run-length encoding of zeros). \n"
+                                   "Default value true."))
+
+    , d_resultLogFile(initData(&d_resultLogFile, "resultLogFile",
+                               "If set, lambda, delta and dfree of all the constraint rows are logged at each step \n"
+                               "in this binary file, by columns in chunks of steps (see QPResultLogger), e.g. to \n"
+                               "plot the forces of the actuators and the distances of the effectors to their goal. \n"
+                               "The file is written by a background thread. \n"
+                               "Default value empty (no log)."))
+
+    , d_resultLogChunkSize(initData(&d_resultLogChunkSize, (unsigned int)256, "resultLogChunkSize",
+                                    "Number of steps of a chunk of the result log. \n"
+                                    "Default value 256."))
+
+    , d_captureFile(initData(&d_captureFile, "captureFile",
+                             "If set, the last captureWindow problems solved are kept in memory and dumped in a \n"
+                             "recording (as recordFile, with _<index> before the extension) when an anomaly occurs: \n"
+                             "an infeasible QP, more than captureMaxPivots contact pivots, a resolution longer \n"
+                             "than captureTimeBudget, or a variation of the infinity norm of Q above \n"
+                             "captureMaxQNormVariation. The window is cleared after a dump. \n"
+                             "Default value empty (no capture)."))
+
+    , d_captureWindow(initData(&d_captureWindow, (unsigned int)20, "captureWindow",
+                               "Number of the last problems kept for the dumps of captureFile. \n"
+                               "Default value 20."))
+
+    , d_captureOnInfeasible(initData(&d_captureOnInfeasible, true, "captureOnInfeasible",
+                                     "If true, the problems are dumped when a QP is infeasible (see qpRecovery). \n"
+                                     "Default value true."))
+
+    , d_captureMaxPivots(initData(&d_captureMaxPivots, 0, "captureMaxPivots",
+                                  "If not 0, the problems are dumped when the contact pivots of a step exceed \n"
+                                  "this number. \n"
+                                  "Default value 0."))
+
+    , d_captureTimeBudget(initData(&d_captureTimeBudget, 0., "captureTimeBudget",
+                                   "If not 0, the problems are dumped when the resolution of a step takes more \n"
+                                   "than this time, in ms. \n"
+                                   "Default value 0."))
+
+    , d_captureMaxQNormVariation(initData(&d_captureMaxQNormVariation, 0., "captureMaxQNormVariation",
+                                          "If not 0, the problems are dumped when the infinity norm of Q varies \n"
+                                          "by more than this percentage from the last step. \n"
+                                          "Default value 0."))
+
+    , d_captureMaxDumps(initData(&d_captureMaxDumps, (unsigned int)10, "captureMaxDumps",
+                                 "Maximum number of dumps of captureFile, the following anomalies are ignored. \n"
+                                 "Default value 10."))
+
+    , d_traceFile(initData(&d_traceFile, "traceFile",
+                           "If set, the durations of the phases of each step (compliance, LCP, contact pivots, \n"
+                           "QP resolutions with their size and number of working set changes) are written \n"
+                           "in this file, in the Chrome trace JSON format (to open with Perfetto or chrome://tracing). \n"
+                           "Default value empty (no trace)."))
+
+    , d_checkpointFile(initData(&d_checkpointFile, "checkpointFile",
+                                "If set, the warm-start state of the solver (forces of the actuators, states of the \n"
+                                "contacts, working sets of the active set cache, and the cached compliance if \n"
+                                "cacheCompliance is true) is read from this binary file at init, if it exists, and \n"
+                                "written to it at cleanup, so that a restarted process solves its first steps at its \n"
+                                "steady-state speed. The scene has to be the same as the one of the checkpoint. \n"
+                                "Default value empty (no checkpoint)."))
+
+    , d_checkpointPeriod(initData(&d_checkpointPeriod, (unsigned int)0, "checkpointPeriod",
+                                  "If not 0, the checkpoint is also written every checkpointPeriod steps, \n"
+                                  "e.g. for a process that may be stopped without cleanup. \n"
+                                  "Default value 0."))
+
+    , d_telemetryStream(initData(&d_telemetryStream, "telemetryStream",
+                                 "If set, name of a POSIX shared memory object (e.g. /softrobots) in which a record \n"
+                                 "of each step is written: timings of the phases, telemetry entries, objective, \n"
+                                 "iterations, norms of delta and lambdas. External processes read the ring buffer \n"
+                                 "of the last records without synchronizing with the simulation (see QPTelemetryStream \n"
+                                 "for the layout). Not available on the platforms without shared memory. \n"
+                                 "Default value empty (no stream)."))
+
+    , d_telemetryStreamCapacity(initData(&d_telemetryStreamCapacity, (unsigned int)1024, "telemetryStreamCapacity",
+                                         "Number of records kept in the telemetry stream. \n"
+                                         "Default value 1024."))
+
+    , d_telemetryStreamMaxRows(initData(&d_telemetryStreamMaxRows, (unsigned int)256, "telemetryStreamMaxRows",
+                                        "Maximum number of lambdas of a record of the telemetry stream, the \n"
+                                        "following ones are dropped. \n"
+                                        "Default value 256."))
 
     , d_maxIterations(initData(&d_maxIterations, 250, "maxIterations", "Maximum iterations for LCP solver"))
 
+    , d_maxNbPivots(initData(&d_maxNbPivots, 100, "maxNbPivots",
+                             "Maximum number of pivots of the contact states (QPs solved) in a step. \n"
+                             "Default value 100."))
+
+    , d_maxNbWorkingSetChanges(initData(&d_maxNbWorkingSetChanges, 500, "maxNbWorkingSetChanges",
+                                        "Maximum number of working set changes of a qpOASES resolution (nWSR). \n"
+                                        "Default value 500."))
+
+    , d_adaptiveLimits(initData(&d_adaptiveLimits, false, "adaptiveLimits",
+                                "If true, the limits on the pivots and on the working set changes are sized from \n"
+                                "their counts over the last 100 steps and QPs (adaptiveLimitsPercentile of the counts, \n"
+                                "plus adaptiveLimitsMargin), bounded by maxNbPivots and maxNbWorkingSetChanges. \n"
+                                "A QP stopped by its limit returns its best feasible iterate. \n"
+                                "Default value false."))
+
+    , d_adaptiveLimitsPercentile(initData(&d_adaptiveLimitsPercentile, 0.9, "adaptiveLimitsPercentile",
+                                          "Percentile of the recent counts the adaptive limits are sized from, in [0,1]. \n"
+                                          "Default value 0.9."))
+
+    , d_adaptiveLimitsMargin(initData(&d_adaptiveLimitsMargin, 1., "adaptiveLimitsMargin",
+                                      "Relative margin of the adaptive limits above the percentile of the counts. \n"
+                                      "Default value 1 (twice the percentile)."))
+
     , d_tolerance(initData(&d_tolerance, 1e-10, "tolerance", "Tolerance for LCP solver"))
 
     , d_responseFriction(initData(&d_responseFriction, 0., "responseFriction", "Response friction for contact resolution"))
@@ -127,16 +370,61 @@ QPInverseProblemSolver::QPInverseProblemSolver()
                          "energy does not disrupt the quality of the effector positioning. "
                          "Default value 1e-3."))
 
+    , d_adaptiveEpsilon(initData(&d_adaptiveEpsilon, false, "adaptiveEpsilon",
+                                 "If true, the norms of Q and of the compliance weighting the energy term are \n"
+                                 "only computed every 50 steps or when the traces of the matrices drift by a \n"
+                                 "factor 2, and extrapolated from their traces in between. Epsilon is scaled \n"
+                                 "(from 1e-3 to 1e3 times its value) to keep the ratio of the largest and \n"
+                                 "smallest diagonal terms of Q within [adaptiveEpsilonMinConditioning, \n"
+                                 "adaptiveEpsilonMaxConditioning], and increased after a QP solved again with an \n"
+                                 "indefinite Hessian. The scale is shown in info (Epsilon scale). \n"
+                                 "Default value false."))
+
+    , d_adaptiveEpsilonMinConditioning(initData(&d_adaptiveEpsilonMinConditioning, 1e2, "adaptiveEpsilonMinConditioning",
+                                                "Below this conditioning of the diagonal of Q, the adaptive epsilon \n"
+                                                "is decreased, for a more accurate positioning of the effectors. \n"
+                                                "Default value 1e2."))
+
+    , d_adaptiveEpsilonMaxConditioning(initData(&d_adaptiveEpsilonMaxConditioning, 1e8, "adaptiveEpsilonMaxConditioning",
+                                                "Above this conditioning of the diagonal of Q, the adaptive epsilon \n"
+                                                "is increased. \n"
+                                                "Default value 1e8."))
+
     , d_actuatorsOnly(initData(&d_actuatorsOnly, false, "actuatorsOnly",
                          "An energy term is added in the minimization process. \n"
                          "If true, only for actuators."
                          "Default value false."))
 
+    , d_energyApproximation(initData(&d_energyApproximation, sofa::helper::OptionsGroup{"Full", "BlockDiagonal", "Diagonal"}, "energyApproximation",
+                                     "Part of the compliance in the energy term: \n"
+                                     "Full (default), BlockDiagonal (the lines of each actuator, equality constraint \n"
+                                     "or contact) or Diagonal. The approximations keep the sparsity of the effector \n"
+                                     "coupling in the QP matrix, for the sparse QP backends, with a small change of \n"
+                                     "the solution when epsilon is small (see the energyApproximation benchmark)."))
+
     , d_allowSliding(initData(&d_allowSliding,false,"allowSliding",
                               "In case of friction, this option enable/disable sliding contact."))
 
+    , d_frictionFacets(initData(&d_frictionFacets, 4u, "frictionFacets",
+                                "Number of facets of the polygonal friction cone used with sliding contacts, \n"
+                                "rounded up to a multiple of 4. More facets approach the Coulomb cone more closely \n"
+                                "(the friction radius is underestimated by at most 1-cos(pi/frictionFacets)), \n"
+                                "at the cost of one more constraint row per facet for each stick contact. \n"
+                                "Default value 4, the pyramid |lambda_t| + |lambda_o| <= mu*lambda_n."))
+
     , d_graph(initData(&d_graph,"info","") )
 
+    , d_publishInfo(initData(&d_publishInfo, true, "publishInfo",
+                             "If true, the report of the last step (sizes, objective, iterations, counters) \n"
+                             "is written in the data info, for the GUI. The report is kept in a fixed layout \n"
+                             "by the solver in any case, info is only a view over it. \n"
+                             "Default value true."))
+
+    , d_telemetryHistory(initData(&d_telemetryHistory, 100u, "telemetryHistory",
+                                  "Number of steps for which the values of the report are kept, \n"
+                                  "in buffers allocated once. 0 to only keep the last step. \n"
+                                  "Default value 100."))
+
     , d_minContactForces(initData(&d_minContactForces, "minContactForces",
                                   "If set, will contraints the sum of contact forces \n"
                                   "to be greater or equal to the given value (grasping option).") )
@@ -147,30 +435,741 @@ QPInverseProblemSolver::QPInverseProblemSolver()
 
     , d_objective(initData(&d_objective, 250.0, "objective", "Erreur between the target and the end effector "))
 
+    , d_hotStart(initData(&d_hotStart, false, "hotStart",
+                          "If true, the QP is hot started from the active set found at the previous step, \n"
+                          "as long as the number of variables and constraints does not change. \n"
+                          "The QP of the contact problem without friction is hot started the same way. \n"
+                          "Default value false."))
+
+    , d_contactFreeHotStart(initData(&d_contactFreeHotStart, false, "contactFreeHotStart",
+                                     "If true, the steps without contact are solved with a QP of their own, kept \n"
+                                     "through the steps with contacts, and hot started from the previous contact-free \n"
+                                     "step as long as the actuator and equality constraints do not change. When Q and \n"
+                                     "the constraint matrix did not change either, its factorization is reused. \n"
+                                     "Default value false."))
+
+    , d_parametricQP(initData(&d_parametricQP, false, "parametricQP",
+                              "If true, Q and the constraint matrix of the QP are kept between the resolutions \n"
+                              "while their relative variation stays below parametricThreshold, and only c and \n"
+                              "the bounds are updated by a hot start of qpOASES (online active set strategy, \n"
+                              "for tracking tasks). They are factorized again when the threshold is reached. \n"
+                              "Default value false."))
+
+    , d_parametricThreshold(initData(&d_parametricThreshold, 0.01, "parametricThreshold",
+                                     "Relative variation of Q and of the constraint matrix (infinity norm of the \n"
+                                     "difference) since their last factorization that triggers a new one. \n"
+                                     "Default value 0.01."))
+
+    , d_reuseHessian(initData(&d_reuseHessian, false, "reuseHessian",
+                              "If true, the QP matrix Q is kept between steps and reused as long as the \n"
+                              "blocks of the compliance it is computed from are unchanged (e.g. with a \n"
+                              "factorization kept by a LinearSolverConstraintCorrection), only c is computed again. \n"
+                              "Default value false."))
+
+    , d_condensedEffectors(initData(&d_condensedEffectors, false, "condensedEffectors",
+                                    "If true, Q and c are accumulated from the effector rows of W by chunks of rows, \n"
+                                    "without a copy of the whole block W(effectors, variables), for the problems with \n"
+                                    "many more effector rows than variables. Not used with reuseHessian, \n"
+                                    "a hessianBackend other than CPU, a horizon or priority levels. \n"
+                                    "Default value false."))
+
+    , d_effectorSketchSize(initData(&d_effectorSketchSize, (unsigned int)0, "effectorSketchSize",
+                                    "If greater than 0 and smaller than the number of effector rows, Q and c are \n"
+                                    "assembled from a random sketch of this number of rows of the effector rows of W \n"
+                                    "(approximate objective), for the problems with many more effector rows than \n"
+                                    "variables. Same exclusions as condensedEffectors. \n"
+                                    "Default value 0."))
+
+    , d_warmStartContacts(initData(&d_warmStartContacts, false, "warmStartContacts",
+                                   "If true, the pivot algorithm of the contacts starts from the state (active, inactive, \n"
+                                   "stick, sliding) each contact had at the end of the previous step, instead of the \n"
+                                   "guess from the contact problem without actuation. Only applies to the contacts \n"
+                                   "given a persistent id by their component (e.g. UnilateralLagrangianConstraint), \n"
+                                   "or by the contact tracker (trackContacts). \n"
+                                   "Default value false."))
+
+    , d_trackContacts(initData(&d_trackContacts, false, "trackContacts",
+                               "If true, the contacts whose component gives no persistent id are matched to the \n"
+                               "contacts of the previous step, by component and by their rows of the compliance \n"
+                               "(coupling with the actuators and equality constraints, own compliance), and given \n"
+                               "a stable id. The contact solvers then start from the forces of the same contacts \n"
+                               "at the previous step instead of the forces of the rows at the same index. \n"
+                               "It reads the assembled W: matrixFree and lazyContactCompliance are not applied. \n"
+                               "Default value false."))
+
+    , d_trackContactsTolerance(initData(&d_trackContactsTolerance, 1e-2, "trackContactsTolerance",
+                                        "Largest distance between the compliance rows of a same contact at two \n"
+                                        "steps, relative to their norm. \n"
+                                        "Default value 1e-2."))
+
+    , d_primalWarmStart(initData(&d_primalWarmStart, false, "primalWarmStart",
+                                 "If true, the first QP of the pivot algorithm of the contacts is initialized with \n"
+                                 "the solution of the contact problem (the actuators keeping their last values) and \n"
+                                 "with the working set of the last QP of the previous step, instead of a cold start. \n"
+                                 "Default value false."))
+
+    , d_activeSetCacheSize(initData(&d_activeSetCacheSize, (unsigned int)0, "activeSetCacheSize",
+                                    "Number of contact configurations whose outcome of the pivot algorithm (states \n"
+                                    "of the contacts, working set of the last QP) is cached. When a configuration \n"
+                                    "comes back (e.g. pick-and-place cycles), the pivot algorithm starts from its \n"
+                                    "outcome. The least recently used configuration is replaced. 0 to disable. \n"
+                                    "Default value 0."))
+
+    , d_pivoting(initData(&d_pivoting, sofa::helper::OptionsGroup{"Single", "Block"}, "pivoting",
+                          "Pivoting of the contact states between the QPs of a step: \n"
+                          "Single (the state of the most blocking contact changes at each QP, default) \n"
+                          "or Block (the states of all the contacts violating their complementarity \n"
+                          "condition change at once, with a fallback to single pivots while the number \n"
+                          "of violating contacts does not decrease). \n"
+                          "The number of contacts pivoted at each iteration is reported in info."))
+
+    , d_speculativePivots(initData(&d_speculativePivots, (unsigned int)0, "speculativePivots",
+                                   "Number of candidate pivots whose QP is solved ahead at each single pivot \n"
+                                   "(concurrently when multithreading is true), among the contacts of largest dual. \n"
+                                   "The candidate whose solution leaves the fewest contacts at a boundary is pivoted. \n"
+                                   "0 or 1 to pivot the most blocking contact. \n"
+                                   "Default value 0."))
+
+    , d_partialCompliance(initData(&d_partialCompliance, false, "partialCompliance",
+                                   "If true, only the blocks of the compliance matrix read by the QP are assembled: \n"
+                                   "the entries coupling only effectors and sensors are skipped (and left to zero). \n"
+                                   "Default value false."))
+
+    , d_symmetricCompliance(initData(&d_symmetricCompliance, false, "symmetricCompliance",
+                                     "If true, only the upper triangle of the compliance matrix W = J A^-1 J^T, which \n"
+                                     "is symmetric, is assembled: the entries written by the constraint corrections \n"
+                                     "below the diagonal are dropped, and the merge of the multithreaded compliance \n"
+                                     "only adds the upper triangle. The lower triangle is then copied from it, in one \n"
+                                     "pass, before the resolution. Default value false."))
+
+    , d_clearComplianceBlocks(initData(&d_clearComplianceBlocks, false, "clearComplianceBlocks",
+                                       "If true (with partialCompliance), while the number of constraint rows does \n"
+                                       "not change, only the rows and columns of the QP variables are cleared in the \n"
+                                       "compliance matrix at each step, instead of the whole dense matrix. The entries \n"
+                                       "coupling only effectors and sensors are then left to their previous values. \n"
+                                       "Default value false."))
+
+    , d_cacheCompliance(initData(&d_cacheCompliance, false, "cacheCompliance",
+                                 "If true, the contribution of a constraint correction to the compliance matrix is \n"
+                                 "kept, and reused while the constraint Jacobian of its mechanical state and the \n"
+                                 "time step do not change (e.g. actuators and effectors only). Only valid if the \n"
+                                 "system of the constraint correction is constant (linear FEM): the cache is only \n"
+                                 "cleared when the system is rebuilt or the solver reinitialized. \n"
+                                 "Default value false."))
+
+    , d_incrementalCompliance(initData(&d_incrementalCompliance, false, "incrementalCompliance",
+                                       "If true (with cacheCompliance), when at most half of the rows of a constraint \n"
+                                       "correction changed (e.g. the contacts), only their rows and columns of the \n"
+                                       "compliance are computed, with partial solves, and spliced into the cached ones. \n"
+                                       "Default value false."))
+
+    , d_lazyContactCompliance(initData(&d_lazyContactCompliance, false, "lazyContactCompliance",
+                                       "If true, the compliance between the contacts predicted inactive (not penetrating \n"
+                                       "up to lazyContactMargin, and not active at the last step) is not computed. When \n"
+                                       "one of them is active in the solution, the missing entries are computed and the \n"
+                                       "problem is solved again. For scenes with many separating contacts. \n"
+                                       "Default value false."))
+
+    , d_lazyContactMargin(initData(&d_lazyContactMargin, 0., "lazyContactMargin",
+                                   "With lazyContactCompliance, the contacts whose violation (dfree) is below this \n"
+                                   "margin are predicted active. \n"
+                                   "Default value 0."))
+
+    , d_reducedBasis(initData(&d_reducedBasis, "reducedBasis",
+                              "Basis of the deformations of the mechanical state of reducedConstraintCorrection \n"
+                              "(e.g. POD modes of the actuated deformations, precomputed offline): the modes \n"
+                              "one after the other, each of the size of the derivatives of the state. With \n"
+                              "reducedCompliance, the compliance of the actuators and effectors of this state \n"
+                              "is formed from the reduced system. The contacts still go through the full path: \n"
+                              "as soon as a contact is on the state, its constraint correction computes the \n"
+                              "whole contribution. Default value is empty (no reduced-order compliance)."))
+
+    , d_reducedCompliance(initData(&d_reducedCompliance, "reducedCompliance",
+                                   "Compliance in the coordinates of reducedBasis (nbModes x nbModes, row-major), \n"
+                                   "scaled as the constraint correction scales its compliance (e.g. the inverse of \n"
+                                   "the projected stiffness, times the factor of the time integration). \n"
+                                   "Default value is empty."))
+
+    , d_reducedConstraintCorrection(initData(&d_reducedConstraintCorrection, "reducedConstraintCorrection",
+                                             "Name of the constraint correction whose contribution is formed from \n"
+                                             "reducedBasis and reducedCompliance. \n"
+                                             "Default value is empty (the first constraint correction)."))
+
+    , d_complianceTable(initData(&d_complianceTable, "complianceTable",
+                                 "If set, table of compliance matrices sampled over the actuation states (the forces \n"
+                                 "of the actuators at the previous step) in an offline run, see recordComplianceTable. \n"
+                                 "At the steps without contacts, the compliance is interpolated from the nearest samples \n"
+                                 "instead of being computed by the constraint corrections. When the actuation state is \n"
+                                 "outside the sampled region (see complianceTableRadius) or the constraints do not match \n"
+                                 "the table, the compliance is computed as usual. The violation is always computed. \n"
+                                 "Default value empty (no table)."))
+
+    , d_complianceTableRadius(initData(&d_complianceTableRadius, 0.1, "complianceTableRadius",
+                                       "Maximal distance from the actuation state to the nearest sample of complianceTable, \n"
+                                       "the forces of each actuator being scaled by their sampled range. \n"
+                                       "Default value 0.1."))
+
+    , d_recordComplianceTable(initData(&d_recordComplianceTable, "recordComplianceTable",
+                                       "If set, the actuation state and the compliance matrix of each step without contacts \n"
+                                       "are appended to this file, to be used as complianceTable (for instance in an offline \n"
+                                       "run sweeping the workspace, the files of several runs can be merged and thinned with \n"
+                                       "the tool SoftRobots.Inverse_compliancetable). \n"
+                                       "Default value empty (no recording)."))
+
+    , d_restComplianceFile(initData(&d_restComplianceFile, "restComplianceFile",
+                                    "If set, the compliance of the first step without contacts (actuators, effectors and \n"
+                                    "sensors at the rest configuration) is read from this file, mapped read-only in memory \n"
+                                    "and shared by the processes starting the same scene on the host, instead of being \n"
+                                    "computed by the constraint corrections. The file is keyed by a hash of the constraint \n"
+                                    "rows, of the names, time steps and constraint Jacobians of the constraint corrections: \n"
+                                    "when it does not match, the compliance is computed and the file is written. It has to \n"
+                                    "be removed when the mechanical parameters of the scene change. \n"
+                                    "Default value empty (no file)."))
+
+    , d_lazySensors(initData(&d_lazySensors, false, "lazySensors",
+                             "If true, the sensors are left out of the resolution: neither their violation nor \n"
+                             "their rows of the compliance matrix are computed. They are evaluated from the \n"
+                             "state after the correction instead of the linearized delta, which costs a \n"
+                             "propagation of the corrected positions and velocities to the mapped states. \n"
+                             "Default value false."))
+
+    , d_batchSensors(initData(&d_batchSensors, false, "batchSensors",
+                              "If true, the sensors are taken out of the constraint problem: they are not built \n"
+                              "with the other constraints and get no rows in the compliance, the violation and \n"
+                              "the QP, which are smaller. They are evaluated once per step from the corrected \n"
+                              "state, after the storage of the lambdas, in one pass over all the sensors, \n"
+                              "concurrently with multithreading for the sensors that support it (see \n"
+                              "concurrentResults). Replaces lazySensors. \n"
+                              "Default value false."))
+
+    , d_clearConstrainedStates(initData(&d_clearConstrainedStates, false, "clearConstrainedStates",
+                                        "If true, the buffers of lambda and dx are cleared, at each step, only in the \n"
+                                        "states in which the constraints wrote: the states of the constraints, their \n"
+                                        "parents through the mappings, and the states integrated by the same ODE solvers, \n"
+                                        "instead of in all the states of the graph. Only known for the SoftRobots \n"
+                                        "constraints: with other constraints (e.g. contacts) or constraint corrections \n"
+                                        "without ODE solver, all the states are cleared. \n"
+                                        "Default value false."))
+
+    , d_sparseLambdaStore(initData(&d_sparseLambdaStore, false, "sparseLambdaStore",
+                                   "If true, the constraints whose rows all have a zero lambda (the effectors, the \n"
+                                   "inactive contacts) are skipped when the lambdas are stored in the states, as the \n"
+                                   "mappings below which no lambda was stored. \n"
+                                   "Default value false."))
+
+    , d_measurementOnlyRows(initData(&d_measurementOnlyRows, false, "measurementOnlyRows",
+                                     "If true, the rows of the effectors and sensors, which carry no force, are \n"
+                                     "measurement-only: the constraint corrections whose states only have such rows, \n"
+                                     "or rows of zero lambda, skip the computation of their motion correction from \n"
+                                     "lambda (their correction is zero) and of their residual. Only known for the \n"
+                                     "SoftRobots constraints: with a force on another constraint (e.g. a contact), no \n"
+                                     "constraint correction is skipped. \n"
+                                     "Default value false."))
+
+    , d_decomposeSubproblems(initData(&d_decomposeSubproblems, false, "decomposeSubproblems",
+                                      "If true, the groups of constraints that are not coupled by the compliance \n"
+                                      "(e.g. several robots without mechanical interaction) are solved as \n"
+                                      "independent QPs, concurrently if multithreading is enabled. \n"
+                                      "Default value false."))
+
+    , d_consensusChannel(initData(&d_consensusChannel, string(""), "consensusChannel",
+                                  "Name of the shared memory object through which the processes of a distributed \n"
+                                  "resolution exchange their coupling contacts (see consensusContacts), each process \n"
+                                  "solving its own part. Replaces decomposeSubproblems. \n"
+                                  "Default value empty (no exchange)."))
+
+    , d_consensusNode(initData(&d_consensusNode, 0u, "consensusNode",
+                               "Index of this process among the consensusNbNodes processes of the channel. \n"
+                               "Default value 0."))
+
+    , d_consensusNbNodes(initData(&d_consensusNbNodes, 1u, "consensusNbNodes",
+                                  "Number of processes of the channel, the same in all of them. \n"
+                                  "Default value 1."))
+
+    , d_consensusContacts(initData(&d_consensusContacts, "consensusContacts",
+                                   "Names or paths of the contact components coupled with the other processes, in the \n"
+                                   "same order in all of them. The normal force of their contacts is the multiplier of \n"
+                                   "their non-penetration, the gap being the sum of the displacements of the processes \n"
+                                   "(the free gap only appearing in one of them), and their tangential force is zero. \n"
+                                   "Without consensusChannel, they are solved by the same iterations in this process. \n"
+                                   "Default value empty."))
+
+    , d_consensusRelaxation(initData(&d_consensusRelaxation, 0.8, "consensusRelaxation",
+                                     "Relaxation of the update of the coupling forces, f = max(0, f - relaxation*gap/compliance), \n"
+                                     "to decrease if the forces oscillate. \n"
+                                     "Default value 0.8."))
+
+    , d_consensusIterations(initData(&d_consensusIterations, 20u, "consensusIterations",
+                                     "Maximum number of resolutions per step for the consensus on the coupling forces. \n"
+                                     "Default value 20."))
+
+    , d_consensusTolerance(initData(&d_consensusTolerance, 1e-6, "consensusTolerance",
+                                    "The consensus is reached when no coupling force of the processes changes by more \n"
+                                    "than the tolerance. \n"
+                                    "Default value 1e-6."))
+
+    , d_consensusTimeout(initData(&d_consensusTimeout, 1., "consensusTimeout",
+                                  "Seconds to wait for the other processes at each exchange. \n"
+                                  "Default value 1."))
+
+    , d_qpSolver(initData(&d_qpSolver, sofa::helper::OptionsGroup{"qpOASES", "ADMM", "Adaptive"}, "qpSolver",
+                          "QP solver used for the inverse problem and the contact LCP: \n"
+                          "qpOASES (active set, default) or ADMM (operator splitting, scales better \n"
+                          "with the number of actuators, solution accurate up to a tolerance of 1e-6). \n"
+                          "Adaptive chooses the method of each QP from its size, the density of its \n"
+                          "constraints, its contacts and the outcome of the previous steps, with the cost \n"
+                          "model backendCostModel: the unconstrained minimizer, the fixed-size kernel, \n"
+                          "qpOASES with hot start or ADMM (the contact LCP is solved with qpOASES). \n"
+                          "The choice is logged when it changes."))
+
+    , d_backendCostModel(initData(&d_backendCostModel, "backendCostModel",
+                                  "Cost model of qpSolver Adaptive: the time of a method is a + b*flops in \n"
+                                  "microseconds, given as {a, b} for Interior, SmallKernel, ActiveSet and ADMM, \n"
+                                  "as printed by the benchmark backendCostModel on the target machine. \n"
+                                  "Default value is empty (model measured on a desktop CPU)."))
+
+    , d_structuredFactorization(initData(&d_structuredFactorization, false, "structuredFactorization",
+                                         "If true, with qpSolver ADMM, the system of its iterations is factorized by \n"
+                                         "blocks when the actuators split in groups only coupled through the contacts \n"
+                                         "(e.g. the fingers of a gripper around a grasped object): each group is \n"
+                                         "eliminated on its own, concurrently with multithreading, and the reduced \n"
+                                         "problem of the contacts is factorized, the cost growing linearly with the \n"
+                                         "number of groups. Without such structure the system is factorized as a whole. \n"
+                                         "Default value false."))
+
+    , d_smallProblemKernel(initData(&d_smallProblemKernel, false, "smallProblemKernel",
+                                    "If true, the QPs without contact of at most 16 variables and 32 constraints \n"
+                                    "(e.g. robots with a few actuators) are solved by a dual active-set kernel of \n"
+                                    "fixed size, on stack storage, instead of setting up a qpOASES problem. The \n"
+                                    "selected qpSolver remains the fallback when the kernel fails (Hessian not \n"
+                                    "positive definite, infeasible constraints). \n"
+                                    "Default value false."))
+
+    , d_interiorFastPath(initData(&d_interiorFastPath, false, "interiorFastPath",
+                                  "If true, the QPs without equality constraint first try the unconstrained \n"
+                                  "minimizer of the objective (one LDLT factorization of Q). When it strictly \n"
+                                  "satisfies the bounds and the constraints, no constraint is active and the QP \n"
+                                  "solver is not called (e.g. tracking steps far from the limits). \n"
+                                  "Default value false."))
+
+    , d_matrixFree(initData(&d_matrixFree, false, "matrixFree",
+                            "If true and all the active constraint corrections apply their compliance to a \n"
+                            "vector (ComplianceOperator, e.g. MatrixFreeConstraintCorrection), the problems \n"
+                            "without contact are solved without assembling W, by ADMM with conjugate \n"
+                            "gradient steps. For large problems (e.g. shape tracking with many effectors) \n"
+                            "where building W dominates. The other steps, or the ones with options reading \n"
+                            "W, use the assembled compliance. \n"
+                            "Default value false."))
+
+    , d_matrixFreeTolerance(initData(&d_matrixFreeTolerance, 1e-6, "matrixFreeTolerance",
+                                     "Relative tolerance on the primal and dual residuals of the matrix-free \n"
+                                     "resolution. \n"
+                                     "Default value 1e-6."))
+
+    , d_matrixFreeMaxIterations(initData(&d_matrixFreeMaxIterations, 4000, "matrixFreeMaxIterations",
+                                         "Maximum number of ADMM iterations of the matrix-free resolution. \n"
+                                         "Default value 4000."))
+
+    , d_hessianBackend(initData(&d_hessianBackend, sofa::helper::OptionsGroup{"CPU", "CUDA"}, "hessianBackend",
+                                "Backend of the product Wea^T Wea forming the Hessian of the inverse problem: \n"
+                                "CPU (Eigen, default) or CUDA (cuBLAS on the GPU, for problems of at least 128 \n"
+                                "variables, requires the plugin built with SOFTROBOTSINVERSE_WITH_CUDA, \n"
+                                "falls back to CPU otherwise)."))
+
+    , d_lcpSolver(initData(&d_lcpSolver, sofa::helper::OptionsGroup{"QP", "PGS"}, "lcpSolver",
+                           "Solver of the contact problem without friction: \n"
+                           "QP (qpOASES or the solver chosen with qpSolver, hot started with hotStart, default) \n"
+                           "or PGS (projected Gauss-Seidel with over-relaxation, faster but only accurate \n"
+                           "up to the given tolerance and number of iterations)."))
+
+    , d_lcpRelaxation(initData(&d_lcpRelaxation, 1., "lcpRelaxation",
+                               "Relaxation factor of the PGS contact solver, in ]0,2[. \n"
+                               "Default value 1 (projected Gauss-Seidel without over-relaxation)."))
+
+    , d_sparseContacts(initData(&d_sparseContacts, false, "sparseContacts",
+                                "If true, the compliance between the contacts is stored in a sparse matrix for \n"
+                                "the contact problem with friction, and without friction with the PGS solver, \n"
+                                "so that the memory scales with the number of coupled contact pairs. \n"
+                                "Default value false."))
+
+    , d_sparseQPThreshold(initData(&d_sparseQPThreshold, 0., "sparseQPThreshold",
+                                   "Largest density (ratio of nonzeros) of the Hessian and of the constraint matrix \n"
+                                   "of a QP for which they are given to qpOASES as compressed sparse matrices, e.g. \n"
+                                   "0.2 for the many loosely coupled rows of large surface actuators or barycentric \n"
+                                   "effectors. Default value 0 (dense matrices)."))
+
+    , d_nlcpRelaxation(initData(&d_nlcpRelaxation, 1., "nlcpRelaxation",
+                                "Over-relaxation factor of the contact solver with friction, in ]0,2[. \n"
+                                "Default value 1 (Gauss-Seidel without over-relaxation)."))
+
+    , d_nlcpAdaptiveRelaxation(initData(&d_nlcpAdaptiveRelaxation, false, "nlcpAdaptiveRelaxation",
+                                        "If true, the over-relaxation factor of the contact solver with friction is \n"
+                                        "estimated from the convergence of its first iterations, bounded by nlcpRelaxation. \n"
+                                        "Default value false."))
+
+    , d_mixedPrecision(initData(&d_mixedPrecision, false, "mixedPrecision",
+                                "If true, the iterations of the contact solver with friction read a float copy of \n"
+                                "the compliance of the contacts (half the memory traffic), the displacements being \n"
+                                "accumulated in double, then refinement iterations on the double compliance bring \n"
+                                "the error within the tolerance. Only used with the dense compliance (sparseContacts \n"
+                                "and multithreading false). \n"
+                                "Default value false."))
+
+    , d_storagePolicy(initData(&d_storagePolicy, sofa::helper::OptionsGroup{"Default", "Aligned", "TransparentHugePages", "HugePages"}, "storagePolicy",
+                               "Allocation of the dense buffers of the resolution (QP matrices, gathered block \n"
+                               "of the compliance and its float copy): Default (default), Aligned (on 64 bytes, the rows of \n"
+                               "the compliance block padded to 64 bytes), TransparentHugePages (Aligned, the buffers \n"
+                               "of at least 2 MB advised for transparent huge pages) or HugePages (Aligned, the \n"
+                               "buffers of at least 2 MB on the huge pages reserved in vm.nr_hugepages, transparent \n"
+                               "huge pages when none is left). The huge pages are only used on Linux. The matrix W \n"
+                               "of the constraint solver keeps its allocation (see the storagePolicy benchmark)."))
+
+    , d_contactReduction(initData(&d_contactReduction, false, "contactReduction",
+                                  "If true, the contacts whose rows of the compliance matrix are nearly collinear \n"
+                                  "(e.g. many contacts on a same flat patch) are merged before the resolution. \n"
+                                  "Default value false."))
+
+    , d_contactReductionTolerance(initData(&d_contactReductionTolerance, 1e-3, "contactReductionTolerance",
+                                           "Tolerance on 1-cos(angle) between the rows of two contacts to merge them. \n"
+                                           "Default value 1e-3."))
+
+    , d_contactReductionExpand(initData(&d_contactReductionExpand, true, "contactReductionExpand",
+                                        "If true, the force of merged contacts is spread on all of them, otherwise \n"
+                                        "it is applied on the most constraining one only. \n"
+                                        "Default value true."))
+
+    , d_multilevelContacts(initData(&d_multilevelContacts, false, "multilevelContacts",
+                                    "If true, the contacts are solved coarse-to-fine: the contacts whose rows of the \n"
+                                    "compliance matrix are collinear up to multilevelContactsTolerance are first solved \n"
+                                    "as patches, then the contacts of the patches at a state boundary are solved \n"
+                                    "individually. Replaces contactReduction. \n"
+                                    "Default value false."))
+
+    , d_multilevelContactsTolerance(initData(&d_multilevelContactsTolerance, 5e-2, "multilevelContactsTolerance",
+                                             "Tolerance on 1-cos(angle) between the rows of two contacts to put them in \n"
+                                             "a same patch. \n"
+                                             "Default value 5e-2."))
+
+    , d_multilevelContactsThreshold(initData(&d_multilevelContactsThreshold, 1e-2, "multilevelContactsThreshold",
+                                             "Displacement, relative to the largest free displacement of the patch, above \n"
+                                             "which a contact disagrees with the state of its patch and the patch is refined. \n"
+                                             "Default value 1e-2."))
+
+    , d_presolve(initData(&d_presolve, false, "presolve",
+                          "If true, the rows of the constraints that do not constrain the QP (null rows, \n"
+                          "rows on fixed variables whose bounds hold, exact duplicates) are removed before \n"
+                          "each resolution. The number of removed rows is reported in the telemetry. \n"
+                          "Default value false."))
+
+    , d_scaling(initData(&d_scaling, false, "scaling",
+                         "If true, the QP is equilibrated (diagonal scaling of the variables and of the \n"
+                         "constraint rows by Ruiz iterations) before its resolution, for actuators of very \n"
+                         "different magnitudes (e.g. cable forces and Young's modulus). The solution is \n"
+                         "unscaled after the resolution. \n"
+                         "Default value false."))
+
+    , d_scalingIterations(initData(&d_scalingIterations, (unsigned int)10, "scalingIterations",
+                                   "Maximum number of Ruiz iterations of the scaling. \n"
+                                   "Default value 10."))
+
+    , d_equalityElimination(initData(&d_equalityElimination, false, "equalityElimination",
+                                     "If true, the equality constraints (e.g. PositionEquality, CableEquality) are \n"
+                                     "eliminated by substitution: the QP solved has dim-nbEq variables and only \n"
+                                     "inequality constraints. The full QP is solved if the equality constraints are \n"
+                                     "redundant or if the reduced QP is infeasible. \n"
+                                     "Default value false."))
+
+    , d_infeasibilityRecovery(initData(&d_infeasibilityRecovery, sofa::helper::OptionsGroup{"Cascade", "Soft"}, "infeasibilityRecovery",
+                                       "Recovery of an infeasible QP: \n"
+                                       "Cascade (solve again without the conflicting actuator constraints, then with \n"
+                                       "an indefinite Hessian, default) \n"
+                                       "or Soft (solve once with the constraint violations as penalized slack \n"
+                                       "variables, as soon as the infeasibility is detected)."))
+
+    , d_timeBudget(initData(&d_timeBudget, 0., "timeBudget",
+                            "Time budget of the resolution of one step in milliseconds, 0 for no budget. \n"
+                            "The contact LCP can use a quarter of it, the contact pivot loop and the QPs the rest. \n"
+                            "When it is exhausted, the best feasible iterate found so far is returned. \n"
+                            "Default value 0."))
+
+    , d_deadlineHit(initData(&d_deadlineHit, false, "deadlineHit",
+                             "Output: true if the last step was stopped by the time budget."))
+
+    , d_qpRecovery(initData(&d_qpRecovery, string("None"), "qpRecovery",
+                            "Output: most severe recovery of an infeasible QP during the last step: \n"
+                            "None, ActuatorConstraints, IndefiniteHessian, SoftConstraints or Failed."))
+
+    , d_computeTimings(initData(&d_computeTimings, false, "computeTimings",
+                                "If true, the duration of each phase of the resolution is measured \n"
+                                "and published in the output timings. \n"
+                                "Default value false."))
+
+    , d_timingsWindow(initData(&d_timingsWindow, 100u, "timingsWindow",
+                               "Number of steps over which the maximum duration of each phase is taken. \n"
+                               "Default value 100."))
+
+    , d_timings(initData(&d_timings, "timings",
+                         "Output: for each phase of the resolution (accumulate constraint, constraint violation, \n"
+                         "compliance per constraint correction, QP build, LCP, QPs, correction, lambda store), \n"
+                         "{last, moving average, maximum over timingsWindow steps} of its duration in ms."))
+
+    , d_computeCounters(initData(&d_computeCounters, false, "computeCounters",
+                                 "If true, counters are read around each phase of the resolution and published \n"
+                                 "in the output counters: the heap allocations, when the allocation hook is preloaded \n"
+                                 "(tools/allochook), and the cycles, instructions and cache misses of the simulation \n"
+                                 "thread (perf_event on Linux). Can be toggled during the simulation. \n"
+                                 "Default value false."))
+
+    , d_counters(initData(&d_counters, "counters",
+                          "Output: for each phase of the resolution and counter (e.g. \"QPs: allocations\"), \n"
+                          "{last, moving average, maximum over timingsWindow steps} of its value."))
+
+    , d_profile(initData(&d_profile, false, "profile",
+                         "If set to true, the next profileSteps steps are captured in detail and written in a \n"
+                         "report (profileFile): durations and counters of the phases, size and sparsity of the \n"
+                         "compliance, pivots per iteration, working set changes and telemetry entries of each step. \n"
+                         "Reset to false once the capture starts. The capture can also be started by the key P \n"
+                         "(Ctrl+P in runSofa) when the solver is listening. \n"
+                         "Default value false."))
+
+    , d_profileSteps(initData(&d_profileSteps, (unsigned int)10, "profileSteps",
+                              "Number of steps captured in the profile report. \n"
+                              "Default value 10."))
+
+    , d_profileFile(initData(&d_profileFile, "profileFile",
+                             "JSON file of the profile report, overwritten by each capture. \n"
+                             "Default value empty (the report is written in <name of the solver>_profile.json)."))
+
+    , d_costAttribution(initData(&d_costAttribution, false, "costAttribution",
+                                 "Diagnostic mode: if true, the cost of the QPs is attributed to the constraint \n"
+                                 "components (actuators, equality, effectors, sensors, and the contacts as a whole) \n"
+                                 "and published in the output costs. \n"
+                                 "Default value false."))
+
+    , d_costs(initData(&d_costs, "costs",
+                       "Output: for each constraint component (path name), {number of rows, share of the nonzeros \n"
+                       "of the compliance in its rows, frequency of the QPs where one of its bounds or constraints \n"
+                       "is active, share of the active set changes}, accumulated since costAttribution is enabled."))
+
+    , d_exportDuals(initData(&d_exportDuals, false, "exportDuals",
+                             "If true, the duals of the bounds of the actuators and the limits of the actuators active \n"
+                             "at the solution are published in the outputs actuatorsBoundDuals and actuatorsActiveSet. \n"
+                             "They are read from the last QP of the step, without additional resolution. \n"
+                             "Default value false."))
+
+    , d_actuatorsBoundDuals(initData(&d_actuatorsBoundDuals, "actuatorsBoundDuals",
+                                     "Output: for each actuator row, the dual of its bounds on lambda, positive when \n"
+                                     "lambdaMin is active and negative when lambdaMax is active (sensitivity of the \n"
+                                     "objective to the bound). Filled when exportDuals is true."))
+
+    , d_actuatorsActiveSet(initData(&d_actuatorsActiveSet, "actuatorsActiveSet",
+                                    "Output: for each actuator row, its limits active at the solution, as the sum of \n"
+                                    "1 (lambdaMin), 2 (lambdaMax), 4 (deltaMin) and 8 (deltaMax). Filled when \n"
+                                    "exportDuals is true."))
+
+    , d_sensitivities(initData(&d_sensitivities, false, "sensitivities",
+                               "If true, the derivatives of the solution lambda are computed from the KKT system of \n"
+                               "the active set of the last QP of the step, and published in the outputs \n"
+                               "dfreeSensitivities, targetSensitivities and boundSensitivities. They replace the finite \n"
+                               "differences of whole steps, with a single factorization per step. Not computed when the \n"
+                               "step ends with the friction contact solver, or with the decomposition in subproblems. \n"
+                               "Default value false."))
+
+    , d_sensitivityRows(initData(&d_sensitivityRows, "sensitivityRows",
+                                 "Output: constraint row of each variable of the last QP (actuators, equality, then \n"
+                                 "contacts), i.e. of each row of the sensitivities. Filled when sensitivities is true."))
+
+    , d_dfreeSensitivities(initData(&d_dfreeSensitivities, "dfreeSensitivities",
+                                    "Output: dlambda/d(dfree), row-major, one row per variable and one column per \n"
+                                    "constraint row. Filled when sensitivities is true."))
+
+    , d_targetSensitivities(initData(&d_targetSensitivities, "targetSensitivities",
+                                     "Output: dlambda/d(target), row-major, one row per variable and one column per \n"
+                                     "effector row. Filled when sensitivities is true."))
+
+    , d_boundSensitivities(initData(&d_boundSensitivities, "boundSensitivities",
+                                    "Output: dlambda/d(lambda bounds), row-major, one row and one column per variable, \n"
+                                    "for the bound active at the solution (zero columns for the free variables). \n"
+                                    "Filled when sensitivities is true."))
+
+    , d_lazyProblems(initData(&d_lazyProblems, false, "lazyProblems",
+                              "If true, the second and third constraint problems, used while the previous ones \n"
+                              "are locked (e.g. read by a haptic thread), are only allocated when a lock needs them. \n"
+                              "Default value false."))
+
+    , d_problemPool(initData(&d_problemPool, false, "problemPool",
+                             "If true, the constraint problems are taken from a pool shared by the solvers of \n"
+                             "the process, and given back to it when the solver is initialized again or removed, \n"
+                             "so that the robots added at runtime reuse the problems and their buffers. The task \n"
+                             "scheduler is then initialized once per process. \n"
+                             "Default value false."))
+
+    , d_moveResolutionState(initData(&d_moveResolutionState, false, "moveResolutionState",
+                                     "If true, when a lock makes the solver write into another constraint problem, \n"
+                                     "the state kept across the steps (caches, hot started QPs, contact states, \n"
+                                     "LCP solvers) moves to it, and only the compliance and the QP system stay \n"
+                                     "in the locked problem. The state is thereby allocated once, and stays warm. \n"
+                                     "Default value false."))
+
+    , d_pipelined(initData(&d_pipelined, false, "pipelined",
+                           "If true, the problem of a step is solved on a worker thread while the simulation \n"
+                           "computes the free motion of the next step, and its correction is applied at that \n"
+                           "next step, one step late. The steps with contacts, decomposed subproblems or cost \n"
+                           "attribution, and those whose rows differ from the previous step, are solved in \n"
+                           "sequence. Default value false."))
+
+    , d_solveOnChange(initData(&d_solveOnChange, false, "solveOnChange",
+                               "If true, for the quasi-static scenes, the problem is only solved when it changed \n"
+                               "since the last resolution: when the constraints and their rows (so the contacts), \n"
+                               "dfree (so the targets of the effectors), the compliance and the limits are the \n"
+                               "same within solveOnChangeTolerance, and the parameters of the resolution \n"
+                               "(epsilon, friction, QP options...) did not change, the previous lambda is reused. \n"
+                               "Not used with decomposeSubproblems nor pipelined. The skipped resolutions are \n"
+                               "counted in the telemetry. Default value false."))
+
+    , d_solveOnChangeTolerance(initData(&d_solveOnChangeTolerance, 1e-12, "solveOnChangeTolerance",
+                                        "Largest change of an entry of dfree, of the compliance or of a limit \n"
+                                        "considered as no change with solveOnChange. \n"
+                                        "Default value 1e-12."))
+
+    , d_inverseSolvePeriod(initData(&d_inverseSolvePeriod, (unsigned int)1, "inverseSolvePeriod",
+                                    "Number of time steps between two resolutions of the inverse problem. On the \n"
+                                    "steps in between, the actuators keep the lambdas of the last inverse step and \n"
+                                    "only the contacts are solved, e.g. 10 for an inverse control at 100 Hz of a \n"
+                                    "simulation at 1 kHz. Not used with decomposeSubproblems, pipelined nor the \n"
+                                    "equality constraints. Default value 1, every step is inverse."))
+
+    , d_forwardWithoutEffectors(initData(&d_forwardWithoutEffectors, false, "forwardWithoutEffectors",
+                                         "If true, when the scene has no effector and all the actuators and equality \n"
+                                         "constraints have an imposed force (eqForce, or minForce equal to maxForce) \n"
+                                         "and no displacement limit, the QP is skipped: they take their imposed \n"
+                                         "forces and only the contacts are solved. Default value false."))
+
+    , d_reuseConstantRows(initData(&d_reuseConstantRows, false, "reuseConstantRows",
+                                   "If true, when all the constraints have constant rows (see ConstantRows, e.g. \n"
+                                   "BarycentricCenterEffector and ForcePointActuator) and are only mapped by \n"
+                                   "linear mappings, the constraint matrices built, mapped and projected at a \n"
+                                   "step are kept at the next steps while the constraints and their rows do not \n"
+                                   "change. Not used with batchSensors. Default value false."))
+
+    , d_classContiguousRows(initData(&d_classContiguousRows, false, "classContiguousRows",
+                                     "If true, from the second step the rows of the constraints are numbered by type \n"
+                                     "instead of in traversal order: the actuators, the effectors, the sensors, the \n"
+                                     "equality constraints, then the contacts, so that the blocks of W read by the QP \n"
+                                     "are contiguous. The constraints are numbered in traversal order when they \n"
+                                     "changed since the previous step. Default value false."))
+
+    , d_fuseConstraintViolation(initData(&d_fuseConstraintViolation, false, "fuseConstraintViolation",
+                                         "If true, each constraint computes its violation right after building its \n"
+                                         "rows, in the same visit, instead of in a separate traversal of the graph \n"
+                                         "(MechanicalGetConstraintViolationVisitor). When the rows are built \n"
+                                         "concurrently or kept (reuseConstantRows), the violations are computed from \n"
+                                         "the list of the constraints, without traversal either. The mapping of the \n"
+                                         "rows stays a separate pass. Default value false."))
+
+    , d_productionMode(initData(&d_productionMode, false, "productionMode",
+                                "If true, the consistency checks of the constraint lists and the feasibility check \n"
+                                "of the solution are only done when the layout of the problem (number of variables, \n"
+                                "of constraints and of contact rows) changed since they were last done, instead of \n"
+                                "at each resolution. Default value false."))
+
+    , d_horizon(initData(&d_horizon, (unsigned int)1, "horizon",
+                         "Number of steps of the model-predictive mode. With more than one step, the steps without \n"
+                         "contact and equality constraints plan the actuation over the horizon, W being assumed \n"
+                         "constant, and apply its first step. Default value 1 (single-step problem)."))
+
+    , d_horizonVariationWeight(initData(&d_horizonVariationWeight, 0., "horizonVariationWeight",
+                                        "Weight of the variation of the actuation between consecutive steps of the \n"
+                                        "horizon, and from the previous step. Default value 0."))
+
+    , d_horizonTargetShifts(initData(&d_horizonTargetShifts, "horizonTargetShifts",
+                                     "Displacement of the targets of the effector rows at each future step of the \n"
+                                     "horizon, from the current targets: the values of all the effector rows for \n"
+                                     "the step 1, then for the step 2, and so on. The missing steps keep the last \n"
+                                     "given targets. Default value empty (constant targets)."))
+
+    , d_disabledConstraints(initData(&d_disabledConstraints, "disabledConstraints",
+                                     "Names or paths of the actuators and effectors masked at runtime, e.g. to switch \n"
+                                     "them between the phases of a task. Their rows are kept in the problem, so that \n"
+                                     "the hot start and the cached structures stay valid: a disabled actuator applies \n"
+                                     "no force (lambda fixed to zero, no delta limits) and a disabled effector has \n"
+                                     "no weight in the objective. Default value empty (all enabled)."))
+
+    , d_memoryUsage(initData(&d_memoryUsage, "memoryUsage",
+                             "Output: for each allocated constraint problem (problem1, problem2, problem3, and the \n"
+                             "subproblems together), {compliance, QP system, resolution buffers, total} in bytes. \n"
+                             "The entry peak is the high-water mark of their sum since the initialization."))
+
     , m_lastCP(NULL)
 {
     createProblems();
     d_graph.setWidget("graph");
+    d_deadlineHit.setReadOnly(true);
+    d_qpRecovery.setReadOnly(true);
+    d_timings.setReadOnly(true);
+    d_counters.setReadOnly(true);
+    d_costs.setReadOnly(true);
+    d_actuatorsBoundDuals.setReadOnly(true);
+    d_actuatorsActiveSet.setReadOnly(true);
+    d_sensitivityRows.setReadOnly(true);
+    d_dfreeSensitivities.setReadOnly(true);
+    d_targetSensitivities.setReadOnly(true);
+    d_boundSensitivities.setReadOnly(true);
+    d_memoryUsage.setReadOnly(true);
 }
 
 void QPInverseProblemSolver::createProblems()
 {
-    m_CP1 = new module::QPInverseProblemImpl();
-    m_CP2 = new module::QPInverseProblemImpl();
-    m_CP3 = new module::QPInverseProblemImpl();
+    m_CP1 = newProblem();
+    m_CP2 = (d_lazyProblems.getValue())? nullptr : newProblem();
+    m_CP3 = (d_lazyProblems.getValue())? nullptr : newProblem();
 
     m_currentCP = m_CP1;
+    m_peakMemoryUsage = module::QPInverseProblem::QPMemoryUsage();
+    d_memoryUsage.beginEdit()->clear();
+    d_memoryUsage.endEdit();
+}
+
+module::QPInverseProblemImpl* QPInverseProblemSolver::getProblem(module::QPInverseProblemImpl*& problem)
+{
+    if(!problem)
+        problem = newProblem();
+    return problem;
+}
+
+module::QPInverseProblemImpl* QPInverseProblemSolver::newProblem() const
+{
+    if(d_problemPool.getValue())
+        return module::QPProblemPool::getInstance().acquire();
+    return new module::QPInverseProblemImpl();
+}
+
+void QPInverseProblemSolver::deleteProblem(module::QPInverseProblemImpl* problem) const
+{
+    if(d_problemPool.getValue())
+        module::QPProblemPool::getInstance().release(problem);
+    else
+        delete problem;
 }
 
 void QPInverseProblemSolver::deleteProblems()
 {
-    delete m_CP1;
-    delete m_CP2;
-    delete m_CP3;
+    stopPipeline();
+
+    deleteProblem(m_CP1);
+    deleteProblem(m_CP2);
+    deleteProblem(m_CP3);
+    m_CP1 = m_CP2 = m_CP3 = nullptr;
+    m_currentCP = m_lastCP = nullptr;
+
+    for(module::QPInverseProblemImpl* subproblem : m_subproblems)
+        deleteProblem(subproblem);
+    m_subproblems.clear();
 }
 
 QPInverseProblemSolver::~QPInverseProblemSolver()
 {
+    m_messageQueue.stop();
     deleteProblems();
 }
 
@@ -180,6 +1179,27 @@ void QPInverseProblemSolver::init()
     deleteProblems();
     createProblems();
     m_currentCP->init();
+    m_constraintClassification.clear();
+    m_complianceCache.clear();
+    m_changeDetection.clear();
+    m_heldActuators.clear();
+    m_nbStepsSinceInverseSolve = 0;
+    m_nbForwardSteps = 0;
+    m_hasConstantRows = false;
+    m_nbConstantRowsReuses = 0;
+
+    if(d_lcpRelaxation.getValue() <= 0. || d_lcpRelaxation.getValue() >= 2.)
+    {
+        msg_warning() << "The relaxation factor lcpRelaxation should be in ]0,2[, set to 1.";
+        d_lcpRelaxation.setValue(1.);
+    }
+
+    if(!d_backendCostModel.getValue().empty() && d_backendCostModel.getValue().size() != 2*module::QPBackendSelector::NbBackends)
+    {
+        msg_warning() << "backendCostModel should have " << 2*module::QPBackendSelector::NbBackends
+                      << " values ({a, b} per method), the default model is used.";
+        d_backendCostModel.setValue(vector<double>());
+    }
 
     // Prevents ConstraintCorrection accumulation due to multiple AnimationLoop initialization on
     // dynamic components Add/Remove operations.
@@ -188,6 +1208,19 @@ void QPInverseProblemSolver::init()
 
     getContext()->get<BaseConstraintCorrection>(&m_constraintsCorrections, BaseContext::SearchDown);
     m_isConstraintCorrectionActive.resize(m_constraintsCorrections.size());
+    m_batchedCorrections.clear();
+    m_complianceOperators.clear();
+    for (BaseConstraintCorrection* cc : m_constraintsCorrections)
+    {
+        m_batchedCorrections.push_back(dynamic_cast<softrobotsinverse::behavior::BatchedCompliance*>(cc));
+        m_complianceOperators.push_back(dynamic_cast<softrobotsinverse::behavior::ComplianceOperator*>(cc));
+    }
+    m_lastActiveContacts.clear();
+    m_nbLazyContactMisses = 0;
+    m_isForcelessCorrection.assign(m_constraintsCorrections.size(), false);
+    initCorrectionGroups();
+    m_constrainedStates.clear();
+    m_hasConstrainedStates = false;
     m_context = (Node*) getContext();
 
     VectorOperations vop(ExecParams::defaultInstance(), this->getContext());
@@ -203,7 +1236,363 @@ void QPInverseProblemSolver::init()
     }
 
     if(d_multithreading.getValue())
-        sofa::simulation::MainTaskSchedulerFactory::createInRegistry()->init();
+    {
+        if(d_problemPool.getValue())
+            module::QPProblemPool::initTaskScheduler();
+        else
+            sofa::simulation::MainTaskSchedulerFactory::createInRegistry()->init();
+    }
+
+    initMessageQueue();
+    openRecorder();
+    openResultLogger();
+    initProblemCapture();
+    openTrace();
+    initReducedCompliance();
+    initComplianceTable();
+    initRestCompliance();
+    initThreadAffinity();
+    initTaskPool();
+    openTelemetryStream();
+    openConsensusChannel();
+    restoreCheckpoint();
+}
+
+void QPInverseProblemSolver::initCorrectionGroups()
+{
+    m_correctionGroups.clear();
+    m_sequentialCorrections.clear();
+
+    // A state is integrated by one ODE solver: the constraint corrections of different ODE solvers write disjoint
+    // states, and the ones of the same solver (which may share its linear solver) stay in order in one group
+    vector<OdeSolver*> solvers;
+    for (unsigned int i = 0; i < m_constraintsCorrections.size(); i++)
+    {
+        OdeSolver* solver = m_constraintsCorrections[i]->getContext()->get<OdeSolver>(BaseContext::SearchUp);
+        if (!solver)
+        {
+            m_sequentialCorrections.push_back(i);
+            continue;
+        }
+
+        const unsigned int g = std::find(solvers.begin(), solvers.end(), solver) - solvers.begin();
+        if (g == solvers.size())
+        {
+            solvers.push_back(solver);
+            m_correctionGroups.emplace_back();
+        }
+        m_correctionGroups[g].push_back(i);
+    }
+}
+
+void QPInverseProblemSolver::openRecorder()
+{
+    m_recorder.close();
+    const std::string& filename = d_recordFile.getFullPath();
+    if(filename.empty())
+        return;
+
+    if(!m_recorder.open(filename, d_recordCompression.getValue()))
+        msg_error() << "Cannot open the record file " << filename << ", the problems will not be recorded.";
+}
+
+void QPInverseProblemSolver::openResultLogger()
+{
+    m_resultLogger.close();
+    const std::string& filename = d_resultLogFile.getFullPath();
+    if(filename.empty())
+        return;
+
+    if(!m_resultLogger.open(filename, d_resultLogChunkSize.getValue()))
+        msg_error() << "Cannot open the result log " << filename << ", the results will not be logged.";
+}
+
+void QPInverseProblemSolver::initMessageQueue()
+{
+    m_messageQueue.stop();
+    m_messageQueue.setInterval(d_messageInterval.getValue());
+    if(d_asyncMessages.getValue())
+        m_messageQueue.start(s_messageQueueSize);
+}
+
+void QPInverseProblemSolver::initProblemCapture()
+{
+    m_problemCapture.close();
+    m_nbProblemDumps = 0;
+    m_problemCapture.setWindowSize(d_captureFile.getValue().empty()? 0 : d_captureWindow.getValue());
+
+    module::QPProblemCapture::Triggers triggers;
+    triggers.infeasible = d_captureOnInfeasible.getValue();
+    triggers.maxNbPivots = d_captureMaxPivots.getValue();
+    triggers.timeBudget = d_captureTimeBudget.getValue();
+    triggers.maxQNormVariation = d_captureMaxQNormVariation.getValue();
+    m_problemCapture.setTriggers(triggers);
+}
+
+void QPInverseProblemSolver::captureProblems(const double& time, const bool& infeasible, const int& nbPivots,
+                                             const double& solveTime)
+{
+    m_problemCapture.beginStep();
+    for(unsigned int i=0; i<m_solvedProblems.size(); i++)
+        m_problemCapture.capture(*m_solvedProblems[i]->getQPSystem(), *m_solvedProblems[i]->getQPConstraintLists(),
+                                 time, m_solvedObjectives[i], m_solvedIterations[i]);
+    const int events = m_problemCapture.getEvents(infeasible, nbPivots, solveTime);
+    m_problemCapture.endStep();
+    if(!events || m_nbProblemDumps >= d_captureMaxDumps.getValue())
+        return;
+
+    const std::string filename = module::QPProblemCapture::getDumpName(d_captureFile.getFullPath(), m_nbProblemDumps++);
+    const unsigned int nbSteps = m_problemCapture.getNbCapturedSteps();
+    if(!m_problemCapture.dump(filename, d_recordCompression.getValue()))
+        msg_error() << "Cannot open the capture file " << filename << ", the problems are not dumped.";
+    else
+        m_messageQueue.warning(this, s_anomalyMessage) << "Anomaly at time " << time << " (" << module::QPProblemCapture::getEventNames(events)
+                                                       << "), the last " << nbSteps << " problems are dumped in " << filename << ".";
+}
+
+void QPInverseProblemSolver::restoreCheckpoint()
+{
+    m_nbStepsSinceCheckpoint = 0;
+    const std::string& filename = d_checkpointFile.getFullPath();
+    if(filename.empty())
+        return;
+
+    if(!m_checkpoint.read(filename))
+    {
+        std::ifstream file(filename);
+        if(file.is_open())
+            msg_warning() << "The checkpoint " << filename << " is not valid, the solver starts without warm-start state.";
+        return;
+    }
+
+    m_currentCP->restoreCheckpoint(m_checkpoint);
+    if(d_cacheCompliance.getValue())
+        m_complianceCache.restore(m_checkpoint.complianceBlocks);
+    msg_info() << "Warm-start state restored from " << filename << ".";
+    m_checkpoint.clear();
+}
+
+void QPInverseProblemSolver::writeCheckpoint()
+{
+    m_nbStepsSinceCheckpoint = 0;
+    const std::string& filename = d_checkpointFile.getFullPath();
+    if(filename.empty() || !m_currentCP)
+        return;
+
+    m_currentCP->saveCheckpoint(m_checkpoint);
+    if(d_cacheCompliance.getValue())
+        m_complianceCache.save(m_checkpoint.complianceBlocks);
+    if(!m_checkpoint.write(filename))
+        msg_error() << "Cannot write the checkpoint " << filename << ".";
+}
+
+void QPInverseProblemSolver::openTelemetryStream()
+{
+    m_telemetryStream.close();
+    m_telemetrySample = module::QPTelemetryStream::Sample();
+    m_hasTelemetrySample = false;
+    const std::string& name = d_telemetryStream.getValue();
+    if(name.empty())
+        return;
+
+    if(!m_telemetryStream.open(name, d_telemetryStreamCapacity.getValue(), d_telemetryStreamMaxRows.getValue()))
+        msg_warning() << "Cannot create the telemetry stream " << name << ", the steps will not be streamed.";
+}
+
+void QPInverseProblemSolver::openConsensusChannel()
+{
+    m_consensusChannel.close();
+    m_consensus.clear();
+    const std::string& name = d_consensusChannel.getValue();
+    if(name.empty())
+        return;
+
+    if(!m_consensusChannel.open(name, d_consensusNode.getValue(), d_consensusNbNodes.getValue()))
+        msg_warning() << "Cannot open the consensus channel " << name << " as the node " << d_consensusNode.getValue()
+                      << " of " << d_consensusNbNodes.getValue() << ", the coupling contacts are solved in this process only.";
+}
+
+
+void QPInverseProblemSolver::openTrace()
+{
+    m_trace.close();
+    const std::string& filename = d_traceFile.getFullPath();
+    if(filename.empty())
+        return;
+
+    if(!m_trace.open(filename))
+        msg_error() << "Cannot open the trace file " << filename << ", the phases will not be traced.";
+}
+
+void QPInverseProblemSolver::initReducedCompliance()
+{
+    m_reducedCompliance.clear();
+    m_reducedComplianceId = -1;
+    if(d_reducedBasis.getValue().empty() && d_reducedCompliance.getValue().empty())
+        return;
+
+    const string& name = d_reducedConstraintCorrection.getValue();
+    for (unsigned int i = 0; i < m_constraintsCorrections.size() && m_reducedComplianceId < 0; i++)
+        if(name.empty() || m_constraintsCorrections[i]->getName() == name)
+            m_reducedComplianceId = i;
+
+    if(m_reducedComplianceId < 0)
+    {
+        msg_error() << "No constraint correction named " << name << ", the reduced-order compliance is not used.";
+        return;
+    }
+
+    BaseConstraintCorrection* cc = m_constraintsCorrections[m_reducedComplianceId];
+    BaseMechanicalState* mstate = cc->getContext()->getMechanicalState();
+    const unsigned int nbDofs = (mstate)? mstate->getMatrixSize() : 0;
+    if(!m_reducedCompliance.set(d_reducedBasis.getValue(), d_reducedCompliance.getValue(), nbDofs))
+    {
+        msg_error() << "The sizes of reducedBasis (" << d_reducedBasis.getValue().size() << ") and reducedCompliance ("
+                    << d_reducedCompliance.getValue().size() << ") do not match the " << nbDofs << " degrees of freedom of "
+                    << cc->getName() << ", the reduced-order compliance is not used.";
+        m_reducedComplianceId = -1;
+        return;
+    }
+
+    msg_info() << "Reduced-order compliance of " << cc->getName() << " with " << m_reducedCompliance.getNbModes() << " modes.";
+}
+
+void QPInverseProblemSolver::initComplianceTable()
+{
+    m_complianceTable.clear();
+    m_lastActuatorRowIds.clear();
+    m_lastActuatorForces.clear();
+    m_nbComplianceTableHits = 0;
+    m_nbComplianceTableMisses = 0;
+    const std::string& filename = d_complianceTable.getFullPath();
+    if(!filename.empty())
+    {
+        if(!m_complianceTable.load(filename))
+        {
+            msg_error() << "Cannot read the compliance table " << filename << ", the compliance is computed at each step.";
+            m_complianceTable.clear();
+        }
+        else
+            msg_info() << "Compliance table of " << m_complianceTable.getNbSamples() << " samples, "
+                       << m_complianceTable.getNbKeys() << " actuators and " << m_complianceTable.getDim() << " rows.";
+    }
+
+    m_complianceTableRecord.close();
+    const std::string& recordFilename = d_recordComplianceTable.getFullPath();
+    if(recordFilename.empty())
+        return;
+
+    m_complianceTableRecord.open(recordFilename, std::ios::out | std::ios::app);
+    if(!m_complianceTableRecord.is_open())
+        msg_error() << "Cannot open the compliance table " << recordFilename << ", the samples will not be recorded.";
+}
+
+void QPInverseProblemSolver::initRestCompliance()
+{
+    m_restCompliance.unmap();
+    m_isRestStep = true;
+    const std::string& filename = d_restComplianceFile.getFullPath();
+    if(!filename.empty() && m_restCompliance.map(filename))
+        msg_info() << "Compliance of the rest configuration mapped from " << filename << " (" << m_restCompliance.getDim() << " rows).";
+}
+
+uint64_t QPInverseProblemSolver::getRestComplianceKey(const ConstraintParams* cParams)
+{
+    using module::QPMappedCompliance;
+    uint64_t key = QPMappedCompliance::s_hashSeed;
+    auto hashValue = [&key](const auto& value) {key = QPMappedCompliance::hash(&value, sizeof(value), key);};
+
+    // Rows of the problem, and the options that change the entries of W which are computed
+    const module::QPInverseProblem::QPConstraintLists* qpCLists = m_currentCP->getQPConstraintLists();
+    hashValue(uint64_t(m_currentCP->W.rowSize()));
+    for(const vector<unsigned int>* rowIds : {&qpCLists->actuatorRowIds, &qpCLists->effectorRowIds,
+                                              &qpCLists->sensorRowIds, &qpCLists->equalityRowIds})
+    {
+        hashValue(uint64_t(rowIds->size()));
+        key = QPMappedCompliance::hash(rowIds->data(), rowIds->size()*sizeof(unsigned int), key);
+    }
+    hashValue(hasLazySensors());
+    hashValue(d_partialCompliance.getValue());
+    hashValue(m_reducedComplianceId);
+
+    // Constraint corrections, with the constraint Jacobian of their mechanical state
+    for(unsigned int i=0; i<m_constraintsCorrections.size(); i++)
+    {
+        BaseConstraintCorrection* cc = m_constraintsCorrections[i];
+        const string name = cc->getPathName();
+        key = QPMappedCompliance::hash(name.data(), name.size(), key);
+        hashValue(cc->getContext()->getDt());
+        hashValue(bool(cc->isActive() && m_isConstraintCorrectionActive[i]));
+
+        BaseMechanicalState* mstate = cc->getContext()->getMechanicalState();
+        if(!mstate)
+            continue;
+
+        hashValue(uint64_t(mstate->getMatrixSize()));
+        m_restJacobian.clear();
+        module::QPComplianceCache::Recorder J(nullptr, &m_restJacobian);
+        unsigned int offset = 0;
+        mstate->getConstraintJacobian(cParams, &J, offset);
+        hashValue(uint64_t(m_restJacobian.size()));
+        for(const module::QPComplianceCache::Entry& entry : m_restJacobian)
+        {
+            hashValue(entry.i);
+            hashValue(entry.j);
+            hashValue(entry.value);
+        }
+    }
+    return key;
+}
+
+void QPInverseProblemSolver::initThreadAffinity()
+{
+    vector<int> cores = d_threadCores.getValue();
+    const int socket = d_threadSocket.getValue();
+    if(cores.empty() && socket >= 0 && !module::QPThreadAffinity::getNodeCores(socket, cores))
+        msg_warning() << "Cannot read the cores of the NUMA node " << socket << ", the threads are not pinned.";
+
+    if(!cores.empty() && !module::QPThreadAffinity::isSupported())
+    {
+        msg_warning() << "Pinning the threads is not supported on this platform, the threads are not pinned.";
+        cores.clear();
+    }
+
+    m_threadAffinity.setCores(cores);
+}
+
+void QPInverseProblemSolver::initTaskPool()
+{
+    if(d_multithreading.getValue() && d_dedicatedThreadPool.getValue())
+        m_taskPool.init(d_threadPoolSize.getValue());
+    else
+        m_taskPool.stop();
+
+    // The threads of the main task scheduler also run the tasks of the other components
+    int priority = (m_taskPool.isStarted())? d_threadPoolPriority.getValue() : 0;
+    if(priority && !module::QPThreadAffinity::isSupported())
+    {
+        msg_warning() << "Setting the priority of the threads is not supported on this platform, the priority is unchanged.";
+        priority = 0;
+    }
+    m_threadAffinity.setPriority(priority);
+}
+
+sofa::simulation::TaskScheduler* QPInverseProblemSolver::getComplianceTaskScheduler()
+{
+    if(m_taskPool.isStarted())
+        return m_taskPool.getTaskScheduler();
+    return sofa::simulation::MainTaskSchedulerFactory::createInRegistry();
+}
+
+bool QPInverseProblemSolver::getActuationState()
+{
+    // Forces of the actuators at the previous step, if they are in the same rows at this step
+    const module::QPInverseProblem::QPConstraintLists* qpCLists = m_currentCP->getQPConstraintLists();
+    if(!qpCLists->contactRowIds.empty() || qpCLists->actuatorRowIds != m_lastActuatorRowIds)
+        return false;
+
+    m_actuationState = m_lastActuatorForces;
+    return true;
 }
 
 void QPInverseProblemSolver::reinit()
@@ -211,6 +1600,17 @@ void QPInverseProblemSolver::reinit()
     deleteProblems();
     createProblems();
     m_currentCP->init();
+    m_constraintClassification.clear();
+    m_complianceCache.clear();
+    m_changeDetection.clear();
+    m_heldActuators.clear();
+    initReducedCompliance();
+    initComplianceTable();
+    initRestCompliance();
+    initThreadAffinity();
+    initTaskPool();
+    initProblemCapture();
+    initMessageQueue();
 }
 
 void QPInverseProblemSolver::cleanup()
@@ -222,6 +1622,22 @@ void QPInverseProblemSolver::cleanup()
         m_constraintsCorrections.clear();
     }
 
+    stopPipeline();
+    writeCheckpoint();
+    m_recorder.close();
+    m_resultLogger.close();
+    m_problemCapture.close();
+    m_trace.close();
+    m_perfCounters.close();
+    m_isCountersRequested = false;
+    m_profileReport.clear();
+    m_isProfileCounters = false;
+    m_telemetryStream.close();
+    m_consensusChannel.close();
+    m_complianceTableRecord.close();
+    m_taskPool.stop();
+    m_messageQueue.stop();
+
     VectorOperations vop(ExecParams::defaultInstance(), this->getContext());
     vop.v_free(m_lambdaId, false, true);
     vop.v_free(m_dxId, false, true);
@@ -242,6 +1658,23 @@ bool QPInverseProblemSolver::prepareStates(const ConstraintParams *cParams, Mult
 
     m_lastCP = m_currentCP;
 
+    // The problem in flight and the one read by getConstraintProblem() are left untouched
+    if(d_pipelined.getValue())
+    {
+        module::QPInverseProblemImpl** problems[3] = {&m_CP1, &m_CP2, &m_CP3};
+        for(module::QPInverseProblemImpl** problem : problems)
+        {
+            if(*problem == m_lastCP || (*problem && *problem == m_solveWorker.getProblem()))
+                continue;
+            m_currentCP = getProblem(*problem);
+            break;
+        }
+        if(d_moveResolutionState.getValue() && m_currentCP != m_lastCP)
+            m_currentCP->swapResolutionState(*m_lastCP);
+    }
+    else
+        stopPipeline();
+
     m_time = 0.0;
     m_timeTotal = 0.0;
     m_timeScale = 1000.0 / (double)CTime::getTicksPerSec();
@@ -253,7 +1686,7 @@ bool QPInverseProblemSolver::prepareStates(const ConstraintParams *cParams, Mult
         lambda.realloc(&vop,false,true);
         m_lambdaId = lambda.id();
 
-        clearMultiVecId(getContext(), cParams, m_lambdaId);
+        clearConstrainedStates(cParams, m_lambdaId);
     }
 
     {
@@ -261,7 +1694,7 @@ bool QPInverseProblemSolver::prepareStates(const ConstraintParams *cParams, Mult
         dx.realloc(&vop,false,true);
         m_dxId = dx.id();
 
-        clearMultiVecId(getContext(), cParams, m_dxId);
+        clearConstrainedStates(cParams, m_dxId);
     }
 
     if ( d_displayTime.getValue() )
@@ -280,132 +1713,758 @@ bool QPInverseProblemSolver::buildSystem(const ConstraintParams *cParams, MultiV
 
     unsigned int nbLinesTotal = 0;
 
+    updatePerfCounters();
+    beginProfileStep();
+    auto timer = startTimer();
     accumulateConstraint(cParams, nbLinesTotal);
+    m_isMatrixFreeStep = isMatrixFreeStep();
     setConstraintProblemSize(nbLinesTotal);
+    if(d_warmStartContacts.getValue() || d_lazyContactCompliance.getValue() || d_trackContacts.getValue())
+        m_currentCP->updateContactIds(cParams);
+    stopTimer(s_accumulatePhase, timer);
+
+    timer = startTimer();
     computeConstraintViolation(cParams);
+    stopTimer(s_violationPhase, timer);
 
     if (f_printLog.getValue())
-        msg_info() <<nbLinesTotal<<" lines of constraint";
+        m_messageQueue.info(this, s_linesMessage) <<nbLinesTotal<<" lines of constraint";
 
     getConstraintCorrectionState();
+    selectLazyContacts();
 
-    buildCompliance(cParams);
+    timer = startTimer();
+    if(!m_isMatrixFreeStep)
+        assembleCompliance(cParams);
+    stopTimer(s_compliancePhase, timer);
 
     if (d_displayTime.getValue())
     {
-        msg_info() <<"build system in " << ( (double) m_timer.getTime() - m_time)*m_timeScale<<" ms";
+        m_messageQueue.info(this, s_buildTimeMessage) <<"build system in " << ( (double) m_timer.getTime() - m_time)*m_timeScale<<" ms";
         m_time = (double) m_timer.getTime();
     }
 
     return true;
 }
 
-inline void QPInverseProblemSolver::accumulateConstraint(const ConstraintParams *cParams,
-                                                         unsigned int & nbLinesTotal)
+void QPInverseProblemSolver::assembleCompliance(const ConstraintParams *cParams)
 {
-    AdvancedTimer::stepBegin("Accumulate Constraint");
+    const bool hasActuationState = (m_complianceTable.getNbSamples() > 0 || m_complianceTableRecord.is_open())
+                                   && getActuationState();
+    const bool isInterpolated = hasActuationState && m_complianceTable.getNbSamples() > 0
+                                && m_complianceTable.interpolate(m_actuationState, d_complianceTableRadius.getValue(), &m_currentCP->W);
+    if(isInterpolated)
+        m_nbComplianceTableHits++;
+    else if(m_complianceTable.getNbSamples() > 0)
+        m_nbComplianceTableMisses++;
+
+    // The compliance of the first step without contacts can be read from the mapped file
+    const bool isRestCompliance = !isInterpolated && m_isRestStep && !d_restComplianceFile.getValue().empty()
+                                  && m_currentCP->getQPConstraintLists()->contactRowIds.empty();
+    const uint64_t restComplianceKey = (isRestCompliance)? getRestComplianceKey(cParams) : 0;
+    const bool isMapped = isRestCompliance && m_restCompliance.get(restComplianceKey, &m_currentCP->W);
+    m_isRestStep = false;
+
+    if(!isInterpolated && !isMapped)
+    {
+        buildCompliance(cParams);
+        if(d_symmetricCompliance.getValue())
+            module::QPComplianceMatrix::mirrorUpperTriangle(m_currentCP->W);
+        if(hasActuationState && m_complianceTableRecord.is_open())
+            module::QPComplianceTable::writeSample(m_complianceTableRecord, m_actuationState, m_currentCP->W);
+        if(isRestCompliance && !module::QPMappedCompliance::write(d_restComplianceFile.getFullPath(), restComplianceKey, m_currentCP->W))
+            msg_warning() << "Cannot write the compliance of the rest configuration in " << d_restComplianceFile.getFullPath() << ".";
+    }
+}
 
-    // Mechanical action executed from root node to propagate the constraints
-    MechanicalResetConstraintVisitor(cParams).execute(m_context);
+bool QPInverseProblemSolver::isMatrixFreeStep()
+{
+    if(!d_matrixFree.getValue())
+        return false;
+
+    // Options reading or storing W
+    if(d_pipelined.getValue() || isConsensusEnabled() || d_solveOnChange.getValue() || d_decomposeSubproblems.getValue()
+            || d_costAttribution.getValue() || d_sensitivities.getValue() || d_exportDuals.getValue()
+            || d_forwardWithoutEffectors.getValue() || d_reuseConstantRows.getValue() || d_saveMatrices.getValue()
+            || d_cacheCompliance.getValue() || d_incrementalCompliance.getValue() || d_trackContacts.getValue()
+            || d_horizon.getValue() > 1 || d_inverseSolvePeriod.getValue() > 1
+            || m_recorder.isOpen() || m_problemCapture.isEnabled()
+            || m_complianceTable.getNbSamples() > 0 || m_complianceTableRecord.is_open()
+            || !d_restComplianceFile.getValue().empty() || m_reducedComplianceId >= 0
+            || d_energyApproximation.getValue().getSelectedItem() != "Full")
+        return false;
 
-    m_currentCP->clearProblem();
+    for (unsigned int i = 0; i < m_constraintsCorrections.size(); i++)
+        if(!m_constraintsCorrections[i]->getContext()->isSleeping() && m_complianceOperators[i] == nullptr)
+            return false;
 
-    module::QPMechanicalSetConstraint(cParams,
-                              MatrixDerivId::constraintJacobian(),
-                              nbLinesTotal,
-                              m_currentCP).execute(m_context);
+    module::QPConstraintLists* qpCLists = m_currentCP->getQPConstraintLists();
+    qpCLists->updateVariableRows();
+    return module::QPMatrixFreeSolver::isSupported(*qpCLists, d_actuatorsOnly.getValue());
+}
 
-    module::QPMechanicalAccumulateConstraint(cParams,
-                                     MatrixDerivId::constraintJacobian(),
-                                     d_reverseAccumulateOrder.getValue()).execute(m_context);
+void QPInverseProblemSolver::selectLazyContacts()
+{
+    m_hasLazyContacts = false;
+    m_isLazyCompletion = false;
+    m_nbLazyContacts = 0;
 
-    MechanicalParams mparams = MechanicalParams(*cParams);
-    MechanicalProjectJacobianMatrixVisitor(&mparams).execute(m_context);
+    const module::QPInverseProblem::QPConstraintLists* qpCLists = m_currentCP->getQPConstraintLists();
+    if(!d_lazyContactCompliance.getValue() || qpCLists->contactRowIds.empty())
+        return;
 
-    AdvancedTimer::stepEnd("Accumulate Constraint");
+    // Options reading the compliance between the inactive contacts, or solving the problem elsewhere
+    if(d_pipelined.getValue() || isConsensusEnabled() || d_solveOnChange.getValue() || d_decomposeSubproblems.getValue()
+            || d_cacheCompliance.getValue() || d_reuseConstantRows.getValue() || d_multilevelContacts.getValue()
+            || d_contactReduction.getValue() || d_costAttribution.getValue() || d_sensitivities.getValue()
+            || d_exportDuals.getValue() || d_forwardWithoutEffectors.getValue() || d_saveMatrices.getValue()
+            || d_trackContacts.getValue() || d_horizon.getValue() > 1 || d_inverseSolvePeriod.getValue() > 1
+            || m_recorder.isOpen() || m_problemCapture.isEnabled())
+        return;
+
+    const unsigned int contactNbLines = (d_responseFriction.getValue()>0.)? 3 : 1;
+    const vector<unsigned int>& rows = qpCLists->contactRowIds;
+    const bool hasIds = qpCLists->contactIds.size() == rows.size();
+    const double margin = d_lazyContactMargin.getValue();
+    m_lazyContactOfRow.assign(m_currentCP->getDimension(), -1);
+    for(unsigned int k=0; k+contactNbLines<=rows.size(); k+=contactNbLines)
+    {
+        const bool isPredictedActive = m_currentCP->dFree[rows[k]] < margin
+                || (hasIds && m_lastActiveContacts.count(qpCLists->contactIds[k]) > 0);
+        if(isPredictedActive)
+            continue;
+
+        for(unsigned int l=0; l<contactNbLines; l++)
+            m_lazyContactOfRow[rows[k+l]] = k;
+        m_nbLazyContacts++;
+    }
+
+    // A single lazy contact has no entry to defer
+    m_hasLazyContacts = m_nbLazyContacts > 1;
+    if(m_hasLazyContacts)
+    {
+        m_isEagerRow.resize(m_lazyContactOfRow.size());
+        for(unsigned int i=0; i<m_lazyContactOfRow.size(); i++)
+            m_isEagerRow[i] = m_lazyContactOfRow[i] < 0;
+    }
 }
 
-inline void QPInverseProblemSolver::setConstraintProblemSize(const unsigned int &nbLinesTotal)
+bool QPInverseProblemSolver::isLazyContactsSolution() const
 {
-    AdvancedTimer::valSet("numConstraints", nbLinesTotal);
-    m_currentCP->clear(nbLinesTotal);
+    for(unsigned int i=0; i<m_lazyContactOfRow.size(); i++)
+        if(m_lazyContactOfRow[i] >= 0 && m_currentCP->f[i] != 0.)
+            return false;
+    return true;
 }
 
-inline void QPInverseProblemSolver::computeConstraintViolation(const ConstraintParams *cParams)
+void QPInverseProblemSolver::completeLazyContacts(const ConstraintParams *cParams, double& objective, int& iterations)
 {
-    sofa::helper::ScopedAdvancedTimer timer("Get Constraint Value");
-    sofa::component::constraint::lagrangian::solver::MechanicalGetConstraintViolationVisitor(cParams, &m_currentCP->dFree).execute(m_context);
+    m_nbLazyContactMisses++;
+    m_isLazyCompletion = true;
+    buildCompliance(cParams);
+    if(d_symmetricCompliance.getValue())
+        module::QPComplianceMatrix::mirrorUpperTriangle(m_currentCP->W);
+    m_hasLazyContacts = false;
+    m_isLazyCompletion = false;
+
+    m_currentCP->solve(objective, iterations);
 }
 
-inline void QPInverseProblemSolver::getConstraintCorrectionState()
+void QPInverseProblemSolver::storeActiveContacts()
 {
-    for (unsigned int i = 0; i < m_constraintsCorrections.size(); i++)
-        m_isConstraintCorrectionActive[i] = !m_constraintsCorrections[i]->getContext()->isSleeping();
+    m_lastActiveContacts.clear();
+    const module::QPInverseProblem::QPConstraintLists* qpCLists = m_currentCP->getQPConstraintLists();
+    const vector<unsigned int>& rows = qpCLists->contactRowIds;
+    if(qpCLists->contactIds.size() != rows.size())
+        return;
+
+    const unsigned int contactNbLines = (d_responseFriction.getValue()>0.)? 3 : 1;
+    for(unsigned int k=0; k+contactNbLines<=rows.size(); k+=contactNbLines)
+        if(m_currentCP->f[rows[k]] > 0. && qpCLists->contactIds[k].isValid())
+            m_lastActiveContacts.insert(qpCLists->contactIds[k]);
 }
 
-inline void QPInverseProblemSolver::buildCompliance(const ConstraintParams *cParams)
+bool QPInverseProblemSolver::ComplianceProduct::apply(const vector<double>& f, vector<double>& d)
 {
-    AdvancedTimer::stepBegin("Get Compliance");
-    msg_info() << "computeCompliance in "  << m_constraintsCorrections.size()<< " constraintCorrections";
+    d.assign(f.size(), 0.);
+    for (unsigned int i = 0; i < solver->m_constraintsCorrections.size(); i++)
+    {
+        if(!solver->m_isConstraintCorrectionActive[i])
+            continue;
+        if(!solver->m_complianceOperators[i]->addComplianceProduct(cParams, f, d))
+            return false;
+    }
+    return true;
+}
 
-    if(d_multithreading.getValue()){
+inline void QPInverseProblemSolver::accumulateConstraint(const ConstraintParams *cParams,
+                                                         unsigned int & nbLinesTotal)
+{
+    AdvancedTimer::stepBegin("Accumulate Constraint");
 
-        sofa::simulation::TaskScheduler* taskScheduler = sofa::simulation::MainTaskSchedulerFactory::createInRegistry();
-        sofa::simulation::CpuTask::Status status;
+    const unsigned int firstLine = nbLinesTotal;
+    m_isViolationFused = false;
+    if(keepConstantRows(cParams, nbLinesTotal))
+    {
+        findConstrainedStates();
+        AdvancedTimer::stepEnd("Accumulate Constraint");
+        return;
+    }
 
-        sofa::type::vector<QPInverseProblemSolver::ComputeComplianceTask> tasks;
-        sofa::Index nbTasks = m_constraintsCorrections.size();
-        tasks.resize(nbTasks, QPInverseProblemSolver::ComputeComplianceTask(&status));
-        sofa::Index dim = m_currentCP->W.rowSize();
+    // Mechanical action executed from root node to propagate the constraints
+    MechanicalResetConstraintVisitor(cParams).execute(m_context);
 
-        for (sofa::Index i=0; i<nbTasks; i++)
-        {
-            sofa::core::behavior::BaseConstraintCorrection* cc = m_constraintsCorrections[i];
-            if (!cc->isActive())
-                continue;
+    m_currentCP->clearProblem();
+    m_batchedSensors.clear();
+    vector<softrobots::behavior::SoftRobotsBaseConstraint*>* batchedSensors = (d_batchSensors.getValue())? &m_batchedSensors : nullptr;
 
-            tasks[i].set(cc, *cParams, dim);
-            taskScheduler->addTask(&tasks[i]);
+    // Concurrent build (or class contiguous build) into the rows of the previous step, refused when the constraints changed
+    bool isBuilt = false;
+    if(d_multithreading.getValue() || d_classContiguousRows.getValue())
+    {
+        isBuilt = m_parallelSetConstraint.build(cParams,
+                                                MatrixDerivId::constraintJacobian(),
+                                                nbLinesTotal,
+                                                m_currentCP,
+                                                &m_constraintClassification,
+                                                m_context,
+                                                batchedSensors,
+                                                d_multithreading.getValue(),
+                                                d_classContiguousRows.getValue());
+        if(!isBuilt)
+        {
+            MechanicalResetConstraintVisitor(cParams).execute(m_context);
+            m_currentCP->clearProblem();
+            m_batchedSensors.clear();
+            nbLinesTotal = firstLine;
         }
-        taskScheduler->workUntilDone(&status);
+    }
 
-        auto & W = m_currentCP->W;
+    if(!isBuilt)
+    {
+        m_isViolationFused = d_fuseConstraintViolation.getValue();
+        module::QPMechanicalSetConstraint(cParams,
+                                  MatrixDerivId::constraintJacobian(),
+                                  nbLinesTotal,
+                                  m_currentCP,
+                                  &m_constraintClassification,
+                                  batchedSensors,
+                                  (m_isViolationFused)? &m_fusedViolation : nullptr,
+                                  d_lazySensors.getValue()).execute(m_context);
+    }
+    m_constraintClassification.endTraversal();
 
-        // Accumulate the contribution of each constraints
-        // into the system's compliant matrix W
-        for (sofa::Index i = 0; i < nbTasks; i++) {
-            sofa::core::behavior::BaseConstraintCorrection* cc = m_constraintsCorrections[i];
-            if (!cc->isActive())
+    module::QPMechanicalAccumulateConstraint(cParams,
+                                     MatrixDerivId::constraintJacobian(),
+                                     d_reverseAccumulateOrder.getValue()).execute(m_context);
+
+    MechanicalParams mparams = MechanicalParams(*cParams);
+    MechanicalProjectJacobianMatrixVisitor(&mparams).execute(m_context);
+
+    findConstantRows(firstLine);
+    findConstrainedStates();
+
+    AdvancedTimer::stepEnd("Accumulate Constraint");
+}
+
+void QPInverseProblemSolver::findConstantRows(const unsigned int& firstLine)
+{
+    m_hasConstantRows = false;
+    m_constantRows.clear();
+    if(!d_reuseConstantRows.getValue() || d_batchSensors.getValue())
+        return;
+
+    vector<BaseMechanicalState*> states;
+    for(unsigned int i=0; i<m_constraintClassification.getNbEntries(); i++)
+    {
+        sofa::core::behavior::BaseConstraintSet* constraint = m_constraintClassification.getEntry(i).constraint;
+        softrobotsinverse::behavior::ConstantRows* constantRows = dynamic_cast<softrobotsinverse::behavior::ConstantRows*>(constraint);
+        BaseMechanicalState* state = m_constraintClassification.getEntry(i).state;
+        if(!constantRows || !state)
+            return;
+
+        m_constantRows.push_back(constantRows);
+        if(std::find(states.begin(), states.end(), state) == states.end())
+            states.push_back(state);
+    }
+
+    // The mapped rows are only constant through linear mappings
+    m_hasConstantRows = !m_constantRows.empty() && hasLinearMappings(states);
+    m_constantRowsFirstLine = firstLine;
+}
+
+
+bool QPInverseProblemSolver::keepConstantRows(const ConstraintParams* cParams, unsigned int& nbLinesTotal)
+{
+    if(!d_reuseConstantRows.getValue() || !m_hasConstantRows || nbLinesTotal != m_constantRowsFirstLine)
+        return false;
+
+    // Same constraints in the same order, and rows that did not change since the build
+    module::QPMechanicalCollectConstraint(cParams, m_collectedConstraints).execute(m_context);
+    const unsigned int nbEntries = m_constraintClassification.getNbEntries();
+    if(m_collectedConstraints.size() != nbEntries || m_constantRows.size() != nbEntries)
+        return false;
+    for(unsigned int i=0; i<nbEntries; i++)
+        if(m_collectedConstraints[i] != m_constraintClassification.getEntry(i).constraint || !m_constantRows[i]->hasConstantRows())
+            return false;
+
+    m_currentCP->clearProblem();
+    m_batchedSensors.clear();
+    for(unsigned int i=0; i<nbEntries; i++)
+    {
+        const module::QPConstraintClassification::Entry& entry = m_constraintClassification.getEntry(i);
+        m_constantRows[i]->keepRows();
+        module::QPMechanicalSetConstraint::addConstraintRows(m_currentCP, entry, entry.firstLine);
+        nbLinesTotal += entry.nbLines;
+    }
+    m_nbConstantRowsReuses++;
+    return true;
+}
+
+
+void QPInverseProblemSolver::findConstrainedStates()
+{
+    m_constrainedStates.clear();
+    m_hasConstrainedStates = d_clearConstrainedStates.getValue() && m_sequentialCorrections.empty();
+    if(!m_hasConstrainedStates)
+        return;
+
+    // States the constraints are linked to, the constraints without a single state may write anywhere
+    vector<BaseMechanicalState*> states;
+    for(unsigned int i=0; i<m_constraintClassification.getNbEntries(); i++)
+    {
+        const module::QPConstraintClassification::Entry& entry = m_constraintClassification.getEntry(i);
+        if(entry.nbLines == 0)
+            continue;
+
+        BaseMechanicalState* state = entry.state;
+        if(!state)
+        {
+            m_hasConstrainedStates = false;
+            return;
+        }
+        if(std::find(states.begin(), states.end(), state) == states.end())
+            states.push_back(state);
+    }
+    for(softrobots::behavior::SoftRobotsBaseConstraint* sensor : m_batchedSensors)
+    {
+        BaseMechanicalState* state = module::QPConstraintClassification::getConstrainedState(static_cast<sofa::core::behavior::BaseConstraintSet*>(sensor));
+        if(state && std::find(states.begin(), states.end(), state) == states.end())
+            states.push_back(state);
+    }
+
+    // The rows are accumulated in the parents, and the correction of an independent state is computed for all
+    // the states of its ODE solver
+    addParentStates(states);
+    vector<OdeSolver*> solvers;
+    const unsigned int nbStates = states.size();
+    for(unsigned int i=0; i<nbStates; i++)
+    {
+        Node* node = dynamic_cast<Node*>(states[i]->getContext());
+        if(node && node->mechanicalMapping.get())
+            continue;
+
+        OdeSolver* solver = states[i]->getContext()->get<OdeSolver>(BaseContext::SearchUp);
+        if(!solver || std::find(solvers.begin(), solvers.end(), solver) != solvers.end())
+            continue;
+        solvers.push_back(solver);
+
+        vector<BaseMechanicalState*> solverStates;
+        solver->getContext()->get<BaseMechanicalState>(&solverStates, BaseContext::SearchDown);
+        for(BaseMechanicalState* state : solverStates)
+            if(std::find(states.begin(), states.end(), state) == states.end())
+                states.push_back(state);
+    }
+
+    m_constrainedStates.reserve(states.size());
+    for(BaseMechanicalState* state : states)
+        m_constrainedStates.push_back(BaseMechanicalState::SPtr(state));
+}
+
+void QPInverseProblemSolver::findForcelessCorrections()
+{
+    m_isForcelessCorrection.assign(m_constraintsCorrections.size(), false);
+    if(!d_measurementOnlyRows.getValue())
+        return;
+
+    // States receiving a force
+    vector<BaseMechanicalState*> states;
+    const sofa::linearalgebra::FullVector<SReal>& lambda = m_currentCP->f;
+    for(unsigned int i=0; i<m_constraintClassification.getNbEntries(); i++)
+    {
+        const module::QPConstraintClassification::Entry& entry = m_constraintClassification.getEntry(i);
+        const unsigned int firstLine = entry.firstLine;
+        const unsigned int line = firstLine + entry.nbLines;
+        if(entry.type == module::QPConstraintClassification::EFFECTOR || entry.type == module::QPConstraintClassification::SENSOR)
+            continue;
+
+        bool hasForce = (line > (unsigned int)lambda.size());
+        for(unsigned int j=firstLine; !hasForce && j<line; j++)
+            hasForce = (lambda[j] != 0.);
+        if(!hasForce)
+            continue;
+
+        BaseMechanicalState* state = entry.state;
+        if(!state)
+            return;
+        if(std::find(states.begin(), states.end(), state) == states.end())
+            states.push_back(state);
+    }
+    addParentStates(states);
+
+    for(unsigned int i=0; i<m_constraintsCorrections.size(); i++)
+    {
+        BaseMechanicalState* state = m_constraintsCorrections[i]->getContext()->getMechanicalState();
+        m_isForcelessCorrection[i] = state && std::find(states.begin(), states.end(), state) == states.end();
+    }
+}
+
+void QPInverseProblemSolver::clearConstrainedStates(const ConstraintParams *cParams, const MultiVecDerivId& vid)
+{
+    if(!m_hasConstrainedStates)
+    {
+        clearMultiVecId(getContext(), cParams, vid);
+        return;
+    }
+
+    // The other states were not written since they were last cleared
+    for(const BaseMechanicalState::SPtr& state : m_constrainedStates)
+        state->vOp(cParams, vid.getId(state.get()));
+}
+
+inline void QPInverseProblemSolver::setConstraintProblemSize(const unsigned int &nbLinesTotal)
+{
+    AdvancedTimer::valSet("numConstraints", nbLinesTotal);
+
+    // W is not assembled by the matrix-free resolution
+    if(m_isMatrixFreeStep)
+        m_currentCP->clearMatrixFree(nbLinesTotal);
+    // With a partial compliance, only the entries read by the QP are assembled, so only those are cleared
+    else if(d_partialCompliance.getValue() && d_clearComplianceBlocks.getValue())
+    {
+        module::QPComplianceMatrix::getQPVariableRows(m_currentCP->getQPConstraintLists(), nbLinesTotal, m_isQPVariableRow);
+        m_currentCP->clearBlocks(nbLinesTotal, m_isQPVariableRow);
+    }
+    else
+        m_currentCP->clear(nbLinesTotal);
+}
+
+inline void QPInverseProblemSolver::computeConstraintViolation(const ConstraintParams *cParams)
+{
+    sofa::helper::ScopedAdvancedTimer timer("Get Constraint Value");
+
+    // Written with the rows, the sensors left out with lazySensors
+    if(m_isViolationFused)
+    {
+        const unsigned int nbRows = std::min(m_currentCP->dFree.size(), m_fusedViolation.size());
+        std::copy(m_fusedViolation.ptr(), m_fusedViolation.ptr() + nbRows, m_currentCP->dFree.ptr());
+        return;
+    }
+
+    if(hasLazySensors() || d_fuseConstraintViolation.getValue())
+    {
+        // Constraints of the last traversal, in the order of MechanicalGetConstraintViolationVisitor,
+        // without the lazy sensors
+        const bool skipSensors = hasLazySensors();
+        for(unsigned int i=0; i<m_constraintClassification.getNbEntries(); i++)
+        {
+            const module::QPConstraintClassification::Entry& entry = m_constraintClassification.getEntry(i);
+            if(!skipSensors || entry.type != module::QPConstraintClassification::SENSOR)
+                entry.constraint->getConstraintViolation(cParams, &m_currentCP->dFree);
+        }
+        return;
+    }
+
+    sofa::component::constraint::lagrangian::solver::MechanicalGetConstraintViolationVisitor(cParams, &m_currentCP->dFree).execute(m_context);
+}
+
+inline bool QPInverseProblemSolver::hasLazySensors() const
+{
+    return d_lazySensors.getValue() && m_constraintClassification.getNbRows(module::QPConstraintClassification::SENSOR) > 0;
+}
+
+inline void QPInverseProblemSolver::getConstraintCorrectionState()
+{
+    for (unsigned int i = 0; i < m_constraintsCorrections.size(); i++)
+        m_isConstraintCorrectionActive[i] = !m_constraintsCorrections[i]->getContext()->isSleeping();
+}
+
+inline void QPInverseProblemSolver::buildCompliance(const ConstraintParams *cParams)
+{
+    AdvancedTimer::stepBegin("Get Compliance");
+    if (f_printLog.getValue())
+        m_messageQueue.info(this, s_complianceMessage) << "computeCompliance in "  << m_constraintsCorrections.size()<< " constraintCorrections";
+
+    const bool partialCompliance = d_partialCompliance.getValue();
+    if(partialCompliance)
+        module::QPComplianceMatrix::getQPVariableRows(m_currentCP->getQPConstraintLists(),
+                                                      m_currentCP->W.rowSize(),
+                                                      m_isQPVariableRow);
+    const vector<bool>* isQPVariableRow = (partialCompliance)? &m_isQPVariableRow : nullptr;
+
+    const bool lazySensors = hasLazySensors();
+    if(lazySensors)
+        module::QPComplianceMatrix::getSensorRows(m_currentCP->getQPConstraintLists(),
+                                                  m_currentCP->W.rowSize(),
+                                                  m_isSensorRow);
+    const vector<bool>* isSensorRow = (lazySensors)? &m_isSensorRow : nullptr;
+
+    // W being symmetric, its lower triangle is copied from the upper one once assembled
+    const bool upperTriangle = d_symmetricCompliance.getValue();
+
+    // The entries between the lazy contacts are deferred, then only those are added by the completion pass
+    const vector<int>* lazyContactOfRow = (m_hasLazyContacts)? &m_lazyContactOfRow : nullptr;
+
+    // Contributions of unchanged constraint corrections are replayed instead of computed
+    const bool cacheCompliance = d_cacheCompliance.getValue();
+    if(!cacheCompliance)
+        m_complianceCache.clear();
+    const sofa::Index dim = m_currentCP->W.rowSize();
+    m_complianceActions.assign(m_constraintsCorrections.size(), module::QPComplianceCache::Action::Compute);
+
+    // The constraint corrections that batch their contribution solve all the rows of the step at once
+    const bool hasBatchedCorrections = std::any_of(m_batchedCorrections.begin(), m_batchedCorrections.end(),
+                                                   [](const auto* batched){return batched != nullptr;});
+    if(hasBatchedCorrections)
+        m_batchedCompliance.setRows(dim, (m_isLazyCompletion)? &m_isEagerRow : isSensorRow);
+
+    // The constraint correction with a reduced-order compliance forms its contribution from the reduced
+    // system, unless a contact is on its state
+    if(m_reducedComplianceId >= 0 && m_constraintsCorrections[m_reducedComplianceId]->isActive())
+    {
+        m_isContactRow.assign(dim, false);
+        for(unsigned int rowId : m_currentCP->getQPConstraintLists()->contactRowIds)
+            m_isContactRow[rowId] = true;
+
+        BaseConstraintCorrection* cc = m_constraintsCorrections[m_reducedComplianceId];
+        const ConstraintCorrectionNames& names = getConstraintCorrectionNames(m_reducedComplianceId);
+        auto timer = startTimer();
+        if(m_reducedCompliance.update(cc->getContext()->getMechanicalState(), cParams, &m_isContactRow))
+            m_complianceActions[m_reducedComplianceId] = module::QPComplianceCache::Action::Reduced;
+        stopTimer(names.phase, timer);
+    }
+
+    if(cacheCompliance)
+        for (unsigned int i=0; i<m_constraintsCorrections.size(); i++)
+        {
+            BaseConstraintCorrection* cc = m_constraintsCorrections[i];
+            if (!cc->isActive() || m_complianceActions[i] == module::QPComplianceCache::Action::Reduced)
                 continue;
 
-            const auto & Wi = tasks[i].W;
+            module::QPComplianceCache::Action& action = m_complianceActions[i];
+            action = m_complianceCache.update(i, cc, cParams, d_incrementalCompliance.getValue());
+            if (action == module::QPComplianceCache::Action::Splice)
+            {
+                const ConstraintCorrectionNames& names = getConstraintCorrectionNames(i);
+                auto timer = startTimer();
+                if (!m_complianceCache.splice(i, cc, dim))
+                    action = module::QPComplianceCache::Action::Compute;
+                stopTimer(names.phase, timer);
+            }
+        }
+
+    if(d_multithreading.getValue()){
+
+        sofa::simulation::TaskScheduler* taskScheduler = getComplianceTaskScheduler();
+
+        // The tasks keep their buffers from one step to the next
+        vector<QPInverseProblemSolver::ComputeComplianceTask>& tasks = m_complianceTasks;
+        sofa::Index nbTasks = m_constraintsCorrections.size();
+        tasks.resize(nbTasks, QPInverseProblemSolver::ComputeComplianceTask(&m_complianceStatus));
+
+        // In deterministic mode, the contributions are recorded and replayed in the sequential order
+        const bool deterministic = d_deterministic.getValue();
+        if (deterministic)
+            m_orderedEntries.resize(nbTasks);
+
+        for (sofa::Index i=0; i<nbTasks; i++)
+        {
+            sofa::core::behavior::BaseConstraintCorrection* cc = m_constraintsCorrections[i];
+            if (!cc->isActive() || m_complianceActions[i] != module::QPComplianceCache::Action::Compute)
+            {
+                tasks[i].skip();
+                continue;
+            }
+
+            tasks[i].set(cc, *cParams, dim, isQPVariableRow, d_computeTimings.getValue() || m_profileReport.isStepOpen());
+            tasks[i].setTrace(&m_trace, getConstraintCorrectionNames(i).phase);
+            tasks[i].setSkippedRows(isSensorRow);
+            tasks[i].setLazyContacts(lazyContactOfRow, m_isLazyCompletion);
+            tasks[i].setUpperTriangle(upperTriangle);
+            if (hasBatchedCorrections)
+                tasks[i].setBatched(&m_batchedCompliance, m_batchedCorrections[i]);
+            else
+                tasks[i].setBatched(nullptr, nullptr);
+            tasks[i].setThreadAffinity(&m_threadAffinity);
+            vector<module::QPComplianceCache::Entry>* entries = (cacheCompliance)? m_complianceCache.getEntries(i) : nullptr;
+            if (deterministic && !entries)
+            {
+                m_orderedEntries[i].clear();
+                entries = &m_orderedEntries[i];
+            }
+            tasks[i].setRecordedEntries(entries);
+            taskScheduler->addTask(&tasks[i]);
+        }
+        taskScheduler->workUntilDone(&m_complianceStatus);
+
+        if(d_computeTimings.getValue() || m_profileReport.isStepOpen())
+            for (sofa::Index i=0; i<nbTasks; i++)
+                if (m_constraintsCorrections[i]->isActive() && m_complianceActions[i] == module::QPComplianceCache::Action::Compute)
+                {
+                    const string& name = QPTrace::getName(getConstraintCorrectionNames(i).phase);
+                    if(d_computeTimings.getValue())
+                        m_timings.add(name, tasks[i].time);
+                    m_profileReport.addPhase(name, tasks[i].time);
+                }
+
+        // Accumulate the contribution of each constraint correction
+        // into the system's compliant matrix W, each merge task owning a range of rows
+        const sofa::Index nbMergeTasks = std::max<sofa::Index>(1, std::min<sofa::Index>(taskScheduler->getThreadCount(), dim));
+        const sofa::Index nbRowsPerTask = (dim + nbMergeTasks - 1) / nbMergeTasks;
+
+        vector<QPInverseProblemSolver::MergeComplianceTask>& mergeTasks = m_mergeTasks;
+        mergeTasks.resize(nbMergeTasks, QPInverseProblemSolver::MergeComplianceTask(&m_complianceStatus));
+
+        for (sofa::Index k=0; k<nbMergeTasks; k++)
+        {
+            const sofa::Index rowBegin = std::min(dim, k*nbRowsPerTask);
+            const sofa::Index rowEnd = std::min(dim, rowBegin+nbRowsPerTask);
+            mergeTasks[k].set(&m_currentCP->W, &tasks, rowBegin, rowEnd);
+            mergeTasks[k].setThreadAffinity(&m_threadAffinity);
+            mergeTasks[k].setUpperTriangle(upperTriangle);
+            mergeTasks[k].setDeterministic((deterministic)? this : nullptr, isQPVariableRow, isSensorRow);
+            taskScheduler->addTask(&mergeTasks[k]);
+        }
+        taskScheduler->workUntilDone(&m_complianceStatus);
 
-            for (sofa::Index j = 0; j < dim; ++j)
-                for (sofa::Index l = 0; l < dim; ++l)
-                    W.add(j, l, Wi.element(j,l));
+        if (deterministic)
+        {
+            AdvancedTimer::stepEnd("Get Compliance");
+            return;
         }
 
+        module::QPComplianceMatrix partialW(&m_currentCP->W, isQPVariableRow);
+        partialW.setSkippedRows(isSensorRow);
+        partialW.setLazyContacts(lazyContactOfRow, m_isLazyCompletion);
+        partialW.setUpperTriangle(upperTriangle);
+        for (sofa::Index i=0; i<nbTasks; i++)
+            if (m_constraintsCorrections[i]->isActive() && m_complianceActions[i] != module::QPComplianceCache::Action::Compute)
+                addKeptCompliance(i, &partialW);
+
     } else {
+        module::QPComplianceMatrix partialW(&m_currentCP->W, isQPVariableRow);
+        partialW.setSkippedRows(isSensorRow);
+        partialW.setLazyContacts(lazyContactOfRow, m_isLazyCompletion);
+        partialW.setUpperTriangle(upperTriangle);
+        BaseMatrix* W = (partialCompliance || lazySensors || lazyContactOfRow || upperTriangle)? static_cast<BaseMatrix*>(&partialW) : &m_currentCP->W;
+
         for (unsigned int i=0; i<m_constraintsCorrections.size(); i++)
         {
             sofa::core::behavior::BaseConstraintCorrection* cc = m_constraintsCorrections[i];
             if (!cc->isActive())
                 continue;
 
-            sofa::helper::AdvancedTimer::stepBegin("Object name: "+cc->getName());
-            cc->addComplianceInConstraintSpace(cParams, &m_currentCP->W);
-            sofa::helper::AdvancedTimer::stepEnd("Object name: "+cc->getName());
+            if (m_complianceActions[i] != module::QPComplianceCache::Action::Compute)
+            {
+                addKeptCompliance(i, W);
+                continue;
+            }
+
+            const ConstraintCorrectionNames& names = getConstraintCorrectionNames(i);
+            sofa::helper::AdvancedTimer::stepBegin(names.stepName);
+            auto timer = startTimer();
+            vector<module::QPComplianceCache::Entry>* entries = (cacheCompliance)? m_complianceCache.getEntries(i) : nullptr;
+            softrobotsinverse::behavior::BatchedCompliance* batched = m_batchedCorrections[i];
+            if (entries)
+            {
+                module::QPComplianceCache::Recorder recordedW(W, entries);
+                if (!m_batchedCompliance.add(batched, cParams, &recordedW))
+                    cc->addComplianceInConstraintSpace(cParams, &recordedW);
+            }
+            else if (!m_batchedCompliance.add(batched, cParams, W))
+                cc->addComplianceInConstraintSpace(cParams, W);
+            stopTimer(names.phase, timer);
+            sofa::helper::AdvancedTimer::stepEnd(names.stepName);
         }
     }
 
     AdvancedTimer::stepEnd("Get Compliance");
 }
 
+inline void QPInverseProblemSolver::addKeptCompliance(const unsigned int& i, BaseMatrix* W)
+{
+    if (m_complianceActions[i] == module::QPComplianceCache::Action::Reduced)
+    {
+        auto timer = startTimer();
+        m_reducedCompliance.addCompliance(W);
+        stopTimer(getConstraintCorrectionNames(i).phase, timer);
+    }
+    else
+        m_complianceCache.replay(i, W);
+}
+
+void QPInverseProblemSolver::mergeComplianceInOrder(const vector<ComputeComplianceTask>& tasks, BaseMatrix* W,
+                                                    sofa::Index rowBegin, sofa::Index rowEnd,
+                                                    const vector<bool>* isQPVariableRow,
+                                                    const vector<bool>* isSkippedRow)
+{
+    // Same writes, in the same order, as the sequential resolution for each entry of the rows
+    module::QPComplianceMatrix rowsW(W, isQPVariableRow);
+    rowsW.setSkippedRows(isSkippedRow);
+    rowsW.setRowRange(rowBegin, rowEnd);
+    rowsW.setUpperTriangle(d_symmetricCompliance.getValue());
+    if(m_hasLazyContacts)
+        rowsW.setLazyContacts(&m_lazyContactOfRow, m_isLazyCompletion);
+
+    for (unsigned int i=0; i<m_constraintsCorrections.size(); i++)
+    {
+        if (!m_constraintsCorrections[i]->isActive())
+            continue;
+
+        if (m_complianceActions[i] == module::QPComplianceCache::Action::Compute)
+        {
+            for (const module::QPComplianceCache::Entry& entry : *tasks[i].entries)
+            {
+                if (entry.isSet)
+                    rowsW.set(entry.i, entry.j, entry.value);
+                else
+                    rowsW.add(entry.i, entry.j, entry.value);
+            }
+        }
+        else if (m_complianceActions[i] == module::QPComplianceCache::Action::Reduced)
+            m_reducedCompliance.addCompliance(&rowsW);
+        else
+            m_complianceCache.replay(i, &rowsW);
+    }
+}
+
+const QPInverseProblemSolver::ConstraintCorrectionNames& QPInverseProblemSolver::getConstraintCorrectionNames(const unsigned int& i)
+{
+    if(m_constraintCorrectionNames.size() < m_constraintsCorrections.size())
+        m_constraintCorrectionNames.resize(m_constraintsCorrections.size());
+
+    ConstraintCorrectionNames& names = m_constraintCorrectionNames[i];
+    const string& name = m_constraintsCorrections[i]->getName();
+    if(names.stepName.empty() || names.name != name)
+    {
+        names.name = name;
+        names.stepName = "Object name: " + name;
+        names.phase = QPTrace::intern("Compliance: " + name);
+    }
+    return names;
+}
+
 void QPInverseProblemSolver::rebuildSystem(double massFactor, double forceFactor)
 {
-    d_graph.beginEdit()->clear();
+    // The entries of the graph keep their vectors, only their values are removed
+    m_telemetry.clear();
+    for(auto& entry : *d_graph.beginEdit())
+        entry.second.clear();
     d_graph.endEdit();
 
+    // The compliance of the constraint corrections changes with their system
+    m_complianceCache.invalidate();
+
     //rebuildConstraintCorrectionSystem()
     for (unsigned int i=0; i<m_constraintsCorrections.size(); i++)
     {
@@ -419,162 +2478,1425 @@ bool QPInverseProblemSolver::solveSystem(const ConstraintParams * cParams,
                                          MultiVecId res2)
 {
 
-    SOFA_UNUSED(cParams);
     SOFA_UNUSED(res1);
     SOFA_UNUSED(res2);
 
 
+    m_complianceProduct.set(this, cParams);
     double time = getContext()->getTime();
-    m_currentCP->setTime(time);
-    m_currentCP->setEpsilon(d_epsilon.getValue());
-    m_currentCP->setEnergyActuatorsOnly(d_actuatorsOnly.getValue());
-    m_currentCP->setTolerance(d_tolerance.getValue());
-    m_currentCP->setMaxIterations(d_maxIterations.getValue());
-    m_currentCP->setFrictionCoeff(d_responseFriction.getValue());
-    m_currentCP->allowSliding(d_allowSliding.getValue());
-    if(d_minContactForces.isSet()) m_currentCP->setMinContactForces(d_minContactForces.getValue());
-    if(d_maxContactForces.isSet()) m_currentCP->setMaxContactForces(d_maxContactForces.getValue());
+    setProblemParameters(m_currentCP, time);
+
+    const unsigned int contactNbLines = (d_responseFriction.getValue()>0.)? 3 : 1;
+    const bool decompose = d_decomposeSubproblems.getValue() && !isConsensusEnabled() && !m_isMatrixFreeStep &&
+            m_decomposition.compute(m_currentCP, contactNbLines) > 1;
 
     double objective;
     int iterations;
+    double solveTime = 0.;
     {
         sofa::helper::ScopedAdvancedTimer("ConstraintsQP");
-        m_currentCP->solve(objective, iterations);
+        auto timer = startTimer();
+        if(decompose)
+        {
+            stopPipeline();
+            m_changeDetection.clear();
+            m_heldActuators.clear();
+            solveSubproblems(time, objective, iterations);
+        }
+        else if(isConsensusEnabled() || !d_pipelined.getValue() || !solvePipelined(objective, iterations))
+        {
+            if(isConsensusEnabled())
+                solveConsensus(objective, iterations);
+            else if(!solveForwardStep(objective, iterations))
+            {
+                solveOnChange(objective, iterations);
+                if(m_hasLazyContacts && !isLazyContactsSolution())
+                    completeLazyContacts(cParams, objective, iterations);
+                holdActuation();
+            }
+            m_solvedProblems.assign(1, m_currentCP);
+            m_solvedObjectives.assign(1, objective);
+            m_solvedIterations.assign(1, iterations);
+
+            if(d_pipelined.getValue())
+            {
+                m_pipelinedCP = m_currentCP;
+                m_pipelinedObjective = objective;
+                m_pipelinedIterations = iterations;
+            }
+        }
+        if(m_problemCapture.isEnabled())
+            solveTime = (double)(CTime::getTime() - timer.start)*m_timeScale;
+        stopTimer(s_solvePhase, timer);
+    }
 
+    if(d_computeTimings.getValue() || m_telemetryStream.isOpen())
+    {
+        module::QPInverseProblemImpl::QPPhaseTimes phaseTimes;
+        for(module::QPInverseProblemImpl* problem : m_solvedProblems)
+        {
+            phaseTimes.build += problem->getPhaseTimes().build;
+            phaseTimes.lcp += problem->getPhaseTimes().lcp;
+            phaseTimes.qp += problem->getPhaseTimes().qp;
+        }
+        if(d_computeTimings.getValue())
+        {
+            m_timings.add("QP build", phaseTimes.build);
+            m_timings.add("LCP", phaseTimes.lcp);
+            m_timings.add("QPs", phaseTimes.qp);
+        }
+        m_telemetrySample.phaseTimes[module::QPTelemetryStream::QPBuildPhase] = phaseTimes.build;
+        m_telemetrySample.phaseTimes[module::QPTelemetryStream::LCPPhase] = phaseTimes.lcp;
+        m_telemetrySample.phaseTimes[module::QPTelemetryStream::QPsPhase] = phaseTimes.qp;
     }
 
     module::QPInverseProblem::QPConstraintLists* qpCLists = m_currentCP->getQPConstraintLists();
 
-    map<string, vector<SReal>>& graph = *d_graph.beginEdit();
-    vector<SReal>& graph_effectors = graph[string("#Effectors:")];
-    graph_effectors.clear();
-    graph_effectors.push_back(qpCLists->effectorRowIds.size());
+    if(d_lazyContactCompliance.getValue())
+        storeActiveContacts();
+
+    // Actuation state of the next step, for the compliance table
+    m_lastActuatorRowIds = qpCLists->actuatorRowIds;
+    m_lastActuatorForces.resize(qpCLists->actuatorRowIds.size());
+    for(unsigned int k=0; k<qpCLists->actuatorRowIds.size(); k++)
+        m_lastActuatorForces[k] = m_currentCP->f[qpCLists->actuatorRowIds[k]];
+
+    m_telemetry.beginStep();
+    m_telemetry.set(module::QPTelemetry::NbEffectors, qpCLists->effectorRowIds.size());
+    m_telemetry.set(module::QPTelemetry::NbActuators, qpCLists->actuatorRowIds.size());
+    m_telemetry.set(module::QPTelemetry::NbEquality, qpCLists->equalityRowIds.size());
+    m_telemetry.set(module::QPTelemetry::NbContacts, qpCLists->contactRowIds.size());
+    m_telemetry.set(module::QPTelemetry::LastObjective, objective);
+    d_objective.setValue(objective);
 
-    vector<SReal>& graph_actuators = graph[string("#Actuators:")];
-    graph_actuators.clear();
-    graph_actuators.push_back(qpCLists->actuatorRowIds.size());
+    m_telemetry.set(module::QPTelemetry::LastIterations, iterations);
 
-    vector<SReal>& graph_equality = graph[string("#Equality:")];
-    graph_equality.clear();
-    graph_equality.push_back(qpCLists->equalityRowIds.size());
+    // Working set changes and limits, the largest over the subproblems
+    int maxNbWorkingSetChanges = 0, pivotLimit = 0, workingSetLimit = 0;
+    unsigned int nbWorkingSetLimitHits = 0, nbPriorityLevels = 0;
+    for(module::QPInverseProblemImpl* problem : m_solvedProblems)
+    {
+        nbPriorityLevels = std::max(nbPriorityLevels, problem->getNbPriorityLevels());
+        maxNbWorkingSetChanges = std::max(maxNbWorkingSetChanges, problem->getMaxNbWorkingSetChanges());
+        pivotLimit = std::max(pivotLimit, problem->getPivotLimit());
+        workingSetLimit = std::max(workingSetLimit, problem->getWorkingSetLimit());
+        nbWorkingSetLimitHits += problem->getNbWorkingSetLimitHits();
+    }
 
-    vector<SReal>& graph_contacts = graph[string("#Contacts:")];
-    graph_contacts.clear();
-    graph_contacts.push_back(qpCLists->contactRowIds.size());
+    m_telemetry.set(module::QPTelemetry::MaxNbWorkingSetChanges, maxNbWorkingSetChanges);
+    if(nbPriorityLevels > 0)
+        m_telemetry.set(module::QPTelemetry::NbPriorityLevels, nbPriorityLevels);
 
-    vector<SReal>& graph_error = graph[string("Last Objective:")];
-    graph_error.clear();
-    graph_error.push_back(objective);
-    d_objective.setValue(objective);
+    if(d_adaptiveLimits.getValue())
+    {
+        m_telemetry.set(module::QPTelemetry::PivotLimit, pivotLimit);
+        m_telemetry.set(module::QPTelemetry::WorkingSetLimit, workingSetLimit);
+        m_telemetry.set(module::QPTelemetry::NbWorkingSetLimitHits, nbWorkingSetLimitHits);
+    }
 
-    vector<SReal>& graph_it = graph[string("Last Iterations:")];
-    graph_it.clear();
-    graph_it.push_back(iterations);
+    if(decompose)
+        m_telemetry.set(module::QPTelemetry::NbSubproblems, m_solvedProblems.size());
+
+    unsigned int nbHotStartHits = 0, nbHotStartMisses = 0, nbDeadlineHits = 0, nbWarmStartedContacts = 0;
+    unsigned int nbReducedContacts = 0, nbContactFreeHotStarts = 0, nbContactFreeFactorizationReuses = 0;
+    unsigned int nbParametricHotStarts = 0, nbParametricFactorizations = 0;
+    unsigned int nbPresolvedRows = 0, nbEqualityEliminations = 0, nbActiveSetCacheHits = 0, nbActiveSetCacheMisses = 0;
+    unsigned int nbPrimalWarmStarts = 0, nbSmallProblemSolves = 0, nbContactPatches = 0, nbRefinedPatches = 0;
+    unsigned int nbComplianceProducts = 0, nbInteriorSolves = 0, nbDeadbandEffectors = 0;
+    unsigned int nbTrackedContacts = 0, nbNewContacts = 0;
+    module::QPInverseProblemImpl::QPOASESStatistics qpOASESStatistics;
+    unsigned int nbBackendSelections[module::QPBackendSelector::NbBackends]{};
+    bool hasDeadbands = false;
+    double epsilonScale = 0.;
+    bool deadlineHit = false;
+    module::QPInverseProblemImpl::QPRecovery recovery = module::QPInverseProblemImpl::QPRecovery::None;
+    for(module::QPInverseProblemImpl* problem : m_solvedProblems)
+    {
+        recovery = std::max(recovery, problem->getRecovery());
+        nbWarmStartedContacts += problem->getNbWarmStartedContacts();
+        nbTrackedContacts += problem->getNbTrackedContacts();
+        nbNewContacts += problem->getNbNewContacts();
+        const module::QPInverseProblemImpl::QPOASESStatistics& statistics = problem->getQPOASESStatistics();
+        qpOASESStatistics.nbResolutions += statistics.nbResolutions;
+        qpOASESStatistics.nbWorkingSetChanges += statistics.nbWorkingSetChanges;
+        qpOASESStatistics.nbBoundFlips += statistics.nbBoundFlips;
+        qpOASESStatistics.nbFactorizations += statistics.nbFactorizations;
+        qpOASESStatistics.nbFactorizationUpdates += statistics.nbFactorizationUpdates;
+        qpOASESStatistics.nbRampings += statistics.nbRampings;
+        qpOASESStatistics.nbRegularizations += statistics.nbRegularizations;
+        qpOASESStatistics.nbIndefiniteFallbacks += statistics.nbIndefiniteFallbacks;
+        for(unsigned int b=0; b<module::QPBackendSelector::NbBackends; b++)
+            nbBackendSelections[b] += problem->getNbBackendSelections(module::QPBackendSelector::Backend(b));
+        nbReducedContacts += problem->getNbReducedContacts();
+        nbPresolvedRows += problem->getNbPresolvedRows();
+        nbEqualityEliminations += problem->getNbEqualityEliminations();
+        nbActiveSetCacheHits += problem->getNbActiveSetCacheHits();
+        nbActiveSetCacheMisses += problem->getNbActiveSetCacheMisses();
+        nbPrimalWarmStarts += problem->getNbPrimalWarmStarts();
+        nbSmallProblemSolves += problem->getNbSmallProblemSolves();
+        nbInteriorSolves += problem->getNbInteriorSolves();
+        nbDeadbandEffectors += problem->getNbDeadbandEffectors();
+        hasDeadbands = hasDeadbands || !problem->getQPConstraintLists()->effectorDeadbands.empty();
+        nbComplianceProducts += problem->getNbComplianceProducts();
+        nbContactPatches += problem->getNbContactPatches();
+        nbRefinedPatches += problem->getNbRefinedPatches();
+        epsilonScale = std::max(epsilonScale, problem->getEpsilonScale());
+        nbHotStartHits += problem->getNbHotStartHits();
+        nbHotStartMisses += problem->getNbHotStartMisses();
+        nbContactFreeHotStarts += problem->getNbContactFreeHotStarts();
+        nbParametricHotStarts += problem->getNbParametricHotStarts();
+        nbParametricFactorizations += problem->getNbParametricFactorizations();
+        nbContactFreeFactorizationReuses += problem->getNbContactFreeFactorizationReuses();
+        nbDeadlineHits += problem->getNbDeadlineHits();
+        deadlineHit = deadlineHit || problem->hasHitDeadline();
+    }
 
-    if (f_printLog.getValue())
+    if(d_hotStart.getValue())
     {
-        int count = d_countdownFilterStartPerturb.getValue();
-        m_currentCP->displayQNormVariation(count);
-        d_countdownFilterStartPerturb.setValue(count);
-        m_currentCP->displayQPSystem();
+        m_telemetry.set(module::QPTelemetry::NbHotStartHits, nbHotStartHits);
+        m_telemetry.set(module::QPTelemetry::NbHotStartMisses, nbHotStartMisses);
     }
 
-    if ( d_displayTime.getValue() )
+    if(d_contactFreeHotStart.getValue())
     {
-        msg_info() <<" TOTAL solve QP " <<( (double) m_timer.getTime() - m_time)*m_timeScale<<" ms";
-        m_time = (double) m_timer.getTime();
+        m_telemetry.set(module::QPTelemetry::NbContactFreeHotStarts, nbContactFreeHotStarts);
+        m_telemetry.set(module::QPTelemetry::NbContactFreeFactorizationReuses, nbContactFreeFactorizationReuses);
     }
 
-    if(f_printLog.getValue())
-        m_currentCP->displayResult();
+    if(d_parametricQP.getValue())
+    {
+        m_telemetry.set(module::QPTelemetry::NbParametricHotStarts, nbParametricHotStarts);
+        m_telemetry.set(module::QPTelemetry::NbParametricFactorizations, nbParametricFactorizations);
+    }
 
-    if(d_saveMatrices.getValue())
-        m_currentCP->saveMatricesToFile();
+    if(d_warmStartContacts.getValue())
+        m_telemetry.set(module::QPTelemetry::NbWarmStartedContacts, nbWarmStartedContacts);
 
+    if(d_trackContacts.getValue())
+    {
+        m_telemetry.set(module::QPTelemetry::NbTrackedContacts, nbTrackedContacts);
+        m_telemetry.set(module::QPTelemetry::NbNewContacts, nbNewContacts);
+    }
 
-    return true;
-}
+    // Only published for the steps solved with qpOASES (not by another backend or a fast path)
+    if(qpOASESStatistics.nbResolutions > 0)
+    {
+        m_telemetry.set(module::QPTelemetry::NbQPOASESResolutions, qpOASESStatistics.nbResolutions);
+        m_telemetry.set(module::QPTelemetry::NbWorkingSetChanges, qpOASESStatistics.nbWorkingSetChanges);
+        m_telemetry.set(module::QPTelemetry::NbBoundFlips, qpOASESStatistics.nbBoundFlips);
+        m_telemetry.set(module::QPTelemetry::NbFactorizations, qpOASESStatistics.nbFactorizations);
+        m_telemetry.set(module::QPTelemetry::NbFactorizationUpdates, qpOASESStatistics.nbFactorizationUpdates);
+        m_telemetry.set(module::QPTelemetry::NbRampings, qpOASESStatistics.nbRampings);
+        m_telemetry.set(module::QPTelemetry::NbRegularizations, qpOASESStatistics.nbRegularizations);
+        m_telemetry.set(module::QPTelemetry::NbIndefiniteFallbacks, qpOASESStatistics.nbIndefiniteFallbacks);
+    }
 
+    if(d_qpSolver.getValue().getSelectedItem() == "Adaptive")
+    {
+        m_telemetry.set(module::QPTelemetry::NbInteriorSelections, nbBackendSelections[module::QPBackendSelector::Interior]);
+        m_telemetry.set(module::QPTelemetry::NbSmallKernelSelections, nbBackendSelections[module::QPBackendSelector::SmallKernel]);
+        m_telemetry.set(module::QPTelemetry::NbActiveSetSelections, nbBackendSelections[module::QPBackendSelector::ActiveSet]);
+        m_telemetry.set(module::QPTelemetry::NbADMMSelections, nbBackendSelections[module::QPBackendSelector::ADMM]);
+    }
 
-void QPInverseProblemSolver::computeResidual(const ExecParams* eparam)
-{
-    for (unsigned int i=0; i<m_constraintsCorrections.size(); i++)
+    if(d_activeSetCacheSize.getValue()>0)
     {
-        BaseConstraintCorrection* CC = m_constraintsCorrections[i];
-        CC->computeResidual(eparam,&m_currentCP->f);
+        m_telemetry.set(module::QPTelemetry::NbActiveSetCacheHits, nbActiveSetCacheHits);
+        m_telemetry.set(module::QPTelemetry::NbActiveSetCacheMisses, nbActiveSetCacheMisses);
     }
-}
 
-bool QPInverseProblemSolver::applyCorrection(const ConstraintParams *cParams, MultiVecId res1, MultiVecId res2)
-{
-    AdvancedTimer::stepBegin("Compute And Apply Motion Correction");
+    if(d_primalWarmStart.getValue())
+        m_telemetry.set(module::QPTelemetry::NbPrimalWarmStarts, nbPrimalWarmStarts);
 
-    if (cParams->constOrder() == ConstraintParams::POS_AND_VEL)
+    if(d_adaptiveEpsilon.getValue())
+        m_telemetry.set(module::QPTelemetry::EpsilonScale, epsilonScale);
+
+    if(d_smallProblemKernel.getValue())
+        m_telemetry.set(module::QPTelemetry::NbSmallProblemSolves, nbSmallProblemSolves);
+
+    if(d_interiorFastPath.getValue())
+        m_telemetry.set(module::QPTelemetry::NbInteriorSolves, nbInteriorSolves);
+
+    if(hasDeadbands)
+        m_telemetry.set(module::QPTelemetry::NbDeadbandEffectors, nbDeadbandEffectors);
+
+    if(d_asyncMessages.getValue() || d_messageInterval.getValue() > 0.)
     {
-        MultiVecCoordId xId(res1);
-        MultiVecDerivId vId(res2);
-        for (unsigned int i = 0; i < m_constraintsCorrections.size(); i++)
-        {
-            if (!m_isConstraintCorrectionActive[i])
-                continue;
+        m_telemetry.set(module::QPTelemetry::NbSuppressedMessages, m_messageQueue.getNbSuppressed());
+        m_telemetry.set(module::QPTelemetry::NbDroppedMessages, m_messageQueue.getNbDropped());
+    }
 
-            BaseConstraintCorrection* cc = m_constraintsCorrections[i];
-            if (!cc->isActive())
-                continue;
+    if(d_matrixFree.getValue())
+        m_telemetry.set(module::QPTelemetry::NbComplianceProducts, nbComplianceProducts);
 
-            cc->computeMotionCorrectionFromLambda(cParams, getDx(), &m_currentCP->f);
-            cc->applyMotionCorrection(cParams, xId, vId, cParams->dx(), getDx());
-        }
+    if(d_contactReduction.getValue())
+        m_telemetry.set(module::QPTelemetry::NbReducedContacts, nbReducedContacts);
+
+    if(isConsensusEnabled())
+        m_telemetry.set(module::QPTelemetry::NbConsensusIterations, m_consensus.getNbIterations());
+
+    if(d_multilevelContacts.getValue())
+    {
+        m_telemetry.set(module::QPTelemetry::NbContactPatches, nbContactPatches);
+        m_telemetry.set(module::QPTelemetry::NbRefinedPatches, nbRefinedPatches);
     }
-    else if (cParams->constOrder() == ConstraintParams::POS)
+
+    if(d_presolve.getValue())
+        m_telemetry.set(module::QPTelemetry::NbPresolvedRows, nbPresolvedRows);
+
+    if(d_equalityElimination.getValue())
+        m_telemetry.set(module::QPTelemetry::NbEqualityEliminations, nbEqualityEliminations);
+
+    if(!qpCLists->contactRowIds.empty())
     {
-        MultiVecCoordId xId(res1);
-        for (unsigned int i = 0; i < m_constraintsCorrections.size(); i++)
+        // Pivots of the subproblems are summed by iteration
+        vector<SReal>& pivotSeries = m_telemetry.getSeries(module::QPTelemetry::PivotsPerIteration);
+        unsigned int nbFallbacks = 0, nbPivotCycles = 0, nbSpeculativePivots = 0;
+        for(module::QPInverseProblemImpl* problem : m_solvedProblems)
         {
-            if (!m_isConstraintCorrectionActive[i])
-                continue;
+            const vector<unsigned int>& pivots = problem->getPivotsPerIteration();
+            if(pivotSeries.size() < pivots.size())
+                pivotSeries.resize(pivots.size(), 0);
+            for(unsigned int i=0; i<pivots.size(); i++)
+                pivotSeries[i] += pivots[i];
+            nbFallbacks += problem->getNbSinglePivotFallbacks();
+            nbPivotCycles += problem->getNbPivotCycles();
+            nbSpeculativePivots += problem->getNbSpeculativePivots();
+        }
 
-            BaseConstraintCorrection* cc = m_constraintsCorrections[i];
-            if (!cc->isActive())
-                continue;
+        m_telemetry.set(module::QPTelemetry::NbPivotCycles, nbPivotCycles);
+        if(d_speculativePivots.getValue() > 1)
+            m_telemetry.set(module::QPTelemetry::NbSpeculativePivots, nbSpeculativePivots);
 
-            cc->computeMotionCorrectionFromLambda(cParams, getDx(), &m_currentCP->f);
-            cc->applyPositionCorrection(cParams, xId, cParams->dx(), getDx());
-        }
+        if(d_pivoting.getValue().getSelectedItem() == "Block")
+            m_telemetry.set(module::QPTelemetry::NbSinglePivotFallbacks, nbFallbacks);
     }
-    else if (cParams->constOrder() == ConstraintParams::VEL)
+
+    // Report of the contact solver with friction, the iterations and errors of the subproblems are summed
+    bool hasSolvedNLCP = false;
+    unsigned int nbNLCPIterations = 0, nbNLCPNotConverged = 0;
+    double nlcpError = 0.;
+    vector<SReal>* nlcpResiduals = nullptr;
+    for(module::QPInverseProblemImpl* problem : m_solvedProblems)
     {
-        MultiVecDerivId vId(res1);
-        for (unsigned int i = 0; i < m_constraintsCorrections.size(); i++)
-        {
-            if (!m_isConstraintCorrectionActive[i])
-                continue;
+        if(!problem->hasSolvedNLCP())
+            continue;
+
+        const module::NLCPSolver* nlcp = problem->getNLCPSolver();
+        if(!hasSolvedNLCP)
+            nlcpResiduals = &m_telemetry.getSeries(module::QPTelemetry::NLCPResiduals);
+        hasSolvedNLCP = true;
+        nbNLCPIterations += nlcp->getNbIterations();
+        nlcpError += nlcp->getError();
+        nbNLCPNotConverged += (nlcp->hasConverged())? 0 : 1;
+
+        const sofa::type::vector<double>& residuals = nlcp->getResidualHistory();
+        if(nlcpResiduals->size() < residuals.size())
+            nlcpResiduals->resize(residuals.size(), 0.);
+        for(unsigned int i=0; i<residuals.size(); i++)
+            (*nlcpResiduals)[i] += residuals[i];
+    }
 
-            BaseConstraintCorrection* cc = m_constraintsCorrections[i];
-            if (!cc->isActive())
-                continue;
+    if(hasSolvedNLCP)
+    {
+        m_telemetry.set(module::QPTelemetry::NLCPIterations, nbNLCPIterations);
+        m_telemetry.set(module::QPTelemetry::NLCPError, nlcpError);
+        m_telemetry.set(module::QPTelemetry::NbNLCPNotConverged, nbNLCPNotConverged);
+    }
 
-            cc->computeMotionCorrectionFromLambda(cParams, getDx(), &m_currentCP->f);
-            cc->applyVelocityCorrection(cParams, vId, cParams->dx(), getDx());
-        }
+    d_deadlineHit.setValue(deadlineHit);
+    d_qpRecovery.setValue(module::QPInverseProblemImpl::getRecoveryName(recovery));
+    if(d_timeBudget.getValue()>0.)
+        m_telemetry.set(module::QPTelemetry::NbDeadlineHits, nbDeadlineHits);
+
+    if(d_lazyContactCompliance.getValue())
+    {
+        m_telemetry.set(module::QPTelemetry::NbLazyContacts, m_nbLazyContacts);
+        m_telemetry.set(module::QPTelemetry::NbLazyContactMisses, m_nbLazyContactMisses);
     }
 
-    AdvancedTimer::stepEnd("Compute And Apply Motion Correction");
+    if(m_complianceTable.getNbSamples() > 0)
+    {
+        m_telemetry.set(module::QPTelemetry::NbComplianceTableHits, m_nbComplianceTableHits);
+        m_telemetry.set(module::QPTelemetry::NbComplianceTableMisses, m_nbComplianceTableMisses);
+    }
 
-    AdvancedTimer::stepBegin("Store Constraint Lambdas");
-    /// Some constraint correction schemes may have written the constraint motion space lambda in the lambdaId VecId.
-    /// In order to be sure that we are not accumulating things twice, we need to clear.
-    clearMultiVecId(getContext(), cParams, m_lambdaId);
+    if(d_solveOnChange.getValue())
+        m_telemetry.set(module::QPTelemetry::NbSkippedSolves, m_changeDetection.getNbSkippedSolves());
+    if(d_inverseSolvePeriod.getValue() > 1)
+        m_telemetry.set(module::QPTelemetry::NbForwardSteps, m_nbForwardSteps);
+    if(d_reuseConstantRows.getValue())
+        m_telemetry.set(module::QPTelemetry::NbConstantRowsReuses, m_nbConstantRowsReuses);
+
+    m_telemetry.setHistoryLength(d_telemetryHistory.getValue());
+    m_telemetry.endStep();
+    fillProfileStep();
+    if(d_publishInfo.getValue())
+    {
+        m_telemetry.writeGraph(*d_graph.beginEdit());
+        d_graph.endEdit();
+    }
 
-    /// Store lambda and accumulate.
-    ConstraintStoreLambdaVisitor v(cParams, &m_currentCP->f);
-    this->getContext()->executeVisitor(&v);
-    AdvancedTimer::stepEnd("Store Constraint Lambdas");
+    publishCosts();
+    publishDuals(decompose);
+    publishSensitivities(decompose);
+    publishMemoryUsage();
+    if(m_telemetryStream.isOpen())
+        fillTelemetrySample(time, objective, iterations);
 
+    const unsigned int nbRows = m_currentCP->getDimension();
+    if(m_resultLogger.isOpen() && m_currentCP->getQPSystem()->delta.size() >= nbRows)
+        m_resultLogger.log(time, nbRows, m_currentCP->f.ptr(), m_currentCP->getQPSystem()->delta.data(),
+                           m_currentCP->dFree.ptr(), *qpCLists);
 
-    if (d_displayTime.getValue())
-        msg_info() << "TotalTime " << ((double) m_timerTotal.getTime() - m_timeTotal) * m_timeScale << " ms" ;
-    return true;
+    if(d_checkpointPeriod.getValue() > 0 && ++m_nbStepsSinceCheckpoint >= d_checkpointPeriod.getValue())
+        writeCheckpoint();
+
+    if (f_printLog.getValue())
+    {
+        int count = d_countdownFilterStartPerturb.getValue();
+        for(module::QPInverseProblemImpl* problem : m_solvedProblems)
+        {
+            problem->displayQNormVariation(count);
+            problem->displayQPSystem();
+        }
+        d_countdownFilterStartPerturb.setValue(count);
+    }
+
+    if ( d_displayTime.getValue() )
+    {
+        m_messageQueue.info(this, s_solveTimeMessage) <<" TOTAL solve QP " <<( (double) m_timer.getTime() - m_time)*m_timeScale<<" ms";
+        m_time = (double) m_timer.getTime();
+    }
+
+    if(f_printLog.getValue())
+        m_currentCP->displayResult();
+
+    // When the problem is decomposed, each subproblem is saved (and recorded) as a step of its own
+    for(unsigned int i=0; i<m_solvedProblems.size(); i++)
+    {
+        module::QPInverseProblemImpl* problem = m_solvedProblems[i];
+        if(d_saveMatrices.getValue())
+            problem->saveMatricesToFile(i>0);
+
+        if(m_recorder.isOpen())
+            m_recorder.record(*problem->getQPSystem(), *problem->getQPConstraintLists(), time,
+                              m_solvedObjectives[i], m_solvedIterations[i]);
+    }
+
+    if(m_problemCapture.isEnabled())
+        captureProblems(time, recovery != module::QPInverseProblemImpl::QPRecovery::None, iterations, solveTime);
+
+    return true;
+}
+
+
+void QPInverseProblemSolver::setProblemParameters(module::QPInverseProblemImpl* problem, const double& time)
+{
+    problem->setTime(time);
+    problem->setEpsilon(d_epsilon.getValue());
+    problem->setAdaptiveEpsilon(d_adaptiveEpsilon.getValue(), d_adaptiveEpsilonMinConditioning.getValue(),
+                                d_adaptiveEpsilonMaxConditioning.getValue());
+    problem->setEnergyActuatorsOnly(d_actuatorsOnly.getValue());
+    problem->setEnergyApproximation(d_energyApproximation.getValue().getSelectedItem());
+    problem->setTolerance(d_tolerance.getValue());
+    problem->setMaxIterations(d_maxIterations.getValue());
+    problem->setMaxNbPivots(d_maxNbPivots.getValue());
+    problem->setMaxNbWorkingSetChanges(d_maxNbWorkingSetChanges.getValue());
+    problem->setAdaptiveLimits(d_adaptiveLimits.getValue(), d_adaptiveLimitsPercentile.getValue(), d_adaptiveLimitsMargin.getValue());
+    problem->setFrictionCoeff(d_responseFriction.getValue());
+    problem->allowSliding(d_allowSliding.getValue());
+    problem->setNbFrictionFacets(d_frictionFacets.getValue());
+    problem->setLazySensors(hasLazySensors());
+    problem->setConcurrentResults(d_concurrentResults.getValue() && d_multithreading.getValue());
+    problem->setHotStart(d_hotStart.getValue());
+    problem->setContactFreeHotStart(d_contactFreeHotStart.getValue());
+    problem->setParametricQP(d_parametricQP.getValue(), d_parametricThreshold.getValue());
+    problem->setReuseHessian(d_reuseHessian.getValue());
+    problem->setCondensedEffectors(d_condensedEffectors.getValue());
+    problem->setEffectorSketch(d_effectorSketchSize.getValue());
+    problem->setWarmStartContacts(d_warmStartContacts.getValue());
+    problem->setTrackContacts(d_trackContacts.getValue());
+    problem->setTrackContactsTolerance(d_trackContactsTolerance.getValue());
+    problem->setPrimalWarmStart(d_primalWarmStart.getValue());
+    problem->setActiveSetCache(d_activeSetCacheSize.getValue());
+    problem->setPivoting(d_pivoting.getValue().getSelectedItem());
+    problem->setSpeculativePivots(d_speculativePivots.getValue());
+    problem->setInfeasibilityRecovery(d_infeasibilityRecovery.getValue().getSelectedItem());
+    problem->setQPSolver(d_qpSolver.getValue().getSelectedItem());
+    problem->setBackendCostModel(d_backendCostModel.getValue());
+    problem->setStructuredFactorization(d_structuredFactorization.getValue());
+    problem->setSmallProblemKernel(d_smallProblemKernel.getValue());
+    problem->setMessageQueue(&m_messageQueue);
+    problem->setInteriorFastPath(d_interiorFastPath.getValue());
+    problem->setComplianceOperator((m_isMatrixFreeStep)? &m_complianceProduct : nullptr);
+    problem->setMatrixFreeTolerance(d_matrixFreeTolerance.getValue());
+    problem->setMatrixFreeMaxIterations(d_matrixFreeMaxIterations.getValue());
+    problem->setHessianBackend(d_hessianBackend.getValue().getSelectedItem());
+    problem->setLCPSolver(d_lcpSolver.getValue().getSelectedItem());
+    problem->setLCPRelaxation(d_lcpRelaxation.getValue());
+    problem->setSparseContacts(d_sparseContacts.getValue());
+    problem->setSparseQPThreshold(d_sparseQPThreshold.getValue());
+    problem->setNLCPRelaxation(d_nlcpRelaxation.getValue(), d_nlcpAdaptiveRelaxation.getValue());
+    problem->setContactReduction(d_contactReduction.getValue(), d_contactReductionTolerance.getValue(),
+                                 d_contactReductionExpand.getValue());
+    problem->setMultilevelContacts(d_multilevelContacts.getValue(), d_multilevelContactsTolerance.getValue(),
+                                   d_multilevelContactsThreshold.getValue());
+    problem->setForwardWithoutEffectors(d_forwardWithoutEffectors.getValue());
+    problem->setPresolve(d_presolve.getValue());
+    problem->setScaling(d_scaling.getValue(), d_scalingIterations.getValue());
+    problem->setEqualityElimination(d_equalityElimination.getValue());
+    // The concurrent sweeps of the contacts visit them in another order than the sequential ones
+    problem->setMultithreading(d_multithreading.getValue() && !d_deterministic.getValue());
+    problem->setThreadAffinity(&m_threadAffinity);
+    problem->setTaskScheduler(m_taskPool.getTaskScheduler());
+    problem->setMixedPrecision(d_mixedPrecision.getValue());
+    problem->setStoragePolicy(d_storagePolicy.getValue().getSelectedItem());
+    problem->setTimeBudget(d_timeBudget.getValue()*1e-3);
+    problem->setComputeTimings(d_computeTimings.getValue() || m_telemetryStream.isOpen());
+    problem->setTrace(&m_trace);
+    problem->setCostAttribution(d_costAttribution.getValue());
+    problem->setExportDuals(d_exportDuals.getValue());
+    problem->setSensitivities(d_sensitivities.getValue());
+    problem->setProductionMode(d_productionMode.getValue());
+    problem->setHorizon(d_horizon.getValue(), d_horizonVariationWeight.getValue(), d_horizonTargetShifts.getValue());
+    problem->setDetached(false);
+    setDisabledConstraints(problem);
+    if(d_minContactForces.isSet()) problem->setMinContactForces(d_minContactForces.getValue());
+    if(d_maxContactForces.isSet()) problem->setMaxContactForces(d_maxContactForces.getValue());
+}
+
+
+void QPInverseProblemSolver::setDisabledConstraints(module::QPInverseProblemImpl* problem) const
+{
+    module::QPInverseProblem::QPConstraintLists* qpCLists = problem->getQPConstraintLists();
+    qpCLists->disabledConstraints.clear();
+
+    const vector<string>& names = d_disabledConstraints.getValue();
+    if(names.empty())
+        return;
+
+    for(const vector<softrobots::behavior::SoftRobotsBaseConstraint*>* constraints : {&qpCLists->actuators, &qpCLists->effectors})
+        for(softrobots::behavior::SoftRobotsBaseConstraint* constraint : *constraints)
+        {
+            const string& name = constraint->getName();
+            if(std::find(names.begin(), names.end(), name) != names.end()
+                    || std::find(names.begin(), names.end(), constraint->getPathName()) != names.end())
+                qpCLists->disabledConstraints.insert(constraint);
+        }
+}
+
+
+bool QPInverseProblemSolver::solvePipelined(double& objective, int& iterations)
+{
+    if(m_solveWorker.getProblem())
+        m_pipelinedCP = m_solveWorker.wait(m_pipelinedObjective, m_pipelinedIterations);
+
+    module::QPInverseProblemImpl* previous = m_pipelinedCP;
+    m_pipelinedCP = nullptr;
+
+    // The correction of the previous problem is applied to the rows of this step, they have to match
+    if(!previous || previous == m_currentCP || d_costAttribution.getValue() || !hasSameRows(m_currentCP, previous))
+        return false;
+
+    // The limits are read from the components here, the results are sent to them once back
+    m_currentCP->getQPConstraintLists()->updateVariableRows();
+    m_currentCP->setDetached(true);
+    m_currentCP->setTrace(nullptr);
+    m_currentCP->setMultithreading(false);
+    m_solveWorker.start(m_currentCP);
+
+    m_currentCP = previous;
+    m_currentCP->sendPendingResults();
+    objective = m_pipelinedObjective;
+    iterations = m_pipelinedIterations;
+    m_solvedProblems.assign(1, m_currentCP);
+    m_solvedObjectives.assign(1, objective);
+    m_solvedIterations.assign(1, iterations);
+    return true;
+}
+
+
+void QPInverseProblemSolver::solveOnChange(double& objective, int& iterations)
+{
+    if(!d_solveOnChange.getValue() || d_pipelined.getValue())
+    {
+        m_changeDetection.clear();
+        m_currentCP->solve(objective, iterations);
+        return;
+    }
+
+    m_changeDetection.setTolerance(d_solveOnChangeTolerance.getValue());
+    const uint64_t parametersKey = getProblemParametersKey();
+    if(m_changeDetection.isUnchanged(m_currentCP, parametersKey))
+    {
+        m_changeDetection.reuse(m_currentCP, objective, iterations);
+        return;
+    }
+
+    m_currentCP->solve(objective, iterations);
+    m_changeDetection.record(m_currentCP, objective, parametersKey);
+}
+
+
+uint64_t QPInverseProblemSolver::getProblemParametersKey() const
+{
+    using module::QPMappedCompliance;
+    uint64_t key = QPMappedCompliance::s_hashSeed;
+    auto hashValue = [&key](const auto& value) {key = QPMappedCompliance::hash(&value, sizeof(value), key);};
+    auto hashVector = [&key, &hashValue](const auto& values) {
+        hashValue(uint64_t(values.size()));
+        key = QPMappedCompliance::hash(values.data(), values.size()*sizeof(values[0]), key);
+    };
+
+    // Objective and resolution of the QP
+    hashValue(d_epsilon.getValue());
+    hashValue(d_adaptiveEpsilon.getValue());
+    hashValue(d_adaptiveEpsilonMinConditioning.getValue());
+    hashValue(d_adaptiveEpsilonMaxConditioning.getValue());
+    hashValue(d_actuatorsOnly.getValue());
+    hashValue(d_energyApproximation.getValue().getSelectedId());
+    hashValue(d_tolerance.getValue());
+    hashValue(d_maxIterations.getValue());
+    hashValue(d_maxNbPivots.getValue());
+    hashValue(d_maxNbWorkingSetChanges.getValue());
+    hashValue(d_adaptiveLimits.getValue());
+    hashValue(d_adaptiveLimitsPercentile.getValue());
+    hashValue(d_adaptiveLimitsMargin.getValue());
+    hashValue(hasLazySensors());
+    hashValue(d_hotStart.getValue());
+    hashValue(d_contactFreeHotStart.getValue());
+    hashValue(d_parametricQP.getValue());
+    hashValue(d_parametricThreshold.getValue());
+    hashValue(d_reuseHessian.getValue());
+    hashValue(d_condensedEffectors.getValue());
+    hashValue(d_effectorSketchSize.getValue());
+    hashValue(d_primalWarmStart.getValue());
+    hashValue(d_activeSetCacheSize.getValue());
+    hashValue(d_pivoting.getValue().getSelectedId());
+    hashValue(d_speculativePivots.getValue());
+    hashValue(d_infeasibilityRecovery.getValue().getSelectedId());
+    hashValue(d_qpSolver.getValue().getSelectedId());
+    hashVector(d_backendCostModel.getValue());
+    hashValue(d_structuredFactorization.getValue());
+    hashValue(d_smallProblemKernel.getValue());
+    hashValue(d_interiorFastPath.getValue());
+    hashValue(d_matrixFreeTolerance.getValue());
+    hashValue(d_matrixFreeMaxIterations.getValue());
+    hashValue(d_hessianBackend.getValue().getSelectedId());
+    hashValue(d_forwardWithoutEffectors.getValue());
+    hashValue(d_presolve.getValue());
+    hashValue(d_scaling.getValue());
+    hashValue(d_scalingIterations.getValue());
+    hashValue(d_equalityElimination.getValue());
+    hashValue(d_mixedPrecision.getValue());
+    hashValue(d_storagePolicy.getValue().getSelectedId());
+    hashValue(d_timeBudget.getValue());
+    hashValue(d_horizon.getValue());
+    hashValue(d_horizonVariationWeight.getValue());
+    hashVector(d_horizonTargetShifts.getValue());
+
+    // Contacts
+    hashValue(d_responseFriction.getValue());
+    hashValue(d_allowSliding.getValue());
+    hashValue(d_frictionFacets.getValue());
+    hashValue(d_warmStartContacts.getValue());
+    hashValue(d_trackContacts.getValue());
+    hashValue(d_trackContactsTolerance.getValue());
+    hashValue(d_lcpSolver.getValue().getSelectedId());
+    hashValue(d_lcpRelaxation.getValue());
+    hashValue(d_sparseContacts.getValue());
+    hashValue(d_sparseQPThreshold.getValue());
+    hashValue(d_nlcpRelaxation.getValue());
+    hashValue(d_nlcpAdaptiveRelaxation.getValue());
+    hashValue(d_contactReduction.getValue());
+    hashValue(d_contactReductionTolerance.getValue());
+    hashValue(d_contactReductionExpand.getValue());
+    hashValue(d_multilevelContacts.getValue());
+    hashValue(d_multilevelContactsTolerance.getValue());
+    hashValue(d_multilevelContactsThreshold.getValue());
+    hashValue(d_minContactForces.isSet());
+    hashValue(d_minContactForces.getValue());
+    hashValue(d_maxContactForces.isSet());
+    hashValue(d_maxContactForces.getValue());
+
+    // Order of the contact sweeps
+    hashValue(d_multithreading.getValue());
+    hashValue(d_deterministic.getValue());
+    hashValue(d_concurrentResults.getValue());
+    return key;
+}
+
+
+void QPInverseProblemSolver::findCouplingContacts(const unsigned int& contactNbLines)
+{
+    m_couplingRows.clear();
+    m_couplingKeys.clear();
+    m_couplingCompliances.clear();
+
+    const vector<string>& names = d_consensusContacts.getValue();
+    const module::QPInverseProblem::QPConstraintLists* qpCLists = m_currentCP->getQPConstraintLists();
+    double** W = m_currentCP->getW();
+    std::map<const sofa::core::behavior::BaseConstraint*, uint32_t> ranks;
+    for(unsigned int k=0; k+contactNbLines<=qpCLists->contactRowIds.size() && k<qpCLists->contactIds.size(); k+=contactNbLines)
+    {
+        const module::QPInverseProblem::QPContactId& id = qpCLists->contactIds[k];
+        if(!id.constraint)
+            continue;
+
+        auto name = std::find(names.begin(), names.end(), id.constraint->getName());
+        if(name == names.end())
+            name = std::find(names.begin(), names.end(), id.constraint->getPathName());
+        if(name == names.end())
+            continue;
+
+        const uint32_t rank = ranks[id.constraint]++;
+        const uint64_t index = name - names.begin();
+        m_couplingKeys.push_back((index << 32) | (id.isValid()? uint32_t(id.id) : rank));
+        const unsigned int row = qpCLists->contactRowIds[k];
+        m_couplingCompliances.push_back(W[row][row]);
+        for(unsigned int line=0; line<contactNbLines; line++)
+            m_couplingRows.push_back(qpCLists->contactRowIds[k+line]);
+    }
+}
+
+
+void QPInverseProblemSolver::solveConsensus(double& objective, int& iterations)
+{
+    m_changeDetection.clear();
+    m_heldActuators.clear();
+
+    const unsigned int contactNbLines = (d_responseFriction.getValue()>0.)? 3 : 1;
+    findCouplingContacts(contactNbLines);
+
+    m_consensus.setChannel(&m_consensusChannel);
+    m_consensus.setRelaxation(d_consensusRelaxation.getValue());
+    m_consensus.setNbIterations(d_consensusIterations.getValue());
+    m_consensus.setTolerance(d_consensusTolerance.getValue());
+    m_consensus.setTimeout(d_consensusTimeout.getValue());
+    m_consensus.beginStep(m_couplingKeys, m_couplingCompliances);
+    const bool wasTimedOut = m_consensus.hasTimedOut();
+
+    // Without coupling contact, the problem is solved once and the node only takes part in the exchanges
+    const unsigned int nbCouplingContacts = m_couplingKeys.size();
+    m_couplingDeltas.assign(nbCouplingContacts, 0.);
+    iterations = 0;
+    bool isSolved = false;
+    do
+    {
+        if(isSolved && nbCouplingContacts == 0)
+            continue;
+
+        // The coupling contacts are frictionless, only their normal force is imposed
+        const vector<double>& forces = m_consensus.getForces();
+        m_couplingForces.assign(m_couplingRows.size(), 0.);
+        for(unsigned int k=0; k<nbCouplingContacts; k++)
+            m_couplingForces[k*contactNbLines] = forces[k];
+        m_currentCP->setImposedContactForces(m_couplingRows, m_couplingForces);
+
+        int nbIterations = 0;
+        m_currentCP->solve(objective, nbIterations);
+        iterations += nbIterations;
+        isSolved = true;
+
+        const vector<double>& deltas = m_currentCP->getImposedContactDeltas();
+        for(unsigned int k=0; k<nbCouplingContacts; k++)
+            m_couplingDeltas[k] = deltas[k*contactNbLines];
+    } while(m_consensus.update(m_couplingDeltas));
+
+    m_currentCP->setImposedContactForces(vector<unsigned int>(), vector<double>());
+    if(!wasTimedOut && m_consensus.hasTimedOut())
+        m_messageQueue.warning(this, s_consensusMessage) << "The processes of the consensus channel did not answer within consensusTimeout, "
+                                                         << "the coupling contacts are solved in this process only until the solver is initialized again.";
+}
+
+
+bool QPInverseProblemSolver::solveForwardStep(double& objective, int& iterations)
+{
+    if(d_inverseSolvePeriod.getValue() <= 1 || d_pipelined.getValue()
+            || m_nbStepsSinceInverseSolve + 1 >= d_inverseSolvePeriod.getValue())
+        return false;
+
+    // The actuation is only kept for the same actuators, a change in the scene triggers the inverse step
+    const module::QPInverseProblem::QPConstraintLists* qpCLists = m_currentCP->getQPConstraintLists();
+    if(qpCLists->actuators.empty() || qpCLists->actuators != m_heldActuators
+            || qpCLists->actuatorRowIds.size() != m_heldActuatorLambdas.size()
+            || !m_currentCP->solveContactsOnly(m_heldActuatorLambdas, objective, iterations))
+        return false;
+
+    m_nbStepsSinceInverseSolve++;
+    m_nbForwardSteps++;
+    return true;
+}
+
+
+void QPInverseProblemSolver::holdActuation()
+{
+    m_nbStepsSinceInverseSolve = 0;
+    if(d_inverseSolvePeriod.getValue() <= 1 || d_pipelined.getValue())
+    {
+        m_heldActuators.clear();
+        return;
+    }
+
+    const module::QPInverseProblem::QPConstraintLists* qpCLists = m_currentCP->getQPConstraintLists();
+    const vector<double>& lambda = m_currentCP->getQPSystem()->lambda;
+    m_heldActuators = qpCLists->actuators;
+    m_heldActuatorLambdas.assign(lambda.begin(), lambda.begin() + std::min(lambda.size(), qpCLists->actuatorRowIds.size()));
+}
+
+
+void QPInverseProblemSolver::stopPipeline()
+{
+    // The results of the problem in flight are dropped
+    double objective;
+    int iterations;
+    m_solveWorker.wait(objective, iterations);
+    m_pipelinedCP = nullptr;
+}
+
+
+bool QPInverseProblemSolver::hasSameRows(module::QPInverseProblemImpl* problem, module::QPInverseProblemImpl* other) const
+{
+    const module::QPInverseProblem::QPConstraintLists* lists = problem->getQPConstraintLists();
+    const module::QPInverseProblem::QPConstraintLists* otherLists = other->getQPConstraintLists();
+
+    // The contacts are left to the sequential resolution, their rows change from one step to the next
+    return problem->W.rowSize() == other->W.rowSize()
+            && lists->contactRowIds.empty() && otherLists->contactRowIds.empty()
+            && lists->actuatorRowIds == otherLists->actuatorRowIds
+            && lists->effectorRowIds == otherLists->effectorRowIds
+            && lists->equalityRowIds == otherLists->equalityRowIds
+            && lists->sensorRowIds == otherLists->sensorRowIds
+            && lists->actuators == otherLists->actuators
+            && lists->effectors == otherLists->effectors
+            && lists->equality == otherLists->equality
+            && lists->sensors == otherLists->sensors;
+}
+
+
+void QPInverseProblemSolver::solveSubproblems(const double& time, double& objective, int& iterations)
+{
+    const unsigned int nbSubproblems = m_decomposition.getNbComponents();
+
+    m_solvedProblems.resize(nbSubproblems);
+    for(unsigned int i=0; i<nbSubproblems; i++)
+    {
+        if(i == m_subproblems.size())
+            m_subproblems.push_back(newProblem());
+
+        module::QPInverseProblemImpl* subproblem = m_subproblems[i];
+        const bool isNewLayout = (subproblem->getDimension() != (int)m_decomposition.getComponent(i).rows.size());
+        m_decomposition.setSubproblem(i, m_currentCP, subproblem);
+        setProblemParameters(subproblem, time);
+        if(d_multithreading.getValue())
+            subproblem->setConcurrentResults(false); // the subproblems are already solved concurrently
+        if(isNewLayout)
+            subproblem->init();
+
+        m_solvedProblems[i] = subproblem;
+    }
+
+    m_batchSolver.setMultithreading(d_multithreading.getValue());
+    m_batchSolver.solve(m_solvedProblems);
+    m_solvedObjectives = m_batchSolver.getObjectives();
+    m_solvedIterations = m_batchSolver.getIterations();
+
+    objective = 0.;
+    iterations = 0;
+    for(unsigned int i=0; i<nbSubproblems; i++)
+    {
+        m_decomposition.mergeResults(i, m_subproblems[i], m_currentCP);
+        objective += m_solvedObjectives[i];
+        iterations += m_solvedIterations[i];
+    }
+}
+
+
+void QPInverseProblemSolver::setSensorParams(const ConstraintParams *cParams, MultiVecId res1, MultiVecId res2,
+                                             ConstraintParams& sensorParams)
+{
+    // The mapped states of the sensors are updated from the corrected ones
+    MechanicalParams mparams(*cParams);
+    const SReal time = getContext()->getTime();
+    if (cParams->constOrder() == ConstraintParams::POS_AND_VEL)
+    {
+        sensorParams.setX(MultiVecCoordId(res1));
+        sensorParams.setV(MultiVecDerivId(res2));
+        MechanicalPropagateOnlyPositionAndVelocityVisitor(&mparams, time, MultiVecCoordId(res1), MultiVecDerivId(res2)).execute(m_context);
+    }
+    else if (cParams->constOrder() == ConstraintParams::POS)
+    {
+        sensorParams.setX(MultiVecCoordId(res1));
+        MechanicalPropagateOnlyPositionVisitor(&mparams, time, MultiVecCoordId(res1)).execute(m_context);
+    }
+    else if (cParams->constOrder() == ConstraintParams::VEL)
+    {
+        sensorParams.setV(MultiVecDerivId(res1));
+        MechanicalPropagateOnlyVelocityVisitor(&mparams, time, MultiVecDerivId(res1)).execute(m_context);
+    }
+
+    // The sensors add J*dx to the violation at the current positions. The dx of cParams now holds the
+    // correction, already in the positions: they read the correction buffer of the solver instead, cleared
+    clearConstrainedStates(cParams, m_dxId);
+    sensorParams.setDx(m_dxId);
+}
+
+void QPInverseProblemSolver::evaluateSensors(const ConstraintParams *cParams, MultiVecId res1, MultiVecId res2)
+{
+    sofa::helper::ScopedAdvancedTimer timer("Evaluate Sensors");
+
+    ConstraintParams sensorParams(*cParams);
+    setSensorParams(cParams, res1, res2, sensorParams);
+
+    m_sensorViolation.resize(m_currentCP->dFree.size());
+    m_sensorViolation.clear();
+    for (unsigned int i=0; i<m_constraintClassification.getNbEntries(); i++)
+    {
+        const module::QPConstraintClassification::Entry& entry = m_constraintClassification.getEntry(i);
+        if (entry.type == module::QPConstraintClassification::SENSOR)
+            entry.constraint->getConstraintViolation(&sensorParams, &m_sensorViolation);
+    }
+
+    // The violation at the corrected state replaces the linearized delta
+    module::QPInverseProblem::QPConstraintLists* qpCLists = m_currentCP->getQPConstraintLists();
+    unsigned int line = 0;
+    for (softrobots::behavior::SoftRobotsBaseConstraint* sensor : qpCLists->sensors)
+    {
+        vector<double> localDelta(sensor->getNbLines());
+        for (double& delta : localDelta)
+            delta = m_sensorViolation[qpCLists->sensorRowIds[line++]];
+        sensor->storeResults(localDelta);
+    }
+}
+
+void QPInverseProblemSolver::evaluateBatchedSensors(const ConstraintParams *cParams, MultiVecId res1, MultiVecId res2)
+{
+    sofa::helper::ScopedAdvancedTimer timer("Evaluate Batched Sensors");
+
+    ConstraintParams sensorParams(*cParams);
+    setSensorParams(cParams, res1, res2, sensorParams);
+
+    // The rows of the sensors are only built for their lines in the violation, after the rows of the problem.
+    // They are neither accumulated nor in the compliance, and their J*dx vanishes with the cleared correction.
+    // They stay in the constraint matrix until its reset at the next step.
+    unsigned int line = m_currentCP->getDimension();
+    m_batchedSensorLines.resize(m_batchedSensors.size()+1);
+    for (unsigned int i=0; i<m_batchedSensors.size(); i++)
+    {
+        m_batchedSensorLines[i] = line;
+        static_cast<sofa::core::behavior::BaseConstraintSet*>(m_batchedSensors[i])->buildConstraintMatrix(&sensorParams, MatrixDerivId::constraintJacobian(), line);
+    }
+    m_batchedSensorLines.back() = line;
+
+    m_sensorViolation.resize(line);
+    m_sensorViolation.clear();
+
+    // The sensors that only read their state and write their own Data are evaluated concurrently
+    sofa::simulation::CpuTask::Status status;
+    vector<EvaluateSensorTask> tasks(m_batchedSensors.size(), EvaluateSensorTask(&status));
+    sofa::simulation::TaskScheduler* taskScheduler = (d_multithreading.getValue())? sofa::simulation::MainTaskSchedulerFactory::createInRegistry() : nullptr;
+    for (unsigned int i=0; i<m_batchedSensors.size(); i++)
+    {
+        tasks[i].set(m_batchedSensors[i], &sensorParams, &m_sensorViolation, m_batchedSensorLines[i],
+                     m_batchedSensorLines[i+1] - m_batchedSensorLines[i]);
+        if (taskScheduler && module::QPInverseProblem::hasConcurrentResults(m_batchedSensors[i]))
+            taskScheduler->addTask(&tasks[i]);
+    }
+    for (unsigned int i=0; i<m_batchedSensors.size(); i++)
+        if (!taskScheduler || !module::QPInverseProblem::hasConcurrentResults(m_batchedSensors[i]))
+            tasks[i].run();
+    if (taskScheduler)
+        taskScheduler->workUntilDone(&status);
+}
+
+void QPInverseProblemSolver::computeResidual(const ExecParams* eparam)
+{
+    // The rows of the batched sensors follow the rows of the problem in the constraint matrix, without force
+    sofa::linearalgebra::FullVector<SReal>* lambda = &m_currentCP->f;
+    if (!m_batchedSensorLines.empty() && m_batchedSensorLines.back() > (unsigned int)lambda->size())
+    {
+        m_residualLambda.resize(m_batchedSensorLines.back());
+        m_residualLambda.clear();
+        for (sofa::Index i=0; i<lambda->size(); i++)
+            m_residualLambda.set(i, lambda->element(i));
+        lambda = &m_residualLambda;
+    }
+
+    for (unsigned int i=0; i<m_constraintsCorrections.size(); i++)
+    {
+        if (i < m_isForcelessCorrection.size() && m_isForcelessCorrection[i])
+            continue;
+
+        BaseConstraintCorrection* CC = m_constraintsCorrections[i];
+        CC->computeResidual(eparam,lambda);
+    }
+}
+
+bool QPInverseProblemSolver::applyCorrection(const ConstraintParams *cParams, MultiVecId res1, MultiVecId res2)
+{
+    AdvancedTimer::stepBegin("Compute And Apply Motion Correction");
+    auto timer = startTimer();
+
+    findForcelessCorrections();
+
+    sofa::simulation::TaskScheduler* taskScheduler = (d_multithreading.getValue() && m_correctionGroups.size() > 1)?
+                sofa::simulation::MainTaskSchedulerFactory::createInRegistry() : nullptr;
+    if (taskScheduler)
+    {
+        sofa::simulation::CpuTask::Status status;
+
+        vector<CorrectMotionTask> tasks;
+        tasks.resize(m_correctionGroups.size(), CorrectMotionTask(&status));
+        for (unsigned int g = 0; g < tasks.size(); g++)
+        {
+            tasks[g].set(this, &m_correctionGroups[g], cParams, res1, res2);
+            taskScheduler->addTask(&tasks[g]);
+        }
+        taskScheduler->workUntilDone(&status);
+
+        // Without ODE solver, the states written are not known
+        for (const unsigned int& i : m_sequentialCorrections)
+            correctMotion(i, cParams, res1, res2);
+    }
+    else
+    {
+        for (unsigned int i = 0; i < m_constraintsCorrections.size(); i++)
+            correctMotion(i, cParams, res1, res2);
+    }
+
+    if (hasLazySensors())
+        evaluateSensors(cParams, res1, res2);
+
+    stopTimer(s_correctionPhase, timer);
+    AdvancedTimer::stepEnd("Compute And Apply Motion Correction");
+
+    AdvancedTimer::stepBegin("Store Constraint Lambdas");
+    timer = startTimer();
+    /// Some constraint correction schemes may have written the constraint motion space lambda in the lambdaId VecId.
+    /// In order to be sure that we are not accumulating things twice, we need to clear.
+    clearConstrainedStates(cParams, m_lambdaId);
+
+    /// Store lambda and accumulate.
+    if (d_sparseLambdaStore.getValue())
+    {
+        module::QPMechanicalStoreLambda v(cParams, &m_currentCP->f, m_constraintClassification);
+        this->getContext()->executeVisitor(&v);
+    }
+    else
+    {
+        ConstraintStoreLambdaVisitor v(cParams, &m_currentCP->f);
+        this->getContext()->executeVisitor(&v);
+    }
+    stopTimer(s_lambdaStorePhase, timer);
+    AdvancedTimer::stepEnd("Store Constraint Lambdas");
+
+    // After the storage of the lambdas, which reads the rows of the problem only
+    m_batchedSensorLines.clear();
+    if (!m_batchedSensors.empty())
+        evaluateBatchedSensors(cParams, res1, res2);
+
+    publishTimings();
+    publishCounters();
+    publishProfileReport();
+    publishTelemetryStream();
+
+
+    if (d_displayTime.getValue())
+        m_messageQueue.info(this, s_totalTimeMessage) << "TotalTime " << ((double) m_timerTotal.getTime() - m_timeTotal) * m_timeScale << " ms" ;
+    return true;
+}
+
+
+void QPInverseProblemSolver::correctMotion(const unsigned int& i, const ConstraintParams *cParams, MultiVecId res1, MultiVecId res2)
+{
+    if (!m_isConstraintCorrectionActive[i])
+        return;
+
+    BaseConstraintCorrection* cc = m_constraintsCorrections[i];
+    if (!cc->isActive())
+        return;
+
+    // Without force, the correction is the cleared dx
+    const bool hasForce = !m_isForcelessCorrection[i];
+
+    if (cParams->constOrder() == ConstraintParams::POS_AND_VEL)
+    {
+        if (hasForce)
+            cc->computeMotionCorrectionFromLambda(cParams, getDx(), &m_currentCP->f);
+        cc->applyMotionCorrection(cParams, MultiVecCoordId(res1), MultiVecDerivId(res2), cParams->dx(), getDx());
+    }
+    else if (cParams->constOrder() == ConstraintParams::POS)
+    {
+        if (hasForce)
+            cc->computeMotionCorrectionFromLambda(cParams, getDx(), &m_currentCP->f);
+        cc->applyPositionCorrection(cParams, MultiVecCoordId(res1), cParams->dx(), getDx());
+    }
+    else if (cParams->constOrder() == ConstraintParams::VEL)
+    {
+        if (hasForce)
+            cc->computeMotionCorrectionFromLambda(cParams, getDx(), &m_currentCP->f);
+        cc->applyVelocityCorrection(cParams, MultiVecDerivId(res1), cParams->dx(), getDx());
+    }
+}
+
+
+QPInverseProblemSolver::PhaseTimer QPInverseProblemSolver::startTimer() const
+{
+    PhaseTimer timer;
+    if(d_computeTimings.getValue() || m_trace.isOpen() || m_telemetryStream.isOpen() || m_problemCapture.isEnabled()
+            || m_profileReport.isStepOpen())
+        timer.start = CTime::getTime();
+    if(m_perfCounters.isOpen())
+        m_perfCounters.read(timer.counters);
+    return timer;
+}
+
+void QPInverseProblemSolver::stopTimer(const QPTrace::NameId& phase, const PhaseTimer& timer)
+{
+    if(m_perfCounters.isOpen())
+    {
+        module::QPPerfCounters::Values counters;
+        m_perfCounters.read(counters);
+
+        // The names are built once per phase, the counters of the next phases do not see their allocations
+        auto names = m_counterNames.find(phase);
+        if(names == m_counterNames.end())
+        {
+            names = m_counterNames.emplace(phase, std::array<string, module::QPPerfCounters::NbCounters>()).first;
+            for(unsigned int i=0; i<module::QPPerfCounters::NbCounters; i++)
+                names->second[i] = QPTrace::getName(phase) + ": "
+                        + module::QPPerfCounters::getName(module::QPPerfCounters::Counter(i));
+        }
+
+        for(unsigned int i=0; i<module::QPPerfCounters::NbCounters; i++)
+            if(m_perfCounters.isAvailable(module::QPPerfCounters::Counter(i)))
+            {
+                const double count = double(counters.counts[i] - timer.counters.counts[i]);
+                if(m_isCountersRequested)
+                    m_counters.add(names->second[i], count);
+                m_profileReport.addPhase(names->second[i], count);
+            }
+    }
+
+    const sofa::helper::system::thread::ctime_t& start = timer.start;
+    if(d_computeTimings.getValue() || m_telemetryStream.isOpen() || m_profileReport.isStepOpen())
+    {
+        const double time = (double)(CTime::getTime() - start)*m_timeScale;
+        if(d_computeTimings.getValue())
+            m_timings.add(QPTrace::getName(phase), time);
+        m_profileReport.addPhase(QPTrace::getName(phase), time);
+        const int streamPhase = getStreamPhase(phase);
+        if(m_telemetryStream.isOpen() && streamPhase < module::QPTelemetryStream::NbPhases)
+            m_telemetrySample.phaseTimes[streamPhase] += time;
+    }
+    m_trace.end(phase, start);
+}
+
+void QPInverseProblemSolver::publishCosts()
+{
+    if(!d_costAttribution.getValue())
+    {
+        m_costAttribution.clear();
+        return;
+    }
+
+    for(module::QPInverseProblemImpl* problem : m_solvedProblems)
+        m_costAttribution.add(problem->getCostAttribution());
+    m_costAttribution.getTable(*d_costs.beginEdit());
+    d_costs.endEdit();
+}
+
+void QPInverseProblemSolver::publishDuals(const bool& decompose)
+{
+    if(!d_exportDuals.getValue() || m_solvedProblems.empty())
+        return;
+
+    auto& boundDuals = *d_actuatorsBoundDuals.beginEdit();
+    auto& activeSet = *d_actuatorsActiveSet.beginEdit();
+    if(!decompose)
+    {
+        const module::QPInverseProblemImpl* problem = m_solvedProblems[0];
+        boundDuals.assign(problem->getActuatorBoundDuals().begin(), problem->getActuatorBoundDuals().end());
+        activeSet.assign(problem->getActuatorActiveLimits().begin(), problem->getActuatorActiveLimits().end());
+    }
+    else
+    {
+        // The actuators of the subproblems are written at their position in the actuators of the whole problem
+        const auto& actuatorRowIds = m_currentCP->getQPConstraintLists()->actuatorRowIds;
+        boundDuals.assign(actuatorRowIds.size(), 0.);
+        activeSet.assign(actuatorRowIds.size(), 0);
+        for(unsigned int i=0; i<m_solvedProblems.size(); i++)
+        {
+            const auto& subproblemRowIds = m_decomposition.getComponent(i).lists.actuatorRowIds;
+            const auto& subproblemDuals = m_solvedProblems[i]->getActuatorBoundDuals();
+            const auto& subproblemLimits = m_solvedProblems[i]->getActuatorActiveLimits();
+            for(unsigned int k=0; k<subproblemRowIds.size() && k<subproblemLimits.size(); k++)
+            {
+                auto it = std::find(actuatorRowIds.begin(), actuatorRowIds.end(), subproblemRowIds[k]);
+                if(it == actuatorRowIds.end())
+                    continue;
+                boundDuals[it-actuatorRowIds.begin()] = subproblemDuals[k];
+                activeSet[it-actuatorRowIds.begin()] = subproblemLimits[k];
+            }
+        }
+    }
+    d_actuatorsBoundDuals.endEdit();
+    d_actuatorsActiveSet.endEdit();
+}
+
+void QPInverseProblemSolver::publishSensitivities(const bool& decompose)
+{
+    if(!d_sensitivities.getValue() || m_solvedProblems.empty())
+        return;
+
+    // The variables of the subproblems are not the ones of the whole problem
+    const module::QPInverseProblemImpl* problem = m_solvedProblems[0];
+    const bool hasSensitivities = !decompose && problem->hasSensitivities();
+    auto write = [hasSensitivities](sofa::Data<vector<SReal>>& data, const module::QPInverseProblem::RowMajorMatrixXd& matrix)
+    {
+        auto& values = *data.beginEdit();
+        if(hasSensitivities)
+            values.assign(matrix.data(), matrix.data() + matrix.size());
+        else
+            values.clear();
+        data.endEdit();
+    };
+
+    auto& rows = *d_sensitivityRows.beginEdit();
+    if(hasSensitivities)
+        rows.assign(problem->getSensitivityRows().begin(), problem->getSensitivityRows().end());
+    else
+        rows.clear();
+    d_sensitivityRows.endEdit();
+    write(d_dfreeSensitivities, problem->getDfreeSensitivity());
+    write(d_targetSensitivities, problem->getTargetSensitivity());
+    write(d_boundSensitivities, problem->getBoundSensitivity());
+}
+
+void QPInverseProblemSolver::publishMemoryUsage()
+{
+    auto write = [](vector<SReal>& entry, const module::QPInverseProblem::QPMemoryUsage& usage)
+    {
+        entry.resize(4);
+        entry[0] = usage.compliance;
+        entry[1] = usage.qpSystem;
+        entry[2] = usage.solvers;
+        entry[3] = usage.getTotal();
+    };
+
+    // The entries keep their vectors, only the allocated problems are written
+    auto& memoryUsage = *d_memoryUsage.beginEdit();
+    module::QPInverseProblem::QPMemoryUsage usage, totalUsage;
+    auto accumulate = [&totalUsage](const module::QPInverseProblem::QPMemoryUsage& usage)
+    {
+        totalUsage.compliance += usage.compliance;
+        totalUsage.qpSystem += usage.qpSystem;
+        totalUsage.solvers += usage.solvers;
+    };
+
+    const module::QPInverseProblemImpl* problems[3] = {m_CP1, m_CP2, m_CP3};
+    static const string names[3] = {"problem1", "problem2", "problem3"};
+    for(unsigned int i=0; i<3; i++)
+    {
+        if(!problems[i])
+            continue;
+        problems[i]->getMemoryUsage(usage);
+        write(memoryUsage[names[i]], usage);
+        accumulate(usage);
+    }
+
+    if(!m_subproblems.empty())
+    {
+        module::QPInverseProblem::QPMemoryUsage subproblemsUsage;
+        for(const module::QPInverseProblemImpl* subproblem : m_subproblems)
+        {
+            subproblem->getMemoryUsage(usage);
+            subproblemsUsage.compliance += usage.compliance;
+            subproblemsUsage.qpSystem += usage.qpSystem;
+            subproblemsUsage.solvers += usage.solvers;
+        }
+        write(memoryUsage["subproblems"], subproblemsUsage);
+        accumulate(subproblemsUsage);
+    }
+
+    // The problems given back to the pool or shrunk by a reinit lower the total, the peak keeps the breakdown
+    // of the step with the largest one
+    if(totalUsage.getTotal() > m_peakMemoryUsage.getTotal())
+        m_peakMemoryUsage = totalUsage;
+    write(memoryUsage["peak"], m_peakMemoryUsage);
+    d_memoryUsage.endEdit();
+}
+
+void QPInverseProblemSolver::fillTelemetrySample(const double& time, const double& objective, const int& iterations)
+{
+    module::QPTelemetryStream::Sample& sample = m_telemetrySample;
+    sample.time = time;
+    sample.objective = objective;
+    sample.iterations = iterations;
+    for(unsigned int i=0; i<module::QPTelemetry::NbEntries; i++)
+    {
+        const module::QPTelemetry::Entry entry = module::QPTelemetry::Entry(i);
+        sample.entries[i] = (m_telemetry.isPublished(entry))? m_telemetry.get(entry) : std::numeric_limits<double>::quiet_NaN();
+    }
+
+    // The subproblems have their own rows, the norms are accumulated over them
+    double squaredNorms[module::QPTelemetryStream::NbDeltaNorms]{};
+    for(module::QPInverseProblemImpl* problem : m_solvedProblems)
+    {
+        const vector<double>& delta = problem->getQPSystem()->delta;
+        const module::QPInverseProblem::QPConstraintLists* qpCLists = problem->getQPConstraintLists();
+        const vector<unsigned int>* rowIds[module::QPTelemetryStream::NbDeltaNorms] = {
+            &qpCLists->effectorRowIds, &qpCLists->actuatorRowIds, &qpCLists->contactRowIds};
+        for(unsigned int k=0; k<module::QPTelemetryStream::NbDeltaNorms; k++)
+            for(const unsigned int& rowId : *rowIds[k])
+                if(rowId < delta.size())
+                    squaredNorms[k] += delta[rowId]*delta[rowId];
+    }
+    for(unsigned int k=0; k<module::QPTelemetryStream::NbDeltaNorms; k++)
+        sample.deltaNorms[k] = std::sqrt(squaredNorms[k]);
+
+    const unsigned int nbRows = std::min<unsigned int>(m_currentCP->getDimension(), m_telemetryStream.getMaxNbRows());
+    sample.lambda.resize(nbRows);
+    for(unsigned int i=0; i<nbRows; i++)
+        sample.lambda[i] = m_currentCP->f[i];
+    m_hasTelemetrySample = true;
+}
+
+void QPInverseProblemSolver::publishTelemetryStream()
+{
+    if(!m_telemetryStream.isOpen() || !m_hasTelemetrySample)
+        return;
+
+    m_telemetrySample.step = m_telemetryStream.getWriteCount();
+    m_telemetryStream.write(m_telemetrySample);
+    std::fill(m_telemetrySample.phaseTimes, m_telemetrySample.phaseTimes + module::QPTelemetryStream::NbPhases, 0.);
+    m_hasTelemetrySample = false;
+}
+
+void QPInverseProblemSolver::updatePerfCounters()
+{
+    // Only opened or closed when computeCounters changes, a failed opening is not retried at each step
+    const bool computeCounters = d_computeCounters.getValue();
+    if(computeCounters == m_isCountersRequested)
+        return;
+    m_isCountersRequested = computeCounters;
+
+    if(!computeCounters)
+    {
+        m_perfCounters.close();
+        m_counters.clear();
+        d_counters.beginEdit()->clear();
+        d_counters.endEdit();
+        return;
+    }
+
+    if(!m_perfCounters.open())
+        msg_warning() << "No counter is available: preload the allocation hook (tools/allochook) for the "
+                         "allocations, and allow perf_event (/proc/sys/kernel/perf_event_paranoid) for the "
+                         "hardware counters.";
+    else if(!m_perfCounters.hasHardwareCounts())
+        msg_info() << "The hardware counters are not available, only the allocations are counted.";
+    else if(!m_perfCounters.hasAllocationCounts())
+        msg_info() << "The allocation hook is not loaded, only the hardware counters are read.";
+}
+
+void QPInverseProblemSolver::publishCounters()
+{
+    if(!m_isCountersRequested || !m_perfCounters.isOpen())
+        return;
+
+    m_counters.setWindowSize(d_timingsWindow.getValue());
+    m_counters.endStep();
+    m_counters.getStatistics(*d_counters.beginEdit());
+    d_counters.endEdit();
+}
+
+void QPInverseProblemSolver::handleEvent(sofa::core::objectmodel::Event* event)
+{
+    if(KeypressedEvent::checkEventType(event))
+    {
+        const char key = static_cast<KeypressedEvent*>(event)->getKey();
+        if(key == 'P' || key == 'p')
+            requestProfile();
+    }
+    ConstraintSolver::handleEvent(event);
+}
+
+void QPInverseProblemSolver::requestProfile()
+{
+    const unsigned int nbSteps = d_profileSteps.getValue();
+    if(nbSteps == 0)
+        return;
+
+    // The counters are read during the capture even without computeCounters, when available
+    if(!m_perfCounters.isOpen())
+        m_isProfileCounters = m_perfCounters.open();
+    m_profileReport.request(nbSteps);
+    msg_info() << "Profiling the next " << nbSteps << " steps.";
+}
+
+void QPInverseProblemSolver::beginProfileStep()
+{
+    if(d_profile.getValue())
+    {
+        d_profile.setValue(false);
+        requestProfile();
+    }
+    m_profileReport.beginStep(getContext()->getTime());
+}
+
+void QPInverseProblemSolver::fillProfileStep()
+{
+    if(!m_profileReport.isStepOpen())
+        return;
+
+    module::QPProfileReport::Step& step = m_profileReport.getStep();
+    const auto& W = m_currentCP->W; // empty at the matrix-free steps
+    step.dim = m_currentCP->getDimension();
+    step.nbNonZeros = 0;
+    for(sofa::Index i=0; i<W.rowSize(); i++)
+        for(sofa::Index j=0; j<W.colSize(); j++)
+            if(W.element(i,j) != 0.)
+                step.nbNonZeros++;
+
+    for(unsigned int i=0; i<module::QPTelemetry::NbEntries; i++)
+    {
+        const module::QPTelemetry::Entry entry = module::QPTelemetry::Entry(i);
+        if(m_telemetry.isPublished(entry))
+            step.values[module::QPTelemetry::getName(entry)] = m_telemetry.get(entry);
+    }
+
+    if(m_telemetry.isPublished(module::QPTelemetry::PivotsPerIteration))
+        step.pivotsPerIteration = m_telemetry.getSeries(module::QPTelemetry::PivotsPerIteration);
+}
+
+void QPInverseProblemSolver::publishProfileReport()
+{
+    if(!m_profileReport.endStep())
+        return;
+
+    const string filename = (d_profileFile.getValue().empty())? getName() + "_profile.json" : d_profileFile.getFullPath();
+    if(m_profileReport.write(filename))
+        msg_info() << "Profile of " << m_profileReport.getSteps().size() << " steps written in " << filename;
+    else
+        msg_warning() << "Cannot write the profile report in " << filename;
+    m_profileReport.clear();
+
+    if(m_isProfileCounters && !m_isCountersRequested)
+        m_perfCounters.close();
+    m_isProfileCounters = false;
+}
+
+void QPInverseProblemSolver::publishTimings()
+{
+    if(!d_computeTimings.getValue())
+        return;
+
+    m_timings.setWindowSize(d_timingsWindow.getValue());
+    m_timings.endStep();
+    m_timings.getStatistics(*d_timings.beginEdit());
+    d_timings.endEdit();
 }
 
 
@@ -591,12 +3913,22 @@ void QPInverseProblemSolver::lockConstraintProblem(sofa::core::objectmodel::Base
     if( (m_currentCP != p1) && (m_currentCP != p2) ) //The current ConstraintProblem is not locked
         return;
 
+    // In pipelined mode, prepareStates() already writes into another problem than getConstraintProblem()
+    if(d_pipelined.getValue())
+        return;
+
+    module::QPInverseProblemImpl* lockedCP = m_currentCP;
+
+    // In lazy mode, cp2 and cp3 are allocated the first time they are needed
     if( (m_CP1 != p1) && (m_CP1 != p2) ) //cp1 is not locked
         m_currentCP = m_CP1;
-    else if( (m_CP2 != p1) && (m_CP2 != p2) ) //cp2 is not locked
-        m_currentCP = m_CP2;
+    else if( !m_CP2 || ((m_CP2 != p1) && (m_CP2 != p2)) ) //cp2 is not locked
+        m_currentCP = getProblem(m_CP2);
     else
-        m_currentCP = m_CP3; //cp1 et cp2 are locked, thus cp3 is not locked
+        m_currentCP = getProblem(m_CP3); //cp1 et cp2 are locked, thus cp3 is not locked
+
+    if(d_moveResolutionState.getValue() && m_currentCP != lockedCP)
+        m_currentCP->swapResolutionState(*lockedCP);
 }
 
 
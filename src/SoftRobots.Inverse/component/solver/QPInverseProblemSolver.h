@@ -28,17 +28,56 @@
 ******************************************************************************/
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <set>
+
 #include <sofa/component/constraint/lagrangian/solver/ConstraintSolverImpl.h>
 #include <sofa/core/behavior/BaseConstraint.h>
 #include <sofa/core/behavior/ConstraintSolver.h>
 #include <sofa/core/behavior/BaseConstraintCorrection.h>
+#include <sofa/core/behavior/BaseMechanicalState.h>
 #include <sofa/core/objectmodel/KeypressedEvent.h>
 #include <sofa/simulation/TaskScheduler.h>
 #include <sofa/simulation/InitTasks.h>
 #include <sofa/helper/map.h>
+#include <sofa/helper/OptionsGroup.h>
+#include <sofa/core/objectmodel/DataFileName.h>
+#include <sofa/linearalgebra/FullVector.h>
 
 #include <SoftRobots/component/behavior/SoftRobotsBaseConstraint.h>
 #include <SoftRobots.Inverse/component/solver/modules/QPInverseProblemImpl.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPBatchSolver.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPBatchedCompliance.h>
+#include <SoftRobots.Inverse/component/behavior/BatchedCompliance.h>
+#include <SoftRobots.Inverse/component/behavior/ComplianceOperator.h>
+#include <SoftRobots.Inverse/component/behavior/ConstantRows.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPChangeDetection.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPCheckpoint.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPComplianceCache.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPComplianceMatrix.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPComplianceTable.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPMappedCompliance.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPMechanicalSetConstraint.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPMessageQueue.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPPerfCounters.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPProblemCapture.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPProblemDecomposition.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPConsensus.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPConsensusChannel.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPProblemPool.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPProfileReport.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPProblemRecorder.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPReducedCompliance.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPResultLogger.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPSolveWorker.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPTelemetry.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPTelemetryStream.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPTaskPool.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPThreadAffinity.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPTimings.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPTrace.h>
 #include <SoftRobots.Inverse/component/config.h>
 
 using sofa::core::objectmodel::KeypressedEvent ;
@@ -81,6 +120,7 @@ public:
     void init() override;
     void reinit() override;
     void cleanup() override;
+    void handleEvent(sofa::core::objectmodel::Event* event) override;
     ////////////////////////////////////////////////////////////////////////////////
 
     ////////////////////// Inherited from ConstraintSolver ///////////////////////////
@@ -111,6 +151,21 @@ public:
         return m_lambdaId;
     }
 
+    /// Report of the last steps, info is a view over it
+    const module::QPTelemetry& getTelemetry() const {return m_telemetry;}
+    /// Trace of the phases, open if traceFile is set
+    const module::QPTrace& getTrace() const {return m_trace;}
+    /// Contributions of the constraint corrections to the compliance, kept if cacheCompliance is true
+    const module::QPComplianceCache& getComplianceCache() const {return m_complianceCache;}
+    /// Constraints of the last traversal, with the first row of each one
+    const module::QPConstraintClassification& getConstraintClassification() const {return m_constraintClassification;}
+    /// Concurrent build of the constraint matrix, used with multithreading or classContiguousRows
+    const module::QPParallelSetConstraint& getParallelSetConstraint() const {return m_parallelSetConstraint;}
+    /// Problem of the last step. Its getLambda(), getDelta() and getRowComponents() give the results of
+    /// all the rows in contiguous buffers, without copy (e.g. for the Python controllers reading all the
+    /// actuators at once, instead of the Data of each component)
+    module::QPInverseProblemImpl* getResultProblem() const {return m_currentCP;}
+
     MultiVecDerivId getDx() const override
     {
         return m_dxId;
@@ -128,22 +183,168 @@ public:
 
     sofa::Data<bool>      d_displayTime;
     sofa::Data<bool>      d_multithreading;
+    sofa::Data<bool>      d_concurrentResults;
+    sofa::Data<bool>      d_deterministic;
+    sofa::Data<vector<int>> d_threadCores;
+    sofa::Data<int>       d_threadSocket;
+    sofa::Data<bool>      d_dedicatedThreadPool;
+    sofa::Data<unsigned int> d_threadPoolSize;
+    sofa::Data<int>       d_threadPoolPriority;
     sofa::Data<bool>      d_reverseAccumulateOrder;
 
     sofa::Data<int>       d_countdownFilterStartPerturb;
     sofa::Data<bool>      d_saveMatrices;
+    sofa::Data<bool>      d_asyncMessages;
+    sofa::Data<double>    d_messageInterval;
+    sofa::core::objectmodel::DataFileName d_recordFile;
+    sofa::Data<bool>      d_recordCompression;
+    sofa::core::objectmodel::DataFileName d_resultLogFile;
+    sofa::Data<unsigned int> d_resultLogChunkSize;
+    sofa::core::objectmodel::DataFileName d_captureFile;
+    sofa::Data<unsigned int> d_captureWindow;
+    sofa::Data<bool>      d_captureOnInfeasible;
+    sofa::Data<int>       d_captureMaxPivots;
+    sofa::Data<double>    d_captureTimeBudget;
+    sofa::Data<double>    d_captureMaxQNormVariation;
+    sofa::Data<unsigned int> d_captureMaxDumps;
+    sofa::core::objectmodel::DataFileName d_traceFile;
+    sofa::core::objectmodel::DataFileName d_checkpointFile;
+    sofa::Data<unsigned int> d_checkpointPeriod;
+    sofa::Data<std::string> d_telemetryStream;
+    sofa::Data<unsigned int> d_telemetryStreamCapacity;
+    sofa::Data<unsigned int> d_telemetryStreamMaxRows;
 
     sofa::Data<int>       d_maxIterations;
+    sofa::Data<int>       d_maxNbPivots;
+    sofa::Data<int>       d_maxNbWorkingSetChanges;
+    sofa::Data<bool>      d_adaptiveLimits;
+    sofa::Data<double>    d_adaptiveLimitsPercentile;
+    sofa::Data<double>    d_adaptiveLimitsMargin;
     sofa::Data<double>    d_tolerance;
     sofa::Data<double>    d_responseFriction;
 
     sofa::Data<double>    d_epsilon;
+    sofa::Data<bool>      d_adaptiveEpsilon;
+    sofa::Data<double>    d_adaptiveEpsilonMinConditioning;
+    sofa::Data<double>    d_adaptiveEpsilonMaxConditioning;
     sofa::Data<bool>      d_actuatorsOnly;
+    sofa::Data<sofa::helper::OptionsGroup> d_energyApproximation;
     sofa::Data<bool>      d_allowSliding;
+    sofa::Data<unsigned int> d_frictionFacets;
     sofa::Data<map <string, vector<SReal> > > d_graph;
+    sofa::Data<bool>      d_publishInfo;
+    sofa::Data<unsigned int> d_telemetryHistory;
     sofa::Data<double>    d_minContactForces;
     sofa::Data<double>    d_maxContactForces;
     sofa::Data<SReal >    d_objective;
+    sofa::Data<bool>      d_hotStart;
+    sofa::Data<bool>      d_contactFreeHotStart;
+    sofa::Data<bool>      d_parametricQP;
+    sofa::Data<double>    d_parametricThreshold;
+    sofa::Data<bool>      d_reuseHessian;
+    sofa::Data<bool>      d_condensedEffectors;
+    sofa::Data<unsigned int> d_effectorSketchSize;
+    sofa::Data<bool>      d_warmStartContacts;
+    sofa::Data<bool>      d_trackContacts;
+    sofa::Data<double>    d_trackContactsTolerance;
+    sofa::Data<bool>      d_primalWarmStart;
+    sofa::Data<unsigned int> d_activeSetCacheSize;
+    sofa::Data<sofa::helper::OptionsGroup> d_pivoting;
+    sofa::Data<unsigned int> d_speculativePivots;
+    sofa::Data<bool>      d_partialCompliance;
+    sofa::Data<bool>      d_symmetricCompliance;
+    sofa::Data<bool>      d_clearComplianceBlocks;
+    sofa::Data<bool>      d_cacheCompliance;
+    sofa::Data<bool>      d_incrementalCompliance;
+    sofa::Data<bool>      d_lazyContactCompliance;
+    sofa::Data<double>    d_lazyContactMargin;
+    sofa::Data<vector<SReal>> d_reducedBasis;
+    sofa::Data<vector<SReal>> d_reducedCompliance;
+    sofa::Data<string>    d_reducedConstraintCorrection;
+    sofa::core::objectmodel::DataFileName d_complianceTable;
+    sofa::Data<double>    d_complianceTableRadius;
+    sofa::core::objectmodel::DataFileName d_recordComplianceTable;
+    sofa::core::objectmodel::DataFileName d_restComplianceFile;
+    sofa::Data<bool>      d_lazySensors;
+    sofa::Data<bool>      d_batchSensors;
+    sofa::Data<bool>      d_clearConstrainedStates;
+    sofa::Data<bool>      d_sparseLambdaStore;
+    sofa::Data<bool>      d_measurementOnlyRows;
+    sofa::Data<bool>      d_decomposeSubproblems;
+    sofa::Data<string>    d_consensusChannel;
+    sofa::Data<unsigned int> d_consensusNode;
+    sofa::Data<unsigned int> d_consensusNbNodes;
+    sofa::Data<vector<string> > d_consensusContacts;
+    sofa::Data<double>    d_consensusRelaxation;
+    sofa::Data<unsigned int> d_consensusIterations;
+    sofa::Data<double>    d_consensusTolerance;
+    sofa::Data<double>    d_consensusTimeout;
+    sofa::Data<sofa::helper::OptionsGroup> d_qpSolver;
+    sofa::Data<vector<double> > d_backendCostModel;
+    sofa::Data<bool>      d_structuredFactorization;
+    sofa::Data<bool>      d_smallProblemKernel;
+    sofa::Data<bool>      d_interiorFastPath;
+    sofa::Data<bool>      d_matrixFree;
+    sofa::Data<double>    d_matrixFreeTolerance;
+    sofa::Data<int>       d_matrixFreeMaxIterations;
+    sofa::Data<sofa::helper::OptionsGroup> d_hessianBackend;
+    sofa::Data<sofa::helper::OptionsGroup> d_lcpSolver;
+    sofa::Data<double>    d_lcpRelaxation;
+    sofa::Data<bool>      d_sparseContacts;
+    sofa::Data<double>    d_sparseQPThreshold;
+    sofa::Data<double>    d_nlcpRelaxation;
+    sofa::Data<bool>      d_nlcpAdaptiveRelaxation;
+    sofa::Data<bool>      d_mixedPrecision;
+    sofa::Data<sofa::helper::OptionsGroup> d_storagePolicy;
+    sofa::Data<bool>      d_contactReduction;
+    sofa::Data<double>    d_contactReductionTolerance;
+    sofa::Data<bool>      d_contactReductionExpand;
+    sofa::Data<bool>      d_multilevelContacts;
+    sofa::Data<double>    d_multilevelContactsTolerance;
+    sofa::Data<double>    d_multilevelContactsThreshold;
+    sofa::Data<bool>      d_presolve;
+    sofa::Data<bool>      d_scaling;
+    sofa::Data<unsigned int> d_scalingIterations;
+    sofa::Data<bool>      d_equalityElimination;
+    sofa::Data<sofa::helper::OptionsGroup> d_infeasibilityRecovery;
+    sofa::Data<double>    d_timeBudget;
+    sofa::Data<bool>      d_deadlineHit;
+    sofa::Data<string>    d_qpRecovery;
+    sofa::Data<bool>      d_computeTimings;
+    sofa::Data<unsigned int> d_timingsWindow;
+    sofa::Data<map <string, vector<SReal> > > d_timings;
+    sofa::Data<bool>      d_computeCounters;
+    sofa::Data<map <string, vector<SReal> > > d_counters;
+    sofa::Data<bool>      d_profile;
+    sofa::Data<unsigned int> d_profileSteps;
+    sofa::core::objectmodel::DataFileName d_profileFile;
+    sofa::Data<bool>      d_costAttribution;
+    sofa::Data<map <string, vector<SReal> > > d_costs;
+    sofa::Data<bool>      d_exportDuals;
+    sofa::Data<vector<SReal> > d_actuatorsBoundDuals;
+    sofa::Data<vector<int> > d_actuatorsActiveSet;
+    sofa::Data<bool>      d_sensitivities;
+    sofa::Data<vector<unsigned int> > d_sensitivityRows;
+    sofa::Data<vector<SReal> > d_dfreeSensitivities;
+    sofa::Data<vector<SReal> > d_targetSensitivities;
+    sofa::Data<vector<SReal> > d_boundSensitivities;
+    sofa::Data<bool>      d_lazyProblems;
+    sofa::Data<bool>      d_problemPool;
+    sofa::Data<bool>      d_moveResolutionState;
+    sofa::Data<bool>      d_pipelined;
+    sofa::Data<bool>      d_solveOnChange;
+    sofa::Data<double>    d_solveOnChangeTolerance;
+    sofa::Data<unsigned int> d_inverseSolvePeriod;
+    sofa::Data<bool>      d_forwardWithoutEffectors;
+    sofa::Data<bool>      d_reuseConstantRows;
+    sofa::Data<bool>      d_classContiguousRows;
+    sofa::Data<bool>      d_fuseConstraintViolation;
+    sofa::Data<bool>      d_productionMode;
+    sofa::Data<unsigned int> d_horizon;
+    sofa::Data<double>    d_horizonVariationWeight;
+    sofa::Data<vector<SReal> > d_horizonTargetShifts;
+    sofa::Data<vector<string> > d_disabledConstraints;
+    sofa::Data<map <string, vector<SReal> > > d_memoryUsage;
 
 protected:
 
@@ -154,6 +355,67 @@ protected:
     module::QPInverseProblemImpl *m_lastCP, *m_currentCP;
     vector<BaseConstraintCorrection*> m_constraintsCorrections;
     vector<char> m_isConstraintCorrectionActive;
+    vector<softrobotsinverse::behavior::BatchedCompliance*> m_batchedCorrections; // null for the row by row ones
+    vector<softrobotsinverse::behavior::ComplianceOperator*> m_complianceOperators; // null for the ones without product
+    bool m_isMatrixFreeStep{false}; // W is not assembled at this step, see isMatrixFreeStep()
+    module::QPBatchedCompliance m_batchedCompliance;
+    vector<char> m_isForcelessCorrection; // no force in its states at this step, with measurementOnlyRows
+    vector<vector<unsigned int>> m_correctionGroups; // constraint corrections integrated by the same ODE solver
+    vector<unsigned int> m_sequentialCorrections;    // constraint corrections without ODE solver
+    vector<sofa::core::behavior::BaseMechanicalState::SPtr> m_constrainedStates; // written by the step, with clearConstrainedStates
+    bool m_hasConstrainedStates{false}; // false when the states written are unknown, all the states are cleared
+    vector<softrobotsinverse::behavior::ConstantRows*> m_constantRows; // of the entries of the classification, with reuseConstantRows
+    bool m_hasConstantRows{false}; // the constraint matrices of the last build can be kept while the rows are constant
+    unsigned int m_constantRowsFirstLine{0};
+    unsigned int m_nbConstantRowsReuses{0};
+    vector<sofa::core::behavior::BaseConstraintSet*> m_collectedConstraints;
+    vector<bool> m_isQPVariableRow;
+    vector<bool> m_isSensorRow; // rows left out of the compliance with lazySensors
+
+    // With lazyContactCompliance, contacts predicted inactive whose compliance between each other is deferred
+    vector<int> m_lazyContactOfRow; // contact of each lazy row, -1 for the other rows
+    vector<bool> m_isEagerRow; // rows of W that are not lazy, left out of the batched completion pass
+    bool m_hasLazyContacts{false};
+    bool m_isLazyCompletion{false}; // buildCompliance() only adds the deferred entries
+    std::set<module::QPInverseProblem::QPContactId> m_lastActiveContacts;
+    unsigned int m_nbLazyContacts{0};
+    unsigned int m_nbLazyContactMisses{0};
+    sofa::linearalgebra::FullVector<SReal> m_sensorViolation; // evaluated after the correction
+    vector<softrobots::behavior::SoftRobotsBaseConstraint*> m_batchedSensors; // out of the constraint problem with batchSensors
+    vector<unsigned int> m_batchedSensorLines; // first line of each batched sensor after the rows of the problem, and the end
+    sofa::linearalgebra::FullVector<SReal> m_residualLambda; // lambda with the rows of the batched sensors
+    module::QPComplianceCache m_complianceCache;
+    vector<module::QPComplianceCache::Action> m_complianceActions; // for each constraint correction, at this step
+    vector<vector<module::QPComplianceCache::Entry>> m_orderedEntries; // recorded contributions, deterministic mode
+    module::QPThreadAffinity m_threadAffinity;
+    module::QPTaskPool m_taskPool;
+    module::QPReducedCompliance m_reducedCompliance;
+    int m_reducedComplianceId{-1}; // constraint correction of the reduced-order compliance, -1 if none
+    vector<bool> m_isContactRow; // rows left to the full path by the reduced-order compliance
+    module::QPComplianceTable m_complianceTable;
+    module::QPChangeDetection m_changeDetection;
+
+    // Actuation of the last inverse step, kept on the forward steps of inverseSolvePeriod
+    vector<softrobots::behavior::SoftRobotsBaseConstraint*> m_heldActuators;
+    vector<double> m_heldActuatorLambdas;
+    unsigned int m_nbStepsSinceInverseSolve{0};
+    unsigned int m_nbForwardSteps{0};
+
+    std::ofstream m_complianceTableRecord;
+    vector<double> m_actuationState; // key of the compliance table at this step
+    vector<unsigned int> m_lastActuatorRowIds;
+    vector<double> m_lastActuatorForces;
+    unsigned int m_nbComplianceTableHits{0};
+    unsigned int m_nbComplianceTableMisses{0};
+    module::QPMappedCompliance m_restCompliance;
+    bool m_isRestStep{true}; // first step after init, at the rest configuration
+    vector<module::QPComplianceCache::Entry> m_restJacobian; // scratch of getRestComplianceKey()
+    void initRestCompliance();
+    uint64_t getRestComplianceKey(const ConstraintParams* cParams);
+    module::QPConstraintClassification m_constraintClassification;
+    module::QPParallelSetConstraint m_parallelSetConstraint;
+    sofa::linearalgebra::FullVector<SReal> m_fusedViolation; // written with the rows, with fuseConstraintViolation
+    bool m_isViolationFused{false};
 
     Node *m_context;
 
@@ -164,8 +426,126 @@ protected:
     double m_timeTotal;
     double m_timeScale;
 
+    module::QPTelemetry m_telemetry;
+
+    module::QPTimings m_timings;
+    module::QPTrace m_trace;
+
+    /// Start of a phase: time, and values of the counters with computeCounters
+    struct PhaseTimer {
+        sofa::helper::system::thread::ctime_t start{0};
+        module::QPPerfCounters::Values counters;
+    };
+    PhaseTimer startTimer() const;
+    void stopTimer(const module::QPTrace::NameId& phase, const PhaseTimer& timer);
+    void publishTimings();
+
+    module::QPPerfCounters m_perfCounters;
+    bool m_isCountersRequested{false};
+    module::QPTimings m_counters; // same statistics as the timings, per phase and counter
+    std::map<module::QPTrace::NameId, std::array<string, module::QPPerfCounters::NbCounters>> m_counterNames;
+    void updatePerfCounters();
+    void publishCounters();
+
+    // Report of the next steps, on request (see d_profile)
+    module::QPProfileReport m_profileReport;
+    bool m_isProfileCounters{false}; // counters opened for the report only
+    void requestProfile();
+    void beginProfileStep();
+    void fillProfileStep();
+    void publishProfileReport();
+    void openTrace();
+    void initReducedCompliance();
+    void initComplianceTable();
+    void initThreadAffinity();
+    void initTaskPool();
+    /// Scheduler of the compliance tasks, the dedicated pool if it is started, else the main task scheduler
+    sofa::simulation::TaskScheduler* getComplianceTaskScheduler();
+    bool getActuationState();
+
+    module::QPCostAttribution m_costAttribution; // accumulated over the steps
+    void publishCosts();
+    void publishDuals(const bool& decompose);
+    void publishSensitivities(const bool& decompose);
+
+    /// Names of the steps of a constraint correction, only built again when its name changes
+    struct ConstraintCorrectionNames {
+        string name;
+        string stepName; // AdvancedTimer step
+        module::QPTrace::NameId phase{0}; // timing and trace span of its compliance
+    };
+    vector<ConstraintCorrectionNames> m_constraintCorrectionNames;
+    const ConstraintCorrectionNames& getConstraintCorrectionNames(const unsigned int& i);
+
+    module::QPProblemRecorder m_recorder;
+    void openRecorder();
+
+    module::QPResultLogger m_resultLogger;
+    void openResultLogger();
+
+    // Messages of the steps, see d_asyncMessages
+    module::QPMessageQueue m_messageQueue;
+    void initMessageQueue();
+
+    // Problems dumped on anomalies only, see d_captureFile
+    module::QPProblemCapture m_problemCapture;
+    unsigned int m_nbProblemDumps{0};
+    void initProblemCapture();
+    void captureProblems(const double& time, const bool& infeasible, const int& nbPivots, const double& solveTime);
+
+    module::QPCheckpoint m_checkpoint;
+    unsigned int m_nbStepsSinceCheckpoint{0};
+    void restoreCheckpoint();
+    void writeCheckpoint();
+
+    // Record of the step, filled by solveSystem() and the timers, written once the correction is applied
+    module::QPTelemetryStream m_telemetryStream;
+    module::QPTelemetryStream::Sample m_telemetrySample;
+    bool m_hasTelemetrySample{false};
+    void openTelemetryStream();
+    void fillTelemetrySample(const double& time, const double& objective, const int& iterations);
+    void publishTelemetryStream();
+
+    // Independent subproblems, kept across steps to be hot started
+    module::QPProblemDecomposition m_decomposition;
+    vector<module::QPInverseProblemImpl*> m_subproblems;
+    vector<module::QPInverseProblemImpl*> m_solvedProblems; // m_currentCP, or the subproblems solved at this step
+    module::QPBatchSolver m_batchSolver;
+    vector<double> m_solvedObjectives;
+    vector<int> m_solvedIterations;
+
+    // Contacts coupled with the problems of other processes, see consensusChannel
+    module::QPConsensusChannel m_consensusChannel;
+    module::QPConsensus m_consensus;
+    vector<unsigned int> m_couplingRows; // All the rows of the coupling contacts
+    vector<uint64_t> m_couplingKeys; // Per coupling contact
+    vector<double> m_couplingCompliances;
+    vector<double> m_couplingForces; // Per row of m_couplingRows
+    vector<double> m_couplingDeltas; // Per coupling contact, normal displacement
+    void openConsensusChannel();
+    bool isConsensusEnabled() const {return m_consensusChannel.isOpen() || !d_consensusContacts.getValue().empty();}
+    /// Lists the contacts of the components of consensusContacts, keyed by the index of their component in the
+    /// list and their persistent id (their rank in the component if they have none)
+    void findCouplingContacts(const unsigned int& contactNbLines);
+    /// Solves the current problem with the forces of the coupling contacts imposed, until the consensus on
+    /// them is reached with the other nodes (see QPConsensus)
+    void solveConsensus(double& objective, int& iterations);
+
+    // Pipelined mode: the problem of a step is solved on the worker during the next step
+    module::QPSolveWorker m_solveWorker;
+    module::QPInverseProblemImpl* m_pipelinedCP{nullptr}; // solved, its results not applied yet
+    double m_pipelinedObjective{0.};
+    int m_pipelinedIterations{0};
+
     virtual void createProblems();
     void deleteProblems();
+    /// Allocates the problem if needed (lazy mode)
+    module::QPInverseProblemImpl* getProblem(module::QPInverseProblemImpl*& problem);
+    /// New problem, taken from the pool of the process with problemPool
+    module::QPInverseProblemImpl* newProblem() const;
+    void deleteProblem(module::QPInverseProblemImpl* problem) const;
+    void publishMemoryUsage();
+    module::QPInverseProblem::QPMemoryUsage m_peakMemoryUsage; // High-water mark of the sum over the problems
 
 
 private:
@@ -174,6 +554,85 @@ private:
     void computeConstraintViolation(const ConstraintParams *cParams);
     void getConstraintCorrectionState();
     void buildCompliance(const ConstraintParams *cParams);
+    /// Builds W: interpolated from the compliance table, read from the mapped file or computed
+    void assembleCompliance(const ConstraintParams *cParams);
+    /// With matrixFree, true when the step can be solved without W: the active constraint corrections apply
+    /// their compliance to a vector, the problem is supported by QPMatrixFreeSolver and none of the options
+    /// reading W is enabled
+    bool isMatrixFreeStep();
+    /// With lazyContactCompliance, flags the contacts which are neither penetrating (up to lazyContactMargin)
+    /// nor active at the last step: their compliance between each other is not computed
+    void selectLazyContacts();
+    /// True when all the lazy contacts are inactive in the solution, which is then the one of the full W
+    bool isLazyContactsSolution() const;
+    /// Adds the deferred entries of W and solves the problem again
+    void completeLazyContacts(const ConstraintParams *cParams, double& objective, int& iterations);
+    void storeActiveContacts();
+    void addKeptCompliance(const unsigned int& i, sofa::linearalgebra::BaseMatrix* W);
+    class ComputeComplianceTask;
+    void mergeComplianceInOrder(const vector<ComputeComplianceTask>& tasks, sofa::linearalgebra::BaseMatrix* W,
+                                sofa::Index rowBegin, sofa::Index rowEnd,
+                                const vector<bool>* isQPVariableRow, const vector<bool>* isSkippedRow);
+    /// Groups the constraint corrections by ODE solver: the groups write disjoint states, so that with
+    /// multithreading their motion corrections are applied concurrently
+    void initCorrectionGroups();
+    void correctMotion(const unsigned int& i, const ConstraintParams *cParams, MultiVecId res1, MultiVecId res2);
+    /// Lists the states in which the step writes lambda and dx: the states of the constraints, their parents
+    /// through the mappings, and the states integrated by the ODE solvers of the independent ones
+    void findConstrainedStates();
+    /// Whether the constraint matrices just built can be kept at the next steps (see reuseConstantRows)
+    void findConstantRows(const unsigned int& firstLine);
+    /// Keeps the constraint matrices of the last build when the constraints are the same and their rows are
+    /// constant, only their rows being registered in the problem. False when they have to be built.
+    bool keepConstantRows(const ConstraintParams* cParams, unsigned int& nbLinesTotal);
+    /// Marks the constraint corrections whose states receive no force at this step: their rows are only
+    /// measurement-only rows (effectors, sensors) or rows of zero lambda
+    void findForcelessCorrections();
+    /// Clears the vector in the states listed by findConstrainedStates, or in all the states if they are unknown
+    void clearConstrainedStates(const ConstraintParams *cParams, const MultiVecDerivId& vid);
+    class CorrectMotionTask;
+    bool hasLazySensors() const;
+    void evaluateSensors(const ConstraintParams *cParams, MultiVecId res1, MultiVecId res2);
+    /// Propagates the corrected state to the mapped states, and sets the state and the (cleared) correction
+    /// buffer read by the sensors
+    void setSensorParams(const ConstraintParams *cParams, MultiVecId res1, MultiVecId res2, ConstraintParams& sensorParams);
+    /// Builds the rows of the batched sensors after the rows of the problem and evaluates them from the
+    /// corrected state, concurrently for the ones that support it
+    void evaluateBatchedSensors(const ConstraintParams *cParams, MultiVecId res1, MultiVecId res2);
+    class EvaluateSensorTask;
+    void setProblemParameters(module::QPInverseProblemImpl* problem, const double& time);
+    /// Fills the disabled constraints of the lists of the problem from the data disabledConstraints
+    void setDisabledConstraints(module::QPInverseProblemImpl* problem) const;
+    void solveSubproblems(const double& time, double& objective, int& iterations);
+    bool solvePipelined(double& objective, int& iterations);
+    void stopPipeline();
+    /// Solves the current problem, or reuses the last solution when solveOnChange is set and the problem
+    /// did not change since
+    void solveOnChange(double& objective, int& iterations);
+    /// Hash of the parameters given to the problems by setProblemParameters(), but the time (a change of
+    /// one of them is a change of the problem for solveOnChange)
+    uint64_t getProblemParametersKey() const;
+    /// Solves only the contacts with the actuation of the last inverse step, false on the steps of the inverse
+    /// resolution (see inverseSolvePeriod)
+    bool solveForwardStep(double& objective, int& iterations);
+    void holdActuation();
+    bool hasSameRows(module::QPInverseProblemImpl* problem, module::QPInverseProblemImpl* other) const;
+
+    /// Products d = W f of the matrix-free resolution, summed over the active constraint corrections
+    class ComplianceProduct : public module::QPMatrixFreeSolver::Operator
+    {
+    public:
+        void set(QPInverseProblemSolver* _solver, const ConstraintParams* _cParams){
+            solver = _solver;
+            cParams = _cParams;
+        }
+        bool apply(const vector<double>& f, vector<double>& d) override;
+
+    private:
+        QPInverseProblemSolver* solver{nullptr};
+        const ConstraintParams* cParams{nullptr};
+    };
+    ComplianceProduct m_complianceProduct;
 
     class ComputeComplianceTask : public sofa::simulation::CpuTask
     {
@@ -182,22 +641,275 @@ private:
         ~ComputeComplianceTask() override {}
 
         MemoryAlloc run() final {
-            cc->addComplianceInConstraintSpace(&cparams, &W);
+            if (affinity)
+                affinity->pinCurrentThread();
+            const bool isTraced = (trace && trace->isOpen());
+            sofa::helper::system::thread::ctime_t start = (computeTime || isTraced)? CTime::getTime() : 0;
+
+            // First touch by the thread running the task, so that W is allocated on its NUMA node. The task is
+            // kept across the steps (see m_complianceTasks): with the same size, only the rows written at its
+            // last run are cleared
+            if (W.rowSize() != (sofa::Index)dim)
+                W.resize(dim,dim);
+            else
+                for (const sofa::Index& i : touchedIds)
+                    std::fill(W[i], W[i]+dim, 0.);
+
+            // Record the rows written by the constraint correction, so that the merge only visits those
+            touchedRows.assign(W.rowSize(), false);
+            module::QPComplianceMatrix trackedW(&W, isQPVariableRow, &touchedRows);
+            trackedW.setSkippedRows(isSkippedRow);
+            trackedW.setUpperTriangle(isUpperTriangle);
+            if (lazyContactOfRow)
+                trackedW.setLazyContacts(lazyContactOfRow, isLazyCompletion);
+            if (entries)
+            {
+                module::QPComplianceCache::Recorder recordedW(&trackedW, entries);
+                if (!batchedCompliance || !batchedCompliance->add(batched, &cparams, &recordedW))
+                    cc->addComplianceInConstraintSpace(&cparams, &recordedW);
+            }
+            else if (!batchedCompliance || !batchedCompliance->add(batched, &cparams, &trackedW))
+                cc->addComplianceInConstraintSpace(&cparams, &trackedW);
+
+            touchedIds.clear();
+            for (sofa::Index i=0; i<touchedRows.size(); i++)
+                if (touchedRows[i])
+                    touchedIds.push_back(i);
+
+            if (computeTime)
+                time = 1000.*(double)(CTime::getTime() - start)/(double)CTime::getTicksPerSec();
+            if (isTraced)
+                trace->end(span, start);
             return MemoryAlloc::Stack;
         }
 
-        void set(sofa::core::behavior::BaseConstraintCorrection* _cc, sofa::core::ConstraintParams _cparams, int dim){
+        void set(sofa::core::behavior::BaseConstraintCorrection* _cc, sofa::core::ConstraintParams _cparams, int _dim,
+                 const vector<bool>* _isQPVariableRow = nullptr, bool _computeTime = false){
             cc = _cc;
             cparams = _cparams;
-            W.resize(dim,dim);
+            isQPVariableRow = _isQPVariableRow;
+            computeTime = _computeTime;
+            dim = _dim;
+            isComputed = true;
+        }
+
+        /// The constraint correction is not computed at this step, the task is not merged
+        void skip(){
+            isComputed = false;
+        }
+
+        void setTrace(module::QPTrace* _trace, const module::QPTrace::NameId& _span){
+            trace = _trace;
+            span = _span;
+        }
+
+        void setThreadAffinity(const module::QPThreadAffinity* _affinity){
+            affinity = _affinity;
         }
 
+        /// Records the contribution of the constraint correction in the compliance cache
+        void setRecordedEntries(vector<module::QPComplianceCache::Entry>* _entries){
+            entries = _entries;
+        }
+
+        /// Leaves the entries of the flagged rows and columns out of the compliance
+        void setSkippedRows(const vector<bool>* _isSkippedRow){
+            isSkippedRow = _isSkippedRow;
+        }
+
+        /// Defers the entries between the lazy contacts, or only computes them, see QPComplianceMatrix
+        void setLazyContacts(const vector<int>* _lazyContactOfRow, bool _isLazyCompletion){
+            lazyContactOfRow = _lazyContactOfRow;
+            isLazyCompletion = _isLazyCompletion;
+        }
+
+        /// Only keeps the upper triangle of the contribution, see symmetricCompliance
+        void setUpperTriangle(bool _isUpperTriangle){
+            isUpperTriangle = _isUpperTriangle;
+        }
+
+        /// Computes the contribution of the constraint correction for the rows of the block at once when it batches
+        void setBatched(const module::QPBatchedCompliance* _batchedCompliance,
+                        softrobotsinverse::behavior::BatchedCompliance* _batched){
+            batchedCompliance = _batchedCompliance;
+            batched = _batched;
+        }
+
+        const sofa::linearalgebra::LPtrFullMatrix<double>& getW() const {return W;}
+        const vector<sofa::Index>& getTouchedIds() const {return touchedIds;}
+        bool isComputedStep() const {return isComputed;}
+
     private:
-        sofa::core::behavior::BaseConstraintCorrection* cc;
+        sofa::core::behavior::BaseConstraintCorrection* cc{nullptr};
+        softrobotsinverse::behavior::BatchedCompliance* batched{nullptr};
+        const module::QPBatchedCompliance* batchedCompliance{nullptr};
         sofa::linearalgebra::LPtrFullMatrix<double> W;
+        int dim{0};
         sofa::core::ConstraintParams cparams;
+        const vector<bool>* isQPVariableRow{nullptr};
+        const vector<bool>* isSkippedRow{nullptr};
+        const vector<int>* lazyContactOfRow{nullptr};
+        bool isLazyCompletion{false};
+        bool isUpperTriangle{false};
+        vector<char> touchedRows;
+        vector<sofa::Index> touchedIds; // sorted
+        bool isComputed{false};
+        bool computeTime{false};
+        double time{0.}; // in ms
+        module::QPTrace* trace{nullptr};
+        module::QPTrace::NameId span{0};
+        vector<module::QPComplianceCache::Entry>* entries{nullptr};
+        const module::QPThreadAffinity* affinity{nullptr};
         friend class QPInverseProblemSolver;
     };
+
+    /// Computes and applies the motion corrections of a group of constraint corrections, in order
+    class CorrectMotionTask : public sofa::simulation::CpuTask
+    {
+    public:
+        CorrectMotionTask(sofa::simulation::CpuTask::Status* status): CpuTask(status) {}
+        ~CorrectMotionTask() override {}
+
+        MemoryAlloc run() final {
+            for (const unsigned int& i : *ids)
+                solver->correctMotion(i, cparams, res1, res2);
+            return MemoryAlloc::Stack;
+        }
+
+        void set(QPInverseProblemSolver* _solver, const vector<unsigned int>* _ids, const ConstraintParams* _cparams,
+                 MultiVecId _res1, MultiVecId _res2){
+            solver = _solver;
+            ids = _ids;
+            cparams = _cparams;
+            res1 = _res1;
+            res2 = _res2;
+        }
+
+    private:
+        QPInverseProblemSolver* solver{nullptr};
+        const vector<unsigned int>* ids{nullptr};
+        const ConstraintParams* cparams{nullptr};
+        MultiVecId res1;
+        MultiVecId res2;
+    };
+
+    /// Evaluates a batched sensor from the corrected state and stores its results
+    class EvaluateSensorTask : public sofa::simulation::CpuTask
+    {
+    public:
+        EvaluateSensorTask(sofa::simulation::CpuTask::Status* status): CpuTask(status) {}
+        ~EvaluateSensorTask() override {}
+
+        MemoryAlloc run() final {
+            static_cast<sofa::core::behavior::BaseConstraintSet*>(sensor)->getConstraintViolation(cparams, violation);
+            delta.resize(nbLines);
+            for (unsigned int i=0; i<nbLines; i++)
+                delta[i] = violation->element(firstLine+i);
+            sensor->storeResults(delta);
+            return MemoryAlloc::Stack;
+        }
+
+        void set(softrobots::behavior::SoftRobotsBaseConstraint* _sensor, const sofa::core::ConstraintParams* _cparams,
+                 sofa::linearalgebra::FullVector<SReal>* _violation, unsigned int _firstLine, unsigned int _nbLines){
+            sensor = _sensor;
+            cparams = _cparams;
+            violation = _violation;
+            firstLine = _firstLine;
+            nbLines = _nbLines;
+        }
+
+    private:
+        softrobots::behavior::SoftRobotsBaseConstraint* sensor{nullptr};
+        const sofa::core::ConstraintParams* cparams{nullptr};
+        sofa::linearalgebra::FullVector<SReal>* violation{nullptr}; // the sensors write their own lines
+        unsigned int firstLine{0};
+        unsigned int nbLines{0};
+        vector<double> delta;
+    };
+
+    /// Adds the compliance computed by each ComputeComplianceTask into the rows [rowBegin, rowEnd) of W.
+    /// The merge tasks own disjoint row ranges, so they can run concurrently without locks.
+    /// In deterministic mode, the recorded contributions are replayed in the order of the sequential
+    /// resolution, together with the kept ones, so that W is bitwise the same.
+    class MergeComplianceTask : public sofa::simulation::CpuTask
+    {
+    public:
+        MergeComplianceTask(sofa::simulation::CpuTask::Status* status): CpuTask(status) {}
+        ~MergeComplianceTask() override {}
+
+        MemoryAlloc run() final {
+            if (affinity)
+                affinity->pinCurrentThread();
+            if (solver)
+            {
+                solver->mergeComplianceInOrder(*tasks, W, rowBegin, rowEnd, isQPVariableRow, isSkippedRow);
+                return MemoryAlloc::Stack;
+            }
+
+            for (const ComputeComplianceTask& task : *tasks)
+            {
+                if (!task.isComputedStep())
+                    continue;
+
+                const vector<sofa::Index>& ids = task.getTouchedIds();
+                const auto& Wt = task.getW();
+
+                for (sofa::Index j : ids)
+                {
+                    if (j < rowBegin) continue;
+                    if (j >= rowEnd) break;
+
+                    SReal* Wj = (*W)[j];
+                    const double* Wtj = Wt[j];
+                    auto first = (isUpperTriangle)? std::lower_bound(ids.begin(), ids.end(), j) : ids.begin();
+                    for (auto l = first; l != ids.end(); ++l)
+                        Wj[*l] += Wtj[*l];
+                }
+            }
+            return MemoryAlloc::Stack;
+        }
+
+        void set(sofa::linearalgebra::LPtrFullMatrix<SReal>* _W, const vector<ComputeComplianceTask>* _tasks,
+                 sofa::Index _rowBegin, sofa::Index _rowEnd){
+            W = _W;
+            tasks = _tasks;
+            rowBegin = _rowBegin;
+            rowEnd = _rowEnd;
+        }
+
+        void setThreadAffinity(const module::QPThreadAffinity* _affinity){
+            affinity = _affinity;
+        }
+
+        /// The contributions only have their upper triangle, see symmetricCompliance
+        void setUpperTriangle(bool _isUpperTriangle){
+            isUpperTriangle = _isUpperTriangle;
+        }
+
+        void setDeterministic(QPInverseProblemSolver* _solver, const vector<bool>* _isQPVariableRow,
+                              const vector<bool>* _isSkippedRow){
+            solver = _solver;
+            isQPVariableRow = _isQPVariableRow;
+            isSkippedRow = _isSkippedRow;
+        }
+
+    private:
+        sofa::linearalgebra::LPtrFullMatrix<SReal>* W{nullptr};
+        const vector<ComputeComplianceTask>* tasks{nullptr};
+        sofa::Index rowBegin{0};
+        sofa::Index rowEnd{0};
+        bool isUpperTriangle{false};
+        const module::QPThreadAffinity* affinity{nullptr};
+        QPInverseProblemSolver* solver{nullptr}; // deterministic mode
+        const vector<bool>* isQPVariableRow{nullptr};
+        const vector<bool>* isSkippedRow{nullptr};
+    };
+
+    // Tasks of the multithreaded compliance, kept across the steps with the contribution buffers of the
+    // constraint corrections, so that building the compliance does not allocate
+    sofa::simulation::CpuTask::Status m_complianceStatus;
+    vector<ComputeComplianceTask> m_complianceTasks;
+    vector<MergeComplianceTask> m_mergeTasks;
 };
 
 } // namespace
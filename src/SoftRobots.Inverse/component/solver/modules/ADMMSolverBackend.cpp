@@ -0,0 +1,188 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+#include <SoftRobots.Inverse/component/solver/modules/ADMMSolverBackend.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+using Eigen::VectorXd;
+using Eigen::Infinity;
+
+namespace
+{
+    const double s_infinity = std::numeric_limits<double>::infinity();
+    const double s_rhoMin = 1e-6;
+    const double s_rhoMax = 1e6;
+
+    double toBound(const real_t* bounds, int i, double infinity)
+    {
+        if(!bounds) return infinity;
+        if(bounds[i] >= 1e20) return s_infinity;
+        if(bounds[i] <= -1e20) return -s_infinity;
+        return bounds[i];
+    }
+}
+
+
+bool ADMMSolverBackend::solve(int nbVariables, int nbConstraints,
+                              const real_t* H, const real_t* g, const real_t* A,
+                              const real_t* lb, const real_t* ub, const real_t* lbA, const real_t* ubA,
+                              real_t* x, real_t* y, real_t& objective)
+{
+    m_nbIterations = 0;
+    m_timeLimitReached = false;
+    objective = 0.;
+    if(nbVariables == 0)
+        return true;
+
+    int nbRows = nbVariables + nbConstraints;
+    ConstMatrixMap Hm(H, nbVariables, nbVariables);
+    ConstMatrixMap Am(A, nbConstraints, nbVariables);
+    Eigen::Map<const VectorXd> gv(g, nbVariables);
+
+    m_l.resize(nbRows);
+    m_u.resize(nbRows);
+    m_rhoRows.resize(nbRows);
+    for(int i=0; i<nbRows; i++)
+    {
+        bool isBound = (i<nbVariables);
+        m_l[i] = isBound? toBound(lb, i, -s_infinity) : toBound(lbA, i-nbVariables, -s_infinity);
+        m_u[i] = isBound? toBound(ub, i, s_infinity) : toBound(ubA, i-nbVariables, s_infinity);
+
+        // As in OSQP: stiffer equality rows, almost free unbounded rows
+        if(m_u[i] - m_l[i] < 1e-10)                               m_rhoRows[i] = 1e3*m_rho;
+        else if(m_l[i] == -s_infinity && m_u[i] == s_infinity)     m_rhoRows[i] = s_rhoMin;
+        else                                                       m_rhoRows[i] = m_rho;
+    }
+
+    // Warm start from the previous resolution when the layout did not change
+    if(m_x.size() != nbVariables || m_z.size() != nbRows)
+    {
+        m_x.setZero(nbVariables);
+        m_z.setZero(nbRows);
+        m_y.setZero(nbRows);
+    }
+
+    if(!factorize(Hm, Am, nbVariables))
+        return false;
+
+    VectorXd w(nbRows), rhs(nbVariables), xTilde(nbVariables), zTilde(nbRows), zRelaxed(nbRows);
+    VectorXd Cx(nbRows), Hx(nbVariables), Cty(nbVariables);
+    bool converged = false;
+    auto start = std::chrono::steady_clock::now();
+
+    for(int k=0; k<m_maxIterations && !converged; k++)
+    {
+        m_nbIterations++;
+
+        // (H + sigma*I + C^T*rho*C) xTilde = sigma*x - g + C^T*(rho*z - y)
+        w = m_rhoRows.cwiseProduct(m_z) - m_y;
+        rhs = m_sigma*m_x - gv + w.head(nbVariables);
+        rhs.noalias() += Am.transpose()*w.tail(nbConstraints);
+        xTilde = m_structuredFactorization? m_bordered.solve(rhs) : m_llt.solve(rhs);
+
+        zTilde.head(nbVariables) = xTilde;
+        zTilde.tail(nbConstraints).noalias() = Am*xTilde;
+
+        m_x = m_alpha*xTilde + (1.-m_alpha)*m_x;
+        zRelaxed = m_alpha*zTilde + (1.-m_alpha)*m_z;
+        m_z = (zRelaxed + m_y.cwiseQuotient(m_rhoRows)).cwiseMax(m_l).cwiseMin(m_u);
+        m_y += m_rhoRows.cwiseProduct(zRelaxed - m_z);
+
+        if(k % m_checkInterval != 0 && k != m_maxIterations-1)
+            continue;
+
+        // Residuals
+        Cx.head(nbVariables) = m_x;
+        Cx.tail(nbConstraints).noalias() = Am*m_x;
+        Hx.noalias() = Hm*m_x;
+        Cty = m_y.head(nbVariables);
+        Cty.noalias() += Am.transpose()*m_y.tail(nbConstraints);
+
+        double primalScale = std::max(Cx.lpNorm<Infinity>(), m_z.lpNorm<Infinity>());
+        double dualScale = std::max({Hx.lpNorm<Infinity>(), Cty.lpNorm<Infinity>(), gv.lpNorm<Infinity>()});
+        double primalResidual = (Cx - m_z).lpNorm<Infinity>();
+        double dualResidual = (Hx + gv + Cty).lpNorm<Infinity>();
+
+        converged = (primalResidual <= m_epsAbs + m_epsRel*primalScale &&
+                     dualResidual <= m_epsAbs + m_epsRel*dualScale);
+
+        if(!converged && m_timeLimit>0. &&
+                std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() > m_timeLimit)
+        {
+            m_timeLimitReached = true;
+            break;
+        }
+
+        // Balance the primal and dual residuals by adapting rho
+        double ratio = std::sqrt((primalResidual/(primalScale+1e-10)) / (dualResidual/(dualScale+1e-10)+1e-10));
+        if(!converged && (ratio > 5. || ratio < 0.2))
+        {
+            for(int i=0; i<nbRows; i++)
+                m_rhoRows[i] = std::min(std::max(m_rhoRows[i]*ratio, s_rhoMin), s_rhoMax);
+            if(!factorize(Hm, Am, nbVariables))
+                return false;
+        }
+    }
+
+    Eigen::Map<VectorXd>(x, nbVariables) = m_x;
+    Eigen::Map<VectorXd>(y, nbRows) = -m_y; // qpOASES sign convention
+    Hx.noalias() = Hm*m_x;
+    objective = 0.5*m_x.dot(Hx) + gv.dot(m_x);
+
+    return converged;
+}
+
+
+bool ADMMSolverBackend::factorize(const ConstMatrixMap& H, const ConstMatrixMap& A, int nbVariables)
+{
+    m_K = H;
+    m_K.diagonal().array() += m_sigma;
+    m_K.diagonal() += m_rhoRows.head(nbVariables);
+    m_K.noalias() += A.transpose()*m_rhoRows.tail(A.rows()).asDiagonal()*A;
+
+    if(m_structuredFactorization)
+    {
+        m_bordered.setBorderSize(m_borderSize);
+        m_bordered.setMultithreading(m_multithreading);
+        return m_bordered.compute(m_K);
+    }
+
+    m_llt.compute(m_K);
+    return (m_llt.info() == Eigen::Success);
+}
+
+} // namespace
@@ -0,0 +1,90 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <Eigen/Core>
+#include <Eigen/Cholesky>
+
+#include <SoftRobots.Inverse/component/solver/modules/QPBorderedFactorization.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPSolverBackend.h>
+#include <SoftRobots.Inverse/component/config.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+/// Operator splitting (ADMM) QP solver, following the OSQP scheme:
+/// the constraints are written l <= Cx = z <= u with C = [I; A], and each iteration solves
+/// a linear system with the fixed matrix H + sigma*I + C^T*diag(rho)*C, factorized once by
+/// resolution (or when rho is adapted). Its cost grows with the size of the system instead of
+/// the number of active set changes, and it is warm started from the previous resolution when
+/// the layout does not change. The solution is only accurate up to the tolerances.
+/// With the structured factorization, the system is factorized by blocks when it is bordered block-diagonal.
+class SOFA_SOFTROBOTS_INVERSE_API ADMMSolverBackend : public QPSolverBackend
+{
+public:
+    bool solve(int nbVariables, int nbConstraints,
+               const real_t* H, const real_t* g, const real_t* A,
+               const real_t* lb, const real_t* ub, const real_t* lbA, const real_t* ubA,
+               real_t* x, real_t* y, real_t& objective) override;
+
+    std::string getName() const override {return "ADMM";}
+
+    void setTolerances(const double& absolute, const double& relative) {m_epsAbs = absolute; m_epsRel = relative;}
+    void setMaxIterations(const int& maxIterations) {m_maxIterations = maxIterations;}
+
+    /// Factorization of the last resolution, by blocks if structured
+    const QPBorderedFactorization& getStructuredFactorization() const {return m_bordered;}
+
+protected:
+    typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> RowMajorMatrixXd;
+    typedef Eigen::Map<const RowMajorMatrixXd> ConstMatrixMap;
+
+    double m_rho{0.1};
+    double m_sigma{1e-6};
+    double m_alpha{1.6};
+    double m_epsAbs{1e-6};
+    double m_epsRel{1e-6};
+    int m_maxIterations{4000};
+    int m_checkInterval{10};
+
+    // Bounds and step sizes of the rows of C = [I; A]
+    Eigen::VectorXd m_l, m_u, m_rhoRows;
+
+    // Iterates, kept to warm start the next resolution
+    Eigen::VectorXd m_x, m_z, m_y;
+
+    Eigen::MatrixXd m_K;
+    Eigen::LLT<Eigen::MatrixXd> m_llt;
+    QPBorderedFactorization m_bordered;
+
+    bool factorize(const ConstMatrixMap& H, const ConstMatrixMap& A, int nbVariables);
+};
+
+} // namespace
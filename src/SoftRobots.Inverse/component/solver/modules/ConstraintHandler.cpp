@@ -31,6 +31,8 @@
 
 #include <SoftRobots.Inverse/component/solver/modules/ConstraintHandler.h>
 
+#include <algorithm>
+
 namespace softrobotsinverse::solver::module {
 
 using sofa::type::vector;
@@ -38,14 +40,192 @@ using softrobots::behavior::SoftRobotsBaseConstraint;
 using sofa::helper::rabs;
 
 
-void ConstraintHandler::buildInequalityConstraintMatrices(const vector<double> &result,
-                                                          QPInverseProblem::QPSystem* qpSystem,
-                                                          QPInverseProblem::QPConstraintLists* qpCLists)
+namespace
 {
-    bool error = checkCListsConsistency(qpCLists);
-    if(error)
-        return;
 
+/// Signs of the tangential forces of a sliding contact, on which its constraint rows depend
+int getSlidingSignature(const vector<double> &result,
+                        QPInverseProblem::QPSystem* qpSystem,
+                        const unsigned int& i,
+                        const unsigned int& contactNbLines)
+{
+    int signature = 0;
+    for (unsigned int k=1; k<contactNbLines; k++)
+    {
+        int sign = (result[i+k]>0)? 1 : (result[i+k]<0)? 2 : 0;
+        if(rabs(result[i+k])<1e-13 && qpSystem->previousResult.size()!=0)
+            sign |= (qpSystem->previousResult[i+k]>0)? 4 : (qpSystem->previousResult[i+k]<0)? 8 : 0;
+        signature |= sign << (4*(k-1));
+    }
+    return signature;
+}
+
+/// Sign of the tangential force of a sliding contact along the direction of row i, from the
+/// previous resolution when the force vanishes
+double getSlidingForceSign(const vector<double> &result,
+                           QPInverseProblem::QPSystem* qpSystem,
+                           const unsigned int& i)
+{
+    if(result[i]<0)
+        return -1.;
+    if(rabs(result[i])<1e-13 && qpSystem->previousResult.size()!=0 && qpSystem->previousResult[i]<0)
+        return -1.;
+    return 1.;
+}
+
+/// Facet of the friction cone on which the force of the sliding contact of first row i lies
+unsigned int getSlidingFacetId(const vector<double> &result,
+                               QPInverseProblem::QPSystem* qpSystem,
+                               const ConstraintHandler::QPConstraintParams* qpCParams,
+                               const unsigned int& i)
+{
+    const unsigned int t = i+qpCParams->slidingDirId1;
+    const unsigned int o = i+qpCParams->slidingDirId2;
+    return qpCParams->frictionCone.getFacetId(getSlidingForceSign(result, qpSystem, t),
+                                              getSlidingForceSign(result, qpSystem, o),
+                                              result[t], result[o]);
+}
+
+}
+
+
+void ConstraintHandler::ConstraintRows::clear()
+{
+    A.clear();
+    bl.clear();
+    bu.clear();
+    constraintsId.clear();
+    nbLines = 0;
+    isValid = false;
+}
+
+
+void ConstraintHandler::ConstraintRowsCache::clear(const unsigned int& _dim, const bool& _hasBothSideInequalityConstraint)
+{
+    // The blocks keep their memory
+    for (ConstraintRows& block : blocks)
+        block.isValid = false;
+    dim = _dim;
+    hasBothSideInequalityConstraint = _hasBothSideInequalityConstraint;
+}
+
+
+void ConstraintHandler::setReuseConstraintRows(const bool& reuse)
+{
+    m_reuseConstraintRows = reuse;
+    m_inequalityRowsCache.clear(0, false);
+    m_equalityRowsCache.clear(0, false);
+}
+
+
+ConstraintHandler::ConstraintRows& ConstraintHandler::getConstraintRows(ConstraintRowsCache& cache,
+                                                                        const unsigned int& blockId,
+                                                                        const vector<double> &result,
+                                                                        QPInverseProblem::QPSystem* qpSystem,
+                                                                        QPInverseProblem::QPConstraintLists* qpCLists,
+                                                                        const unsigned int& firstLine)
+{
+    if(blockId == cache.blocks.size())
+        cache.blocks.emplace_back();
+    ConstraintRows& block = cache.blocks[blockId];
+
+    const ContactHandler* state = nullptr;
+    int slidingSignature = 0;
+    const unsigned int firstContactLine = qpCLists->actuatorRowIds.size() + qpCLists->equalityRowIds.size();
+    if(firstLine >= firstContactLine)
+    {
+        state = m_qpCParams->contactStates[(firstLine-firstContactLine)/m_qpCParams->contactNbLines];
+        if(state == &m_qpCParams->slidingContact)
+        {
+            slidingSignature = getSlidingSignature(result, qpSystem, firstLine, m_qpCParams->contactNbLines);
+            if(m_qpCParams->frictionCone.getNbFacets() > 4) // Several facets per sign pattern
+                slidingSignature |= getSlidingFacetId(result, qpSystem, m_qpCParams, firstLine) << 16;
+        }
+    }
+
+    if(block.isValid && block.firstLine == firstLine && block.state == state && block.slidingSignature == slidingSignature)
+    {
+        m_nbReusedConstraintRows++;
+        return block;
+    }
+
+    block.clear();
+    block.firstLine = firstLine;
+    block.state = state;
+    block.slidingSignature = slidingSignature;
+    m_nbBuiltConstraintRows++;
+    return block;
+}
+
+
+void ConstraintHandler::appendConstraintRows(const ConstraintRowsCache& cache,
+                                             const unsigned int& nbBlocks,
+                                             QPInverseProblem::QPMatrix& A,
+                                             vector<double>* bl,
+                                             vector<double>& bu)
+{
+    for (unsigned int k=0; k<nbBlocks; k++)
+    {
+        const ConstraintRows& block = cache.blocks[k];
+        A.push_back(block.A);
+        if(bl)
+            bl->insert(bl->end(), block.bl.begin(), block.bl.end());
+        bu.insert(bu.end(), block.bu.begin(), block.bu.end());
+        m_qpCParams->constraintsId.insert(m_qpCParams->constraintsId.end(), block.constraintsId.begin(), block.constraintsId.end());
+    }
+}
+
+
+void ConstraintHandler::updateVariableColumns(QPInverseProblem::QPSystem* qpSystem,
+                                              QPInverseProblem::QPConstraintLists* qpCLists)
+{
+    unsigned int nbActuatorRows   = qpCLists->actuatorRowIds.size();
+    unsigned int nbEqualityRows   = qpCLists->equalityRowIds.size();
+
+    m_variableColumns.resize(qpSystem->dim);
+    for (unsigned int j=0; j<qpSystem->dim; j++)
+    {
+        if (j<nbActuatorRows)                      m_variableColumns[j] = qpCLists->actuatorRowIds[j];
+        else if (j<nbActuatorRows+nbEqualityRows)  m_variableColumns[j] = qpCLists->equalityRowIds[j-nbActuatorRows];
+        else                                       m_variableColumns[j] = qpCLists->contactRowIds[j-nbActuatorRows-nbEqualityRows];
+    }
+}
+
+
+double* ConstraintHandler::appendRow(QPInverseProblem::QPMatrix& A,
+                                     const unsigned int& dim)
+{
+    // The rows of a block are cleared before a build, the new entries of the buffer are value-initialized (0)
+    A.resize(A.nbRows()+1, dim);
+    return A[A.nbRows()-1];
+}
+
+
+void ConstraintHandler::appendWRow(QPInverseProblem::QPMatrix& A,
+                                   QPInverseProblem::QPSystem* qpSystem,
+                                   const unsigned int& wRow,
+                                   const double& sign)
+{
+    // Row of W restricted to the columns of the QP variables [actuators equality contacts]
+    double* row = appendRow(A, qpSystem->dim);
+    const double* w = qpSystem->W[wRow];
+    for (unsigned int j=0; j<qpSystem->dim; j++)
+        row[j] = w[m_variableColumns[j]]*sign;
+}
+
+
+unsigned int ConstraintHandler::getBlockNbLines(const unsigned int& i,
+                                                QPInverseProblem::QPConstraintLists* qpCLists) const
+{
+    if (i<qpCLists->actuatorRowIds.size()+qpCLists->equalityRowIds.size())
+        return qpCLists->variableRows[i].nbLines;
+    return m_qpCParams->contactNbLines;
+}
+
+
+void ConstraintHandler::beginInequalityConstraintMatrices(QPInverseProblem::QPSystem* qpSystem,
+                                                          QPInverseProblem::QPConstraintLists* qpCLists)
+{
     /// Problem:
     ///     minimize(1/2 lambdaT*Q*lambda + cT*lambda)
     ///     s.t     A*lambda <= bu
@@ -60,261 +240,356 @@ void ConstraintHandler::buildInequalityConstraintMatrices(const vector<double> &
     qpSystem->bu.clear();
     qpSystem->bl.clear();
 
-    unsigned int nbActuatorRows   = qpCLists->actuatorRowIds.size();
-    unsigned int nbEqualityRows   = qpCLists->equalityRowIds.size();
-
-    for (unsigned int i=0; i<qpCLists->actuators.size(); i++)
-        if((qpCLists->actuators[i]->hasDeltaMax() && qpCLists->actuators[i]->hasDeltaMin())
-                || (qpCLists->actuators[i]->hasLambdaMax() && qpCLists->actuators[i]->hasLambdaMin())){
-            qpSystem->hasBothSideInequalityConstraint = true;}
+    if(qpCLists->hasBothSideActuatorLimits)
+        qpSystem->hasBothSideInequalityConstraint = true;
 
+    m_contactLimitsVariable = -1;
     if(m_qpCParams->hasMinContactForces || m_qpCParams->hasMaxContactForces)
         addContactLimits(qpSystem, qpCLists);
     if(m_qpCParams->hasMinContactForces && m_qpCParams->hasMaxContactForces)
         qpSystem->hasBothSideInequalityConstraint = true;
 
-    int actuatorsId = 0;
+    if(!m_reuseConstraintRows || qpSystem->dim != m_inequalityRowsCache.dim
+            || qpSystem->hasBothSideInequalityConstraint != m_inequalityRowsCache.hasBothSideInequalityConstraint)
+        m_inequalityRowsCache.clear(qpSystem->dim, qpSystem->hasBothSideInequalityConstraint);
+}
+
+
+void ConstraintHandler::beginEqualityConstraintMatrices(QPInverseProblem::QPSystem* qpSystem)
+{
+    qpSystem->Aeq.clear();
+    qpSystem->beq.clear();
+
+    if(!m_reuseConstraintRows || qpSystem->dim != m_equalityRowsCache.dim)
+        m_equalityRowsCache.clear(qpSystem->dim, false);
+}
+
+
+unsigned int ConstraintHandler::beginConstraintOnLambda(QPInverseProblem::QPSystem* qpSystem,
+                                                        QPInverseProblem::QPConstraintLists* qpCLists)
+{
+    int dim = qpSystem->Q.size(); // Different than m_system->m_dim in case of friction with sliding contacts
+    int nbActuatorRows = qpCLists->actuatorRowIds.size();
+
+    qpSystem->u.resize(qpSystem->dim);
+    qpSystem->l.resize(qpSystem->dim);
+
+    // lambda_min <= lambda_a <= lambda_max, the missing bounds being already infinite in the buffer
+    const int nbBoundedRows = std::min(nbActuatorRows, dim);
+    const QPInverseProblem::QPActuatorBounds& bounds = qpCLists->actuatorBounds;
+    std::copy(bounds.lambdaMin.begin(), bounds.lambdaMin.begin() + nbBoundedRows, qpSystem->l.begin());
+    std::copy(bounds.lambdaMax.begin(), bounds.lambdaMax.begin() + nbBoundedRows, qpSystem->u.begin());
+    return std::max(nbBoundedRows, 0);
+}
+
+
+ConstraintHandler::ContactModel ConstraintHandler::getContactModel() const
+{
+    if(m_qpCParams->mu<=0.)
+        return Frictionless;
+    return (m_qpCParams->allowSliding)? Sliding : FrictionPyramid;
+}
+
+
+template<class Function>
+void ConstraintHandler::withContactModel(const Function& function) const
+{
+    switch(getContactModel())
+    {
+    case Frictionless:
+        function(FrictionlessContacts());
+        break;
+    case FrictionPyramid:
+        function(FrictionPyramidContacts());
+        break;
+    case Sliding:
+        function(SlidingContacts());
+        break;
+    }
+}
+
+
+void ConstraintHandler::buildConstraintMatrices(const vector<double> &result,
+                                                QPInverseProblem::QPSystem* qpSystem,
+                                                QPInverseProblem::QPConstraintLists* qpCLists)
+{
+    withContactModel([&](auto contacts){
+        buildConstraintMatricesFor<decltype(contacts)>(result, qpSystem, qpCLists);
+    });
+}
+
+
+template<class Contacts>
+void ConstraintHandler::buildConstraintMatricesFor(const vector<double> &result,
+                                                   QPInverseProblem::QPSystem* qpSystem,
+                                                   QPInverseProblem::QPConstraintLists* qpCLists)
+{
+    bool error = checkCListsConsistency(qpCLists);
+    if(error)
+    {
+        m_contactLimitsVariable = -1;
+        getConstraintOnLambdaFor<Contacts>(result, qpSystem, qpCLists);
+        return;
+    }
+
+    // One walk of the variable blocks builds their inequality rows, their equality rows and the bounds
+    // of their lambdas, in the kept rows of the blocks (reused or rebuilt as by the separate builders)
+    updateVariableColumns(qpSystem, qpCLists);
+    beginInequalityConstraintMatrices(qpSystem, qpCLists);
+    beginEqualityConstraintMatrices(qpSystem);
+    const unsigned int nbBoundedRows = beginConstraintOnLambda(qpSystem, qpCLists);
+    const unsigned int lambdaDim = qpSystem->Q.size();
+
+    unsigned int nbBlocks = 0;
     for (unsigned int i=0; i<qpSystem->dim;)
     {
-        vector<double> row;
-        if (i<nbActuatorRows)
+        const unsigned int nbLines = getBlockNbLines(i, qpCLists);
+
+        ConstraintRows& inequalityRows = getConstraintRows(m_inequalityRowsCache, nbBlocks, result, qpSystem, qpCLists, i);
+        if(!inequalityRows.isValid)
         {
-            SoftRobotsBaseConstraint* ac;
-            ac = qpCLists->actuators[actuatorsId];
-            actuatorsId++;
-            int nbLines = ac->getNbLines();
-            if(ac->hasDeltaMax())
-            {
-                for (int k=0; k<nbLines; k++)
-                {
-                    row.clear();
-                    row.resize(qpSystem->dim, 0.);
+            buildInequalityRows<Contacts>(inequalityRows, i, result, qpSystem, qpCLists);
+            inequalityRows.nbLines = nbLines;
+            inequalityRows.isValid = true;
+        }
 
-                    for (unsigned int j=0; j<qpSystem->dim; j++) // rows corresponding to (Waa Wac)
-                    {
-                        if (j<nbActuatorRows)                      row[j] = qpSystem->W[qpCLists->actuatorRowIds[i+k]][qpCLists->actuatorRowIds[j]];
-                        else if (j<nbActuatorRows+nbEqualityRows)  row[j] = qpSystem->W[qpCLists->actuatorRowIds[i+k]][qpCLists->equalityRowIds[j-nbActuatorRows]];
-                        else                                       row[j] = qpSystem->W[qpCLists->actuatorRowIds[i+k]][qpCLists->contactRowIds[j-nbActuatorRows-nbEqualityRows]];
-                    }
+        ConstraintRows& equalityRows = getConstraintRows(m_equalityRowsCache, nbBlocks, result, qpSystem, qpCLists, i);
+        if(!equalityRows.isValid)
+        {
+            buildEqualityRows<Contacts>(equalityRows, i, result, qpSystem, qpCLists);
+            equalityRows.nbLines = nbLines;
+            equalityRows.isValid = true;
+        }
 
-                    qpSystem->A.push_back(row);
-                    m_qpCParams->constraintsId.push_back(i);
+        if(i>=nbBoundedRows && i<lambdaDim)
+            setConstraintOnLambda<Contacts>(i, result, qpSystem, qpCLists);
 
-                    qpSystem->bu.push_back(ac->getDeltaMax(k) - qpSystem->dFree[qpCLists->actuatorRowIds[i+k]]); // (delta_max - delta_free_a)
+        nbBlocks++;
+        i+=nbLines;
+    }
 
-                    if(ac->hasDeltaMin()) // lambda_min <= A*lambda <= lambda_max
-                        qpSystem->bl.push_back(ac->getDeltaMin(k) - qpSystem->dFree[qpCLists->actuatorRowIds[i+k]]); // (delta_min - delta_free_a)
-                    else if(qpSystem->hasBothSideInequalityConstraint) // One constraint has both side constraint and this one has not -> Set -1e99 <= A*lambda <= lambda_max
-                        qpSystem->bl.push_back(-1e99);
-                }
-            }
-            else if(ac->hasDeltaMin())
-            {
-                if(qpSystem->hasBothSideInequalityConstraint) // One constraint has both side constraint and this one has not -> Set lambda_min <= A*lambda <= 1e99
-                {
-                    for (int k=0; k<nbLines; k++)
-                    {
-                        row.clear();
-                        row.resize(qpSystem->dim, 0.);
+    appendConstraintRows(m_inequalityRowsCache, nbBlocks, qpSystem->A, &qpSystem->bl, qpSystem->bu);
+    appendConstraintRows(m_equalityRowsCache, nbBlocks, qpSystem->Aeq, nullptr, qpSystem->beq);
+}
 
-                        for (unsigned int j=0; j<qpSystem->dim; j++) // rows corresponding to (Waa Wac)
-                        {
-                            if (j<nbActuatorRows)                        row[j] = qpSystem->W[qpCLists->actuatorRowIds[i+k]][qpCLists->actuatorRowIds[j]];
-                            else if (j<nbActuatorRows+nbEqualityRows)    row[j] = qpSystem->W[qpCLists->actuatorRowIds[i+k]][qpCLists->equalityRowIds[j-nbActuatorRows]];
-                            else                                         row[j] = qpSystem->W[qpCLists->actuatorRowIds[i+k]][qpCLists->contactRowIds[j-nbActuatorRows-nbEqualityRows]];
-                        }
 
-                        qpSystem->A.push_back(row);
-                        m_qpCParams->constraintsId.push_back(i);
-                        qpSystem->bl.push_back(ac->getDeltaMin(k) - qpSystem->dFree[qpCLists->actuatorRowIds[i+k]]); // (delta_min - delta_free_a)
-                        qpSystem->bu.push_back(1e99);
-                    }
-                }
-                else
-                {
-                    for (int k=0; k<nbLines; k++)
-                    {
-                        row.clear();
-                        row.resize(qpSystem->dim, 0.);
+void ConstraintHandler::buildInequalityConstraintMatrices(const vector<double> &result,
+                                                          QPInverseProblem::QPSystem* qpSystem,
+                                                          QPInverseProblem::QPConstraintLists* qpCLists)
+{
+    withContactModel([&](auto contacts){
+        buildInequalityConstraintMatricesFor<decltype(contacts)>(result, qpSystem, qpCLists);
+    });
+}
 
-                        for (unsigned int j=0; j<qpSystem->dim; j++)
-                        {
-                            if (j<nbActuatorRows)                        row[j] = -qpSystem->W[qpCLists->actuatorRowIds[i+k]][qpCLists->actuatorRowIds[j]];
-                            else if (j<nbActuatorRows+nbEqualityRows)    row[j] = -qpSystem->W[qpCLists->actuatorRowIds[i+k]][qpCLists->equalityRowIds[j-nbActuatorRows]];
-                            else                                         row[j] = -qpSystem->W[qpCLists->actuatorRowIds[i+k]][qpCLists->contactRowIds[j-nbActuatorRows-nbEqualityRows]];
 
-                        }
+template<class Contacts>
+void ConstraintHandler::buildInequalityConstraintMatricesFor(const vector<double> &result,
+                                                             QPInverseProblem::QPSystem* qpSystem,
+                                                             QPInverseProblem::QPConstraintLists* qpCLists)
+{
+    bool error = checkCListsConsistency(qpCLists);
+    if(error)
+        return;
 
-                        qpSystem->A.push_back(row);
-                        m_qpCParams->constraintsId.push_back(i);
-                        qpSystem->bu.push_back(-ac->getDeltaMin(k) + qpSystem->dFree[qpCLists->actuatorRowIds[i+k]]);
-                    }
-                }
-            }
-            i+=nbLines;
+    updateVariableColumns(qpSystem, qpCLists);
+    beginInequalityConstraintMatrices(qpSystem, qpCLists);
+
+    unsigned int nbBlocks = 0;
+    for (unsigned int i=0; i<qpSystem->dim;)
+    {
+        // Rows of the variable i, reused if its contact state did not change since they were built
+        ConstraintRows& block = getConstraintRows(m_inequalityRowsCache, nbBlocks++, result, qpSystem, qpCLists, i);
+        const unsigned int nbLines = getBlockNbLines(i, qpCLists);
+        if(!block.isValid)
+        {
+            buildInequalityRows<Contacts>(block, i, result, qpSystem, qpCLists);
+            block.nbLines = nbLines;
+            block.isValid = true;
         }
-        else if (i<nbActuatorRows+nbEqualityRows) {
-            SoftRobotsBaseConstraint* ec;
-            int equalityId = 0;
-            ec = qpCLists->equality[equalityId];
-            equalityId++;
-            int nbLines = ec->getNbLines();
-            i+=nbLines;
+        i+=nbLines;
+    }
+
+    appendConstraintRows(m_inequalityRowsCache, nbBlocks, qpSystem->A, &qpSystem->bl, qpSystem->bu);
+}
+
+
+template<class Contacts>
+void ConstraintHandler::buildInequalityRows(ConstraintRows& block,
+                                            const unsigned int& i,
+                                            const vector<double> &result,
+                                            QPInverseProblem::QPSystem* qpSystem,
+                                            QPInverseProblem::QPConstraintLists* qpCLists)
+{
+    unsigned int nbActuatorRows   = qpCLists->actuatorRowIds.size();
+    unsigned int nbEqualityRows   = qpCLists->equalityRowIds.size();
+
+    if (i<nbActuatorRows)
+    {
+        const QPInverseProblem::QPActuatorBounds& bounds = qpCLists->actuatorBounds;
+        const QPInverseProblem::QPVariableRow* ac = &qpCLists->variableRows[i];  // ac[k] is the line k of the component
+        int nbLines = ac->nbLines;
+        if(ac->hasDeltaMax)
+        {
+            for (int k=0; k<nbLines; k++)
+            {
+                appendWRow(block.A, qpSystem, qpCLists->actuatorRowIds[i+k], 1.); // rows corresponding to (Waa Wac)
+                block.constraintsId.push_back(i);
+
+                block.bu.push_back(bounds.deltaMax[i+k] - qpSystem->dFree[qpCLists->actuatorRowIds[i+k]]); // (delta_max - delta_free_a)
+
+                if(ac->hasDeltaMin) // lambda_min <= A*lambda <= lambda_max
+                    block.bl.push_back(bounds.deltaMin[i+k] - qpSystem->dFree[qpCLists->actuatorRowIds[i+k]]); // (delta_min - delta_free_a)
+                else if(qpSystem->hasBothSideInequalityConstraint) // One constraint has both side constraint and this one has not -> Set -1e99 <= A*lambda <= lambda_max
+                    block.bl.push_back(-1e99);
+            }
         }
-        else
+        else if(ac->hasDeltaMin)
         {
-            if(m_qpCParams->mu>0.0)
+            if(qpSystem->hasBothSideInequalityConstraint) // One constraint has both side constraint and this one has not -> Set lambda_min <= A*lambda <= 1e99
             {
-                int contactId = (i-nbActuatorRows-nbEqualityRows)/m_qpCParams->contactNbLines;
-                if(m_qpCParams->contactStates[contactId]==&m_qpCParams->inactiveContact)// delta_n >= 0
+                for (int k=0; k<nbLines; k++)
                 {
-                    row.clear();
-                    row.resize(qpSystem->dim, 0.);
+                    appendWRow(block.A, qpSystem, qpCLists->actuatorRowIds[i+k], 1.); // rows corresponding to (Waa Wac)
+                    block.constraintsId.push_back(i);
+                    block.bl.push_back(bounds.deltaMin[i+k] - qpSystem->dFree[qpCLists->actuatorRowIds[i+k]]); // (delta_min - delta_free_a)
+                    block.bu.push_back(1e99);
+                }
+            }
+            else
+            {
+                for (int k=0; k<nbLines; k++)
+                {
+                    appendWRow(block.A, qpSystem, qpCLists->actuatorRowIds[i+k], -1.);
+                    block.constraintsId.push_back(i);
+                    block.bu.push_back(-bounds.deltaMin[i+k] + qpSystem->dFree[qpCLists->actuatorRowIds[i+k]]);
+                }
+            }
+        }
+    }
+    else if (i>=nbActuatorRows+nbEqualityRows)
+    {
+        const unsigned int contactRow = i-nbActuatorRows-nbEqualityRows;
+        if constexpr(Contacts::hasFriction)
+        {
+            int contactId = contactRow/m_qpCParams->contactNbLines;
+            if(m_qpCParams->contactStates[contactId]==&m_qpCParams->inactiveContact)// delta_n >= 0
+            {
+                appendWRow(block.A, qpSystem, qpCLists->contactRowIds[contactRow], -1.); // rows corresponding to (-Wca -Wcc)
+                block.constraintsId.push_back(i);
 
-                    // rows corresponding to (-Wca -Wcc)
-                    for (unsigned int j=0; j<qpSystem->dim; j++)
-                    {
-                        if (j<nbActuatorRows)                     row[j] = -qpSystem->W[qpCLists->contactRowIds[i-nbActuatorRows-nbEqualityRows]][qpCLists->actuatorRowIds[j]];
-                        else if (j<nbActuatorRows+nbEqualityRows) row[j] = -qpSystem->W[qpCLists->contactRowIds[i-nbActuatorRows-nbEqualityRows]][qpCLists->equalityRowIds[j-nbActuatorRows]];
-                        else                                      row[j] = -qpSystem->W[qpCLists->contactRowIds[i-nbActuatorRows-nbEqualityRows]][qpCLists->contactRowIds[j-nbActuatorRows-nbEqualityRows]];
-                    }
-                    qpSystem->A.push_back(row);
-                    m_qpCParams->constraintsId.push_back(i);
+                // ( delta_free_c )
+                block.bu.push_back(qpSystem->dFree[qpCLists->contactRowIds[contactRow]]);
+
+                if(qpSystem->hasBothSideInequalityConstraint) // One constraint has both side constraint and this one has not
+                    block.bl.push_back(-1e99);
+            }
 
-                    // ( delta_free_c )
-                    qpSystem->bu.push_back(qpSystem->dFree[qpCLists->contactRowIds[i-nbActuatorRows-nbEqualityRows]]);
+            if(Contacts::allowSliding && m_qpCParams->contactStates[contactId]==&m_qpCParams->stickContact)// a_t*lambda_t + a_o*lambda_o <= lambda_n*m_qpCParams->m_mu for each facet of the cone
+            {
+                const unsigned int nbFacets = m_qpCParams->frictionCone.getNbFacets();
+                for(unsigned int k=0; k<nbFacets; k++)
+                {
+                    double* row = appendRow(block.A, qpSystem->dim);
+                    row[i] = -m_qpCParams->mu;
+                    m_qpCParams->frictionCone.getFacet(k, row[i+m_qpCParams->slidingDirId1], row[i+m_qpCParams->slidingDirId2]);
+                    block.constraintsId.push_back(i+1);
+                    block.bu.push_back(0.);
 
                     if(qpSystem->hasBothSideInequalityConstraint) // One constraint has both side constraint and this one has not
-                        qpSystem->bl.push_back(-1e99);
+                        block.bl.push_back(-1e99);
                 }
+            }
 
-                if(m_qpCParams->contactStates[contactId]==&m_qpCParams->stickContact && m_qpCParams->allowSliding)// ||lambda_o|| + ||lambda_t|| <= lambda_n*m_qpCParams->m_mu
+            if(m_qpCParams->contactStates[contactId]==&m_qpCParams->slidingContact && m_qpCParams->frictionCone.getNbFacets() > 4)
+            {
+                // The tangential force stays in the angular sector of its facet, the bounds of lambda only keep it in the quadrant
+                vector<double> a_t, a_o;
+                m_qpCParams->frictionCone.getSectorRows(getSlidingFacetId(result, qpSystem, m_qpCParams, i), a_t, a_o);
+                for (unsigned int k=0; k<a_t.size(); k++)
                 {
-                    row.clear();
-                    row.resize(qpSystem->dim, 0.);
-
-                    row[i]   = -m_qpCParams->mu;
-                    row[i+1] = 1.;
-                    row[i+2] = 1.;
-                    qpSystem->A.push_back(row);
-                    m_qpCParams->constraintsId.push_back(i+1);
-
-                    row[i+1] = -1.;
-                    row[i+2] = -1.;
-                    qpSystem->A.push_back(row);
-                    m_qpCParams->constraintsId.push_back(i+1);
-
-                    row[i+1] = 1.;
-                    row[i+2] = -1.;
-                    qpSystem->A.push_back(row);
-                    m_qpCParams->constraintsId.push_back(i+1);
-
-                    row[i+1] = -1.;
-                    row[i+2] = 1.;
-                    qpSystem->A.push_back(row);
-                    m_qpCParams->constraintsId.push_back(i+1);
-
-                    for(int k=0; k<4; k++)
-                    {
-                        qpSystem->bu.push_back(0.);
+                    double* row = appendRow(block.A, qpSystem->dim);
+                    row[i+m_qpCParams->slidingDirId1] = a_t[k];
+                    row[i+m_qpCParams->slidingDirId2] = a_o[k];
+                    block.constraintsId.push_back(i+1);
+                    block.bu.push_back(0.);
 
-                        if(qpSystem->hasBothSideInequalityConstraint) // One constraint has both side constraint and this one has not
-                            qpSystem->bl.push_back(-1e99);
-                    }
+                    if(qpSystem->hasBothSideInequalityConstraint) // One constraint has both side constraint and this one has not
+                        block.bl.push_back(-1e99);
                 }
+            }
 
-                if(m_qpCParams->contactStates[contactId]==&m_qpCParams->slidingContact)
+            if(m_qpCParams->contactStates[contactId]==&m_qpCParams->slidingContact)
+            {
+                for (unsigned int k=1; k<m_qpCParams->contactNbLines; k++)
                 {
-                    for (unsigned int k=1; k<m_qpCParams->contactNbLines; k++)
+                    if(k==m_qpCParams->slidingDirId1 || k==m_qpCParams->slidingDirId2)
                     {
-                        if(k==m_qpCParams->slidingDirId1 || k==m_qpCParams->slidingDirId2)
-                        {
-                            double sign = 1.;
-                            if(result[i+k]>0)
-                                sign = -1.;
-                            else if(rabs(result[i+k])<1e-13 && qpSystem->previousResult.size()!=0 && qpSystem->previousResult[i+k]>0)
-                                sign = -1.;
-
-                            row.clear();
-                            row.resize(qpSystem->dim, 0.);
-
-                            for (unsigned int j=0; j<qpSystem->dim; j++)
-                            {
-                                if (j<nbActuatorRows)                      row[j] = -qpSystem->W[qpCLists->contactRowIds[i-nbActuatorRows-nbEqualityRows+k]][qpCLists->actuatorRowIds[j]]*sign;
-                                else if (j<nbActuatorRows+nbEqualityRows)  row[j] = -qpSystem->W[qpCLists->contactRowIds[i-nbActuatorRows-nbEqualityRows+k]][qpCLists->equalityRowIds[j-nbActuatorRows]]*sign;
-                                else                                       row[j] = -qpSystem->W[qpCLists->contactRowIds[i-nbActuatorRows-nbEqualityRows+k]][qpCLists->contactRowIds[j-nbActuatorRows-nbEqualityRows]]*sign;
-                            }
-                            qpSystem->A.push_back(row);
-                            m_qpCParams->constraintsId.push_back(i+k);
-
-                            qpSystem->bu.push_back(qpSystem->dFree[qpCLists->contactRowIds[i-nbActuatorRows+k-nbEqualityRows]]*sign);
-
-                            if(qpSystem->hasBothSideInequalityConstraint) // One constraint has both side constraint and this one has not
-                                qpSystem->bl.push_back(-1e99);
-                        }
+                        double sign = 1.;
+                        if(result[i+k]>0)
+                            sign = -1.;
+                        else if(rabs(result[i+k])<1e-13 && qpSystem->previousResult.size()!=0 && qpSystem->previousResult[i+k]>0)
+                            sign = -1.;
+
+                        appendWRow(block.A, qpSystem, qpCLists->contactRowIds[contactRow+k], -sign);
+                        block.constraintsId.push_back(i+k);
+
+                        block.bu.push_back(qpSystem->dFree[qpCLists->contactRowIds[contactRow+k]]*sign);
+
+                        if(qpSystem->hasBothSideInequalityConstraint) // One constraint has both side constraint and this one has not
+                            block.bl.push_back(-1e99);
                     }
                 }
             }
-            else
+        }
+        else
+        {
+            if(m_qpCParams->contactStates[contactRow]==&m_qpCParams->inactiveContact)// delta_c >= 0
             {
-                if(m_qpCParams->contactStates[i-nbActuatorRows]==&m_qpCParams->inactiveContact)// delta_c >= 0
-                {
-                    row.clear();
-                    row.resize(qpSystem->dim, 0.);
+                appendWRow(block.A, qpSystem, qpCLists->contactRowIds[contactRow], -1.); // rows corresponding to (-Wca -Wcc)
+                block.constraintsId.push_back(i);
 
-                    // rows corresponding to (-Wca -Wcc)
-                    for (unsigned int j=0; j<qpSystem->dim; j++)
-                    {
-                        if (j<nbActuatorRows)                       row[j] = -qpSystem->W[qpCLists->contactRowIds[i-nbActuatorRows-nbEqualityRows]][qpCLists->actuatorRowIds[j]];
-                        else if (j<nbActuatorRows+nbEqualityRows)   row[j] = -qpSystem->W[qpCLists->contactRowIds[i-nbActuatorRows-nbEqualityRows]][qpCLists->equalityRowIds[j-nbActuatorRows]];
-                        else                                        row[j] = -qpSystem->W[qpCLists->contactRowIds[i-nbActuatorRows-nbEqualityRows]][qpCLists->contactRowIds[j-nbActuatorRows-nbEqualityRows]];
-                    }
-                    qpSystem->A.push_back(row);
-                    m_qpCParams->constraintsId.push_back(i);
-
-                    // ( delta_free_c )
-                    qpSystem->bu.push_back(qpSystem->dFree[qpCLists->contactRowIds[i-nbActuatorRows-nbEqualityRows]]);
+                // ( delta_free_c )
+                block.bu.push_back(qpSystem->dFree[qpCLists->contactRowIds[contactRow]]);
 
-                    if(qpSystem->hasBothSideInequalityConstraint) // One constraint has both side constraint and this one has not
-                        qpSystem->bl.push_back(-1e99);
-                }
+                if(qpSystem->hasBothSideInequalityConstraint) // One constraint has both side constraint and this one has not
+                    block.bl.push_back(-1e99);
             }
-
-            i+=m_qpCParams->contactNbLines;
         }
     }
-
 }
 
 
 void ConstraintHandler::addContactLimits(QPInverseProblem::QPSystem* qpSystem,
                                               QPInverseProblem::QPConstraintLists* qpCLists)
 {
-    vector<double> contactLimitRow;
-    contactLimitRow.resize(qpSystem->dim, 0.);
-
     int nbContacts  = qpCLists->contactRowIds.size();
-    int nbActuators = qpCLists->actuatorRowIds.size();
+    int firstContactVariable = qpCLists->actuatorRowIds.size() + qpCLists->equalityRowIds.size();
 
-    double value = 1;
-    if(!m_qpCParams->hasMaxContactForces)
-        value = -1;
-
-    int nbActiveContact = 0;
+    // Normal force of each contact that is not inactive
+    vector<int>& variables = m_contactLimitsVariables;
+    variables.clear();
     for(int i=0; i<nbContacts; i+=m_qpCParams->contactNbLines)
     {
         int contactId = i/m_qpCParams->contactNbLines;
         if(m_qpCParams->contactStates[contactId]!=&m_qpCParams->inactiveContact)
-        {
-            contactLimitRow[nbActuators+i] = value; // normal direction
-            nbActiveContact++;
-        }
+            variables.push_back(firstContactVariable+i);
     }
 
-    if(nbActiveContact<2)
+    // The limits of a single contact are bounds of its normal force (see setConstraintOnLambda)
+    if(variables.size()==1)
+        m_contactLimitsVariable = variables[0];
+    if(variables.size()<2)
         return;
 
-    qpSystem->A.push_back(contactLimitRow);
+    double value = 1;
+    if(!m_qpCParams->hasMaxContactForces)
+        value = -1;
+
+    // The row is built in place, only its non-zero entries being written
+    double* contactLimitRow = appendRow(qpSystem->A, qpSystem->dim);
+    for(int variable : variables)
+        contactLimitRow[variable] = value; // normal direction
 
     if (m_qpCParams->hasMaxContactForces){
         qpSystem->bu.push_back(m_qpCParams->maxContactForces);
@@ -336,354 +611,270 @@ void ConstraintHandler::addContactLimits(QPInverseProblem::QPSystem* qpSystem,
 void ConstraintHandler::buildEqualityConstraintMatrices(const vector<double> &result,
                                                         QPInverseProblem::QPSystem* qpSystem,
                                                         QPInverseProblem::QPConstraintLists* qpCLists)
+{
+    withContactModel([&](auto contacts){
+        buildEqualityConstraintMatricesFor<decltype(contacts)>(result, qpSystem, qpCLists);
+    });
+}
+
+
+template<class Contacts>
+void ConstraintHandler::buildEqualityConstraintMatricesFor(const vector<double> &result,
+                                                           QPInverseProblem::QPSystem* qpSystem,
+                                                           QPInverseProblem::QPConstraintLists* qpCLists)
 {
     bool error = checkCListsConsistency(qpCLists);
     if(error)
         return;
 
-    qpSystem->Aeq.clear();
-    qpSystem->beq.clear();
-    unsigned int nbActuatorRows   = qpCLists->actuatorRowIds.size();
-    unsigned int nbEqualityRows   = qpCLists->equalityRowIds.size();
+    updateVariableColumns(qpSystem, qpCLists);
+    beginEqualityConstraintMatrices(qpSystem);
 
-    int actuatorsId = 0; // Counter allowing multiple lines for actuator
-    int equalityId = 0;
+    unsigned int nbBlocks = 0;
     for (unsigned int i=0; i<qpSystem->dim;)
     {
-        vector<double> row;
+        // Rows of the variable i, reused if its contact state did not change since they were built
+        ConstraintRows& block = getConstraintRows(m_equalityRowsCache, nbBlocks++, result, qpSystem, qpCLists, i);
+        const unsigned int nbLines = getBlockNbLines(i, qpCLists);
+        if(!block.isValid)
+        {
+            buildEqualityRows<Contacts>(block, i, result, qpSystem, qpCLists);
+            block.nbLines = nbLines;
+            block.isValid = true;
+        }
+        i+=nbLines;
+    }
+
+    appendConstraintRows(m_equalityRowsCache, nbBlocks, qpSystem->Aeq, nullptr, qpSystem->beq);
+}
 
-        if (i<nbActuatorRows)
+
+template<class Contacts>
+void ConstraintHandler::buildEqualityRows(ConstraintRows& block,
+                                          const unsigned int& i,
+                                          const vector<double> &result,
+                                          QPInverseProblem::QPSystem* qpSystem,
+                                          QPInverseProblem::QPConstraintLists* qpCLists)
+{
+    unsigned int nbActuatorRows   = qpCLists->actuatorRowIds.size();
+    unsigned int nbEqualityRows   = qpCLists->equalityRowIds.size();
+
+    if (i<nbActuatorRows+nbEqualityRows)
+    {
+        const QPInverseProblem::QPVariableRow* ac = &qpCLists->variableRows[i];  // ac[k] is the line k of the component
+        int nbLines = ac->nbLines;
+        if(ac->hasLambdaEqual)
         {
-            SoftRobotsBaseConstraint* ac;
-            ac = qpCLists->actuators[actuatorsId];
-            actuatorsId++;
-            int nbLines = ac->getNbLines();
-            if(ac->hasLambdaEqual())
+            for (int k=0; k<nbLines; k++)
             {
-                for (int k=0; k<nbLines; k++)
-                {
-                    row.clear();
-                    row.resize(qpSystem->dim, 0.);
-
-                    row[i+k] = 1;
-                    qpSystem->Aeq.push_back(row);
-                    m_qpCParams->constraintsId.push_back(i);
-                    qpSystem->beq.push_back(ac->getLambdaEqual(k));
-                }
+                double* row = appendRow(block.A, qpSystem->dim);
+                row[i+k] = 1;
+                block.constraintsId.push_back(i);
+                block.bu.push_back(ac[k].lambdaEqual);
             }
+        }
 
-            if(ac->hasDeltaEqual())
+        if(ac->hasDeltaEqual)
+        {
+            for (int k=0; k<nbLines; k++)
             {
-                for (int k=0; k<nbLines; k++)
-                {
-                    row.clear();
-                    row.resize(qpSystem->dim, 0.);
-
-                    for (unsigned int j=0; j<qpSystem->dim; j++) // rows corresponding to (Waa Wac)
-                    {
-                        if (j<nbActuatorRows)                       row[j] = qpSystem->W[qpCLists->actuatorRowIds[i+k]][qpCLists->actuatorRowIds[j]];
-                        else if (j<nbActuatorRows+nbEqualityRows)   row[j] = qpSystem->W[qpCLists->actuatorRowIds[i+k]][qpCLists->equalityRowIds[j-nbActuatorRows]];
-                        else                                        row[j] = qpSystem->W[qpCLists->actuatorRowIds[i+k]][qpCLists->contactRowIds[j-nbActuatorRows-nbEqualityRows]];
-                    }
-
-                    qpSystem->Aeq.push_back(row);
-                    m_qpCParams->constraintsId.push_back(i);
-                    qpSystem->beq.push_back(ac->getDeltaEqual(k) - qpSystem->dFree[qpCLists->actuatorRowIds[i+k]]); // (delta_min - delta_free_a)
-                }
+                const unsigned int wRow = (i<nbActuatorRows)? qpCLists->actuatorRowIds[i+k] : qpCLists->equalityRowIds[i+k-nbActuatorRows];
+                appendWRow(block.A, qpSystem, wRow, 1.); // rows corresponding to (Waa Wac)
+                block.constraintsId.push_back(i);
+                block.bu.push_back(ac[k].deltaEqual - qpSystem->dFree[wRow]); // beq = (delta_eq - delta_free_a)
             }
-            i+=nbLines;
         }
-        else if (i < nbActuatorRows+nbEqualityRows)
+    }
+    else
+    {
+        const unsigned int contactRow = i-nbActuatorRows-nbEqualityRows;
+        if constexpr(Contacts::hasFriction)
         {
-            SoftRobotsBaseConstraint* ac;
-            ac = qpCLists->equality[equalityId];
-            equalityId++;
+            int contactId = contactRow/m_qpCParams->contactNbLines;
+            if(m_qpCParams->contactStates[contactId]!=&m_qpCParams->inactiveContact)// delta_n = 0
+            {
+                appendWRow(block.A, qpSystem, qpCLists->contactRowIds[contactRow], -1.);
+                block.constraintsId.push_back(i);
+                block.bu.push_back(qpSystem->dFree[qpCLists->contactRowIds[contactRow]]);
+            }
 
-            int nbLines = ac->getNbLines();
-            if(ac->hasLambdaEqual())
+            if(m_qpCParams->contactStates[contactId]==&m_qpCParams->stickContact)// delta_o = delta_t = 0
             {
-                for (int k=0; k<nbLines; k++)
+                for (unsigned int k=1; k<3; k++)
                 {
-                    row.clear();
-                    row.resize(qpSystem->dim, 0.);
-
-                    row[i+k] = 1;
-                    qpSystem->Aeq.push_back(row);
-                    m_qpCParams->constraintsId.push_back(i);
-                    qpSystem->beq.push_back(ac->getLambdaEqual(k));
+                    appendWRow(block.A, qpSystem, qpCLists->contactRowIds[contactRow+k], -1.);
+                    block.constraintsId.push_back(i+k);
+                    block.bu.push_back(qpSystem->dFree[qpCLists->contactRowIds[contactRow+k]]);
                 }
             }
 
-            if(ac->hasDeltaEqual())
+            if(m_qpCParams->contactStates[contactId]==&m_qpCParams->slidingContact)
             {
-                for (int k=0; k<nbLines; k++)
-                {
-                    row.clear();
-                    row.resize(qpSystem->dim, 0.);
-
-                    for (unsigned int j=0; j<qpSystem->dim; j++) // rows corresponding to (Waa Wac)
-                    {
-                        if (j<nbActuatorRows)                      row[j] = qpSystem->W[qpCLists->equalityRowIds[i+k-nbActuatorRows]][qpCLists->actuatorRowIds[j]];
-                        else if (j<nbActuatorRows+nbEqualityRows)  row[j] = qpSystem->W[qpCLists->equalityRowIds[i+k-nbActuatorRows]][qpCLists->equalityRowIds[j-nbActuatorRows]];
-                        else                                       row[j] = qpSystem->W[qpCLists->equalityRowIds[i+k-nbActuatorRows]][qpCLists->contactRowIds[j-nbActuatorRows-nbEqualityRows]];
-                    }
-                    qpSystem->Aeq.push_back(row);
-                    m_qpCParams->constraintsId.push_back(i);
-                    qpSystem->beq.push_back(ac->getDeltaEqual(k) - qpSystem->dFree[qpCLists->equalityRowIds[i+k-nbActuatorRows]]); // beq = (delta_eq - delta_free_a)
-                }
+                // a_t*lambda_t + a_o*lambda_o = lambda_n*m_qpCParams->m_mu on the facet of the force, i.e. ||lambda_o|| + ||lambda_t|| = lambda_n*m_qpCParams->m_mu with 4 facets
+                double* row = appendRow(block.A, qpSystem->dim);
+                row[i]   = -m_qpCParams->mu;
+                m_qpCParams->frictionCone.getFacet(getSlidingFacetId(result, qpSystem, m_qpCParams, i),
+                                                   row[i+m_qpCParams->slidingDirId1],
+                                                   row[i+m_qpCParams->slidingDirId2]);
+
+                block.constraintsId.push_back(i+1); // TODO
+                block.bu.push_back(0.0);
             }
-            i+=nbLines;
         }
         else
         {
-            if(m_qpCParams->mu>0.)
+            if(m_qpCParams->contactStates[contactRow]==&m_qpCParams->activeContact)// delta_c = 0
             {
-                int contactId = (i-nbActuatorRows-nbEqualityRows)/m_qpCParams->contactNbLines;
-                if(m_qpCParams->contactStates[contactId]!=&m_qpCParams->inactiveContact)// delta_n = 0
-                {
-                    row.clear();
-                    row.resize(qpSystem->dim, 0.);
-
-                    for (unsigned int j=0; j<qpSystem->dim; j++)
-                    {
-                        if (j<nbActuatorRows)                      row[j] = -qpSystem->W[qpCLists->contactRowIds[i-nbActuatorRows-nbEqualityRows]][qpCLists->actuatorRowIds[j]];
-                        else if (j<nbActuatorRows+nbEqualityRows)  row[j] = -qpSystem->W[qpCLists->contactRowIds[i-nbActuatorRows-nbEqualityRows]][qpCLists->equalityRowIds[j-nbActuatorRows]];
-                        else                                       row[j] = -qpSystem->W[qpCLists->contactRowIds[i-nbActuatorRows-nbEqualityRows]][qpCLists->contactRowIds[j-nbActuatorRows-nbEqualityRows]];
-                    }
-                    qpSystem->Aeq.push_back(row);
-                    m_qpCParams->constraintsId.push_back(i);
-                    qpSystem->beq.push_back(qpSystem->dFree[qpCLists->contactRowIds[i-nbActuatorRows-nbEqualityRows]]);
-                }
-
-                if(m_qpCParams->contactStates[contactId]==&m_qpCParams->stickContact)// delta_o = delta_t = 0
-                {
-                    row.clear();
-                    row.resize(qpSystem->dim, 0.);
-
-                    for (unsigned int k=1; k<3; k++)
-                    {
-                        for (unsigned int j=0; j<qpSystem->dim; j++)
-                        {
-                            if (j<nbActuatorRows)                      row[j] = -qpSystem->W[qpCLists->contactRowIds[i+k-nbActuatorRows-nbEqualityRows]][qpCLists->actuatorRowIds[j]];
-                            else if (j<nbActuatorRows+nbEqualityRows)  row[j] = -qpSystem->W[qpCLists->contactRowIds[i+k-nbActuatorRows-nbEqualityRows]][qpCLists->equalityRowIds[j-nbActuatorRows]];
-                            else                                       row[j] = -qpSystem->W[qpCLists->contactRowIds[i+k-nbActuatorRows-nbEqualityRows]][qpCLists->contactRowIds[j-nbActuatorRows-nbEqualityRows]];
-                        }
-
-                        qpSystem->Aeq.push_back(row);
-                        m_qpCParams->constraintsId.push_back(i+k);
-                        qpSystem->beq.push_back(qpSystem->dFree[qpCLists->contactRowIds[i+k-nbActuatorRows-nbEqualityRows]]);
-                    }
-                }
-
-                if(m_qpCParams->contactStates[contactId]==&m_qpCParams->slidingContact)
-                {
-                    // ||lambda_o|| + ||lambda_t|| = lambda_n*m_qpCParams->m_mu
-                    row.clear();
-                    row.resize(qpSystem->dim, 0.);
-
-                    row[i]   = -m_qpCParams->mu;
-                    row[i+m_qpCParams->slidingDirId1] = 1;
-                    row[i+m_qpCParams->slidingDirId2] = 1;
-
-                    if(result[i+m_qpCParams->slidingDirId1]<0)
-                        row[i+m_qpCParams->slidingDirId1] = -1;
-                    else if(rabs(result[i+m_qpCParams->slidingDirId1])<1e-13 && qpSystem->previousResult.size()!=0 && qpSystem->previousResult[i+m_qpCParams->slidingDirId1]<0)
-                        row[i+m_qpCParams->slidingDirId1] = -1;
-
-                    if(result[i+m_qpCParams->slidingDirId2]<0)
-                        row[i+m_qpCParams->slidingDirId2] = -1;
-                    else if(rabs(result[i+m_qpCParams->slidingDirId2])<1e-13 && qpSystem->previousResult.size()!=0 && qpSystem->previousResult[i+m_qpCParams->slidingDirId2]<0)
-                        row[i+m_qpCParams->slidingDirId2] = -1;
-
-                    qpSystem->Aeq.push_back(row);
-                    m_qpCParams->constraintsId.push_back(i+1); // TODO
-                    qpSystem->beq.push_back(0.0);
-                }
+                appendWRow(block.A, qpSystem, qpCLists->contactRowIds[contactRow], -1.);
+                block.constraintsId.push_back(i);
+                block.bu.push_back(qpSystem->dFree[qpCLists->contactRowIds[contactRow]]);
             }
-            else
-            {
-                if(m_qpCParams->contactStates[i-nbActuatorRows]==&m_qpCParams->activeContact)// delta_c = 0
-                {
-                    row.clear();
-                    row.resize(qpSystem->dim, 0.);
-
-                    for (unsigned int j=0; j<qpSystem->dim; j++)
-                    {
-                        if (j<nbActuatorRows)                      row[j] = -qpSystem->W[qpCLists->contactRowIds[i-nbActuatorRows-nbEqualityRows]][qpCLists->actuatorRowIds[j]];
-                        else if (j<nbActuatorRows+nbEqualityRows)  row[j] = -qpSystem->W[qpCLists->contactRowIds[i-nbActuatorRows-nbEqualityRows]][qpCLists->equalityRowIds[j-nbActuatorRows]];
-                        else                                       row[j] = -qpSystem->W[qpCLists->contactRowIds[i-nbActuatorRows-nbEqualityRows]][qpCLists->contactRowIds[j-nbActuatorRows-nbEqualityRows]];
-                    }
-                    qpSystem->Aeq.push_back(row);
-                    m_qpCParams->constraintsId.push_back(i);
-                    qpSystem->beq.push_back(qpSystem->dFree[qpCLists->contactRowIds[i-nbActuatorRows-nbEqualityRows]]);
-                }
-            }
-            i+=m_qpCParams->contactNbLines;
         }
     }
 }
 
 
-
 void ConstraintHandler::getConstraintOnLambda(const vector<double> &result,
                                               QPInverseProblem::QPSystem* qpSystem,
                                               QPInverseProblem::QPConstraintLists* qpCLists)
 {
-    int dim = qpSystem->Q.size(); // Different than m_system->m_dim in case of friction with sliding contacts
-    int nbActuatorRows = qpCLists->actuatorRowIds.size();
-    int nbEqualityRows = qpCLists->equalityRowIds.size();
+    withContactModel([&](auto contacts){
+        getConstraintOnLambdaFor<decltype(contacts)>(result, qpSystem, qpCLists);
+    });
+}
 
-    qpSystem->u.resize(qpSystem->dim);
-    qpSystem->l.resize(qpSystem->dim);
 
-    int actuatorsId = 0;
-    int equalityId = 0;
-    for (int i=0; i<dim;)
-    {
-        if (i<nbActuatorRows)
-        {
-            SoftRobotsBaseConstraint* ac;
-            ac = qpCLists->actuators[actuatorsId];
-            actuatorsId++;
+template<class Contacts>
+void ConstraintHandler::getConstraintOnLambdaFor(const vector<double> &result,
+                                                 QPInverseProblem::QPSystem* qpSystem,
+                                                 QPInverseProblem::QPConstraintLists* qpCLists)
+{
+    const unsigned int dim = qpSystem->Q.size(); // Different than m_system->m_dim in case of friction with sliding contacts
 
-            int nbLines = ac->getNbLines();
-            if(ac->hasLambdaMax()) // lambda_a <= lambda_max
-            {
-                for (int k=0; k<nbLines; k++)
-                {
-                    qpSystem->u[i+k] = ac->getLambdaMax(k);
+    for (unsigned int i=beginConstraintOnLambda(qpSystem, qpCLists); i<dim; i+=getBlockNbLines(i, qpCLists))
+        setConstraintOnLambda<Contacts>(i, result, qpSystem, qpCLists);
+}
 
-                    if(ac->hasLambdaMin()) // lambda_min <= lambda_a <= lambda_max
-                        qpSystem->l[i+k] = ac->getLambdaMin(k);
-                    else
-                        qpSystem->l[i+k] = -1e99;
-                }
-            }
-            else if(ac->hasLambdaMin()) // lambda_min <= lambda_a
+
+template<class Contacts>
+void ConstraintHandler::setConstraintOnLambda(const unsigned int& i,
+                                              const vector<double> &result,
+                                              QPInverseProblem::QPSystem* qpSystem,
+                                              QPInverseProblem::QPConstraintLists* qpCLists)
+{
+    unsigned int nbActuatorRows = qpCLists->actuatorRowIds.size();
+    unsigned int nbEqualityRows = qpCLists->equalityRowIds.size();
+
+    if (i < nbActuatorRows+nbEqualityRows)
+    {
+        const QPInverseProblem::QPVariableRow* ac = &qpCLists->variableRows[i];  // ac[k] is the line k of the component
+        int nbLines = ac->nbLines;
+        if(ac->hasLambdaEqual){
+            for (int k=0; k<nbLines; k++)
             {
-                for (int k=0; k<nbLines; k++)
-                {
-                    qpSystem->u[i+k] = 1e99;
-                    qpSystem->l[i+k] = ac->getLambdaMin(k);
-                }
+                qpSystem->u[i+k] = ac[k].lambdaEqual;
+                qpSystem->l[i+k] = ac[k].lambdaEqual;
             }
-            else
+        }else {
+            for (int k=0; k<nbLines; k++)
             {
-                for (int k=0; k<nbLines; k++)
-                {
-                    qpSystem->u[i+k] = 1e99;
-                    qpSystem->l[i+k] = -1e99;
-                }
+                qpSystem->u[i+k] = 1e99;
+                qpSystem->l[i+k] = -1e99;
             }
-            i+=nbLines;
         }
-        else if (i < nbActuatorRows+nbEqualityRows)
-        {
-            SoftRobotsBaseConstraint* ac;
-            ac = qpCLists->equality[equalityId];
-            equalityId++;
-            int nbLines = ac->getNbLines();
-            if(ac->hasLambdaEqual()){
-                for (int k=0; k<nbLines; k++)
-                {
-                    qpSystem->u[i+k] = ac->getLambdaEqual(k);
-                    qpSystem->l[i+k] = ac->getLambdaEqual(k);
-                }
-            }else {
-                for (int k=0; k<nbLines; k++)
-                {
-                    qpSystem->u[i+k] = 1e99;
-                    qpSystem->l[i+k] = -1e99;
-                }
-            }
-            i+=nbLines;
-        }
-        else
+    }
+    else
+    {
+        if constexpr(Contacts::hasFriction)
         {
-            if(m_qpCParams->mu>0.0)
+            int contactId = (i-nbActuatorRows-nbEqualityRows)/m_qpCParams->contactNbLines;
+            if(m_qpCParams->contactStates[contactId]!=&m_qpCParams->inactiveContact) // lambda_n >= 0
             {
-                int contactId = (i-nbActuatorRows-nbEqualityRows)/m_qpCParams->contactNbLines;
-                if(m_qpCParams->contactStates[contactId]!=&m_qpCParams->inactiveContact) // lambda_n >= 0
-                {
-                    qpSystem->u[i] = 1e99;
-                    qpSystem->l[i] = 0.;
-                }
+                qpSystem->u[i] = 1e99;
+                qpSystem->l[i] = 0.;
+            }
 
-                if(m_qpCParams->contactStates[contactId]==&m_qpCParams->inactiveContact) // lambda_c = 0
-                {
-                    qpSystem->u[i] = 0.;
-                    qpSystem->l[i] = 0.;
+            if(m_qpCParams->contactStates[contactId]==&m_qpCParams->inactiveContact) // lambda_c = 0
+            {
+                qpSystem->u[i] = 0.;
+                qpSystem->l[i] = 0.;
 
-                    qpSystem->u[i+1] = 0.;
-                    qpSystem->l[i+1] = 0.;
+                qpSystem->u[i+1] = 0.;
+                qpSystem->l[i+1] = 0.;
 
-                    qpSystem->u[i+2] = 0.;
-                    qpSystem->l[i+2] = 0.;
-                }
+                qpSystem->u[i+2] = 0.;
+                qpSystem->l[i+2] = 0.;
+            }
 
-                else if(m_qpCParams->contactStates[contactId]==&m_qpCParams->slidingContact) // lambda_ti <=/>= 0 and lambda_ti <=/>= 0 other directions are zero
+            else if(m_qpCParams->contactStates[contactId]==&m_qpCParams->slidingContact) // lambda_ti <=/>= 0 and lambda_ti <=/>= 0 other directions are zero
+            {
+                for (unsigned int j=1; j<m_qpCParams->contactNbLines; j++)
                 {
-                    for (unsigned int j=1; j<m_qpCParams->contactNbLines; j++)
+                    if(j==m_qpCParams->slidingDirId1 || j==m_qpCParams->slidingDirId2)
                     {
-                        if(j==m_qpCParams->slidingDirId1 || j==m_qpCParams->slidingDirId2)
+                        if(result[i+j]<0)
                         {
-                            if(result[i+j]<0)
-                            {
-                                qpSystem->u[i+j] = 0.;
-                                qpSystem->l[i+j] = -1e99;
-                            }
-                            else if(rabs(result[i+j])<1e-13 && qpSystem->previousResult.size()!=0 && qpSystem->previousResult[i+j]<0)
-                            {
-                                qpSystem->u[i+j] = 0.;
-                                qpSystem->l[i+j] = -1e99;
-                            }
-                            else
-                            {
-                                qpSystem->u[i+j] = 1e99;
-                                qpSystem->l[i+j] = 0.;
-                            }
+                            qpSystem->u[i+j] = 0.;
+                            qpSystem->l[i+j] = -1e99;
                         }
-                        else
+                        else if(rabs(result[i+j])<1e-13 && qpSystem->previousResult.size()!=0 && qpSystem->previousResult[i+j]<0)
                         {
                             qpSystem->u[i+j] = 0.;
+                            qpSystem->l[i+j] = -1e99;
+                        }
+                        else
+                        {
+                            qpSystem->u[i+j] = 1e99;
                             qpSystem->l[i+j] = 0.;
                         }
                     }
+                    else
+                    {
+                        qpSystem->u[i+j] = 0.;
+                        qpSystem->l[i+j] = 0.;
+                    }
                 }
+            }
 
-                else // Stick, no constraint on lambda_o and lambda_t other directions are zero
+            else // Stick, no constraint on lambda_o and lambda_t other directions are zero
+            {
+                for(unsigned int k=1; k<m_qpCParams->contactNbLines; k++)
                 {
-                    for(unsigned int k=1; k<m_qpCParams->contactNbLines; k++)
+                    if(k==1 || k==2)
                     {
-                        if(k==1 || k==2)
-                        {
-                            qpSystem->u[i+k] = 1e99;
-                            qpSystem->l[i+k] = -1e99;
-                        }
-                        else
-                        {
-                            qpSystem->u[i+k] = 0.;
-                            qpSystem->l[i+k] = 0.;
-                        }
-
+                        qpSystem->u[i+k] = 1e99;
+                        qpSystem->l[i+k] = -1e99;
                     }
+                    else
+                    {
+                        qpSystem->u[i+k] = 0.;
+                        qpSystem->l[i+k] = 0.;
+                    }
+
                 }
             }
-            else
+        }
+        else
+        {
+            if(m_qpCParams->contactStates[i-nbActuatorRows-nbEqualityRows]==&m_qpCParams->activeContact) // lambda_c >= 0
             {
-                if(m_qpCParams->contactStates[i-nbActuatorRows-nbEqualityRows]==&m_qpCParams->activeContact) // lambda_c >= 0
-                {
-                    qpSystem->u[i] = 1e99;
-                    qpSystem->l[i] = 0.;
-                }
-                else // lambda_c = 0
-                {
-                    qpSystem->u[i] = 0.;
-                    qpSystem->l[i] = 0.;
-                }
+                qpSystem->u[i] = 1e99;
+                qpSystem->l[i] = 0.;
             }
+            else // lambda_c = 0
+            {
+                qpSystem->u[i] = 0.;
+                qpSystem->l[i] = 0.;
+            }
+        }
 
-            i+=m_qpCParams->contactNbLines;
+        // Limits of the sum of the contact forces, for a single contact that is not inactive
+        if(int(i)==m_contactLimitsVariable)
+        {
+            if(m_qpCParams->hasMaxContactForces)
+                qpSystem->u[i] = m_qpCParams->maxContactForces;
+            if(m_qpCParams->hasMinContactForces)
+                qpSystem->l[i] = std::max(qpSystem->l[i], m_qpCParams->minContactForces);
         }
     }
 }
@@ -691,6 +882,11 @@ void ConstraintHandler::getConstraintOnLambda(const vector<double> &result,
 
 bool ConstraintHandler::checkCListsConsistency(QPInverseProblem::QPConstraintLists* qpCLists)
 {
+    const int nbContactRows = qpCLists->contactRowIds.size();
+    const int nbContactStates = m_qpCParams->contactStates.size();
+    if(m_productionMode && nbContactRows == m_checkedNbContactRows && nbContactStates == m_checkedNbContactStates)
+        return false;
+
     bool error = false;
 
     // Check contact lists. If contacts occured, should be true:
@@ -709,6 +905,8 @@ bool ConstraintHandler::checkCListsConsistency(QPInverseProblem::QPConstraintLis
     if(error)
         dmsg_error("ConstraintHandler") << "Problem with qpCLists consistency";
 
+    m_checkedNbContactRows = (error)? -1 : nbContactRows;
+    m_checkedNbContactStates = (error)? -1 : nbContactStates;
     return error;
 }
 
@@ -749,21 +947,11 @@ vector<bool> ConstraintHandler::getInfeasibleConstraints(const vector<double> &x
     int nbConstraints = qpSystem->A.size()+qpSystem->Aeq.size();
     infeasibleIds.resize(nbConstraints, false);
 
+    m_constraintResiduals.compute(*qpSystem, x.data());
     for (unsigned int i=0; i<qpSystem->A.size(); i++)
     {
         if(m_qpCParams->constraintsId[i]<(int)qpCLists->actuators.size()) // Constraint on actuator are set first in the constraint matrix A, only these constraints can be released.
-        {
-            double Ax_i = 0;
-            for(unsigned int j=0; j<qpSystem->dim; j++)
-                Ax_i += qpSystem->A[i][j]*x[j];
-
-            if(Ax_i>qpSystem->bu[i] && rabs(Ax_i-qpSystem->bu[i])>1e-5)
-                infeasibleIds[i]=true;
-
-            if(qpSystem->hasBothSideInequalityConstraint)
-                if(Ax_i<qpSystem->bl[i] && rabs(Ax_i-qpSystem->bl[i])>1e-5)
-                    infeasibleIds[i]=true;
-        }
+            infeasibleIds[i] = m_constraintResiduals.isViolated(i);
     }
 
     return infeasibleIds;
@@ -788,7 +976,7 @@ void ConstraintHandler::initContactHandlers(const vector<double>&result,
             {
                 m_qpCParams->contactStates[contactId] = &m_qpCParams->inactiveContact;
             }
-            else if(rabs(rabs(lambda_t)+rabs(lambda_o)-m_qpCParams->mu*rabs(lambda_n))<1e-14)
+            else if(rabs(m_qpCParams->frictionCone.getGap(rabs(lambda_n), lambda_t, lambda_o, m_qpCParams->mu))<1e-14)
             {
                 if(m_qpCParams->allowSliding)
                     m_qpCParams->contactStates[contactId] = &m_qpCParams->slidingContact;
@@ -835,7 +1023,10 @@ void ConstraintHandler::initContactHandlerList()
     }
 
     for(unsigned int i=0; i<m_qpCParams->allowedContactStates.size(); i++)
+    {
         m_qpCParams->allowedContactStates[i]->setAllowSliding(m_qpCParams->allowSliding);
+        m_qpCParams->allowedContactStates[i]->setFrictionCone(m_qpCParams->frictionCone);
+    }
 }
 
 } // namespace
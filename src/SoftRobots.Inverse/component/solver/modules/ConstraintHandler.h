@@ -31,7 +31,9 @@
 #include <sofa/type/vector.h>
 
 #include <SoftRobots.Inverse/component/solver/modules/QPInverseProblem.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPConstraintResiduals.h>
 #include <SoftRobots.Inverse/component/solver/modules/ContactHandler.h>
+#include <SoftRobots.Inverse/component/solver/modules/FrictionCone.h>
 #include <SoftRobots.Inverse/component/config.h>
 
 namespace softrobotsinverse::solver::module {
@@ -61,6 +63,7 @@ public:
 
         double mu{0}; // Friction coefficient
         bool allowSliding{false};
+        FrictionCone frictionCone; // Polygonal linearization of the friction cone, in the plane of the sliding directions
 
         double minContactForces{0};
         double maxContactForces{0};
@@ -68,6 +71,14 @@ public:
         bool hasMaxContactForces{false};
     };
 
+    /// Contact models, as policies of the builders of the constraint matrices: the walk of the variables is
+    /// instantiated for each one, the model being resolved once per build from mu and allowSliding instead of
+    /// at each contact
+    enum ContactModel {Frictionless, FrictionPyramid, Sliding};
+    struct FrictionlessContacts    {static constexpr bool hasFriction = false; static constexpr bool allowSliding = false;};
+    struct FrictionPyramidContacts {static constexpr bool hasFriction = true;  static constexpr bool allowSliding = false;};
+    struct SlidingContacts         {static constexpr bool hasFriction = true;  static constexpr bool allowSliding = true;};
+
     ConstraintHandler()
     {
         m_qpCParams = new QPConstraintParams;
@@ -86,7 +97,14 @@ public:
     ///         bl<=Ax<=bu
     ///         Aeqx=beq
     ///         l<=x<=u
-
+    ///
+    /// in a single walk of the variables [actuators equality contacts]: the inequality rows, the equality
+    /// rows and the bounds of each variable are built at once, in the kept rows of the variable (see
+    /// setReuseConstraintRows). Same result as buildInequalityConstraintMatrices, buildEqualityConstraintMatrices
+    /// and getConstraintOnLambda called in sequence.
+    void buildConstraintMatrices(const vector<double> &result,
+                                 QPInverseProblem::QPSystem* qpSystem,
+                                 QPInverseProblem::QPConstraintLists* qpCLists);
 
     /// Build constraints matrices A, bu, bl
     void buildInequalityConstraintMatrices(const vector<double> &result,
@@ -104,8 +122,22 @@ public:
                                QPInverseProblem::QPConstraintLists* qpCLists);
 
     QPConstraintParams* getQPConstraintParams() {return m_qpCParams;}
+    ContactModel getContactModel() const;
+
+    /// While enabled, the constraint rows built for a variable (actuator, equality or contact point) are kept
+    /// and reused by the next builds as long as its contact state does not change, so that a pivot only
+    /// rebuilds the rows of the contacts that changed. W, dFree and the constraint lists must not change
+    /// meanwhile, it is meant for the pivot loop of one resolution. Enabling or disabling clears the kept rows.
+    void setReuseConstraintRows(const bool& reuse);
 
+    /// Number of blocks of constraint rows (one per variable) built or reused by the builds of A and Aeq
+    unsigned int getNbBuiltConstraintRows() const {return m_nbBuiltConstraintRows;}
+    unsigned int getNbReusedConstraintRows() const {return m_nbReusedConstraintRows;}
+
+    /// True if the contact lists do not match the contact states. With the production mode, the lists are only
+    /// checked when the number of contact rows or of contact states changed since the last check that passed.
     bool checkCListsConsistency(QPInverseProblem::QPConstraintLists* qpCLists);
+    void setProductionMode(const bool& production) {m_productionMode = production; m_checkedNbContactRows = -1;}
 
     void checkAndUpdateActuatorConstraints(const vector<double> &result,
                                            QPInverseProblem::QPSystem* qpSystem,
@@ -115,6 +147,9 @@ public:
                                           QPInverseProblem::QPSystem* qpSystem,
                                           QPInverseProblem::QPConstraintLists* qpCLists);
 
+    /// Residuals of [A; Aeq] computed by the last getInfeasibleConstraints
+    const QPConstraintResiduals& getConstraintResiduals() const {return m_constraintResiduals;}
+
     void initContactHandlers(const vector<double>&result,
                              QPInverseProblem::QPConstraintLists* qpCLists);
     void initContactHandlers();
@@ -125,6 +160,121 @@ public:
 protected:
 
     QPConstraintParams* m_qpCParams;
+
+    /// Constraint rows of one variable, with the contact state they were built for
+    struct ConstraintRows{
+        QPInverseProblem::QPMatrix A;
+        vector<double> bl; // Only for the inequality constraints
+        vector<double> bu; // beq for the equality constraints
+        vector<int> constraintsId;
+
+        unsigned int firstLine{0};
+        unsigned int nbLines{0};
+        const ContactHandler* state{nullptr};
+        int slidingSignature{0}; // Signs of the tangential forces, for a sliding contact
+        bool isValid{false};
+
+        void clear();
+    };
+
+    struct ConstraintRowsCache{
+        vector<ConstraintRows> blocks;
+        unsigned int dim{0};
+        bool hasBothSideInequalityConstraint{false};
+
+        void clear(const unsigned int& dim, const bool& hasBothSideInequalityConstraint);
+    };
+
+    // Variable whose bounds carry the contact limits, when a single contact is not inactive, -1 otherwise
+    int m_contactLimitsVariable{-1};
+    vector<int> m_contactLimitsVariables; // normal forces of the contacts that are not inactive
+
+    bool m_reuseConstraintRows{false};
+    ConstraintRowsCache m_inequalityRowsCache;
+    ConstraintRowsCache m_equalityRowsCache;
+    unsigned int m_nbBuiltConstraintRows{0};
+    unsigned int m_nbReusedConstraintRows{0};
+    QPConstraintResiduals m_constraintResiduals;
+
+    bool m_productionMode{false};
+    int m_checkedNbContactRows{-1}; // sizes of the last consistent lists, see checkCListsConsistency()
+    int m_checkedNbContactStates{-1};
+    vector<unsigned int> m_variableColumns; // Column of W of each QP variable, see updateVariableColumns()
+
+    ConstraintRows& getConstraintRows(ConstraintRowsCache& cache,
+                                      const unsigned int& blockId,
+                                      const vector<double> &result,
+                                      QPInverseProblem::QPSystem* qpSystem,
+                                      QPInverseProblem::QPConstraintLists* qpCLists,
+                                      const unsigned int& firstLine);
+
+    void appendConstraintRows(const ConstraintRowsCache& cache,
+                              const unsigned int& nbBlocks,
+                              QPInverseProblem::QPMatrix& A,
+                              vector<double>* bl,
+                              vector<double>& bu);
+
+    void updateVariableColumns(QPInverseProblem::QPSystem* qpSystem,
+                               QPInverseProblem::QPConstraintLists* qpCLists);
+
+    /// Appends a row of zeros to A and returns it, valid until the next append
+    double* appendRow(QPInverseProblem::QPMatrix& A, const unsigned int& dim);
+
+    /// Appends the row wRow of W, times sign, on the columns of the QP variables
+    void appendWRow(QPInverseProblem::QPMatrix& A,
+                    QPInverseProblem::QPSystem* qpSystem,
+                    const unsigned int& wRow,
+                    const double& sign);
+
+    /// Number of variables of the block starting at the variable i (lines of its component, or of a contact)
+    unsigned int getBlockNbLines(const unsigned int& i, QPInverseProblem::QPConstraintLists* qpCLists) const;
+
+    void beginInequalityConstraintMatrices(QPInverseProblem::QPSystem* qpSystem,
+                                           QPInverseProblem::QPConstraintLists* qpCLists);
+    void beginEqualityConstraintMatrices(QPInverseProblem::QPSystem* qpSystem);
+    /// Sets the bounds of the actuators, returns the first variable left to bound
+    unsigned int beginConstraintOnLambda(QPInverseProblem::QPSystem* qpSystem,
+                                         QPInverseProblem::QPConstraintLists* qpCLists);
+
+    /// Calls function with the policy of the contact model of the parameters
+    template<class Function>
+    void withContactModel(const Function& function) const;
+
+    template<class Contacts>
+    void buildConstraintMatricesFor(const vector<double> &result,
+                                    QPInverseProblem::QPSystem* qpSystem,
+                                    QPInverseProblem::QPConstraintLists* qpCLists);
+    template<class Contacts>
+    void buildInequalityConstraintMatricesFor(const vector<double> &result,
+                                              QPInverseProblem::QPSystem* qpSystem,
+                                              QPInverseProblem::QPConstraintLists* qpCLists);
+    template<class Contacts>
+    void buildEqualityConstraintMatricesFor(const vector<double> &result,
+                                            QPInverseProblem::QPSystem* qpSystem,
+                                            QPInverseProblem::QPConstraintLists* qpCLists);
+    template<class Contacts>
+    void getConstraintOnLambdaFor(const vector<double> &result,
+                                  QPInverseProblem::QPSystem* qpSystem,
+                                  QPInverseProblem::QPConstraintLists* qpCLists);
+
+    /// Rows and bounds of the block of variables starting at the variable i
+    template<class Contacts>
+    void buildInequalityRows(ConstraintRows& block,
+                             const unsigned int& i,
+                             const vector<double> &result,
+                             QPInverseProblem::QPSystem* qpSystem,
+                             QPInverseProblem::QPConstraintLists* qpCLists);
+    template<class Contacts>
+    void buildEqualityRows(ConstraintRows& block,
+                           const unsigned int& i,
+                           const vector<double> &result,
+                           QPInverseProblem::QPSystem* qpSystem,
+                           QPInverseProblem::QPConstraintLists* qpCLists);
+    template<class Contacts>
+    void setConstraintOnLambda(const unsigned int& i,
+                               const vector<double> &result,
+                               QPInverseProblem::QPSystem* qpSystem,
+                               QPInverseProblem::QPConstraintLists* qpCLists);
 };
 
 } //namespace
@@ -36,29 +36,29 @@
 
 namespace softrobotsinverse::solver::module {
 
-using sofa::helper::rabs;
 using sofa::type::vector;
 
+// Handler of the state among the allowed ones, nullptr if it is not allowed
+static ContactHandler* findContactHandler(const vector<ContactHandler*>& handlerPtrList, const QPContactStates::State& state)
+{
+    for(ContactHandler* handler : handlerPtrList)
+        if(handler->getState() == state)
+            return handler;
+    return nullptr;
+}
+
 /******************************* ACTIVECONTACTHANDLER********************************************************/
 
 bool ActiveContactHandler::hasReachedBoundary(const double &lambda, const double &delta)
 {
-    SOFA_UNUSED(delta);
-
-    if(rabs(lambda) <= m_epsilon)
-        return true;
-
-    return false;
+    return QPContactStates::hasReachedBoundary(m_state, lambda, delta);
 }
 
 ContactHandler* ActiveContactHandler::getNewContactHandler(const vector<ContactHandler*>& handlerPtrList,
                                                            const double& lambda,
                                                            const double& delta )
 {
-    SOFA_UNUSED(lambda);
-    SOFA_UNUSED(delta);
-
-    return handlerPtrList[1];
+    return findContactHandler(handlerPtrList, QPContactStates::getNewState(m_state, lambda, delta)); // InactiveContactHandler
 }
 
 
@@ -66,35 +66,19 @@ ContactHandler* ActiveContactHandler::getNewContactHandler(const vector<ContactH
 
 bool InactiveContactHandler::hasReachedBoundary(const double &lambda, const double &delta)
 {
-    SOFA_UNUSED(lambda);
-
-    if(rabs(delta) <= m_epsilon)
-        return true;
-
-    return false;
+    return QPContactStates::hasReachedBoundary(m_state, lambda, delta);
 }
 
 ContactHandler* InactiveContactHandler::getNewContactHandler(const vector<ContactHandler*>& handlerPtrList,
                                                              const double& lambda,
                                                              const double& delta )
 {
-    SOFA_UNUSED(delta);
-    SOFA_UNUSED(lambda);
-
-    return handlerPtrList[0]; // ActiveContactHandler
+    return findContactHandler(handlerPtrList, QPContactStates::getNewState(m_state, lambda, delta)); // ActiveContactHandler
 }
 
 bool InactiveContactHandler::hasReachedBoundary(const vector<double> &lambda, const vector<double> &delta, const double &mu, int &candidateId)
 {
-    SOFA_UNUSED(lambda);
-    SOFA_UNUSED(mu);
-
-    candidateId=0; // Blocking constraint is lambda_n
-
-    if(rabs(delta[0]) <= m_epsilon)
-        return true;
-
-    return false;
+    return QPContactStates::hasReachedBoundary(m_state, lambda.data(), delta.data(), mu, m_allowSliding, m_frictionCone, candidateId);
 }
 
 ContactHandler* InactiveContactHandler::getNewContactHandler(const vector<ContactHandler*>& handlerPtrList,
@@ -102,13 +86,8 @@ ContactHandler* InactiveContactHandler::getNewContactHandler(const vector<Contac
                                                              const vector<double>& delta ,
                                                              const double& mu)
 {
-    SOFA_UNUSED(delta);
-
-    if(m_allowSliding)
-        if(rabs(rabs(lambda[1])+rabs(lambda[2])-mu*lambda[0])<=m_epsilon)
-            return handlerPtrList[2]; // SlidingContactHandler
-
-    return handlerPtrList[1]; // StickContactHandler
+    // StickContactHandler, or SlidingContactHandler on the friction cone
+    return findContactHandler(handlerPtrList, QPContactStates::getNewState(m_state, lambda.data(), delta.data(), mu, m_allowSliding, m_frictionCone));
 }
 
 
@@ -119,24 +98,7 @@ ContactHandler* InactiveContactHandler::getNewContactHandler(const vector<Contac
 
 bool StickContactHandler::hasReachedBoundary(const vector<double> &lambda, const vector<double> &delta, const double &mu, int& candidateId)
 {
-    SOFA_UNUSED(delta);
-
-    if(m_allowSliding)
-    {
-        if(rabs(rabs(lambda[1])+rabs(lambda[2])-mu*lambda[0]) <= m_epsilon)
-        {
-            candidateId=3; // Blocking constraint are lambda_t and lambda_o
-            return true;
-        }
-    }
-
-    if(rabs(lambda[0])<=m_epsilon/* && rabs(lambda[1])<=m_epsilon && rabs(lambda[2])<=m_epsilon*/)
-    {
-        candidateId=0; // Blocking constraint is lambda_n
-        return true;
-    }
-
-    return false;
+    return QPContactStates::hasReachedBoundary(m_state, lambda.data(), delta.data(), mu, m_allowSliding, m_frictionCone, candidateId);
 }
 
 ContactHandler* StickContactHandler::getNewContactHandler(const vector<ContactHandler*>& handlerPtrList,
@@ -144,14 +106,8 @@ ContactHandler* StickContactHandler::getNewContactHandler(const vector<ContactHa
                                                           const vector<double>& delta ,
                                                           const double& mu)
 {
-    SOFA_UNUSED(delta);
-    SOFA_UNUSED(mu);
-
-    if(m_allowSliding)
-        if(rabs(rabs(lambda[1])+rabs(lambda[2])-mu*lambda[0]) <= m_epsilon)
-            return handlerPtrList[2]; // SlidingContactHandler
-
-    return handlerPtrList[0]; // InactiveContactHandler
+    // InactiveContactHandler, or SlidingContactHandler on the friction cone
+    return findContactHandler(handlerPtrList, QPContactStates::getNewState(m_state, lambda.data(), delta.data(), mu, m_allowSliding, m_frictionCone));
 }
 
 
@@ -160,21 +116,7 @@ ContactHandler* StickContactHandler::getNewContactHandler(const vector<ContactHa
 
 bool SlidingContactHandler::hasReachedBoundary(const vector<double> &lambda, const vector<double> &delta, const double &mu, int &candidateId)
 {
-    SOFA_UNUSED(mu);
-
-    if(rabs(lambda[0])<=m_epsilon)
-    {
-        candidateId=0; // Blocking constraint is lambda_n
-        return true;
-    }
-
-    if(rabs(delta[1])<=m_epsilon && rabs(delta[2])<=m_epsilon)
-    {
-        candidateId=3; // Blocking constraint are lambda_t and lambda_o
-        return true;
-    }
-
-    return false;
+    return QPContactStates::hasReachedBoundary(m_state, lambda.data(), delta.data(), mu, m_allowSliding, m_frictionCone, candidateId);
 }
 
 ContactHandler* SlidingContactHandler::getNewContactHandler(const vector<ContactHandler*>& handlerPtrList,
@@ -182,13 +124,8 @@ ContactHandler* SlidingContactHandler::getNewContactHandler(const vector<Contact
                                                              const vector<double>& delta ,
                                                              const double& mu)
 {
-    SOFA_UNUSED(mu);
-    SOFA_UNUSED(delta);
-
-    if(rabs(lambda[0])<=m_epsilon)
-        return handlerPtrList[0]; // InactiveContactHandler
-
-    return handlerPtrList[1]; // StickContactHandler
+    // InactiveContactHandler, or StickContactHandler
+    return findContactHandler(handlerPtrList, QPContactStates::getNewState(m_state, lambda.data(), delta.data(), mu, m_allowSliding, m_frictionCone));
 }
 
 
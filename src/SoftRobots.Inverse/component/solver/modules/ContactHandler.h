@@ -31,9 +31,13 @@
 
 #include <sofa/type/vector.h>
 #include <SoftRobots.Inverse/component/config.h>
+#include <SoftRobots.Inverse/component/solver/modules/FrictionCone.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPContactStates.h>
 
 namespace softrobotsinverse::solver::module {
 
+/// State of a contact point, with the rules of the pivots of the state, as implemented by QPContactStates.
+/// The pivot algorithm tests the contacts with QPContactStates, on the enum of each state (see getState()).
 class SOFA_SOFTROBOTS_INVERSE_API ContactHandler
 {
 public:
@@ -96,11 +100,15 @@ public:
     }
 
     void setAllowSliding(bool allowSliding) {m_allowSliding=allowSliding;}
+    void setFrictionCone(const FrictionCone& frictionCone) {m_frictionCone=frictionCone;}
     virtual std::string getStateString()=0;
+    QPContactStates::State getState() const {return m_state;}
 
 protected:
-    double m_epsilon{1e-14};
+    QPContactStates::State m_state{QPContactStates::Inactive};
+    double m_epsilon{QPContactStates::s_epsilon};
     double m_allowSliding{false};
+    FrictionCone m_frictionCone; // Boundary of the stick state
 
 };
 
@@ -108,7 +116,7 @@ protected:
 class ActiveContactHandler : public ContactHandler
 {
 public:
-    ActiveContactHandler(){}
+    ActiveContactHandler(){m_state = QPContactStates::Active;}
     virtual ~ActiveContactHandler(){}
 
 public:
@@ -127,7 +135,7 @@ public:
 class InactiveContactHandler : public ContactHandler
 {
 public:
-    InactiveContactHandler(){}
+    InactiveContactHandler(){m_state = QPContactStates::Inactive;}
     virtual ~InactiveContactHandler(){}
 
 public:
@@ -155,7 +163,7 @@ public:
 class StickContactHandler : public ContactHandler
 {
 public:
-    StickContactHandler(){}
+    StickContactHandler(){m_state = QPContactStates::Stick;}
     virtual ~StickContactHandler(){}
 
 public:
@@ -176,7 +184,7 @@ public:
 class SlidingContactHandler : public ContactHandler
 {
 public:
-    SlidingContactHandler(){}
+    SlidingContactHandler(){m_state = QPContactStates::Sliding;}
     virtual ~SlidingContactHandler(){}
 
 public:
@@ -0,0 +1,136 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+
+#include <cmath>
+#include <algorithm>
+
+#include <SoftRobots.Inverse/component/solver/modules/FrictionCone.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+using sofa::type::vector;
+
+
+void FrictionCone::setNbFacets(const unsigned int& nbFacets)
+{
+    m_nbFacets = std::max(4u, 4*((nbFacets+3)/4));
+}
+
+
+void FrictionCone::getVertex(const unsigned int& k, double& v_t, double& v_o) const
+{
+    const unsigned int id = k%m_nbFacets;
+    if((4*id)%m_nbFacets == 0)
+    {
+        const unsigned int axis = 4*id/m_nbFacets;
+        v_t = (axis==0)? 1. : (axis==2)? -1. : 0.;
+        v_o = (axis==1)? 1. : (axis==3)? -1. : 0.;
+        return;
+    }
+
+    const double angle = 2.*M_PI*id/m_nbFacets;
+    v_t = cos(angle);
+    v_o = sin(angle);
+}
+
+
+void FrictionCone::getFacet(const unsigned int& k, double& a_t, double& a_o) const
+{
+    // The normal n of the facet between the vertices v0 and v1 satisfies n.v0 = n.v1 = 1
+    double v0_t, v0_o, v1_t, v1_o;
+    getVertex(k, v0_t, v0_o);
+    getVertex(k+1, v1_t, v1_o);
+
+    const double scale = 1. + v0_t*v1_t + v0_o*v1_o;
+    a_t = (v0_t + v1_t)/scale;
+    a_o = (v0_o + v1_o)/scale;
+}
+
+
+unsigned int FrictionCone::getFacetId(const double& sign_t, const double& sign_o,
+                                      const double& lambda_t, const double& lambda_o) const
+{
+    const unsigned int nbQuadrantFacets = m_nbFacets/4;
+    const unsigned int quadrant = (sign_t>0)? ((sign_o>0)? 0 : 3) : ((sign_o>0)? 1 : 2);
+
+    // Index of the facet in the quadrant, counted from the axis t
+    const double angle = atan2(std::abs(lambda_o), std::abs(lambda_t));
+    unsigned int id = std::min(nbQuadrantFacets-1, static_cast<unsigned int>(angle*m_nbFacets/(2.*M_PI)));
+
+    // The quadrants 1 and 3 are run through from the axis o
+    if(quadrant%2 == 1)
+        id = nbQuadrantFacets-1-id;
+
+    return quadrant*nbQuadrantFacets + id;
+}
+
+
+void FrictionCone::getSectorRows(const unsigned int& k, vector<double>& a_t, vector<double>& a_o) const
+{
+    a_t.clear();
+    a_o.clear();
+
+    // lambda on the left of v0, i.e. v0_o*lambda_t - v0_t*lambda_o <= 0
+    if((4*k)%m_nbFacets != 0)
+    {
+        double v_t, v_o;
+        getVertex(k, v_t, v_o);
+        a_t.push_back(v_o);
+        a_o.push_back(-v_t);
+    }
+
+    // lambda on the right of v1, i.e. -v1_o*lambda_t + v1_t*lambda_o <= 0
+    if((4*(k+1))%m_nbFacets != 0)
+    {
+        double v_t, v_o;
+        getVertex(k+1, v_t, v_o);
+        a_t.push_back(-v_o);
+        a_o.push_back(v_t);
+    }
+}
+
+
+double FrictionCone::getGap(const double& lambda_n, const double& lambda_t, const double& lambda_o, const double& mu) const
+{
+    if(m_nbFacets == 4)
+        return std::abs(lambda_t) + std::abs(lambda_o) - mu*lambda_n;
+
+    double radius = -1e99;
+    for(unsigned int k=0; k<m_nbFacets; k++)
+    {
+        double a_t, a_o;
+        getFacet(k, a_t, a_o);
+        radius = std::max(radius, a_t*lambda_t + a_o*lambda_o);
+    }
+    return radius - mu*lambda_n;
+}
+
+} // namespace
@@ -0,0 +1,83 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <sofa/type/vector.h>
+
+#include <SoftRobots.Inverse/component/config.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+/// Polygonal linearization of the Coulomb friction cone ||lambda_tan|| <= mu*lambda_n, in the plane of the
+/// two sliding directions (t, o). The polygon has nbFacets facets inscribed in the circle, its vertices at the
+/// angles 2*pi*k/nbFacets, so that the facet k is a_t*lambda_t + a_o*lambda_o <= mu*lambda_n with
+/// (a_t, a_o) = (cos(theta_k), sin(theta_k))/cos(pi/nbFacets), theta_k = pi*(2k+1)/nbFacets.
+/// The number of facets is a multiple of 4, so that each facet lies in one quadrant of the tangential plane,
+/// on which the sign bounds of the sliding state are set. With 4 facets, this is the pyramid
+/// |lambda_t| + |lambda_o| <= mu*lambda_n. More facets tighten the approximation of the cone (the inscribed
+/// polygon underestimates the friction radius by at most 1-cos(pi/nbFacets)), at the cost of one
+/// inequality row per facet for each stick contact.
+class SOFA_SOFTROBOTS_INVERSE_API FrictionCone
+{
+public:
+
+    FrictionCone(){}
+
+    /// Rounded up to the next multiple of 4, with a minimum of 4
+    void setNbFacets(const unsigned int& nbFacets);
+    unsigned int getNbFacets() const {return m_nbFacets;}
+
+    /// Normal (a_t, a_o) of the facet k
+    void getFacet(const unsigned int& k, double& a_t, double& a_o) const;
+
+    /// Facet of the quadrant of signs (sign_t, sign_o) on which the sliding force lies,
+    /// from the direction of (|lambda_t|, |lambda_o|)
+    unsigned int getFacetId(const double& sign_t, const double& sign_o,
+                            const double& lambda_t, const double& lambda_o) const;
+
+    /// Rows (a_t, a_o), with a_t*lambda_t + a_o*lambda_o <= 0, keeping the tangential force in the angular
+    /// sector of the facet k. The sector sides lying on the axes are left out: they are the sign bounds of the
+    /// sliding state. There are no rows with 4 facets.
+    void getSectorRows(const unsigned int& k, sofa::type::vector<double>& a_t, sofa::type::vector<double>& a_o) const;
+
+    /// max_k(a_t*lambda_t + a_o*lambda_o) - mu*lambda_n, zero on the boundary of the polygonal cone.
+    /// With 4 facets, this is |lambda_t| + |lambda_o| - mu*lambda_n.
+    double getGap(const double& lambda_n, const double& lambda_t, const double& lambda_o, const double& mu) const;
+
+protected:
+
+    unsigned int m_nbFacets{4};
+
+    /// Vertex k of the unit polygon, exact on the axes
+    void getVertex(const unsigned int& k, double& v_t, double& v_o) const;
+};
+
+} // namespace
@@ -0,0 +1,167 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+
+#include <sofa/helper/AdvancedTimer.h>
+#include <sofa/helper/logging/Messaging.h>
+#include <sofa/helper/system/thread/CTime.h>
+#include <SoftRobots.Inverse/component/solver/modules/LCPPGSSolver.h>
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+using sofa::helper::AdvancedTimer;
+using sofa::helper::system::thread::CTime;
+using sofa::helper::system::thread::ctime_t;
+
+
+bool LCPPGSSolver::solve(int dim, double*q, double**M, double*res)
+{
+    return solveDense<double>(dim, q, M, res);
+}
+
+
+bool LCPPGSSolver::solve(int dim, double*q, const float* const* M, double*res)
+{
+    return solveDense<float>(dim, q, M, res);
+}
+
+
+template<class Real>
+bool LCPPGSSolver::solveDense(int dim, const double*q, const Real* const* M, double*res)
+{
+    m_timeLimitReached = false;
+    m_nbIterations = 0;
+
+    const ctime_t startTime = CTime::getTime();
+    const double timeLimitTicks = m_timeLimit*(double)CTime::getTicksPerSec();
+
+    // The initial guess has to be feasible
+    for (int i=0; i<dim; i++)
+        res[i] = std::max(res[i], 0.);
+
+    bool converged = false;
+    while (!converged && m_nbIterations<m_maxIterations)
+    {
+        m_nbIterations++;
+
+        // Sum of the changes of the displacements w over the sweep
+        double error = 0.;
+        for (int i=0; i<dim; i++)
+        {
+            const double Mii = M[i][i];
+            if (Mii <= 0.)
+            {
+                res[i] = 0.;
+                continue;
+            }
+
+            double w = q[i];
+            for (int j=0; j<dim; j++)
+                w += M[i][j]*res[j];
+
+            double x = std::max(res[i] - m_omega*w/Mii, 0.);
+            error += std::abs(Mii*(x - res[i]));
+            res[i] = x;
+        }
+
+        converged = (error < m_tolerance*(dim+1));
+
+        if (!converged && m_timeLimit > 0. && (double)(CTime::getTime() - startTime) > timeLimitTicks)
+        {
+            m_timeLimitReached = true;
+            break;
+        }
+    }
+
+    AdvancedTimer::valSet("PGS iterations", m_nbIterations);
+    return converged;
+}
+
+
+bool LCPPGSSolver::solve(int dim, double*q, const LCPSparseMatrix& M, double*res)
+{
+    m_timeLimitReached = false;
+    m_nbIterations = 0;
+
+    if (M.getBlockSize() != 1 || M.getDim() != dim)
+    {
+        msg_error("LCPPGSSolver") << "The sparse matrix should be of size " << dim << " with blocks of size 1.";
+        return false;
+    }
+
+    const ctime_t startTime = CTime::getTime();
+    const double timeLimitTicks = m_timeLimit*(double)CTime::getTicksPerSec();
+
+    // The initial guess has to be feasible
+    for (int i=0; i<dim; i++)
+        res[i] = std::max(res[i], 0.);
+
+    bool converged = false;
+    while (!converged && m_nbIterations<m_maxIterations)
+    {
+        m_nbIterations++;
+
+        // Sum of the changes of the displacements w over the sweep
+        double error = 0.;
+        for (int i=0; i<dim; i++)
+        {
+            const double Mii = *M.getDiagonalBlock(i);
+            if (Mii <= 0.)
+            {
+                res[i] = 0.;
+                continue;
+            }
+
+            double w = q[i];
+            for (int k=M.getRowBegin(i); k<M.getRowEnd(i); k++)
+                w += *M.getBlock(k)*res[M.getColumn(k)];
+
+            double x = std::max(res[i] - m_omega*w/Mii, 0.);
+            error += std::abs(Mii*(x - res[i]));
+            res[i] = x;
+        }
+
+        converged = (error < m_tolerance*(dim+1));
+
+        if (!converged && m_timeLimit > 0. && (double)(CTime::getTime() - startTime) > timeLimitTicks)
+        {
+            m_timeLimitReached = true;
+            break;
+        }
+    }
+
+    AdvancedTimer::valSet("PGS iterations", m_nbIterations);
+    return converged;
+}
+
+} // namespace
@@ -0,0 +1,81 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <sofa/type/vector.h>
+#include <SoftRobots.Inverse/component/solver/modules/LCPSparseMatrix.h>
+
+// Projected Gauss-Seidel solver for the frictionless contact LCP
+//     w = M x + q,  x >= 0,  w >= 0,  x^T w = 0
+// with successive over-relaxation (PGS-SOR). Cheaper per step than the QP formulation of LCPQPSolver,
+// but only accurate up to the tolerance.
+
+namespace softrobotsinverse::solver::module {
+
+class LCPPGSSolver
+{
+
+public:
+
+    LCPPGSSolver(){}
+    ~LCPPGSSolver(){}
+
+    /// res is used as initial guess (warm start). Returns true on convergence.
+    bool solve(int dim, double*q, double**M, double*res);
+    /// Same resolution with the rows of M in float (e.g. QPPermutedComplianceF), x and w staying in double.
+    /// The tolerance is to be above the precision of float.
+    bool solve(int dim, double*q, const float* const* M, double*res);
+    /// Same resolution with M in CSR form (blockSize 1), each sweep only visits the non zero entries
+    bool solve(int dim, double*q, const LCPSparseMatrix& M, double*res);
+
+    void setTolerance(double tolerance) {m_tolerance = tolerance;}
+    void setMaxIterations(int maxIterations) {m_maxIterations = maxIterations;}
+    /// Relaxation factor in ]0, 2[, 1 for plain projected Gauss-Seidel
+    void setRelaxation(double omega) {m_omega = omega;}
+
+    /// Time limit of the resolution in seconds, 0 for no limit
+    void setTimeLimit(double timeLimit) {m_timeLimit = timeLimit;}
+    bool isTimeLimitReached() const {return m_timeLimitReached;}
+
+    int getNbIterations() const {return m_nbIterations;}
+
+protected:
+    /// Sweeps reading the rows of M in the scalar type Real, instantiated for double and float
+    template<class Real>
+    bool solveDense(int dim, const double*q, const Real* const* M, double*res);
+
+    double m_tolerance{1e-10};
+    int m_maxIterations{1000};
+    double m_omega{1.};
+    double m_timeLimit{0.};
+    bool m_timeLimitReached{false};
+    int m_nbIterations{0};
+};
+
+} // namespace
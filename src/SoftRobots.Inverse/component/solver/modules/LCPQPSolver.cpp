@@ -27,7 +27,6 @@
 * Contact information: https://project.inria.fr/softrobot/contact/            *
 ******************************************************************************/
 
-#include <qpOASES.hpp>
 #include <sofa/helper/logging/Messaging.h>
 #include <SoftRobots.Inverse/component/solver/modules/LCPQPSolver.h>
 
@@ -35,23 +34,57 @@
 namespace softrobotsinverse::solver::module
 {
 
-using qpOASES::QProblemB;
-using qpOASES::QProblem;
-
-using qpOASES::Options;
 using qpOASES::real_t;
 using qpOASES::int_t;
+using qpOASES::returnValue;
+using qpOASES::SQProblem;
+using qpOASES::Options;
 
 using sofa::type::vector;
 
 
+LCPQPSolver::~LCPQPSolver()
+{
+    deleteHotStartProblem();
+}
+
+
+void LCPQPSolver::setMaxNbWorkingSetChanges(int maxNbWorkingSetChanges)
+{
+    m_maxNbWorkingSetChanges = maxNbWorkingSetChanges;
+    m_defaultBackend.setMaxNbWorkingSetChanges(maxNbWorkingSetChanges);
+}
+
+
+size_t LCPQPSolver::getMemoryUsage() const
+{
+    size_t usage = sizeof(real_t)*(m_Q.capacity() + m_c.capacity() + m_l.capacity() + m_u.capacity()
+                                   + m_A.capacity() + m_bl.capacity() + m_bu.capacity()
+                                   + m_lambda.capacity() + m_dual.capacity());
+    if(m_hotStartProblem)
+        usage += QPOASESSolverBackend::getProblemMemoryUsage(m_hotStartDim, m_hotStartDim);
+    return usage;
+}
+
+
 void LCPQPSolver::solve(int dim, double*q, double**M, double*res)
 {
+    // The buffers keep their capacity, they are only reallocated when dim grows
+    m_l.resize(dim);
+    m_u.resize(dim);
+    m_Q.resize(dim*dim);
+    m_c.resize(dim);
+    m_lambda.resize(dim);
+    m_A.resize(dim*dim);
+    m_bu.resize(dim);
+    m_bl.resize(dim);
+    m_dual.resize(2*dim);
+
     //////////////////////////////////////////
     // Constraints on lambda
     //////////////////////////////////////////
-    real_t * l = new real_t[dim];
-    real_t * u = new real_t[dim];
+    real_t * l = m_l.data();
+    real_t * u = m_u.data();
 
     for (int i=0; i<dim; i++)
     {
@@ -63,24 +96,25 @@ void LCPQPSolver::solve(int dim, double*q, double**M, double*res)
     //////////////////////////////////////////
     // Convertion to real_t for qpOASES
     //////////////////////////////////////////
-    real_t * Q = new real_t[dim*dim];
-    real_t * c = new real_t[dim];
-    real_t * lambda = new real_t[dim];
+    real_t * Q = m_Q.data();
+    real_t * c = m_c.data();
+    real_t * lambda = m_lambda.data();
 
     for (int i=0; i<dim; i++)
     {
         for (int j=0; j<dim; j++)
             Q[i*dim+j] = M[i][j];
         c[i] = q[i];
+        lambda[i] = 0.; // returned as is if the time limit stops the solver before a first iterate
     }
 
 
     //////////////////////////////////////////
     // Inequality constraint matrices
     //////////////////////////////////////////
-    real_t * A  = new real_t[dim*dim];
-    real_t * bu = new real_t[dim];
-    real_t * bl = new real_t[dim];
+    real_t * A  = m_A.data();
+    real_t * bu = m_bu.data();
+    real_t * bl = m_bl.data();
 
     for (int i=0; i<dim; i++)
     {
@@ -96,15 +130,22 @@ void LCPQPSolver::solve(int dim, double*q, double**M, double*res)
     // Solve
     /////////////////////////////////////////
 
-    int_t nWSR = 500;
-    QProblem problem(dim, dim);
-    Options options;
-    problem.setOptions(options);
-    problem.setPrintLevel(qpOASES::PL_LOW);
-    problem.init(Q, c, A, l, u, bl, bu, nWSR);
-    problem.getPrimalSolution(lambda);
+    m_timeLimitReached = false;
+    if(!m_backend && m_hotStart && solveWithHotStart(dim, Q, c, A, l, u, bl, bu, lambda))
+    {
+        for (int i=0; i<dim; i++)
+            res[i]=lambda[i];
+        return;
+    }
 
-    if(problem.isInfeasible())
+    QPSolverBackend* backend = (m_backend)? m_backend : &m_defaultBackend;
+
+    real_t * dual = m_dual.data();
+    real_t objective;
+    backend->setTimeLimit(m_timeLimit);
+    bool solved = backend->solve(dim, dim, Q, c, A, l, u, bl, bu, lambda, dual, objective);
+    m_timeLimitReached = backend->isTimeLimitReached();
+    if(!solved && !m_timeLimitReached)
         msg_warning("LCPQPSolver") << "QP infeasible.";
 
 
@@ -113,15 +154,55 @@ void LCPQPSolver::solve(int dim, double*q, double**M, double*res)
     /////////////////////////////////////////
     for (int i=0; i<dim; i++)
         res[i]=lambda[i];
+}
+
+
+bool LCPQPSolver::solveWithHotStart(int dim, real_t* Q, real_t* c, real_t* A,
+                                    real_t* l, real_t* u, real_t* bl, real_t* bu, real_t* lambda)
+{
+    int_t nWSR = m_maxNbWorkingSetChanges;
+    real_t cputime = m_timeLimit;
+
+    // Hot start from the active set of the previous resolution, for a stable set of contacts
+    if(m_hotStartProblem && dim == m_hotStartDim)
+    {
+        returnValue status = m_hotStartProblem->hotstart(Q, c, A, l, u, bl, bu, nWSR, (m_timeLimit>0.)? &cputime : nullptr);
+        if(status == qpOASES::SUCCESSFUL_RETURN && m_hotStartProblem->isSolved() && !m_hotStartProblem->isInfeasible())
+        {
+            m_hotStartProblem->getPrimalSolution(lambda);
+            m_nbHotStartHits++;
+            return true;
+        }
+    }
+
+    deleteHotStartProblem();
+    m_hotStartProblem = new SQProblem(dim, dim);
+    m_hotStartDim = dim;
 
-    delete[] u;
-    delete[] l;
-    delete[] A;
-    delete[] bl;
-    delete[] bu;
-    delete[] Q;
-    delete[] c;
-    delete[] lambda;
+    Options options;
+    m_hotStartProblem->setOptions(options);
+    m_hotStartProblem->setPrintLevel(qpOASES::PL_NONE);
+
+    nWSR = m_maxNbWorkingSetChanges;
+    cputime = m_timeLimit;
+    returnValue status = m_hotStartProblem->init(Q, c, A, l, u, bl, bu, nWSR, (m_timeLimit>0.)? &cputime : nullptr);
+    if(status == qpOASES::SUCCESSFUL_RETURN && m_hotStartProblem->isSolved() && !m_hotStartProblem->isInfeasible())
+    {
+        m_hotStartProblem->getPrimalSolution(lambda);
+        return true;
+    }
+
+    // Let the cold resolution handle this step
+    deleteHotStartProblem();
+    return false;
+}
+
+
+void LCPQPSolver::deleteHotStartProblem()
+{
+    delete m_hotStartProblem;
+    m_hotStartProblem = nullptr;
+    m_hotStartDim = 0;
 }
 
 } // namespace
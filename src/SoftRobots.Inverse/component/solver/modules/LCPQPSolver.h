@@ -29,8 +29,10 @@
 #pragma once
 
 #include <sofa/type/vector.h>
+#include <qpOASES/SQProblem.hpp>
+#include <SoftRobots.Inverse/component/solver/modules/QPSolverBackend.h>
 
-// LCP solver using qpOASES QP solver
+// LCP solver using a QP solver (qpOASES by default, optionally hot started across resolutions)
 // QP formulation for solving a LCP with a symmetric matrix M.
 
 namespace softrobotsinverse::solver::module {
@@ -42,10 +44,48 @@ class LCPQPSolver
 
 public:
 
-    LCPQPSolver(){}
-    ~LCPQPSolver(){}
+    LCPQPSolver(QPSolverBackend* backend = nullptr) : m_backend(backend) {}
+    ~LCPQPSolver();
 
     void solve(int dim, double*q, double**M, double*res);
+
+    /// QP solver used for the resolution (not owned), nullptr for qpOASES
+    void setBackend(QPSolverBackend* backend) {m_backend = backend;}
+
+    /// If true (and without backend), the qpOASES problem is kept alive and hot started with the new
+    /// q and M, as long as the number of contacts does not change
+    void setHotStart(bool hotStart) {m_hotStart = hotStart;}
+    unsigned int getNbHotStartHits() const {return m_nbHotStartHits;}
+
+    /// Time limit of the resolution in seconds, 0 for no limit
+    void setTimeLimit(double timeLimit) {m_timeLimit = timeLimit;}
+    bool isTimeLimitReached() const {return m_timeLimitReached;}
+
+    /// Largest number of working set changes of a qpOASES resolution (nWSR)
+    void setMaxNbWorkingSetChanges(int maxNbWorkingSetChanges);
+
+    /// Memory of the buffers and of the hot started problem, in bytes
+    size_t getMemoryUsage() const;
+
+protected:
+    QPSolverBackend* m_backend; // not owned
+    QPOASESSolverBackend m_defaultBackend;
+    double m_timeLimit{0.};
+    bool m_timeLimitReached{false};
+    int m_maxNbWorkingSetChanges{500};
+
+    // Buffers of the QP, kept across resolutions so that they are only reallocated when dim grows
+    vector<real_t> m_Q, m_c, m_l, m_u, m_A, m_bl, m_bu;
+    vector<real_t> m_lambda, m_dual;
+
+    bool m_hotStart{false};
+    qpOASES::SQProblem* m_hotStartProblem{nullptr};
+    int m_hotStartDim{0};
+    unsigned int m_nbHotStartHits{0};
+
+    bool solveWithHotStart(int dim, real_t* Q, real_t* c, real_t* A,
+                           real_t* l, real_t* u, real_t* bl, real_t* bu, real_t* lambda);
+    void deleteHotStartProblem();
 };
 
 } // namespace
@@ -0,0 +1,74 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+
+#include <SoftRobots.Inverse/component/solver/modules/LCPSparseMatrix.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+void LCPSparseMatrix::build(double** W, int dim, int blockSize, const unsigned int* rowIds)
+{
+    m_dim = dim;
+    m_blockSize = blockSize;
+    const int nbBlockRows = dim/blockSize;
+
+    auto row = [&](int i){return (rowIds)? rowIds[i] : (unsigned int)i;};
+    auto isNonZero = [&](int bi, int bj){
+        for (int a=0; a<blockSize; a++)
+            for (int b=0; b<blockSize; b++)
+                if (W[row(bi*blockSize+a)][row(bj*blockSize+b)] != 0.)
+                    return true;
+        return false;
+    };
+
+    m_rowOffsets.resize(nbBlockRows+1);
+    m_diagonals.resize(nbBlockRows);
+    m_columns.clear();
+    m_values.clear();
+    for (int bi=0; bi<nbBlockRows; bi++)
+    {
+        m_rowOffsets[bi] = m_columns.size();
+        for (int bj=0; bj<nbBlockRows; bj++)
+        {
+            if (bi != bj && !isNonZero(bi, bj) && !isNonZero(bj, bi))
+                continue;
+
+            if (bi == bj)
+                m_diagonals[bi] = m_columns.size();
+            m_columns.push_back(bj);
+            for (int a=0; a<blockSize; a++)
+                for (int b=0; b<blockSize; b++)
+                    m_values.push_back(W[row(bi*blockSize+a)][row(bj*blockSize+b)]);
+        }
+    }
+    m_rowOffsets[nbBlockRows] = m_columns.size();
+}
+
+} // namespace
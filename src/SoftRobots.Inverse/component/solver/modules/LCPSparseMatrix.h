@@ -0,0 +1,80 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <sofa/type/vector.h>
+
+#include <SoftRobots.Inverse/component/config.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+/// Square matrix stored by blocks of blockSize x blockSize, in compressed sparse rows of blocks
+/// (block-CSR), each block being stored row-major. A block is stored if it has a non zero entry, or
+/// if its symmetric block has one, so that the pattern is symmetric. The diagonal blocks are always
+/// stored. With blockSize 1 it is a plain CSR matrix. Used for the contact-contact block of W, whose
+/// contacts between different bodies are mostly decoupled: the memory scales with the number of
+/// coupled contact pairs.
+class SOFA_SOFTROBOTS_INVERSE_API LCPSparseMatrix
+{
+public:
+
+    /// Extracts the entries W[rowIds[i]][rowIds[j]] of the dense matrix W, for i,j < dim, dim being
+    /// a multiple of blockSize. Without rowIds, the first dim rows and columns of W are extracted.
+    /// The storage is kept from the previous extractions.
+    void build(double** W, int dim, int blockSize, const unsigned int* rowIds = nullptr);
+
+    int getDim() const {return m_dim;}
+    int getBlockSize() const {return m_blockSize;}
+    int getNbBlockRows() const {return m_dim/m_blockSize;}
+    int getNbBlocks() const {return m_columns.size();}
+
+    /// Blocks of the block row i are the blocks k in [getRowBegin(i), getRowEnd(i)[,
+    /// in the block column getColumn(k)
+    int getRowBegin(int i) const {return m_rowOffsets[i];}
+    int getRowEnd(int i) const {return m_rowOffsets[i+1];}
+    int getColumn(int k) const {return m_columns[k];}
+    const double* getBlock(int k) const {return &m_values[k*m_blockSize*m_blockSize];}
+    const double* getDiagonalBlock(int i) const {return getBlock(m_diagonals[i]);}
+
+    /// Entry (a,b) of the block (i, j) in a row-major block
+    static double getEntry(const double* block, int blockSize, int a, int b) {return block[a*blockSize+b];}
+
+protected:
+
+    int m_dim{0};
+    int m_blockSize{1};
+    sofa::type::vector<int> m_rowOffsets;
+    sofa::type::vector<int> m_columns;
+    sofa::type::vector<int> m_diagonals; // Index of the diagonal block of each block row
+    sofa::type::vector<double> m_values;
+};
+
+} // namespace
@@ -31,6 +31,8 @@
 #include <sofa/helper/logging/Messaging.h>
 #include <sofa/helper/rmath.h>
 #include <sofa/type/Mat.h>
+#include <algorithm>
+#include <cmath>
 
 #include <SoftRobots.Inverse/component/solver/modules/NLCPSolver.h>
 
@@ -42,44 +44,23 @@ using namespace sofa::helper::system::thread;
 using sofa::helper::AdvancedTimer;
 using sofa::type::Mat;
 
-int NLCPSolver::solve(int dim, double *dfree, double**W, double *result, double mu, double tol, int nbIterationMax,
-                      bool useInitialF, bool verbose, double minW, double maxF, sofa::type::vector<double>* residuals,
-                      sofa::type::vector<double>* violations)
-
+template<class Real>
+bool NLCPSolver::solveSweeps(int dim, double *dfree, double**W, const Real* const* Wr, double *result, double mu,
+                             double tol, double relativeTol, int nbIterationMax, sofa::type::vector<double>* residuals,
+                             sofa::type::vector<double>* violations, const ctime_t& startTime, int& it, double& error)
 {
-    SOFA_UNUSED(minW);
-    SOFA_UNUSED(maxF);
-
-    if (dim % 3)
-    {
-        msg_warning("NLCPSolver") << "The parameter 'dim' should be dividable by three.";
-        return 0;
-    }
     const int nbContacts = dim/3;
+    const double timeLimitTicks = m_timeLimit*(double)CTime::getTicksPerSec();
 
     // iterators
-    int it,cIt,i;
-
-    // put the vector force to zero
-    if (!useInitialF)
-        memset(result, 0, dim*sizeof(double));
+    int cIt,i;
 
     // previous value of the force and the displacment
     double f_prev[3];
     double d_prev[3];
 
-    // allocation of the inverted system 3x3
-    NLCPSolverMatrix33 **W33;
-    W33 = (NLCPSolverMatrix33 **) malloc (dim*sizeof(NLCPSolverMatrix33));
-    for (cIt=0; cIt<nbContacts; cIt++)
-        W33[cIt] = new NLCPSolverMatrix33();
-
-
-    //////////////
-    // Beginning of iterative computations
-    //////////////
-    double error = 0.;
     double dn, dt, ds, fn, ft, fs;
+    double firstError = 0.;
 
     for (it=0; it<nbIterationMax; it++)
     {
@@ -95,32 +76,36 @@ int NLCPSolver::solve(int dim, double *dfree, double**W, double *result, double
             f_prev[2] = result[3*cIndex+2];
             sofa::helper::set3Dof(result,cIndex,0.0,0.0,0.0); // f[3*cIndex] = 0.0; f[3*cIndex+1] = 0.0; f[3*cIndex+2] = 0.0;
 
-            // computation of actual d due to contribution of other contacts
+            // computation of actual d due to contribution of other contacts, accumulated in double
             dn=dfree[3*cIndex];
             dt=dfree[3*cIndex+1];
             ds=dfree[3*cIndex+2];
 
+            const Real* Wn = Wr[3*cIndex];
+            const Real* Wt = Wr[3*cIndex+1];
+            const Real* Ws = Wr[3*cIndex+2];
             for (i=0; i<dim; i++)
             {
-                dn += W[3*cIndex  ][i]*result[i];
-                dt += W[3*cIndex+1][i]*result[i];
-                ds += W[3*cIndex+2][i]*result[i];
+                dn += Wn[i]*result[i];
+                dt += Wt[i]*result[i];
+                ds += Ws[i]*result[i];
             }
 
-            d_prev[0] = dn + W[3*cIndex  ][3*cIndex  ]*f_prev[0]+W[3*cIndex  ][3*cIndex+1]*f_prev[1]+W[3*cIndex  ][3*cIndex+2]*f_prev[2];
-            d_prev[1] = dt + W[3*cIndex+1][3*cIndex  ]*f_prev[0]+W[3*cIndex+1][3*cIndex+1]*f_prev[1]+W[3*cIndex+1][3*cIndex+2]*f_prev[2];
-            d_prev[2] = ds + W[3*cIndex+2][3*cIndex  ]*f_prev[0]+W[3*cIndex+2][3*cIndex+1]*f_prev[1]+W[3*cIndex+2][3*cIndex+2]*f_prev[2];
+            d_prev[0] = dn + Wn[3*cIndex]*f_prev[0]+Wn[3*cIndex+1]*f_prev[1]+Wn[3*cIndex+2]*f_prev[2];
+            d_prev[1] = dt + Wt[3*cIndex]*f_prev[0]+Wt[3*cIndex+1]*f_prev[1]+Wt[3*cIndex+2]*f_prev[2];
+            d_prev[2] = ds + Ws[3*cIndex]*f_prev[0]+Ws[3*cIndex+1]*f_prev[1]+Ws[3*cIndex+2]*f_prev[2];
 
-            if(W33[cIndex]->m_stored==false)
+            // the local problem is always solved with the diagonal block of W in double
+            if(m_W33[cIndex].m_stored==false)
             {
-                W33[cIndex]->storeW(W[3*cIndex][3*cIndex],W[3*cIndex][3*cIndex+1],W[3*cIndex][3*cIndex+2],
+                m_W33[cIndex].storeW(W[3*cIndex][3*cIndex],W[3*cIndex][3*cIndex+1],W[3*cIndex][3*cIndex+2],
                         W[3*cIndex+1][3*cIndex+1], W[3*cIndex+1][3*cIndex+2],W[3*cIndex+2][3*cIndex+2]);
             }
 
             fn=f_prev[0];
             ft=f_prev[1];
             fs=f_prev[2];
-            W33[cIndex]->GSState(mu,dn,dt,ds,fn,ft,fs,m_allowSliding);
+            updateContactForce(cIndex,mu,dn,dt,ds,fn,ft,fs);
 
             error += sofa::helper::absError(dn,dt,ds,d_prev[0],d_prev[1],d_prev[2]);
 
@@ -128,6 +113,7 @@ int NLCPSolver::solve(int dim, double *dfree, double**W, double *result, double
         }
 
         if (residuals) residuals->push_back(error);
+        endSweep(error);
 
         if (violations)
         {
@@ -137,7 +123,7 @@ int NLCPSolver::solve(int dim, double *dfree, double**W, double *result, double
                 dn = dfree[3*c];
 
                 for (int i=0; i<dim; i++)
-                    dn += W[3*c][i]*result[i];
+                    dn += Wr[3*c][i]*result[i];
 
                 if (dn < 0)
                     sum_d += -dn;
@@ -145,22 +131,329 @@ int NLCPSolver::solve(int dim, double *dfree, double**W, double *result, double
             violations->push_back(sum_d);
         }
 
+        if (it == 0)
+            firstError = error;
+
+        if (error < tol*(nbContacts+1) || error < relativeTol*firstError)
+        {
+            it++;
+            return error < tol*(nbContacts+1);
+        }
+
+        if (m_timeLimit > 0. && (double)(CTime::getTime() - startTime) > timeLimitTicks)
+        {
+            m_timeLimitReached = true;
+            it++;
+            return false;
+        }
+    }
+    return false;
+}
+
+
+int NLCPSolver::solve(int dim, double *dfree, double**W, double *result, double mu, double tol, int nbIterationMax,
+                      bool useInitialF, bool verbose, double minW, double maxF, sofa::type::vector<double>* residuals,
+                      sofa::type::vector<double>* violations)
+
+{
+    if (dim % 3)
+    {
+        msg_warning("NLCPSolver") << "The parameter 'dim' should be dividable by three.";
+        return 0;
+    }
+    const int nbContacts = dim/3;
+
+    startSolve(minW, maxF);
+    m_timeLimitReached = false;
+    m_nbRefinementSweeps = 0;
+    const ctime_t startTime = CTime::getTime();
+
+    // put the vector force to zero
+    if (!useInitialF)
+        memset(result, 0, dim*sizeof(double));
+
+    // diagonal blocks 3x3 of W, the storage is kept from the previous resolutions but the values
+    // are read again as W changes with the configuration
+    m_W33.resize(nbContacts);
+    for (int cIt=0; cIt<nbContacts; cIt++)
+        m_W33[cIt].m_stored = false;
+
+    if (m_multithreading)
+    {
+        m_blockW.build(W, dim, 3);
+        return solve(dim, dfree, m_blockW, result, mu, tol, nbIterationMax, true, verbose, minW, maxF, residuals, violations);
+    }
+
+
+    //////////////
+    // Beginning of iterative computations
+    //////////////
+    int it = 0;
+    double error = 0.;
+    bool converged = false;
+    if (m_mixedPrecision)
+    {
+        // Sweeps on a float copy of W, which halves the memory read by each sweep, until the error
+        // is reduced down to the precision of float, then refinement sweeps on W from this solution
+        // until the error is within the tolerance in double
+        m_floatIds.resize(dim);
+        for (int i=0; i<dim; i++)
+            m_floatIds[i] = i;
+        m_floatBlocks.assign(1, {0, (unsigned int)dim, 0});
+        m_floatW.gather(W, m_floatIds, m_floatBlocks);
+
+        converged = solveSweeps<float>(dim, dfree, W, m_floatW.getRows(), result, mu, tol, s_floatRelativeTolerance,
+                                       nbIterationMax, residuals, violations, startTime, it, error);
+        if (!m_timeLimitReached)
+        {
+            converged = solveSweeps<double>(dim, dfree, W, W, result, mu, tol, 0., nbIterationMax-it,
+                                            residuals, violations, startTime, m_nbRefinementSweeps, error);
+            it += m_nbRefinementSweeps;
+        }
+    }
+    else
+        converged = solveSweeps<double>(dim, dfree, W, W, result, mu, tol, 0., nbIterationMax,
+                                        residuals, violations, startTime, it, error);
+
+    AdvancedTimer::valSet("GS iterations", it);
+    setReport(it, error, converged);
+
+    if (converged)
+    {
+        if (verbose)
+            msg_info("NLCPSolver") << "Convergence after" << it <<" iteration(s) with tolerance : "<< tol <<" and error : "<< error <<" with dim : "<<dim;
+        return 1;
+    }
+
+    if (verbose)
+        msg_warning("NLCPSolver") <<"No convergence in  nlcp_gaussseidel function : error ="<<error <<" after"<< it<<" iterations";
+
+    return 0;
+}
+
+
+int NLCPSolver::solve(int dim, double *dfree, const LCPSparseMatrix& W, double *result, double mu, double tol, int nbIterationMax,
+                      bool useInitialF, bool verbose, double minW, double maxF, sofa::type::vector<double>* residuals,
+                      sofa::type::vector<double>* violations)
+{
+    startSolve(minW, maxF);
+    if (dim % 3 || W.getBlockSize() != 3 || W.getDim() != dim)
+    {
+        msg_warning("NLCPSolver") << "The parameter 'dim' should be dividable by three, and W made of 3x3 blocks of size dim.";
+        return 0;
+    }
+    const int nbContacts = dim/3;
+
+    m_timeLimitReached = false;
+    if (!useInitialF)
+        memset(result, 0, dim*sizeof(double));
+
+    m_W33.resize(nbContacts);
+    for (int c=0; c<nbContacts; c++)
+    {
+        const double* w = W.getDiagonalBlock(c);
+        double w11 = w[0], w12 = w[1], w13 = w[2], w22 = w[4], w23 = w[5], w33 = w[8];
+        m_W33[c].storeW(w11, w12, w13, w22, w23, w33);
+    }
+
+    if (m_multithreading)
+        return solveColored(dim, dfree, W, result, mu, tol, nbIterationMax, verbose, residuals, violations);
+
+    const ctime_t startTime = CTime::getTime();
+    const double timeLimitTicks = m_timeLimit*(double)CTime::getTicksPerSec();
+
+    double error = 0.;
+    int it;
+    for (it=0; it<nbIterationMax; it++)
+    {
+        error = 0.;
+        for (int c=0; c<nbContacts; c++)
+        {
+            // d of the contact, with the blocks of the contacts coupled with it
+            double d[3] = {dfree[3*c], dfree[3*c+1], dfree[3*c+2]};
+            for (int k=W.getRowBegin(c); k<W.getRowEnd(c); k++)
+            {
+                const double* w = W.getBlock(k);
+                const double* f = &result[3*W.getColumn(k)];
+                for (int a=0; a<3; a++)
+                    d[a] += w[3*a]*f[0] + w[3*a+1]*f[1] + w[3*a+2]*f[2];
+            }
+
+            // without the contribution of the contact itself
+            const double* w = W.getDiagonalBlock(c);
+            double fn = result[3*c], ft = result[3*c+1], fs = result[3*c+2];
+            double dn = d[0] - w[0]*fn - w[1]*ft - w[2]*fs;
+            double dt = d[1] - w[3]*fn - w[4]*ft - w[5]*fs;
+            double ds = d[2] - w[6]*fn - w[7]*ft - w[8]*fs;
+            updateContactForce(c,mu,dn,dt,ds,fn,ft,fs);
+
+            error += sofa::helper::absError(dn,dt,ds,d[0],d[1],d[2]);
+
+            sofa::helper::set3Dof(result,c,fn,ft,fs);
+        }
+
+        if (residuals) residuals->push_back(error);
+        endSweep(error);
+
+        if (violations)
+        {
+            double sum_d = 0;
+            for (int c=0;  c<nbContacts ; c++)
+            {
+                double dn = dfree[3*c];
+                for (int k=W.getRowBegin(c); k<W.getRowEnd(c); k++)
+                {
+                    const double* w = W.getBlock(k);
+                    const double* f = &result[3*W.getColumn(k)];
+                    dn += w[0]*f[0] + w[1]*f[1] + w[2]*f[2];
+                }
+                if (dn < 0)
+                    sum_d += -dn;
+            }
+            violations->push_back(sum_d);
+        }
+
         if (error < tol*(nbContacts+1))
         {
-            for (int i = 0; i < nbContacts; i++)
-                delete W33[i];
-            free(W33);
             if (verbose)
                 msg_info("NLCPSolver") << "Convergence after" << it <<" iteration(s) with tolerance : "<< tol <<" and error : "<< error <<" with dim : "<<dim;
             AdvancedTimer::valSet("GS iterations", it+1);
+            setReport(it+1, error, true);
             return 1;
         }
+
+        if (m_timeLimit > 0. && (double)(CTime::getTime() - startTime) > timeLimitTicks)
+        {
+            m_timeLimitReached = true;
+            it++;
+            break;
+        }
     }
     AdvancedTimer::valSet("GS iterations", it);
+    setReport(it, error, false);
+
+    if (verbose)
+        msg_warning("NLCPSolver") <<"No convergence in  nlcp_gaussseidel function : error ="<<error <<" after"<< it<<" iterations";
+
+    return 0;
+}
+
+
+int NLCPSolver::solveColored(int dim, double *dfree, const LCPSparseMatrix& W, double *result, double mu, double tol, int nbIterationMax,
+                             bool verbose, sofa::type::vector<double>* residuals, sofa::type::vector<double>* violations)
+{
+    const int nbContacts = dim/3;
+    const ctime_t startTime = CTime::getTime();
+    const double timeLimitTicks = m_timeLimit*(double)CTime::getTicksPerSec();
+
+    colorContacts(W);
+
+    // The local problems of a color are solved by batches, reading the diagonal blocks in color order
+    m_colorBlocks.resize(6*nbContacts);
+    for (int k=0; k<nbContacts; k++)
+        for (int j=0; j<6; j++)
+            m_colorBlocks[j*nbContacts + k] = m_W33[m_colorContacts[k]].m_w[j];
+
+    // d = W f + dfree, only the blocks coupling the contacts contribute
+    m_d.resize(dim);
+    m_df.resize(dim);
+    for (int c=0; c<nbContacts; c++)
+    {
+        double* d = &m_d[3*c];
+        d[0] = dfree[3*c]; d[1] = dfree[3*c+1]; d[2] = dfree[3*c+2];
+        for (int k=W.getRowBegin(c); k<W.getRowEnd(c); k++)
+        {
+            const double* w = W.getBlock(k);
+            const double* f = &result[3*W.getColumn(k)];
+            for (int a=0; a<3; a++)
+                d[a] += w[3*a]*f[0] + w[3*a+1]*f[1] + w[3*a+2]*f[2];
+        }
+    }
+
+    sofa::simulation::TaskScheduler* taskScheduler = (m_taskScheduler)? m_taskScheduler :
+                                                      sofa::simulation::MainTaskSchedulerFactory::createInRegistry();
+    sofa::simulation::CpuTask::Status status;
+    const int nbTasks = std::max<int>(1, taskScheduler->getThreadCount());
+
+    sofa::type::vector<SolveColorTask> solveTasks;
+    solveTasks.resize(nbTasks, SolveColorTask(&status));
+    sofa::type::vector<UpdateDisplacementTask> updateTasks;
+    updateTasks.resize(nbTasks, UpdateDisplacementTask(&status));
+
+    double error = 0.;
+    int it;
+    for (it=0; it<nbIterationMax; it++)
+    {
+        error = 0.;
+        for (unsigned int color=0; color<m_nbColors; color++)
+        {
+            // New forces of the contacts of the color, which are independent
+            const int begin = m_colorOffsets[color];
+            const int nbColorContacts = m_colorOffsets[color+1] - begin;
+            const int nbSolveTasks = std::min(nbTasks, nbColorContacts);
+            const int chunk = (nbColorContacts + nbSolveTasks - 1) / nbSolveTasks;
+            for (int k=0; k<nbSolveTasks; k++)
+                solveTasks[k].set(this, &W, result, mu, begin + k*chunk, std::min(begin + (k+1)*chunk, begin + nbColorContacts));
+
+            if (nbSolveTasks == 1)
+                solveTasks[0].run();
+            else
+            {
+                for (int k=0; k<nbSolveTasks; k++)
+                    taskScheduler->addTask(&solveTasks[k]);
+                taskScheduler->workUntilDone(&status);
+            }
+            for (int k=0; k<nbSolveTasks; k++)
+                error += solveTasks[k].error;
+
+            // Update of d for the contacts coupled with the color
+            const int affectedBegin = m_affectedOffsets[color];
+            const int nbAffected = m_affectedOffsets[color+1] - affectedBegin;
+            const int nbUpdateTasks = std::min(nbTasks, nbAffected);
+            const int affectedChunk = (nbAffected + nbUpdateTasks - 1) / nbUpdateTasks;
+            for (int k=0; k<nbUpdateTasks; k++)
+                updateTasks[k].set(this, &W, color, affectedBegin + k*affectedChunk, std::min(affectedBegin + (k+1)*affectedChunk, affectedBegin + nbAffected));
+
+            if (nbUpdateTasks == 1)
+                updateTasks[0].run();
+            else
+            {
+                for (int k=0; k<nbUpdateTasks; k++)
+                    taskScheduler->addTask(&updateTasks[k]);
+                taskScheduler->workUntilDone(&status);
+            }
+        }
+
+        if (residuals) residuals->push_back(error);
+        endSweep(error);
+
+        if (violations)
+        {
+            double sum_d = 0;
+            for (int c=0;  c<nbContacts ; c++)
+                if (m_d[3*c] < 0)
+                    sum_d += -m_d[3*c];
+            violations->push_back(sum_d);
+        }
+
+        if (error < tol*(nbContacts+1))
+        {
+            if (verbose)
+                msg_info("NLCPSolver") << "Convergence after" << it <<" iteration(s) with tolerance : "<< tol <<" and error : "<< error <<" with dim : "<<dim;
+            AdvancedTimer::valSet("GS iterations", it+1);
+            setReport(it+1, error, true);
+            return 1;
+        }
 
-    for (int i = 0; i < nbContacts; i++)
-        delete W33[i];
-    free(W33);
+        if (m_timeLimit > 0. && (double)(CTime::getTime() - startTime) > timeLimitTicks)
+        {
+            m_timeLimitReached = true;
+            it++;
+            break;
+        }
+    }
+    AdvancedTimer::valSet("GS iterations", it);
+    setReport(it, error, false);
 
     if (verbose)
         msg_warning("NLCPSolver") <<"No convergence in  nlcp_gaussseidel function : error ="<<error <<" after"<< it<<" iterations";
@@ -169,6 +462,344 @@ int NLCPSolver::solve(int dim, double *dfree, double**W, double *result, double
 }
 
 
+sofa::simulation::Task::MemoryAlloc NLCPSolver::SolveColorTask::run()
+{
+    if (solver->m_threadAffinity)
+        solver->m_threadAffinity->pinCurrentThread();
+
+    error = 0.;
+    const int nbContacts = solver->m_colorContacts.size();
+    const double* blocks = solver->m_colorBlocks.data();
+    NLCPContactBatch batch;
+    for (int k0=begin; k0<end; k0+=NLCPContactBatch::s_width)
+    {
+        batch.size = std::min(NLCPContactBatch::s_width, end-k0);
+        for (int l=0; l<NLCPContactBatch::s_width; l++)
+        {
+            if (l >= batch.size)
+            {
+                batch.clearLane(l);
+                continue;
+            }
+
+            const int c = solver->m_colorContacts[k0+l];
+            const double* d = &solver->m_d[3*c];
+            const double* w = W->getDiagonalBlock(c);
+            const double fPrev[3] = {f[3*c], f[3*c+1], f[3*c+2]};
+
+            // d without the contribution of the contact itself
+            batch.d[0][l] = d[0] - w[0]*fPrev[0] - w[1]*fPrev[1] - w[2]*fPrev[2];
+            batch.d[1][l] = d[1] - w[3]*fPrev[0] - w[4]*fPrev[1] - w[5]*fPrev[2];
+            batch.d[2][l] = d[2] - w[6]*fPrev[0] - w[7]*fPrev[1] - w[8]*fPrev[2];
+            for (int a=0; a<3; a++)
+                batch.f[a][l] = fPrev[a];
+            for (int j=0; j<6; j++)
+                batch.w[j][l] = blocks[j*nbContacts + k0+l];
+        }
+
+        solver->updateContactForces(batch, mu);
+
+        for (int l=0; l<batch.size; l++)
+        {
+            const int c = solver->m_colorContacts[k0+l];
+            const double* d = &solver->m_d[3*c];
+            error += sofa::helper::absError(batch.d[0][l],batch.d[1][l],batch.d[2][l],d[0],d[1],d[2]);
+
+            for (int a=0; a<3; a++)
+                solver->m_df[3*c+a] = batch.f[a][l] - f[3*c+a];
+            sofa::helper::set3Dof(f,c,batch.f[0][l],batch.f[1][l],batch.f[2][l]);
+        }
+    }
+    return MemoryAlloc::Stack;
+}
+
+
+sofa::simulation::Task::MemoryAlloc NLCPSolver::UpdateDisplacementTask::run()
+{
+    if (solver->m_threadAffinity)
+        solver->m_threadAffinity->pinCurrentThread();
+
+    // Rank-3 update of d with the blocks of W coupling each contact with the contacts of the color
+    const double* df = solver->m_df.data();
+    for (int k=begin; k<end; k++)
+    {
+        const int n = solver->m_affectedContacts[k];
+        double* d = &solver->m_d[3*n];
+        for (int j=W->getRowBegin(n); j<W->getRowEnd(n); j++)
+        {
+            const int c = W->getColumn(j);
+            if (solver->m_contactColors[c] != color)
+                continue;
+
+            const double* w = W->getBlock(j);
+            for (int a=0; a<3; a++)
+                d[a] += w[3*a]*df[3*c] + w[3*a+1]*df[3*c+1] + w[3*a+2]*df[3*c+2];
+        }
+    }
+    return MemoryAlloc::Stack;
+}
+
+
+void NLCPSolver::colorContacts(const LCPSparseMatrix& W)
+{
+    // Greedy coloring in the order of the contacts, the pattern of W is symmetric
+    const int nbContacts = W.getNbBlockRows();
+    m_contactColors.assign(nbContacts, -1);
+    sofa::type::vector<int> forbidden(nbContacts+1, -1); // forbidden[color] == c if a neighbor of c has this color
+    m_nbColors = 0;
+    for (int c=0; c<nbContacts; c++)
+    {
+        for (int j=W.getRowBegin(c); j<W.getRowEnd(c); j++)
+        {
+            const int color = m_contactColors[W.getColumn(j)];
+            if (color >= 0)
+                forbidden[color] = c;
+        }
+
+        int color = 0;
+        while (forbidden[color] == c)
+            color++;
+        m_contactColors[c] = color;
+        m_nbColors = std::max(m_nbColors, (unsigned int)color+1);
+    }
+
+    m_colorOffsets.assign(m_nbColors+1, 0);
+    for (int c=0; c<nbContacts; c++)
+        m_colorOffsets[m_contactColors[c]+1]++;
+    for (unsigned int color=0; color<m_nbColors; color++)
+        m_colorOffsets[color+1] += m_colorOffsets[color];
+
+    m_colorContacts.resize(nbContacts);
+    sofa::type::vector<int> position(m_colorOffsets.begin(), m_colorOffsets.end()-1);
+    for (int c=0; c<nbContacts; c++)
+        m_colorContacts[position[m_contactColors[c]]++] = c;
+
+    // Contacts whose d changes with the forces of each color
+    m_affectedOffsets.resize(m_nbColors+1);
+    m_affectedContacts.clear();
+    sofa::type::vector<int> marker(nbContacts, -1);
+    for (unsigned int color=0; color<m_nbColors; color++)
+    {
+        m_affectedOffsets[color] = m_affectedContacts.size();
+        for (int k=m_colorOffsets[color]; k<m_colorOffsets[color+1]; k++)
+        {
+            const int c = m_colorContacts[k];
+            for (int j=W.getRowBegin(c); j<W.getRowEnd(c); j++)
+            {
+                const int n = W.getColumn(j);
+                if (marker[n] != (int)color)
+                {
+                    marker[n] = color;
+                    m_affectedContacts.push_back(n);
+                }
+            }
+        }
+    }
+    m_affectedOffsets[m_nbColors] = m_affectedContacts.size();
+}
+
+
+size_t NLCPSolver::getMemoryUsage() const
+{
+    return sizeof(NLCPSolverMatrix33)*m_W33.capacity() + m_floatW.getMemoryUsage()
+            + sizeof(unsigned int)*m_floatIds.capacity()
+            + sizeof(double)*(m_d.capacity() + m_df.capacity() + m_colorBlocks.capacity());
+}
+
+
+void NLCPSolver::startSolve(double minW, double maxF)
+{
+    m_minW = minW;
+    m_maxF = maxF;
+    m_omega = (m_adaptiveRelaxation)? 1. : m_relaxation;
+    m_nbEstimationSweeps = 0;
+    m_residualHistory.clear();
+    setReport(0, 0., false);
+}
+
+
+void NLCPSolver::endSweep(double error)
+{
+    // Adaptive relaxation: the contraction rate rho of the error is measured over plain Gauss-Seidel sweeps,
+    // then the factor of Young 2/(1+sqrt(1-rho)), optimal for linear problems, is used up to the given
+    // factor. If the error grows again, the factor restarts from 1 for a new estimation.
+    if (m_adaptiveRelaxation && !m_residualHistory.empty())
+    {
+        const double previousError = m_residualHistory.back();
+        if (m_omega == 1.)
+        {
+            m_nbEstimationSweeps++;
+            if (m_nbEstimationSweeps >= s_nbEstimationSweeps && previousError > 0. && error < previousError)
+            {
+                const double rho = error/previousError;
+                m_omega = std::min(2./(1.+std::sqrt(1.-rho)), m_relaxation);
+            }
+        }
+        else if (error > previousError)
+        {
+            m_omega = 1.;
+            m_nbEstimationSweeps = 0;
+        }
+    }
+    m_residualHistory.push_back(error);
+}
+
+
+void NLCPSolver::setReport(int nbIterations, double error, bool converged)
+{
+    m_nbIterations = nbIterations;
+    m_error = error;
+    m_converged = converged;
+}
+
+
+void NLCPSolver::updateContactForce(int c, double mu, double &dn, double &dt, double &ds, double &fn, double &ft, double &fs)
+{
+    NLCPSolverMatrix33& w33 = m_W33[c];
+
+    // Not enough compliance to compute a force
+    if (m_minW > 0. && w33.m_w[0] < m_minW)
+    {
+        fn = 0.; ft = 0.; fs = 0.;
+        return;
+    }
+
+    const double d0[3] = {dn, dt, ds};
+    const double fPrev[3] = {fn, ft, fs};
+    w33.GSState(mu,dn,dt,ds,fn,ft,fs,m_allowSliding);
+
+    if (m_omega == 1. && m_maxF <= 0.)
+        return;
+
+    // Over-relaxation and bound of the normal force, projected back on the friction cone
+    fn = fPrev[0] + m_omega*(fn - fPrev[0]);
+    ft = fPrev[1] + m_omega*(ft - fPrev[1]);
+    fs = fPrev[2] + m_omega*(fs - fPrev[2]);
+    if (m_maxF > 0. && fn > m_maxF)
+        fn = m_maxF;
+
+    if (fn <= 0.)
+    {
+        fn = 0.; ft = 0.; fs = 0.;
+    }
+    else if (m_allowSliding)
+    {
+        const double normFt = rabs(ft)+rabs(fs);
+        if (normFt > mu*fn)
+        {
+            ft *= mu*fn/normFt;
+            fs *= mu*fn/normFt;
+        }
+    }
+
+    const double* w = w33.m_w;
+    dn = d0[0] + w[0]*fn + w[1]*ft + w[2]*fs;
+    dt = d0[1] + w[1]*fn + w[3]*ft + w[4]*fs;
+    ds = d0[2] + w[2]*fn + w[4]*ft + w[5]*fs;
+}
+
+
+void NLCPSolver::updateContactForces(NLCPContactBatch& batch, double mu) const
+{
+    constexpr int width = NLCPContactBatch::s_width;
+    double d0[3][width];
+    double fPrev[3][width];
+    for (int a=0; a<3; a++)
+        for (int l=0; l<width; l++)
+        {
+            d0[a][l] = batch.d[a][l];
+            fPrev[a][l] = batch.f[a][l];
+        }
+
+    batch.GSState(mu, m_allowSliding);
+
+    const double (&w)[6][width] = batch.w;
+    if (m_omega != 1. || m_maxF > 0.)
+    {
+        // Over-relaxation and bound of the normal force, projected back on the friction cone
+        for (int l=0; l<width; l++)
+        {
+            double fn = fPrev[0][l] + m_omega*(batch.f[0][l] - fPrev[0][l]);
+            double ft = fPrev[1][l] + m_omega*(batch.f[1][l] - fPrev[1][l]);
+            double fs = fPrev[2][l] + m_omega*(batch.f[2][l] - fPrev[2][l]);
+            fn = (m_maxF > 0. && fn > m_maxF)? m_maxF : fn;
+
+            const bool isActive = fn > 0.;
+            const double normFt = rabs(ft)+rabs(fs);
+            const double scale = (m_allowSliding && normFt > mu*fn)? mu*fn/normFt : 1.;
+            fn = isActive? fn : 0.;
+            ft = isActive? ft*scale : 0.;
+            fs = isActive? fs*scale : 0.;
+
+            batch.f[0][l] = fn;
+            batch.f[1][l] = ft;
+            batch.f[2][l] = fs;
+            batch.d[0][l] = d0[0][l] + w[0][l]*fn + w[1][l]*ft + w[2][l]*fs;
+            batch.d[1][l] = d0[1][l] + w[1][l]*fn + w[3][l]*ft + w[4][l]*fs;
+            batch.d[2][l] = d0[2][l] + w[2][l]*fn + w[4][l]*ft + w[5][l]*fs;
+        }
+    }
+
+    // Not enough compliance to compute a force
+    if (m_minW > 0.)
+        for (int l=0; l<width; l++)
+        {
+            const bool isCompliant = w[0][l] >= m_minW;
+            for (int a=0; a<3; a++)
+            {
+                batch.f[a][l] = isCompliant? batch.f[a][l] : 0.;
+                batch.d[a][l] = isCompliant? batch.d[a][l] : d0[a][l];
+            }
+        }
+}
+
+
+void NLCPContactBatch::clearLane(int lane)
+{
+    w[0][lane] = 1.; w[1][lane] = 0.; w[2][lane] = 0.;
+    w[3][lane] = 1.; w[4][lane] = 0.; w[5][lane] = 1.;
+    for (int a=0; a<3; a++)
+    {
+        d[a][lane] = 0.;
+        f[a][lane] = 0.;
+    }
+}
+
+
+void NLCPContactBatch::GSState(double mu, bool allowSliding)
+{
+    for (int l=0; l<s_width; l++)
+    {
+        const double w11 = w[0][l], w12 = w[1][l], w13 = w[2][l];
+        const double w22 = w[3][l], w23 = w[4][l], w33 = w[5][l];
+        const double dn = d[0][l], dt = d[1][l], ds = d[2][l];
+
+        // new normal force, the contact is released if it is negative
+        double fn = f[0][l], ft = f[1][l], fs = f[2][l];
+        fn -= (w11*fn + w12*ft + w13*fs + dn)/w11;
+        const bool isActive = !(fn < 0);
+        fn = isActive? fn : 0.;
+
+        // new friction forces, projected on the friction cone if sliding is allowed
+        const double dt1 = w12*fn + w22*ft + w23*fs + dt;
+        const double ds1 = w13*fn + w23*ft + w33*fs + ds;
+        ft -= 2*dt1/(w22+w33);
+        fs -= 2*ds1/(w22+w33);
+        const double normFt = rabs(ft)+rabs(fs);
+        const double scale = (allowSliding && normFt > mu*fn)? mu*fn/normFt : 1.;
+        ft = isActive? ft*scale : 0.;
+        fs = isActive? fs*scale : 0.;
+
+        f[0][l] = fn;
+        f[1][l] = ft;
+        f[2][l] = fs;
+        d[0][l] = dn + w11*fn + w12*ft + w13*fs;
+        d[1][l] = dt + w12*fn + w22*ft + w23*fs;
+        d[2][l] = ds + w13*fn + w23*ft + w33*fs;
+    }
+}
+
+
 void NLCPSolverMatrix33::GSState(double &mu, double &dn, double &dt, double &ds, double &fn, double &ft, double &fs, bool allowSliding)
 {
     double d[3];
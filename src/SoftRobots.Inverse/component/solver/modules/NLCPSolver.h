@@ -31,6 +31,10 @@
 #include <sofa/helper/system/thread/CTime.h>
 #include <sofa/type/vector.h>
 #include <sofa/helper/LCPcalc.h>
+#include <sofa/simulation/TaskScheduler.h>
+#include <SoftRobots.Inverse/component/solver/modules/LCPSparseMatrix.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPPermutedCompliance.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPThreadAffinity.h>
 
 
 // NLCP solver for friction contact
@@ -41,36 +45,224 @@
 namespace softrobotsinverse::solver::module
 {
 
+class NLCPSolverMatrix33
+{
+
+public:
+    double m_w[6];
+    bool m_stored;
+
+public:
+    NLCPSolverMatrix33() {m_stored=false;}
+    ~NLCPSolverMatrix33() {}
+
+    void storeW(double &w11, double &w12, double &w13, double &w22, double &w23, double &w33);
+    void GSState(double &mu, double &dn, double &dt, double &ds, double &fn, double &ft, double &fs, bool allowSliding);
+};
+
+/// Local problems of a batch of independent contacts (e.g. of a color), in structure of arrays: each lane
+/// is a contact, and the lanes are updated without branches so that the loops are vectorized by the
+/// compiler for the target (SSE/AVX, NEON)
+class NLCPContactBatch
+{
+
+public:
+    static constexpr int s_width{8};
+
+    int size{0};            // lanes in use, the others hold an inactive contact
+    double w[6][s_width];   // upper triangle of the diagonal blocks of W: w11, w12, w13, w22, w23, w33
+    double d[3][s_width];   // displacement without the force of the contact, then with its new force
+    double f[3][s_width];   // previous force, then new force
+
+    /// Puts an inactive contact in the lane (unit compliance, no force)
+    void clearLane(int lane);
+
+    /// NLCPSolverMatrix33::GSState on each lane
+    void GSState(double mu, bool allowSliding);
+};
+
 class NLCPSolver
 {
 
 protected:
     bool m_allowSliding;
+    double m_timeLimit{0.};
+    bool m_timeLimitReached{false};
+
+    // Diagonal 3x3 blocks of W, one per contact. The solver is meant to be kept alive across steps
+    // so that this storage is only reallocated when the number of contacts grows.
+    sofa::type::vector<NLCPSolverMatrix33> m_W33;
+
+    // Colored Gauss-Seidel: the blocks of W coupling the contacts (including the contact itself) are
+    // stored in block-CSR form, and the contacts of a color are not coupled with each other
+    bool m_multithreading{false};
+    LCPSparseMatrix m_blockW; // Extracted from a dense W
+    sofa::type::vector<int> m_colorOffsets;
+    sofa::type::vector<int> m_colorContacts;
+    sofa::type::vector<int> m_contactColors;
+    sofa::type::vector<int> m_affectedOffsets;  // Contacts coupled with the contacts of each color
+    sofa::type::vector<int> m_affectedContacts;
+    sofa::type::vector<double> m_d;  // d = W f + dfree, updated after each color
+    sofa::type::vector<double> m_df; // Change of the forces of the contacts of the current color
+    sofa::type::vector<double> m_colorBlocks; // Upper triangles of the diagonal blocks, by entry then in color order
+    unsigned int m_nbColors{0};
+    const QPThreadAffinity* m_threadAffinity{nullptr}; // cores of the threads running the tasks
+    sofa::simulation::TaskScheduler* m_taskScheduler{nullptr}; // nullptr for the main task scheduler
+
+    class SolveColorTask : public sofa::simulation::CpuTask
+    {
+    public:
+        SolveColorTask(sofa::simulation::CpuTask::Status* status): CpuTask(status) {}
+        ~SolveColorTask() override {}
+
+        MemoryAlloc run() final;
+
+        void set(NLCPSolver* _solver, const LCPSparseMatrix* _W, double* _f, double _mu, int _begin, int _end){
+            solver = _solver;
+            W = _W;
+            f = _f;
+            mu = _mu;
+            begin = _begin;
+            end = _end;
+        }
+
+        double error{0.};
+
+    private:
+        NLCPSolver* solver{nullptr};
+        const LCPSparseMatrix* W{nullptr};
+        double* f{nullptr};
+        double mu{0.};
+        int begin{0}; // range in m_colorContacts
+        int end{0};
+    };
+
+    class UpdateDisplacementTask : public sofa::simulation::CpuTask
+    {
+    public:
+        UpdateDisplacementTask(sofa::simulation::CpuTask::Status* status): CpuTask(status) {}
+        ~UpdateDisplacementTask() override {}
+
+        MemoryAlloc run() final;
+
+        void set(NLCPSolver* _solver, const LCPSparseMatrix* _W, int _color, int _begin, int _end){
+            solver = _solver;
+            W = _W;
+            color = _color;
+            begin = _begin;
+            end = _end;
+        }
+
+    private:
+        NLCPSolver* solver{nullptr};
+        const LCPSparseMatrix* W{nullptr};
+        int color{0};
+        int begin{0}; // range in m_affectedContacts
+        int end{0};
+    };
+
+    // Convergence report and relaxation
+    double m_relaxation{1.};
+    bool m_adaptiveRelaxation{false};
+    double m_omega{1.};
+    int m_nbEstimationSweeps{0};
+    static constexpr int s_nbEstimationSweeps{5};
+    double m_minW{0.};
+    double m_maxF{0.};
+    int m_nbIterations{0};
+    double m_error{0.};
+    bool m_converged{false};
+    sofa::type::vector<double> m_residualHistory;
+
+    void startSolve(double minW, double maxF);
+    void endSweep(double error);
+    void setReport(int nbIterations, double error, bool converged);
+    void updateContactForce(int c, double mu, double &dn, double &dt, double &ds, double &fn, double &ft, double &fs);
+    /// updateContactForce() on the lanes of the batch
+    void updateContactForces(NLCPContactBatch& batch, double mu) const;
+
+    // Mixed precision: the sweeps read a float copy of the dense W, then refinement sweeps read W
+    bool m_mixedPrecision{false};
+    QPPermutedComplianceF m_floatW;
+    sofa::type::vector<unsigned int> m_floatIds;
+    sofa::type::vector<QPPermutedComplianceF::QPRowBlock> m_floatBlocks;
+    int m_nbRefinementSweeps{0};
+    static constexpr double s_floatRelativeTolerance{1e-5}; // reduction of the error by the float sweeps
+
+    /// Gauss-Seidel sweeps reading the rows Wr of W (W itself or a copy in another precision), the
+    /// local problems using the diagonal blocks of W. The sweeps stop on convergence (returns true), or
+    /// once the error is reduced by relativeTol from the first sweep (if not null).
+    template<class Real>
+    bool solveSweeps(int dim, double *dfree, double**W, const Real* const* Wr, double *f, double mu,
+                     double tol, double relativeTol, int nbIterationMax, sofa::type::vector<double>* residuals,
+                     sofa::type::vector<double>* violations, const sofa::helper::system::thread::ctime_t& startTime,
+                     int& nbIterations, double& error);
+
+    void colorContacts(const LCPSparseMatrix& W);
+    int solveColored(int dim, double *dfree, const LCPSparseMatrix& W, double *f, double mu, double tol, int numItMax,
+                     bool verbose, sofa::type::vector<double>* residuals, sofa::type::vector<double>* violations);
 
 public:
     NLCPSolver(){}
     ~NLCPSolver(){}
 
+    /// Returns 1 on convergence. The contacts whose normal compliance is lower than minW (if not null)
+    /// get no force, and the normal forces are bounded by maxF (if not null).
     int solve(int dim, double *dfree, double**W, double *f, double mu, double tol, int numItMax,
               bool useInitialF, bool verbose = false, double minW=0.0, double maxF=0.0,
               sofa::type::vector<double>* residuals = NULL, sofa::type::vector<double>* violations = NULL);
 
+    /// Same resolution with the 3x3 blocks of W given in block-CSR form (blockSize 3), each sweep
+    /// only visits the blocks coupling the contacts
+    int solve(int dim, double *dfree, const LCPSparseMatrix& W, double *f, double mu, double tol, int numItMax,
+              bool useInitialF, bool verbose = false, double minW=0.0, double maxF=0.0,
+              sofa::type::vector<double>* residuals = NULL, sofa::type::vector<double>* violations = NULL);
+
     void setAllowSliding(bool allowSliding) {m_allowSliding=allowSliding;}
-};
 
-class NLCPSolverMatrix33
-{
+    /// If enabled, the contacts are colored so that the contacts of a color are not coupled by W, and
+    /// the contacts of a color are updated concurrently on the task scheduler. d = W f + dfree is kept
+    /// and updated with the blocks of W coupling the contacts, instead of full rows of W per contact.
+    /// The sweeps follow the order of the colors, so the iterates differ from the sequential solver.
+    void setMultithreading(bool multithreading) {m_multithreading=multithreading;}
+    /// Cores the threads running the tasks of the colors are pinned to, nullptr to leave them free
+    void setThreadAffinity(const QPThreadAffinity* threadAffinity) {m_threadAffinity=threadAffinity;}
+    /// Scheduler running the tasks of the colors (see QPTaskPool), nullptr for the main task scheduler
+    void setTaskScheduler(sofa::simulation::TaskScheduler* taskScheduler) {m_taskScheduler=taskScheduler;}
 
-public:
-    double m_w[6];
-    bool m_stored;
+    /// If enabled, the sweeps of the dense resolution read a float copy of W (the displacements being
+    /// accumulated in double), then refinement sweeps on W continue from this solution until the error is
+    /// within the tolerance. The sweeps read half the memory, only the last ones reading W.
+    void setMixedPrecision(bool mixedPrecision) {m_mixedPrecision=mixedPrecision;}
+    /// Number of refinement sweeps of the last mixed precision resolution
+    int getNbRefinementSweeps() const {return m_nbRefinementSweeps;}
+    /// Allocation of the float copy of W, see QPStoragePolicy
+    void setStoragePolicy(const QPStoragePolicy& policy) {m_floatW.setStoragePolicy(policy);}
 
-public:
-    NLCPSolverMatrix33() {m_stored=false;}
-    ~NLCPSolverMatrix33() {}
+    /// Memory of the buffers kept across the resolutions, in bytes
+    size_t getMemoryUsage() const;
 
-    void storeW(double &w11, double &w12, double &w13, double &w22, double &w23, double &w33);
-    void GSState(double &mu, double &dn, double &dt, double &ds, double &fn, double &ft, double &fs, bool allowSliding);
+    /// Over-relaxation of the new forces of each sweep, in ]0, 2[ (1 for plain Gauss-Seidel), the forces
+    /// being projected back on the friction cone. If adaptive, the factor is estimated from the contraction
+    /// of the error over the first plain sweeps (optimal factor of SOR for linear problems), bounded by the
+    /// given one, and estimated again if the error grows.
+    void setRelaxation(double omega) {m_relaxation=omega;}
+    void setAdaptiveRelaxation(bool adaptive) {m_adaptiveRelaxation=adaptive;}
+
+    /// Report of the last resolution: number of sweeps, error of the last sweep, convergence,
+    /// and error of each sweep
+    int getNbIterations() const {return m_nbIterations;}
+    double getError() const {return m_error;}
+    bool hasConverged() const {return m_converged;}
+    const sofa::type::vector<double>& getResidualHistory() const {return m_residualHistory;}
+
+    /// Number of colors of the last colored resolution
+    unsigned int getNbColors() const {return m_nbColors;}
+
+    /// Time limit of the resolution in seconds (0 for no limit). When it is reached, the iterations stop
+    /// and the current forces, which are always inside the friction cone, are returned.
+    void setTimeLimit(double timeLimit) {m_timeLimit=timeLimit;}
+    bool isTimeLimitReached() const {return m_timeLimitReached;}
 };
 
 } // namespace
@@ -0,0 +1,112 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#include <functional>
+#include <SoftRobots.Inverse/component/solver/modules/QPActiveSetCache.h>
+
+namespace softrobotsinverse::solver::module
+{
+
+void QPActiveSetCache::setCapacity(const unsigned int& capacity)
+{
+    m_capacity = capacity;
+    while(m_entries.size() > m_capacity)
+    {
+        m_index.erase(m_entries.back().first);
+        m_entries.pop_back();
+    }
+}
+
+
+const QPActiveSetCache::Entry* QPActiveSetCache::find(const Key& key)
+{
+    auto it = m_index.find(key);
+    if(it == m_index.end())
+        return nullptr;
+
+    m_entries.splice(m_entries.begin(), m_entries, it->second);
+    return &it->second->second;
+}
+
+
+void QPActiveSetCache::insert(const Key& key, const Entry& entry)
+{
+    if(m_capacity == 0)
+        return;
+
+    auto it = m_index.find(key);
+    if(it != m_index.end())
+    {
+        it->second->second = entry;
+        m_entries.splice(m_entries.begin(), m_entries, it->second);
+        return;
+    }
+
+    if(m_entries.size() >= m_capacity)
+    {
+        m_index.erase(m_entries.back().first);
+        m_entries.pop_back();
+    }
+
+    m_entries.emplace_front(key, entry);
+    m_index.emplace(key, m_entries.begin());
+}
+
+
+void QPActiveSetCache::clear()
+{
+    m_entries.clear();
+    m_index.clear();
+}
+
+
+size_t QPActiveSetCache::getMemoryUsage() const
+{
+    size_t usage = 0;
+    for(const auto& [key, entry] : m_entries)
+    {
+        // The keys are stored twice, in the list and in the index
+        usage += 2*sizeof(int)*key.capacity();
+        usage += sizeof(int)*(entry.contactStates.capacity() + entry.bounds.capacity())
+                + sizeof(double)*entry.x.capacity()
+                + entry.constraints.size()*(sizeof(std::pair<int,int>) + sizeof(int));
+    }
+    return usage;
+}
+
+
+size_t QPActiveSetCache::KeyHash::operator()(const Key& key) const
+{
+    size_t hash = key.size();
+    std::hash<int> hasher;
+    for(const int& value : key)
+        hash ^= hasher(value) + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+    return hash;
+}
+
+} // namespace
@@ -0,0 +1,95 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <map>
+#include <unordered_map>
+
+#include <sofa/type/vector.h>
+
+#include <SoftRobots.Inverse/component/config.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+using sofa::type::vector;
+
+/// Least recently used cache of the outcome of the contact pivot algorithm, for the repetitive tasks
+/// (e.g. pick-and-place cycles) where the same few contact configurations come back. The key is a
+/// signature of the configuration at the start of the algorithm (see QPInverseProblemImpl), the entry
+/// holds the contact states the algorithm ended with, and the working set of its last QP (guess of the
+/// solution, status of the bounds and of the constraint rows by variable id and rank, as qpOASES
+/// SubjectToStatus values).
+class SOFA_SOFTROBOTS_INVERSE_API QPActiveSetCache
+{
+public:
+    typedef vector<int> Key;
+
+    struct Entry{
+        vector<int> contactStates; // Index of the state of each contact point among the allowed states
+        vector<double> x;
+        vector<int> bounds;
+        std::map<std::pair<int,int>, int> constraints;
+    };
+
+    typedef std::list<std::pair<Key, Entry>> EntryList;
+
+    /// Maximum number of entries, 0 disables the cache
+    void setCapacity(const unsigned int& capacity);
+    unsigned int getCapacity() const {return m_capacity;}
+    unsigned int size() const {return m_entries.size();}
+
+    /// Entry of the key (marked as the most recently used one), nullptr if not in the cache
+    const Entry* find(const Key& key);
+
+    /// Adds or replaces the entry of the key, the least recently used entry is removed if the cache is full
+    void insert(const Key& key, const Entry& entry);
+
+    void clear();
+
+    /// Entries from the most to the least recently used, e.g. to save them in a checkpoint
+    const EntryList& getEntries() const {return m_entries;}
+
+    size_t getMemoryUsage() const;
+
+protected:
+
+    struct KeyHash{
+        size_t operator()(const Key& key) const;
+    };
+
+    unsigned int m_capacity{0};
+    EntryList m_entries; // From the most to the least recently used
+    std::unordered_map<Key, EntryList::iterator, KeyHash> m_index;
+};
+
+} // namespace
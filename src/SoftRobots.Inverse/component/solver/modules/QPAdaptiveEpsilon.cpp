@@ -0,0 +1,118 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#include <algorithm>
+
+#include <SoftRobots.Inverse/component/solver/modules/QPAdaptiveEpsilon.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+namespace
+{
+    bool hasDrifted(const double& trace, const double& reference, const double& maxDrift)
+    {
+        if(reference <= 0. || trace <= 0.)
+            return trace != reference;
+        return (trace > reference*maxDrift || trace*maxDrift < reference);
+    }
+}
+
+
+void QPAdaptiveEpsilon::setAdaptive(const bool& adaptive, const double& minConditioning, const double& maxConditioning)
+{
+    if(adaptive != m_adaptive)
+        clear();
+
+    m_adaptive = adaptive;
+    m_minConditioning = std::min(minConditioning, maxConditioning);
+    m_maxConditioning = maxConditioning;
+}
+
+
+bool QPAdaptiveEpsilon::isRefreshNeeded(const unsigned int& dim, const double& traceQ, const double& traceW) const
+{
+    if(!m_adaptive || !m_hasWeight || dim != m_dim || m_nbSteps+1 >= m_refreshPeriod)
+        return true;
+
+    return hasDrifted(traceQ, m_traceQ, s_maxTraceDrift) || hasDrifted(traceW, m_traceW, s_maxTraceDrift);
+}
+
+
+void QPAdaptiveEpsilon::setWeight(const double& weight, const unsigned int& dim, const double& traceQ, const double& traceW)
+{
+    m_weight = weight;
+    m_dim = dim;
+    m_traceQ = traceQ;
+    m_traceW = traceW;
+    m_hasWeight = true;
+    m_nbSteps = 0;
+    m_nbRefreshes++;
+}
+
+
+double QPAdaptiveEpsilon::getWeight(const double& traceQ, const double& traceW)
+{
+    m_nbSteps++;
+    if(m_traceQ <= 0. || traceW <= 0.)
+        return m_weight;
+    return m_weight*(traceQ/m_traceQ)*(m_traceW/traceW);
+}
+
+
+void QPAdaptiveEpsilon::updateScale(const double& conditioning)
+{
+    if(!m_adaptive)
+        return;
+
+    if(conditioning > m_maxConditioning)
+        m_scale = std::min(2.*m_scale, s_maxScale);
+    else if(conditioning < m_minConditioning)
+        m_scale = std::max(0.5*m_scale, s_minScale);
+}
+
+
+void QPAdaptiveEpsilon::addIndefiniteHessian()
+{
+    m_nbIndefiniteHessians++;
+    if(m_adaptive)
+        m_scale = std::min(10.*m_scale, s_maxScale);
+}
+
+
+void QPAdaptiveEpsilon::clear()
+{
+    m_scale = 1.;
+    m_hasWeight = false;
+    m_nbSteps = 0;
+    m_nbRefreshes = 0;
+    m_nbIndefiniteHessians = 0;
+}
+
+} // namespace
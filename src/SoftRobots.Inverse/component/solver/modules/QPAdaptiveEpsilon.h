@@ -0,0 +1,101 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <SoftRobots.Inverse/component/config.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+/// Adaptive energy term of the QP, Q += epsilon*scale*weight*W_energy with weight = ||Q||/||W_energy||.
+///
+/// The uniform norms are computed from scratch at the first step, then every refreshPeriod steps, or when
+/// the dimension changes or the traces of Q and W_energy drift by more than a factor 2 from the step of the
+/// norms. In between, the weight is extrapolated from the traces, read in O(n) instead of the O(n^2) scans.
+///
+/// The scale keeps a cheap estimate of the condition number of the Hessian in [minConditioning,
+/// maxConditioning]: the ratio of its largest and smallest diagonal terms, a lower bound of the condition
+/// number of a positive definite matrix. The scale is doubled at the next step when the estimate is above
+/// the range, halved when below, within [1e-3, 1e3]. A QP solved again with an indefinite Hessian
+/// multiplies it by 10, so that the next steps do not need the retry.
+/// While disabled, the scale is 1 and the norms are computed at each step.
+class SOFA_SOFTROBOTS_INVERSE_API QPAdaptiveEpsilon
+{
+public:
+
+    void setAdaptive(const bool& adaptive, const double& minConditioning, const double& maxConditioning);
+    bool isAdaptive() const {return m_adaptive;}
+    void setRefreshPeriod(const unsigned int& period) {m_refreshPeriod = period;}
+
+    /// True if the norms have to be computed at this step, from the traces of Q (without the energy term)
+    /// and W_energy, and the dimension of W_energy
+    bool isRefreshNeeded(const unsigned int& dim, const double& traceQ, const double& traceW) const;
+    /// Weight computed from the norms, the reference of the next extrapolations
+    void setWeight(const double& weight, const unsigned int& dim, const double& traceQ, const double& traceW);
+    /// Weight extrapolated from the traces
+    double getWeight(const double& traceQ, const double& traceW);
+
+    /// Ratio of the largest and smallest diagonal terms of the Hessian of the step
+    void updateScale(const double& conditioning);
+    /// The QP of the step was solved again with an indefinite Hessian
+    void addIndefiniteHessian();
+
+    double getScale() const {return (m_adaptive)? m_scale : 1.;}
+    unsigned int getNbRefreshes() const {return m_nbRefreshes;}
+    unsigned int getNbIndefiniteHessians() const {return m_nbIndefiniteHessians;}
+
+    void clear();
+
+protected:
+
+    bool m_adaptive{false};
+    double m_minConditioning{1e2};
+    double m_maxConditioning{1e8};
+    unsigned int m_refreshPeriod{50};
+
+    double m_scale{1.};
+
+    // Reference of the extrapolation
+    bool m_hasWeight{false};
+    double m_weight{0.};
+    double m_traceQ{0.};
+    double m_traceW{0.};
+    unsigned int m_dim{0};
+    unsigned int m_nbSteps{0}; // Since the last refresh
+
+    unsigned int m_nbRefreshes{0};
+    unsigned int m_nbIndefiniteHessians{0};
+
+    static constexpr double s_minScale{1e-3};
+    static constexpr double s_maxScale{1e3};
+    static constexpr double s_maxTraceDrift{2.};
+};
+
+} // namespace
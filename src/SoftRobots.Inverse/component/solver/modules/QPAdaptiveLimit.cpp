@@ -0,0 +1,108 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <SoftRobots.Inverse/component/solver/modules/QPAdaptiveLimit.h>
+
+namespace softrobotsinverse::solver::module
+{
+
+void QPAdaptiveLimit::setMaxLimit(const int& maxLimit)
+{
+    m_maxLimit = std::max(maxLimit, 1);
+    updateLimit();
+}
+
+
+void QPAdaptiveLimit::setAdaptive(const bool& adaptive, const double& percentile, const double& margin)
+{
+    if(!adaptive && m_adaptive)
+        clear();
+
+    m_adaptive = adaptive;
+    m_percentile = std::min(std::max(percentile, 0.), 1.);
+    m_margin = std::max(margin, 0.);
+    updateLimit();
+}
+
+
+void QPAdaptiveLimit::setWindowSize(const unsigned int& windowSize)
+{
+    unsigned int size = std::max(windowSize, 1u);
+    if(size == m_windowSize)
+        return;
+
+    m_windowSize = size;
+    clear();
+}
+
+
+void QPAdaptiveLimit::add(const int& count)
+{
+    if(!m_adaptive)
+        return;
+
+    if(m_window.size() < m_windowSize)
+        m_window.push_back(count);
+    else
+        m_window[m_next] = count;
+
+    m_next = (m_next+1)%m_windowSize;
+    m_isFilled = m_isFilled || m_window.size() == m_windowSize;
+    updateLimit();
+}
+
+
+void QPAdaptiveLimit::clear()
+{
+    m_window.clear();
+    m_next = 0;
+    m_isFilled = false;
+}
+
+
+void QPAdaptiveLimit::updateLimit()
+{
+    if(m_window.empty())
+    {
+        m_limit = m_maxLimit;
+        return;
+    }
+
+    m_sorted = m_window;
+    unsigned int rank = std::min((unsigned int)std::ceil(m_percentile*m_sorted.size()), (unsigned int)m_sorted.size());
+    rank = (rank>0)? rank-1 : 0;
+    std::nth_element(m_sorted.begin(), m_sorted.begin()+rank, m_sorted.end());
+
+    const int limit = (int)std::ceil(m_sorted[rank]*(1.+m_margin));
+    m_limit = std::min(std::max(limit, m_minLimit), m_maxLimit);
+}
+
+} // namespace
@@ -0,0 +1,80 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <sofa/type/vector.h>
+
+#include <SoftRobots.Inverse/component/config.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+/// Limit on an iteration count (pivots of the contact loop, working set changes of a QP), sized from the
+/// counts of the recent resolutions: the given percentile of the counts over a window, times (1+margin),
+/// bounded in [minLimit, maxLimit]. A pathological resolution is thereby stopped at a few times the usual
+/// count, instead of running up to maxLimit. A resolution stopped by the limit records the limit itself,
+/// so that the limit grows back by (1+margin) at each stopped resolution if the problem became harder.
+/// While disabled, or until the window has been filled once, the limit is maxLimit.
+class SOFA_SOFTROBOTS_INVERSE_API QPAdaptiveLimit
+{
+public:
+
+    QPAdaptiveLimit(const int& maxLimit, const int& minLimit) : m_maxLimit(maxLimit), m_minLimit(minLimit) {}
+
+    void setMaxLimit(const int& maxLimit);
+    void setAdaptive(const bool& adaptive, const double& percentile, const double& margin);
+    void setWindowSize(const unsigned int& windowSize);
+
+    /// Count of the last resolution
+    void add(const int& count);
+    void clear();
+
+    int getLimit() const {return (m_adaptive && m_isFilled)? m_limit : m_maxLimit;}
+    int getMaxLimit() const {return m_maxLimit;}
+
+protected:
+
+    int m_maxLimit;
+    int m_minLimit;
+    bool m_adaptive{false};
+    double m_percentile{0.9};
+    double m_margin{1.};
+
+    sofa::type::vector<int> m_window; // Ring buffer of the last counts
+    sofa::type::vector<int> m_sorted;
+    unsigned int m_windowSize{100};
+    unsigned int m_next{0};
+    bool m_isFilled{false};
+    int m_limit{0};
+
+    void updateLimit();
+};
+
+} // namespace
@@ -0,0 +1,255 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#define SOFTROBOTS_INVERSE_QPALIGNEDBUFFER_CPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <new>
+#include <utility>
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+#include <SoftRobots.Inverse/component/solver/modules/QPAlignedBuffer.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+namespace
+{
+
+std::atomic<unsigned int> nbHugePageFallbacks{0};
+
+size_t roundUp(const size_t& n, const size_t& multiple)
+{
+    return (n + multiple - 1)/multiple*multiple;
+}
+
+}
+
+
+bool QPStorage::getPolicy(const std::string& name, QPStoragePolicy& policy)
+{
+    if(name == "Default")
+        policy = QPStoragePolicy::Default;
+    else if(name == "Aligned")
+        policy = QPStoragePolicy::Aligned;
+    else if(name == "TransparentHugePages")
+        policy = QPStoragePolicy::TransparentHugePages;
+    else if(name == "HugePages")
+        policy = QPStoragePolicy::HugePages;
+    else
+        return false;
+    return true;
+}
+
+
+QPStorage::Block QPStorage::allocate(const size_t& bytes, const QPStoragePolicy& policy)
+{
+    Block block;
+    if(bytes == 0)
+        return block;
+
+    if(policy == QPStoragePolicy::Default)
+    {
+        block.data = ::operator new(bytes);
+        block.bytes = bytes;
+        return block;
+    }
+
+    const bool isHuge = policy != QPStoragePolicy::Aligned && bytes >= s_hugePageSize;
+    block.alignment = (isHuge)? s_hugePageSize : s_alignment;
+    block.bytes = roundUp(bytes, block.alignment);
+
+#if defined(__linux__) && defined(MAP_HUGETLB)
+    if(isHuge && policy == QPStoragePolicy::HugePages)
+    {
+        void* data = mmap(nullptr, block.bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if(data != MAP_FAILED)
+        {
+            block.data = data;
+            block.isMapped = true;
+            return block;
+        }
+        nbHugePageFallbacks++; // No huge page reserved (vm.nr_hugepages) or left
+    }
+#endif
+
+    block.data = ::operator new(block.bytes, std::align_val_t(block.alignment));
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    if(isHuge)
+        madvise(block.data, block.bytes, MADV_HUGEPAGE); // Only advice, ignored when disabled
+#endif
+    return block;
+}
+
+
+void QPStorage::deallocate(Block& block)
+{
+    if(block.data)
+    {
+#if defined(__linux__)
+        if(block.isMapped)
+            munmap(block.data, block.bytes);
+        else
+#endif
+        if(block.alignment > 0)
+            ::operator delete(block.data, std::align_val_t(block.alignment));
+        else
+            ::operator delete(block.data);
+    }
+    block = Block();
+}
+
+
+size_t QPStorage::getPaddedSize(const size_t& n, const size_t& elementSize, const QPStoragePolicy& policy)
+{
+    if(policy == QPStoragePolicy::Default)
+        return n;
+    return roundUp(n*elementSize, s_alignment)/elementSize;
+}
+
+
+unsigned int QPStorage::getNbHugePageFallbacks()
+{
+    return nbHugePageFallbacks;
+}
+
+
+template<class T>
+QPAlignedBuffer<T>::QPAlignedBuffer(const QPAlignedBuffer& other)
+    : m_policy(other.m_policy)
+{
+    append(other.begin(), other.end());
+}
+
+
+template<class T>
+QPAlignedBuffer<T>::QPAlignedBuffer(QPAlignedBuffer&& other) noexcept
+    : m_block(std::exchange(other.m_block, QPStorage::Block()))
+    , m_size(std::exchange(other.m_size, 0))
+    , m_policy(other.m_policy)
+{
+}
+
+
+template<class T>
+QPAlignedBuffer<T>& QPAlignedBuffer<T>::operator=(const QPAlignedBuffer& other)
+{
+    if(this == &other)
+        return *this;
+    if(m_policy != other.m_policy)
+    {
+        QPStorage::deallocate(m_block);
+        m_policy = other.m_policy;
+    }
+    m_size = 0;
+    append(other.begin(), other.end());
+    return *this;
+}
+
+
+template<class T>
+QPAlignedBuffer<T>& QPAlignedBuffer<T>::operator=(QPAlignedBuffer&& other) noexcept
+{
+    std::swap(m_block, other.m_block);
+    std::swap(m_size, other.m_size);
+    std::swap(m_policy, other.m_policy);
+    return *this;
+}
+
+
+template<class T>
+void QPAlignedBuffer<T>::setPolicy(const QPStoragePolicy& policy)
+{
+    if(policy == m_policy)
+        return;
+    if(m_block.data)
+        reallocate(capacity(), policy);
+    m_policy = policy;
+}
+
+
+template<class T>
+void QPAlignedBuffer<T>::reserve(const size_t& capacity)
+{
+    if(capacity > this->capacity())
+        reallocate(capacity, m_policy);
+}
+
+
+template<class T>
+void QPAlignedBuffer<T>::resize(const size_t& size)
+{
+    if(size > m_size)
+    {
+        grow(size);
+        std::fill(data() + m_size, data() + size, T());
+    }
+    m_size = size;
+}
+
+
+template<class T>
+void QPAlignedBuffer<T>::append(const T* first, const T* last)
+{
+    const size_t n = last - first;
+    if(n == 0)
+        return;
+    grow(m_size + n);
+    std::copy(first, last, data() + m_size);
+    m_size += n;
+}
+
+
+template<class T>
+void QPAlignedBuffer<T>::grow(const size_t& size)
+{
+    if(size > capacity())
+        reallocate(std::max(size, 2*capacity()), m_policy);
+}
+
+
+template<class T>
+void QPAlignedBuffer<T>::reallocate(const size_t& capacity, const QPStoragePolicy& policy)
+{
+    QPStorage::Block block = QPStorage::allocate(capacity*sizeof(T), policy);
+    if(m_size > 0)
+        std::memcpy(block.data, m_block.data, m_size*sizeof(T));
+    QPStorage::deallocate(m_block);
+    m_block = block;
+}
+
+// The double buffers hold the QP matrices and the compliance, the float ones its mixed precision copy
+template class SOFA_SOFTROBOTS_INVERSE_API QPAlignedBuffer<double>;
+template class SOFA_SOFTROBOTS_INVERSE_API QPAlignedBuffer<float>;
+
+} // namespace
@@ -0,0 +1,130 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include <SoftRobots.Inverse/component/config.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+/// Allocation of the large dense buffers of the solver (QP matrices, [A; Aeq] given to qpOASES, gathered
+/// block of the compliance):
+///  - Default: operator new, as a std::vector
+///  - Aligned: on 64 bytes (a cache line, an AVX-512 register), the matrices read by rows having their rows
+///    padded to a multiple of 64 bytes when their layout allows it, so that no row straddles two lines
+///  - TransparentHugePages: Aligned, the buffers of at least a huge page (2 MB) are aligned on a huge page
+///    and advised to the kernel for transparent huge pages (madvise, Linux only)
+///  - HugePages: Aligned, the buffers of at least a huge page are mapped on the reserved huge pages (mmap
+///    MAP_HUGETLB, Linux only), TransparentHugePages when none is available
+/// The huge pages reduce the TLB misses of the sweeps over matrices of hundreds of MB.
+enum class QPStoragePolicy {Default, Aligned, TransparentHugePages, HugePages};
+
+struct SOFA_SOFTROBOTS_INVERSE_API QPStorage
+{
+    static constexpr size_t s_alignment = 64;
+    static constexpr size_t s_hugePageSize = size_t(1)<<21;
+
+    struct Block{
+        void* data{nullptr};
+        size_t bytes{0};
+        size_t alignment{0}; // 0 for operator new without alignment
+        bool isMapped{false};
+    };
+
+    /// Policy of the name ("Default", "Aligned", "TransparentHugePages", "HugePages"), false if unknown
+    static bool getPolicy(const std::string& name, QPStoragePolicy& policy);
+
+    static Block allocate(const size_t& bytes, const QPStoragePolicy& policy);
+    static void deallocate(Block& block);
+
+    /// Number of elements of a row of n elements, padded to a multiple of the alignment but for Default
+    static size_t getPaddedSize(const size_t& n, const size_t& elementSize, const QPStoragePolicy& policy);
+
+    /// Number of allocations with HugePages that fell back to transparent huge pages, for all the buffers
+    static unsigned int getNbHugePageFallbacks();
+};
+
+
+/// Growable buffer of trivially copyable values, allocated with a storage policy. Used instead of a vector
+/// for the buffers given to the dense kernels (the interface is the part of std::vector they need).
+/// Clearing the buffer keeps the allocated memory, a new policy reallocates it with the values kept.
+template<class T>
+class QPAlignedBuffer
+{
+public:
+    QPAlignedBuffer() = default;
+    QPAlignedBuffer(const QPAlignedBuffer& other);
+    QPAlignedBuffer(QPAlignedBuffer&& other) noexcept;
+    QPAlignedBuffer& operator=(const QPAlignedBuffer& other);
+    QPAlignedBuffer& operator=(QPAlignedBuffer&& other) noexcept;
+    ~QPAlignedBuffer() {QPStorage::deallocate(m_block);}
+
+    void setPolicy(const QPStoragePolicy& policy);
+    const QPStoragePolicy& getPolicy() const {return m_policy;}
+
+    size_t size() const {return m_size;}
+    size_t capacity() const {return m_block.bytes/sizeof(T);}
+    bool empty() const {return m_size==0;}
+
+    T* data() {return static_cast<T*>(m_block.data);}
+    const T* data() const {return static_cast<const T*>(m_block.data);}
+    T* begin() {return data();}
+    const T* begin() const {return data();}
+    T* end() {return data() + m_size;}
+    const T* end() const {return data() + m_size;}
+    T& operator[](const size_t& i) {return data()[i];}
+    const T& operator[](const size_t& i) const {return data()[i];}
+
+    void clear() {m_size = 0;}
+    void reserve(const size_t& capacity);
+    /// New values are zero, as with std::vector
+    void resize(const size_t& size);
+    void append(const T* first, const T* last);
+
+protected:
+    void reallocate(const size_t& capacity, const QPStoragePolicy& policy);
+    void grow(const size_t& size); // Geometric growth, at least size
+
+    QPStorage::Block m_block;
+    size_t m_size{0};
+    QPStoragePolicy m_policy{QPStoragePolicy::Default};
+};
+
+// Declares template as extern to avoid the code generation of the template for
+// each compilation unit. see: http://www.stroustrup.com/C++11FAQ.html#extern-templates
+#if !defined(SOFTROBOTS_INVERSE_QPALIGNEDBUFFER_CPP)
+extern template class SOFA_SOFTROBOTS_INVERSE_API QPAlignedBuffer<double>;
+extern template class SOFA_SOFTROBOTS_INVERSE_API QPAlignedBuffer<float>;
+#endif
+
+} // namespace
@@ -0,0 +1,190 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#include <SoftRobots.Inverse/component/solver/modules/QPBackendSelector.h>
+
+#include <algorithm>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+using std::string;
+
+namespace
+{
+// Measured on a desktop CPU with the benchmark backendCostModel, see setCostModel()
+const double s_defaultCoefficients[2*QPBackendSelector::NbBackends] = {1., 1e-3,    // Interior
+                                                                       0.5, 1e-3,   // SmallKernel
+                                                                       5., 2e-3,    // ActiveSet
+                                                                       20., 1e-3};  // ADMM
+const double s_priorSuccessRates[QPBackendSelector::NbBackends] = {0.5, 0.9, 1., 0.9};
+const double s_defaultIterations[QPBackendSelector::NbBackends] = {1., 1., -1., 50.}; // -1: the dimension
+const double s_outcomeWeight = 0.3; // of the last outcome in the moving averages
+const double s_priorWeight = 0.02; // pull of the prior at each step a backend is not chosen
+const string s_names[QPBackendSelector::NbBackends] = {"Interior", "SmallKernel", "ActiveSet", "ADMM"};
+}
+
+
+QPBackendSelector::QPBackendSelector()
+{
+    std::copy(s_defaultCoefficients, s_defaultCoefficients + 2*NbBackends, m_coefficients);
+    clear();
+}
+
+
+bool QPBackendSelector::setCostModel(const sofa::type::vector<double>& coefficients)
+{
+    if(coefficients.empty())
+        std::copy(s_defaultCoefficients, s_defaultCoefficients + 2*NbBackends, m_coefficients);
+    else if(coefficients.size() != 2*NbBackends)
+        return false;
+    else
+        std::copy(coefficients.begin(), coefficients.end(), m_coefficients);
+    return true;
+}
+
+
+void QPBackendSelector::clear()
+{
+    std::copy(s_priorSuccessRates, s_priorSuccessRates + NbBackends, m_successRates);
+    std::fill(m_iterations, m_iterations + NbBackends, -1.);
+    m_decision = Decision();
+    m_hasDecision = false;
+}
+
+
+const string& QPBackendSelector::getName(const Backend& backend)
+{
+    return s_names[backend];
+}
+
+
+double QPBackendSelector::getWork(const Backend& backend, const Features& features, const double& nbIterations)
+{
+    const double n = features.dim;
+    const double constraints = features.nbConstraints*n*features.density; // product by the constraint rows
+    switch(backend)
+    {
+    // One LDLT factorization of Q, and the check of the constraints
+    case Interior:
+        return n*n*n/3. + n*n + constraints;
+    // Dense factorizations of the reduced problem at each working set change
+    case SmallKernel:
+        return nbIterations*(n + features.nbConstraints)*n*n;
+    // Factorization of the hot start, then an update of it per working set change
+    case ActiveSet:
+        return n*n*n/3. + nbIterations*(n*n + constraints);
+    // Factorization of Q + rho A^T A, then a solve and two products by A per iteration
+    case ADMM:
+        return n*n*n/3. + n*constraints + nbIterations*(n*n + 2.*constraints);
+    default:
+        return 0.;
+    }
+}
+
+
+double QPBackendSelector::getPredictedCost(const Backend& backend, const Features& features) const
+{
+    double nbIterations = m_iterations[backend];
+    if(nbIterations < 0.)
+        nbIterations = (s_defaultIterations[backend] < 0.)? features.dim + features.nbConstraints : s_defaultIterations[backend];
+    return m_coefficients[2*backend] + m_coefficients[2*backend+1]*getWork(backend, features, nbIterations);
+}
+
+
+bool QPBackendSelector::isSupported(const Backend& backend, const Features& features) const
+{
+    switch(backend)
+    {
+    case Interior:
+        return features.nbEqualities == 0 && features.dim > 0;
+    case SmallKernel:
+        return features.isSmallProblem;
+    case ADMM:
+        return features.isADMMAvailable;
+    default:
+        return true;
+    }
+}
+
+
+const QPBackendSelector::Decision& QPBackendSelector::select(const Features& features)
+{
+    const Backend previous = m_decision.backend;
+    m_decision.features = features;
+
+    // The active set is the last resort, the other methods fall back on it, the interior solution on the best
+    // of the other ones
+    const double activeSetCost = getPredictedCost(ActiveSet, features);
+    m_decision.costs[ActiveSet] = activeSetCost;
+    Backend best = ActiveSet;
+    for(Backend backend : {SmallKernel, ADMM})
+    {
+        m_decision.costs[backend] = -1.;
+        if(!isSupported(backend, features))
+            continue;
+        m_decision.costs[backend] = getPredictedCost(backend, features) + (1. - getSuccessRate(backend))*activeSetCost;
+        if(m_decision.costs[backend] < m_decision.costs[best])
+            best = backend;
+    }
+
+    m_decision.backend = best;
+    m_decision.fallback = ActiveSet;
+    m_decision.costs[Interior] = -1.;
+    if(isSupported(Interior, features))
+    {
+        m_decision.costs[Interior] = getPredictedCost(Interior, features) + (1. - getSuccessRate(Interior))*m_decision.costs[best];
+        if(m_decision.costs[Interior] < m_decision.costs[best])
+        {
+            m_decision.backend = Interior;
+            m_decision.fallback = best;
+        }
+    }
+
+    for(unsigned int b=0; b<NbBackends; b++)
+        if(b != (unsigned int)m_decision.backend)
+            m_successRates[b] += s_priorWeight*(s_priorSuccessRates[b] - m_successRates[b]);
+
+    m_decision.hasChanged = !m_hasDecision || m_decision.backend != previous;
+    m_hasDecision = true;
+    return m_decision;
+}
+
+
+void QPBackendSelector::setOutcome(const Backend& backend, const bool& solved, const int& nbIterations)
+{
+    m_successRates[backend] += s_outcomeWeight*((solved? 1. : 0.) - m_successRates[backend]);
+    if(!solved)
+        return;
+
+    const double iterations = std::max(nbIterations, 1);
+    m_iterations[backend] = (m_iterations[backend] < 0.)? iterations : m_iterations[backend] + s_outcomeWeight*(iterations - m_iterations[backend]);
+}
+
+} // namespace
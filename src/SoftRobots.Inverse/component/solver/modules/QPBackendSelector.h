@@ -0,0 +1,102 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <string>
+#include <sofa/type/vector.h>
+
+#include <SoftRobots.Inverse/component/config.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+/// Choice of the method solving the QP of a step, from cheap features of the problem (size, density of the
+/// constraints, contacts) and the outcome of the previous steps. The predicted time of a method is a + b*work
+/// (in microseconds), work being its flop estimate for the features and the moving average of its last
+/// iteration counts, with coefficients {a, b} calibrated by the benchmark backendCostModel. The methods that can
+/// fail (no interior minimizer, kernel or ADMM not converged) add the time of their fallback, weighted by their
+/// failure rate, a moving average of their last outcomes pulled back towards a prior while they are not chosen.
+class SOFA_SOFTROBOTS_INVERSE_API QPBackendSelector
+{
+public:
+    enum Backend {Interior, SmallKernel, ActiveSet, ADMM, NbBackends};
+
+    struct Features {
+        int dim{0};
+        int nbConstraints{0}; // inequality and equality rows
+        int nbEqualities{0};
+        double density{1.}; // fraction of non-zero entries of the constraint rows
+        int nbContacts{0};
+        bool isSmallProblem{false}; // supported by the fixed-size kernel
+        bool isADMMAvailable{false};
+    };
+
+    struct Decision {
+        Features features;
+        Backend backend{ActiveSet};
+        Backend fallback{ActiveSet}; // tried when the backend fails, before the active set
+        double costs[NbBackends]{}; // expected time in microseconds, negative for the unsupported methods
+        bool hasChanged{false}; // the backend differs from the previous decision
+    };
+
+    QPBackendSelector();
+
+    /// {a, b} of each backend in the order of Backend, as printed by the benchmark backendCostModel.
+    /// Returns false, and keeps the current model, if the size is not 2*NbBackends. Empty for the default model.
+    bool setCostModel(const sofa::type::vector<double>& coefficients);
+    const double* getCostModel() const {return m_coefficients;}
+
+    /// Flop estimate of the backend for the features, with the given number of iterations
+    static double getWork(const Backend& backend, const Features& features, const double& nbIterations);
+    /// Predicted time of the backend in microseconds, from its last iteration counts
+    double getPredictedCost(const Backend& backend, const Features& features) const;
+
+    const Decision& select(const Features& features);
+    /// Outcome of a backend chosen by select(), as its fallback or not
+    void setOutcome(const Backend& backend, const bool& solved, const int& nbIterations);
+
+    const Decision& getDecision() const {return m_decision;}
+    static const std::string& getName(const Backend& backend);
+
+    /// Forgets the outcomes of the previous steps
+    void clear();
+
+protected:
+    double m_coefficients[2*NbBackends];
+    double m_successRates[NbBackends];
+    double m_iterations[NbBackends]; // moving average, negative until a first resolution
+    Decision m_decision;
+    bool m_hasDecision{false};
+
+    bool isSupported(const Backend& backend, const Features& features) const;
+    double getSuccessRate(const Backend& backend) const {return m_successRates[backend];}
+};
+
+} // namespace
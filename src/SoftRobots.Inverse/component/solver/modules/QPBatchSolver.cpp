@@ -0,0 +1,63 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#include <sofa/simulation/MainTaskSchedulerFactory.h>
+
+#include <SoftRobots.Inverse/component/solver/modules/QPBatchSolver.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+void QPBatchSolver::solve(const vector<QPInverseProblemImpl*>& problems)
+{
+    const unsigned int nbProblems = problems.size();
+    m_objectives.assign(nbProblems, 0.);
+    m_iterations.assign(nbProblems, 0);
+
+    if(!m_multithreading || nbProblems < 2)
+    {
+        for(unsigned int i=0; i<nbProblems; i++)
+            problems[i]->solve(m_objectives[i], m_iterations[i]);
+        return;
+    }
+
+    sofa::simulation::TaskScheduler* taskScheduler = sofa::simulation::MainTaskSchedulerFactory::createInRegistry();
+    sofa::simulation::CpuTask::Status status;
+
+    vector<SolveTask> tasks;
+    tasks.resize(nbProblems, SolveTask(&status));
+    for(unsigned int i=0; i<nbProblems; i++)
+    {
+        tasks[i].set(problems[i], &m_objectives[i], &m_iterations[i]);
+        taskScheduler->addTask(&tasks[i]);
+    }
+    taskScheduler->workUntilDone(&status);
+}
+
+} // namespace
@@ -0,0 +1,96 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <sofa/type/vector.h>
+#include <sofa/simulation/TaskScheduler.h>
+
+#include <SoftRobots.Inverse/component/solver/modules/QPInverseProblemImpl.h>
+#include <SoftRobots.Inverse/component/config.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+using sofa::type::vector;
+
+/// Solves a batch of independent constraint problems, e.g. the instances of a same robot simulated with
+/// different parameters for a calibration, or the subproblems of a scene split by QPProblemDecomposition.
+///
+/// Each problem keeps its own workspace and resolution state (hot started QPs, LCP solvers, contact
+/// states), so that the problems are solved concurrently on the task scheduler without sharing any
+/// buffer, and each one is hot started from its own previous resolution, as when solved alone. The
+/// batch can be called outside of a scene: the problems only need their compliance, free violation
+/// and row lists to be set (see QPInverseProblem::clear() and getQPConstraintLists()).
+class SOFA_SOFTROBOTS_INVERSE_API QPBatchSolver
+{
+public:
+    QPBatchSolver() {}
+    ~QPBatchSolver() {}
+
+    /// If true, the problems are solved on the task scheduler, which has to be initialized
+    void setMultithreading(const bool& multithreading) {m_multithreading = multithreading;}
+
+    /// Solves each problem as QPInverseProblemImpl::solve() does, and keeps their objectives and iterations
+    void solve(const vector<QPInverseProblemImpl*>& problems);
+
+    /// Objective and iterations of each problem of the last batch
+    const vector<double>& getObjectives() const {return m_objectives;}
+    const vector<int>& getIterations() const {return m_iterations;}
+
+protected:
+    bool m_multithreading{false};
+    vector<double> m_objectives;
+    vector<int> m_iterations;
+
+    class SolveTask : public sofa::simulation::CpuTask
+    {
+    public:
+        SolveTask(sofa::simulation::CpuTask::Status* status): CpuTask(status) {}
+        ~SolveTask() override {}
+
+        MemoryAlloc run() final {
+            problem->solve(*objective, *iterations);
+            return MemoryAlloc::Stack;
+        }
+
+        void set(QPInverseProblemImpl* _problem, double* _objective, int* _iterations){
+            problem = _problem;
+            objective = _objective;
+            iterations = _iterations;
+        }
+
+    private:
+        QPInverseProblemImpl* problem{nullptr};
+        double* objective{nullptr};
+        int* iterations{nullptr};
+    };
+};
+
+} // namespace
@@ -0,0 +1,52 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#include <SoftRobots.Inverse/component/solver/modules/QPBatchedCompliance.h>
+
+namespace softrobotsinverse::solver::module
+{
+
+void QPBatchedCompliance::setRows(const Index& dim, const sofa::type::vector<bool>* isSkippedRow)
+{
+    m_rows.clear();
+    for(Index i=0; i<dim; i++)
+        if(!isSkippedRow || !(*isSkippedRow)[i])
+            m_rows.push_back(i);
+}
+
+
+bool QPBatchedCompliance::add(behavior::BatchedCompliance* batched,
+                              const sofa::core::ConstraintParams* cParams,
+                              sofa::linearalgebra::BaseMatrix* W) const
+{
+    if(!batched || m_rows.empty())
+        return false;
+    return batched->addBatchedCompliance(cParams, W, m_rows);
+}
+
+} // namespace
@@ -0,0 +1,64 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <sofa/core/ConstraintParams.h>
+#include <sofa/linearalgebra/BaseMatrix.h>
+#include <sofa/type/vector.h>
+
+#include <SoftRobots.Inverse/component/behavior/BatchedCompliance.h>
+#include <SoftRobots.Inverse/component/config.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+/// Block of rows of the compliance passed at once to the constraint corrections that batch their
+/// contribution (see behavior::BatchedCompliance). The block is set once per step, and shared by the
+/// constraint corrections, also when they are computed concurrently.
+class SOFA_SOFTROBOTS_INVERSE_API QPBatchedCompliance
+{
+public:
+    typedef sofa::linearalgebra::BaseMatrix::Index Index;
+
+    /// The rows [0, dim) of the system, without the skipped ones (e.g. the lazy sensors)
+    void setRows(const Index& dim, const sofa::type::vector<bool>* isSkippedRow);
+    const sofa::type::vector<unsigned int>& getRows() const {return m_rows;}
+
+    /// Adds the contribution of the constraint correction to W as one block. Returns false if it does not
+    /// batch (batched is null) or refused the block, its contribution is then to be added row by row.
+    bool add(behavior::BatchedCompliance* batched,
+             const sofa::core::ConstraintParams* cParams,
+             sofa::linearalgebra::BaseMatrix* W) const;
+
+protected:
+    sofa::type::vector<unsigned int> m_rows;
+};
+
+} // namespace
@@ -0,0 +1,241 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#include <algorithm>
+
+#include <sofa/simulation/MainTaskSchedulerFactory.h>
+
+#include <SoftRobots.Inverse/component/solver/modules/QPBorderedFactorization.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+bool QPBorderedFactorization::compute(const MatrixXd& K)
+{
+    detectBlocks(K);
+    if(m_blocks.empty())
+    {
+        m_full.compute(K);
+        return (m_full.info() == Eigen::Success);
+    }
+
+    const unsigned int nbBlocks = m_blocks.size();
+    if(!m_multithreading)
+    {
+        for(Block& block: m_blocks)
+            block.factorize(K, m_border);
+    }
+    else
+    {
+        sofa::simulation::TaskScheduler* taskScheduler = sofa::simulation::MainTaskSchedulerFactory::createInRegistry();
+        sofa::simulation::CpuTask::Status status;
+
+        vector<FactorizeTask> tasks;
+        tasks.resize(nbBlocks, FactorizeTask(&status));
+        for(unsigned int i=0; i<nbBlocks; i++)
+        {
+            tasks[i].set(&m_blocks[i], &K, &m_border);
+            taskScheduler->addTask(&tasks[i]);
+        }
+        taskScheduler->workUntilDone(&status);
+    }
+
+    for(const Block& block: m_blocks)
+        if(!block.factorized)
+            return false;
+
+    const unsigned int nbBorder = m_border.size();
+    if(nbBorder == 0)
+        return true;
+
+    // Summed in the order of the blocks, the same with or without multithreading
+    MatrixXd S(nbBorder, nbBorder);
+    for(unsigned int a=0; a<nbBorder; a++)
+        for(unsigned int b=0; b<nbBorder; b++)
+            S(a, b) = K(m_border[a], m_border[b]);
+    for(const Block& block: m_blocks)
+        S -= block.schur;
+
+    m_schur.compute(S);
+    return (m_schur.info() == Eigen::Success);
+}
+
+
+void QPBorderedFactorization::Block::factorize(const MatrixXd& K, const vector<int>& border)
+{
+    const unsigned int nbIds = ids.size();
+    const unsigned int nbBorder = border.size();
+
+    MatrixXd Ki(nbIds, nbIds);
+    for(unsigned int a=0; a<nbIds; a++)
+        for(unsigned int b=0; b<nbIds; b++)
+            Ki(a, b) = K(ids[a], ids[b]);
+
+    llt.compute(Ki);
+    factorized = (llt.info() == Eigen::Success);
+    if(!factorized)
+        return;
+
+    Kib.resize(nbIds, nbBorder);
+    for(unsigned int a=0; a<nbIds; a++)
+        for(unsigned int b=0; b<nbBorder; b++)
+            Kib(a, b) = K(ids[a], border[b]);
+
+    X = llt.solve(Kib);
+    schur.noalias() = Kib.transpose()*X;
+}
+
+
+QPBorderedFactorization::VectorXd QPBorderedFactorization::solve(const VectorXd& b) const
+{
+    if(m_blocks.empty())
+        return m_full.solve(b);
+
+    const unsigned int nbBorder = m_border.size();
+    VectorXd x(b.size());
+    VectorXd rb(nbBorder);
+    for(unsigned int a=0; a<nbBorder; a++)
+        rb[a] = b[m_border[a]];
+
+    // Eliminates the blocks: y_i = K_i^-1 b_i, rb = b_b - sum K_bi y_i
+    for(const Block& block: m_blocks)
+    {
+        const unsigned int nbIds = block.ids.size();
+        VectorXd bi(nbIds);
+        for(unsigned int a=0; a<nbIds; a++)
+            bi[a] = b[block.ids[a]];
+
+        const VectorXd yi = block.llt.solve(bi);
+        if(nbBorder > 0)
+            rb.noalias() -= block.Kib.transpose()*yi;
+        for(unsigned int a=0; a<nbIds; a++)
+            x[block.ids[a]] = yi[a];
+    }
+
+    if(nbBorder == 0)
+        return x;
+
+    // Border, then back substitution x_i = y_i - K_i^-1 K_ib x_b
+    const VectorXd xb = m_schur.solve(rb);
+    for(unsigned int a=0; a<nbBorder; a++)
+        x[m_border[a]] = xb[a];
+
+    for(const Block& block: m_blocks)
+    {
+        const VectorXd correction = block.X*xb;
+        for(unsigned int a=0; a<block.ids.size(); a++)
+            x[block.ids[a]] -= correction[a];
+    }
+
+    return x;
+}
+
+
+int QPBorderedFactorization::find(int i)
+{
+    while(m_parent[i] != i)
+    {
+        m_parent[i] = m_parent[m_parent[i]];
+        i = m_parent[i];
+    }
+    return i;
+}
+
+
+void QPBorderedFactorization::detectBlocks(const MatrixXd& K)
+{
+    const int n = K.rows();
+    const int first = n - std::min<int>(m_borderSize, n);
+
+    m_isBorder.assign(n, false);
+    for(int i=first; i<n; i++)
+        m_isBorder[i] = true;
+
+    // The variables coupled with most of the others would join all the blocks
+    for(int i=0; i<first; i++)
+    {
+        int nbCoupled = 0;
+        for(int j=0; j<n; j++)
+            if(j != i && K(i, j) != 0.)
+                nbCoupled++;
+        if(n > 2 && 2*nbCoupled > n-1)
+            m_isBorder[i] = true;
+    }
+
+    m_parent.resize(n);
+    for(int i=0; i<n; i++)
+        m_parent[i] = i;
+
+    for(int i=0; i<n; i++)
+    {
+        if(m_isBorder[i])
+            continue;
+        for(int j=i+1; j<n; j++)
+            if(!m_isBorder[j] && K(i, j) != 0.)
+            {
+                const int ri = find(i);
+                const int rj = find(j);
+                if(ri != rj)
+                    m_parent[std::max(ri, rj)] = std::min(ri, rj);
+            }
+    }
+
+    m_border.clear();
+    m_blockId.assign(n, -1);
+    unsigned int nbBlocks = 0;
+    for(int i=0; i<n; i++)
+    {
+        if(m_isBorder[i])
+        {
+            m_border.push_back(i);
+            continue;
+        }
+        const int root = find(i);
+        if(m_blockId[root] < 0)
+            m_blockId[root] = nbBlocks++;
+        m_blockId[i] = m_blockId[root];
+    }
+
+    if(nbBlocks < 2)
+    {
+        m_blocks.clear();
+        m_border.clear();
+        return;
+    }
+
+    // The blocks are kept across the resolutions, with their buffers
+    m_blocks.resize(nbBlocks);
+    for(Block& block: m_blocks)
+        block.ids.clear();
+    for(int i=0; i<n; i++)
+        if(!m_isBorder[i])
+            m_blocks[m_blockId[i]].ids.push_back(i);
+}
+
+} // namespace
@@ -0,0 +1,130 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <Eigen/Core>
+#include <Eigen/Cholesky>
+#include <sofa/type/vector.h>
+#include <sofa/simulation/TaskScheduler.h>
+
+#include <SoftRobots.Inverse/component/config.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+using sofa::type::vector;
+
+/// Cholesky factorization of a symmetric positive definite matrix K with a bordered block-diagonal
+/// (arrowhead) structure, e.g. the system of a gripper whose fingers are only coupled through the
+/// contacts with the grasped object:
+///     K = [K_1            K_1b]
+///         [     ...       ... ]
+///         [          K_n  K_nb]
+///         [K_b1  ... K_bn K_bb]
+/// The border holds the last borderSize variables (the contacts), and the variables coupled with
+/// more than half of the others. The blocks are the connected components of the coupling graph of
+/// the remaining variables. Each block is factorized on its own, concurrently on the task scheduler
+/// if enabled, and eliminated in the Schur complement S = K_bb - sum K_bi K_i^-1 K_ib, so that the
+/// cost grows linearly with the number of blocks instead of cubically with the size of K.
+/// Without at least two blocks, K is factorized as a whole.
+class SOFA_SOFTROBOTS_INVERSE_API QPBorderedFactorization
+{
+public:
+    typedef Eigen::MatrixXd MatrixXd;
+    typedef Eigen::VectorXd VectorXd;
+
+    void setBorderSize(const unsigned int& borderSize) {m_borderSize = borderSize;}
+    void setMultithreading(const bool& multithreading) {m_multithreading = multithreading;}
+
+    /// Detects the structure of K and factorizes it, returns false if K is not positive definite
+    bool compute(const MatrixXd& K);
+
+    /// Solution x of K x = b, with K of the last call to compute()
+    VectorXd solve(const VectorXd& b) const;
+
+    /// True if the last factorization was done by blocks
+    bool isStructured() const {return !m_blocks.empty();}
+    unsigned int getNbBlocks() const {return m_blocks.size();}
+    unsigned int getBorderDimension() const {return m_border.size();}
+
+protected:
+
+    struct Block{
+        vector<int> ids;     // Variables of the block, increasing
+        Eigen::LLT<MatrixXd> llt;
+        MatrixXd Kib;        // Coupling with the border
+        MatrixXd X;          // K_i^-1 K_ib
+        MatrixXd schur;      // K_bi K_i^-1 K_ib
+        bool factorized{false};
+
+        void factorize(const MatrixXd& K, const vector<int>& border);
+    };
+
+    unsigned int m_borderSize{0};
+    bool m_multithreading{false};
+
+    vector<Block> m_blocks;
+    vector<int> m_border;
+    Eigen::LLT<MatrixXd> m_schur;
+    Eigen::LLT<MatrixXd> m_full;
+
+    // Union-find over the variables
+    vector<int> m_parent;
+    vector<bool> m_isBorder;
+    vector<int> m_blockId;
+
+    int find(int i);
+    void detectBlocks(const MatrixXd& K);
+
+    class FactorizeTask : public sofa::simulation::CpuTask
+    {
+    public:
+        FactorizeTask(sofa::simulation::CpuTask::Status* status): CpuTask(status) {}
+        ~FactorizeTask() override {}
+
+        MemoryAlloc run() final {
+            block->factorize(*K, *border);
+            return MemoryAlloc::Stack;
+        }
+
+        void set(Block* _block, const MatrixXd* _K, const vector<int>* _border){
+            block = _block;
+            K = _K;
+            border = _border;
+        }
+
+    private:
+        Block* block{nullptr};
+        const MatrixXd* K{nullptr};
+        const vector<int>* border{nullptr};
+    };
+};
+
+} // namespace
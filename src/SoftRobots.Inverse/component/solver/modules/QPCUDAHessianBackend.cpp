@@ -0,0 +1,201 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#include <algorithm>
+#include <cstring>
+
+#include <sofa/helper/logging/Messaging.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPCUDAHessianBackend.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+QPCUDAHessianBackend::QPCUDAHessianBackend()
+{
+    int nbDevices = 0;
+    if(cudaGetDeviceCount(&nbDevices) != cudaSuccess || nbDevices == 0)
+        return;
+
+    if(cublasCreate(&m_handle) != CUBLAS_STATUS_SUCCESS)
+    {
+        m_handle = nullptr;
+        return;
+    }
+
+    m_isReady = check(cudaStreamCreateWithFlags(&m_copyStream, cudaStreamNonBlocking))
+            && check(cudaStreamCreateWithFlags(&m_computeStream, cudaStreamNonBlocking))
+            && check(cublasSetStream(m_handle, m_computeStream));
+    for(int k=0; k<s_nbChunks && m_isReady; k++)
+        m_isReady = check(cudaEventCreateWithFlags(&m_chunkUploaded[k], cudaEventDisableTiming));
+}
+
+
+QPCUDAHessianBackend::~QPCUDAHessianBackend()
+{
+    releaseBuffers();
+    for(int k=0; k<s_nbChunks; k++)
+        if(m_chunkUploaded[k])
+            cudaEventDestroy(m_chunkUploaded[k]);
+    if(m_copyStream)
+        cudaStreamDestroy(m_copyStream);
+    if(m_computeStream)
+        cudaStreamDestroy(m_computeStream);
+    if(m_handle)
+        cublasDestroy(m_handle);
+}
+
+
+void QPCUDAHessianBackend::computeProduct(int nbEffectors, int nbVariables, const double* Wea, double* Q)
+{
+    const size_t WeaSize = (size_t)nbEffectors*nbVariables;
+    const size_t QSize = (size_t)nbVariables*nbVariables;
+    if(m_isReady && nbVariables >= s_minNbVariables && nbEffectors > 0 && !reserve(WeaSize, QSize))
+    {
+        msg_warning("QPCUDAHessianBackend") << "Cannot allocate the buffers on the GPU, the Hessian is computed on the CPU.";
+        m_isReady = false;
+        releaseBuffers();
+    }
+
+    if(!m_isReady || nbVariables < s_minNbVariables || nbEffectors == 0)
+    {
+        m_cpuBackend.computeProduct(nbEffectors, nbVariables, Wea, Q);
+        return;
+    }
+
+    // In column-major order, the row-major Wea is A = Wea^T (nbVariables x nbEffectors), and Q = A A^T.
+    // The lower triangle of the row-major Q is the upper triangle of the column-major one.
+    const int nbRowsPerChunk = (nbEffectors + s_nbChunks - 1) / s_nbChunks;
+    bool success = true;
+    for(int k=0; k*nbRowsPerChunk<nbEffectors && success; k++)
+    {
+        const int firstRow = k*nbRowsPerChunk;
+        const int nbRows = std::min(nbRowsPerChunk, nbEffectors - firstRow);
+        const size_t offset = (size_t)firstRow*nbVariables;
+        const size_t size = (size_t)nbRows*nbVariables;
+
+        // The copy into the pinned buffer of a chunk overlaps the upload of the previous one
+        std::memcpy(m_hostWea + offset, Wea + offset, size*sizeof(double));
+        const double alpha = 1.;
+        const double beta = (k == 0)? 0. : 1.;
+        success = check(cudaMemcpyAsync(m_deviceWea + offset, m_hostWea + offset, size*sizeof(double),
+                                        cudaMemcpyHostToDevice, m_copyStream))
+                && check(cudaEventRecord(m_chunkUploaded[k], m_copyStream))
+                && check(cudaStreamWaitEvent(m_computeStream, m_chunkUploaded[k], 0))
+                && check(cublasDsyrk(m_handle, CUBLAS_FILL_MODE_UPPER, CUBLAS_OP_N, nbVariables, nbRows,
+                                     &alpha, m_deviceWea + offset, nbVariables, &beta, m_deviceQ, nbVariables));
+    }
+
+    success = success
+            && check(cudaMemcpyAsync(Q, m_deviceQ, QSize*sizeof(double), cudaMemcpyDeviceToHost, m_computeStream))
+            && check(cudaStreamSynchronize(m_computeStream));
+
+    if(!success)
+    {
+        cudaStreamSynchronize(m_copyStream);
+        cudaStreamSynchronize(m_computeStream);
+        msg_warning("QPCUDAHessianBackend") << "The product on the GPU failed, the Hessian is computed on the CPU.";
+        m_isReady = false;
+        releaseBuffers();
+        m_cpuBackend.computeProduct(nbEffectors, nbVariables, Wea, Q);
+    }
+}
+
+
+size_t QPCUDAHessianBackend::getMemoryUsage() const
+{
+    // Pinned host copy of Wea and its device copy, device Q
+    return sizeof(double)*(2*m_WeaCapacity + m_QCapacity);
+}
+
+
+bool QPCUDAHessianBackend::reserve(const size_t& WeaSize, const size_t& QSize)
+{
+    if(WeaSize > m_WeaCapacity)
+    {
+        if(m_hostWea)
+            cudaFreeHost(m_hostWea);
+        if(m_deviceWea)
+            cudaFree(m_deviceWea);
+        m_hostWea = nullptr;
+        m_deviceWea = nullptr;
+        m_WeaCapacity = 0;
+        if(!check(cudaMallocHost((void**)&m_hostWea, WeaSize*sizeof(double)))
+                || !check(cudaMalloc((void**)&m_deviceWea, WeaSize*sizeof(double))))
+            return false;
+        m_WeaCapacity = WeaSize;
+    }
+
+    if(QSize > m_QCapacity)
+    {
+        if(m_deviceQ)
+            cudaFree(m_deviceQ);
+        m_deviceQ = nullptr;
+        m_QCapacity = 0;
+        if(!check(cudaMalloc((void**)&m_deviceQ, QSize*sizeof(double))))
+            return false;
+        m_QCapacity = QSize;
+    }
+    return true;
+}
+
+
+void QPCUDAHessianBackend::releaseBuffers()
+{
+    if(m_hostWea)
+        cudaFreeHost(m_hostWea);
+    if(m_deviceWea)
+        cudaFree(m_deviceWea);
+    if(m_deviceQ)
+        cudaFree(m_deviceQ);
+    m_hostWea = nullptr;
+    m_deviceWea = nullptr;
+    m_deviceQ = nullptr;
+    m_WeaCapacity = 0;
+    m_QCapacity = 0;
+}
+
+
+bool QPCUDAHessianBackend::check(const cudaError_t& error)
+{
+    if(error == cudaSuccess)
+        return true;
+    msg_warning("QPCUDAHessianBackend") << "CUDA error: " << cudaGetErrorString(error);
+    return false;
+}
+
+
+bool QPCUDAHessianBackend::check(const cublasStatus_t& status)
+{
+    if(status == CUBLAS_STATUS_SUCCESS)
+        return true;
+    msg_warning("QPCUDAHessianBackend") << "cuBLAS error " << (int)status;
+    return false;
+}
+
+} // namespace
@@ -0,0 +1,90 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <cublas_v2.h>
+#include <cuda_runtime.h>
+
+#include <sofa/type/vector.h>
+
+#include <SoftRobots.Inverse/component/solver/modules/QPHessianBackend.h>
+#include <SoftRobots.Inverse/component/config.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+/// Q = Wea^T Wea computed by cuBLAS (dsyrk) on the current CUDA device.
+///
+/// Wea is uploaded in chunks of rows on a copy stream, while the rank-k updates of the chunks already
+/// uploaded run on the compute stream, so that the transfers overlap the product. The device and
+/// pinned host buffers are kept across the steps and only reallocated when the problem grows.
+/// Below s_minNbVariables variables, the transfers cost more than the product and Q is computed on
+/// the CPU. If a CUDA call fails, the backend falls back to the CPU for the rest of the run.
+/// Only built with the CMake option SOFTROBOTSINVERSE_WITH_CUDA.
+class SOFA_SOFTROBOTS_INVERSE_API QPCUDAHessianBackend : public QPHessianBackend
+{
+public:
+    QPCUDAHessianBackend();
+    ~QPCUDAHessianBackend() override;
+
+    /// False if no CUDA device or cuBLAS could not be initialized
+    bool isReady() const {return m_isReady;}
+
+    void computeProduct(int nbEffectors, int nbVariables, const double* Wea, double* Q) override;
+
+    std::string getName() const override {return "CUDA";}
+
+    size_t getMemoryUsage() const override;
+
+    static constexpr int s_minNbVariables{128};
+    static constexpr int s_nbChunks{4};
+
+protected:
+    bool m_isReady{false};
+    cublasHandle_t m_handle{nullptr};
+    cudaStream_t m_copyStream{nullptr};
+    cudaStream_t m_computeStream{nullptr};
+    cudaEvent_t m_chunkUploaded[s_nbChunks]{};
+
+    double* m_hostWea{nullptr};   // pinned
+    double* m_deviceWea{nullptr};
+    double* m_deviceQ{nullptr};
+    size_t m_WeaCapacity{0};      // in doubles
+    size_t m_QCapacity{0};
+
+    QPCPUHessianBackend m_cpuBackend;
+
+    bool reserve(const size_t& WeaSize, const size_t& QSize);
+    void releaseBuffers();
+    bool check(const cudaError_t& error);
+    bool check(const cublasStatus_t& status);
+};
+
+} // namespace
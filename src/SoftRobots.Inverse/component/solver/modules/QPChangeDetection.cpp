@@ -0,0 +1,144 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+
+#include <algorithm>
+#include <SoftRobots.Inverse/component/solver/modules/QPChangeDetection.h>
+
+namespace softrobotsinverse::solver::module
+{
+
+bool QPChangeDetection::isUnchanged(QPInverseProblemImpl* problem, const uint64_t& parametersKey)
+{
+    if(!m_isRecorded || parametersKey != m_parametersKey)
+        return false;
+
+    QPConstraintLists* lists = problem->getQPConstraintLists();
+    const unsigned int dim = problem->getDimension();
+    if(dim*dim != m_W.size() || !hasSameRows(*lists))
+        return false;
+
+    const double* dFree = problem->getDfree();
+    for(unsigned int i=0; i<dim; i++)
+        if(!isNear(dFree[i], m_dFree[i]))
+            return false;
+
+    double** W = problem->getW();
+    for(unsigned int i=0; i<dim; i++)
+        for(unsigned int j=0; j<dim; j++)
+            if(!isNear(W[i][j], m_W[i*dim+j]))
+                return false;
+
+    if(!problem->isDetached())
+        lists->updateVariableRows();
+    if(lists->variableRows.size() != m_lists.variableRows.size() || lists->effectorWeights.size() != m_lists.effectorWeights.size()
+            || lists->disabledEffectorRows != m_lists.disabledEffectorRows || lists->effectorRowLevels != m_lists.effectorRowLevels)
+        return false;
+    for(unsigned int k=0; k<lists->variableRows.size(); k++)
+        if(!hasSameLimits(lists->variableRows[k], m_lists.variableRows[k]))
+            return false;
+    for(unsigned int k=0; k<lists->effectorWeights.size(); k++)
+        if(!isNear(lists->effectorWeights[k], m_lists.effectorWeights[k]))
+            return false;
+
+    return true;
+}
+
+
+void QPChangeDetection::record(QPInverseProblemImpl* problem, const double& objective, const uint64_t& parametersKey)
+{
+    const QPConstraintLists* lists = problem->getQPConstraintLists();
+    const unsigned int dim = problem->getDimension();
+
+    m_lists = *lists;
+    m_dFree.assign(problem->getDfree(), problem->getDfree() + dim);
+    m_W.resize(dim*dim);
+    double** W = problem->getW();
+    for(unsigned int i=0; i<dim; i++)
+        std::copy(W[i], W[i] + dim, m_W.begin() + i*dim);
+    m_lambda = problem->getQPSystem()->lambda;
+    m_objective = objective;
+    m_parametersKey = parametersKey;
+    m_isRecorded = true;
+}
+
+
+void QPChangeDetection::reuse(QPInverseProblemImpl* problem, double& objective, int& iterations)
+{
+    problem->reuseSolution(m_lambda);
+    objective = m_objective;
+    iterations = 0; // nothing was solved
+    m_nbSkippedSolves++;
+}
+
+
+void QPChangeDetection::clear()
+{
+    m_isRecorded = false;
+    m_nbSkippedSolves = 0;
+    m_parametersKey = 0;
+    m_lists = QPConstraintLists();
+    m_dFree.clear();
+    m_W.clear();
+    m_lambda.clear();
+}
+
+
+bool QPChangeDetection::hasSameRows(const QPConstraintLists& lists) const
+{
+    return lists.actuatorRowIds == m_lists.actuatorRowIds
+            && lists.effectorRowIds == m_lists.effectorRowIds
+            && lists.equalityRowIds == m_lists.equalityRowIds
+            && lists.sensorRowIds == m_lists.sensorRowIds
+            && lists.contactRowIds == m_lists.contactRowIds
+            && lists.actuators == m_lists.actuators
+            && lists.effectors == m_lists.effectors
+            && lists.equality == m_lists.equality
+            && lists.sensors == m_lists.sensors
+            && lists.contacts == m_lists.contacts
+            && lists.disabledConstraints == m_lists.disabledConstraints;
+}
+
+
+bool QPChangeDetection::hasSameLimits(const QPVariableRow& row, const QPVariableRow& recorded) const
+{
+    if(row.owner != recorded.owner || row.line != recorded.line || row.isDisabled != recorded.isDisabled
+            || row.hasEpsilon != recorded.hasEpsilon || row.hasLambdaMin != recorded.hasLambdaMin
+            || row.hasLambdaMax != recorded.hasLambdaMax || row.hasLambdaEqual != recorded.hasLambdaEqual
+            || row.hasDeltaMin != recorded.hasDeltaMin || row.hasDeltaMax != recorded.hasDeltaMax
+            || row.hasDeltaEqual != recorded.hasDeltaEqual)
+        return false;
+
+    return isNear(row.epsilon, recorded.epsilon)
+            && isNear(row.lambdaMin, recorded.lambdaMin) && isNear(row.lambdaMax, recorded.lambdaMax)
+            && isNear(row.lambdaEqual, recorded.lambdaEqual)
+            && isNear(row.deltaMin, recorded.deltaMin) && isNear(row.deltaMax, recorded.deltaMax)
+            && isNear(row.deltaEqual, recorded.deltaEqual);
+}
+
+} // namespace
@@ -0,0 +1,94 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <sofa/type/vector.h>
+
+#include <SoftRobots.Inverse/component/solver/modules/QPInverseProblemImpl.h>
+#include <SoftRobots.Inverse/component/config.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+using sofa::type::vector;
+
+/// Detection of the steps whose problem did not change, for the quasi-static scenes (e.g. a teleoperation
+/// goal held still while the robot settled). A problem is unchanged when it has the same constraints on the
+/// same rows (so the same contact set), and when dfree (which holds the targets of the effectors), the
+/// compliance and the limits of the variables moved by at most the tolerance since the recorded resolution.
+/// The parameters of the resolution (epsilon, friction, contact forces bounds, QP options...) are given by a
+/// key, any change of the key being a change of the problem. The recorded solution is then reused instead
+/// of solving the problem again.
+class SOFA_SOFTROBOTS_INVERSE_API QPChangeDetection
+{
+public:
+    typedef QPInverseProblem::QPConstraintLists QPConstraintLists;
+    typedef QPInverseProblem::QPVariableRow QPVariableRow;
+
+    /// Largest change of an entry of dfree, of the compliance or of a limit considered as no change
+    void setTolerance(const double& tolerance) {m_tolerance = tolerance;}
+    double getTolerance() const {return m_tolerance;}
+
+    /// Compares the problem with the recorded one. The limits of the variables are first read from the
+    /// constraint components (QPConstraintLists::updateVariableRows) unless the problem is detached.
+    bool isUnchanged(QPInverseProblemImpl* problem, const uint64_t& parametersKey);
+
+    /// Records the problem just solved, with its solution and the key of the parameters it was solved with
+    void record(QPInverseProblemImpl* problem, const double& objective, const uint64_t& parametersKey);
+
+    /// Stores the recorded solution in the problem, as its resolution would, and counts a skipped solve
+    void reuse(QPInverseProblemImpl* problem, double& objective, int& iterations);
+
+    void clear();
+    bool isRecorded() const {return m_isRecorded;}
+
+    /// Number of resolutions skipped since the last clear
+    unsigned int getNbSkippedSolves() const {return m_nbSkippedSolves;}
+
+protected:
+    double m_tolerance{0.};
+    bool m_isRecorded{false};
+    unsigned int m_nbSkippedSolves{0};
+    uint64_t m_parametersKey{0};
+
+    QPConstraintLists m_lists; // constraints, rows and limits of the recorded problem
+    vector<double> m_dFree;
+    vector<double> m_W; // by rows
+    vector<double> m_lambda; // QP variables
+    double m_objective{0.};
+
+    bool isNear(const double& value, const double& recorded) const {return std::abs(value - recorded) <= m_tolerance;}
+    bool hasSameRows(const QPConstraintLists& lists) const;
+    bool hasSameLimits(const QPVariableRow& row, const QPVariableRow& recorded) const;
+};
+
+} // namespace
@@ -0,0 +1,350 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <SoftRobots.Inverse/component/solver/modules/QPCheckpoint.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+const char QPCheckpoint::s_magic[8] = {'S','R','I','Q','P','C','K','P'};
+
+namespace
+{
+
+constexpr uint64_t s_headerSize = 8 + 2*sizeof(uint32_t) + 2*sizeof(uint64_t);
+
+/// FNV-1a hash of the payload, to reject a corrupted checkpoint
+uint64_t getChecksum(const vector<char>& buffer)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for(const char& byte : buffer)
+        hash = (hash ^ (unsigned char)byte) * 0x100000001b3ULL;
+    return hash;
+}
+
+class BufferWriter
+{
+public:
+    BufferWriter(vector<char>& buffer) : m_buffer(buffer) {}
+
+    template<class T>
+    void write(const T& value)
+    {
+        const size_t size = m_buffer.size();
+        m_buffer.resize(size + sizeof(T));
+        std::memcpy(m_buffer.data() + size, &value, sizeof(T));
+    }
+
+    template<class T>
+    void writeVector(const vector<T>& values)
+    {
+        write(uint64_t(values.size()));
+        if(values.empty())
+            return;
+        const size_t size = m_buffer.size();
+        m_buffer.resize(size + values.size()*sizeof(T));
+        std::memcpy(m_buffer.data() + size, values.data(), values.size()*sizeof(T));
+    }
+
+    void writeString(const std::string& value)
+    {
+        write(uint64_t(value.size()));
+        m_buffer.insert(m_buffer.end(), value.begin(), value.end());
+    }
+
+    // Field by field, the padding of the struct is not written
+    void writeEntries(const vector<QPComplianceCache::Entry>& entries)
+    {
+        write(uint64_t(entries.size()));
+        for(const QPComplianceCache::Entry& entry : entries)
+        {
+            write(entry.i);
+            write(entry.j);
+            write(entry.value);
+            write(uint8_t(entry.isSet));
+        }
+    }
+
+protected:
+    vector<char>& m_buffer;
+};
+
+/// Reads the values of the payload, and fails (instead of reading out of the buffer) on a corrupted checkpoint
+class BufferReader
+{
+public:
+    BufferReader(const vector<char>& buffer) : m_buffer(buffer) {}
+
+    bool isValid() const {return m_valid;}
+    bool isAtEnd() const {return m_position == m_buffer.size();}
+
+    template<class T>
+    void read(T& value)
+    {
+        if(!m_valid || m_position + sizeof(T) > m_buffer.size())
+        {
+            m_valid = false;
+            return;
+        }
+        std::memcpy(&value, m_buffer.data() + m_position, sizeof(T));
+        m_position += sizeof(T);
+    }
+
+    /// Number of items of a list, rejected if the items (of at least minItemSize bytes) cannot fit in the buffer
+    uint64_t readSize(const uint64_t& minItemSize)
+    {
+        uint64_t size = 0;
+        read(size);
+        if(m_valid && size > (m_buffer.size() - m_position)/minItemSize)
+            m_valid = false;
+        return (m_valid)? size : 0;
+    }
+
+    template<class T>
+    void readVector(vector<T>& values)
+    {
+        const uint64_t size = readSize(sizeof(T));
+        values.resize(size);
+        if(size == 0)
+            return;
+        std::memcpy(values.data(), m_buffer.data() + m_position, size*sizeof(T));
+        m_position += size*sizeof(T);
+    }
+
+    void readString(std::string& value)
+    {
+        const uint64_t size = readSize(1);
+        value.assign(m_buffer.data() + m_position, size);
+        m_position += size;
+    }
+
+    void readEntries(vector<QPComplianceCache::Entry>& entries)
+    {
+        const uint64_t size = readSize(2*sizeof(QPComplianceCache::Index) + sizeof(SReal) + 1);
+        entries.resize(size);
+        for(QPComplianceCache::Entry& entry : entries)
+        {
+            uint8_t isSet = 0;
+            read(entry.i);
+            read(entry.j);
+            read(entry.value);
+            read(isSet);
+            entry.isSet = (isSet != 0);
+        }
+    }
+
+protected:
+    const vector<char>& m_buffer;
+    size_t m_position{0};
+    bool m_valid{true};
+};
+
+} // namespace
+
+
+void QPCheckpoint::clear()
+{
+    actuatorRowIds.clear();
+    equalityRowIds.clear();
+    lambda.clear();
+    contactStates.clear();
+    activeBounds.clear();
+    activeSets.clear();
+    complianceBlocks.clear();
+}
+
+
+bool QPCheckpoint::write(const std::string& filename) const
+{
+    vector<char> payload;
+    BufferWriter writer(payload);
+
+    writer.writeVector(actuatorRowIds);
+    writer.writeVector(equalityRowIds);
+    writer.writeVector(lambda);
+
+    writer.write(uint64_t(contactStates.size()));
+    for(const ContactState& contact : contactStates)
+    {
+        writer.writeString(contact.constraint);
+        writer.write(int32_t(contact.id));
+        writer.writeString(contact.state);
+    }
+
+    writer.writeVector(activeBounds);
+    writer.write(uint64_t(activeSets.size()));
+    for(const auto& [key, entry] : activeSets)
+    {
+        writer.writeVector(key);
+        writer.writeVector(entry.contactStates);
+        writer.writeVector(entry.x);
+        writer.writeVector(entry.bounds);
+        writer.write(uint64_t(entry.constraints.size()));
+        for(const auto& [row, status] : entry.constraints)
+        {
+            writer.write(int32_t(row.first));
+            writer.write(int32_t(row.second));
+            writer.write(int32_t(status));
+        }
+    }
+
+    writer.write(uint64_t(complianceBlocks.size()));
+    for(const QPComplianceCache::SavedBlock& block : complianceBlocks)
+    {
+        writer.writeString(block.constraintCorrection);
+        writer.write(block.dt);
+        writer.writeEntries(block.jacobian);
+        writer.writeEntries(block.compliance);
+    }
+
+    const std::string temporaryFilename = filename + ".tmp";
+    {
+        std::ofstream file(temporaryFilename, std::ios::binary | std::ios::trunc);
+        if(!file.is_open())
+            return false;
+
+        const uint32_t version = s_version, reserved = 0;
+        const uint64_t size = payload.size(), checksum = getChecksum(payload);
+        file.write(s_magic, 8);
+        file.write(reinterpret_cast<const char*>(&version), sizeof(uint32_t));
+        file.write(reinterpret_cast<const char*>(&reserved), sizeof(uint32_t));
+        file.write(reinterpret_cast<const char*>(&size), sizeof(uint64_t));
+        file.write(reinterpret_cast<const char*>(&checksum), sizeof(uint64_t));
+        file.write(payload.data(), payload.size());
+        file.flush();
+        if(!file.good())
+        {
+            file.close();
+            std::remove(temporaryFilename.c_str());
+            return false;
+        }
+    }
+
+    // Replaces the previous checkpoint at once
+    if(std::rename(temporaryFilename.c_str(), filename.c_str()) != 0)
+    {
+        std::remove(filename.c_str());
+        if(std::rename(temporaryFilename.c_str(), filename.c_str()) != 0)
+        {
+            std::remove(temporaryFilename.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+
+bool QPCheckpoint::read(const std::string& filename)
+{
+    clear();
+
+    std::ifstream file(filename, std::ios::binary);
+    if(!file.is_open())
+        return false;
+
+    file.seekg(0, std::ios::end);
+    const uint64_t fileSize = file.tellg();
+    file.seekg(0, std::ios::beg);
+    if(fileSize < s_headerSize)
+        return false;
+
+    char magic[8];
+    uint32_t version = 0, reserved = 0;
+    uint64_t size = 0, checksum = 0;
+    file.read(magic, 8);
+    file.read(reinterpret_cast<char*>(&version), sizeof(uint32_t));
+    file.read(reinterpret_cast<char*>(&reserved), sizeof(uint32_t));
+    file.read(reinterpret_cast<char*>(&size), sizeof(uint64_t));
+    file.read(reinterpret_cast<char*>(&checksum), sizeof(uint64_t));
+    if(!file.good() || std::memcmp(magic, s_magic, 8) != 0 || version > s_version || size != fileSize - s_headerSize)
+        return false;
+
+    vector<char> payload(size);
+    file.read(payload.data(), size);
+    if(!file.good() || getChecksum(payload) != checksum)
+        return false;
+
+    BufferReader reader(payload);
+    reader.readVector(actuatorRowIds);
+    reader.readVector(equalityRowIds);
+    reader.readVector(lambda);
+
+    contactStates.resize(reader.readSize(2*sizeof(uint64_t) + sizeof(int32_t)));
+    for(ContactState& contact : contactStates)
+    {
+        int32_t id = -1;
+        reader.readString(contact.constraint);
+        reader.read(id);
+        reader.readString(contact.state);
+        contact.id = id;
+    }
+
+    reader.readVector(activeBounds);
+    const uint64_t nbActiveSets = reader.readSize(5*sizeof(uint64_t));
+    for(uint64_t i=0; i<nbActiveSets && reader.isValid(); i++)
+    {
+        activeSets.emplace_back();
+        auto& [key, entry] = activeSets.back();
+        reader.readVector(key);
+        reader.readVector(entry.contactStates);
+        reader.readVector(entry.x);
+        reader.readVector(entry.bounds);
+        const uint64_t nbConstraints = reader.readSize(3*sizeof(int32_t));
+        for(uint64_t j=0; j<nbConstraints && reader.isValid(); j++)
+        {
+            int32_t variable = 0, rank = 0, status = 0;
+            reader.read(variable);
+            reader.read(rank);
+            reader.read(status);
+            entry.constraints[{variable, rank}] = status;
+        }
+    }
+
+    complianceBlocks.resize(reader.readSize(sizeof(uint64_t) + sizeof(double) + 2*sizeof(uint64_t)));
+    for(QPComplianceCache::SavedBlock& block : complianceBlocks)
+    {
+        reader.readString(block.constraintCorrection);
+        reader.read(block.dt);
+        reader.readEntries(block.jacobian);
+        reader.readEntries(block.compliance);
+    }
+
+    if(!reader.isValid() || !reader.isAtEnd())
+    {
+        clear();
+        return false;
+    }
+    return true;
+}
+
+} // namespace
@@ -0,0 +1,88 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <sofa/type/vector.h>
+
+#include <SoftRobots.Inverse/component/solver/modules/QPActiveSetCache.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPComplianceCache.h>
+#include <SoftRobots.Inverse/component/config.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+using sofa::type::vector;
+
+/// Warm-start state of QPInverseProblemSolver, saved in a compact binary checkpoint so that a restarted
+/// process solves its first steps with the state of the last steps of the previous one: the forces of
+/// the actuators and equality constraints, the states of the contacts (by constraint component and
+/// persistent contact id), the working sets of the active set cache, and the cached contributions of
+/// the constraint corrections to the compliance.
+///
+/// The file starts with a header (magic "SRIQPCKP", version, size of the payload), followed by the
+/// payload. Values are stored in the byte order of the machine. A truncated or corrupted file is
+/// rejected by read(), the checkpoint is then left empty.
+struct SOFA_SOFTROBOTS_INVERSE_API QPCheckpoint
+{
+    /// State of a contact point, by path name of its constraint component, persistent id of the contact
+    /// (see QPInverseProblem::QPContactId), and name of its state (see ContactHandler::getStateString())
+    struct ContactState{
+        std::string constraint;
+        int id{-1};
+        std::string state;
+    };
+
+    // Rows of the variables the forces are given for, the forces are only restored in the same rows
+    vector<unsigned int> actuatorRowIds;
+    vector<unsigned int> equalityRowIds;
+    vector<double> lambda; // of the actuators, then of the equality constraints
+
+    vector<ContactState> contactStates;
+    vector<int> activeBounds; // Bounds active at the end of the last step, part of the active set keys
+    QPActiveSetCache::EntryList activeSets; // from the most to the least recently used
+    vector<QPComplianceCache::SavedBlock> complianceBlocks;
+
+    bool isEmpty() const {return lambda.empty() && contactStates.empty() && activeSets.empty() && complianceBlocks.empty();}
+    void clear();
+
+    /// Writes the checkpoint to a temporary file renamed into filename, so that a process stopped while
+    /// writing leaves the previous checkpoint. Returns false if the file cannot be written.
+    bool write(const std::string& filename) const;
+    /// Returns false if the file does not exist or is not a valid checkpoint
+    bool read(const std::string& filename);
+
+    static const char s_magic[8];
+    static constexpr uint32_t s_version{1};
+};
+
+} // namespace
@@ -0,0 +1,348 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <list>
+
+#include <sofa/core/behavior/BaseMechanicalState.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPComplianceCache.h>
+
+namespace softrobotsinverse::solver::module
+{
+
+using sofa::type::vector;
+using sofa::linearalgebra::BaseMatrix;
+using sofa::core::behavior::BaseConstraintCorrection;
+using sofa::core::behavior::BaseMechanicalState;
+
+QPComplianceCache::Recorder::Recorder(BaseMatrix* W, vector<Entry>* entries)
+    : m_W(W)
+    , m_entries(entries)
+{
+}
+
+
+void QPComplianceCache::Recorder::resize(Index nbRow, Index nbCol)
+{
+    if(m_W)
+        m_W->resize(nbRow, nbCol);
+    m_nbRows = nbRow;
+    m_nbCols = nbCol;
+}
+
+
+void QPComplianceCache::Recorder::clear()
+{
+    if(m_W)
+        m_W->clear();
+}
+
+
+void QPComplianceCache::Recorder::set(Index i, Index j, double v)
+{
+    if(m_W)
+        m_W->set(i,j,v);
+    if(m_entries)
+        m_entries->push_back({i, j, v, true});
+}
+
+
+void QPComplianceCache::Recorder::add(Index i, Index j, double v)
+{
+    if(m_W)
+        m_W->add(i,j,v);
+    if(m_entries)
+        m_entries->push_back({i, j, v, false});
+}
+
+
+QPComplianceCache::Action QPComplianceCache::update(const unsigned int& i,
+                                                    BaseConstraintCorrection* cc,
+                                                    const sofa::core::ConstraintParams* cParams,
+                                                    const bool& allowSplice)
+{
+    if(m_blocks.size() <= i)
+        m_blocks.resize(i+1);
+
+    Block& block = m_blocks[i];
+    if(!block.cc && !block.restoredName.empty() && block.restoredName == cc->getPathName())
+    {
+        block.cc = cc;
+        block.restoredName.clear();
+    }
+    if(block.cc != cc)
+    {
+        block = Block();
+        block.cc = cc;
+    }
+
+    BaseMechanicalState* mstate = cc->getContext()->getMechanicalState();
+    block.isCached = (mstate != nullptr);
+    if(!block.isCached)
+    {
+        block.isValid = false;
+        return Action::Compute;
+    }
+
+    // Jacobian of the mechanical state, as seen by the constraint correction
+    m_jacobian.clear();
+    Recorder J(nullptr, &m_jacobian);
+    unsigned int offset = 0;
+    mstate->getConstraintJacobian(cParams, &J, offset);
+    std::sort(m_jacobian.begin(), m_jacobian.end(),
+              [](const Entry& a, const Entry& b){return a.i<b.i || (a.i==b.i && a.j<b.j);});
+
+    const double dt = cc->getContext()->getDt();
+    compareRows(block.jacobian, m_jacobian, block);
+    const bool isCompatible = block.isValid && block.version == m_version && block.dt == dt;
+    if(isCompatible && block.nbChangedRows == 0)
+    {
+        m_nbReuses++;
+        return Action::Replay;
+    }
+
+    block.jacobian.swap(m_jacobian);
+    block.version = m_version;
+    block.dt = dt;
+    block.isValid = true;
+
+    // The blocks between the unchanged rows are kept, only the changed rows will be computed
+    if(isCompatible && allowSplice && 2*block.changedRows.size() <= block.rows.size())
+        return Action::Splice;
+
+    // The contribution is computed again, and recorded from the new Jacobian
+    block.compliance.clear();
+    return Action::Compute;
+}
+
+
+bool QPComplianceCache::splice(const unsigned int& i,
+                               BaseConstraintCorrection* cc,
+                               const Index& dim)
+{
+    Block& block = m_blocks[i];
+
+    // Rows and columns of the changed rows, W(:,k) being the constraint displacements due to a unit force
+    // on the row k. The unbuilt resolution only gives it to a factor of the compliance of the built one,
+    // so each column is scaled by the diagonal compliance of its row.
+    m_columns.clear();
+    if(!block.changedRows.empty())
+    {
+        m_force.assign(dim, 0.);
+        m_dforce.assign(dim, 0.);
+        m_displacement.resize(dim);
+        m_isChangedRow.assign(dim, false);
+        for(Index k : block.changedRows)
+            m_isChangedRow[k] = true;
+
+        std::list<unsigned int> renumbering;
+        cc->resetForUnbuiltResolution(m_force.data(), renumbering);
+        bool isComputed = true;
+        for(Index k : block.changedRows)
+        {
+            m_dforce[k] = 1.;
+            cc->setConstraintDForce(m_dforce.data(), k, k, true);
+            for(Index r : block.rows)
+            {
+                m_displacement[r] = 0.;
+                cc->addConstraintDisplacement(m_displacement.data(), r, r);
+            }
+            m_dforce[k] = -1.;
+            cc->setConstraintDForce(m_dforce.data(), k, k, true);
+            m_dforce[k] = 0.;
+
+            m_diagonal.clear();
+            Recorder D(nullptr, &m_diagonal);
+            cc->getBlockDiagonalCompliance(&D, k, k);
+            SReal Wkk = 0.;
+            for(const Entry& entry : m_diagonal)
+                if(entry.i == k && entry.j == k)
+                    Wkk += entry.value;
+
+            if(std::abs(m_displacement[k]) < 1e-20 || Wkk == 0.)
+            {
+                isComputed = false;
+                break;
+            }
+
+            const SReal scale = Wkk / m_displacement[k];
+            for(Index r : block.rows)
+            {
+                const SReal value = (r == k)? Wkk : scale*m_displacement[r];
+                m_columns.push_back({r, k, value, false});
+                if(!m_isChangedRow[r])
+                    m_columns.push_back({k, r, value, false}); // symmetric
+            }
+        }
+        cc->resetContactForce();
+
+        if(!isComputed)
+        {
+            block.compliance.clear();
+            return false;
+        }
+    }
+
+    // Entries of the changed and removed rows are replaced by the new columns
+    Index maxRow = dim;
+    for(Index r : block.removedRows)
+        maxRow = std::max(maxRow, r+1);
+    m_isChangedRow.assign(maxRow, false);
+    for(Index k : block.changedRows)
+        m_isChangedRow[k] = true;
+    for(Index k : block.removedRows)
+        m_isChangedRow[k] = true;
+
+    auto isChanged = [this](const Entry& entry){
+        return entry.i >= (Index)m_isChangedRow.size() || entry.j >= (Index)m_isChangedRow.size()
+                || m_isChangedRow[entry.i] || m_isChangedRow[entry.j];
+    };
+    block.compliance.erase(std::remove_if(block.compliance.begin(), block.compliance.end(), isChanged),
+                           block.compliance.end());
+    block.compliance.insert(block.compliance.end(), m_columns.begin(), m_columns.end());
+    m_nbSplices++;
+    return true;
+}
+
+
+vector<QPComplianceCache::Entry>* QPComplianceCache::getEntries(const unsigned int& i)
+{
+    if(i >= m_blocks.size() || !m_blocks[i].isCached)
+        return nullptr;
+    return &m_blocks[i].compliance;
+}
+
+
+void QPComplianceCache::replay(const unsigned int& i, BaseMatrix* W) const
+{
+    if(i >= m_blocks.size())
+        return;
+
+    for(const Entry& entry : m_blocks[i].compliance)
+    {
+        if(entry.isSet)
+            W->set(entry.i, entry.j, entry.value);
+        else
+            W->add(entry.i, entry.j, entry.value);
+    }
+}
+
+
+void QPComplianceCache::clear()
+{
+    m_blocks.clear();
+    m_jacobian.clear();
+    m_nbReuses = 0;
+    m_nbSplices = 0;
+}
+
+
+void QPComplianceCache::save(vector<SavedBlock>& blocks) const
+{
+    blocks.clear();
+    blocks.resize(m_blocks.size());
+    for(unsigned int i=0; i<m_blocks.size(); i++)
+    {
+        const Block& block = m_blocks[i];
+        if(!block.cc || !block.isValid || !block.isCached || block.version != m_version)
+            continue;
+
+        blocks[i].constraintCorrection = block.cc->getPathName();
+        blocks[i].dt = block.dt;
+        blocks[i].jacobian = block.jacobian;
+        blocks[i].compliance = block.compliance;
+    }
+}
+
+
+void QPComplianceCache::restore(const vector<SavedBlock>& blocks)
+{
+    clear();
+    m_blocks.resize(blocks.size());
+    for(unsigned int i=0; i<blocks.size(); i++)
+    {
+        if(blocks[i].constraintCorrection.empty())
+            continue;
+
+        Block& block = m_blocks[i];
+        block.restoredName = blocks[i].constraintCorrection;
+        block.isValid = true;
+        block.isCached = true;
+        block.version = m_version;
+        block.dt = blocks[i].dt;
+        block.jacobian = blocks[i].jacobian;
+        block.compliance = blocks[i].compliance;
+    }
+}
+
+
+unsigned int QPComplianceCache::getNbChangedRows(const unsigned int& i) const
+{
+    return (i < m_blocks.size())? m_blocks[i].nbChangedRows : 0;
+}
+
+
+void QPComplianceCache::compareRows(const vector<Entry>& previous,
+                                    const vector<Entry>& current,
+                                    Block& block)
+{
+    block.rows.clear();
+    block.changedRows.clear();
+    block.removedRows.clear();
+
+    // Both lists are sorted by row, compared row by row
+    size_t p = 0, c = 0;
+    while(p < previous.size() || c < current.size())
+    {
+        Index row;
+        if(p == previous.size())     row = current[c].i;
+        else if(c == current.size()) row = previous[p].i;
+        else                         row = std::min(previous[p].i, current[c].i);
+
+        size_t pEnd = p, cEnd = c;
+        while(pEnd < previous.size() && previous[pEnd].i == row) pEnd++;
+        while(cEnd < current.size() && current[cEnd].i == row) cEnd++;
+
+        if(cEnd > c)
+            block.rows.push_back(row);
+
+        if(pEnd-p != cEnd-c || !std::equal(previous.begin()+p, previous.begin()+pEnd, current.begin()+c))
+        {
+            if(cEnd > c) block.changedRows.push_back(row);
+            else         block.removedRows.push_back(row);
+        }
+
+        p = pEnd;
+        c = cEnd;
+    }
+    block.nbChangedRows = block.changedRows.size() + block.removedRows.size();
+}
+
+} // namespace
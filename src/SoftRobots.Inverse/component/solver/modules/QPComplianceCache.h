@@ -0,0 +1,178 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <sofa/core/ConstraintParams.h>
+#include <sofa/core/behavior/BaseConstraintCorrection.h>
+#include <sofa/linearalgebra/BaseMatrix.h>
+#include <sofa/type/vector.h>
+#include <string>
+
+#include <SoftRobots.Inverse/component/config.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+/// Contribution of each constraint correction to the compliance matrix W, kept across the steps.
+/// The contribution of a constraint correction is reused while the constraint Jacobian of its
+/// mechanical state, its time step and the version of the systems are unchanged (e.g. the actuators
+/// and effectors of a linear FEM). The rows of the Jacobian are compared one by one: as soon as one
+/// of them changed (usually a contact), the constraint correction computes its contribution again.
+/// Optionally, when only a few rows changed, their rows and columns are computed with the unbuilt
+/// resolution API of the constraint correction (one unit force per changed row, with partial solves)
+/// and spliced into the kept contribution, so that the cost scales with the number of changed rows.
+/// The version has to be incremented by invalidate() when the systems change (rebuilt, reinit).
+class SOFA_SOFTROBOTS_INVERSE_API QPComplianceCache
+{
+public:
+    typedef sofa::linearalgebra::BaseMatrix::Index Index;
+
+    struct Entry{
+        Index i;
+        Index j;
+        SReal value;
+        bool isSet;
+
+        bool operator==(const Entry& other) const {return i==other.i && j==other.j && value==other.value && isSet==other.isSet;}
+    };
+
+    /// Forwards the entries to W (if any), and records them in the given list (if any)
+    class SOFA_SOFTROBOTS_INVERSE_API Recorder : public sofa::linearalgebra::BaseMatrix
+    {
+    public:
+        Recorder(sofa::linearalgebra::BaseMatrix* W, sofa::type::vector<Entry>* entries);
+        ~Recorder() override {}
+
+        Index rowSize() const override {return (m_W)? m_W->rowSize() : m_nbRows;}
+        Index colSize() const override {return (m_W)? m_W->colSize() : m_nbCols;}
+        SReal element(Index i, Index j) const override {return (m_W)? m_W->element(i,j) : 0.;}
+        void resize(Index nbRow, Index nbCol) override;
+        void clear() override;
+        void set(Index i, Index j, double v) override;
+        void add(Index i, Index j, double v) override;
+
+    protected:
+        sofa::linearalgebra::BaseMatrix* m_W;
+        sofa::type::vector<Entry>* m_entries;
+        Index m_nbRows{0};
+        Index m_nbCols{0};
+    };
+
+    /// What is done with the contribution of a constraint correction at this step
+    enum class Action{
+        Compute, // computed, and recorded in getEntries(i)
+        Replay,  // unchanged, replayed
+        Splice,  // only the changed rows are computed, by splice()
+        Reduced  // formed from a reduced-order compliance instead, see QPReducedCompliance
+    };
+
+    /// Compares the Jacobian of the constraint correction i with the one its contribution was computed
+    /// from, and keeps the new one. A splice is proposed if allowed and if at most half of the rows changed.
+    Action update(const unsigned int& i,
+                  sofa::core::behavior::BaseConstraintCorrection* cc,
+                  const sofa::core::ConstraintParams* cParams,
+                  const bool& allowSplice = false);
+
+    /// Computes the rows and columns of the changed rows of the constraint correction i, in a system of
+    /// size dim, and splices them into its contribution. Returns false if the constraint correction could
+    /// not compute them, its contribution has then to be computed (and recorded) again.
+    bool splice(const unsigned int& i,
+                sofa::core::behavior::BaseConstraintCorrection* cc,
+                const Index& dim);
+
+    /// List to record the contribution of the constraint correction i, nullptr if it cannot be cached
+    /// (no mechanical state)
+    sofa::type::vector<Entry>* getEntries(const unsigned int& i);
+
+    /// Adds the recorded contribution of the constraint correction i into W
+    void replay(const unsigned int& i, sofa::linearalgebra::BaseMatrix* W) const;
+
+    void invalidate() {m_version++;}
+    void clear();
+
+    /// Contribution of a constraint correction as saved in a checkpoint (see QPCheckpoint), identified by
+    /// the path name of the constraint correction, empty if the contribution was not cached
+    struct SavedBlock{
+        std::string constraintCorrection;
+        double dt{0.};
+        sofa::type::vector<Entry> jacobian;
+        sofa::type::vector<Entry> compliance;
+    };
+
+    /// Saves the cached contributions, one block per constraint correction
+    void save(sofa::type::vector<SavedBlock>& blocks) const;
+    /// Replaces the contributions by the saved ones. A restored contribution is replayed by update() once
+    /// the constraint correction of the same path name has the same Jacobian and time step: the scene has
+    /// to be the same as the one of the checkpoint.
+    void restore(const sofa::type::vector<SavedBlock>& blocks);
+
+    unsigned int getNbReuses() const {return m_nbReuses;}
+    unsigned int getNbSplices() const {return m_nbSplices;}
+    /// Number of rows of the Jacobian of the constraint correction i that changed at its last update
+    unsigned int getNbChangedRows(const unsigned int& i) const;
+
+protected:
+
+    struct Block{
+        const sofa::core::behavior::BaseConstraintCorrection* cc{nullptr};
+        std::string restoredName; // path name of the constraint correction of a restored block, until update() finds it
+        bool isValid{false};
+        bool isCached{false};
+        unsigned int version{0};
+        double dt{0.};
+        sofa::type::vector<Entry> jacobian; // sorted by row and column
+        sofa::type::vector<Entry> compliance; // in the order they were written
+        sofa::type::vector<Index> rows; // rows of the Jacobian, sorted
+        sofa::type::vector<Index> changedRows; // rows of the Jacobian that are new or changed
+        sofa::type::vector<Index> removedRows; // rows of the previous Jacobian that are gone
+        unsigned int nbChangedRows{0};
+    };
+
+    sofa::type::vector<Block> m_blocks;
+    sofa::type::vector<Entry> m_jacobian; // Jacobian of the current update
+    unsigned int m_version{0};
+    unsigned int m_nbReuses{0};
+    unsigned int m_nbSplices{0};
+
+    // Scratch of splice(), sized once by the dimension of the system
+    sofa::type::vector<SReal> m_force;
+    sofa::type::vector<SReal> m_dforce;
+    sofa::type::vector<SReal> m_displacement;
+    sofa::type::vector<Entry> m_diagonal;
+    sofa::type::vector<Entry> m_columns;
+    sofa::type::vector<char> m_isChangedRow;
+
+    /// Compares the rows of two Jacobians sorted by row, and fills the rows of the block
+    static void compareRows(const sofa::type::vector<Entry>& previous,
+                            const sofa::type::vector<Entry>& current,
+                            Block& block);
+};
+
+} // namespace
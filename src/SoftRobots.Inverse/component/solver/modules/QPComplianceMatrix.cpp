@@ -0,0 +1,125 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+
+#include <SoftRobots.Inverse/component/solver/modules/QPComplianceMatrix.h>
+
+#include <algorithm>
+
+namespace softrobotsinverse::solver::module
+{
+
+using sofa::type::vector;
+
+QPComplianceMatrix::QPComplianceMatrix(sofa::linearalgebra::BaseMatrix* W,
+                                       const vector<bool>* isQPVariableRow,
+                                       vector<char>* touchedRows)
+    : m_W(W)
+    , m_isQPVariableRow(isQPVariableRow)
+    , m_touchedRows(touchedRows)
+{
+}
+
+
+void QPComplianceMatrix::getQPVariableRows(const QPInverseProblem::QPConstraintLists* qpCLists,
+                                           const Index& dim,
+                                           vector<bool>& isQPVariableRow)
+{
+    isQPVariableRow.assign(dim, false);
+
+    for(unsigned int rowId : qpCLists->actuatorRowIds)
+        isQPVariableRow[rowId] = true;
+
+    for(unsigned int rowId : qpCLists->equalityRowIds)
+        isQPVariableRow[rowId] = true;
+
+    for(unsigned int rowId : qpCLists->contactRowIds)
+        isQPVariableRow[rowId] = true;
+}
+
+
+void QPComplianceMatrix::getSensorRows(const QPInverseProblem::QPConstraintLists* qpCLists,
+                                       const Index& dim,
+                                       vector<bool>& isSensorRow)
+{
+    isSensorRow.assign(dim, false);
+
+    for(unsigned int rowId : qpCLists->sensorRowIds)
+        isSensorRow[rowId] = true;
+}
+
+
+void QPComplianceMatrix::mirrorUpperTriangle(sofa::linearalgebra::LPtrFullMatrix<SReal>& W)
+{
+    const Index dim = W.rowSize();
+    const Index tileSize = 64;
+    for(Index ib=0; ib<dim; ib+=tileSize)
+    {
+        const Index iEnd = std::min(dim, ib+tileSize);
+        for(Index jb=0; jb<=ib; jb+=tileSize)
+            for(Index i=ib; i<iEnd; i++)
+            {
+                SReal* Wi = W[i];
+                const Index jEnd = std::min(i, jb+tileSize);
+                for(Index j=jb; j<jEnd; j++)
+                    Wi[j] = W[j][i];
+            }
+    }
+}
+
+
+void QPComplianceMatrix::set(Index i, Index j, double v)
+{
+    if(isUsed(i,j))
+    {
+        m_W->set(i,j,v);
+        touch(i,j);
+    }
+}
+
+
+void QPComplianceMatrix::add(Index i, Index j, double v)
+{
+    if(isUsed(i,j))
+    {
+        m_W->add(i,j,v);
+        touch(i,j);
+    }
+}
+
+
+void QPComplianceMatrix::touch(Index i, Index j)
+{
+    if(m_touchedRows)
+    {
+        (*m_touchedRows)[i] = true;
+        (*m_touchedRows)[j] = true;
+    }
+}
+
+} // namespace
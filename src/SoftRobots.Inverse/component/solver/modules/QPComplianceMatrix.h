@@ -0,0 +1,127 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <sofa/linearalgebra/BaseMatrix.h>
+#include <sofa/linearalgebra/FullMatrix.h>
+#include <sofa/type/vector.h>
+#include <limits>
+
+#include <SoftRobots.Inverse/component/solver/modules/QPInverseProblem.h>
+#include <SoftRobots.Inverse/component/config.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+/// Compliance matrix W restricted to the blocks read by the QP.
+/// An entry W(i,j) is forwarded to the wrapped matrix only if the row i or the row j is a QP
+/// variable (actuator, equality or contact). The blocks coupling only effectors and sensors
+/// are never used by the QP, and are left to zero in the wrapped matrix.
+/// If no flags are given, all the entries are forwarded.
+/// The entries of the skipped rows and columns (e.g. the lazy sensors) are never forwarded.
+/// Optionally, the rows (and columns) actually written are recorded in touchedRows.
+/// Optionally, only the entries of the rows in [rowBegin, rowEnd) are forwarded.
+/// Optionally, the entries between two different lazy contacts are left out, or in the completion pass,
+/// are the only ones forwarded (see setLazyContacts()).
+/// Optionally, only the upper triangle (j >= i) is forwarded, W being symmetric: the lower triangle is then
+/// copied from it once assembled (see mirrorUpperTriangle()).
+class SOFA_SOFTROBOTS_INVERSE_API QPComplianceMatrix : public sofa::linearalgebra::BaseMatrix
+{
+public:
+    QPComplianceMatrix(sofa::linearalgebra::BaseMatrix* W,
+                       const sofa::type::vector<bool>* isQPVariableRow,
+                       sofa::type::vector<char>* touchedRows = nullptr);
+    ~QPComplianceMatrix() override {}
+
+    /// Flags the actuator, equality and contact rows of a system of size dim
+    static void getQPVariableRows(const QPInverseProblem::QPConstraintLists* qpCLists,
+                                  const Index& dim,
+                                  sofa::type::vector<bool>& isQPVariableRow);
+
+    /// Flags the sensor rows of a system of size dim
+    static void getSensorRows(const QPInverseProblem::QPConstraintLists* qpCLists,
+                              const Index& dim,
+                              sofa::type::vector<bool>& isSensorRow);
+
+    void setSkippedRows(const sofa::type::vector<bool>* isSkippedRow) {m_isSkippedRow = isSkippedRow;}
+    void setRowRange(Index rowBegin, Index rowEnd) {m_rowBegin = rowBegin; m_rowEnd = rowEnd;}
+    void setUpperTriangle(bool upperTriangle) {m_isUpperTriangle = upperTriangle;}
+
+    /// Copies the upper triangle of W into its lower triangle, by tiles so that the columns read stay in cache
+    static void mirrorUpperTriangle(sofa::linearalgebra::LPtrFullMatrix<SReal>& W);
+
+    /// Contact of each row whose compliance with the other lazy contacts is deferred, -1 for the other rows.
+    /// The entries between two different lazy contacts are skipped, unless completion is set, in which case
+    /// they are the only entries forwarded (the other ones being already in W).
+    void setLazyContacts(const sofa::type::vector<int>* lazyContactOfRow, bool completion)
+    {
+        m_lazyContactOfRow = lazyContactOfRow;
+        m_isLazyCompletion = completion;
+    }
+
+    bool isUsed(Index i, Index j) const
+    {
+        if(i < m_rowBegin || i >= m_rowEnd || (m_isUpperTriangle && j < i))
+            return false;
+        if(m_isSkippedRow && ((*m_isSkippedRow)[i] || (*m_isSkippedRow)[j]))
+            return false;
+        if(m_lazyContactOfRow)
+        {
+            const int ci = (*m_lazyContactOfRow)[i];
+            const int cj = (*m_lazyContactOfRow)[j];
+            if((ci >= 0 && cj >= 0 && ci != cj) != m_isLazyCompletion)
+                return false;
+        }
+        return !m_isQPVariableRow || (*m_isQPVariableRow)[i] || (*m_isQPVariableRow)[j];
+    }
+
+    Index rowSize() const override {return m_W->rowSize();}
+    Index colSize() const override {return m_W->colSize();}
+    SReal element(Index i, Index j) const override {return m_W->element(i,j);}
+    void resize(Index nbRow, Index nbCol) override {m_W->resize(nbRow, nbCol);}
+    void clear() override {m_W->clear();}
+    void set(Index i, Index j, double v) override;
+    void add(Index i, Index j, double v) override;
+
+protected:
+    sofa::linearalgebra::BaseMatrix* m_W;
+    const sofa::type::vector<bool>* m_isQPVariableRow;
+    const sofa::type::vector<bool>* m_isSkippedRow{nullptr};
+    const sofa::type::vector<int>* m_lazyContactOfRow{nullptr};
+    bool m_isLazyCompletion{false};
+    bool m_isUpperTriangle{false};
+    Index m_rowBegin{0};
+    Index m_rowEnd{std::numeric_limits<Index>::max()};
+    sofa::type::vector<char>* m_touchedRows;
+
+    void touch(Index i, Index j);
+};
+
+} // namespace
@@ -0,0 +1,240 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#include <SoftRobots.Inverse/component/solver/modules/QPComplianceTable.h>
+
+namespace softrobotsinverse::solver::module
+{
+
+using sofa::type::vector;
+using sofa::linearalgebra::BaseMatrix;
+
+bool QPComplianceTable::load(const std::string& filename)
+{
+    std::ifstream file(filename);
+    if(!file.is_open())
+        return false;
+
+    std::string line;
+    vector<double> key, W;
+    while(std::getline(file, line))
+    {
+        if(line.empty() || line[0] == '#')
+            continue;
+
+        std::istringstream in(line);
+        unsigned int nbKeys = 0, dim = 0;
+        if(!(in >> nbKeys >> dim))
+            return false;
+
+        key.resize(nbKeys);
+        W.resize(size_t(dim)*dim);
+        for(double& value : key)
+            in >> value;
+        for(double& value : W)
+            in >> value;
+        if(in.fail() || !addSample(key, W))
+            return false;
+    }
+    return true;
+}
+
+bool QPComplianceTable::save(const std::string& filename) const
+{
+    std::ofstream file(filename);
+    if(!file.is_open())
+        return false;
+
+    file << std::setprecision(17);
+    const size_t size = size_t(m_dim)*m_dim;
+    for(unsigned int s=0; s<m_nbSamples; s++)
+    {
+        file << m_nbKeys << " " << m_dim;
+        for(unsigned int k=0; k<m_nbKeys; k++)
+            file << " " << m_keys[size_t(s)*m_nbKeys + k];
+        for(size_t i=0; i<size; i++)
+            file << " " << m_compliances[s*size + i];
+        file << "\n";
+    }
+    return file.good();
+}
+
+void QPComplianceTable::writeSample(std::ostream& out, const vector<double>& key, const BaseMatrix& W)
+{
+    const Index dim = W.rowSize();
+    out << std::setprecision(17) << key.size() << " " << dim;
+    for(const double& value : key)
+        out << " " << value;
+    for(Index i=0; i<dim; i++)
+        for(Index j=0; j<dim; j++)
+            out << " " << W.element(i, j);
+    out << "\n";
+}
+
+bool QPComplianceTable::addSample(const vector<double>& key, const vector<double>& W)
+{
+    unsigned int dim = 0;
+    while(size_t(dim)*dim < W.size())
+        dim++;
+    if(size_t(dim)*dim != W.size())
+        return false;
+
+    if(m_nbSamples == 0)
+    {
+        m_nbKeys = key.size();
+        m_dim = dim;
+        m_minKey = key;
+        m_maxKey = key;
+    }
+    else if(key.size() != m_nbKeys || dim != m_dim)
+        return false;
+
+    for(unsigned int k=0; k<m_nbKeys; k++)
+    {
+        m_minKey[k] = std::min(m_minKey[k], key[k]);
+        m_maxKey[k] = std::max(m_maxKey[k], key[k]);
+    }
+
+    m_keys.insert(m_keys.end(), key.begin(), key.end());
+    m_compliances.insert(m_compliances.end(), W.begin(), W.end());
+    m_nbSamples++;
+    return true;
+}
+
+void QPComplianceTable::clear()
+{
+    m_nbSamples = 0;
+    m_nbKeys = 0;
+    m_dim = 0;
+    m_keys.clear();
+    m_compliances.clear();
+    m_minKey.clear();
+    m_maxKey.clear();
+}
+
+double QPComplianceTable::getScaledDistance2(const double* a, const double* b) const
+{
+    double distance2 = 0.;
+    for(unsigned int k=0; k<m_nbKeys; k++)
+    {
+        const double range = m_maxKey[k] - m_minKey[k];
+        const double d = (range > 0.)? (a[k] - b[k]) / range : a[k] - b[k];
+        distance2 += d*d;
+    }
+    return distance2;
+}
+
+void QPComplianceTable::thin(const double& spacing)
+{
+    const double spacing2 = spacing*spacing;
+    const size_t size = size_t(m_dim)*m_dim;
+    unsigned int nbKept = 0;
+    for(unsigned int s=0; s<m_nbSamples; s++)
+    {
+        const double* key = &m_keys[size_t(s)*m_nbKeys];
+        bool isKept = true;
+        for(unsigned int t=0; t<nbKept && isKept; t++)
+            isKept = getScaledDistance2(key, &m_keys[size_t(t)*m_nbKeys]) >= spacing2;
+        if(!isKept)
+            continue;
+
+        if(nbKept != s)
+        {
+            std::copy(key, key + m_nbKeys, m_keys.begin() + size_t(nbKept)*m_nbKeys);
+            std::copy(m_compliances.begin() + s*size, m_compliances.begin() + (s+1)*size,
+                      m_compliances.begin() + nbKept*size);
+        }
+        nbKept++;
+    }
+
+    m_nbSamples = nbKept;
+    m_keys.resize(size_t(nbKept)*m_nbKeys);
+    m_compliances.resize(nbKept*size);
+}
+
+bool QPComplianceTable::interpolate(const vector<double>& key, const double& radius, BaseMatrix* W)
+{
+    if(m_nbSamples == 0 || key.size() != m_nbKeys || W->rowSize() != Index(m_dim))
+        return false;
+
+    // The nbKeys+1 nearest samples, sorted by distance
+    const unsigned int nbNearest = std::min(m_nbSamples, m_nbKeys + 1);
+    m_nearest.clear();
+    m_nearestDistances.clear();
+    for(unsigned int s=0; s<m_nbSamples; s++)
+    {
+        const double distance2 = getScaledDistance2(key.data(), &m_keys[size_t(s)*m_nbKeys]);
+        if(m_nearest.size() == nbNearest && distance2 >= m_nearestDistances.back())
+            continue;
+
+        const size_t position = std::upper_bound(m_nearestDistances.begin(), m_nearestDistances.end(), distance2)
+                                - m_nearestDistances.begin();
+        m_nearest.insert(m_nearest.begin() + position, s);
+        m_nearestDistances.insert(m_nearestDistances.begin() + position, distance2);
+        if(m_nearest.size() > nbNearest)
+        {
+            m_nearest.pop_back();
+            m_nearestDistances.pop_back();
+        }
+    }
+
+    if(m_nearestDistances[0] > radius*radius)
+        return false;
+
+    const size_t size = size_t(m_dim)*m_dim;
+    m_W.assign(size, 0.);
+    if(m_nearestDistances[0] < 1e-24)
+        std::copy(m_compliances.begin() + m_nearest[0]*size, m_compliances.begin() + (m_nearest[0]+1)*size, m_W.begin());
+    else
+    {
+        double sumWeights = 0.;
+        for(unsigned int n=0; n<m_nearest.size(); n++)
+        {
+            const double weight = 1. / m_nearestDistances[n];
+            const double* compliance = &m_compliances[m_nearest[n]*size];
+            for(size_t i=0; i<size; i++)
+                m_W[i] += weight * compliance[i];
+            sumWeights += weight;
+        }
+        for(double& value : m_W)
+            value /= sumWeights;
+    }
+
+    for(unsigned int i=0; i<m_dim; i++)
+        for(unsigned int j=0; j<m_dim; j++)
+            W->set(i, j, m_W[size_t(i)*m_dim + j]);
+    return true;
+}
+
+} // namespace
@@ -0,0 +1,104 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <sofa/linearalgebra/BaseMatrix.h>
+#include <sofa/type/vector.h>
+
+#include <SoftRobots.Inverse/component/config.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+/// Compliance matrices W sampled over the actuation states of a robot in an offline run, then
+/// interpolated at runtime instead of being computed by the constraint corrections. The actuation state
+/// (the key of a sample) is a vector of nbKeys values, the forces of the actuators at the previous step,
+/// and W covers the dim rows of the problems without contacts (actuators, effectors, sensors).
+///
+/// The interpolation blends the nbKeys+1 nearest samples with weights in the inverse of their squared
+/// distance, the keys being scaled by the sampled range of each actuator. When the nearest sample is
+/// farther than the given radius (in the same scaled units), the state left the sampled region and no
+/// value is returned.
+///
+/// File format (text): one sample per line, "nbKeys dim key[nbKeys] W[dim*dim]" with W row-major, the
+/// lines starting with # being comments. Samples can thereby be appended as they are computed, and
+/// the files of several runs concatenated.
+class SOFA_SOFTROBOTS_INVERSE_API QPComplianceTable
+{
+public:
+    typedef sofa::linearalgebra::BaseMatrix::Index Index;
+
+    /// Appends the samples of the file. Returns false if it cannot be read, or if its sizes do not
+    /// match the samples already in the table.
+    bool load(const std::string& filename);
+    bool save(const std::string& filename) const;
+    static void writeSample(std::ostream& out,
+                            const sofa::type::vector<double>& key,
+                            const sofa::linearalgebra::BaseMatrix& W);
+
+    /// Returns false if the sizes do not match the samples already in the table
+    bool addSample(const sofa::type::vector<double>& key, const sofa::type::vector<double>& W);
+    void clear();
+
+    /// Removes the samples closer than spacing (scaled units) to a sample kept before them
+    void thin(const double& spacing);
+
+    /// Interpolated compliance at the given actuation state, set in W (of size dim). Returns false,
+    /// leaving W unchanged, if the sizes do not match or if the nearest sample is farther than radius.
+    bool interpolate(const sofa::type::vector<double>& key, const double& radius,
+                     sofa::linearalgebra::BaseMatrix* W);
+
+    unsigned int getNbSamples() const {return m_nbSamples;}
+    unsigned int getNbKeys() const {return m_nbKeys;}
+    unsigned int getDim() const {return m_dim;}
+    const sofa::type::vector<double>& getMinKey() const {return m_minKey;}
+    const sofa::type::vector<double>& getMaxKey() const {return m_maxKey;}
+
+protected:
+
+    unsigned int m_nbSamples{0};
+    unsigned int m_nbKeys{0};
+    unsigned int m_dim{0};
+    sofa::type::vector<double> m_keys; // nbSamples x nbKeys
+    sofa::type::vector<double> m_compliances; // nbSamples x dim x dim
+    sofa::type::vector<double> m_minKey;
+    sofa::type::vector<double> m_maxKey;
+
+    // Scratch of interpolate()
+    sofa::type::vector<unsigned int> m_nearest;
+    sofa::type::vector<double> m_nearestDistances;
+    sofa::type::vector<double> m_W;
+
+    double getScaledDistance2(const double* a, const double* b) const;
+};
+
+} // namespace
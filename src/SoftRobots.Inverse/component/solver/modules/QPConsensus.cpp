@@ -0,0 +1,131 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+
+#include <SoftRobots.Inverse/component/solver/modules/QPConsensus.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+void QPConsensus::beginStep(const vector<uint64_t>& keys, const vector<double>& compliances)
+{
+    m_iteration = 0;
+    m_change = 0.;
+
+    m_keys = keys;
+    m_compliances = compliances;
+    m_forces.resize(m_keys.size());
+    for(unsigned int i=0; i<m_keys.size(); i++)
+    {
+        const auto previous = m_previousForces.find(m_keys[i]);
+        m_forces[i] = (previous != m_previousForces.end())? previous->second : 0.;
+    }
+}
+
+
+bool QPConsensus::update(const vector<double>& deltas)
+{
+    m_iteration++;
+
+    m_entries.resize(m_keys.size());
+    for(unsigned int i=0; i<m_keys.size(); i++)
+    {
+        m_entries[i].key = m_keys[i];
+        m_entries[i].delta = deltas[i];
+        m_entries[i].compliance = m_compliances[i];
+    }
+
+    double change = m_change;
+    if(m_channel && m_channel->isOpen() && !m_timedOut)
+    {
+        m_sequence++;
+        m_channel->publish(m_sequence, m_entries, m_change);
+        if(!m_channel->gather(m_sequence, m_timeout, m_gathered, change))
+        {
+            m_timedOut = true;
+            endStep();
+            return false;
+        }
+    }
+    else
+        m_gathered = m_entries;
+
+    if(m_gathered.empty() || (m_iteration > 1 && change <= m_tolerance) || m_iteration >= m_nbIterations)
+    {
+        endStep();
+        return false;
+    }
+
+    m_gaps.clear();
+    for(const QPConsensusChannel::Entry& entry : m_gathered)
+    {
+        std::pair<double, double>& gap = m_gaps[entry.key];
+        gap.first += entry.delta;
+        gap.second += entry.compliance;
+    }
+
+    m_change = 0.;
+    for(unsigned int i=0; i<m_keys.size(); i++)
+    {
+        const std::pair<double, double>& gap = m_gaps[m_keys[i]];
+        if(gap.second <= 0.)
+            continue;
+
+        const double force = std::max(0., m_forces[i] - m_relaxation*gap.first/gap.second);
+        m_change = std::max(m_change, std::abs(force - m_forces[i]));
+        m_forces[i] = force;
+    }
+    return true;
+}
+
+
+void QPConsensus::endStep()
+{
+    m_previousForces.clear();
+    for(unsigned int i=0; i<m_keys.size(); i++)
+        m_previousForces[m_keys[i]] = m_forces[i];
+}
+
+
+void QPConsensus::clear()
+{
+    m_previousForces.clear();
+    m_keys.clear();
+    m_compliances.clear();
+    m_forces.clear();
+    m_sequence = 0;
+    m_iteration = 0;
+    m_timedOut = false;
+    m_change = 0.;
+}
+
+} // namespace
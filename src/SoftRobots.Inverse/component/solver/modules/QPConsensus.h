@@ -0,0 +1,109 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <sofa/type/vector.h>
+
+#include <SoftRobots.Inverse/component/solver/modules/QPConsensusChannel.h>
+#include <SoftRobots.Inverse/component/config.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+using sofa::type::vector;
+
+/// Dual decomposition of the contacts coupling the problems of several processes, e.g. robots of a cell
+/// touching shared objects, each process solving its own problem.
+/// The normal force f of a coupling contact is imposed to the problems of the nodes sharing it, which give
+/// back the normal displacement of their side of the contact. The gap of the contact is the sum of these
+/// displacements over the nodes (the free gap only appearing on one of them), and the force is the multiplier
+/// of the non-penetration of the contact, updated by a projected Jacobi step on all the nodes:
+///     f = max(0, f - relaxation * gap / sum of the compliances of the contact on the nodes)
+/// Every node computes the same update from the same exchange (see QPConsensusChannel), and they stop
+/// together when the forces of all of them change by less than the tolerance, or after nbIterations.
+/// Without channel, the node is alone and its coupling contacts are solved by the same iterations. After a
+/// timeout of an exchange, the nodes are out of step and the channel is not used until clear().
+class SOFA_SOFTROBOTS_INVERSE_API QPConsensus
+{
+public:
+
+    void setChannel(QPConsensusChannel* channel) {m_channel = channel;}
+    void setRelaxation(const double& relaxation) {m_relaxation = relaxation;}
+    void setNbIterations(const unsigned int& nbIterations) {m_nbIterations = std::max(1u, nbIterations);}
+    void setTolerance(const double& tolerance) {m_tolerance = tolerance;}
+    /// Seconds to wait for the other nodes at an exchange
+    void setTimeout(const double& timeout) {m_timeout = timeout;}
+
+    /// Coupling contacts of the step on this node, with the compliance of their normal row. Their forces start
+    /// from the ones of the previous step, zero for the new contacts.
+    void beginStep(const vector<uint64_t>& keys, const vector<double>& compliances);
+
+    /// Normal forces of the coupling contacts to impose at the current iteration
+    const vector<double>& getForces() const {return m_forces;}
+
+    /// Exchanges the normal displacements of the coupling contacts under the current forces. Returns true if the
+    /// forces were updated for a next iteration, false once the consensus is reached, after nbIterations or on
+    /// a timeout of the exchange.
+    bool update(const vector<double>& deltas);
+
+    /// Iterations of the step, and whether an exchange timed out
+    unsigned int getNbIterations() const {return m_iteration;}
+    bool hasTimedOut() const {return m_timedOut;}
+
+    /// Forgets the forces of the previous steps and the timeouts, the nodes being in step again
+    void clear();
+
+protected:
+
+    QPConsensusChannel* m_channel{nullptr};
+    double m_relaxation{0.8};
+    unsigned int m_nbIterations{20};
+    double m_tolerance{1e-6};
+    double m_timeout{1.};
+
+    uint64_t m_sequence{0}; // Number of exchanges, the same on all the nodes
+    unsigned int m_iteration{0};
+    bool m_timedOut{false};
+    double m_change{0.}; // Largest change of the forces of this node at the last update
+
+    vector<uint64_t> m_keys;
+    vector<double> m_compliances;
+    vector<double> m_forces;
+    vector<QPConsensusChannel::Entry> m_entries;
+    vector<QPConsensusChannel::Entry> m_gathered;
+    std::map<uint64_t, std::pair<double, double>> m_gaps; // Per key, sum of the displacements and of the compliances
+    std::map<uint64_t, double> m_previousForces;
+
+    void endStep();
+};
+
+} // namespace
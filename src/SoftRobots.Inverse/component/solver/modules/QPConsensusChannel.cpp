@@ -0,0 +1,235 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <SoftRobots.Inverse/component/solver/modules/QPConsensusChannel.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+const char QPConsensusChannel::s_magic[8] = {'S','R','I','Q','P','C','N','S'};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "The shared sequences have to be lock-free");
+
+namespace
+{
+
+/// The buffers are aligned on cache lines, the nodes do not share a line
+constexpr size_t s_alignment = 64;
+
+size_t align(const size_t& size)
+{
+    return (size + s_alignment - 1)/s_alignment*s_alignment;
+}
+
+} // namespace
+
+
+QPConsensusChannel::~QPConsensusChannel()
+{
+    close();
+}
+
+
+std::string QPConsensusChannel::getObjectName(const std::string& name)
+{
+    return (!name.empty() && name[0] == '/')? name : "/" + name;
+}
+
+
+bool QPConsensusChannel::open(const std::string& name, const unsigned int& node, const unsigned int& nbNodes,
+                              const unsigned int& capacity)
+{
+    close();
+    if(name.empty() || nbNodes == 0 || node >= nbNodes)
+        return false;
+
+#if defined(__unix__) || defined(__APPLE__)
+    m_name = getObjectName(name);
+    m_headerSize = align(sizeof(Header));
+    m_bufferSize = align(sizeof(BufferHeader) + sizeof(Entry)*capacity);
+    m_size = m_headerSize + size_t(2*nbNodes)*m_bufferSize;
+
+    // Created by the first node, the others map the same object
+    const int object = shm_open(m_name.c_str(), O_CREAT | O_RDWR, 0644);
+    if(object < 0)
+        return false;
+
+    struct stat status;
+    void* data = MAP_FAILED;
+    if(fstat(object, &status) == 0 && (size_t(status.st_size) == m_size
+                                       || (status.st_size == 0 && ftruncate(object, m_size) == 0)))
+        data = mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, object, 0);
+    ::close(object); // the mapping stays valid
+    if(data == MAP_FAILED)
+    {
+        m_name.clear();
+        m_size = 0;
+        return false;
+    }
+
+    m_data = static_cast<char*>(data);
+    m_node = node;
+    m_nbNodes = nbNodes;
+    m_capacity = capacity;
+
+    // Written identically by all the nodes
+    Header* header = reinterpret_cast<Header*>(m_data);
+    header->version = s_version;
+    header->nbNodes = m_nbNodes;
+    header->capacity = m_capacity;
+    header->bufferSize = m_bufferSize;
+    std::memcpy(header->magic, s_magic, 8);
+
+    // The exchanges left by a previous run of this node are dropped
+    getBuffer(m_node, 0)->sequence.store(0, std::memory_order_release);
+    getBuffer(m_node, 1)->sequence.store(0, std::memory_order_release);
+    return true;
+#else
+    SOFA_UNUSED(node);
+    SOFA_UNUSED(capacity);
+    return false;
+#endif
+}
+
+
+void QPConsensusChannel::close()
+{
+#if defined(__unix__) || defined(__APPLE__)
+    if(m_data)
+    {
+        munmap(m_data, m_size);
+        if(m_node == 0)
+            shm_unlink(m_name.c_str());
+    }
+#endif
+
+    m_data = nullptr;
+    m_size = 0;
+    m_name.clear();
+    m_node = 0;
+    m_nbNodes = 0;
+    m_capacity = 0;
+    m_headerSize = 0;
+    m_bufferSize = 0;
+}
+
+
+QPConsensusChannel::BufferHeader* QPConsensusChannel::getBuffer(const unsigned int& node, const uint64_t& sequence) const
+{
+    return reinterpret_cast<BufferHeader*>(m_data + m_headerSize + (2*node + sequence % 2)*m_bufferSize);
+}
+
+
+QPConsensusChannel::Entry* QPConsensusChannel::getEntries(BufferHeader* buffer) const
+{
+    return reinterpret_cast<Entry*>(reinterpret_cast<char*>(buffer) + sizeof(BufferHeader));
+}
+
+
+void QPConsensusChannel::publish(const uint64_t& sequence, const sofa::type::vector<Entry>& entries, const double& change)
+{
+    if(!m_data || sequence == 0)
+        return;
+
+    BufferHeader* buffer = getBuffer(m_node, sequence);
+    buffer->sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    const unsigned int nbEntries = std::min<size_t>(entries.size(), m_capacity);
+    buffer->nbEntries = nbEntries;
+    buffer->change = change;
+    if(nbEntries > 0)
+        std::memcpy(getEntries(buffer), entries.data(), sizeof(Entry)*nbEntries);
+
+    buffer->sequence.store(sequence, std::memory_order_release);
+}
+
+
+bool QPConsensusChannel::read(const unsigned int& node, const uint64_t& sequence,
+                              sofa::type::vector<Entry>& entries, double& change) const
+{
+    BufferHeader* buffer = getBuffer(node, sequence);
+    if(buffer->sequence.load(std::memory_order_acquire) != sequence)
+        return false;
+
+    const size_t size = entries.size();
+    const unsigned int nbEntries = std::min(buffer->nbEntries, m_capacity);
+    const double nodeChange = buffer->change;
+    entries.resize(size + nbEntries);
+    if(nbEntries > 0)
+        std::memcpy(entries.data() + size, getEntries(buffer), sizeof(Entry)*nbEntries);
+
+    // The copy is valid if the node did not start rewriting the buffer meanwhile
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if(buffer->sequence.load(std::memory_order_relaxed) != sequence)
+    {
+        entries.resize(size);
+        return false;
+    }
+
+    change = std::max(change, nodeChange);
+    return true;
+}
+
+
+bool QPConsensusChannel::gather(const uint64_t& sequence, const double& timeout,
+                                sofa::type::vector<Entry>& entries, double& change) const
+{
+    entries.clear();
+    change = 0.;
+    if(!m_data || sequence == 0)
+        return false;
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(timeout);
+    for(unsigned int node=0; node<m_nbNodes; node++)
+    {
+        while(!read(node, sequence, entries, change))
+        {
+            if(std::chrono::steady_clock::now() > deadline)
+                return false;
+            std::this_thread::yield();
+        }
+    }
+    return true;
+}
+
+} // namespace
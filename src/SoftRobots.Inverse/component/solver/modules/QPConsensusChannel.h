@@ -0,0 +1,132 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <sofa/type/vector.h>
+
+#include <SoftRobots.Inverse/component/config.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+/// Exchange of the coupling contacts between the processes of a distributed resolution (see QPConsensus),
+/// in a POSIX shared memory object opened by all of them. Each node writes its entries in a slot of its own
+/// and reads the slots of the others, the exchanges are numbered by a sequence known by all the nodes.
+///
+/// Layout (byte order of the machine, versioned by s_version):
+///   Header  magic "SRIQPCNS", version, nbNodes, capacity, bufferSize
+///   Buffers 2 per node from the aligned size of the header, the exchange s of node n in the buffer
+///           2*n + s % 2: sequence (uint64, 0 while the buffer is written, s once written), nbEntries
+///           (uint32), reserved (uint32), change (double), then capacity entries (key, delta, compliance)
+/// A node only writes the exchange s+2 after having read the exchange s+1 of all the nodes, which they only
+/// write after having read the exchange s: two buffers per node are enough for the nodes in step. A reader
+/// checks the sequence after its copy, in case of a node out of step. On the platforms without shared
+/// memory, open() fails.
+class SOFA_SOFTROBOTS_INVERSE_API QPConsensusChannel
+{
+public:
+
+    /// Normal row of a coupling contact: its key shared by the nodes, its displacement on this node and the
+    /// compliance of the row on this node
+    struct Entry {
+        uint64_t key{0};
+        double delta{0.};
+        double compliance{0.};
+    };
+
+    QPConsensusChannel() {}
+    ~QPConsensusChannel();
+    QPConsensusChannel(const QPConsensusChannel&) = delete;
+    QPConsensusChannel& operator=(const QPConsensusChannel&) = delete;
+
+    /// Opens the shared memory object, created by the first node opening it, as the given node of nbNodes,
+    /// with capacity entries per node. All the nodes have to give the same nbNodes and capacity. The name is
+    /// prefixed with '/' if it does not start with it.
+    bool open(const std::string& name, const unsigned int& node, const unsigned int& nbNodes,
+              const unsigned int& capacity = s_defaultCapacity);
+    /// Unmaps the object, and removes it on the node 0
+    void close();
+    bool isOpen() const {return m_data != nullptr;}
+
+    unsigned int getNode() const {return m_node;}
+    unsigned int getNbNodes() const {return m_nbNodes;}
+    unsigned int getCapacity() const {return m_capacity;}
+
+    /// Writes the entries of the node for the exchange sequence (>0), the entries past the capacity are dropped
+    void publish(const uint64_t& sequence, const sofa::type::vector<Entry>& entries, const double& change);
+
+    /// Waits for the exchange sequence of all the nodes, at most timeout seconds, and copies their entries
+    /// (this node included) and the largest of their changes. Returns false on timeout.
+    bool gather(const uint64_t& sequence, const double& timeout, sofa::type::vector<Entry>& entries, double& change) const;
+
+    static const char s_magic[8];
+    static constexpr uint32_t s_version{1};
+    static constexpr unsigned int s_defaultCapacity{4096};
+
+protected:
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t nbNodes;
+        uint32_t capacity;
+        uint32_t bufferSize;
+    };
+
+    struct BufferHeader {
+        std::atomic<uint64_t> sequence;
+        uint32_t nbEntries;
+        uint32_t reserved;
+        double change;
+        // followed by capacity entries
+    };
+
+    BufferHeader* getBuffer(const unsigned int& node, const uint64_t& sequence) const;
+    Entry* getEntries(BufferHeader* buffer) const;
+
+    /// Copies the exchange sequence of the node, false if it is not written yet or was rewritten meanwhile
+    bool read(const unsigned int& node, const uint64_t& sequence, sofa::type::vector<Entry>& entries, double& change) const;
+
+    static std::string getObjectName(const std::string& name);
+
+    char* m_data{nullptr};
+    size_t m_size{0};
+    std::string m_name;
+    unsigned int m_node{0};
+    unsigned int m_nbNodes{0};
+    unsigned int m_capacity{0};
+    uint32_t m_headerSize{0};
+    uint32_t m_bufferSize{0};
+};
+
+} // namespace
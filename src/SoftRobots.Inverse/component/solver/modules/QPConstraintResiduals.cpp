@@ -0,0 +1,88 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#include <algorithm>
+#include <cmath>
+#include <SoftRobots.Inverse/component/solver/modules/QPConstraintResiduals.h>
+
+namespace softrobotsinverse::solver::module
+{
+
+namespace
+{
+
+typedef Eigen::Map<const Eigen::VectorXd> ConstVectorMap;
+typedef Eigen::Map<Eigen::VectorXd> VectorMap;
+
+}
+
+
+void QPConstraintResiduals::compute(const QPInverseProblem::QPSystem& qpSystem, const double* x)
+{
+    const unsigned int dim = qpSystem.dim;
+    const unsigned int nbRows = qpSystem.A.size();
+    const unsigned int nbEqRows = qpSystem.Aeq.size();
+
+    m_Ax.resize(nbRows);
+    m_Aeqx.resize(nbEqRows);
+    m_violations.resize(nbRows + nbEqRows);
+    m_maxViolation = 0.;
+    m_maxViolationRow = -1;
+
+    ConstVectorMap xv(x, dim);
+    if(nbRows>0)
+        VectorMap(m_Ax.data(), nbRows).noalias() = qpSystem.A.view().leftCols(dim) * xv;
+    if(nbEqRows>0)
+        VectorMap(m_Aeqx.data(), nbEqRows).noalias() = qpSystem.Aeq.view().leftCols(dim) * xv;
+
+    for(unsigned int i=0; i<nbRows; i++)
+    {
+        double violation = m_Ax[i] - qpSystem.bu[i];
+        if(qpSystem.hasBothSideInequalityConstraint)
+            violation = std::max(violation, qpSystem.bl[i] - m_Ax[i]);
+        m_violations[i] = std::max(violation, 0.);
+    }
+
+    for(unsigned int i=0; i<nbEqRows; i++)
+        m_violations[nbRows+i] = std::abs(m_Aeqx[i] - qpSystem.beq[i]);
+
+    for(unsigned int i=0; i<m_violations.size(); i++)
+        if(m_violations[i] > m_maxViolation)
+        {
+            m_maxViolation = m_violations[i];
+            m_maxViolationRow = i;
+        }
+}
+
+
+size_t QPConstraintResiduals::getMemoryUsage() const
+{
+    return sizeof(double)*(m_Ax.capacity() + m_Aeqx.capacity() + m_violations.capacity());
+}
+
+} // namespace
@@ -0,0 +1,78 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <sofa/type/vector.h>
+
+#include <SoftRobots.Inverse/component/solver/modules/QPInverseProblem.h>
+#include <SoftRobots.Inverse/component/config.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+using sofa::type::vector;
+
+/// Residuals of the constraints [A; Aeq] of a QP system at a point x, computed in a single pass: the
+/// products A x and Aeq x are matrix-vector products on the contiguous storage of the matrices, from
+/// which the violation of each row is derived:
+/// - max(A_i x - bu_i, bl_i - A_i x, 0) for an inequality row (bl only with both side constraints),
+/// - |Aeq_i x - beq_i| for an equality row.
+/// The feasibility checks, the release of the actuator constraints and the diagnostics read the same
+/// residuals instead of walking the matrices row by row.
+class SOFA_SOFTROBOTS_INVERSE_API QPConstraintResiduals
+{
+public:
+    static constexpr double s_defaultTolerance{1e-5};
+
+    void compute(const QPInverseProblem::QPSystem& qpSystem, const double* x);
+
+    /// Products A x and Aeq x of the last computation
+    const vector<double>& getAx() const {return m_Ax;}
+    const vector<double>& getAeqx() const {return m_Aeqx;}
+
+    /// Violation of each row of [A; Aeq], 0 if the row is satisfied
+    const vector<double>& getViolations() const {return m_violations;}
+    double getMaxViolation() const {return m_maxViolation;}
+    int getMaxViolationRow() const {return m_maxViolationRow;} /// -1 if no row is violated
+
+    bool isFeasible(const double& tolerance = s_defaultTolerance) const {return m_maxViolation <= tolerance;}
+    bool isViolated(const unsigned int& row, const double& tolerance = s_defaultTolerance) const {return m_violations[row] > tolerance;}
+
+    size_t getMemoryUsage() const;
+
+protected:
+    vector<double> m_Ax;
+    vector<double> m_Aeqx;
+    vector<double> m_violations;
+    double m_maxViolation{0.};
+    int m_maxViolationRow{-1};
+};
+
+} // namespace
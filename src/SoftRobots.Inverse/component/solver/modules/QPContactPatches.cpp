@@ -0,0 +1,142 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+
+#include <SoftRobots.Inverse/component/solver/modules/QPContactPatches.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+unsigned int QPContactPatches::coarsen(QPInverseProblem::QPConstraintLists* lists, double** W, const double* dfree,
+                                       const unsigned int& contactNbLines)
+{
+    m_nbPatches = 0;
+    m_nbRefinedPatches = 0;
+    m_isolated.clear();
+    if(reduce(lists, W, dfree, contactNbLines) == 0)
+        return 0;
+
+    m_patch = m_representative;
+    m_patchSize.assign(m_representatives.size(), 0);
+    for(unsigned int patch : m_patch)
+        m_patchSize[patch]++;
+    for(unsigned int size : m_patchSize)
+        if(size > 1)
+            m_nbPatches++;
+
+    return m_nbRemovedContacts;
+}
+
+
+unsigned int QPContactPatches::findBoundaries(const QPInverseProblem::QPConstraintLists* lists, double** W,
+                                              const double* dfree, const vector<double>& x, const double& mu)
+{
+    m_nbRefinedPatches = 0;
+    const unsigned int nbPatches = m_patchSize.size();
+    m_isRefined.assign(nbPatches, 0);
+
+    const unsigned int nbContactRows = lists->contactRowIds.size();
+    const unsigned int nbContacts = m_patch.size();
+    if(m_nbPatches == 0 || nbContacts*m_contactNbLines != nbContactRows || x.size() != m_columns.size())
+        return 0;
+
+    m_patchScale.assign(nbPatches, 0.);
+    for(unsigned int contact=0; contact<nbContacts; contact++)
+    {
+        const double normalDfree = std::abs(dfree[lists->contactRowIds[contact*m_contactNbLines]]);
+        m_patchScale[m_patch[contact]] = std::max(m_patchScale[m_patch[contact]], normalDfree);
+    }
+
+    // Displacement of a contact row, delta = W lambda + dfree on the columns of the QP variables
+    auto getDelta = [&](const unsigned int& row) {
+        const double* w = W[lists->contactRowIds[row]];
+        double delta = dfree[lists->contactRowIds[row]];
+        for(unsigned int j=0; j<m_columns.size(); j++)
+            delta += w[m_columns[j]]*x[j];
+        return delta;
+    };
+
+    const unsigned int offset = x.size() - nbContactRows;
+    for(unsigned int contact=0; contact<nbContacts; contact++)
+    {
+        const unsigned int patch = m_patch[contact];
+        if(m_patchSize[patch] < 2 || m_isRefined[patch])
+            continue;
+
+        const unsigned int row = contact*m_contactNbLines;
+        const double threshold = m_threshold*m_patchScale[patch];
+        const double lambdaN = x[offset+row];
+        const double deltaN = getDelta(row);
+
+        bool disagrees = false;
+        if(lambdaN <= 0.) // Separated patch, the contacts of a patch share the sign of its force
+            disagrees = deltaN < -threshold;
+        else
+        {
+            disagrees = std::abs(deltaN) > threshold;
+            if(!disagrees && m_contactNbLines == 3)
+            {
+                const double lambdaT = std::sqrt(x[offset+row+1]*x[offset+row+1] + x[offset+row+2]*x[offset+row+2]);
+                if(lambdaT < mu*lambdaN*(1.-1e-6)) // Sticking patch
+                {
+                    const double deltaT = getDelta(row+1);
+                    const double deltaO = getDelta(row+2);
+                    disagrees = std::sqrt(deltaT*deltaT + deltaO*deltaO) > threshold;
+                }
+            }
+        }
+
+        if(disagrees)
+        {
+            m_isRefined[patch] = 1;
+            m_nbRefinedPatches++;
+        }
+    }
+
+    return m_nbRefinedPatches;
+}
+
+
+unsigned int QPContactPatches::refine(QPInverseProblem::QPConstraintLists* lists, double** W, const double* dfree,
+                                      const unsigned int& contactNbLines)
+{
+    const unsigned int nbContacts = m_patch.size();
+    m_isolated.resize(nbContacts);
+    for(unsigned int contact=0; contact<nbContacts; contact++)
+        m_isolated[contact] = m_isRefined[m_patch[contact]];
+
+    const unsigned int nbRemovedContacts = reduce(lists, W, dfree, contactNbLines);
+    m_isolated.clear();
+    return nbRemovedContacts;
+}
+
+} // namespace
@@ -0,0 +1,91 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <sofa/type/vector.h>
+
+#include <SoftRobots.Inverse/component/solver/modules/QPContactReduction.h>
+#include <SoftRobots.Inverse/component/config.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+using sofa::type::vector;
+
+/// Coarse-to-fine resolution of dense contact patches, in two levels.
+/// The coarse level merges the contacts whose rows of W are collinear up to a loose tolerance (see
+/// QPContactReduction): each patch is solved as one contact, which gives the state of the patch.
+/// The force of a patch is then spread on its contacts and their displacements are computed with their own
+/// rows of W. A patch is at a state boundary when one of its contacts disagrees with the state of the patch:
+/// a penetrating contact in a separated patch, a penetrating or separating contact in a patch in contact,
+/// a slipping contact in a sticking patch. The fine level solves the contacts of these patches individually,
+/// the other patches staying merged.
+class SOFA_SOFTROBOTS_INVERSE_API QPContactPatches : public QPContactReduction
+{
+public:
+
+    QPContactPatches() {m_tolerance = 5e-2;}
+
+    /// Displacement above which a contact disagrees with its patch, relative to the largest |dfree| of the
+    /// normal rows of the patch
+    void setThreshold(const double& threshold) {m_threshold = threshold;}
+
+    /// Coarse level: replaces the contact rows of the lists by the rows of the patches, returns the number
+    /// of removed contacts (0 if no patch has more than one contact)
+    unsigned int coarsen(QPInverseProblem::QPConstraintLists* lists, double** W, const double* dfree,
+                         const unsigned int& contactNbLines);
+
+    /// From the forces x of the coarse level expanded on all the contacts (see expand()), flags the patches
+    /// at a state boundary and returns their number
+    unsigned int findBoundaries(const QPInverseProblem::QPConstraintLists* lists, double** W, const double* dfree,
+                                const vector<double>& x, const double& mu);
+
+    /// Fine level: replaces the contact rows of the lists, the contacts of the patches at a state boundary
+    /// are kept individually, returns the number of removed contacts
+    unsigned int refine(QPInverseProblem::QPConstraintLists* lists, double** W, const double* dfree,
+                        const unsigned int& contactNbLines);
+
+    /// Patches of more than one contact at the coarse level, and those refined at the fine level
+    unsigned int getNbPatches() const {return m_nbPatches;}
+    unsigned int getNbRefinedPatches() const {return m_nbRefinedPatches;}
+
+protected:
+
+    double m_threshold{1e-2};
+    unsigned int m_nbPatches{0};
+    unsigned int m_nbRefinedPatches{0};
+
+    vector<unsigned int> m_patch; // Per contact, its patch at the coarse level
+    vector<unsigned int> m_patchSize;
+    vector<double> m_patchScale; // Per patch, largest |dfree| of the normal rows
+    vector<char> m_isRefined; // Per patch
+};
+
+} // namespace
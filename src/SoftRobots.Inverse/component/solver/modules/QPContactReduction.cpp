@@ -0,0 +1,199 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <SoftRobots.Inverse/component/solver/modules/QPContactReduction.h>
+
+namespace softrobotsinverse::solver::module
+{
+
+using sofa::type::vector;
+
+
+unsigned int QPContactReduction::reduce(QPInverseProblem::QPConstraintLists* lists, double** W, const double* dfree,
+                                        const unsigned int& contactNbLines)
+{
+    m_nbRemovedContacts = 0;
+    m_contactNbLines = contactNbLines;
+
+    const unsigned int nbContactRows = lists->contactRowIds.size();
+    const unsigned int nbContacts = nbContactRows/contactNbLines;
+    if(nbContacts < 2)
+        return 0;
+
+    m_fullContactRowIds = lists->contactRowIds;
+    m_fullContactIds = lists->contactIds;
+
+    m_columns = lists->actuatorRowIds;
+    m_columns.insert(m_columns.end(), lists->equalityRowIds.begin(), lists->equalityRowIds.end());
+    m_columns.insert(m_columns.end(), lists->contactRowIds.begin(), lists->contactRowIds.end());
+
+    m_norms.resize(nbContactRows);
+    for(unsigned int i=0; i<nbContactRows; i++)
+    {
+        const double* w = W[lists->contactRowIds[i]];
+        double norm = 0.;
+        for(unsigned int column : m_columns)
+            norm += w[column]*w[column];
+        m_norms[i] = sqrt(norm);
+    }
+
+    // The most constraining contacts (smallest normalized dfree on the normal row) are the representatives
+    m_order.resize(nbContacts);
+    for(unsigned int i=0; i<nbContacts; i++)
+        m_order[i] = i;
+    auto normalizedDfree = [&](const unsigned int& contact) {
+        const unsigned int row = contact*contactNbLines;
+        return (m_norms[row]>0.)? dfree[lists->contactRowIds[row]]/m_norms[row] : std::numeric_limits<double>::max();
+    };
+    std::stable_sort(m_order.begin(), m_order.end(), [&](const unsigned int& a, const unsigned int& b) {
+        return normalizedDfree(a) < normalizedDfree(b);
+    });
+
+    m_representative.resize(nbContacts);
+    m_scale.resize(nbContactRows);
+    m_representatives.clear();
+    vector<double> scales(contactNbLines);
+    for(unsigned int contact : m_order)
+    {
+        bool merged = false;
+        for(unsigned int representative : m_representatives)
+        {
+            if(isIsolated(contact))
+                break;
+            if(isIsolated(representative))
+                continue;
+            if(areCollinear(W, contact, representative, scales))
+            {
+                m_representative[contact] = representative;
+                for(unsigned int k=0; k<contactNbLines; k++)
+                    m_scale[contact*contactNbLines+k] = scales[k];
+                merged = true;
+                break;
+            }
+        }
+
+        if(!merged)
+        {
+            m_representative[contact] = contact;
+            for(unsigned int k=0; k<contactNbLines; k++)
+                m_scale[contact*contactNbLines+k] = 1.;
+            m_representatives.push_back(contact);
+        }
+    }
+
+    if(m_representatives.size() == nbContacts)
+        return 0;
+
+    // The kept contacts stay in their original order
+    std::sort(m_representatives.begin(), m_representatives.end());
+    vector<unsigned int> reducedId(nbContacts, 0);
+    for(unsigned int i=0; i<m_representatives.size(); i++)
+        reducedId[m_representatives[i]] = i;
+    for(unsigned int i=0; i<nbContacts; i++)
+        m_representative[i] = reducedId[m_representative[i]];
+
+    m_scaleSum.assign(m_representatives.size()*contactNbLines, 0.);
+    for(unsigned int i=0; i<nbContactRows; i++)
+        m_scaleSum[m_representative[i/contactNbLines]*contactNbLines + i%contactNbLines] += m_scale[i];
+
+    lists->contactRowIds.clear();
+    lists->contactIds.clear();
+    for(unsigned int representative : m_representatives)
+        for(unsigned int k=0; k<contactNbLines; k++)
+        {
+            const unsigned int row = representative*contactNbLines+k;
+            lists->contactRowIds.push_back(m_fullContactRowIds[row]);
+            if(row < m_fullContactIds.size())
+                lists->contactIds.push_back(m_fullContactIds[row]);
+        }
+
+    m_nbRemovedContacts = nbContacts - m_representatives.size();
+    return m_nbRemovedContacts;
+}
+
+
+bool QPContactReduction::areCollinear(double** W, const unsigned int& contact, const unsigned int& representative,
+                                      vector<double>& scales) const
+{
+    for(unsigned int k=0; k<m_contactNbLines; k++)
+    {
+        const unsigned int row = contact*m_contactNbLines+k;
+        const unsigned int representativeRow = representative*m_contactNbLines+k;
+        const double norm = m_norms[row];
+        const double representativeNorm = m_norms[representativeRow];
+        if(norm<=0. || representativeNorm<=0.)
+            return false;
+
+        const double* w = W[m_fullContactRowIds[row]];
+        const double* wr = W[m_fullContactRowIds[representativeRow]];
+        double dot = 0.;
+        for(unsigned int column : m_columns)
+            dot += w[column]*wr[column];
+
+        if(dot < (1.-m_tolerance)*norm*representativeNorm)
+            return false;
+
+        scales[k] = dot/(representativeNorm*representativeNorm); // Least squares fit of r_c = s_c r_rep
+    }
+    return true;
+}
+
+
+void QPContactReduction::expand(QPInverseProblem::QPConstraintLists* lists, vector<double>& x) const
+{
+    if(!isReduced())
+        return;
+
+    const unsigned int nbReducedRows = lists->contactRowIds.size();
+    const unsigned int offset = x.size() - nbReducedRows;
+    const unsigned int nbContactRows = m_fullContactRowIds.size();
+
+    vector<double> contactForces(nbContactRows);
+    for(unsigned int i=0; i<nbContactRows; i++)
+    {
+        const unsigned int contact = i/m_contactNbLines;
+        const unsigned int reducedRow = m_representative[contact]*m_contactNbLines + i%m_contactNbLines;
+        const double force = x[offset+reducedRow];
+        if(m_expandForces)
+            contactForces[i] = force/m_scaleSum[reducedRow];
+        else
+            contactForces[i] = (m_representatives[m_representative[contact]] == contact)? force : 0.;
+    }
+
+    x.resize(offset);
+    x.insert(x.end(), contactForces.begin(), contactForces.end());
+
+    lists->contactRowIds = m_fullContactRowIds;
+    lists->contactIds = m_fullContactIds;
+}
+
+} // namespace
@@ -0,0 +1,97 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <sofa/type/vector.h>
+
+#include <SoftRobots.Inverse/component/solver/modules/QPInverseProblem.h>
+#include <SoftRobots.Inverse/component/config.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+using sofa::type::vector;
+
+/// Merges the redundant contacts of an inverse problem before the QP is assembled.
+/// Collision pipelines often report many contacts on a same flat patch, whose rows of W are nearly
+/// collinear: they bring no new information but inflate the size of the QP and make it rank-deficient.
+/// The contacts are visited from the most constraining (smallest normalized dfree on the normal row)
+/// and each one is attached to the first kept contact (its representative) whose rows are all collinear
+/// to its own rows, up to the tolerance on 1-cos(angle). Only the representatives are solved.
+/// With r_c = s_c r_rep + e_c for the rows of a merged contact, the displacement of the merged contact
+/// is known up to |e_c| |lambda|, the error is thereby bounded by the tolerance.
+/// After the resolution, the force of a representative is spread on its contacts, weighted such that
+/// sum(s_c lambda_c) = lambda_rep so that the displacements are unchanged, or kept on the representative
+/// alone.
+class SOFA_SOFTROBOTS_INVERSE_API QPContactReduction
+{
+public:
+
+    void setTolerance(const double& tolerance) {m_tolerance = tolerance;}
+    void setExpandForces(const bool& expand) {m_expandForces = expand;}
+
+    /// Replaces the contact rows of the lists by the rows of the representatives, returns the number
+    /// of removed contacts. The removed contacts are restored by expand().
+    unsigned int reduce(QPInverseProblem::QPConstraintLists* lists, double** W, const double* dfree,
+                        const unsigned int& contactNbLines);
+
+    /// Restores the contact rows of the lists, and expands the contact forces of x (ordered as the QP
+    /// variables: actuators, equality, contacts) from the representatives to all the contacts
+    void expand(QPInverseProblem::QPConstraintLists* lists, vector<double>& x) const;
+
+    bool isReduced() const {return m_nbRemovedContacts>0;}
+    unsigned int getNbRemovedContacts() const {return m_nbRemovedContacts;}
+
+protected:
+
+    double m_tolerance{1e-3};
+    bool m_expandForces{true};
+    unsigned int m_nbRemovedContacts{0};
+    unsigned int m_contactNbLines{1};
+
+    vector<unsigned int> m_fullContactRowIds;
+    vector<QPInverseProblem::QPContactId> m_fullContactIds;
+    vector<unsigned int> m_representative; // Per contact, index of its representative in the reduced contacts
+    vector<double> m_scale; // Per contact row, s_c
+    vector<double> m_scaleSum; // Per reduced contact row, sum of s_c over the contacts of the representative
+
+    vector<unsigned int> m_columns; // Rows of the QP variables, columns of W compared between contacts
+    vector<double> m_norms; // Per contact row, norm of the row of W on the columns
+    vector<unsigned int> m_order;
+    vector<unsigned int> m_representatives; // Contacts kept
+    vector<char> m_isolated; // Per contact, true if it is neither merged nor a representative of other contacts
+
+    bool isIsolated(const unsigned int& contact) const {return contact<m_isolated.size() && m_isolated[contact];}
+
+    bool areCollinear(double** W, const unsigned int& contact, const unsigned int& representative,
+                      vector<double>& scales) const;
+};
+
+} // namespace
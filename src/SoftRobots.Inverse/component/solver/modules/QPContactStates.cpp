@@ -0,0 +1,219 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#include <cmath>
+#include <sofa/helper/config.h>
+
+#include <SoftRobots.Inverse/component/solver/modules/QPContactStates.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+void QPContactStates::setFriction(const double& mu, const bool& allowSliding, const FrictionCone& frictionCone)
+{
+    m_mu = mu;
+    m_allowSliding = allowSliding;
+    m_frictionCone = frictionCone;
+}
+
+
+unsigned int QPContactStates::findBoundaries(const double* lambda, const double* delta, vector<int>& candidates)
+{
+    const unsigned int nbContacts = m_states.size();
+    candidates.resize(nbContacts);
+    unsigned int nbCandidates = 0;
+
+    if(m_mu <= 0.)
+    {
+        for(unsigned int i=0; i<nbContacts; i++)
+        {
+            const bool isCandidate = hasReachedBoundary(m_states[i], lambda[i], delta[i]);
+            candidates[i] = (isCandidate)? s_normalCandidate : s_noCandidate;
+            nbCandidates += isCandidate;
+        }
+        return nbCandidates;
+    }
+
+    // The tests of all the contacts first, without branches on the states, then the selection by state
+    m_isNormalForceZero.resize(nbContacts);
+    m_isNormalDeltaZero.resize(nbContacts);
+    m_isOnCone.resize(nbContacts);
+    m_isSlidingDeltaZero.resize(nbContacts);
+    for(unsigned int i=0; i<nbContacts; i++)
+    {
+        const double* l = lambda + 3*i;
+        const double* d = delta + 3*i;
+        m_isNormalForceZero[i] = std::abs(l[0]) <= s_epsilon;
+        m_isNormalDeltaZero[i] = std::abs(d[0]) <= s_epsilon;
+        m_isSlidingDeltaZero[i] = (std::abs(d[1]) <= s_epsilon) & (std::abs(d[2]) <= s_epsilon);
+    }
+    if(m_allowSliding && m_frictionCone.getNbFacets() == 4)
+        for(unsigned int i=0; i<nbContacts; i++)
+        {
+            const double* l = lambda + 3*i;
+            m_isOnCone[i] = std::abs(std::abs(l[1]) + std::abs(l[2]) - m_mu*l[0]) <= s_epsilon;
+        }
+    else if(m_allowSliding)
+        for(unsigned int i=0; i<nbContacts; i++)
+        {
+            const double* l = lambda + 3*i;
+            m_isOnCone[i] = std::abs(m_frictionCone.getGap(l[0], l[1], l[2], m_mu)) <= s_epsilon;
+        }
+    else
+        std::fill(m_isOnCone.begin(), m_isOnCone.end(), 0);
+
+    for(unsigned int i=0; i<nbContacts; i++)
+    {
+        int candidate = s_noCandidate;
+        switch(m_states[i])
+        {
+        case Inactive:
+            if(m_isNormalDeltaZero[i])
+                candidate = s_normalCandidate;
+            break;
+        case Stick:
+            if(m_isOnCone[i])
+                candidate = s_slidingCandidates;
+            else if(m_isNormalForceZero[i])
+                candidate = s_normalCandidate;
+            break;
+        case Sliding:
+            if(m_isNormalForceZero[i])
+                candidate = s_normalCandidate;
+            else if(m_isSlidingDeltaZero[i])
+                candidate = s_slidingCandidates;
+            break;
+        default:
+            break;
+        }
+        candidates[i] = candidate;
+        nbCandidates += (candidate != s_noCandidate);
+    }
+    return nbCandidates;
+}
+
+
+QPContactStates::State QPContactStates::getNewState(const unsigned int& i, const double* lambda, const double* delta) const
+{
+    if(m_mu <= 0.)
+        return getNewState(m_states[i], lambda[i], delta[i]);
+    return getNewState(m_states[i], lambda + 3*i, delta + 3*i, m_mu, m_allowSliding, m_frictionCone);
+}
+
+
+bool QPContactStates::hasReachedBoundary(const State& state, const double* lambda, const double* delta,
+                                         const double& mu, const bool& allowSliding, const FrictionCone& frictionCone,
+                                         int& candidateId)
+{
+    switch(state)
+    {
+    case Inactive:
+        candidateId = s_normalCandidate; // Blocking constraint is lambda_n
+        return std::abs(delta[0]) <= s_epsilon;
+    case Stick:
+        if(allowSliding && std::abs(frictionCone.getGap(lambda[0], lambda[1], lambda[2], mu)) <= s_epsilon)
+        {
+            candidateId = s_slidingCandidates; // Blocking constraint are lambda_t and lambda_o
+            return true;
+        }
+        if(std::abs(lambda[0]) <= s_epsilon)
+        {
+            candidateId = s_normalCandidate;
+            return true;
+        }
+        return false;
+    case Sliding:
+        if(std::abs(lambda[0]) <= s_epsilon)
+        {
+            candidateId = s_normalCandidate;
+            return true;
+        }
+        if(std::abs(delta[1]) <= s_epsilon && std::abs(delta[2]) <= s_epsilon)
+        {
+            candidateId = s_slidingCandidates;
+            return true;
+        }
+        return false;
+    default:
+        return false;
+    }
+}
+
+
+bool QPContactStates::hasReachedBoundary(const State& state, const double& lambda, const double& delta)
+{
+    switch(state)
+    {
+    case Active:
+        return std::abs(lambda) <= s_epsilon;
+    case Inactive:
+        return std::abs(delta) <= s_epsilon;
+    default:
+        return false;
+    }
+}
+
+
+QPContactStates::State QPContactStates::getNewState(const State& state, const double* lambda, const double* delta,
+                                                    const double& mu, const bool& allowSliding, const FrictionCone& frictionCone)
+{
+    SOFA_UNUSED(delta);
+
+    switch(state)
+    {
+    case Inactive:
+    case Stick:
+        if(allowSliding && std::abs(frictionCone.getGap(lambda[0], lambda[1], lambda[2], mu)) <= s_epsilon)
+            return Sliding;
+        return (state == Inactive)? Stick : Inactive;
+    case Sliding:
+        return (std::abs(lambda[0]) <= s_epsilon)? Inactive : Stick;
+    default:
+        return state;
+    }
+}
+
+
+QPContactStates::State QPContactStates::getNewState(const State& state, const double& lambda, const double& delta)
+{
+    SOFA_UNUSED(lambda);
+    SOFA_UNUSED(delta);
+
+    switch(state)
+    {
+    case Active:
+        return Inactive;
+    case Inactive:
+        return Active;
+    default:
+        return state;
+    }
+}
+
+} // namespace
@@ -0,0 +1,96 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <sofa/type/vector.h>
+
+#include <SoftRobots.Inverse/component/config.h>
+#include <SoftRobots.Inverse/component/solver/modules/FrictionCone.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+using sofa::type::vector;
+
+/// States of the contact points of the pivot algorithm, as an array of enums, with the rules of the
+/// transitions between them. The boundary tests of all the contacts are done in one pass, reading the
+/// forces and displacements of the contact rows in place, as contiguous triplets (normal and the two sliding
+/// directions) with friction, or single values without. The ContactHandler classes (one instance per state,
+/// pointed to by QPConstraintParams::contactStates) apply the same rules, through the static functions below.
+class SOFA_SOFTROBOTS_INVERSE_API QPContactStates
+{
+public:
+    enum State : unsigned char {Inactive, Active, Stick, Sliding};
+
+    /// Rows of a contact at its boundary: the normal row, or the two sliding rows (sliding <-> stick)
+    static constexpr int s_noCandidate = -1;
+    static constexpr int s_normalCandidate = 0;
+    static constexpr int s_slidingCandidates = 3;
+
+    static constexpr double s_epsilon = 1e-14;
+
+    /// mu = 0 for frictionless contacts (one row per contact)
+    void setFriction(const double& mu, const bool& allowSliding, const FrictionCone& frictionCone);
+
+    vector<State>& getStates() {return m_states;}
+    const vector<State>& getStates() const {return m_states;}
+
+    /// Candidate rows of each contact (see s_normalCandidate), s_noCandidate if it has not reached its
+    /// boundary, from the forces and displacements of the contact rows. Returns the number of contacts at
+    /// their boundary.
+    unsigned int findBoundaries(const double* lambda, const double* delta, vector<int>& candidates);
+
+    /// State of the contact i after a pivot
+    State getNewState(const unsigned int& i, const double* lambda, const double* delta) const;
+
+    /// With friction, lambda and delta are the triplets of the contact
+    static bool hasReachedBoundary(const State& state, const double* lambda, const double* delta,
+                                   const double& mu, const bool& allowSliding, const FrictionCone& frictionCone,
+                                   int& candidateId);
+    static bool hasReachedBoundary(const State& state, const double& lambda, const double& delta);
+
+    static State getNewState(const State& state, const double* lambda, const double* delta,
+                             const double& mu, const bool& allowSliding, const FrictionCone& frictionCone);
+    static State getNewState(const State& state, const double& lambda, const double& delta);
+
+protected:
+    vector<State> m_states;
+    double m_mu{0.};
+    bool m_allowSliding{false};
+    FrictionCone m_frictionCone;
+
+    // Tests of the pass, for each contact (see findBoundaries())
+    vector<unsigned char> m_isNormalForceZero;
+    vector<unsigned char> m_isNormalDeltaZero;
+    vector<unsigned char> m_isOnCone;
+    vector<unsigned char> m_isSlidingDeltaZero;
+};
+
+} // namespace
@@ -0,0 +1,170 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <SoftRobots.Inverse/component/solver/modules/QPContactTracker.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+using sofa::type::vector;
+
+
+unsigned int QPContactTracker::track(QPInverseProblem::QPConstraintLists* lists, double** W,
+                                     const unsigned int& contactNbLines)
+{
+    m_nbMatchedContacts = 0;
+    m_nbNewContacts = 0;
+
+    const vector<unsigned int>& contactRowIds = lists->contactRowIds;
+    vector<QPInverseProblem::QPContactId>& contactIds = lists->contactIds;
+    if(contactIds.size() != contactRowIds.size())
+        return 0;
+
+    // The signatures of the previous step are not comparable once the fixed rows changed
+    const unsigned int signatureSize = lists->actuatorRowIds.size() + lists->equalityRowIds.size() + 1;
+    if(signatureSize != m_signatureSize)
+        clear();
+    m_signatureSize = signatureSize;
+
+    m_contacts.clear();
+    for(unsigned int first=0; first+contactNbLines<=contactRowIds.size(); first+=contactNbLines)
+        if(!contactIds[first].isValid())
+            m_contacts.push_back({contactIds[first].constraint, -1, first});
+    std::stable_sort(m_contacts.begin(), m_contacts.end(), [](const Contact& a, const Contact& b)
+    {
+        return std::less<const BaseConstraint*>()(a.constraint, b.constraint);
+    });
+
+    const unsigned int nbContacts = m_contacts.size();
+    m_signatures.resize(nbContacts*m_signatureSize);
+    m_norms.resize(nbContacts);
+    for(unsigned int i=0; i<nbContacts; i++)
+    {
+        const unsigned int row = contactRowIds[m_contacts[i].first];
+        const double* w = W[row];
+        double* signature = m_signatures.data() + i*m_signatureSize;
+        for(unsigned int j : lists->actuatorRowIds)
+            *signature++ = w[j];
+        for(unsigned int j : lists->equalityRowIds)
+            *signature++ = w[j];
+        *signature = w[row];
+
+        const double* s = m_signatures.data() + i*m_signatureSize;
+        double norm2 = 0.;
+        for(unsigned int k=0; k<m_signatureSize; k++)
+            norm2 += s[k]*s[k];
+        m_norms[i] = std::sqrt(norm2);
+    }
+
+    // Candidate pairs of the same component within the tolerance, both lists being sorted by component
+    m_candidates.clear();
+    unsigned int previousBegin = 0;
+    for(unsigned int i=0; i<nbContacts; i++)
+    {
+        const BaseConstraint* constraint = m_contacts[i].constraint;
+        while(previousBegin<m_previousContacts.size()
+              && std::less<const BaseConstraint*>()(m_previousContacts[previousBegin].constraint, constraint))
+            previousBegin++;
+        for(unsigned int p=previousBegin; p<m_previousContacts.size() && m_previousContacts[p].constraint == constraint; p++)
+        {
+            const double distance = getDistance(i, p);
+            if(distance <= m_tolerance)
+                m_candidates.push_back({distance, i, p});
+        }
+    }
+
+    // Greedy matching from the closest pairs
+    std::sort(m_candidates.begin(), m_candidates.end());
+    m_isMatched.assign(nbContacts, false);
+    m_isPreviousMatched.assign(m_previousContacts.size(), false);
+    for(const Candidate& candidate : m_candidates)
+    {
+        if(m_isMatched[candidate.contact] || m_isPreviousMatched[candidate.previous])
+            continue;
+        m_isMatched[candidate.contact] = true;
+        m_isPreviousMatched[candidate.previous] = true;
+        m_contacts[candidate.contact].id = m_previousContacts[candidate.previous].id;
+        m_nbMatchedContacts++;
+    }
+
+    for(unsigned int i=0; i<nbContacts; i++)
+    {
+        Contact& contact = m_contacts[i];
+        if(!m_isMatched[i])
+        {
+            contact.id = m_nextId;
+            m_nextId = (m_nextId == std::numeric_limits<int>::max())? s_firstId : m_nextId + 1;
+            m_nbNewContacts++;
+        }
+        for(unsigned int line=0; line<contactNbLines; line++)
+            contactIds[contact.first + line].id = contact.id;
+    }
+
+    std::swap(m_contacts, m_previousContacts);
+    std::swap(m_signatures, m_previousSignatures);
+    std::swap(m_norms, m_previousNorms);
+    return m_nbMatchedContacts;
+}
+
+
+double QPContactTracker::getDistance(const unsigned int& contact, const unsigned int& previous) const
+{
+    const double* s = m_signatures.data() + contact*m_signatureSize;
+    const double* t = m_previousSignatures.data() + previous*m_signatureSize;
+    double distance2 = 0.;
+    for(unsigned int k=0; k<m_signatureSize; k++)
+        distance2 += (s[k] - t[k])*(s[k] - t[k]);
+
+    const double scale = std::max(m_norms[contact], m_previousNorms[previous]);
+    return (scale > 0.)? std::sqrt(distance2)/scale : 0.;
+}
+
+
+void QPContactTracker::clear()
+{
+    m_previousContacts.clear();
+    m_previousSignatures.clear();
+    m_previousNorms.clear();
+}
+
+
+size_t QPContactTracker::getMemoryUsage() const
+{
+    return sizeof(Contact)*(m_contacts.capacity() + m_previousContacts.capacity())
+            + sizeof(double)*(m_signatures.capacity() + m_previousSignatures.capacity()
+                              + m_norms.capacity() + m_previousNorms.capacity())
+            + sizeof(Candidate)*m_candidates.capacity() + m_isMatched.capacity() + m_isPreviousMatched.capacity();
+}
+
+} // namespace
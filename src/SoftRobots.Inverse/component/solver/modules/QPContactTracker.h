@@ -0,0 +1,101 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <sofa/type/vector.h>
+
+#include <SoftRobots.Inverse/component/solver/modules/QPInverseProblem.h>
+#include <SoftRobots.Inverse/component/config.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+using sofa::type::vector;
+
+/// Identity of the contacts across the steps, for the contacts whose component gives no persistent id
+/// (see QPInverseProblem::updateContactIds()), e.g. when the collision pipeline recreates its rows in a
+/// different order at each step.
+/// A contact is described by its component (the pair of colliding objects) and by a signature read from the
+/// normal row of W: its coupling with the actuators and equality constraints and its own compliance, which
+/// vary continuously with the location of the contact on the robot. The contacts of a component are
+/// matched to those of the previous step by increasing distance between their signatures, up to the
+/// tolerance relative to their norms. A matched contact keeps the id of the previous one, the others get
+/// new ids, in a range distinct from the persistent ids.
+class SOFA_SOFTROBOTS_INVERSE_API QPContactTracker
+{
+public:
+    static constexpr int s_firstId = 1<<30;
+
+    void setTolerance(const double& tolerance) {m_tolerance = tolerance;}
+
+    /// Gives an id to the contacts of the lists without a valid one (lists->contactIds sized as the contact
+    /// rows), returns the number of contacts matched to a contact of the previous step
+    unsigned int track(QPInverseProblem::QPConstraintLists* lists, double** W, const unsigned int& contactNbLines);
+
+    unsigned int getNbMatchedContacts() const {return m_nbMatchedContacts;}
+    unsigned int getNbNewContacts() const {return m_nbNewContacts;}
+
+    /// Forgets the contacts of the previous step, the next ones are all new
+    void clear();
+
+    size_t getMemoryUsage() const;
+
+protected:
+
+    struct Contact{
+        const BaseConstraint* constraint{nullptr};
+        int id{-1};
+        unsigned int first{0}; // First row of the contact in contactRowIds
+    };
+
+    struct Candidate{
+        double distance;
+        unsigned int contact;
+        unsigned int previous;
+
+        bool operator<(const Candidate& other) const {return distance < other.distance;}
+    };
+
+    double m_tolerance{1e-2};
+    int m_nextId{s_firstId};
+    unsigned int m_nbMatchedContacts{0};
+    unsigned int m_nbNewContacts{0};
+
+    unsigned int m_signatureSize{0};
+    vector<Contact> m_contacts, m_previousContacts; // Sorted by component
+    vector<double> m_signatures, m_previousSignatures; // m_signatureSize values per contact
+    vector<double> m_norms, m_previousNorms;
+    vector<Candidate> m_candidates;
+    vector<char> m_isMatched, m_isPreviousMatched;
+
+    double getDistance(const unsigned int& contact, const unsigned int& previous) const;
+};
+
+} // namespace
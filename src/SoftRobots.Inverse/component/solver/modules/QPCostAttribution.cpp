@@ -0,0 +1,203 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#include <cmath>
+#include <SoftRobots.Inverse/component/solver/modules/QPCostAttribution.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+void QPCostAttribution::beginStep(const QPConstraintLists& lists, double** W, const unsigned int& dim)
+{
+    m_costs.clear();
+    m_componentCosts.clear();
+
+    addComponents(lists.actuators, lists.actuatorRowIds, W, dim);
+    addComponents(lists.equality, lists.equalityRowIds, W, dim);
+    addComponents(lists.effectors, lists.effectorRowIds, W, dim);
+    addComponents(lists.sensors, lists.sensorRowIds, W, dim);
+
+    if(!lists.contactRowIds.empty())
+    {
+        Cost cost;
+        cost.name = "contacts";
+        cost.nbRows = lists.contactRowIds.size();
+        cost.nbNonZeros = countNonZeros(lists.contactRowIds, 0, cost.nbRows, W, dim);
+        m_componentCosts[nullptr] = m_costs.size();
+        m_costs.push_back(cost);
+    }
+
+    m_nbNonZeros = 0;
+    m_nbWorkingSetChanges = 0;
+    for(const Cost& cost : m_costs)
+        m_nbNonZeros += cost.nbNonZeros;
+}
+
+
+void QPCostAttribution::addComponents(const vector<SoftRobotsBaseConstraint*>& components, const vector<unsigned int>& rowIds,
+                                      double** W, const unsigned int& dim)
+{
+    unsigned int first = 0;
+    for(SoftRobotsBaseConstraint* component : components)
+    {
+        Cost cost;
+        cost.name = component->getPathName();
+        cost.nbRows = component->getNbLines();
+        cost.nbNonZeros = countNonZeros(rowIds, first, cost.nbRows, W, dim);
+        first += cost.nbRows;
+
+        m_componentCosts[component] = m_costs.size();
+        m_costs.push_back(cost);
+    }
+}
+
+
+unsigned int QPCostAttribution::countNonZeros(const vector<unsigned int>& rowIds, const unsigned int& first, const unsigned int& size,
+                                              double** W, const unsigned int& dim) const
+{
+    unsigned int nbNonZeros = 0;
+    for(unsigned int k=first; k<first+size && k<rowIds.size(); k++)
+    {
+        if(rowIds[k] >= dim)
+            continue;
+        const double* row = W[rowIds[k]];
+        for(unsigned int j=0; j<dim; j++)
+            if(row[j] != 0.)
+                nbNonZeros++;
+    }
+    return nbNonZeros;
+}
+
+
+int QPCostAttribution::getCostId(const QPConstraintLists& lists, const int& variable) const
+{
+    if(variable < 0 || variable >= (int)lists.variableRows.size())
+        return -1;
+
+    auto it = m_componentCosts.find(lists.variableRows[variable].owner);
+    return (it != m_componentCosts.end())? (int)it->second : -1;
+}
+
+
+void QPCostAttribution::addResolution(const QPConstraintLists& lists, const vector<int>& constraintsId,
+                                      const int& nbVariables, const int& nbConstraints, const double* dual)
+{
+    // A QP of another size starts from an empty active set
+    if((int)m_activeBounds.size() != nbVariables || (int)m_activeConstraints.size() != nbConstraints)
+    {
+        m_activeBounds.assign(nbVariables, false);
+        m_activeConstraints.assign(nbConstraints, false);
+    }
+    m_isCostActive.assign(m_costs.size(), false);
+
+    auto update = [&](char& wasActive, const double& multiplier, const int& variable)
+    {
+        const bool isActive = (std::fabs(multiplier) > s_activeDualThreshold);
+        const int id = getCostId(lists, variable);
+        if(id >= 0)
+        {
+            if(isActive)
+                m_isCostActive[id] = true;
+            if(isActive != (bool)wasActive)
+            {
+                m_costs[id].nbWorkingSetChanges++;
+                m_nbWorkingSetChanges++;
+            }
+        }
+        wasActive = isActive;
+    };
+
+    for(int j=0; j<nbVariables; j++)
+        update(m_activeBounds[j], dual[j], j);
+    for(int i=0; i<nbConstraints; i++)
+        update(m_activeConstraints[i], dual[nbVariables+i], (i<(int)constraintsId.size())? constraintsId[i] : -1);
+
+    for(unsigned int k=0; k<m_costs.size(); k++)
+    {
+        m_costs[k].nbResolutions++;
+        if(m_isCostActive[k])
+            m_costs[k].nbActiveResolutions++;
+    }
+}
+
+
+void QPCostAttribution::add(const QPCostAttribution& step)
+{
+    for(const Cost& stepCost : step.m_costs)
+    {
+        auto it = m_namedCosts.find(stepCost.name);
+        if(it == m_namedCosts.end())
+        {
+            it = m_namedCosts.emplace(stepCost.name, m_costs.size()).first;
+            m_costs.emplace_back();
+            m_costs.back().name = stepCost.name;
+        }
+
+        Cost& cost = m_costs[it->second];
+        cost.nbRows = stepCost.nbRows;
+        cost.nbNonZeros = stepCost.nbNonZeros;
+        cost.nbResolutions += stepCost.nbResolutions;
+        cost.nbActiveResolutions += stepCost.nbActiveResolutions;
+        cost.nbWorkingSetChanges += stepCost.nbWorkingSetChanges;
+    }
+
+    m_nbNonZeros = 0;
+    for(const Cost& cost : m_costs)
+        m_nbNonZeros += cost.nbNonZeros;
+    m_nbWorkingSetChanges += step.m_nbWorkingSetChanges;
+}
+
+
+void QPCostAttribution::clear()
+{
+    m_costs.clear();
+    m_componentCosts.clear();
+    m_namedCosts.clear();
+    m_nbNonZeros = 0;
+    m_nbWorkingSetChanges = 0;
+    m_activeBounds.clear();
+    m_activeConstraints.clear();
+}
+
+
+void QPCostAttribution::getTable(Table& table) const
+{
+    table.clear();
+    for(const Cost& cost : m_costs)
+    {
+        vector<SReal>& entry = table[cost.name];
+        entry.resize(4);
+        entry[0] = cost.nbRows;
+        entry[1] = (m_nbNonZeros>0)? (SReal)cost.nbNonZeros/(SReal)m_nbNonZeros : 0.;
+        entry[2] = (cost.nbResolutions>0)? (SReal)cost.nbActiveResolutions/(SReal)cost.nbResolutions : 0.;
+        entry[3] = (m_nbWorkingSetChanges>0)? (SReal)cost.nbWorkingSetChanges/(SReal)m_nbWorkingSetChanges : 0.;
+    }
+}
+
+} // namespace
@@ -0,0 +1,115 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <map>
+#include <string>
+#include <sofa/type/vector.h>
+
+#include <SoftRobots.Inverse/component/solver/modules/QPInverseProblem.h>
+#include <SoftRobots.Inverse/component/config.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+using sofa::type::vector;
+
+/// Attribution of the cost of the QPs to the constraint components of the problem (actuators,
+/// equality, effectors and sensors, the contacts being gathered in one entry), to find the ones
+/// that make the resolution expensive.
+///
+/// For each component: its number of rows, the share of the nonzeros of the compliance W in its rows,
+/// the number of QPs solved while one of its bounds or constraints was active, and the number of
+/// changes of the active set of its bounds and constraints. The active set is read from the dual
+/// solution, whatever the backend. Between two QPs of the same size, the changes are the bounds and
+/// constraints whose status differs; otherwise (first QP, new contacts) the active ones are counted,
+/// as a cold start adds them to the working set. This is a lower bound of the working set changes of
+/// qpOASES, which does not report them per bound.
+///
+/// A problem fills a step with beginStep() and addResolution(), the solver accumulates the steps of
+/// its problems with add().
+class SOFA_SOFTROBOTS_INVERSE_API QPCostAttribution
+{
+public:
+    typedef QPInverseProblem::QPConstraintLists QPConstraintLists;
+    typedef std::map<std::string, vector<SReal>> Table;
+
+    struct Cost {
+        std::string name;
+        unsigned int nbRows{0};
+        unsigned int nbNonZeros{0}; // in its rows of W, at the last step
+        unsigned int nbResolutions{0};
+        unsigned int nbActiveResolutions{0};
+        unsigned int nbWorkingSetChanges{0};
+    };
+
+    /// Declares the components of the step and counts the nonzeros of their rows of W
+    void beginStep(const QPConstraintLists& lists, double** W, const unsigned int& dim);
+
+    /// Attributes the active set of a QP of the step, given its dual solution (bounds then constraints)
+    /// and the variable of each constraint (see QPConstraintParams::constraintsId)
+    void addResolution(const QPConstraintLists& lists, const vector<int>& constraintsId,
+                       const int& nbVariables, const int& nbConstraints, const double* dual);
+
+    /// Accumulates the counts of a step, the rows and nonzeros are the ones of the last step
+    void add(const QPCostAttribution& step);
+
+    void clear();
+
+    const vector<Cost>& getCosts() const {return m_costs;}
+    unsigned int getNbNonZeros() const {return m_nbNonZeros;}
+    unsigned int getNbWorkingSetChanges() const {return m_nbWorkingSetChanges;}
+
+    /// Writes {rows, share of the nonzeros of W, frequency in the active set, share of the working set
+    /// changes} for each component, under its path name
+    void getTable(Table& table) const;
+
+    static constexpr double s_activeDualThreshold{1e-10};
+
+protected:
+    vector<Cost> m_costs;
+    std::map<const SoftRobotsBaseConstraint*, unsigned int> m_componentCosts; // index in m_costs in a step, nullptr for the contacts
+    std::map<std::string, unsigned int> m_namedCosts; // index in m_costs in the accumulation
+    unsigned int m_nbNonZeros{0};
+    unsigned int m_nbWorkingSetChanges{0};
+
+    // Active set of the previous QP, to count the changes
+    vector<char> m_activeBounds;
+    vector<char> m_activeConstraints;
+    vector<char> m_isCostActive;
+
+    void addComponents(const vector<SoftRobotsBaseConstraint*>& components, const vector<unsigned int>& rowIds,
+                       double** W, const unsigned int& dim);
+    unsigned int countNonZeros(const vector<unsigned int>& rowIds, const unsigned int& first, const unsigned int& size,
+                               double** W, const unsigned int& dim) const;
+    int getCostId(const QPConstraintLists& lists, const int& variable) const;
+};
+
+} // namespace
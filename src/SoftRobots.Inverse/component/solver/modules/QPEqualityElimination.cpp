@@ -0,0 +1,288 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#include <algorithm>
+#include <cmath>
+#include <SoftRobots.Inverse/component/solver/modules/QPEqualityElimination.h>
+
+namespace softrobotsinverse::solver::module
+{
+
+using sofa::type::vector;
+
+namespace
+{
+// Bounds of qpOASES with this magnitude are infinite
+const double s_infinity = 1e20;
+// A free variable is chosen as basic if its pivot is within this ratio of the largest one
+const double s_freePivotRatio = 0.1;
+
+double shiftBound(const double& bound, const double& offset)
+{
+    return (std::abs(bound) >= s_infinity)? bound : bound - offset;
+}
+}
+
+
+bool QPEqualityElimination::reduce(const QPInverseProblem::QPSystem& system, const vector<int>& constraintsId)
+{
+    const int n = system.dim;
+    const int ASize = system.A.size();
+    const int AeqSize = system.Aeq.size();
+    if(AeqSize == 0 || AeqSize >= n || !chooseBasicVariables(system))
+        return false;
+
+    const int nbReducedVariables = n - AeqSize;
+    const bool hasBounds = (system.l.size() == (size_t)n && system.u.size() == (size_t)n);
+
+    // xB = AeqB^-1 (beq - AeqN xN)
+    Eigen::MatrixXd AeqB(AeqSize, AeqSize);
+    Eigen::MatrixXd AeqN(AeqSize, nbReducedVariables);
+    for(int i=0; i<AeqSize; i++)
+    {
+        for(int k=0; k<AeqSize; k++)
+            AeqB(i, k) = system.Aeq[i][m_basic[k]];
+        for(int j=0; j<nbReducedVariables; j++)
+            AeqN(i, j) = system.Aeq[i][m_nonBasic[j]];
+    }
+    Eigen::PartialPivLU<Eigen::MatrixXd> lu(AeqB);
+    const Eigen::MatrixXd T = lu.solve(AeqN);
+    const Eigen::VectorXd t0 = lu.solve(Eigen::Map<const Eigen::VectorXd>(system.beq.data(), AeqSize));
+    m_AeqBT.compute(AeqB.transpose());
+
+    m_Z.setZero(n, nbReducedVariables);
+    m_x0.setZero(n);
+    for(int k=0; k<AeqSize; k++)
+    {
+        m_Z.row(m_basic[k]) = -T.row(k);
+        m_x0(m_basic[k]) = t0(k);
+    }
+    for(int j=0; j<nbReducedVariables; j++)
+        m_Z(m_nonBasic[j], j) = 1.;
+
+    // Objective
+    const QPInverseProblem::ConstMatrixView Q = system.Q.view();
+    const Eigen::Map<const Eigen::VectorXd> c(system.c.data(), n);
+    const Eigen::VectorXd Qx0 = Q*m_x0;
+    m_objectiveOffset = 0.5*m_x0.dot(Qx0) + c.dot(m_x0);
+
+    m_reduced.dim = nbReducedVariables;
+    m_reduced.Q.resize(nbReducedVariables, nbReducedVariables);
+    Eigen::Map<RowMajorMatrixXd>(m_reduced.Q.data(), nbReducedVariables, nbReducedVariables).noalias() = m_Z.transpose()*(Q*m_Z);
+    m_reduced.c.resize(nbReducedVariables);
+    Eigen::Map<Eigen::VectorXd>(m_reduced.c.data(), nbReducedVariables).noalias() = m_Z.transpose()*(Qx0 + c);
+
+    m_reduced.l.clear();
+    m_reduced.u.clear();
+    m_boundedBasic.clear();
+    if(hasBounds)
+    {
+        for(int j=0; j<nbReducedVariables; j++)
+        {
+            m_reduced.l.push_back(system.l[m_nonBasic[j]]);
+            m_reduced.u.push_back(system.u[m_nonBasic[j]]);
+        }
+        for(int k=0; k<AeqSize; k++)
+            if(system.l[m_basic[k]] > -s_infinity || system.u[m_basic[k]] < s_infinity)
+                m_boundedBasic.push_back(k);
+    }
+
+    // Inequalities: the rows A Z, and the bounds of the basic variables as rows -T xN
+    const int nbReducedConstraints = ASize + m_boundedBasic.size();
+    m_reduced.A.resize(nbReducedConstraints, nbReducedVariables);
+    Eigen::Map<RowMajorMatrixXd> Ar(m_reduced.A.data(), nbReducedConstraints, nbReducedVariables);
+    m_reduced.bl.resize(nbReducedConstraints);
+    m_reduced.bu.resize(nbReducedConstraints);
+    if(ASize > 0)
+    {
+        const QPInverseProblem::ConstMatrixView A = system.A.view();
+        Ar.topRows(ASize).noalias() = A*m_Z;
+        const Eigen::VectorXd Ax0 = A*m_x0;
+        for(int i=0; i<ASize; i++)
+        {
+            m_reduced.bu[i] = shiftBound(system.bu[i], Ax0(i));
+            m_reduced.bl[i] = (system.hasBothSideInequalityConstraint)? shiftBound(system.bl[i], Ax0(i)) : -1e99;
+        }
+    }
+    for(unsigned int r=0; r<m_boundedBasic.size(); r++)
+    {
+        const int k = m_boundedBasic[r];
+        Ar.row(ASize+r) = m_Z.row(m_basic[k]);
+        m_reduced.bl[ASize+r] = shiftBound(system.l[m_basic[k]], t0(k));
+        m_reduced.bu[ASize+r] = shiftBound(system.u[m_basic[k]], t0(k));
+    }
+    m_reduced.hasBothSideInequalityConstraint = true;
+
+    m_reduced.Aeq.clear();
+    m_reduced.beq.clear();
+    m_reduced.lambda.clear();
+    m_reduced.delta.clear();
+    m_reduced.previousResult.clear();
+    m_reduced.W = system.W;
+    m_reduced.dFree = system.dFree;
+
+    m_reducedConstraintsId.clear();
+    if(constraintsId.size() == (size_t)(ASize + AeqSize))
+    {
+        m_reducedConstraintsId.assign(constraintsId.begin(), constraintsId.begin()+ASize);
+        for(unsigned int r=0; r<m_boundedBasic.size(); r++)
+            m_reducedConstraintsId.push_back(-1-(int)r);
+    }
+
+    return true;
+}
+
+
+void QPEqualityElimination::expand(const QPInverseProblem::QPSystem& system, const double* reducedX, const double* reducedDual,
+                                   double* x, double* dual)
+{
+    const int n = system.dim;
+    const int ASize = system.A.size();
+    const int AeqSize = system.Aeq.size();
+    const int nbReducedVariables = m_reduced.dim;
+    const int nbReducedConstraints = m_reduced.A.size();
+
+    m_x = Eigen::Map<const Eigen::VectorXd>(reducedX, nbReducedVariables);
+    if(dual)
+        m_dual = Eigen::Map<const Eigen::VectorXd>(reducedDual, nbReducedVariables + nbReducedConstraints);
+
+    Eigen::Map<Eigen::VectorXd> fullX(x, n);
+    fullX = m_x0 + m_Z*m_x;
+    if(!dual)
+        return;
+
+    // Multipliers of the bounds and of the inequalities, qpOASES convention Q x + c = yB + A^T yA + Aeq^T yEq
+    Eigen::Map<Eigen::VectorXd> yB(dual, n);
+    yB.setZero();
+    for(int j=0; j<nbReducedVariables; j++)
+        yB(m_nonBasic[j]) = m_dual(j);
+    for(unsigned int r=0; r<m_boundedBasic.size(); r++)
+        yB(m_basic[m_boundedBasic[r]]) = m_dual(nbReducedVariables + ASize + r);
+    Eigen::Map<Eigen::VectorXd> yA(dual + n, ASize);
+    yA = m_dual.segment(nbReducedVariables, ASize);
+
+    // The rows of the basic variables give the multipliers of the equalities
+    const Eigen::Map<const Eigen::VectorXd> c(system.c.data(), n);
+    m_residual = system.Q.view()*fullX + c - yB;
+    if(ASize > 0)
+        m_residual.noalias() -= system.A.view().transpose()*yA;
+    Eigen::VectorXd rB(AeqSize);
+    for(int k=0; k<AeqSize; k++)
+        rB(k) = m_residual(m_basic[k]);
+    Eigen::Map<Eigen::VectorXd>(dual + n + ASize, AeqSize) = m_AeqBT.solve(rB);
+}
+
+
+bool QPEqualityElimination::chooseBasicVariables(const QPInverseProblem::QPSystem& system)
+{
+    const int n = system.dim;
+    const int AeqSize = system.Aeq.size();
+    const bool hasBounds = (system.l.size() == (size_t)n && system.u.size() == (size_t)n);
+
+    m_elimination = system.Aeq.view();
+    const double maxEntry = m_elimination.cwiseAbs().maxCoeff();
+    if(maxEntry == 0.)
+        return false;
+
+    vector<char> isBasic(n, false);
+    vector<char> isUsedRow(AeqSize, false);
+    m_basic.clear();
+
+    // Gaussian elimination with full pivoting, the free variables (no finite bound) being preferred as
+    // basic variables so that their bounds do not become constraint rows of the reduced QP
+    for(int step=0; step<AeqSize; step++)
+    {
+        int bestRow = -1, bestCol = -1, bestFreeRow = -1, bestFreeCol = -1;
+        double best = 0., bestFree = 0.;
+        for(int i=0; i<AeqSize; i++)
+        {
+            if(isUsedRow[i])
+                continue;
+            for(int j=0; j<n; j++)
+            {
+                if(isBasic[j])
+                    continue;
+                const double value = std::abs(m_elimination(i, j));
+                if(value > best)
+                {
+                    best = value;
+                    bestRow = i;
+                    bestCol = j;
+                }
+                const bool isFree = !hasBounds || (system.l[j] <= -s_infinity && system.u[j] >= s_infinity);
+                if(isFree && value > bestFree)
+                {
+                    bestFree = value;
+                    bestFreeRow = i;
+                    bestFreeCol = j;
+                }
+            }
+        }
+
+        if(best <= m_tolerance*maxEntry)
+            return false; // Rank deficient
+
+        if(bestFreeCol >= 0 && bestFree >= s_freePivotRatio*best)
+        {
+            bestRow = bestFreeRow;
+            bestCol = bestFreeCol;
+        }
+
+        isUsedRow[bestRow] = true;
+        isBasic[bestCol] = true;
+        m_basic.push_back(bestCol);
+        for(int i=0; i<AeqSize; i++)
+        {
+            if(isUsedRow[i])
+                continue;
+            const double factor = m_elimination(i, bestCol)/m_elimination(bestRow, bestCol);
+            if(factor != 0.)
+                m_elimination.row(i) -= factor*m_elimination.row(bestRow);
+        }
+    }
+
+    m_nonBasic.clear();
+    for(int j=0; j<n; j++)
+        if(!isBasic[j])
+            m_nonBasic.push_back(j);
+    return true;
+}
+
+
+size_t QPEqualityElimination::getMemoryUsage() const
+{
+    return m_reduced.Q.getMemoryUsage() + m_reduced.A.getMemoryUsage()
+            + sizeof(double)*(m_reduced.c.capacity() + m_reduced.l.capacity() + m_reduced.u.capacity()
+                              + m_reduced.bl.capacity() + m_reduced.bu.capacity()
+                              + m_Z.size() + m_x0.size() + m_AeqBT.matrixLU().size() + m_elimination.size()
+                              + m_x.size() + m_dual.size() + m_residual.size())
+            + sizeof(int)*(m_reducedConstraintsId.capacity() + m_basic.capacity() + m_nonBasic.capacity()
+                           + m_boundedBasic.capacity());
+}
+
+} // namespace
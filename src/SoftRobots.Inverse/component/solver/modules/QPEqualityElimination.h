@@ -0,0 +1,99 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <sofa/type/vector.h>
+#include <Eigen/LU>
+
+#include <SoftRobots.Inverse/component/solver/modules/QPInverseProblem.h>
+#include <SoftRobots.Inverse/component/config.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+using sofa::type::vector;
+
+/// Elimination of the equality constraints Aeq x = beq of a QP (Equality components) by substitution.
+/// With Aeq of full row rank, nbEq basic variables xB are chosen by Gaussian elimination, the free variables
+/// (actuators without bounds) being preferred, and expressed from the other ones xN:
+///   xB = t0 - T xN,   with T = AeqB^-1 AeqN and t0 = AeqB^-1 beq
+/// i.e. x = x0 + Z xN. The reduced QP in xN has dim-nbEq variables, the Hessian Z^T Q Z, the inequality
+/// rows A Z and, for the basic variables with finite bounds, the rows -T xN within [l-t0, u-t0]. It has no
+/// equality constraint. The solution and the multipliers of the full QP (qpOASES layout [bounds; A; Aeq])
+/// are recovered from the ones of the reduced QP, the multipliers of the equalities by AeqB^-T.
+class SOFA_SOFTROBOTS_INVERSE_API QPEqualityElimination
+{
+public:
+    typedef QPInverseProblem::RowMajorMatrixXd RowMajorMatrixXd;
+
+    void setTolerance(const double& tolerance) {m_tolerance = tolerance;}
+
+    /// Builds the reduced QP of system, returns false if system has no equality constraint or if Aeq
+    /// is rank deficient. The rows of the reduced QP keep the ids of constraintsId (if it has a row per
+    /// constraint), the rows on the basic variables get the ids -1, -2, ...
+    bool reduce(const QPInverseProblem::QPSystem& system, const vector<int>& constraintsId);
+
+    QPInverseProblem::QPSystem* getReducedSystem() {return &m_reduced;}
+    vector<int>& getReducedConstraintsId() {return m_reducedConstraintsId;}
+    unsigned int getNbEliminatedVariables() const {return m_basic.size();}
+
+    /// Objective of the full QP at x minus the one of the reduced QP
+    double getObjectiveOffset() const {return m_objectiveOffset;}
+
+    /// Solution x and multipliers dual (can be null) of the full QP system given to reduce(), from the
+    /// ones of the reduced QP (reducedX and reducedDual can be the same buffers as x and dual)
+    void expand(const QPInverseProblem::QPSystem& system, const double* reducedX, const double* reducedDual,
+                double* x, double* dual);
+
+    size_t getMemoryUsage() const;
+
+protected:
+    double m_tolerance{1e-10};
+
+    QPInverseProblem::QPSystem m_reduced;
+    vector<int> m_reducedConstraintsId;
+
+    vector<int> m_basic;    // Basic variables, in the order of the columns of AeqB
+    vector<int> m_nonBasic; // Variables of the reduced QP
+    vector<int> m_boundedBasic; // Basic variables with a row in the reduced QP
+    RowMajorMatrixXd m_Z;  // x = x0 + Z xN
+    Eigen::VectorXd m_x0;
+    Eigen::PartialPivLU<Eigen::MatrixXd> m_AeqBT; // AeqB^T, for the multipliers of the equalities
+    double m_objectiveOffset{0.};
+
+    RowMajorMatrixXd m_elimination; // Scratch of the choice of the basic variables
+    Eigen::VectorXd m_x;
+    Eigen::VectorXd m_dual;
+    Eigen::VectorXd m_residual;
+
+    bool chooseBasicVariables(const QPInverseProblem::QPSystem& system);
+};
+
+} // namespace
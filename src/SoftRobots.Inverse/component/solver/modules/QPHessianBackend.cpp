@@ -0,0 +1,66 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#include <Eigen/Core>
+
+#include <SoftRobots.Inverse/component/solver/modules/QPHessianBackend.h>
+#ifdef SOFTROBOTSINVERSE_HAS_CUDA
+#include <SoftRobots.Inverse/component/solver/modules/QPCUDAHessianBackend.h>
+#endif
+
+
+namespace softrobotsinverse::solver::module
+{
+
+QPHessianBackend* QPHessianBackend::create(const std::string& name)
+{
+    if(name == "CPU")
+        return new QPCPUHessianBackend();
+#ifdef SOFTROBOTSINVERSE_HAS_CUDA
+    if(name == "CUDA")
+    {
+        QPCUDAHessianBackend* backend = new QPCUDAHessianBackend();
+        if(backend->isReady())
+            return backend;
+        delete backend;
+    }
+#endif
+    return nullptr;
+}
+
+
+void QPCPUHessianBackend::computeProduct(int nbEffectors, int nbVariables, const double* Wea, double* Q)
+{
+    typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> RowMajorMatrixXd;
+    Eigen::Map<const RowMajorMatrixXd> mappedWea(Wea, nbEffectors, nbVariables);
+    Eigen::Map<RowMajorMatrixXd> mappedQ(Q, nbVariables, nbVariables);
+    mappedQ.setZero();
+    mappedQ.selfadjointView<Eigen::Lower>().rankUpdate(mappedWea.transpose());
+}
+
+} // namespace
@@ -0,0 +1,71 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include <SoftRobots.Inverse/component/config.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+/// Dense product forming the Hessian of the inverse problem from the effector rows of W:
+///     Q = Wea^T Wea
+/// Wea (nbEffectors x nbVariables) and Q (nbVariables x nbVariables) are row-major. Only the lower
+/// triangle of Q is computed, the upper one is left undefined (it is mirrored by the caller).
+class SOFA_SOFTROBOTS_INVERSE_API QPHessianBackend
+{
+public:
+    virtual ~QPHessianBackend() {}
+
+    virtual void computeProduct(int nbEffectors, int nbVariables, const double* Wea, double* Q) = 0;
+
+    virtual std::string getName() const = 0;
+
+    /// Memory held by the backend in bytes (host and device)
+    virtual size_t getMemoryUsage() const {return 0;}
+
+    /// Creates the backend of the given name ("CPU", or "CUDA" if the plugin is built with
+    /// SOFTROBOTSINVERSE_WITH_CUDA), nullptr if unknown or unavailable
+    static QPHessianBackend* create(const std::string& name);
+};
+
+
+/// Symmetric rank-k update of Eigen, on the calling thread
+class SOFA_SOFTROBOTS_INVERSE_API QPCPUHessianBackend : public QPHessianBackend
+{
+public:
+    void computeProduct(int nbEffectors, int nbVariables, const double* Wea, double* Q) override;
+
+    std::string getName() const override {return "CPU";}
+};
+
+} // namespace
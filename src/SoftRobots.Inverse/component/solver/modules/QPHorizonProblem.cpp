@@ -0,0 +1,233 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <SoftRobots.Inverse/component/solver/modules/QPHorizonProblem.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+using Eigen::MatrixXd;
+using Eigen::VectorXd;
+
+
+bool QPHorizonProblem::solve(ConstRefMat Q, ConstRefVec c, ConstRefMat Wea, ConstRefMat Waa, ConstRefVec dFreeActuators,
+                             const QPInverseProblem::QPActuatorBounds& bounds, const vector<double>& previousLambda,
+                             vector<double>& lambda)
+{
+    const Eigen::Index n = Q.rows();
+    const bool hasPrevious = (previousLambda.size() == size_t(n));
+    m_isConstrained = false;
+
+    // The decomposition is shared by all the steps, and kept while Q does not change
+    if(m_Q.rows() != n || m_Q != Q)
+    {
+        m_Q = Q;
+        m_eigenSolver.compute(m_Q);
+        m_nbFactorizations++;
+    }
+
+    buildLinearTerms(c, Wea, previousLambda, hasPrevious);
+
+    if(m_eigenSolver.info() != Eigen::Success || !solveUnconstrained(hasPrevious) || !isFeasible(Waa, dFreeActuators, bounds))
+    {
+        m_isConstrained = true;
+        if(!solveDense(Waa, dFreeActuators, bounds, hasPrevious))
+            return false;
+    }
+
+    const VectorXd first = m_plan.col(0);
+    m_objective = 0.5*first.dot(Q*first) + c.dot(first);
+    lambda.resize(n);
+    for(Eigen::Index i=0; i<n; i++)
+        lambda[i] = first(i);
+    return true;
+}
+
+
+void QPHorizonProblem::buildLinearTerms(ConstRefVec c, ConstRefMat Wea, const vector<double>& previousLambda,
+                                        const bool& hasPrevious)
+{
+    const Eigen::Index n = c.size();
+    const Eigen::Index nbEffectors = Wea.rows();
+    const size_t nbGivenSteps = (nbEffectors>0 && m_targetShifts.size()%nbEffectors == 0)? m_targetShifts.size()/nbEffectors : 0;
+
+    // g_k = c - Wea^T s_k, and the variation from the previous step moves to the linear term of the first step
+    m_g.resize(n, m_horizon);
+    m_g.col(0) = c;
+    for(unsigned int k=1; k<m_horizon; k++)
+    {
+        m_g.col(k) = c;
+        if(nbGivenSteps>0)
+        {
+            const size_t step = std::min(size_t(k), nbGivenSteps) - 1;
+            const QPInverseProblem::ConstVectorView shift(m_targetShifts.data() + step*nbEffectors, nbEffectors);
+            m_g.col(k).noalias() -= Wea.transpose()*shift;
+        }
+    }
+
+    if(hasPrevious)
+        for(Eigen::Index i=0; i<n; i++)
+            m_g(i, 0) -= m_variationWeight*previousLambda[i];
+}
+
+
+bool QPHorizonProblem::solveUnconstrained(const bool& hasPrevious)
+{
+    const Eigen::Index n = m_g.rows();
+    const double rho = m_variationWeight;
+    const VectorXd& mu = m_eigenSolver.eigenvalues();
+    const MatrixXd& V = m_eigenSolver.eigenvectors();
+    const double tolerance = 1e-12*(mu.cwiseAbs().maxCoeff() + rho + 1e-300);
+
+    // In the basis V, the mode i of the steps follows the scalar tridiagonal system
+    //     (mu_i + rho*nbNeighbours_k) y_k - rho y_{k-1} - rho y_{k+1} = -(V^T g_k)_i
+    const MatrixXd h = V.transpose()*m_g;
+    MatrixXd cp(n, m_horizon), dp(n, m_horizon);
+    for(unsigned int k=0; k<m_horizon; k++)
+    {
+        const double nbNeighbours = double((k>0 || hasPrevious) ? 1 : 0) + double((k+1<m_horizon)? 1 : 0);
+        for(Eigen::Index i=0; i<n; i++)
+        {
+            double pivot = mu(i) + rho*nbNeighbours;
+            double rhs = -h(i, k);
+            if(k>0)
+            {
+                pivot += rho*cp(i, k-1);
+                rhs += rho*dp(i, k-1);
+            }
+            if(pivot <= tolerance) // singular mode, left to the dense resolution
+                return false;
+            cp(i, k) = -rho/pivot;
+            dp(i, k) = rhs/pivot;
+        }
+    }
+
+    MatrixXd& y = dp; // back substitution in place
+    for(int k=int(m_horizon)-2; k>=0; k--)
+        y.col(k) -= cp.col(k).cwiseProduct(y.col(k+1));
+
+    m_plan.noalias() = V*y;
+    return true;
+}
+
+
+bool QPHorizonProblem::isFeasible(ConstRefMat Waa, ConstRefVec dFreeActuators,
+                                  const QPInverseProblem::QPActuatorBounds& bounds) const
+{
+    const Eigen::Index n = m_plan.rows();
+    for(unsigned int k=0; k<m_horizon; k++)
+    {
+        const VectorXd delta = Waa*m_plan.col(k) + dFreeActuators;
+        for(Eigen::Index i=0; i<n; i++)
+        {
+            const double l = m_plan(i, k);
+            if(l < bounds.lambdaMin[i] - 1e-9*(1.+std::abs(bounds.lambdaMin[i])) ||
+               l > bounds.lambdaMax[i] + 1e-9*(1.+std::abs(bounds.lambdaMax[i])) ||
+               delta(i) < bounds.deltaMin[i] - 1e-9*(1.+std::abs(bounds.deltaMin[i])) ||
+               delta(i) > bounds.deltaMax[i] + 1e-9*(1.+std::abs(bounds.deltaMax[i])))
+                return false;
+        }
+    }
+    return true;
+}
+
+
+bool QPHorizonProblem::solveDense(ConstRefMat Waa, ConstRefVec dFreeActuators,
+                                  const QPInverseProblem::QPActuatorBounds& bounds, const bool& hasPrevious)
+{
+    const int n = int(m_g.rows());
+    const int H = int(m_horizon);
+    const int nbVariables = n*H;
+    const double rho = m_variationWeight;
+
+    // Rows of the actuators with a limit on their displacement
+    vector<int> deltaRows;
+    for(int i=0; i<n; i++)
+        if(bounds.deltaMin[i] > -1e20 || bounds.deltaMax[i] < 1e20)
+            deltaRows.push_back(i);
+    const int nbDeltaRows = int(deltaRows.size());
+    const int nbConstraints = nbDeltaRows*H;
+
+    m_H.assign(size_t(nbVariables)*nbVariables, 0.);
+    m_gDense.resize(nbVariables);
+    m_lb.resize(nbVariables);
+    m_ub.resize(nbVariables);
+    m_A.assign(size_t(nbConstraints)*nbVariables, 0.);
+    m_lbA.resize(nbConstraints);
+    m_ubA.resize(nbConstraints);
+    m_x.assign(nbVariables, 0.);
+    m_y.resize(nbVariables + nbConstraints);
+
+    for(int k=0; k<H; k++)
+    {
+        const double nbNeighbours = double((k>0 || hasPrevious) ? 1 : 0) + double((k+1<H)? 1 : 0);
+        for(int i=0; i<n; i++)
+        {
+            const int row = k*n + i;
+            real_t* Hrow = m_H.data() + size_t(row)*nbVariables;
+            for(int j=0; j<n; j++)
+                Hrow[k*n + j] = m_Q(i, j);
+            Hrow[row] += rho*nbNeighbours;
+            if(k>0)   Hrow[row - n] = -rho;
+            if(k+1<H) Hrow[row + n] = -rho;
+
+            m_gDense[row] = m_g(i, k);
+            m_lb[row] = bounds.lambdaMin[i];
+            m_ub[row] = bounds.lambdaMax[i];
+        }
+
+        for(int r=0; r<nbDeltaRows; r++)
+        {
+            const int i = deltaRows[r];
+            const int row = k*nbDeltaRows + r;
+            real_t* Arow = m_A.data() + size_t(row)*nbVariables;
+            for(int j=0; j<n; j++)
+                Arow[k*n + j] = Waa(i, j);
+            m_lbA[row] = bounds.deltaMin[i] - dFreeActuators(i);
+            m_ubA[row] = bounds.deltaMax[i] - dFreeActuators(i);
+        }
+    }
+
+    real_t objective;
+    if(!m_backend.solve(nbVariables, nbConstraints, m_H.data(), m_gDense.data(), m_A.data(),
+                        m_lb.data(), m_ub.data(), m_lbA.data(), m_ubA.data(),
+                        m_x.data(), m_y.data(), objective))
+        return false;
+
+    m_plan.resize(n, H);
+    for(int k=0; k<H; k++)
+        for(int i=0; i<n; i++)
+            m_plan(i, k) = m_x[k*n + i];
+    return true;
+}
+
+} // namespace
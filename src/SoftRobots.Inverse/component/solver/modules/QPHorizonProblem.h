@@ -0,0 +1,121 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <Eigen/Core>
+#include <Eigen/Eigenvalues>
+#include <sofa/type/vector.h>
+
+#include <SoftRobots.Inverse/component/solver/modules/QPInverseProblem.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPSolverBackend.h>
+#include <SoftRobots.Inverse/component/config.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+using sofa::type::vector;
+
+/// Model-predictive actuation of the actuator-only problem over H steps. W is assumed constant over the
+/// horizon, the effector violations of the step k are dFree_e - s_k, with s_k the displacement of the
+/// targets from the current step (s_0 = 0), and the actuation of consecutive steps is coupled by a
+/// penalty on its variation:
+///     min sum_k ( 1/2 l_k^T Q l_k + (c - Wea^T s_k)^T l_k ) + rho/2 sum_k |l_k - l_{k-1}|^2
+///     s.t. lambdaMin <= l_k <= lambdaMax,    deltaMin <= Waa l_k + dFree_a <= deltaMax
+/// with Q and c the Hessian and the linear term of the single-step QP (energy term included), and
+/// l_{-1} the actuation of the previous step. Only l_0 is applied, the plan is computed again at the
+/// next step (receding horizon).
+///
+/// The Hessian of the stacked problem is block tridiagonal with blocks built from Q and the identity, so
+/// one eigendecomposition Q = V diag(mu) V^T diagonalizes all of them: in the basis V, each mode is a
+/// scalar tridiagonal system over the horizon, solved by a Riccati-like forward/backward recursion. The
+/// plan costs one decomposition of the size of the actuators, kept while Q does not change, and O(H n^2).
+/// When the unconstrained plan violates a bound, the stacked QP is solved densely instead.
+class SOFA_SOFTROBOTS_INVERSE_API QPHorizonProblem
+{
+public:
+    typedef const Eigen::Ref<const Eigen::MatrixXd> ConstRefMat;
+    typedef const Eigen::Ref<const Eigen::VectorXd> ConstRefVec;
+
+    /// Number of steps of the horizon, 1 (default) for the single-step problem
+    void setHorizon(const unsigned int& horizon) {m_horizon = (horizon>0)? horizon : 1;}
+    unsigned int getHorizon() const {return m_horizon;}
+
+    /// Weight rho of the variation of the actuation between consecutive steps
+    void setVariationWeight(const double& weight) {m_variationWeight = (weight>0.)? weight : 0.;}
+
+    /// Displacements of the targets of the effector rows at the steps 1..H-1, given step by step
+    /// ((H-1) x nbEffectors values). Missing steps keep the targets of the last given step, none
+    /// keeps the current targets over the horizon.
+    template<class Real>
+    void setTargetShifts(const vector<Real>& shifts) {m_targetShifts.assign(shifts.begin(), shifts.end());}
+
+    /// Plans the actuation of the horizon and writes its first step into lambda. Q, c (size of the
+    /// actuators) and Wea (effectors x actuators) are those of the single-step QP, Waa and dFreeActuators
+    /// give the actuator displacements. previousLambda is empty at the first step. Returns false if the
+    /// stacked problem could not be solved.
+    bool solve(ConstRefMat Q, ConstRefVec c, ConstRefMat Wea, ConstRefMat Waa, ConstRefVec dFreeActuators,
+               const QPInverseProblem::QPActuatorBounds& bounds, const vector<double>& previousLambda,
+               vector<double>& lambda);
+
+    /// Actuation planned for each step (nbActuators x H) by the last resolution
+    const Eigen::MatrixXd& getPlan() const {return m_plan;}
+    /// Whether the last resolution had an active bound and was solved densely
+    bool isConstrained() const {return m_isConstrained;}
+    /// Single-step objective 1/2 l_0^T Q l_0 + c^T l_0 of the last resolution
+    double getObjective() const {return m_objective;}
+    /// Number of eigendecompositions of Q, one per change of Q
+    unsigned int getNbFactorizations() const {return m_nbFactorizations;}
+
+protected:
+    unsigned int m_horizon{1};
+    double m_variationWeight{0.};
+    vector<double> m_targetShifts;
+
+    Eigen::MatrixXd m_Q;
+    Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> m_eigenSolver;
+    unsigned int m_nbFactorizations{0};
+
+    Eigen::MatrixXd m_g;    // Linear term of each step, nbActuators x H
+    Eigen::MatrixXd m_plan; // nbActuators x H
+    bool m_isConstrained{false};
+    double m_objective{0.};
+
+    // Dense stacked QP
+    QPOASESSolverBackend m_backend;
+    vector<real_t> m_H, m_gDense, m_A, m_lb, m_ub, m_lbA, m_ubA, m_x, m_y;
+
+    void buildLinearTerms(ConstRefVec c, ConstRefMat Wea, const vector<double>& previousLambda, const bool& hasPrevious);
+    bool solveUnconstrained(const bool& hasPrevious);
+    bool isFeasible(ConstRefMat Waa, ConstRefVec dFreeActuators, const QPInverseProblem::QPActuatorBounds& bounds) const;
+    bool solveDense(ConstRefMat Waa, ConstRefVec dFreeActuators, const QPInverseProblem::QPActuatorBounds& bounds,
+                    const bool& hasPrevious);
+};
+
+} // namespace
@@ -31,9 +31,15 @@
 
 #include <SoftRobots.Inverse/component/solver/modules/QPInverseProblem.h>
 #include <SoftRobots.Inverse/component/solver/modules/QPInverseProblemImpl.h>
+#include <SoftRobots.Inverse/component/behavior/ConcurrentResults.h>
+#include <SoftRobots.Inverse/component/behavior/EffectorDeadband.h>
+#include <SoftRobots.Inverse/component/behavior/EffectorPriority.h>
+#include <SoftRobots.Inverse/component/behavior/EffectorWeights.h>
 
 #include <sofa/helper/LCPcalc.h>
+#include <sofa/simulation/MainTaskSchedulerFactory.h>
 #include <qpOASES.hpp>
+#include <algorithm>
 #include <fstream>
 
 #include <iomanip>
@@ -83,12 +89,81 @@ QPInverseProblem::~QPInverseProblem()
 }
 
 
+void QPInverseProblem::getRowBlocks(const vector<unsigned int>& rowIds, vector<QPRowBlock>& blocks)
+{
+    blocks.clear();
+    for(unsigned int i=0; i<rowIds.size(); i++)
+    {
+        if(!blocks.empty() && rowIds[i] == blocks.back().first + blocks.back().size)
+            blocks.back().size++;
+        else
+            blocks.push_back({rowIds[i], 1, i});
+    }
+}
+
+
+void QPInverseProblem::getMemoryUsage(QPMemoryUsage& usage) const
+{
+    const size_t dim = W.rowSize();
+    usage.compliance = dim*W.colSize()*sizeof(SReal) + dim*sizeof(SReal*)
+            + (dFree.size() + f.size())*sizeof(SReal);
+
+    const QPSystem& system = *m_qpSystem;
+    usage.qpSystem = system.Q.getMemoryUsage() + system.A.getMemoryUsage() + system.Aeq.getMemoryUsage()
+            + sizeof(double)*(system.c.capacity() + system.bl.capacity() + system.bu.capacity() + system.beq.capacity()
+                              + system.l.capacity() + system.u.capacity() + system.delta.capacity()
+                              + system.lambda.capacity() + system.previousResult.capacity());
+    usage.solvers = 0;
+}
+
+
 void QPInverseProblem::clear(int nbC)
 {
     ConstraintProblem::clear(nbC);
 }
 
 
+void QPInverseProblem::clearMatrixFree(int nbC)
+{
+    dimension = nbC;
+    W.resize(0, 0);
+    dFree.resize(nbC);
+    f.resize(nbC);
+    dFree.clear();
+    f.clear();
+}
+
+
+void QPInverseProblem::clearBlocks(int nbC, const vector<bool>& isClearedRow)
+{
+    // W is reallocated and cleared entirely when its size changes
+    if(nbC != getDimension() || W.rowSize() != nbC || W.colSize() != nbC || isClearedRow.size() != size_t(nbC))
+    {
+        clear(nbC);
+        return;
+    }
+
+    dFree.clear();
+    f.clear();
+
+    m_clearedRowIds.clear();
+    for(int i=0; i<nbC; i++)
+        if(isClearedRow[i])
+            m_clearedRowIds.push_back(i);
+    getRowBlocks(m_clearedRowIds, m_clearedBlocks);
+
+    for(int i=0; i<nbC; i++)
+    {
+        double* Wi = W[i];
+        if(isClearedRow[i])
+            std::fill(Wi, Wi + nbC, 0.);
+        else
+            for(const QPRowBlock& block : m_clearedBlocks)
+                std::fill(Wi + block.first, Wi + block.first + block.size, 0.);
+    }
+}
+
+
 void QPInverseProblem::solveTimed(double tol, int maxIt, double timeout)
 {
     SOFA_UNUSED(tol);
@@ -110,6 +185,15 @@ void QPInverseProblem::clearProblem()
     m_qpCLists->effectorRowIds.clear();
     m_qpCLists->sensorRowIds.clear();
     m_qpCLists->contactRowIds.clear();
+    m_qpCLists->contactIds.clear();
+    m_qpCLists->variableRows.clear();
+    m_qpCLists->disabledEffectorRows.clear();
+    m_qpCLists->effectorWeightBlocks.clear();
+    m_qpCLists->effectorWeights.clear();
+    m_qpCLists->effectorRowLevels.clear();
+    m_qpCLists->effectorDeadbands.clear();
+    m_qpCLists->actuatorBounds.clear(0);
+    m_qpCLists->hasBothSideActuatorLimits = false;
 
     m_qpSystem->A.clear();
     m_qpSystem->Aeq.clear();
@@ -119,23 +203,195 @@ void QPInverseProblem::clearProblem()
 
     m_qpSystem->Q.clear();
     m_qpSystem->c.clear();
+    m_hasQChanged = true;
 }
 
 
-void QPInverseProblem::storeResults(const vector<double> &x)
+void QPInverseProblem::updateContactIds(const sofa::core::ConstraintParams* cParams)
+{
+    const vector<unsigned int>& contactRowIds = m_qpCLists->contactRowIds;
+    vector<QPContactId>& contactIds = m_qpCLists->contactIds;
+    contactIds.assign(contactRowIds.size(), QPContactId());
+
+    // A component appears once per group of rows in the list of contacts
+    vector<const BaseConstraint*> visited;
+    BaseConstraint::VecConstraintBlockInfo blocks;
+    BaseConstraint::VecPersistentID ids;
+    for(BaseConstraint* contact : m_qpCLists->contacts)
+    {
+        if(std::find(visited.begin(), visited.end(), contact) != visited.end())
+            continue;
+        visited.push_back(contact);
+
+        blocks.clear();
+        ids.clear();
+        contact->getConstraintInfo(cParams, blocks, ids);
+
+        // The component is kept for the rows without persistent id, for the contact tracker
+        for(const BaseConstraint::ConstraintBlockInfo& block : blocks)
+        {
+            for(int group=0; group<block.nbGroups; group++)
+                for(int line=0; line<block.nbLines; line++)
+                {
+                    // The contact rows are stored in increasing order
+                    const unsigned int row = block.const0 + group*block.nbLines + line;
+                    auto it = std::lower_bound(contactRowIds.begin(), contactRowIds.end(), row);
+                    if(it == contactRowIds.end() || *it != row)
+                        continue;
+
+                    QPContactId& contactId = contactIds[it - contactRowIds.begin()];
+                    contactId.constraint = contact;
+                    if(block.hasId)
+                        contactId.id = ids[block.offsetId + group];
+                }
+        }
+    }
+}
+
+
+void QPInverseProblem::QPConstraintLists::updateVariableRows()
+{
+    const unsigned int nbActuatorRows = actuatorRowIds.size();
+    const unsigned int nbEqualityRows = equalityRowIds.size();
+    variableRows.assign(nbActuatorRows + nbEqualityRows + contactRowIds.size(), QPVariableRow());
+
+    unsigned int k = 0;
+    for(unsigned int i=0; i<actuators.size() + equality.size(); i++)
+    {
+        const bool isActuator = (i<actuators.size());
+        SoftRobotsBaseConstraint* constraint = (isActuator)? actuators[i] : equality[i-actuators.size()];
+        const unsigned int nbLines = constraint->getNbLines();
+
+        QPVariableRow row;
+        row.owner = constraint;
+        row.nbLines = nbLines;
+        row.isDisabled = isActuator && isDisabled(constraint);
+        row.hasEpsilon = constraint->hasEpsilon();
+        row.hasLambdaInit = constraint->hasLambdaInit();
+        row.hasLambdaMin = constraint->hasLambdaMin();
+        row.hasLambdaMax = constraint->hasLambdaMax();
+        row.hasLambdaEqual = constraint->hasLambdaEqual();
+        row.hasDeltaMin = constraint->hasDeltaMin();
+        row.hasDeltaMax = constraint->hasDeltaMax();
+        row.hasDeltaEqual = constraint->hasDeltaEqual();
+        if(row.hasEpsilon)
+            row.epsilon = constraint->getEpsilon();
+
+        for(unsigned int line=0; line<nbLines && k<variableRows.size(); line++, k++)
+        {
+            row.line = line;
+            if(row.hasLambdaInit)  row.lambdaInit = constraint->getLambdaInit(line);
+            if(row.hasLambdaMin)   row.lambdaMin = constraint->getLambdaMin(line);
+            if(row.hasLambdaMax)   row.lambdaMax = constraint->getLambdaMax(line);
+            if(row.hasLambdaEqual) row.lambdaEqual = constraint->getLambdaEqual(line);
+            if(row.hasDeltaMin)    row.deltaMin = constraint->getDeltaMin(line);
+            if(row.hasDeltaMax)    row.deltaMax = constraint->getDeltaMax(line);
+            if(row.hasDeltaEqual)  row.deltaEqual = constraint->getDeltaEqual(line);
+            variableRows[k] = row;
+        }
+    }
+
+    updateEffectorRows();
+
+    updateActuatorBounds();
+}
+
+
+void QPInverseProblem::QPConstraintLists::updateEffectorRows()
+{
+    disabledEffectorRows.clear();
+    effectorWeightBlocks.clear();
+    effectorWeights.clear();
+    effectorRowLevels.clear();
+    effectorDeadbands.clear();
+
+    const unsigned int nbEffectorRows = effectorRowIds.size();
+    unsigned int line = 0;
+    bool hasLevels = false;
+    for(SoftRobotsBaseConstraint* effector : effectors)
+    {
+        const unsigned int nbLines = effector->getNbLines();
+
+        const auto* prioritized = dynamic_cast<const softrobotsinverse::behavior::EffectorPriority*>(effector);
+        const unsigned int level = (prioritized)? prioritized->getPriority() : 0;
+        hasLevels |= (!effectorRowLevels.empty() && level != effectorRowLevels.front());
+        effectorRowLevels.insert(effectorRowLevels.end(), nbLines, level);
+
+        if(isDisabled(effector))
+        {
+            disabledEffectorRows.resize(nbEffectorRows, false);
+            for(unsigned int k=line; k<line+nbLines && k<nbEffectorRows; k++)
+                disabledEffectorRows[k] = true;
+        }
+        else if(line+nbLines <= nbEffectorRows)
+        {
+            const auto* deadband = dynamic_cast<const softrobotsinverse::behavior::EffectorDeadband*>(effector);
+            if(deadband && deadband->getDeadband() > 0.)
+                effectorDeadbands.push_back({line, nbLines, deadband->getDeadband()});
+        }
+
+        // The weights are only kept when their blocks match the rows of the effector
+        const auto* weighted = dynamic_cast<const softrobotsinverse::behavior::EffectorWeights*>(effector);
+        unsigned int blockSize = 1;
+        const unsigned int offset = effectorWeights.size();
+        if(weighted && weighted->getRowWeights(blockSize, effectorWeights))
+        {
+            if(blockSize > 0 && nbLines%blockSize == 0 && line+nbLines <= nbEffectorRows
+                    && effectorWeights.size() == offset + nbLines*blockSize)
+            {
+                for(unsigned int k=0; k<nbLines; k+=blockSize)
+                    effectorWeightBlocks.push_back({line+k, blockSize, offset + k*blockSize});
+            }
+            else
+                effectorWeights.resize(offset);
+        }
+        line += nbLines;
+    }
+
+    if(!hasLevels || effectorRowLevels.size() != nbEffectorRows)
+        effectorRowLevels.clear();
+}
+
+
+void QPInverseProblem::QPConstraintLists::updateActuatorBounds()
+{
+    const unsigned int nbActuatorRows = std::min<size_t>(actuatorRowIds.size(), variableRows.size());
+    actuatorBounds.clear(actuatorRowIds.size());
+    hasBothSideActuatorLimits = false;
+
+    for(unsigned int k=0; k<nbActuatorRows; k++)
+    {
+        const QPVariableRow& row = variableRows[k];
+
+        // The limits flags are kept, so that the rows of A stay, but a disabled actuator does not move
+        if(row.isDisabled)
+        {
+            actuatorBounds.lambdaMin[k] = 0.;
+            actuatorBounds.lambdaMax[k] = 0.;
+        }
+        else
+        {
+            if(row.hasLambdaMin) actuatorBounds.lambdaMin[k] = row.lambdaMin;
+            if(row.hasLambdaMax) actuatorBounds.lambdaMax[k] = row.lambdaMax;
+            if(row.hasDeltaMin)  actuatorBounds.deltaMin[k] = row.deltaMin;
+            if(row.hasDeltaMax)  actuatorBounds.deltaMax[k] = row.deltaMax;
+        }
+
+        if((row.hasDeltaMax && row.hasDeltaMin) || (row.hasLambdaMax && row.hasLambdaMin))
+            hasBothSideActuatorLimits = true;
+    }
+}
+
+
+void QPInverseProblem::storeForces(const vector<double> &x)
 {
     double *lambda = getF();
-    double **w = getW();
-    double *dfree = getDfree();
 
     unsigned int nbActuatorRows = m_qpCLists->actuatorRowIds.size();
     unsigned int nbEffectorRows = m_qpCLists->effectorRowIds.size();
     unsigned int nbSensorRows   = m_qpCLists->sensorRowIds.size();
     unsigned int nbContactRows  = m_qpCLists->contactRowIds.size();
     unsigned int nbEqualityRows     = m_qpCLists->equalityRowIds.size();
-    unsigned int nbRows = nbEffectorRows + nbActuatorRows + nbContactRows + nbSensorRows + nbEqualityRows;
-
-    m_qpSystem->delta.resize(nbRows);
 
     for(unsigned int i=0; i<nbEffectorRows; i++)
         lambda[m_qpCLists->effectorRowIds[i]] = 0;
@@ -151,98 +407,221 @@ void QPInverseProblem::storeResults(const vector<double> &x)
 
     for(unsigned int i=0; i<nbContactRows; i++)
         lambda[m_qpCLists->contactRowIds[i]] = x[i+nbActuatorRows+nbEqualityRows];
+}
 
 
-    for(unsigned int i=0; i<nbRows; i++)
+void QPInverseProblem::storeResults(const vector<double> &x)
+{
+    double *lambda = getF();
+    double **w = getW();
+    double *dfree = getDfree();
+
+    unsigned int nbRows = m_qpCLists->effectorRowIds.size() + m_qpCLists->actuatorRowIds.size() + m_qpCLists->contactRowIds.size()
+                          + m_qpCLists->sensorRowIds.size() + m_qpCLists->equalityRowIds.size();
+
+    m_qpSystem->delta.resize(nbRows);
+    storeForces(x);
+
+    // Only the columns of the QP variables contribute to delta = W*lambda + dfree. They are visited by
+    // blocks of consecutive rows, in increasing order as the sum over all the columns
+    m_variableRowIds = m_qpCLists->actuatorRowIds;
+    m_variableRowIds.insert(m_variableRowIds.end(), m_qpCLists->equalityRowIds.begin(), m_qpCLists->equalityRowIds.end());
+    m_variableRowIds.insert(m_variableRowIds.end(), m_qpCLists->contactRowIds.begin(), m_qpCLists->contactRowIds.end());
+    std::sort(m_variableRowIds.begin(), m_variableRowIds.end());
+    getRowBlocks(m_variableRowIds, m_variableBlocks);
+
+    auto computeDelta = [&](const unsigned int& i)
     {
         m_qpSystem->delta[i] = dfree[i];
-        for(unsigned int j=0; j<nbRows; j++)
-            m_qpSystem->delta[i] += lambda[j]*w[i][j];
+        const double* wi = w[i];
+        for(const QPRowBlock& block : m_variableBlocks)
+            for(unsigned int j=block.first; j<block.first+block.size; j++)
+                m_qpSystem->delta[i] += lambda[j]*wi[j];
+    };
+
+    if(m_lazySensors)
+    {
+        // Neither dfree nor the compliance of the sensors were computed
+        for(unsigned int rowId : m_qpCLists->sensorRowIds)
+            m_qpSystem->delta[rowId] = 0.;
+        for(const vector<unsigned int>* rowIds : {&m_qpCLists->effectorRowIds, &m_qpCLists->actuatorRowIds,
+                                                  &m_qpCLists->equalityRowIds, &m_qpCLists->contactRowIds})
+            for(unsigned int rowId : *rowIds)
+                computeDelta(rowId);
     }
+    else
+        for(unsigned int i=0; i<nbRows; i++)
+            computeDelta(i);
+
+    m_hasPendingResults = m_detached;
+    if(!m_detached)
+        sendResults();
+}
+
 
+void QPInverseProblem::storeResults(const vector<double> &x, const vector<double> &Wlambda)
+{
+    const double *dfree = getDfree();
+    const unsigned int nbRows = Wlambda.size();
+
+    m_qpSystem->delta.resize(nbRows);
+    storeForces(x);
+    for(unsigned int i=0; i<nbRows; i++)
+        m_qpSystem->delta[i] = dfree[i] + Wlambda[i];
+
+    // Neither dfree nor the compliance of the sensors were computed
+    if(m_lazySensors)
+        for(unsigned int rowId : m_qpCLists->sensorRowIds)
+            m_qpSystem->delta[rowId] = 0.;
+
+    m_hasPendingResults = m_detached;
+    if(!m_detached)
+        sendResults();
+}
+
+
+bool QPInverseProblem::sendPendingResults()
+{
+    if(!m_hasPendingResults)
+        return false;
+
+    m_hasPendingResults = false;
     sendResults();
+    return true;
 }
 
 
 void QPInverseProblem::sendResults()
 {
-    double *lambda = getF();
-
-    int line = 0;
-    for(unsigned int i=0; i<m_qpCLists->actuators.size(); i++) // For each actuator component
+    m_concurrentSenders.clear();
+    m_serialSenders.clear();
+    addResultsSenders(m_qpCLists->actuators, m_qpCLists->actuatorRowIds, true);
+    addResultsSenders(m_qpCLists->equality, m_qpCLists->equalityRowIds, true);
+    addResultsSenders(m_qpCLists->effectors, m_qpCLists->effectorRowIds, false);
+    if(!m_lazySensors)
+        addResultsSenders(m_qpCLists->sensors, m_qpCLists->sensorRowIds, false);
+
+    if(!m_concurrentSenders.empty())
     {
-        vector<double> localLambda, localDelta;
-        int nbLines = m_qpCLists->actuators[i]->getNbLines();
+        // Each task sends the results of a range of the constraints
+        sofa::simulation::TaskScheduler* taskScheduler = sofa::simulation::MainTaskSchedulerFactory::createInRegistry();
+        sofa::simulation::CpuTask::Status status;
 
-        localLambda.resize(nbLines);
-        localDelta.resize(nbLines);
+        const unsigned int nbSenders = m_concurrentSenders.size();
+        const unsigned int nbTasks = std::max(1u, std::min(taskScheduler->getThreadCount(), nbSenders));
+        const unsigned int nbSendersPerTask = (nbSenders + nbTasks - 1) / nbTasks;
 
-        for(int j=0; j<nbLines; j++)
+        vector<SendResultsTask> tasks;
+        tasks.resize(nbTasks, SendResultsTask(&status));
+        for(unsigned int k=0; k<nbTasks; k++)
         {
-            localLambda[j] = lambda[m_qpCLists->actuatorRowIds[line]];
-            localDelta[j]  = m_qpSystem->delta[m_qpCLists->actuatorRowIds[line]];
-            line++;
+            const unsigned int begin = std::min(nbSenders, k*nbSendersPerTask);
+            const unsigned int end = std::min(nbSenders, begin+nbSendersPerTask);
+            tasks[k].set(this, m_concurrentSenders.data() + begin, m_concurrentSenders.data() + end);
+            taskScheduler->addTask(&tasks[k]);
         }
+        taskScheduler->workUntilDone(&status);
+    }
 
-        m_qpCLists->actuators[i]->storeResults(localLambda,localDelta);
+    for(const QPResultsSender& sender : m_serialSenders)
+        sendResults(sender, m_localLambda, m_localDelta);
+}
 
-        // Allows actuators to change value of force if needed (from the call to storeResults)
-        for(int j=0; j<nbLines; j++)
-            lambda[m_qpCLists->actuatorRowIds[line-nbLines+j]] = localLambda[j];
-    }
 
-    line = 0;
-    for(unsigned int i=0; i<m_qpCLists->equality.size(); i++) // For each equality component
+void QPInverseProblem::addResultsSenders(const vector<SoftRobotsBaseConstraint*>& constraints,
+                                         const vector<unsigned int>& rowIds, const bool& hasLambda)
+{
+    unsigned int line = 0;
+    for(SoftRobotsBaseConstraint* constraint : constraints) // For each constraint component
     {
-        vector<double> localLambda, localDelta;
-        int nbLines = m_qpCLists->equality[i]->getNbLines();
+        QPResultsSender sender;
+        sender.constraint = constraint;
+        sender.rowIds = &rowIds;
+        sender.firstLine = line;
+        sender.nbLines = constraint->getNbLines();
+        sender.hasLambda = hasLambda;
+        line += sender.nbLines;
+
+        if(m_concurrentResults && hasConcurrentResults(constraint))
+            m_concurrentSenders.push_back(sender);
+        else
+            m_serialSenders.push_back(sender);
+    }
+}
 
-        localLambda.resize(nbLines);
-        localDelta.resize(nbLines);
 
-        for(int j=0; j<nbLines; j++)
-        {
-            localLambda[j] = lambda[m_qpCLists->equalityRowIds[line]];
-            localDelta[j]  = m_qpSystem->delta[m_qpCLists->equalityRowIds[line]];
-            line++;
-        }
+void QPInverseProblem::sendResults(const QPResultsSender& sender, vector<double>& localLambda, vector<double>& localDelta)
+{
+    double *lambda = getF();
+    const vector<unsigned int>& rowIds = *sender.rowIds;
+    const unsigned int nbLines = sender.nbLines;
 
-        m_qpCLists->equality[i]->storeResults(localLambda,localDelta);
+    localDelta.resize(nbLines);
+    for(unsigned int j=0; j<nbLines; j++)
+        localDelta[j] = m_qpSystem->delta[rowIds[sender.firstLine+j]];
 
-        // Allows equality to change value of force if needed (from the call to storeResults)
-        for(int j=0; j<nbLines; j++)
-            lambda[m_qpCLists->equalityRowIds[line-nbLines+j]] = localLambda[j];
+    if(!sender.hasLambda)
+    {
+        sender.constraint->storeResults(localDelta);
+        return;
     }
 
+    localLambda.resize(nbLines);
+    for(unsigned int j=0; j<nbLines; j++)
+        localLambda[j] = lambda[rowIds[sender.firstLine+j]];
 
-    line = 0;
-    for(unsigned int i=0; i<m_qpCLists->effectors.size(); i++) // For each effector component
-    {
-        vector<double> localDelta;
-        int nbLines = m_qpCLists->effectors[i]->getNbLines();
+    sender.constraint->storeResults(localLambda, localDelta);
 
-        localDelta.resize(nbLines);
+    // Allows actuators and equality to change value of force if needed (from the call to storeResults)
+    for(unsigned int j=0; j<nbLines; j++)
+        lambda[rowIds[sender.firstLine+j]] = localLambda[j];
+}
 
-        for(int j=0; j<nbLines; j++)
-            localDelta[j]=m_qpSystem->delta[m_qpCLists->effectorRowIds[line++]];
 
-        m_qpCLists->effectors[i]->storeResults(localDelta);
-    }
+bool QPInverseProblem::hasConcurrentResults(SoftRobotsBaseConstraint* constraint)
+{
+    if(!dynamic_cast<softrobotsinverse::behavior::ConcurrentResults*>(constraint))
+        return false;
+
+    // The propagation through the links of a Data is not thread-safe
+    for(const sofa::core::objectmodel::BaseData* data : constraint->getDataFields())
+        if(!data->getInputs().empty() || !data->getOutputs().empty())
+            return false;
+    return true;
+}
 
 
-    line = 0;
-    for(unsigned int i=0; i<m_qpCLists->sensors.size(); i++) // For each sensor component
-    {
-        vector<double> localDelta;
-        int nbLines = m_qpCLists->sensors[i]->getNbLines();
+sofa::simulation::Task::MemoryAlloc QPInverseProblem::SendResultsTask::run()
+{
+    for(const QPResultsSender* sender = begin; sender != end; sender++)
+        problem->sendResults(*sender, localLambda, localDelta);
+    return MemoryAlloc::Stack;
+}
 
-        localDelta.resize(nbLines);
 
-        for(int j=0; j<nbLines; j++)
-            localDelta[j]=m_qpSystem->delta[m_qpCLists->sensorRowIds[line++]];
+const vector<int>& QPInverseProblem::getRowComponents()
+{
+    m_rowComponents.assign(getDimension(), -1);
+    m_resultComponents.clear();
 
-        m_qpCLists->sensors[i]->storeResults(localDelta);
-    }
+    auto addComponents = [&](const vector<SoftRobotsBaseConstraint*>& constraints, const vector<unsigned int>& rowIds)
+    {
+        unsigned int line = 0;
+        for(SoftRobotsBaseConstraint* constraint : constraints)
+        {
+            const int id = m_resultComponents.size();
+            m_resultComponents.push_back(constraint);
+            const unsigned int nbLines = constraint->getNbLines();
+            for(unsigned int j=0; j<nbLines && line<rowIds.size(); j++)
+                m_rowComponents[rowIds[line++]] = id;
+        }
+    };
+
+    addComponents(m_qpCLists->actuators, m_qpCLists->actuatorRowIds);
+    addComponents(m_qpCLists->equality, m_qpCLists->equalityRowIds);
+    addComponents(m_qpCLists->effectors, m_qpCLists->effectorRowIds);
+    addComponents(m_qpCLists->sensors, m_qpCLists->sensorRowIds);
+    return m_rowComponents;
 }
 
 
@@ -568,20 +947,26 @@ void QPInverseProblem::displayQNormVariation(int& countdownFilterStartPerturb)
     double prevNorm = m_QNorm;
     double norm = 0.0;
 
-    //infinity-norm of a square matrix
-    for (int i=0; i<dim; i++)
+    //infinity-norm of a square matrix, unchanged if Q was reused
+    if(!m_hasQChanged)
+        norm = m_QNorm;
+    else
     {
-        double columnAbsSum = 0.0;
-        for (int j=0; j<dim; j++)
-        {
-            columnAbsSum += sofa::helper::rabs(m_qpSystem->Q[j][i]);
-        }
-        if (columnAbsSum > norm)
+        for (int i=0; i<dim; i++)
         {
-            norm = columnAbsSum;
+            double columnAbsSum = 0.0;
+            for (int j=0; j<dim; j++)
+            {
+                columnAbsSum += sofa::helper::rabs(m_qpSystem->Q[j][i]);
+            }
+            if (columnAbsSum > norm)
+            {
+                norm = columnAbsSum;
+            }
         }
     }
     m_QNorm = norm;
+    m_hasQChanged = false;
 
     ostringstream stream;
     stream << " Q infinity norm : " << norm << "\n";
@@ -29,9 +29,13 @@
 #pragma once
 
 #include <sofa/component/constraint/lagrangian/solver/ConstraintSolverImpl.h>
+#include <sofa/simulation/TaskScheduler.h>
 #include <SoftRobots/component/behavior/SoftRobotsBaseConstraint.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPAlignedBuffer.h>
 #include <SoftRobots.Inverse/component/config.h>
 #include "Eigen/Core"
+#include <algorithm>
+#include <set>
 
 
 namespace softrobotsinverse::solver::module
@@ -46,13 +50,83 @@ class SOFA_SOFTROBOTS_INVERSE_API QPInverseProblem : public sofa::component::con
 
   public:
 
+    typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> RowMajorMatrixXd;
+    typedef Eigen::Map<const RowMajorMatrixXd> ConstMatrixView;
+    typedef Eigen::Map<const Eigen::VectorXd> ConstVectorView;
+
+    /// Dense matrix stored in a single contiguous row-major buffer.
+    /// Rows are accessed with operator[] as with a vector< vector<double> >, and data() can be
+    /// given to qpOASES without copy. Clearing the matrix keeps the allocated memory.
+    /// The buffer is allocated with a storage policy (see QPStoragePolicy), its rows are not padded
+    /// as qpOASES reads the matrix with a leading dimension of its number of columns.
+    class QPMatrix{
+
+    public:
+        unsigned int size() const {return m_nbRows;} /// Number of rows
+        unsigned int nbRows() const {return m_nbRows;}
+        unsigned int nbCols() const {return m_nbCols;}
+        bool empty() const {return m_nbRows==0;}
+
+        double* operator[](const unsigned int i) {return m_data.data() + i*m_nbCols;}
+        const double* operator[](const unsigned int i) const {return m_data.data() + i*m_nbCols;}
+
+        double* data() {return m_data.data();}
+        const double* data() const {return m_data.data();}
+
+        void clear()
+        {
+            m_data.clear();
+            m_nbRows = 0;
+        }
+
+        void resize(const unsigned int nbRows, const unsigned int nbCols)
+        {
+            m_nbRows = nbRows;
+            m_nbCols = nbCols;
+            m_data.resize(nbRows*nbCols);
+        }
+
+        void fill(const double value) {std::fill(m_data.begin(), m_data.end(), value);}
+
+        void push_back(const vector<double>& row)
+        {
+            if(m_nbRows==0)
+                m_nbCols = row.size();
+            m_data.append(row.data(), row.data()+m_nbCols);
+            m_nbRows++;
+        }
+
+        void push_back(const QPMatrix& rows) /// Appends all the rows of a matrix with the same number of columns
+        {
+            if(rows.empty())
+                return;
+            if(m_nbRows==0)
+                m_nbCols = rows.nbCols();
+            m_data.append(rows.m_data.begin(), rows.m_data.begin()+rows.nbRows()*m_nbCols);
+            m_nbRows += rows.nbRows();
+        }
+
+        ConstMatrixView view() const {return ConstMatrixView(m_data.data(), m_nbRows, m_nbCols);}
+
+        size_t getMemoryUsage() const {return m_data.capacity()*sizeof(double);}
+
+        /// Reallocates the matrix with the policy if it changed, the values being kept
+        void setStoragePolicy(const QPStoragePolicy& policy) {m_data.setPolicy(policy);}
+        const QPStoragePolicy& getStoragePolicy() const {return m_data.getPolicy();}
+
+    protected:
+        QPAlignedBuffer<double> m_data;
+        unsigned int m_nbRows{0};
+        unsigned int m_nbCols{0};
+    };
+
     struct QPSystem{
 
-        vector< vector<double> > Q; /// QP problem matrix
+        QPMatrix Q; /// QP problem matrix
         vector< double > c;  /// QP problem vector
 
-        vector< vector<double> > A; /// Inequality constraint matrix
-        vector< vector<double> > Aeq; /// Equality constraint matrix
+        QPMatrix A; /// Inequality constraint matrix
+        QPMatrix Aeq; /// Equality constraint matrix
         vector< double > bl; /// Inequality constraint vector A*x >= bl
         vector< double > bu; /// Inequality constraint vector A*x <= bu
         vector< double > beq; /// Equality constraint vector Aeq*x = beq
@@ -72,6 +146,81 @@ class SOFA_SOFTROBOTS_INVERSE_API QPInverseProblem : public sofa::component::con
         double** W;
     };
 
+    /// Metadata of a QP variable [actuators equality contacts]: the constraint component owning it and
+    /// the parameters of its line, read once from the component so that the builders of the QP do not
+    /// walk the components line by line nor call their virtuals in the inner loops
+    struct QPVariableRow{
+        SoftRobotsBaseConstraint* owner{nullptr}; // nullptr for a contact
+        unsigned int line{0};    // Line of the variable in its owner
+        unsigned int nbLines{1}; // Number of lines of the owner
+        bool isDisabled{false};  // Owner masked at runtime, see QPConstraintLists::disabledConstraints
+
+        bool hasEpsilon{false};
+        bool hasLambdaInit{false};
+        bool hasLambdaMin{false};
+        bool hasLambdaMax{false};
+        bool hasLambdaEqual{false};
+        bool hasDeltaMin{false};
+        bool hasDeltaMax{false};
+        bool hasDeltaEqual{false};
+
+        double epsilon{0.};
+        double lambdaInit{0.};
+        double lambdaMin{0.};
+        double lambdaMax{0.};
+        double lambdaEqual{0.};
+        double deltaMin{0.};
+        double deltaMax{0.};
+        double deltaEqual{0.};
+    };
+
+    /// Bounds of the actuator variables, one slot per QP variable of an actuator, in struct of arrays so
+    /// that the bounds of all the actuators are set in the QP with one contiguous copy per kind of bound.
+    /// A missing bound is stored as -1e99 or 1e99, the infinite bounds of the QP.
+    struct QPActuatorBounds{
+        vector<double> lambdaMin;
+        vector<double> lambdaMax;
+        vector<double> deltaMin;
+        vector<double> deltaMax;
+
+        void clear(unsigned int nbRows)
+        {
+            lambdaMin.assign(nbRows, -1e99);
+            lambdaMax.assign(nbRows, 1e99);
+            deltaMin.assign(nbRows, -1e99);
+            deltaMax.assign(nbRows, 1e99);
+        }
+    };
+
+    /// Square block of the weights of the effector rows, S in the objective 1/2 delta_e^T S delta_e (see
+    /// behavior::EffectorWeights). The effector rows out of the blocks have the weight 1.
+    struct QPEffectorWeightBlock{
+        unsigned int first{0};  // Index of the first row of the block in effectorRowIds
+        unsigned int size{1};
+        unsigned int offset{0}; // Offset of the block, in row-major order, in QPConstraintLists::effectorWeights
+    };
+
+    /// Rows of an effector with a deadband (see behavior::EffectorDeadband)
+    struct QPEffectorDeadband{
+        unsigned int first{0}; // Index of the first row of the effector in effectorRowIds
+        unsigned int size{0};
+        double deadband{0.};
+    };
+
+    /// Identity of a contact across time steps: its constraint component and the persistent id the
+    /// component gives to the contact (see BaseConstraint::getConstraintInfo), or the id given by the
+    /// contact tracker (see QPContactTracker), -1 if it has none
+    struct QPContactId{
+        const BaseConstraint* constraint{nullptr};
+        int id{-1};
+
+        bool isValid() const {return id>=0;}
+        bool operator<(const QPContactId& other) const
+        {
+            return (constraint != other.constraint)? std::less<const BaseConstraint*>()(constraint, other.constraint) : id < other.id;
+        }
+    };
+
     struct QPConstraintLists{
 
         vector<SoftRobotsBaseConstraint*> actuators;
@@ -85,11 +234,55 @@ class SOFA_SOFTROBOTS_INVERSE_API QPInverseProblem : public sofa::component::con
         vector< unsigned int > sensorRowIds;
         vector< unsigned int > contactRowIds;
         vector< unsigned int > equalityRowIds;
+
+        vector<QPContactId> contactIds; // Identity of the contact of each row of contactRowIds, see updateContactIds()
+        vector<QPVariableRow> variableRows; // Size of the number of QP variables, see updateVariableRows()
+        QPActuatorBounds actuatorBounds; // Size of the number of actuator rows, see updateVariableRows()
+        bool hasBothSideActuatorLimits{false}; // An actuator has both delta or both lambda limits
+
+        /// Actuators and effectors masked at runtime. Their rows are kept in the lists, so that the layout of the
+        /// problem does not change: the variables of a disabled actuator are fixed to zero (lambda bounds [0,0], no
+        /// delta limits), and the rows of a disabled effector have no weight in the objective. Not cleared with the lists.
+        std::set<const SoftRobotsBaseConstraint*> disabledConstraints;
+        vector<char> disabledEffectorRows; // Size of the number of effector rows or empty if none is disabled, see updateVariableRows()
+        vector<QPEffectorWeightBlock> effectorWeightBlocks; // Sorted by first row, see updateVariableRows()
+        vector<double> effectorWeights;
+        vector<unsigned int> effectorRowLevels; // Priority of each effector row, empty if they all have the same, see updateVariableRows()
+        vector<QPEffectorDeadband> effectorDeadbands; // Of the enabled effectors with a deadband, see updateVariableRows()
+
+        bool isDisabled(const SoftRobotsBaseConstraint* constraint) const
+        {
+            return !disabledConstraints.empty() && disabledConstraints.count(constraint);
+        }
+
+        /// Fills variableRows, actuatorBounds, disabledEffectorRows and the effector weights from the components and
+        /// the row ids, to be called once the lists are set and before building the QP
+        void updateVariableRows();
+        /// Fills disabledEffectorRows, the effector weights and deadbands from the effector components
+        void updateEffectorRows();
+        /// Fills actuatorBounds and hasBothSideActuatorLimits from variableRows, e.g. when they are set without components
+        void updateActuatorBounds();
+    };
+
+
+    /// Range of consecutive rows [first, first+size) of W, found at [offset, offset+size) in a list of
+    /// row ids. The rows of a constraint component are consecutive, so a multi-row effector or actuator
+    /// is one block, and the blocks of W it reads can be copied contiguously instead of element by element.
+    struct QPRowBlock{
+        unsigned int first{0};
+        unsigned int size{0};
+        unsigned int offset{0};
     };
 
+    /// Splits a list of row ids in blocks of consecutive rows
+    static void getRowBlocks(const vector<unsigned int>& rowIds, vector<QPRowBlock>& blocks);
+
 
     QPInverseProblem();
     virtual ~QPInverseProblem();
+    // The problem owns its system and lists, a copy would share them
+    QPInverseProblem(const QPInverseProblem&) = delete;
+    QPInverseProblem& operator=(const QPInverseProblem&) = delete;
 
 
     ////////////////////// Inherit from ConstraintSolverImpl ////////////////////////
@@ -97,6 +290,14 @@ class SOFA_SOFTROBOTS_INVERSE_API QPInverseProblem : public sofa::component::con
     virtual void solveTimed(double tol, int maxIt, double timeout);
     /////////////////////////////////////////////////////////////////////////////////
 
+    /// Same as clear, without allocating W: for a matrix-free resolution, only dfree and the forces are used
+    void clearMatrixFree(int nbConstraints);
+
+    /// Same as clear, but while the number of rows does not change, W is only cleared on the rows
+    /// flagged in isClearedRow and on their columns, by blocks of consecutive rows. The other entries
+    /// keep their previous values, so they must not be read (e.g. partial compliance).
+    void clearBlocks(int nbConstraints, const vector<bool>& isClearedRow);
+
     void solve(double& objective, int& iterations);
 
     void setTime(const double& time) {m_time = time;}
@@ -104,11 +305,30 @@ class SOFA_SOFTROBOTS_INVERSE_API QPInverseProblem : public sofa::component::con
     void setEnergyActuatorsOnly(const bool& actuatorsOnly) {m_actuatorsOnly = actuatorsOnly;}
     void setTolerance(const double& tolerance) {m_tolerance = tolerance;}
     void setMaxIterations(const int& maxIt) {m_maxIteration = maxIt;}
+    void setMaxNbPivots(const int& maxNbPivots) {m_maxNbPivot = maxNbPivots;}
     void setFrictionCoeff(const double& mu) {m_mu = mu;}
     void allowSliding(const bool& allowSliding) {m_allowSliding = allowSliding;}
+    void setNbFrictionFacets(const unsigned int& nbFacets) {m_nbFrictionFacets = nbFacets;}
+    /// If true, delta is not computed for the sensors and their results are not sent: they are
+    /// evaluated by the solver from the state after the correction
+    void setLazySensors(const bool& lazySensors) {m_lazySensors = lazySensors;}
+    bool hasLazySensors() const {return m_lazySensors;}
+    /// If true, the results of the constraints marked with behavior::ConcurrentResults are sent concurrently
+    /// with the task scheduler, the others on the calling thread
+    void setConcurrentResults(const bool& concurrentResults) {m_concurrentResults = concurrentResults;}
+    /// If true, solve() neither reads the constraint components nor sends them the results, so that it can
+    /// run on another thread than the simulation: the caller reads the limits beforehand with
+    /// QPConstraintLists::updateVariableRows(), and sends the results afterwards with sendPendingResults()
+    void setDetached(const bool& detached) {m_detached = detached;}
+    bool isDetached() const {return m_detached;}
+    /// Sends the results stored by a detached resolution to the constraint components, false if there was none
+    bool sendPendingResults();
 
     void clearProblem();
 
+    /// Fills the identities of the contacts from their constraint components, once the lists are set
+    void updateContactIds(const sofa::core::ConstraintParams* cParams);
+
     void displayResult();
 
     void displayQPSystem();
@@ -120,6 +340,16 @@ class SOFA_SOFTROBOTS_INVERSE_API QPInverseProblem : public sofa::component::con
     QPSystem* getQPSystem() {return m_qpSystem;}
     QPConstraintLists* getQPConstraintLists() {return m_qpCLists;}
 
+    /// Memory allocated by the problem in bytes, from the capacities of its buffers
+    struct QPMemoryUsage{
+        size_t compliance{0}; // W, dfree and the forces
+        size_t qpSystem{0};   // Matrices and vectors of the QP
+        size_t solvers{0};    // Buffers of the resolution: workspaces, caches, LCP solvers and qpOASES problems (estimated)
+
+        size_t getTotal() const {return compliance + qpSystem + solvers;}
+    };
+    virtual void getMemoryUsage(QPMemoryUsage& usage) const;
+
 
 protected:
 
@@ -130,61 +360,101 @@ protected:
     bool      m_actuatorsOnly;
     double    m_tolerance;
     int       m_maxIteration;
-    int       m_maxNbPivot{100}; //TODO: set by user?
+    int       m_maxNbPivot{100};
     double    m_mu{0.0};
     bool      m_allowSliding;
+    unsigned int m_nbFrictionFacets{4};
+    bool      m_lazySensors{false};
+    bool      m_concurrentResults{false};
+    bool      m_detached{false};
+    bool      m_hasPendingResults{false};
 
     double m_largestQNormVariation;
     double m_QNorm;
+    bool m_hasQChanged{true}; // False when Q was reused as is since the last computation of m_QNorm
+
+    vector<unsigned int> m_variableRowIds; // Rows of the QP variables, the only ones with a nonzero lambda
+    vector<QPRowBlock>   m_variableBlocks;
+    vector<unsigned int> m_clearedRowIds;
+    vector<QPRowBlock>   m_clearedBlocks;
 
     int m_resolutionId;
 
     double   m_time{0.};
 
     void storeResults(const sofa::type::vector<double> &x);
+    /// Same as storeResults, delta being computed from the product Wlambda = W*lambda given on all the rows
+    /// instead of W (matrix-free resolution)
+    void storeResults(const sofa::type::vector<double> &x, const sofa::type::vector<double> &Wlambda);
+    void storeForces(const sofa::type::vector<double> &x);
     void sendResults();
 
-public:
-    Eigen::MatrixXd getQPMatriceQ(){
-        Eigen::MatrixXd Q;
-        Q.resize(m_qpSystem->dim,m_qpSystem->dim);
+    /// Rows of a constraint component in the list of its type
+    struct QPResultsSender{
+        SoftRobotsBaseConstraint* constraint{nullptr};
+        const vector<unsigned int>* rowIds{nullptr};
+        unsigned int firstLine{0};
+        unsigned int nbLines{0};
+        bool hasLambda{false}; // actuators and equality
+    };
+
+    class SendResultsTask : public sofa::simulation::CpuTask
+    {
+    public:
+        SendResultsTask(sofa::simulation::CpuTask::Status* status): CpuTask(status) {}
+        ~SendResultsTask() override {}
+
+        MemoryAlloc run() final;
+
+        void set(QPInverseProblem* _problem, const QPResultsSender* _begin, const QPResultsSender* _end){
+            problem = _problem;
+            begin = _begin;
+            end = _end;
+        }
+
+    private:
+        QPInverseProblem* problem{nullptr};
+        const QPResultsSender* begin{nullptr};
+        const QPResultsSender* end{nullptr};
+        vector<double> localLambda;
+        vector<double> localDelta;
+    };
+
+    vector<int> m_rowComponents;
+    vector<SoftRobotsBaseConstraint*> m_resultComponents;
 
-        for (unsigned int i=0; i<m_qpSystem->dim; i++)
-            for (unsigned int j=0; j<m_qpSystem->dim; j++)
-                Q(i,j) = m_qpSystem->Q[i][j];
+    vector<QPResultsSender> m_concurrentSenders;
+    vector<QPResultsSender> m_serialSenders;
+    vector<double> m_localLambda;
+    vector<double> m_localDelta;
 
-        return Q;
+    void addResultsSenders(const vector<SoftRobotsBaseConstraint*>& constraints,
+                           const vector<unsigned int>& rowIds, const bool& hasLambda);
+    void sendResults(const QPResultsSender& sender, vector<double>& localLambda, vector<double>& localDelta);
+
+public:
+    /// The constraint is marked behavior::ConcurrentResults and has no linked Data, its results can be
+    /// stored concurrently with the other constraints
+    static bool hasConcurrentResults(SoftRobotsBaseConstraint* constraint);
+
+    /// QP problem matrix
+    ConstMatrixView getQPMatriceQ(){
+        return m_qpSystem->Q.view();
     }
 
     /// QP problem vector
-    Eigen::VectorXd getQPVectorC(){
-        Eigen::VectorXd c; c.resize(m_qpSystem->dim);
-
-        for (unsigned int i=0; i<m_qpSystem->dim; i++)
-            c(i) = m_qpSystem->c[i];
-        return c;
+    ConstVectorView getQPVectorC(){
+        return ConstVectorView(m_qpSystem->c.data(), m_qpSystem->dim);
     }
 
     /// Inequality constraint matrix
-    Eigen::MatrixXd getQPMatrixA(){
-        unsigned int ASize = m_qpSystem->A.size();
-        Eigen::MatrixXd A; A.resize(ASize,m_qpSystem->dim);
-
-        for (unsigned int i=0; i<ASize; i++)
-            for (unsigned int j=0; j<m_qpSystem->dim; j++)
-                A(i,j) = m_qpSystem->A[i][j];
-        return A;
+    ConstMatrixView getQPMatrixA(){
+        return m_qpSystem->A.view();
     }
 
     /// Equality constraint matrix
-    Eigen::MatrixXd getQPMatrixAeq(){
-        unsigned int AeqSize = m_qpSystem->Aeq.size();
-        Eigen::MatrixXd Aeq; Aeq.resize(AeqSize,m_qpSystem->dim);
-
-        for (unsigned int i=0; i<AeqSize; i++)
-            for (unsigned int j=0; j<m_qpSystem->dim; j++)
-                Aeq(i,j) = m_qpSystem->Aeq[i][j];
-        return Aeq;
+    ConstMatrixView getQPMatrixAeq(){
+        return m_qpSystem->Aeq.view();
     }
 
     /// Inequality constraint vector A*x >= bl
@@ -199,41 +469,43 @@ public:
     }
 
     /// Inequality constraint vector A*x <= bu
-    Eigen::VectorXd getQPVectorbu(){
-        Eigen::VectorXd bu; bu.resize(m_qpSystem->A.size());
-
-        for(unsigned int i=0; i<m_qpSystem->A.size(); i++)
-            bu(i)=m_qpSystem->bu[i];
-        return bu;
+    ConstVectorView getQPVectorbu(){
+        return ConstVectorView(m_qpSystem->bu.data(), m_qpSystem->A.size());
     }
 
     /// Equality constraint vector Aeq*x = beq
-    Eigen::VectorXd getQPVectorbeq(){
-        Eigen::VectorXd beq; beq.resize(m_qpSystem->Aeq.size());
-
-        for(unsigned int i=0; i<m_qpSystem->Aeq.size(); i++)
-            beq(i)=m_qpSystem->beq[i];
-        return beq;
+    ConstVectorView getQPVectorbeq(){
+        return ConstVectorView(m_qpSystem->beq.data(), m_qpSystem->Aeq.size());
     }
 
     /// Inequality constraint vector x >= l
-    Eigen::VectorXd getQPVectorl(){
-        Eigen::VectorXd l; l.resize(m_qpSystem->dim);
-
-        for(unsigned int i=0; i<m_qpSystem->dim; i++)
-            l(i)=m_qpSystem->l[i];
-        return l;
+    ConstVectorView getQPVectorl(){
+        return ConstVectorView(m_qpSystem->l.data(), m_qpSystem->dim);
     }
 
     /// Inequality constraint vector x <= u
-    Eigen::VectorXd getQPvectoru(){
-        Eigen::VectorXd u; u.resize(m_qpSystem->dim);
+    ConstVectorView getQPvectoru(){
+        return ConstVectorView(m_qpSystem->u.data(), m_qpSystem->dim);
+    }
 
-        for(unsigned int i=0; i<m_qpSystem->dim; i++)
-            u(i)=m_qpSystem->u[i];
-        return u;
+    /// Forces of all the rows of the last resolution, without copy (e.g. to read the states of all the
+    /// actuators at once from Python). The view is valid until the next step.
+    ConstVectorView getLambda(){
+        return ConstVectorView(getF(), getDimension());
     }
 
+    /// Displacements delta = W*lambda + dfree of all the rows of the last resolution, without copy.
+    /// The rows of the sensors are zero with lazy sensors. The view is valid until the next step.
+    ConstVectorView getDelta(){
+        return ConstVectorView(m_qpSystem->delta.data(), m_qpSystem->delta.size());
+    }
+
+    /// Index in getResultComponents() of the component of each row, -1 for the contacts and the other rows,
+    /// updated from the constraint lists
+    const vector<int>& getRowComponents();
+    /// Actuators, equality, effectors and sensors, in this order and in the order of their lists
+    const vector<SoftRobotsBaseConstraint*>& getResultComponents() const {return m_resultComponents;}
+
 };
 
 } // namespace
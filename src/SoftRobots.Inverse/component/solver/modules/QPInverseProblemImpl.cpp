@@ -31,13 +31,16 @@
 
 
 #include <SoftRobots.Inverse/component/solver/modules/QPInverseProblemImpl.h>
-#include <SoftRobots.Inverse/component/solver/modules/NLCPSolver.h>
-#include <SoftRobots.Inverse/component/solver/modules/LCPQPSolver.h>
 
 #include <sofa/helper/AdvancedTimer.h>
 #include <sofa/component/collision/response/contact/CollisionResponse.h>
+#include <Eigen/Eigenvalues>
+#include <algorithm>
+#include <cmath>
 #include <iomanip>
+#include <limits>
 #include <sstream>
+#include <type_traits>
 #include <qpOASES.hpp>
 
 namespace softrobotsinverse::solver::module
@@ -60,6 +63,10 @@ using sofa::core::behavior::BaseConstraint;
 
 using qpOASES::QProblemB;
 using qpOASES::QProblem;
+using qpOASES::SQProblem;
+using qpOASES::returnValue;
+using qpOASES::Bounds;
+using qpOASES::Constraints;
 
 using qpOASES::Options;
 using qpOASES::real_t;
@@ -70,6 +77,35 @@ using Eigen::VectorXd;
 using Eigen::LDLT;
 
 using sofa::helper::AdvancedTimer;
+using sofa::helper::system::thread::CTime;
+
+namespace
+{
+
+/// Spans of the trace, and names of their annotations
+const QPTrace::NameId s_lcpSpan = QPTrace::intern("LCP resolution");
+const QPTrace::NameId s_pivotLoopSpan = QPTrace::intern("QPs resolution");
+const QPTrace::NameId s_pivotSpan = QPTrace::intern("Pivot");
+const QPTrace::NameId s_qpSpan = QPTrace::intern("QP");
+const QPTrace::NameId s_dimArg = QPTrace::intern("dim");
+const QPTrace::NameId s_constraintsArg = QPTrace::intern("constraints");
+const QPTrace::NameId s_nWSRArg = QPTrace::intern("nWSR");
+const QPTrace::NameId s_iterationArg = QPTrace::intern("iteration");
+const QPTrace::NameId s_pivotsArg = QPTrace::intern("pivots");
+
+/// Keys of the rate limited messages, see QPMessageQueue
+const char* const s_matrixFreeMessage = "matrix-free";
+const char* const s_feasibilityMessage = "feasibility";
+const char* const s_backendMessage = "backend";
+const char* const s_selectionMessage = "backendSelection";
+const char* const s_actuatorRecoveryMessage = "actuator recovery";
+const char* const s_indefiniteRecoveryMessage = "indefinite recovery";
+const char* const s_failedRecoveryMessage = "failed recovery";
+const char* const s_softRecoveryMessage = "soft recovery";
+const char* const s_iterateMessage = "iterate";
+const char* const s_prioritizedMessage = "prioritized";
+
+}
 
 
 QPInverseProblemImpl::QPInverseProblemImpl()
@@ -81,65 +117,157 @@ QPInverseProblemImpl::QPInverseProblemImpl()
 
     m_constraintHandler = new ConstraintHandler();
     m_qpCParams = m_constraintHandler->getQPConstraintParams();
+
+    m_nlcpSolver = new NLCPSolver();
+    m_lcpSolver = new LCPQPSolver();
+    m_pgsSolver = new LCPPGSSolver();
 }
 
 
 QPInverseProblemImpl::~QPInverseProblemImpl()
 {
+    deleteHotStartProblem();
+    deleteColdProblem();
+    m_contactFree.clear();
+    m_parametric.clear();
+    delete m_nlcpSolver;
+    delete m_lcpSolver;
+    delete m_pgsSolver;
+    delete m_qpBackend;
+    delete m_admmBackend;
+    delete m_hessianBackend;
     delete m_constraintHandler;
 }
 
+
+void QPInverseProblemImpl::setQPSolver(const std::string& name)
+{
+    const bool isBackendAdaptive = (name == "Adaptive");
+    if(isBackendAdaptive && !m_isBackendAdaptive)
+        m_backendSelector.clear();
+    m_isBackendAdaptive = isBackendAdaptive;
+    if(m_isBackendAdaptive && !m_admmBackend)
+        m_admmBackend = QPSolverBackend::create("ADMM");
+
+    if(m_qpBackend && m_qpBackend->getName() == name)
+        return;
+
+    delete m_qpBackend;
+    m_qpBackend = nullptr;
+    m_lcpSolver->setBackend(nullptr);
+
+    if(name == "qpOASES" || m_isBackendAdaptive)
+        return;
+
+    m_qpBackend = QPSolverBackend::create(name);
+    if(!m_qpBackend)
+        msg_error("QPInverseProblemImpl") << "Unknown QP solver " << name << ", use qpOASES instead.";
+    m_lcpSolver->setBackend(m_qpBackend);
+}
+
+void QPInverseProblemImpl::setHessianBackend(const std::string& name)
+{
+    if(m_hessianBackendName == name)
+        return;
+
+    m_hessianBackendName = name;
+    delete m_hessianBackend;
+    m_hessianBackend = nullptr;
+
+    if(name == "CPU")
+        return;
+
+    m_hessianBackend = QPHessianBackend::create(name);
+    if(!m_hessianBackend)
+        msg_warning("QPInverseProblemImpl") << "The Hessian backend " << name << " is not available, use CPU instead.";
+}
+
+void QPInverseProblemImpl::setLCPSolver(const std::string& name)
+{
+    if(name == "QP")
+        m_usePGSSolver = false;
+    else if(name == "PGS")
+        m_usePGSSolver = true;
+    else
+    {
+        msg_error("QPInverseProblemImpl") << "Unknown LCP solver " << name << ", use QP instead.";
+        m_usePGSSolver = false;
+    }
+}
+
+void QPInverseProblemImpl::setStoragePolicy(const std::string& name)
+{
+    QPStoragePolicy policy = QPStoragePolicy::Default;
+    if(!QPStorage::getPolicy(name, policy))
+        msg_error("QPInverseProblemImpl") << "Unknown storage policy " << name << ", use Default instead.";
+
+    m_qpSystem->Q.setStoragePolicy(policy);
+    m_qpSystem->A.setStoragePolicy(policy);
+    m_qpSystem->Aeq.setStoragePolicy(policy);
+    m_workspace.A.setPolicy(policy);
+    m_permutedCompliance.setStoragePolicy(policy);
+    m_nlcpSolver->setStoragePolicy(policy);
+}
+
 void QPInverseProblemImpl::init(){
 
     m_step=0;
+    m_qpCLists->updateVariableRows();
     unsigned int nbActuators = m_qpCLists->actuatorRowIds.size();
-    int actuatorsId = 0;
-    unsigned int actuatorLine = 0;
 
     m_qpSystem->lambda.clear();
     m_qpSystem->lambda.resize(m_qpSystem->dim);
-    for (unsigned int k=0; k<m_qpSystem->dim; k++)
+    for (unsigned int k=0; k<m_qpSystem->dim && k<nbActuators; k++) // actuators
     {
-        if(k<nbActuators) // actuators
-        {
-            SoftRobotsBaseConstraint* ac;
-            ac = m_qpCLists->actuators[actuatorsId];
-            if(ac->hasLambdaInit())
-                m_qpSystem->lambda[k] = ac->getLambdaInit(actuatorLine);
-            actuatorLine++;
-            if(actuatorLine == ac->getNbLines())
-            {
-                actuatorLine = 0;
-                actuatorsId++;
-            }
-        }
+        const QPVariableRow& row = m_qpCLists->variableRows[k];
+        if(row.hasLambdaInit)
+            m_qpSystem->lambda[k] = row.lambdaInit;
     }
 }
 
 /// Build system
-void QPInverseProblemImpl:: computeEnergyWeight(double& weight)
+const vector<unsigned int>& QPInverseProblemImpl::updateVariableIds()
 {
-    weight = 0.0;
     unsigned int nbActuators = m_qpCLists->actuatorRowIds.size();
     unsigned int nbEquality = m_qpCLists->equalityRowIds.size();
 
-    vector<unsigned int> acIds;
+    // Kept in the workspace, only reallocated when the number of variables grows
+    vector<unsigned int>& acIds = m_workspace.variableIds;
     acIds.resize(m_qpSystem->dim);
     for (unsigned int i=0; i<m_qpSystem->dim; i++)
     {
         if(i<nbActuators)                  acIds[i] = m_qpCLists->actuatorRowIds[i];  // actuators first
-        else if(i<nbActuators+nbEquality)  acIds[i] = m_qpCLists->equalityRowIds[i-nbActuators]; //second
+        else if(i<nbActuators+nbEquality)  acIds[i] = m_qpCLists->equalityRowIds[i-nbActuators]; // equality second
         else                               acIds[i] = m_qpCLists->contactRowIds[i-nbActuators-nbEquality]; // contacts last
     }
+    return acIds;
+}
+
+
+void QPInverseProblemImpl:: computeEnergyWeight(double& weight)
+{
+    weight = 0.0;
+    unsigned int nbActuators = m_qpCLists->actuatorRowIds.size();
+    const QPPermutedCompliance& Wx = updatePermutedCompliance();
 
-    double normQ = 0; // uniform norm
+    // Uniform norm of Q, read from its lower triangle only (Q is symmetric): the entry (k,j) counts in
+    // the sums of the rows k and j
+    vector<double>& rowSums = m_QRowSums;
+    rowSums.assign(m_qpSystem->dim, 0.);
     for (unsigned int k=0; k<m_qpSystem->dim; k++)
     {
-        double sum = 0;
-        for(unsigned int j=0; j<m_qpSystem->dim; j++)
-            sum += rabs(m_qpSystem->Q[k][j]);
-        if (sum>normQ) normQ = sum;
+        const double* Qk = m_qpSystem->Q[k];
+        for(unsigned int j=0; j<k; j++)
+        {
+            const double v = rabs(Qk[j]);
+            rowSums[k] += v;
+            rowSums[j] += v;
+        }
+        rowSums[k] += rabs(Qk[k]);
     }
+    double normQ = 0;
+    for (const double& sum : rowSums)
+        if (sum>normQ) normQ = sum;
 
     // If not m_actuatorsOnly:
     // W_energy = (Waa Wac)
@@ -149,9 +277,10 @@ void QPInverseProblemImpl:: computeEnergyWeight(double& weight)
     double normW = 0; // uniform norm
     for (unsigned int k=0; k<dim; k++)
     {
+        const double* Wk = Wx[k];
         double sum = 0;
         for(unsigned int j=0; j<dim; j++)
-            sum += rabs(m_qpSystem->W[acIds[k]][acIds[j]]);
+            sum += rabs(Wk[j]);
         if (sum>normW) normW = sum;
     }
 
@@ -160,448 +289,3087 @@ void QPInverseProblemImpl:: computeEnergyWeight(double& weight)
 }
 
 
+void QPInverseProblemImpl::updateEnergyWeight(const unsigned int& energyDim, double& weight)
+{
+    if(!m_adaptiveEpsilon.isAdaptive())
+    {
+        computeEnergyWeight(weight);
+        return;
+    }
+
+    // Traces of Q (without the energy term yet) and W_energy, the norms are only computed on drift
+    const QPPermutedCompliance& Wx = updatePermutedCompliance();
+    double traceQ = 0.;
+    for (unsigned int k=0; k<m_qpSystem->dim; k++)
+        traceQ += m_qpSystem->Q[k][k];
+    double traceW = 0.;
+    for (unsigned int k=0; k<energyDim; k++)
+        traceW += Wx[k][k];
+
+    if(m_adaptiveEpsilon.isRefreshNeeded(energyDim, traceQ, traceW))
+    {
+        computeEnergyWeight(weight);
+        m_adaptiveEpsilon.setWeight(weight, energyDim, traceQ, traceW);
+    }
+    else
+        weight = m_adaptiveEpsilon.getWeight(traceQ, traceW);
+}
+
+
+void QPInverseProblemImpl::setAdaptiveEpsilon(const bool& adaptive, const double& minConditioning, const double& maxConditioning)
+{
+    if(adaptive != m_adaptiveEpsilon.isAdaptive())
+        m_hessianCache.clear();
+    m_adaptiveEpsilon.setAdaptive(adaptive, minConditioning, maxConditioning);
+}
+
+
 void QPInverseProblemImpl::buildQPMatrices()
 {
     unsigned int nbActuators   = m_qpCLists->actuatorRowIds.size();
     unsigned int nbEffectors   = m_qpCLists->effectorRowIds.size();
-    unsigned int nbEquality   = m_qpCLists->equalityRowIds.size();
 
-    vector<unsigned int> acIds;
-    acIds.resize(m_qpSystem->dim);
-    for (unsigned int i=0; i<m_qpSystem->dim; i++)
-    {
-        if(i<nbActuators)                 acIds[i] = m_qpCLists->actuatorRowIds[i]; // actuators first
-        else if(i<nbActuators+nbEquality) acIds[i] = m_qpCLists->equalityRowIds[i-nbActuators]; // equality second
-        else                              acIds[i] = m_qpCLists->contactRowIds[i-nbActuators-nbEquality ]; // contacts last
-    }
+    const vector<unsigned int>& acIds = updateVariableIds();
+    const QPPermutedCompliance& Wx = updatePermutedCompliance();
 
     m_qpSystem->Q.clear();
     m_qpSystem->c.clear();
 
-    m_qpSystem->Q.resize(m_qpSystem->dim);
-    for(unsigned int j=0; j<m_qpSystem->dim; j++)
-        m_qpSystem->Q[j].resize(m_qpSystem->dim);
+    unsigned int dimQ = m_qpSystem->dim;
+    m_qpSystem->Q.resize(dimQ, dimQ);
+    m_qpSystem->c.resize(dimQ);
 
-    for (unsigned int k=0; k<m_qpSystem->dim; k++)
+    // If not m_actuatorsOnly:
+    // W_energy = (Waa Wac)
+    //            (Wca Wcc)
+    unsigned int dim = (m_actuatorsOnly)? nbActuators : m_qpSystem->dim;
+
+    getRowBlocks(acIds, m_variableColumnBlocks);
+    updateInactiveEffectorRows();
+    if(isSketchingEffectors())
+        sketchEffectors(dimQ);
+    else if(isCondensingEffectors())
+        condenseEffectors(dimQ);
+    else
     {
-        for(unsigned int j=0; j<m_qpSystem->dim; j++)
+        // Gather the block Wea = W(effectors, [actuators equality contacts]) and the effectors dfree.
+        // The columns of a multi-row constraint are consecutive in W, so each row of Wea is copied
+        // by blocks of contiguous columns. The effectors in their deadband are left out of Wea, unless
+        // the horizon or the priority levels read its rows by index.
+        if(m_nbDeadbandEffectors>0 && m_horizonProblem.getHorizon()<2 && m_qpCLists->effectorRowLevels.empty())
         {
-            double sum = 0;
-            for(unsigned int i=0; i<nbEffectors; i++)
-            {
-                unsigned int rowId  = m_qpCLists->effectorRowIds[i];
-                unsigned int col1Id = acIds[j];
-                unsigned int col2Id = acIds[k];
-                sum += m_qpSystem->W[rowId][col1Id]* m_qpSystem->W[rowId][col2Id];
-            }
-            m_qpSystem->Q[k][j] = sum;
+            unsigned int nbRows = 0;
+            for(const QPRowBlock& span : m_activeEffectorSpans)
+                nbRows += span.size;
+            m_Wea.resize(nbRows, dimQ);
+            m_dFreeEffectors.resize(nbRows);
+            for(const QPRowBlock& span : m_activeEffectorSpans)
+                gatherEffectorRows(span.first, span.size, span.offset);
+        }
+        else
+        {
+            m_Wea.resize(nbEffectors, dimQ);
+            m_dFreeEffectors.resize(nbEffectors);
+            gatherEffectorRows(0, nbEffectors);
         }
-    }
 
-    m_qpSystem->c.resize(m_qpSystem->dim);
-    for(unsigned int j=0; j<m_qpSystem->dim; j++)
-    {
-        m_qpSystem->c[j] = 0;
-        for(unsigned int i=0; i<nbEffectors; i++)
-            m_qpSystem->c[j] += m_qpSystem->W[m_qpCLists->effectorRowIds[i]][acIds[j]]*m_qpSystem->dFree[m_qpCLists->effectorRowIds[i]];
+        // c = Wea^T*dfree_e
+        Eigen::Map<VectorXd> c(m_qpSystem->c.data(), dimQ);
+        c.noalias() = m_Wea.transpose() * m_dFreeEffectors;
+
+        // Q only depends on Wea, W_energy and the energy parameters
+        if(m_hessianCache.enabled && reuseHessian(dim))
+            return;
+
+        // Q = Wea^T*Wea as a symmetric rank-k update of the lower triangle only, in place. The upper
+        // triangle is filled once the energy term is added.
+        QPHessianBackend* backend = (m_hessianBackend)? m_hessianBackend : &m_cpuHessianBackend;
+        backend->computeProduct(m_Wea.rows(), dimQ, m_Wea.data(), m_qpSystem->Q.data());
     }
 
     // Add energy term to Q+=eps*||Q||/||Waa||*Waa, eps is set by user
     double weight = 0.;
-    computeEnergyWeight(weight); // compute ||Q||/||Waa||
-    int actuatorsId = 0;
-    int equalityId = 0;
-    unsigned int actuatorsNbLines = 0;
-    unsigned int equalitysNbLines = 0;
+    updateEnergyWeight(dim, weight); // compute ||Q||/||Waa||
 
-    // If not m_actuatorsOnly:
-    // W_energy = (Waa Wac)
-    //            (Wca Wcc)
     // Q+=eps*||Q||/||W_energy||*W_energy
-    unsigned int dim = (m_actuatorsOnly)? nbActuators : m_qpSystem->dim;
+    // added to the lower triangle, which is then mirrored in the same pass
+    const double scaledWeight = m_adaptiveEpsilon.getScale()*weight;
+    const double epsilonWeight = m_epsilon*scaledWeight;
 
-    for (unsigned int k=0; k<dim; k++)
+    double minDiagonal = std::numeric_limits<double>::max();
+    double maxDiagonal = 0.;
+    for (unsigned int k=0; k<dimQ; k++)
     {
-        if(k<nbActuators) // actuators
+        double* Qk = m_qpSystem->Q[k];
+        if(k<dim)
         {
-            SoftRobotsBaseConstraint* ac;
-            ac = m_qpCLists->actuators[actuatorsId];
-            actuatorsNbLines++;
-            if(actuatorsNbLines == ac->getNbLines())
-            {
-                actuatorsNbLines = 0;
-                actuatorsId++;
-            }
-            for(unsigned int j=0; j<dim; j++)
-            {
-                if(ac->hasEpsilon() && j==k) // energy of a specific actuator
-                    m_qpSystem->Q[k][j] += ac->getEpsilon()*weight*m_qpSystem->W[acIds[k]][acIds[j]];
-                else
-                    m_qpSystem->Q[k][j] += m_epsilon*weight*m_qpSystem->W[acIds[k]][acIds[j]];
-            }
+            // The energy of a specific actuator or equality only weights its diagonal term
+            const QPVariableRow& row = m_qpCLists->variableRows[k];
+            const double* Wk = Wx[k];
+            for(unsigned int j=getEnergyBlockFirst(k); j<k; j++)
+                Qk[j] += epsilonWeight*Wk[j];
+            Qk[k] += ((row.hasEpsilon)? row.epsilon : m_epsilon)*scaledWeight*Wk[k];
+        }
+        minDiagonal = std::min(minDiagonal, Qk[k]);
+        maxDiagonal = std::max(maxDiagonal, Qk[k]);
+
+        for(unsigned int j=0; j<k; j++)
+            m_qpSystem->Q[j][k] = Qk[j];
+    }
+
+    // Scale of the next steps, from the conditioning of the diagonal
+    if(dimQ > 0)
+        m_adaptiveEpsilon.updateScale((minDiagonal > 0.)? maxDiagonal/minDiagonal : std::numeric_limits<double>::infinity());
+
+    // With the energy term on all the variables, Q is positive definite and qpOASES does not need to
+    // determine the type of the Hessian
+    m_hessianType = (m_epsilon>0. && weight>0. && dim==dimQ)? qpOASES::HST_POSDEF : qpOASES::HST_UNKNOWN;
+    m_hasQChanged = true;
+
+    if(m_hessianCache.enabled)
+        storeHessian(dim);
+}
+
+
+bool QPInverseProblemImpl::isCondensingEffectors() const
+{
+    // Wea is read again by the cached Hessian, the backends of the product, the horizon and the
+    // priority levels: they keep the whole block
+    return m_condensedEffectors && !m_hessianCache.enabled && !m_hessianBackend
+            && m_horizonProblem.getHorizon()<2 && m_qpCLists->effectorRowLevels.empty();
+}
+
+
+void QPInverseProblemImpl::setCondensedEffectors(const bool& condensed)
+{
+    m_condensedEffectors = condensed;
+}
+
+
+bool QPInverseProblemImpl::isSketchingEffectors() const
+{
+    // Same exclusions as the condensed effectors, the sketch replaces the whole block Wea
+    return m_effectorSketchSize>0 && m_qpCLists->effectorRowIds.size()>m_effectorSketchSize
+            && !m_hessianCache.enabled && !m_hessianBackend
+            && m_horizonProblem.getHorizon()<2 && m_qpCLists->effectorRowLevels.empty();
+}
+
+
+void QPInverseProblemImpl::setEffectorSketch(const unsigned int& size)
+{
+    m_effectorSketchSize = size;
+    if(size == 0)
+    {
+        m_sketchedWea.resize(0, 0);
+        m_sketchedDFree.resize(0);
+    }
+}
+
+
+void QPInverseProblemImpl::gatherEffectorRows(const unsigned int& first, const unsigned int& nbRows,
+                                              const unsigned int& offset)
+{
+    const vector<unsigned int>& effectorRowIds = m_qpCLists->effectorRowIds;
+    for(unsigned int i=0; i<nbRows; i++)
+    {
+        const double* Wi = m_qpSystem->W[effectorRowIds[first + i]];
+        for(const QPRowBlock& block : m_variableColumnBlocks)
+            m_Wea.row(offset + i).segment(block.offset, block.size) = ConstVectorView(Wi + block.first, block.size).transpose();
+        m_dFreeEffectors(offset + i) = m_qpSystem->dFree[effectorRowIds[first + i]];
+    }
+
+    // The rows of the disabled effectors (and of the effectors in their deadband) stay in Wea, with no weight
+    for(unsigned int i=0; i<nbRows && first + i<m_inactiveEffectorRows.size(); i++)
+    {
+        if(!m_inactiveEffectorRows[first + i])
+            continue;
+        m_Wea.row(offset + i).setZero();
+        m_dFreeEffectors(offset + i) = 0.;
+    }
+    applyEffectorWeights(first, nbRows, offset);
+}
+
+
+void QPInverseProblemImpl::updateInactiveEffectorRows()
+{
+    const unsigned int nbEffectors = m_qpCLists->effectorRowIds.size();
+    const vector<char>& disabledEffectorRows = m_qpCLists->disabledEffectorRows;
+    m_inactiveEffectorRows.assign(disabledEffectorRows.begin(), disabledEffectorRows.end());
+    m_activeEffectorSpans.clear();
+    m_nbDeadbandEffectors = 0;
+
+    // An effector is in its deadband when its distance to the goal at the free motion is at most the deadband
+    for(const QPEffectorDeadband& effector : m_qpCLists->effectorDeadbands)
+    {
+        if(effector.first + effector.size > nbEffectors)
+            continue;
+        double distance2 = 0.;
+        for(unsigned int k=effector.first; k<effector.first + effector.size; k++)
+        {
+            const double d = m_qpSystem->dFree[m_qpCLists->effectorRowIds[k]];
+            distance2 += d*d;
         }
-        else if (k<nbActuators+nbEquality)
+        if(distance2 > effector.deadband*effector.deadband)
+            continue;
+
+        m_inactiveEffectorRows.resize(nbEffectors, false);
+        std::fill(m_inactiveEffectorRows.begin() + effector.first, m_inactiveEffectorRows.begin() + effector.first + effector.size, true);
+        m_nbDeadbandEffectors++;
+    }
+    if(m_nbDeadbandEffectors == 0)
+        return;
+
+    // Spans of the other rows, with their offset in the compacted Wea. The weight blocks are within an
+    // effector, a span never cuts one.
+    unsigned int offset = 0;
+    for(unsigned int i=0; i<nbEffectors; )
+    {
+        if(m_inactiveEffectorRows[i])
         {
-            SoftRobotsBaseConstraint* ac;
-            ac = m_qpCLists->equality[equalityId];
-            equalitysNbLines++;
-            if(equalitysNbLines == ac->getNbLines())
-            {
-                equalitysNbLines = 0;
-                equalityId++;
-            }
-            for(unsigned int j=0; j<dim; j++)
-            {
-                if(ac->hasEpsilon() && j==k) // energy of a specific actuator
-                    m_qpSystem->Q[k][j] += ac->getEpsilon()*weight*m_qpSystem->W[acIds[k]][acIds[j]];
-                else
-                    m_qpSystem->Q[k][j] += m_epsilon*weight*m_qpSystem->W[acIds[k]][acIds[j]];
-            }
+            i++;
+            continue;
         }
-        else // contacts
+        unsigned int last = i;
+        while(last<nbEffectors && !m_inactiveEffectorRows[last])
+            last++;
+        m_activeEffectorSpans.push_back({i, last - i, offset});
+        offset += last - i;
+        i = last;
+    }
+}
+
+
+void QPInverseProblemImpl::condenseEffectors(const unsigned int& dimQ)
+{
+    // Q = sum of Wea_k^T*Wea_k and c = sum of Wea_k^T*dfree_k over chunks k of effector rows, gathered
+    // one after the other in the first rows of Wea. A chunk ends at the end of a weight block, whose
+    // factor mixes its rows.
+    const unsigned int nbEffectors = m_qpCLists->effectorRowIds.size();
+
+    Eigen::Map<RowMajorMatrixXd> Q(m_qpSystem->Q.data(), dimQ, dimQ);
+    Eigen::Map<VectorXd> c(m_qpSystem->c.data(), dimQ);
+    Q.setZero();
+    c.setZero();
+    m_Wea.resize(std::min(s_condensedChunkSize, nbEffectors), dimQ);
+    m_dFreeEffectors.resize(m_Wea.rows());
+
+    unsigned int block = 0;
+    for(unsigned int first=0; first<nbEffectors; )
+    {
+        const unsigned int last = gatherEffectorChunk(first, block, dimQ);
+        const unsigned int nbRows = last - first;
+        const auto Wk = m_Wea.topRows(nbRows);
+        c.noalias() += Wk.transpose() * m_dFreeEffectors.head(nbRows);
+        Q.selfadjointView<Eigen::Lower>().rankUpdate(Wk.transpose());
+        first = last;
+    }
+}
+
+
+unsigned int QPInverseProblemImpl::gatherEffectorChunk(const unsigned int& first, unsigned int& block,
+                                                       const unsigned int& dimQ)
+{
+    const unsigned int nbEffectors = m_qpCLists->effectorRowIds.size();
+    const vector<QPEffectorWeightBlock>& blocks = m_qpCLists->effectorWeightBlocks;
+
+    unsigned int last = std::min(first + s_condensedChunkSize, nbEffectors);
+    for(; block<blocks.size() && blocks[block].first<last; block++)
+        last = std::max(last, std::min(blocks[block].first + blocks[block].size, nbEffectors));
+
+    const unsigned int nbRows = last - first;
+    if((unsigned int)m_Wea.rows() < nbRows || (unsigned int)m_Wea.cols() != dimQ)
+    {
+        m_Wea.resize(nbRows, dimQ);
+        m_dFreeEffectors.resize(nbRows);
+    }
+    gatherEffectorRows(first, nbRows);
+    return last;
+}
+
+
+void QPInverseProblemImpl::sketchEffectors(const unsigned int& dimQ)
+{
+    // CountSketch of the weighted effector rows: each row is added, with a sign, to one of the
+    // m_effectorSketchSize rows of S*Wea and S*dfree_e. The bucket and the sign only depend on the index
+    // of the row, so the sketch is the same from one step to the other. E[S^T*S] = I, and
+    // Q = (S*Wea)^T*(S*Wea), c = (S*Wea)^T*(S*dfree_e) approximate Wea^T*Wea and Wea^T*dfree_e.
+    const unsigned int nbEffectors = m_qpCLists->effectorRowIds.size();
+    const unsigned int size = m_effectorSketchSize;
+
+    m_sketchedWea.setZero(size, dimQ);
+    m_sketchedDFree.setZero(size);
+    m_Wea.resize(std::min(s_condensedChunkSize, nbEffectors), dimQ);
+    m_dFreeEffectors.resize(m_Wea.rows());
+
+    unsigned int block = 0;
+    for(unsigned int first=0; first<nbEffectors; )
+    {
+        const unsigned int last = gatherEffectorChunk(first, block, dimQ);
+        for(unsigned int i=first; i<last; i++)
         {
-            for(unsigned int j=0; j<dim; j++)
-                m_qpSystem->Q[k][j] += m_epsilon*weight*m_qpSystem->W[acIds[k]][acIds[j]];
+            const uint64_t hash = getSketchHash(i);
+            const unsigned int bucket = hash % size;
+            const double sign = (hash >> 63)? -1. : 1.;
+            m_sketchedWea.row(bucket) += sign*m_Wea.row(i - first);
+            m_sketchedDFree(bucket) += sign*m_dFreeEffectors(i - first);
         }
+        first = last;
+    }
+
+    Eigen::Map<RowMajorMatrixXd> Q(m_qpSystem->Q.data(), dimQ, dimQ);
+    Eigen::Map<VectorXd> c(m_qpSystem->c.data(), dimQ);
+    c.noalias() = m_sketchedWea.transpose() * m_sketchedDFree;
+    Q.setZero();
+    Q.selfadjointView<Eigen::Lower>().rankUpdate(m_sketchedWea.transpose());
+}
+
+
+uint64_t QPInverseProblemImpl::getSketchHash(const unsigned int& row)
+{
+    // splitmix64 finalizer
+    uint64_t z = (uint64_t(row) + 1) * 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+
+void QPInverseProblemImpl::setEnergyApproximation(const std::string& name)
+{
+    QPEnergyApproximation approximation = QPEnergyApproximation::Full;
+    if(name == "BlockDiagonal")
+        approximation = QPEnergyApproximation::BlockDiagonal;
+    else if(name == "Diagonal")
+        approximation = QPEnergyApproximation::Diagonal;
+    else if(name != "Full")
+        msg_error("QPInverseProblemImpl") << "Unknown energy approximation " << name << ", use Full instead.";
+
+    if(approximation == m_energyApproximation)
+        return;
+    m_energyApproximation = approximation;
+    m_hessianCache.clear();
+}
+
+
+unsigned int QPInverseProblemImpl::getEnergyBlockFirst(const unsigned int& k) const
+{
+    switch(m_energyApproximation)
+    {
+    case QPEnergyApproximation::Full: return 0;
+    case QPEnergyApproximation::Diagonal: return k;
+    case QPEnergyApproximation::BlockDiagonal: break;
     }
 
+    // The lines of an actuator or equality constraint are consecutive variables, followed by the contacts
+    const QPVariableRow& row = m_qpCLists->variableRows[k];
+    if(row.owner)
+        return k - std::min(row.line, k);
+    const unsigned int nbFixedRows = m_qpCLists->actuatorRowIds.size() + m_qpCLists->equalityRowIds.size();
+    const unsigned int nbLines = std::max(m_qpCParams->contactNbLines, 1u);
+    if(k < nbFixedRows)
+        return k;
+    return nbFixedRows + ((k - nbFixedRows)/nbLines)*nbLines;
 }
 
 
+const QPPermutedCompliance& QPInverseProblemImpl::updatePermutedCompliance()
+{
+    // Within solve(), W and the variables do not change and the block is gathered once. Out of it, e.g.
+    // when the kernels are called on their own, it is gathered at each call.
+    if(m_isPermutedComplianceKept && m_permutedCompliance.isValid() && m_permutedCompliance.getDimension() == m_qpSystem->dim)
+        return m_permutedCompliance;
+
+    const vector<unsigned int>& acIds = updateVariableIds();
+    getRowBlocks(acIds, m_variableColumnBlocks);
+    m_permutedCompliance.gather(m_qpSystem->W, acIds, m_variableColumnBlocks);
+    return m_permutedCompliance;
+}
 
-/// Solve system
 
-void QPInverseProblemImpl::solve(double& objective, int& iterations)
+void QPInverseProblemImpl::QPHessianCache::clear()
 {
-    int nbContactRows   = m_qpCLists->contactRowIds.size();
-    int nbActuatorRows  = m_qpCLists->actuatorRowIds.size();
-    int nbEffectorRows  = m_qpCLists->effectorRowIds.size();
-    int nbEqualityRows  = m_qpCLists->equalityRowIds.size();
+    isValid = false;
+    Wea.resize(0, 0);
+    WEnergy.resize(0, 0);
+    epsilons.clear();
+    Q.clear();
+}
 
-    m_qpSystem->dim = nbContactRows + nbActuatorRows + nbEqualityRows;
-    m_qpSystem->W = getW();
-    m_qpSystem->dFree = getDfree();
-    m_qpCParams->mu = m_mu;
-    m_qpCParams->allowSliding = m_allowSliding;
 
-    vector<double> result; // size of dim
-    vector<double> dual; // size of nb constraints
+void QPInverseProblemImpl::setReuseHessian(const bool& reuse)
+{
+    if(m_hessianCache.enabled == reuse)
+        return;
 
-    objective  = 0;
-    iterations = 0; // from contact pivot algorithm
+    m_hessianCache.enabled = reuse;
+    m_hessianCache.clear();
+}
 
-    if(nbContactRows>0)
+
+void QPInverseProblemImpl::applyEffectorWeights(const unsigned int& firstRow, const unsigned int& nbRows,
+                                                const unsigned int& offset)
+{
+    const vector<double>& weights = m_qpCLists->effectorWeights;
+    for(QPEffectorWeightBlock block : m_qpCLists->effectorWeightBlocks)
     {
-        if(m_mu>0.)
+        if(block.first < firstRow || block.first + block.size > firstRow + nbRows)
+            continue;
+        block.first = block.first - firstRow + offset;
+
+        // A diagonal weight only scales its row
+        if(block.size == 1)
         {
-            // TODO: implement choice of user and projection of the tangential force to determine dir1 and dir2
-            m_qpCParams->slidingDirId1 = 1;
-            m_qpCParams->slidingDirId2 = 2;
-            m_qpCParams->contactNbLines = 3;
-            m_qpCParams->nbContactPoints = m_qpCLists->contactRowIds.size()/m_qpCParams->contactNbLines;
+            const double scale = std::sqrt(std::max(weights[block.offset], 0.));
+            m_Wea.row(block.first) *= scale;
+            m_dFreeEffectors(block.first) *= scale;
+            continue;
         }
-        else
+
+        // S = V*D*V^T and F = V*sqrt(D), the negative eigenvalues of a badly conditioned block being clamped
+        const Eigen::Map<const RowMajorMatrixXd> S(weights.data() + block.offset, block.size, block.size);
+        m_effectorWeightSolver.compute(S);
+        m_effectorWeightFactor = m_effectorWeightSolver.eigenvectors()
+                * m_effectorWeightSolver.eigenvalues().cwiseMax(0.).cwiseSqrt().asDiagonal();
+        m_Wea.middleRows(block.first, block.size) = m_effectorWeightFactor.transpose() * m_Wea.middleRows(block.first, block.size);
+        m_dFreeEffectors.segment(block.first, block.size) = m_effectorWeightFactor.transpose() * m_dFreeEffectors.segment(block.first, block.size);
+    }
+}
+
+
+double QPInverseProblemImpl::getEffectorsFreeObjective() const
+{
+    return getEffectorsObjective(m_qpSystem->dFree);
+}
+
+
+double QPInverseProblemImpl::getEffectorsObjective(const double* delta) const
+{
+    const vector<unsigned int>& rowIds = m_qpCLists->effectorRowIds;
+    const vector<char>& disabledEffectorRows = m_qpCLists->disabledEffectorRows;
+    const vector<QPEffectorWeightBlock>& blocks = m_qpCLists->effectorWeightBlocks;
+    const vector<double>& weights = m_qpCLists->effectorWeights;
+
+    // The rows of a block belong to one effector, so they are all disabled or none is
+    double objective = 0.;
+    unsigned int b = 0;
+    for(unsigned int i=0; i<rowIds.size(); )
+    {
+        const bool isDisabled = (i<disabledEffectorRows.size() && disabledEffectorRows[i]);
+        if(b<blocks.size() && blocks[b].first == i)
         {
-            m_qpCParams->contactNbLines = 1;
-            m_qpCParams->nbContactPoints = m_qpCLists->contactRowIds.size();
+            const QPEffectorWeightBlock& block = blocks[b++];
+            for(unsigned int j=0; j<block.size && !isDisabled; j++)
+                for(unsigned int k=0; k<block.size; k++)
+                    objective += delta[rowIds[i+j]]*weights[block.offset + j*block.size + k]*delta[rowIds[i+k]];
+            i += block.size;
+            continue;
         }
-        solveWithContact(result, objective, iterations);
+
+        if(!isDisabled)
+            objective += delta[rowIds[i]]*delta[rowIds[i]];
+        i++;
     }
-    else if(nbActuatorRows + nbEqualityRows > 0 )
+    return objective;
+}
+
+
+bool QPInverseProblemImpl::reuseHessian(const unsigned int& energyDim)
+{
+    QPHessianCache& cache = m_hessianCache;
+    const unsigned int dimQ = m_qpSystem->dim;
+
+    if(!cache.isValid || cache.Q.size() != dimQ*dimQ || (unsigned int)cache.WEnergy.rows() != energyDim
+            || cache.Wea.rows() != m_Wea.rows() || cache.Wea.cols() != m_Wea.cols()
+            || cache.epsilon != m_epsilon || cache.epsilonScale != m_adaptiveEpsilon.getScale())
+        return false;
+
+    for (unsigned int k=0; k<energyDim; k++)
     {
-        buildQPMatrices();
-        m_constraintHandler->buildInequalityConstraintMatrices(result, m_qpSystem, m_qpCLists);
-        m_constraintHandler->buildEqualityConstraintMatrices(result, m_qpSystem, m_qpCLists);
-        m_constraintHandler->getConstraintOnLambda(result, m_qpSystem, m_qpCLists);
+        const QPVariableRow& row = m_qpCLists->variableRows[k];
+        if(cache.epsilons[k] != ((row.hasEpsilon)? row.epsilon : m_epsilon))
+            return false;
+    }
 
-        AdvancedTimer::stepBegin("QP resolution");
-        solveInverseProblem(objective, result, dual);
-        AdvancedTimer::stepEnd("QP resolution");
+    // Exact comparison, stopped at the first entry that changed
+    if(cache.Wea != m_Wea)
+        return false;
 
-        updateLambda(result);
-        if(!isFeasible(result))
-            msg_warning("QPInverseProblemImpl") << "Solution not feasible.";
+    const QPPermutedCompliance& Wx = updatePermutedCompliance();
+    for (unsigned int k=0; k<energyDim; k++)
+        if(!std::equal(Wx[k], Wx[k] + energyDim, cache.WEnergy.data() + k*energyDim))
+            return false;
+
+    std::copy(cache.Q.begin(), cache.Q.end(), m_qpSystem->Q.data());
+    m_hessianType = cache.hessianType;
+    m_hasQChanged = false;
+    cache.nbReuses++;
+    return true;
+}
+
+
+void QPInverseProblemImpl::storeHessian(const unsigned int& energyDim)
+{
+    QPHessianCache& cache = m_hessianCache;
+    const unsigned int dimQ = m_qpSystem->dim;
+
+    cache.Wea = m_Wea;
+    cache.WEnergy.resize(energyDim, energyDim);
+    cache.epsilons.resize(energyDim);
+    const QPPermutedCompliance& Wx = updatePermutedCompliance();
+    for (unsigned int k=0; k<energyDim; k++)
+    {
+        std::copy(Wx[k], Wx[k] + energyDim, cache.WEnergy.data() + k*energyDim);
+
+        const QPVariableRow& row = m_qpCLists->variableRows[k];
+        cache.epsilons[k] = (row.hasEpsilon)? row.epsilon : m_epsilon;
     }
+    cache.epsilon = m_epsilon;
+    cache.epsilonScale = m_adaptiveEpsilon.getScale();
+
+    cache.Q.assign(m_qpSystem->Q.data(), m_qpSystem->Q.data() + dimQ*dimQ);
+    cache.hessianType = m_hessianType;
+    cache.isValid = true;
+}
+
+
+
+/// Solve system
+
+void QPInverseProblemImpl::presolveConstraints()
+{
+    if(m_presolve)
+        m_nbPresolvedRows = m_presolveStage.apply(m_qpSystem, m_qpCParams->constraintsId);
+}
+
+
+void QPInverseProblemImpl::setScaling(const bool& scaling, const unsigned int& nbIterations)
+{
+    m_scale = scaling;
+    m_scaling.setNbIterations(nbIterations);
+}
+
+
+void QPInverseProblemImpl::setContactReduction(const bool& reduce, const double& tolerance, const bool& expandForces)
+{
+    m_reduceContacts = reduce;
+    m_contactReduction.setTolerance(tolerance);
+    m_contactReduction.setExpandForces(expandForces);
+}
+
+
+void QPInverseProblemImpl::setMultilevelContacts(const bool& multilevel, const double& tolerance, const double& threshold)
+{
+    m_multilevelContacts = multilevel;
+    m_contactPatches.setTolerance(tolerance);
+    m_contactPatches.setThreshold(threshold);
+}
+
+
+void QPInverseProblemImpl::setImposedContactForces(const vector<unsigned int>& rows, const vector<double>& forces)
+{
+    m_imposedContactRows = rows;
+    m_imposedContactForces = forces;
+    m_imposedContactForces.resize(rows.size(), 0.);
+    m_imposedContactDeltas.assign(rows.size(), 0.);
+}
+
+
+void QPInverseProblemImpl::imposeContactForces()
+{
+    if(m_imposedContactRows.empty())
+        return;
+
+    const unsigned int dim = getDimension();
+    m_isImposedContactRow.assign(dim, 0);
+    for(unsigned int row : m_imposedContactRows)
+        if(row < dim)
+            m_isImposedContactRow[row] = 1;
+
+    m_allContactRowIds = m_qpCLists->contactRowIds;
+    m_allContactIds = m_qpCLists->contactIds;
+    m_qpCLists->contactRowIds.clear();
+    m_qpCLists->contactIds.clear();
+    for(unsigned int k=0; k<m_allContactRowIds.size(); k++)
+    {
+        if(m_isImposedContactRow[m_allContactRowIds[k]])
+            continue;
+        m_qpCLists->contactRowIds.push_back(m_allContactRowIds[k]);
+        if(k < m_allContactIds.size())
+            m_qpCLists->contactIds.push_back(m_allContactIds[k]);
+    }
+
+    // dfree += W(:, imposed) * forces, restored by releaseContactForces()
+    double* dfree = getDfree();
+    double** W = getW();
+    m_dfreeWithoutImposedForces.assign(dfree, dfree + dim);
+    for(unsigned int i=0; i<dim; i++)
+    {
+        const double* w = W[i];
+        for(unsigned int k=0; k<m_imposedContactRows.size(); k++)
+            if(m_imposedContactRows[k] < dim)
+                dfree[i] += w[m_imposedContactRows[k]]*m_imposedContactForces[k];
+    }
+}
+
+
+void QPInverseProblemImpl::releaseContactForces()
+{
+    if(m_imposedContactRows.empty())
+        return;
+
+    const unsigned int dim = getDimension();
+    double* lambda = getF();
+    double* dfree = getDfree();
+    double** W = getW();
+
+    // Displacements of the imposed rows: the forces of the QP variables, the imposed forces being in dfree
+    for(unsigned int k=0; k<m_imposedContactRows.size(); k++)
+    {
+        const unsigned int row = m_imposedContactRows[k];
+        if(row >= dim)
+            continue;
+
+        const double* w = W[row];
+        double delta = dfree[row];
+        for(unsigned int j : m_qpCLists->actuatorRowIds)
+            delta += w[j]*lambda[j];
+        for(unsigned int j : m_qpCLists->equalityRowIds)
+            delta += w[j]*lambda[j];
+        for(unsigned int j : m_qpCLists->contactRowIds)
+            delta += w[j]*lambda[j];
+        m_imposedContactDeltas[k] = delta;
+    }
+
+    for(unsigned int k=0; k<m_imposedContactRows.size(); k++)
+        if(m_imposedContactRows[k] < dim)
+            lambda[m_imposedContactRows[k]] = m_imposedContactForces[k];
+    std::copy(m_dfreeWithoutImposedForces.begin(), m_dfreeWithoutImposedForces.end(), dfree);
+
+    // The QP variables cover all the contacts again
+    m_qpCLists->contactRowIds = m_allContactRowIds;
+    m_qpCLists->contactIds = m_allContactIds;
+    vector<double>& x = m_qpSystem->lambda;
+    x.resize(m_qpCLists->actuatorRowIds.size() + m_qpCLists->equalityRowIds.size());
+    for(unsigned int row : m_qpCLists->contactRowIds)
+        x.push_back(lambda[row]);
+    m_qpSystem->dim = x.size();
+    if(!m_detached)
+        m_qpCLists->updateVariableRows();
+    else
+        m_qpCLists->variableRows.resize(m_qpSystem->dim);
+}
+
+
+void QPInverseProblemImpl::solve(double& objective, int& iterations)
+{
+    m_qpOASESStatistics = QPOASESStatistics();
+    std::fill(m_nbBackendSelections, m_nbBackendSelections + QPBackendSelector::NbBackends, 0u);
+
+    // The contacts are identified before the imposed ones are removed from the variables
+    if(m_trackContacts && !m_complianceOperator)
+        m_contactTracker.track(m_qpCLists, getW(), (m_mu>0.)? 3 : 1);
+
+    imposeContactForces();
+    if(m_forwardWithoutEffectors && getImposedActuation(m_imposedActuation)
+            && solveContactsOnly(m_imposedActuation, objective, iterations))
+    {
+        m_nbForwardSolves++;
+        releaseContactForces();
+        return;
+    }
+
+    if(m_complianceOperator)
+    {
+        solveMatrixFree(objective, iterations);
+        releaseContactForces();
+        return;
+    }
+
+    m_solveStartTime = CTime::getTime();
+    m_deadlineHit = false;
+    m_phaseTimes = QPPhaseTimes();
+    m_pivotsPerIteration.clear();
+
+    // The redundant contacts are merged before the sizes of the problem are set, and restored with
+    // their forces before the results are stored
+    const unsigned int contactNbLines = (m_mu>0.)? 3 : 1;
+    if(m_multilevelContacts)
+    {
+        // The patches are solved as single contacts, then the contacts of the patches at a state boundary
+        // are solved individually
+        m_contactPatches.coarsen(m_qpCLists, getW(), getDfree(), contactNbLines);
+        solveLevel(objective, iterations);
+        if(m_contactPatches.isReduced())
+        {
+            restoreContacts(m_contactPatches);
+            if(!m_deadlineHit && m_contactPatches.findBoundaries(m_qpCLists, getW(), getDfree(), m_qpSystem->lambda, m_mu) > 0)
+            {
+                int fineIterations = 0;
+                m_contactPatches.refine(m_qpCLists, getW(), getDfree(), contactNbLines);
+                solveLevel(objective, fineIterations);
+                iterations += fineIterations;
+                if(m_contactPatches.isReduced())
+                    restoreContacts(m_contactPatches);
+            }
+        }
+    }
+    else
+    {
+        if(m_reduceContacts)
+            m_contactReduction.reduce(m_qpCLists, getW(), getDfree(), contactNbLines);
+        solveLevel(objective, iterations);
+        if(m_reduceContacts && m_contactReduction.isReduced())
+            restoreContacts(m_contactReduction);
+    }
+
+    objective += getEffectorsFreeObjective();
+
+    if(m_deadlineHit)
+        m_nbDeadlineHits++;
+
+    storeResults(m_qpSystem->lambda);
+    if(m_trackContacts)
+        storeContactForces();
+    if(m_exportDuals)
+        updateActuatorLimits();
+    releaseContactForces();
+}
+
+
+void QPInverseProblemImpl::solveMatrixFree(double& objective, int& iterations)
+{
+    m_solveStartTime = CTime::getTime();
+    m_deadlineHit = false;
+    m_phaseTimes = QPPhaseTimes();
+    m_pivotsPerIteration.clear();
+
+    m_qpSystem->dim = m_qpCLists->actuatorRowIds.size() + m_qpCLists->equalityRowIds.size();
+    m_qpSystem->dFree = getDfree();
+    if(!m_detached)
+        m_qpCLists->updateVariableRows();
+
+    AdvancedTimer::stepBegin("QP resolution");
+    auto timer = startTimer();
+    vector<double>& result = m_workspace.result;
+    if(!m_matrixFreeSolver.solve(*m_complianceOperator, *m_qpCLists, getDfree(), getDimension(), m_epsilon,
+                                 result, m_matrixFreeProduct, objective))
+        warningMessage(s_matrixFreeMessage) << "The matrix-free resolution did not converge in " << m_matrixFreeSolver.getNbIterations()
+                                            << " iterations, its last iterate is used.";
+    iterations = m_matrixFreeSolver.getNbIterations();
+    m_nbComplianceProducts = m_matrixFreeSolver.getNbApplications();
+    stopTimer(timer, m_phaseTimes.qp);
+    AdvancedTimer::stepEnd("QP resolution");
+
+    updateLambda(result);
+    objective += getEffectorsFreeObjective();
+    storeResults(m_qpSystem->lambda, m_matrixFreeProduct);
+}
+
+
+void QPInverseProblemImpl::solveLevel(double& objective, int& iterations)
+{
+    int nbContactRows   = m_qpCLists->contactRowIds.size();
+    int nbActuatorRows  = m_qpCLists->actuatorRowIds.size();
+    int nbEffectorRows  = m_qpCLists->effectorRowIds.size();
+    int nbEqualityRows  = m_qpCLists->equalityRowIds.size();
+
+    m_qpSystem->dim = nbContactRows + nbActuatorRows + nbEqualityRows;
+    m_qpSystem->W = getW();
+    m_qpSystem->dFree = getDfree();
+    if(!m_detached)
+        m_qpCLists->updateVariableRows();
+    else // the limits are already set, the contacts may have been reduced
+        m_qpCLists->variableRows.resize(m_qpSystem->dim);
+    m_qpCParams->mu = m_mu;
+    m_qpCParams->allowSliding = m_allowSliding;
+    if(m_attributeCosts)
+        m_costAttribution.beginStep(*m_qpCLists, getW(), getDimension());
+    m_qpCParams->frictionCone.setNbFacets(m_nbFrictionFacets);
+    m_permutedCompliance.invalidate();
+    m_isPermutedComplianceKept = true;
+
+    // Cleared but kept in the workspace, a steady-state step does not allocate them again
+    vector<double>& result = m_workspace.result;
+    vector<double>& dual = m_workspace.dual;
+    result.clear();
+    dual.clear();
+
+    objective  = 0;
+    iterations = 0; // from contact pivot algorithm
+
+    m_nbSinglePivotFallbacks = 0;
+    m_nbPivotCycles = 0;
+    m_nbSpeculativePivots = 0;
+    m_nbComplianceProducts = 0;
+    m_duals.clear();
+    m_sensitivities.isPending = false;
+    m_nbEqualityEliminations = 0;
+    m_nbPriorityLevels = 0;
+    m_nbActiveSetCacheHits = 0;
+    m_nbActiveSetCacheMisses = 0;
+    m_nbPresolvedRows = 0;
+    m_hasSolvedNLCP = false;
+    if(m_restoredState.isPending)
+        applyRestoredState();
+    m_recovery = QPRecovery::None;
+    m_maxNbWorkingSetChanges = 0;
+    m_workingSetLimitHit = false;
+    m_blockBestNbCandidates = std::numeric_limits<int>::max();
+    m_blockNbTrials = 0;
+
+    if(nbContactRows>0)
+    {
+        setContactParams();
+        solveWithContact(result, objective, iterations);
+    }
+    else if(nbActuatorRows + nbEqualityRows > 0 )
+    {
+        auto timer = startTimer();
+        buildQPMatrices();
+        m_constraintHandler->buildConstraintMatrices(result, m_qpSystem, m_qpCLists);
+        stopTimer(timer, m_phaseTimes.build);
+
+        AdvancedTimer::stepBegin("QP resolution");
+        timer = startTimer();
+        if(!solvePrioritizedProblem(objective, result)
+                && (m_horizonProblem.getHorizon()<2 || nbEqualityRows>0 || !solveHorizonProblem(objective, result)))
+            solveInverseProblem(objective, result, dual);
+        stopTimer(timer, m_phaseTimes.qp);
+        AdvancedTimer::stepEnd("QP resolution");
+
+        updateLambda(result);
+        if(!isLayoutChecked() && !isFeasible(result))
+            warningMessage(s_feasibilityMessage) << "Solution not feasible, largest violation " << m_constraintResiduals.getMaxViolation()
+                                                 << " on the constraint row " << m_constraintResiduals.getMaxViolationRow() << " of [A; Aeq].";
+    }
+
+    if(m_computeSensitivities)
+        updateSensitivities();
+    m_isPermutedComplianceKept = false;
+}
+
+
+void QPInverseProblemImpl::restoreContacts(const QPContactReduction& reduction)
+{
+    reduction.expand(m_qpCLists, m_qpSystem->lambda);
+    m_qpSystem->dim = m_qpSystem->lambda.size();
+    if(!m_detached)
+        m_qpCLists->updateVariableRows();
+    else
+        m_qpCLists->variableRows.resize(m_qpSystem->dim);
+}
+
+
+void QPInverseProblemImpl::reuseSolution(const vector<double>& lambda)
+{
+    m_qpSystem->dim = lambda.size();
+    m_qpSystem->W = getW();
+    m_qpSystem->dFree = getDfree();
+    m_qpSystem->lambda = lambda;
+    storeResults(m_qpSystem->lambda);
+}
+
+
+bool QPInverseProblemImpl::solveContactsOnly(const vector<double>& lambdas, double& objective, int& iterations)
+{
+    const unsigned int nbFixedRows = m_qpCLists->actuatorRowIds.size() + m_qpCLists->equalityRowIds.size();
+    const unsigned int nbContactRows = m_qpCLists->contactRowIds.size();
+    if(lambdas.size() != nbFixedRows)
+        return false;
+
+    m_qpSystem->dim = nbFixedRows + nbContactRows;
+    m_qpSystem->W = getW();
+    m_qpSystem->dFree = getDfree();
+    if(!m_detached)
+        m_qpCLists->updateVariableRows();
+    else
+        m_qpCLists->variableRows.resize(m_qpSystem->dim);
+    m_qpCParams->mu = m_mu;
+    m_qpCParams->allowSliding = m_allowSliding;
+
+    // The contact forces of the last step warm start the contact solvers, as in solveWithContact()
+    m_qpSystem->lambda.resize(m_qpSystem->dim, 0.);
+    std::copy(lambdas.begin(), lambdas.end(), m_qpSystem->lambda.begin());
+
+    m_solveStartTime = CTime::getTime();
+    m_deadlineHit = false;
+    m_phaseTimes = QPPhaseTimes();
+    m_hasSolvedNLCP = false;
+    iterations = 0;
+    if(nbContactRows>0)
+    {
+        setContactParams();
+        vector<double>& result = m_workspace.result;
+
+        AdvancedTimer::stepBegin("LCP resolution");
+        auto timer = startTimer();
+        solveContacts(result, nbFixedRows);
+        stopTimer(timer, m_phaseTimes.lcp);
+        AdvancedTimer::stepEnd("LCP resolution");
+        updateLambda(result);
+    }
+
+    if(m_deadlineHit)
+        m_nbDeadlineHits++;
+
+    storeResults(m_qpSystem->lambda);
+    objective = getEffectorsObjective(m_qpSystem->delta.data());
+    return true;
+}
+
+
+bool QPInverseProblemImpl::getImposedActuation(vector<double>& lambdas)
+{
+    const unsigned int nbFixedRows = m_qpCLists->actuatorRowIds.size() + m_qpCLists->equalityRowIds.size();
+    if(!m_qpCLists->effectorRowIds.empty() || nbFixedRows == 0)
+        return false;
+
+    if(!m_detached)
+        m_qpCLists->updateVariableRows();
+    if(m_qpCLists->variableRows.size() < nbFixedRows)
+        return false;
+
+    lambdas.resize(nbFixedRows);
+    for(unsigned int i=0; i<nbFixedRows; i++)
+    {
+        const QPVariableRow& row = m_qpCLists->variableRows[i];
+        if(row.isDisabled)
+            lambdas[i] = 0.;
+        else if(row.hasDeltaMin || row.hasDeltaMax || row.hasDeltaEqual)
+            return false; // the force depends on the displacement
+        else if(row.hasLambdaEqual)
+            lambdas[i] = row.lambdaEqual;
+        else if(row.hasLambdaMin && row.hasLambdaMax && row.lambdaMin == row.lambdaMax)
+            lambdas[i] = row.lambdaMin;
+        else
+            return false;
+    }
+    return true;
+}
+
+
+void QPInverseProblemImpl::setContactParams()
+{
+    if(m_mu>0.)
+    {
+        // TODO: implement choice of user and projection of the tangential force to determine dir1 and dir2
+        m_qpCParams->slidingDirId1 = 1;
+        m_qpCParams->slidingDirId2 = 2;
+        m_qpCParams->contactNbLines = 3;
+        m_qpCParams->nbContactPoints = m_qpCLists->contactRowIds.size()/m_qpCParams->contactNbLines;
+    }
+    else
+    {
+        m_qpCParams->contactNbLines = 1;
+        m_qpCParams->nbContactPoints = m_qpCLists->contactRowIds.size();
+    }
+}
+
+
+void QPInverseProblemImpl::solveWithContact(vector<double>& result, double& objective, int& iteration)
+{
+    int nbActuatorRows  = m_qpCLists->actuatorRowIds.size();
+
+    m_constraintHandler->initContactHandlerList();
+    m_constraintHandler->initContactHandlers();
+
+    AdvancedTimer::stepBegin("LCP resolution");
+    auto timer = startTimer();
+    auto span = beginSpan();
+    solveContacts(result, nbActuatorRows);
+    stopTimer(timer, m_phaseTimes.lcp);
+    endSpan(s_lcpSpan, span, {{s_dimArg, (long long)m_qpCLists->contactRowIds.size()}});
+    AdvancedTimer::stepEnd("LCP resolution");
+    updateLambda(result);
+    m_qpSystem->previousResult = result;
+
+    m_nbWarmStartedContacts = 0;
+    if(nbActuatorRows>0)
+    {
+        m_constraintHandler->initContactHandlers(result, m_qpCLists);
+        if(m_warmStartContacts)
+            warmStartContactStates();
+
+        iteration = 0;
+        objective = 0.;
+
+        timer = startTimer();
+        buildQPMatrices();
+        stopTimer(timer, m_phaseTimes.build);
+
+        // The null rows are removed by the presolve stage, if enabled, before each QP
+
+        AdvancedTimer::stepBegin("QPs resolution");
+        m_pivotWorkingSet.clear();
+        m_pivotWorkingSet.enabled = true;
+        if(m_activeSetCache.getCapacity()>0)
+            restoreActiveSet();
+        if(m_primalWarmStart && !m_pivotWorkingSet.valid)
+            seedPivotWorkingSet(result);
+        m_constraintHandler->setReuseConstraintRows(true); // Only the rows of the contacts that changed are rebuilt
+        bool stopFlag = false;
+        bool converged = false;
+        m_pivotLimit.setMaxLimit(m_maxNbPivot);
+        const int maxNbPivots = m_pivotLimit.getLimit();
+        span = beginSpan();
+        while(stopFlag == false && iteration<=maxNbPivots)
+        {
+            m_iteration = iteration;
+            auto pivotSpan = beginSpan();
+
+            timer = startTimer();
+            m_qpCParams->constraintsId.clear();
+            m_constraintHandler->buildConstraintMatrices(result, m_qpSystem, m_qpCLists);
+            stopTimer(timer, m_phaseTimes.build);
+
+            vector<double>& dual = m_workspace.dual;
+            dual.clear();
+            timer = startTimer();
+            solveInverseProblem(objective, result, dual);
+            stopTimer(timer, m_phaseTimes.qp);
+
+            // Out of time, keep this result (the best feasible iterate if the QP was stopped)
+            bool outOfTime = isDeadlineReached();
+            m_deadlineHit |= outOfTime;
+
+            stopFlag = outOfTime || m_workingSetLimitHit || checkAndUpdatePivot(result, dual);
+            converged = stopFlag && !outOfTime && !m_workingSetLimitHit;
+            endSpan(s_pivotSpan, pivotSpan, {{s_iterationArg, iteration}});
+            iteration++;
+
+            if(stopFlag == true || iteration == maxNbPivots)
+                updateLambda(result);
+        }
+        m_pivotLimit.add(iteration);
+        endSpan(s_pivotLoopSpan, span, {{s_pivotsArg, iteration}});
+        AdvancedTimer::stepEnd("QPs resolution");
+        if(m_activeSetCache.getCapacity()>0 && converged)
+            storeActiveSet();
+        m_activeSetKey.clear();
+        if(m_primalWarmStart && m_pivotWorkingSet.valid)
+            std::swap(m_previousStepWorkingSet, m_pivotWorkingSet);
+        m_pivotWorkingSet.enabled = false;
+        m_constraintHandler->setReuseConstraintRows(false);
+
+        if(m_warmStartContacts)
+            storeContactStates();
+        m_qpCParams->contactStates.clear();
+        m_sequence.clear();
+        m_currentSequence.clear();
+        m_previousSequence.clear();
+    }
+}
+
+
+void QPInverseProblemImpl::setPivoting(const std::string& name)
+{
+    if(name == "Single")
+        m_blockPivoting = false;
+    else if(name == "Block")
+        m_blockPivoting = true;
+    else
+    {
+        msg_error("QPInverseProblemImpl") << "Unknown pivoting " << name << ", use Single instead.";
+        m_blockPivoting = false;
+    }
+}
+
+
+void QPInverseProblemImpl::setWarmStartContacts(const bool& warmStart)
+{
+    m_warmStartContacts = warmStart;
+    if(!warmStart)
+        m_workspace.contactStates.clear();
+}
+
+
+void QPInverseProblemImpl::setTrackContacts(const bool& track)
+{
+    m_trackContacts = track;
+    if(!track)
+    {
+        m_contactTracker.clear();
+        m_previousContactForceIds.clear();
+        m_previousContactForces.clear();
+    }
+}
+
+
+void QPInverseProblemImpl::setPrimalWarmStart(const bool& warmStart)
+{
+    m_primalWarmStart = warmStart;
+    if(!warmStart)
+        m_previousStepWorkingSet.clear();
+}
+
+
+void QPInverseProblemImpl::seedPivotWorkingSet(const vector<double>& result)
+{
+    const unsigned int nbVariables = m_qpSystem->dim;
+    if(result.size() != nbVariables)
+        return;
+
+    // The rows of the constraints are matched by constraint id, as between two pivots
+    if(m_previousStepWorkingSet.bounds.size() == nbVariables)
+    {
+        m_pivotWorkingSet.bounds.swap(m_previousStepWorkingSet.bounds);
+        m_pivotWorkingSet.constraintOffsets.swap(m_previousStepWorkingSet.constraintOffsets);
+        m_pivotWorkingSet.constraints.swap(m_previousStepWorkingSet.constraints);
+    }
+    m_previousStepWorkingSet.clear();
+
+    m_pivotWorkingSet.x.assign(result.begin(), result.end());
+    m_pivotWorkingSet.valid = true;
+    m_pivotWorkingSet.isPrimalWarmStart = true;
+}
+
+
+void QPInverseProblemImpl::warmStartContactStates()
+{
+    const vector<QPContactId>& contactIds = m_qpCLists->contactIds;
+    if(contactIds.size() != m_qpCLists->contactRowIds.size())
+        return;
+
+    if(!m_restoredState.contactStates.empty())
+        applyRestoredContactStates();
+
+    const vector<ContactHandler*>& allowedStates = m_qpCParams->allowedContactStates;
+    for(unsigned int i=0; i<m_qpCParams->nbContactPoints; i++)
+    {
+        const QPContactId& id = contactIds[i*m_qpCParams->contactNbLines];
+        if(!id.isValid())
+            continue;
+
+        const vector<QPWorkspace::ContactState>& previousStates = m_workspace.contactStates;
+        auto it = std::lower_bound(previousStates.begin(), previousStates.end(), id,
+                                   [](const QPWorkspace::ContactState& state, const QPContactId& id){return state.first < id;});
+        if(it == previousStates.end() || id < it->first) // New contact, keep the guess from the contact LCP
+            continue;
+
+        // The state is only kept if it still applies (the friction may have been changed)
+        if(std::find(allowedStates.begin(), allowedStates.end(), it->second) == allowedStates.end())
+            continue;
+
+        m_qpCParams->contactStates[i] = it->second;
+        m_nbWarmStartedContacts++;
+    }
+}
+
+
+void QPInverseProblemImpl::storeContactStates()
+{
+    // Contacts that disappeared are forgotten
+    vector<QPWorkspace::ContactState>& previousStates = m_workspace.contactStates;
+    previousStates.clear();
+
+    const vector<QPContactId>& contactIds = m_qpCLists->contactIds;
+    if(contactIds.size() != m_qpCLists->contactRowIds.size())
+        return;
+
+    for(unsigned int i=0; i<m_qpCParams->contactStates.size(); i++)
+    {
+        const QPContactId& id = contactIds[i*m_qpCParams->contactNbLines];
+        if(id.isValid())
+            previousStates.push_back({id, m_qpCParams->contactStates[i]});
+    }
+
+    // The identities of a step are unique
+    std::sort(previousStates.begin(), previousStates.end(),
+              [](const QPWorkspace::ContactState& a, const QPWorkspace::ContactState& b){return a.first < b.first;});
+}
+
+
+void QPInverseProblemImpl::setPreviousContactState(const QPContactId& id, ContactHandler* state)
+{
+    vector<QPWorkspace::ContactState>& previousStates = m_workspace.contactStates;
+    auto it = std::lower_bound(previousStates.begin(), previousStates.end(), id,
+                               [](const QPWorkspace::ContactState& state, const QPContactId& id){return state.first < id;});
+    if(it != previousStates.end() && !(id < it->first))
+        it->second = state;
+    else
+        previousStates.insert(it, {id, state});
+}
+
+
+void QPInverseProblemImpl::initContactForces(FullVector<double>& x, const unsigned int& nbFixedRows) const
+{
+    const unsigned int nbContactRows = m_qpCLists->contactRowIds.size();
+    const vector<QPContactId>& contactIds = m_qpCLists->contactIds;
+
+    // The rows of the contacts can be reordered between the steps: a tracked contact starts from the forces
+    // of the same contact at the end of the previous resolution, a new one from zero
+    if(m_trackContacts && !m_previousContactForceIds.empty() && contactIds.size() == nbContactRows)
+    {
+        const unsigned int nbLines = (m_mu>0.)? 3 : 1;
+        for(unsigned int first=0; first+nbLines<=nbContactRows; first+=nbLines)
+        {
+            const auto it = (contactIds[first].isValid())? m_previousContactForceIds.find(contactIds[first])
+                                                          : m_previousContactForceIds.end();
+            for(unsigned int line=0; line<nbLines; line++)
+                x[first + line] = (it != m_previousContactForceIds.end())? m_previousContactForces[it->second + line] : 0.;
+        }
+        return;
+    }
+
+    if(m_qpSystem->lambda.size()>=nbFixedRows+nbContactRows)
+        for(unsigned int i=0; i<nbContactRows; i++)
+            x[i] = m_qpSystem->lambda[nbFixedRows+i];
+}
+
+
+void QPInverseProblemImpl::storeContactForces()
+{
+    // Contacts that disappeared are forgotten
+    m_previousContactForceIds.clear();
+    m_previousContactForces.clear();
+
+    const vector<QPContactId>& contactIds = m_qpCLists->contactIds;
+    const unsigned int nbContactRows = m_qpCLists->contactRowIds.size();
+    const unsigned int firstContact = m_qpCLists->actuatorRowIds.size() + m_qpCLists->equalityRowIds.size();
+    const vector<double>& lambda = m_qpSystem->lambda;
+    if(contactIds.size() != nbContactRows || lambda.size() < firstContact + nbContactRows)
+        return;
+
+    const unsigned int nbLines = (m_mu>0.)? 3 : 1;
+    for(unsigned int first=0; first+nbLines<=nbContactRows; first+=nbLines)
+    {
+        if(!contactIds[first].isValid())
+            continue;
+        m_previousContactForceIds[contactIds[first]] = m_previousContactForces.size();
+        m_previousContactForces.insert(m_previousContactForces.end(), lambda.begin() + firstContact + first,
+                                       lambda.begin() + firstContact + first + nbLines);
+    }
+}
+
+
+void QPInverseProblemImpl::QPRestoredState::clear()
+{
+    actuatorRowIds.clear();
+    equalityRowIds.clear();
+    lambda.clear();
+    contactStates.clear();
+    activeBounds.clear();
+    activeSets.clear();
+    isPending = false;
+}
+
+
+void QPInverseProblemImpl::saveCheckpoint(QPCheckpoint& checkpoint) const
+{
+    checkpoint.clear();
+
+    // A state restored but not applied yet is saved as it was read
+    const unsigned int nbVariables = m_qpCLists->actuatorRowIds.size() + m_qpCLists->equalityRowIds.size();
+    if(m_restoredState.isPending)
+    {
+        checkpoint.actuatorRowIds = m_restoredState.actuatorRowIds;
+        checkpoint.equalityRowIds = m_restoredState.equalityRowIds;
+        checkpoint.lambda = m_restoredState.lambda;
+        checkpoint.activeBounds = m_restoredState.activeBounds;
+        checkpoint.activeSets = m_restoredState.activeSets;
+    }
+    else
+    {
+        if(nbVariables > 0 && m_qpSystem->lambda.size() >= nbVariables)
+        {
+            checkpoint.actuatorRowIds = m_qpCLists->actuatorRowIds;
+            checkpoint.equalityRowIds = m_qpCLists->equalityRowIds;
+            checkpoint.lambda.assign(m_qpSystem->lambda.begin(), m_qpSystem->lambda.begin()+nbVariables);
+        }
+        checkpoint.activeBounds = m_activeBounds;
+        checkpoint.activeSets = m_activeSetCache.getEntries();
+    }
+
+    for(const auto& [id, state] : m_workspace.contactStates)
+        if(id.constraint && state)
+            checkpoint.contactStates.push_back({id.constraint->getPathName(), id.id, state->getStateString()});
+    for(const auto& [id, state] : m_restoredState.contactStates)
+        checkpoint.contactStates.push_back({id.first, id.second, state});
+}
+
+
+void QPInverseProblemImpl::restoreCheckpoint(const QPCheckpoint& checkpoint)
+{
+    m_restoredState.clear();
+    if(checkpoint.lambda.size() == checkpoint.actuatorRowIds.size() + checkpoint.equalityRowIds.size())
+    {
+        m_restoredState.actuatorRowIds = checkpoint.actuatorRowIds;
+        m_restoredState.equalityRowIds = checkpoint.equalityRowIds;
+        m_restoredState.lambda = checkpoint.lambda;
+    }
+
+    m_restoredState.activeBounds = checkpoint.activeBounds;
+    m_restoredState.activeSets = checkpoint.activeSets;
+    m_restoredState.isPending = true;
+
+    m_workspace.contactStates.clear();
+    for(const QPCheckpoint::ContactState& contact : checkpoint.contactStates)
+        m_restoredState.contactStates[{contact.constraint, contact.id}] = contact.state;
+}
+
+
+void QPInverseProblemImpl::applyRestoredState()
+{
+    // From the least to the most recently used, the most recent ones are kept by a smaller cache
+    m_activeBounds = m_restoredState.activeBounds;
+    m_activeSetCache.clear();
+    for(auto it = m_restoredState.activeSets.rbegin(); it != m_restoredState.activeSets.rend(); ++it)
+        m_activeSetCache.insert(it->first, it->second);
+
+    // The forces are only restored in the same rows, the first step is otherwise initialized from lambdaInit
+    if(!m_restoredState.lambda.empty()
+            && m_restoredState.actuatorRowIds == m_qpCLists->actuatorRowIds
+            && m_restoredState.equalityRowIds == m_qpCLists->equalityRowIds
+            && m_restoredState.lambda.size() <= m_qpSystem->dim)
+    {
+        if(m_step == 0)
+        {
+            init();
+            m_step++;
+        }
+        std::copy(m_restoredState.lambda.begin(), m_restoredState.lambda.end(), m_qpSystem->lambda.begin());
+    }
+
+    m_restoredState.actuatorRowIds.clear();
+    m_restoredState.equalityRowIds.clear();
+    m_restoredState.lambda.clear();
+    m_restoredState.activeBounds.clear();
+    m_restoredState.activeSets.clear();
+    m_restoredState.isPending = false;
+}
+
+
+void QPInverseProblemImpl::applyRestoredContactStates()
+{
+    // The contacts of the first step with contacts are matched with the restored ones, the others are forgotten
+    const vector<QPContactId>& contactIds = m_qpCLists->contactIds;
+    const vector<ContactHandler*>& allowedStates = m_qpCParams->allowedContactStates;
+    for(unsigned int i=0; i<m_qpCParams->nbContactPoints; i++)
+    {
+        const QPContactId& id = contactIds[i*m_qpCParams->contactNbLines];
+        if(!id.isValid())
+            continue;
+
+        auto it = m_restoredState.contactStates.find({id.constraint->getPathName(), id.id});
+        if(it == m_restoredState.contactStates.end())
+            continue;
+
+        for(ContactHandler* state : allowedStates)
+            if(state->getStateString() == it->second)
+                setPreviousContactState(id, state);
+    }
+    m_restoredState.contactStates.clear();
+}
+
+
+bool QPInverseProblemImpl::restoreActiveSet()
+{
+    const vector<ContactHandler*>& allowedStates = m_qpCParams->allowedContactStates;
+    vector<ContactHandler*>& contactStates = m_qpCParams->contactStates;
+
+    // Signature of the starting configuration, each list preceded by its size
+    QPActiveSetCache::Key& key = m_activeSetKey;
+    key.clear();
+    for(const auto* rowIds : {&m_qpCLists->actuatorRowIds, &m_qpCLists->equalityRowIds, &m_qpCLists->contactRowIds})
+    {
+        key.push_back(rowIds->size());
+        key.insert(key.end(), rowIds->begin(), rowIds->end());
+    }
+    key.push_back(contactStates.size());
+    for(ContactHandler* state : contactStates)
+        key.push_back(std::find(allowedStates.begin(), allowedStates.end(), state) - allowedStates.begin());
+    key.push_back(m_activeBounds.size());
+    key.insert(key.end(), m_activeBounds.begin(), m_activeBounds.end());
+
+    const QPActiveSetCache::Entry* entry = m_activeSetCache.find(key);
+    if(!entry || entry->contactStates.size() != contactStates.size())
+    {
+        m_nbActiveSetCacheMisses++;
+        return false;
+    }
+
+    for(unsigned int i=0; i<contactStates.size(); i++)
+        contactStates[i] = allowedStates[entry->contactStates[i]];
+
+    // The first QP is initialized with this working set (see initWithPivotWorkingSet()), and the pivot
+    // algorithm still checks the contact states
+    m_pivotWorkingSet.x = entry->x;
+    for(const int& status : entry->bounds)
+        m_pivotWorkingSet.bounds.push_back(qpOASES::SubjectToStatus(status));
+    // The entry is sorted by variable id and rank
+    for(const auto& [row, status] : entry->constraints)
+        m_pivotWorkingSet.appendConstraintStatus(row.first, qpOASES::SubjectToStatus(status));
+    m_pivotWorkingSet.valid = !entry->bounds.empty();
+
+    m_nbActiveSetCacheHits++;
+    return true;
+}
+
+
+void QPInverseProblemImpl::storeActiveSet()
+{
+    const vector<ContactHandler*>& allowedStates = m_qpCParams->allowedContactStates;
+
+    QPActiveSetCache::Entry entry;
+    for(ContactHandler* state : m_qpCParams->contactStates)
+    {
+        auto it = std::find(allowedStates.begin(), allowedStates.end(), state);
+        if(it == allowedStates.end())
+            return;
+        entry.contactStates.push_back(it - allowedStates.begin());
+    }
+
+    m_activeBounds.clear();
+    if(m_pivotWorkingSet.valid)
+    {
+        entry.x.assign(m_pivotWorkingSet.x.begin(), m_pivotWorkingSet.x.end());
+        for(const qpOASES::SubjectToStatus& status : m_pivotWorkingSet.bounds)
+        {
+            if(status != qpOASES::ST_INACTIVE)
+                m_activeBounds.push_back(entry.bounds.size());
+            entry.bounds.push_back(status);
+        }
+        const vector<unsigned int>& offsets = m_pivotWorkingSet.constraintOffsets;
+        for(unsigned int id=0; id+1<offsets.size(); id++)
+            for(unsigned int k=offsets[id]; k<offsets[id+1]; k++)
+                entry.constraints[std::make_pair(int(id), int(k-offsets[id]))] = m_pivotWorkingSet.constraints[k];
+    }
+
+    if(!m_activeSetKey.empty())
+        m_activeSetCache.insert(m_activeSetKey, entry);
+}
+
+
+void QPInverseProblemImpl::solveContacts(vector<double>& res, const unsigned int& nbFixedRows)
+{
+    unsigned int nbContactRows    = m_qpCLists->contactRowIds.size();
+
+    // The fixed rows are the first variables of the gathered block W(x, x), the contacts its last ones
+    const QPPermutedCompliance& Wx = updatePermutedCompliance();
+    const unsigned int firstContact = Wx.getDimension() - nbContactRows;
+
+    // The QP solver of the frictionless problem needs the dense matrix
+    const bool useSparseM = m_sparseContacts && (m_mu>0. || m_usePGSSolver);
+
+    // Kept across steps, only reallocated when the number of contact rows grows
+    FullVector<double>& q = m_contactQ;
+    q.resize(nbContactRows);
+    LPtrFullMatrix<double>& M = m_contactM;
+    if(useSparseM)
+        m_contactSparseM.build(m_qpSystem->W, nbContactRows, m_qpCParams->contactNbLines, m_qpCLists->contactRowIds.data());
+    else
+        M.resize(nbContactRows,nbContactRows);
+
+    if (m_step == 0) {
+        init();
+        m_step++;
+    }
+
+    for(unsigned int i=0; i<nbContactRows; i++)
+    {
+        const double* Wi = Wx[firstContact + i];
+        q[i]=m_qpSystem->dFree[m_qpCLists->contactRowIds[i]];
+        if(m_qpSystem->lambda.size()!=0)
+            for(unsigned int j=0; j<nbFixedRows; j++)
+                q[i]+=Wi[j]*m_qpSystem->lambda[j];
+
+        if(!useSparseM)
+            std::copy(Wi + firstContact, Wi + firstContact + nbContactRows, M[i]);
+    }
+
+    FullVector<double>& x = m_contactForces;
+    res.clear();
+    res.resize(m_qpSystem->dim, 0.);
+
+    if(m_mu>0.)
+    {
+        x.resize(nbContactRows);
+
+        // Warm start
+        initContactForces(x, nbFixedRows);
+
+        m_nlcpSolver->setAllowSliding(m_allowSliding);
+        m_nlcpSolver->setTimeLimit((m_timeBudget>0.)? std::max(getRemainingTime(s_contactBudgetRatio), 1e-6) : 0.);
+        if(useSparseM)
+            m_nlcpSolver->solve(nbContactRows, q.ptr(), m_contactSparseM, x.ptr(), m_mu, m_tolerance, m_maxIteration, true);
+        else
+            m_nlcpSolver->solve(nbContactRows, q.ptr(), M.lptr(), x.ptr(), m_mu, m_tolerance, m_maxIteration, true);
+        m_deadlineHit |= m_nlcpSolver->isTimeLimitReached();
+        m_hasSolvedNLCP = true;
+
+        for (unsigned int i=0; i<nbContactRows; i++)
+            res[i+nbFixedRows] = x[i];
+    }
+    else
+    {
+        x.clear();
+        x.resize(nbContactRows);
+        double timeLimit = (m_timeBudget>0.)? std::max(getRemainingTime(s_contactBudgetRatio), 1e-6) : 0.;
+
+        if(m_usePGSSolver)
+        {
+            // Warm start
+            initContactForces(x, nbFixedRows);
+
+            m_pgsSolver->setTolerance(m_tolerance);
+            m_pgsSolver->setMaxIterations(m_maxIteration);
+            m_pgsSolver->setTimeLimit(timeLimit);
+            if(useSparseM)
+                m_pgsSolver->solve(nbContactRows, q.ptr(), m_contactSparseM, x.ptr());
+            else
+                m_pgsSolver->solve(nbContactRows, q.ptr(), M.lptr(), x.ptr());
+            m_deadlineHit |= m_pgsSolver->isTimeLimitReached();
+        }
+        else
+        {
+            m_lcpSolver->setHotStart(m_hotStart);
+            m_lcpSolver->setTimeLimit(timeLimit);
+            m_lcpSolver->solve(nbContactRows, q.ptr(), M.lptr(), x.ptr());
+            m_deadlineHit |= m_lcpSolver->isTimeLimitReached();
+        }
+
+        for (unsigned int i=0; i<nbContactRows; i++)
+            res[i+nbFixedRows]=x[i];
+    }
+
+    if(m_qpSystem->lambda.size()>=nbFixedRows)
+        for (unsigned int i=0; i<nbFixedRows; i++)
+            res[i] = m_qpSystem->lambda[i];
+}
+
+
+void QPInverseProblemImpl::solveInverseProblem(double& objective,
+                                               vector<double> &result,
+                                               vector<double> &dual)
+{
+    m_qpSystem->previousResult = result;
+    m_nWSRLimit = m_workingSetLimit.getLimit();
+    presolveConstraints();
+
+    int ASize = m_qpSystem->A.size();
+    int AeqSize = m_qpSystem->Aeq.size();
+    int nbVariables = m_qpSystem->dim;
+    int nbConstraints = ASize+AeqSize;
+
+    // The reduced QP is smaller than the full one, the buffers are sized for the full one
+    m_workspace.reserve(nbVariables, nbConstraints);
+    real_t* lambda = m_workspace.lambda.data();
+    real_t * slack = m_workspace.slack.data(); // dual solution: slack[0:nV-1] => corresponds to lambda, slack[nV:nC+1] => corresponds to dual variables
+
+    // The equality constraints are eliminated by substitution, the full QP is solved if Aeq is rank
+    // deficient or if the reduced QP is infeasible (the recoveries rebuild the constraints of the full QP)
+    bool solved = false;
+    if(m_eliminateEqualities && AeqSize>0 && beginEqualityElimination())
+    {
+        solved = solveQP(objective, result, lambda, slack);
+        endEqualityElimination(solved, objective, lambda, slack);
+    }
+    if(!solved)
+        solveQP(objective, result, lambda, slack);
+
+    if(m_attributeCosts)
+        m_costAttribution.addResolution(*m_qpCLists, m_qpCParams->constraintsId, nbVariables, nbConstraints, slack);
+
+    dual.resize(nbConstraints);
+    for (int i=0; i<nbConstraints; i++)
+        dual[i]=slack[nbVariables+i];
+
+    if(m_exportDuals)
+    {
+        m_duals.bounds.assign(slack, slack+nbVariables);
+        m_duals.constraints.assign(dual.begin(), dual.end());
+        m_duals.constraintsId.assign(m_qpCParams->constraintsId.begin(), m_qpCParams->constraintsId.end());
+    }
+
+    // The derivatives are only computed for the last QP, see updateSensitivities()
+    if(m_computeSensitivities)
+    {
+        m_sensitivities.dual.assign(slack, slack+nbVariables+nbConstraints);
+        m_sensitivities.constraintsId.assign(m_qpCParams->constraintsId.begin(), m_qpCParams->constraintsId.end());
+        m_sensitivities.isPending = true;
+    }
+
+    result.clear();
+    result.resize(nbVariables);
+    for (int i=0; i<nbVariables; i++){
+        result[i]=lambda[i];
+    }
+}
+
+
+bool QPInverseProblemImpl::solveQP(double& objective, const vector<double>& result, real_t* lambda, real_t* slack)
+{
+    int nbVariables = m_qpSystem->dim;
+    int nbConstraints = m_qpSystem->A.size()+m_qpSystem->Aeq.size();
+
+    real_t* Q = nullptr;
+    real_t* c = nullptr;
+    real_t* l = nullptr;
+    real_t* u = nullptr;
+    real_t* A  = nullptr;
+    real_t* bu = m_workspace.bu.data();
+    real_t* bl = m_workspace.bl.data();
+
+    updateOASESMatrices(Q, c, l, u, A, bl, bu);
+
+    m_reducedQPInfeasible = false;
+    auto span = beginSpan();
+
+    // The methods tried before the built-in qpOASES resolution: the enabled ones, or the backend chosen by the
+    // adaptive QP solver and its fallback
+    bool useInterior = m_interiorFastPath;
+    bool useSmallProblemKernel = m_smallProblemKernel;
+    QPSolverBackend* qpBackend = m_qpBackend;
+    if(m_isBackendAdaptive)
+    {
+        const QPBackendSelector::Decision& decision = selectBackend(A, nbVariables, nbConstraints);
+        auto isChosen = [&decision](const QPBackendSelector::Backend& backend)
+        {
+            return decision.backend == backend || decision.fallback == backend;
+        };
+        useInterior = isChosen(QPBackendSelector::Interior);
+        useSmallProblemKernel = isChosen(QPBackendSelector::SmallKernel);
+        qpBackend = (isChosen(QPBackendSelector::ADMM))? m_admmBackend : nullptr;
+    }
+
+    bool solved = false;
+    if(useInterior && m_qpSystem->Aeq.empty() && nbVariables>0)
+    {
+        solved = solveInteriorProblem(Q, c, l, u, A, bl, bu, lambda, slack, objective);
+        if(solved)
+        {
+            m_nbQPIterations = 0;
+            m_nbInteriorSolves++;
+        }
+        if(m_isBackendAdaptive)
+            m_backendSelector.setOutcome(QPBackendSelector::Interior, solved, 0);
+    }
+
+    if(!solved && useSmallProblemKernel && m_qpCLists->contactRowIds.empty() && QPSmallProblem::isSupported(nbVariables, nbConstraints))
+    {
+        solved = m_smallProblem.solve(nbVariables, nbConstraints, Q, c, A, l, u, bl, bu, lambda, slack, objective, m_nWSRLimit);
+        if(solved)
+        {
+            m_nbQPIterations = m_smallProblem.getNbIterations();
+            addWorkingSetChanges(m_nbQPIterations);
+            m_nbSmallProblemSolves++;
+        }
+        if(m_isBackendAdaptive)
+            m_backendSelector.setOutcome(QPBackendSelector::SmallKernel, solved, m_smallProblem.getNbIterations());
+    }
+
+    if(!solved && qpBackend)
+    {
+        real_t cputime = 0.;
+        qpBackend->setTimeLimit(getCPUTimeLimit(cputime)? cputime : 0.);
+        // The contacts are the last variables, they couple the groups of actuators
+        qpBackend->setStructuredFactorization(m_structuredFactorization, m_qpCLists->contactRowIds.size());
+        qpBackend->setMultithreading(m_multithreading);
+        solved = qpBackend->solve(nbVariables, nbConstraints, Q, c, A, l, u, bl, bu, lambda, slack, objective);
+        m_nbQPIterations = qpBackend->getNbIterations();
+        if(m_isBackendAdaptive)
+            m_backendSelector.setOutcome(QPBackendSelector::ADMM, solved, m_nbQPIterations);
+        if(!solved && qpBackend->isTimeLimitReached())
+        {
+            real_t* iterate = m_workspace.iterate.data();
+            std::copy(lambda, lambda+nbVariables, iterate);
+            m_deadlineHit = true;
+            useBestIterate(result, iterate, Q, c, l, u, lambda, slack, objective);
+            solved = true;
+        }
+        else if(!solved)
+            warningMessage(s_backendMessage) << qpBackend->getName() << " did not solve the QP at time = " << m_time << ", solve it with qpOASES." ;
+    }
+
+    if(!solved)
+    {
+        solveWithQPOASES(objective, result, Q, c, l, u, A, bl, bu, lambda, slack);
+        if(m_isBackendAdaptive)
+            m_backendSelector.setOutcome(QPBackendSelector::ActiveSet, true, m_nbQPIterations);
+    }
+    endSpan(s_qpSpan, span, {{s_dimArg, nbVariables}, {s_constraintsArg, nbConstraints}, {s_nWSRArg, m_nbQPIterations}});
+
+    if(m_reducedQPInfeasible)
+        return false;
+
+    if(m_scale)
+        m_scaling.unscaleSolution(nbVariables, nbConstraints, lambda, slack);
+    return true;
+}
+
+
+const QPBackendSelector::Decision& QPInverseProblemImpl::selectBackend(const real_t* A, const int& nbVariables,
+                                                                       const int& nbConstraints)
+{
+    QPBackendSelector::Features features;
+    features.dim = nbVariables;
+    features.nbConstraints = nbConstraints;
+    features.nbEqualities = m_qpSystem->Aeq.size();
+    features.nbContacts = m_qpCLists->contactRowIds.size();
+    features.isSmallProblem = (features.nbContacts == 0 && QPSmallProblem::isSupported(nbVariables, nbConstraints));
+    features.isADMMAvailable = (m_admmBackend != nullptr);
+    if(A && nbConstraints>0 && nbVariables>0)
+    {
+        const size_t size = size_t(nbConstraints)*nbVariables;
+        features.density = double(size - std::count(A, A+size, 0.))/size;
+    }
+
+    const QPBackendSelector::Decision& decision = m_backendSelector.select(features);
+    m_nbBackendSelections[decision.backend]++;
+    if(decision.hasChanged)
+    {
+        QPMessageQueue::Stream message = infoMessage(s_selectionMessage);
+        message << "QP solved with " << QPBackendSelector::getName(decision.backend) << " from time = " << m_time
+                << " (dim " << features.dim << ", " << features.nbConstraints << " constraints, density "
+                << features.density << ", " << features.nbContacts << " contacts), expected time in us:";
+        for(unsigned int b=0; b<QPBackendSelector::NbBackends; b++)
+            if(decision.costs[b] >= 0.)
+                message << " " << QPBackendSelector::getName(QPBackendSelector::Backend(b)) << " " << decision.costs[b];
+    }
+    return decision;
+}
+
+
+bool QPInverseProblemImpl::solveInteriorProblem(const real_t* Q, const real_t* c, const real_t* l, const real_t* u,
+                                                const real_t* A, const real_t* bl, const real_t* bu,
+                                                real_t* lambda, real_t* slack, double& objective)
+{
+    const int nbVariables = m_qpSystem->dim;
+    const int nbConstraints = m_qpSystem->A.size();
+
+    Eigen::Map<const RowMajorMatrixXd> H(Q, nbVariables, nbVariables);
+    Eigen::Map<const VectorXd> g(c, nbVariables);
+    m_interiorFactorization.compute(H);
+    if(m_interiorFactorization.info() != Eigen::Success)
+        return false;
+
+    // A semi-definite Q has no unique minimizer, qpOASES handles it
+    const VectorXd& D = m_interiorFactorization.vectorD();
+    if(D.minCoeff() <= std::numeric_limits<double>::epsilon()*std::max(1., D.maxCoeff())*nbVariables)
+        return false;
+
+    m_interiorSolution.noalias() = -m_interiorFactorization.solve(g);
+    const VectorXd& x = m_interiorSolution;
+
+    // A bound or a constraint at its limit may be active, qpOASES decides
+    Eigen::Map<const VectorXd> lower(l, nbVariables);
+    Eigen::Map<const VectorXd> upper(u, nbVariables);
+    if(!((x.array() > lower.array()).all() && (x.array() < upper.array()).all()))
+        return false;
+
+    if(nbConstraints>0)
+    {
+        Eigen::Map<const RowMajorMatrixXd> AMap(A, nbConstraints, nbVariables);
+        m_interiorProducts.noalias() = AMap*x;
+        Eigen::Map<const VectorXd> lowerA(bl, nbConstraints);
+        Eigen::Map<const VectorXd> upperA(bu, nbConstraints);
+        if(!((m_interiorProducts.array() > lowerA.array()).all() && (m_interiorProducts.array() < upperA.array()).all()))
+            return false;
+    }
+
+    Eigen::Map<VectorXd>(lambda, nbVariables) = x;
+    std::fill(slack, slack+nbVariables+nbConstraints, 0.);
+    objective = 0.5*g.dot(x); // x^T*Q*x = -c^T*x at the minimizer
+    return true;
+}
+
+
+bool QPInverseProblemImpl::beginEqualityElimination()
+{
+    if(!m_equalityElimination.reduce(*m_qpSystem, m_qpCParams->constraintsId))
+        return false;
+
+    m_fullQPSystem = m_qpSystem;
+    m_qpSystem = m_equalityElimination.getReducedSystem();
+    m_qpCParams->constraintsId.swap(m_equalityElimination.getReducedConstraintsId());
+    return true;
+}
+
+
+void QPInverseProblemImpl::endEqualityElimination(const bool& solved, double& objective, real_t* lambda, real_t* slack)
+{
+    m_qpSystem = m_fullQPSystem;
+    m_fullQPSystem = nullptr;
+    m_qpCParams->constraintsId.swap(m_equalityElimination.getReducedConstraintsId());
+    if(!solved)
+        return;
+
+    m_equalityElimination.expand(*m_qpSystem, lambda, slack, lambda, slack);
+    objective += m_equalityElimination.getObjectiveOffset();
+    m_nbEqualityEliminations++;
+}
+
+
+void QPInverseProblemImpl::solveWithQPOASES(double& objective, const vector<double>& result,
+                                            real_t * Q, real_t * c, real_t * l, real_t * u,
+                                            real_t * A, real_t * bl, real_t * bu,
+                                            real_t * lambda, real_t * slack)
+{
+    int nbVariables = m_qpSystem->dim;
+    int nbConstraints = m_qpSystem->A.size()+m_qpSystem->Aeq.size();
+
+    int_t nWSR = m_nWSRLimit;
+    real_t cputime = 0.;
+
+    QProblemB boundedProblem;
+    QProblemB* solvedProblem = nullptr;
+
+    m_sparseMatrices.update(Q, A, nbVariables, nbConstraints);
+
+    if(m_contactFree.enabled && m_qpCLists->contactRowIds.empty() && solveWithContactFreeProblem(Q, c, l, u, A, bl, bu, nWSR))
+        solvedProblem = m_contactFree.problem;
+    else if(m_parametric.enabled && solveWithParametricProblem(Q, c, l, u, A, bl, bu, nWSR))
+        solvedProblem = m_parametric.problem;
+    else if(m_hotStart && solveWithHotStart(Q, c, l, u, A, bl, bu, nWSR))
+        solvedProblem = m_hotStartProblem;
+    else if(nbConstraints==0 && nbVariables>0 && solveBoundedProblem(boundedProblem, Q, c, l, u, nWSR))
+        solvedProblem = &boundedProblem;
+    else
+    {
+        QProblem& problem = resetQProblem(nWSR);
+        solvedProblem = &problem;
+        if(!initWithPivotWorkingSet(problem, Q, c, l, u, A, bl, bu, nWSR))
+        {
+            resetQProblem(nWSR);
+            initQProblem(problem, Q, c, l, u, A, bl, bu, nWSR, getCPUTimeLimit(cputime));
+        }
+
+        // The infeasibility detected by qpOASES during the initialization is solved at once with penalized
+        // constraint violations, the cascade of resolutions is the fallback
+        if(problem.isInfeasible() && m_fullQPSystem)
+        {
+            m_reducedQPInfeasible = true;
+            return;
+        }
+
+        if(problem.isInfeasible() && m_softRecovery && nbConstraints>0)
+        {
+            if(solveWithSoftConstraints(objective, Q, c, l, u, A, bl, bu, lambda, slack))
+            {
+                setRecovery(QPRecovery::SoftConstraints);
+                m_pivotWorkingSet.clear();
+                return;
+            }
+        }
+
+        if(problem.isInfeasible())
+        {
+            if(m_qpCLists->contacts.size()>0)
+            {
+                warningMessage(s_actuatorRecoveryMessage) << "QP infeasible at time = " << m_time << " with " << m_qpCParams->contactStates.size() << " contacts, check constraint on actuators." ;
+                setRecovery(QPRecovery::ActuatorConstraints);
+                m_constraintHandler->checkAndUpdateActuatorConstraints(result, m_qpSystem, m_qpCLists);
+                updateOASESMatrices(Q, c, l, u, A, bl, bu);
+
+                resetQProblem(nWSR);
+                problem.init(Q, c, A, l, u, bl, bu, nWSR, getCPUTimeLimit(cputime));
+                addQPOASESStatistics(problem, QPOASESCounters(), nWSR);
+            }
+
+            if(problem.isInfeasible() || !problem.isSolved())
+            {
+                warningMessage(s_indefiniteRecoveryMessage) << "QP infeasible at time = " << m_time << ", try with option HST_INDEF." ;
+                setRecovery(QPRecovery::IndefiniteHessian);
+                m_constraintHandler->buildInequalityConstraintMatrices(result, m_qpSystem, m_qpCLists);
+                m_constraintHandler->getConstraintOnLambda(result, m_qpSystem, m_qpCLists);
+                presolveConstraints(); // same rows as the workspace was sized for
+                updateOASESMatrices(Q, c, l, u, A, bl, bu);
+
+                resetQProblem(nWSR);
+                problem.setHessianType(qpOASES::HST_INDEF);
+                problem.init(Q, c, A, l, u, bl, bu, nWSR, getCPUTimeLimit(cputime));
+                addQPOASESStatistics(problem, QPOASESCounters(), nWSR);
+                m_qpOASESStatistics.nbIndefiniteFallbacks++;
+
+                if(problem.isInfeasible())
+                {
+                    errorMessage(s_failedRecoveryMessage) << "QP infeasible at time = " << m_time << ", iteration = " << m_iteration << ", and final nWSR = " << nWSR;
+                    setRecovery(QPRecovery::Failed);
+                }
+            }
+        }
+
+        // Stopped by the time budget, or by the limit of working set changes on a pathological QP
+        bool stoppedByTimeBudget = isStoppedByTimeBudget(problem, nWSR);
+        bool stoppedByLimit = !stoppedByTimeBudget && isStoppedByWorkingSetLimit(problem, nWSR);
+        if(stoppedByTimeBudget || stoppedByLimit)
+        {
+            m_nbQPIterations = nWSR;
+            addWorkingSetChanges(nWSR);
+            m_deadlineHit |= stoppedByTimeBudget;
+            if(stoppedByLimit)
+            {
+                m_workingSetLimitHit = true;
+                m_nbWorkingSetLimitHits++;
+            }
+
+            real_t* iterate = m_workspace.iterate.data();
+            bool hasIterate = (problem.getPrimalSolution(iterate) == qpOASES::SUCCESSFUL_RETURN);
+            useBestIterate(result, hasIterate? iterate : nullptr, Q, c, l, u, lambda, slack, objective);
+            m_pivotWorkingSet.clear();
+            return;
+        }
+    }
+
+    solvedProblem->getPrimalSolution(lambda);
+    objective = solvedProblem->getObjVal();
+    m_nbQPIterations = nWSR;
+    addWorkingSetChanges(nWSR);
+    storePivotWorkingSet(solvedProblem);
+
+    solvedProblem->getDualSolution(slack);
+}
+
+
+bool QPInverseProblemImpl::solveWithSoftConstraints(double& objective,
+                                                    real_t * Q, real_t * c, real_t * l, real_t * u,
+                                                    real_t * A, real_t * bl, real_t * bu,
+                                                    real_t * lambda, real_t * slack)
+{
+    // Variables [x; s] with s >= 0 the violation of each constraint row, penalized by rho (s^2/2 + s):
+    //   min 1/2 x^T Q x + c^T x + rho (s^T s/2 + sum(s))
+    //   s.t. bl <= A x + s and A x - s <= bu
+    // The problem is always feasible, and the linear penalty is exact once rho exceeds the multipliers
+    const int nbVariables = m_qpSystem->dim;
+    const int nbConstraints = m_qpSystem->A.size()+m_qpSystem->Aeq.size();
+    const int nbSoftVariables = nbVariables + nbConstraints;
+    const int nbSoftConstraints = 2*nbConstraints;
+
+    double maxDiagonal = 1.;
+    for(int i=0; i<nbVariables; i++)
+        maxDiagonal = std::max(maxDiagonal, rabs(Q[i*nbVariables+i]));
+    const double rho = s_softConstraintPenalty*maxDiagonal;
+
+    vector<real_t> softQ(nbSoftVariables*nbSoftVariables, 0.);
+    vector<real_t> softC(nbSoftVariables, rho);
+    vector<real_t> softL(nbSoftVariables, 0.);
+    vector<real_t> softU(nbSoftVariables, 1e99);
+    for(int i=0; i<nbVariables; i++)
+    {
+        std::copy(Q + i*nbVariables, Q + (i+1)*nbVariables, softQ.begin() + i*nbSoftVariables);
+        softC[i] = c[i];
+        softL[i] = (l)? l[i] : -1e99;
+        softU[i] = (u)? u[i] : 1e99;
+    }
+    for(int i=nbVariables; i<nbSoftVariables; i++)
+        softQ[i*nbSoftVariables+i] = rho;
+
+    vector<real_t> softA(nbSoftConstraints*nbSoftVariables, 0.);
+    vector<real_t> softBl(nbSoftConstraints, -1e99);
+    vector<real_t> softBu(nbSoftConstraints, 1e99);
+    for(int i=0; i<nbConstraints; i++)
+    {
+        real_t* lowerRow = softA.data() + i*nbSoftVariables;
+        real_t* upperRow = softA.data() + (nbConstraints+i)*nbSoftVariables;
+        std::copy(A + i*nbVariables, A + (i+1)*nbVariables, lowerRow);
+        std::copy(A + i*nbVariables, A + (i+1)*nbVariables, upperRow);
+        lowerRow[nbVariables+i] = 1.;
+        upperRow[nbVariables+i] = -1.;
+        softBl[i] = bl[i];
+        softBu[nbConstraints+i] = bu[i];
+    }
+
+    QProblem problem(nbSoftVariables, nbSoftConstraints, (m_hessianType == qpOASES::HST_POSDEF)? qpOASES::HST_POSDEF : qpOASES::HST_UNKNOWN);
+    Options options;
+    problem.setOptions(options);
+    problem.setPrintLevel(qpOASES::PL_NONE);
+
+    int_t nWSR = m_nWSRLimit;
+    real_t cputime = 0.;
+    returnValue status = problem.init(softQ.data(), softC.data(), softA.data(), softL.data(), softU.data(),
+                                      softBl.data(), softBu.data(), nWSR, getCPUTimeLimit(cputime));
+    addQPOASESStatistics(problem, QPOASESCounters(), nWSR);
+    m_nbQPIterations = nWSR;
+    if(status != qpOASES::SUCCESSFUL_RETURN || !problem.isSolved())
+        return false;
+
+    vector<real_t> x(nbSoftVariables);
+    vector<real_t> y(nbSoftVariables + nbSoftConstraints);
+    problem.getPrimalSolution(x.data());
+    problem.getDualSolution(y.data());
+
+    // Objective of the original problem, without the penalty
+    objective = 0.;
+    for(int i=0; i<nbVariables; i++)
+    {
+        lambda[i] = x[i];
+        slack[i] = y[i];
+        double Qx = 0.;
+        for(int j=0; j<nbVariables; j++)
+            Qx += Q[i*nbVariables+j]*x[j];
+        objective += 0.5*x[i]*Qx + c[i]*x[i];
+    }
+
+    double maxViolation = 0.;
+    for(int i=0; i<nbConstraints; i++)
+    {
+        slack[nbVariables+i] = y[nbSoftVariables+i] + y[nbSoftVariables+nbConstraints+i];
+        maxViolation = std::max(maxViolation, x[nbVariables+i]);
+    }
+
+    warningMessage(s_softRecoveryMessage) << "QP infeasible at time = " << m_time << ", solved with penalized constraint violations (maximum violation " << maxViolation << ")." ;
+    return true;
+}
+
+
+void QPInverseProblemImpl::setMaxNbWorkingSetChanges(const int& maxNbWorkingSetChanges)
+{
+    m_workingSetLimit.setMaxLimit(maxNbWorkingSetChanges);
+    m_lcpSolver->setMaxNbWorkingSetChanges(maxNbWorkingSetChanges);
+}
+
+
+void QPInverseProblemImpl::setAdaptiveLimits(const bool& adaptive, const double& percentile, const double& margin)
+{
+    m_pivotLimit.setAdaptive(adaptive, percentile, margin);
+    m_workingSetLimit.setAdaptive(adaptive, percentile, margin);
+}
+
+
+void QPInverseProblemImpl::setInfeasibilityRecovery(const std::string& name)
+{
+    if(name == "Cascade")
+        m_softRecovery = false;
+    else if(name == "Soft")
+        m_softRecovery = true;
+    else
+    {
+        msg_error("QPInverseProblemImpl") << "Unknown infeasibility recovery " << name << ", use Cascade instead.";
+        m_softRecovery = false;
+    }
+}
+
+
+std::string QPInverseProblemImpl::getRecoveryName(const QPRecovery& recovery)
+{
+    switch(recovery)
+    {
+    case QPRecovery::None: return "None";
+    case QPRecovery::ActuatorConstraints: return "ActuatorConstraints";
+    case QPRecovery::IndefiniteHessian: return "IndefiniteHessian";
+    case QPRecovery::SoftConstraints: return "SoftConstraints";
+    case QPRecovery::Failed: return "Failed";
+    }
+    return "None";
+}
+
+
+void QPInverseProblemImpl::setRecovery(const QPRecovery& recovery)
+{
+    if(recovery > m_recovery)
+        m_recovery = recovery;
+    if(recovery == QPRecovery::IndefiniteHessian)
+        m_adaptiveEpsilon.addIndefiniteHessian();
+}
+
+
+bool QPInverseProblemImpl::initWithPivotWorkingSet(QProblem& problem,
+                                                   real_t * Q, real_t * c, real_t * l, real_t * u,
+                                                   real_t * A, real_t * bl, real_t * bu, int_t& nWSR)
+{
+    int nbVariables = m_qpSystem->dim;
+    int nbConstraints = m_qpSystem->A.size()+m_qpSystem->Aeq.size();
+
+    // A primal warm start may come without working set, qpOASES then guesses it from x
+    const bool hasWorkingSet = !m_pivotWorkingSet.bounds.empty();
+    if(!m_pivotWorkingSet.enabled || !m_pivotWorkingSet.valid
+            || (int)m_pivotWorkingSet.x.size() != nbVariables
+            || (hasWorkingSet && (int)m_pivotWorkingSet.bounds.size() != nbVariables)
+            || (int)m_qpCParams->constraintsId.size() != nbConstraints)
+        return false;
+
+    Bounds guessedBounds(nbVariables);
+    Constraints guessedConstraints(nbConstraints);
+    if(hasWorkingSet)
+    {
+        for(int i=0; i<nbVariables; i++)
+            guessedBounds.setupBound(i, m_pivotWorkingSet.bounds[i]);
+
+        // Rows that did not exist at the previous pivot are guessed inactive
+        vector<int>& rank = m_workspace.constraintRanks;
+        rank.clear();
+        for(int i=0; i<nbConstraints; i++)
+        {
+            int id = m_qpCParams->constraintsId[i];
+            if(id < 0)
+            {
+                guessedConstraints.setupConstraint(i, qpOASES::ST_INACTIVE);
+                continue;
+            }
+            if(id >= (int)rank.size())
+                rank.resize(id+1, 0);
+            guessedConstraints.setupConstraint(i, m_pivotWorkingSet.getConstraintStatus(id, rank[id]++));
+        }
+    }
+
+    // The guess is stored in the variables of the original QP, the scaling changes with the pivots
+    real_t* x = m_pivotWorkingSet.x.data();
+    if(m_scale)
+    {
+        x = m_workspace.iterate.data();
+        std::copy(m_pivotWorkingSet.x.begin(), m_pivotWorkingSet.x.end(), x);
+        m_scaling.scaleVariables(nbVariables, x);
+    }
+
+    real_t cputime = 0.;
+    returnValue status = initQProblem(problem, Q, c, l, u, A, bl, bu, nWSR, getCPUTimeLimit(cputime),
+                                      x, (hasWorkingSet)? &guessedBounds : nullptr,
+                                      (hasWorkingSet)? &guessedConstraints : nullptr);
+
+    // A failed or infeasible warm start is solved again from scratch
+    if(status != qpOASES::SUCCESSFUL_RETURN || !problem.isSolved() || problem.isInfeasible())
+        return false;
+
+    if(m_pivotWorkingSet.isPrimalWarmStart)
+        m_nbPrimalWarmStarts++;
+    else
+        m_nbPivotWarmStarts++;
+    return true;
+}
+
+
+returnValue QPInverseProblemImpl::initQProblem(QProblem& problem,
+                                               real_t * Q, real_t * c, real_t * l, real_t * u,
+                                               real_t * A, real_t * bl, real_t * bu, int_t& nWSR, real_t* cputime,
+                                               const real_t* x, const Bounds* guessedBounds,
+                                               const Constraints* guessedConstraints)
+{
+    const QPOASESCounters start = getQPOASESCounters(problem);
+    returnValue status = (m_sparseMatrices.isUsed())?
+                problem.init(m_sparseMatrices.getHessian(), c, m_sparseMatrices.getConstraintMatrix(), l, u, bl, bu,
+                             nWSR, cputime, x, nullptr, guessedBounds, guessedConstraints) :
+                problem.init(Q, c, A, l, u, bl, bu, nWSR, cputime, x, nullptr, guessedBounds, guessedConstraints);
+    addQPOASESStatistics(problem, start, nWSR);
+    return status;
+}
+
+
+QPInverseProblemImpl::QPOASESCounters QPInverseProblemImpl::getQPOASESCounters(const QProblemB& problem)
+{
+    QPOASESCounters counters;
+    problem.getStatistics(counters.nbFlips, counters.nbRampings, counters.nbFactorizations, counters.nbUpdates);
+    return counters;
+}
+
+
+void QPInverseProblemImpl::addQPOASESStatistics(const QProblemB& problem, const QPOASESCounters& start, const int_t& nWSR)
+{
+    const QPOASESCounters counters = getQPOASESCounters(problem);
+    QPOASESStatistics& statistics = m_qpOASESStatistics;
+    statistics.nbResolutions++;
+    statistics.nbWorkingSetChanges += std::max(nWSR, int_t(0));
+    statistics.nbBoundFlips += counters.nbFlips - start.nbFlips;
+    statistics.nbRampings += counters.nbRampings - start.nbRampings;
+    statistics.nbFactorizations += counters.nbFactorizations - start.nbFactorizations;
+    statistics.nbFactorizationUpdates += counters.nbUpdates - start.nbUpdates;
+    if(problem.usingRegularisation())
+        statistics.nbRegularizations++;
+}
+
+
+void QPInverseProblemImpl::storePivotWorkingSet(QProblemB* problem)
+{
+    if(!m_pivotWorkingSet.enabled)
+        return;
+
+    m_pivotWorkingSet.clear();
+
+    int nbVariables = m_qpSystem->dim;
+    int nbConstraints = m_qpSystem->A.size()+m_qpSystem->Aeq.size();
+    if(problem->getNV() != nbVariables || (int)m_qpCParams->constraintsId.size() != nbConstraints)
+        return;
+
+    auto sanitize = [](qpOASES::SubjectToStatus status){
+        return (status == qpOASES::ST_LOWER || status == qpOASES::ST_UPPER)? status : qpOASES::ST_INACTIVE;
+    };
+
+    m_pivotWorkingSet.x.resize(nbVariables);
+    problem->getPrimalSolution(m_pivotWorkingSet.x.data());
+    if(m_scale)
+        m_scaling.unscaleVariables(nbVariables, m_pivotWorkingSet.x.data());
+
+    Bounds bounds;
+    problem->getBounds(bounds);
+    m_pivotWorkingSet.bounds.resize(nbVariables);
+    for(int i=0; i<nbVariables; i++)
+        m_pivotWorkingSet.bounds[i] = sanitize(bounds.getStatus(i));
+
+    if(nbConstraints>0)
+    {
+        QProblem* qproblem = dynamic_cast<QProblem*>(problem);
+        if(!qproblem)
+            return;
+
+        Constraints constraints;
+        qproblem->getConstraints(constraints);
+
+        // Rows grouped by variable id (counting sort), the rows without variable are not matched
+        const vector<int>& ids = m_qpCParams->constraintsId;
+        int nbIds = 0;
+        for(int i=0; i<nbConstraints; i++)
+            nbIds = std::max(nbIds, ids[i]+1);
+
+        vector<unsigned int>& offsets = m_pivotWorkingSet.constraintOffsets;
+        offsets.assign(nbIds+1, 0);
+        for(int i=0; i<nbConstraints; i++)
+            if(ids[i] >= 0)
+                offsets[ids[i]+1]++;
+        for(int id=0; id<nbIds; id++)
+            offsets[id+1] += offsets[id];
+
+        vector<int>& rank = m_workspace.constraintRanks;
+        rank.assign(nbIds, 0);
+        m_pivotWorkingSet.constraints.resize(offsets[nbIds]);
+        for(int i=0; i<nbConstraints; i++)
+            if(ids[i] >= 0)
+                m_pivotWorkingSet.constraints[offsets[ids[i]] + rank[ids[i]]++] = sanitize(constraints.getStatus(i));
+    }
+
+    m_pivotWorkingSet.valid = true;
+}
+
+
+bool QPInverseProblemImpl::solveBoundedProblem(QProblemB& problem,
+                                               real_t * Q, real_t * c, real_t * l, real_t * u, int_t& nWSR)
+{
+    // Only a bounded QP problem (without additional inequalities or equalities)
+    // From qpOASES manual: This special form can be exploited within the solution algorithm for speeding up
+    // the computation, typically by a factor of three to five.
+    int nbVariables = m_qpSystem->dim;
+
+    problem = QProblemB(nbVariables, m_hessianType);
+    Options options;
+    problem.setOptions(options);
+    problem.setPrintLevel(qpOASES::PL_NONE);
+
+    nWSR = m_nWSRLimit;
+    real_t cputime = 0.;
+    returnValue status = (m_sparseMatrices.isUsed())? problem.init(m_sparseMatrices.getHessian(), c, l, u, nWSR, getCPUTimeLimit(cputime))
+                                                    : problem.init(Q, c, l, u, nWSR, getCPUTimeLimit(cputime));
+    addQPOASESStatistics(problem, QPOASESCounters(), nWSR);
+
+    // QProblemB does not handle singular Hessians, fall back to the general solver on any failure
+    bool success = (status == qpOASES::SUCCESSFUL_RETURN && problem.isSolved() && !problem.isInfeasible());
+
+    if(success)
+    {
+        real_t* x = m_workspace.lambda.data();
+        problem.getPrimalSolution(x);
+        for(int i=0; i<nbVariables && success; i++)
+            success = (x[i] >= l[i] - 1e-9*(1.+rabs(l[i])) && x[i] <= u[i] + 1e-9*(1.+rabs(u[i])));
+    }
+
+    if(!success)
+    {
+        nWSR = m_nWSRLimit;
+        return false;
+    }
+
+    m_nbBoundedResolutions++;
+    return true;
+}
+
+
+sofa::helper::system::thread::ctime_t QPInverseProblemImpl::startTimer() const
+{
+    return (m_computeTimings)? CTime::getTime() : 0;
+}
+
+
+void QPInverseProblemImpl::stopTimer(const sofa::helper::system::thread::ctime_t& start, double& time) const
+{
+    if(m_computeTimings)
+        time += 1000.*(double)(CTime::getTime() - start)/(double)CTime::getTicksPerSec();
+}
+
+
+void QPInverseProblemImpl::swapResolutionState(QPInverseProblemImpl& other)
+{
+    std::swap(m_constraintHandler, other.m_constraintHandler);
+    std::swap(m_qpCParams, other.m_qpCParams);
+    std::swap(m_workspace, other.m_workspace);
+    std::swap(m_scaling, other.m_scaling);
+    std::swap(m_equalityElimination, other.m_equalityElimination);
+
+    m_Wea.swap(other.m_Wea);
+    m_dFreeEffectors.swap(other.m_dFreeEffectors);
+    m_sketchedWea.swap(other.m_sketchedWea);
+    m_sketchedDFree.swap(other.m_sketchedDFree);
+    std::swap(m_variableColumnBlocks, other.m_variableColumnBlocks);
+    std::swap(m_inactiveEffectorRows, other.m_inactiveEffectorRows);
+    std::swap(m_activeEffectorSpans, other.m_activeEffectorSpans);
+    std::swap(m_nbDeadbandEffectors, other.m_nbDeadbandEffectors);
+    std::swap(m_permutedCompliance, other.m_permutedCompliance);
+    std::swap(m_QRowSums, other.m_QRowSums);
+    std::swap(m_hessianType, other.m_hessianType);
+    std::swap(m_hessianCache, other.m_hessianCache);
+
+    std::swap(m_hotStartProblem, other.m_hotStartProblem);
+    std::swap(m_hotStartNbVariables, other.m_hotStartNbVariables);
+    std::swap(m_hotStartNbConstraints, other.m_hotStartNbConstraints);
+    std::swap(m_hotStartHessianType, other.m_hotStartHessianType);
+    std::swap(m_coldProblem, other.m_coldProblem);
+    std::swap(m_coldNbVariables, other.m_coldNbVariables);
+    std::swap(m_coldNbConstraints, other.m_coldNbConstraints);
+    std::swap(m_nbHotStartHits, other.m_nbHotStartHits);
+    std::swap(m_nbHotStartMisses, other.m_nbHotStartMisses);
+    std::swap(m_nbBoundedResolutions, other.m_nbBoundedResolutions);
+    std::swap(m_nbSmallProblemSolves, other.m_nbSmallProblemSolves);
+    std::swap(m_nbInteriorSolves, other.m_nbInteriorSolves);
+    std::swap(m_qpOASESStatistics, other.m_qpOASESStatistics);
+    std::swap(m_matrixFreeSolver, other.m_matrixFreeSolver);
+    std::swap(m_contactFree, other.m_contactFree);
+    std::swap(m_parametric, other.m_parametric);
+
+    std::swap(m_pivotLimit, other.m_pivotLimit);
+    std::swap(m_workingSetLimit, other.m_workingSetLimit);
+    std::swap(m_adaptiveEpsilon, other.m_adaptiveEpsilon);
+    std::swap(m_nbWorkingSetLimitHits, other.m_nbWorkingSetLimitHits);
+    std::swap(m_pivotWorkingSet, other.m_pivotWorkingSet);
+    std::swap(m_nbPivotWarmStarts, other.m_nbPivotWarmStarts);
+    std::swap(m_previousStepWorkingSet, other.m_previousStepWorkingSet);
+    std::swap(m_nbPrimalWarmStarts, other.m_nbPrimalWarmStarts);
+    std::swap(m_activeSetCache, other.m_activeSetCache);
+    std::swap(m_activeSetKey, other.m_activeSetKey);
+    std::swap(m_activeBounds, other.m_activeBounds);
+    std::swap(m_nbWarmStartedContacts, other.m_nbWarmStartedContacts);
+    std::swap(m_contactTracker, other.m_contactTracker);
+    std::swap(m_previousContactForceIds, other.m_previousContactForceIds);
+    std::swap(m_previousContactForces, other.m_previousContactForces);
+    std::swap(m_restoredState, other.m_restoredState);
+
+    std::swap(m_qpBackend, other.m_qpBackend);
+    std::swap(m_admmBackend, other.m_admmBackend);
+    std::swap(m_backendSelector, other.m_backendSelector);
+    std::swap(m_nbBackendSelections, other.m_nbBackendSelections);
+    std::swap(m_nlcpSolver, other.m_nlcpSolver);
+    std::swap(m_lcpSolver, other.m_lcpSolver);
+    std::swap(m_pgsSolver, other.m_pgsSolver);
+
+    std::swap(m_nbDeadlineHits, other.m_nbDeadlineHits);
+    std::swap(m_costAttribution, other.m_costAttribution);
+}
+
+
+void QPInverseProblemImpl::resetResolutionState()
+{
+    m_step = 0;
+    m_qpSystem->lambda.clear();
+    m_qpSystem->previousResult.clear();
+    m_currentSequence.clear();
+    m_previousSequence.clear();
+    m_sequence.clear();
+    m_permutedCompliance.invalidate();
+    m_isPermutedComplianceKept = false;
+    m_hessianCache.clear();
+
+    deleteHotStartProblem();
+    m_nbHotStartHits = 0;
+    m_nbHotStartMisses = 0;
+    m_nbBoundedResolutions = 0;
+    m_nbSmallProblemSolves = 0;
+    m_nbInteriorSolves = 0;
+    m_qpOASESStatistics = QPOASESStatistics();
+    std::fill(m_nbBackendSelections, m_nbBackendSelections + QPBackendSelector::NbBackends, 0u);
+    m_backendSelector.clear();
+    m_matrixFreeSolver.clear();
+    m_contactFree.clear();
+    m_contactFree.nbHotStarts = 0;
+    m_contactFree.nbFactorizationReuses = 0;
+    m_parametric.clear();
+    m_parametric.nbHotStarts = 0;
+    m_parametric.nbFactorizations = 0;
+
+    m_pivotLimit.clear();
+    m_workingSetLimit.clear();
+    m_adaptiveEpsilon.clear();
+    m_nbWorkingSetLimitHits = 0;
+    m_pivotWorkingSet.clear();
+    m_nbPivotWarmStarts = 0;
+    m_previousStepWorkingSet.clear();
+    m_nbPrimalWarmStarts = 0;
+    m_workspace.contactStates.clear();
+    m_nbWarmStartedContacts = 0;
+    m_contactTracker.clear();
+    m_previousContactForceIds.clear();
+    m_previousContactForces.clear();
+    m_activeSetCache.clear();
+    m_activeSetKey.clear();
+    m_activeBounds.clear();
+    m_restoredState.clear();
+
+    m_nbForwardSolves = 0;
+    m_nbDeadlineHits = 0;
+    m_costAttribution.clear();
+}
+
+
+void QPInverseProblemImpl::getMemoryUsage(QPMemoryUsage& usage) const
+{
+    QPInverseProblem::getMemoryUsage(usage);
+
+    size_t solvers = sizeof(real_t)*(m_workspace.lambda.capacity() + m_workspace.A.capacity() + m_workspace.bu.capacity()
+                                     + m_workspace.bl.capacity() + m_workspace.slack.capacity() + m_workspace.iterate.capacity())
+                     + sizeof(double)*(m_workspace.result.capacity() + m_workspace.dual.capacity() + m_workspace.previousLambda.capacity())
+                     + sizeof(unsigned int)*m_workspace.variableIds.capacity()
+                     + sizeof(QPWorkspace::ContactState)*m_workspace.contactStates.capacity();
+    solvers += sizeof(double)*(m_Wea.size() + m_dFreeEffectors.size() + m_sketchedWea.size() + m_sketchedDFree.size() + m_QRowSums.capacity() + m_contactDeltas.capacity()) + m_permutedCompliance.getMemoryUsage();
+    solvers += sizeof(double)*(m_Waa.size() + m_dFreeActuators.size());
+    solvers += sizeof(double)*(m_interiorFactorization.rows()*(m_interiorFactorization.cols() + 1)
+                               + m_interiorSolution.size() + m_interiorProducts.size());
+    solvers += m_sparseMatrices.getMemoryUsage();
+    if(m_scale)
+        solvers += m_scaling.getMemoryUsage();
+    if(m_eliminateEqualities)
+        solvers += m_equalityElimination.getMemoryUsage();
+    solvers += m_activeSetCache.getMemoryUsage();
+    solvers += m_contactTracker.getMemoryUsage() + sizeof(double)*m_previousContactForces.capacity();
+    solvers += m_constraintResiduals.getMemoryUsage();
+    solvers += m_currentSequence.getMemoryUsage() + m_sequence.getMemoryUsage() + m_previousSequence.getMemoryUsage();
+    if(m_hessianBackend)
+        solvers += m_hessianBackend->getMemoryUsage();
+    solvers += sizeof(double)*(m_hessianCache.Wea.size() + m_hessianCache.WEnergy.size()
+                               + m_hessianCache.epsilons.capacity() + m_hessianCache.Q.capacity());
+    solvers += sizeof(real_t)*(m_contactFree.Q.capacity() + m_contactFree.A.capacity() + m_pivotWorkingSet.x.capacity());
+    solvers += sizeof(double)*(m_contactQ.size() + m_contactForces.size() + m_contactM.rowSize()*m_contactM.colSize());
+    solvers += m_lcpSolver->getMemoryUsage() + m_nlcpSolver->getMemoryUsage();
+
+    if(m_hotStartProblem)
+        solvers += QPOASESSolverBackend::getProblemMemoryUsage(m_hotStartNbVariables, m_hotStartNbConstraints);
+    if(m_coldProblem)
+        solvers += QPOASESSolverBackend::getProblemMemoryUsage(m_coldNbVariables, m_coldNbConstraints);
+    if(m_contactFree.problem)
+        solvers += QPOASESSolverBackend::getProblemMemoryUsage(m_contactFree.nbVariables, m_contactFree.nbConstraints);
+    if(m_parametric.problem)
+        solvers += QPOASESSolverBackend::getProblemMemoryUsage(m_parametric.nbVariables, m_parametric.nbConstraints)
+                + sizeof(real_t)*(m_parametric.Q.capacity() + m_parametric.A.capacity());
+
+    usage.solvers = solvers;
+}
+
+
+double QPInverseProblemImpl::getRemainingTime(const double& budgetRatio) const
+{
+    double elapsed = (double)(CTime::getTime() - m_solveStartTime)/(double)CTime::getTicksPerSec();
+    return budgetRatio*m_timeBudget - elapsed;
+}
+
+
+bool QPInverseProblemImpl::isDeadlineReached() const
+{
+    return (m_timeBudget>0. && getRemainingTime()<=0.);
+}
+
+
+real_t* QPInverseProblemImpl::getCPUTimeLimit(real_t& cputime) const
+{
+    if(m_timeBudget<=0.)
+        return nullptr;
+
+    // qpOASES always performs a first iteration, even if the limit is already exhausted
+    cputime = std::max(getRemainingTime(), 1e-6);
+    return &cputime;
+}
+
+
+bool QPInverseProblemImpl::isStoppedByTimeBudget(const QProblemB& problem, const int_t& nWSR) const
+{
+    // qpOASES stops before the maximum number of working set changes when the cputime is exhausted
+    return (m_timeBudget>0. && !problem.isSolved() && !problem.isInfeasible() && nWSR<m_nWSRLimit);
+}
+
+
+bool QPInverseProblemImpl::isStoppedByWorkingSetLimit(const QProblemB& problem, const int_t& nWSR) const
+{
+    return (!problem.isSolved() && !problem.isInfeasible() && nWSR>=m_nWSRLimit);
+}
+
+
+void QPInverseProblemImpl::addWorkingSetChanges(const int_t& nWSR)
+{
+    m_workingSetLimit.add(nWSR);
+    m_maxNbWorkingSetChanges = std::max(m_maxNbWorkingSetChanges, (int)nWSR);
+}
+
+
+void QPInverseProblemImpl::useBestIterate(const vector<double>& result, const real_t* iterate,
+                                          real_t * Q, real_t * c, real_t * l, real_t * u,
+                                          real_t * lambda, real_t * slack, double& objective)
+{
+    int nbVariables = m_qpSystem->dim;
+    int nbConstraints = m_qpSystem->A.size()+m_qpSystem->Aeq.size();
+
+    // Candidates, by order of preference: the last iterate of the QP solver, the result of the previous
+    // pivot and the solution of the previous step. If none is feasible, the last one is projected on the bounds.
+    // With the scaling, the candidates are compared in the variables of the original QP
+    if(m_scale)
+    {
+        Q = m_qpSystem->Q.data();
+        c = m_qpSystem->c.data();
+        l = m_qpSystem->l.data();
+        u = m_qpSystem->u.data();
+    }
+
+    vector<const double*> candidates;
+    if(iterate) candidates.push_back(iterate);
+    if((int)result.size() == nbVariables) candidates.push_back(result.data());
+    if((int)m_qpSystem->lambda.size() == nbVariables) candidates.push_back(m_qpSystem->lambda.data());
+
+    vector<double> x(nbVariables, 0.);
+    bool feasible = false;
+    for(const double* candidate : candidates)
+    {
+        x.assign(candidate, candidate+nbVariables);
+        if(m_scale && candidate == iterate)
+            m_scaling.unscaleVariables(nbVariables, x.data());
+        feasible = isFeasible(x);
+        for(int i=0; i<nbVariables && feasible; i++)
+            feasible = (x[i] >= l[i] - 1e-5 && x[i] <= u[i] + 1e-5);
+        if(feasible)
+            break;
+    }
+
+    if(!feasible)
+    {
+        for(int i=0; i<nbVariables; i++)
+            x[i] = std::min(std::max(x[i], l[i]), u[i]);
+        warningMessage(s_iterateMessage) << "QP stopped at time = " << m_time << " without a feasible iterate." ;
+    }
+
+    Eigen::Map<const RowMajorMatrixXd> H(Q, nbVariables, nbVariables);
+    Eigen::Map<const VectorXd> g(c, nbVariables);
+    Eigen::Map<VectorXd> xOpt(lambda, nbVariables);
+    xOpt = Eigen::Map<const VectorXd>(x.data(), nbVariables);
+    objective = 0.5*xOpt.dot(H*xOpt) + g.dot(xOpt);
+    if(m_scale)
+        m_scaling.scaleVariables(nbVariables, lambda); // unscaled with the solution of the QP
+
+    // The multipliers are unknown, the contact pivot loop stops on a deadline or a working set limit
+    std::fill(slack, slack+nbVariables+nbConstraints, 0.);
+}
+
+
+qpOASES::SubjectToStatus QPInverseProblemImpl::QPPivotWorkingSet::getConstraintStatus(const int& id, const int& rank) const
+{
+    if(id < 0 || id+1 >= (int)constraintOffsets.size())
+        return qpOASES::ST_INACTIVE;
+
+    const unsigned int k = constraintOffsets[id] + rank;
+    return (k < constraintOffsets[id+1])? constraints[k] : qpOASES::ST_INACTIVE;
+}
+
+
+void QPInverseProblemImpl::QPPivotWorkingSet::appendConstraintStatus(const int& id, const qpOASES::SubjectToStatus& status)
+{
+    if(id < 0)
+        return;
+
+    if(constraintOffsets.empty())
+        constraintOffsets.push_back(0);
+    while((int)constraintOffsets.size() < id+2)
+        constraintOffsets.push_back(constraints.size());
+    constraints.push_back(status);
+    constraintOffsets.back() = constraints.size();
+}
+
+
+void QPInverseProblemImpl::QPWorkspace::reserve(const int nbVariables, const int nbConstraints)
+{
+    if(nbVariables <= maxNbVariables && nbConstraints <= maxNbConstraints)
+        return;
+
+    maxNbVariables = std::max(nbVariables, maxNbVariables);
+    maxNbConstraints = std::max(nbConstraints, maxNbConstraints);
+
+    lambda.resize(maxNbVariables);
+    A.resize(maxNbConstraints*maxNbVariables);
+    bu.resize(maxNbConstraints);
+    bl.resize(maxNbConstraints);
+    slack.resize(maxNbVariables+maxNbConstraints);
+    iterate.resize(maxNbVariables);
+
+    nbAllocations++;
+}
+
+
+bool QPInverseProblemImpl::solveWithHotStart(real_t * Q, real_t * c, real_t * l, real_t * u,
+                                             real_t * A, real_t * bl, real_t * bu, int_t& nWSR)
+{
+    int nbVariables = m_qpSystem->dim;
+    int nbConstraints = m_qpSystem->A.size()+m_qpSystem->Aeq.size();
+
+    // Hot start from the active set of the previous resolution, only possible if the layout did not change
+    if(m_hotStartProblem && nbVariables == m_hotStartNbVariables && nbConstraints == m_hotStartNbConstraints
+            && m_hessianType == m_hotStartHessianType)
+    {
+        nWSR = m_nWSRLimit;
+        real_t cputime = 0.;
+        const QPOASESCounters start = getQPOASESCounters(*m_hotStartProblem);
+        returnValue status = (m_sparseMatrices.isUsed())?
+                    m_hotStartProblem->hotstart(m_sparseMatrices.getHessian(), c, m_sparseMatrices.getConstraintMatrix(),
+                                                l, u, bl, bu, nWSR, getCPUTimeLimit(cputime)) :
+                    m_hotStartProblem->hotstart(Q, c, A, l, u, bl, bu, nWSR, getCPUTimeLimit(cputime));
+        addQPOASESStatistics(*m_hotStartProblem, start, nWSR);
+        if(status == qpOASES::SUCCESSFUL_RETURN && m_hotStartProblem->isSolved() && !m_hotStartProblem->isInfeasible())
+        {
+            m_nbHotStartHits++;
+            return true;
+        }
+    }
+
+    m_nbHotStartMisses++;
+
+    // The layout changed (or the hot start failed), start again from a fresh problem
+    deleteHotStartProblem();
+    m_hotStartProblem = new SQProblem(nbVariables, nbConstraints, m_hessianType);
+    m_hotStartNbVariables = nbVariables;
+    m_hotStartNbConstraints = nbConstraints;
+    m_hotStartHessianType = m_hessianType;
+
+    Options options;
+    m_hotStartProblem->setOptions(options);
+    m_hotStartProblem->setPrintLevel(qpOASES::PL_NONE);
+
+    nWSR = m_nWSRLimit;
+    real_t cputime = 0.;
+    returnValue status = initQProblem(*m_hotStartProblem, Q, c, l, u, A, bl, bu, nWSR, getCPUTimeLimit(cputime));
+    if(status == qpOASES::SUCCESSFUL_RETURN && m_hotStartProblem->isSolved() && !m_hotStartProblem->isInfeasible())
+        return true;
+
+    // Let the usual resolution (and its fallbacks in case of infeasibility) handle this step
+    deleteHotStartProblem();
+    return false;
+}
+
+
+void QPInverseProblemImpl::deleteHotStartProblem()
+{
+    delete m_hotStartProblem;
+    m_hotStartProblem = nullptr;
+    m_hotStartNbVariables = 0;
+    m_hotStartNbConstraints = 0;
+}
+
+
+void QPInverseProblemImpl::QPContactFreeProblem::clear()
+{
+    delete problem;
+    problem = nullptr;
+    nbVariables = 0;
+    nbConstraints = 0;
+    actuatorRowIds.clear();
+    equalityRowIds.clear();
+    Q.clear();
+    A.clear();
+}
+
+
+void QPInverseProblemImpl::QPParametricProblem::clear()
+{
+    delete problem;
+    problem = nullptr;
+    nbVariables = 0;
+    nbConstraints = 0;
+    constraintsId.clear();
+    Q.clear();
+    A.clear();
+    QNorm = 0.;
+    ANorm = 0.;
+}
+
+
+void QPInverseProblemImpl::QPDuals::clear()
+{
+    bounds.clear();
+    constraints.clear();
+    constraintsId.clear();
+    actuatorBounds.clear();
+    actuatorLimits.clear();
+}
+
 
-    for(int i=0; i<nbEffectorRows; i++)
-        objective += m_qpSystem->dFree[m_qpCLists->effectorRowIds[i]]*m_qpSystem->dFree[m_qpCLists->effectorRowIds[i]];
+void QPInverseProblemImpl::updateActuatorLimits()
+{
+    const QPActuatorBounds& actuatorBounds = m_qpCLists->actuatorBounds;
+    unsigned int nbActuatorRows = m_qpCLists->actuatorRowIds.size();
+    if(actuatorBounds.lambdaMin.size() < nbActuatorRows || m_qpSystem->lambda.size() < nbActuatorRows)
+        return;
+
+    // A bound is active when the solution reaches it, up to a tolerance relative to the bound.
+    // The infinite bounds (1e99) of the missing limits are never reached
+    auto isReached = [](const double& value, const double& bound)
+    {
+        return std::abs(bound)<1e98 && std::abs(value-bound) <= 1e-8*std::max(1., std::abs(bound));
+    };
 
-    storeResults(m_qpSystem->lambda);
+    m_duals.actuatorBounds.assign(nbActuatorRows, 0.);
+    m_duals.actuatorLimits.assign(nbActuatorRows, 0);
+    for(unsigned int k=0; k<nbActuatorRows; k++)
+    {
+        if(k < m_duals.bounds.size())
+            m_duals.actuatorBounds[k] = m_duals.bounds[k];
+
+        const double& lambda = m_qpSystem->lambda[k];
+        const double& delta = m_qpSystem->delta[m_qpCLists->actuatorRowIds[k]];
+        int& limits = m_duals.actuatorLimits[k];
+        if(isReached(lambda, actuatorBounds.lambdaMin[k])) limits |= LambdaMin;
+        if(isReached(lambda, actuatorBounds.lambdaMax[k])) limits |= LambdaMax;
+        if(isReached(delta, actuatorBounds.deltaMin[k]))   limits |= DeltaMin;
+        if(isReached(delta, actuatorBounds.deltaMax[k]))   limits |= DeltaMax;
+    }
 }
 
 
-void QPInverseProblemImpl::solveWithContact(vector<double>& result, double& objective, int& iteration)
+void QPInverseProblemImpl::QPSensitivities::clear()
 {
-    int nbActuatorRows  = m_qpCLists->actuatorRowIds.size();
-
-    m_constraintHandler->initContactHandlerList();
-    m_constraintHandler->initContactHandlers();
+    dual.clear();
+    constraintsId.clear();
+    rows.clear();
+    dfree.resize(0, 0);
+    targets.resize(0, 0);
+}
 
-    AdvancedTimer::stepBegin("LCP resolution");
-    solveContacts(result);
-    AdvancedTimer::stepEnd("LCP resolution");
-    updateLambda(result);
-    m_qpSystem->previousResult = result;
 
-    if(nbActuatorRows>0)
+void QPInverseProblemImpl::updateSensitivities()
+{
+    // The friction contact solver, the prioritized and the horizon problems do not end with the QP of the system
+    const bool isPending = m_sensitivities.isPending && !m_hasSolvedNLCP;
+    m_sensitivities.isPending = false;
+    if(!isPending || m_sensitivities.dual.size() != m_qpSystem->dim + m_qpSystem->A.size() + m_qpSystem->Aeq.size()
+            || !m_sensitivity.compute(*m_qpSystem, m_sensitivities.dual.data()))
     {
-        m_constraintHandler->initContactHandlers(result, m_qpCLists);
-
-        iteration = 0;
-        objective = 0.;
+        m_sensitivity.clear();
+        m_sensitivities.clear();
+        return;
+    }
 
-        buildQPMatrices();
+    const unsigned int dim = m_qpSystem->dim;
+    const unsigned int nbEffectors = m_qpCLists->effectorRowIds.size();
+    const vector<unsigned int>& acIds = updateVariableIds();
+    m_sensitivities.rows.assign(acIds.begin(), acIds.end());
 
-        // TODO check for null rows and remove them from the OASES system
+    // c = Wea^T S dfree_e, the rows of the disabled effectors (and in their deadband) have no weight
+    RowMajorMatrixXd& SWea = m_sensitivities.effectorRows;
+    SWea.setZero(nbEffectors, dim);
+    for(unsigned int i=0; i<nbEffectors; i++)
+    {
+        if(i<m_inactiveEffectorRows.size() && m_inactiveEffectorRows[i])
+            continue;
+        const double* Wi = m_qpSystem->W[m_qpCLists->effectorRowIds[i]];
+        for(unsigned int j=0; j<dim; j++)
+            SWea(i, j) = Wi[acIds[j]];
+    }
+    const vector<double>& weights = m_qpCLists->effectorWeights;
+    for(const QPEffectorWeightBlock& block : m_qpCLists->effectorWeightBlocks)
+    {
+        if(block.first + block.size > nbEffectors)
+            continue;
+        const Eigen::Map<const RowMajorMatrixXd> S(weights.data() + block.offset, block.size, block.size);
+        SWea.middleRows(block.first, block.size) = S * SWea.middleRows(block.first, block.size);
+    }
 
-        AdvancedTimer::stepBegin("QPs resolution");
-        bool stopFlag = false;
-        while(stopFlag == false && iteration<=m_maxNbPivot)
+    const RowMajorMatrixXd& dxdc = m_sensitivity.getLinearTermSensitivity();
+    const RowMajorMatrixXd& dxdb = m_sensitivity.getConstraintSensitivity();
+    RowMajorMatrixXd& dfree = m_sensitivities.dfree;
+    dfree.setZero(dim, getDimension());
+    for(unsigned int i=0; i<nbEffectors; i++)
+        dfree.col(m_qpCLists->effectorRowIds[i]) += dxdc * SWea.row(i).transpose();
+
+    // A row s*W(r, x) of [A; Aeq] bounds the displacement of the row r, its bounds are s*(limit - dfree(r)).
+    // The rows of a multi-line actuator or equality have the id of its first line.
+    const unsigned int nbFixedRows = m_qpCLists->actuatorRowIds.size() + m_qpCLists->equalityRowIds.size();
+    const vector<int>& constraintsId = m_sensitivities.constraintsId;
+    for(unsigned int k=0; k<constraintsId.size() && k<(unsigned int)dxdb.cols(); k++)
+    {
+        const int id = constraintsId[k];
+        if(id<0 || id>=(int)dim)
+            continue;
+        const unsigned int nbLines = ((unsigned int)id<nbFixedRows && (unsigned int)id<m_qpCLists->variableRows.size())?
+                    std::max(1u, m_qpCLists->variableRows[id].nbLines) : 1u;
+        for(unsigned int line=0; line<nbLines && id+line<dim; line++)
         {
-            m_iteration = iteration;
-
-            m_qpCParams->constraintsId.clear();
-            m_constraintHandler->buildInequalityConstraintMatrices(result, m_qpSystem, m_qpCLists);
-            m_constraintHandler->buildEqualityConstraintMatrices(result, m_qpSystem, m_qpCLists);
-            m_constraintHandler->getConstraintOnLambda(result, m_qpSystem, m_qpCLists);
+            const unsigned int row = acIds[id+line];
+            const int sign = getWRowSign(k, row);
+            if(sign == 0)
+                continue;
+            dfree.col(row) -= double(sign)*dxdb.col(k);
+            break;
+        }
+    }
 
-            vector<double> dual;
-            solveInverseProblem(objective, result, dual);
+    RowMajorMatrixXd& targets = m_sensitivities.targets;
+    targets.resize(dim, nbEffectors);
+    for(unsigned int i=0; i<nbEffectors; i++)
+        targets.col(i) = -dfree.col(m_qpCLists->effectorRowIds[i]);
+}
 
-            stopFlag = checkAndUpdatePivot(result, dual);
-            iteration++;
 
-            if(stopFlag == true || iteration == m_maxNbPivot)
-                updateLambda(result);
-        }
-        AdvancedTimer::stepEnd("QPs resolution");
+int QPInverseProblemImpl::getWRowSign(const unsigned int& constraintRow, const unsigned int& row) const
+{
+    const unsigned int ASize = m_qpSystem->A.size();
+    const double* Ak = (constraintRow < ASize)? m_qpSystem->A[constraintRow] : m_qpSystem->Aeq[constraintRow-ASize];
+    const double* Wr = m_qpSystem->W[row];
+    const vector<unsigned int>& acIds = m_workspace.variableIds;
 
-        m_qpCParams->contactStates.clear();
-        m_sequence.clear();
-        m_currentSequence.clear();
-        m_previousSequence.clear();
+    // The rows of the friction cone, of the lambda of an actuator or of the contact limits are not rows of W
+    double norm = 0.;
+    for(unsigned int j=0; j<m_qpSystem->dim; j++)
+        norm = std::max(norm, rabs(Wr[acIds[j]]));
+    if(norm == 0.)
+        return 0;
+    for(int sign : {1, -1})
+    {
+        bool isWRow = true;
+        for(unsigned int j=0; j<m_qpSystem->dim && isWRow; j++)
+            isWRow = rabs(Ak[j] - sign*Wr[acIds[j]]) <= 1e-12*norm;
+        if(isWRow)
+            return sign;
     }
+    return 0;
 }
 
 
-void QPInverseProblemImpl::solveContacts(vector<double>& res)
+void QPInverseProblemImpl::setParametricQP(const bool& parametric, const double& threshold)
 {
-    unsigned int nbActuatorRows   = m_qpCLists->actuatorRowIds.size();
-    unsigned int nbContactRows    = m_qpCLists->contactRowIds.size();
-
-    FullVector<double> q;
-    q.resize(nbContactRows);
-    LPtrFullMatrix<double> M;
-    M.resize(nbContactRows,nbContactRows);
+    m_parametric.threshold = threshold;
+    if(m_parametric.enabled == parametric)
+        return;
 
-    if (m_step == 0) {
-        init();
-        m_step++;
-    }
+    m_parametric.enabled = parametric;
+    m_parametric.clear();
+}
 
-    for(unsigned int i=0; i<nbContactRows; i++)
-    {
-        q[i]=m_qpSystem->dFree[m_qpCLists->contactRowIds[i]];
-        if(m_qpSystem->lambda.size()!=0)
-            for(unsigned int j=0; j<nbActuatorRows; j++)
-                q[i]+=m_qpSystem->W[m_qpCLists->contactRowIds[i]][m_qpCLists->actuatorRowIds[j]]*m_qpSystem->lambda[j];
 
-        for(unsigned int j=0; j<nbContactRows; j++)
-            M[i][j]=m_qpSystem->W[m_qpCLists->contactRowIds[i]][m_qpCLists->contactRowIds[j]];
-    }
+bool QPInverseProblemImpl::solveWithParametricProblem(real_t * Q, real_t * c, real_t * l, real_t * u,
+                                                      real_t * A, real_t * bl, real_t * bu, int_t& nWSR)
+{
+    const int nbVariables = m_qpSystem->dim;
+    const int nbConstraints = m_qpSystem->A.size()+m_qpSystem->Aeq.size();
 
-    FullVector<double> x;
-    res.clear();
-    res.resize(m_qpSystem->dim, 0.);
+    // Infinity norm of M - reference (of M without reference)
+    auto getNorm = [](const real_t* M, const real_t* reference, const int rows, const int cols){
+        double norm = 0.;
+        for(int i=0; i<rows; i++)
+        {
+            double rowAbsSum = 0.;
+            for(int j=0; j<cols; j++)
+                rowAbsSum += rabs(M[i*cols+j] - ((reference)? reference[i*cols+j] : 0.));
+            norm = std::max(norm, rowAbsSum);
+        }
+        return norm;
+    };
 
-    if(m_mu>0.)
+    QPParametricProblem& pp = m_parametric;
+    if(pp.problem && nbVariables == pp.nbVariables && nbConstraints == pp.nbConstraints && m_hessianType == pp.hessianType
+            && m_qpCParams->constraintsId == pp.constraintsId)
     {
-        x.resize(nbContactRows);
-
-        // Warm start
-        if(m_qpSystem->lambda.size()>=nbActuatorRows+nbContactRows)
+        const bool isQKept = getNorm(Q, pp.Q.data(), nbVariables, nbVariables) <= pp.threshold*pp.QNorm;
+        const bool isAKept = nbConstraints==0 || getNorm(A, pp.A.data(), nbConstraints, nbVariables) <= pp.threshold*pp.ANorm;
+        if(isQKept && isAKept)
         {
-            for(unsigned int i=0; i<nbContactRows; i++)
-                x[i] = m_qpSystem->lambda[nbActuatorRows+i];
+            nWSR = m_nWSRLimit;
+            real_t cputime = 0.;
+            const QPOASESCounters start = getQPOASESCounters(*pp.problem);
+            returnValue status = pp.problem->hotstart(c, l, u, bl, bu, nWSR, getCPUTimeLimit(cputime));
+            addQPOASESStatistics(*pp.problem, start, nWSR);
+            if(status == qpOASES::SUCCESSFUL_RETURN && pp.problem->isSolved() && !pp.problem->isInfeasible())
+            {
+                pp.nbHotStarts++;
+                return true;
+            }
         }
-
-        NLCPSolver* nlcpSolver = new NLCPSolver();
-        nlcpSolver->setAllowSliding(m_allowSliding);
-        nlcpSolver->solve(nbContactRows, q.ptr(), M.lptr(), x.ptr(), m_mu, m_tolerance, m_maxIteration, true);
-        delete nlcpSolver;
-
-        for (unsigned int i=0; i<nbContactRows; i++)
-            res[i+nbActuatorRows] = x[i];
     }
-    else
-    {
-        LCPQPSolver* lcpSolver = new LCPQPSolver();
-        x.clear();
-        x.resize(nbContactRows);
-        lcpSolver->solve(nbContactRows, q.ptr(), M.lptr(), x.ptr());
-        delete lcpSolver;
 
-        for (unsigned int i=0; i<nbContactRows; i++)
-            res[i+nbActuatorRows]=x[i];
-    }
+    // Q or A moved beyond the threshold (or the layout changed), factorize the current ones
+    pp.clear();
+    pp.problem = new SQProblem(nbVariables, nbConstraints, m_hessianType);
+    pp.nbVariables = nbVariables;
+    pp.nbConstraints = nbConstraints;
+    pp.hessianType = m_hessianType;
+    pp.constraintsId = m_qpCParams->constraintsId;
+    pp.Q.assign(Q, Q+nbVariables*nbVariables);
+    pp.A.assign(A, A+nbConstraints*nbVariables);
+    pp.QNorm = getNorm(Q, nullptr, nbVariables, nbVariables);
+    pp.ANorm = getNorm(A, nullptr, nbConstraints, nbVariables);
 
-    if(m_qpSystem->lambda.size()>=nbActuatorRows)
-        for (unsigned int i=0; i<nbActuatorRows; i++)
-            res[i] = m_qpSystem->lambda[i];
+    Options options;
+    pp.problem->setOptions(options);
+    pp.problem->setPrintLevel(qpOASES::PL_NONE);
+
+    nWSR = m_nWSRLimit;
+    real_t cputime = 0.;
+    returnValue status = pp.problem->init(pp.Q.data(), c, (nbConstraints>0)? pp.A.data() : nullptr, l, u, bl, bu, nWSR, getCPUTimeLimit(cputime));
+    addQPOASESStatistics(*pp.problem, QPOASESCounters(), nWSR);
+    pp.nbFactorizations++;
+    if(status == qpOASES::SUCCESSFUL_RETURN && pp.problem->isSolved() && !pp.problem->isInfeasible())
+        return true;
+
+    // Let the usual resolution (and its fallbacks in case of infeasibility) handle this step
+    pp.clear();
+    return false;
 }
 
 
-void QPInverseProblemImpl::solveInverseProblem(double& objective,
-                                               vector<double> &result,
-                                               vector<double> &dual)
+void QPInverseProblemImpl::setContactFreeHotStart(const bool& hotStart)
 {
-    m_qpSystem->previousResult = result;
-
-    int ASize = m_qpSystem->A.size();
-    int AeqSize = m_qpSystem->Aeq.size();
-    int nbVariables = m_qpSystem->dim;
-    int nbConstraints = ASize+AeqSize;
+    if(m_contactFree.enabled == hotStart)
+        return;
 
-    real_t* Q = new real_t[nbVariables*nbVariables];
-    real_t* c = new real_t[nbVariables];
-    real_t* lambda = new real_t[nbVariables];
-    real_t* l = new real_t[nbVariables];
-    real_t* u = new real_t[nbVariables];
-    real_t* A  = new real_t[nbConstraints*nbVariables];
-    real_t* bu = new real_t[nbConstraints];
-    real_t* bl = new real_t[nbConstraints];
-
-    updateOASESMatrices(Q, c, l, u, A, bl, bu);
+    m_contactFree.enabled = hotStart;
+    m_contactFree.clear();
+}
 
-    int_t nWSR = 500;
-    //    Eulalie.C (01/19): QProblemB of qpOASES for simply bounded problem does not work (constraints are not satisfied). We should either find why or remove this commented block of code
-    //    if(nbConstraints==0)
-    //    {
-    //        //only a bounded QP problem (without additional inequalities or equalities)
-    //        //From pqOASES manual: This special form can be exploited within the solution algorithm for speeding up
-    //        //the computation, typically by a factor of three to five.
-    //        QProblemB problem(nbVariables);
-    //        problem.setPrintLevel(qpOASES::PL_LOW);
-    //        problem.init(Q, c, l, u, nWSR);
-    //        problem.getPrimalSolution(lambda);
-    //    }
-    //    else
-    //    {
-    QProblem problem = getNewQProblem(nWSR);
 
-    problem.init(Q, c, A, l, u, bl, bu, nWSR);
+bool QPInverseProblemImpl::solveWithContactFreeProblem(real_t * Q, real_t * c, real_t * l, real_t * u,
+                                                       real_t * A, real_t * bl, real_t * bu, int_t& nWSR)
+{
+    int nbVariables = m_qpSystem->dim;
+    int nbConstraints = m_qpSystem->A.size()+m_qpSystem->Aeq.size();
+    const int QSize = nbVariables*nbVariables;
+    const int ASize = nbConstraints*nbVariables;
 
-    if(problem.isInfeasible())
+    QPContactFreeProblem& cf = m_contactFree;
+    if(cf.problem && nbVariables == cf.nbVariables && nbConstraints == cf.nbConstraints && m_hessianType == cf.hessianType
+            && m_qpCLists->actuatorRowIds == cf.actuatorRowIds && m_qpCLists->equalityRowIds == cf.equalityRowIds)
     {
-        if(m_qpCLists->contacts.size()>0)
+        const bool sameMatrices = std::equal(Q, Q+QSize, cf.Q.begin()) && (ASize==0 || std::equal(A, A+ASize, cf.A.begin()));
+        if(!sameMatrices)
         {
-            msg_warning("QPInverseProblemImpl") << "QP infeasible at time = " << m_time << " with " << m_qpCParams->contactStates.size() << " contacts, check constraint on actuators." ;
-            m_constraintHandler->checkAndUpdateActuatorConstraints(result, m_qpSystem, m_qpCLists);
-            updateOASESMatrices(Q, c, l, u, A, bl, bu);
-
-            problem = getNewQProblem(nWSR);
-            problem.init(Q, c, A, l, u, bl, bu, nWSR);
+            std::copy(Q, Q+QSize, cf.Q.begin());
+            if(ASize>0)
+                std::copy(A, A+ASize, cf.A.begin());
         }
 
-        if(problem.isInfeasible() || !problem.isSolved())
+        nWSR = m_nWSRLimit;
+        real_t cputime = 0.;
+        const QPOASESCounters start = getQPOASESCounters(*cf.problem);
+        returnValue status = (sameMatrices)? cf.problem->hotstart(c, l, u, bl, bu, nWSR, getCPUTimeLimit(cputime))
+                                           : cf.problem->hotstart(cf.Q.data(), c, cf.A.data(), l, u, bl, bu, nWSR, getCPUTimeLimit(cputime));
+        addQPOASESStatistics(*cf.problem, start, nWSR);
+        if(status == qpOASES::SUCCESSFUL_RETURN && cf.problem->isSolved() && !cf.problem->isInfeasible())
         {
-            msg_warning("QPInverseProblemImpl") << "QP infeasible at time = " << m_time << ", try with option HST_INDEF." ;
-            m_constraintHandler->buildInequalityConstraintMatrices(result, m_qpSystem, m_qpCLists);
-            m_constraintHandler->getConstraintOnLambda(result, m_qpSystem, m_qpCLists);
-            updateOASESMatrices(Q, c, l, u, A, bl, bu);
-
-            problem = getNewQProblem(nWSR);
-            problem.setHessianType(qpOASES::HST_INDEF);
-            problem.init(Q, c, A, l, u, bl, bu, nWSR);
-
-            if(problem.isInfeasible())
-                msg_error("QPInverseProblemImpl") << "QP infeasible at time = " << m_time << ", iteration = " << m_iteration << ", and final nWSR = " << nWSR;
+            cf.nbHotStarts++;
+            if(sameMatrices)
+                cf.nbFactorizationReuses++;
+            return true;
         }
     }
 
-    problem.getPrimalSolution(lambda);
-    objective = problem.getObjVal();
-
-    real_t * slack = new real_t[nbVariables+nbConstraints]; // dual solution: slack[0:nV-1] => corresponds to lambda, slack[nV:nC+1] => corresponds to dual variables
-    problem.getDualSolution(slack);
-
-    dual.resize(nbConstraints);
-    for (int i=0; i<nbConstraints; i++)
-        dual[i]=slack[nbVariables+i];
-    delete[] slack;
-    //    }
+    // First contact-free step with this structure (or failed hot start), set up the problem again
+    cf.clear();
+    cf.problem = new SQProblem(nbVariables, nbConstraints, m_hessianType);
+    cf.nbVariables = nbVariables;
+    cf.nbConstraints = nbConstraints;
+    cf.hessianType = m_hessianType;
+    cf.actuatorRowIds = m_qpCLists->actuatorRowIds;
+    cf.equalityRowIds = m_qpCLists->equalityRowIds;
+    cf.Q.assign(Q, Q+QSize);
+    if(ASize>0)
+        cf.A.assign(A, A+ASize);
 
-    result.clear();
-    result.resize(nbVariables);
-    for (int i=0; i<nbVariables; i++){
-        result[i]=lambda[i];
-    }
+    Options options;
+    cf.problem->setOptions(options);
+    cf.problem->setPrintLevel(qpOASES::PL_NONE);
+
+    nWSR = m_nWSRLimit;
+    real_t cputime = 0.;
+    returnValue status = cf.problem->init(cf.Q.data(), c, (ASize>0)? cf.A.data() : nullptr, l, u, bl, bu, nWSR, getCPUTimeLimit(cputime));
+    addQPOASESStatistics(*cf.problem, QPOASESCounters(), nWSR);
+    if(status == qpOASES::SUCCESSFUL_RETURN && cf.problem->isSolved() && !cf.problem->isInfeasible())
+        return true;
 
-    delete[] u;
-    delete[] l;
-    delete[] A;
-    delete[] bl;
-    delete[] bu;
-    delete[] Q;
-    delete[] c;
-    delete[] lambda;
+    // Let the usual resolution (and its fallbacks in case of infeasibility) handle this step
+    cf.clear();
+    return false;
 }
 
 
-QProblem QPInverseProblemImpl::getNewQProblem(int& nWSR)
+QProblem& QPInverseProblemImpl::resetQProblem(int& nWSR)
 {
     int nbVariables = m_qpSystem->dim;
     int nbConstraints = m_qpSystem->A.size()+m_qpSystem->Aeq.size();
 
-    QProblem problem(nbVariables, nbConstraints);
+    // The arrays of the problem are sized for its layout: a problem of the same layout is reset instead of
+    // allocated again
+    if(m_coldProblem && nbVariables > 0 && nbVariables == m_coldNbVariables && nbConstraints == m_coldNbConstraints)
+        m_coldProblem->reset();
+    else
+    {
+        deleteColdProblem();
+        m_coldProblem = new QProblem(nbVariables, nbConstraints, m_hessianType);
+        m_coldNbVariables = nbVariables;
+        m_coldNbConstraints = nbConstraints;
+
+        Options options;
+        m_coldProblem->setOptions(options);
+        m_coldProblem->setPrintLevel(qpOASES::PL_NONE);
+    }
+
+    // reset() forgets the type of the Hessian, which the fallbacks also change
+    m_coldProblem->setHessianType(m_hessianType);
 
-    Options options;
-    problem.setOptions(options);
+    nWSR = m_nWSRLimit; // problem.init() changes the variable nWSR with the number of working set recalculation it took to solve the problem. So we have to update it.
 
-    problem.setPrintLevel(qpOASES::PL_NONE);
+    return *m_coldProblem;
+}
 
-    nWSR = 500; // problem.init() changes the variable nWSR with the number of working set recalculation it took to solve the problem. So we have to update it.
 
-    return problem;
+void QPInverseProblemImpl::deleteColdProblem()
+{
+    delete m_coldProblem;
+    m_coldProblem = nullptr;
+    m_coldNbVariables = 0;
+    m_coldNbConstraints = 0;
 }
 
 
-void QPInverseProblemImpl::updateOASESMatrices(real_t * Q, real_t * c, real_t * l, real_t * u,
-                                               real_t * A, real_t * bl, real_t * bu)
+void QPInverseProblemImpl::updateOASESMatrices(real_t *& Q, real_t *& c, real_t *& l, real_t *& u,
+                                               real_t *& A, real_t * bl, real_t * bu)
 {
-    for (unsigned int i=0; i<m_qpSystem->dim; i++)
-    {
-        for (unsigned int j=0; j<m_qpSystem->dim; j++)
-            Q[i*m_qpSystem->dim+j] = m_qpSystem->Q[i][j];
-        c[i] = m_qpSystem->c[i];
-    }
+    static_assert(std::is_same<real_t, double>::value, "The QP system is given to qpOASES without conversion, real_t should be double");
+
+    // Q, c, l and u are stored contiguously in the QP system and given to qpOASES without copy
+    Q = m_qpSystem->Q.data();
+    c = m_qpSystem->c.data();
+    l = m_qpSystem->l.data();
+    u = m_qpSystem->u.data();
 
     int ASize = m_qpSystem->A.size();
     int AeqSize = m_qpSystem->Aeq.size();
-    for (int i=0; i<ASize; i++)
+    int dim = m_qpSystem->dim;
+
+    // qpOASES expects [A; Aeq], which only needs a copy when there are equality constraints
+    if(AeqSize == 0)
+        A = m_qpSystem->A.data();
+    else
     {
-        for (unsigned int j=0; j<m_qpSystem->dim; j++)
-            A[i*m_qpSystem->dim+j] = m_qpSystem->A[i][j];
+        A = m_workspace.A.data();
+        std::copy(m_qpSystem->A.data(), m_qpSystem->A.data() + ASize*dim, A);
+        std::copy(m_qpSystem->Aeq.data(), m_qpSystem->Aeq.data() + AeqSize*dim, A + ASize*dim);
+    }
 
+    for (int i=0; i<ASize; i++)
+    {
         bu[i]=m_qpSystem->bu[i];
         if (m_qpSystem->hasBothSideInequalityConstraint) bl[i]=m_qpSystem->bl[i];
         else bl[i]=-1e99;
     }
 
-    if(m_qpSystem->Aeq.size())
-        for (int i=0; i<AeqSize; i++)
-        {
-            for (unsigned int j=0; j<m_qpSystem->dim; j++)
-                A[(i+ASize)*m_qpSystem->dim+j] = m_qpSystem->Aeq[i][j];
-
-            bu[ASize+i]=m_qpSystem->beq[i];
-            bl[ASize+i]=m_qpSystem->beq[i];
-        }
+    for (int i=0; i<AeqSize; i++)
+    {
+        bu[ASize+i]=m_qpSystem->beq[i];
+        bl[ASize+i]=m_qpSystem->beq[i];
+    }
 
-    for (unsigned int i=0; i<m_qpSystem->dim; i++)
+    // The solvers are given the equilibrated QP, unscaled at the end of solveInverseProblem()
+    if(m_scale)
     {
-        u[i]=m_qpSystem->u[i];
-        l[i]=m_qpSystem->l[i];
+        m_scaling.scale(dim, ASize+AeqSize, Q, c, l, u, A, bl, bu);
+        Q = m_scaling.getQ();
+        c = m_scaling.getC();
+        l = m_scaling.getL();
+        u = m_scaling.getU();
+        A = m_scaling.getA();
     }
 }
 
@@ -622,68 +3390,100 @@ bool QPInverseProblemImpl::checkAndUpdatePivot(const vector<double>&result,
 
     int nbPivot = 0;
 
-    // Identify those inequality constraints that reach their boundary
-    if(m_mu>0.0)
+    // The displacements of all the contact rows at once, read by the pivots below
+    computeContactDeltas(result);
+
+    // Identify those inequality constraints that reach their boundary, for all the contacts in one pass
+    // over the states and the triplets (lambda, delta) of the contact rows
+    gatherContactStates();
+    const double* contactLambda = result.data() + nbActuatorRow;
+    nbPivot = m_contactStates.findBoundaries(contactLambda, m_contactDeltas.data(), m_contactCandidates);
+    for(unsigned int c=0; c<m_contactCandidates.size(); c++)
     {
-        for(int i=0; i<nbContactRow; i+=m_qpCParams->contactNbLines) // For each contact point
-        {
-            vector<double> delta  = {getDelta(result, m_qpCLists->contactRowIds[i]),
-                                     getDelta(result, m_qpCLists->contactRowIds[i+m_qpCParams->slidingDirId1]),
-                                     getDelta(result, m_qpCLists->contactRowIds[i+m_qpCParams->slidingDirId2])};
-            vector<double> lambda = {result[nbActuatorRow+i],
-                                     result[nbActuatorRow+i+m_qpCParams->slidingDirId1],
-                                     result[nbActuatorRow+i+m_qpCParams->slidingDirId2]};
+        const int candidateId = m_contactCandidates[c];
+        const int i = c*m_qpCParams->contactNbLines;
+        if(candidateId == QPContactStates::s_noCandidate)
+            continue;
 
-            for(unsigned int k=0;k<m_qpCParams->contactNbLines; k++)
-                isCandidate[i+k]   = false;
+        if(m_mu>0.0 && m_allowSliding && candidateId == QPContactStates::s_slidingCandidates)
+        {
+            // In case sliding <-> stick we need to look at the dual variable of both lambda_t and lambda_o
+            isCandidate[i+m_qpCParams->slidingDirId1] = true;
+            isCandidate[i+m_qpCParams->slidingDirId2] = true;
+        }
+        else
+            isCandidate[i] = true;
+    }
 
-            int candidateId = 0;
-            if(m_qpCParams->contactStates[i/m_qpCParams->contactNbLines]->hasReachedBoundary(lambda, delta, m_mu, candidateId))
+    // Pivot constraints
+    if(nbPivot>0)
+    {
+        // Block pivoting (Judice and Pires): all the candidates are pivoted at once, as long as the number
+        // of candidates decreases. It is allowed s_maxBlockTrials iterations without decrease before
+        // falling back to single pivots, until the number of candidates is lower than the best one.
+        bool doBlockPivot = false;
+        if(m_blockPivoting)
+        {
+            if(nbPivot < m_blockBestNbCandidates)
             {
-                if(m_allowSliding)
-                {
-                    if(candidateId>2) // In case sliding <-> stick we need to look at the dual variable of both lambda_t and lambda_o
-                    {
-                        isCandidate[i+m_qpCParams->slidingDirId1] = true;
-                        isCandidate[i+m_qpCParams->slidingDirId2] = true;
-                    }
-                    else
-                        isCandidate[i+candidateId] = true;
-                }
-                else
-                    isCandidate[i] = true;
+                m_blockBestNbCandidates = nbPivot;
+                m_blockNbTrials = 0;
+                doBlockPivot = true;
             }
-
-            if(isCandidate[i] || isCandidate[i+1] || isCandidate[i+2])
-                nbPivot++;
+            else if(m_blockNbTrials < s_maxBlockTrials)
+            {
+                m_blockNbTrials++;
+                doBlockPivot = true;
+            }
+            else
+                m_nbSinglePivotFallbacks++;
         }
-    }
-    else
-    {
-        for(int i=0; i<nbContactRow; i++)
+
+        if(doBlockPivot)
         {
-            double delta = getDelta(result, m_qpCLists->contactRowIds[i]);
-            double lambda = result[nbActuatorRow+i];
+            // Only the contacts with a row in [A; Aeq] are pivoted, as for the single pivot
+            vector<bool> isPivoted(m_qpCParams->nbContactPoints, false);
+            for(unsigned int i=0; i<dual.size(); i++)
+                if(m_qpCParams->constraintsId[i]>=nbActuatorRow)
+                {
+                    int contactConstraintId = m_qpCParams->constraintsId[i]-nbActuatorRow;
+                    if(isCandidate[contactConstraintId])
+                        isPivoted[contactConstraintId/m_qpCParams->contactNbLines] = true;
+                }
+
+            unsigned int nbPivoted = 0;
+            for(unsigned int i=0; i<m_qpCParams->nbContactPoints; i++)
+                if(isPivoted[i])
+                {
+                    updateContactState(result, i);
+                    nbPivoted++;
+                }
 
-            isCandidate[i] = m_qpCParams->contactStates[i]->hasReachedBoundary(lambda, delta);
-            if(isCandidate[i])
-                nbPivot++;
+            if(nbPivoted>0)
+            {
+                // The sequences of single pivots are not comparable across a block pivot
+                m_sequence.clear();
+                m_currentSequence.clear();
+                m_previousSequence.clear();
+                m_pivotsPerIteration.push_back(nbPivoted);
+                return false;
+            }
         }
-    }
 
-    // Pivot constraints
-    if(nbPivot>0)
-    {
         // Select best candidate for pivot
         double max = 0.;
         bool doPivot = false;
         int bestCandidate = 0;
+        const bool isSpeculative = m_speculativePivots.isEnabled();
+        m_speculativeRows.clear();
 
         for(unsigned int i=0; i<dual.size(); i++) // Size of [A; Aeq]
         {
             if(m_qpCParams->constraintsId[i]>=nbActuatorRow) // Row in [A; Aeq] corresponding to contact constraint
             {
                 int contactConstraintId = m_qpCParams->constraintsId[i]-nbActuatorRow;
+                if(isSpeculative && isCandidate[contactConstraintId] && !isCycling(contactConstraintId))
+                    m_speculativeRows.push_back({dual[i], contactConstraintId});
                 if(isCandidate[contactConstraintId] && (dual[i]>max || doPivot == false)) // Find the most blocking lambda_c by looking at its dual
                 {
                     if(!isCycling(contactConstraintId))
@@ -692,40 +3492,27 @@ bool QPInverseProblemImpl::checkAndUpdatePivot(const vector<double>&result,
                         bestCandidate = contactConstraintId;
                         doPivot = true;
                     }
-                    /*else
-                        msg_warning("checkAndUpdatePivot") << "is cycling at iteration " << m_iteration;*/
+                    else
+                        m_nbPivotCycles++;
                 }
             }
         }
 
+        if(doPivot && isSpeculative)
+            bestCandidate = selectSpeculativePivot(result, bestCandidate);
+
         // Update
         // Pivot best candidate
         if(doPivot)
         {
-            if(m_mu>0)
-            {
-                int candidate = (bestCandidate - (bestCandidate%m_qpCParams->contactNbLines))/m_qpCParams->contactNbLines; // Contact id
-
-                vector<double> delta  = {getDelta(result, m_qpCLists->contactRowIds[candidate*m_qpCParams->contactNbLines]),
-                                         getDelta(result, m_qpCLists->contactRowIds[candidate*m_qpCParams->contactNbLines+1]),
-                                         getDelta(result, m_qpCLists->contactRowIds[candidate*m_qpCParams->contactNbLines+2])};
-                vector<double> lambda = {result[nbActuatorRow+candidate*m_qpCParams->contactNbLines],
-                                         result[nbActuatorRow+candidate*m_qpCParams->contactNbLines+1],
-                                         result[nbActuatorRow+candidate*m_qpCParams->contactNbLines+2]};
+            updateContactState(result, bestCandidate/m_qpCParams->contactNbLines);
+            m_pivotsPerIteration.push_back(1);
 
-                m_qpCParams->contactStates[candidate] = m_qpCParams->contactStates[candidate]->getNewContactHandler(m_qpCParams->allowedContactStates, lambda, delta, m_mu);
-            }
-            else
-            {
-                double delta = getDelta(result, m_qpCLists->contactRowIds[bestCandidate]);
-                double lambda = result[nbActuatorRow+bestCandidate];
-                m_qpCParams->contactStates[bestCandidate] = m_qpCParams->contactStates[bestCandidate]->getNewContactHandler(m_qpCParams->allowedContactStates, lambda, delta);
-            }
-
-            if(isIn(m_currentSequence,bestCandidate))
+            if(m_currentSequence.contains(bestCandidate))
             {
-                m_previousSequence = m_sequence;
-                m_sequence = m_currentSequence;
+                // previous <- sequence <- current, by exchanges of the buffers
+                m_previousSequence.swap(m_sequence);
+                m_sequence.swap(m_currentSequence);
                 m_currentSequence.clear();
             }
             m_currentSequence.push_back(bestCandidate);
@@ -734,30 +3521,127 @@ bool QPInverseProblemImpl::checkAndUpdatePivot(const vector<double>&result,
         }
     }
 
+    m_pivotsPerIteration.push_back(0);
     return true;
 }
 
 
+int QPInverseProblemImpl::selectSpeculativePivot(const vector<double>& result, const int& bestCandidate)
+{
+    // Candidates of largest dual, one row per contact
+    const unsigned int nbLines = m_qpCParams->contactNbLines;
+    std::stable_sort(m_speculativeRows.begin(), m_speculativeRows.end(),
+                     [](const std::pair<double, int>& a, const std::pair<double, int>& b){return a.first > b.first;});
+    m_speculativeContacts.clear();
+    for(const std::pair<double, int>& row : m_speculativeRows)
+    {
+        if(m_speculativeContacts.size() == m_speculativePivots.getMaxNbCandidates())
+            break;
+        const bool isListed = std::any_of(m_speculativeContacts.begin(), m_speculativeContacts.end(),
+                                          [&](const int& listed){return listed/nbLines == row.second/nbLines;});
+        if(!isListed)
+            m_speculativeContacts.push_back(row.second);
+    }
+    if(m_speculativeContacts.size() < 2)
+        return bestCandidate;
+
+    // The QP of each candidate is built after its pivot, from the states of this iteration. Q and c do not
+    // depend on the contact states.
+    const int nbActuatorRow = m_qpCLists->actuatorRowIds.size();
+    const int nbVariables = m_qpSystem->dim;
+    m_speculativeHandlers = m_qpCParams->contactStates;
+    m_speculativeStates.clear();
+    m_speculativePivots.begin(nbVariables, m_qpSystem->Q.data(), m_qpSystem->c.data(), m_hessianType, m_nWSRLimit);
+    for(const int& row : m_speculativeContacts)
+    {
+        const unsigned int contactId = row/nbLines;
+        m_speculativeStates.push_back(m_contactStates.getNewState(contactId, result.data() + nbActuatorRow, m_contactDeltas.data()));
+        m_qpCParams->contactStates = m_speculativeHandlers;
+        updateContactState(result, contactId);
+        m_qpCParams->constraintsId.clear();
+        m_constraintHandler->buildConstraintMatrices(result, m_qpSystem, m_qpCLists);
+        if((int)m_qpSystem->dim == nbVariables)
+            m_speculativePivots.addCandidate(row, *m_qpSystem);
+    }
+    m_qpCParams->contactStates = m_speculativeHandlers;
+    m_qpCParams->constraintsId.clear();
+    m_constraintHandler->buildConstraintMatrices(result, m_qpSystem, m_qpCLists);
+    m_speculativePivots.solve();
+
+    // Progress of each solution: the contacts left at a boundary, then the objective
+    int selected = bestCandidate;
+    int bestNbBoundaries = std::numeric_limits<int>::max();
+    double bestObjective = 0.;
+    for(unsigned int i=0; i<m_speculativePivots.getNbCandidates(); i++)
+    {
+        const QPSpeculativePivots::Candidate& candidate = m_speculativePivots.getCandidate(i);
+        if(!candidate.isSolved)
+            continue;
+
+        const unsigned int k = std::find(m_speculativeContacts.begin(), m_speculativeContacts.end(), candidate.pivot) - m_speculativeContacts.begin();
+        gatherContactStates();
+        m_contactStates.getStates()[candidate.pivot/nbLines] = m_speculativeStates[k];
+        computeContactDeltas(candidate.x);
+        const int nbBoundaries = m_contactStates.findBoundaries(candidate.x.data() + nbActuatorRow, m_contactDeltas.data(),
+                                                                m_speculativeBoundaries);
+        if(nbBoundaries < bestNbBoundaries || (nbBoundaries == bestNbBoundaries && candidate.objective < bestObjective))
+        {
+            selected = candidate.pivot;
+            bestNbBoundaries = nbBoundaries;
+            bestObjective = candidate.objective;
+        }
+    }
+
+    // State of the iteration, read by the pivot
+    computeContactDeltas(result);
+    gatherContactStates();
+    m_nbSpeculativePivots++;
+    return selected;
+}
+
+
+void QPInverseProblemImpl::gatherContactStates()
+{
+    // The handlers stay the states read by the constraint handler, their enums are gathered for the pass
+    const vector<ContactHandler*>& handlers = m_qpCParams->contactStates;
+    vector<QPContactStates::State>& states = m_contactStates.getStates();
+    states.resize(handlers.size());
+    for(unsigned int i=0; i<handlers.size(); i++)
+        states[i] = handlers[i]->getState();
+    m_contactStates.setFriction(m_mu, m_allowSliding, m_qpCParams->frictionCone);
+}
+
+
+void QPInverseProblemImpl::updateContactState(const vector<double>& result, const unsigned int& contactId)
+{
+    int nbActuatorRow  = m_qpCLists->actuatorRowIds.size();
+
+    // The states are gathered by checkAndUpdatePivot(), the pivots of a block all read them before any update
+    const QPContactStates::State state = m_contactStates.getNewState(contactId, result.data() + nbActuatorRow, m_contactDeltas.data());
+    for(ContactHandler* handler : m_qpCParams->allowedContactStates)
+        if(handler->getState() == state)
+            m_qpCParams->contactStates[contactId] = handler;
+}
+
+
 bool QPInverseProblemImpl::isCycling(const int pivot)
 {
     // Sequence starts if pivot already in currentSequence
-    if(isIn(m_currentSequence, pivot))
-        if(m_currentSequence.size()!=0 && m_currentSequence[m_currentSequence.size()-1]==pivot)
-            return true;
+    if(!m_currentSequence.empty() && m_currentSequence.back()==pivot)
+        return true;
 
-    if(m_sequence.size()!=0 && m_previousSequence.size()!=0 && m_previousSequence[0]==pivot && m_sequence[0]==pivot)
+    if(!m_sequence.empty() && !m_previousSequence.empty() && m_previousSequence.front()==pivot && m_sequence.front()==pivot)
         return true;
 
-    vector<int> currentSequence = m_currentSequence;
-    currentSequence.push_back(pivot);
-    if(currentSequence==m_sequence || currentSequence==m_previousSequence)
+    // currentSequence + pivot repeats one of the last two sequences, compared by their hashes
+    if(m_sequence.isExtensionOf(m_currentSequence, pivot) || m_previousSequence.isExtensionOf(m_currentSequence, pivot))
         return true;
 
     return false;
 }
 
 
-bool QPInverseProblemImpl::isIn(const vector<int> list,
+bool QPInverseProblemImpl::isIn(const vector<int>& list,
                                 const int elem)
 {
     for(unsigned int i=0; i<list.size(); i++)
@@ -768,32 +3652,120 @@ bool QPInverseProblemImpl::isIn(const vector<int> list,
 }
 
 
-double QPInverseProblemImpl::getDelta(const vector<double>& result,
-                                      const int& index)
+void QPInverseProblemImpl::computeContactDeltas(const vector<double>& result)
 {
-    unsigned int nbActuators  = m_qpCLists->actuatorRowIds.size();
-    unsigned int nbEquality = m_qpCLists->equalityRowIds.size();
+    // delta_c = dfree_c + W(c, [actuators equality contacts]) x, the rows of the contacts being the last
+    // rows of the gathered block W(x, x), each a contiguous dot product
+    const QPPermutedCompliance& Wx = updatePermutedCompliance();
+    const unsigned int dim = Wx.getDimension();
+    const vector<unsigned int>& contactRowIds = m_qpCLists->contactRowIds;
+    const unsigned int nbFixedRows = dim - contactRowIds.size();
+    m_contactDeltas.resize(contactRowIds.size());
+    const ConstVectorView x(result.data(), dim);
+    for(unsigned int i=0; i<contactRowIds.size(); i++)
+        m_contactDeltas[i] = m_qpSystem->dFree[contactRowIds[i]] + ConstVectorView(Wx[nbFixedRows + i], dim).dot(x);
+}
 
-    vector<unsigned int> acIds;
-    acIds.resize(m_qpSystem->dim);
 
-    for (unsigned int i=0; i<m_qpSystem->dim; i++)
+
+/// Others
+
+void QPInverseProblemImpl::setHorizon(const unsigned int& horizon, const double& variationWeight,
+                                      const vector<SReal>& targetShifts)
+{
+    m_horizonProblem.setHorizon(horizon);
+    m_horizonProblem.setVariationWeight(variationWeight);
+    m_horizonProblem.setTargetShifts(targetShifts);
+}
+
+
+bool QPInverseProblemImpl::solveHorizonProblem(double& objective, vector<double>& result)
+{
+    // Q, c and Wea come from buildQPMatrices(), on the actuators only, which are the first variables of
+    // the gathered block W(x, x)
+    const vector<unsigned int>& acIds = m_qpCLists->actuatorRowIds;
+    const unsigned int nbActuators = acIds.size();
+    const QPPermutedCompliance& Wx = updatePermutedCompliance();
+    m_Waa.resize(nbActuators, nbActuators);
+    m_dFreeActuators.resize(nbActuators);
+    for(unsigned int i=0; i<nbActuators; i++)
     {
-        if (i<nbActuators)                acIds[i] = m_qpCLists->actuatorRowIds[i];  // actuators first
-        else if(i<nbActuators+nbEquality) acIds[i] = m_qpCLists->equalityRowIds[i-nbActuators]; // equality second
-        else                              acIds[i] = m_qpCLists->contactRowIds[i-nbActuators-nbEquality]; // contacts last
+        for(unsigned int j=0; j<nbActuators; j++)
+            m_Waa(i, j) = Wx[i][j];
+        m_dFreeActuators(i) = m_qpSystem->dFree[acIds[i]];
     }
 
-    double delta = m_qpSystem->dFree[index];
-    for(unsigned int i=0; i<m_qpSystem->dim; i++)
-        delta += m_qpSystem->W[index][acIds[i]]*result[i];
+    // The actuation of the previous step, the actuators come first in lambda
+    vector<double>& previous = m_workspace.previousLambda;
+    previous.clear();
+    if(m_qpSystem->lambda.size()>=nbActuators)
+        previous.assign(m_qpSystem->lambda.begin(), m_qpSystem->lambda.begin()+nbActuators);
+
+    const ConstMatrixView Q(m_qpSystem->Q.data(), nbActuators, nbActuators);
+    const ConstVectorView c(m_qpSystem->c.data(), nbActuators);
+    if(!m_horizonProblem.solve(Q, c, m_Wea, m_Waa, m_dFreeActuators, m_qpCLists->actuatorBounds, previous, result))
+        return false;
 
-    return delta;
+    objective = m_horizonProblem.getObjective();
+    return true;
 }
 
 
+bool QPInverseProblemImpl::solvePrioritizedProblem(double& objective, vector<double>& result)
+{
+    const vector<unsigned int>& levels = m_qpCLists->effectorRowLevels;
+    if(levels.empty() || levels.size() != size_t(m_Wea.rows()))
+        return false;
+
+    // Q, c and the weighted Wea come from buildQPMatrices(), the energy term is the rest of Q
+    const int nbVariables = m_qpSystem->dim;
+    const ConstMatrixView Q(m_qpSystem->Q.data(), nbVariables, nbVariables);
+    m_energyHessian = Q;
+    m_energyHessian.noalias() -= m_Wea.transpose()*m_Wea;
+
+    // Constraints [A; Aeq] as given to qpOASES, without the equilibration of the single QP
+    const int ASize = m_qpSystem->A.size();
+    const int AeqSize = m_qpSystem->Aeq.size();
+    const int nbConstraints = ASize+AeqSize;
+    m_workspace.reserve(nbVariables, nbConstraints);
+    real_t* A = m_qpSystem->A.data();
+    if(AeqSize>0)
+    {
+        A = m_workspace.A.data();
+        std::copy(m_qpSystem->A.data(), m_qpSystem->A.data() + ASize*nbVariables, A);
+        std::copy(m_qpSystem->Aeq.data(), m_qpSystem->Aeq.data() + AeqSize*nbVariables, A + ASize*nbVariables);
+    }
+    real_t* bl = m_workspace.bl.data();
+    real_t* bu = m_workspace.bu.data();
+    for(int i=0; i<ASize; i++)
+    {
+        bu[i] = m_qpSystem->bu[i];
+        bl[i] = (m_qpSystem->hasBothSideInequalityConstraint)? m_qpSystem->bl[i] : -1e99;
+    }
+    for(int i=0; i<AeqSize; i++)
+        bl[ASize+i] = bu[ASize+i] = m_qpSystem->beq[i];
+
+    auto span = beginSpan();
+    const bool solved = m_prioritizedProblem.solve(levels, m_Wea, m_dFreeEffectors, m_energyHessian, nbConstraints, A,
+                                                   m_qpSystem->l.data(), m_qpSystem->u.data(), bl, bu, result);
+    m_nbQPIterations = m_prioritizedProblem.getNbIterations();
+    endSpan(s_qpSpan, span, {{s_dimArg, nbVariables}, {s_constraintsArg, nbConstraints}, {s_nWSRArg, m_nbQPIterations}});
+    if(!solved)
+    {
+        warningMessage(s_prioritizedMessage) << "The prioritized problem could not be solved at time = " << m_time
+                                             << ", its levels are solved together.";
+        return false;
+    }
+    addWorkingSetChanges(m_nbQPIterations);
+
+    // Objective of the single QP, 1/2 x^T Q x + c^T x
+    const Eigen::Map<const Eigen::VectorXd> x(result.data(), nbVariables);
+    const ConstVectorView c(m_qpSystem->c.data(), nbVariables);
+    objective = 0.5*x.dot(Q*x) + c.dot(x);
+    m_nbPriorityLevels = QPPrioritizedProblem::getNbLevels(levels);
+    return true;
+}
 
-/// Others
 
 void QPInverseProblemImpl::updateLambda(const vector<double>& lambda)
 {
@@ -807,33 +3779,32 @@ void QPInverseProblemImpl::updateLambda(const vector<double>& lambda)
 }
 
 
-bool QPInverseProblemImpl::isFeasible(const vector<double>& x)
+void QPInverseProblemImpl::setProductionMode(const bool& production)
 {
-    for (unsigned int i=0; i<m_qpSystem->A.size(); i++)
-    {
-        double Ax_i = 0;
-        for(unsigned int j=0; j<m_qpSystem->dim; j++)
-            Ax_i += m_qpSystem->A[i][j]*x[j];
+    m_productionMode = production;
+    m_checkedNbVariables = -1;
+    m_checkedNbConstraints = -1;
+    m_constraintHandler->setProductionMode(production);
+}
 
-        if(Ax_i>m_qpSystem->bu[i] && rabs(Ax_i-m_qpSystem->bu[i])>1e-5)
-            return false;
 
-        if(m_qpSystem->hasBothSideInequalityConstraint)
-            if(Ax_i<m_qpSystem->bl[i] && rabs(Ax_i-m_qpSystem->bl[i])>1e-5)
-                return false;
-    }
+bool QPInverseProblemImpl::isLayoutChecked()
+{
+    const int nbVariables = m_qpSystem->dim;
+    const int nbConstraints = m_qpSystem->A.size()+m_qpSystem->Aeq.size();
+    if(m_productionMode && nbVariables == m_checkedNbVariables && nbConstraints == m_checkedNbConstraints)
+        return true;
 
-    for (unsigned int i=0; i<m_qpSystem->Aeq.size(); i++)
-    {
-        double Ax_i = 0;
-        for(unsigned int j=0; j<m_qpSystem->dim; j++)
-            Ax_i += m_qpSystem->Aeq[i][j]*x[j];
+    m_checkedNbVariables = nbVariables;
+    m_checkedNbConstraints = nbConstraints;
+    return false;
+}
 
-        if(rabs(Ax_i-m_qpSystem->beq[i])>1e-5)
-            return false;
-    }
 
-    return true;
+bool QPInverseProblemImpl::isFeasible(const vector<double>& x)
+{
+    m_constraintResiduals.compute(*m_qpSystem, x.data());
+    return m_constraintResiduals.isFeasible();
 }
 
 
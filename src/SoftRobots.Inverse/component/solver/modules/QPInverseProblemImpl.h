@@ -28,13 +28,50 @@
 ******************************************************************************/
 #pragma once
 
+#include <cstdint>
+#include <map>
 #include <Eigen/Core>
+#include <Eigen/Cholesky>
 #include <qpOASES/Types.hpp>
 #include <qpOASES/QProblem.hpp>
+#include <qpOASES/SQProblem.hpp>
+#include <sofa/helper/system/thread/CTime.h>
+#include <sofa/linearalgebra/FullMatrix.h>
+#include <sofa/linearalgebra/FullVector.h>
 #include <SoftRobots/component/behavior/SoftRobotsBaseConstraint.h>
 
 #include <SoftRobots.Inverse/component/solver/modules/ConstraintHandler.h>
+#include <SoftRobots.Inverse/component/solver/modules/LCPPGSSolver.h>
+#include <SoftRobots.Inverse/component/solver/modules/LCPQPSolver.h>
+#include <SoftRobots.Inverse/component/solver/modules/NLCPSolver.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPActiveSetCache.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPAdaptiveEpsilon.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPAdaptiveLimit.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPBackendSelector.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPCheckpoint.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPConstraintResiduals.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPContactPatches.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPContactReduction.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPContactStates.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPContactTracker.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPCostAttribution.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPEqualityElimination.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPHessianBackend.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPHorizonProblem.h>
 #include <SoftRobots.Inverse/component/solver/modules/QPInverseProblem.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPMatrixFreeSolver.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPMessageQueue.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPPermutedCompliance.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPPivotSequence.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPPresolve.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPPrioritizedProblem.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPScaling.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPSensitivity.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPSmallProblem.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPSolverBackend.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPSparseMatrices.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPSpeculativePivots.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPTrace.h>
 
 #include <SoftRobots.Inverse/component/config.h>
 
@@ -44,8 +81,16 @@ namespace softrobotsinverse::solver::module
 
 using sofa::type::vector;
 using qpOASES::real_t;
+using qpOASES::int_t;
 
 
+/// Thread safety: an instance owns all the state of its resolutions (QP system, constraint handler, hot
+/// started qpOASES problems, LCP solvers, workspaces, pivot sequences, step counters), so that distinct
+/// instances can be solved at the same time on distinct threads, e.g. several simulations in one process
+/// or a QPBatchSolver. An instance itself is used by one thread at a time. qpOASES is built without
+/// output (__SUPPRESSANYOUTPUT__), so that its global message handler is never written. The constraint
+/// components are read by solve() and receive its results, see setDetached() when a simulation thread
+/// updates them meanwhile.
 class SOFA_SOFTROBOTS_INVERSE_API QPInverseProblemImpl : public QPInverseProblem
 {
 
@@ -61,48 +106,978 @@ public:
 
     void init();
     void solve(double &objective, int &iterations);
+    /// Stores the given solution of the QP variables as solve() would, without solving, e.g. the solution of
+    /// the same problem at the previous step (see QPChangeDetection)
+    void reuseSolution(const vector<double>& lambda);
+    /// Forward step: the lambdas of the actuators then of the equality rows are fixed to the given ones, e.g. the
+    /// solution of the last inverse step, and only the contact problem is solved. False if some are missing.
+    bool solveContactsOnly(const vector<double>& lambdas, double& objective, int& iterations);
     void setMinContactForces(const double& minContactForces) {m_qpCParams->minContactForces = minContactForces; m_qpCParams->hasMinContactForces = true;}
     void setMaxContactForces(const double& maxContactForces) {m_qpCParams->maxContactForces = maxContactForces; m_qpCParams->hasMaxContactForces = true;}
+    void setHotStart(const bool& hotStart) {m_hotStart = hotStart;}
+
+    /// While enabled, the steps without contact are solved with a QP of their own, kept between these steps
+    /// (and through the steps with contacts) as long as the actuator and equality rows, and the number of
+    /// constraints, do not change. It is hot started from the previous contact-free step, and when Q and A
+    /// did not change either (e.g. a compliance from a factorization kept between steps), only the vectors
+    /// are updated and the factorization of the previous step is reused. Disabling releases this QP.
+    void setContactFreeHotStart(const bool& hotStart);
+
+    /// While enabled, the QPs are solved with a QP of their own whose Q and A are kept, as long as the QP
+    /// layout does not change and the relative variation of Q and A (infinity norm of the difference, as
+    /// in displayQNormVariation) since their factorization stays below threshold. Only the vectors (c and
+    /// the bounds) are updated by a hot start, as in the online active set strategy, and Q and A are
+    /// factorized again when the threshold is reached. The solution is the one of the QP with the kept
+    /// Q and A. Disabling releases this QP.
+    void setParametricQP(const bool& parametric, const double& threshold);
+
+    /// While enabled, Q and the energy weight are kept and reused as long as the blocks of W they are
+    /// computed from do not change (e.g. a compliance from a factorization kept between steps), only c
+    /// is computed again. Disabling releases the cached Hessian.
+    void setReuseHessian(const bool& reuse);
+
+    /// While enabled, Q and c are accumulated from the effector rows of W by chunks of s_condensedChunkSize
+    /// rows, instead of from a copy of the whole block Wea = W(effectors, variables): the scratch is
+    /// O(chunk*dim) instead of O(nbEffectors*dim). Not used with the cached Hessian, a backend of the
+    /// product, a horizon or priority levels, which read the whole block.
+    void setCondensedEffectors(const bool& condensed);
+    bool isCondensingEffectors() const;
+
+    /// With a size > 0 smaller than the number of effector rows, Q and c are assembled from a sketch S*Wea
+    /// of size rows instead of Wea (CountSketch, fixed from one step to the other): the product is
+    /// O(size*dim^2) instead of O(nbEffectors*dim^2), with an approximate objective. Same exclusions as
+    /// setCondensedEffectors(). 0 (default) disables it.
+    void setEffectorSketch(const unsigned int& size);
+    bool isSketchingEffectors() const;
+
+    /// Part of W_energy in the energy term of Q, by name: "Full" (default), "BlockDiagonal" (the blocks of the
+    /// lines of each actuator or equality constraint, and of each contact) or "Diagonal". The approximations
+    /// keep in Q the sparsity of Wea^T*Wea, e.g. for the sparse QP matrices, the energy weight being the
+    /// same. Changing it releases the cached Hessian.
+    void setEnergyApproximation(const std::string& name);
+
+    /// Number of assemblies of Q that reused the cached Hessian
+    unsigned int getNbHessianReuses() const {return m_hessianCache.nbReuses;}
+
+    /// While enabled, the state of each contact found at the end of the pivot algorithm is kept, by
+    /// contact identity (QPConstraintLists::contactIds), and used as initial state at the next step
+    /// instead of the guess from the contact LCP. Disabling clears the kept states.
+    void setWarmStartContacts(const bool& warmStart);
+
+    /// While enabled, the contacts without a persistent id are given one by matching them to the contacts of
+    /// the previous resolution (see QPContactTracker), and the contact solvers start from the forces the same
+    /// contacts had at the end of the previous resolution, instead of the forces of the rows at the same
+    /// index. Disabling clears the tracked contacts and their forces.
+    void setTrackContacts(const bool& track);
+    void setTrackContactsTolerance(const double& tolerance) {m_contactTracker.setTolerance(tolerance);}
+
+    /// While enabled, the first QP of the contact pivot loop is initialized with the solution of the contact
+    /// LCP (the actuators and equality constraints keeping their last values) as primal guess, and with the
+    /// working set of the last QP of the previous step when it has as many variables. Without a working
+    /// set, qpOASES guesses it from the primal guess. A working set of the active set cache prevails.
+    void setPrimalWarmStart(const bool& warmStart);
+
+    /// Number of steps whose first QP was initialized from the guess above
+    unsigned int getNbPrimalWarmStarts() const {return m_nbPrimalWarmStarts;}
+
+    /// Number of contacts whose state was taken from the previous step at the last resolution
+    unsigned int getNbWarmStartedContacts() const {return m_nbWarmStartedContacts;}
+
+    /// Contacts of the last resolution matched by the tracker to a contact of the previous one, and new ones
+    unsigned int getNbTrackedContacts() const {return m_contactTracker.getNbMatchedContacts();}
+    unsigned int getNbNewContacts() const {return m_contactTracker.getNbNewContacts();}
+
+    /// With a capacity > 0, the contact states and the working set of the last QP the pivot algorithm
+    /// ended with are cached for the configuration it started from (initial contact states, rows of the
+    /// actuators, equalities and contacts, bounds active at the end of the previous step). When the
+    /// configuration comes back, the pivot algorithm starts from them (see QPActiveSetCache).
+    void setActiveSetCache(const unsigned int& capacity) {m_activeSetCache.setCapacity(capacity);}
+    unsigned int getNbActiveSetCacheHits() const {return m_nbActiveSetCacheHits;}
+    unsigned int getNbActiveSetCacheMisses() const {return m_nbActiveSetCacheMisses;}
+
+    /// Selects the pivoting of the contact states: "Single" (default) changes the state of the most
+    /// blocking contact at each iteration, "Block" changes the states of all the contacts that violate
+    /// their complementarity condition, with a fallback to single pivots while it does not converge
+    void setPivoting(const std::string& name);
+
+    /// Number of contacts pivoted at each iteration of the last pivot algorithm (0 for the last one),
+    /// and number of iterations of the block pivoting that fell back to a single pivot
+    const vector<unsigned int>& getPivotsPerIteration() const {return m_pivotsPerIteration;}
+
+    /// Displacements delta = dfree + W x of the contact rows (in the order of contactRowIds), at the
+    /// solution of the last iteration of the pivot algorithm
+    const vector<double>& getContactDeltas() const {return m_contactDeltas;}
+    unsigned int getNbSinglePivotFallbacks() const {return m_nbSinglePivotFallbacks;}
+
+    /// Number of pivot candidates rejected by the cycle detection of the last pivot algorithm
+    unsigned int getNbPivotCycles() const {return m_nbPivotCycles;}
+
+    /// Speculative pivots: when several contacts are candidates for a single pivot, the QPs of the nbCandidates
+    /// candidates of largest dual are solved ahead (concurrently with multithreading, see QPSpeculativePivots),
+    /// and the candidate whose solution leaves the fewest contacts at a boundary is pivoted, the one of lowest
+    /// objective between equal ones. 0 or 1 to pivot the candidate of largest dual.
+    void setSpeculativePivots(const unsigned int& nbCandidates) {m_speculativePivots.setMaxNbCandidates(nbCandidates);}
+    /// Number of pivots of the last pivot algorithm chosen from the QPs of their candidates
+    unsigned int getNbSpeculativePivots() const {return m_nbSpeculativePivots;}
+
+    /// Violation of each row of [A; Aeq] at the last feasibility check (the solution of the last solve, or of
+    /// the last solve of a new layout in production mode), 0 for the satisfied rows, see QPConstraintResiduals
+    const vector<double>& getConstraintViolations() const {return m_constraintResiduals.getViolations();}
+
+    /// Selects the QP solver by name (see QPSolverBackend::create). The default "qpOASES" uses the
+    /// built-in qpOASES resolution, with hot start and the handling of infeasible problems. With "Adaptive",
+    /// the method of each QP is chosen by QPBackendSelector among the unconstrained minimizer, the fixed-size
+    /// kernel, the built-in qpOASES resolution and ADMM, whatever setInteriorFastPath() and setSmallProblemKernel()
+    /// (the contact LCP is solved with qpOASES). The decisions are logged when the method changes.
+    void setQPSolver(const std::string& name);
+    /// Coefficients of the cost model of the adaptive QP solver, see QPBackendSelector::setCostModel()
+    bool setBackendCostModel(const vector<double>& coefficients) {return m_backendSelector.setCostModel(coefficients);}
+    const QPBackendSelector& getBackendSelector() const {return m_backendSelector;}
+    /// Number of QPs of the last call to solve() for which the adaptive QP solver chose the backend
+    unsigned int getNbBackendSelections(const QPBackendSelector::Backend& backend) const {return m_nbBackendSelections[backend];}
+    /// With the ADMM solver, the linear system of its iterations is factorized by blocks when the QP
+    /// variables other than the contacts split in groups only coupled through the contacts (e.g. the
+    /// actuators of the fingers of a gripper), see QPBorderedFactorization
+    void setStructuredFactorization(const bool& structured) {m_structuredFactorization = structured;}
+    /// If enabled, the QPs without contact of at most QPSmallProblem::s_maxDim variables and
+    /// QPSmallProblem::s_maxConstraints constraints are solved by the fixed-size kernel of their size
+    /// (see QPSmallProblemKernel), before the selected QP solver, which remains the fallback when the
+    /// kernel fails (Hessian not positive definite, infeasible constraints).
+    void setSmallProblemKernel(const bool& smallProblemKernel) {m_smallProblemKernel = smallProblemKernel;}
+    /// Number of QPs solved by the fixed-size kernel
+    unsigned int getNbSmallProblemSolves() const {return m_nbSmallProblemSolves;}
+    /// If enabled, the QPs without equality constraint first try the unconstrained minimizer -Q^-1*c (one
+    /// LDLT factorization of Q): if it strictly satisfies the bounds and the constraints, it is the solution,
+    /// with zero multipliers, and the QP solvers are not called.
+    void setInteriorFastPath(const bool& interiorFastPath) {m_interiorFastPath = interiorFastPath;}
+    /// Number of QPs solved by the unconstrained minimizer
+    unsigned int getNbInteriorSolves() const {return m_nbInteriorSolves;}
+    /// Number of effectors left out of the objective at the last assembly, see behavior::EffectorDeadband
+    unsigned int getNbDeadbandEffectors() const {return m_nbDeadbandEffectors;}
+
+    /// Queue of the warnings of the resolution (infeasible QPs, recoveries), which can be shared by the problems.
+    /// Without queue (default), they are emitted at once.
+    void setMessageQueue(QPMessageQueue* queue) {m_messageQueue = queue;}
+
+    /// While an operator is set, solve() neither reads W nor its rows: the problem, which has to be supported
+    /// by QPMatrixFreeSolver (no contact), is solved with the products d = W f of the operator, and delta is
+    /// computed from them. nullptr to solve from W.
+    void setComplianceOperator(QPMatrixFreeSolver::Operator* complianceOperator) {m_complianceOperator = complianceOperator;}
+    void setMatrixFreeTolerance(const double& tolerance) {m_matrixFreeSolver.setTolerances(tolerance, tolerance);}
+    void setMatrixFreeMaxIterations(const int& maxIterations) {m_matrixFreeSolver.setMaxIterations(maxIterations);}
+    /// Number of products by W of the last matrix-free resolution
+    unsigned int getNbComplianceProducts() const {return m_nbComplianceProducts;}
+
+    /// Selects the backend of the product Q = Wea^T Wea by name (see QPHessianBackend::create).
+    /// The default "CPU" uses Eigen on the calling thread. An unavailable backend falls back to it.
+    void setHessianBackend(const std::string& name);
+
+    /// Selects the solver of the frictionless contact LCP: "QP" (default) or "PGS" (projected Gauss-Seidel
+    /// with over-relaxation, cheaper but only accurate up to the tolerance)
+    void setLCPSolver(const std::string& name);
+    void setLCPRelaxation(const double& omega) {m_pgsSolver->setRelaxation(omega);}
+
+    /// While enabled, the contact-contact block of W is extracted in block-CSR form (LCPSparseMatrix) for
+    /// the friction contact solver and the PGS solver, instead of a dense matrix. The QP solver of the
+    /// frictionless problem keeps the dense matrix.
+    void setSparseContacts(const bool& sparseContacts) {m_sparseContacts = sparseContacts;}
+
+    /// Largest density of [Q; A] for which qpOASES is given compressed matrices instead of the dense arrays
+    /// (see QPSparseMatrices), 0 to disable. The contact-free QP, the fallbacks of an infeasible QP and the
+    /// alternative QP solvers keep the dense arrays.
+    void setSparseQPThreshold(const double& threshold) {m_sparseMatrices.setDensityThreshold(threshold);}
+    const QPSparseMatrices& getSparseMatrices() const {return m_sparseMatrices;}
+
+    /// Over-relaxation of the friction contact solver (see NLCPSolver::setRelaxation)
+    void setNLCPRelaxation(const double& omega, const bool& adaptive) {m_nlcpSolver->setRelaxation(omega); m_nlcpSolver->setAdaptiveRelaxation(adaptive);}
+
+    /// Report of the friction contact solver at the last resolution, only valid if hasSolvedNLCP()
+    bool hasSolvedNLCP() const {return m_hasSolvedNLCP;}
+    const NLCPSolver* getNLCPSolver() const {return m_nlcpSolver;}
+
+    /// While enabled, the contacts whose rows of W are collinear up to the tolerance (on 1-cos) are merged
+    /// before the resolution, and their force is spread back on all of them if expandForces is true, or
+    /// kept on the most constraining one otherwise (see QPContactReduction)
+    void setContactReduction(const bool& reduce, const double& tolerance, const bool& expandForces);
+    unsigned int getNbReducedContacts() const {return m_contactReduction.getNbRemovedContacts();}
+
+    /// While enabled, the contacts are solved in two levels (see QPContactPatches): the contacts whose rows of W
+    /// are collinear up to the tolerance are solved as patches, then the contacts of the patches where one contact
+    /// disagrees with the state of its patch, by more than the threshold relative to the dfree of the patch, are
+    /// solved individually. Replaces the contact reduction.
+    void setMultilevelContacts(const bool& multilevel, const double& tolerance, const double& threshold);
+    unsigned int getNbContactPatches() const {return m_multilevelContacts? m_contactPatches.getNbPatches() : 0;}
+    unsigned int getNbRefinedPatches() const {return m_multilevelContacts? m_contactPatches.getNbRefinedPatches() : 0;}
+
+    /// While enabled, a problem without effector rows, whose actuators and equality rows all have an imposed
+    /// force (lambdaEqual, or equal min and max forces) and no displacement limit, is solved forward: they take
+    /// their imposed forces and only the contacts are solved (see solveContactsOnly())
+    void setForwardWithoutEffectors(const bool& forward) {m_forwardWithoutEffectors = forward;}
+    unsigned int getNbForwardSolves() const {return m_nbForwardSolves;}
+
+    /// Contact rows whose force is imposed at the next resolutions, e.g. by the consensus with the problems of
+    /// other processes (see QPConsensus): they are removed from the contacts and their forces moved in dfree.
+    /// After the resolution, they take their imposed force and getImposedContactDeltas() gives their
+    /// displacement. Empty rows to solve all the contacts.
+    void setImposedContactForces(const vector<unsigned int>& rows, const vector<double>& forces);
+    const vector<double>& getImposedContactDeltas() const {return m_imposedContactDeltas;}
+
+    /// While enabled, the constant and duplicate rows of the constraints are removed before each QP
+    /// (see QPPresolve). getNbPresolvedRows() gives the number removed from the last QP of the step.
+    void setPresolve(const bool& presolve) {m_presolve = presolve;}
+    unsigned int getNbPresolvedRows() const {return m_nbPresolvedRows;}
+
+    /// While enabled, the QP given to the solver is equilibrated with nbIterations of Ruiz (see QPScaling),
+    /// and its solution and multipliers are unscaled after the resolution
+    void setScaling(const bool& scaling, const unsigned int& nbIterations);
+
+    /// While enabled, the equality constraints are eliminated by substitution and the reduced QP, with
+    /// dim-nbEq variables and no equality constraint, is solved (see QPEqualityElimination). The full QP
+    /// is solved when Aeq is rank deficient or when the reduced QP is infeasible.
+    void setEqualityElimination(const bool& eliminate) {m_eliminateEqualities = eliminate;}
+    unsigned int getNbEqualityEliminations() const {return m_nbEqualityEliminations;}
+
+    /// Solves the friction contact problem with the colored Gauss-Seidel of NLCPSolver, the contacts
+    /// that are not coupled by W being updated concurrently (see NLCPSolver::setMultithreading),
+    /// and the blocks of the structured factorization being factorized concurrently
+    void setMultithreading(const bool& multithreading)
+    {
+        m_multithreading = multithreading;
+        m_nlcpSolver->setMultithreading(multithreading);
+        m_speculativePivots.setMultithreading(multithreading);
+    }
+    /// Cores the threads running the contact tasks are pinned to (see QPThreadAffinity)
+    void setThreadAffinity(const QPThreadAffinity* threadAffinity) {m_nlcpSolver->setThreadAffinity(threadAffinity);}
+    /// Scheduler running the contact tasks (see QPTaskPool), nullptr for the main task scheduler
+    void setTaskScheduler(sofa::simulation::TaskScheduler* taskScheduler)
+    {
+        m_nlcpSolver->setTaskScheduler(taskScheduler);
+        m_speculativePivots.setTaskScheduler(taskScheduler);
+    }
+
+    /// Solves the friction contact problem on a float copy of W, refined on W (see NLCPSolver::setMixedPrecision)
+    void setMixedPrecision(const bool& mixedPrecision) {m_nlcpSolver->setMixedPrecision(mixedPrecision);}
+
+    /// Allocation of the dense buffers of the resolution by name (see QPStoragePolicy): Q, A and Aeq of
+    /// the QP system, [A; Aeq] given to qpOASES, W(x, x) and its float copy, the last two with padded rows
+    void setStoragePolicy(const std::string& name);
+
+    /// Largest number of working set changes of a qpOASES resolution (nWSR), for the QPs and the contact LCP
+    void setMaxNbWorkingSetChanges(const int& maxNbWorkingSetChanges);
+
+    /// While enabled, the limits on the pivots of the contact loop and on the working set changes of the QPs
+    /// are sized from the counts of the recent resolutions (see QPAdaptiveLimit), bounded by the largest ones.
+    /// A QP stopped by its limit returns its best feasible iterate and ends the contact pivot loop.
+    void setAdaptiveLimits(const bool& adaptive, const double& percentile, const double& margin);
+    int getPivotLimit() const {return m_pivotLimit.getLimit();}
+    int getWorkingSetLimit() const {return m_workingSetLimit.getLimit();}
+
+    /// While enabled, the weight of the energy term is extrapolated from the traces of Q and W_energy between
+    /// the computations of their norms, and epsilon is scaled to keep the conditioning of Q in
+    /// [minConditioning, maxConditioning] (see QPAdaptiveEpsilon)
+    void setAdaptiveEpsilon(const bool& adaptive, const double& minConditioning, const double& maxConditioning);
+    double getEpsilonScale() const {return m_adaptiveEpsilon.getScale();}
+    unsigned int getNbEnergyNormRefreshes() const {return m_adaptiveEpsilon.getNbRefreshes();}
+
+    /// Largest number of working set changes of the QPs of the last call to solve(), and number of QPs
+    /// stopped by the limit of working set changes
+    int getMaxNbWorkingSetChanges() const {return m_maxNbWorkingSetChanges;}
+    unsigned int getNbWorkingSetLimitHits() const {return m_nbWorkingSetLimitHits;}
+
+    /// Recovery of an infeasible QP: "Cascade" (default) solves it again without the conflicting actuator
+    /// constraints and then with an indefinite Hessian, "Soft" solves it once with the constraint violations
+    /// as penalized slack variables, as soon as qpOASES detects the infeasibility (with the cascade as fallback)
+    void setInfeasibilityRecovery(const std::string& name);
+
+    /// Recovery branches of an infeasible QP, by increasing severity
+    enum class QPRecovery {None, ActuatorConstraints, IndefiniteHessian, SoftConstraints, Failed};
+
+    /// Most severe recovery taken by the QPs of the last call to solve()
+    QPRecovery getRecovery() const {return m_recovery;}
+    static std::string getRecoveryName(const QPRecovery& recovery);
+
+    /// Number of QP resolutions solved by a hot start of the previous problem (hits),
+    /// or that had to be (re)initialized from scratch (misses)
+    unsigned int getNbHotStartHits() const {return m_nbHotStartHits;}
+    unsigned int getNbHotStartMisses() const {return m_nbHotStartMisses;}
+
+    /// Number of contact-free QP resolutions solved by a hot start of the contact-free QP, and among them
+    /// the ones that reused its factorization (same Q and A)
+    unsigned int getNbContactFreeHotStarts() const {return m_contactFree.nbHotStarts;}
+    unsigned int getNbContactFreeFactorizationReuses() const {return m_contactFree.nbFactorizationReuses;}
+
+    /// Number of QP resolutions of the parametric mode that only updated the vectors, and number of
+    /// factorizations of its Q and A
+    unsigned int getNbParametricHotStarts() const {return m_parametric.nbHotStarts;}
+    unsigned int getNbParametricFactorizations() const {return m_parametric.nbFactorizations;}
+
+    void getMemoryUsage(QPMemoryUsage& usage) const override;
+
+    /// Exchanges the state kept across the resolutions (constraint handler and its row caches, workspace,
+    /// Hessian cache, hot started QPs, adaptive limits, contact states, LCP solvers and their counters)
+    /// with the other problem. W, dfree, the forces and the QP system stay in place, so that a locked
+    /// problem remains readable while the state moves to the problem written next.
+    void swapResolutionState(QPInverseProblemImpl& other);
+
+    /// Brings the problem back to the state of a new one, e.g. for another solver (see QPProblemPool):
+    /// the state carried from a step to the next (hot started QPs, Hessian and active set caches, working
+    /// sets, contact states, adaptive limits and counters) is cleared, the buffers are kept.
+    void resetResolutionState();
+
+    /// Number of QP resolutions solved with the simple bounds solver (no general constraints)
+    unsigned int getNbBoundedResolutions() const {return m_nbBoundedResolutions;}
+
+    /// Number of QPs of the contact pivot loop initialized from the working set of the previous pivot
+    unsigned int getNbPivotWarmStarts() const {return m_nbPivotWarmStarts;}
+
+    /// Number of iterations of the last QP resolution: working set changes for qpOASES,
+    /// iterations for the other backends
+    int getNbQPIterations() const {return m_nbQPIterations;}
+
+    /// Counters of the qpOASES calls (init() and hotstart()) of the QPs of the last call to solve(), summed
+    /// over the calls, including those whose result is not used (missed hot starts, infeasible QPs before a
+    /// recovery). The contact LCP is not included.
+    struct QPOASESStatistics{
+        unsigned int nbResolutions{0};
+        unsigned int nbWorkingSetChanges{0}; // Final nWSR of the calls
+        unsigned int nbBoundFlips{0}; // Bounds and constraints moved from a limit to the other (flipping bounds)
+        unsigned int nbFactorizations{0}; // Computed from scratch
+        unsigned int nbFactorizationUpdates{0}; // Bounds and constraints added to or removed from the working set
+        unsigned int nbRampings{0}; // Ramping strategy applied on degenerate steps
+        unsigned int nbRegularizations{0}; // Calls ending with a regularized Hessian
+        unsigned int nbIndefiniteFallbacks{0}; // Calls with HST_INDEF after an infeasible QP
+    };
+    const QPOASESStatistics& getQPOASESStatistics() const {return m_qpOASESStatistics;}
+
+    /// Time budget of one call to solve() in seconds, 0 for no budget. The contact LCP can use a quarter
+    /// of it, the contact pivot loop and the QPs the rest. When the budget is exhausted, the resolution
+    /// stops and returns the best feasible iterate found so far instead of running over the control period.
+    void setTimeBudget(const double& timeBudget) {m_timeBudget = timeBudget;}
+
+    /// True if the last call to solve() was stopped by the time budget, and number of such calls
+    bool hasHitDeadline() const {return m_deadlineHit;}
+    unsigned int getNbDeadlineHits() const {return m_nbDeadlineHits;}
+
+    /// Durations in milliseconds of the phases of the last call to solve(), only measured if enabled:
+    /// assembly of the QP matrices, contact LCP, and QP resolutions (including the contact pivot loop)
+    struct QPPhaseTimes{
+        double build{0.};
+        double lcp{0.};
+        double qp{0.};
+    };
+    void setComputeTimings(const bool& computeTimings) {m_computeTimings = computeTimings;}
+    const QPPhaseTimes& getPhaseTimes() const {return m_phaseTimes;}
+
+    /// Trace receiving the spans of the LCP, of the contact pivots and of each QP, nullptr for none
+    void setTrace(QPTrace* trace) {m_trace = trace;}
+
+    /// Diagnostic mode: attributes the cost of the QPs of each call to solve() to the constraint components
+    void setCostAttribution(const bool& attributeCosts) {m_attributeCosts = attributeCosts;}
+    const QPCostAttribution& getCostAttribution() const {return m_costAttribution;}
+
+    /// Production mode: the consistency of the constraint lists and the feasibility of the solution are only
+    /// checked when the layout of the problem (number of variables and of constraints, contact rows) changed
+    /// since the last checks, e.g. at the first resolution and when the contacts change
+    void setProductionMode(const bool& production);
+
+    /// Sensitivity output: keeps the duals of the last QP of each call to solve(), with the limits of the
+    /// actuators active at its solution. They are read from the QP solver, no resolution is added.
+    void setExportDuals(const bool& exportDuals) {m_exportDuals = exportDuals;}
+
+    /// Limits of an actuator row active at the solution, combined as bits
+    enum ActuatorLimit {LambdaMin=1, LambdaMax=2, DeltaMin=4, DeltaMax=8};
+
+    /// Duals of the bounds l <= x <= u of the QP variables (qpOASES convention: positive for an active lower
+    /// bound, negative for an active upper bound), empty if the last call to solve() did not solve a QP
+    const vector<double>& getBoundDuals() const {return m_duals.bounds;}
+    /// Duals of the rows of [A; Aeq], with the id of the variable of each row (see ConstraintHandler)
+    const vector<double>& getConstraintDuals() const {return m_duals.constraints;}
+    const vector<int>& getConstraintDualIds() const {return m_duals.constraintsId;}
+    /// Per actuator row: dual of its bounds on lambda, and its active limits (ActuatorLimit bits) on lambda
+    /// and on delta, from the solution
+    const vector<double>& getActuatorBoundDuals() const {return m_duals.actuatorBounds;}
+    const vector<int>& getActuatorActiveLimits() const {return m_duals.actuatorLimits;}
+
+    /// Differentiation of the solution: keeps the derivatives of the solution of the last QP of each call to
+    /// solve(), from the KKT system of its active set (see QPSensitivity), with no additional resolution.
+    /// They are empty if the last call to solve() did not end with a QP (e.g. friction contact solver).
+    void setSensitivities(const bool& sensitivities) {m_computeSensitivities = sensitivities;}
+    bool hasSensitivities() const {return m_sensitivity.isValid();}
+    /// Rows of W of the variables of the last QP, in the order of the rows of the derivatives (a merged
+    /// contact is given by its representative row)
+    const vector<unsigned int>& getSensitivityRows() const {return m_sensitivities.rows;}
+    /// dlambda/d(dfree) (nbVariables x getDimension()), through the effector rows of c = Wea^T S dfree_e and
+    /// the rows of the constraints whose bounds are limits minus dfree (delta limits, contacts, equality)
+    const RowMajorMatrixXd& getDfreeSensitivity() const {return m_sensitivities.dfree;}
+    /// dlambda/d(target) of the effector rows (nbVariables x nbEffectorRows), with dfree_e = delta_e - target
+    const RowMajorMatrixXd& getTargetSensitivity() const {return m_sensitivities.targets;}
+    /// dlambda/d(lambda bounds) (nbVariables x nbVariables), for the active bound of each variable
+    const RowMajorMatrixXd& getBoundSensitivity() const {return m_sensitivity.getBoundSensitivity();}
+    /// dlambda/d(bounds of the rows of [A; Aeq]) (nbVariables x nbConstraints), for the active side of each
+    /// row (e.g. deltaMax or deltaMin of an actuator), with the id of the variable of each row
+    const RowMajorMatrixXd& getConstraintBoundSensitivity() const {return m_sensitivity.getConstraintSensitivity();}
+    const vector<int>& getConstraintSensitivityIds() const {return m_sensitivities.constraintsId;}
+
+    /// Model-predictive mode: with a horizon of more than one step, the steps with only actuators plan their
+    /// actuation over the horizon and apply its first step (see QPHorizonProblem). The equality and contact
+    /// rows keep the single-step resolution.
+    void setHorizon(const unsigned int& horizon, const double& variationWeight, const vector<SReal>& targetShifts);
+    const QPHorizonProblem& getHorizonProblem() const {return m_horizonProblem;}
+
+    /// When the effectors have several priority levels (see behavior::EffectorPriority), the problems without
+    /// contact are solved level by level (see QPPrioritizedProblem). With contacts, the rows of all the levels
+    /// are minimized together in the single QP.
+    const QPPrioritizedProblem& getPrioritizedProblem() const {return m_prioritizedProblem;}
+    /// Number of levels of the last resolution, 0 if it was not prioritized
+    unsigned int getNbPriorityLevels() const {return m_nbPriorityLevels;}
+
+    /// Warm-start state, to restart a process at its steady-state speed (see QPCheckpoint). The state is
+    /// restored at the next call to solve(): the active set cache (if enabled), the forces if the actuator
+    /// and equality rows are the same (the initialization from lambdaInit is then skipped), and the states
+    /// of the contacts found by the path name of their component and their persistent id (warmStartContacts).
+    void saveCheckpoint(QPCheckpoint& checkpoint) const;
+    void restoreCheckpoint(const QPCheckpoint& checkpoint);
 
 protected:
 
+    /// Buffers given to qpOASES that are not already stored in the QP system, sized once and only
+    /// reallocated when the number of variables or constraints grows, so that a steady-state step
+    /// does not allocate them again. The scratch of a call to solve() lives here for the same reason:
+    /// it is cleared, not freed, between two steps.
+    struct QPWorkspace{
+
+        vector<real_t> lambda;
+        QPAlignedBuffer<real_t> A; // [A; Aeq], only used when there are equality constraints
+        vector<real_t> bu;
+        vector<real_t> bl;
+        vector<real_t> slack;
+        vector<real_t> iterate; // Copy of lambda, for the best iterate of a stopped resolution
+
+        vector<unsigned int> variableIds; // Rows of W of the variables [actuators equality contacts]
+        vector<double> result; // size of dim
+        vector<double> dual; // size of nb constraints
+        vector<double> previousLambda; // Actuation of the previous step, for the horizon problem
+
+        // States of the contacts at the end of the last pivot algorithm, sorted by contact identity (see
+        // storeContactStates()). Refilled in place at each step with contacts.
+        typedef std::pair<QPContactId, ContactHandler*> ContactState;
+        vector<ContactState> contactStates;
+
+        vector<int> constraintRanks; // by variable id, to match the rows of the pivot working sets
+
+        int maxNbVariables{0};
+        int maxNbConstraints{0};
+        unsigned int nbAllocations{0}; // Number of times the buffers had to grow
+
+        void reserve(const int nbVariables, const int nbConstraints);
+    };
+
     ConstraintHandler* m_constraintHandler;
     ConstraintHandler::QPConstraintParams* m_qpCParams;
+    QPWorkspace m_workspace;
+
+    // Scratch used to assemble Q and c from the compliance matrix
+    RowMajorMatrixXd m_Wea; // W(effectors, [actuators equality contacts])
+    Eigen::VectorXd m_dFreeEffectors;
+    Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> m_effectorWeightSolver; // Factors the weight blocks of the effectors
+    Eigen::MatrixXd m_effectorWeightFactor;
+    vector<QPRowBlock> m_variableColumnBlocks; // Blocks of consecutive columns of W read in Wea
+    vector<char> m_inactiveEffectorRows; // Disabled or in their deadband, empty if none, see updateInactiveEffectorRows()
+    vector<QPRowBlock> m_activeEffectorSpans; // Spans of the other rows (first in effectorRowIds, offset in Wea)
+    unsigned int m_nbDeadbandEffectors{0}; // At the last assembly of Q and c
+    QPPermutedCompliance m_permutedCompliance; // W(x, x), gathered once per resolution
+    bool m_isPermutedComplianceKept{false};    // Within solve(), see updatePermutedCompliance()
+    bool m_condensedEffectors{false}; // Wea only holds a chunk of the effector rows, see setCondensedEffectors()
+    unsigned int m_effectorSketchSize{0}; // See setEffectorSketch()
+    RowMajorMatrixXd m_sketchedWea; // S*Wea
+    Eigen::VectorXd m_sketchedDFree; // S*dfree_e
+    enum class QPEnergyApproximation {Full, BlockDiagonal, Diagonal};
+    QPEnergyApproximation m_energyApproximation{QPEnergyApproximation::Full};
+    /// First variable of the energy block of the variable k, see setEnergyApproximation()
+    unsigned int getEnergyBlockFirst(const unsigned int& k) const;
+    static constexpr unsigned int s_condensedChunkSize{64};
+    vector<double> m_QRowSums;
+    qpOASES::HessianType m_hessianType{qpOASES::HST_UNKNOWN}; // Known type of Q, given to qpOASES
+
+    /// Q of the last assembly, with the data it was computed from: the blocks Wea and W_energy of W
+    /// and the energy parameters. W is only compared, entry by entry, with these copies.
+    struct QPHessianCache{
+        bool enabled{false};
+        bool isValid{false};
+
+        RowMajorMatrixXd Wea;
+        RowMajorMatrixXd WEnergy;
+        double epsilon{0.};
+        double epsilonScale{1.};
+        vector<double> epsilons; // Epsilon of the diagonal term of each variable of W_energy
+
+        vector<double> Q;
+        qpOASES::HessianType hessianType{qpOASES::HST_UNKNOWN};
+        unsigned int nbReuses{0};
+
+        void clear();
+    };
+    QPHessianCache m_hessianCache;
 
     // Utils to prevent cycling in pivot algorithm
-    vector<int>   m_currentSequence;
-    vector<int>   m_previousSequence;
-    vector<int>   m_sequence;
+    QPPivotSequence m_currentSequence;
+    QPPivotSequence m_previousSequence;
+    QPPivotSequence m_sequence;
+    unsigned int  m_nbPivotCycles{0};
+
+    // Speculative pivots, see setSpeculativePivots()
+    QPSpeculativePivots m_speculativePivots;
+    vector<std::pair<double, int>> m_speculativeRows; // (dual, contact row) of the candidates of the iteration
+    vector<int> m_speculativeContacts;                // contact rows solved ahead, a row per contact
+    vector<QPContactStates::State> m_speculativeStates;  // state of the contact after each pivot
+    vector<ContactHandler*> m_speculativeHandlers;       // states of the iteration
+    vector<int> m_speculativeBoundaries;
+    unsigned int m_nbSpeculativePivots{0};
+    int selectSpeculativePivot(const vector<double>& result, const int& bestCandidate);
 
     int m_iteration{0};
     int m_step{0};
 
+    // Block pivoting, the number of candidates is allowed to not decrease s_maxBlockTrials times
+    bool m_blockPivoting{false};
+    int m_blockBestNbCandidates{0};
+    int m_blockNbTrials{0};
+    static constexpr int s_maxBlockTrials{3};
+    vector<unsigned int> m_pivotsPerIteration;
+    vector<double> m_contactDeltas; // of the contact rows, see computeContactDeltas()
+    QPContactStates m_contactStates; // enums of QPConstraintParams::contactStates, see gatherContactStates()
+    vector<int> m_contactCandidates; // candidate rows of each contact at the last check of the pivots
+    QPConstraintResiduals m_constraintResiduals; // of the last isFeasible()
+    unsigned int m_nbSinglePivotFallbacks{0};
+
+    // Persistent QP used in hot start mode, kept alive while the layout (number of variables
+    // and constraints) of the problem does not change
+    bool m_hotStart{false};
+    qpOASES::SQProblem* m_hotStartProblem{nullptr};
+    int m_hotStartNbVariables{0};
+    int m_hotStartNbConstraints{0};
+    qpOASES::HessianType m_hotStartHessianType{qpOASES::HST_UNKNOWN};
+    unsigned int m_nbHotStartHits{0};
+    unsigned int m_nbHotStartMisses{0};
+
+    // QP of the cold resolutions, kept alive across the pivots and the steps while the layout of the problem
+    // does not change, and reset before each initialization (see resetQProblem())
+    qpOASES::QProblem* m_coldProblem{nullptr};
+    int m_coldNbVariables{0};
+    int m_coldNbConstraints{0};
+    unsigned int m_nbBoundedResolutions{0};
+
+    // Persistent QP of the steps without contact, with the structure it was set up for. Q and A are
+    // copied, qpOASES only keeps pointers on them and uses them again when only the vectors change.
+    struct QPContactFreeProblem{
+        bool enabled{false};
+        qpOASES::SQProblem* problem{nullptr};
+        int nbVariables{0};
+        int nbConstraints{0};
+        qpOASES::HessianType hessianType{qpOASES::HST_UNKNOWN};
+        vector<unsigned int> actuatorRowIds;
+        vector<unsigned int> equalityRowIds;
+        vector<real_t> Q;
+        vector<real_t> A;
+        unsigned int nbHotStarts{0};
+        unsigned int nbFactorizationReuses{0};
+
+        void clear();
+    };
+    QPContactFreeProblem m_contactFree;
+
+    // Persistent QP of the parametric mode, with the Q and A it was initialized with and their norms
+    struct QPParametricProblem{
+        bool enabled{false};
+        double threshold{0.01};
+        qpOASES::SQProblem* problem{nullptr};
+        int nbVariables{0};
+        int nbConstraints{0};
+        qpOASES::HessianType hessianType{qpOASES::HST_UNKNOWN};
+        vector<int> constraintsId;
+        vector<real_t> Q;
+        vector<real_t> A;
+        double QNorm{0.};
+        double ANorm{0.};
+        unsigned int nbHotStarts{0};
+        unsigned int nbFactorizations{0};
+
+        void clear();
+    };
+    QPParametricProblem m_parametric;
+    int m_nbQPIterations{0};
+
+    // Limits of the pivot loop and of the working set changes of a QP
+    QPAdaptiveLimit m_pivotLimit{100, 10};
+    QPAdaptiveLimit m_workingSetLimit{500, 50};
+    QPAdaptiveEpsilon m_adaptiveEpsilon;
+    int_t m_nWSRLimit{500}; // Limit of the QP being solved
+    int m_maxNbWorkingSetChanges{0};
+    bool m_workingSetLimitHit{false};
+    unsigned int m_nbWorkingSetLimitHits{0};
+    void addWorkingSetChanges(const int_t& nWSR);
+
+    // Recovery of the infeasible QPs
+    bool m_softRecovery{false};
+    QPRecovery m_recovery{QPRecovery::None};
+    static constexpr double s_softConstraintPenalty{1e4}; // Relative to the largest diagonal entry of Q
+    void setRecovery(const QPRecovery& recovery);
+
+    // Working set of the last QP of the contact pivot loop, used to warm start the next pivot.
+    // Consecutive pivots only differ by a few constraint rows, a row is matched with the previous
+    // pivot by the variable it corresponds to (QPConstraintParams::constraintsId) and its rank
+    // among the rows of this variable. The status of the rows are grouped by variable id, in rank
+    // order: the rows of the variable id are constraints[constraintOffsets[id], constraintOffsets[id+1]).
+    struct QPPivotWorkingSet{
+        bool enabled{false};
+        bool valid{false};
+        bool isPrimalWarmStart{false}; // x from the contact LCP, bounds from the previous step if not empty
+        vector<real_t> x;
+        vector<qpOASES::SubjectToStatus> bounds;
+        vector<unsigned int> constraintOffsets;
+        vector<qpOASES::SubjectToStatus> constraints;
+
+        /// Status of the row of the given rank among the rows of the variable id, inactive if it was not stored
+        qpOASES::SubjectToStatus getConstraintStatus(const int& id, const int& rank) const;
+
+        /// Adds the status of the next row of the variable id, the ids being given in increasing order
+        void appendConstraintStatus(const int& id, const qpOASES::SubjectToStatus& status);
+
+        void clear() {valid = false; isPrimalWarmStart = false; x.clear(); bounds.clear(); constraintOffsets.clear(); constraints.clear();}
+    };
+    QPPivotWorkingSet m_pivotWorkingSet;
+    unsigned int m_nbPivotWarmStarts{0};
+
+    // Working set of the last QP of the previous step, see setPrimalWarmStart()
+    bool m_primalWarmStart{false};
+    QPPivotWorkingSet m_previousStepWorkingSet;
+    unsigned int m_nbPrimalWarmStarts{0};
+    void seedPivotWorkingSet(const vector<double>& result);
+
+    // The states of the contacts at the end of the last pivot algorithm are in m_workspace.contactStates
+    bool m_warmStartContacts{false};
+    unsigned int m_nbWarmStartedContacts{0};
+    void setPreviousContactState(const QPContactId& id, ContactHandler* state);
+
+    // Identity of the contacts without persistent id, and forces of the contacts at the end of the last
+    // resolution by contact identity, see setTrackContacts()
+    bool m_trackContacts{false};
+    QPContactTracker m_contactTracker;
+    std::map<QPContactId, unsigned int> m_previousContactForceIds; // Offset of the forces in m_previousContactForces
+    vector<double> m_previousContactForces;
+
+    // State read from a checkpoint, until the next call to solve() applies it
+    struct QPRestoredState{
+        vector<unsigned int> actuatorRowIds;
+        vector<unsigned int> equalityRowIds;
+        vector<double> lambda;
+        std::map<std::pair<std::string,int>, std::string> contactStates; // by path name of the component and contact id
+        vector<int> activeBounds;
+        QPActiveSetCache::EntryList activeSets;
+        bool isPending{false}; // lambda and the active sets are not applied yet
+
+        void clear();
+    };
+    QPRestoredState m_restoredState;
+    void applyRestoredState();
+    void applyRestoredContactStates();
+
+    // Outcome of the pivot algorithm by starting configuration
+    QPActiveSetCache m_activeSetCache;
+    QPActiveSetCache::Key m_activeSetKey; // Starting configuration of the current step
+    vector<int> m_activeBounds; // Bounds active at the end of the previous step
+    unsigned int m_nbActiveSetCacheHits{0};
+    unsigned int m_nbActiveSetCacheMisses{0};
+    bool restoreActiveSet();
+    void storeActiveSet();
 
+    // Alternative QP solver, nullptr for the built-in qpOASES resolution
+    QPSolverBackend* m_qpBackend{nullptr};
+    bool m_isBackendAdaptive{false};
+    QPBackendSelector m_backendSelector;
+    QPSolverBackend* m_admmBackend{nullptr}; // ADMM of the adaptive QP solver
+    unsigned int m_nbBackendSelections[QPBackendSelector::NbBackends]{};
+    const QPBackendSelector::Decision& selectBackend(const real_t* A, const int& nbVariables, const int& nbConstraints);
+    bool m_structuredFactorization{false};
+    bool m_multithreading{false};
+    bool m_smallProblemKernel{false};
+    QPSmallProblem m_smallProblem;
+    unsigned int m_nbSmallProblemSolves{0};
+    bool m_interiorFastPath{false};
+    Eigen::LDLT<Eigen::MatrixXd> m_interiorFactorization; // Of Q, kept for its buffers
+    Eigen::VectorXd m_interiorSolution;
+    Eigen::VectorXd m_interiorProducts; // A*x
+    unsigned int m_nbInteriorSolves{0};
+    QPMessageQueue* m_messageQueue{nullptr};
+    QPMatrixFreeSolver::Operator* m_complianceOperator{nullptr};
+    QPMatrixFreeSolver m_matrixFreeSolver;
+    vector<double> m_matrixFreeProduct; // W*lambda on all the rows
+    unsigned int m_nbComplianceProducts{0};
+    QPHessianBackend* m_hessianBackend{nullptr}; // nullptr for the CPU, which uses m_cpuHessianBackend
+    QPCPUHessianBackend m_cpuHessianBackend;
+    std::string m_hessianBackendName{"CPU"}; // as selected, even if unavailable
+
+    // Contact LCP solvers and their buffers, kept across steps
+    NLCPSolver* m_nlcpSolver{nullptr};
+    LCPQPSolver* m_lcpSolver{nullptr};
+    LCPPGSSolver* m_pgsSolver{nullptr};
+    bool m_usePGSSolver{false};
+    sofa::linearalgebra::FullVector<double> m_contactQ;
+    sofa::linearalgebra::FullVector<double> m_contactForces;
+    sofa::linearalgebra::LPtrFullMatrix<double> m_contactM;
+    bool m_sparseContacts{false};
+    QPSparseMatrices m_sparseMatrices;
+    bool m_hasSolvedNLCP{false};
+    LCPSparseMatrix m_contactSparseM;
+
+    // Merge of the redundant contacts
+    bool m_reduceContacts{false};
+    QPContactReduction m_contactReduction;
+
+    // Coarse-to-fine resolution of the contact patches
+    bool m_multilevelContacts{false};
+    QPContactPatches m_contactPatches;
+
+    // Forward resolution of the problems whose actuation is imposed
+    bool m_forwardWithoutEffectors{false};
+    unsigned int m_nbForwardSolves{0};
+    vector<double> m_imposedActuation;
+    bool getImposedActuation(vector<double>& lambdas);
+
+    // Contacts whose force is imposed
+    vector<unsigned int> m_imposedContactRows;
+    vector<double> m_imposedContactForces;
+    vector<double> m_imposedContactDeltas;
+    vector<char> m_isImposedContactRow;
+    vector<unsigned int> m_allContactRowIds;
+    vector<QPContactId> m_allContactIds;
+    vector<double> m_dfreeWithoutImposedForces;
+    void imposeContactForces();
+    void releaseContactForces();
+
+    // Removal of the rows that do not constrain the QP
+    bool m_presolve{false};
+    QPPresolve m_presolveStage;
+    unsigned int m_nbPresolvedRows{0};
+    void presolveConstraints();
+
+    // Equilibration of the QP given to the solver
+    bool m_scale{false};
+    QPScaling m_scaling;
+
+    // Elimination of the equality constraints, m_qpSystem is the reduced QP between begin and end
+    bool m_eliminateEqualities{false};
+    QPEqualityElimination m_equalityElimination;
+    QPSystem* m_fullQPSystem{nullptr};
+    bool m_reducedQPInfeasible{false};
+    unsigned int m_nbEqualityEliminations{0};
+    bool beginEqualityElimination();
+    void endEqualityElimination(const bool& solved, double& objective, real_t* lambda, real_t* slack);
+
+    // Real-time deadline
+    double m_timeBudget{0.};
+    sofa::helper::system::thread::ctime_t m_solveStartTime{0};
+    bool m_deadlineHit{false};
+    unsigned int m_nbDeadlineHits{0};
+    static constexpr double s_contactBudgetRatio{0.25};
+
+    bool m_computeTimings{false};
+    QPPhaseTimes m_phaseTimes;
+    sofa::helper::system::thread::ctime_t startTimer() const;
+    void stopTimer(const sofa::helper::system::thread::ctime_t& start, double& time) const;
+
+    QPTrace* m_trace{nullptr};
+    QPTrace::ctime_t beginSpan() const {return (m_trace)? m_trace->begin() : 0;}
+    void endSpan(const QPTrace::NameId& name, const QPTrace::ctime_t& start, std::initializer_list<QPTrace::Arg> args = {}) const
+    {
+        if(m_trace)
+            m_trace->end(name, start, args);
+    }
+
+    bool m_attributeCosts{false};
+    QPCostAttribution m_costAttribution;
+
+    bool m_productionMode{false};
+    int m_checkedNbVariables{-1}; // layout of the last checked solution, see isLayoutChecked()
+    int m_checkedNbConstraints{-1};
+    bool isLayoutChecked();
+
+    bool m_exportDuals{false};
+    struct QPDuals{
+        vector<double> bounds;
+        vector<double> constraints;
+        vector<int> constraintsId;
+        vector<double> actuatorBounds;
+        vector<int> actuatorLimits;
+
+        void clear();
+    };
+    QPDuals m_duals;
+    void updateActuatorLimits();
+
+    bool m_computeSensitivities{false};
+    struct QPSensitivities{
+        bool isPending{false}; // The dual of the last QP is kept, see solveInverseProblem()
+        vector<double> dual;
+        vector<int> constraintsId;
+        vector<unsigned int> rows;
+        RowMajorMatrixXd effectorRows; // S Wea, dc/d(dfree_e) = Wea^T S
+        RowMajorMatrixXd dfree;
+        RowMajorMatrixXd targets;
+
+        void clear();
+    };
+    QPSensitivity m_sensitivity;
+    QPSensitivities m_sensitivities;
+    void updateSensitivities();
+    int getWRowSign(const unsigned int& constraintRow, const unsigned int& row) const;
+
+    QPHorizonProblem m_horizonProblem;
+    RowMajorMatrixXd m_Waa;
+    Eigen::VectorXd m_dFreeActuators;
+    bool solveHorizonProblem(double& objective, vector<double>& result);
+
+    QPPrioritizedProblem m_prioritizedProblem;
+    Eigen::MatrixXd m_energyHessian; // Q - Wea^T Wea
+    unsigned int m_nbPriorityLevels{0};
+    bool solvePrioritizedProblem(double& objective, vector<double>& result);
+
+
+    const vector<unsigned int>& updateVariableIds();
+    /// Block W(x, x) for the variables x of updateVariableIds(), read by the kernels of the resolution
+    const QPPermutedCompliance& updatePermutedCompliance();
     void computeEnergyWeight(double& weight);
+    void updateEnergyWeight(const unsigned int& energyDim, double& weight);
     void buildQPMatrices();
+    /// Copies the effector rows [first, first+nbRows) of W and dfree in the rows of Wea and dfree_e from offset,
+    /// sized beforehand, with the inactive rows zeroed and the weights applied
+    void gatherEffectorRows(const unsigned int& first, const unsigned int& nbRows, const unsigned int& offset = 0);
+    /// Fills the inactive effector rows (disabled, or in their deadband at this step) and the spans of the others
+    void updateInactiveEffectorRows();
+    void condenseEffectors(const unsigned int& dimQ);
+    /// Gathers the chunk of effector rows from first in Wea, extended to the end of the weight block it
+    /// ends in (block is the next weight block to look at), and returns the end of the chunk
+    unsigned int gatherEffectorChunk(const unsigned int& first, unsigned int& block, const unsigned int& dimQ);
+    void sketchEffectors(const unsigned int& dimQ);
+    static uint64_t getSketchHash(const unsigned int& row);
+    /// Replaces each weighted block of rows of Wea and dfree_e by F^T*rows, where S = F*F^T is the block
+    /// of the weights, so that Q = Wea^T*S*Wea and c = Wea^T*S*dfree_e are assembled as without weights.
+    /// Wea holds the effector rows [firstRow, firstRow+nbRows) from its row offset, only the blocks within are applied.
+    void applyEffectorWeights(const unsigned int& firstRow, const unsigned int& nbRows, const unsigned int& offset = 0);
+    /// dfree_e^T*S*dfree_e, the constant term of the objective, without the disabled effectors
+    double getEffectorsFreeObjective() const;
+    /// d_e^T*S*d_e for the given deltas d of the rows, the constant term above being the one of dfree
+    double getEffectorsObjective(const double* delta) const;
+    bool reuseHessian(const unsigned int& energyDim);
+    void storeHessian(const unsigned int& energyDim);
 
 
+    /// Resolution of the problem with the contact rows currently in the lists, a level of solve()
+    void solveLevel(double& objective, int& iterations);
+    /// Resolution with the compliance operator, see setComplianceOperator()
+    void solveMatrixFree(double& objective, int& iterations);
+    /// Restores the contacts merged by the reduction in the lists, with their forces in lambda
+    void restoreContacts(const QPContactReduction& reduction);
+
     void solveWithContact(vector<double>& result, double &objective, int &iterations);
-    void solveContacts(vector<double>& res);
+    void setContactParams();
+    /// The first nbFixedRows QP variables (actuators then equality) keep their lambda
+    void solveContacts(vector<double>& res, const unsigned int& nbFixedRows);
     void solveInverseProblem(double &objective,
                              vector<double> &result,
                              vector<double> &dual);
 
-    void updateOASESMatrices(real_t * Q, real_t * c, real_t * l, real_t * u,
-                             real_t * A, real_t * bl, real_t * bu);
+    /// Resolution of the QP of m_qpSystem into lambda and slack, returns false if the reduced QP of the
+    /// equality elimination is infeasible
+    bool solveQP(double& objective, const vector<double>& result, real_t* lambda, real_t* slack);
+
+    /// Messages of the resolution, of the rate limited key, see setMessageQueue()
+    QPMessageQueue::Stream infoMessage(const char* key) {return QPMessageQueue::Stream(m_messageQueue, QPMessageQueue::Info, "QPInverseProblemImpl", key);}
+    QPMessageQueue::Stream warningMessage(const char* key) {return QPMessageQueue::Stream(m_messageQueue, QPMessageQueue::Warning, "QPInverseProblemImpl", key);}
+    QPMessageQueue::Stream errorMessage(const char* key) {return QPMessageQueue::Stream(m_messageQueue, QPMessageQueue::Error, "QPInverseProblemImpl", key);}
+    /// Unconstrained minimizer of the QP, see setInteriorFastPath(). Returns false, without writing lambda
+    /// and slack, if Q is not positive definite or if a bound or a constraint is not strictly satisfied.
+    bool solveInteriorProblem(const real_t* Q, const real_t* c, const real_t* l, const real_t* u,
+                              const real_t* A, const real_t* bl, const real_t* bu,
+                              real_t* lambda, real_t* slack, double& objective);
+
+    void updateOASESMatrices(real_t *& Q, real_t *& c, real_t *& l, real_t *& u,
+                             real_t *& A, real_t * bl, real_t * bu);
 
     void updateLambda(const vector<double>& x);
     bool isFeasible(const vector<double>& x);
 
     bool checkAndUpdatePivot(const vector<double>&result, const vector<double>&dual);
+    void updateContactState(const vector<double>& result, const unsigned int& contactId);
+    void warmStartContactStates();
+    void storeContactStates();
+    void initContactForces(sofa::linearalgebra::FullVector<double>& x, const unsigned int& nbFixedRows) const;
+    void storeContactForces();
     bool isCycling(const int pivot);
-    double getDelta(const vector<double> &result, const int& index);
-    bool isIn(const vector<int> list, const int elem);
+    void computeContactDeltas(const vector<double>& result);
+    void gatherContactStates();
+    bool isIn(const vector<int>& list, const int elem);
     std::string getContactsState();
 
 
+    void solveWithQPOASES(double& objective, const vector<double>& result,
+                          real_t * Q, real_t * c, real_t * l, real_t * u,
+                          real_t * A, real_t * bl, real_t * bu,
+                          real_t * lambda, real_t * slack);
+
+    bool solveWithHotStart(real_t * Q, real_t * c, real_t * l, real_t * u,
+                           real_t * A, real_t * bl, real_t * bu, int_t& nWSR);
+    void deleteHotStartProblem();
+
+    bool solveWithContactFreeProblem(real_t * Q, real_t * c, real_t * l, real_t * u,
+                                     real_t * A, real_t * bl, real_t * bu, int_t& nWSR);
+    bool solveWithParametricProblem(real_t * Q, real_t * c, real_t * l, real_t * u,
+                                    real_t * A, real_t * bl, real_t * bu, int_t& nWSR);
+
+    bool solveWithSoftConstraints(double& objective,
+                                  real_t * Q, real_t * c, real_t * l, real_t * u,
+                                  real_t * A, real_t * bl, real_t * bu,
+                                  real_t * lambda, real_t * slack);
+
+    /// Initializes the problem with the compressed matrices if they are used, with Q and A otherwise
+    qpOASES::returnValue initQProblem(qpOASES::QProblem& problem,
+                                      real_t * Q, real_t * c, real_t * l, real_t * u,
+                                      real_t * A, real_t * bl, real_t * bu, int_t& nWSR, real_t* cputime,
+                                      const real_t* x = nullptr, const qpOASES::Bounds* guessedBounds = nullptr,
+                                      const qpOASES::Constraints* guessedConstraints = nullptr);
+
+    bool initWithPivotWorkingSet(qpOASES::QProblem& problem,
+                                 real_t * Q, real_t * c, real_t * l, real_t * u,
+                                 real_t * A, real_t * bl, real_t * bu, int_t& nWSR);
+    void storePivotWorkingSet(qpOASES::QProblemB* problem);
+
+    bool solveBoundedProblem(qpOASES::QProblemB& problem,
+                             real_t * Q, real_t * c, real_t * l, real_t * u, int_t& nWSR);
+
+    /// Cumulated counters of a qpOASES problem, read before a call to attribute its part to the statistics
+    struct QPOASESCounters{
+        qpOASES::uint_t nbFlips{0};
+        qpOASES::uint_t nbRampings{0};
+        qpOASES::uint_t nbFactorizations{0};
+        qpOASES::uint_t nbUpdates{0};
+    };
+    QPOASESStatistics m_qpOASESStatistics;
+    static QPOASESCounters getQPOASESCounters(const qpOASES::QProblemB& problem);
+    void addQPOASESStatistics(const qpOASES::QProblemB& problem, const QPOASESCounters& start, const int_t& nWSR);
+
+    double getRemainingTime(const double& budgetRatio = 1.) const;
+    bool isDeadlineReached() const;
+    real_t* getCPUTimeLimit(real_t& cputime) const;
+    bool isStoppedByTimeBudget(const qpOASES::QProblemB& problem, const int_t& nWSR) const;
+    bool isStoppedByWorkingSetLimit(const qpOASES::QProblemB& problem, const int_t& nWSR) const;
+    void useBestIterate(const vector<double>& result, const real_t* iterate,
+                        real_t * Q, real_t * c, real_t * l, real_t * u,
+                        real_t * lambda, real_t * slack, double& objective);
+
 private:
-    qpOASES::QProblem getNewQProblem(int &nWSR);
+    /// QP of the cold resolutions, ready to be initialized (nWSR set to its limit)
+    qpOASES::QProblem& resetQProblem(int &nWSR);
+    void deleteColdProblem();
 
 };
 
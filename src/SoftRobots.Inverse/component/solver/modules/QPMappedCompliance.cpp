@@ -0,0 +1,247 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <random>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <SoftRobots.Inverse/component/solver/modules/QPMappedCompliance.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+using sofa::linearalgebra::BaseMatrix;
+
+const char QPMappedCompliance::s_magic[8] = {'S','R','I','Q','P','W','M','F'};
+
+namespace
+{
+
+constexpr size_t s_headerSize = 8 + 2*sizeof(uint32_t) + 3*sizeof(uint64_t); // W is 8-byte aligned
+constexpr size_t s_checksumOffset = 8 + 2*sizeof(uint32_t) + 2*sizeof(uint64_t);
+
+/// Creates a temporary file next to filename, with a name unique to the call so that the processes
+/// writing the same file at once do not write into each other's. Returns an empty string on failure.
+std::string createTemporaryFile(const std::string& filename)
+{
+#if defined(__unix__) || defined(__APPLE__)
+    std::string temporaryFilename = filename + ".XXXXXX";
+    const int file = mkstemp(&temporaryFilename[0]);
+    if(file < 0)
+        return std::string();
+    fchmod(file, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH); // mkstemp restricts it to the owner
+    close(file);
+    return temporaryFilename;
+#else
+    std::random_device device;
+    for(unsigned int attempt=0; attempt<16; attempt++)
+    {
+        const std::string temporaryFilename = filename + "." + std::to_string(device()) + ".tmp";
+        if(!std::ifstream(temporaryFilename).is_open())
+            return temporaryFilename;
+    }
+    return std::string();
+#endif
+}
+
+} // namespace
+
+
+QPMappedCompliance::~QPMappedCompliance()
+{
+    unmap();
+}
+
+
+bool QPMappedCompliance::map(const std::string& filename)
+{
+    unmap();
+
+#if defined(__unix__) || defined(__APPLE__)
+    const int file = open(filename.c_str(), O_RDONLY);
+    if(file < 0)
+        return false;
+
+    struct stat status;
+    if(fstat(file, &status) == 0 && size_t(status.st_size) >= s_headerSize)
+    {
+        void* data = mmap(nullptr, status.st_size, PROT_READ, MAP_SHARED, file, 0);
+        if(data != MAP_FAILED)
+        {
+            m_data = static_cast<const char*>(data);
+            m_size = status.st_size;
+            m_isFileMapping = true;
+        }
+    }
+    close(file); // the mapping stays valid
+#else
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if(!file.is_open())
+        return false;
+
+    m_buffer.resize(size_t(file.tellg()));
+    file.seekg(0, std::ios::beg);
+    file.read(m_buffer.data(), m_buffer.size());
+    if(file.good() && m_buffer.size() >= s_headerSize)
+    {
+        m_data = m_buffer.data();
+        m_size = m_buffer.size();
+    }
+#endif
+
+    if(!m_data)
+        return false;
+
+    uint32_t version = 0;
+    uint64_t dim = 0, checksum = 0;
+    std::memcpy(&version, m_data + 8, sizeof(uint32_t));
+    std::memcpy(&m_key, m_data + 8 + 2*sizeof(uint32_t), sizeof(uint64_t));
+    std::memcpy(&dim, m_data + 8 + 2*sizeof(uint32_t) + sizeof(uint64_t), sizeof(uint64_t));
+    std::memcpy(&checksum, m_data + s_checksumOffset, sizeof(uint64_t));
+    // A truncated or partially written file is rejected by its size or its checksum
+    if(std::memcmp(m_data, s_magic, 8) != 0 || version != s_version
+            || dim > (m_size - s_headerSize)/sizeof(double) || s_headerSize + dim*dim*sizeof(double) != m_size
+            || hash(m_data + s_headerSize, m_size - s_headerSize) != checksum)
+    {
+        unmap();
+        return false;
+    }
+
+    m_dim = dim;
+    return true;
+}
+
+
+void QPMappedCompliance::unmap()
+{
+#if defined(__unix__) || defined(__APPLE__)
+    if(m_isFileMapping)
+        munmap(const_cast<char*>(m_data), m_size);
+#endif
+    m_data = nullptr;
+    m_size = 0;
+    m_isFileMapping = false;
+    m_buffer.clear();
+    m_key = 0;
+    m_dim = 0;
+}
+
+
+bool QPMappedCompliance::get(const uint64_t& key, BaseMatrix* W) const
+{
+    if(!m_data || key != m_key || W->rowSize() != Index(m_dim) || W->colSize() != Index(m_dim))
+        return false;
+
+    const char* values = m_data + s_headerSize;
+    double value;
+    for(unsigned int i=0; i<m_dim; i++)
+        for(unsigned int j=0; j<m_dim; j++)
+        {
+            std::memcpy(&value, values + (size_t(i)*m_dim + j)*sizeof(double), sizeof(double));
+            W->set(i, j, value);
+        }
+    return true;
+}
+
+
+bool QPMappedCompliance::write(const std::string& filename, const uint64_t& key, const BaseMatrix& W)
+{
+    const uint64_t dim = W.rowSize();
+    const std::string temporaryFilename = createTemporaryFile(filename);
+    if(temporaryFilename.empty())
+        return false;
+    {
+        std::ofstream file(temporaryFilename, std::ios::binary | std::ios::trunc);
+        if(!file.is_open())
+        {
+            std::remove(temporaryFilename.c_str());
+            return false;
+        }
+
+        const uint32_t version = s_version, reserved = 0;
+        uint64_t checksum = s_hashSeed;
+        file.write(s_magic, 8);
+        file.write(reinterpret_cast<const char*>(&version), sizeof(uint32_t));
+        file.write(reinterpret_cast<const char*>(&reserved), sizeof(uint32_t));
+        file.write(reinterpret_cast<const char*>(&key), sizeof(uint64_t));
+        file.write(reinterpret_cast<const char*>(&dim), sizeof(uint64_t));
+        file.write(reinterpret_cast<const char*>(&checksum), sizeof(uint64_t)); // set once W is written
+
+        sofa::type::vector<double> row(dim);
+        for(Index i=0; i<Index(dim); i++)
+        {
+            for(Index j=0; j<Index(dim); j++)
+                row[j] = W.element(i, j);
+            file.write(reinterpret_cast<const char*>(row.data()), dim*sizeof(double));
+            checksum = hash(row.data(), dim*sizeof(double), checksum);
+        }
+        file.seekp(s_checksumOffset);
+        file.write(reinterpret_cast<const char*>(&checksum), sizeof(uint64_t));
+        file.flush();
+        if(!file.good())
+        {
+            file.close();
+            std::remove(temporaryFilename.c_str());
+            return false;
+        }
+    }
+
+    // Replaces the previous file at once, the processes which mapped it keep their pages
+    if(std::rename(temporaryFilename.c_str(), filename.c_str()) != 0)
+    {
+        std::remove(filename.c_str());
+        if(std::rename(temporaryFilename.c_str(), filename.c_str()) != 0)
+        {
+            std::remove(temporaryFilename.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+
+uint64_t QPMappedCompliance::hash(const void* data, const size_t& size, const uint64_t& seed)
+{
+    uint64_t hash = seed;
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for(size_t i=0; i<size; i++)
+        hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+    return hash;
+}
+
+} // namespace
@@ -0,0 +1,95 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <sofa/linearalgebra/BaseMatrix.h>
+#include <sofa/type/vector.h>
+
+#include <SoftRobots.Inverse/component/config.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+/// Compliance matrix W of the first step of a scene without contacts (actuators, effectors, sensors),
+/// at its rest configuration, stored in a file mapped read-only in memory. The processes starting the
+/// same scene on a host share the pages of the file instead of each computing the compliance at their
+/// first step. The file is keyed by a hash of the scene (see hash()): a file written for another scene is
+/// ignored, and replaced once the compliance is computed.
+///
+/// File format (binary, byte order of the machine): magic "SRIQPWMF", version, reserved, key, dim, checksum
+/// (hash() of W), then W (dim*dim doubles, row-major). The file is written to a temporary file unique to the
+/// writer and renamed into place, so that the processes which mapped the previous file keep reading it. On
+/// the platforms without mmap, the file is read in memory.
+class SOFA_SOFTROBOTS_INVERSE_API QPMappedCompliance
+{
+public:
+    typedef sofa::linearalgebra::BaseMatrix::Index Index;
+
+    QPMappedCompliance() {}
+    ~QPMappedCompliance();
+    QPMappedCompliance(const QPMappedCompliance&) = delete;
+    QPMappedCompliance& operator=(const QPMappedCompliance&) = delete;
+
+    /// Maps the file read-only. Returns false if it does not exist or is not a valid file, or if W does not
+    /// match its checksum.
+    bool map(const std::string& filename);
+    void unmap();
+    bool isMapped() const {return m_data != nullptr;}
+
+    uint64_t getKey() const {return m_key;}
+    unsigned int getDim() const {return m_dim;}
+
+    /// Sets the compliance of the file in W. Returns false, leaving W unchanged, if the key or the size of
+    /// W does not match the file.
+    bool get(const uint64_t& key, sofa::linearalgebra::BaseMatrix* W) const;
+
+    static bool write(const std::string& filename, const uint64_t& key, const sofa::linearalgebra::BaseMatrix& W);
+
+    /// FNV-1a hash, chained over the data identifying the scene to build the key
+    static uint64_t hash(const void* data, const size_t& size, const uint64_t& seed = s_hashSeed);
+
+    static const char s_magic[8];
+    static constexpr uint32_t s_version{2};
+    static constexpr uint64_t s_hashSeed{0xcbf29ce484222325ULL};
+
+protected:
+    const char* m_data{nullptr};
+    size_t m_size{0};
+    bool m_isFileMapping{false}; // false when the file is read in m_buffer
+    sofa::type::vector<char> m_buffer;
+    uint64_t m_key{0};
+    unsigned int m_dim{0};
+};
+
+} // namespace
@@ -0,0 +1,373 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <SoftRobots.Inverse/component/solver/modules/QPMatrixFreeSolver.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+using Eigen::VectorXd;
+using Eigen::Infinity;
+
+namespace
+{
+    const double s_infinity = std::numeric_limits<double>::infinity();
+    const double s_rhoMin = 1e-6;
+    const double s_rhoMax = 1e6;
+    const double s_cgTolerance = 1e-8; // relative to the right-hand side
+
+    double toBound(const double& bound)
+    {
+        if(bound >= 1e20) return s_infinity;
+        if(bound <= -1e20) return -s_infinity;
+        return bound;
+    }
+}
+
+
+bool QPMatrixFreeSolver::isSupported(const QPInverseProblem::QPConstraintLists& lists, const bool& actuatorsOnly)
+{
+    if(!lists.contactRowIds.empty() || !lists.effectorWeightBlocks.empty() || !lists.effectorRowLevels.empty())
+        return false;
+    if(actuatorsOnly && !lists.equalityRowIds.empty())
+        return false;
+    return std::none_of(lists.variableRows.begin(), lists.variableRows.end(),
+                        [](const QPInverseProblem::QPVariableRow& row){return row.hasEpsilon;});
+}
+
+
+void QPMatrixFreeSolver::clear()
+{
+    m_x.resize(0);
+    m_z.resize(0);
+    m_y.resize(0);
+}
+
+
+bool QPMatrixFreeSolver::solve(Operator& W, const QPInverseProblem::QPConstraintLists& lists,
+                               const double* dFree, const unsigned int& nbRows, const double& epsilon,
+                               vector<double>& x, vector<double>& Wx, double& objective)
+{
+    m_nbIterations = 0;
+    m_nbApplications = 0;
+    objective = 0.;
+    m_operator = &W;
+
+    const unsigned int nbActuators = lists.actuatorRowIds.size();
+    m_variableRows = lists.actuatorRowIds;
+    m_variableRows.insert(m_variableRows.end(), lists.equalityRowIds.begin(), lists.equalityRowIds.end());
+    const int nbVariables = m_variableRows.size();
+
+    m_effectorRows = lists.effectorRowIds;
+    const int nbEffectors = m_effectorRows.size();
+    m_effectorWeights.assign(nbEffectors, 1.);
+    m_dFreeEffectors.resize(nbEffectors);
+    for(int k=0; k<nbEffectors; k++)
+    {
+        if(!lists.disabledEffectorRows.empty() && lists.disabledEffectorRows[k])
+            m_effectorWeights[k] = 0.;
+        m_dFreeEffectors[k] = m_effectorWeights[k]*dFree[m_effectorRows[k]];
+    }
+
+    m_f.assign(nbRows, 0.);
+    m_d.assign(nbRows, 0.);
+    x.resize(nbVariables);
+    Wx.assign(nbRows, 0.);
+    if(nbVariables == 0)
+        return true;
+
+    // Bounds of lambda, then the displacement limits of the variables having one, as the rows of Wxx
+    vector<double> lower(nbVariables), upper(nbVariables);
+    vector<double> deltaLower, deltaUpper;
+    m_limitedVariables.clear();
+    for(int k=0; k<nbVariables; k++)
+    {
+        const QPInverseProblem::QPVariableRow& row = lists.variableRows[k];
+        const bool isActuator = (unsigned int)k < nbActuators;
+        lower[k] = (isActuator)? toBound(lists.actuatorBounds.lambdaMin[k]) : -s_infinity;
+        upper[k] = (isActuator)? toBound(lists.actuatorBounds.lambdaMax[k]) : s_infinity;
+        if(row.hasLambdaEqual && !row.isDisabled)
+            lower[k] = upper[k] = row.lambdaEqual;
+
+        double dmin = (isActuator)? toBound(lists.actuatorBounds.deltaMin[k]) : -s_infinity;
+        double dmax = (isActuator)? toBound(lists.actuatorBounds.deltaMax[k]) : s_infinity;
+        if(row.hasDeltaEqual)
+            dmin = dmax = row.deltaEqual;
+        if(dmin > -s_infinity || dmax < s_infinity)
+        {
+            m_limitedVariables.push_back(k);
+            deltaLower.push_back(dmin - dFree[m_variableRows[k]]);
+            deltaUpper.push_back(dmax - dFree[m_variableRows[k]]);
+        }
+    }
+
+    const int nbLimited = m_limitedVariables.size();
+    const int nbConstraintRows = nbVariables + nbLimited;
+    m_l.resize(nbConstraintRows);
+    m_u.resize(nbConstraintRows);
+    m_rhoRows.resize(nbConstraintRows);
+    for(int i=0; i<nbConstraintRows; i++)
+    {
+        m_l[i] = (i<nbVariables)? lower[i] : deltaLower[i-nbVariables];
+        m_u[i] = (i<nbVariables)? upper[i] : deltaUpper[i-nbVariables];
+
+        // As in OSQP: stiffer equality rows, almost free unbounded rows
+        if(m_u[i] - m_l[i] < 1e-10)                               m_rhoRows[i] = 1e3*m_rho;
+        else if(m_l[i] == -s_infinity && m_u[i] == s_infinity)     m_rhoRows[i] = s_rhoMin;
+        else                                                       m_rhoRows[i] = m_rho;
+    }
+
+    // Warm start from the previous resolution when the layout did not change
+    if(m_x.size() != nbVariables || m_z.size() != nbConstraintRows)
+    {
+        m_x.setZero(nbVariables);
+        m_z.setZero(nbConstraintRows);
+        m_y.setZero(nbConstraintRows);
+    }
+
+    // Energy weight as ||Q||/||W_energy||, then g = Wex^T dfree_e
+    double normQ = 0., normW = 0.;
+    if(!estimateNorm(false, normQ) || !estimateNorm(true, normW))
+        return false;
+    m_energyWeight = (normW > 1e-14)? epsilon*normQ/normW : 0.;
+
+    if(!applyEffectorsAndLimits(m_dFreeEffectors, VectorXd::Zero(nbLimited)))
+        return false;
+    VectorXd g(nbVariables);
+    for(int k=0; k<nbVariables; k++)
+        g[k] = m_d[m_variableRows[k]];
+
+    VectorXd w(nbConstraintRows), rhs(nbVariables), xTilde(nbVariables), zTilde(nbConstraintRows), zRelaxed(nbConstraintRows);
+    VectorXd Cx(nbConstraintRows), Hx(nbVariables), Cty(nbVariables), We(nbEffectors), Ex(nbVariables);
+    bool converged = false;
+
+    for(int k=0; k<m_maxIterations && !converged; k++)
+    {
+        m_nbIterations++;
+
+        // (H + sigma*I + C^T*rho*C) xTilde = sigma*x - g + C^T*(rho*z - y)
+        w = m_rhoRows.cwiseProduct(m_z) - m_y;
+        rhs = m_sigma*m_x - g + w.head(nbVariables);
+        if(nbLimited > 0)
+        {
+            if(!applyEffectorsAndLimits(VectorXd::Zero(nbEffectors), w.tail(nbLimited)))
+                return false;
+            for(int i=0; i<nbVariables; i++)
+                rhs[i] += m_d[m_variableRows[i]];
+        }
+        xTilde = m_x;
+        if(!solveSystem(rhs, xTilde))
+            return false;
+
+        zTilde.head(nbVariables) = xTilde;
+        if(nbLimited > 0)
+        {
+            if(!applyVariables(xTilde))
+                return false;
+            for(int j=0; j<nbLimited; j++)
+                zTilde[nbVariables+j] = m_d[m_variableRows[m_limitedVariables[j]]];
+        }
+
+        m_x = m_alpha*xTilde + (1.-m_alpha)*m_x;
+        zRelaxed = m_alpha*zTilde + (1.-m_alpha)*m_z;
+        m_z = (zRelaxed + m_y.cwiseQuotient(m_rhoRows)).cwiseMax(m_l).cwiseMin(m_u);
+        m_y += m_rhoRows.cwiseProduct(zRelaxed - m_z);
+
+        if(k % m_checkInterval != 0 && k != m_maxIterations-1)
+            continue;
+
+        // Residuals, Hx = Wxe We + w Ex with We = Wex x and Ex = Wxx x, Cty = y_I + Wxg y_g
+        if(!applyVariables(m_x))
+            return false;
+        Cx.head(nbVariables) = m_x;
+        for(int j=0; j<nbLimited; j++)
+            Cx[nbVariables+j] = m_d[m_variableRows[m_limitedVariables[j]]];
+        for(int i=0; i<nbEffectors; i++)
+            We[i] = m_effectorWeights[i]*m_d[m_effectorRows[i]];
+        for(int i=0; i<nbVariables; i++)
+            Ex[i] = m_d[m_variableRows[i]];
+
+        if(!applyEffectorsAndLimits(We, VectorXd::Zero(nbLimited)))
+            return false;
+        for(int i=0; i<nbVariables; i++)
+            Hx[i] = m_d[m_variableRows[i]] + m_energyWeight*Ex[i];
+
+        Cty = m_y.head(nbVariables);
+        if(nbLimited > 0)
+        {
+            if(!applyEffectorsAndLimits(VectorXd::Zero(nbEffectors), m_y.tail(nbLimited)))
+                return false;
+            for(int i=0; i<nbVariables; i++)
+                Cty[i] += m_d[m_variableRows[i]];
+        }
+
+        double primalScale = std::max(Cx.lpNorm<Infinity>(), m_z.lpNorm<Infinity>());
+        double dualScale = std::max({Hx.lpNorm<Infinity>(), Cty.lpNorm<Infinity>(), g.lpNorm<Infinity>()});
+        double primalResidual = (Cx - m_z).lpNorm<Infinity>();
+        double dualResidual = (Hx + g + Cty).lpNorm<Infinity>();
+
+        converged = (primalResidual <= m_epsAbs + m_epsRel*primalScale &&
+                     dualResidual <= m_epsAbs + m_epsRel*dualScale);
+
+        // Balance the primal and dual residuals by adapting rho, without factorization to update
+        double ratio = std::sqrt((primalResidual/(primalScale+1e-10)) / (dualResidual/(dualScale+1e-10)+1e-10));
+        if(!converged && (ratio > 5. || ratio < 0.2))
+            for(int i=0; i<nbConstraintRows; i++)
+                m_rhoRows[i] = std::min(std::max(m_rhoRows[i]*ratio, s_rhoMin), s_rhoMax);
+    }
+
+    // Results: Wx = W*lambda on all the rows, objective = 1/2 x^T (Wxe Wex + w Wxx) x + dfree_e^T Wex x
+    if(!applyVariables(m_x))
+        return false;
+    std::copy(m_d.begin(), m_d.end(), Wx.begin());
+    for(int i=0; i<nbVariables; i++)
+    {
+        x[i] = m_x[i];
+        objective += 0.5*m_energyWeight*m_x[i]*m_d[m_variableRows[i]];
+    }
+    for(int i=0; i<nbEffectors; i++)
+    {
+        const double we = m_effectorWeights[i]*m_d[m_effectorRows[i]];
+        objective += 0.5*we*we + m_dFreeEffectors[i]*we;
+    }
+
+    return converged;
+}
+
+
+bool QPMatrixFreeSolver::applyVariables(const VectorXd& v)
+{
+    std::fill(m_f.begin(), m_f.end(), 0.);
+    for(unsigned int i=0; i<m_variableRows.size(); i++)
+        m_f[m_variableRows[i]] = v[i];
+    m_nbApplications++;
+    return m_operator->apply(m_f, m_d);
+}
+
+
+bool QPMatrixFreeSolver::applyEffectorsAndLimits(const VectorXd& a, const VectorXd& b)
+{
+    std::fill(m_f.begin(), m_f.end(), 0.);
+    for(unsigned int i=0; i<m_effectorRows.size(); i++)
+        m_f[m_effectorRows[i]] = a[i];
+    for(unsigned int j=0; j<m_limitedVariables.size(); j++)
+        m_f[m_variableRows[m_limitedVariables[j]]] = b[j];
+    m_nbApplications++;
+    return m_operator->apply(m_f, m_d);
+}
+
+
+bool QPMatrixFreeSolver::applySystem(const VectorXd& v, VectorXd& Kv)
+{
+    // First product for Wex v, Wgx v and Wxx v, second one for Wxe We + Wxg rho_g Wgx v
+    const int nbVariables = m_variableRows.size();
+    if(!applyVariables(v))
+        return false;
+
+    VectorXd We(m_effectorRows.size()), Wg(m_limitedVariables.size());
+    for(unsigned int i=0; i<m_effectorRows.size(); i++)
+        We[i] = m_effectorWeights[i]*m_d[m_effectorRows[i]];
+    for(unsigned int j=0; j<m_limitedVariables.size(); j++)
+        Wg[j] = m_rhoRows[nbVariables+j]*m_d[m_variableRows[m_limitedVariables[j]]];
+    Kv.resize(nbVariables);
+    for(int i=0; i<nbVariables; i++)
+        Kv[i] = m_energyWeight*m_d[m_variableRows[i]] + (m_sigma + m_rhoRows[i])*v[i];
+
+    if(!applyEffectorsAndLimits(We, Wg))
+        return false;
+    for(int i=0; i<nbVariables; i++)
+        Kv[i] += m_d[m_variableRows[i]];
+    return true;
+}
+
+
+bool QPMatrixFreeSolver::solveSystem(const VectorXd& b, VectorXd& x)
+{
+    // Conjugate gradient warm started from x, the system being symmetric positive definite
+    VectorXd Kp;
+    if(!applySystem(x, Kp))
+        return false;
+    VectorXd r = b - Kp;
+    VectorXd p = r;
+    double rr = r.squaredNorm();
+    const double tolerance = s_cgTolerance*s_cgTolerance*std::max(b.squaredNorm(), 1e-30);
+
+    for(int k=0; k<m_maxCGIterations && rr > tolerance; k++)
+    {
+        if(!applySystem(p, Kp))
+            return false;
+        const double pKp = p.dot(Kp);
+        if(pKp <= 0.)
+            break;
+        const double alpha = rr/pKp;
+        x += alpha*p;
+        r -= alpha*Kp;
+        const double rrNew = r.squaredNorm();
+        p = r + (rrNew/rr)*p;
+        rr = rrNew;
+    }
+    return true;
+}
+
+
+bool QPMatrixFreeSolver::estimateNorm(const bool& energy, double& norm)
+{
+    const int nbVariables = m_variableRows.size();
+    VectorXd v = VectorXd::Constant(nbVariables, 1./std::sqrt(double(nbVariables)));
+    VectorXd Av(nbVariables), We(m_effectorRows.size());
+    norm = 0.;
+
+    for(int k=0; k<m_nbPowerIterations; k++)
+    {
+        if(!applyVariables(v))
+            return false;
+        if(!energy)
+        {
+            for(unsigned int i=0; i<m_effectorRows.size(); i++)
+                We[i] = m_effectorWeights[i]*m_d[m_effectorRows[i]];
+            if(!applyEffectorsAndLimits(We, VectorXd::Zero(m_limitedVariables.size())))
+                return false;
+        }
+        for(int i=0; i<nbVariables; i++)
+            Av[i] = m_d[m_variableRows[i]];
+
+        norm = Av.norm();
+        if(norm < 1e-14)
+            return true;
+        v = Av/norm;
+    }
+    return true;
+}
+
+} // namespace
@@ -0,0 +1,133 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <Eigen/Core>
+#include <sofa/type/vector.h>
+
+#include <SoftRobots.Inverse/component/solver/modules/QPInverseProblem.h>
+#include <SoftRobots.Inverse/component/config.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+using sofa::type::vector;
+
+/// Inverse problem without contact solved without forming W, for the large problems (e.g. shape tracking with
+/// many effectors) where assembling the dim x dim compliance is the bottleneck. The solver only applies W to
+/// vectors of constraint forces, d = W f, through an Operator (the constraint corrections compute J A^-1 J^T f).
+///
+/// The QP is the one of QPInverseProblemImpl, with x the forces of the actuators and equality rows:
+///     min 1/2 |dfree_e + Wex x|^2 + 1/2 w x^T Wxx x    s.t.    l <= x <= u,    dmin <= dfree_x + Wxx x <= dmax
+/// It is solved by ADMM as ADMMSolverBackend (C = [I; the rows of Wxx with displacement limits]), the linear
+/// system of each iteration being solved by conjugate gradient, with two applications of W per product. The
+/// weight w of the energy term is the ratio ||Wex^T Wex|| / ||Wxx|| of the spectral norms, estimated by power
+/// iterations, instead of the uniform norms of the assembled matrices. The iterates are kept to warm start the
+/// next resolution when the layout does not change. The solution is only accurate up to the tolerances.
+class SOFA_SOFTROBOTS_INVERSE_API QPMatrixFreeSolver
+{
+public:
+    class Operator
+    {
+    public:
+        virtual ~Operator() = default;
+        /// d = W f, f and d having one entry per row of the constraint matrix. Returns false if the product
+        /// could not be computed.
+        virtual bool apply(const vector<double>& f, vector<double>& d) = 0;
+    };
+
+    /// True if the problem of the lists can be solved without W: no contact, no effector weights nor priority
+    /// levels, no specific epsilon, and an energy term on all the variables unless there is no equality row
+    static bool isSupported(const QPInverseProblem::QPConstraintLists& lists, const bool& actuatorsOnly);
+
+    void setTolerances(const double& absolute, const double& relative) {m_epsAbs = absolute; m_epsRel = relative;}
+    void setMaxIterations(const int& maxIterations) {m_maxIterations = maxIterations;}
+    void setMaxCGIterations(const int& maxIterations) {m_maxCGIterations = maxIterations;}
+
+    /// Solves the problem of the lists (with updated variable rows) for the nbRows rows of dFree. x receives
+    /// the forces of the variables [actuators equality], Wx the product W*lambda on all the rows (lambda being
+    /// x on the rows of the variables, zero elsewhere) and objective the objective without 1/2 |dfree_e|^2.
+    /// Returns false if the operator failed or the resolution did not converge (x is then the last iterate).
+    bool solve(Operator& W, const QPInverseProblem::QPConstraintLists& lists,
+               const double* dFree, const unsigned int& nbRows, const double& epsilon,
+               vector<double>& x, vector<double>& Wx, double& objective);
+
+    /// Iterations of ADMM and applications of W of the last resolution
+    int getNbIterations() const {return m_nbIterations;}
+    unsigned int getNbApplications() const {return m_nbApplications;}
+
+    /// Removes the iterates of the warm start
+    void clear();
+
+protected:
+    double m_rho{0.1};
+    double m_sigma{1e-6};
+    double m_alpha{1.6};
+    double m_epsAbs{1e-6};
+    double m_epsRel{1e-6};
+    int m_maxIterations{4000};
+    int m_maxCGIterations{100};
+    int m_checkInterval{10};
+    int m_nbPowerIterations{20};
+
+    int m_nbIterations{0};
+    unsigned int m_nbApplications{0};
+
+    // Layout of the problem: the rows of the variables, of the effectors (and their weights, 0 for a disabled
+    // row), the variables with displacement limits
+    Operator* m_operator{nullptr};
+    vector<unsigned int> m_variableRows;
+    vector<unsigned int> m_effectorRows;
+    vector<double> m_effectorWeights;
+    vector<unsigned int> m_limitedVariables;
+    double m_energyWeight{0.};
+
+    // Constraints of C = [I; Wgx] and their step sizes
+    Eigen::VectorXd m_l, m_u, m_rhoRows;
+    Eigen::VectorXd m_dFreeEffectors;
+
+    // Iterates, kept to warm start the next resolution
+    Eigen::VectorXd m_x, m_z, m_y;
+
+    // Vectors of the constraint rows given to the operator
+    vector<double> m_f, m_d;
+
+    /// m_d = W*f with f = v on the rows of the variables
+    bool applyVariables(const Eigen::VectorXd& v);
+    /// m_d = W*f with f = a on the rows of the effectors and b on the rows of the limited variables
+    bool applyEffectorsAndLimits(const Eigen::VectorXd& a, const Eigen::VectorXd& b);
+    /// Kv = (H + sigma I + C^T rho C) v
+    bool applySystem(const Eigen::VectorXd& v, Eigen::VectorXd& Kv);
+    bool solveSystem(const Eigen::VectorXd& b, Eigen::VectorXd& x);
+    /// Largest eigenvalue of Wex^T Wex (or of Wxx if energy), by power iterations
+    bool estimateNorm(const bool& energy, double& norm);
+};
+
+} // namespace
@@ -30,6 +30,8 @@
 #ifndef SOFA_COMPONENT_CONSTRAINTSET_QPMECHANICALSETCONSTRAINT_CPP
 #define SOFA_COMPONENT_CONSTRAINTSET_QPMECHANICALSETCONSTRAINT_CPP
 
+#include <algorithm>
+#include <sofa/simulation/MainTaskSchedulerFactory.h>
 #include <SoftRobots.Inverse/component/solver/modules/QPMechanicalSetConstraint.h>
 
 namespace softrobotsinverse::solver::module
@@ -44,81 +46,224 @@ using sofa::core::ConstraintParams ;
 using sofa::core::BaseMapping ;
 using sofa::simulation::Node ;
 using sofa::simulation::Visitor ;
+using sofa::core::behavior::BaseConstraintSet ;
+using sofa::core::behavior::BaseMechanicalState ;
+using sofa::linearalgebra::FullVector ;
+
+void QPConstraintClassification::clear()
+{
+    m_entries.clear();
+    m_position = 0;
+    for(unsigned int i=0; i<NB_ROW_TYPES; i++)
+        m_nbRows[i] = 0;
+}
+
+
+void QPConstraintClassification::beginTraversal()
+{
+    m_position = 0;
+}
+
+
+const QPConstraintClassification::Entry& QPConstraintClassification::classify(BaseConstraintSet* c, const unsigned int& nbLines,
+                                                                             const unsigned int& firstLine)
+{
+    if(m_position < m_entries.size())
+    {
+        Entry& entry = m_entries[m_position];
+        if(entry.constraint == c)
+        {
+            if(entry.nbLines != nbLines) // the constraint changed, classify it again
+                classify(entry, c, nbLines);
+            entry.firstLine = firstLine;
+            return m_entries[m_position++];
+        }
+
+        // The scene changed from here, invalidate the rest of the table
+        m_entries.resize(m_position);
+    }
+
+    m_entries.emplace_back();
+    classify(m_entries.back(), c, nbLines);
+    m_entries.back().firstLine = firstLine;
+    return m_entries[m_position++];
+}
+
+
+BaseMechanicalState* QPConstraintClassification::getConstrainedState(BaseConstraintSet* c)
+{
+    const auto& states = c->getMechanicalStates();
+    return (states.size() == 1)? states[0] : nullptr;
+}
+
+
+void QPConstraintClassification::classify(Entry& entry, BaseConstraintSet* c, const unsigned int& nbLines)
+{
+    entry.constraint = c;
+    entry.nbLines = nbLines;
+    entry.type = OTHER;
+    entry.softRobotsConstraint = dynamic_cast<SoftRobotsBaseConstraint*>(c);
+    entry.baseConstraint = dynamic_cast<BaseConstraint*>(c);
+    entry.state = getConstrainedState(c);
+
+    SoftRobotsBaseConstraint* ipc = entry.softRobotsConstraint;
+    if(ipc)
+    {
+        if(ipc->m_constraintType == ipc->ACTUATOR)      entry.type = ACTUATOR;
+        else if(ipc->m_constraintType == ipc->EFFECTOR) entry.type = EFFECTOR;
+        else if(ipc->m_constraintType == ipc->SENSOR)   entry.type = SENSOR;
+        else if(ipc->m_constraintType == ipc->EQUALITY) entry.type = EQUALITY;
+    }
+    else if(entry.baseConstraint)
+        entry.type = CONTACT;
+}
+
+
+void QPConstraintClassification::endTraversal()
+{
+    // Constraints removed at the end of the traversal
+    m_entries.resize(m_position);
+
+    for(unsigned int i=0; i<NB_ROW_TYPES; i++)
+        m_nbRows[i] = 0;
+    for(const Entry& entry : m_entries)
+        m_nbRows[entry.type] += entry.nbLines;
+}
+
 
 QPMechanicalSetConstraint::QPMechanicalSetConstraint(const ConstraintParams* cparams,
                                                      MultiMatrixDerivId res,
                                                      unsigned int &constraintId,
-                                                     QPInverseProblem* currentCP)
+                                                     QPInverseProblem* currentCP,
+                                                     QPConstraintClassification* classification,
+                                                     vector<SoftRobotsBaseConstraint*>* batchedSensors,
+                                                     FullVector<SReal>* violation,
+                                                     const bool& skipSensorViolations)
     : sofa::simulation::BaseMechanicalVisitor(cparams)
     , m_res(res)
     , m_constraintId(constraintId)
     , m_cparams(cparams)
     , m_currentCP(currentCP)
+    , m_classification(classification? classification : &m_localClassification)
+    , m_batchedSensors(batchedSensors)
+    , m_violation(violation)
+    , m_skipSensorViolations(skipSensorViolations)
 {
 #ifdef SOFA_DUMP_VISITOR_INFO
     setReadWriteVectors();
 #endif
+
+    m_classification->beginTraversal();
+
+    // Sizes from the previous traversal, to avoid regrowing the row ids vectors
+    QPInverseProblem::QPConstraintLists* qpCLists = m_currentCP->getQPConstraintLists();
+    qpCLists->actuatorRowIds.reserve(m_classification->getNbRows(QPConstraintClassification::ACTUATOR));
+    qpCLists->effectorRowIds.reserve(m_classification->getNbRows(QPConstraintClassification::EFFECTOR));
+    qpCLists->sensorRowIds.reserve(m_classification->getNbRows(QPConstraintClassification::SENSOR));
+    qpCLists->equalityRowIds.reserve(m_classification->getNbRows(QPConstraintClassification::EQUALITY));
+    qpCLists->contactRowIds.reserve(m_classification->getNbRows(QPConstraintClassification::CONTACT));
+
+    // Rows of the previous traversal, the vector only grows when new rows are built
+    if(m_violation)
+    {
+        unsigned int nbRows = m_constraintId;
+        for(unsigned int t=0; t<QPConstraintClassification::NB_ROW_TYPES; t++)
+            nbRows += m_classification->getNbRows(QPConstraintClassification::RowType(t));
+        if(m_violation->size() < nbRows)
+            m_violation->resize(nbRows);
+        else
+            m_violation->clear();
+    }
 }
 
 Visitor::Result QPMechanicalSetConstraint::fwdConstraintSet(Node* node, sofa::core::behavior::BaseConstraintSet* c)
 {
+    if(batchSensor(c, m_batchedSensors))
+        return RESULT_CONTINUE;
+
     ctime_t t0 = begin(node, c);
 
     unsigned int index = m_constraintId;
-    QPInverseProblem::QPConstraintLists* qpCLists = m_currentCP->getQPConstraintLists();
 
     c->buildConstraintMatrix(m_cparams, m_res, m_constraintId);
 
-    SoftRobotsBaseConstraint* ipc = dynamic_cast<SoftRobotsBaseConstraint*>(c);
-    BaseConstraint* cc = dynamic_cast<BaseConstraint*>(c);
+    unsigned int nbLines = m_constraintId - index;
+    const QPConstraintClassification::Entry& entry = m_classification->classify(c, nbLines, index);
+    addConstraintRows(m_currentCP, entry, index);
+    if(m_violation)
+        addConstraintViolation(c, entry);
 
-    if(ipc && ipc->m_constraintType == ipc->ACTUATOR)
-    {
-        unsigned int nbLines = m_constraintId - index;
-        for(unsigned int i=0; i<nbLines; i++)
-            (qpCLists->actuatorRowIds).push_back(index + i);
+    end(node, c, t0);
+    return RESULT_CONTINUE;
+}
 
-        (qpCLists->actuators).push_back(ipc);
-    }
+void QPMechanicalSetConstraint::addConstraintViolation(BaseConstraintSet* c, const QPConstraintClassification::Entry& entry)
+{
+    if(entry.nbLines == 0 || (m_skipSensorViolations && entry.type == QPConstraintClassification::SENSOR))
+        return;
 
-    if(ipc && ipc->m_constraintType == ipc->EFFECTOR)
+    // Resizing a FullVector clears it, the rows already written are kept aside
+    const unsigned int nbRows = m_violation->size();
+    if(nbRows < m_constraintId)
     {
-        unsigned int nbLines = m_constraintId - index;
-        for(unsigned int i=0; i<nbLines; i++)
-            (qpCLists->effectorRowIds).push_back(index + i);
-
-        (qpCLists->effectors).push_back(ipc);
+        m_violationCopy.resize(nbRows);
+        std::copy(m_violation->ptr(), m_violation->ptr() + nbRows, m_violationCopy.begin());
+        m_violation->resize(std::max(m_constraintId, 2*nbRows));
+        std::copy(m_violationCopy.begin(), m_violationCopy.end(), m_violation->ptr());
     }
 
-    if(ipc && ipc->m_constraintType == ipc->SENSOR)
-    {
-        unsigned int nbLines = m_constraintId - index;
-        for(unsigned int i=0; i<nbLines; i++)
-            (qpCLists->sensorRowIds).push_back(index + i);
+    c->getConstraintViolation(m_cparams, m_violation);
+}
 
-        (qpCLists->sensors).push_back(ipc);
-    }
+void QPMechanicalSetConstraint::addConstraintRows(QPInverseProblem* currentCP,
+                                                  const QPConstraintClassification::Entry& entry,
+                                                  const unsigned int& index)
+{
+    QPInverseProblem::QPConstraintLists* qpCLists = currentCP->getQPConstraintLists();
 
-    if(ipc && ipc->m_constraintType == ipc->EQUALITY)
+    vector<unsigned int>* rowIds = nullptr;
+    switch(entry.type)
     {
-        unsigned int nbLines = m_constraintId - index;
-        for(unsigned int i=0; i<nbLines; i++)
-            (qpCLists->equalityRowIds).push_back(index + i);
-        (qpCLists->equality).push_back(ipc);
-
+    case QPConstraintClassification::ACTUATOR:
+        rowIds = &qpCLists->actuatorRowIds;
+        (qpCLists->actuators).push_back(entry.softRobotsConstraint);
+        break;
+    case QPConstraintClassification::EFFECTOR:
+        rowIds = &qpCLists->effectorRowIds;
+        (qpCLists->effectors).push_back(entry.softRobotsConstraint);
+        break;
+    case QPConstraintClassification::SENSOR:
+        rowIds = &qpCLists->sensorRowIds;
+        (qpCLists->sensors).push_back(entry.softRobotsConstraint);
+        break;
+    case QPConstraintClassification::EQUALITY:
+        rowIds = &qpCLists->equalityRowIds;
+        (qpCLists->equality).push_back(entry.softRobotsConstraint);
+        break;
+    case QPConstraintClassification::CONTACT:
+        rowIds = &qpCLists->contactRowIds;
+        (qpCLists->contacts).push_back(entry.baseConstraint);
+        break;
+    default:
+        break;
     }
 
-    if(!ipc && cc)
-    {
-        unsigned int nbLines = m_constraintId - index;
-        for(unsigned int i=0; i<nbLines; i++)
-            (qpCLists->contactRowIds).push_back(index + i);
+    if(rowIds)
+        for(unsigned int i=0; i<entry.nbLines; i++)
+            rowIds->push_back(index + i);
+}
 
-        (qpCLists->contacts).push_back(cc);
-    }
+bool QPMechanicalSetConstraint::batchSensor(BaseConstraintSet* c, vector<SoftRobotsBaseConstraint*>* batchedSensors)
+{
+    if(!batchedSensors)
+        return false;
 
-    end(node, c, t0);
-    return RESULT_CONTINUE;
+    SoftRobotsBaseConstraint* ipc = dynamic_cast<SoftRobotsBaseConstraint*>(c);
+    if(!ipc || ipc->m_constraintType != ipc->SENSOR)
+        return false;
+
+    batchedSensors->push_back(ipc);
+    return true;
 }
 
 const char* QPMechanicalSetConstraint::getClassName() const
@@ -145,6 +290,216 @@ void QPMechanicalSetConstraint::setReadWriteVectors()
 }
 #endif
 
+
+
+QPMechanicalCollectConstraint::QPMechanicalCollectConstraint(const ConstraintParams* cparams,
+                                                             vector<BaseConstraintSet*>& constraints,
+                                                             vector<SoftRobotsBaseConstraint*>* batchedSensors)
+    : sofa::simulation::BaseMechanicalVisitor(cparams)
+    , m_constraints(constraints)
+    , m_batchedSensors(batchedSensors)
+{
+    m_constraints.clear();
+}
+
+Visitor::Result QPMechanicalCollectConstraint::fwdConstraintSet(Node* node, BaseConstraintSet* c)
+{
+    SOFA_UNUSED(node);
+
+    if(QPMechanicalSetConstraint::batchSensor(c, m_batchedSensors))
+        return RESULT_CONTINUE;
+
+    m_constraints.push_back(c);
+    return RESULT_CONTINUE;
+}
+
+const char* QPMechanicalCollectConstraint::getClassName() const
+{
+    return "QPMechanicalCollectConstraint";
+}
+
+bool QPMechanicalCollectConstraint::isThreadSafe() const
+{
+    return false;
+}
+
+bool QPMechanicalCollectConstraint::stopAtMechanicalMapping(Node* node, BaseMapping* map)
+{
+    SOFA_UNUSED(node);
+    SOFA_UNUSED(map);
+
+    return false;
+}
+
+
+sofa::simulation::Task::MemoryAlloc QPParallelSetConstraint::BuildConstraintsTask::run()
+{
+    for(const unsigned int& id : *ids)
+        builder->buildConstraint(cparams, res, id);
+    return MemoryAlloc::Stack;
+}
+
+
+bool QPParallelSetConstraint::build(const ConstraintParams* cparams,
+                                    MultiMatrixDerivId res,
+                                    unsigned int &constraintId,
+                                    QPInverseProblem* currentCP,
+                                    QPConstraintClassification* classification,
+                                    Node* root,
+                                    vector<SoftRobotsBaseConstraint*>* batchedSensors,
+                                    const bool& isConcurrent,
+                                    const bool& isClassContiguous)
+{
+    // The rows of the contacts would not be predicted, and the build refused once done
+    if(!isClassContiguous && classification->getNbRows(QPConstraintClassification::CONTACT) > 0)
+    {
+        m_nbRefusedBuilds++;
+        return false;
+    }
+
+    // First pass: list the constraints and assign their rows
+    QPMechanicalCollectConstraint(cparams, m_constraints, batchedSensors).execute(root);
+
+    unsigned int nbLinesTotal = constraintId;
+    if(!assignRows(*classification, nbLinesTotal, isClassContiguous))
+    {
+        m_nbRefusedBuilds++;
+        return false;
+    }
+
+    // Second pass: build the constraints into their rows
+    if(isConcurrent)
+    {
+        sofa::simulation::TaskScheduler* taskScheduler = sofa::simulation::MainTaskSchedulerFactory::createInRegistry();
+        sofa::simulation::CpuTask::Status status;
+
+        vector<BuildConstraintsTask> tasks;
+        tasks.resize(m_groups.size(), BuildConstraintsTask(&status));
+        for(unsigned int i=0; i<m_groups.size(); i++)
+        {
+            tasks[i].set(cparams, res, this, &m_groups[i]);
+            taskScheduler->addTask(&tasks[i]);
+        }
+        taskScheduler->workUntilDone(&status);
+    }
+    else
+        for(const vector<unsigned int>& group : m_groups)
+            for(const unsigned int& id : group)
+                buildConstraint(cparams, res, id);
+
+    // Constraints that may share their mechanical states with the groups
+    for(const unsigned int& id : m_sequentialIds)
+        buildConstraint(cparams, res, id);
+
+    // Rows appended after the predicted ones, whatever their number
+    for(const unsigned int& id : m_appendedIds)
+    {
+        m_offsets[id] = nbLinesTotal;
+        buildConstraint(cparams, res, id);
+        m_expectedLines[id] = m_nbLines[id];
+        nbLinesTotal += m_nbLines[id];
+    }
+
+    for(unsigned int i=0; i<m_constraints.size(); i++)
+        if(m_nbLines[i] != m_expectedLines[i])
+        {
+            m_nbRefusedBuilds++;
+            return false;
+        }
+
+    // Rows are registered in traversal order, as QPMechanicalSetConstraint would do
+    classification->beginTraversal();
+    for(unsigned int i=0; i<m_constraints.size(); i++)
+    {
+        const QPConstraintClassification::Entry& entry = classification->classify(m_constraints[i], m_nbLines[i], m_offsets[i]);
+        QPMechanicalSetConstraint::addConstraintRows(currentCP, entry, m_offsets[i]);
+    }
+
+    constraintId = nbLinesTotal;
+    m_nbParallelBuilds++;
+    return true;
+}
+
+
+bool QPParallelSetConstraint::assignRows(const QPConstraintClassification& classification, unsigned int& nbLinesTotal,
+                                         const bool& isClassContiguous)
+{
+    const unsigned int nbConstraints = m_constraints.size();
+    if(nbConstraints == 0 || classification.getNbEntries() != nbConstraints)
+        return false;
+
+    m_offsets.resize(nbConstraints);
+    m_expectedLines.resize(nbConstraints);
+    m_nbLines.assign(nbConstraints, 0);
+    for(vector<unsigned int>& group : m_groups)
+        group.clear();
+    m_groupStates.clear();
+    m_sequentialIds.clear();
+    m_appendedIds.clear();
+
+    for(unsigned int i=0; i<nbConstraints; i++)
+        if(classification.getEntry(i).constraint != m_constraints[i])
+            return false;
+
+    // Rows in traversal order, or by type of rows
+    const unsigned int nbTypes = (isClassContiguous)? QPConstraintClassification::NB_ROW_TYPES : 1;
+    for(unsigned int t=0; t<nbTypes; t++)
+        for(unsigned int i=0; i<nbConstraints; i++)
+        {
+            const QPConstraintClassification::Entry& entry = classification.getEntry(i);
+            if(isClassContiguous && entry.type != QPConstraintClassification::RowType(t))
+                continue;
+
+            m_expectedLines[i] = entry.nbLines;
+            if(isClassContiguous && (entry.type == QPConstraintClassification::CONTACT || entry.type == QPConstraintClassification::OTHER))
+            {
+                m_appendedIds.push_back(i);
+                continue;
+            }
+
+            m_offsets[i] = nbLinesTotal;
+            nbLinesTotal += entry.nbLines;
+        }
+
+    unsigned int nbGroups = 0;
+    for(unsigned int i=0; i<nbConstraints; i++)
+    {
+        const QPConstraintClassification::Entry& entry = classification.getEntry(i);
+        if(isClassContiguous && (entry.type == QPConstraintClassification::CONTACT || entry.type == QPConstraintClassification::OTHER))
+            continue;
+
+        // Constraints writing in the same MatrixDeriv share a task
+        BaseMechanicalState* state = entry.state;
+        if(!state)
+        {
+            m_sequentialIds.push_back(i);
+            continue;
+        }
+
+        unsigned int g = std::find(m_groupStates.begin(), m_groupStates.end(), state) - m_groupStates.begin();
+        if(g == nbGroups)
+        {
+            m_groupStates.push_back(state);
+            if(m_groups.size() <= nbGroups)
+                m_groups.emplace_back();
+            nbGroups++;
+        }
+        m_groups[g].push_back(i);
+    }
+    m_groups.resize(nbGroups);
+
+    return true;
+}
+
+
+void QPParallelSetConstraint::buildConstraint(const ConstraintParams* cparams, MultiMatrixDerivId res,
+                                              const unsigned int& id)
+{
+    unsigned int index = m_offsets[id];
+    m_constraints[id]->buildConstraintMatrix(cparams, res, index);
+    m_nbLines[id] = index - m_offsets[id];
+}
+
 } // namespace
 
 #endif
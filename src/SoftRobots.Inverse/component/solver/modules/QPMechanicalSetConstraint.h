@@ -30,6 +30,8 @@
 #pragma once
 
 #include <sofa/component/constraint/lagrangian/solver/ConstraintSolverImpl.h>
+#include <sofa/linearalgebra/FullVector.h>
+#include <sofa/simulation/TaskScheduler.h>
 
 #include <SoftRobots/component/behavior/SoftRobotsBaseConstraint.h>
 #include <SoftRobots.Inverse/component/solver/modules/QPInverseProblem.h>
@@ -39,13 +41,69 @@
 namespace softrobotsinverse::solver::module
 {
 
+/// Classification of the constraints met by QPMechanicalSetConstraint, in traversal order.
+/// It saves the dynamic_casts done on each constraint at each step: an entry is reused as long as
+/// the same constraint is met at the same position with the same number of lines. A constraint whose
+/// number of lines changed is classified again, and a different constraint invalidates the table from
+/// this position on.
+class SOFA_SOFTROBOTS_INVERSE_API QPConstraintClassification
+{
+public:
+    enum RowType {ACTUATOR=0, EFFECTOR, SENSOR, EQUALITY, CONTACT, OTHER, NB_ROW_TYPES};
+
+    struct Entry
+    {
+        sofa::core::behavior::BaseConstraintSet* constraint{nullptr};
+        unsigned int nbLines{0};
+        unsigned int firstLine{0}; // first row of the constraint, at the last traversal
+        RowType type{OTHER};
+        softrobots::behavior::SoftRobotsBaseConstraint* softRobotsConstraint{nullptr};
+        sofa::core::behavior::BaseConstraint* baseConstraint{nullptr};
+        sofa::core::behavior::BaseMechanicalState* state{nullptr}; // see getConstrainedState()
+    };
+
+    /// Mechanical state the constraint writes its rows in: the state of its links (see StateAccessor), which
+    /// is not necessarily the one of its context. Null when the constraint has no state or several ones.
+    static sofa::core::behavior::BaseMechanicalState* getConstrainedState(sofa::core::behavior::BaseConstraintSet* c);
+
+    void clear();
+
+    void beginTraversal();
+    const Entry& classify(sofa::core::behavior::BaseConstraintSet* c, const unsigned int& nbLines,
+                          const unsigned int& firstLine);
+    void endTraversal();
+
+    /// Number of rows of the given type found during the last complete traversal
+    unsigned int getNbRows(const RowType& type) const {return m_nbRows[type];}
+
+    /// Entries of the last complete traversal, in traversal order
+    unsigned int getNbEntries() const {return m_entries.size();}
+    const Entry& getEntry(const unsigned int& i) const {return m_entries[i];}
+
+protected:
+    sofa::type::vector<Entry> m_entries;
+    unsigned int m_position{0};
+    unsigned int m_nbRows[NB_ROW_TYPES]{};
+
+    void classify(Entry& entry, sofa::core::behavior::BaseConstraintSet* c, const unsigned int& nbLines);
+};
+
+
+/// With a violation vector, each constraint also writes its violation in its rows right after building them,
+/// while its positions are in cache, which saves the traversal of MechanicalGetConstraintViolationVisitor.
+/// The vector is cleared and grows with the rows, its first rows are then those of the constraint problem.
+/// The violations of the sensors can be left out (see the data lazySensors of QPInverseProblemSolver).
 class SOFA_SOFTROBOTS_INVERSE_API QPMechanicalSetConstraint : public sofa::simulation::BaseMechanicalVisitor
 {
 public:
     QPMechanicalSetConstraint(const sofa::core::ConstraintParams* cparams,
                               sofa::core::MultiMatrixDerivId res,
                               unsigned int &contactId,
-                              QPInverseProblem *currentCP) ;
+                              QPInverseProblem *currentCP,
+                              QPConstraintClassification* classification = nullptr,
+                              vector<softrobots::behavior::SoftRobotsBaseConstraint*>* batchedSensors = nullptr,
+                              sofa::linearalgebra::FullVector<SReal>* violation = nullptr,
+                              const bool& skipSensorViolations = false) ;
 
 
     ////////////////////// Inherited from ConstraintSolverImpl ////////////////////////
@@ -60,13 +118,131 @@ public:
     void setReadWriteVectors() ;
 #endif
 
+    /// With a list of batched sensors, the sensors are added to it instead of being built: they get no rows
+    /// in the constraint problem (see the data batchSensors of QPInverseProblemSolver)
+    static bool batchSensor(sofa::core::behavior::BaseConstraintSet* c,
+                            vector<softrobots::behavior::SoftRobotsBaseConstraint*>* batchedSensors);
+
+    /// Registers the rows [index, index+entry.nbLines) of the constraint in the lists of the problem
+    static void addConstraintRows(QPInverseProblem* currentCP,
+                                  const QPConstraintClassification::Entry& entry,
+                                  const unsigned int& index);
+
 protected:
     sofa::core::MultiMatrixDerivId m_res;
     unsigned int &m_constraintId;
     const sofa::core::ConstraintParams *m_cparams;
 
     QPInverseProblem* m_currentCP;
+    QPConstraintClassification* m_classification;
+    QPConstraintClassification m_localClassification; // used when no persistent table is given
+    vector<softrobots::behavior::SoftRobotsBaseConstraint*>* m_batchedSensors;
+    sofa::linearalgebra::FullVector<SReal>* m_violation;
+    bool m_skipSensorViolations;
+    vector<SReal> m_violationCopy; // rows kept while the violation vector grows
+
+    void addConstraintViolation(sofa::core::behavior::BaseConstraintSet* c,
+                                const QPConstraintClassification::Entry& entry);
+};
+
+
+/// Lists the constraints met by QPMechanicalSetConstraint, in the same traversal order, without
+/// building them
+class SOFA_SOFTROBOTS_INVERSE_API QPMechanicalCollectConstraint : public sofa::simulation::BaseMechanicalVisitor
+{
+public:
+    QPMechanicalCollectConstraint(const sofa::core::ConstraintParams* cparams,
+                                  sofa::type::vector<sofa::core::behavior::BaseConstraintSet*>& constraints,
+                                  vector<softrobots::behavior::SoftRobotsBaseConstraint*>* batchedSensors = nullptr) ;
+
+    virtual Visitor::Result fwdConstraintSet(sofa::simulation::Node* node, sofa::core::behavior::BaseConstraintSet* c) ;
+    virtual const char* getClassName() const ;
+    virtual bool isThreadSafe() const ;
+    virtual bool stopAtMechanicalMapping(sofa::simulation::Node* node, sofa::core::BaseMapping* map) ;
+
+protected:
+    sofa::type::vector<sofa::core::behavior::BaseConstraintSet*>& m_constraints;
+    vector<softrobots::behavior::SoftRobotsBaseConstraint*>* m_batchedSensors;
+};
+
+
+/// Two-pass alternative to QPMechanicalSetConstraint that builds the constraint matrix concurrently.
+/// The first pass lists the constraints and assigns to each one its range of rows, from the number of
+/// lines it had at the previous traversal. The second pass builds the constraints into these ranges,
+/// one task per mechanical state (constraints writing in the same MatrixDeriv stay on the same task), the
+/// state being the one the constraint is linked to (see QPConstraintClassification::getConstrainedState()).
+/// Constraints that are not linked to a single mechanical state, like contacts, are built afterwards
+/// on the calling thread. Rows ids and their order are the same as with QPMechanicalSetConstraint.
+///
+/// With class contiguous rows, the ranges are assigned by type of row instead (actuators, effectors, sensors,
+/// equality, contacts, others, in the order of QPConstraintClassification::RowType), so that the rows of each
+/// type are consecutive in W. The contacts and the other constraints are then built last, one after the
+/// other, and their number of lines is not predicted. Each constraint reads its lambda in its own rows, the
+/// layout is kept in the firstLine of the entries of the classification.
+///
+/// The build is refused (returns false) when the ranges can not be predicted, that is at the first
+/// traversal and whenever the set of constraints changed, or when a constraint did not write the number
+/// of lines expected. The caller then resets the constraints and uses QPMechanicalSetConstraint.
+/// In traversal order, the contacts change their number of lines almost at each step: with contacts at the
+/// previous traversal, the build is refused before building anything.
+class SOFA_SOFTROBOTS_INVERSE_API QPParallelSetConstraint
+{
+public:
+    bool build(const sofa::core::ConstraintParams* cparams,
+               sofa::core::MultiMatrixDerivId res,
+               unsigned int &constraintId,
+               QPInverseProblem* currentCP,
+               QPConstraintClassification* classification,
+               sofa::simulation::Node* root,
+               vector<softrobots::behavior::SoftRobotsBaseConstraint*>* batchedSensors = nullptr,
+               const bool& isConcurrent = true,
+               const bool& isClassContiguous = false);
+
+    /// Number of traversals built concurrently, and refused
+    unsigned int getNbParallelBuilds() const {return m_nbParallelBuilds;}
+    unsigned int getNbRefusedBuilds() const {return m_nbRefusedBuilds;}
+
+protected:
+
+    class BuildConstraintsTask : public sofa::simulation::CpuTask
+    {
+    public:
+        BuildConstraintsTask(sofa::simulation::CpuTask::Status* status): CpuTask(status) {}
+        ~BuildConstraintsTask() override {}
+
+        MemoryAlloc run() final;
+
+        void set(const sofa::core::ConstraintParams* _cparams, sofa::core::MultiMatrixDerivId _res,
+                 QPParallelSetConstraint* _builder, const vector<unsigned int>* _ids){
+            cparams = _cparams;
+            res = _res;
+            builder = _builder;
+            ids = _ids;
+        }
+
+    private:
+        const sofa::core::ConstraintParams* cparams{nullptr};
+        sofa::core::MultiMatrixDerivId res;
+        QPParallelSetConstraint* builder{nullptr};
+        const vector<unsigned int>* ids{nullptr}; // constraints of the group, in traversal order
+    };
+
+    vector<sofa::core::behavior::BaseConstraintSet*> m_constraints; // in traversal order
+    vector<unsigned int> m_offsets;       // first row of each constraint
+    vector<unsigned int> m_expectedLines; // number of lines of each constraint at the previous traversal
+    vector<unsigned int> m_nbLines;       // number of lines written at this traversal
+    vector<vector<unsigned int>> m_groups; // constraints sharing a mechanical state
+    vector<sofa::core::behavior::BaseMechanicalState*> m_groupStates;
+    vector<unsigned int> m_sequentialIds;  // constraints built on the calling thread
+    vector<unsigned int> m_appendedIds;    // constraints built last with class contiguous rows, in row order
+
+    unsigned int m_nbParallelBuilds{0};
+    unsigned int m_nbRefusedBuilds{0};
 
+    bool assignRows(const QPConstraintClassification& classification, unsigned int& nbLinesTotal,
+                    const bool& isClassContiguous);
+    void buildConstraint(const sofa::core::ConstraintParams* cparams, sofa::core::MultiMatrixDerivId res,
+                         const unsigned int& id);
 };
 
 } // namespace
@@ -0,0 +1,141 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+
+#ifndef SOFA_COMPONENT_CONSTRAINTSET_QPMECHANICALSTORELAMBDA_CPP
+#define SOFA_COMPONENT_CONSTRAINTSET_QPMECHANICALSTORELAMBDA_CPP
+
+#include <SoftRobots.Inverse/component/solver/modules/QPMechanicalStoreLambda.h>
+#include <sofa/core/BaseMapping.h>
+#include <sofa/core/behavior/BaseConstraint.h>
+
+namespace softrobotsinverse::solver::module
+{
+using sofa::core::ConstraintParams ;
+using sofa::core::MechanicalParams ;
+using sofa::core::BaseMapping ;
+using sofa::core::behavior::BaseConstraint ;
+using sofa::core::behavior::BaseConstraintSet ;
+using sofa::core::behavior::BaseMechanicalState ;
+using sofa::linearalgebra::BaseVector ;
+using sofa::simulation::Node ;
+using sofa::simulation::Visitor ;
+
+
+QPMechanicalStoreLambda::QPMechanicalStoreLambda(const ConstraintParams* cparams,
+                                                 const BaseVector* lambda,
+                                                 const QPConstraintClassification& classification,
+                                                 const unsigned int& firstLine)
+    : sofa::simulation::BaseMechanicalVisitor(cparams)
+    , m_cparams(cparams)
+    , m_lambda(lambda)
+{
+    // Rows of the constraints, as numbered at the last traversal of the classification
+    for(unsigned int i=0; i<classification.getNbEntries(); i++)
+    {
+        const QPConstraintClassification::Entry& entry = classification.getEntry(i);
+        const unsigned int line = firstLine + entry.firstLine;
+
+        bool isZero = (line + entry.nbLines <= (unsigned int)m_lambda->size());
+        for(unsigned int j=line; isZero && j<line+entry.nbLines; j++)
+            isZero = (m_lambda->element(j) == 0.);
+
+        if(isZero)
+            m_zeroConstraints.insert(entry.constraint);
+
+        m_constraintStates[entry.constraint] = entry.state;
+    }
+}
+
+Visitor::Result QPMechanicalStoreLambda::fwdConstraintSet(Node* node, BaseConstraintSet* cSet)
+{
+    BaseConstraint* c = cSet->toBaseConstraint();
+    if(!c)
+        return RESULT_CONTINUE;
+
+    if(m_zeroConstraints.count(cSet))
+    {
+        m_nbSkippedConstraints++;
+        return RESULT_CONTINUE;
+    }
+
+    ctime_t t0 = begin(node, c);
+    c->storeLambda(m_cparams, m_cparams->lambda(), m_lambda);
+    end(node, c, t0);
+    m_nbStoredConstraints++;
+
+    // Constraints out of the classification, like the batched sensors
+    auto it = m_constraintStates.find(cSet);
+    BaseMechanicalState* state = (it != m_constraintStates.end())? it->second : QPConstraintClassification::getConstrainedState(cSet);
+    if(state)
+        m_writtenStates.insert(state);
+    else
+        m_writesUnknownStates = true;
+
+    return RESULT_CONTINUE;
+}
+
+void QPMechanicalStoreLambda::bwdMechanicalMapping(Node* node, BaseMapping* map)
+{
+    // The lambda of the child is zero: nothing to accumulate in the parents
+    if(!m_writesUnknownStates)
+    {
+        bool isWritten = false;
+        for(BaseMechanicalState* child : map->getMechTo())
+            isWritten = isWritten || m_writtenStates.count(child);
+        if(!isWritten)
+            return;
+    }
+
+    ctime_t t0 = begin(node, map);
+    MechanicalParams mparams(*m_cparams);
+    mparams.setDx(m_cparams->dx());
+    mparams.setF(m_cparams->lambda());
+    map->applyJT(&mparams, m_cparams->lambda(), m_cparams->lambda());
+    end(node, map, t0);
+
+    for(BaseMechanicalState* parent : map->getMechFrom())
+        m_writtenStates.insert(parent);
+}
+
+/// Return a class name for this visitor
+/// Only used for debugging / profiling purposes
+const char* QPMechanicalStoreLambda::getClassName() const
+{
+    return "QPMechanicalStoreLambda";
+}
+
+bool QPMechanicalStoreLambda::isThreadSafe() const
+{
+    return false;
+}
+
+} // namespace
+
+#endif
+
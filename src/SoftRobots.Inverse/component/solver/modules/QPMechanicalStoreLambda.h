@@ -0,0 +1,83 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <unordered_map>
+#include <unordered_set>
+
+#include <sofa/component/constraint/lagrangian/solver/ConstraintSolverImpl.h>
+#include <sofa/linearalgebra/BaseVector.h>
+
+#include <SoftRobots.Inverse/component/solver/modules/QPMechanicalSetConstraint.h>
+#include <SoftRobots.Inverse/component/config.h>
+
+namespace softrobotsinverse::solver::module
+{
+
+/// Sparse alternative to ConstraintStoreLambdaVisitor. The constraints of the classification whose rows all
+/// have a zero lambda (e.g. the effectors, or the inactive contacts) are not stored, and a mapping only
+/// accumulates the lambda of its child in its parents when a constraint was stored below it. The constraints
+/// that are not in the classification are stored as by ConstraintStoreLambdaVisitor.
+/// The rows of a constraint are the ones of its entry in the classification (see Entry::firstLine), shifted by firstLine.
+/// The lambda of the states must have been cleared before the traversal.
+class SOFA_SOFTROBOTS_INVERSE_API QPMechanicalStoreLambda : public sofa::simulation::BaseMechanicalVisitor
+{
+public:
+    QPMechanicalStoreLambda(const sofa::core::ConstraintParams* cparams,
+                            const sofa::linearalgebra::BaseVector* lambda,
+                            const QPConstraintClassification& classification,
+                            const unsigned int& firstLine = 0) ;
+
+    virtual Visitor::Result fwdConstraintSet(sofa::simulation::Node* node, sofa::core::behavior::BaseConstraintSet* c) ;
+    virtual void bwdMechanicalMapping(sofa::simulation::Node* node, sofa::core::BaseMapping* map) ;
+
+    /// Return a class name for this visitor
+    /// Only used for debugging / profiling purposes
+    virtual const char* getClassName() const ;
+
+    virtual bool isThreadSafe() const ;
+
+    /// Number of constraints stored, and skipped, during the traversal
+    unsigned int getNbStoredConstraints() const {return m_nbStoredConstraints;}
+    unsigned int getNbSkippedConstraints() const {return m_nbSkippedConstraints;}
+
+protected:
+    const sofa::core::ConstraintParams *m_cparams;
+    const sofa::linearalgebra::BaseVector* m_lambda;
+
+    std::unordered_set<const sofa::core::behavior::BaseConstraintSet*> m_zeroConstraints; // all rows with a zero lambda
+    std::unordered_map<const sofa::core::behavior::BaseConstraintSet*, sofa::core::behavior::BaseMechanicalState*> m_constraintStates;
+    std::unordered_set<const sofa::core::behavior::BaseMechanicalState*> m_writtenStates;
+    bool m_writesUnknownStates{false}; // a constraint of unknown states was stored, all the mappings are applied
+
+    unsigned int m_nbStoredConstraints{0};
+    unsigned int m_nbSkippedConstraints{0};
+};
+
+} // namespace
@@ -0,0 +1,214 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+
+#include <algorithm>
+#include <sofa/helper/logging/Messaging.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPMessageQueue.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+QPMessageQueue::Stream::Stream(QPMessageQueue* queue, const Type& type, const std::string_view& sender, const char* key)
+    : m_queue(queue)
+    , m_type(type)
+    , m_sender(sender)
+{
+    if(!m_queue || m_queue->accept(key, m_nbSuppressed))
+        m_text.emplace();
+}
+
+
+QPMessageQueue::Stream::Stream(QPMessageQueue* queue, const Type& type, const sofa::core::objectmodel::Base* component,
+                               const char* key)
+    : m_queue(queue)
+    , m_type(type)
+    , m_component(component)
+{
+    if(!m_queue || m_queue->accept(key, m_nbSuppressed))
+        m_text.emplace();
+}
+
+
+QPMessageQueue::Stream::~Stream()
+{
+    if(!m_text)
+        return;
+
+    if(m_nbSuppressed > 0)
+        *m_text << " (" << m_nbSuppressed << " similar messages suppressed)";
+    if(m_queue)
+        m_queue->post(m_type, m_component, m_sender, m_text->str());
+    else
+        emit(m_type, m_component, std::string(m_sender), m_text->str());
+}
+
+
+QPMessageQueue::~QPMessageQueue()
+{
+    stop();
+}
+
+
+void QPMessageQueue::start(const unsigned int& capacity)
+{
+    stop();
+
+    m_capacity = std::max(capacity, 1u);
+    m_stop = false;
+    m_isStarted = true;
+    m_emitter = std::thread(&QPMessageQueue::emitLoop, this);
+}
+
+
+void QPMessageQueue::stop()
+{
+    if(!m_isStarted)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_pendingCondition.notify_one();
+    m_emitter.join();
+    m_isStarted = false;
+}
+
+
+bool QPMessageQueue::accept(const char* key, unsigned int& nbSuppressed)
+{
+    nbSuppressed = 0;
+    if(m_interval <= 0.)
+        return true;
+
+    const Clock::time_point now = Clock::now();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = std::find_if(m_keys.begin(), m_keys.end(), [key](const KeyState& state){return state.key == key;});
+    if(it == m_keys.end())
+    {
+        m_keys.push_back({key, now, 0});
+        return true;
+    }
+
+    if(std::chrono::duration<double>(now - it->last).count() < m_interval)
+    {
+        it->nbSuppressed++;
+        m_nbSuppressed++;
+        return false;
+    }
+
+    nbSuppressed = it->nbSuppressed;
+    it->nbSuppressed = 0;
+    it->last = now;
+    return true;
+}
+
+
+void QPMessageQueue::post(const Type& type, const sofa::core::objectmodel::Base* component,
+                          const std::string_view& sender, std::string&& text)
+{
+    if(!m_isStarted)
+    {
+        emit(type, component, std::string(sender), text);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(m_pending.size() >= m_capacity)
+        {
+            m_nbDropped++;
+            return;
+        }
+        m_pending.push_back({type, component, std::string(sender), std::move(text)});
+    }
+    m_pendingCondition.notify_one();
+}
+
+
+unsigned int QPMessageQueue::getNbSuppressed() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_nbSuppressed;
+}
+
+
+unsigned int QPMessageQueue::getNbDropped() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_nbDropped;
+}
+
+
+void QPMessageQueue::emit(const Type& type, const sofa::core::objectmodel::Base* component, const std::string& sender,
+                          const std::string& text)
+{
+    switch(type)
+    {
+    case Info:
+        if(component)
+            msg_info(component) << text;
+        else
+            msg_info(sender) << text;
+        break;
+    case Warning:
+        if(component)
+            msg_warning(component) << text;
+        else
+            msg_warning(sender) << text;
+        break;
+    case Error:
+        if(component)
+            msg_error(component) << text;
+        else
+            msg_error(sender) << text;
+        break;
+    }
+}
+
+
+void QPMessageQueue::emitLoop()
+{
+    while(true)
+    {
+        Message message;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_pendingCondition.wait(lock, [this]{return m_stop || !m_pending.empty();});
+            if(m_pending.empty()) // stopped, and all the messages are emitted
+                return;
+            message = std::move(m_pending.front());
+            m_pending.pop_front();
+        }
+        emit(message.type, message.component, message.sender, message.text);
+    }
+}
+
+} // namespace
@@ -0,0 +1,150 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <sofa/core/objectmodel/Base.h>
+#include <sofa/type/vector.h>
+
+#include <SoftRobots.Inverse/component/config.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+/// Messages of the solvers (warnings of infeasible QPs, timings, ...), emitted through the SOFA messaging by a
+/// background thread once started, so that their output does not stall the steps. The queue is bounded, the
+/// messages posted while it is full are dropped. Each message has a key (a string literal, compared by address):
+/// the messages of a key posted less than the interval after the last accepted one are only counted, and the
+/// count is reported with the next accepted one. A rate limited message is not formatted. The sender is a
+/// component, which has to outlive the queue, or a name.
+class SOFA_SOFTROBOTS_INVERSE_API QPMessageQueue
+{
+public:
+    enum Type {Info, Warning, Error};
+
+    /// Message being formatted, posted when destroyed. Without queue, it is emitted at once, without rate limit.
+    class SOFA_SOFTROBOTS_INVERSE_API Stream
+    {
+    public:
+        Stream(QPMessageQueue* queue, const Type& type, const std::string_view& sender, const char* key);
+        Stream(QPMessageQueue* queue, const Type& type, const sofa::core::objectmodel::Base* component, const char* key);
+        Stream(const Stream&) = delete;
+        Stream& operator=(const Stream&) = delete;
+        ~Stream();
+
+        template<class T>
+        Stream& operator<<(const T& value)
+        {
+            if(m_text)
+                *m_text << value;
+            return *this;
+        }
+
+    protected:
+        QPMessageQueue* m_queue;
+        Type m_type;
+        const sofa::core::objectmodel::Base* m_component{nullptr};
+        std::string_view m_sender;
+        unsigned int m_nbSuppressed{0};
+        std::optional<std::ostringstream> m_text; // only for the accepted messages
+    };
+
+    QPMessageQueue() {}
+    ~QPMessageQueue();
+
+    /// Starts the thread emitting the messages, at most capacity messages are pending
+    void start(const unsigned int& capacity);
+    /// Emits the pending messages and stops the thread, the messages are then emitted when posted
+    void stop();
+    bool isStarted() const {return m_isStarted;}
+
+    /// Minimum time in seconds between two messages of the same key, 0 to disable the rate limit
+    void setInterval(const double& interval) {m_interval = interval;}
+
+    Stream info(const std::string_view& sender, const char* key) {return Stream(this, Info, sender, key);}
+    Stream warning(const std::string_view& sender, const char* key) {return Stream(this, Warning, sender, key);}
+    Stream error(const std::string_view& sender, const char* key) {return Stream(this, Error, sender, key);}
+    Stream info(const sofa::core::objectmodel::Base* component, const char* key) {return Stream(this, Info, component, key);}
+    Stream warning(const sofa::core::objectmodel::Base* component, const char* key) {return Stream(this, Warning, component, key);}
+    Stream error(const sofa::core::objectmodel::Base* component, const char* key) {return Stream(this, Error, component, key);}
+
+    /// Returns false, and counts the message, if a message of the key was accepted less than the interval ago.
+    /// Else nbSuppressed is the number of messages of the key counted since the last accepted one.
+    bool accept(const char* key, unsigned int& nbSuppressed);
+    void post(const Type& type, const sofa::core::objectmodel::Base* component, const std::string_view& sender,
+              std::string&& text);
+
+    /// Number of messages rate limited, and dropped because the queue was full
+    unsigned int getNbSuppressed() const;
+    unsigned int getNbDropped() const;
+
+    static void emit(const Type& type, const sofa::core::objectmodel::Base* component, const std::string& sender,
+                     const std::string& text);
+
+protected:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Message {
+        Type type{Info};
+        const sofa::core::objectmodel::Base* component{nullptr};
+        std::string sender;
+        std::string text;
+    };
+
+    struct KeyState {
+        const char* key{nullptr};
+        Clock::time_point last;
+        unsigned int nbSuppressed{0};
+    };
+
+    double m_interval{0.};
+    sofa::type::vector<KeyState> m_keys; // a few keys, searched linearly
+    unsigned int m_capacity{256};
+    bool m_isStarted{false};
+    bool m_stop{false};
+    std::deque<Message> m_pending;
+    std::thread m_emitter;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_pendingCondition;
+    unsigned int m_nbSuppressed{0};
+    unsigned int m_nbDropped{0};
+
+    void emitLoop();
+};
+
+} // namespace
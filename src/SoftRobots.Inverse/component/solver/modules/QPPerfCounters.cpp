@@ -0,0 +1,160 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+
+#include <SoftRobots.Inverse/component/solver/modules/QPPerfCounters.h>
+
+#if defined(__linux__)
+#include <dlfcn.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+namespace softrobotsinverse::solver::module
+{
+
+namespace
+{
+const std::string s_counterNames[QPPerfCounters::NbCounters] = {"allocations", "allocated bytes", "cycles",
+                                                                "instructions", "cache misses"};
+
+#if defined(__linux__)
+int openHardwareCounter(const uint64_t& config, const int& groupFd)
+{
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.disabled = (groupFd < 0)? 1 : 0; // the group is enabled at once, from its leader
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP;
+    return (int)syscall(__NR_perf_event_open, &attr, 0, -1, groupFd, 0); // calling thread, any CPU
+}
+#endif
+}
+
+
+QPPerfCounters::~QPPerfCounters()
+{
+    close();
+}
+
+
+bool QPPerfCounters::open()
+{
+    close();
+
+#if defined(__linux__)
+    m_getAllocationCounts = reinterpret_cast<AllocationCountsFunction>(dlsym(RTLD_DEFAULT, s_allocationCountsSymbol));
+
+    const uint64_t configs[NbCounters-Cycles] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                                                 PERF_COUNT_HW_CACHE_MISSES};
+    for(unsigned int i=0; i<NbCounters-Cycles; i++)
+    {
+        m_fds[i] = openHardwareCounter(configs[i], m_groupFd);
+        if(m_fds[i] < 0)
+            break;
+        if(i == 0)
+            m_groupFd = m_fds[0];
+    }
+
+    // A partial group would shift the values read, all of them or none
+    if(m_groupFd >= 0 && m_fds[NbCounters-Cycles-1] < 0)
+    {
+        for(int& fd : m_fds)
+            if(fd >= 0)
+                ::close(fd);
+        for(int& fd : m_fds)
+            fd = -1;
+        m_groupFd = -1;
+    }
+
+    if(m_groupFd >= 0)
+    {
+        ioctl(m_groupFd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(m_groupFd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+#endif
+
+    m_isOpen = hasAllocationCounts() || hasHardwareCounts();
+    return m_isOpen;
+}
+
+
+void QPPerfCounters::close()
+{
+#if defined(__linux__)
+    for(int& fd : m_fds)
+    {
+        if(fd >= 0)
+            ::close(fd);
+        fd = -1;
+    }
+#endif
+    m_groupFd = -1;
+    m_getAllocationCounts = nullptr;
+    m_isOpen = false;
+}
+
+
+bool QPPerfCounters::isAvailable(const Counter& counter) const
+{
+    return (counter < Cycles)? hasAllocationCounts() : hasHardwareCounts();
+}
+
+
+void QPPerfCounters::read(Values& values) const
+{
+    values = Values();
+    if(m_getAllocationCounts)
+        m_getAllocationCounts(&values.counts[Allocations], &values.counts[AllocatedBytes]);
+
+#if defined(__linux__)
+    if(m_groupFd >= 0)
+    {
+        // PERF_FORMAT_GROUP: number of counters, then their values in the order of creation
+        uint64_t data[1 + NbCounters-Cycles];
+        if(::read(m_groupFd, data, sizeof(data)) == (ssize_t)sizeof(data) && data[0] == NbCounters-Cycles)
+            for(unsigned int i=0; i<NbCounters-Cycles; i++)
+                values.counts[Cycles+i] = data[1+i];
+    }
+#endif
+}
+
+
+const std::string& QPPerfCounters::getName(const Counter& counter)
+{
+    return s_counterNames[counter];
+}
+
+} // namespace
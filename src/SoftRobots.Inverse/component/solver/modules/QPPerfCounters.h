@@ -0,0 +1,88 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include <SoftRobots.Inverse/component/config.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+/// Counters read around the phases of a resolution, to see the allocation storms and the cache misses
+/// without reproducing the scene under a profiler:
+/// - the heap allocations of the process (number and bytes), when the allocation hook of
+///   tools/allochook is preloaded (LD_PRELOAD), found at open() by the name of its entry point,
+/// - the hardware counters of the calling thread (cycles, instructions, cache misses), with
+///   perf_event on Linux, when the kernel allows it (see /proc/sys/kernel/perf_event_paranoid).
+/// The counters of a phase are the differences of two reads. The allocations of all the threads are
+/// counted, the hardware events only on the thread which opened the counters.
+class SOFA_SOFTROBOTS_INVERSE_API QPPerfCounters
+{
+public:
+    enum Counter {Allocations, AllocatedBytes, Cycles, Instructions, CacheMisses, NbCounters};
+
+    struct Values {
+        uint64_t counts[NbCounters]{};
+    };
+
+    /// Entry point of the allocation hook
+    typedef void (*AllocationCountsFunction)(uint64_t* nbAllocations, uint64_t* nbBytes);
+    static constexpr const char* s_allocationCountsSymbol{"softrobotsinverse_getAllocationCounts"};
+
+    QPPerfCounters() {}
+    ~QPPerfCounters();
+    QPPerfCounters(const QPPerfCounters&) = delete;
+    QPPerfCounters& operator=(const QPPerfCounters&) = delete;
+
+    /// Opens the counters available. Returns false if none is.
+    bool open();
+    void close();
+    bool isOpen() const {return m_isOpen;}
+
+    bool hasAllocationCounts() const {return m_getAllocationCounts != nullptr;}
+    bool hasHardwareCounts() const {return m_groupFd >= 0;}
+    bool isAvailable(const Counter& counter) const;
+
+    /// Current values of the counters, those unavailable are left to 0
+    void read(Values& values) const;
+
+    static const std::string& getName(const Counter& counter);
+
+protected:
+    bool m_isOpen{false};
+    AllocationCountsFunction m_getAllocationCounts{nullptr};
+    int m_groupFd{-1}; // leader of the group of hardware counters, read at once
+    int m_fds[NbCounters-Cycles]{-1, -1, -1};
+};
+
+} // namespace
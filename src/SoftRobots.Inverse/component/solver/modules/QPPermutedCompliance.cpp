@@ -0,0 +1,73 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#define SOFTROBOTS_INVERSE_QPPERMUTEDCOMPLIANCE_CPP
+
+#include <algorithm>
+
+#include <SoftRobots.Inverse/component/solver/modules/QPPermutedCompliance.h>
+
+namespace softrobotsinverse::solver::module
+{
+
+template<class Real>
+void QPPermutedComplianceT<Real>::gather(const double* const* W, const sofa::type::vector<unsigned int>& ids,
+                                         const sofa::type::vector<QPRowBlock>& columnBlocks)
+{
+    m_dim = ids.size();
+    m_pitch = QPStorage::getPaddedSize(m_dim, sizeof(Real), m_W.getPolicy());
+    m_W.resize(m_pitch*m_dim);
+    m_rows.resize(m_dim);
+
+    Real* row = m_W.data();
+    for(unsigned int i=0; i<m_dim; i++, row+=m_pitch)
+    {
+        const double* Wi = W[ids[i]];
+        for(const QPRowBlock& block : columnBlocks)
+            std::copy(Wi + block.first, Wi + block.first + block.size, row + block.offset);
+        m_rows[i] = row;
+    }
+    m_isValid = true;
+}
+
+
+template<class Real>
+void QPPermutedComplianceT<Real>::setStoragePolicy(const QPStoragePolicy& policy)
+{
+    if(policy == m_W.getPolicy())
+        return;
+    m_W.clear();
+    m_W.setPolicy(policy);
+    m_isValid = false;
+}
+
+// The double copy is read by the QP assembly, the float copy by the mixed precision sweeps
+template class SOFA_SOFTROBOTS_INVERSE_API QPPermutedComplianceT<double>;
+template class SOFA_SOFTROBOTS_INVERSE_API QPPermutedComplianceT<float>;
+
+} // namespace
@@ -0,0 +1,95 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <sofa/type/vector.h>
+
+#include <SoftRobots.Inverse/component/solver/modules/QPAlignedBuffer.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPInverseProblem.h>
+#include <SoftRobots.Inverse/component/config.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+/// Contiguous copy of the block W(x, x) of the compliance, x being the QP variables [actuators equality
+/// contacts] in the order of QPInverseProblemImpl::updateVariableIds(). W is otherwise read through the
+/// row ids of the variables, its rows and columns in random order: the copy is gathered once, each row
+/// by runs of consecutive columns, and the kernels that follow read it with a unit stride.
+/// The copy is stored in the scalar type Real, W being converted while it is gathered: double for the QP
+/// assembly, float for the sweeps of the contact solvers in mixed precision (see NLCPSolver).
+/// With a storage policy other than Default (see QPStoragePolicy), the rows are padded to a multiple of
+/// 64 bytes and each starts on a cache line.
+template<class Real>
+class QPPermutedComplianceT
+{
+public:
+    typedef QPInverseProblem::QPRowBlock QPRowBlock;
+
+    /// Copies W(ids, ids), columnBlocks being the blocks of consecutive ids (see QPInverseProblem::getRowBlocks)
+    void gather(const double* const* W, const sofa::type::vector<unsigned int>& ids,
+                const sofa::type::vector<QPRowBlock>& columnBlocks);
+
+    void invalidate() {m_isValid = false;}
+    bool isValid() const {return m_isValid;}
+
+    unsigned int getDimension() const {return m_dim;}
+    /// Distance between two rows, the dimension padded for the storage policy
+    size_t getPitch() const {return m_pitch;}
+
+    /// Reallocates the copy with the policy if it changed, it is gathered again at the next call
+    void setStoragePolicy(const QPStoragePolicy& policy);
+
+    /// Row i of the copy, W(ids[i], ids)
+    const Real* operator[](const unsigned int& i) const {return m_W.data() + i*m_pitch;}
+    /// Rows of the copy, for the kernels reading a matrix as an array of rows
+    const Real* const* getRows() const {return m_rows.data();}
+
+    size_t getMemoryUsage() const {return sizeof(Real)*m_W.capacity() + sizeof(const Real*)*m_rows.capacity();}
+
+protected:
+    QPAlignedBuffer<Real> m_W; // Row-major, kept between steps
+    sofa::type::vector<const Real*> m_rows;
+    unsigned int m_dim{0};
+    size_t m_pitch{0};
+    bool m_isValid{false};
+};
+
+typedef QPPermutedComplianceT<double> QPPermutedCompliance;
+typedef QPPermutedComplianceT<float> QPPermutedComplianceF;
+
+// Declares template as extern to avoid the code generation of the template for
+// each compilation unit. see: http://www.stroustrup.com/C++11FAQ.html#extern-templates
+#if !defined(SOFTROBOTS_INVERSE_QPPERMUTEDCOMPLIANCE_CPP)
+extern template class SOFA_SOFTROBOTS_INVERSE_API QPPermutedComplianceT<double>;
+extern template class SOFA_SOFTROBOTS_INVERSE_API QPPermutedComplianceT<float>;
+#endif
+
+} // namespace
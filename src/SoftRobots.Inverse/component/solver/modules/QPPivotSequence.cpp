@@ -0,0 +1,111 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#include <algorithm>
+#include <utility>
+#include <SoftRobots.Inverse/component/solver/modules/QPPivotSequence.h>
+
+namespace softrobotsinverse::solver::module
+{
+
+void QPPivotSequence::clear()
+{
+    m_pivots.clear();
+    m_hash = 0;
+
+    // A new stamp empties the set, the stamps are only reset when they wrap around
+    m_stamp++;
+    if(m_stamp == 0)
+    {
+        std::fill(m_stamps.begin(), m_stamps.end(), 0);
+        m_stamp = 1;
+    }
+}
+
+
+void QPPivotSequence::push_back(const int& pivot)
+{
+    m_pivots.push_back(pivot);
+    m_hash = extendHash(m_hash, pivot);
+
+    if(pivot < 0)
+        return;
+    if(static_cast<size_t>(pivot) >= m_stamps.size())
+        m_stamps.resize(pivot+1, 0);
+    m_stamps[pivot] = m_stamp;
+}
+
+
+bool QPPivotSequence::contains(const int& pivot) const
+{
+    if(pivot >= 0)
+        return static_cast<size_t>(pivot) < m_stamps.size() && m_stamps[pivot] == m_stamp;
+
+    for(const int& p : m_pivots)
+        if(p == pivot)
+            return true;
+    return false;
+}
+
+
+bool QPPivotSequence::isExtensionOf(const QPPivotSequence& prefix, const int& pivot) const
+{
+    if(m_pivots.size() != prefix.m_pivots.size()+1 || m_hash != extendHash(prefix.m_hash, pivot))
+        return false;
+
+    if(m_pivots.back() != pivot)
+        return false;
+    for(size_t i=0; i<prefix.m_pivots.size(); i++)
+        if(m_pivots[i] != prefix.m_pivots[i])
+            return false;
+    return true;
+}
+
+
+void QPPivotSequence::swap(QPPivotSequence& other)
+{
+    m_pivots.swap(other.m_pivots);
+    m_stamps.swap(other.m_stamps);
+    std::swap(m_hash, other.m_hash);
+    std::swap(m_stamp, other.m_stamp);
+}
+
+
+size_t QPPivotSequence::getMemoryUsage() const
+{
+    return sizeof(int)*m_pivots.capacity() + sizeof(unsigned int)*m_stamps.capacity();
+}
+
+
+uint64_t QPPivotSequence::extendHash(const uint64_t& hash, const int& pivot)
+{
+    // Polynomial rolling hash, modulo 2^64
+    return hash*0x100000001b3ULL + static_cast<uint64_t>(static_cast<int64_t>(pivot)) + 1;
+}
+
+} // namespace
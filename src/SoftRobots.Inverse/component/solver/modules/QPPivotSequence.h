@@ -0,0 +1,82 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <sofa/type/vector.h>
+
+#include <SoftRobots.Inverse/component/config.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+using sofa::type::vector;
+
+/// Sequence of pivots (contact constraint ids) of the pivot algorithm, used to detect its cycles. Along with
+/// the pivots, the sequence keeps a polynomial hash of its content and a set of the pivots it holds (a stamp
+/// per id, cleared by a new stamp), so that the tests of the cycle detection are O(1) and do not copy the
+/// sequence: membership, and equality of the sequence with another one extended by a pivot.
+class SOFA_SOFTROBOTS_INVERSE_API QPPivotSequence
+{
+public:
+
+    void clear();
+    void push_back(const int& pivot);
+
+    size_t size() const {return m_pivots.size();}
+    bool empty() const {return m_pivots.empty();}
+    int operator[](const size_t& i) const {return m_pivots[i];}
+    int front() const {return m_pivots.front();}
+    int back() const {return m_pivots.back();}
+
+    bool contains(const int& pivot) const;
+
+    /// Whether this sequence is the sequence prefix followed by the pivot. The hashes are compared first,
+    /// the pivots are only compared when they match (i.e. when a cycle is detected).
+    bool isExtensionOf(const QPPivotSequence& prefix, const int& pivot) const;
+
+    /// Constant time exchange of the content, to move a sequence to another one
+    void swap(QPPivotSequence& other);
+
+    size_t getMemoryUsage() const;
+
+protected:
+
+    static uint64_t extendHash(const uint64_t& hash, const int& pivot);
+
+    vector<int> m_pivots;
+    uint64_t m_hash{0};
+    vector<unsigned int> m_stamps; // by pivot, m_stamp if the pivot is in the sequence
+    unsigned int m_stamp{1};
+};
+
+} // namespace
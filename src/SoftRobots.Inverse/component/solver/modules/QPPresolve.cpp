@@ -0,0 +1,204 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <unordered_map>
+#include <SoftRobots.Inverse/component/solver/modules/QPPresolve.h>
+
+namespace softrobotsinverse::solver::module
+{
+
+using sofa::type::vector;
+
+
+unsigned int QPPresolve::apply(QPInverseProblem::QPSystem* qpSystem, vector<int>& constraintsId)
+{
+    m_nbConstantRows = 0;
+    m_nbDuplicateRows = 0;
+
+    QPInverseProblem::QPMatrix& A = qpSystem->A;
+    QPInverseProblem::QPMatrix& Aeq = qpSystem->Aeq;
+    const unsigned int dim = qpSystem->dim;
+    const unsigned int ASize = A.size();
+    const unsigned int AeqSize = Aeq.size();
+    if(dim == 0 || ASize + AeqSize == 0)
+        return 0;
+
+    double maxEntry = 0.;
+    for(unsigned int i=0; i<ASize*dim; i++)
+        maxEntry = std::max(maxEntry, std::abs(A.data()[i]));
+    for(unsigned int i=0; i<AeqSize*dim; i++)
+        maxEntry = std::max(maxEntry, std::abs(Aeq.data()[i]));
+    const double zero = m_tolerance*std::max(maxEntry, 1.);
+
+    const bool hasBounds = (qpSystem->l.size() == dim && qpSystem->u.size() == dim);
+    m_isFixed.assign(dim, false);
+    if(hasBounds)
+        for(unsigned int j=0; j<dim; j++)
+            m_isFixed[j] = (qpSystem->l[j] == qpSystem->u[j]);
+    const double* l = (hasBounds)? qpSystem->l.data() : nullptr;
+
+    const bool hasLowerBounds = qpSystem->hasBothSideInequalityConstraint && qpSystem->bl.size() == ASize;
+    m_isKept.assign(ASize + AeqSize, true);
+    m_hashes.resize(ASize + AeqSize);
+
+    // Rows of A, then of Aeq, by hash of their entries: a duplicate is only looked for among the rows
+    // of the same matrix
+    std::unordered_multimap<size_t, unsigned int> rowsByHash;
+    for(unsigned int k=0; k<ASize+AeqSize; k++)
+    {
+        const bool isEquality = (k >= ASize);
+        const unsigned int i = (isEquality)? k-ASize : k;
+        const double* row = (isEquality)? Aeq[i] : A[i];
+        if(k == ASize)
+            rowsByHash.clear();
+
+        double value = 0.;
+        if(getConstantValue(row, dim, l, zero, value))
+        {
+            const double feasibility = 1e-9*std::max(1., std::abs(value));
+            bool isSatisfied;
+            if(isEquality)
+                isSatisfied = std::abs(value - qpSystem->beq[i]) <= feasibility;
+            else
+                isSatisfied = value <= qpSystem->bu[i] + feasibility
+                        && (!hasLowerBounds || value >= qpSystem->bl[i] - feasibility);
+            if(isSatisfied)
+            {
+                m_isKept[k] = false;
+                m_nbConstantRows++;
+                continue;
+            }
+        }
+
+        const size_t hash = hashRow(row, dim);
+        bool isDuplicate = false;
+        auto range = rowsByHash.equal_range(hash);
+        for(auto it=range.first; it!=range.second && !isDuplicate; ++it)
+        {
+            const unsigned int first = it->second;
+            if(std::memcmp(row, (isEquality)? Aeq[first-ASize] : A[first], dim*sizeof(double)) != 0)
+                continue;
+
+            if(isEquality)
+            {
+                isDuplicate = (qpSystem->beq[i] == qpSystem->beq[first-ASize]);
+                continue;
+            }
+
+            const double bu = std::min(qpSystem->bu[i], qpSystem->bu[first]);
+            const double bl = (hasLowerBounds)? std::max(qpSystem->bl[i], qpSystem->bl[first]) : -1e99;
+            if(bl > bu)
+                continue;
+            qpSystem->bu[first] = bu;
+            if(hasLowerBounds)
+                qpSystem->bl[first] = bl;
+            isDuplicate = true;
+        }
+
+        if(isDuplicate)
+        {
+            m_isKept[k] = false;
+            m_nbDuplicateRows++;
+        }
+        else
+            rowsByHash.emplace(hash, k);
+    }
+
+    const unsigned int nbRemovedRows = getNbRemovedRows();
+    if(nbRemovedRows == 0)
+        return 0;
+
+    if(constraintsId.size() == ASize + AeqSize)
+    {
+        unsigned int nbKept = 0;
+        for(unsigned int k=0; k<ASize+AeqSize; k++)
+            if(m_isKept[k])
+                constraintsId[nbKept++] = constraintsId[k];
+        constraintsId.resize(nbKept);
+    }
+
+    removeRows(A, m_isKept.data(), &qpSystem->bu, (qpSystem->bl.size() == ASize)? &qpSystem->bl : nullptr);
+    removeRows(Aeq, m_isKept.data() + ASize, &qpSystem->beq, nullptr);
+    return nbRemovedRows;
+}
+
+
+bool QPPresolve::getConstantValue(const double* row, const unsigned int& dim, const double* l,
+                                  const double& zero, double& value) const
+{
+    value = 0.;
+    for(unsigned int j=0; j<dim; j++)
+    {
+        if(std::abs(row[j]) <= zero)
+            continue;
+        if(!m_isFixed[j])
+            return false;
+        value += row[j]*l[j];
+    }
+    return true;
+}
+
+
+size_t QPPresolve::hashRow(const double* row, const unsigned int& dim)
+{
+    size_t hash = dim;
+    std::hash<double> hasher;
+    for(unsigned int j=0; j<dim; j++)
+        hash ^= hasher(row[j]) + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+    return hash;
+}
+
+
+void QPPresolve::removeRows(QPInverseProblem::QPMatrix& M, const char* isKept, vector<double>* b1, vector<double>* b2)
+{
+    const unsigned int nbRows = M.size();
+    const unsigned int nbCols = M.nbCols();
+    unsigned int nbKept = 0;
+    for(unsigned int i=0; i<nbRows; i++)
+    {
+        if(!isKept[i])
+            continue;
+        if(nbKept != i)
+        {
+            std::copy(M[i], M[i] + nbCols, M[nbKept]);
+            if(b1) (*b1)[nbKept] = (*b1)[i];
+            if(b2) (*b2)[nbKept] = (*b2)[i];
+        }
+        nbKept++;
+    }
+
+    M.resize(nbKept, nbCols);
+    if(b1) b1->resize(nbKept);
+    if(b2) b2->resize(nbKept);
+}
+
+} // namespace
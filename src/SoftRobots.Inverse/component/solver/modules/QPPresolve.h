@@ -0,0 +1,82 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <sofa/type/vector.h>
+
+#include <SoftRobots.Inverse/component/solver/modules/QPInverseProblem.h>
+#include <SoftRobots.Inverse/component/config.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+using sofa::type::vector;
+
+/// Removes from the constraints [A; Aeq] of a QP system, before the QP is solved, the rows that do not
+/// constrain it:
+/// - the constant rows, whose entries are all ~0 (e.g. a contact on a fixed node) or only multiply fixed
+///   variables (l = u), and whose bounds are satisfied by their constant value,
+/// - the rows identical to a previous one, whose bounds are merged into the first one (the intersection).
+/// The tolerance on the zero entries is relative to the largest entry of [A; Aeq]. The constant rows
+/// violating their bounds and the duplicates with disjoint bounds are kept, for the infeasibility
+/// handling of the QP. The variables are not removed: the fixed ones are equality bounds for qpOASES,
+/// and the solution and the pivots of the contacts keep the layout of the QP variables.
+/// The removed rows are taken out of the constraint ids as well, so that the dual solution of the
+/// reduced QP is read with them. The dual of a merged row is the one of the first row.
+class SOFA_SOFTROBOTS_INVERSE_API QPPresolve
+{
+public:
+    void setTolerance(const double& tolerance) {m_tolerance = tolerance;}
+
+    /// Removes the rows from A, bl, bu, Aeq, beq and constraintsId (if it has a row per constraint),
+    /// returns the number of removed rows
+    unsigned int apply(QPInverseProblem::QPSystem* qpSystem, vector<int>& constraintsId);
+
+    /// Removed rows of the last call
+    unsigned int getNbRemovedRows() const {return m_nbConstantRows + m_nbDuplicateRows;}
+    unsigned int getNbConstantRows() const {return m_nbConstantRows;}
+    unsigned int getNbDuplicateRows() const {return m_nbDuplicateRows;}
+
+protected:
+    double m_tolerance{1e-12};
+    unsigned int m_nbConstantRows{0};
+    unsigned int m_nbDuplicateRows{0};
+
+    vector<char> m_isFixed; // for each variable
+    vector<char> m_isKept;  // for each row of [A; Aeq]
+    vector<size_t> m_hashes;
+
+    bool getConstantValue(const double* row, const unsigned int& dim, const double* l,
+                          const double& zero, double& value) const;
+    static size_t hashRow(const double* row, const unsigned int& dim);
+    static void removeRows(QPInverseProblem::QPMatrix& M, const char* isKept, vector<double>* b1, vector<double>* b2);
+};
+
+} // namespace
@@ -0,0 +1,201 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#include <algorithm>
+#include <SoftRobots.Inverse/component/solver/modules/QPPrioritizedProblem.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+using Eigen::MatrixXd;
+using Eigen::VectorXd;
+
+namespace
+{
+constexpr double s_infinity = 1e99;
+constexpr double s_finiteBound = 1e20; // beyond, a bound is infinite for qpOASES
+constexpr double s_regularization = 1e-12; // relative, on the Hessians of the levels without energy
+}
+
+
+unsigned int QPPrioritizedProblem::getNbLevels(const vector<unsigned int>& rowLevels)
+{
+    vector<unsigned int> levels(rowLevels.begin(), rowLevels.end());
+    std::sort(levels.begin(), levels.end());
+    return std::unique(levels.begin(), levels.end()) - levels.begin();
+}
+
+
+bool QPPrioritizedProblem::solve(const vector<unsigned int>& rowLevels, ConstRefMat Wea, ConstRefVec dFree,
+                                 ConstRefMat energy, const int& nbConstraints, const double* A,
+                                 const double* lb, const double* ub, const double* lbA, const double* ubA,
+                                 vector<double>& x)
+{
+    const Eigen::Index n = Wea.cols();
+    if(rowLevels.size() != size_t(Wea.rows()))
+        return false;
+
+    m_levels.assign(rowLevels.begin(), rowLevels.end());
+    std::sort(m_levels.begin(), m_levels.end());
+    m_levels.erase(std::unique(m_levels.begin(), m_levels.end()), m_levels.end());
+    m_levelDimensions.clear();
+    m_nbIterations = 0;
+
+    m_x = VectorXd::Zero(n);
+    m_N = MatrixXd::Identity(n, n);
+    for(unsigned int k=0; k<m_levels.size(); k++)
+    {
+        // No freedom left, the next levels can not change the solution
+        if(m_N.cols() == 0)
+            break;
+
+        Eigen::Index nbRows = 0;
+        for(const unsigned int& level : rowLevels)
+            nbRows += (level == m_levels[k])? 1 : 0;
+        m_E.resize(nbRows, n);
+        m_d.resize(nbRows);
+        for(Eigen::Index i=0, row=0; i<Wea.rows(); i++)
+        {
+            if(rowLevels[i] != m_levels[k])
+                continue;
+            m_E.row(row) = Wea.row(i);
+            m_d(row++) = dFree(i);
+        }
+
+        const bool isLast = (k+1 == m_levels.size());
+        if(!solveLevel(k==0, isLast, energy, nbConstraints, A, lb, ub, lbA, ubA))
+            return false;
+        if(!isLast)
+            updateNullSpace();
+    }
+
+    x.resize(n);
+    for(Eigen::Index i=0; i<n; i++)
+        x[i] = m_x(i);
+    return true;
+}
+
+
+bool QPPrioritizedProblem::solveLevel(const bool& isFirst, const bool& isLast, ConstRefMat energy,
+                                      const int& nbConstraints, const double* A,
+                                      const double* lb, const double* ub, const double* lbA, const double* ubA)
+{
+    const Eigen::Index n = m_N.rows();
+    const Eigen::Index r = m_N.cols();
+    m_levelDimensions.push_back(r);
+
+    // min 1/2 |E (x + N z) + d|^2 (+ 1/2 (x + N z)^T energy (x + N z) on the last level)
+    m_EN.noalias() = m_E*m_N;
+    m_H.resize(r, r);
+    m_H.noalias() = m_EN.transpose()*m_EN;
+    VectorXd g = m_EN.transpose()*(m_E*m_x + m_d);
+    if(isLast)
+    {
+        m_H.noalias() += m_N.transpose()*energy*m_N;
+        g.noalias() += m_N.transpose()*(energy*m_x);
+    }
+    else
+    {
+        // The task of a level rarely spans all the free directions
+        const double scale = std::max(m_H.diagonal().cwiseAbs().maxCoeff(), 1.);
+        m_H.diagonal().array() += s_regularization*scale;
+    }
+    m_g.assign(g.data(), g.data()+r);
+
+    // At the first level z = x, the bounds of x are kept as bounds. Afterwards, the bounded rows of
+    // x + N z are general constraints.
+    const Eigen::Map<const RowMajorMatrixXd> Ax(A, nbConstraints, n);
+    const VectorXd ANx = (nbConstraints>0)? VectorXd(Ax*m_x) : VectorXd();
+    vector<Eigen::Index> boundedRows;
+    if(!isFirst)
+        for(Eigen::Index i=0; i<n; i++)
+            if(lb[i] > -s_finiteBound || ub[i] < s_finiteBound)
+                boundedRows.push_back(i);
+
+    const Eigen::Index nbBoundedRows = boundedRows.size();
+    const int nbRows = int(nbBoundedRows) + nbConstraints;
+    m_A.resize(nbRows, r);
+    m_lbA.resize(nbRows);
+    m_ubA.resize(nbRows);
+    for(Eigen::Index k=0; k<nbBoundedRows; k++)
+    {
+        const Eigen::Index i = boundedRows[k];
+        m_A.row(k) = m_N.row(i);
+        m_lbA[k] = (lb[i] > -s_finiteBound)? lb[i] - m_x(i) : -s_infinity;
+        m_ubA[k] = (ub[i] < s_finiteBound)? ub[i] - m_x(i) : s_infinity;
+    }
+    if(nbConstraints>0)
+        m_A.bottomRows(nbConstraints).noalias() = Ax*m_N;
+    for(int i=0; i<nbConstraints; i++)
+    {
+        m_lbA[nbBoundedRows+i] = (lbA[i] > -s_finiteBound)? lbA[i] - ANx(i) : -s_infinity;
+        m_ubA[nbBoundedRows+i] = (ubA[i] < s_finiteBound)? ubA[i] - ANx(i) : s_infinity;
+    }
+
+    m_lb.resize(r);
+    m_ub.resize(r);
+    for(Eigen::Index j=0; j<r; j++)
+    {
+        m_lb[j] = (isFirst)? lb[j] : -s_infinity;
+        m_ub[j] = (isFirst)? ub[j] : s_infinity;
+    }
+
+    m_z.resize(r);
+    m_y.resize(r + nbRows);
+    real_t objective = 0.;
+    if(!m_backend.solve(int(r), nbRows, m_H.data(), m_g.data(), (nbRows>0)? m_A.data() : nullptr,
+                        m_lb.data(), m_ub.data(), (nbRows>0)? m_lbA.data() : nullptr, (nbRows>0)? m_ubA.data() : nullptr,
+                        m_z.data(), m_y.data(), objective))
+        return false;
+    m_nbIterations += m_backend.getNbIterations();
+
+    m_x.noalias() += m_N*Eigen::Map<const VectorXd>(m_z.data(), r);
+    return true;
+}
+
+
+void QPPrioritizedProblem::updateNullSpace()
+{
+    // E N = P R^T Q^T, the last columns of Q (after the rank) span the null space of the projected task
+    const Eigen::Index r = m_N.cols();
+    if(m_EN.rows() == 0)
+        return;
+
+    m_qr.setThreshold(m_rankTolerance);
+    m_qr.compute(m_EN.transpose());
+    m_nbFactorizations++;
+    const Eigen::Index rank = m_qr.rank();
+    if(rank == 0)
+        return;
+
+    const MatrixXd Q = m_qr.householderQ();
+    m_N = m_N*Q.rightCols(r - rank);
+}
+
+} // namespace
@@ -0,0 +1,106 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <Eigen/Core>
+#include <Eigen/QR>
+#include <sofa/type/vector.h>
+
+#include <SoftRobots.Inverse/component/solver/modules/QPSolverBackend.h>
+#include <SoftRobots.Inverse/component/config.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+using sofa::type::vector;
+
+/// Lexicographic resolution of the QP when the effector rows have several priority levels (see
+/// behavior::EffectorPriority). With E_k and d_k the (weighted) rows of Wea and dFree_e of the level k,
+/// the levels are solved in increasing order:
+///     min 1/2 |E_k x + d_k|^2    s.t.    lb <= x <= ub,    lbA <= A x <= ubA,    E_j x = E_j x_j  (j < k)
+/// the energy term of the single QP being only added to the last level. The solution of a level is kept
+/// by the next ones by searching x = x_k + N_k z in the null space N_k of the levels before, so that the
+/// QP of a level only has the remaining degrees of freedom as variables, and a lower level does not
+/// trade off a higher one. N_k is obtained from N_{k-1} and a QR factorization of the projected task
+/// E_k N_{k-1} only, the factorizations of the previous levels being reused.
+class SOFA_SOFTROBOTS_INVERSE_API QPPrioritizedProblem
+{
+public:
+    typedef const Eigen::Ref<const Eigen::MatrixXd> ConstRefMat;
+    typedef const Eigen::Ref<const Eigen::VectorXd> ConstRefVec;
+    typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> RowMajorMatrixXd;
+
+    /// Number of distinct levels of the rows
+    static unsigned int getNbLevels(const vector<unsigned int>& rowLevels);
+
+    /// Solves the levels of the rows of Wea (rowLevels, one per row) and writes the solution into x.
+    /// energy is the part of the Hessian of the single QP that is not Wea^T Wea. A (nbConstraints x n,
+    /// row-major), lb, ub, lbA and ubA are the constraints as given to qpOASES. Returns false if the
+    /// QP of a level could not be solved.
+    bool solve(const vector<unsigned int>& rowLevels, ConstRefMat Wea, ConstRefVec dFree, ConstRefMat energy,
+               const int& nbConstraints, const double* A, const double* lb, const double* ub,
+               const double* lbA, const double* ubA, vector<double>& x);
+
+    /// Relative tolerance on the pivots of the QR factorization of a level, below which a direction is
+    /// considered free of the task
+    void setRankTolerance(const double& tolerance) {m_rankTolerance = tolerance;}
+
+    /// Number of variables of the QP of each level of the last resolution
+    const vector<unsigned int>& getLevelDimensions() const {return m_levelDimensions;}
+    /// Number of QR factorizations of the projected tasks, counted since the creation
+    unsigned int getNbFactorizations() const {return m_nbFactorizations;}
+    /// Working set changes of the QPs of the last resolution
+    int getNbIterations() const {return m_nbIterations;}
+
+protected:
+    double m_rankTolerance{1e-9};
+    vector<unsigned int> m_levels;
+    vector<unsigned int> m_levelDimensions;
+    unsigned int m_nbFactorizations{0};
+    int m_nbIterations{0};
+
+    Eigen::VectorXd m_x;
+    Eigen::MatrixXd m_N;  // Basis of the null space of the levels solved, n x r
+    Eigen::MatrixXd m_E;  // Rows of the level
+    Eigen::VectorXd m_d;
+    Eigen::MatrixXd m_EN; // Projected task
+    Eigen::ColPivHouseholderQR<Eigen::MatrixXd> m_qr;
+
+    // QP of the level, in the variables z of the null space
+    QPOASESSolverBackend m_backend;
+    RowMajorMatrixXd m_H, m_A;
+    vector<real_t> m_g, m_lb, m_ub, m_lbA, m_ubA, m_z, m_y;
+
+    bool solveLevel(const bool& isFirst, const bool& isLast, ConstRefMat energy, const int& nbConstraints,
+                    const double* A, const double* lb, const double* ub, const double* lbA, const double* ubA);
+    void updateNullSpace();
+};
+
+} // namespace
@@ -0,0 +1,170 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <SoftRobots.Inverse/component/solver/modules/QPProblemCapture.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+void QPProblemCapture::setWindowSize(const unsigned int& windowSize)
+{
+    if(windowSize == m_slots.size())
+        return;
+
+    m_slots.clear();
+    m_slots.resize(windowSize);
+    m_first = 0;
+    m_nbSlots = 0;
+}
+
+
+void QPProblemCapture::beginStep()
+{
+    m_QNorm = 0.;
+    m_hasQNorm = false;
+}
+
+
+void QPProblemCapture::capture(const QPSystem& qpSystem, const QPConstraintLists& qpCLists,
+                               const double& time, const double& objective, const int& iterations)
+{
+    if(m_slots.empty())
+        return;
+
+    // The oldest problem is overwritten once the window is full, its buffer is reused
+    Slot& slot = m_slots[(m_first + m_nbSlots) % m_slots.size()];
+    if(m_nbSlots < m_slots.size())
+        m_nbSlots++;
+    else
+        m_first = (m_first + 1) % m_slots.size();
+
+    slot.step = m_nbSteps++;
+    QPProblemRecorder::encodeStep(qpSystem, qpCLists, slot.step, time, objective, iterations, slot.data);
+
+    // Infinity norm of Q: the largest absolute sum of a row (of a column, Q being symmetric)
+    const QPInverseProblem::QPMatrix& Q = qpSystem.Q;
+    for(unsigned int i=0; i<Q.nbRows(); i++)
+    {
+        const double* row = Q.data() + i*Q.nbCols();
+        double sum = 0.;
+        for(unsigned int j=0; j<Q.nbCols(); j++)
+            sum += std::abs(row[j]);
+        m_QNorm = std::max(m_QNorm, sum);
+    }
+    m_hasQNorm = true;
+}
+
+
+double QPProblemCapture::getQNormVariation() const
+{
+    if(!m_hasQNorm || m_previousQNorm <= 0.)
+        return 0.;
+    return std::abs(m_QNorm - m_previousQNorm)/m_previousQNorm*100.;
+}
+
+
+int QPProblemCapture::getEvents(const bool& infeasible, const int& nbPivots, const double& solveTime) const
+{
+    int events = 0;
+    if(m_triggers.infeasible && infeasible)
+        events |= Infeasible;
+    if(m_triggers.maxNbPivots > 0 && nbPivots > m_triggers.maxNbPivots)
+        events |= Pivots;
+    if(m_triggers.timeBudget > 0. && solveTime > m_triggers.timeBudget)
+        events |= SolveTime;
+    if(m_triggers.maxQNormVariation > 0. && getQNormVariation() > m_triggers.maxQNormVariation)
+        events |= QNormVariation;
+    return events;
+}
+
+
+void QPProblemCapture::endStep()
+{
+    if(m_hasQNorm)
+        m_previousQNorm = m_QNorm;
+}
+
+
+bool QPProblemCapture::dump(const std::string& filename, const bool& compress)
+{
+    // Opening the file waits for the previous dump
+    if(!m_recorder.open(filename, compress))
+        return false;
+
+    m_recorder.setMaxPendingSteps(m_nbSlots);
+    for(unsigned int k=0; k<m_nbSlots; k++)
+    {
+        Slot& slot = m_slots[(m_first + k) % m_slots.size()];
+        m_recorder.recordEncoded(slot.step, slot.data);
+    }
+    m_first = 0;
+    m_nbSlots = 0;
+    return true;
+}
+
+
+void QPProblemCapture::close()
+{
+    m_recorder.close();
+}
+
+
+std::string QPProblemCapture::getEventNames(const int& events)
+{
+    static const std::pair<Event, const char*> names[] = {{Infeasible, "infeasible QP"},
+                                                          {Pivots, "contact pivots"},
+                                                          {SolveTime, "solve time"},
+                                                          {QNormVariation, "Q norm variation"}};
+    std::string result;
+    for(const auto& [event, name] : names)
+    {
+        if(!(events & event))
+            continue;
+        if(!result.empty())
+            result += ", ";
+        result += name;
+    }
+    return result;
+}
+
+
+std::string QPProblemCapture::getDumpName(const std::string& filename, const unsigned int& index)
+{
+    const size_t separator = filename.find_last_of("/\\");
+    const size_t dot = filename.find_last_of('.');
+    const std::string suffix = "_" + std::to_string(index);
+    if(dot == std::string::npos || dot == 0 || (separator != std::string::npos && dot <= separator + 1))
+        return filename + suffix;
+    return filename.substr(0, dot) + suffix + filename.substr(dot);
+}
+
+} // namespace
@@ -0,0 +1,113 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <sofa/type/vector.h>
+
+#include <SoftRobots.Inverse/component/solver/modules/QPProblemRecorder.h>
+#include <SoftRobots.Inverse/component/config.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+/// Rolling window of the last problems solved, kept in memory in the encoding of QPProblemRecorder, and
+/// dumped to a recording only when an anomaly occurs: an infeasible QP, too many contact pivots, a
+/// resolution over its time budget, or a large variation of the infinity norm of Q since the last step.
+/// The dump is written by the background thread of a recorder, replayed as any recording.
+class SOFA_SOFTROBOTS_INVERSE_API QPProblemCapture
+{
+public:
+    typedef QPInverseProblem::QPSystem QPSystem;
+    typedef QPInverseProblem::QPConstraintLists QPConstraintLists;
+
+    enum Event {Infeasible = 1, Pivots = 2, SolveTime = 4, QNormVariation = 8};
+
+    /// Thresholds of the events, 0 (or false) to disable an event
+    struct Triggers {
+        bool infeasible{true};
+        int maxNbPivots{0};
+        double timeBudget{0.}; // ms
+        double maxQNormVariation{0.}; // relative variation, in %
+    };
+
+    /// Number of problems kept, 0 to disable the capture. The window is cleared.
+    void setWindowSize(const unsigned int& windowSize);
+    unsigned int getWindowSize() const {return m_slots.size();}
+    unsigned int getNbCapturedSteps() const {return m_nbSlots;}
+    bool isEnabled() const {return !m_slots.empty();}
+
+    void setTriggers(const Triggers& triggers) {m_triggers = triggers;}
+    const Triggers& getTriggers() const {return m_triggers;}
+
+    /// Resets the infinity norm of Q of the step
+    void beginStep();
+    /// Adds a problem of the step to the window (the subproblems of a step are added one after the other)
+    void capture(const QPSystem& qpSystem, const QPConstraintLists& qpCLists,
+                 const double& time, const double& objective, const int& iterations);
+    /// Events of the step (a mask of Event), from the problems captured since beginStep()
+    int getEvents(const bool& infeasible, const int& nbPivots, const double& solveTime) const;
+    void endStep();
+
+    /// Relative variation of the infinity norm of Q of this step from the last one, in %
+    double getQNormVariation() const;
+
+    /// Writes the window in the recording filename and clears it. Returns false if the file cannot be opened.
+    bool dump(const std::string& filename, const bool& compress);
+    /// Waits for the last dump to be written
+    void close();
+
+    /// Names of the events of the mask, separated by commas
+    static std::string getEventNames(const int& events);
+    /// filename with _<index> before its extension
+    static std::string getDumpName(const std::string& filename, const unsigned int& index);
+
+protected:
+    struct Slot {
+        uint64_t step{0};
+        vector<char> data;
+    };
+
+    vector<Slot> m_slots; // ring buffer, m_nbSlots steps from m_first
+    unsigned int m_first{0};
+    unsigned int m_nbSlots{0};
+    uint64_t m_nbSteps{0};
+
+    Triggers m_triggers;
+    double m_QNorm{0.}; // maximum over the problems of the step
+    double m_previousQNorm{-1.}; // negative before the first step
+    bool m_hasQNorm{false};
+
+    QPProblemRecorder m_recorder;
+};
+
+} // namespace
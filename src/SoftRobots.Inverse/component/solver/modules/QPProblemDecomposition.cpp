@@ -0,0 +1,262 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+
+#include <numeric>
+#include <SoftRobots.Inverse/component/solver/modules/QPComplianceMatrix.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPProblemDecomposition.h>
+
+namespace softrobotsinverse::solver::module
+{
+
+using sofa::type::vector;
+
+
+unsigned int QPProblemDecomposition::find(unsigned int row)
+{
+    while(m_parent[row] != row)
+    {
+        m_parent[row] = m_parent[m_parent[row]]; // Path halving
+        row = m_parent[row];
+    }
+    return row;
+}
+
+
+void QPProblemDecomposition::join(const unsigned int& row1, const unsigned int& row2)
+{
+    unsigned int root1 = find(row1);
+    unsigned int root2 = find(row2);
+    if(root1 == root2)
+        return;
+
+    // The root is the smallest row, so that the components are ordered by their first row
+    if(root1 < root2)
+        m_parent[root2] = root1;
+    else
+        m_parent[root1] = root2;
+}
+
+
+template<class TConstraint>
+void QPProblemDecomposition::joinConstraintRows(const vector<TConstraint*>& constraints,
+                                                const vector<unsigned int>& rowIds)
+{
+    unsigned int line = 0;
+    for(TConstraint* constraint : constraints)
+    {
+        unsigned int nbLines = constraint->getNbLines();
+        for(unsigned int j=1; j<nbLines; j++)
+            join(rowIds[line], rowIds[line+j]);
+        line += nbLines;
+    }
+}
+
+
+template<class TConstraint>
+void QPProblemDecomposition::dispatchConstraints(const vector<TConstraint*>& constraints,
+                                                 const vector<unsigned int>& rowIds,
+                                                 vector<TConstraint*> QPInverseProblem::QPConstraintLists::* componentConstraints,
+                                                 vector<unsigned int> QPInverseProblem::QPConstraintLists::* componentRowIds)
+{
+    unsigned int line = 0;
+    for(TConstraint* constraint : constraints)
+    {
+        unsigned int nbLines = constraint->getNbLines();
+        if(nbLines == 0)
+            continue;
+
+        QPInverseProblem::QPConstraintLists& lists = m_components[m_componentId[rowIds[line]]].lists;
+        (lists.*componentConstraints).push_back(constraint);
+        for(unsigned int j=0; j<nbLines; j++)
+            (lists.*componentRowIds).push_back(rowIds[line+j]);
+        line += nbLines;
+    }
+}
+
+
+unsigned int QPProblemDecomposition::compute(QPInverseProblem* problem, const unsigned int& contactNbLines)
+{
+    m_components.clear();
+
+    const QPInverseProblem::QPConstraintLists* qpCLists = problem->getQPConstraintLists();
+    const unsigned int dim = problem->getDimension();
+    double** W = problem->getW();
+
+    m_parent.resize(dim);
+    std::iota(m_parent.begin(), m_parent.end(), 0);
+
+    // Rows of a same constraint component, or of a same contact point
+    joinConstraintRows(qpCLists->actuators, qpCLists->actuatorRowIds);
+    joinConstraintRows(qpCLists->equality , qpCLists->equalityRowIds);
+    joinConstraintRows(qpCLists->effectors, qpCLists->effectorRowIds);
+    joinConstraintRows(qpCLists->sensors  , qpCLists->sensorRowIds);
+
+    const vector<unsigned int>& contactRowIds = qpCLists->contactRowIds;
+    for(unsigned int i=0; i+contactNbLines<=contactRowIds.size(); i+=contactNbLines)
+        for(unsigned int j=1; j<contactNbLines; j++)
+            join(contactRowIds[i], contactRowIds[i+j]);
+
+    // Coupling through the compliance, only the entries read by the QP are assembled
+    // (see partialCompliance), so the entries between two effectors or sensors are not considered
+    QPComplianceMatrix::getQPVariableRows(qpCLists, dim, m_isQPVariableRow);
+    for(unsigned int i=0; i<dim; i++)
+    {
+        if(!m_isQPVariableRow[i])
+            continue;
+
+        for(unsigned int j=0; j<dim; j++)
+            if(W[i][j] != 0. || W[j][i] != 0.)
+                join(i, j);
+    }
+
+    // One component per group of rows containing a QP variable
+    m_componentId.assign(dim, -1);
+    vector<int> rootComponentId(dim, -1);
+    for(unsigned int i=0; i<dim; i++)
+    {
+        unsigned int root = find(i);
+        if(m_isQPVariableRow[i] && rootComponentId[root] == -1)
+        {
+            rootComponentId[root] = m_components.size();
+            m_components.emplace_back();
+        }
+    }
+
+    if(m_components.size() < 2)
+    {
+        m_components.clear();
+        return (dim>0)? 1 : 0;
+    }
+
+    for(unsigned int i=0; i<dim; i++)
+        m_componentId[i] = std::max(0, rootComponentId[find(i)]);
+
+    dispatchConstraints(qpCLists->actuators, qpCLists->actuatorRowIds,
+                        &QPInverseProblem::QPConstraintLists::actuators, &QPInverseProblem::QPConstraintLists::actuatorRowIds);
+    dispatchConstraints(qpCLists->equality, qpCLists->equalityRowIds,
+                        &QPInverseProblem::QPConstraintLists::equality, &QPInverseProblem::QPConstraintLists::equalityRowIds);
+    dispatchConstraints(qpCLists->effectors, qpCLists->effectorRowIds,
+                        &QPInverseProblem::QPConstraintLists::effectors, &QPInverseProblem::QPConstraintLists::effectorRowIds);
+    dispatchConstraints(qpCLists->sensors, qpCLists->sensorRowIds,
+                        &QPInverseProblem::QPConstraintLists::sensors, &QPInverseProblem::QPConstraintLists::sensorRowIds);
+
+    const bool hasContactIds = (qpCLists->contactIds.size() == contactRowIds.size());
+    for(unsigned int i=0; i<contactRowIds.size(); i++)
+    {
+        QPInverseProblem::QPConstraintLists& lists = m_components[m_componentId[contactRowIds[i]]].lists;
+        lists.contactRowIds.push_back(contactRowIds[i]);
+        if(hasContactIds)
+            lists.contactIds.push_back(qpCLists->contactIds[i]);
+    }
+
+    // The contact components can not be attributed to a subproblem from the row ids,
+    // they are only used to report infeasible problems
+    for(Component& component : m_components)
+        if(!component.lists.contactRowIds.empty())
+            component.lists.contacts = qpCLists->contacts;
+
+    // Rows of each component, and their index in the subproblem
+    m_localRow.assign(dim, 0);
+    for(unsigned int i=0; i<dim; i++)
+    {
+        vector<unsigned int>& rows = m_components[m_componentId[i]].rows;
+        m_localRow[i] = rows.size();
+        rows.push_back(i);
+    }
+
+    return m_components.size();
+}
+
+
+void QPProblemDecomposition::setLocalRowIds(const vector<unsigned int>& rowIds,
+                                            vector<unsigned int>& localRowIds) const
+{
+    localRowIds.resize(rowIds.size());
+    for(unsigned int i=0; i<rowIds.size(); i++)
+        localRowIds[i] = m_localRow[rowIds[i]];
+}
+
+
+void QPProblemDecomposition::setSubproblem(const unsigned int& i, QPInverseProblem* problem,
+                                           QPInverseProblem* subproblem) const
+{
+    const Component& component = m_components[i];
+    const vector<unsigned int>& rows = component.rows;
+    const unsigned int nbRows = rows.size();
+
+    subproblem->clear(nbRows);
+
+    double** W = problem->getW();
+    double* dFree = problem->getDfree();
+    double** subW = subproblem->getW();
+    double* subDFree = subproblem->getDfree();
+    for(unsigned int j=0; j<nbRows; j++)
+    {
+        subDFree[j] = dFree[rows[j]];
+        for(unsigned int k=0; k<nbRows; k++)
+            subW[j][k] = W[rows[j]][rows[k]];
+    }
+
+    QPInverseProblem::QPConstraintLists* subLists = subproblem->getQPConstraintLists();
+    subLists->actuators = component.lists.actuators;
+    subLists->equality  = component.lists.equality;
+    subLists->effectors = component.lists.effectors;
+    subLists->sensors   = component.lists.sensors;
+    subLists->contacts  = component.lists.contacts;
+    subLists->contactIds = component.lists.contactIds;
+    subLists->disabledConstraints = problem->getQPConstraintLists()->disabledConstraints;
+
+    setLocalRowIds(component.lists.actuatorRowIds, subLists->actuatorRowIds);
+    setLocalRowIds(component.lists.equalityRowIds, subLists->equalityRowIds);
+    setLocalRowIds(component.lists.effectorRowIds, subLists->effectorRowIds);
+    setLocalRowIds(component.lists.sensorRowIds  , subLists->sensorRowIds);
+    setLocalRowIds(component.lists.contactRowIds , subLists->contactRowIds);
+}
+
+
+void QPProblemDecomposition::mergeResults(const unsigned int& i, QPInverseProblem* subproblem,
+                                          QPInverseProblem* problem) const
+{
+    const vector<unsigned int>& rows = m_components[i].rows;
+
+    double* lambda = problem->getF();
+    double* subLambda = subproblem->getF();
+    vector<double>& delta = problem->getQPSystem()->delta;
+    const vector<double>& subDelta = subproblem->getQPSystem()->delta;
+
+    delta.resize(problem->getDimension());
+    for(unsigned int j=0; j<rows.size(); j++)
+    {
+        lambda[rows[j]] = subLambda[j];
+        if(j<subDelta.size())
+            delta[rows[j]] = subDelta[j];
+    }
+}
+
+} // namespace
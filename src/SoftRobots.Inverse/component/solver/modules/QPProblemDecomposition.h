@@ -0,0 +1,96 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <sofa/type/vector.h>
+
+#include <SoftRobots.Inverse/component/solver/modules/QPInverseProblem.h>
+#include <SoftRobots.Inverse/component/config.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+using sofa::type::vector;
+
+/// Splits an inverse problem into independent subproblems.
+/// Two constraint rows are coupled if one of them is a QP variable (actuator, equality or contact)
+/// and their entry in the compliance matrix W is not zero. The rows of a same constraint component,
+/// and of a same contact point, are always kept together. Each connected component of the coupling
+/// graph is a subproblem that can be solved separately, e.g. one per robot when several robots
+/// without mechanical interaction are driven by the same solver.
+/// The rows that are not coupled to any QP variable (effectors or sensors alone) are gathered in
+/// the first subproblem.
+class SOFA_SOFTROBOTS_INVERSE_API QPProblemDecomposition
+{
+public:
+
+    struct Component{
+        QPInverseProblem::QPConstraintLists lists; // Row ids in the rows of the whole problem
+        vector<unsigned int> rows; // Rows of the whole problem, sorted
+    };
+
+    /// Computes the subproblems of the problem, returns their number
+    unsigned int compute(QPInverseProblem* problem, const unsigned int& contactNbLines);
+
+    unsigned int getNbComponents() const {return m_components.size();}
+    const Component& getComponent(const unsigned int& i) const {return m_components[i];}
+
+    /// Sets the constraint lists, the compliance matrix and dfree of the i-th subproblem
+    void setSubproblem(const unsigned int& i, QPInverseProblem* problem, QPInverseProblem* subproblem) const;
+
+    /// Copies lambda and delta of the i-th subproblem in the rows of the whole problem
+    void mergeResults(const unsigned int& i, QPInverseProblem* subproblem, QPInverseProblem* problem) const;
+
+protected:
+
+    vector<Component> m_components;
+
+    // Union-find over the rows of the problem
+    vector<unsigned int> m_parent;
+    vector<bool> m_isQPVariableRow;
+    vector<int> m_componentId; // Per row, -1 for the rows that are not constraint rows
+    vector<unsigned int> m_localRow; // Per row, its index in the rows of its component
+
+    unsigned int find(unsigned int row);
+    void join(const unsigned int& row1, const unsigned int& row2);
+
+    template<class TConstraint>
+    void joinConstraintRows(const vector<TConstraint*>& constraints, const vector<unsigned int>& rowIds);
+
+    template<class TConstraint>
+    void dispatchConstraints(const vector<TConstraint*>& constraints, const vector<unsigned int>& rowIds,
+                             vector<TConstraint*> QPInverseProblem::QPConstraintLists::* componentConstraints,
+                             vector<unsigned int> QPInverseProblem::QPConstraintLists::* componentRowIds);
+
+    void setLocalRowIds(const vector<unsigned int>& rowIds, vector<unsigned int>& localRowIds) const;
+};
+
+} // namespace
+
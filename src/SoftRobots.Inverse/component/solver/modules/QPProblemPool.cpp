@@ -0,0 +1,143 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#include <sofa/simulation/MainTaskSchedulerFactory.h>
+
+#include <SoftRobots.Inverse/component/solver/modules/QPProblemPool.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+QPProblemPool::~QPProblemPool()
+{
+    clear();
+}
+
+
+QPProblemPool& QPProblemPool::getInstance()
+{
+    static QPProblemPool pool;
+    return pool;
+}
+
+
+QPInverseProblemImpl* QPProblemPool::acquire()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(!m_problems.empty())
+        {
+            QPInverseProblemImpl* problem = m_problems.back();
+            m_problems.pop_back();
+            m_nbReuses++;
+            return problem;
+        }
+    }
+    return new QPInverseProblemImpl();
+}
+
+
+void QPProblemPool::release(QPInverseProblemImpl* problem)
+{
+    if(!problem)
+        return;
+
+    // Reset out of the lock, the problem is not shared yet
+    problem->resetResolutionState();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(m_problems.size() < m_capacity)
+        {
+            m_problems.push_back(problem);
+            return;
+        }
+    }
+    delete problem;
+}
+
+
+void QPProblemPool::setCapacity(const unsigned int& capacity)
+{
+    vector<QPInverseProblemImpl*> deleted;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_capacity = capacity;
+        while(m_problems.size() > m_capacity)
+        {
+            deleted.push_back(m_problems.back());
+            m_problems.pop_back();
+        }
+    }
+    for(QPInverseProblemImpl* problem : deleted)
+        delete problem;
+}
+
+
+unsigned int QPProblemPool::getCapacity() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_capacity;
+}
+
+
+unsigned int QPProblemPool::getNbProblems() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_problems.size();
+}
+
+
+unsigned int QPProblemPool::getNbReuses() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_nbReuses;
+}
+
+
+void QPProblemPool::clear()
+{
+    vector<QPInverseProblemImpl*> deleted;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        deleted.swap(m_problems);
+    }
+    for(QPInverseProblemImpl* problem : deleted)
+        delete problem;
+}
+
+
+void QPProblemPool::initTaskScheduler()
+{
+    static std::once_flag initialized;
+    std::call_once(initialized, [](){
+        sofa::simulation::MainTaskSchedulerFactory::createInRegistry()->init();
+    });
+}
+
+} // namespace
@@ -0,0 +1,85 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <mutex>
+#include <sofa/type/vector.h>
+
+#include <SoftRobots.Inverse/component/solver/modules/QPInverseProblemImpl.h>
+#include <SoftRobots.Inverse/component/config.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+using sofa::type::vector;
+
+/// Pool of constraint problems shared by the solvers of a process, for the scenes adding and removing
+/// robots at runtime. The problems of a solver are given back to the pool when it is initialized again or
+/// destroyed, reset to the state of a new problem (see QPInverseProblemImpl::resetResolutionState()), and
+/// the next solvers take them with their buffers instead of allocating new ones. The task scheduler is
+/// also initialized once per process instead of at the initialization of each solver.
+/// The pool is thread-safe. Beyond its capacity, the released problems are deleted.
+class SOFA_SOFTROBOTS_INVERSE_API QPProblemPool
+{
+public:
+    QPProblemPool() {}
+    ~QPProblemPool();
+
+    QPProblemPool(const QPProblemPool&) = delete;
+    QPProblemPool& operator=(const QPProblemPool&) = delete;
+
+    /// Pool of the process
+    static QPProblemPool& getInstance();
+
+    /// A problem of the pool if any, a new one otherwise
+    QPInverseProblemImpl* acquire();
+    /// Gives the problem back to the pool, nullptr is ignored
+    void release(QPInverseProblemImpl* problem);
+
+    void setCapacity(const unsigned int& capacity);
+    unsigned int getCapacity() const;
+    unsigned int getNbProblems() const;
+    /// Problems taken from the pool instead of being allocated
+    unsigned int getNbReuses() const;
+
+    /// Deletes the problems of the pool
+    void clear();
+
+    /// Initializes the main task scheduler with its default number of threads, the first time only
+    static void initTaskScheduler();
+
+protected:
+    mutable std::mutex m_mutex;
+    vector<QPInverseProblemImpl*> m_problems;
+    unsigned int m_capacity{16};
+    unsigned int m_nbReuses{0};
+};
+
+} // namespace
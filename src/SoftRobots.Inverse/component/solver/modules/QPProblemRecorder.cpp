@@ -0,0 +1,565 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+
+#include <cstring>
+#include <sofa/helper/logging/Messaging.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPProblemRecorder.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+namespace
+{
+
+/// Size of the header of a chunk: tag, encoding, raw size, stored size
+constexpr uint64_t s_chunkHeaderSize = 2*sizeof(uint32_t) + 2*sizeof(uint64_t);
+constexpr uint64_t s_fileHeaderSize = 8 + 2*sizeof(uint32_t);
+
+template<class T>
+void append(vector<char>& buffer, const T& value)
+{
+    const size_t size = buffer.size();
+    buffer.resize(size + sizeof(T));
+    std::memcpy(buffer.data() + size, &value, sizeof(T));
+}
+
+template<class T>
+void appendArray(vector<char>& buffer, const T* values, const uint32_t& nbValues)
+{
+    append(buffer, nbValues);
+    if(nbValues == 0)
+        return;
+    const size_t size = buffer.size();
+    buffer.resize(size + nbValues*sizeof(T));
+    std::memcpy(buffer.data() + size, values, nbValues*sizeof(T));
+}
+
+template<class T>
+void appendVector(vector<char>& buffer, const vector<T>& values)
+{
+    appendArray(buffer, values.data(), values.size());
+}
+
+void appendMatrix(vector<char>& buffer, const QPInverseProblem::QPMatrix& matrix)
+{
+    append(buffer, uint32_t(matrix.nbRows()));
+    appendArray(buffer, matrix.data(), matrix.nbRows()*matrix.nbCols());
+}
+
+void appendVarint(vector<char>& buffer, uint64_t value)
+{
+    while(value >= 0x80)
+    {
+        buffer.push_back(char((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    buffer.push_back(char(value));
+}
+
+/// Reads the values of a step buffer, and fails (instead of reading out of the buffer) on a corrupted step
+class BufferReader
+{
+public:
+    BufferReader(const vector<char>& buffer) : m_buffer(buffer) {}
+
+    bool isValid() const {return m_valid;}
+
+    template<class T>
+    void read(T& value)
+    {
+        if(!m_valid || m_position + sizeof(T) > m_buffer.size())
+        {
+            m_valid = false;
+            return;
+        }
+        std::memcpy(&value, m_buffer.data() + m_position, sizeof(T));
+        m_position += sizeof(T);
+    }
+
+    template<class T>
+    void readVector(vector<T>& values)
+    {
+        uint32_t nbValues = 0;
+        read(nbValues);
+        if(!m_valid || m_position + uint64_t(nbValues)*sizeof(T) > m_buffer.size())
+        {
+            m_valid = false;
+            values.clear();
+            return;
+        }
+        values.resize(nbValues);
+        if(nbValues > 0)
+            std::memcpy(values.data(), m_buffer.data() + m_position, nbValues*sizeof(T));
+        m_position += nbValues*sizeof(T);
+    }
+
+    bool readVarint(uint64_t& value)
+    {
+        value = 0;
+        for(unsigned int shift=0; shift<64; shift+=7)
+        {
+            if(m_position >= m_buffer.size())
+                return false;
+            const unsigned char byte = m_buffer[m_position++];
+            value |= uint64_t(byte & 0x7f) << shift;
+            if(!(byte & 0x80))
+                return true;
+        }
+        return false;
+    }
+
+    bool readBytes(char* output, const uint64_t& size)
+    {
+        if(m_position + size > m_buffer.size())
+            return false;
+        std::memcpy(output, m_buffer.data() + m_position, size);
+        m_position += size;
+        return true;
+    }
+
+    bool atEnd() const {return m_position >= m_buffer.size();}
+
+protected:
+    const vector<char>& m_buffer;
+    size_t m_position{0};
+    bool m_valid{true};
+};
+
+} // namespace
+
+
+const char QPProblemRecorder::s_magic[8] = {'S','R','I','Q','P','R','E','C'};
+
+
+QPProblemRecorder::~QPProblemRecorder()
+{
+    close();
+}
+
+
+bool QPProblemRecorder::open(const std::string& filename, const bool& compress)
+{
+    close();
+
+    m_file.open(filename, std::ios::binary | std::ios::trunc);
+    if(!m_file.is_open())
+        return false;
+
+    m_file.write(s_magic, 8);
+    const uint32_t version = s_version;
+    const uint32_t reserved = 0;
+    m_file.write(reinterpret_cast<const char*>(&version), sizeof(uint32_t));
+    m_file.write(reinterpret_cast<const char*>(&reserved), sizeof(uint32_t));
+    m_file.flush();
+
+    m_offset = s_fileHeaderSize;
+    m_compress = compress;
+    m_nbSteps = 0;
+    m_nbRecordedSteps = 0;
+    m_nbFailedSteps = 0;
+    m_stop = false;
+    m_isOpen = true;
+    m_writer = std::thread(&QPProblemRecorder::writeLoop, this);
+    return true;
+}
+
+
+void QPProblemRecorder::close()
+{
+    if(!m_isOpen)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_pendingCondition.notify_one();
+    m_writer.join();
+
+    m_file.close();
+    m_freeBuffers.clear();
+    m_isOpen = false;
+}
+
+
+void QPProblemRecorder::record(const QPSystem& qpSystem, const QPConstraintLists& qpCLists,
+                               const double& time, const double& objective, const int& iterations)
+{
+    if(!m_isOpen)
+        return;
+
+    PendingStep pending;
+    pending.step = m_nbSteps++;
+    waitPendingStep(pending);
+    encodeStep(qpSystem, qpCLists, pending.step, time, objective, iterations, pending.data);
+    pushPendingStep(pending);
+}
+
+
+void QPProblemRecorder::recordEncoded(const uint64_t& step, vector<char>& data)
+{
+    if(!m_isOpen)
+        return;
+
+    PendingStep pending;
+    pending.step = step;
+    waitPendingStep(pending);
+    pending.data.swap(data);
+    pushPendingStep(pending);
+}
+
+
+void QPProblemRecorder::encodeStep(const QPSystem& qpSystem, const QPConstraintLists& qpCLists, const uint64_t& step,
+                                   const double& time, const double& objective, const int& iterations, vector<char>& buffer)
+{
+    buffer.clear();
+    append(buffer, step);
+    append(buffer, time);
+    append(buffer, uint32_t(qpSystem.hasBothSideInequalityConstraint));
+    appendMatrix(buffer, qpSystem.Q);
+    appendVector(buffer, qpSystem.c);
+    appendMatrix(buffer, qpSystem.A);
+    appendVector(buffer, qpSystem.bl);
+    appendVector(buffer, qpSystem.bu);
+    appendMatrix(buffer, qpSystem.Aeq);
+    appendVector(buffer, qpSystem.beq);
+    appendVector(buffer, qpSystem.l);
+    appendVector(buffer, qpSystem.u);
+    appendVector(buffer, qpCLists.actuatorRowIds);
+    appendVector(buffer, qpCLists.effectorRowIds);
+    appendVector(buffer, qpCLists.sensorRowIds);
+    appendVector(buffer, qpCLists.contactRowIds);
+    appendVector(buffer, qpCLists.equalityRowIds);
+    appendVector(buffer, qpSystem.previousResult);
+    appendVector(buffer, qpSystem.lambda);
+    append(buffer, objective);
+    append(buffer, int32_t(iterations));
+}
+
+
+void QPProblemRecorder::waitPendingStep(PendingStep& pending)
+{
+    // Back pressure: a writer that cannot keep up should not make the memory grow without limit
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_writtenCondition.wait(lock, [this]{return m_pending.size() < m_maxPendingSteps;});
+    if(!m_freeBuffers.empty())
+    {
+        pending.data.swap(m_freeBuffers.back());
+        m_freeBuffers.pop_back();
+    }
+}
+
+
+void QPProblemRecorder::pushPendingStep(PendingStep& pending)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pending.push_back(std::move(pending));
+    }
+    m_pendingCondition.notify_one();
+}
+
+
+unsigned int QPProblemRecorder::getNbRecordedSteps() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_nbRecordedSteps;
+}
+
+
+unsigned int QPProblemRecorder::getNbFailedSteps() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_nbFailedSteps;
+}
+
+
+void QPProblemRecorder::writeLoop()
+{
+    vector<char> encoded;
+    while(true)
+    {
+        PendingStep step;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_pendingCondition.wait(lock, [this]{return m_stop || !m_pending.empty();});
+            if(m_pending.empty()) // stopped, and all the steps are written
+                return;
+            step = std::move(m_pending.front());
+            m_pending.pop_front();
+        }
+        m_writtenCondition.notify_one();
+
+        writeStep(step, encoded);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(m_file.good())
+            m_nbRecordedSteps++;
+        else
+            m_nbFailedSteps++;
+        m_freeBuffers.push_back(std::move(step.data));
+    }
+}
+
+
+void QPProblemRecorder::writeStep(PendingStep& step, vector<char>& encoded)
+{
+    if(!m_file.good())
+        return;
+
+    const uint64_t offset = m_offset;
+    const vector<char>* stored = &step.data;
+    uint32_t encoding = RAW;
+    if(m_compress)
+    {
+        encodeZeroRun(step.data, encoded);
+        if(encoded.size() < step.data.size())
+        {
+            stored = &encoded;
+            encoding = ZERO_RUN;
+        }
+    }
+    writeChunk(s_stepTag, encoding, step.data.size(), *stored);
+
+    vector<char> index;
+    append(index, step.step);
+    append(index, offset);
+    append(index, uint64_t(s_chunkHeaderSize + stored->size()));
+    writeChunk(s_indexTag, RAW, index.size(), index);
+
+    // The step is complete in the file once its index is written
+    m_file.flush();
+}
+
+
+void QPProblemRecorder::writeChunk(const uint32_t& tag, const uint32_t& encoding, const uint64_t& rawSize, const vector<char>& data)
+{
+    const uint64_t storedSize = data.size();
+    m_file.write(reinterpret_cast<const char*>(&tag), sizeof(uint32_t));
+    m_file.write(reinterpret_cast<const char*>(&encoding), sizeof(uint32_t));
+    m_file.write(reinterpret_cast<const char*>(&rawSize), sizeof(uint64_t));
+    m_file.write(reinterpret_cast<const char*>(&storedSize), sizeof(uint64_t));
+    m_file.write(data.data(), storedSize);
+    m_offset += s_chunkHeaderSize + storedSize;
+}
+
+
+void QPProblemRecorder::encodeZeroRun(const vector<char>& input, vector<char>& output)
+{
+    output.clear();
+    const uint64_t nbWords = (input.size() + 7)/8;
+
+    auto getWord = [&input](const uint64_t& i) {
+        uint64_t word = 0;
+        std::memcpy(&word, input.data() + i*8, std::min<size_t>(8, input.size() - i*8));
+        return word;
+    };
+
+    uint64_t i = 0;
+    while(i < nbWords)
+    {
+        uint64_t begin = i;
+        while(i < nbWords && getWord(i) != 0)
+            i++;
+        appendVarint(output, i - begin);
+        for(uint64_t k=begin; k<i; k++)
+            append(output, getWord(k));
+
+        begin = i;
+        while(i < nbWords && getWord(i) == 0)
+            i++;
+        appendVarint(output, i - begin);
+    }
+}
+
+
+bool QPProblemRecorder::decodeZeroRun(const vector<char>& input, const uint64_t& size, vector<char>& output)
+{
+    const uint64_t nbWords = (size + 7)/8;
+    output.resize(nbWords*8);
+
+    BufferReader reader(input);
+    uint64_t i = 0;
+    while(i < nbWords)
+    {
+        uint64_t nbLiterals = 0, nbZeros = 0;
+        if(!reader.readVarint(nbLiterals) || i + nbLiterals > nbWords)
+            return false;
+        if(!reader.readBytes(output.data() + i*8, nbLiterals*8))
+            return false;
+        i += nbLiterals;
+
+        if(!reader.readVarint(nbZeros) || i + nbZeros > nbWords)
+            return false;
+        std::memset(output.data() + i*8, 0, nbZeros*8);
+        i += nbZeros;
+    }
+
+    output.resize(size);
+    return reader.atEnd();
+}
+
+
+bool QPProblemReader::open(const std::string& filename)
+{
+    close();
+
+    m_file.open(filename, std::ios::binary);
+    if(!m_file.is_open())
+        return false;
+
+    m_file.seekg(0, std::ios::end);
+    const uint64_t fileSize = m_file.tellg();
+    m_file.seekg(0, std::ios::beg);
+
+    char magic[8];
+    uint32_t version = 0, reserved = 0;
+    m_file.read(magic, 8);
+    m_file.read(reinterpret_cast<char*>(&version), sizeof(uint32_t));
+    m_file.read(reinterpret_cast<char*>(&reserved), sizeof(uint32_t));
+    if(!m_file.good() || std::memcmp(magic, QPProblemRecorder::s_magic, 8) != 0)
+    {
+        close();
+        return false;
+    }
+    if(version > QPProblemRecorder::s_version)
+    {
+        msg_error("QPProblemReader") << "Recording version " << version << " is not supported by this version of the plugin.";
+        close();
+        return false;
+    }
+
+    // Index the steps, an incomplete chunk at the end of the file is ignored
+    uint64_t position = s_fileHeaderSize;
+    while(position + s_chunkHeaderSize <= fileSize)
+    {
+        uint32_t tag = 0, encoding = 0;
+        uint64_t rawSize = 0, storedSize = 0;
+        m_file.seekg(position);
+        m_file.read(reinterpret_cast<char*>(&tag), sizeof(uint32_t));
+        m_file.read(reinterpret_cast<char*>(&encoding), sizeof(uint32_t));
+        m_file.read(reinterpret_cast<char*>(&rawSize), sizeof(uint64_t));
+        m_file.read(reinterpret_cast<char*>(&storedSize), sizeof(uint64_t));
+        if(!m_file.good() || position + s_chunkHeaderSize + storedSize > fileSize)
+            break;
+
+        if(tag == QPProblemRecorder::s_indexTag && storedSize == sizeof(IndexEntry))
+        {
+            IndexEntry entry;
+            m_file.read(reinterpret_cast<char*>(&entry.step), sizeof(uint64_t));
+            m_file.read(reinterpret_cast<char*>(&entry.offset), sizeof(uint64_t));
+            m_file.read(reinterpret_cast<char*>(&entry.size), sizeof(uint64_t));
+            if(m_file.good() && entry.offset + entry.size <= position)
+                m_index.push_back(entry);
+        }
+        position += s_chunkHeaderSize + storedSize;
+    }
+
+    m_file.clear();
+    return true;
+}
+
+
+void QPProblemReader::close()
+{
+    if(m_file.is_open())
+        m_file.close();
+    m_file.clear();
+    m_index.clear();
+}
+
+
+bool QPProblemReader::readStep(const unsigned int& i, QPRecordedStep& step)
+{
+    if(i >= m_index.size())
+        return false;
+
+    const IndexEntry& entry = m_index[i];
+    uint32_t tag = 0, encoding = 0;
+    uint64_t rawSize = 0, storedSize = 0;
+    m_file.clear();
+    m_file.seekg(entry.offset);
+    m_file.read(reinterpret_cast<char*>(&tag), sizeof(uint32_t));
+    m_file.read(reinterpret_cast<char*>(&encoding), sizeof(uint32_t));
+    m_file.read(reinterpret_cast<char*>(&rawSize), sizeof(uint64_t));
+    m_file.read(reinterpret_cast<char*>(&storedSize), sizeof(uint64_t));
+    if(!m_file.good() || tag != QPProblemRecorder::s_stepTag || s_chunkHeaderSize + storedSize != entry.size)
+        return false;
+
+    m_buffer.resize(storedSize);
+    m_file.read(m_buffer.data(), storedSize);
+    if(!m_file.good())
+        return false;
+
+    const vector<char>* data = &m_buffer;
+    if(encoding == QPProblemRecorder::ZERO_RUN)
+    {
+        if(!QPProblemRecorder::decodeZeroRun(m_buffer, rawSize, m_decoded))
+            return false;
+        data = &m_decoded;
+    }
+    else if(encoding != QPProblemRecorder::RAW)
+        return false;
+
+    BufferReader reader(*data);
+    uint32_t hasBothSide = 0, nbRows = 0;
+    int32_t iterations = 0;
+
+    reader.read(step.step);
+    reader.read(step.time);
+    reader.read(hasBothSide);
+    step.hasBothSideInequalityConstraint = hasBothSide;
+    reader.read(nbRows); step.dim = nbRows;
+    reader.readVector(step.Q);
+    reader.readVector(step.c);
+    reader.read(nbRows); step.nbInequalities = nbRows;
+    reader.readVector(step.A);
+    reader.readVector(step.bl);
+    reader.readVector(step.bu);
+    reader.read(nbRows); step.nbEqualities = nbRows;
+    reader.readVector(step.Aeq);
+    reader.readVector(step.beq);
+    reader.readVector(step.l);
+    reader.readVector(step.u);
+    reader.readVector(step.actuatorRowIds);
+    reader.readVector(step.effectorRowIds);
+    reader.readVector(step.sensorRowIds);
+    reader.readVector(step.contactRowIds);
+    reader.readVector(step.equalityRowIds);
+    reader.readVector(step.result);
+    reader.readVector(step.lambda);
+    reader.read(step.objective);
+    reader.read(iterations);
+    step.iterations = iterations;
+
+    return reader.isValid();
+}
+
+} // namespace
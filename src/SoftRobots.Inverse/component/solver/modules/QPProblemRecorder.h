@@ -0,0 +1,193 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <sofa/type/vector.h>
+
+#include <SoftRobots.Inverse/component/solver/modules/QPInverseProblem.h>
+#include <SoftRobots.Inverse/component/config.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+using sofa::type::vector;
+
+/// One step of a recording: the last QP solved (QPSystem), the row ids of the constraint lists,
+/// and the results of the resolution.
+struct SOFA_SOFTROBOTS_INVERSE_API QPRecordedStep
+{
+    uint64_t step{0};
+    double time{0.};
+
+    unsigned int dim{0};
+    unsigned int nbInequalities{0};
+    unsigned int nbEqualities{0};
+    bool hasBothSideInequalityConstraint{false};
+
+    vector<double> Q;   // dim*dim, row-major
+    vector<double> c;
+    vector<double> A;   // nbInequalities*dim, row-major
+    vector<double> bl;  // empty if !hasBothSideInequalityConstraint
+    vector<double> bu;
+    vector<double> Aeq; // nbEqualities*dim, row-major
+    vector<double> beq;
+    vector<double> l;
+    vector<double> u;
+
+    vector<unsigned int> actuatorRowIds;
+    vector<unsigned int> effectorRowIds;
+    vector<unsigned int> sensorRowIds;
+    vector<unsigned int> contactRowIds;
+    vector<unsigned int> equalityRowIds;
+
+    vector<double> result; // solution of the QP
+    vector<double> lambda; // forces in the constraint space
+    double objective{0.};
+    int iterations{0};
+};
+
+
+/// Binary recording of the problems solved by QPInverseProblemSolver, to be replayed offline.
+///
+/// The file starts with a header (magic "SRIQPREC", version), followed by chunks appended one after
+/// the other: a step chunk, then an index chunk giving the step number, offset and size of this step
+/// chunk. A step is only considered recorded once its index chunk is written, so a file cut by a
+/// crash can still be read up to the last complete step. Values are stored in the byte order of the
+/// machine. Step chunks can be compressed with a run-length encoding of the zero words, which
+/// suits the sparse A, Aeq and Q matrices.
+///
+/// record() only copies the problem into a buffer, the encoding and the writing are done by a
+/// background thread. When the writer is more than maxPendingSteps behind, record() waits for it.
+class SOFA_SOFTROBOTS_INVERSE_API QPProblemRecorder
+{
+public:
+    typedef QPInverseProblem::QPSystem QPSystem;
+    typedef QPInverseProblem::QPConstraintLists QPConstraintLists;
+
+    QPProblemRecorder() {}
+    ~QPProblemRecorder();
+
+    /// Creates (or truncates) the file and starts the writer thread. Returns false if the file cannot be opened.
+    bool open(const std::string& filename, const bool& compress);
+    /// Writes the pending steps and closes the file
+    void close();
+    bool isOpen() const {return m_isOpen;}
+
+    void setMaxPendingSteps(const unsigned int& maxPendingSteps) {m_maxPendingSteps = std::max(maxPendingSteps, 1u);}
+
+    void record(const QPSystem& qpSystem, const QPConstraintLists& qpCLists,
+                const double& time, const double& objective, const int& iterations);
+
+    /// Records a step encoded by encodeStep(). data is swapped with a recycled buffer.
+    void recordEncoded(const uint64_t& step, vector<char>& data);
+
+    /// Content of a step chunk, before its compression
+    static void encodeStep(const QPSystem& qpSystem, const QPConstraintLists& qpCLists, const uint64_t& step,
+                           const double& time, const double& objective, const int& iterations, vector<char>& buffer);
+
+    /// Number of steps written in the file, and number of steps that could not be written
+    unsigned int getNbRecordedSteps() const;
+    unsigned int getNbFailedSteps() const;
+
+    enum Encoding : uint32_t {RAW = 0, ZERO_RUN = 1};
+    static const char s_magic[8];
+    static constexpr uint32_t s_version{1};
+    static constexpr uint32_t s_stepTag{0x50455453}; // "STEP"
+    static constexpr uint32_t s_indexTag{0x58444e49}; // "INDX"
+
+    /// Run-length encoding of the zero 8-byte words: alternates the number of literal words (varint),
+    /// the literal words, and the number of zero words (varint). The input is padded to 8 bytes.
+    static void encodeZeroRun(const vector<char>& input, vector<char>& output);
+    static bool decodeZeroRun(const vector<char>& input, const uint64_t& size, vector<char>& output);
+
+protected:
+    struct PendingStep {
+        uint64_t step{0};
+        vector<char> data;
+    };
+
+    std::ofstream m_file;
+    bool m_isOpen{false};
+    bool m_compress{true};
+    uint64_t m_nbSteps{0};
+    uint64_t m_offset{0};
+
+    std::thread m_writer;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_pendingCondition;
+    std::condition_variable m_writtenCondition;
+    std::deque<PendingStep> m_pending;
+    vector<vector<char>> m_freeBuffers; // recycled step buffers
+    unsigned int m_maxPendingSteps{64};
+    bool m_stop{false};
+    unsigned int m_nbRecordedSteps{0};
+    unsigned int m_nbFailedSteps{0};
+
+    void waitPendingStep(PendingStep& pending);
+    void pushPendingStep(PendingStep& pending);
+    void writeLoop();
+    void writeStep(PendingStep& step, vector<char>& encoded);
+    void writeChunk(const uint32_t& tag, const uint32_t& encoding, const uint64_t& rawSize, const vector<char>& data);
+};
+
+
+/// Reads the recordings written by QPProblemRecorder
+class SOFA_SOFTROBOTS_INVERSE_API QPProblemReader
+{
+public:
+    /// Opens the file and indexes its complete steps. Returns false if it is not a recording.
+    bool open(const std::string& filename);
+    void close();
+
+    unsigned int getNbSteps() const {return m_index.size();}
+    bool readStep(const unsigned int& i, QPRecordedStep& step);
+
+protected:
+    struct IndexEntry {
+        uint64_t step;
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    std::ifstream m_file;
+    vector<IndexEntry> m_index;
+    vector<char> m_buffer;
+    vector<char> m_decoded;
+};
+
+} // namespace
@@ -0,0 +1,149 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#include <fstream>
+#include <iomanip>
+#include <SoftRobots.Inverse/component/solver/modules/QPProfileReport.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+namespace
+{
+
+void writeString(std::ofstream& file, const std::string& value)
+{
+    file << '"';
+    for(const char& character : value)
+    {
+        if(character == '"' || character == '\\')
+            file << '\\' << character;
+        else if((unsigned char)character < 0x20)
+            file << ' ';
+        else
+            file << character;
+    }
+    file << '"';
+}
+
+void writeMap(std::ofstream& file, const std::map<std::string, double>& values)
+{
+    file << '{';
+    bool isFirst = true;
+    for(const auto& [name, value] : values)
+    {
+        if(!isFirst)
+            file << ',';
+        isFirst = false;
+        writeString(file, name);
+        file << ':' << value;
+    }
+    file << '}';
+}
+
+}
+
+
+void QPProfileReport::request(const unsigned int& nbSteps)
+{
+    clear();
+    m_nbRemainingSteps = nbSteps;
+    m_steps.reserve(nbSteps);
+}
+
+
+void QPProfileReport::beginStep(const double& time)
+{
+    if(!isCapturing())
+        return;
+
+    if(!m_isStepOpen)
+        m_steps.emplace_back();
+    m_steps.back() = Step();
+    m_steps.back().time = time;
+    m_isStepOpen = true;
+}
+
+
+void QPProfileReport::addPhase(const std::string& name, const double& value)
+{
+    if(m_isStepOpen)
+        m_steps.back().phases[name] += value;
+}
+
+
+bool QPProfileReport::endStep()
+{
+    if(!m_isStepOpen)
+        return false;
+
+    m_isStepOpen = false;
+    return (--m_nbRemainingSteps == 0);
+}
+
+
+bool QPProfileReport::write(const std::string& filename) const
+{
+    std::ofstream file(filename, std::ios::trunc);
+    if(!file.is_open())
+        return false;
+
+    file << std::setprecision(10);
+    file << "{\"steps\":[";
+    for(unsigned int i=0; i<m_steps.size(); i++)
+    {
+        const Step& step = m_steps[i];
+        const double nbEntries = double(step.dim)*double(step.dim);
+        file << ((i>0)? ",\n" : "\n");
+        file << "{\"time\":" << step.time
+             << ",\"dim\":" << step.dim
+             << ",\"nonZerosW\":" << step.nbNonZeros
+             << ",\"densityW\":" << ((nbEntries > 0.)? step.nbNonZeros/nbEntries : 0.);
+        file << ",\"phases\":";
+        writeMap(file, step.phases);
+        file << ",\"telemetry\":";
+        writeMap(file, step.values);
+        file << ",\"pivotsPerIteration\":[";
+        for(unsigned int k=0; k<step.pivotsPerIteration.size(); k++)
+            file << ((k>0)? "," : "") << step.pivotsPerIteration[k];
+        file << "]}";
+    }
+    file << "\n]}\n";
+    return file.good();
+}
+
+
+void QPProfileReport::clear()
+{
+    m_steps.clear();
+    m_nbRemainingSteps = 0;
+    m_isStepOpen = false;
+}
+
+} // namespace
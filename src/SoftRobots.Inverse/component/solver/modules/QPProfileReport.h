@@ -0,0 +1,83 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <map>
+#include <string>
+#include <sofa/type/vector.h>
+
+#include <SoftRobots.Inverse/component/config.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+/// Detailed report of the next steps, captured on demand (e.g. to find why a frame was slow): durations
+/// and counters of the phases, size and sparsity of the compliance, pivots per iteration of the contact
+/// loop and the telemetry entries of the step (including the working set changes of qpOASES). The steps
+/// are kept in memory while captured, and written in one JSON file once the last one is closed.
+class SOFA_SOFTROBOTS_INVERSE_API QPProfileReport
+{
+public:
+
+    struct Step {
+        double time{0.};
+        unsigned int dim{0};
+        unsigned int nbNonZeros{0}; // of W
+        std::map<std::string, double> phases; // durations (ms) and counters, summed over the step
+        std::map<std::string, double> values; // telemetry entries
+        sofa::type::vector<SReal> pivotsPerIteration;
+    };
+
+    /// Captures the next nbSteps steps, the steps of a capture in progress are dropped
+    void request(const unsigned int& nbSteps);
+    bool isCapturing() const {return m_nbRemainingSteps > 0;}
+    unsigned int getNbRemainingSteps() const {return m_nbRemainingSteps;}
+
+    /// Opens the step captured, a step left open is replaced
+    void beginStep(const double& time);
+    bool isStepOpen() const {return m_isStepOpen;}
+    Step& getStep() {return m_steps.back();}
+    void addPhase(const std::string& name, const double& value);
+    /// Closes the step, returns true if it was the last one of the capture
+    bool endStep();
+
+    const sofa::type::vector<Step>& getSteps() const {return m_steps;}
+
+    /// Writes the captured steps, returns false if the file cannot be opened
+    bool write(const std::string& filename) const;
+    void clear();
+
+protected:
+    sofa::type::vector<Step> m_steps;
+    unsigned int m_nbRemainingSteps{0};
+    bool m_isStepOpen{false};
+};
+
+} // namespace
@@ -0,0 +1,136 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+
+#include <algorithm>
+
+#include <SoftRobots.Inverse/component/solver/modules/QPReducedCompliance.h>
+
+namespace softrobotsinverse::solver::module
+{
+
+using sofa::type::vector;
+using sofa::linearalgebra::BaseMatrix;
+using sofa::core::behavior::BaseMechanicalState;
+
+bool QPReducedCompliance::set(const vector<SReal>& basis,
+                              const vector<SReal>& compliance,
+                              const unsigned int& nbDofs)
+{
+    clear();
+
+    unsigned int nbModes = 0;
+    while(nbModes*nbModes < compliance.size())
+        nbModes++;
+    if(nbModes == 0 || nbDofs == 0 || nbModes*nbModes != compliance.size() || basis.size() != size_t(nbModes)*nbDofs)
+        return false;
+
+    m_nbModes = nbModes;
+    m_nbDofs = nbDofs;
+    m_basis = basis;
+    m_compliance = compliance;
+    return true;
+}
+
+void QPReducedCompliance::clear()
+{
+    m_nbModes = 0;
+    m_nbDofs = 0;
+    m_basis.clear();
+    m_compliance.clear();
+    m_jacobian.clear();
+    m_rows.clear();
+    m_JPhi.clear();
+    m_JPhiC.clear();
+}
+
+bool QPReducedCompliance::update(BaseMechanicalState* mstate,
+                                 const sofa::core::ConstraintParams* cParams,
+                                 const vector<bool>* isFullRow)
+{
+    m_rows.clear();
+    if(!isSet() || !mstate || mstate->getMatrixSize() != m_nbDofs)
+        return false;
+
+    m_jacobian.clear();
+    QPComplianceCache::Recorder J(nullptr, &m_jacobian);
+    unsigned int offset = 0;
+    mstate->getConstraintJacobian(cParams, &J, offset);
+
+    for(const QPComplianceCache::Entry& entry : m_jacobian)
+    {
+        if(entry.j < 0 || entry.j >= Index(m_nbDofs))
+            return false;
+        if(isFullRow && entry.i < Index(isFullRow->size()) && (*isFullRow)[entry.i])
+            return false;
+        m_rows.push_back(entry.i);
+    }
+    std::sort(m_rows.begin(), m_rows.end());
+    m_rows.erase(std::unique(m_rows.begin(), m_rows.end()), m_rows.end());
+
+    // J Phi, row by row of the Jacobian
+    const size_t nbRows = m_rows.size();
+    m_JPhi.assign(nbRows*m_nbModes, 0.);
+    for(const QPComplianceCache::Entry& entry : m_jacobian)
+    {
+        const size_t r = std::lower_bound(m_rows.begin(), m_rows.end(), entry.i) - m_rows.begin();
+        SReal* JPhi = &m_JPhi[r*m_nbModes];
+        for(unsigned int m=0; m<m_nbModes; m++)
+            JPhi[m] += entry.value * m_basis[size_t(m)*m_nbDofs + entry.j];
+    }
+
+    // (J Phi) C
+    m_JPhiC.assign(nbRows*m_nbModes, 0.);
+    for(size_t r=0; r<nbRows; r++)
+        for(unsigned int m=0; m<m_nbModes; m++)
+        {
+            const SReal value = m_JPhi[r*m_nbModes + m];
+            if(value == 0.)
+                continue;
+            for(unsigned int n=0; n<m_nbModes; n++)
+                m_JPhiC[r*m_nbModes + n] += value * m_compliance[size_t(m)*m_nbModes + n];
+        }
+
+    return true;
+}
+
+void QPReducedCompliance::addCompliance(BaseMatrix* W)
+{
+    // (J Phi) C (J Phi)^T, symmetric when C is
+    const size_t nbRows = m_rows.size();
+    for(size_t r=0; r<nbRows; r++)
+        for(size_t s=0; s<nbRows; s++)
+        {
+            SReal value = 0.;
+            for(unsigned int m=0; m<m_nbModes; m++)
+                value += m_JPhiC[r*m_nbModes + m] * m_JPhi[s*m_nbModes + m];
+            W->add(m_rows[r], m_rows[s], value);
+        }
+}
+
+} // namespace
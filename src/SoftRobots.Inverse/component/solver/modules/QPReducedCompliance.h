@@ -0,0 +1,91 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <sofa/core/ConstraintParams.h>
+#include <sofa/core/behavior/BaseMechanicalState.h>
+#include <sofa/linearalgebra/BaseMatrix.h>
+#include <sofa/type/vector.h>
+
+#include <SoftRobots.Inverse/component/solver/modules/QPComplianceCache.h>
+#include <SoftRobots.Inverse/component/config.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+/// Reduced-order contribution of a constraint correction to the compliance matrix W:
+///     W += (J Phi) C (J Phi)^T
+/// with Phi a basis of nbModes modes of the nbDofs degrees of freedom of its mechanical state (mode-major,
+/// one mode after the other), and C the compliance in the reduced coordinates (nbModes x nbModes, e.g. the
+/// inverse of Phi^T K Phi, scaled as the constraint correction scales its compliance). Both are precomputed
+/// offline (POD of snapshots of the actuated deformations, model order reduction). The cost scales with the
+/// non-zeros of the Jacobian J times nbModes, instead of one resolution of the system per row.
+/// The basis is only trusted for the deformations it was built from (actuators, effectors), so that the
+/// contribution is left to the full path as soon as one of the rows marked as full (contacts) is on the state.
+class SOFA_SOFTROBOTS_INVERSE_API QPReducedCompliance
+{
+public:
+    typedef sofa::linearalgebra::BaseMatrix::Index Index;
+
+    /// Returns false, and clears the basis, if the sizes are not consistent
+    bool set(const sofa::type::vector<SReal>& basis,
+             const sofa::type::vector<SReal>& compliance,
+             const unsigned int& nbDofs);
+    void clear();
+
+    bool isSet() const {return m_nbModes > 0;}
+    unsigned int getNbModes() const {return m_nbModes;}
+    unsigned int getNbDofs() const {return m_nbDofs;}
+
+    /// Reads the Jacobian of the mechanical state and projects it on the basis. Returns false if the
+    /// contribution has to be computed by the full path: a row of the Jacobian is marked in isFullRow, or the
+    /// state does not have the size of the basis.
+    bool update(sofa::core::behavior::BaseMechanicalState* mstate,
+                const sofa::core::ConstraintParams* cParams,
+                const sofa::type::vector<bool>* isFullRow);
+
+    /// Adds the contribution of the last update() into W
+    void addCompliance(sofa::linearalgebra::BaseMatrix* W);
+
+protected:
+
+    unsigned int m_nbModes{0};
+    unsigned int m_nbDofs{0};
+    sofa::type::vector<SReal> m_basis;
+    sofa::type::vector<SReal> m_compliance;
+
+    // Scratch of update(), kept across the steps
+    sofa::type::vector<QPComplianceCache::Entry> m_jacobian;
+    sofa::type::vector<Index> m_rows; // rows of the Jacobian, sorted
+    sofa::type::vector<SReal> m_JPhi; // nbRows x nbModes
+    sofa::type::vector<SReal> m_JPhiC; // nbRows x nbModes
+};
+
+} // namespace
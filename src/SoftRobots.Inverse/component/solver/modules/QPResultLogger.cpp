@@ -0,0 +1,442 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+
+#include <cstring>
+#include <sofa/helper/logging/Messaging.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPResultLogger.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+namespace
+{
+
+constexpr uint64_t s_fileHeaderSize = 8 + 2*sizeof(uint32_t);
+/// Size of the header of a chunk: tag, reserved, nbSteps, nbRows, nbColumns, payload size
+constexpr uint64_t s_chunkHeaderSize = 2*sizeof(uint32_t) + 4*sizeof(uint64_t);
+/// Size of the header of a column: name, type, reserved, nbValues
+constexpr uint64_t s_columnHeaderSize = 8 + 2*sizeof(uint32_t) + sizeof(uint64_t);
+
+uint64_t getPaddedSize(const uint64_t& size)
+{
+    return (size + 7)/8*8;
+}
+
+template<class T>
+void append(vector<char>& buffer, const T& value)
+{
+    const size_t size = buffer.size();
+    buffer.resize(size + sizeof(T));
+    std::memcpy(buffer.data() + size, &value, sizeof(T));
+}
+
+void appendColumn(vector<char>& buffer, const char* name, const QPResultLogger::ColumnType& type,
+                  const void* values, const uint64_t& nbValues, const size_t& valueSize)
+{
+    char paddedName[8] = {};
+    std::strncpy(paddedName, name, 8);
+    buffer.insert(buffer.end(), paddedName, paddedName + 8);
+    append(buffer, uint32_t(type));
+    append(buffer, uint32_t(0));
+    append(buffer, nbValues);
+
+    const size_t size = buffer.size();
+    buffer.resize(size + getPaddedSize(nbValues*valueSize), 0);
+    if(nbValues > 0)
+        std::memcpy(buffer.data() + size, values, nbValues*valueSize);
+}
+
+/// Copies the per-step rows (step-major) in the per-row series (row-major)
+void transpose(const vector<double>& values, const uint64_t& nbSteps, const uint64_t& nbRows, vector<double>& column)
+{
+    column.resize(nbSteps*nbRows);
+    for(uint64_t s=0; s<nbSteps; s++)
+    {
+        const double* row = values.data() + s*nbRows;
+        for(uint64_t r=0; r<nbRows; r++)
+            column[r*nbSteps+s] = row[r];
+    }
+}
+
+template<class T>
+bool readColumn(const char* data, const uint64_t& nbValues, const uint64_t& expectedNbValues, vector<T>& values)
+{
+    if(nbValues != expectedNbValues)
+        return false;
+    values.resize(nbValues);
+    if(nbValues > 0)
+        std::memcpy(values.data(), data, nbValues*sizeof(T));
+    return true;
+}
+
+} // namespace
+
+
+const char QPResultLogger::s_magic[8] = {'S','R','I','Q','P','R','E','S'};
+
+
+void QPResultLogger::PendingChunk::clear()
+{
+    rowKinds.clear();
+    steps.clear();
+    times.clear();
+    lambda.clear();
+    delta.clear();
+    dfree.clear();
+}
+
+
+QPResultLogger::~QPResultLogger()
+{
+    close();
+}
+
+
+bool QPResultLogger::open(const std::string& filename, const unsigned int& chunkSize)
+{
+    close();
+
+    m_file.open(filename, std::ios::binary | std::ios::trunc);
+    if(!m_file.is_open())
+        return false;
+
+    m_file.write(s_magic, 8);
+    const uint32_t version = s_version;
+    const uint32_t reserved = 0;
+    m_file.write(reinterpret_cast<const char*>(&version), sizeof(uint32_t));
+    m_file.write(reinterpret_cast<const char*>(&reserved), sizeof(uint32_t));
+    m_file.flush();
+
+    m_chunkSize = std::max(chunkSize, 1u);
+    m_nbSteps = 0;
+    m_chunk.clear();
+    m_nbLoggedSteps = 0;
+    m_nbFailedSteps = 0;
+    m_stop = false;
+    m_isOpen = true;
+    m_writer = std::thread(&QPResultLogger::writeLoop, this);
+    return true;
+}
+
+
+void QPResultLogger::close()
+{
+    if(!m_isOpen)
+        return;
+
+    pushChunk();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_pendingCondition.notify_one();
+    m_writer.join();
+
+    m_file.close();
+    m_freeChunks.clear();
+    m_isOpen = false;
+}
+
+
+void QPResultLogger::log(const double& time, const unsigned int& nbRows, const double* lambda, const double* delta,
+                         const double* dfree, const QPConstraintLists& qpCLists)
+{
+    if(!m_isOpen)
+        return;
+
+    m_rowKinds.assign(nbRows, UNKNOWN_ROW);
+    auto setKind = [this, &nbRows](const vector<unsigned int>& rowIds, const RowKind& kind)
+    {
+        for(const unsigned int& rowId : rowIds)
+            if(rowId < nbRows)
+                m_rowKinds[rowId] = kind;
+    };
+    setKind(qpCLists.actuatorRowIds, ACTUATOR_ROW);
+    setKind(qpCLists.effectorRowIds, EFFECTOR_ROW);
+    setKind(qpCLists.sensorRowIds, SENSOR_ROW);
+    setKind(qpCLists.contactRowIds, CONTACT_ROW);
+    setKind(qpCLists.equalityRowIds, EQUALITY_ROW);
+
+    // The steps of a chunk share their rows
+    if(!m_chunk.steps.empty() && m_chunk.rowKinds != m_rowKinds)
+        pushChunk();
+    if(m_chunk.steps.empty())
+        m_chunk.rowKinds.assign(m_rowKinds.begin(), m_rowKinds.end());
+
+    m_chunk.steps.push_back(m_nbSteps++);
+    m_chunk.times.push_back(time);
+    m_chunk.lambda.insert(m_chunk.lambda.end(), lambda, lambda + nbRows);
+    m_chunk.delta.insert(m_chunk.delta.end(), delta, delta + nbRows);
+    m_chunk.dfree.insert(m_chunk.dfree.end(), dfree, dfree + nbRows);
+
+    if(m_chunk.steps.size() >= m_chunkSize)
+        pushChunk();
+}
+
+
+void QPResultLogger::pushChunk()
+{
+    if(m_chunk.steps.empty())
+        return;
+
+    {
+        // Back pressure: a writer that cannot keep up should not make the memory grow without limit
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_writtenCondition.wait(lock, [this]{return m_pending.size() < m_maxPendingChunks;});
+        m_pending.push_back(std::move(m_chunk));
+        m_chunk = PendingChunk();
+        if(!m_freeChunks.empty())
+        {
+            m_chunk = std::move(m_freeChunks.back());
+            m_freeChunks.pop_back();
+        }
+    }
+    m_pendingCondition.notify_one();
+    m_chunk.clear();
+}
+
+
+unsigned int QPResultLogger::getNbLoggedSteps() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_nbLoggedSteps;
+}
+
+
+unsigned int QPResultLogger::getNbFailedSteps() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_nbFailedSteps;
+}
+
+
+void QPResultLogger::writeLoop()
+{
+    vector<char> buffer;
+    vector<double> column;
+    while(true)
+    {
+        PendingChunk chunk;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_pendingCondition.wait(lock, [this]{return m_stop || !m_pending.empty();});
+            if(m_pending.empty()) // stopped, and all the chunks are written
+                return;
+            chunk = std::move(m_pending.front());
+            m_pending.pop_front();
+        }
+        m_writtenCondition.notify_one();
+
+        writeChunk(chunk, buffer, column);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(m_file.good())
+            m_nbLoggedSteps += chunk.steps.size();
+        else
+            m_nbFailedSteps += chunk.steps.size();
+        m_freeChunks.push_back(std::move(chunk));
+    }
+}
+
+
+void QPResultLogger::writeChunk(const PendingChunk& chunk, vector<char>& buffer, vector<double>& column)
+{
+    if(!m_file.good())
+        return;
+
+    const uint64_t nbSteps = chunk.steps.size();
+    const uint64_t nbRows = chunk.rowKinds.size();
+    const uint64_t nbColumns = 6;
+
+    buffer.clear();
+    appendColumn(buffer, "rowkind", UINT8, chunk.rowKinds.data(), nbRows, sizeof(uint8_t));
+    appendColumn(buffer, "step", UINT64, chunk.steps.data(), nbSteps, sizeof(uint64_t));
+    appendColumn(buffer, "time", FLOAT64, chunk.times.data(), nbSteps, sizeof(double));
+    transpose(chunk.lambda, nbSteps, nbRows, column);
+    appendColumn(buffer, "lambda", FLOAT64, column.data(), column.size(), sizeof(double));
+    transpose(chunk.delta, nbSteps, nbRows, column);
+    appendColumn(buffer, "delta", FLOAT64, column.data(), column.size(), sizeof(double));
+    transpose(chunk.dfree, nbSteps, nbRows, column);
+    appendColumn(buffer, "dfree", FLOAT64, column.data(), column.size(), sizeof(double));
+
+    const uint32_t tag = s_chunkTag;
+    const uint32_t reserved = 0;
+    const uint64_t payloadSize = buffer.size();
+    m_file.write(reinterpret_cast<const char*>(&tag), sizeof(uint32_t));
+    m_file.write(reinterpret_cast<const char*>(&reserved), sizeof(uint32_t));
+    m_file.write(reinterpret_cast<const char*>(&nbSteps), sizeof(uint64_t));
+    m_file.write(reinterpret_cast<const char*>(&nbRows), sizeof(uint64_t));
+    m_file.write(reinterpret_cast<const char*>(&nbColumns), sizeof(uint64_t));
+    m_file.write(reinterpret_cast<const char*>(&payloadSize), sizeof(uint64_t));
+    m_file.write(buffer.data(), payloadSize);
+    m_file.flush();
+}
+
+
+bool QPResultReader::open(const std::string& filename)
+{
+    close();
+
+    m_file.open(filename, std::ios::binary);
+    if(!m_file.is_open())
+        return false;
+
+    m_file.seekg(0, std::ios::end);
+    const uint64_t fileSize = m_file.tellg();
+    m_file.seekg(0, std::ios::beg);
+
+    char magic[8];
+    uint32_t version = 0, reserved = 0;
+    m_file.read(magic, 8);
+    m_file.read(reinterpret_cast<char*>(&version), sizeof(uint32_t));
+    m_file.read(reinterpret_cast<char*>(&reserved), sizeof(uint32_t));
+    if(!m_file.good() || std::memcmp(magic, QPResultLogger::s_magic, 8) != 0)
+    {
+        close();
+        return false;
+    }
+    if(version > QPResultLogger::s_version)
+    {
+        msg_error("QPResultReader") << "Result log version " << version << " is not supported by this version of the plugin.";
+        close();
+        return false;
+    }
+
+    // Index the chunks, an incomplete chunk at the end of the file is ignored
+    uint64_t position = s_fileHeaderSize;
+    while(position + s_chunkHeaderSize <= fileSize)
+    {
+        uint32_t tag = 0;
+        uint64_t nbSteps = 0, nbRows = 0, nbColumns = 0, payloadSize = 0;
+        m_file.seekg(position);
+        m_file.read(reinterpret_cast<char*>(&tag), sizeof(uint32_t));
+        m_file.read(reinterpret_cast<char*>(&reserved), sizeof(uint32_t));
+        m_file.read(reinterpret_cast<char*>(&nbSteps), sizeof(uint64_t));
+        m_file.read(reinterpret_cast<char*>(&nbRows), sizeof(uint64_t));
+        m_file.read(reinterpret_cast<char*>(&nbColumns), sizeof(uint64_t));
+        m_file.read(reinterpret_cast<char*>(&payloadSize), sizeof(uint64_t));
+        if(!m_file.good() || tag != QPResultLogger::s_chunkTag || position + s_chunkHeaderSize + payloadSize > fileSize)
+            break;
+
+        m_offsets.push_back(position);
+        m_nbSteps += nbSteps;
+        position += s_chunkHeaderSize + payloadSize;
+    }
+
+    m_file.clear();
+    return true;
+}
+
+
+void QPResultReader::close()
+{
+    if(m_file.is_open())
+        m_file.close();
+    m_file.clear();
+    m_offsets.clear();
+    m_nbSteps = 0;
+}
+
+
+bool QPResultReader::readChunk(const unsigned int& i, QPResultChunk& chunk)
+{
+    if(i >= m_offsets.size())
+        return false;
+
+    uint32_t tag = 0, reserved = 0;
+    uint64_t nbColumns = 0, payloadSize = 0;
+    m_file.clear();
+    m_file.seekg(m_offsets[i]);
+    m_file.read(reinterpret_cast<char*>(&tag), sizeof(uint32_t));
+    m_file.read(reinterpret_cast<char*>(&reserved), sizeof(uint32_t));
+    m_file.read(reinterpret_cast<char*>(&chunk.nbSteps), sizeof(uint64_t));
+    m_file.read(reinterpret_cast<char*>(&chunk.nbRows), sizeof(uint64_t));
+    m_file.read(reinterpret_cast<char*>(&nbColumns), sizeof(uint64_t));
+    m_file.read(reinterpret_cast<char*>(&payloadSize), sizeof(uint64_t));
+    if(!m_file.good() || tag != QPResultLogger::s_chunkTag)
+        return false;
+
+    m_buffer.resize(payloadSize);
+    m_file.read(m_buffer.data(), payloadSize);
+    if(!m_file.good())
+        return false;
+
+    chunk.rowKinds.clear();
+    chunk.steps.clear();
+    chunk.times.clear();
+    chunk.lambda.clear();
+    chunk.delta.clear();
+    chunk.dfree.clear();
+
+    const uint64_t nbValues = chunk.nbSteps*chunk.nbRows;
+    uint64_t position = 0;
+    for(uint64_t k=0; k<nbColumns; k++)
+    {
+        if(position + s_columnHeaderSize > payloadSize)
+            return false;
+
+        char name[9] = {};
+        uint32_t type = 0;
+        uint64_t nbColumnValues = 0;
+        std::memcpy(name, m_buffer.data() + position, 8);
+        std::memcpy(&type, m_buffer.data() + position + 8, sizeof(uint32_t));
+        std::memcpy(&nbColumnValues, m_buffer.data() + position + 8 + 2*sizeof(uint32_t), sizeof(uint64_t));
+        position += s_columnHeaderSize;
+
+        const uint64_t valueSize = (type == QPResultLogger::UINT8)? 1 : 8;
+        if(type > QPResultLogger::FLOAT64 || nbColumnValues > payloadSize
+                || position + getPaddedSize(nbColumnValues*valueSize) > payloadSize)
+            return false;
+
+        const char* data = m_buffer.data() + position;
+        const std::string columnName(name);
+        bool isValid = true;
+        if(columnName == "rowkind")
+            isValid = type == QPResultLogger::UINT8 && readColumn(data, nbColumnValues, chunk.nbRows, chunk.rowKinds);
+        else if(columnName == "step")
+            isValid = type == QPResultLogger::UINT64 && readColumn(data, nbColumnValues, chunk.nbSteps, chunk.steps);
+        else if(columnName == "time")
+            isValid = type == QPResultLogger::FLOAT64 && readColumn(data, nbColumnValues, chunk.nbSteps, chunk.times);
+        else if(columnName == "lambda")
+            isValid = type == QPResultLogger::FLOAT64 && readColumn(data, nbColumnValues, nbValues, chunk.lambda);
+        else if(columnName == "delta")
+            isValid = type == QPResultLogger::FLOAT64 && readColumn(data, nbColumnValues, nbValues, chunk.delta);
+        else if(columnName == "dfree")
+            isValid = type == QPResultLogger::FLOAT64 && readColumn(data, nbColumnValues, nbValues, chunk.dfree);
+        if(!isValid)
+            return false;
+
+        position += getPaddedSize(nbColumnValues*valueSize);
+    }
+
+    return true;
+}
+
+} // namespace
@@ -0,0 +1,167 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <sofa/type/vector.h>
+
+#include <SoftRobots.Inverse/component/solver/modules/QPInverseProblem.h>
+#include <SoftRobots.Inverse/component/config.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+using sofa::type::vector;
+
+/// Chunk of a result log: the values of nbSteps consecutive steps with the same rows, by column.
+/// The series of a row over the steps are contiguous: the value of row r at step s is at r*nbSteps+s.
+struct SOFA_SOFTROBOTS_INVERSE_API QPResultChunk
+{
+    uint64_t nbSteps{0};
+    uint64_t nbRows{0};
+    vector<uint8_t> rowKinds; // QPResultLogger::RowKind of each row
+    vector<uint64_t> steps;
+    vector<double> times;
+    vector<double> lambda;
+    vector<double> delta; // W lambda + dfree, the distance to the goal for the effector rows
+    vector<double> dfree; // the same at the free motion
+};
+
+
+/// Per-step results of QPInverseProblemSolver (lambda, delta and dfree of all the constraint rows),
+/// logged in a chunked columnar binary file to be loaded as columns (numpy, Arrow) offline.
+///
+/// The file starts with a header (magic "SRIQPRES", version, reserved), followed by chunks of up to
+/// chunkSize steps, a new chunk being started when the kinds of the rows change. A chunk is: tag "RCHK",
+/// reserved (uint32), nbSteps, nbRows, nbColumns, payload size (uint64), then its columns, each one being
+/// name (8 chars, zero padded), type (uint32, ColumnType), reserved (uint32), nbValues (uint64) and the
+/// values padded to 8 bytes. The columns are "rowkind", "step", "time", "lambda", "delta" and "dfree", a
+/// reader skips the columns it does not know. Values are stored in the byte order of the machine, and a
+/// chunk cut by a crash at the end of the file is ignored.
+///
+/// log() only appends the rows of the step to the current chunk, the full chunks are transposed to columns
+/// and written by a background thread. When the writer is more than maxPendingChunks behind, log() waits
+/// for it.
+class SOFA_SOFTROBOTS_INVERSE_API QPResultLogger
+{
+public:
+    typedef QPInverseProblem::QPConstraintLists QPConstraintLists;
+
+    enum RowKind : uint8_t {UNKNOWN_ROW = 0, ACTUATOR_ROW = 1, EFFECTOR_ROW = 2, SENSOR_ROW = 3,
+                            CONTACT_ROW = 4, EQUALITY_ROW = 5};
+    enum ColumnType : uint32_t {UINT8 = 0, UINT64 = 1, FLOAT64 = 2};
+
+    QPResultLogger() {}
+    ~QPResultLogger();
+
+    /// Creates (or truncates) the file and starts the writer thread. Returns false if the file cannot be opened.
+    bool open(const std::string& filename, const unsigned int& chunkSize);
+    /// Writes the current chunk and the pending ones, and closes the file
+    void close();
+    bool isOpen() const {return m_isOpen;}
+
+    void setMaxPendingChunks(const unsigned int& maxPendingChunks) {m_maxPendingChunks = std::max(maxPendingChunks, 1u);}
+
+    /// Appends the step, lambda, delta and dfree having nbRows values
+    void log(const double& time, const unsigned int& nbRows, const double* lambda, const double* delta,
+             const double* dfree, const QPConstraintLists& qpCLists);
+
+    /// Number of steps written in the file, and number of steps that could not be written
+    unsigned int getNbLoggedSteps() const;
+    unsigned int getNbFailedSteps() const;
+
+    static const char s_magic[8];
+    static constexpr uint32_t s_version{1};
+    static constexpr uint32_t s_chunkTag{0x4b484352}; // "RCHK"
+
+protected:
+    /// Chunk being filled: the rows of the steps one after the other
+    struct PendingChunk {
+        vector<uint8_t> rowKinds;
+        vector<uint64_t> steps;
+        vector<double> times;
+        vector<double> lambda;
+        vector<double> delta;
+        vector<double> dfree;
+        void clear();
+    };
+
+    std::ofstream m_file;
+    bool m_isOpen{false};
+    unsigned int m_chunkSize{256};
+    uint64_t m_nbSteps{0};
+    PendingChunk m_chunk;
+    vector<uint8_t> m_rowKinds; // of the step logged
+
+    std::thread m_writer;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_pendingCondition;
+    std::condition_variable m_writtenCondition;
+    std::deque<PendingChunk> m_pending;
+    vector<PendingChunk> m_freeChunks; // recycled chunk buffers
+    unsigned int m_maxPendingChunks{8};
+    bool m_stop{false};
+    unsigned int m_nbLoggedSteps{0};
+    unsigned int m_nbFailedSteps{0};
+
+    void pushChunk();
+    void writeLoop();
+    void writeChunk(const PendingChunk& chunk, vector<char>& buffer, vector<double>& column);
+};
+
+
+/// Reads the result logs written by QPResultLogger
+class SOFA_SOFTROBOTS_INVERSE_API QPResultReader
+{
+public:
+    /// Opens the file and indexes its complete chunks. Returns false if it is not a result log.
+    bool open(const std::string& filename);
+    void close();
+
+    unsigned int getNbChunks() const {return m_offsets.size();}
+    uint64_t getNbSteps() const {return m_nbSteps;}
+    bool readChunk(const unsigned int& i, QPResultChunk& chunk);
+
+protected:
+    std::ifstream m_file;
+    vector<uint64_t> m_offsets;
+    uint64_t m_nbSteps{0};
+    vector<char> m_buffer;
+};
+
+} // namespace
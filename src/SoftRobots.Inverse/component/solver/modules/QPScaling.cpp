@@ -0,0 +1,182 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#include <algorithm>
+#include <cmath>
+#include <SoftRobots.Inverse/component/solver/modules/QPScaling.h>
+
+namespace softrobotsinverse::solver::module
+{
+
+namespace
+{
+// Stop once the norms of the rows and columns of the scaled KKT matrix are in [1-tol, 1+tol]
+const double s_normTolerance = 0.1;
+// Bounds of the factor of an iteration, for the rows and columns that are nearly null
+const double s_minFactor = 1e-4;
+const double s_maxFactor = 1e4;
+// Bounds of qpOASES with this magnitude are infinite
+const double s_infinity = 1e20;
+}
+
+
+void QPScaling::scale(const int& nbVariables, const int& nbConstraints,
+                      const double* Q, const double* c, const double* l, const double* u, const double* A,
+                      double* bl, double* bu)
+{
+    const int n = nbVariables;
+    const int m = nbConstraints;
+
+    m_Q.assign(Q, Q + n*n);
+    m_A.assign(A, A + m*n);
+    m_D.assign(n, 1.);
+    m_E.assign(m, 1.);
+    m_variableNorms.resize(n);
+    m_constraintNorms.resize(m);
+
+    m_nbPerformedIterations = 0;
+    for(unsigned int k=0; k<m_nbIterations; k++)
+    {
+        // Infinity norms of the columns of [Q; A] (variables) and of the rows of A (constraints)
+        std::fill(m_variableNorms.begin(), m_variableNorms.end(), 0.);
+        for(int i=0; i<n; i++)
+            for(int j=0; j<n; j++)
+                m_variableNorms[j] = std::max(m_variableNorms[j], std::abs(m_Q[i*n+j]));
+        for(int i=0; i<m; i++)
+        {
+            double norm = 0.;
+            for(int j=0; j<n; j++)
+            {
+                const double value = std::abs(m_A[i*n+j]);
+                norm = std::max(norm, value);
+                m_variableNorms[j] = std::max(m_variableNorms[j], value);
+            }
+            m_constraintNorms[i] = norm;
+        }
+
+        bool isEquilibrated = true;
+        for(int j=0; j<n && isEquilibrated; j++)
+            isEquilibrated = (m_variableNorms[j] == 0. || std::abs(1. - m_variableNorms[j]) <= s_normTolerance);
+        for(int i=0; i<m && isEquilibrated; i++)
+            isEquilibrated = (m_constraintNorms[i] == 0. || std::abs(1. - m_constraintNorms[i]) <= s_normTolerance);
+        if(isEquilibrated)
+            break;
+
+        for(int j=0; j<n; j++)
+            m_variableNorms[j] = getScalingFactor(m_variableNorms[j]);
+        for(int i=0; i<m; i++)
+            m_constraintNorms[i] = getScalingFactor(m_constraintNorms[i]);
+
+        for(int i=0; i<n; i++)
+        {
+            m_D[i] *= m_variableNorms[i];
+            for(int j=0; j<n; j++)
+                m_Q[i*n+j] *= m_variableNorms[i]*m_variableNorms[j];
+        }
+        for(int i=0; i<m; i++)
+        {
+            m_E[i] *= m_constraintNorms[i];
+            for(int j=0; j<n; j++)
+                m_A[i*n+j] *= m_constraintNorms[i]*m_variableNorms[j];
+        }
+        m_nbPerformedIterations++;
+    }
+
+    m_c.resize(n);
+    for(int j=0; j<n; j++)
+        m_c[j] = m_D[j]*c[j];
+
+    m_hasBounds = (l && u);
+    if(m_hasBounds)
+    {
+        m_l.resize(n);
+        m_u.resize(n);
+        for(int j=0; j<n; j++)
+        {
+            m_l[j] = scaleBound(l[j], 1./m_D[j]);
+            m_u[j] = scaleBound(u[j], 1./m_D[j]);
+        }
+    }
+
+    for(int i=0; i<m; i++)
+    {
+        bl[i] = scaleBound(bl[i], m_E[i]);
+        bu[i] = scaleBound(bu[i], m_E[i]);
+    }
+}
+
+
+void QPScaling::unscaleSolution(const int& nbVariables, const int& nbConstraints, double* x, double* dual) const
+{
+    unscaleVariables(nbVariables, x);
+    if(!dual)
+        return;
+
+    for(int j=0; j<nbVariables; j++)
+        dual[j] /= m_D[j];
+    for(int i=0; i<nbConstraints; i++)
+        dual[nbVariables+i] *= m_E[i];
+}
+
+
+void QPScaling::unscaleVariables(const int& nbVariables, double* x) const
+{
+    for(int j=0; j<nbVariables; j++)
+        x[j] *= m_D[j];
+}
+
+
+void QPScaling::scaleVariables(const int& nbVariables, double* x) const
+{
+    for(int j=0; j<nbVariables; j++)
+        x[j] /= m_D[j];
+}
+
+
+size_t QPScaling::getMemoryUsage() const
+{
+    return sizeof(double)*(m_D.capacity() + m_E.capacity() + m_Q.capacity() + m_c.capacity()
+                           + m_l.capacity() + m_u.capacity() + m_A.capacity()
+                           + m_variableNorms.capacity() + m_constraintNorms.capacity());
+}
+
+
+double QPScaling::getScalingFactor(const double& norm)
+{
+    if(norm == 0.)
+        return 1.;
+    return std::min(std::max(1./std::sqrt(norm), s_minFactor), s_maxFactor);
+}
+
+
+double QPScaling::scaleBound(const double& bound, const double& factor)
+{
+    return (std::abs(bound) >= s_infinity)? bound : bound*factor;
+}
+
+} // namespace
@@ -0,0 +1,102 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <cstddef>
+
+#include <sofa/type/vector.h>
+
+#include <SoftRobots.Inverse/component/config.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+using sofa::type::vector;
+
+/// Diagonal scaling of a QP (Ruiz equilibration), for actuators of different magnitudes (forces in N,
+/// pressures in kPa, Young's modulus in Pa). With D the scaling of the variables and E the one of the
+/// constraint rows, x = D xs and the scaled QP is:
+///   min 1/2 xs^T (D Q D) xs + (D c)^T xs   s.t.   l/D <= xs <= u/D,   E bl <= (E A D) xs <= E bu
+/// D and E are computed by iterations of Ruiz on [Q A^T; A 0], each one dividing the rows and columns
+/// by the square root of their infinity norm, until these norms are close to 1. The objective is not
+/// scaled, so that the objective of the scaled QP is the one of the original QP. The infinite bounds are
+/// left as is.
+class SOFA_SOFTROBOTS_INVERSE_API QPScaling
+{
+public:
+
+    void setNbIterations(const unsigned int& nbIterations) {m_nbIterations = nbIterations;}
+
+    /// Computes the scaling and the scaled Q, c, l, u and A (row major [A; Aeq]), stored in this object.
+    /// bl and bu are scaled in place. l and u can be null.
+    void scale(const int& nbVariables, const int& nbConstraints,
+               const double* Q, const double* c, const double* l, const double* u, const double* A,
+               double* bl, double* bu);
+
+    double* getQ() {return m_Q.data();}
+    double* getC() {return m_c.data();}
+    double* getL() {return (m_hasBounds)? m_l.data() : nullptr;}
+    double* getU() {return (m_hasBounds)? m_u.data() : nullptr;}
+    double* getA() {return m_A.data();}
+
+    /// Solution of the scaled QP to solution of the original one: x = D xs, and for the multipliers (qpOASES
+    /// layout [bounds; constraints]) y = ys/D for the bounds and y = E ys for the constraints. dual can be null.
+    void unscaleSolution(const int& nbVariables, const int& nbConstraints, double* x, double* dual) const;
+    void unscaleVariables(const int& nbVariables, double* x) const;
+    void scaleVariables(const int& nbVariables, double* x) const;
+
+    const vector<double>& getVariableScaling() const {return m_D;}
+    const vector<double>& getConstraintScaling() const {return m_E;}
+    unsigned int getNbPerformedIterations() const {return m_nbPerformedIterations;}
+
+    size_t getMemoryUsage() const;
+
+protected:
+
+    unsigned int m_nbIterations{10};
+    unsigned int m_nbPerformedIterations{0};
+    bool m_hasBounds{false};
+
+    vector<double> m_D; // for each variable
+    vector<double> m_E; // for each constraint row
+    vector<double> m_Q;
+    vector<double> m_c;
+    vector<double> m_l;
+    vector<double> m_u;
+    vector<double> m_A;
+
+    vector<double> m_variableNorms;
+    vector<double> m_constraintNorms;
+
+    static double getScalingFactor(const double& norm);
+    static double scaleBound(const double& bound, const double& factor);
+};
+
+} // namespace
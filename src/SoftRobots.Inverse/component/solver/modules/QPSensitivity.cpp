@@ -0,0 +1,138 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <SoftRobots.Inverse/component/solver/modules/QPSensitivity.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+bool QPSensitivity::compute(const QPInverseProblem::QPSystem& system, const double* dual)
+{
+    clear();
+    const int n = system.dim;
+    const int ASize = system.A.size();
+    const int AeqSize = system.Aeq.size();
+    const int nbConstraints = ASize + AeqSize;
+    if(n == 0 || system.Q.size() != (unsigned int)n)
+        return false;
+
+    double largestDual = 1.;
+    for(int i=0; i<n+nbConstraints; i++)
+        largestDual = std::max(largestDual, std::abs(dual[i]));
+    const double threshold = m_tolerance*largestDual;
+
+    for(int i=0; i<n; i++)
+    {
+        if(std::abs(dual[i]) > threshold)
+            m_bound.push_back(i);
+        else
+            m_free.push_back(i);
+    }
+    for(int k=0; k<nbConstraints; k++)
+        if(k >= ASize || std::abs(dual[n+k]) > threshold)
+            m_active.push_back(k);
+
+    auto row = [&](const int& k) {return (k < ASize)? system.A[k] : system.Aeq[k-ASize];};
+
+    const int nbFree = m_free.size();
+    const int nbBound = m_bound.size();
+    const int nbActive = m_active.size();
+    const int size = nbFree + nbActive;
+    m_dxdc.setZero(n, n);
+    m_dxdb.setZero(n, nbConstraints);
+    m_dxdx.setZero(n, n);
+    for(int i : m_bound)
+        m_dxdx(i, i) = 1.;
+
+    if(size > 0)
+    {
+        m_kkt.setZero(size, size);
+        for(int p=0; p<nbFree; p++)
+            for(int q=0; q<nbFree; q++)
+                m_kkt(p, q) = system.Q[m_free[p]][m_free[q]];
+        for(int q=0; q<nbActive; q++)
+        {
+            const double* Aq = row(m_active[q]);
+            for(int p=0; p<nbFree; p++)
+                m_kkt(p, nbFree+q) = m_kkt(nbFree+q, p) = Aq[m_free[p]];
+        }
+        m_lu.compute(m_kkt);
+        if(!m_lu.isInvertible())
+        {
+            clear();
+            return false;
+        }
+
+        // Right-hand sides of the derivatives of c_F, of b_a and of x_B
+        m_rhs.setZero(size, nbFree + nbActive + nbBound);
+        for(int p=0; p<nbFree; p++)
+            m_rhs(p, p) = -1.;
+        for(int q=0; q<nbActive; q++)
+            m_rhs(nbFree+q, nbFree+q) = 1.;
+        for(int r=0; r<nbBound; r++)
+        {
+            const int column = nbFree + nbActive + r;
+            for(int p=0; p<nbFree; p++)
+                m_rhs(p, column) = -system.Q[m_free[p]][m_bound[r]];
+            for(int q=0; q<nbActive; q++)
+                m_rhs(nbFree+q, column) = -row(m_active[q])[m_bound[r]];
+        }
+        m_solution.noalias() = m_lu.solve(m_rhs);
+
+        for(int p=0; p<nbFree; p++)
+        {
+            for(int q=0; q<nbFree; q++)
+                m_dxdc(m_free[p], m_free[q]) = m_solution(p, q);
+            for(int q=0; q<nbActive; q++)
+                m_dxdb(m_free[p], m_active[q]) = m_solution(p, nbFree+q);
+            for(int r=0; r<nbBound; r++)
+                m_dxdx(m_free[p], m_bound[r]) = m_solution(p, nbFree+nbActive+r);
+        }
+    }
+
+    m_isValid = true;
+    return true;
+}
+
+
+void QPSensitivity::clear()
+{
+    m_isValid = false;
+    m_free.clear();
+    m_bound.clear();
+    m_active.clear();
+    m_dxdc.resize(0, 0);
+    m_dxdb.resize(0, 0);
+    m_dxdx.resize(0, 0);
+}
+
+} // namespace
@@ -0,0 +1,96 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <sofa/type/vector.h>
+#include <Eigen/LU>
+
+#include <SoftRobots.Inverse/component/solver/modules/QPInverseProblem.h>
+#include <SoftRobots.Inverse/component/config.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+using sofa::type::vector;
+
+/// Sensitivities of the solution x of a QP (qpOASES form: min 1/2 x^T Q x + c^T x with l <= x <= u,
+/// bl <= A x <= bu and Aeq x = beq) to its data, at the active set of the solution. With B the variables at
+/// an active bound, F the other ones and a the active rows of [A; Aeq] (the rows with a non-zero multiplier,
+/// and all the equality rows), x is locally the solution of the KKT system
+///   [Q_FF  A_aF^T] [x_F]   [-c_F - Q_FB x_B]
+///   [A_aF  0     ] [ z ] = [ b_a - A_aB x_B]
+/// with x_B the active bounds and b_a the active side of the bounds of the rows. It is factorized once, and
+/// each block of derivatives is a back-substitution of several right-hand sides. The columns of the inactive
+/// rows and bounds are zero. Where the active set changes, the derivatives are the ones of the active set of
+/// the solution (one-sided).
+class SOFA_SOFTROBOTS_INVERSE_API QPSensitivity
+{
+public:
+    typedef QPInverseProblem::RowMajorMatrixXd RowMajorMatrixXd;
+
+    /// A multiplier is active above the tolerance, relative to the largest multiplier
+    void setTolerance(const double& tolerance) {m_tolerance = tolerance;}
+
+    /// From the Hessian and the constraint rows of system, and the multipliers dual of its solution
+    /// (qpOASES layout [bounds; A; Aeq]). Returns false, with no sensitivity, if the KKT system is singular
+    /// (e.g. linearly dependent active rows).
+    bool compute(const QPInverseProblem::QPSystem& system, const double* dual);
+    void clear();
+
+    bool isValid() const {return m_isValid;}
+    unsigned int getNbActiveBounds() const {return m_bound.size();}
+    unsigned int getNbActiveConstraints() const {return m_active.size();}
+
+    /// dx/dc (dim x dim)
+    const RowMajorMatrixXd& getLinearTermSensitivity() const {return m_dxdc;}
+    /// dx/db (dim x nbConstraints), b being the active bound (bl, bu or beq) of each row of [A; Aeq]
+    const RowMajorMatrixXd& getConstraintSensitivity() const {return m_dxdb;}
+    /// dx/dl or dx/du (dim x dim), for the active bound of each variable
+    const RowMajorMatrixXd& getBoundSensitivity() const {return m_dxdx;}
+
+protected:
+    double m_tolerance{1e-10};
+    bool m_isValid{false};
+
+    vector<int> m_free;   // F
+    vector<int> m_bound;  // B
+    vector<int> m_active; // a, rows of [A; Aeq]
+
+    Eigen::MatrixXd m_kkt;
+    Eigen::FullPivLU<Eigen::MatrixXd> m_lu;
+    Eigen::MatrixXd m_rhs;
+    Eigen::MatrixXd m_solution;
+
+    RowMajorMatrixXd m_dxdc;
+    RowMajorMatrixXd m_dxdb;
+    RowMajorMatrixXd m_dxdx;
+};
+
+} // namespace
@@ -0,0 +1,85 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#include <SoftRobots.Inverse/component/solver/modules/QPSmallProblem.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+template<int N>
+static bool solveWithKernel(const int& nbConstraints,
+                            const double* Q, const double* c, const double* A,
+                            const double* l, const double* u, const double* bl, const double* bu,
+                            double* x, double* y, double& objective, const int& maxIterations, int& nbIterations)
+{
+    QPSmallProblemKernel<N> kernel;
+    const bool solved = kernel.solve(nbConstraints, Q, c, A, l, u, bl, bu, x, y, objective, maxIterations);
+    nbIterations = kernel.getNbIterations();
+    return solved;
+}
+
+
+bool QPSmallProblem::isSupported(const int& dim, const int& nbConstraints)
+{
+    return dim > 0 && dim <= s_maxDim && nbConstraints >= 0 && nbConstraints <= s_maxConstraints;
+}
+
+
+bool QPSmallProblem::solve(const int& dim, const int& nbConstraints,
+                           const double* Q, const double* c, const double* A,
+                           const double* l, const double* u, const double* bl, const double* bu,
+                           double* x, double* y, double& objective, const int& maxIterations)
+{
+    m_nbIterations = 0;
+    if(!isSupported(dim, nbConstraints))
+        return false;
+
+    switch(dim)
+    {
+    case 1:  return solveWithKernel<1>(nbConstraints, Q, c, A, l, u, bl, bu, x, y, objective, maxIterations, m_nbIterations);
+    case 2:  return solveWithKernel<2>(nbConstraints, Q, c, A, l, u, bl, bu, x, y, objective, maxIterations, m_nbIterations);
+    case 3:  return solveWithKernel<3>(nbConstraints, Q, c, A, l, u, bl, bu, x, y, objective, maxIterations, m_nbIterations);
+    case 4:  return solveWithKernel<4>(nbConstraints, Q, c, A, l, u, bl, bu, x, y, objective, maxIterations, m_nbIterations);
+    case 5:  return solveWithKernel<5>(nbConstraints, Q, c, A, l, u, bl, bu, x, y, objective, maxIterations, m_nbIterations);
+    case 6:  return solveWithKernel<6>(nbConstraints, Q, c, A, l, u, bl, bu, x, y, objective, maxIterations, m_nbIterations);
+    case 7:  return solveWithKernel<7>(nbConstraints, Q, c, A, l, u, bl, bu, x, y, objective, maxIterations, m_nbIterations);
+    case 8:  return solveWithKernel<8>(nbConstraints, Q, c, A, l, u, bl, bu, x, y, objective, maxIterations, m_nbIterations);
+    case 9:  return solveWithKernel<9>(nbConstraints, Q, c, A, l, u, bl, bu, x, y, objective, maxIterations, m_nbIterations);
+    case 10: return solveWithKernel<10>(nbConstraints, Q, c, A, l, u, bl, bu, x, y, objective, maxIterations, m_nbIterations);
+    case 11: return solveWithKernel<11>(nbConstraints, Q, c, A, l, u, bl, bu, x, y, objective, maxIterations, m_nbIterations);
+    case 12: return solveWithKernel<12>(nbConstraints, Q, c, A, l, u, bl, bu, x, y, objective, maxIterations, m_nbIterations);
+    case 13: return solveWithKernel<13>(nbConstraints, Q, c, A, l, u, bl, bu, x, y, objective, maxIterations, m_nbIterations);
+    case 14: return solveWithKernel<14>(nbConstraints, Q, c, A, l, u, bl, bu, x, y, objective, maxIterations, m_nbIterations);
+    case 15: return solveWithKernel<15>(nbConstraints, Q, c, A, l, u, bl, bu, x, y, objective, maxIterations, m_nbIterations);
+    case 16: return solveWithKernel<16>(nbConstraints, Q, c, A, l, u, bl, bu, x, y, objective, maxIterations, m_nbIterations);
+    default: return false;
+    }
+}
+
+} // namespace
@@ -0,0 +1,353 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <cmath>
+#include <limits>
+#include <Eigen/Core>
+#include <Eigen/Cholesky>
+
+#include <SoftRobots.Inverse/component/config.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+/// Dense QP of exactly N variables (N <= 16), solved with the dual active-set method of Goldfarb and Idnani
+/// on fixed-size (stack) storage:
+///     min 1/2 x^T Q x + c^T x   s.t.   l <= x <= u,   bl <= A x <= bu
+/// The arrays follow the layout of qpOASES (row-major Q and A, no bounds for a null l or u, no bound beyond
+/// 1e20), and so do the multipliers y (bounds then constraints, positive on a lower bound, negative on an
+/// upper bound, Q x + c = y_x + A^T y_A). A row with bl = bu is an equality, never dropped once active.
+/// The method starts from the unconstrained minimum and adds the most violated constraint at each
+/// iteration, so no feasible initial point is needed, but Q must be positive definite.
+template<int N>
+class QPSmallProblemKernel
+{
+public:
+    static_assert(N > 0 && N <= 16, "QPSmallProblemKernel is meant for small problems, at most 16 variables");
+
+    typedef Eigen::Matrix<double, N, N> MatrixN;
+    typedef Eigen::Matrix<double, N, 1> VectorN;
+
+    /// Returns false if Q is not positive definite, if the constraints are infeasible or linearly dependent
+    /// at the solution, or after maxIterations changes of the active set, for the caller to fall back to
+    /// the general solver. x, y and objective are only written on success.
+    bool solve(const int& nbConstraints,
+               const double* Q, const double* c, const double* A,
+               const double* l, const double* u, const double* bl, const double* bu,
+               double* x, double* y, double& objective, const int& maxIterations);
+
+    int getNbIterations() const {return m_nbIterations;}
+
+protected:
+
+    // Active constraints: index (bounds then rows), side (+1 lower, -1 upper), multiplier, and
+    // d = L^-1 n with n the normal oriented by the side, Q = L L^T. m_basis and m_R are the thin QR
+    // factorization of the columns d, the step directions are computed from them.
+    int m_nbActive{0};
+    int m_ids[N];
+    double m_sides[N];
+    double m_multipliers[N];
+    bool m_isEquality[N];
+    MatrixN m_D;
+    MatrixN m_basis;
+    MatrixN m_R;
+    int m_nbIterations{0};
+
+    const double* m_A{nullptr};
+    const double* m_lower[2]{}; // l, bl
+    const double* m_upper[2]{}; // u, bu
+
+    static constexpr double s_infinity = 1e20;
+    static constexpr double s_tolerance = 1e-10;
+
+    VectorN getNormal(const int& id) const;
+    double getBound(const int& id, const double& side) const;
+    bool isActive(const int& id) const;
+    bool addActive(const int& id, const double& side, const double& multiplier, const bool& isEquality, const VectorN& d);
+    void dropActive(const int& k);
+    bool orthonormalize(const int& k);
+};
+
+
+template<int N>
+typename QPSmallProblemKernel<N>::VectorN QPSmallProblemKernel<N>::getNormal(const int& id) const
+{
+    if(id < N)
+        return VectorN::Unit(id);
+    return Eigen::Map<const VectorN>(m_A + (id-N)*N);
+}
+
+
+template<int N>
+double QPSmallProblemKernel<N>::getBound(const int& id, const double& side) const
+{
+    const int set = (id < N)? 0 : 1;
+    const int index = (id < N)? id : id - N;
+    const double* bounds = (side > 0.)? m_lower[set] : m_upper[set];
+    if(!bounds)
+        return side * -s_infinity;
+    return bounds[index];
+}
+
+
+template<int N>
+bool QPSmallProblemKernel<N>::isActive(const int& id) const
+{
+    for(int j=0; j<m_nbActive; j++)
+        if(m_ids[j] == id)
+            return true;
+    return false;
+}
+
+
+template<int N>
+bool QPSmallProblemKernel<N>::orthonormalize(const int& k)
+{
+    // Gram-Schmidt of the column k against the previous ones, with a second pass for the rounding errors
+    VectorN v = m_D.col(k);
+    m_R.col(k).setZero();
+    for(int pass=0; pass<2; pass++)
+        for(int j=0; j<k; j++)
+        {
+            const double w = m_basis.col(j).dot(v);
+            m_R(j,k) += w;
+            v -= w*m_basis.col(j);
+        }
+
+    const double norm = v.norm();
+    if(norm <= s_tolerance*(1. + m_D.col(k).norm()))
+        return false;
+    m_R(k,k) = norm;
+    m_basis.col(k) = v/norm;
+    return true;
+}
+
+
+template<int N>
+bool QPSmallProblemKernel<N>::addActive(const int& id, const double& side, const double& multiplier,
+                                        const bool& isEquality, const VectorN& d)
+{
+    if(m_nbActive == N)
+        return false;
+
+    const int k = m_nbActive;
+    m_ids[k] = id;
+    m_sides[k] = side;
+    m_multipliers[k] = multiplier;
+    m_isEquality[k] = isEquality;
+    m_D.col(k) = d;
+    if(!orthonormalize(k))
+        return false;
+    m_nbActive++;
+    return true;
+}
+
+
+template<int N>
+void QPSmallProblemKernel<N>::dropActive(const int& k)
+{
+    for(int j=k; j+1<m_nbActive; j++)
+    {
+        m_ids[j] = m_ids[j+1];
+        m_sides[j] = m_sides[j+1];
+        m_multipliers[j] = m_multipliers[j+1];
+        m_isEquality[j] = m_isEquality[j+1];
+        m_D.col(j) = m_D.col(j+1);
+    }
+    m_nbActive--;
+
+    // The columns before k keep their factorization
+    for(int j=k; j<m_nbActive; j++)
+        orthonormalize(j);
+}
+
+
+template<int N>
+bool QPSmallProblemKernel<N>::solve(const int& nbConstraints,
+                                    const double* Q, const double* c, const double* A,
+                                    const double* l, const double* u, const double* bl, const double* bu,
+                                    double* x, double* y, double& objective, const int& maxIterations)
+{
+    m_nbIterations = 0;
+    m_nbActive = 0;
+    m_A = A;
+    m_lower[0] = l; m_lower[1] = bl;
+    m_upper[0] = u; m_upper[1] = bu;
+
+    // Q is symmetric, its row-major storage is also its column-major storage
+    const Eigen::Map<const MatrixN> Qm(Q);
+    const Eigen::LLT<MatrixN> llt(Qm);
+    if(llt.info() != Eigen::Success)
+        return false;
+
+    const Eigen::Map<const VectorN> cv(c);
+    VectorN xv = llt.solve(-cv);
+
+    const int nbIds = N + ((A)? nbConstraints : 0);
+    while(true)
+    {
+        // Most violated constraint, the equalities first
+        int p = -1;
+        double side = 0.;
+        double maxViolation = 0.;
+        bool isEquality = false;
+        for(int id=0; id<nbIds; id++)
+        {
+            if(isActive(id))
+                continue;
+
+            const double lower = getBound(id, 1.);
+            const double upper = getBound(id, -1.);
+            const double value = getNormal(id).dot(xv);
+            const bool equality = (lower == upper);
+            if(isEquality && !equality)
+                continue;
+
+            double violation = 0.;
+            double idSide = 0.;
+            if(lower > -s_infinity && lower - value > s_tolerance*(1. + std::abs(lower)))
+            {
+                violation = lower - value;
+                idSide = 1.;
+            }
+            else if(upper < s_infinity && value - upper > s_tolerance*(1. + std::abs(upper)))
+            {
+                violation = value - upper;
+                idSide = -1.;
+            }
+
+            if(idSide != 0. && (violation > maxViolation || (equality && !isEquality)))
+            {
+                p = id;
+                side = idSide;
+                maxViolation = violation;
+                isEquality = equality;
+            }
+        }
+        if(p < 0)
+            break;
+
+        // Steps towards the constraint p, dropping the active inequalities whose multiplier vanishes first
+        const VectorN n = side*getNormal(p);
+        const double b = side*getBound(p, side);
+        double multiplier = 0.;
+        bool isAdded = false;
+        while(!isAdded)
+        {
+            if(++m_nbIterations > maxIterations)
+                return false;
+
+            const VectorN d = llt.matrixL().solve(n);
+            double w[N];
+            VectorN projected = d;
+            for(int j=0; j<m_nbActive; j++)
+            {
+                w[j] = m_basis.col(j).dot(d);
+                projected -= w[j]*m_basis.col(j);
+            }
+            const VectorN z = llt.matrixU().solve(projected);
+
+            // r = R^-1 w, the change of the multipliers of the active constraints
+            double r[N];
+            for(int j=m_nbActive-1; j>=0; j--)
+            {
+                double sum = w[j];
+                for(int i=j+1; i<m_nbActive; i++)
+                    sum -= m_R(j,i)*r[i];
+                r[j] = sum/m_R(j,j);
+            }
+
+            double partialStep = std::numeric_limits<double>::infinity();
+            int k = -1;
+            for(int j=0; j<m_nbActive; j++)
+                if(!m_isEquality[j] && r[j] > 0. && m_multipliers[j]/r[j] < partialStep)
+                {
+                    partialStep = m_multipliers[j]/r[j];
+                    k = j;
+                }
+
+            const double zn = z.dot(n);
+            const double fullStep = (zn > s_tolerance*n.squaredNorm())? (b - n.dot(xv))/zn : std::numeric_limits<double>::infinity();
+
+            if(k < 0 && std::isinf(fullStep))
+                return false; // infeasible
+
+            const double step = std::min(partialStep, fullStep);
+            if(!std::isinf(fullStep))
+                xv += step*z;
+            for(int j=0; j<m_nbActive; j++)
+                m_multipliers[j] -= step*r[j];
+            multiplier += step;
+
+            if(fullStep <= partialStep)
+                isAdded = addActive(p, side, multiplier, isEquality, d);
+            else
+                dropActive(k);
+
+            if(fullStep <= partialStep && !isAdded)
+                return false; // dependent constraints
+        }
+    }
+
+    Eigen::Map<VectorN> xm(x);
+    xm = xv;
+    for(int id=0; id<nbIds; id++)
+        y[id] = 0.;
+    for(int j=0; j<m_nbActive; j++)
+        y[m_ids[j]] = m_sides[j]*m_multipliers[j];
+    objective = 0.5*xv.dot(Qm*xv) + cv.dot(xv);
+    return true;
+}
+
+
+/// Dispatch of the dense QPs to the kernel of their size (see QPSmallProblemKernel), for the problems
+/// of at most s_maxDim variables and s_maxConstraints constraints.
+class SOFA_SOFTROBOTS_INVERSE_API QPSmallProblem
+{
+public:
+    static constexpr int s_maxDim = 16;
+    static constexpr int s_maxConstraints = 32;
+
+    static bool isSupported(const int& dim, const int& nbConstraints);
+
+    /// See QPSmallProblemKernel::solve(), returns false if the size is not supported
+    bool solve(const int& dim, const int& nbConstraints,
+               const double* Q, const double* c, const double* A,
+               const double* l, const double* u, const double* bl, const double* bu,
+               double* x, double* y, double& objective, const int& maxIterations);
+
+    int getNbIterations() const {return m_nbIterations;}
+
+protected:
+    int m_nbIterations{0};
+};
+
+} // namespace
@@ -0,0 +1,119 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#include <SoftRobots.Inverse/component/solver/modules/QPSolveWorker.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+QPSolveWorker::~QPSolveWorker()
+{
+    stop();
+}
+
+
+void QPSolveWorker::start(QPInverseProblemImpl* problem)
+{
+    if(!m_thread.joinable())
+    {
+        m_stop = false;
+        m_thread = std::thread(&QPSolveWorker::solveLoop, this);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_problem = problem;
+        m_isSolved = false;
+    }
+    m_condition.notify_all();
+}
+
+
+QPInverseProblemImpl* QPSolveWorker::wait(double& objective, int& iterations)
+{
+    if(!m_problem)
+        return nullptr;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_condition.wait(lock, [this]{return m_isSolved;});
+    objective = m_objective;
+    iterations = m_iterations;
+
+    QPInverseProblemImpl* problem = m_problem;
+    m_problem = nullptr;
+    return problem;
+}
+
+
+void QPSolveWorker::stop()
+{
+    if(!m_thread.joinable())
+        return;
+
+    double objective;
+    int iterations;
+    wait(objective, iterations);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_condition.notify_all();
+    m_thread.join();
+}
+
+
+void QPSolveWorker::solveLoop()
+{
+    while(true)
+    {
+        QPInverseProblemImpl* problem = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this]{return m_stop || (m_problem && !m_isSolved);});
+            if(m_stop)
+                return;
+            problem = m_problem;
+        }
+
+        double objective = 0.;
+        int iterations = 0;
+        problem->solve(objective, iterations);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_objective = objective;
+            m_iterations = iterations;
+            m_isSolved = true;
+        }
+        m_condition.notify_all();
+    }
+}
+
+} // namespace
@@ -0,0 +1,76 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include <SoftRobots.Inverse/component/solver/modules/QPInverseProblemImpl.h>
+#include <SoftRobots.Inverse/component/config.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+/// Solves one constraint problem at a time on a background thread, while the simulation proceeds.
+///
+/// start() hands the problem to the thread, started the first time, and returns. wait() blocks until
+/// the problem is solved, and gives it back with its objective and iterations. The problem must be
+/// detached (see QPInverseProblem::setDetached), so that its resolution does not access the constraint
+/// components the simulation thread is updating.
+class SOFA_SOFTROBOTS_INVERSE_API QPSolveWorker
+{
+public:
+    QPSolveWorker() {}
+    ~QPSolveWorker();
+
+    void start(QPInverseProblemImpl* problem);
+    /// Returns the problem solved, nullptr if none was started
+    QPInverseProblemImpl* wait(double& objective, int& iterations);
+    /// Waits for the problem in flight, if any, and stops the thread
+    void stop();
+
+    /// Problem in flight, nullptr if none
+    const QPInverseProblemImpl* getProblem() const {return m_problem;}
+
+protected:
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    QPInverseProblemImpl* m_problem{nullptr}; // only set and reset by the simulation thread
+    bool m_isSolved{false};
+    bool m_stop{false};
+    double m_objective{0.};
+    int m_iterations{0};
+
+    void solveLoop();
+};
+
+} // namespace
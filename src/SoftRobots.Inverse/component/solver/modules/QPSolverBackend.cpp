@@ -0,0 +1,90 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+
+#include <algorithm>
+#include <qpOASES.hpp>
+
+#include <SoftRobots.Inverse/component/solver/modules/QPSolverBackend.h>
+#include <SoftRobots.Inverse/component/solver/modules/ADMMSolverBackend.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+using qpOASES::QProblem;
+using qpOASES::Options;
+using qpOASES::int_t;
+using qpOASES::returnValue;
+
+
+QPSolverBackend* QPSolverBackend::create(const std::string& name)
+{
+    if(name == "qpOASES")
+        return new QPOASESSolverBackend();
+    if(name == "ADMM")
+        return new ADMMSolverBackend();
+    return nullptr;
+}
+
+
+bool QPOASESSolverBackend::solve(int nbVariables, int nbConstraints,
+                                 const real_t* H, const real_t* g, const real_t* A,
+                                 const real_t* lb, const real_t* ub, const real_t* lbA, const real_t* ubA,
+                                 real_t* x, real_t* y, real_t& objective)
+{
+    QProblem problem(nbVariables, nbConstraints);
+    Options options;
+    problem.setOptions(options);
+    problem.setPrintLevel(qpOASES::PL_NONE);
+
+    int_t nWSR = m_maxNbWorkingSetChanges;
+    real_t cputime = m_timeLimit;
+    returnValue status = problem.init(H, g, A, lb, ub, lbA, ubA, nWSR, (m_timeLimit>0.)? &cputime : nullptr);
+
+    // qpOASES stops before the maximum number of working set changes when the time limit is exhausted
+    m_timeLimitReached = (m_timeLimit>0. && status == qpOASES::RET_MAX_NWSR_REACHED && nWSR<m_maxNbWorkingSetChanges);
+    m_nbIterations = nWSR;
+
+    problem.getPrimalSolution(x);
+    problem.getDualSolution(y);
+    objective = problem.getObjVal();
+
+    return (status == qpOASES::SUCCESSFUL_RETURN && !problem.isInfeasible());
+}
+
+
+size_t QPOASESSolverBackend::getProblemMemoryUsage(const int& nbVariables, const int& nbConstraints)
+{
+    const size_t nV = std::max(nbVariables, 0);
+    const size_t nC = std::max(nbConstraints, 0);
+    const size_t sizeT = std::min(nV, nC);
+    return sizeof(real_t)*(2*nV*nV + sizeT*sizeT + 10*nV + 10*nC);
+}
+
+} // namespace
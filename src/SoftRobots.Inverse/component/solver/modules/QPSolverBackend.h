@@ -0,0 +1,116 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <qpOASES/Types.hpp>
+
+#include <SoftRobots.Inverse/component/config.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+using qpOASES::real_t;
+
+/// Dense QP solver used by the inverse problem and the contact LCP:
+///     min 1/2 x^T H x + g^T x    s.t.    lb <= x <= ub,    lbA <= A x <= ubA
+/// H (nbVariables x nbVariables) and A (nbConstraints x nbVariables) are row-major.
+/// Infinite bounds are given as values beyond +/-1e20.
+/// The dual solution y = [y_bounds; y_constraints] follows the qpOASES convention:
+/// positive for an active lower bound, negative for an active upper bound.
+class SOFA_SOFTROBOTS_INVERSE_API QPSolverBackend
+{
+public:
+    virtual ~QPSolverBackend() {}
+
+    /// Returns false if the problem could not be solved (infeasible or not converged)
+    virtual bool solve(int nbVariables, int nbConstraints,
+                       const real_t* H, const real_t* g, const real_t* A,
+                       const real_t* lb, const real_t* ub, const real_t* lbA, const real_t* ubA,
+                       real_t* x, real_t* y, real_t& objective) = 0;
+
+    virtual std::string getName() const = 0;
+
+    /// Time limit of one resolution in seconds, 0 for no limit. When the limit stops the resolution,
+    /// solve() returns false, isTimeLimitReached() returns true and x holds the last iterate if available.
+    void setTimeLimit(const double& timeLimit) {m_timeLimit = timeLimit;}
+    bool isTimeLimitReached() const {return m_timeLimitReached;}
+
+    /// Number of iterations of the last resolution (working set changes for an active-set solver)
+    int getNbIterations() const {return m_nbIterations;}
+
+    /// If true, the backends solving a linear system at each iteration (ADMM) factorize it by blocks when it
+    /// has a bordered block-diagonal structure, the last borderSize variables being in the border (e.g. the
+    /// contacts coupling the fingers of a gripper, see QPBorderedFactorization)
+    void setStructuredFactorization(const bool& structured, const unsigned int& borderSize)
+    {
+        m_structuredFactorization = structured;
+        m_borderSize = borderSize;
+    }
+    /// The blocks of the structured factorization are factorized on the task scheduler
+    void setMultithreading(const bool& multithreading) {m_multithreading = multithreading;}
+
+    /// Creates the backend of the given name ("qpOASES" or "ADMM"), nullptr if unknown
+    static QPSolverBackend* create(const std::string& name);
+
+protected:
+    double m_timeLimit{0.};
+    bool m_timeLimitReached{false};
+    int m_nbIterations{0};
+    bool m_structuredFactorization{false};
+    unsigned int m_borderSize{0};
+    bool m_multithreading{false};
+};
+
+
+/// Active-set solver of qpOASES, cold started at each resolution
+class SOFA_SOFTROBOTS_INVERSE_API QPOASESSolverBackend : public QPSolverBackend
+{
+public:
+    bool solve(int nbVariables, int nbConstraints,
+               const real_t* H, const real_t* g, const real_t* A,
+               const real_t* lb, const real_t* ub, const real_t* lbA, const real_t* ubA,
+               real_t* x, real_t* y, real_t& objective) override;
+
+    std::string getName() const override {return "qpOASES";}
+
+    /// Largest number of working set changes of a resolution (nWSR)
+    void setMaxNbWorkingSetChanges(const int& maxNbWorkingSetChanges) {m_maxNbWorkingSetChanges = maxNbWorkingSetChanges;}
+
+    /// Estimate in bytes of the memory held by a qpOASES problem of this size: its factorizations
+    /// (R and Q of size nV x nV, T of size min(nV,nC)^2) and its vectors
+    static size_t getProblemMemoryUsage(const int& nbVariables, const int& nbConstraints);
+
+protected:
+    int m_maxNbWorkingSetChanges{500};
+};
+
+} // namespace
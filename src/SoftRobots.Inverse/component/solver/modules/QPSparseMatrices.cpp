@@ -0,0 +1,123 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+
+#include <SoftRobots.Inverse/component/solver/modules/QPSparseMatrices.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+QPSparseMatrices::~QPSparseMatrices()
+{
+    deleteMatrices();
+}
+
+
+bool QPSparseMatrices::update(const real_t* Q, const real_t* A, const int& nbVariables, const int& nbConstraints)
+{
+    deleteMatrices();
+    m_isUsed = false;
+    m_density = 1.;
+    if(m_densityThreshold<=0. || nbVariables==0)
+        return false;
+
+    // The diagonal of Q is always stored, qpOASES looks for it in the compressed columns of the Hessian
+    size_t nbNonZeros = 0;
+    for(int i=0; i<nbVariables; i++)
+        for(int j=0; j<nbVariables; j++)
+            if(Q[i*nbVariables+j] != 0. || i==j)
+                nbNonZeros++;
+    for(int k=0; k<nbConstraints*nbVariables; k++)
+        if(A[k] != 0.)
+            nbNonZeros++;
+
+    m_density = double(nbNonZeros)/(double(nbVariables)*double(nbVariables+nbConstraints));
+    if(m_density > m_densityThreshold)
+        return false;
+
+    m_HRowIds.clear();
+    m_HValues.clear();
+    m_HColumnStarts.resize(nbVariables+1);
+    for(int j=0; j<nbVariables; j++)
+    {
+        m_HColumnStarts[j] = m_HRowIds.size();
+        for(int i=0; i<nbVariables; i++)
+        {
+            const real_t v = Q[j*nbVariables+i];
+            if(v != 0. || i==j)
+            {
+                m_HRowIds.push_back(i);
+                m_HValues.push_back(v);
+            }
+        }
+    }
+    m_HColumnStarts[nbVariables] = m_HRowIds.size();
+
+    m_AColumnIds.clear();
+    m_AValues.clear();
+    m_ARowStarts.resize(nbConstraints+1);
+    for(int i=0; i<nbConstraints; i++)
+    {
+        m_ARowStarts[i] = m_AColumnIds.size();
+        for(int j=0; j<nbVariables; j++)
+        {
+            const real_t v = A[i*nbVariables+j];
+            if(v != 0.)
+            {
+                m_AColumnIds.push_back(j);
+                m_AValues.push_back(v);
+            }
+        }
+    }
+    m_ARowStarts[nbConstraints] = m_AColumnIds.size();
+
+    m_H = new qpOASES::SymSparseMat(nbVariables, nbVariables, m_HRowIds.data(), m_HColumnStarts.data(), m_HValues.data());
+    m_H->createDiagInfo();
+    m_A = new qpOASES::SparseMatrixRow(nbConstraints, nbVariables, m_ARowStarts.data(), m_AColumnIds.data(), m_AValues.data());
+    m_isUsed = true;
+    return true;
+}
+
+
+size_t QPSparseMatrices::getMemoryUsage() const
+{
+    return sizeof(sparse_int_t)*(m_HRowIds.capacity() + m_HColumnStarts.capacity() + m_ARowStarts.capacity() + m_AColumnIds.capacity())
+            + sizeof(real_t)*(m_HValues.capacity() + m_AValues.capacity());
+}
+
+
+void QPSparseMatrices::deleteMatrices()
+{
+    delete m_H;
+    m_H = nullptr;
+    delete m_A;
+    m_A = nullptr;
+}
+
+} // namespace
@@ -0,0 +1,96 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <qpOASES/Matrices.hpp>
+#include <sofa/type/vector.h>
+
+#include <SoftRobots.Inverse/component/config.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+using sofa::type::vector;
+using qpOASES::real_t;
+using qpOASES::sparse_int_t;
+
+/// Compressed copies of the Hessian and of the constraint matrix of a QP, given to qpOASES instead of the
+/// dense row-major arrays when they have many structural zeros (e.g. the many rows of a ForceSurfaceActuator
+/// or of a BarycentricCenterEffector, which only couple a few nodes). qpOASES then only visits the nonzeros
+/// in its products with H and A.
+///
+/// The matrices are rebuilt by each call to update(). qpOASES keeps a shallow copy of the matrices it is
+/// given, without owning them: a problem solved with them must be given new matrices (or be deleted) before
+/// it is used after the next update.
+class SOFA_SOFTROBOTS_INVERSE_API QPSparseMatrices
+{
+public:
+    ~QPSparseMatrices();
+
+    /// Largest density (ratio of nonzeros) of [Q; A] for which the compressed matrices are used,
+    /// 0 (default) to always give the dense arrays to qpOASES
+    void setDensityThreshold(const double& threshold) {m_densityThreshold = threshold;}
+    double getDensityThreshold() const {return m_densityThreshold;}
+
+    /// Measures the density of Q (nbVariables x nbVariables) and A (nbConstraints x nbVariables), both
+    /// row-major, and builds the compressed matrices if it is below the threshold. Returns isUsed().
+    bool update(const real_t* Q, const real_t* A, const int& nbVariables, const int& nbConstraints);
+
+    /// Whether the last update built the compressed matrices
+    bool isUsed() const {return m_isUsed;}
+    /// Density of [Q; A] at the last update
+    double getDensity() const {return m_density;}
+
+    qpOASES::SymSparseMat* getHessian() {return m_H;}
+    qpOASES::SparseMatrixRow* getConstraintMatrix() {return m_A;}
+
+    size_t getMemoryUsage() const;
+
+protected:
+    double m_densityThreshold{0.};
+    bool m_isUsed{false};
+    double m_density{1.};
+
+    // Q is symmetric, its compressed rows are its compressed columns
+    vector<sparse_int_t> m_HRowIds;
+    vector<sparse_int_t> m_HColumnStarts;
+    vector<real_t> m_HValues;
+    vector<sparse_int_t> m_ARowStarts;
+    vector<sparse_int_t> m_AColumnIds;
+    vector<real_t> m_AValues;
+
+    qpOASES::SymSparseMat* m_H{nullptr};
+    qpOASES::SparseMatrixRow* m_A{nullptr};
+
+    void deleteMatrices();
+};
+
+} // namespace
@@ -0,0 +1,144 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+
+#include <algorithm>
+#include <qpOASES/QProblem.hpp>
+#include <sofa/simulation/MainTaskSchedulerFactory.h>
+
+#include <SoftRobots.Inverse/component/solver/modules/QPSpeculativePivots.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+void QPSpeculativePivots::begin(const int& nbVariables, const double* Q, const double* c,
+                                const qpOASES::HessianType& hessianType, const int& nWSRLimit)
+{
+    m_nbVariables = nbVariables;
+    m_Q = Q;
+    m_c = c;
+    m_hessianType = hessianType;
+    m_nWSRLimit = nWSRLimit;
+    m_nbCandidates = 0;
+}
+
+
+void QPSpeculativePivots::addCandidate(const int& pivot, const QPInverseProblem::QPSystem& system)
+{
+    if(m_candidates.size() <= m_nbCandidates)
+        m_candidates.emplace_back();
+    Candidate& candidate = m_candidates[m_nbCandidates++];
+
+    const int dim = m_nbVariables;
+    const int ASize = system.A.size();
+    const int AeqSize = system.Aeq.size();
+    candidate.pivot = pivot;
+    candidate.nbConstraints = ASize + AeqSize;
+    candidate.isSolved = false;
+
+    // Same layout as given to qpOASES by QPInverseProblemImpl::updateOASESMatrices()
+    candidate.A.resize(candidate.nbConstraints*dim);
+    std::copy(system.A.data(), system.A.data() + ASize*dim, candidate.A.begin());
+    std::copy(system.Aeq.data(), system.Aeq.data() + AeqSize*dim, candidate.A.begin() + ASize*dim);
+
+    candidate.l.assign(system.l.begin(), system.l.begin() + dim);
+    candidate.u.assign(system.u.begin(), system.u.begin() + dim);
+    candidate.bl.resize(candidate.nbConstraints);
+    candidate.bu.resize(candidate.nbConstraints);
+    for(int i=0; i<ASize; i++)
+    {
+        candidate.bu[i] = system.bu[i];
+        candidate.bl[i] = (system.hasBothSideInequalityConstraint)? system.bl[i] : -1e99;
+    }
+    for(int i=0; i<AeqSize; i++)
+    {
+        candidate.bu[ASize+i] = system.beq[i];
+        candidate.bl[ASize+i] = system.beq[i];
+    }
+}
+
+
+void QPSpeculativePivots::solve()
+{
+    if(!m_multithreading || m_nbCandidates < 2)
+    {
+        for(unsigned int i=0; i<m_nbCandidates; i++)
+            solveCandidate(m_candidates[i]);
+        return;
+    }
+
+    sofa::simulation::TaskScheduler* taskScheduler = (m_taskScheduler)? m_taskScheduler :
+                                                      sofa::simulation::MainTaskSchedulerFactory::createInRegistry();
+    sofa::simulation::CpuTask::Status status;
+
+    vector<SolveTask> tasks;
+    tasks.resize(m_nbCandidates, SolveTask(&status));
+    for(unsigned int i=0; i<m_nbCandidates; i++)
+    {
+        tasks[i].set(this, &m_candidates[i]);
+        taskScheduler->addTask(&tasks[i]);
+    }
+    taskScheduler->workUntilDone(&status);
+}
+
+
+void QPSpeculativePivots::solveCandidate(Candidate& candidate) const
+{
+    const int dim = m_nbVariables;
+    candidate.x.resize(dim);
+
+    qpOASES::int_t nWSR = m_nWSRLimit;
+    qpOASES::returnValue status;
+    if(candidate.nbConstraints == 0)
+    {
+        qpOASES::QProblemB problem(dim, m_hessianType);
+        problem.setPrintLevel(qpOASES::PL_NONE);
+        status = problem.init(m_Q, m_c, candidate.l.data(), candidate.u.data(), nWSR);
+        candidate.isSolved = (status == qpOASES::SUCCESSFUL_RETURN && problem.isSolved());
+        if(candidate.isSolved)
+        {
+            problem.getPrimalSolution(candidate.x.data());
+            candidate.objective = problem.getObjVal();
+        }
+        return;
+    }
+
+    qpOASES::QProblem problem(dim, candidate.nbConstraints, m_hessianType);
+    problem.setPrintLevel(qpOASES::PL_NONE);
+    status = problem.init(m_Q, m_c, candidate.A.data(), candidate.l.data(), candidate.u.data(),
+                          candidate.bl.data(), candidate.bu.data(), nWSR);
+    candidate.isSolved = (status == qpOASES::SUCCESSFUL_RETURN && problem.isSolved() && !problem.isInfeasible());
+    if(candidate.isSolved)
+    {
+        problem.getPrimalSolution(candidate.x.data());
+        candidate.objective = problem.getObjVal();
+    }
+}
+
+} // namespace
@@ -0,0 +1,124 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <qpOASES/Types.hpp>
+#include <sofa/type/vector.h>
+#include <sofa/simulation/TaskScheduler.h>
+
+#include <SoftRobots.Inverse/component/solver/modules/QPInverseProblem.h>
+#include <SoftRobots.Inverse/component/config.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+using sofa::type::vector;
+
+/// QPs of the candidate pivots of an iteration of the contact pivot loop, solved ahead of the pivot.
+///
+/// The candidates share the Hessian and the linear term of the QP of the iteration (kept as pointers, they do
+/// not change with the contact states), each one has its own constraints [A; Aeq] and bounds, as built after
+/// its pivot. The QPs are solved from scratch with qpOASES, each candidate with its own QProblem and buffers,
+/// so that they are solved concurrently on the task scheduler. The caller then evaluates the progress of each
+/// solution and pivots the best one.
+class SOFA_SOFTROBOTS_INVERSE_API QPSpeculativePivots
+{
+public:
+    struct Candidate
+    {
+        int pivot{-1}; // contact row pivoted
+        int nbConstraints{0};
+        vector<double> A; // [A; Aeq], row-major
+        vector<double> l, u, bl, bu;
+
+        bool isSolved{false};
+        vector<double> x;
+        double objective{0.};
+    };
+
+    /// If true, the candidates are solved on the task scheduler
+    void setMultithreading(const bool& multithreading) {m_multithreading = multithreading;}
+    /// Scheduler running the tasks, nullptr for the main task scheduler
+    void setTaskScheduler(sofa::simulation::TaskScheduler* taskScheduler) {m_taskScheduler = taskScheduler;}
+
+    /// Number of candidate pivots solved ahead, 0 or 1 to pivot without speculation
+    void setMaxNbCandidates(const unsigned int& nbCandidates) {m_maxNbCandidates = nbCandidates;}
+    unsigned int getMaxNbCandidates() const {return m_maxNbCandidates;}
+    bool isEnabled() const {return m_maxNbCandidates > 1;}
+
+    /// Starts the candidates of an iteration, Q (row-major) and c are read until solve() returns
+    void begin(const int& nbVariables, const double* Q, const double* c,
+               const qpOASES::HessianType& hessianType, const int& nWSRLimit);
+    /// Adds a candidate with the constraints and bounds of the QP system, built after its pivot
+    void addCandidate(const int& pivot, const QPInverseProblem::QPSystem& system);
+    void solve();
+
+    unsigned int getNbCandidates() const {return m_nbCandidates;}
+    const Candidate& getCandidate(const unsigned int& i) const {return m_candidates[i];}
+
+protected:
+    bool m_multithreading{false};
+    sofa::simulation::TaskScheduler* m_taskScheduler{nullptr};
+    unsigned int m_maxNbCandidates{0};
+
+    int m_nbVariables{0};
+    const double* m_Q{nullptr};
+    const double* m_c{nullptr};
+    qpOASES::HessianType m_hessianType{qpOASES::HST_UNKNOWN};
+    int m_nWSRLimit{0};
+
+    vector<Candidate> m_candidates; // kept with their buffers, the first m_nbCandidates are used
+    unsigned int m_nbCandidates{0};
+
+    void solveCandidate(Candidate& candidate) const;
+
+    class SolveTask : public sofa::simulation::CpuTask
+    {
+    public:
+        SolveTask(sofa::simulation::CpuTask::Status* status): CpuTask(status) {}
+        ~SolveTask() override {}
+
+        MemoryAlloc run() final {
+            pivots->solveCandidate(*candidate);
+            return MemoryAlloc::Stack;
+        }
+
+        void set(const QPSpeculativePivots* _pivots, Candidate* _candidate){
+            pivots = _pivots;
+            candidate = _candidate;
+        }
+
+    private:
+        const QPSpeculativePivots* pivots{nullptr};
+        Candidate* candidate{nullptr};
+    };
+};
+
+} // namespace
@@ -0,0 +1,124 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#include <sofa/helper/logging/Messaging.h>
+#include <algorithm>
+
+#include <SoftRobots.Inverse/component/solver/modules/QPStandaloneProblem.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+QPStandaloneProblem::QPStandaloneProblem()
+{
+    m_problem.setDetached(true);
+}
+
+
+void QPStandaloneProblem::setRows(const vector<RowType>& rowTypes)
+{
+    m_problem.clearProblem();
+    QPInverseProblem::QPConstraintLists* lists = m_problem.getQPConstraintLists();
+
+    m_nbRows = rowTypes.size();
+    for(unsigned int i=0; i<m_nbRows; i++)
+    {
+        switch(rowTypes[i])
+        {
+        case RowType::Effector: lists->effectorRowIds.push_back(i); break;
+        case RowType::Actuator: lists->actuatorRowIds.push_back(i); break;
+        case RowType::Equality: lists->equalityRowIds.push_back(i); break;
+        case RowType::Contact:  lists->contactRowIds.push_back(i); break;
+        case RowType::Sensor:   lists->sensorRowIds.push_back(i); break;
+        }
+    }
+
+    // Without components, the contacts have no identity across the calls
+    lists->contactIds.assign(lists->contactRowIds.size(), QPInverseProblem::QPContactId());
+    lists->variableRows.assign(lists->actuatorRowIds.size() + lists->equalityRowIds.size() + lists->contactRowIds.size(),
+                               RowLimits());
+    lists->updateActuatorBounds();
+
+    m_problem.clear(m_nbRows);
+}
+
+
+bool QPStandaloneProblem::setLimits(const unsigned int& rowId, const RowLimits& limits)
+{
+    QPInverseProblem::QPConstraintLists* lists = m_problem.getQPConstraintLists();
+
+    // The QP variables are the actuators, then the equality rows
+    unsigned int variable = 0;
+    auto it = std::find(lists->actuatorRowIds.begin(), lists->actuatorRowIds.end(), rowId);
+    if(it != lists->actuatorRowIds.end())
+        variable = it - lists->actuatorRowIds.begin();
+    else
+    {
+        it = std::find(lists->equalityRowIds.begin(), lists->equalityRowIds.end(), rowId);
+        if(it == lists->equalityRowIds.end())
+            return false;
+        variable = lists->actuatorRowIds.size() + (it - lists->equalityRowIds.begin());
+    }
+
+    RowLimits& row = lists->variableRows[variable];
+    row = limits;
+    row.owner = nullptr;
+    row.line = 0;
+    row.nbLines = 1;
+    lists->updateActuatorBounds();
+    return true;
+}
+
+
+bool QPStandaloneProblem::solve(QPInverseProblemImpl::ConstRefMat W, QPInverseProblemImpl::ConstRefVec dFree,
+                                QPInverseProblemImpl::RefVec lambda, QPInverseProblemImpl::RefVec delta)
+{
+    const Eigen::Index nbRows = m_nbRows;
+    if(W.rows() != nbRows || W.cols() != nbRows || dFree.size() != nbRows || lambda.size() != nbRows || delta.size() != nbRows)
+    {
+        msg_error("QPStandaloneProblem") << "The sizes of W, dFree, lambda and delta should match the "
+                                         << m_nbRows << " rows given to setRows().";
+        return false;
+    }
+
+    for(unsigned int i=0; i<m_nbRows; i++)
+    {
+        for(unsigned int j=0; j<m_nbRows; j++)
+            m_problem.W[i][j] = W(i, j);
+        m_problem.dFree[i] = dFree(i);
+    }
+
+    m_problem.solve(m_objective, m_iterations);
+
+    lambda = m_problem.getLambda();
+    delta = m_problem.getDelta();
+    return true;
+}
+
+} // namespace
@@ -0,0 +1,85 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <sofa/type/vector.h>
+
+#include <SoftRobots.Inverse/component/solver/modules/QPInverseProblemImpl.h>
+#include <SoftRobots.Inverse/component/config.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+using sofa::type::vector;
+
+/// Inverse problem solved without scene, e.g. embedded in a controller process: the compliance W and the
+/// free violation dFree of the rows are given directly, with the kind of each row and the limits of the
+/// actuators, and the forces lambda and the violations delta = W*lambda + dFree are returned.
+///
+/// It wraps a QPInverseProblemImpl in detached mode, without constraint components, so that the QP is built
+/// and solved as by QPInverseProblemSolver, with the same options (see getProblem()). The buffers are kept
+/// across the calls: a call with the same rows does not allocate, and can be hot started from the previous one.
+class SOFA_SOFTROBOTS_INVERSE_API QPStandaloneProblem
+{
+public:
+    enum class RowType {Effector, Actuator, Equality, Contact, Sensor};
+
+    /// Limits of an actuator or equality row: the flags and values of the bounds, the owner is not used
+    typedef QPInverseProblem::QPVariableRow RowLimits;
+
+    QPStandaloneProblem();
+    ~QPStandaloneProblem() {}
+
+    /// Sets the kind of each row, and clears the limits. With friction, the three rows of a contact
+    /// (normal, then tangents) are consecutive.
+    void setRows(const vector<RowType>& rowTypes);
+    /// Limits of an actuator or equality row, false for another kind of row
+    bool setLimits(const unsigned int& rowId, const RowLimits& limits);
+
+    /// Solves the problem of compliance W (symmetric, nbRows x nbRows) and free violation dFree, and writes
+    /// the results into lambda and delta. Returns false if the sizes do not match the rows.
+    bool solve(QPInverseProblemImpl::ConstRefMat W, QPInverseProblemImpl::ConstRefVec dFree,
+               QPInverseProblemImpl::RefVec lambda, QPInverseProblemImpl::RefVec delta);
+
+    double getObjective() const {return m_objective;}
+    int getIterations() const {return m_iterations;}
+
+    /// Options of the resolution (setEpsilon, setFrictionCoeff, setHotStart, setQPSolver...)
+    QPInverseProblemImpl& getProblem() {return m_problem;}
+    unsigned int getNbRows() const {return m_nbRows;}
+
+protected:
+    QPInverseProblemImpl m_problem;
+    unsigned int m_nbRows{0};
+    double m_objective{0.};
+    int m_iterations{0};
+};
+
+} // namespace
@@ -0,0 +1,71 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#include <sofa/simulation/DefaultTaskScheduler.h>
+
+#include <SoftRobots.Inverse/component/solver/modules/QPTaskPool.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+QPTaskPool::~QPTaskPool()
+{
+    stop();
+}
+
+
+void QPTaskPool::init(const unsigned int& nbThreads)
+{
+    if(m_scheduler && nbThreads == m_nbThreads)
+        return;
+
+    stop();
+    m_scheduler.reset(sofa::simulation::DefaultTaskScheduler::create());
+    m_scheduler->init(nbThreads);
+    m_nbThreads = nbThreads;
+}
+
+
+void QPTaskPool::stop()
+{
+    if(!m_scheduler)
+        return;
+
+    m_scheduler->stop();
+    m_scheduler.reset();
+    m_nbThreads = 0;
+}
+
+
+unsigned int QPTaskPool::getThreadCount() const
+{
+    return (m_scheduler)? m_scheduler->getThreadCount() : 0;
+}
+
+} // namespace
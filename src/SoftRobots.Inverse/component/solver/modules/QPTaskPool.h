@@ -0,0 +1,68 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <memory>
+
+#include <sofa/simulation/TaskScheduler.h>
+
+#include <SoftRobots.Inverse/component/config.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+/// Task scheduler owned by the solver, for the compliance and contact tasks, separate from the main task
+/// scheduler of SOFA.
+///
+/// The main task scheduler is shared with the other components (force field assembly, mappings, ...) and
+/// initialized with their thread count. The threads of the pool only run the tasks of the solver, their
+/// number is chosen for the inverse problem, and their priority can be changed (see QPThreadAffinity)
+/// without changing the priority of the threads of the other components.
+class SOFA_SOFTROBOTS_INVERSE_API QPTaskPool
+{
+public:
+    ~QPTaskPool();
+
+    /// Starts the threads of the pool, 0 for one thread per core. The calling thread is one of them, as it
+    /// runs tasks while waiting for them. Restarts the pool if the number of threads changed.
+    void init(const unsigned int& nbThreads);
+    void stop();
+
+    bool isStarted() const {return m_scheduler != nullptr;}
+    /// Scheduler of the pool, nullptr if it is not started
+    sofa::simulation::TaskScheduler* getTaskScheduler() const {return m_scheduler.get();}
+    unsigned int getThreadCount() const;
+
+protected:
+    std::unique_ptr<sofa::simulation::TaskScheduler> m_scheduler;
+    unsigned int m_nbThreads{0}; // as requested, 0 for one thread per core
+};
+
+} // namespace
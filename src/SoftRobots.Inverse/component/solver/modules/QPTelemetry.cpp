@@ -0,0 +1,203 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+
+#include <SoftRobots.Inverse/component/solver/modules/QPTelemetry.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+using sofa::type::vector;
+using std::string;
+
+
+namespace
+{
+
+const string s_entryNames[QPTelemetry::NbEntries] = {"#Effectors:", "#Actuators:", "#Equality:", "#Contacts:",
+                                                      "Last Objective:", "Last Iterations:",
+                                                      "Max nWSR:", "Pivot limit:", "nWSR limit:", "#nWSR limit hits:",
+                                                      "#Subproblems:",
+                                                      "#HotStart hits:", "#HotStart misses:",
+                                                      "#Contact-free hot starts:", "#Contact-free factorization reuses:",
+                                                      "#Parametric hot starts:", "#Parametric factorizations:",
+                                                      "#Active set cache hits:", "#Active set cache misses:",
+                                                      "#Warm started contacts:", "#Reduced contacts:", "#Presolved rows:", "#Equality eliminations:",
+                                                      "#Single pivot fallbacks:", "#Pivot cycles:",
+                                                      "NLCP iterations:", "NLCP error:", "#NLCP not converged:",
+                                                      "#Deadline hits:",
+                                                      "#Compliance table hits:", "#Compliance table misses:",
+                                                      "#Skipped solves:", "#Forward steps:",
+                                                      "#Constant rows reuses:",
+                                                      "#Priority levels:",
+                                                      "#Primal warm starts:",
+                                                      "Epsilon scale:",
+                                                      "#Small problem solves:",
+                                                      "#Contact patches:", "#Refined patches:",
+                                                      "#Consensus iterations:",
+                                                      "#Speculative pivots:",
+                                                      "#Compliance products:",
+                                                      "#Lazy contacts:",
+                                                      "#Lazy contact misses:",
+                                                      "#Interior solves:",
+                                                      "#Suppressed messages:",
+                                                      "#Dropped messages:",
+                                                      "#Deadband effectors:",
+                                                      "#Tracked contacts:",
+                                                      "#New contacts:",
+                                                      "#qpOASES resolutions:",
+                                                      "#Working set changes:",
+                                                      "#Bound flips:",
+                                                      "#Factorizations:",
+                                                      "#Factorization updates:",
+                                                      "#Rampings:",
+                                                      "#Regularized Hessians:",
+                                                      "#HST_INDEF fallbacks:",
+                                                      "#Interior selections:",
+                                                      "#Small kernel selections:",
+                                                      "#Active set selections:",
+                                                      "#ADMM selections:"};
+
+const string s_seriesNames[QPTelemetry::NbSeries] = {"Pivots per iteration:", "NLCP residuals:"};
+
+}
+
+
+const string& QPTelemetry::getName(const Entry& entry)
+{
+    return s_entryNames[entry];
+}
+
+
+const string& QPTelemetry::getName(const Series& series)
+{
+    return s_seriesNames[series];
+}
+
+
+void QPTelemetry::setHistoryLength(const unsigned int& length)
+{
+    if(length == m_historyLength)
+        return;
+
+    m_historyLength = length;
+    m_history.assign(NbEntries*length, 0.);
+    m_historySize = 0;
+    m_next = 0;
+}
+
+
+void QPTelemetry::beginStep()
+{
+    for(unsigned int i=0; i<NbEntries; i++)
+        m_published[i] = false;
+    for(unsigned int i=0; i<NbSeries; i++)
+        m_seriesPublished[i] = false;
+}
+
+
+void QPTelemetry::set(const Entry& entry, const double& value)
+{
+    m_values[entry] = value;
+    m_published[entry] = true;
+}
+
+
+vector<SReal>& QPTelemetry::getSeries(const Series& series)
+{
+    m_seriesPublished[series] = true;
+    m_series[series].clear();
+    return m_series[series];
+}
+
+
+void QPTelemetry::endStep()
+{
+    if(m_historyLength == 0)
+        return;
+
+    for(unsigned int i=0; i<NbEntries; i++)
+        m_history[i*m_historyLength + m_next] = m_values[i];
+
+    m_next = (m_next+1)%m_historyLength;
+    if(m_historySize < m_historyLength)
+        m_historySize++;
+}
+
+
+void QPTelemetry::clear()
+{
+    for(unsigned int i=0; i<NbEntries; i++)
+        m_values[i] = 0.;
+    for(unsigned int i=0; i<NbSeries; i++)
+        m_series[i].clear();
+    beginStep();
+
+    m_historySize = 0;
+    m_next = 0;
+}
+
+
+double QPTelemetry::getHistory(const Entry& entry, const unsigned int& k) const
+{
+    if(k >= m_historySize)
+        return 0.;
+
+    const unsigned int id = (m_next + m_historyLength - 1 - k)%m_historyLength;
+    return m_history[entry*m_historyLength + id];
+}
+
+
+void QPTelemetry::writeGraph(Graph& graph) const
+{
+    for(unsigned int i=0; i<NbEntries; i++)
+    {
+        if(!m_published[i])
+            continue;
+
+        auto it = graph.find(s_entryNames[i]);
+        if(it == graph.end())
+            it = graph.emplace(s_entryNames[i], vector<SReal>()).first;
+        it->second.clear();
+        it->second.push_back(m_values[i]);
+    }
+
+    for(unsigned int i=0; i<NbSeries; i++)
+    {
+        if(!m_seriesPublished[i])
+            continue;
+
+        auto it = graph.find(s_seriesNames[i]);
+        if(it == graph.end())
+            it = graph.emplace(s_seriesNames[i], vector<SReal>()).first;
+        it->second.assign(m_series[i].begin(), m_series[i].end());
+    }
+}
+
+} // namespace
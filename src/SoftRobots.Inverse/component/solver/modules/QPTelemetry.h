@@ -0,0 +1,120 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <map>
+#include <string>
+#include <sofa/type/vector.h>
+
+#include <SoftRobots.Inverse/component/config.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+/// Report of the last resolutions of the solver, in a fixed layout: a value per entry for the last step,
+/// with a ring buffer of its last values, and two series (pivots per iteration, NLCP residuals). The buffers
+/// are allocated once, writing a step does not allocate (the series only grow past their largest size).
+/// Only the entries set during the step are published, the others keep their last value but are not shown.
+class SOFA_SOFTROBOTS_INVERSE_API QPTelemetry
+{
+public:
+    typedef std::map<std::string, sofa::type::vector<SReal>> Graph;
+
+    enum Entry {NbEffectors, NbActuators, NbEquality, NbContacts,
+                LastObjective, LastIterations,
+                MaxNbWorkingSetChanges, PivotLimit, WorkingSetLimit, NbWorkingSetLimitHits,
+                NbSubproblems,
+                NbHotStartHits, NbHotStartMisses, NbContactFreeHotStarts, NbContactFreeFactorizationReuses,
+                NbParametricHotStarts, NbParametricFactorizations,
+                NbActiveSetCacheHits, NbActiveSetCacheMisses,
+                NbWarmStartedContacts, NbReducedContacts, NbPresolvedRows, NbEqualityEliminations,
+                NbSinglePivotFallbacks, NbPivotCycles,
+                NLCPIterations, NLCPError, NbNLCPNotConverged,
+                NbDeadlineHits,
+                NbComplianceTableHits, NbComplianceTableMisses,
+                NbSkippedSolves, NbForwardSteps, NbConstantRowsReuses,
+                NbPriorityLevels, NbPrimalWarmStarts,
+                EpsilonScale, NbSmallProblemSolves,
+                NbContactPatches, NbRefinedPatches, NbConsensusIterations,
+                NbSpeculativePivots, NbComplianceProducts, NbLazyContacts, NbLazyContactMisses,
+                NbInteriorSolves, NbSuppressedMessages, NbDroppedMessages,
+                NbDeadbandEffectors, NbTrackedContacts, NbNewContacts,
+                NbQPOASESResolutions, NbWorkingSetChanges, NbBoundFlips, NbFactorizations, NbFactorizationUpdates,
+                NbRampings, NbRegularizations, NbIndefiniteFallbacks,
+                NbInteriorSelections, NbSmallKernelSelections, NbActiveSetSelections, NbADMMSelections,
+                NbEntries};
+
+    enum Series {PivotsPerIteration, NLCPResiduals, NbSeries};
+
+    /// Key of the entry in the graph view (as shown by the GUI)
+    static const std::string& getName(const Entry& entry);
+    static const std::string& getName(const Series& series);
+
+    /// Number of values kept for each entry, 0 to only keep the last one
+    void setHistoryLength(const unsigned int& length);
+    unsigned int getHistoryLength() const {return m_historyLength;}
+
+    /// Unpublishes the entries and series, before they are set for the new step
+    void beginStep();
+    void set(const Entry& entry, const double& value);
+    void endStep();
+
+    /// Series of the step, cleared and filled in place
+    sofa::type::vector<SReal>& getSeries(const Series& series);
+
+    /// Removes the values and the history, the buffers are kept
+    void clear();
+
+    bool isPublished(const Entry& entry) const {return m_published[entry];}
+    bool isPublished(const Series& series) const {return m_seriesPublished[series];}
+    double get(const Entry& entry) const {return m_values[entry];}
+    const sofa::type::vector<SReal>& getSeries(const Series& series) const {return m_series[series];}
+
+    /// Value of the entry k steps ago (0 is the last step), in the history of the published values
+    double getHistory(const Entry& entry, const unsigned int& k) const;
+    unsigned int getHistorySize() const {return m_historySize;}
+
+    /// Writes the published entries and series in the graph, the existing keys reuse their vectors
+    void writeGraph(Graph& graph) const;
+
+protected:
+
+    double m_values[NbEntries]{};
+    bool   m_published[NbEntries]{};
+    sofa::type::vector<SReal> m_series[NbSeries];
+    bool   m_seriesPublished[NbSeries]{};
+
+    sofa::type::vector<double> m_history; // NbEntries ring buffers of m_historyLength values
+    unsigned int m_historyLength{0};
+    unsigned int m_historySize{0};
+    unsigned int m_next{0};
+};
+
+} // namespace
@@ -0,0 +1,294 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <SoftRobots.Inverse/component/solver/modules/QPTelemetryStream.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+const char QPTelemetryStream::s_magic[8] = {'S','R','I','Q','P','T','L','M'};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "The shared counters have to be lock-free");
+
+namespace
+{
+
+/// The header and the records are aligned on cache lines, so that the writer and the
+/// readers do not share a line between two records
+constexpr size_t s_alignment = 64;
+
+size_t align(const size_t& size)
+{
+    return (size + s_alignment - 1)/s_alignment*s_alignment;
+}
+
+} // namespace
+
+
+QPTelemetryStream::~QPTelemetryStream()
+{
+    close();
+}
+
+
+std::string QPTelemetryStream::getObjectName(const std::string& name)
+{
+    return (!name.empty() && name[0] == '/')? name : "/" + name;
+}
+
+
+bool QPTelemetryStream::open(const std::string& name, const unsigned int& capacity, const unsigned int& maxNbRows)
+{
+    close();
+    if(name.empty() || capacity == 0)
+        return false;
+
+#if defined(__unix__) || defined(__APPLE__)
+    m_name = getObjectName(name);
+    m_headerSize = align(sizeof(Header));
+    m_recordSize = align(sizeof(RecordHeader) + sizeof(double)*(QPTelemetry::NbEntries + NbPhases + maxNbRows));
+    m_size = m_headerSize + size_t(capacity)*m_recordSize;
+
+    // A stream left by a process which did not close it is replaced, its readers keep their mapping
+    shm_unlink(m_name.c_str());
+    const int object = shm_open(m_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if(object < 0)
+        return false;
+
+    void* data = MAP_FAILED;
+    if(ftruncate(object, m_size) == 0)
+        data = mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, object, 0);
+    ::close(object); // the mapping stays valid
+    if(data == MAP_FAILED)
+    {
+        shm_unlink(m_name.c_str());
+        return false;
+    }
+
+    m_data = static_cast<char*>(data); // zero-filled by ftruncate
+    m_isOwner = true;
+    m_capacity = capacity;
+    m_maxNbRows = maxNbRows;
+    m_nbEntries = QPTelemetry::NbEntries;
+    m_nbPhases = NbPhases;
+
+    Header* header = getHeader();
+    header->version = s_version;
+    header->headerSize = m_headerSize;
+    header->recordSize = m_recordSize;
+    header->capacity = m_capacity;
+    header->nbEntries = m_nbEntries;
+    header->nbPhases = m_nbPhases;
+    header->maxNbRows = m_maxNbRows;
+    header->writeCount.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(header->magic, s_magic, 8); // last, a reader seeing the magic sees a complete header
+    return true;
+#else
+    SOFA_UNUSED(maxNbRows);
+    return false;
+#endif
+}
+
+
+bool QPTelemetryStream::attach(const std::string& name)
+{
+    close();
+    if(name.empty())
+        return false;
+
+#if defined(__unix__) || defined(__APPLE__)
+    m_name = getObjectName(name);
+    const int object = shm_open(m_name.c_str(), O_RDONLY, 0);
+    if(object < 0)
+        return false;
+
+    struct stat status;
+    void* data = MAP_FAILED;
+    if(fstat(object, &status) == 0 && size_t(status.st_size) >= sizeof(Header))
+        data = mmap(nullptr, status.st_size, PROT_READ, MAP_SHARED, object, 0);
+    ::close(object);
+    if(data == MAP_FAILED)
+        return false;
+
+    m_data = static_cast<char*>(data);
+    m_size = status.st_size;
+
+    const Header* header = getHeader();
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const uint64_t minRecordSize = sizeof(RecordHeader) + sizeof(double)*(uint64_t(header->nbEntries) + header->nbPhases + header->maxNbRows);
+    if(std::memcmp(header->magic, s_magic, 8) != 0 || header->version > s_version
+            || header->headerSize < sizeof(Header) || header->capacity == 0
+            || header->recordSize < minRecordSize || header->recordSize % sizeof(double) != 0
+            || header->headerSize + uint64_t(header->capacity)*header->recordSize > m_size)
+    {
+        close();
+        return false;
+    }
+
+    m_headerSize = header->headerSize;
+    m_recordSize = header->recordSize;
+    m_capacity = header->capacity;
+    m_nbEntries = header->nbEntries;
+    m_nbPhases = header->nbPhases;
+    m_maxNbRows = header->maxNbRows;
+    return true;
+#else
+    return false;
+#endif
+}
+
+
+void QPTelemetryStream::close()
+{
+#if defined(__unix__) || defined(__APPLE__)
+    if(m_data)
+        munmap(m_data, m_size);
+    if(m_isOwner)
+        shm_unlink(m_name.c_str());
+#endif
+
+    m_data = nullptr;
+    m_size = 0;
+    m_name.clear();
+    m_isOwner = false;
+    m_capacity = 0;
+    m_maxNbRows = 0;
+    m_nbEntries = 0;
+    m_nbPhases = 0;
+    m_recordSize = 0;
+    m_headerSize = 0;
+}
+
+
+QPTelemetryStream::RecordHeader* QPTelemetryStream::getRecord(const uint64_t& n) const
+{
+    return reinterpret_cast<RecordHeader*>(m_data + m_headerSize + (n % m_capacity)*m_recordSize);
+}
+
+
+double* QPTelemetryStream::getEntries(RecordHeader* record) const
+{
+    return reinterpret_cast<double*>(reinterpret_cast<char*>(record) + sizeof(RecordHeader));
+}
+
+
+double* QPTelemetryStream::getPhaseTimes(RecordHeader* record) const
+{
+    return getEntries(record) + m_nbEntries;
+}
+
+
+double* QPTelemetryStream::getLambda(RecordHeader* record) const
+{
+    return getPhaseTimes(record) + m_nbPhases;
+}
+
+
+uint64_t QPTelemetryStream::getWriteCount() const
+{
+    return (m_data)? getHeader()->writeCount.load(std::memory_order_acquire) : 0;
+}
+
+
+void QPTelemetryStream::write(const Sample& sample)
+{
+    if(!m_isOwner)
+        return;
+
+    Header* header = getHeader();
+    const uint64_t n = header->writeCount.load(std::memory_order_relaxed);
+    RecordHeader* record = getRecord(n);
+
+    // Seqlock: odd while the slot is written, the readers retry or skip the record
+    record->sequence.store(2*n+1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    const unsigned int nbRows = std::min<size_t>(sample.lambda.size(), m_maxNbRows);
+    record->step = sample.step;
+    record->time = sample.time;
+    record->objective = sample.objective;
+    record->iterations = sample.iterations;
+    record->nbRows = nbRows;
+    std::memcpy(record->deltaNorms, sample.deltaNorms, sizeof(sample.deltaNorms));
+    std::memcpy(getEntries(record), sample.entries, sizeof(sample.entries));
+    std::memcpy(getPhaseTimes(record), sample.phaseTimes, sizeof(sample.phaseTimes));
+    if(nbRows > 0)
+        std::memcpy(getLambda(record), sample.lambda.data(), sizeof(double)*nbRows);
+
+    record->sequence.store(2*(n+1), std::memory_order_release);
+    header->writeCount.store(n+1, std::memory_order_release);
+}
+
+
+bool QPTelemetryStream::read(const uint64_t& n, Sample& sample) const
+{
+    const uint64_t writeCount = getWriteCount();
+    if(n >= writeCount || writeCount - n > m_capacity)
+        return false;
+
+    RecordHeader* record = getRecord(n);
+    const uint64_t sequence = record->sequence.load(std::memory_order_acquire);
+    if(sequence != 2*(n+1))
+        return false;
+
+    const unsigned int nbRows = std::min(record->nbRows, m_maxNbRows);
+    const unsigned int nbEntries = std::min<unsigned int>(m_nbEntries, QPTelemetry::NbEntries);
+    const unsigned int nbPhases = std::min<unsigned int>(m_nbPhases, NbPhases);
+    sample.step = record->step;
+    sample.time = record->time;
+    sample.objective = record->objective;
+    sample.iterations = record->iterations;
+    std::memcpy(sample.deltaNorms, record->deltaNorms, sizeof(sample.deltaNorms));
+    std::fill(sample.entries, sample.entries + QPTelemetry::NbEntries, std::numeric_limits<double>::quiet_NaN());
+    std::memcpy(sample.entries, getEntries(record), sizeof(double)*nbEntries);
+    std::fill(sample.phaseTimes, sample.phaseTimes + NbPhases, std::numeric_limits<double>::quiet_NaN());
+    std::memcpy(sample.phaseTimes, getPhaseTimes(record), sizeof(double)*nbPhases);
+    sample.lambda.resize(nbRows);
+    if(nbRows > 0)
+        std::memcpy(sample.lambda.data(), getLambda(record), sizeof(double)*nbRows);
+
+    // The copy is valid if the writer did not start rewriting the slot meanwhile
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return record->sequence.load(std::memory_order_relaxed) == sequence;
+}
+
+} // namespace
@@ -0,0 +1,154 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <sofa/type/vector.h>
+
+#include <SoftRobots.Inverse/component/solver/modules/QPTelemetry.h>
+#include <SoftRobots.Inverse/component/config.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+/// Ring buffer of per-step records in a POSIX shared memory object, written by the solver and read by
+/// external processes (dashboards) without any synchronization with the simulation thread: the writer
+/// never waits, a reader copies a record and checks that it was not rewritten meanwhile (seqlock).
+///
+/// Layout (byte order of the machine, versioned by s_version):
+///   Header  magic "SRIQPTLM", version, headerSize, recordSize, capacity, nbEntries, nbPhases, maxNbRows,
+///           reserved (uint32), writeCount (uint64, number of records written)
+///   Records capacity slots of recordSize bytes from headerSize, record n in slot n % capacity:
+///           sequence (uint64, odd while the slot is written, 2*(n+1) once record n is written),
+///           step (uint64), time, objective (double), iterations (int32), nbRows (uint32),
+///           deltaNorms (NbDeltaNorms doubles), entries (nbEntries doubles, the QPTelemetry entries, NaN
+///           when not published), phaseTimes (nbPhases doubles, in ms), lambda (maxNbRows doubles, the
+///           first nbRows are set)
+/// The offsets of the entries, phase times and lambdas follow from the sizes of the header, so that the
+/// readers keep reading the streams of the versions adding entries or phases. On the platforms without shared memory, open() fails.
+class SOFA_SOFTROBOTS_INVERSE_API QPTelemetryStream
+{
+public:
+    enum Phase {AccumulatePhase, ViolationPhase, CompliancePhase, SolvePhase, CorrectionPhase, LambdaStorePhase,
+                QPBuildPhase, LCPPhase, QPsPhase,
+                NbPhases};
+
+    /// Norms of delta (W lambda + dfree) over the rows of the effectors, actuators and contacts
+    enum DeltaNorm {EffectorDeltaNorm, ActuatorDeltaNorm, ContactDeltaNorm, NbDeltaNorms};
+
+    struct Sample {
+        uint64_t step{0};
+        double time{0.};
+        double objective{0.};
+        int iterations{0};
+        double deltaNorms[NbDeltaNorms]{};
+        double entries[QPTelemetry::NbEntries]{};
+        double phaseTimes[NbPhases]{};
+        sofa::type::vector<double> lambda;
+    };
+
+    QPTelemetryStream() {}
+    ~QPTelemetryStream();
+    QPTelemetryStream(const QPTelemetryStream&) = delete;
+    QPTelemetryStream& operator=(const QPTelemetryStream&) = delete;
+
+    /// Creates the shared memory object (replacing an existing one) with capacity records of up to
+    /// maxNbRows lambdas. The name is prefixed with '/' if it does not start with it.
+    bool open(const std::string& name, const unsigned int& capacity, const unsigned int& maxNbRows);
+    /// Maps an existing object read-only, as a reader
+    bool attach(const std::string& name);
+    /// Unmaps the object, and removes it if it was created by open()
+    void close();
+    bool isOpen() const {return m_data != nullptr;}
+
+    /// Writes the record of a step, the lambdas past maxNbRows are dropped
+    void write(const Sample& sample);
+
+    uint64_t getWriteCount() const;
+    unsigned int getCapacity() const {return m_capacity;}
+    unsigned int getMaxNbRows() const {return m_maxNbRows;}
+
+    /// Copies the record n (0 for the first one written). Returns false if it was not written yet, has been
+    /// overwritten, or is being written.
+    bool read(const uint64_t& n, Sample& sample) const;
+
+    static const char s_magic[8];
+    static constexpr uint32_t s_version{1};
+
+protected:
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t headerSize;
+        uint32_t recordSize;
+        uint32_t capacity;
+        uint32_t nbEntries;
+        uint32_t nbPhases;
+        uint32_t maxNbRows;
+        uint32_t reserved;
+        std::atomic<uint64_t> writeCount;
+    };
+
+    struct RecordHeader {
+        std::atomic<uint64_t> sequence;
+        uint64_t step;
+        double time;
+        double objective;
+        int32_t iterations;
+        uint32_t nbRows;
+        double deltaNorms[NbDeltaNorms];
+        // followed by the entries, phase times and lambdas, at the offsets given by the sizes of the header
+    };
+
+    Header* getHeader() const {return reinterpret_cast<Header*>(m_data);}
+    RecordHeader* getRecord(const uint64_t& n) const;
+    double* getEntries(RecordHeader* record) const;
+    double* getPhaseTimes(RecordHeader* record) const;
+    double* getLambda(RecordHeader* record) const;
+
+    static std::string getObjectName(const std::string& name);
+
+    char* m_data{nullptr};
+    size_t m_size{0};
+    std::string m_name;
+    bool m_isOwner{false}; // true when created by open()
+    unsigned int m_capacity{0};
+    unsigned int m_maxNbRows{0};
+    uint32_t m_nbEntries{0}; // of the object, possibly fewer than the entries of this version for a reader
+    uint32_t m_nbPhases{0};
+    uint32_t m_recordSize{0};
+    uint32_t m_headerSize{0};
+};
+
+} // namespace
@@ -0,0 +1,160 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#include <fstream>
+#include <sstream>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <SoftRobots.Inverse/component/solver/modules/QPThreadAffinity.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+using sofa::type::vector;
+
+std::atomic<unsigned int> QPThreadAffinity::s_generation{0};
+
+// Generation of the cores the calling thread is pinned to, 0 if it is free
+static thread_local unsigned int t_pinnedGeneration{0};
+
+
+void QPThreadAffinity::setCores(const vector<int>& cores)
+{
+    if(cores == m_cores && (m_generation || !isUsed()))
+        return;
+
+    m_cores = cores;
+    m_generation = (isUsed())? ++s_generation : 0;
+}
+
+
+void QPThreadAffinity::setPriority(const int& priority)
+{
+    m_priorityOwner = std::this_thread::get_id();
+    if(priority == m_priority && (m_generation || !isUsed()))
+        return;
+
+    m_priority = priority;
+    m_generation = (isUsed())? ++s_generation : 0;
+}
+
+
+bool QPThreadAffinity::pinCurrentThread() const
+{
+    if(!m_generation || t_pinnedGeneration == m_generation)
+        return true;
+
+    // Only tried once per thread, a failure is not repeated at each task
+    t_pinnedGeneration = m_generation;
+
+#ifdef __linux__
+    bool success = true;
+    if(!m_cores.empty())
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for(int core : m_cores)
+            if(core >= 0 && core < CPU_SETSIZE)
+                CPU_SET(core, &set);
+        success = CPU_COUNT(&set) != 0 && pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &set) == 0;
+    }
+
+    // On Linux, the nice value is a property of each thread, set with its id
+    if(m_priority && std::this_thread::get_id() != m_priorityOwner)
+        success = setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), m_priority) == 0 && success;
+    return success;
+#else
+    return false;
+#endif
+}
+
+
+bool QPThreadAffinity::isSupported()
+{
+#ifdef __linux__
+    return true;
+#else
+    return false;
+#endif
+}
+
+
+bool QPThreadAffinity::getNodeCores(const int& node, vector<int>& cores)
+{
+    cores.clear();
+#ifdef __linux__
+    if(node < 0)
+        return false;
+
+    std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    std::string list;
+    if(!file.is_open() || !std::getline(file, list))
+        return false;
+    return parseCoreList(list, cores) && !cores.empty();
+#else
+    return false;
+#endif
+}
+
+
+bool QPThreadAffinity::parseCoreList(const std::string& list, vector<int>& cores)
+{
+    cores.clear();
+    std::istringstream stream(list);
+    std::string range;
+    while(std::getline(stream, range, ','))
+    {
+        if(range.find_first_not_of(" \t\n") == std::string::npos)
+            continue;
+
+        int first, last;
+        char dash;
+        std::istringstream rangeStream(range);
+        if(!(rangeStream >> first))
+            return false;
+        last = first;
+        if(rangeStream >> dash && (dash != '-' || !(rangeStream >> last)))
+            return false;
+        if(first < 0 || last < first)
+            return false;
+
+        for(int core=first; core<=last; core++)
+            cores.push_back(core);
+    }
+    return true;
+}
+
+} // namespace
@@ -0,0 +1,85 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include <sofa/type/vector.h>
+
+#include <SoftRobots.Inverse/component/config.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+/// Set of cores the threads running the compliance and contact tasks are pinned to.
+///
+/// On a machine with several sockets, the workers of the task scheduler are free to move from one
+/// socket to the other, and the buffers of the tasks end up read from the remote memory. Pinning the
+/// threads to the cores of one socket keeps the tasks and their buffers (allocated on first touch, by
+/// the thread running the task) on the same NUMA node.
+/// A thread is pinned the first time it runs a task, and stays pinned afterwards, also for the other
+/// tasks it runs. Pinning is only supported on Linux, it does nothing on the other platforms.
+/// A priority (nice value) can also be given to the threads, when they only run the tasks of the solver
+/// (see QPTaskPool). It is applied with the cores, except to the thread which set it (the simulation thread).
+class SOFA_SOFTROBOTS_INVERSE_API QPThreadAffinity
+{
+public:
+    /// An empty set leaves the threads free
+    void setCores(const sofa::type::vector<int>& cores);
+    const sofa::type::vector<int>& getCores() const {return m_cores;}
+    bool isUsed() const {return !m_cores.empty() || m_priority;}
+
+    /// Nice value of the threads running the tasks, 0 to leave their priority unchanged. A negative value
+    /// needs the privilege to raise the priority of a thread.
+    void setPriority(const int& priority);
+    int getPriority() const {return m_priority;}
+
+    /// Pins the calling thread to the cores and sets its priority, once per thread as long as they are
+    /// unchanged. Returns false if the thread could not be pinned or its priority could not be set.
+    bool pinCurrentThread() const;
+
+    static bool isSupported();
+    /// Cores of a NUMA node (a socket), read from the system. Returns false if unknown.
+    static bool getNodeCores(const int& node, sofa::type::vector<int>& cores);
+    /// Parses a list of cores such as "0-7,16-23". Returns false if the list is malformed.
+    static bool parseCoreList(const std::string& list, sofa::type::vector<int>& cores);
+
+protected:
+    sofa::type::vector<int> m_cores;
+    int m_priority{0};
+    std::thread::id m_priorityOwner; // thread which set the priority, left unchanged
+    unsigned int m_generation{0}; // identifies the cores and the priority applied to a thread
+
+    static std::atomic<unsigned int> s_generation;
+};
+
+} // namespace
@@ -0,0 +1,90 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+
+#include <algorithm>
+#include <SoftRobots.Inverse/component/solver/modules/QPTimings.h>
+
+namespace softrobotsinverse::solver::module
+{
+
+void QPTimings::setWindowSize(const unsigned int& windowSize)
+{
+    unsigned int size = std::max(windowSize, 1u);
+    if(size == m_windowSize)
+        return;
+
+    m_windowSize = size;
+    for(auto& phase : m_phases)
+    {
+        phase.second.window.clear();
+        phase.second.next = 0;
+    }
+}
+
+
+void QPTimings::endStep()
+{
+    for(const auto& current : m_current)
+    {
+        PhaseStatistics& phase = m_phases[current.first];
+        const double& time = current.second;
+
+        phase.last = time;
+        phase.average = (phase.initialized)? m_alpha*time + (1.-m_alpha)*phase.average : time;
+        phase.initialized = true;
+
+        if(phase.window.size() < m_windowSize)
+            phase.window.push_back(time);
+        else
+            phase.window[phase.next] = time;
+        phase.next = (phase.next+1) % m_windowSize;
+    }
+    m_current.clear();
+}
+
+
+void QPTimings::clear()
+{
+    m_current.clear();
+    m_phases.clear();
+}
+
+
+void QPTimings::getStatistics(Output& output) const
+{
+    output.clear();
+    for(const auto& phase : m_phases)
+    {
+        const PhaseStatistics& stats = phase.second;
+        double max = (stats.window.empty())? 0. : *std::max_element(stats.window.begin(), stats.window.end());
+        output[phase.first] = {stats.last, stats.average, max};
+    }
+}
+
+} // namespace
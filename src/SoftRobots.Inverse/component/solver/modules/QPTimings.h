@@ -0,0 +1,77 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <map>
+#include <string>
+#include <sofa/type/vector.h>
+
+#include <SoftRobots.Inverse/component/config.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+/// Statistics on the duration of the phases of a resolution, in milliseconds.
+/// For each phase: the last value, an exponentially weighted moving average (EWMA) and the
+/// maximum over a window of the last steps. The durations of a phase measured several times
+/// during a step are summed, the step is closed with endStep().
+class SOFA_SOFTROBOTS_INVERSE_API QPTimings
+{
+public:
+    typedef std::map<std::string, sofa::type::vector<SReal>> Output;
+
+    /// Number of steps over which the maximum is taken
+    void setWindowSize(const unsigned int& windowSize);
+    /// Weight of the last value in the moving average, in ]0,1]
+    void setSmoothingFactor(const double& alpha) {m_alpha = alpha;}
+
+    void add(const std::string& phase, const double& time) {m_current[phase] += time;}
+    void endStep();
+    void clear();
+
+    /// Writes {last, EWMA, max} for each phase
+    void getStatistics(Output& output) const;
+
+protected:
+    struct PhaseStatistics {
+        double last{0.};
+        double average{0.};
+        sofa::type::vector<double> window; // ring buffer of the last values
+        unsigned int next{0};
+        bool initialized{false};
+    };
+
+    std::map<std::string, double> m_current;
+    std::map<std::string, PhaseStatistics> m_phases;
+    unsigned int m_windowSize{100};
+    double m_alpha{0.1};
+};
+
+} // namespace
@@ -0,0 +1,204 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#include <atomic>
+#include <iomanip>
+#include <deque>
+#include <unordered_map>
+#include <SoftRobots.Inverse/component/solver/modules/QPTrace.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+using sofa::helper::system::thread::CTime;
+
+namespace
+{
+
+/// Names of the spans, a deque keeps the references given by getName() valid when it grows
+struct NameRegistry
+{
+    std::mutex mutex;
+    std::deque<std::string> names;
+    std::unordered_map<std::string, QPTrace::NameId> ids;
+};
+
+NameRegistry& getRegistry()
+{
+    static NameRegistry registry;
+    return registry;
+}
+
+/// Small index of the calling thread, used as the "tid" of its events
+unsigned int getThreadIndex()
+{
+    static std::atomic<unsigned int> nbThreads{0};
+    thread_local const unsigned int index = nbThreads++;
+    return index;
+}
+
+}
+
+
+QPTrace::~QPTrace()
+{
+    close();
+}
+
+
+QPTrace::NameId QPTrace::intern(const std::string& name)
+{
+    NameRegistry& registry = getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    auto it = registry.ids.find(name);
+    if(it != registry.ids.end())
+        return it->second;
+
+    const NameId id = registry.names.size();
+    registry.names.push_back(name);
+    registry.ids.emplace(name, id);
+    return id;
+}
+
+
+const std::string& QPTrace::getName(const NameId& id)
+{
+    NameRegistry& registry = getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    return registry.names[id];
+}
+
+
+bool QPTrace::open(const std::string& filename)
+{
+    close();
+
+    m_file.open(filename, std::ios::trunc);
+    if(!m_file.is_open())
+        return false;
+
+    m_events.reserve(s_bufferSize);
+    m_events.clear();
+    m_nbEvents = 0;
+    m_origin = CTime::getTime();
+    m_ticksToMicroseconds = 1e6/(double)CTime::getTicksPerSec();
+
+    m_file << std::fixed << std::setprecision(3);
+    m_file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    m_isOpen = true;
+    return true;
+}
+
+
+void QPTrace::close()
+{
+    if(!m_isOpen)
+        return;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_isOpen = false;
+    flush();
+    m_file << "\n]}\n";
+    m_file.close();
+}
+
+
+void QPTrace::end(const NameId& name, const ctime_t& start, std::initializer_list<Arg> args)
+{
+    if(!m_isOpen)
+        return;
+
+    Event event;
+    event.name = name;
+    event.thread = getThreadIndex();
+    event.start = start;
+    event.end = CTime::getTime();
+    for(const Arg& arg : args)
+        if(event.nbArgs < s_maxNbArgs)
+            event.args[event.nbArgs++] = arg;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(m_events.size() == s_bufferSize)
+        flush();
+    m_events.push_back(event);
+}
+
+
+unsigned int QPTrace::getNbEvents() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_nbEvents + m_events.size();
+}
+
+
+void QPTrace::flush()
+{
+    for(const Event& event : m_events)
+    {
+        m_file << ((m_nbEvents++ == 0)? "\n" : ",\n");
+        m_file << "{\"name\":";
+        writeString(getName(event.name));
+        m_file << ",\"cat\":\"SoftRobots.Inverse\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread
+               << ",\"ts\":" << (double)(event.start - m_origin)*m_ticksToMicroseconds
+               << ",\"dur\":" << (double)(event.end - event.start)*m_ticksToMicroseconds;
+        if(event.nbArgs > 0)
+        {
+            m_file << ",\"args\":{";
+            for(unsigned int i=0; i<event.nbArgs; i++)
+            {
+                if(i > 0)
+                    m_file << ",";
+                writeString(getName(event.args[i].name));
+                m_file << ":" << event.args[i].value;
+            }
+            m_file << "}";
+        }
+        m_file << "}";
+    }
+    m_events.clear();
+    m_file.flush();
+}
+
+
+void QPTrace::writeString(const std::string& value)
+{
+    m_file << '"';
+    for(const char& character : value)
+    {
+        if(character == '"' || character == '\\')
+            m_file << '\\' << character;
+        else if((unsigned char)character < 0x20)
+            m_file << ' ';
+        else
+            m_file << character;
+    }
+    m_file << '"';
+}
+
+} // namespace
@@ -0,0 +1,107 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <fstream>
+#include <initializer_list>
+#include <mutex>
+#include <string>
+#include <sofa/helper/system/thread/CTime.h>
+#include <sofa/type/vector.h>
+
+#include <SoftRobots.Inverse/component/config.h>
+
+
+namespace softrobotsinverse::solver::module
+{
+
+/// Trace of the phases of the resolutions, written as a Chrome trace JSON file (complete "X" events),
+/// which can be opened in Perfetto (ui.perfetto.dev) or chrome://tracing.
+///
+/// The names of the spans are interned once in a global registry, and a span only stores their ids:
+/// while the trace is not open, begin() and end() reduce to a test. The events are buffered and written
+/// when the buffer is full or when the trace is closed. end() can be called from the worker threads.
+class SOFA_SOFTROBOTS_INVERSE_API QPTrace
+{
+public:
+    typedef unsigned int NameId;
+    typedef sofa::helper::system::thread::ctime_t ctime_t;
+
+    /// Annotation of a span, shown in the "args" of the event
+    struct Arg {
+        NameId name;
+        long long value;
+    };
+    static constexpr unsigned int s_maxNbArgs{3};
+    static constexpr unsigned int s_bufferSize{4096};
+
+    QPTrace() {}
+    ~QPTrace();
+
+    /// Id of the name, the same for all the traces. Intended to be called once, at static initialization.
+    static NameId intern(const std::string& name);
+    static const std::string& getName(const NameId& id);
+
+    /// Creates (or truncates) the file. Returns false if the file cannot be opened.
+    bool open(const std::string& filename);
+    /// Writes the buffered events and closes the file
+    void close();
+    bool isOpen() const {return m_isOpen;}
+
+    ctime_t begin() const {return (m_isOpen)? sofa::helper::system::thread::CTime::getTime() : 0;}
+    /// Records the span started at start, with at most s_maxNbArgs annotations
+    void end(const NameId& name, const ctime_t& start, std::initializer_list<Arg> args = {});
+
+    /// Number of events recorded since the trace was opened
+    unsigned int getNbEvents() const;
+
+protected:
+    struct Event {
+        NameId name{0};
+        unsigned int thread{0};
+        ctime_t start{0};
+        ctime_t end{0};
+        unsigned int nbArgs{0};
+        Arg args[s_maxNbArgs];
+    };
+
+    std::ofstream m_file;
+    bool m_isOpen{false};
+    ctime_t m_origin{0};
+    double m_ticksToMicroseconds{1.};
+
+    mutable std::mutex m_mutex;
+    sofa::type::vector<Event> m_events;
+    unsigned int m_nbEvents{0};
+
+    void flush();
+    void writeString(const std::string& value);
+};
+
+} // namespace
@@ -0,0 +1,211 @@
+#!/usr/bin/python3
+# -*- coding: utf-8 -*-
+
+# Brief:
+# Runs each scene of the examples repository (examples/sofapython3/component and examples/xml/component)
+# headless for a number of steps, and writes the duration of each phase of the QPInverseProblemSolver
+# components and the wall time of the steps in a JSON file, to compare the performance across commits.
+#
+# Each scene runs in its own process, with the SofaPython3 bindings (Sofa, Sofa.Simulation importable,
+# e.g. through PYTHONPATH). The phases are read from the trace of the solvers (see the data traceFile),
+# the counters from their data info.
+#
+# Usage:
+#   BenchmarkExamplesScenes.py [-n STEPS] [-o results.json] [--compare previous.json] [pattern]
+
+import argparse
+import importlib.util
+import json
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+examplesPath = os.path.dirname(os.path.abspath(__file__)) + '/../examples/'
+scenesPaths = [examplesPath + 'sofapython3/component', examplesPath + 'xml/component']
+
+
+def findScenes(pattern):
+    scenes = []
+    for scenesPath in scenesPaths:
+        for dirname, _, names in os.walk(scenesPath):
+            for name in sorted(names):
+                filename = os.path.join(dirname, name)
+                if pattern not in filename:
+                    continue
+                if name.endswith('.scn'):
+                    scenes.append(filename)
+                elif name.endswith('.py'):
+                    with open(filename) as file:
+                        if 'def createScene' in file.read():
+                            scenes.append(filename)
+    return sorted(scenes)
+
+
+def getCommit():
+    try:
+        return subprocess.check_output(['git', 'rev-parse', 'HEAD'], cwd=examplesPath,
+                                       stderr=subprocess.DEVNULL).decode().strip()
+    except (OSError, subprocess.CalledProcessError):
+        return ''
+
+
+def getStatistics(values):
+    if not values:
+        return {'count': 0}
+    return {'count': len(values), 'total': sum(values), 'mean': sum(values) / len(values), 'max': max(values)}
+
+
+def readTrace(filename):
+    # The events are only complete once the trace is closed, at the cleanup of the solver
+    with open(filename) as file:
+        text = file.read()
+    try:
+        events = json.loads(text)['traceEvents']
+    except (ValueError, KeyError):
+        events = json.loads(text.rstrip().rstrip(',') + ']}')['traceEvents']
+
+    durations = {}
+    args = {}
+    for event in events:
+        name = event['name']
+        durations.setdefault(name, []).append(event['dur'] / 1000.)  # ms
+        for arg, value in event.get('args', {}).items():
+            args.setdefault(name, {}).setdefault(arg, []).append(value)
+
+    phases = {}
+    for name, values in durations.items():
+        phases[name] = getStatistics(values)
+        for arg, argValues in args.get(name, {}).items():
+            phases[name][arg] = getStatistics(argValues)
+    return phases
+
+
+def getSolvers(node):
+    solvers = [obj for obj in node.objects if obj.getClassName() == 'QPInverseProblemSolver']
+    for child in node.children:
+        solvers += getSolvers(child)
+    return solvers
+
+
+def runScene(filename, nbSteps, output):
+    import Sofa
+    import Sofa.Core
+    import Sofa.Simulation
+
+    sys.path.insert(0, os.path.dirname(filename))
+    startTime = time.perf_counter()
+    if filename.endswith('.scn'):
+        root = Sofa.Simulation.load(filename)
+    else:
+        spec = importlib.util.spec_from_file_location('scene', filename)
+        scene = importlib.util.module_from_spec(spec)
+        spec.loader.exec_module(scene)
+        root = Sofa.Core.Node('root')
+        scene.createScene(root)
+
+    traceDirectory = tempfile.mkdtemp()
+    solvers = getSolvers(root)
+    traces = []
+    for i, solver in enumerate(solvers):
+        traces.append(os.path.join(traceDirectory, 'trace' + str(i) + '.json'))
+        solver.traceFile.value = traces[-1]
+        solver.computeTimings.value = True
+
+    init = getattr(Sofa.Simulation, 'initRoot', None) or Sofa.Simulation.init
+    init(root)
+    loadTime = time.perf_counter() - startTime
+
+    stepTimes = []
+    for _ in range(nbSteps):
+        stepStart = time.perf_counter()
+        Sofa.Simulation.animate(root, root.dt.value)
+        stepTimes.append((time.perf_counter() - stepStart) * 1000.)  # ms
+
+    result = {'loadTime': loadTime, 'steps': getStatistics(stepTimes), 'solvers': {}}
+    for solver in solvers:
+        try:
+            info = {name: list(values) for name, values in solver.info.value.items()}
+        except (AttributeError, TypeError):
+            info = {}
+        result['solvers'][solver.getPathName()] = {'info': info}
+
+    Sofa.Simulation.unload(root)
+    for solver, trace in zip(solvers, traces):
+        if os.path.isfile(trace):
+            result['solvers'][solver.getPathName()]['phases'] = readTrace(trace)
+            os.remove(trace)
+    os.rmdir(traceDirectory)
+
+    with open(output, 'w') as file:
+        json.dump(result, file)
+
+
+def compare(results, previous):
+    print('====================== [COMPARISON] =====================')
+    for scene, result in sorted(results['scenes'].items()):
+        previousResult = previous['scenes'].get(scene)
+        if not previousResult or 'steps' not in result or 'steps' not in previousResult:
+            continue
+        mean, previousMean = result['steps'].get('mean'), previousResult['steps'].get('mean')
+        if mean is None or not previousMean:
+            continue
+        print('{0}: {1:.3f} ms per step ({2:+.1f}%)'.format(os.path.relpath(scene, examplesPath), mean,
+                                                          100. * (mean - previousMean) / previousMean))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Headless benchmark of the scenes of the examples.')
+    parser.add_argument('pattern', nargs='?', default='/', help='only run the scenes whose path contains it')
+    parser.add_argument('-n', '--steps', type=int, default=100, help='number of steps of each scene')
+    parser.add_argument('-o', '--output', default='BenchmarkExamplesScenes.json', help='JSON file of the results')
+    parser.add_argument('--compare', help='JSON file of a previous run, to print the variation of the step time')
+    parser.add_argument('--scene', help=argparse.SUPPRESS)  # runs a single scene, in the child process
+    args = parser.parse_args()
+
+    if args.scene:
+        runScene(args.scene, args.steps, args.output)
+        return
+
+    results = {'commit': getCommit(), 'nbSteps': args.steps, 'scenes': {}}
+    nbFailed = 0
+    outputFile = open('BenchmarkExamplesScenesOutput.txt', 'w')
+    for filename in findScenes(args.pattern):
+        print('[RUNNING] ' + os.path.relpath(filename, examplesPath), end='')
+        sys.stdout.flush()
+        with tempfile.NamedTemporaryFile(suffix='.json', delete=False) as sceneOutput:
+            sceneOutputName = sceneOutput.name
+        retcode = subprocess.call([sys.executable, os.path.abspath(__file__), '--scene', filename,
+                                   '--steps', str(args.steps), '--output', sceneOutputName],
+                                  stdout=outputFile, stderr=outputFile)
+        key = os.path.relpath(filename, examplesPath)
+        if retcode == 0 and os.path.getsize(sceneOutputName) > 0:
+            with open(sceneOutputName) as file:
+                results['scenes'][key] = json.load(file)
+            print(' ({0:.3f} ms per step) [SUCCEED]'.format(results['scenes'][key]['steps'].get('mean', 0.)))
+        else:
+            nbFailed += 1
+            results['scenes'][key] = {'failed': True, 'returnCode': retcode}
+            print(' [FAILED]')
+        os.remove(sceneOutputName)
+    outputFile.close()
+
+    with open(args.output, 'w') as file:
+        json.dump(results, file, indent=2, sort_keys=True)
+
+    print('====================== [SUMMARY] ========================')
+    print('Benchmark: run ' + str(args.steps) + ' steps of each scene of the examples repository.')
+    print('Results written in ' + args.output)
+    print('Succeed scene(s): ' + str(len(results['scenes']) - nbFailed))
+    print('Failed  scene(s): ' + str(nbFailed), file=sys.stderr if nbFailed else sys.stdout)
+
+    if args.compare:
+        with open(args.compare) as file:
+            compare(results, json.load(file))
+
+    sys.exit(1 if nbFailed else 0)
+
+
+if __name__ == '__main__':
+    main()
@@ -19,13 +19,20 @@ struct BarycentricCenterEffectorTest : public BaseTest, BarycentricCenterEffecto
 
     using BarycentricCenterEffector<_DataTypes>::initData;
     using BarycentricCenterEffector<_DataTypes>::getTarget;
+    using BarycentricCenterEffector<_DataTypes>::getTargetLimits;
     using BarycentricCenterEffector<_DataTypes>::d_effectorGoalPosition;
     using BarycentricCenterEffector<_DataTypes>::d_limitShiftToTarget;
     using BarycentricCenterEffector<_DataTypes>::d_maxShiftToTarget;
+    using BarycentricCenterEffector<_DataTypes>::d_indices;
+    using BarycentricCenterEffector<_DataTypes>::d_weights;
+    using BarycentricCenterEffector<_DataTypes>::m_indices;
+    using BarycentricCenterEffector<_DataTypes>::m_weights;
+    using BarycentricCenterEffector<_DataTypes>::computeWeights;
 
     typedef _DataTypes DataTypes;
     typedef typename DataTypes::Coord Coord;
     typedef typename DataTypes::Real Real;
+    typedef typename BarycentricCenterEffector<_DataTypes>::TargetLimits TargetLimits;
 
     void testEffectorGoalDefaultInitialization()
     {
@@ -51,6 +58,46 @@ struct BarycentricCenterEffectorTest : public BaseTest, BarycentricCenterEffecto
         EXPECT_EQ(getTarget(-10., -12.), -10.);
         EXPECT_EQ(getTarget(-10., -13.), -11.);
     }
+
+    void testTargetLimits()
+    {
+        // The limits are read once from the Data, and give the same targets as the Data
+        d_limitShiftToTarget.setValue(true);
+        d_maxShiftToTarget.setValue(2.);
+        TargetLimits limits = getTargetLimits();
+        EXPECT_TRUE(limits.hasShiftLimit);
+        EXPECT_FALSE(limits.hasSpeedLimit);
+        EXPECT_TRUE(limits.isActive());
+        for(const Real& current : {Real(5.), Real(8.), Real(12.), Real(13.)})
+            EXPECT_EQ(getTarget(limits, Real(10.), current), getTarget(Real(10.), current));
+
+        // Without limit, the targets are unchanged
+        limits.hasShiftLimit = false;
+        EXPECT_FALSE(limits.isActive());
+        EXPECT_EQ(getTarget(limits, Real(10.), Real(5.)), Real(10.));
+    }
+
+    void testWeights()
+    {
+        // All the points, uniform weights
+        computeWeights(4);
+        ASSERT_EQ(m_indices.size(), 4u);
+        for(unsigned int k=0; k<4; k++)
+        {
+            EXPECT_EQ(m_indices[k], k);
+            EXPECT_EQ(m_weights[k], Real(0.25));
+        }
+
+        // Subset of the points with normalized weights, zero weights are dropped
+        d_indices.setValue({1, 3, 2});
+        d_weights.setValue({1., 3., 0.});
+        computeWeights(4);
+        ASSERT_EQ(m_indices.size(), 2u);
+        EXPECT_EQ(m_indices[0], 1u);
+        EXPECT_EQ(m_indices[1], 3u);
+        EXPECT_EQ(m_weights[0], Real(0.25));
+        EXPECT_EQ(m_weights[1], Real(0.75));
+    }
 };
 
 using ::testing::Types;
@@ -69,5 +116,13 @@ TYPED_TEST(BarycentricCenterEffectorTest, TargetLimit) {
     ASSERT_NO_THROW( this->testTargetLimit() );
 }
 
+TYPED_TEST(BarycentricCenterEffectorTest, TargetLimits) {
+    ASSERT_NO_THROW( this->testTargetLimits() );
+}
+
+TYPED_TEST(BarycentricCenterEffectorTest, Weights) {
+    ASSERT_NO_THROW( this->testWeights() );
+}
+
 }
 
@@ -0,0 +1,192 @@
+#include <cmath>
+#include <string>
+using std::string ;
+#include <sofa/testing/BaseTest.h>
+using sofa::testing::BaseTest ;
+#include <sofa/helper/BackTrace.h>
+#include <sofa/component/statecontainer/MechanicalObject.h>
+
+using sofa::helper::ReadAccessor ;
+using sofa::helper::WriteAccessor ;
+using sofa::defaulttype::Rigid3Types ;
+
+#include <sofa/simulation/graph/DAGSimulation.h>
+using sofa::simulation::Simulation ;
+#include <sofa/simulation/Node.h>
+using sofa::simulation::Node ;
+using sofa::core::objectmodel::New ;
+using sofa::component::statecontainer::MechanicalObject ;
+
+#include <SoftRobots.Inverse/component/constraint/BeamRestPositionActuator.h>
+using sofa::component::constraintset::BeamRestPositionActuator ;
+
+using sofa::type::vector;
+using std::fabs;
+
+
+namespace softrobotsinverse
+{
+
+template <typename _DataTypes>
+struct BeamRestPositionActuatorTest : public BaseTest, BeamRestPositionActuator<_DataTypes>
+{
+    typedef BeamRestPositionActuator<_DataTypes> ThisClass ;
+    typedef _DataTypes DataTypes;
+    typedef typename DataTypes::Deriv Deriv;
+    typedef typename DataTypes::VecDeriv VecDeriv;
+    typedef typename DataTypes::MatrixDeriv MatrixDeriv;
+    typedef typename DataTypes::Coord Coord;
+    typedef typename DataTypes::VecCoord VecCoord;
+    typedef typename DataTypes::MatrixDeriv::RowConstIterator MatrixDerivRowConstIterator;
+    typedef typename DataTypes::MatrixDeriv::ColConstIterator MatrixDerivColConstIterator;
+    typedef sofa::defaulttype::Vec<3,double> Vec3;
+
+    ////////////////////////////////////////////////////////////////////
+    // Bring parents members in the current lookup context.
+    // more info at: https://gcc.gnu.org/onlinedocs/gcc/Name-lookup.html
+    using BeamRestPositionActuator<_DataTypes>::d_actuationDirection ;
+    using BeamRestPositionActuator<_DataTypes>::d_nbBasisFunctions ;
+    using BeamRestPositionActuator<_DataTypes>::m_beamLengthList ;
+    using BeamRestPositionActuator<_DataTypes>::m_basis ;
+    /////////////////////////////////////////////////////////////////////
+
+    Node::SPtr m_node;
+    typename MechanicalObject<DataTypes>::SPtr m_mecaobject;
+
+
+    // Actuator on five nodes at the identity orientation, with unit beams and three hat functions:
+    // the abscissa of the nodes 1..4 are 1..4, the functions are centered on 1, 2.5 and 4 with a width of 1.5
+    typename ThisClass::SPtr createActuator(const sofa::defaulttype::Vec<3,bool>& direction)
+    {
+        m_node = sofa::simulation::getSimulation()->createNewGraph("root");
+        m_mecaobject = New<MechanicalObject<DataTypes> >() ;
+        m_mecaobject->resize(5);
+        m_node->addObject(m_mecaobject) ;
+        m_mecaobject->init() ;
+
+        typename ThisClass::SPtr thisobject = New<ThisClass >() ;
+        m_node->addObject(thisobject) ;
+        thisobject->d_actuationDirection.setValue(direction);
+        thisobject->d_nbBasisFunctions.setValue(3);
+        thisobject->init() ;
+
+        // The lengths of the rest positions are not used here
+        thisobject->m_beamLengthList.assign(4, 1.);
+        thisobject->initBasis();
+        return thisobject;
+    }
+
+
+    const vector<vector<double>> expectedBasis = {{1., 1./3., 0.,    0.},
+                                                  {0., 2./3., 2./3., 0.},
+                                                  {0., 0.,    1./3., 1.}};
+
+
+    void basisTests()
+    {
+        typename ThisClass::SPtr thisobject = createActuator(sofa::defaulttype::Vec<3,bool>(false,true,true));
+
+        ASSERT_EQ(thisobject->m_basis.size(), 3u);
+        for (unsigned int k=0; k<3; k++)
+        {
+            ASSERT_EQ(thisobject->m_basis[k].size(), 4u);
+            for (unsigned int i=0; i<4; i++)
+                EXPECT_NEAR(thisobject->m_basis[k][i], expectedBasis[k][i], 1e-12) << "function " << k << ", beam " << i;
+        }
+
+        // One row per function and per direction, row k being sum_i phi_k(i) J[i]
+        VecDeriv J(5);
+        for (unsigned int i=1; i<5; i++)
+            J[i] = Deriv(Vec3(1.*i, 2.*i, -1.*i), Vec3(0.5*i, 0., 3.*i));
+
+        MatrixDeriv column;
+        unsigned int columnIndex = 2;
+        thisobject->addJacobianRows(column, columnIndex, J);
+        thisobject->addJacobianRows(column, columnIndex, J);
+        EXPECT_EQ(columnIndex, 2u + 2*3);
+
+        for (unsigned int row=2; row<columnIndex; row++)
+        {
+            const unsigned int k = (row-2)%3;
+            vector<bool> isWritten(5, false);
+            MatrixDerivRowConstIterator rowIt = column.readLine(row);
+            for (MatrixDerivColConstIterator colIt = rowIt.begin(); colIt != rowIt.end(); ++colIt)
+            {
+                const unsigned int i = colIt.index();
+                ASSERT_GE(i, 1u);
+                ASSERT_LT(i, 5u);
+                EXPECT_NE(expectedBasis[k][i-1], 0.) << "row " << row << ", node " << i;
+                EXPECT_NEAR((colIt.val() - J[i]*expectedBasis[k][i-1]).norm(), 0., 1e-12) << "row " << row << ", node " << i;
+                isWritten[i] = true;
+            }
+            for (unsigned int i=1; i<5; i++)
+                EXPECT_EQ(isWritten[i], expectedBasis[k][i-1] != 0.) << "row " << row << ", node " << i;
+        }
+
+        // Without basis, one row per node
+        thisobject->d_nbBasisFunctions.setValue(0);
+        thisobject->initBasis();
+        MatrixDeriv nodeColumn;
+        columnIndex = 0;
+        thisobject->addJacobianRows(nodeColumn, columnIndex, J);
+        EXPECT_EQ(columnIndex, 4u);
+    }
+
+
+    void restRotationTests()
+    {
+        typename ThisClass::SPtr thisobject = createActuator(sofa::defaulttype::Vec<3,bool>(false,true,true));
+
+        // The variables of the direction y come first, then the ones of z
+        vector<double> lambda = {1e-3, -2e-3, 4e-3, 3e-3, 0., -1e-3};
+        for (unsigned int b=0; b<4; b++)
+        {
+            double y = 0., z = 0.;
+            for (unsigned int k=0; k<3; k++)
+            {
+                y += expectedBasis[k][b]*lambda[k];
+                z += expectedBasis[k][b]*lambda[3+k];
+            }
+            EXPECT_NEAR(thisobject->getRestAngle(lambda, 0, b), y, 1e-15) << "beam " << b;
+            EXPECT_NEAR(thisobject->getRestAngle(lambda, 3, b), z, 1e-15) << "beam " << b;
+        }
+
+        // The rest orientation of each node rotates around y by its angle: from the identity, the update of
+        // RigidCoord gives the quaternion (0, a/2, 0, 1), normalized
+        thisobject = createActuator(sofa::defaulttype::Vec<3,bool>(false,true,false));
+        lambda = {1e-3, -2e-3, 4e-3};
+        vector<double> delta(3, 0.);
+        thisobject->storeResults(lambda, delta);
+
+        ReadAccessor<sofa::Data<VecCoord> > restPosition = m_mecaobject->read(sofa::core::ConstVecCoordId::restPosition());
+        for (unsigned int b=0; b<4; b++)
+        {
+            double angle = 0.;
+            for (unsigned int k=0; k<3; k++)
+                angle += expectedBasis[k][b]*lambda[k];
+
+            const auto& orientation = restPosition[b+1].getOrientation();
+            EXPECT_NEAR(orientation[0], 0., 1e-12) << "node " << b+1;
+            EXPECT_NEAR(orientation[1], 0.5*angle/std::sqrt(1.+0.25*angle*angle), 1e-12) << "node " << b+1;
+            EXPECT_NEAR(orientation[2], 0., 1e-12) << "node " << b+1;
+        }
+    }
+
+};
+
+using ::testing::Types;
+typedef Types<Rigid3Types> DataTypes;
+
+TYPED_TEST_SUITE(BeamRestPositionActuatorTest, DataTypes);
+
+
+TYPED_TEST(BeamRestPositionActuatorTest, Basis) {
+    ASSERT_NO_THROW(this->basisTests()) ;
+}
+
+TYPED_TEST(BeamRestPositionActuatorTest, RestRotation) {
+    ASSERT_NO_THROW(this->restRotationTests()) ;
+}
+
+
+}
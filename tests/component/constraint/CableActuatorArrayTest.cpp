@@ -0,0 +1,194 @@
+#include <cmath>
+#include <map>
+#include <string>
+using std::string ;
+#include <sofa/testing/BaseTest.h>
+using sofa::testing::BaseTest ;
+#include <sofa/helper/BackTrace.h>
+#include <sofa/component/statecontainer/MechanicalObject.h>
+
+#include <sofa/linearalgebra/FullVector.h>
+using sofa::linearalgebra::FullVector;
+using sofa::core::objectmodel::Data ;
+
+using sofa::helper::WriteAccessor ;
+using sofa::defaulttype::Vec3Types ;
+
+#include <sofa/simulation/graph/DAGSimulation.h>
+using sofa::simulation::Simulation ;
+#include <sofa/simulation/Node.h>
+using sofa::simulation::Node ;
+using sofa::core::objectmodel::New ;
+using sofa::component::statecontainer::MechanicalObject ;
+
+#include <SoftRobots.Inverse/component/constraint/CableActuatorArray.h>
+using softrobotsinverse::constraint::CableActuatorArray ;
+
+using sofa::type::vector;
+
+
+namespace softrobotsinverse
+{
+
+template <typename _DataTypes>
+struct CableActuatorArrayTest : public BaseTest, CableActuatorArray<_DataTypes>
+{
+    typedef CableActuatorArray<_DataTypes> ThisClass ;
+    typedef _DataTypes DataTypes;
+    typedef typename DataTypes::Deriv Deriv;
+    typedef typename DataTypes::MatrixDeriv MatrixDeriv;
+    typedef typename DataTypes::Coord Coord;
+    typedef typename DataTypes::VecCoord VecCoord;
+
+    typedef typename DataTypes::MatrixDeriv::RowConstIterator MatrixDerivRowConstIterator;
+    typedef typename DataTypes::MatrixDeriv::ColConstIterator MatrixDerivColConstIterator;
+
+    Node::SPtr m_node;
+    typename MechanicalObject<DataTypes>::SPtr m_mecaobject;
+
+
+    // Two cables with a pull point: a straight one along x (points 0 1 2), and a bent one (points 3 4)
+    typename ThisClass::SPtr createCables()
+    {
+        m_node = sofa::simulation::getSimulation()->createNewGraph("root");
+        m_mecaobject = New<MechanicalObject<DataTypes> >() ;
+        typename ThisClass::SPtr thisobject = New<ThisClass >() ;
+
+        m_node->addObject(m_mecaobject) ;
+        m_mecaobject->findData("position")->read("0. 0. 0.   1. 0. 0.   2. 0. 0.   0. 1. 0.   1. 2. 0.");
+        m_mecaobject->init();
+        m_node->addObject(thisobject) ;
+        thisobject->findData("indices")->read("0 1 2 3 4");
+        thisobject->findData("nbPoints")->read("3 2");
+        thisobject->findData("pullPoints")->read("-1. 0. 0.   -1. 1. 0.");
+        return thisobject;
+    }
+
+
+    void normalTests(){
+        typename ThisClass::SPtr thisobject = createCables();
+
+        thisobject->setName("myname") ;
+        EXPECT_TRUE(thisobject->getName() == "myname") ;
+
+        EXPECT_TRUE( thisobject->findData("indices") != nullptr ) ;
+        EXPECT_TRUE( thisobject->findData("nbPoints") != nullptr ) ;
+        EXPECT_TRUE( thisobject->findData("pullPoints") != nullptr ) ;
+        EXPECT_TRUE( thisobject->findData("maxPositiveDisp") != nullptr ) ;
+        EXPECT_TRUE( thisobject->findData("maxNegativeDisp") != nullptr ) ;
+        EXPECT_TRUE( thisobject->findData("maxDispVariation") != nullptr ) ;
+        EXPECT_TRUE( thisobject->findData("maxForce") != nullptr ) ;
+        EXPECT_TRUE( thisobject->findData("minForce") != nullptr ) ;
+        EXPECT_TRUE( thisobject->findData("constrainAtTime") != nullptr ) ;
+        EXPECT_TRUE( thisobject->findData("force") != nullptr ) ;
+        EXPECT_TRUE( thisobject->findData("displacement") != nullptr ) ;
+        EXPECT_TRUE( thisobject->findData("cableLength") != nullptr ) ;
+
+        EXPECT_NO_THROW( thisobject->init() ) ;
+        EXPECT_NO_THROW( thisobject->bwdInit() ) ;
+        EXPECT_NO_THROW( thisobject->reinit() ) ;
+        EXPECT_NO_THROW( thisobject->reset() ) ;
+
+        EXPECT_EQ(thisobject->getNbCables(), 2u);
+        EXPECT_NEAR(thisobject->getCableLength(m_mecaobject->readPositions().ref(), 0), 3., 1e-12);
+        EXPECT_NEAR(thisobject->getCableLength(m_mecaobject->readPositions().ref(), 1), 1.+sqrt(2.), 1e-12);
+    }
+
+
+    void limitsTests(){
+        typename ThisClass::SPtr thisobject = createCables();
+
+        // One value for all the cables, or one per cable
+        thisobject->findData("maxForce")->read("10");
+        thisobject->findData("minForce")->read("0");
+        thisobject->findData("maxPositiveDisp")->read("5 6");
+        thisobject->findData("maxDispVariation")->read("1");
+        thisobject->init();
+
+        EXPECT_TRUE(thisobject->hasLambdaMax());
+        EXPECT_TRUE(thisobject->hasLambdaMin());
+        EXPECT_TRUE(thisobject->hasDeltaMax());
+        EXPECT_TRUE(thisobject->hasDeltaMin());
+        for(unsigned int i=0; i<2; i++)
+        {
+            EXPECT_EQ(thisobject->getLambdaMax(i), 10.);
+            EXPECT_EQ(thisobject->getLambdaMin(i), 0.);
+            EXPECT_EQ(thisobject->getDeltaMax(i), 1.);
+            EXPECT_EQ(thisobject->getDeltaMin(i), -1.);
+        }
+
+        vector<double> lambda{2., 3.};
+        vector<double> delta{0.5, 0.2};
+        thisobject->storeResults(lambda, delta);
+
+        EXPECT_EQ(thisobject->findData("force")->getValueString(), "2 3");
+        EXPECT_DOUBLE_EQ(thisobject->getDeltaMax(0), 1.5);
+        EXPECT_DOUBLE_EQ(thisobject->getDeltaMin(0), -0.5);
+        EXPECT_DOUBLE_EQ(thisobject->getDeltaMax(1), 1.2);
+        EXPECT_DOUBLE_EQ(thisobject->getDeltaMin(1), -0.8);
+    }
+
+
+    void buildMatrixTests(){
+        typename ThisClass::SPtr thisobject = createCables();
+        thisobject->init();
+
+        sofa::core::ConstraintParams* cparams = nullptr;
+        Data<MatrixDeriv> columns;
+        unsigned int columnsIndex = 0;
+        thisobject->buildConstraintMatrix(cparams, columns, columnsIndex, *m_mecaobject->read(sofa::core::ConstVecCoordId::position()));
+
+        // One row per cable, the opposite of the gradient of its length
+        EXPECT_EQ(columnsIndex, 2u);
+        const double s = 1./sqrt(2.);
+        const vector<std::map<unsigned int, Deriv>> expected{
+            {{0, Deriv(0,0,0)}, {1, Deriv(0,0,0)}, {2, Deriv(-1,0,0)}},
+            {{3, Deriv(-1+s,s,0)}, {4, Deriv(-s,-s,0)}}};
+
+        const MatrixDeriv& matrix = columns.getValue();
+        for(unsigned int row=0; row<2; row++)
+        {
+            MatrixDerivRowConstIterator rowIt = matrix.readLine(row);
+            unsigned int nbCols = 0;
+            for (MatrixDerivColConstIterator colIt = rowIt.begin(); colIt != rowIt.end(); ++colIt, nbCols++)
+            {
+                ASSERT_TRUE(expected[row].find(colIt.index()) != expected[row].end());
+                const Deriv& value = expected[row].at(colIt.index());
+                for(unsigned int k=0; k<3; k++)
+                    EXPECT_NEAR(colIt.val()[k], value[k], 1e-12) << row << " " << colIt.index();
+            }
+            EXPECT_EQ(nbCols, expected[row].size());
+        }
+
+        // Pulling the end of the first cable shortens the second one
+        {
+            WriteAccessor<Data<VecCoord>> positions = *m_mecaobject->write(sofa::core::VecCoordId::position());
+            positions[2] = Coord(3.,0.,0.);
+            positions[4] = Coord(0.,2.,0.);
+        }
+        FullVector<double> violation(2), jdx;
+        thisobject->getConstraintViolation(cparams, &violation, &jdx);
+        EXPECT_NEAR(violation[0], -1., 1e-12);
+        EXPECT_NEAR(violation[1], sqrt(2.)-1., 1e-12);
+    }
+
+};
+
+using ::testing::Types;
+typedef Types<Vec3Types> DataTypes;
+
+TYPED_TEST_SUITE(CableActuatorArrayTest, DataTypes);
+
+TYPED_TEST(CableActuatorArrayTest, NormalBehavior) {
+    ASSERT_NO_THROW(this->normalTests()) ;
+}
+
+TYPED_TEST(CableActuatorArrayTest, LimitsTests) {
+    ASSERT_NO_THROW(this->limitsTests()) ;
+}
+
+TYPED_TEST(CableActuatorArrayTest, BuildMatrixTests) {
+    ASSERT_NO_THROW(this->buildMatrixTests()) ;
+}
+
+}
@@ -29,6 +29,9 @@ using sofa::component::statecontainer::MechanicalObject ;
 #include <SoftRobots.Inverse/component/constraint/CableActuator.h>
 using softrobotsinverse::constraint::CableActuator ;
 
+#include <SoftRobots.Inverse/component/constraint/CableGeometries.h>
+using softrobotsinverse::constraint::CableGeometries ;
+
 using sofa::core::objectmodel::ComponentState;
 
 namespace softrobotsinverse
@@ -141,6 +144,55 @@ struct CableActuatorTest : public BaseTest,
         return ;
     }
 
+    // Geometry of a cable shared by the components of the same cable, updated once per change of the positions
+    void sharedGeometryTests(){
+        sofa::Data<VecCoord> positions;
+        VecCoord& x = *positions.beginEdit();
+        x.push_back(Coord(0.,0.,0.)); x.push_back(Coord(0.,1.,0.)); x.push_back(Coord(1.,1.,0.));
+        positions.endEdit();
+
+        typedef CableGeometries<DataTypes> Geometries;
+        const sofa::type::vector<unsigned int> indices = {0, 1, 2};
+        const Coord pullPoint(0.,-2.,0.);
+        int state, otherState;
+        auto cable = Geometries::getCable(&state, indices, true, pullPoint);
+        auto sameCable = Geometries::getCable(&state, indices, true, pullPoint);
+        auto freeCable = Geometries::getCable(&state, indices, false, pullPoint);
+        auto otherCable = Geometries::getCable(&otherState, indices, true, pullPoint);
+        EXPECT_EQ(cable, sameCable);
+        EXPECT_NE(cable, freeCable);
+        EXPECT_NE(cable, otherCable);
+
+        // The first query updates the cables of the same state only
+        EXPECT_NEAR(Geometries::getLength(*cable, positions), 4., 1e-12);
+        EXPECT_NEAR(freeCable->getLength(), 2., 1e-12);
+        EXPECT_EQ(otherCable->getNbUpdates(), 0u);
+
+        MatrixDeriv matrix;
+        Geometries::writeRow(*sameCable, positions, matrix, 0);
+        EXPECT_EQ(cable->getNbUpdates(), 1u);
+        const sofa::type::vector<Deriv>& directions = cable->getDirections();
+        ASSERT_EQ(directions.size(), 3u);
+        EXPECT_NEAR((directions[0] - Deriv(0.,0.,0.)).norm(), 0., 1e-12);
+        EXPECT_NEAR((directions[1] - Deriv(1.,-1.,0.)).norm(), 0., 1e-12);
+        EXPECT_NEAR((directions[2] - Deriv(-1.,0.,0.)).norm(), 0., 1e-12);
+        EXPECT_NEAR((freeCable->getDirections()[0] - Deriv(0.,1.,0.)).norm(), 0., 1e-12);
+
+        // A move of the pull point gives another cable, a move of the points updates the geometry
+        std::shared_ptr<typename Geometries::Cable> heldCable = cable;
+        Geometries::updateCable(heldCable, &state, indices, true, pullPoint);
+        EXPECT_EQ(heldCable, cable);
+        Geometries::updateCable(heldCable, &state, indices, true, Coord(0.,-1.,0.));
+        EXPECT_NE(heldCable, cable);
+        EXPECT_NEAR(Geometries::getLength(*heldCable, positions), 3., 1e-12);
+
+        positions.beginEdit()->at(2) = Coord(0.,3.,0.);
+        positions.endEdit();
+        EXPECT_NEAR(Geometries::getLength(*cable, positions), 5., 1e-12);
+        EXPECT_EQ(cable->getNbUpdates(), 2u);
+        EXPECT_NEAR(heldCable->getLength(), 4., 1e-12);
+    }
+
 };
 
 using ::testing::Types;
@@ -157,5 +209,10 @@ TYPED_TEST(CableActuatorTest, NormalBehavior) {
     ASSERT_NO_THROW(this->normalTests()) ;
 }
 
+TYPED_TEST(CableActuatorTest, SharedGeometry) {
+    ASSERT_NO_THROW(this->sharedGeometryTests()) ;
+}
+
 
 }
+
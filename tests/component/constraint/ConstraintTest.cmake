@@ -2,9 +2,20 @@
 list(APPEND SOURCE_FILES
     component/constraint/BarycentricCenterEffectorTest.cpp
     component/constraint/CableActuatorTest.cpp
+    component/constraint/CableActuatorArrayTest.cpp
     component/constraint/ForcePointActuatorTest.cpp
+    component/constraint/ForceSurfaceActuatorTest.cpp
+    component/constraint/JointActuatorArrayTest.cpp
     component/constraint/PositionEffectorTest.cpp
     component/constraint/SlidingActuatorTest.cpp
+    component/constraint/SlidingActuatorArrayTest.cpp
     component/constraint/SurfacePressureActuatorTest.cpp
+    component/constraint/SurfacePressureActuatorArrayTest.cpp
     component/constraint/YoungModulusActuatorTest.cpp
 )
+
+if(SOFA-DEVPLUGIN_BEAMADAPTER)
+    list(APPEND SOURCE_FILES
+        component/constraint/BeamRestPositionActuatorTest.cpp
+    )
+endif()
@@ -214,6 +214,45 @@ struct ForcePointActuatorTest : public BaseTest, ForcePointActuator<_DataTypes>
         return true;
     }
 
+
+    void constantRowsTests(){
+        auto simu = sofa::simulation::getSimulation();
+
+        Node::SPtr node = simu->createNewGraph("root");
+        typename MechanicalObject<DataTypes>::SPtr mecaobject = New<MechanicalObject<DataTypes> >() ;
+        typename ThisClass::SPtr thisobject = New<ThisClass >() ;
+
+        node->addObject(mecaobject) ;
+        mecaobject->findData("position")->read("0. 0. 0.   0. 0. 0.   0. 0. 0.   0. 0. 0.");
+        mecaobject->init();
+        node->addObject(thisobject) ;
+        thisobject->findData("direction")->read("1. 0. 0.");
+        thisobject->findData("indices")->read("0 2");
+        thisobject->init();
+
+        sofa::core::ConstraintParams* cparams = NULL;
+        sofa::core::objectmodel::Data<MatrixDeriv> columns;
+        unsigned int columnsIndex = 0;
+        sofa::core::objectmodel::Data<VecCoord> x;
+
+        EXPECT_FALSE(thisobject->hasConstantRows()); // not built yet
+        thisobject->buildConstraintMatrix(cparams, columns, columnsIndex, x);
+        EXPECT_TRUE(thisobject->hasConstantRows());
+
+        // The positions do not change the rows
+        mecaobject->findData("position")->read("1. 0. 0.   0. 1. 0.   0. 0. 1.   1. 1. 1.");
+        EXPECT_TRUE(thisobject->hasConstantRows());
+
+        thisobject->findData("direction")->read("0. 1. 0.");
+        EXPECT_FALSE(thisobject->hasConstantRows());
+        columnsIndex = 0;
+        thisobject->buildConstraintMatrix(cparams, columns, columnsIndex, x);
+        EXPECT_TRUE(thisobject->hasConstantRows());
+
+        thisobject->findData("indices")->read("1");
+        EXPECT_FALSE(thisobject->hasConstantRows());
+    }
+
 };
 
 using ::testing::Types;
@@ -233,5 +272,9 @@ TYPED_TEST(ForcePointActuatorTest, BuildMatrixTests) {
     EXPECT_TRUE(this->buildMatrixTests()) ;
 }
 
+TYPED_TEST(ForcePointActuatorTest, ConstantRowsTests) {
+    ASSERT_NO_THROW(this->constantRowsTests()) ;
+}
+
 
 }
@@ -0,0 +1,362 @@
+#include <sofa/testing/BaseTest.h>
+using sofa::testing::BaseTest ;
+#include <sofa/helper/BackTrace.h>
+#include <sofa/component/statecontainer/MechanicalObject.h>
+
+using sofa::core::topology::BaseMeshTopology ;
+using sofa::core::objectmodel::Data ;
+
+using sofa::helper::WriteAccessor ;
+using sofa::defaulttype::Vec3Types ;
+using sofa::core::objectmodel::New ;
+using sofa::component::statecontainer::MechanicalObject ;
+
+#include <SoftRobots.Inverse/component/constraint/ForceSurfaceActuator.h>
+using softrobotsinverse::constraint::ForceSurfaceActuator ;
+
+using sofa::type::vector;
+
+
+namespace softrobotsinverse
+{
+
+template <typename _DataTypes>
+struct ForceSurfaceActuatorTest : public BaseTest, ForceSurfaceActuator<_DataTypes>
+{
+    typedef _DataTypes DataTypes;
+    typedef typename DataTypes::Coord Coord;
+    typedef typename DataTypes::VecCoord VecCoord;
+    typedef typename DataTypes::Deriv Deriv;
+    typedef typename DataTypes::VecDeriv VecDeriv;
+    typedef typename DataTypes::Real Real;
+
+    typedef BaseMeshTopology::Quad Quad;
+
+    ////////////////////////////////////////////////////////////////////
+    // Bring parents members in the current lookup context.
+    // more info at: https://gcc.gnu.org/onlinedocs/gcc/Name-lookup.html
+    using ForceSurfaceActuator<_DataTypes>::d_positions ;
+    using ForceSurfaceActuator<_DataTypes>::d_centers ;
+    using ForceSurfaceActuator<_DataTypes>::d_radii ;
+    using ForceSurfaceActuator<_DataTypes>::d_quads ;
+    using ForceSurfaceActuator<_DataTypes>::m_pointsInSphereId ;
+    using ForceSurfaceActuator<_DataTypes>::m_quadsInSpheresId ;
+    using ForceSurfaceActuator<_DataTypes>::m_ratios ;
+    using ForceSurfaceActuator<_DataTypes>::d_directions ;
+    using ForceSurfaceActuator<_DataTypes>::d_normalsTolerance ;
+    using ForceSurfaceActuator<_DataTypes>::m_nbUpdatedNormals ;
+    using ForceSurfaceActuator<_DataTypes>::m_state ;
+    using ForceSurfaceActuator<_DataTypes>::d_force ;
+    using ForceSurfaceActuator<_DataTypes>::d_visuScale ;
+    using ForceSurfaceActuator<_DataTypes>::m_forcesBuffer ;
+    /////////////////////////////////////////////////////////////////////
+
+
+    // Grid of n x n points in the plane z=0, and its (n-1) x (n-1) quads
+    void createGrid(const unsigned int n, VecCoord& positions, vector<Quad>& quads)
+    {
+        positions.clear();
+        quads.clear();
+        for(unsigned int i=0; i<n; i++)
+            for(unsigned int j=0; j<n; j++)
+            {
+                positions.push_back(Coord(i, j, 0.));
+                if(i<n-1 && j<n-1)
+                    quads.push_back(Quad(i*n+j, (i+1)*n+j, (i+1)*n+j+1, i*n+j+1));
+            }
+    }
+
+
+    // Compares the points and quads found in the spheres with a test of all of them
+    void checkSpheres()
+    {
+        const VecCoord& positions = d_positions.getValue();
+        const VecCoord& centers = d_centers.getValue();
+        const vector<Real>& radii = d_radii.getValue();
+        const vector<Quad>& quads = d_quads.getValue();
+
+        ASSERT_EQ(m_pointsInSphereId.size(), centers.size());
+        for(unsigned int i=0; i<centers.size(); i++)
+        {
+            vector<unsigned int> points;
+            for(unsigned int p=0; p<positions.size(); p++)
+                if((positions[p]-centers[i]).norm() < radii[i])
+                    points.push_back(p);
+            EXPECT_EQ(m_pointsInSphereId[i], points);
+
+            vector<unsigned int> quadsInSphere;
+            for(unsigned int q=0; q<quads.size(); q++)
+                for(unsigned int j=0; j<4; j++)
+                    if((positions[quads[q][j]]-centers[i]).norm() < radii[i])
+                    {
+                        quadsInSphere.push_back(q);
+                        break;
+                    }
+            EXPECT_EQ(m_quadsInSpheresId[i], quadsInSphere);
+        }
+    }
+
+
+    void spheresTests(){
+        VecCoord positions;
+        vector<Quad> quads;
+        createGrid(10, positions, quads);
+
+        d_positions.setValue(positions);
+        d_quads.setValue(quads);
+        this->findData("centers")->read("2.5 2.5 0.   7. 7. 0.   -5. -5. 0.");
+        this->findData("radii")->read("1.4 2.5 1.");
+        this->computeEdges();
+        this->computeSurfaces();
+
+        checkSpheres();
+        EXPECT_EQ(m_pointsInSphereId[0].size(), 4u);
+        EXPECT_TRUE(m_pointsInSphereId[2].empty());
+
+        // Move some points in other cells of the grid
+        {
+            WriteAccessor<Data<VecCoord>> x = d_positions;
+            x[0] = Coord(2., 2., 0.);
+            x[55] = Coord(-5.5, -5., 0.);
+            x[99] = Coord(3., 3., 0.2);
+        }
+        this->computeSurfaces();
+        checkSpheres();
+
+        // Larger spheres, the grid is rebuilt with larger cells
+        this->findData("radii")->read("3. 3. 3.");
+        this->computeSurfaces();
+        checkSpheres();
+    }
+
+
+    void membershipCacheTests(){
+        VecCoord positions;
+        vector<Quad> quads;
+        createGrid(10, positions, quads);
+
+        d_positions.setValue(positions);
+        d_quads.setValue(quads);
+        this->findData("centers")->read("2.5 2.5 0.   7. 7. 0.");
+        this->findData("radii")->read("1.4 2.5");
+        this->computeEdges();
+        this->computeSurfaces();
+
+        const std::string filename = "ForceSurfaceActuatorTest_membership.bin";
+        const uint64_t key = this->getMembershipKey();
+        ASSERT_TRUE(this->writeMembership(filename, key));
+        const vector<vector<Real>> ratios = m_ratios;
+
+        m_pointsInSphereId.clear();
+        m_quadsInSpheresId.clear();
+        m_ratios.clear();
+        ASSERT_TRUE(this->readMembership(filename, key));
+        checkSpheres();
+        EXPECT_EQ(m_ratios, ratios);
+
+        // The file of other spheres is ignored
+        this->findData("radii")->read("1.4 3.");
+        EXPECT_NE(this->getMembershipKey(), key);
+        EXPECT_FALSE(this->readMembership(filename, this->getMembershipKey()));
+
+        std::remove(filename.c_str());
+    }
+
+
+    // Compares the cached normals with the normals recomputed from all the primitives
+    void checkNormals()
+    {
+        VecDeriv cachedDirections = d_directions.getValue();
+        Real tolerance = d_normalsTolerance.getValue();
+        d_normalsTolerance.setValue(0.);
+        this->computeNormals();
+        d_normalsTolerance.setValue(tolerance);
+
+        const VecDeriv& directions = d_directions.getValue();
+        ASSERT_EQ(cachedDirections.size(), directions.size());
+        for(unsigned int i=0; i<directions.size(); i++)
+            EXPECT_NEAR((cachedDirections[i]-directions[i]).norm(), 0., 1e-12);
+    }
+
+
+    // Rows built concurrently in the staging buffers, against the same rows written directly
+    void constraintRowsBuilderTests(){
+        typedef typename DataTypes::MatrixDeriv MatrixDeriv;
+        sofa::simulation::MainTaskSchedulerFactory::createInRegistry()->init();
+
+        const unsigned int nbRows = 50, firstRowId = 3;
+        auto addColumns = [](const unsigned int i, auto& row)
+        {
+            for(unsigned int j=0; j<i%5; j++)
+                row.addCol(2*i+j, Deriv(i, j, 1.));
+        };
+
+        MatrixDeriv expected;
+        for(unsigned int i=0; i<nbRows; i++)
+        {
+            auto rowIterator = expected.writeLine(firstRowId+i);
+            addColumns(i, rowIterator);
+        }
+
+        softrobotsinverse::behavior::ConstraintRowsBuilder<DataTypes> builder;
+        for(bool multithreading : {false, true, true})
+        {
+            MatrixDeriv matrix;
+            builder.build(matrix, firstRowId, nbRows, multithreading,
+                          [&addColumns](const unsigned int i, auto& chunk){ addColumns(i, chunk); });
+
+            auto expectedRow = expected.begin();
+            for(auto row = matrix.begin(); row != matrix.end(); ++row, ++expectedRow)
+            {
+                ASSERT_TRUE(expectedRow != expected.end());
+                EXPECT_EQ(row.index(), expectedRow.index());
+                auto expectedCol = expectedRow.begin();
+                for(auto col = row.begin(); col != row.end(); ++col, ++expectedCol)
+                {
+                    ASSERT_TRUE(expectedCol != expectedRow.end());
+                    EXPECT_EQ(col.index(), expectedCol.index());
+                    EXPECT_EQ(col.val(), expectedCol.val());
+                }
+                EXPECT_TRUE(expectedCol == expectedRow.end());
+            }
+            EXPECT_TRUE(expectedRow == expected.end());
+        }
+    }
+
+
+    void cachedNormalsTests(){
+        VecCoord positions;
+        vector<Quad> quads;
+        createGrid(10, positions, quads);
+        positions[22][2] = 0.5;
+        positions[23][2] = 0.3;
+        positions[77][2] = -0.4;
+
+        typename MechanicalObject<DataTypes>::SPtr mecaobject = New<MechanicalObject<DataTypes> >() ;
+        mecaobject->resize(positions.size());
+        mecaobject->x.setValue(positions);
+        m_state = mecaobject.get();
+
+        d_positions.setValue(positions);
+        d_quads.setValue(quads);
+        this->findData("centers")->read("2.5 2.5 0.   7. 7. 0.   3. 3. 0.");
+        this->findData("radii")->read("1.4 2.5 1.");
+        d_normalsTolerance.setValue(0.01);
+        this->computeEdges();
+        this->computeSurfaces();
+
+        // First computation of all the normals of the spheres, shared ones only once
+        this->computeNormals();
+        EXPECT_EQ(m_nbUpdatedNormals, 9u + 24u);
+        checkNormals();
+
+        // Displacement below the tolerance, nothing is recomputed
+        {
+            WriteAccessor<Data<VecCoord>> x = mecaobject->x;
+            x[11][2] += 0.005;
+        }
+        this->computeNormals();
+        EXPECT_EQ(m_nbUpdatedNormals, 0u);
+
+        // Displacement above the tolerance, only the normal of the quad of point 11 in a sphere is recomputed
+        {
+            WriteAccessor<Data<VecCoord>> x = mecaobject->x;
+            x[11][2] += 0.1;
+        }
+        this->computeNormals();
+        EXPECT_EQ(m_nbUpdatedNormals, 1u);
+        checkNormals();
+
+        m_state = nullptr;
+    }
+
+
+    void forcesBufferTests(){
+        VecCoord positions;
+        vector<Quad> quads;
+        createGrid(10, positions, quads);
+
+        typename MechanicalObject<DataTypes>::SPtr mecaobject = New<MechanicalObject<DataTypes> >() ;
+        mecaobject->resize(positions.size());
+        mecaobject->x.setValue(positions);
+        m_state = mecaobject.get();
+
+        d_positions.setValue(positions);
+        d_quads.setValue(quads);
+        this->findData("centers")->read("2.5 2.5 0.   7. 7. 0.");
+        this->findData("radii")->read("1.4 2.5");
+        this->computeEdges();
+        this->computeSurfaces();
+        this->computeNormals();
+        d_force.setValue(vector<Real>{1., 2.});
+
+        // Three segments per arrow: the shaft, from the force to the point, and the two sides of the head
+        this->updateForcesBuffer();
+        EXPECT_EQ(m_forcesBuffer.getNbUpdates(), 1u);
+        unsigned int nbArrows = 0;
+        for(unsigned int i=0; i<m_pointsInSphereId.size(); i++)
+            nbArrows += m_pointsInSphereId[i].size();
+        ASSERT_EQ(m_forcesBuffer.points.size(), 6*nbArrows);
+
+        const Coord& position = positions[m_pointsInSphereId[0][0]];
+        const Deriv& direction = d_directions.getValue()[0];
+        EXPECT_NEAR((m_forcesBuffer.points[0] - (position - direction*m_ratios[0][0])).norm(), 0., 1e-12);
+        EXPECT_NEAR((m_forcesBuffer.points[1] - position).norm(), 0., 1e-12);
+        EXPECT_NEAR((m_forcesBuffer.points[2] - position).norm(), 0., 1e-12);
+        EXPECT_NEAR((m_forcesBuffer.points[4] - position).norm(), 0., 1e-12);
+
+        // Same counters, the buffer is kept
+        this->updateForcesBuffer();
+        this->updateForcesBuffer();
+        EXPECT_EQ(m_forcesBuffer.getNbUpdates(), 1u);
+
+        // It is rebuilt once for each change of the forces, of the positions and of the scale
+        d_force.setValue(vector<Real>{1., 3.});
+        this->updateForcesBuffer();
+        this->updateForcesBuffer();
+        EXPECT_EQ(m_forcesBuffer.getNbUpdates(), 2u);
+
+        {
+            WriteAccessor<Data<VecCoord>> x = mecaobject->x;
+            x[11][2] += 0.1;
+        }
+        this->updateForcesBuffer();
+        EXPECT_EQ(m_forcesBuffer.getNbUpdates(), 3u);
+
+        d_visuScale.setValue(0.2);
+        this->updateForcesBuffer();
+        EXPECT_EQ(m_forcesBuffer.getNbUpdates(), 4u);
+        EXPECT_EQ(m_forcesBuffer.points.size(), 6*nbArrows);
+
+        m_state = nullptr;
+    }
+
+};
+
+using ::testing::Types;
+typedef Types<Vec3Types> DataTypes;
+
+TYPED_TEST_SUITE(ForceSurfaceActuatorTest, DataTypes);
+
+TYPED_TEST(ForceSurfaceActuatorTest, SpheresTests) {
+    ASSERT_NO_THROW(this->spheresTests()) ;
+}
+
+TYPED_TEST(ForceSurfaceActuatorTest, MembershipCacheTests) {
+    ASSERT_NO_THROW(this->membershipCacheTests()) ;
+}
+
+TYPED_TEST(ForceSurfaceActuatorTest, CachedNormalsTests) {
+    ASSERT_NO_THROW(this->cachedNormalsTests()) ;
+}
+
+TYPED_TEST(ForceSurfaceActuatorTest, ConstraintRowsBuilderTests) {
+    ASSERT_NO_THROW(this->constraintRowsBuilderTests()) ;
+}
+
+TYPED_TEST(ForceSurfaceActuatorTest, ForcesBufferTests) {
+    ASSERT_NO_THROW(this->forcesBufferTests()) ;
+}
+
+
+}
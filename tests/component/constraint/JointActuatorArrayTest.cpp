@@ -0,0 +1,185 @@
+#include <string>
+using std::string ;
+#include <sofa/testing/BaseTest.h>
+using sofa::testing::BaseTest ;
+#include <sofa/helper/BackTrace.h>
+#include <sofa/component/statecontainer/MechanicalObject.h>
+
+#include <sofa/linearalgebra/FullVector.h>
+using sofa::linearalgebra::FullVector;
+using sofa::core::objectmodel::Data ;
+
+using sofa::defaulttype::Vec1Types ;
+
+#include <sofa/simulation/graph/DAGSimulation.h>
+using sofa::simulation::Simulation ;
+#include <sofa/simulation/Node.h>
+using sofa::simulation::Node ;
+using sofa::core::objectmodel::New ;
+using sofa::component::statecontainer::MechanicalObject ;
+
+#include <SoftRobots.Inverse/component/constraint/JointActuatorArray.h>
+using softrobotsinverse::constraint::JointActuatorArray ;
+
+using sofa::type::vector;
+
+
+namespace softrobotsinverse
+{
+
+template <typename _DataTypes>
+struct JointActuatorArrayTest : public BaseTest, JointActuatorArray<_DataTypes>
+{
+    typedef JointActuatorArray<_DataTypes> ThisClass ;
+    typedef _DataTypes DataTypes;
+    typedef typename DataTypes::Deriv Deriv;
+    typedef typename DataTypes::MatrixDeriv MatrixDeriv;
+
+    typedef typename DataTypes::MatrixDeriv::RowConstIterator MatrixDerivRowConstIterator;
+    typedef typename DataTypes::MatrixDeriv::ColConstIterator MatrixDerivColConstIterator;
+
+    Node::SPtr m_node;
+    typename MechanicalObject<DataTypes>::SPtr m_mecaobject;
+
+
+    // Three joints of an arm, actuated in the order 2 0 1
+    typename ThisClass::SPtr createJoints()
+    {
+        m_node = sofa::simulation::getSimulation()->createNewGraph("root");
+        m_mecaobject = New<MechanicalObject<DataTypes> >() ;
+        typename ThisClass::SPtr thisobject = New<ThisClass >() ;
+
+        m_node->addObject(m_mecaobject) ;
+        m_mecaobject->findData("position")->read("0.1 0.2 0.3");
+        m_mecaobject->init();
+        m_node->addObject(thisobject) ;
+        thisobject->findData("indices")->read("2 0 1");
+        return thisobject;
+    }
+
+
+    void normalTests(){
+        typename ThisClass::SPtr thisobject = createJoints();
+
+        thisobject->setName("myname") ;
+        EXPECT_TRUE(thisobject->getName() == "myname") ;
+
+        EXPECT_TRUE( thisobject->findData("indices") != nullptr ) ;
+        EXPECT_TRUE( thisobject->findData("initEffort") != nullptr ) ;
+        EXPECT_TRUE( thisobject->findData("initAngle") != nullptr ) ;
+        EXPECT_TRUE( thisobject->findData("maxEffort") != nullptr ) ;
+        EXPECT_TRUE( thisobject->findData("minEffort") != nullptr ) ;
+        EXPECT_TRUE( thisobject->findData("maxEffortVariation") != nullptr ) ;
+        EXPECT_TRUE( thisobject->findData("maxAngle") != nullptr ) ;
+        EXPECT_TRUE( thisobject->findData("minAngle") != nullptr ) ;
+        EXPECT_TRUE( thisobject->findData("maxAngleVariation") != nullptr ) ;
+        EXPECT_TRUE( thisobject->findData("effort") != nullptr ) ;
+        EXPECT_TRUE( thisobject->findData("angle") != nullptr ) ;
+
+        EXPECT_NO_THROW( thisobject->init() ) ;
+        EXPECT_NO_THROW( thisobject->bwdInit() ) ;
+        EXPECT_NO_THROW( thisobject->reinit() ) ;
+        EXPECT_NO_THROW( thisobject->reset() ) ;
+
+        EXPECT_EQ(thisobject->getNbJoints(), 3u);
+        EXPECT_TRUE(thisobject->isComponentStateValid());
+    }
+
+
+    void limitsTests(){
+        typename ThisClass::SPtr thisobject = createJoints();
+
+        // One value for all the joints, or one per joint
+        thisobject->findData("maxEffort")->read("10");
+        thisobject->findData("minEffort")->read("-10 -20 -30");
+        thisobject->findData("maxAngle")->read("1.5");
+        thisobject->findData("minAngle")->read("-1.5");
+        thisobject->findData("maxAngleVariation")->read("0.1 0.2 0.3");
+        thisobject->init();
+
+        EXPECT_TRUE(thisobject->hasLambdaMax());
+        EXPECT_TRUE(thisobject->hasLambdaMin());
+        EXPECT_TRUE(thisobject->hasDeltaMax());
+        EXPECT_TRUE(thisobject->hasDeltaMin());
+        for(unsigned int i=0; i<3; i++)
+        {
+            EXPECT_EQ(thisobject->getLambdaMax(i), 10.);
+            EXPECT_EQ(thisobject->getLambdaMin(i), -10.*(i+1));
+            EXPECT_DOUBLE_EQ(thisobject->getDeltaMax(i), 0.1*(i+1));
+            EXPECT_DOUBLE_EQ(thisobject->getDeltaMin(i), -0.1*(i+1));
+        }
+
+        vector<double> lambda{2., 3., 4.};
+        vector<double> delta{1.45, 0.2, -0.5};
+        thisobject->storeResults(lambda, delta);
+
+        EXPECT_EQ(thisobject->findData("effort")->getValueString(), "2 3 4");
+        EXPECT_EQ(thisobject->findData("angle")->getValueString(), "1.45 0.2 -0.5");
+        EXPECT_DOUBLE_EQ(thisobject->getDeltaMax(0), 1.5);
+        EXPECT_DOUBLE_EQ(thisobject->getDeltaMin(0), 1.35);
+        EXPECT_DOUBLE_EQ(thisobject->getDeltaMax(1), 0.4);
+        EXPECT_DOUBLE_EQ(thisobject->getDeltaMin(1), 0.);
+        EXPECT_DOUBLE_EQ(thisobject->getDeltaMax(2), -0.2);
+        EXPECT_DOUBLE_EQ(thisobject->getDeltaMin(2), -0.8);
+    }
+
+
+    void buildMatrixTests(){
+        typename ThisClass::SPtr thisobject = createJoints();
+        thisobject->findData("initAngle")->read("0.5");
+        thisobject->init();
+
+        sofa::core::ConstraintParams* cparams = nullptr;
+        Data<MatrixDeriv> columns;
+        unsigned int columnsIndex = 0;
+        thisobject->buildConstraintMatrix(cparams, columns, columnsIndex, *m_mecaobject->read(sofa::core::ConstVecCoordId::position()));
+
+        // One row per joint, on its dof
+        EXPECT_EQ(columnsIndex, 3u);
+        const vector<unsigned int> expected{2, 0, 1};
+        const MatrixDeriv& matrix = columns.getValue();
+        for(unsigned int row=0; row<3; row++)
+        {
+            MatrixDerivRowConstIterator rowIt = matrix.readLine(row);
+            unsigned int nbCols = 0;
+            for (MatrixDerivColConstIterator colIt = rowIt.begin(); colIt != rowIt.end(); ++colIt, nbCols++)
+            {
+                EXPECT_EQ(colIt.index(), expected[row]);
+                EXPECT_EQ(colIt.val()[0], 1.);
+            }
+            EXPECT_EQ(nbCols, 1u);
+        }
+
+        vector<double> lambda{0., 0., 0.};
+        vector<double> delta{0.5, 0.7, 0.};
+        thisobject->storeResults(lambda, delta);
+
+        FullVector<double> violation(3), jdx(3);
+        for(unsigned int i=0; i<3; i++)
+            jdx.set(i, 0.1*i);
+        thisobject->getConstraintViolation(cparams, &violation, &jdx);
+        EXPECT_NEAR(violation[0], 0., 1e-12);
+        EXPECT_NEAR(violation[1], 0.3, 1e-12);
+        EXPECT_NEAR(violation[2], -0.3, 1e-12);
+    }
+
+};
+
+using ::testing::Types;
+typedef Types<Vec1Types> DataTypes;
+
+TYPED_TEST_SUITE(JointActuatorArrayTest, DataTypes);
+
+TYPED_TEST(JointActuatorArrayTest, NormalBehavior) {
+    ASSERT_NO_THROW(this->normalTests()) ;
+}
+
+TYPED_TEST(JointActuatorArrayTest, LimitsTests) {
+    ASSERT_NO_THROW(this->limitsTests()) ;
+}
+
+TYPED_TEST(JointActuatorArrayTest, BuildMatrixTests) {
+    ASSERT_NO_THROW(this->buildMatrixTests()) ;
+}
+
+}
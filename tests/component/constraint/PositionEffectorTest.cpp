@@ -135,6 +135,311 @@ struct PositionEffectorTest : public BaseTest, PositionEffector<_DataTypes>
         thisObject->init();
         EXPECT_EQ(thisObject->findData("directions")->getValueString(),"1 0 0 0 0 0 0 1 0");
     }
+
+    void violationTests(){
+        auto simu = sofa::simulation::getSimulation();
+
+        Node::SPtr node = simu->createNewGraph("root");
+        typename MechanicalObject<DataTypes>::SPtr mecaObject = New<MechanicalObject<DataTypes> >() ;
+        typename ThisClass::SPtr thisObject = New<ThisClass >() ;
+        mecaObject->resize(3);
+        {
+            WriteAccessor<Data<VecCoord>> x = *mecaObject->write(sofa::core::VecCoordId::position());
+            for(unsigned int i=0; i<3; i++)
+            {
+                x[i][0] = i+1.;
+                x[i][2] = -2.*i;
+            }
+        }
+        mecaObject->init() ;
+
+        node->addObject(mecaObject) ;
+        node->addObject(thisObject) ;
+
+        const VecCoord& x = mecaObject->read(sofa::core::ConstVecCoordId::position())->getValue();
+        VecCoord goals;
+        goals.push_back(x[0]);
+        goals.push_back(x[2]);
+        goals[0][1] += 1.;
+        goals[1][0] -= 3.;
+        thisObject->findData("indices")->read("0 2");
+        thisObject->d_effectorGoal.setValue(goals);
+        thisObject->d_weight.setValue(2.);
+        thisObject->init();
+
+        auto checkViolation = [&]()
+        {
+            const auto& useDirections = thisObject->d_useDirections.getValue();
+            const VecDeriv& directions = thisObject->d_directions.getValue();
+            const vector<unsigned int>& indices = thisObject->d_indices.getValue();
+
+            unsigned int nbLines = 0;
+            for(unsigned int j=0; j<Deriv::total_size; j++)
+                if(useDirections[j])
+                    nbLines++;
+            nbLines *= indices.size();
+
+            // The violation is written in bulk in contiguous vectors
+            FullVector<SReal> Jdx(nbLines);
+            FullVector<SReal> resV(nbLines);
+            for(unsigned int line=0; line<nbLines; line++)
+                Jdx.set(line, 0.5*line);
+
+            thisObject->getConstraintViolation(nullptr, &resV, &Jdx);
+
+            unsigned int line = 0;
+            for(unsigned int i=0; i<indices.size(); i++)
+            {
+                Deriv d = DataTypes::coordDifference(x[indices[i]], goals[i]);
+                for(unsigned int j=0; j<Deriv::total_size; j++)
+                    if(useDirections[j])
+                    {
+                        EXPECT_NEAR(resV.element(line), 0.5*line + d*directions[j]*2., 1e-12);
+                        line++;
+                    }
+            }
+            EXPECT_EQ(line, nbLines);
+        };
+
+        // All the axes
+        checkViolation();
+
+        // Some of the axes only: the translations of a rigid frame, x and z otherwise
+        {
+            WriteAccessor<Data<sofa::type::Vec<Deriv::total_size,bool>>> useDirections = thisObject->d_useDirections;
+            for(unsigned int j=0; j<Deriv::total_size; j++)
+                useDirections[j] = (Deriv::total_size == 6)? (j < 3) : (j != 1);
+        }
+        checkViolation();
+
+        // Directions that are not the axes
+        {
+            WriteAccessor<Data<VecDeriv>> directions = thisObject->d_directions;
+            directions[0] = Deriv();
+            directions[0][0] = directions[0][1] = 1./std::sqrt(2.);
+        }
+        checkViolation();
+    }
+
+    void targetChannelTests(){
+        auto simu = sofa::simulation::getSimulation();
+
+        Node::SPtr node = simu->createNewGraph("root");
+        typename MechanicalObject<DataTypes>::SPtr mecaObject = New<MechanicalObject<DataTypes> >() ;
+        typename ThisClass::SPtr thisObject = New<ThisClass >() ;
+        mecaObject->resize(3);
+        {
+            WriteAccessor<Data<VecCoord>> x = *mecaObject->write(sofa::core::VecCoordId::position());
+            for(unsigned int i=0; i<3; i++)
+                x[i][0] = i+1.;
+        }
+        mecaObject->init() ;
+
+        node->addObject(mecaObject) ;
+        node->addObject(thisObject) ;
+
+        const VecCoord& x = mecaObject->read(sofa::core::ConstVecCoordId::position())->getValue();
+        thisObject->findData("indices")->read("0 2");
+        thisObject->findData("useTargetChannel")->read("1");
+        thisObject->d_effectorGoal.setValue(VecCoord{x[0], x[2]});
+        thisObject->init();
+
+        const auto& useDirections = thisObject->d_useDirections.getValue();
+        const VecDeriv& directions = thisObject->d_directions.getValue();
+        const vector<unsigned int>& indices = thisObject->d_indices.getValue();
+
+        unsigned int nbLines = 0;
+        for(unsigned int j=0; j<Deriv::total_size; j++)
+            if(useDirections[j])
+                nbLines++;
+        nbLines *= indices.size();
+
+        FullVector<SReal> Jdx(nbLines);
+        FullVector<SReal> resV(nbLines);
+        for(unsigned int line=0; line<nbLines; line++)
+            Jdx.set(line, 0.);
+
+        auto checkViolation = [&](const VecCoord& goals){
+            thisObject->getConstraintViolation(nullptr, &resV, &Jdx);
+            unsigned int line = 0;
+            for(unsigned int i=0; i<indices.size(); i++)
+            {
+                Deriv d = DataTypes::coordDifference(x[indices[i]], goals[i]);
+                for(unsigned int j=0; j<Deriv::total_size; j++)
+                    if(useDirections[j])
+                    {
+                        EXPECT_NEAR(resV.element(line), d*directions[j], 1e-12);
+                        line++;
+                    }
+            }
+        };
+
+        // Nothing written yet, effectorGoal is used
+        checkViolation(thisObject->d_effectorGoal.getValue());
+
+        // The latest goals written are used, without timestamp
+        VecCoord goals{x[0], x[2]};
+        goals[0][1] += 1.;
+        goals[1][0] -= 3.;
+        thisObject->getTargetChannel().write(goals);
+        checkViolation(goals);
+        EXPECT_EQ(thisObject->d_effectorGoal.getValue()[0], x[0]);
+
+        // Timestamped goals are interpolated at the simulation time, and held after the last timestamp
+        thisObject->getTargetChannel().write(goals, 0.);
+        checkViolation(goals);
+
+        VecCoord nextGoals = goals;
+        for(auto& goal: nextGoals)
+            goal[0] += 2.;
+        thisObject->getTargetChannel().write(nextGoals, 2.);
+        node->setTime(1.);
+        VecCoord halfwayGoals = goals;
+        for(auto& goal: halfwayGoals)
+            goal[0] += 1.;
+        checkViolation(halfwayGoals);
+
+        node->setTime(3.);
+        checkViolation(nextGoals);
+    }
+
+
+    void targetCloudTests(){
+        auto simu = sofa::simulation::getSimulation();
+
+        Node::SPtr node = simu->createNewGraph("root");
+        typename MechanicalObject<DataTypes>::SPtr mecaObject = New<MechanicalObject<DataTypes> >() ;
+        typename ThisClass::SPtr thisObject = New<ThisClass >() ;
+        mecaObject->resize(3);
+        {
+            WriteAccessor<Data<VecCoord>> x = *mecaObject->write(sofa::core::VecCoordId::position());
+            for(unsigned int i=0; i<3; i++)
+                x[i][0] = i+1.;
+        }
+        mecaObject->init() ;
+
+        node->addObject(mecaObject) ;
+        node->addObject(thisObject) ;
+
+        const VecCoord& x = mecaObject->read(sofa::core::ConstVecCoordId::position())->getValue();
+        VecCoord cloud{x[2], x[0], x[0]};
+        cloud[0][1] += 0.5;
+        cloud[1][1] += 0.2;
+        cloud[2][0] += 100.;
+        thisObject->findData("indices")->read("0 2");
+        thisObject->d_targetCloud.setValue(cloud);
+        thisObject->init();
+
+        // The indices are not resized to the goals
+        const vector<unsigned int>& indices = thisObject->d_indices.getValue();
+        ASSERT_EQ(indices.size(), 2u);
+
+        const auto& useDirections = thisObject->d_useDirections.getValue();
+        const VecDeriv& directions = thisObject->d_directions.getValue();
+        unsigned int nbLines = 0;
+        for(unsigned int j=0; j<Deriv::total_size; j++)
+            if(useDirections[j])
+                nbLines++;
+        nbLines *= indices.size();
+
+        FullVector<SReal> Jdx(nbLines);
+        FullVector<SReal> resV(nbLines);
+        for(unsigned int line=0; line<nbLines; line++)
+            Jdx.set(line, 0.);
+
+        auto checkViolation = [&](const vector<int>& correspondences){
+            thisObject->getConstraintViolation(nullptr, &resV, &Jdx);
+            EXPECT_EQ(thisObject->d_correspondences.getValue(), correspondences);
+            const VecCoord& targetCloud = thisObject->d_targetCloud.getValue();
+            unsigned int line = 0;
+            for(unsigned int i=0; i<indices.size(); i++)
+            {
+                const Coord& goal = (correspondences[i] >= 0)? targetCloud[correspondences[i]] : x[indices[i]];
+                Deriv d = DataTypes::coordDifference(x[indices[i]], goal);
+                for(unsigned int j=0; j<Deriv::total_size; j++)
+                    if(useDirections[j])
+                    {
+                        EXPECT_NEAR(resV.element(line), d*directions[j], 1e-12);
+                        line++;
+                    }
+            }
+        };
+
+        // The goals are the nearest points of the cloud
+        checkViolation({1, 0});
+
+        // Without a point of the cloud close enough, there is no goal
+        thisObject->d_maxCorrespondenceDistance.setValue(0.3);
+        checkViolation({1, -1});
+
+        // The updated cloud is matched
+        cloud[0][1] = x[2][1] + 0.1;
+        cloud[1][0] += 50.;
+        thisObject->d_targetCloud.setValue(cloud);
+        checkViolation({-1, 0});
+
+        thisObject->d_maxCorrespondenceDistance.setValue(0.);
+        checkViolation({0, 0});
+    }
+
+
+    void rowWeightsTests(){
+        auto simu = sofa::simulation::getSimulation();
+
+        Node::SPtr node = simu->createNewGraph("root");
+        typename MechanicalObject<DataTypes>::SPtr mecaObject = New<MechanicalObject<DataTypes> >() ;
+        typename ThisClass::SPtr thisObject = New<ThisClass >() ;
+        mecaObject->resize(2);
+        mecaObject->init() ;
+
+        node->addObject(mecaObject) ;
+        node->addObject(thisObject) ;
+
+        thisObject->findData("indices")->read("0 1");
+        thisObject->d_effectorGoal.setValue(VecCoord(2));
+        thisObject->init();
+
+        constexpr unsigned int N = Deriv::total_size;
+        unsigned int blockSize = 0;
+        vector<double> weights;
+
+        // Not weighted by default
+        EXPECT_FALSE(thisObject->getRowWeights(blockSize, weights));
+        EXPECT_TRUE(weights.empty());
+
+        // One weight per point, on all its directions
+        thisObject->findData("pointWeights")->read("2 3");
+        ASSERT_TRUE(thisObject->getRowWeights(blockSize, weights));
+        EXPECT_EQ(blockSize, 1u);
+        ASSERT_EQ(weights.size(), 2*N);
+        for(unsigned int k=0; k<N; k++)
+        {
+            EXPECT_EQ(weights[k], 2.);
+            EXPECT_EQ(weights[N+k], 3.);
+        }
+
+        // One matrix per point replaces the weights, appended after the previous ones
+        vector<typename DataTypes::Real> matrices(2*N*N, 0.);
+        for(unsigned int k=0; k<N; k++)
+        {
+            matrices[k*N+k] = 1.+k;
+            matrices[N*N+k*N] = 0.5;
+            matrices[N*N+k] = 0.5;
+        }
+        thisObject->d_weightMatrices.setValue(matrices);
+        ASSERT_TRUE(thisObject->getRowWeights(blockSize, weights));
+        EXPECT_EQ(blockSize, N);
+        ASSERT_EQ(weights.size(), 2*N + 2*N*N);
+        for(unsigned int k=0; k<2*N*N; k++)
+            EXPECT_EQ(weights[2*N+k], matrices[k]);
+
+        // Ignored with a wrong size
+        weights.clear();
+        thisObject->findData("weightMatrices")->read("1 2");
+        thisObject->findData("pointWeights")->read("2");
+        EXPECT_FALSE(thisObject->getRowWeights(blockSize, weights));
+        EXPECT_TRUE(weights.empty());
+    }
 };
 
 
@@ -207,5 +512,20 @@ struct PositionEffectorTest : public BaseTest, PositionEffector<_DataTypes>
         ASSERT_NO_THROW(this->initTests()) ;
     }
 
-}
+    TYPED_TEST(PositionEffectorTest, ViolationTests) {
+        ASSERT_NO_THROW(this->violationTests()) ;
+    }
+
+    TYPED_TEST(PositionEffectorTest, TargetChannelTests) {
+        ASSERT_NO_THROW(this->targetChannelTests()) ;
+    }
+
+    TYPED_TEST(PositionEffectorTest, RowWeightsTests) {
+        ASSERT_NO_THROW(this->rowWeightsTests()) ;
+    }
+
+    TYPED_TEST(PositionEffectorTest, TargetCloudTests) {
+        ASSERT_NO_THROW(this->targetCloudTests()) ;
+    }
 
+}
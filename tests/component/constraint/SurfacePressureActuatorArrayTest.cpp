@@ -0,0 +1,212 @@
+#include <map>
+#include <string>
+using std::string ;
+#include <sofa/testing/BaseTest.h>
+using sofa::testing::BaseTest ;
+#include <sofa/helper/BackTrace.h>
+#include <sofa/component/statecontainer/MechanicalObject.h>
+
+#include <sofa/linearalgebra/FullVector.h>
+using sofa::linearalgebra::FullVector;
+using sofa::core::objectmodel::Data ;
+
+using sofa::helper::WriteAccessor ;
+using sofa::defaulttype::Vec3Types ;
+
+#include <sofa/simulation/graph/DAGSimulation.h>
+using sofa::simulation::Simulation ;
+#include <sofa/simulation/Node.h>
+using sofa::simulation::Node ;
+using sofa::core::objectmodel::New ;
+using sofa::component::statecontainer::MechanicalObject ;
+
+#include <SoftRobots.Inverse/component/constraint/SurfacePressureActuatorArray.h>
+using softrobotsinverse::constraint::SurfacePressureActuatorArray ;
+
+using sofa::type::vector;
+
+
+namespace softrobotsinverse
+{
+
+template <typename _DataTypes>
+struct SurfacePressureActuatorArrayTest : public BaseTest, SurfacePressureActuatorArray<_DataTypes>
+{
+    typedef SurfacePressureActuatorArray<_DataTypes> ThisClass ;
+    typedef _DataTypes DataTypes;
+    typedef typename DataTypes::Deriv Deriv;
+    typedef typename DataTypes::MatrixDeriv MatrixDeriv;
+    typedef typename DataTypes::Coord Coord;
+    typedef typename DataTypes::VecCoord VecCoord;
+
+    typedef typename DataTypes::MatrixDeriv::RowConstIterator MatrixDerivRowConstIterator;
+    typedef typename DataTypes::MatrixDeriv::ColConstIterator MatrixDerivColConstIterator;
+
+    Node::SPtr m_node;
+    typename MechanicalObject<DataTypes>::SPtr m_mecaobject;
+
+
+    // Two cavities on the same mechanical state: a unit cube given by quads (points 0 to 7),
+    // and a tetrahedron of volume 1/6 given by triangles (points 8 to 11)
+    typename ThisClass::SPtr createCavities()
+    {
+        m_node = sofa::simulation::getSimulation()->createNewGraph("root");
+        m_mecaobject = New<MechanicalObject<DataTypes> >() ;
+        typename ThisClass::SPtr thisobject = New<ThisClass >() ;
+
+        m_node->addObject(m_mecaobject) ;
+        m_mecaobject->findData("position")->read("0 0 0  1 0 0  1 1 0  0 1 0  0 0 1  1 0 1  1 1 1  0 1 1 "
+                                                 "0 0 5  1 0 5  0 1 5  0 0 6");
+        m_mecaobject->init();
+        m_node->addObject(thisobject) ;
+        thisobject->findData("quads")->read("0 3 2 1  4 5 6 7  0 1 5 4  3 7 6 2  0 4 7 3  1 2 6 5");
+        thisobject->findData("nbQuads")->read("6 0");
+        thisobject->findData("triangles")->read("8 10 9  8 9 11  8 11 10  9 10 11");
+        thisobject->findData("nbTriangles")->read("0 4");
+        return thisobject;
+    }
+
+
+    void normalTests(){
+        typename ThisClass::SPtr thisobject = createCavities();
+
+        thisobject->setName("myname") ;
+        EXPECT_TRUE(thisobject->getName() == "myname") ;
+
+        EXPECT_TRUE( thisobject->findData("triangles") != nullptr ) ;
+        EXPECT_TRUE( thisobject->findData("nbTriangles") != nullptr ) ;
+        EXPECT_TRUE( thisobject->findData("quads") != nullptr ) ;
+        EXPECT_TRUE( thisobject->findData("nbQuads") != nullptr ) ;
+        EXPECT_TRUE( thisobject->findData("maxPressure") != nullptr ) ;
+        EXPECT_TRUE( thisobject->findData("minPressure") != nullptr ) ;
+        EXPECT_TRUE( thisobject->findData("maxVolumeGrowth") != nullptr ) ;
+        EXPECT_TRUE( thisobject->findData("minVolumeGrowth") != nullptr ) ;
+        EXPECT_TRUE( thisobject->findData("maxVolumeGrowthVariation") != nullptr ) ;
+        EXPECT_TRUE( thisobject->findData("pressure") != nullptr ) ;
+        EXPECT_TRUE( thisobject->findData("volumeGrowth") != nullptr ) ;
+        EXPECT_TRUE( thisobject->findData("cavityVolume") != nullptr ) ;
+
+        EXPECT_NO_THROW( thisobject->init() ) ;
+        EXPECT_NO_THROW( thisobject->bwdInit() ) ;
+        EXPECT_NO_THROW( thisobject->reinit() ) ;
+        EXPECT_NO_THROW( thisobject->reset() ) ;
+
+        EXPECT_EQ(thisobject->getNbCavities(), 2u);
+        const vector<double> volumes = this->toVector(thisobject->findData("initialCavityVolume"));
+        ASSERT_EQ(volumes.size(), 2u);
+        EXPECT_NEAR(volumes[0], 1., 1e-12);
+        EXPECT_NEAR(volumes[1], 1./6., 1e-12);
+    }
+
+
+    vector<double> toVector(sofa::core::objectmodel::BaseData* data)
+    {
+        return dynamic_cast<Data<vector<double>>*>(data)->getValue();
+    }
+
+
+    void limitsTests(){
+        typename ThisClass::SPtr thisobject = createCavities();
+
+        // One value for all the cavities, or one per cavity
+        thisobject->findData("maxPressure")->read("10");
+        thisobject->findData("minPressure")->read("0 1");
+        thisobject->findData("maxVolumeGrowthVariation")->read("1");
+        thisobject->init();
+
+        EXPECT_TRUE(thisobject->hasLambdaMax());
+        EXPECT_TRUE(thisobject->hasLambdaMin());
+        EXPECT_TRUE(thisobject->hasDeltaMax());
+        EXPECT_TRUE(thisobject->hasDeltaMin());
+        for(unsigned int i=0; i<2; i++)
+        {
+            EXPECT_EQ(thisobject->getLambdaMax(i), 10.);
+            EXPECT_EQ(thisobject->getLambdaMin(i), double(i));
+            EXPECT_EQ(thisobject->getDeltaMax(i), 1.);
+            EXPECT_EQ(thisobject->getDeltaMin(i), -1.);
+        }
+
+        vector<double> lambda{2., 3.};
+        vector<double> delta{0.5, 0.2};
+        thisobject->storeResults(lambda, delta);
+
+        EXPECT_EQ(thisobject->findData("pressure")->getValueString(), "2 3");
+        EXPECT_DOUBLE_EQ(thisobject->getDeltaMax(0), 1.5);
+        EXPECT_DOUBLE_EQ(thisobject->getDeltaMin(0), -0.5);
+        EXPECT_DOUBLE_EQ(thisobject->getDeltaMax(1), 1.2);
+        EXPECT_DOUBLE_EQ(thisobject->getDeltaMin(1), -0.8);
+
+        // The number of primitives of each cavity should match the primitives
+        thisobject->findData("nbTriangles")->read("1 4");
+        thisobject->init();
+        EXPECT_EQ(thisobject->getComponentState(), sofa::core::objectmodel::ComponentState::Invalid);
+    }
+
+
+    void buildMatrixTests(){
+        typename ThisClass::SPtr thisobject = createCavities();
+        thisobject->init();
+
+        sofa::core::ConstraintParams* cparams = nullptr;
+        Data<MatrixDeriv> columns;
+        unsigned int columnsIndex = 0;
+        thisobject->buildConstraintMatrix(cparams, columns, columnsIndex, *m_mecaobject->read(sofa::core::ConstVecCoordId::position()));
+
+        // One row per cavity, the gradient of its volume on its own points
+        EXPECT_EQ(columnsIndex, 2u);
+        const double third = 1./3.;
+        const vector<std::map<unsigned int, Deriv>> expected{
+            {{6, Deriv(third,third,third)}, {0, Deriv(-third,-third,-third)}},
+            {{11, Deriv(0,0,1./6.)}, {8, Deriv(-1./6.,-1./6.,-1./6.)}}};
+        const vector<unsigned int> nbPoints{8, 4};
+
+        const MatrixDeriv& matrix = columns.getValue();
+        for(unsigned int row=0; row<2; row++)
+        {
+            MatrixDerivRowConstIterator rowIt = matrix.readLine(row);
+            unsigned int nbCols = 0;
+            for (MatrixDerivColConstIterator colIt = rowIt.begin(); colIt != rowIt.end(); ++colIt, nbCols++)
+            {
+                EXPECT_TRUE((row==0 && colIt.index()<8) || (row==1 && colIt.index()>=8)) << row << " " << colIt.index();
+                if(expected[row].find(colIt.index()) == expected[row].end())
+                    continue;
+                const Deriv& value = expected[row].at(colIt.index());
+                for(unsigned int k=0; k<3; k++)
+                    EXPECT_NEAR(colIt.val()[k], value[k], 1e-12) << row << " " << colIt.index();
+            }
+            EXPECT_EQ(nbCols, nbPoints[row]);
+        }
+
+        // Doubling the height of the cube and of the tetrahedron
+        {
+            WriteAccessor<Data<VecCoord>> positions = *m_mecaobject->write(sofa::core::VecCoordId::position());
+            for(unsigned int i=4; i<8; i++)
+                positions[i][2] = 2.;
+            positions[11][2] = 7.;
+        }
+        FullVector<double> violation(2), jdx;
+        thisobject->getConstraintViolation(cparams, &violation, &jdx);
+        EXPECT_NEAR(violation[0], 1., 1e-12);
+        EXPECT_NEAR(violation[1], 1./6., 1e-12);
+    }
+
+};
+
+using ::testing::Types;
+typedef Types<Vec3Types> DataTypes;
+
+TYPED_TEST_SUITE(SurfacePressureActuatorArrayTest, DataTypes);
+
+TYPED_TEST(SurfacePressureActuatorArrayTest, NormalBehavior) {
+    ASSERT_NO_THROW(this->normalTests()) ;
+}
+
+TYPED_TEST(SurfacePressureActuatorArrayTest, LimitsTests) {
+    ASSERT_NO_THROW(this->limitsTests()) ;
+}
+
+TYPED_TEST(SurfacePressureActuatorArrayTest, BuildMatrixTests) {
+    ASSERT_NO_THROW(this->buildMatrixTests()) ;
+}
+
+}
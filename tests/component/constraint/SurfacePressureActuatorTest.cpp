@@ -26,6 +26,10 @@ using sofa::core::objectmodel::BaseData ;
 using sofa::component::statecontainer::MechanicalObject ;
 
 #include <SoftRobots.Inverse/component/constraint/SurfacePressureActuator.h>
+#include <SoftRobots.Inverse/component/constraint/SurfacePressureCavity.h>
+using softrobotsinverse::constraint::SurfacePressureCavity ;
+#include <SoftRobots.Inverse/component/constraint/SurfacePressureCavityVolumes.h>
+using softrobotsinverse::constraint::SurfacePressureCavityVolumes ;
 
 namespace softrobotsinverse {
 
@@ -78,6 +82,101 @@ namespace softrobotsinverse {
 
         }
 
+        // Volume and gradient of a unit cube given by its quads, against the finite differences of the volume
+        void precomputedCavityTests(){
+            VecCoord positions;
+            positions.push_back(Coord(0.,0.,0.)); positions.push_back(Coord(1.,0.,0.));
+            positions.push_back(Coord(1.,1.,0.)); positions.push_back(Coord(0.,1.,0.));
+            positions.push_back(Coord(0.,0.,1.)); positions.push_back(Coord(1.,0.,1.));
+            positions.push_back(Coord(1.,1.,1.)); positions.push_back(Coord(0.,1.,1.));
+
+            sofa::type::vector<Quad> quads;
+            quads.push_back(Quad(0,3,2,1)); quads.push_back(Quad(4,5,6,7));
+            quads.push_back(Quad(0,1,5,4)); quads.push_back(Quad(3,7,6,2));
+            quads.push_back(Quad(0,4,7,3)); quads.push_back(Quad(1,2,6,5));
+
+            SurfacePressureCavity<DataTypes> cavity;
+            cavity.init(sofa::type::vector<BaseMeshTopology::Triangle>(), quads, false);
+            ASSERT_EQ(cavity.getPoints().size(), 8u);
+
+            // Moves a point so that the cube is not symmetric anymore
+            positions[6] = Coord(1.2, 0.9, 1.3);
+            cavity.evaluate(positions);
+            EXPECT_NEAR(cavity.getVolume(), cavity.computeVolume(positions), 1e-12);
+
+            const double eps = 1e-4;
+            for(unsigned int i=0; i<positions.size(); i++)
+            {
+                ASSERT_EQ(cavity.getPoints()[i], i);
+                for(unsigned int k=0; k<3; k++)
+                {
+                    VecCoord plus = positions, minus = positions;
+                    plus[i][k] += eps;
+                    minus[i][k] -= eps;
+                    double gradient = (cavity.computeVolume(plus) - cavity.computeVolume(minus))/(2.*eps);
+                    EXPECT_NEAR(cavity.getGradient()[i][k], gradient, 1e-6);
+                }
+            }
+
+            // Back to the unit cube, and its opposite with flipped normals
+            positions[6] = Coord(1.,1.,1.);
+            cavity.evaluate(positions);
+            EXPECT_NEAR(cavity.getVolume(), 1., 1e-12);
+            EXPECT_NEAR(cavity.getGradient()[6][0], 1./3., 1e-12);
+
+            cavity.init(sofa::type::vector<BaseMeshTopology::Triangle>(), quads, true);
+            EXPECT_NEAR(cavity.computeVolume(positions), -1., 1e-12);
+        }
+
+        // Volume of the unit cube shared by the components of the same surface, updated around the moved points only
+        void sharedVolumeTests(){
+            sofa::Data<VecCoord> positions;
+            VecCoord& x = *positions.beginEdit();
+            x.push_back(Coord(0.,0.,0.)); x.push_back(Coord(1.,0.,0.));
+            x.push_back(Coord(1.,1.,0.)); x.push_back(Coord(0.,1.,0.));
+            x.push_back(Coord(0.,0.,1.)); x.push_back(Coord(1.,0.,1.));
+            x.push_back(Coord(1.,1.,1.)); x.push_back(Coord(0.,1.,1.));
+            positions.endEdit();
+
+            sofa::type::vector<Quad> quads;
+            quads.push_back(Quad(0,3,2,1)); quads.push_back(Quad(4,5,6,7));
+            quads.push_back(Quad(0,1,5,4)); quads.push_back(Quad(3,7,6,2));
+            quads.push_back(Quad(0,4,7,3)); quads.push_back(Quad(1,2,6,5));
+            const sofa::type::vector<BaseMeshTopology::Triangle> triangles;
+
+            typedef SurfacePressureCavityVolumes<DataTypes> Volumes;
+            int state, otherState;
+            auto cavity = Volumes::getCavity(&state, triangles, quads, false);
+            auto sameCavity = Volumes::getCavity(&state, triangles, quads, false);
+            auto flippedCavity = Volumes::getCavity(&state, triangles, quads, true);
+            auto otherCavity = Volumes::getCavity(&otherState, triangles, quads, false);
+            EXPECT_EQ(cavity, sameCavity);
+            EXPECT_NE(cavity, flippedCavity);
+            EXPECT_NE(cavity, otherCavity);
+
+            // The first query updates the cavities of the same state only
+            EXPECT_NEAR(Volumes::getVolume(*cavity, positions), 1., 1e-12);
+            EXPECT_NEAR(flippedCavity->getVolume(), -1., 1e-12);
+            EXPECT_EQ(otherCavity->getVolume(), 0.);
+            EXPECT_NEAR(Volumes::getVolume(*otherCavity, positions), 1., 1e-12);
+
+            // One point moved: its six triangles are recomputed
+            positions.beginEdit()->at(6) = Coord(1.2, 0.9, 1.3);
+            positions.endEdit();
+            SurfacePressureCavity<DataTypes> reference;
+            reference.init(triangles, quads, false);
+            EXPECT_NEAR(Volumes::getVolume(*sameCavity, positions), reference.computeVolume(positions.getValue()), 1e-12);
+            EXPECT_EQ(cavity->getNbUpdatedTriangles(), 6u);
+            EXPECT_NEAR(Volumes::getVolume(*flippedCavity, positions), -reference.computeVolume(positions.getValue()), 1e-12);
+
+            // All the points moved
+            for(Coord& p : *positions.beginEdit())
+                p *= 2.;
+            positions.endEdit();
+            EXPECT_NEAR(Volumes::getVolume(*cavity, positions), reference.computeVolume(positions.getValue()), 1e-12);
+            EXPECT_EQ(cavity->getNbUpdatedTriangles(), 12u);
+        }
+
     };
 
     using ::testing::Types;
@@ -94,5 +193,13 @@ namespace softrobotsinverse {
         this->stressTests() ;
     }
 
+    TYPED_TEST(SurfacePressureActuatorTest, PrecomputedCavity) {
+        this->precomputedCavityTests() ;
+    }
+
+    TYPED_TEST(SurfacePressureActuatorTest, SharedVolume) {
+        this->sharedVolumeTests() ;
+    }
+
 }
 
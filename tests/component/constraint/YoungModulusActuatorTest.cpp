@@ -71,6 +71,7 @@ struct YoungModulusActuatorTest : public BaseTest,
 
         EXPECT_TRUE( thisobject->findData("minYoung") != nullptr ) ;
         EXPECT_TRUE( thisobject->findData("maxYoungVariationRatio") != nullptr ) ;
+        EXPECT_TRUE( thisobject->findData("forceUpdateThreshold") != nullptr ) ;
 
         EXPECT_NO_THROW( thisobject->init() ) ;
         EXPECT_NO_THROW( thisobject->bwdInit() ) ;
@@ -82,6 +83,76 @@ struct YoungModulusActuatorTest : public BaseTest,
 
         thisobject->findData("maxYoungVariationRatio")->read("1");
         EXPECT_NO_THROW(thisobject->reinit()) ;
+
+        thisobject->findData("forceUpdateThreshold")->read("1e-3");
+        EXPECT_NO_THROW(thisobject->reset()) ;
+    }
+
+    void forceUpdateThreshold(){
+        string scene =
+                "<?xml version='1.0'?>"
+                "<Node 	name='Root' gravity='0 0 0' time='0' animate='0'   > "
+                "   <RequiredPlugin name='Sofa.Component.Topology.Container.Constant'/> "
+                "   <MechanicalObject position='0 0 0  1 0 0  0 1 0  0 0 1'/> "
+                "   <MeshTopology tetrahedra='0 1 2 3'/> "
+                "   <TetrahedronFEMForceField youngModulus='100'/> "
+                "   <YoungModulusActuator forceUpdateThreshold='1e-3'/> "
+                "</Node>                             " ;
+        Node::SPtr root = SceneLoaderXML::loadFromMemory("forceUpdateThreshold", scene.c_str());
+        ASSERT_NE(root, nullptr);
+        sofa::simulation::node::initRoot(root.get());
+
+        ThisClass* thisobject = root->get<ThisClass>();
+        MechanicalObject<DataTypes>* mecaobject = root->get<MechanicalObject<DataTypes> >();
+        ASSERT_NE(thisobject, nullptr);
+        ASSERT_NE(mecaobject, nullptr);
+
+        Data<typename DataTypes::VecCoord> x;
+        x.setValue(mecaobject->read(sofa::core::ConstVecCoordId::position())->getValue());
+        // One of the points moved from its rest position, for the force to be non zero
+        {
+            WriteAccessor<Data<typename DataTypes::VecCoord> > positions = x;
+            positions[3][2] = 1.1;
+        }
+
+        const auto build = [&]() {
+            Data<typename DataTypes::MatrixDeriv> matrix;
+            unsigned int index = 0;
+            thisobject->buildConstraintMatrix(nullptr, matrix, index, x);
+            EXPECT_EQ(index, 1u);
+        };
+
+        build();
+        EXPECT_EQ(thisobject->getNbForceEvaluations(), 1u);
+
+        // Below the threshold, the force is reused
+        {
+            WriteAccessor<Data<typename DataTypes::VecCoord> > positions = x;
+            positions[3][2] += 1e-4;
+        }
+        build();
+        EXPECT_EQ(thisobject->getNbForceEvaluations(), 1u);
+
+        // Above the threshold, from the positions of the last evaluation, it is evaluated again
+        {
+            WriteAccessor<Data<typename DataTypes::VecCoord> > positions = x;
+            positions[3][2] += 1e-2;
+        }
+        build();
+        EXPECT_EQ(thisobject->getNbForceEvaluations(), 2u);
+        build();
+        EXPECT_EQ(thisobject->getNbForceEvaluations(), 2u);
+
+        // The reset discards the kept force
+        thisobject->reset();
+        build();
+        EXPECT_EQ(thisobject->getNbForceEvaluations(), 3u);
+
+        // Without threshold, it is evaluated at each build
+        thisobject->findData("forceUpdateThreshold")->read("0");
+        build();
+        build();
+        EXPECT_EQ(thisobject->getNbForceEvaluations(), 5u);
     }
 
 };
@@ -99,5 +170,9 @@ TYPED_TEST(YoungModulusActuatorTest, NormalBehavior) {
     this->normalBehavior() ;
 }
 
+TYPED_TEST(YoungModulusActuatorTest, ForceUpdateThreshold) {
+    this->forceUpdateThreshold() ;
+}
+
 }
 
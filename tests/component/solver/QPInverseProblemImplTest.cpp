@@ -4,21 +4,296 @@ using sofa::testing::BaseTest ;
 #include <SoftRobots.Inverse/component/solver/modules/QPInverseProblemImpl.h>
 using softrobotsinverse::solver::module::QPInverseProblemImpl ;
 
+#include <SoftRobots.Inverse/component/solver/modules/QPProblemRecorder.h>
+using softrobotsinverse::solver::module::QPProblemRecorder ;
+using softrobotsinverse::solver::module::QPProblemReader ;
+
+#include <SoftRobots.Inverse/component/solver/modules/QPProblemCapture.h>
+using softrobotsinverse::solver::module::QPProblemCapture ;
+
+#include <SoftRobots.Inverse/component/solver/modules/QPResultLogger.h>
+using softrobotsinverse::solver::module::QPResultLogger ;
+using softrobotsinverse::solver::module::QPResultReader ;
+using softrobotsinverse::solver::module::QPResultChunk ;
+using softrobotsinverse::solver::module::QPRecordedStep ;
+
+#include <SoftRobots.Inverse/component/solver/modules/QPProfileReport.h>
+using softrobotsinverse::solver::module::QPProfileReport ;
+
+#include <SoftRobots.Inverse/component/solver/modules/QPProblemDecomposition.h>
+using softrobotsinverse::solver::module::QPProblemDecomposition ;
+
+#include <SoftRobots.Inverse/component/solver/modules/QPBatchSolver.h>
+using softrobotsinverse::solver::module::QPBatchSolver ;
+
+#include <SoftRobots.Inverse/component/solver/modules/QPProblemPool.h>
+using softrobotsinverse::solver::module::QPProblemPool ;
+
+#include <SoftRobots.Inverse/component/solver/modules/QPStandaloneProblem.h>
+using softrobotsinverse::solver::module::QPStandaloneProblem ;
+
+#include <SoftRobots.Inverse/component/solver/modules/QPHorizonProblem.h>
+using softrobotsinverse::solver::module::QPHorizonProblem ;
+
+#include <SoftRobots.Inverse/component/solver/modules/QPActiveSetCache.h>
+using softrobotsinverse::solver::module::QPActiveSetCache ;
+
+#include <SoftRobots.Inverse/component/solver/modules/QPAdaptiveEpsilon.h>
+using softrobotsinverse::solver::module::QPAdaptiveEpsilon ;
+
+#include <SoftRobots.Inverse/component/solver/modules/QPAdaptiveLimit.h>
+using softrobotsinverse::solver::module::QPAdaptiveLimit ;
+
+#include <SoftRobots.Inverse/component/solver/modules/QPBatchedCompliance.h>
+using softrobotsinverse::solver::module::QPBatchedCompliance ;
+
+#include <SoftRobots.Inverse/component/solver/modules/QPChangeDetection.h>
+using softrobotsinverse::solver::module::QPChangeDetection ;
+
+#include <SoftRobots.Inverse/component/solver/modules/QPCheckpoint.h>
+using softrobotsinverse::solver::module::QPCheckpoint ;
+
+#include <SoftRobots.Inverse/component/solver/modules/QPContactReduction.h>
+using softrobotsinverse::solver::module::QPContactReduction ;
+
+#include <SoftRobots.Inverse/component/solver/modules/QPContactPatches.h>
+using softrobotsinverse::solver::module::QPContactPatches ;
+
+#include <SoftRobots.Inverse/component/solver/modules/QPConsensus.h>
+using softrobotsinverse::solver::module::QPConsensus ;
+using softrobotsinverse::solver::module::QPConsensusChannel ;
+
+#include <SoftRobots.Inverse/component/solver/modules/QPHessianBackend.h>
+using softrobotsinverse::solver::module::QPHessianBackend ;
+
+#include <SoftRobots.Inverse/component/solver/modules/QPPerfCounters.h>
+using softrobotsinverse::solver::module::QPPerfCounters ;
+
+#include <SoftRobots.Inverse/component/solver/modules/QPTelemetryStream.h>
+using softrobotsinverse::solver::module::QPTelemetryStream ;
+using softrobotsinverse::solver::module::QPTelemetry ;
+
+#include <SoftRobots.Inverse/component/solver/modules/QPContactStates.h>
+using softrobotsinverse::solver::module::QPContactStates ;
+
+#include <SoftRobots.Inverse/component/solver/modules/QPSmallProblem.h>
+using softrobotsinverse::solver::module::QPSmallProblem ;
+
+#include <SoftRobots.Inverse/component/solver/modules/QPSensitivity.h>
+using softrobotsinverse::solver::module::QPSensitivity ;
+
+#include <SoftRobots.Inverse/component/solver/modules/QPTaskPool.h>
+using softrobotsinverse::solver::module::QPTaskPool ;
+
+#include <SoftRobots.Inverse/component/solver/modules/QPThreadAffinity.h>
+using softrobotsinverse::solver::module::QPThreadAffinity ;
+
+#include <SoftRobots.Inverse/component/solver/modules/QPPresolve.h>
+using softrobotsinverse::solver::module::QPPresolve ;
+
+#include <SoftRobots.Inverse/component/solver/modules/QPSpeculativePivots.h>
+using softrobotsinverse::solver::module::QPSpeculativePivots ;
+
+#include <SoftRobots.Inverse/component/solver/modules/QPMatrixFreeSolver.h>
+using softrobotsinverse::solver::module::QPMatrixFreeSolver ;
+
+#include <SoftRobots.Inverse/component/solver/modules/QPComplianceMatrix.h>
+using softrobotsinverse::solver::module::QPComplianceMatrix ;
+
+#include <SoftRobots.Inverse/component/solver/modules/NLCPSolver.h>
+using softrobotsinverse::solver::module::NLCPContactBatch ;
+using softrobotsinverse::solver::module::NLCPSolverMatrix33 ;
+
+#include <SoftRobots.Inverse/component/solver/modules/QPMessageQueue.h>
+using softrobotsinverse::solver::module::QPMessageQueue ;
+
+#include <SoftRobots.Inverse/component/solver/modules/QPContactTracker.h>
+using softrobotsinverse::solver::module::QPContactTracker ;
+
+#include <SoftRobots.Inverse/component/solver/modules/QPAlignedBuffer.h>
+using softrobotsinverse::solver::module::QPAlignedBuffer ;
+using softrobotsinverse::solver::module::QPStorage ;
+using softrobotsinverse::solver::module::QPStoragePolicy ;
+
+#include <SoftRobots.Inverse/component/solver/modules/QPBackendSelector.h>
+using softrobotsinverse::solver::module::QPBackendSelector ;
+
+#include <SoftRobots.Inverse/component/solver/modules/QPPermutedCompliance.h>
+using softrobotsinverse::solver::module::QPPermutedCompliance ;
+using softrobotsinverse::solver::module::QPPermutedComplianceF ;
+
+#include <SoftRobots.Inverse/component/solver/modules/LCPPGSSolver.h>
+using softrobotsinverse::solver::module::LCPPGSSolver ;
+
+#include <SoftRobots.Inverse/component/solver/modules/QPBorderedFactorization.h>
+using softrobotsinverse::solver::module::QPBorderedFactorization ;
+
+#include <SoftRobots.Inverse/component/solver/modules/ADMMSolverBackend.h>
+using softrobotsinverse::solver::module::ADMMSolverBackend ;
+
+#include <SoftRobots.Inverse/component/solver/modules/FrictionCone.h>
+using softrobotsinverse::solver::module::FrictionCone ;
+
+#include <SoftRobots.Inverse/component/solver/modules/ConstraintHandler.h>
+using softrobotsinverse::solver::module::ConstraintHandler ;
+using softrobotsinverse::solver::module::QPInverseProblem ;
+using softrobotsinverse::solver::module::ContactHandler ;
+using softrobotsinverse::solver::module::LCPSparseMatrix ;
+
+#include <SoftRobots.Inverse/component/constraint/CableActuator.h>
+#include <SoftRobots.Inverse/component/behavior/EffectorPriority.h>
+#include <SoftRobots.Inverse/component/behavior/EffectorWeights.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <thread>
+
 #include <sofa/defaulttype/VecTypes.h>
+#include <sofa/linearalgebra/FullMatrix.h>
+#include <sofa/simulation/MainTaskSchedulerFactory.h>
 using sofa::defaulttype::Vec3Types;
 
 using std::vector;
 
 
+// Heap allocations of the test process through operator new (the containers and qpOASES, not Eigen which
+// calls malloc), counted while s_countAllocations is set, see countAllocations()
+namespace
+{
+std::atomic<bool> s_countAllocations{false};
+std::atomic<unsigned int> s_nbAllocations{0};
+}
+
+void* operator new(std::size_t size)
+{
+    if(s_countAllocations.load(std::memory_order_relaxed))
+        s_nbAllocations.fetch_add(1, std::memory_order_relaxed);
+    if(void* pointer = std::malloc((size > 0)? size : 1))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+
 namespace softrobotsinverse::test
 {
 
+/// Number of heap allocations made by the function
+template<class Function>
+unsigned int countAllocations(const Function& function)
+{
+    s_nbAllocations = 0;
+    s_countAllocations = true;
+    function();
+    s_countAllocations = false;
+    return s_nbAllocations;
+}
+
+/// Cable actuator whose force limits are set directly, without scene
+class LimitedCableActuator : public constraint::CableActuator<Vec3Types>
+{
+public:
+    SOFA_CLASS(LimitedCableActuator, SOFA_TEMPLATE(constraint::CableActuator, Vec3Types));
+
+    void setForceLimits(const double& minForce, const double& maxForce)
+    {
+        m_hasLambdaMin = true;
+        m_lambdaMin[0] = minForce;
+        m_hasLambdaMax = true;
+        m_lambdaMax[0] = maxForce;
+    }
+};
+
+
+/// One-line component standing for an effector whose row has a weight in the objective
+class WeightedCableEffector : public LimitedCableActuator, public behavior::EffectorWeights
+{
+public:
+    SOFA_CLASS(WeightedCableEffector, LimitedCableActuator);
+
+    double m_weight{1.};
+
+    bool getRowWeights(unsigned int& blockSize, sofa::type::vector<double>& weights) const override
+    {
+        blockSize = 1;
+        weights.push_back(m_weight);
+        return true;
+    }
+};
+
+
+/// One-line component standing for an effector of a given priority level
+class PrioritizedCableEffector : public LimitedCableActuator, public behavior::EffectorPriority
+{
+public:
+    SOFA_CLASS(PrioritizedCableEffector, LimitedCableActuator);
+
+    unsigned int m_priority{0};
+
+    unsigned int getPriority() const override {return m_priority;}
+};
+
+
+/// Problem solved by one thread of the concurrency test:
+/// minimize 1/2 x^T x - (a 1) x, subject to -10 <= x <= 10, and optionally to the inactive 0 <= 1
+class ConcurrentProblem : public QPInverseProblemImpl
+{
+public:
+    void solveBounded(const double& a, const bool& withConstraint, sofa::type::vector<double>& result)
+    {
+        m_qpSystem->dim = 2;
+        m_qpSystem->Q.resize(2, 2);
+        m_qpSystem->Q.fill(0.);
+        m_qpSystem->Q[0][0] = 1.;
+        m_qpSystem->Q[1][1] = 1.;
+        m_qpSystem->c = {-a, -1.};
+        m_qpSystem->l = {-10., -10.};
+        m_qpSystem->u = {10., 10.};
+        m_qpSystem->A.clear();
+        m_qpSystem->Aeq.clear();
+        m_qpSystem->bl.clear();
+        m_qpSystem->beq.clear();
+        m_qpSystem->bu.clear();
+        if(withConstraint)
+        {
+            sofa::type::vector<double> row = {0., 0.};
+            m_qpSystem->A.push_back(row);
+            m_qpSystem->bu = {1.};
+        }
+
+        double objective;
+        sofa::type::vector<double> dual;
+        solveInverseProblem(objective, result, dual);
+    }
+};
+
+
 template <typename _DataTypes>
 struct QPInverseProblemImplTest : public BaseTest, QPInverseProblemImpl
 {
     typedef QPInverseProblemImpl ThisClass ;
     typedef _DataTypes DataTypes;
 
+    sofa::core::sptr<LimitedCableActuator> m_actuators[2];
+
     void isInTest()
     {
         vector<int> list;
@@ -132,46 +407,4541 @@ struct QPInverseProblemImplTest : public BaseTest, QPInverseProblemImpl
     }
 
 
-    void updateLambdaTest()
+    // The membership and the comparisons of the sequences do not depend on their history (clear, swap)
+    void pivotSequenceTest()
     {
-        m_qpSystem->dim = 5;
-        std::vector<double> lambda = {1,2,3,4,5};
-        updateLambda(lambda);
-        EXPECT_EQ(lambda,m_qpSystem->lambda);
+        m_currentSequence.clear();
+        m_sequence.clear();
+        m_previousSequence.clear();
+
+        m_currentSequence.push_back(1);
+        m_currentSequence.push_back(2);
+        EXPECT_TRUE(m_currentSequence.contains(2));
+        EXPECT_FALSE(m_currentSequence.contains(3));
+
+        // previous <- sequence <- current, as in the pivot algorithm
+        m_previousSequence.swap(m_sequence);
+        m_sequence.swap(m_currentSequence);
+        m_currentSequence.clear();
+        EXPECT_FALSE(m_currentSequence.contains(1));
+        EXPECT_TRUE(m_sequence.contains(1));
+        EXPECT_EQ(m_sequence.size(), 2u);
+
+        m_currentSequence.push_back(1);
+        EXPECT_TRUE(isCycling(2));
+        EXPECT_FALSE(isCycling(3));
+
+        m_currentSequence.clear();
+        m_currentSequence.push_back(2);
+        m_currentSequence.push_back(1);
+        EXPECT_FALSE(m_sequence.isExtensionOf(m_currentSequence, 3));
+
+        m_currentSequence.clear();
+        m_sequence.clear();
     }
 
-};
 
+    // Minimize 1/2 x^T x - (1 1) x, subject to -10 <= x <= 10 (solution x = (1 1))
+    void setBoundedProblem()
+    {
+        m_qpSystem->dim = 2;
+        m_qpSystem->Q.resize(2, 2);
+        m_qpSystem->Q.fill(0.);
+        m_qpSystem->Q[0][0] = 1.;
+        m_qpSystem->Q[1][1] = 1.;
+        m_qpSystem->c = {-1., -1.};
+        m_qpSystem->l = {-10., -10.};
+        m_qpSystem->u = {10., 10.};
+        m_qpSystem->A.clear();
+        m_qpSystem->Aeq.clear();
+        m_qpSystem->bu.clear();
+        m_qpSystem->bl.clear();
+        m_qpSystem->beq.clear();
+    }
 
-using ::testing::Types;
-typedef Types<Vec3Types> DataTypes;
 
-TYPED_TEST_SUITE(QPInverseProblemImplTest, DataTypes);
+    // Test that the buffers and the QP of the resolutions are reused, counting the heap allocations
+    void workspaceAllocationTest()
+    {
+        setBoundedProblem();
 
-TYPED_TEST(QPInverseProblemImplTest, isInTest) {
-    ASSERT_NO_THROW( this->isInTest() );
-}
+        double objective;
+        sofa::type::vector<double> result, dual;
+        auto solve = [&]{solveInverseProblem(objective, result, dual);};
+        const unsigned int firstAllocations = countAllocations(solve);
 
-TYPED_TEST(QPInverseProblemImplTest, isCyclingOnPivotTest) {
-    ASSERT_NO_THROW( this->isCyclingOnPivotTest() );
-}
+        EXPECT_NEAR(result[0], 1., 1e-10);
+        EXPECT_NEAR(result[1], 1., 1e-10);
+        unsigned int nbAllocations = m_workspace.nbAllocations;
 
-TYPED_TEST(QPInverseProblemImplTest, isCyclingOnSequenceTest) {
-    ASSERT_NO_THROW( this->isCyclingOnSequenceTest1() );
-    ASSERT_NO_THROW( this->isCyclingOnSequenceTest2() );
-    ASSERT_NO_THROW( this->isCyclingOnSequenceTest3() );
-}
+        // Steady state: same problem size, the buffers are not allocated again, only the arrays of qpOASES are
+        const unsigned int steadyAllocations = countAllocations(solve);
+        EXPECT_LT(steadyAllocations, firstAllocations);
+        for(int i=0; i<10; i++)
+            EXPECT_EQ(countAllocations(solve), steadyAllocations);
+        EXPECT_EQ(m_workspace.nbAllocations, nbAllocations);
 
-TYPED_TEST(QPInverseProblemImplTest, leaveSequenceUnchangedTest) {
-    ASSERT_NO_THROW( this->leaveSequenceUnchangedTest() );
-}
+        // Smaller problem: the buffers are reused
+        m_qpSystem->dim = 1;
+        m_qpSystem->Q.resize(1, 1);
+        m_qpSystem->Q[0][0] = 1.;
+        m_qpSystem->c = {-1.};
+        m_qpSystem->l = {-10.};
+        m_qpSystem->u = {10.};
+        EXPECT_LE(countAllocations(solve), steadyAllocations);
+        EXPECT_NEAR(result[0], 1., 1e-10);
+        EXPECT_EQ(m_workspace.nbAllocations, nbAllocations);
 
-TYPED_TEST(QPInverseProblemImplTest, leaveCurrentSequenceUnchangedTest) {
-    ASSERT_NO_THROW( this->leaveCurrentSequenceUnchangedTest() );
-}
+        // Constrained problem: the QP of the cold resolutions is reset instead of allocated again while its
+        // layout does not change
+        setBoundedProblem();
+        sofa::type::vector<double> row = {1., 1.};
+        m_qpSystem->A.push_back(row);
+        m_qpSystem->bu = {1.}; // x0 + x1 <= 1, active, x = (0.5 0.5)
+        const unsigned int coldAllocations = countAllocations(solve);
+        const qpOASES::QProblem* coldProblem = m_coldProblem;
+        ASSERT_NE(coldProblem, nullptr);
+        EXPECT_LT(countAllocations(solve), coldAllocations);
+        EXPECT_EQ(m_coldProblem, coldProblem);
+        EXPECT_NEAR(result[0], 0.5, 1e-10);
+        EXPECT_NEAR(result[1], 0.5, 1e-10);
+    }
 
-TYPED_TEST(QPInverseProblemImplTest, updateLambdaTest) {
-    ASSERT_NO_THROW( this->updateLambdaTest() );
+
+    // Test that the simple bounds solver is used when there are no general constraints,
+    // and gives the same solution as the general solver
+    void boundedProblemTest()
+    {
+        setBoundedProblem();
+        m_qpSystem->Q[0][1] = 0.5;
+        m_qpSystem->Q[1][0] = 0.5;
+        m_qpSystem->c = {-30., 1.}; // the upper bound of x0 is active, x = (10, -6)
+
+        double objective, generalObjective;
+        sofa::type::vector<double> result, generalResult, dual;
+
+        unsigned int nbBoundedResolutions = getNbBoundedResolutions();
+        solveInverseProblem(objective, result, dual);
+        EXPECT_EQ(getNbBoundedResolutions(), nbBoundedResolutions+1);
+
+        // Same problem with an inactive general constraint 0 <= 1
+        sofa::type::vector<double> row = {0., 0.};
+        m_qpSystem->A.push_back(row);
+        m_qpSystem->bu = {1.};
+        solveInverseProblem(generalObjective, generalResult, dual);
+        EXPECT_EQ(getNbBoundedResolutions(), nbBoundedResolutions+1);
+
+        ASSERT_EQ(result.size(), generalResult.size());
+        for(unsigned int i=0; i<result.size(); i++)
+            EXPECT_NEAR(result[i], generalResult[i], 1e-10);
+        EXPECT_NEAR(result[0], 10., 1e-10);
+        EXPECT_NEAR(result[1], -6., 1e-10);
+        EXPECT_NEAR(objective, generalObjective, 1e-10);
+    }
+
+
+    // Test that the ADMM solver finds the same solution as qpOASES, up to its tolerance
+    void admmSolverTest()
+    {
+        setBoundedProblem();
+        m_qpSystem->Q[0][1] = 0.5;
+        m_qpSystem->Q[1][0] = 0.5;
+        m_qpSystem->c = {-30., 1.};
+        sofa::type::vector<double> row = {1., 1.};
+        m_qpSystem->A.push_back(row);
+        m_qpSystem->bu = {2.}; // x0 + x1 <= 2, active
+
+        double objective, admmObjective;
+        sofa::type::vector<double> result, admmResult, dual, admmDual;
+
+        solveInverseProblem(objective, result, dual);
+
+        setQPSolver("ADMM");
+        solveInverseProblem(admmObjective, admmResult, admmDual);
+        setQPSolver("qpOASES");
+
+        ASSERT_EQ(result.size(), admmResult.size());
+        for(unsigned int i=0; i<result.size(); i++)
+            EXPECT_NEAR(result[i], admmResult[i], 1e-4);
+        ASSERT_EQ(dual.size(), admmDual.size());
+        EXPECT_NEAR(dual[0], admmDual[0], 1e-3);
+        EXPECT_NEAR(objective, admmObjective, 1e-3);
+    }
+
+
+    // Test that an infeasible QP is solved once with penalized constraint violations
+    void softRecoveryTest()
+    {
+        setBoundedProblem();
+        sofa::type::vector<double> row = {1., 1.};
+        m_qpSystem->A.push_back(row);
+        row = {-1., -1.};
+        m_qpSystem->A.push_back(row);
+        m_qpSystem->bu = {2., -4.}; // x0 + x1 <= 2 and x0 + x1 >= 4
+
+        double objective;
+        sofa::type::vector<double> result, dual;
+        setInfeasibilityRecovery("Soft");
+        m_recovery = QPRecovery::None;
+        solveInverseProblem(objective, result, dual);
+        setInfeasibilityRecovery("Cascade");
+
+        EXPECT_EQ(getRecovery(), QPRecovery::SoftConstraints);
+        ASSERT_EQ(result.size(), 2u);
+        EXPECT_NEAR(result[0], result[1], 1e-8);
+        EXPECT_NEAR(result[0] + result[1], 3., 1e-3); // Both constraints are violated by the same amount
+        ASSERT_EQ(dual.size(), 2u);
+        EXPECT_EQ(getRecoveryName(getRecovery()), "SoftConstraints");
+    }
+
+
+    // Test that the QP of the steps without contact is hot started, reusing its factorization while Q and A do not change
+    void contactFreeHotStartTest()
+    {
+        setBoundedProblem();
+        sofa::type::vector<double> row = {1., 1.};
+        m_qpSystem->A.push_back(row);
+        m_qpSystem->bu = {1.};
+
+        double objective;
+        sofa::type::vector<double> result, dual;
+        setContactFreeHotStart(true);
+        solveInverseProblem(objective, result, dual);
+        EXPECT_EQ(getNbContactFreeHotStarts(), 0u);
+
+        // Only c changes
+        m_qpSystem->c = {-3., 1.};
+        solveInverseProblem(objective, result, dual);
+        EXPECT_EQ(getNbContactFreeHotStarts(), 1u);
+        EXPECT_EQ(getNbContactFreeFactorizationReuses(), 1u);
+        ASSERT_EQ(result.size(), 2u);
+        EXPECT_NEAR(result[0], 2.5, 1e-10);
+        EXPECT_NEAR(result[1], -1.5, 1e-10);
+
+        // Q changes, the constraint becomes inactive
+        m_qpSystem->Q[0][0] = 2.;
+        solveInverseProblem(objective, result, dual);
+        EXPECT_EQ(getNbContactFreeHotStarts(), 2u);
+        EXPECT_EQ(getNbContactFreeFactorizationReuses(), 1u);
+        EXPECT_NEAR(result[0], 1.5, 1e-10);
+        EXPECT_NEAR(result[1], -1., 1e-10);
+
+        setContactFreeHotStart(false);
+    }
+
+
+    // Test that the hot started QP moves with the resolution state, and is still reused after a move
+    void swapResolutionStateTest()
+    {
+        setBoundedProblem();
+        sofa::type::vector<double> row = {1., 1.};
+        m_qpSystem->A.push_back(row);
+        m_qpSystem->bu = {1.};
+
+        double objective;
+        sofa::type::vector<double> result, dual;
+        setContactFreeHotStart(true);
+        solveInverseProblem(objective, result, dual);
+        m_qpSystem->c = {-3., 1.};
+        solveInverseProblem(objective, result, dual);
+        ASSERT_EQ(getNbContactFreeHotStarts(), 1u);
+
+        QPInverseProblemImpl other;
+        other.swapResolutionState(*this);
+        EXPECT_EQ(other.getNbContactFreeHotStarts(), 1u);
+        EXPECT_EQ(getNbContactFreeHotStarts(), 0u);
+        ASSERT_EQ(m_qpSystem->c.size(), 2u); // The QP system stays in place
+
+        swapResolutionState(other);
+        solveInverseProblem(objective, result, dual);
+        EXPECT_EQ(getNbContactFreeHotStarts(), 2u);
+        EXPECT_EQ(getNbContactFreeFactorizationReuses(), 2u);
+        ASSERT_EQ(result.size(), 2u);
+        EXPECT_NEAR(result[0], 2.5, 1e-10);
+        EXPECT_NEAR(result[1], -1.5, 1e-10);
+
+        setContactFreeHotStart(false);
+    }
+
+
+    // Test that a QP stopped by the time budget returns the best feasible iterate, here the previous solution
+    void timeBudgetTest()
+    {
+        setBoundedProblem();
+        m_qpSystem->Q[0][1] = 0.5;
+        m_qpSystem->Q[1][0] = 0.5;
+        m_qpSystem->c = {-30., 1.};
+        sofa::type::vector<double> row = {1., 1.};
+        m_qpSystem->A.push_back(row);
+        m_qpSystem->bu = {2.};
+
+        double objective;
+        sofa::type::vector<double> result, deadlineResult, dual;
+        solveInverseProblem(objective, result, dual);
+        updateLambda(result);
+        EXPECT_FALSE(hasHitDeadline());
+
+        // The ADMM solver needs many iterations, it cannot converge within the budget
+        setQPSolver("ADMM");
+        setTimeBudget(1e-9);
+        m_solveStartTime = sofa::helper::system::thread::CTime::getTime();
+        solveInverseProblem(objective, deadlineResult, dual);
+        setTimeBudget(0.);
+        setQPSolver("qpOASES");
+
+        EXPECT_TRUE(hasHitDeadline());
+        ASSERT_EQ(deadlineResult.size(), result.size());
+        for(unsigned int i=0; i<result.size(); i++)
+            EXPECT_NEAR(deadlineResult[i], result[i], 1e-10);
+        EXPECT_NEAR(objective, -266., 1e-8);
+    }
+
+
+    // Test that the QP (cold and hot started) and PGS solvers of the contact LCP find the same solution
+    void lcpSolversTest()
+    {
+        double Mv[3][3] = {{2., 1., 0.}, {1., 2., 1.}, {0., 1., 2.}};
+        double* M[3] = {Mv[0], Mv[1], Mv[2]};
+        double q[3] = {-1., 1., -2.};
+        double expected[3] = {0.5, 0., 1.}; // w = Mx + q = (0, 2.5, 0)
+        double x[3], y[3] = {0., 0., 0.};
+
+        m_lcpSolver->setBackend(nullptr);
+        m_lcpSolver->setHotStart(true);
+        unsigned int nbHits = m_lcpSolver->getNbHotStartHits();
+        for(int k=0; k<2; k++)
+        {
+            m_lcpSolver->solve(3, q, M, x);
+            for(int i=0; i<3; i++)
+                EXPECT_NEAR(x[i], expected[i], 1e-10);
+        }
+        EXPECT_EQ(m_lcpSolver->getNbHotStartHits(), nbHits+1);
+
+        m_pgsSolver->setTolerance(1e-12);
+        m_pgsSolver->setMaxIterations(1000);
+        m_pgsSolver->setRelaxation(1.2);
+        EXPECT_TRUE(m_pgsSolver->solve(3, q, M, y));
+        for(int i=0; i<3; i++)
+            EXPECT_NEAR(y[i], expected[i], 1e-8);
+    }
+
+
+    // Test that the colored Gauss-Seidel of the friction contacts finds the solution of the sequential one
+    void coloredNLCPTest()
+    {
+        // Contacts 0 and 2 are only coupled with contact 1: two colors
+        const int dim = 9;
+        double Wv[dim][dim] = {};
+        for(int i=0; i<dim; i++)
+            Wv[i][i] = 2.;
+        for(int a=0; a<3; a++)
+        {
+            Wv[a][3+a] = Wv[3+a][a] = 0.5;
+            Wv[6+a][3+a] = Wv[3+a][6+a] = -0.5;
+        }
+        double* W[dim];
+        for(int i=0; i<dim; i++)
+            W[i] = Wv[i];
+        double dfree[dim] = {-1., 0.2, -0.1, 0.5, 0.1, 0., -2., 0., 0.3};
+
+        sofa::simulation::MainTaskSchedulerFactory::createInRegistry()->init();
+        double f[2][dim];
+        for(int k=0; k<2; k++)
+        {
+            m_nlcpSolver->setAllowSliding(true);
+            m_nlcpSolver->setMultithreading(k==1);
+            EXPECT_EQ(m_nlcpSolver->solve(dim, dfree, W, f[k], 0.5, 1e-14, 1000, false), 1);
+        }
+        m_nlcpSolver->setMultithreading(false);
+
+        EXPECT_EQ(m_nlcpSolver->getNbColors(), 2u);
+        for(int i=0; i<dim; i++)
+            EXPECT_NEAR(f[0][i], f[1][i], 1e-10);
+    }
+
+
+    // Test that the batches of the colored Gauss-Seidel solve the local problems as the scalar code, and that
+    // a color of more contacts than the batch width finds the solution of the sequential resolution
+    void nlcpContactBatchTest()
+    {
+        const int width = NLCPContactBatch::s_width;
+        NLCPContactBatch batch;
+        NLCPSolverMatrix33 blocks[width];
+        double d[width][3], f[width][3];
+        for(int l=0; l<width; l++)
+        {
+            double w[6] = {2.+0.1*l, 0.1, -0.2, 1.5, 0.05*l, 1.8};
+            blocks[l].storeW(w[0], w[1], w[2], w[3], w[4], w[5]);
+            for(int j=0; j<6; j++)
+                batch.w[j][l] = w[j];
+            const double dl[3] = {(l%3 == 0)? 1. : -1.+0.1*l, 0.3-0.1*l, 0.2};
+            const double fl[3] = {0.5, 0.1*l, -0.2};
+            for(int a=0; a<3; a++)
+            {
+                batch.d[a][l] = d[l][a] = dl[a];
+                batch.f[a][l] = f[l][a] = fl[a];
+            }
+        }
+
+        double mu = 0.3;
+        batch.GSState(mu, true);
+        for(int l=0; l<width; l++)
+        {
+            blocks[l].GSState(mu, d[l][0], d[l][1], d[l][2], f[l][0], f[l][1], f[l][2], true);
+            for(int a=0; a<3; a++)
+            {
+                EXPECT_NEAR(batch.f[a][l], f[l][a], 1e-12);
+                EXPECT_NEAR(batch.d[a][l], d[l][a], 1e-12);
+            }
+        }
+        EXPECT_EQ(batch.f[0][0], 0.); // released contact
+        EXPECT_GT(batch.f[0][1], 0.);
+
+        // 11 contacts only coupled with themselves: a single color, a full and a partial batch
+        const int nbContacts = 11;
+        const int dim = 3*nbContacts;
+        vector<double> Wv(dim*dim, 0.);
+        vector<double*> W(dim);
+        vector<double> dfree(dim);
+        for(int i=0; i<dim; i++)
+        {
+            W[i] = &Wv[i*dim];
+            W[i][i] = 2.;
+            dfree[i] = (i%3 == 0)? ((i%2 == 0)? -1. : 0.5) : 0.1*(i%5) - 0.2;
+        }
+        for(int c=0; c<nbContacts; c++)
+            W[3*c][3*c+1] = W[3*c+1][3*c] = 0.3;
+
+        sofa::simulation::MainTaskSchedulerFactory::createInRegistry()->init();
+        vector<double> forces[2];
+        for(int k=0; k<2; k++)
+        {
+            forces[k].resize(dim);
+            m_nlcpSolver->setAllowSliding(true);
+            m_nlcpSolver->setRelaxation(1.3);
+            m_nlcpSolver->setMultithreading(k==1);
+            EXPECT_EQ(m_nlcpSolver->solve(dim, dfree.data(), W.data(), forces[k].data(), 0.5, 1e-14, 1000, false, false, 0., 0.4), 1);
+        }
+        m_nlcpSolver->setMultithreading(false);
+        m_nlcpSolver->setRelaxation(1.);
+
+        EXPECT_EQ(m_nlcpSolver->getNbColors(), 1u);
+        for(int i=0; i<dim; i++)
+            EXPECT_NEAR(forces[0][i], forces[1][i], 1e-10);
+        EXPECT_NEAR(forces[0][0], 0.4, 1e-10); // bounded normal force
+    }
+
+
+    // Test the convergence report of the friction contact solver, and that the adaptive relaxation
+    // converges faster on a chain of coupled contacts
+    void nlcpReportTest()
+    {
+        const int nbContacts = 10;
+        const int dim = 3*nbContacts;
+        vector<double> Wv(dim*dim, 0.);
+        vector<double*> W(dim);
+        vector<double> dfree(dim, 0.);
+        for(int i=0; i<dim; i++)
+        {
+            W[i] = &Wv[i*dim];
+            W[i][i] = 2.;
+            if(i+3<dim)
+                Wv[i*dim+i+3] = Wv[(i+3)*dim+i] = -0.99;
+        }
+        for(int c=0; c<nbContacts; c++)
+        {
+            dfree[3*c] = -1.;
+            dfree[3*c+1] = 0.1;
+        }
+
+        int nbIterations[2];
+        for(int k=0; k<2; k++)
+        {
+            vector<double> f(dim, 0.);
+            m_nlcpSolver->setAllowSliding(true);
+            m_nlcpSolver->setRelaxation((k==0)? 1. : 1.9);
+            m_nlcpSolver->setAdaptiveRelaxation(k==1);
+            EXPECT_EQ(m_nlcpSolver->solve(dim, dfree.data(), W.data(), f.data(), 0.5, 1e-10, 10000, false), 1);
+
+            EXPECT_TRUE(m_nlcpSolver->hasConverged());
+            nbIterations[k] = m_nlcpSolver->getNbIterations();
+            ASSERT_EQ(m_nlcpSolver->getResidualHistory().size(), (unsigned int)nbIterations[k]);
+            EXPECT_EQ(m_nlcpSolver->getResidualHistory().back(), m_nlcpSolver->getError());
+            EXPECT_LT(m_nlcpSolver->getError(), 1e-10*(nbContacts+1));
+        }
+        EXPECT_LT(nbIterations[1], nbIterations[0]);
+
+        // Not enough iterations
+        vector<double> f(dim, 0.);
+        EXPECT_EQ(m_nlcpSolver->solve(dim, dfree.data(), W.data(), f.data(), 0.5, 1e-10, 5, false), 0);
+        EXPECT_FALSE(m_nlcpSolver->hasConverged());
+        EXPECT_EQ(m_nlcpSolver->getNbIterations(), 5);
+
+        m_nlcpSolver->setRelaxation(1.);
+        m_nlcpSolver->setAdaptiveRelaxation(false);
+    }
+
+
+    // Test that the friction contact solver on a float copy of W, refined on W, converges to the solution
+    // of the double resolution
+    void mixedPrecisionNLCPTest()
+    {
+        const int nbContacts = 10;
+        const int dim = 3*nbContacts;
+        vector<double> Wv(dim*dim, 0.);
+        vector<double*> W(dim);
+        vector<double> dfree(dim, 0.);
+        for(int i=0; i<dim; i++)
+        {
+            W[i] = &Wv[i*dim];
+            W[i][i] = 2. + 1e-9*i; // not represented in float
+            if(i+3<dim)
+                Wv[i*dim+i+3] = Wv[(i+3)*dim+i] = -0.9 + 1e-10;
+        }
+        for(int c=0; c<nbContacts; c++)
+        {
+            dfree[3*c] = -1.;
+            dfree[3*c+1] = 0.1;
+        }
+
+        vector<double> f[2];
+        for(int k=0; k<2; k++)
+        {
+            f[k].assign(dim, 0.);
+            m_nlcpSolver->setAllowSliding(true);
+            m_nlcpSolver->setMixedPrecision(k==1);
+            EXPECT_EQ(m_nlcpSolver->solve(dim, dfree.data(), W.data(), f[k].data(), 0.5, 1e-13, 10000, false), 1);
+            EXPECT_LT(m_nlcpSolver->getError(), 1e-13*(nbContacts+1));
+        }
+        EXPECT_GE(m_nlcpSolver->getNbRefinementSweeps(), 1);
+        EXPECT_GT(m_nlcpSolver->getNbIterations(), m_nlcpSolver->getNbRefinementSweeps());
+        for(int i=0; i<dim; i++)
+            EXPECT_NEAR(f[0][i], f[1][i], 1e-10);
+
+        m_nlcpSolver->setMixedPrecision(false);
+    }
+
+
+    // Test that the contact solvers give the same solution with the dense and the sparse contact matrix
+    void sparseContactSolversTest()
+    {
+        // Rows 1, 3 and 4 of W, the contacts 0 and 2 are not coupled
+        double Wv[5][5] = {{9., 9., 9., 9., 9.},
+                           {9., 2., 9., 1., 0.},
+                           {9., 9., 9., 9., 9.},
+                           {9., 1., 9., 2., 1.},
+                           {9., 0., 9., 1., 2.}};
+        double* W[5] = {Wv[0], Wv[1], Wv[2], Wv[3], Wv[4]};
+        const unsigned int rowIds[3] = {1, 3, 4};
+        LCPSparseMatrix M;
+        M.build(W, 3, 1, rowIds);
+        EXPECT_EQ(M.getNbBlocks(), 7);
+        EXPECT_EQ(M.getRowEnd(0) - M.getRowBegin(0), 2);
+        EXPECT_EQ(*M.getDiagonalBlock(1), 2.);
+
+        double q[3] = {-1., 1., -2.};
+        double expected[3] = {0.5, 0., 1.}; // w = Mx + q = (0, 2.5, 0)
+        double x[3] = {0., 0., 0.};
+        m_pgsSolver->setTolerance(1e-12);
+        m_pgsSolver->setMaxIterations(1000);
+        m_pgsSolver->setRelaxation(1.);
+        EXPECT_TRUE(m_pgsSolver->solve(3, q, M, x));
+        for(int i=0; i<3; i++)
+            EXPECT_NEAR(x[i], expected[i], 1e-8);
+
+        // Friction contacts, two of them coupled
+        const int dim = 9;
+        double Wf[dim][dim] = {};
+        for(int i=0; i<dim; i++)
+            Wf[i][i] = 2.;
+        for(int a=0; a<3; a++)
+            Wf[a][3+a] = Wf[3+a][a] = 0.5;
+        double* WfRows[dim];
+        for(int i=0; i<dim; i++)
+            WfRows[i] = Wf[i];
+        double dfree[dim] = {-1., 0.2, -0.1, 0.5, 0.1, 0., -2., 0., 0.3};
+        M.build(WfRows, dim, 3);
+        EXPECT_EQ(M.getNbBlocks(), 5);
+
+        double f[2][dim];
+        m_nlcpSolver->setAllowSliding(true);
+        EXPECT_EQ(m_nlcpSolver->solve(dim, dfree, WfRows, f[0], 0.5, 1e-14, 1000, false), 1);
+        EXPECT_EQ(m_nlcpSolver->solve(dim, dfree, M, f[1], 0.5, 1e-14, 1000, false), 1);
+        for(int i=0; i<dim; i++)
+            EXPECT_NEAR(f[0][i], f[1][i], 1e-12);
+    }
+
+
+    // Test that the recorded steps are read back identical, with and without compression
+    void problemRecorderTest()
+    {
+        setBoundedProblem();
+        sofa::type::vector<double> row = {1., 0.};
+        m_qpSystem->A.push_back(row);
+        m_qpSystem->bu = {2.};
+        m_qpCLists->actuatorRowIds = {0, 1};
+
+        double objective;
+        sofa::type::vector<double> result, dual;
+        solveInverseProblem(objective, result, dual);
+        updateLambda(result);
+        m_qpSystem->previousResult = result;
+
+        const std::string filename = "QPInverseProblemImplTest_record.bin";
+        for(bool compress : {false, true})
+        {
+            QPProblemRecorder recorder;
+            ASSERT_TRUE(recorder.open(filename, compress));
+            for(int i=0; i<3; i++)
+                recorder.record(*m_qpSystem, *m_qpCLists, 0.1*i, objective, i);
+            recorder.close();
+            EXPECT_EQ(recorder.getNbRecordedSteps(), 3u);
+
+            QPProblemReader reader;
+            ASSERT_TRUE(reader.open(filename));
+            ASSERT_EQ(reader.getNbSteps(), 3u);
+
+            QPRecordedStep step;
+            ASSERT_TRUE(reader.readStep(2, step));
+            EXPECT_EQ(step.step, 2u);
+            EXPECT_EQ(step.time, 0.2);
+            EXPECT_EQ(step.iterations, 2);
+            EXPECT_EQ(step.objective, objective);
+            EXPECT_EQ(step.dim, 2u);
+            EXPECT_EQ(step.nbInequalities, 1u);
+            EXPECT_EQ(step.nbEqualities, 0u);
+            EXPECT_EQ(step.Q, sofa::type::vector<double>({1., 0., 0., 1.}));
+            EXPECT_EQ(step.A, row);
+            EXPECT_EQ(step.bu, m_qpSystem->bu);
+            EXPECT_EQ(step.l, m_qpSystem->l);
+            EXPECT_EQ(step.u, m_qpSystem->u);
+            EXPECT_EQ(step.actuatorRowIds, m_qpCLists->actuatorRowIds);
+            EXPECT_EQ(step.result, result);
+            EXPECT_EQ(step.lambda, m_qpSystem->lambda);
+            EXPECT_FALSE(reader.readStep(3, step));
+            reader.close();
+        }
+        std::remove(filename.c_str());
+        m_qpCLists->actuatorRowIds.clear();
+    }
+
+
+    void resultLoggerTest()
+    {
+        m_qpCLists->actuatorRowIds = {0};
+        m_qpCLists->effectorRowIds = {1};
+        m_qpCLists->contactRowIds = {2};
+
+        const std::string filename = "QPInverseProblemImplTest_results.bin";
+        QPResultLogger logger;
+        ASSERT_TRUE(logger.open(filename, 2));
+        for(int i=0; i<3; i++)
+        {
+            const double lambda[3] = {1.*i, 2.*i, 3.*i};
+            const double delta[3] = {-1.*i, -2.*i, -3.*i};
+            const double dfree[3] = {10.+i, 20.+i, 30.+i};
+            logger.log(0.1*i, 3, lambda, delta, dfree, *m_qpCLists);
+        }
+
+        // The rows change, a new chunk is started
+        m_qpCLists->contactRowIds.clear();
+        const double lambda[2] = {7., 8.}, delta[2] = {0., 0.}, dfree[2] = {0., 0.};
+        logger.log(0.3, 2, lambda, delta, dfree, *m_qpCLists);
+        logger.close();
+        EXPECT_EQ(logger.getNbLoggedSteps(), 4u);
+
+        QPResultReader reader;
+        ASSERT_TRUE(reader.open(filename));
+        ASSERT_EQ(reader.getNbChunks(), 3u);
+        EXPECT_EQ(reader.getNbSteps(), 4u);
+
+        QPResultChunk chunk;
+        ASSERT_TRUE(reader.readChunk(0, chunk));
+        ASSERT_EQ(chunk.nbSteps, 2u);
+        ASSERT_EQ(chunk.nbRows, 3u);
+        EXPECT_EQ(chunk.rowKinds, vector<uint8_t>({QPResultLogger::ACTUATOR_ROW, QPResultLogger::EFFECTOR_ROW,
+                                                   QPResultLogger::CONTACT_ROW}));
+        EXPECT_EQ(chunk.steps, vector<uint64_t>({0, 1}));
+        EXPECT_EQ(chunk.times, vector<double>({0., 0.1}));
+        // By column: the series of each row over the steps of the chunk
+        EXPECT_EQ(chunk.lambda, vector<double>({0., 1., 0., 2., 0., 3.}));
+        EXPECT_EQ(chunk.delta, vector<double>({0., -1., 0., -2., 0., -3.}));
+        EXPECT_EQ(chunk.dfree, vector<double>({10., 11., 20., 21., 30., 31.}));
+
+        ASSERT_TRUE(reader.readChunk(1, chunk));
+        EXPECT_EQ(chunk.steps, vector<uint64_t>({2}));
+        ASSERT_TRUE(reader.readChunk(2, chunk));
+        EXPECT_EQ(chunk.nbRows, 2u);
+        EXPECT_EQ(chunk.lambda, vector<double>({7., 8.}));
+        EXPECT_FALSE(reader.readChunk(3, chunk));
+        reader.close();
+
+        std::remove(filename.c_str());
+        m_qpCLists->actuatorRowIds.clear();
+        m_qpCLists->effectorRowIds.clear();
+    }
+
+
+    void problemCaptureTest()
+    {
+        EXPECT_EQ(QPProblemCapture::getDumpName("dir/capture.bin", 3), "dir/capture_3.bin");
+        EXPECT_EQ(QPProblemCapture::getDumpName("dir.d/capture", 0), "dir.d/capture_0");
+        EXPECT_EQ(QPProblemCapture::getEventNames(QPProblemCapture::Infeasible | QPProblemCapture::SolveTime),
+                  "infeasible QP, solve time");
+
+        QPProblemCapture capture;
+        QPProblemCapture::Triggers triggers;
+        triggers.maxNbPivots = 5;
+        triggers.timeBudget = 2.;
+        triggers.maxQNormVariation = 50.;
+        capture.setTriggers(triggers);
+        capture.setWindowSize(3);
+
+        setBoundedProblem();
+        for(int i=0; i<5; i++)
+        {
+            m_qpSystem->Q[1][1] = (i==4)? 10. : 1.;
+            capture.beginStep();
+            capture.capture(*m_qpSystem, *m_qpCLists, 0.1*i, i, i);
+            EXPECT_EQ(capture.getEvents(false, i, 1.), (i==4)? QPProblemCapture::QNormVariation : 0);
+            capture.endStep();
+        }
+        EXPECT_EQ(capture.getEvents(true, 6, 3.), QPProblemCapture::Infeasible | QPProblemCapture::Pivots
+                                                  | QPProblemCapture::SolveTime);
+        EXPECT_EQ(capture.getNbCapturedSteps(), 3u);
+
+        // The dump holds the last problems of the window, which is cleared
+        const std::string filename = "QPInverseProblemImplTest_capture.bin";
+        ASSERT_TRUE(capture.dump(filename, true));
+        EXPECT_EQ(capture.getNbCapturedSteps(), 0u);
+        capture.close();
+
+        QPProblemReader reader;
+        ASSERT_TRUE(reader.open(filename));
+        ASSERT_EQ(reader.getNbSteps(), 3u);
+        QPRecordedStep step;
+        ASSERT_TRUE(reader.readStep(0, step));
+        EXPECT_EQ(step.step, 2u);
+        EXPECT_EQ(step.iterations, 2);
+        ASSERT_TRUE(reader.readStep(2, step));
+        EXPECT_EQ(step.step, 4u);
+        EXPECT_EQ(step.Q, sofa::type::vector<double>({1., 0., 0., 10.}));
+        reader.close();
+        std::remove(filename.c_str());
+    }
+
+
+    // Test that only the rows and columns of the QP variables are cleared while the size of W is unchanged
+    void clearBlocksTest()
+    {
+        QPInverseProblemImpl problem;
+        problem.clear(4);
+        for(int i=0; i<4; i++)
+            for(int j=0; j<4; j++)
+                problem.W[i][j] = 1.;
+        problem.dFree[3] = 1.;
+
+        const vector<bool> isClearedRow = {true, true, false, false};
+        problem.clearBlocks(4, isClearedRow);
+        EXPECT_EQ(problem.W[0][3], 0.);
+        EXPECT_EQ(problem.W[3][1], 0.);
+        EXPECT_EQ(problem.W[2][3], 1.); // not read by the QP, kept
+        EXPECT_EQ(problem.dFree[3], 0.);
+
+        // A new size clears the whole matrix
+        problem.clearBlocks(3, {true, false, false});
+        ASSERT_EQ(problem.getDimension(), 3);
+        EXPECT_EQ(problem.W[2][2], 0.);
+    }
+
+
+    // Test that two groups of contacts without coupling in W are split in two subproblems
+    void problemDecompositionTest()
+    {
+        QPInverseProblemImpl problem;
+        problem.clear(4);
+        for(int i=0; i<4; i++)
+        {
+            problem.W[i][i] = 2.;
+            problem.dFree[i] = -1.-i;
+        }
+        problem.W[0][2] = problem.W[2][0] = 1.;
+        problem.getQPConstraintLists()->contactRowIds = {0, 1, 2, 3};
+
+        QPProblemDecomposition decomposition;
+        ASSERT_EQ(decomposition.compute(&problem, 1), 2u);
+        EXPECT_EQ(decomposition.getComponent(0).rows, vector<unsigned int>({0, 2}));
+        EXPECT_EQ(decomposition.getComponent(1).rows, vector<unsigned int>({1, 3}));
+
+        QPInverseProblemImpl subproblem;
+        decomposition.setSubproblem(0, &problem, &subproblem);
+        ASSERT_EQ(subproblem.getDimension(), 2);
+        EXPECT_EQ(subproblem.W[0][1], 1.);
+        EXPECT_EQ(subproblem.W[1][1], 2.);
+        EXPECT_EQ(subproblem.dFree[1], -3.);
+        EXPECT_EQ(subproblem.getQPConstraintLists()->contactRowIds, vector<unsigned int>({0, 1}));
+
+        subproblem.f[0] = 5.;
+        subproblem.f[1] = 6.;
+        decomposition.mergeResults(0, &subproblem, &problem);
+        EXPECT_EQ(problem.f[0], 5.);
+        EXPECT_EQ(problem.f[2], 6.);
+
+        // Coupled groups are solved as a single problem
+        problem.W[1][2] = 1.;
+        EXPECT_EQ(decomposition.compute(&problem, 1), 1u);
+    }
+
+
+    // Test that a batch of problems of same structure, built without scene, gives the solution of each
+    // problem, sequentially and on the task scheduler
+    void batchSolverTest()
+    {
+        const unsigned int nbProblems = 8;
+        vector<QPInverseProblemImpl> problems(nbProblems);
+        vector<QPInverseProblemImpl*> batch;
+        for(unsigned int k=0; k<nbProblems; k++)
+        {
+            QPInverseProblemImpl& problem = problems[k];
+            problem.clear(2);
+            problem.W[0][0] = problem.W[1][1] = 1. + k; // the stiffness varies between the instances
+            problem.dFree[0] = -1.;
+            problem.dFree[1] = 1.; // no penetration, no force
+            problem.getQPConstraintLists()->contactRowIds = {0, 1};
+            batch.push_back(&problem);
+        }
+
+        sofa::simulation::MainTaskSchedulerFactory::createInRegistry()->init();
+        for(bool multithreading : {false, true})
+        {
+            QPBatchSolver solver;
+            solver.setMultithreading(multithreading);
+            solver.solve(batch);
+            ASSERT_EQ(solver.getObjectives().size(), nbProblems);
+            ASSERT_EQ(solver.getIterations().size(), nbProblems);
+            for(unsigned int k=0; k<nbProblems; k++)
+            {
+                EXPECT_NEAR(problems[k].f[0], 1./(1. + k), 1e-6);
+                EXPECT_NEAR(problems[k].f[1], 0., 1e-6);
+            }
+        }
+    }
+
+
+    // Test that a problem given as matrices, without scene nor components, drives the effector with the
+    // actuator and respects the limits of the actuator
+    void standaloneProblemTest()
+    {
+        typedef QPStandaloneProblem::RowType RowType;
+        QPStandaloneProblem problem;
+        problem.getProblem().setEpsilon(0.);
+        problem.setRows({RowType::Effector, RowType::Actuator});
+        EXPECT_FALSE(problem.setLimits(0, QPStandaloneProblem::RowLimits()));
+
+        Eigen::MatrixXd W(2, 2);
+        W << 1., 1.,
+             1., 2.;
+        Eigen::VectorXd dFree(2), lambda(2), delta(2);
+        dFree << -2., 0.;
+
+        ASSERT_TRUE(problem.solve(W, dFree, lambda, delta));
+        EXPECT_NEAR(lambda[0], 0., 1e-10);
+        EXPECT_NEAR(lambda[1], 2., 1e-8);
+        EXPECT_NEAR(delta[0], 0., 1e-8);
+        EXPECT_NEAR(delta[1], 4., 1e-8);
+
+        QPStandaloneProblem::RowLimits limits;
+        limits.hasLambdaMax = true;
+        limits.lambdaMax = 1.;
+        ASSERT_TRUE(problem.setLimits(1, limits));
+        for(int i=0; i<3; i++) // the same rows, solved again from the kept buffers
+        {
+            ASSERT_TRUE(problem.solve(W, dFree, lambda, delta));
+            EXPECT_NEAR(lambda[1], 1., 1e-8);
+            EXPECT_NEAR(delta[0], -1., 1e-8);
+        }
+    }
+
+
+    // Test that the model-predictive mode applies the first step of the plan: with constant targets and no
+    // coupling it is the single-step solution, the variation weight pulls it from the previous actuation
+    // towards the moving targets, and an active bound is handled by the stacked QP
+    void horizonProblemTest()
+    {
+        typedef QPStandaloneProblem::RowType RowType;
+        QPStandaloneProblem problem;
+        problem.getProblem().setEpsilon(0.);
+        problem.setRows({RowType::Effector, RowType::Actuator});
+
+        Eigen::MatrixXd W(2, 2);
+        W << 1., 1.,
+             1., 2.;
+        Eigen::VectorXd dFree(2), lambda(2), delta(2);
+        dFree << -2., 0.;
+
+        const QPHorizonProblem& horizon = problem.getProblem().getHorizonProblem();
+        problem.getProblem().setHorizon(3, 0., {});
+        ASSERT_TRUE(problem.solve(W, dFree, lambda, delta));
+        EXPECT_FALSE(horizon.isConstrained());
+        EXPECT_NEAR(lambda[1], 2., 1e-8);
+        EXPECT_NEAR(horizon.getPlan()(0, 2), 2., 1e-8);
+
+        // The targets move by 1 at the next steps, from the previous actuation 2:
+        // (3 -1 0; -1 3 -1; 0 -1 2) l = (4 3 3)
+        problem.getProblem().setHorizon(3, 1., {1., 1.});
+        ASSERT_TRUE(problem.solve(W, dFree, lambda, delta));
+        EXPECT_FALSE(horizon.isConstrained());
+        EXPECT_NEAR(lambda[1], 29./13., 1e-8);
+        EXPECT_NEAR(horizon.getPlan()(0, 1), 35./13., 1e-8);
+        EXPECT_NEAR(horizon.getPlan()(0, 2), 37./13., 1e-8);
+        EXPECT_EQ(horizon.getNbFactorizations(), 1u);
+
+        QPStandaloneProblem::RowLimits limits;
+        limits.hasLambdaMax = true;
+        limits.lambdaMax = 1.;
+        ASSERT_TRUE(problem.setLimits(1, limits));
+        ASSERT_TRUE(problem.solve(W, dFree, lambda, delta));
+        EXPECT_TRUE(horizon.isConstrained());
+        EXPECT_NEAR(lambda[1], 1., 1e-8);
+        EXPECT_NEAR(delta[0], -1., 1e-8);
+    }
+
+
+    // Test that the QPs given to qpOASES as compressed matrices, cold and hot started, have the solutions
+    // of the dense ones: three effectors each driven by its own actuator, limited by its displacement
+    void sparseQPTest()
+    {
+        typedef QPStandaloneProblem::RowType RowType;
+        const vector<RowType> rows = {RowType::Effector, RowType::Effector, RowType::Effector,
+                                      RowType::Actuator, RowType::Actuator, RowType::Actuator};
+
+        Eigen::MatrixXd W = Eigen::MatrixXd::Zero(6, 6);
+        for(int i=0; i<3; i++)
+        {
+            W(i, i) = 1.;
+            W(i, 3+i) = W(3+i, i) = 1.;
+            W(3+i, 3+i) = 2.;
+        }
+        Eigen::VectorXd dFree = Eigen::VectorXd::Zero(6);
+        dFree << -1., -2., -3., 0., 0., 0.;
+
+        QPStandaloneProblem::RowLimits limits;
+        limits.hasDeltaMax = true;
+        limits.deltaMax = 2.;
+
+        for(bool hotStart : {false, true})
+        {
+            QPStandaloneProblem dense, sparse;
+            dense.getProblem().setEpsilon(0.);
+            sparse.getProblem().setEpsilon(0.);
+            dense.getProblem().setHotStart(hotStart);
+            sparse.getProblem().setHotStart(hotStart);
+            sparse.getProblem().setSparseQPThreshold(0.5);
+            dense.setRows(rows);
+            sparse.setRows(rows);
+            for(unsigned int i=3; i<6; i++)
+            {
+                dense.setLimits(i, limits);
+                sparse.setLimits(i, limits);
+            }
+
+            Eigen::VectorXd lambda(6), delta(6), sparseLambda(6), sparseDelta(6);
+            for(int step=0; step<3; step++)
+            {
+                dFree(0) = -1.5 + 0.5*step;
+                ASSERT_TRUE(dense.solve(W, dFree, lambda, delta));
+                ASSERT_TRUE(sparse.solve(W, dFree, sparseLambda, sparseDelta));
+                EXPECT_TRUE(sparse.getProblem().getSparseMatrices().isUsed());
+                EXPECT_FALSE(dense.getProblem().getSparseMatrices().isUsed());
+                for(int i=0; i<6; i++)
+                    EXPECT_NEAR(sparseLambda[i], lambda[i], 1e-10);
+            }
+            EXPECT_NEAR(lambda[3], 0.5, 1e-8);
+            EXPECT_NEAR(lambda[4], 1., 1e-8);
+            EXPECT_NEAR(lambda[5], 1., 1e-8);
+        }
+    }
+
+
+    // Test the lower triangle of the Hessian product of the CPU backend, and that an unknown backend is not created
+    void hessianBackendTest()
+    {
+        EXPECT_EQ(QPHessianBackend::create("Unknown"), nullptr);
+
+        std::unique_ptr<QPHessianBackend> backend(QPHessianBackend::create("CPU"));
+        ASSERT_NE(backend.get(), nullptr);
+        EXPECT_EQ(backend->getName(), "CPU");
+
+        // Wea is 3x2, Q is 2x2 and initially filled with garbage
+        const double Wea[6] = {1., 2., 3., 4., 5., 6.};
+        double Q[4] = {7., 7., 7., 7.};
+        backend->computeProduct(3, 2, Wea, Q);
+        EXPECT_DOUBLE_EQ(Q[0], 35.);
+        EXPECT_DOUBLE_EQ(Q[2], 44.);
+        EXPECT_DOUBLE_EQ(Q[3], 56.);
+    }
+
+
+    // Test the parsing of the core lists, and that a thread is pinned to the given cores
+    void threadAffinityTest()
+    {
+        sofa::type::vector<int> cores;
+        EXPECT_TRUE(QPThreadAffinity::parseCoreList("0-3,8,10-11\n", cores));
+        EXPECT_EQ(cores, sofa::type::vector<int>({0, 1, 2, 3, 8, 10, 11}));
+        EXPECT_TRUE(QPThreadAffinity::parseCoreList("", cores));
+        EXPECT_TRUE(cores.empty());
+        EXPECT_FALSE(QPThreadAffinity::parseCoreList("3-1", cores));
+        EXPECT_FALSE(QPThreadAffinity::parseCoreList("0:2", cores));
+
+        QPThreadAffinity affinity;
+        EXPECT_FALSE(affinity.isUsed());
+        EXPECT_TRUE(affinity.pinCurrentThread());
+
+        if(!QPThreadAffinity::isSupported())
+            return;
+
+        // On another thread, to leave the one of the tests free
+        affinity.setCores({0});
+        bool isPinned = false;
+        std::thread thread([&affinity, &isPinned]() { isPinned = affinity.pinCurrentThread() && affinity.pinCurrentThread(); });
+        thread.join();
+        EXPECT_TRUE(isPinned);
+    }
+
+
+    // Test the dedicated task pool, and that the priority is given to the threads of the pool but not to
+    // the thread which set it
+    void taskPoolTest()
+    {
+        QPTaskPool pool;
+        EXPECT_FALSE(pool.isStarted());
+        EXPECT_EQ(pool.getTaskScheduler(), nullptr);
+
+        pool.init(2);
+        ASSERT_TRUE(pool.isStarted());
+        EXPECT_EQ(pool.getThreadCount(), 2u);
+        sofa::simulation::TaskScheduler* scheduler = pool.getTaskScheduler();
+        pool.init(2);
+        EXPECT_EQ(pool.getTaskScheduler(), scheduler);
+        pool.init(3);
+        EXPECT_EQ(pool.getThreadCount(), 3u);
+        pool.stop();
+        EXPECT_FALSE(pool.isStarted());
+        EXPECT_EQ(pool.getThreadCount(), 0u);
+
+        QPThreadAffinity affinity;
+        affinity.setPriority(5);
+        EXPECT_TRUE(affinity.isUsed());
+        EXPECT_EQ(affinity.getPriority(), 5);
+        EXPECT_TRUE(affinity.pinCurrentThread());
+        affinity.setPriority(0);
+        EXPECT_FALSE(affinity.isUsed());
+
+        if(!QPThreadAffinity::isSupported())
+            return;
+
+        // Lowering the priority does not need any privilege
+        affinity.setPriority(5);
+        bool isSet = false;
+        std::thread thread([&affinity, &isSet]() { isSet = affinity.pinCurrentThread(); });
+        thread.join();
+        EXPECT_TRUE(isSet);
+    }
+
+
+    // Test that instances solved at the same time on several threads give the results of a sequential
+    // resolution, with qpOASES problems created, hot started and destroyed concurrently
+    void concurrentInstancesTest()
+    {
+        const unsigned int nbThreads = 8;
+        const unsigned int nbSteps = 200;
+
+        vector<int> nbErrors(nbThreads, 0);
+        vector<std::thread> threads;
+        for(unsigned int t=0; t<nbThreads; t++)
+        {
+            threads.emplace_back([t, &nbErrors]()
+            {
+                ConcurrentProblem problem;
+                problem.setHotStart(t%2 == 0);
+                sofa::type::vector<double> result;
+                for(unsigned int step=0; step<nbSteps; step++)
+                {
+                    const double a = 0.01*(t + step%50);
+                    problem.solveBounded(a, step%3 == 0, result);
+                    if(result.size() != 2 || std::abs(result[0]-a) > 1e-8 || std::abs(result[1]-1.) > 1e-8)
+                        nbErrors[t]++;
+                }
+            });
+        }
+        for(std::thread& thread : threads)
+            thread.join();
+
+        for(unsigned int t=0; t<nbThreads; t++)
+            EXPECT_EQ(nbErrors[t], 0) << "thread " << t;
+    }
+
+
+    // Test that the adaptive limit follows a percentile of the recent counts, and grows back when the
+    // resolutions are stopped by it
+    void adaptiveLimitTest()
+    {
+        QPAdaptiveLimit limit(100, 5);
+        limit.setWindowSize(10);
+        limit.setAdaptive(true, 0.9, 1.);
+        for(int i=1; i<=9; i++)
+            limit.add(i);
+        EXPECT_EQ(limit.getLimit(), 100); // The window is not filled yet
+
+        limit.add(10);
+        EXPECT_EQ(limit.getLimit(), 18); // (1+1)*9
+
+        // Small counts are bounded by the minimum limit
+        for(int i=0; i<10; i++)
+            limit.add(1);
+        EXPECT_EQ(limit.getLimit(), 5);
+
+        // Stopped resolutions record the limit, which doubles every two resolutions
+        for(int i=0; i<4; i++)
+            limit.add(limit.getLimit());
+        EXPECT_EQ(limit.getLimit(), 20);
+
+        limit.setMaxLimit(8);
+        EXPECT_EQ(limit.getLimit(), 8);
+
+        limit.setAdaptive(false, 0.9, 1.);
+        limit.setMaxLimit(100);
+        EXPECT_EQ(limit.getLimit(), 100);
+    }
+
+
+    // Test that two contacts with the same rows of W are merged in the most constraining one,
+    // and that their force is spread back on both of them
+    void contactReductionTest()
+    {
+        clear(3);
+        W[0][0] = W[0][1] = W[1][0] = W[1][1] = 1.;
+        W[2][2] = 1.;
+        dFree[0] = -1.;
+        dFree[1] = -2.;
+        dFree[2] = -1.;
+
+        QPInverseProblem::QPConstraintLists lists;
+        lists.contactRowIds = {0, 1, 2};
+
+        QPContactReduction reduction;
+        ASSERT_EQ(reduction.reduce(&lists, getW(), getDfree(), 1), 1u);
+        EXPECT_EQ(lists.contactRowIds, vector<unsigned int>({1, 2}));
+
+        sofa::type::vector<double> x = {4., 3.};
+        reduction.expand(&lists, x);
+        EXPECT_EQ(lists.contactRowIds, vector<unsigned int>({0, 1, 2}));
+        EXPECT_EQ(x, sofa::type::vector<double>({2., 2., 3.}));
+
+        // The force is kept on the representative
+        reduction.setExpandForces(false);
+        reduction.reduce(&lists, getW(), getDfree(), 1);
+        x = {4., 3.};
+        reduction.expand(&lists, x);
+        EXPECT_EQ(x, sofa::type::vector<double>({0., 4., 3.}));
+
+        // Rows that are not collinear are kept
+        W[1][2] = W[2][1] = 0.5;
+        EXPECT_EQ(reduction.reduce(&lists, getW(), getDfree(), 1), 0u);
+        EXPECT_FALSE(reduction.isReduced());
+        EXPECT_EQ(lists.contactRowIds, vector<unsigned int>({0, 1, 2}));
+    }
+
+
+    // Test that the 4 facets cone is the pyramid |lambda_t| + |lambda_o| <= mu*lambda_n, and that with more
+    // facets, the vertices lie on the Coulomb cone and the sliding facet follows the tangential force
+    void frictionConeTest()
+    {
+        FrictionCone cone;
+        EXPECT_EQ(cone.getNbFacets(), 4u);
+
+        double a_t, a_o;
+        cone.getFacet(0, a_t, a_o);
+        EXPECT_EQ(a_t, 1.);
+        EXPECT_EQ(a_o, 1.);
+        cone.getFacet(2, a_t, a_o);
+        EXPECT_EQ(a_t, -1.);
+        EXPECT_EQ(a_o, -1.);
+        EXPECT_EQ(cone.getFacetId(-1., 1., -0.2, 0.3), 1u);
+        EXPECT_EQ(cone.getGap(1., -0.2, 0.3, 0.5), 0.);
+
+        vector<double> sector_t, sector_o;
+        cone.getSectorRows(3, sector_t, sector_o);
+        EXPECT_TRUE(sector_t.empty());
+
+        cone.setNbFacets(6);
+        EXPECT_EQ(cone.getNbFacets(), 8u);
+
+        // Vertices on the cone, facet centers inside at cos(pi/8)
+        EXPECT_NEAR(cone.getGap(1., 0.5, 0., 0.5), 0., 1e-14);
+        EXPECT_NEAR(cone.getGap(1., 0.5*sqrt(0.5), 0.5*sqrt(0.5), 0.5), 0., 1e-14);
+        EXPECT_NEAR(cone.getGap(1., 0.5*cos(M_PI/8.)*cos(M_PI/8.), 0.5*cos(M_PI/8.)*sin(M_PI/8.), 0.5), 0., 1e-14);
+
+        EXPECT_EQ(cone.getFacetId(1., -1., 0.9, -0.1), 7u);
+        EXPECT_EQ(cone.getFacetId(1., -1., 0.1, -0.9), 6u);
+
+        // The force of facet 1 is kept between the diagonal and the axis o
+        cone.getSectorRows(1, sector_t, sector_o);
+        ASSERT_EQ(sector_t.size(), 1u);
+        EXPECT_LT(sector_t[0]*0.1 + sector_o[0]*0.9, 0.);
+        EXPECT_GT(sector_t[0]*0.9 + sector_o[0]*0.1, 0.);
+    }
+
+
+    // Test that between two pivots, only the constraint rows of the contact that changed state are rebuilt
+    void constraintRowsReuseTest()
+    {
+        vector<double> Wdata = {2., 1., 0.,
+                                1., 2., 1.,
+                                0., 1., 2.};
+        vector<double*> W = {&Wdata[0], &Wdata[3], &Wdata[6]};
+        vector<double> dFree = {-1., -2., -3.};
+
+        QPInverseProblem::QPSystem system;
+        system.W = W.data();
+        system.dFree = dFree.data();
+        system.dim = 3;
+        system.hasBothSideInequalityConstraint = false;
+        QPInverseProblem::QPConstraintLists lists;
+        lists.contactRowIds = {0, 1, 2};
+
+        ConstraintHandler handlers[2]; // With and without reuse
+        for(ConstraintHandler& handler : handlers)
+        {
+            ConstraintHandler::QPConstraintParams* params = handler.getQPConstraintParams();
+            params->contactNbLines = 1;
+            params->nbContactPoints = 3;
+            handler.initContactHandlerList();
+            handler.initContactHandlers();
+        }
+        handlers[0].setReuseConstraintRows(true);
+
+        vector<double> result(3, 0.);
+        for(int pivot=0; pivot<2; pivot++)
+        {
+            QPInverseProblem::QPSystem systems[2] = {system, system};
+            for(int k=0; k<2; k++)
+            {
+                ConstraintHandler::QPConstraintParams* params = handlers[k].getQPConstraintParams();
+                if(pivot==1)
+                    params->contactStates[1] = &params->activeContact;
+                params->constraintsId.clear();
+                handlers[k].buildInequalityConstraintMatrices(result, &systems[k], &lists);
+                handlers[k].buildEqualityConstraintMatrices(result, &systems[k], &lists);
+            }
+
+            ASSERT_EQ(systems[0].A.size(), systems[1].A.size());
+            ASSERT_EQ(systems[0].Aeq.size(), systems[1].Aeq.size());
+            for(unsigned int i=0; i<systems[0].A.size(); i++)
+                for(unsigned int j=0; j<3; j++)
+                    EXPECT_EQ(systems[0].A[i][j], systems[1].A[i][j]);
+            for(unsigned int i=0; i<systems[0].Aeq.size(); i++)
+                for(unsigned int j=0; j<3; j++)
+                    EXPECT_EQ(systems[0].Aeq[i][j], systems[1].Aeq[i][j]);
+            EXPECT_EQ(systems[0].bu, systems[1].bu);
+            EXPECT_EQ(systems[0].beq, systems[1].beq);
+            EXPECT_EQ(handlers[0].getQPConstraintParams()->constraintsId, handlers[1].getQPConstraintParams()->constraintsId);
+        }
+
+        // Three contacts in A and Aeq at the first pivot, then the contact that changed
+        EXPECT_EQ(handlers[0].getNbBuiltConstraintRows(), 8u);
+        EXPECT_EQ(handlers[0].getNbReusedConstraintRows(), 4u);
+        EXPECT_EQ(handlers[1].getNbReusedConstraintRows(), 0u);
+    }
+
+
+    // Test that the fused build of [A; Aeq], their bounds and the bounds of lambda gives the matrices of the
+    // separate builders
+    void fusedConstraintMatricesTest()
+    {
+        vector<double> Wdata = {2., 1., 0.,
+                                1., 2., 1.,
+                                0., 1., 2.};
+        vector<double*> W = {&Wdata[0], &Wdata[3], &Wdata[6]};
+        vector<double> dFree = {-1., -2., -3.};
+
+        QPInverseProblem::QPSystem system;
+        system.W = W.data();
+        system.dFree = dFree.data();
+        system.dim = 3;
+        system.Q.resize(3, 3);
+        system.hasBothSideInequalityConstraint = false;
+        QPInverseProblem::QPConstraintLists lists;
+        lists.actuatorRowIds = {2};
+        lists.contactRowIds = {0, 1};
+        lists.variableRows.resize(3);
+        lists.variableRows[0].hasDeltaMin = true;
+        lists.variableRows[0].hasDeltaMax = true;
+        lists.actuatorBounds.clear(1);
+        lists.actuatorBounds.lambdaMin[0] = -1.;
+        lists.actuatorBounds.deltaMin[0] = -0.5;
+        lists.actuatorBounds.deltaMax[0] = 0.5;
+        lists.hasBothSideActuatorLimits = true;
+
+        ConstraintHandler handlers[2]; // Separate and fused builds
+        QPInverseProblem::QPSystem systems[2] = {system, system};
+        vector<double> result(3, 0.);
+        for(int k=0; k<2; k++)
+        {
+            ConstraintHandler::QPConstraintParams* params = handlers[k].getQPConstraintParams();
+            params->contactNbLines = 1;
+            params->nbContactPoints = 2;
+            handlers[k].initContactHandlerList();
+            params->contactStates = {&params->activeContact, &params->inactiveContact};
+            params->constraintsId.clear();
+            if(k==0)
+            {
+                handlers[k].buildInequalityConstraintMatrices(result, &systems[k], &lists);
+                handlers[k].buildEqualityConstraintMatrices(result, &systems[k], &lists);
+                handlers[k].getConstraintOnLambda(result, &systems[k], &lists);
+            }
+            else
+                handlers[k].buildConstraintMatrices(result, &systems[k], &lists);
+        }
+
+        // Actuator and inactive contact in A, active contact in Aeq
+        ASSERT_EQ(systems[1].A.size(), 2u);
+        ASSERT_EQ(systems[1].Aeq.size(), 1u);
+        EXPECT_EQ(systems[1].A[0][0], 2.); // Row of W of the actuator, on the columns [actuator contacts]
+        EXPECT_EQ(systems[1].A[0][1], 0.);
+        EXPECT_EQ(systems[1].A[0][2], 1.);
+        EXPECT_EQ(systems[1].bu[0], 3.5);
+        EXPECT_EQ(systems[1].bl[0], 2.5);
+        EXPECT_EQ(systems[1].Aeq[0][1], -2.);
+        EXPECT_EQ(systems[1].l, vector<double>({-1., 0., 0.}));
+        EXPECT_EQ(systems[1].u, vector<double>({1e99, 1e99, 0.}));
+
+        ASSERT_EQ(systems[0].A.size(), systems[1].A.size());
+        ASSERT_EQ(systems[0].Aeq.size(), systems[1].Aeq.size());
+        for(unsigned int i=0; i<systems[0].A.size(); i++)
+            for(unsigned int j=0; j<3; j++)
+                EXPECT_EQ(systems[0].A[i][j], systems[1].A[i][j]);
+        for(unsigned int i=0; i<systems[0].Aeq.size(); i++)
+            for(unsigned int j=0; j<3; j++)
+                EXPECT_EQ(systems[0].Aeq[i][j], systems[1].Aeq[i][j]);
+        EXPECT_EQ(systems[0].bl, systems[1].bl);
+        EXPECT_EQ(systems[0].bu, systems[1].bu);
+        EXPECT_EQ(systems[0].beq, systems[1].beq);
+        EXPECT_EQ(systems[0].l, systems[1].l);
+        EXPECT_EQ(systems[0].u, systems[1].u);
+        EXPECT_EQ(handlers[0].getQPConstraintParams()->constraintsId, handlers[1].getQPConstraintParams()->constraintsId);
+    }
+
+
+    // Test that the builders follow the contact model of the parameters: the facets of the friction cone
+    // of a stick contact are only built when sliding is allowed
+    void contactModelTest()
+    {
+        vector<double> Wdata = {2., 1., 0.,
+                                1., 2., 1.,
+                                0., 1., 2.};
+        vector<double*> W = {&Wdata[0], &Wdata[3], &Wdata[6]};
+        vector<double> dFree = {-1., 0.5, 0.5};
+
+        QPInverseProblem::QPSystem system;
+        system.W = W.data();
+        system.dFree = dFree.data();
+        system.dim = 3;
+        system.Q.resize(3, 3);
+        system.hasBothSideInequalityConstraint = false;
+        QPInverseProblem::QPConstraintLists lists;
+        lists.contactRowIds = {0, 1, 2};
+        lists.variableRows.resize(3);
+
+        ConstraintHandler handler;
+        ConstraintHandler::QPConstraintParams* params = handler.getQPConstraintParams();
+        params->mu = 0.;
+        EXPECT_EQ(handler.getContactModel(), ConstraintHandler::Frictionless);
+
+        params->mu = 0.5;
+        params->slidingDirId1 = 1;
+        params->slidingDirId2 = 2;
+        params->contactNbLines = 3;
+        params->nbContactPoints = 1;
+        vector<double> result(3, 0.);
+        for(bool allowSliding : {false, true})
+        {
+            params->allowSliding = allowSliding;
+            EXPECT_EQ(handler.getContactModel(), (allowSliding)? ConstraintHandler::Sliding : ConstraintHandler::FrictionPyramid);
+            handler.initContactHandlerList();
+            params->contactStates = {&params->stickContact};
+            params->constraintsId.clear();
+            QPInverseProblem::QPSystem built = system;
+            handler.buildConstraintMatrices(result, &built, &lists);
+
+            // No relative motion of the contact: delta_n = delta_t = delta_o = 0
+            ASSERT_EQ(built.Aeq.size(), 3u);
+            EXPECT_EQ(built.Aeq[1][1], -2.);
+            EXPECT_EQ(built.beq[1], 0.5);
+
+            // -mu*lambda_n + a_t*lambda_t + a_o*lambda_o <= 0 for each facet
+            ASSERT_EQ(built.A.size(), (allowSliding)? 4u : 0u);
+            for(unsigned int k=0; k<built.A.size(); k++)
+                EXPECT_EQ(built.A[k][0], -0.5);
+            EXPECT_EQ(built.l[0], 0.);
+            EXPECT_EQ(built.u[0], 1e99);
+        }
+    }
+
+
+    // Test the limits of the contact forces: the ones of a single contact that is not inactive are the bounds
+    // of its normal force, the ones of several contacts are a row of A on their normal forces
+    void contactLimitsTest()
+    {
+        // An actuator without limits, an active and an inactive contact
+        vector<double> Wdata = {2., 1., 0.,
+                                1., 2., 1.,
+                                0., 1., 2.};
+        vector<double*> W = {&Wdata[0], &Wdata[3], &Wdata[6]};
+        vector<double> dFree = {-1., -2., -3.};
+
+        QPInverseProblem::QPSystem system;
+        system.W = W.data();
+        system.dFree = dFree.data();
+        system.dim = 3;
+        system.Q.resize(3, 3);
+        system.hasBothSideInequalityConstraint = false;
+        QPInverseProblem::QPConstraintLists lists;
+        lists.actuatorRowIds = {2};
+        lists.contactRowIds = {0, 1};
+        lists.variableRows.resize(3);
+        lists.actuatorBounds.clear(1);
+
+        ConstraintHandler handler;
+        ConstraintHandler::QPConstraintParams* params = handler.getQPConstraintParams();
+        params->contactNbLines = 1;
+        params->nbContactPoints = 2;
+        params->hasMaxContactForces = true;
+        params->maxContactForces = 3.;
+        handler.initContactHandlerList();
+        params->contactStates = {&params->activeContact, &params->inactiveContact};
+
+        vector<double> result(3, 0.);
+        QPInverseProblem::QPSystem built = system;
+        params->constraintsId.clear();
+        handler.buildConstraintMatrices(result, &built, &lists);
+        ASSERT_EQ(built.A.size(), 1u); // inactive contact, no row of the limits
+        EXPECT_EQ(built.l[1], 0.);
+        EXPECT_EQ(built.u[1], 3.);
+        EXPECT_EQ(built.u[2], 0.);
+
+        params->hasMinContactForces = true;
+        params->minContactForces = 1.;
+        built = system;
+        params->constraintsId.clear();
+        handler.buildConstraintMatrices(result, &built, &lists);
+        ASSERT_EQ(built.A.size(), 1u);
+        EXPECT_EQ(built.l[1], 1.);
+        EXPECT_EQ(built.u[1], 3.);
+
+        // An equality row, then two friction contacts: the row of the limits is on the normal forces,
+        // the variables 1 and 4
+        const unsigned int dim = 7;
+        vector<double> frictionWdata(dim*dim, 0.);
+        vector<double*> frictionW(dim);
+        for(unsigned int i=0; i<dim; i++)
+        {
+            frictionW[i] = &frictionWdata[i*dim];
+            frictionW[i][i] = 2.;
+            if(i>0)
+                frictionW[i][i-1] = frictionW[i-1][i] = 0.5;
+        }
+        vector<double> frictionDFree(dim, -1.);
+
+        QPInverseProblem::QPSystem frictionSystem;
+        frictionSystem.W = frictionW.data();
+        frictionSystem.dFree = frictionDFree.data();
+        frictionSystem.dim = dim;
+        frictionSystem.Q.resize(dim, dim);
+        frictionSystem.hasBothSideInequalityConstraint = false;
+        QPInverseProblem::QPConstraintLists frictionLists;
+        frictionLists.equalityRowIds = {6};
+        frictionLists.contactRowIds = {0, 1, 2, 3, 4, 5};
+        frictionLists.variableRows.resize(dim);
+        frictionLists.variableRows[0].nbLines = 1;
+        frictionLists.variableRows[0].hasDeltaEqual = true;
+
+        params->hasMinContactForces = false;
+        params->mu = 0.5;
+        params->slidingDirId1 = 1;
+        params->slidingDirId2 = 2;
+        params->contactNbLines = 3;
+        params->nbContactPoints = 2;
+        for(bool hasMaxContactForces : {true, false})
+        {
+            params->hasMaxContactForces = hasMaxContactForces;
+            params->hasMinContactForces = !hasMaxContactForces;
+            handler.initContactHandlerList();
+            params->contactStates = {&params->stickContact, &params->stickContact};
+            params->constraintsId.clear();
+            vector<double> frictionResult(dim, 0.);
+            built = frictionSystem;
+            handler.buildConstraintMatrices(frictionResult, &built, &frictionLists);
+
+            // No facet without sliding, the row of the limits is the only one of A
+            const double value = (hasMaxContactForces)? 1. : -1.;
+            ASSERT_EQ(built.A.size(), 1u);
+            const vector<double> expectedRow = {0., value, 0., 0., value, 0., 0.};
+            for(unsigned int j=0; j<dim; j++)
+                EXPECT_EQ(built.A[0][j], expectedRow[j]) << "column " << j;
+            ASSERT_EQ(built.bu.size(), 1u);
+            EXPECT_EQ(built.bu[0], (hasMaxContactForces)? 3. : -1.);
+            EXPECT_TRUE(built.bl.empty());
+            ASSERT_FALSE(params->constraintsId.empty());
+            EXPECT_EQ(params->constraintsId[0], 0); // not a row of a variable
+        }
+    }
+
+
+    // Test that the block pivoting changes the states of all the candidates, and falls back to a single
+    // pivot when the number of candidates does not decrease
+    void blockPivotingTest()
+    {
+        clear(3);
+        for(unsigned int i=0; i<3; i++)
+            W[i][i] = 1.;
+        dFree[1] = 1.; // Only the contacts 0 and 2 reach their boundary
+
+        clearProblem();
+        m_qpCLists->contactRowIds = {0, 1, 2};
+        m_qpSystem->dim = 3;
+        m_qpSystem->W = getW();
+        m_qpSystem->dFree = getDfree();
+        m_qpCParams->mu = 0.;
+        m_qpCParams->contactNbLines = 1;
+        m_qpCParams->nbContactPoints = 3;
+        m_qpCParams->constraintsId = {0, 1, 2};
+        m_constraintHandler->initContactHandlerList();
+
+        vector<double> result(3, 0.);
+        vector<double> dual = {1., 2., 3.};
+        ContactHandler* active = &m_qpCParams->activeContact;
+        ContactHandler* inactive = &m_qpCParams->inactiveContact;
+
+        // Single pivot of the most blocking contact
+        setPivoting("Single");
+        m_constraintHandler->initContactHandlers();
+        EXPECT_FALSE(checkAndUpdatePivot(result, dual));
+        EXPECT_EQ(m_qpCParams->contactStates, vector<ContactHandler*>({inactive, inactive, active}));
+
+        // Block pivot, allowed three times without decrease of the number of candidates
+        setPivoting("Block");
+        m_pivotsPerIteration.clear();
+        m_blockBestNbCandidates = std::numeric_limits<int>::max();
+        m_blockNbTrials = 0;
+        for(unsigned int k=0; k<4; k++)
+        {
+            m_constraintHandler->initContactHandlers();
+            EXPECT_FALSE(checkAndUpdatePivot(result, dual));
+            EXPECT_EQ(m_qpCParams->contactStates, vector<ContactHandler*>({active, inactive, active}));
+        }
+        EXPECT_EQ(getNbSinglePivotFallbacks(), 0u);
+
+        m_constraintHandler->initContactHandlers();
+        EXPECT_FALSE(checkAndUpdatePivot(result, dual));
+        EXPECT_EQ(m_qpCParams->contactStates, vector<ContactHandler*>({inactive, inactive, active}));
+        EXPECT_EQ(getNbSinglePivotFallbacks(), 1u);
+        EXPECT_EQ(getPivotsPerIteration(), vector<unsigned int>({2, 2, 2, 2, 1}));
+
+        setPivoting("Single");
+        m_qpCParams->contactStates.clear();
+        m_currentSequence.clear();
+        m_sequence.clear();
+        m_previousSequence.clear();
+        clearProblem();
+    }
+
+
+    // Test that the displacements of the contact rows are dfree + W x, with the variables in the order
+    // actuators then contacts (columns of W not consecutive)
+    void contactDeltasTest()
+    {
+        clear(4);
+        for(unsigned int i=0; i<4; i++)
+        {
+            for(unsigned int j=0; j<4; j++)
+                W[i][j] = 1. + i + 0.5*j;
+            dFree[i] = -1. - i;
+        }
+
+        clearProblem();
+        m_qpCLists->actuatorRowIds = {3};
+        m_qpCLists->contactRowIds = {0, 1, 2};
+        m_qpSystem->dim = 4;
+        m_qpSystem->W = getW();
+        m_qpSystem->dFree = getDfree();
+
+        const vector<double> result = {1., 2., 3., 4.}; // rows 3, 0, 1, 2
+        computeContactDeltas(result);
+        ASSERT_EQ(getContactDeltas().size(), 3u);
+        for(unsigned int c=0; c<3; c++)
+        {
+            const double delta = dFree[c] + W[c][3]*1. + W[c][0]*2. + W[c][1]*3. + W[c][2]*4.;
+            EXPECT_NEAR(getContactDeltas()[c], delta, 1e-12);
+        }
+
+        clearProblem();
+    }
+
+
+    void presolveTest()
+    {
+        setBoundedProblem(); // min 1/2|x|^2 - x0 - x1
+        m_qpSystem->hasBothSideInequalityConstraint = false;
+        sofa::type::vector<double> row = {0., 0.};
+        m_qpSystem->A.push_back(row); // null row 0 <= 1
+        row = {1., 1.};
+        m_qpSystem->A.push_back(row);
+        m_qpSystem->A.push_back(row); // duplicate, the tighter bound is kept
+        m_qpSystem->bu = {1., 3., 1.};
+        m_qpCParams->constraintsId = {0, 1, 2};
+
+        setPresolve(true);
+        double objective;
+        sofa::type::vector<double> result, dual;
+        solveInverseProblem(objective, result, dual);
+        setPresolve(false);
+
+        EXPECT_EQ(getNbPresolvedRows(), 2u);
+        ASSERT_EQ(m_qpSystem->A.size(), 1u);
+        EXPECT_EQ(m_qpSystem->bu.size(), 1u);
+        EXPECT_EQ(m_qpSystem->bu[0], 1.);
+        ASSERT_EQ(m_qpCParams->constraintsId.size(), 1u);
+        EXPECT_EQ(m_qpCParams->constraintsId[0], 1);
+        EXPECT_EQ(dual.size(), 1u);
+
+        ASSERT_EQ(result.size(), 2u);
+        EXPECT_NEAR(result[0], 0.5, 1e-10);
+        EXPECT_NEAR(result[1], 0.5, 1e-10);
+
+        // A row on a fixed variable whose bound holds is constant, a violated one is kept
+        m_qpSystem->l = {-10., 2.};
+        m_qpSystem->u = {10., 2.};
+        m_qpSystem->A.clear();
+        row = {0., 3.};
+        m_qpSystem->A.push_back(row);
+        row = {0., -3.};
+        m_qpSystem->A.push_back(row);
+        m_qpSystem->bu = {7., -7.};
+        vector<int> constraintsId = {0, 1};
+
+        QPPresolve presolve;
+        EXPECT_EQ(presolve.apply(m_qpSystem, constraintsId), 1u);
+        EXPECT_EQ(presolve.getNbConstantRows(), 1u);
+        ASSERT_EQ(m_qpSystem->A.size(), 1u);
+        EXPECT_EQ(m_qpSystem->bu[0], -7.);
+        ASSERT_EQ(constraintsId.size(), 1u);
+        EXPECT_EQ(constraintsId[0], 1);
+    }
+
+
+    void scalingTest()
+    {
+        // Variables of very different magnitudes, x0 + x1 <= 4 is active
+        setBoundedProblem();
+        m_qpSystem->hasBothSideInequalityConstraint = false;
+        m_qpSystem->Q[0][0] = 1e6;
+        m_qpSystem->Q[1][1] = 1e-2;
+        m_qpSystem->c = {-2e6, -3e-2};
+        sofa::type::vector<double> row = {1., 1.};
+        m_qpSystem->A.push_back(row);
+        m_qpSystem->bu = {4.};
+
+        double objective, scaledObjective;
+        sofa::type::vector<double> result, scaledResult, dual, scaledDual;
+        solveInverseProblem(objective, result, dual);
+
+        setScaling(true, 10);
+        solveInverseProblem(scaledObjective, scaledResult, scaledDual);
+        setScaling(false, 10);
+
+        const vector<double>& D = m_scaling.getVariableScaling();
+        ASSERT_EQ(D.size(), 2u);
+        EXPECT_LT(D[0], D[1]);
+
+        ASSERT_EQ(result.size(), scaledResult.size());
+        for(unsigned int i=0; i<result.size(); i++)
+            EXPECT_NEAR(result[i], scaledResult[i], 1e-6);
+        EXPECT_NEAR(objective, scaledObjective, 1e-6*std::abs(objective));
+        ASSERT_EQ(dual.size(), scaledDual.size());
+        for(unsigned int i=0; i<dual.size(); i++)
+            EXPECT_NEAR(dual[i], scaledDual[i], 1e-6*std::max(1., std::abs(dual[i])));
+
+        // The problem given to the solver is unchanged
+        EXPECT_EQ(m_qpSystem->Q[0][0], 1e6);
+        EXPECT_EQ(m_qpSystem->bu[0], 4.);
+    }
+
+
+    void equalityEliminationTest()
+    {
+        // min 1/2|x|^2 - x0 - x1 - x2 s.t. x0 + 2 x1 + x2 = 1 and x0 <= 0.1
+        setBoundedProblem();
+        m_qpSystem->dim = 3;
+        m_qpSystem->Q.resize(3, 3);
+        m_qpSystem->Q.fill(0.);
+        for(unsigned int i=0; i<3; i++)
+            m_qpSystem->Q[i][i] = 1.;
+        m_qpSystem->c = {-1., -1., -1.};
+        m_qpSystem->l = {-10., -1e99, -10.};
+        m_qpSystem->u = {10., 1e99, 10.};
+        m_qpSystem->hasBothSideInequalityConstraint = false;
+        sofa::type::vector<double> row = {1., 0., 0.};
+        m_qpSystem->A.push_back(row);
+        m_qpSystem->bu = {0.1};
+        row = {1., 2., 1.};
+        m_qpSystem->Aeq.push_back(row);
+        m_qpSystem->beq = {1.};
+        m_qpCParams->constraintsId = {0, 1};
+
+        double objective, reducedObjective;
+        sofa::type::vector<double> result, reducedResult, dual, reducedDual;
+        solveInverseProblem(objective, result, dual);
+
+        setEqualityElimination(true);
+        solveInverseProblem(reducedObjective, reducedResult, reducedDual);
+        setEqualityElimination(false);
+        EXPECT_EQ(getNbEqualityEliminations(), 1u);
+
+        // The free variable x1 is the eliminated one
+        EXPECT_EQ(m_equalityElimination.getNbEliminatedVariables(), 1u);
+        EXPECT_EQ(m_equalityElimination.getReducedSystem()->dim, 2u);
+        EXPECT_EQ(m_equalityElimination.getReducedSystem()->A.size(), 1u);
+
+        ASSERT_EQ(result.size(), reducedResult.size());
+        for(unsigned int i=0; i<result.size(); i++)
+            EXPECT_NEAR(result[i], reducedResult[i], 1e-8);
+        EXPECT_NEAR(objective, reducedObjective, 1e-8);
+        ASSERT_EQ(dual.size(), reducedDual.size());
+        for(unsigned int i=0; i<dual.size(); i++)
+            EXPECT_NEAR(dual[i], reducedDual[i], 1e-8);
+
+        // The full QP system is given back
+        EXPECT_EQ(m_qpSystem->dim, 3u);
+        EXPECT_EQ(m_qpSystem->Aeq.size(), 1u);
+        EXPECT_EQ(m_qpCParams->constraintsId.size(), 2u);
+    }
+
+
+    void activeSetCacheTest()
+    {
+        QPActiveSetCache cache;
+        QPActiveSetCache::Entry entry;
+        entry.contactStates = {0};
+        cache.insert({1, 2}, entry);
+        EXPECT_EQ(cache.size(), 0u); // Disabled
+
+        cache.setCapacity(2);
+        cache.insert({1, 2}, entry);
+        entry.contactStates = {1};
+        entry.bounds = {1, 0};
+        entry.constraints[std::make_pair(3, 0)] = 2;
+        cache.insert({3}, entry);
+        EXPECT_EQ(cache.size(), 2u);
+
+        const QPActiveSetCache::Entry* found = cache.find({3});
+        ASSERT_NE(found, nullptr);
+        EXPECT_EQ(found->contactStates[0], 1);
+        EXPECT_EQ(found->bounds.size(), 2u);
+        EXPECT_EQ(found->constraints.at(std::make_pair(3, 0)), 2);
+        EXPECT_EQ(cache.find({1}), nullptr);
+
+        // {1, 2} is now the most recently used, {3} is replaced
+        ASSERT_NE(cache.find({1, 2}), nullptr);
+        entry.contactStates = {2};
+        cache.insert({4}, entry);
+        EXPECT_EQ(cache.size(), 2u);
+        EXPECT_EQ(cache.find({3}), nullptr);
+        ASSERT_NE(cache.find({4}), nullptr);
+        EXPECT_EQ(cache.find({1, 2})->contactStates[0], 0);
+
+        // An existing key is updated in place
+        entry.contactStates = {3};
+        cache.insert({4}, entry);
+        EXPECT_EQ(cache.size(), 2u);
+        EXPECT_EQ(cache.find({4})->contactStates[0], 3);
+
+        cache.setCapacity(1);
+        EXPECT_EQ(cache.size(), 1u);
+        EXPECT_NE(cache.find({4}), nullptr);
+    }
+
+
+    void parametricQPTest()
+    {
+        setBoundedProblem();
+        m_qpSystem->hasBothSideInequalityConstraint = false;
+        m_qpSystem->c = {-2., -1.};
+        sofa::type::vector<double> row = {1., 1.};
+        m_qpSystem->A.push_back(row);
+        m_qpSystem->bu = {2.}; // x0 + x1 <= 2, active
+        m_qpCParams->constraintsId = {0};
+
+        setParametricQP(true, 0.01);
+        double objective;
+        sofa::type::vector<double> result, dual;
+        solveInverseProblem(objective, result, dual);
+        EXPECT_EQ(getNbParametricFactorizations(), 1u);
+        EXPECT_EQ(getNbParametricHotStarts(), 0u);
+        ASSERT_EQ(result.size(), 2u);
+        EXPECT_NEAR(result[0], 1.5, 1e-10);
+        EXPECT_NEAR(result[1], 0.5, 1e-10);
+
+        // Only c changed, the vectors are updated
+        m_qpSystem->c = {-2.2, -1.};
+        solveInverseProblem(objective, result, dual);
+        EXPECT_EQ(getNbParametricFactorizations(), 1u);
+        EXPECT_EQ(getNbParametricHotStarts(), 1u);
+        EXPECT_NEAR(result[0], 1.6, 1e-10);
+        EXPECT_NEAR(result[1], 0.4, 1e-10);
+
+        // Q moved beyond the threshold
+        m_qpSystem->Q[0][0] = 1.5;
+        solveInverseProblem(objective, result, dual);
+        EXPECT_EQ(getNbParametricFactorizations(), 2u);
+        EXPECT_EQ(getNbParametricHotStarts(), 1u);
+
+        setParametricQP(false, 0.01);
+        EXPECT_EQ(m_parametric.problem, nullptr);
+    }
+
+
+    // Violations of the rows of [A; Aeq] computed by the feasibility check
+    void constraintViolationsTest()
+    {
+        setBoundedProblem();
+        m_qpSystem->hasBothSideInequalityConstraint = true;
+        m_qpSystem->A.push_back(vector<double>({1., 1.}));
+        m_qpSystem->A.push_back(vector<double>({1., -1.}));
+        m_qpSystem->bl = {-1., 0.};
+        m_qpSystem->bu = {1., 0.5};
+        m_qpSystem->Aeq.push_back(vector<double>({1., 0.}));
+        m_qpSystem->beq = {0.25};
+
+        EXPECT_FALSE(isFeasible({0.75, 0.5}));
+        const vector<double>& violations = getConstraintViolations();
+        ASSERT_EQ(violations.size(), 3u);
+        EXPECT_NEAR(violations[0], 0.25, 1e-12); // above bu
+        EXPECT_NEAR(violations[1], 0., 1e-12);
+        EXPECT_NEAR(violations[2], 0.5, 1e-12);
+        EXPECT_EQ(m_constraintResiduals.getMaxViolationRow(), 2);
+
+        m_qpSystem->beq = {0.75};
+        m_qpSystem->bu = {1.25, 0.5};
+        EXPECT_TRUE(isFeasible({0.75, 0.5}));
+        EXPECT_EQ(m_constraintResiduals.getMaxViolationRow(), -1);
+
+        EXPECT_FALSE(isFeasible({0., 0.5})); // below bl
+        EXPECT_NEAR(getConstraintViolations()[1], 0.5, 1e-12);
+
+        setBoundedProblem();
+    }
+
+
+    // Production mode: the solution and the constraint lists are only checked when the layout changes
+    void productionModeTest()
+    {
+        setBoundedProblem();
+        EXPECT_FALSE(isLayoutChecked()); // checked at each resolution
+        EXPECT_FALSE(isLayoutChecked());
+
+        setProductionMode(true);
+        EXPECT_FALSE(isLayoutChecked()); // first resolution of the layout
+        EXPECT_TRUE(isLayoutChecked());
+
+        m_qpSystem->Aeq.push_back(vector<double>({1., 0.}));
+        m_qpSystem->beq = {0.25};
+        EXPECT_FALSE(isLayoutChecked());
+        EXPECT_TRUE(isLayoutChecked());
+
+        // Inconsistent lists are not kept as checked
+        m_qpCLists->contactRowIds = {0};
+        m_qpCParams->mu = 0.;
+        EXPECT_TRUE(m_constraintHandler->checkCListsConsistency(m_qpCLists));
+        EXPECT_TRUE(m_constraintHandler->checkCListsConsistency(m_qpCLists));
+        m_qpCLists->contactRowIds.clear();
+        EXPECT_FALSE(m_constraintHandler->checkCListsConsistency(m_qpCLists));
+
+        setProductionMode(false);
+        EXPECT_FALSE(isLayoutChecked());
+        setBoundedProblem();
+    }
+
+
+    void speculativePivotsTest()
+    {
+        // min 1/2 |x|^2 - x0 - x1, for a candidate without constraint and one with x0 + x1 <= 1
+        const double Q[4] = {1., 0., 0., 1.};
+        const double c[2] = {-1., -1.};
+        QPInverseProblem::QPSystem system;
+        system.dim = 2;
+        system.l = {-10., -10.};
+        system.u = {10., 10.};
+
+        sofa::simulation::MainTaskSchedulerFactory::createInRegistry()->init();
+        QPSpeculativePivots pivots;
+        EXPECT_FALSE(pivots.isEnabled());
+        pivots.setMaxNbCandidates(2);
+        EXPECT_TRUE(pivots.isEnabled());
+
+        for(bool multithreading : {false, true})
+        {
+            pivots.setMultithreading(multithreading);
+            pivots.begin(2, Q, c, qpOASES::HST_POSDEF, 100);
+            system.A.clear();
+            pivots.addCandidate(3, system);
+            system.A.push_back(vector<double>({1., 1.}));
+            system.bu = {1.};
+            pivots.addCandidate(5, system);
+            pivots.solve();
+
+            ASSERT_EQ(pivots.getNbCandidates(), 2u);
+            const QPSpeculativePivots::Candidate& free = pivots.getCandidate(0);
+            const QPSpeculativePivots::Candidate& constrained = pivots.getCandidate(1);
+            EXPECT_EQ(free.pivot, 3);
+            EXPECT_EQ(constrained.pivot, 5);
+            ASSERT_TRUE(free.isSolved);
+            ASSERT_TRUE(constrained.isSolved);
+            EXPECT_NEAR(free.x[0], 1., 1e-9);
+            EXPECT_NEAR(free.objective, -1., 1e-9);
+            EXPECT_NEAR(constrained.x[0], 0.5, 1e-9);
+            EXPECT_NEAR(constrained.x[1], 0.5, 1e-9);
+            EXPECT_NEAR(constrained.objective, -0.75, 1e-9);
+        }
+    }
+
+
+    void matrixFreeSolverTest()
+    {
+        // Dense W applied to a vector, an actuator (row 0) and two effectors (rows 1 and 2)
+        struct DenseOperator : public QPMatrixFreeSolver::Operator
+        {
+            vector<double> W = {2., 1., 0.,
+                                1., 2., 1.,
+                                0., 1., 2.};
+            bool isAvailable{true};
+            bool apply(const vector<double>& f, vector<double>& d) override
+            {
+                if(!isAvailable)
+                    return false;
+                d.assign(3, 0.);
+                for(unsigned int i=0; i<3; i++)
+                    for(unsigned int j=0; j<3; j++)
+                        d[i] += W[i*3+j]*f[j];
+                return true;
+            }
+        } W;
+        const double dFree[3] = {0., -1., -1.};
+
+        QPInverseProblem::QPConstraintLists lists;
+        lists.actuatorRowIds = {0};
+        lists.effectorRowIds = {1, 2};
+        lists.variableRows.resize(1);
+        lists.variableRows[0].hasDeltaMax = true;
+        lists.actuatorBounds.clear(1);
+        lists.actuatorBounds.lambdaMin[0] = 0.;
+        lists.actuatorBounds.deltaMax[0] = 0.5;
+        EXPECT_TRUE(QPMatrixFreeSolver::isSupported(lists, false));
+
+        // Without limit lambda = 1, the stroke 2 lambda is limited to 0.5
+        QPMatrixFreeSolver solver;
+        solver.setTolerances(1e-8, 1e-8);
+        vector<double> x, Wx;
+        double objective;
+        ASSERT_TRUE(solver.solve(W, lists, dFree, 3, 0., x, Wx, objective));
+        ASSERT_EQ(x.size(), 1u);
+        ASSERT_EQ(Wx.size(), 3u);
+        EXPECT_NEAR(x[0], 0.25, 1e-6);
+        EXPECT_NEAR(dFree[0] + Wx[0], 0.5, 1e-6);
+        EXPECT_NEAR(Wx[1], 0.25, 1e-6);
+        EXPECT_NEAR(objective, -0.21875, 1e-6);
+        EXPECT_GT(solver.getNbIterations(), 0);
+        EXPECT_GT(solver.getNbApplications(), 0u);
+
+        // A failing product stops the resolution
+        W.isAvailable = false;
+        EXPECT_FALSE(solver.solve(W, lists, dFree, 3, 0., x, Wx, objective));
+
+        // The contacts are left to the dense resolution
+        lists.contactRowIds = {2};
+        EXPECT_FALSE(QPMatrixFreeSolver::isSupported(lists, false));
+    }
+
+
+    void lazyContactComplianceTest()
+    {
+        // An actuator (row 0) and three contacts, the last two lazy
+        sofa::linearalgebra::FullMatrix<double> W(4, 4);
+        W.clear();
+        const sofa::type::vector<int> lazyContactOfRow = {-1, -1, 1, 2};
+        QPComplianceMatrix deferredW(&W, nullptr);
+        deferredW.setLazyContacts(&lazyContactOfRow, false);
+        for(unsigned int i=0; i<4; i++)
+            for(unsigned int j=0; j<4; j++)
+                deferredW.add(i, j, 1.);
+
+        // Only the entries between the two lazy contacts are deferred
+        EXPECT_EQ(W.element(2, 3), 0.);
+        EXPECT_EQ(W.element(3, 2), 0.);
+        EXPECT_EQ(W.element(2, 2), 1.);
+        EXPECT_EQ(W.element(3, 3), 1.);
+        EXPECT_EQ(W.element(0, 3), 1.);
+        EXPECT_EQ(W.element(1, 2), 1.);
+
+        // The completion pass only adds them
+        QPComplianceMatrix completionW(&W, nullptr);
+        completionW.setLazyContacts(&lazyContactOfRow, true);
+        for(unsigned int i=0; i<4; i++)
+            for(unsigned int j=0; j<4; j++)
+                completionW.add(i, j, 1.);
+        for(unsigned int i=0; i<4; i++)
+            for(unsigned int j=0; j<4; j++)
+                EXPECT_EQ(W.element(i, j), 1.);
+    }
+
+
+    void symmetricComplianceTest()
+    {
+        // Larger than a tile of mirrorUpperTriangle
+        const unsigned int dim = 150;
+        sofa::linearalgebra::LPtrFullMatrix<SReal> W;
+        W.resize(dim, dim);
+        W.clear();
+        QPComplianceMatrix upperW(&W, nullptr);
+        upperW.setUpperTriangle(true);
+        for(unsigned int i=0; i<dim; i++)
+            for(unsigned int j=0; j<dim; j++)
+                upperW.add(i, j, 1. + i*j + i + j);
+
+        // The entries below the diagonal are dropped, then copied from the upper triangle
+        EXPECT_EQ(W.element(3, 2), 0.);
+        EXPECT_EQ(W.element(2, 3), 12.);
+        EXPECT_EQ(W.element(2, 2), 9.);
+        QPComplianceMatrix::mirrorUpperTriangle(W);
+        for(unsigned int i=0; i<dim; i++)
+            for(unsigned int j=0; j<dim; j++)
+                ASSERT_EQ(W.element(i, j), 1. + i*j + i + j);
+    }
+
+
+    // Duals of the last QP and active limits of the actuators, exported for a sensitivity analysis
+    void exportDualsTest()
+    {
+        setBoundedProblem();
+        m_qpSystem->u = {0.5, 10.}; // x0 <= 0.5, active
+        m_qpCParams->constraintsId.clear();
+
+        setExportDuals(true);
+        double objective;
+        sofa::type::vector<double> result, dual;
+        solveInverseProblem(objective, result, dual);
+        ASSERT_EQ(result.size(), 2u);
+        EXPECT_NEAR(result[0], 0.5, 1e-10);
+        ASSERT_EQ(getBoundDuals().size(), 2u);
+        EXPECT_NEAR(getBoundDuals()[0], -0.5, 1e-10); // upper bound of x0 active
+        EXPECT_NEAR(getBoundDuals()[1], 0., 1e-10);
+        EXPECT_TRUE(getConstraintDuals().empty());
+
+        m_qpCLists->actuatorRowIds = {0, 1};
+        m_qpCLists->actuatorBounds.clear(2);
+        m_qpCLists->actuatorBounds.lambdaMax[0] = 0.5;
+        m_qpCLists->actuatorBounds.deltaMin = {-1., 0.};
+        m_qpSystem->lambda = {0.5, 1.};
+        m_qpSystem->delta = {0.2, 0.};
+        updateActuatorLimits();
+        ASSERT_EQ(getActuatorActiveLimits().size(), 2u);
+        EXPECT_EQ(getActuatorActiveLimits()[0], (int)LambdaMax);
+        EXPECT_EQ(getActuatorActiveLimits()[1], (int)DeltaMin);
+        EXPECT_NEAR(getActuatorBoundDuals()[0], -0.5, 1e-10);
+        EXPECT_NEAR(getActuatorBoundDuals()[1], 0., 1e-10);
+
+        setExportDuals(false);
+        m_qpCLists->actuatorRowIds.clear();
+        m_qpCLists->actuatorBounds.clear(0);
+        setBoundedProblem();
+    }
+
+
+    // Warm-start state written to a checkpoint, and restored at the next call to solve()
+    void checkpointTest()
+    {
+        m_qpCLists->actuatorRowIds = {0, 1};
+        m_qpSystem->dim = 2;
+        m_qpSystem->lambda = {0.5, -1.};
+        m_activeBounds = {1};
+        m_activeSetCache.setCapacity(2);
+        QPActiveSetCache::Entry entry;
+        entry.contactStates = {1};
+        entry.x = {0.5, -1.};
+        entry.bounds = {0, 1};
+        entry.constraints[std::make_pair(2, 0)] = 1;
+        m_activeSetCache.insert({7, 8}, entry);
+
+        QPCheckpoint checkpoint;
+        saveCheckpoint(checkpoint);
+        EXPECT_EQ(checkpoint.actuatorRowIds, m_qpCLists->actuatorRowIds);
+        EXPECT_EQ(checkpoint.lambda, m_qpSystem->lambda);
+        EXPECT_EQ(checkpoint.activeSets.size(), 1u);
+        checkpoint.contactStates.push_back({"/root/contact", 3, "Stick"});
+        checkpoint.complianceBlocks.resize(2);
+        checkpoint.complianceBlocks[1].constraintCorrection = "/root/constraintCorrection";
+        checkpoint.complianceBlocks[1].dt = 0.01;
+        checkpoint.complianceBlocks[1].jacobian = {{0, 1, 2., true}};
+        checkpoint.complianceBlocks[1].compliance = {{0, 0, 0.5, false}, {0, 1, 0.25, true}};
+
+        const std::string filename = "QPInverseProblemImplTest_checkpoint.bin";
+        ASSERT_TRUE(checkpoint.write(filename));
+        QPCheckpoint read;
+        ASSERT_TRUE(read.read(filename));
+        EXPECT_EQ(read.actuatorRowIds, checkpoint.actuatorRowIds);
+        EXPECT_EQ(read.lambda, checkpoint.lambda);
+        EXPECT_EQ(read.activeBounds, sofa::type::vector<int>({1}));
+        ASSERT_EQ(read.contactStates.size(), 1u);
+        EXPECT_EQ(read.contactStates[0].constraint, "/root/contact");
+        EXPECT_EQ(read.contactStates[0].id, 3);
+        EXPECT_EQ(read.contactStates[0].state, "Stick");
+        ASSERT_EQ(read.activeSets.size(), 1u);
+        EXPECT_EQ(read.activeSets.front().first, QPActiveSetCache::Key({7, 8}));
+        EXPECT_EQ(read.activeSets.front().second.x, entry.x);
+        EXPECT_EQ(read.activeSets.front().second.bounds, entry.bounds);
+        EXPECT_EQ(read.activeSets.front().second.constraints, entry.constraints);
+        ASSERT_EQ(read.complianceBlocks.size(), 2u);
+        EXPECT_TRUE(read.complianceBlocks[0].constraintCorrection.empty());
+        EXPECT_EQ(read.complianceBlocks[1].dt, 0.01);
+        EXPECT_EQ(read.complianceBlocks[1].jacobian, checkpoint.complianceBlocks[1].jacobian);
+        EXPECT_EQ(read.complianceBlocks[1].compliance, checkpoint.complianceBlocks[1].compliance);
+
+        // A corrupted checkpoint is rejected
+        {
+            std::fstream file(filename, std::ios::binary | std::ios::in | std::ios::out);
+            file.seekp(-1, std::ios::end);
+            file.put('x');
+        }
+        EXPECT_FALSE(read.read(filename));
+        EXPECT_TRUE(read.isEmpty());
+        std::remove(filename.c_str());
+        EXPECT_FALSE(read.read(filename));
+
+        // Restored at the next call to solve(), in the same rows only
+        m_activeSetCache.clear();
+        m_activeBounds.clear();
+        m_qpSystem->lambda = {0., 0.};
+        m_step = 1;
+        restoreCheckpoint(checkpoint);
+        EXPECT_EQ(m_activeSetCache.size(), 0u);
+        applyRestoredState();
+        EXPECT_EQ(m_qpSystem->lambda, sofa::type::vector<double>({0.5, -1.}));
+        EXPECT_EQ(m_activeBounds, sofa::type::vector<int>({1}));
+        EXPECT_NE(m_activeSetCache.find({7, 8}), nullptr);
+        EXPECT_EQ(m_restoredState.contactStates.size(), 1u); // until the contacts are found
+        EXPECT_FALSE(m_restoredState.isPending);
+
+        restoreCheckpoint(checkpoint);
+        m_qpCLists->actuatorRowIds = {0, 2};
+        m_qpSystem->lambda = {0., 0.};
+        applyRestoredState();
+        EXPECT_EQ(m_qpSystem->lambda, sofa::type::vector<double>({0., 0.}));
+
+        m_restoredState.clear();
+        m_activeSetCache.setCapacity(0);
+        m_activeBounds.clear();
+        m_qpCLists->actuatorRowIds.clear();
+        m_qpSystem->lambda.clear();
+        m_step = 0;
+    }
+
+
+    // Test that the counters unavailable (no allocation hook preloaded, perf_event not allowed) stay to 0,
+    // and that the allocations are counted when the hook is preloaded
+    void perfCountersTest()
+    {
+        QPPerfCounters counters;
+        EXPECT_EQ(counters.open(), counters.hasAllocationCounts() || counters.hasHardwareCounts());
+        EXPECT_EQ(QPPerfCounters::getName(QPPerfCounters::CacheMisses), "cache misses");
+
+        QPPerfCounters::Values start, end;
+        counters.read(start);
+        std::unique_ptr<vector<double>> values(new vector<double>(100));
+        counters.read(end);
+        for(unsigned int i=0; i<QPPerfCounters::NbCounters; i++)
+            if(!counters.isAvailable(QPPerfCounters::Counter(i)))
+                EXPECT_EQ(end.counts[i], 0u);
+        if(counters.hasAllocationCounts())
+        {
+            EXPECT_GE(end.counts[QPPerfCounters::Allocations] - start.counts[QPPerfCounters::Allocations], 2u);
+            EXPECT_GE(end.counts[QPPerfCounters::AllocatedBytes] - start.counts[QPPerfCounters::AllocatedBytes], 800u);
+        }
+
+        counters.close();
+        EXPECT_FALSE(counters.isOpen());
+        counters.read(end);
+        EXPECT_EQ(end.counts[QPPerfCounters::Cycles], 0u);
+    }
+
+
+    void telemetryStreamTest()
+    {
+#if defined(__unix__) || defined(__APPLE__)
+        QPTelemetryStream writer;
+        EXPECT_FALSE(writer.open("", 4, 2));
+        ASSERT_TRUE(writer.open("softrobotsinverse_telemetry_test", 4, 2));
+
+        QPTelemetryStream reader;
+        ASSERT_TRUE(reader.attach("/softrobotsinverse_telemetry_test"));
+        EXPECT_EQ(reader.getCapacity(), 4u);
+        EXPECT_EQ(reader.getMaxNbRows(), 2u);
+
+        QPTelemetryStream::Sample sample, read;
+        EXPECT_FALSE(reader.read(0, read));
+        for(unsigned int n=0; n<6; n++)
+        {
+            sample.step = n;
+            sample.objective = 2.*n;
+            sample.iterations = n+1;
+            sample.deltaNorms[QPTelemetryStream::ContactDeltaNorm] = n;
+            sample.entries[QPTelemetry::NbContacts] = n;
+            sample.entries[QPTelemetry::PivotLimit] = std::numeric_limits<double>::quiet_NaN();
+            sample.phaseTimes[QPTelemetryStream::SolvePhase] = 0.5*n;
+            sample.lambda.assign(n, -1.*n);
+            writer.write(sample);
+        }
+        EXPECT_EQ(reader.getWriteCount(), 6u);
+
+        // The ring keeps the last capacity records
+        EXPECT_FALSE(reader.read(1, read));
+        EXPECT_FALSE(reader.read(6, read));
+        for(unsigned int n=2; n<6; n++)
+        {
+            ASSERT_TRUE(reader.read(n, read));
+            EXPECT_EQ(read.step, n);
+            EXPECT_EQ(read.objective, 2.*n);
+            EXPECT_EQ(read.iterations, int(n+1));
+            EXPECT_EQ(read.deltaNorms[QPTelemetryStream::ContactDeltaNorm], n);
+            EXPECT_EQ(read.entries[QPTelemetry::NbContacts], n);
+            EXPECT_TRUE(std::isnan(read.entries[QPTelemetry::PivotLimit]));
+            EXPECT_EQ(read.phaseTimes[QPTelemetryStream::SolvePhase], 0.5*n);
+            EXPECT_EQ(read.lambda, sofa::type::vector<double>(std::min(n, 2u), -1.*n)); // up to maxNbRows
+        }
+
+        // The object is removed by its writer, the readers keep their mapping
+        writer.close();
+        QPTelemetryStream other;
+        EXPECT_FALSE(other.attach("softrobotsinverse_telemetry_test"));
+        EXPECT_TRUE(reader.read(5, read));
+#endif
+    }
+
+
+    void qpMatrixViewTest()
+    {
+        setBoundedProblem();
+        sofa::type::vector<double> row = {1., 2.};
+        m_qpSystem->A.push_back(row);
+        row = {3., 4.};
+        m_qpSystem->A.push_back(row);
+
+        EXPECT_EQ(m_qpSystem->A.size(), 2u);
+        EXPECT_EQ(m_qpSystem->A[1][0], 3.);
+
+        // The accessors are views on the QP system, not copies
+        auto A = getQPMatrixA();
+        EXPECT_EQ(A.rows(), 2);
+        EXPECT_EQ(A.cols(), 2);
+        EXPECT_EQ(A(0,1), 2.);
+        EXPECT_EQ(A.data(), m_qpSystem->A.data());
+        EXPECT_EQ(getQPMatriceQ().data(), m_qpSystem->Q.data());
+
+        m_qpSystem->A.clear();
+        EXPECT_TRUE(m_qpSystem->A.empty());
+    }
+
+
+    void rowBlocksTest()
+    {
+        // An effector of 3 rows, an actuator of 2 rows and a contact, interleaved
+        sofa::type::vector<unsigned int> rowIds = {4, 5, 0, 1, 2, 7};
+        sofa::type::vector<QPRowBlock> blocks;
+        getRowBlocks(rowIds, blocks);
+
+        ASSERT_EQ(blocks.size(), 3u);
+        EXPECT_EQ(blocks[0].first, 4u);
+        EXPECT_EQ(blocks[0].size, 2u);
+        EXPECT_EQ(blocks[0].offset, 0u);
+        EXPECT_EQ(blocks[1].first, 0u);
+        EXPECT_EQ(blocks[1].size, 3u);
+        EXPECT_EQ(blocks[1].offset, 2u);
+        EXPECT_EQ(blocks[2].first, 7u);
+        EXPECT_EQ(blocks[2].size, 1u);
+        EXPECT_EQ(blocks[2].offset, 5u);
+
+        getRowBlocks(sofa::type::vector<unsigned int>(), blocks);
+        EXPECT_TRUE(blocks.empty());
+    }
+
+
+    // Test the metadata of the QP variables read from the constraint components
+    void variableRowsTest()
+    {
+        sofa::core::sptr<LimitedCableActuator> actuators[2] = {sofa::core::objectmodel::New<LimitedCableActuator>(),
+                                                               sofa::core::objectmodel::New<LimitedCableActuator>()};
+        actuators[0]->setForceLimits(0., 10.);
+
+        clearProblem();
+        m_qpCLists->actuators = {actuators[0].get(), actuators[1].get()};
+        m_qpCLists->actuatorRowIds = {0, 1};
+        m_qpCLists->contactRowIds = {2};
+        m_qpCLists->updateVariableRows();
+
+        const sofa::type::vector<QPVariableRow>& rows = m_qpCLists->variableRows;
+        ASSERT_EQ(rows.size(), 3u);
+        EXPECT_EQ(rows[0].owner, actuators[0].get());
+        EXPECT_EQ(rows[1].owner, actuators[1].get());
+        EXPECT_EQ(rows[2].owner, nullptr);
+        EXPECT_EQ(rows[0].nbLines, 1u);
+        EXPECT_TRUE(rows[0].hasLambdaMin && rows[0].hasLambdaMax);
+        EXPECT_EQ(rows[0].lambdaMax, 10.);
+        EXPECT_FALSE(rows[1].hasLambdaMin || rows[1].hasLambdaMax);
+        EXPECT_TRUE(m_qpCLists->hasBothSideActuatorLimits);
+
+        // The bounds of the actuators are gathered in one slot per actuator row, infinite when missing
+        const QPActuatorBounds& bounds = m_qpCLists->actuatorBounds;
+        ASSERT_EQ(bounds.lambdaMax.size(), 2u);
+        EXPECT_EQ(bounds.lambdaMin[0], 0.);
+        EXPECT_EQ(bounds.lambdaMax[0], 10.);
+        EXPECT_EQ(bounds.lambdaMin[1], -1e99);
+        EXPECT_EQ(bounds.lambdaMax[1], 1e99);
+        EXPECT_EQ(bounds.deltaMin[0], -1e99);
+        EXPECT_EQ(bounds.deltaMax[1], 1e99);
+
+        // The bounds on lambda are read from the table
+        m_qpSystem->dim = 2;
+        m_qpSystem->Q.resize(2, 2);
+        m_qpCLists->contactRowIds.clear();
+        m_qpCLists->updateVariableRows();
+        m_constraintHandler->getConstraintOnLambda(vector<double>(2, 0.), m_qpSystem, m_qpCLists);
+        EXPECT_EQ(m_qpSystem->l[0], 0.);
+        EXPECT_EQ(m_qpSystem->u[0], 10.);
+        EXPECT_EQ(m_qpSystem->l[1], -1e99);
+        EXPECT_EQ(m_qpSystem->u[1], 1e99);
+
+        clearProblem();
+        EXPECT_TRUE(m_qpCLists->variableRows.empty());
+        EXPECT_TRUE(m_qpCLists->actuatorBounds.lambdaMax.empty());
+        EXPECT_FALSE(m_qpCLists->hasBothSideActuatorLimits);
+    }
+
+
+    // Two actuators and two effectors, on a compliance W given row by row
+    void setActuatorsAndEffectorsProblem(const double Wdata[4][4])
+    {
+        for(sofa::core::sptr<LimitedCableActuator>& actuator : m_actuators)
+            if(!actuator)
+                actuator = sofa::core::objectmodel::New<LimitedCableActuator>();
+
+        clear(4);
+        for(unsigned int i=0; i<4; i++)
+            for(unsigned int j=0; j<4; j++)
+                W[i][j] = Wdata[i][j];
+
+        clearProblem();
+        m_qpCLists->actuators = {m_actuators[0].get(), m_actuators[1].get()};
+        m_qpCLists->actuatorRowIds = {0, 1};
+        m_qpCLists->effectorRowIds = {2, 3};
+        m_qpCLists->updateVariableRows();
+        m_qpSystem->dim = 2;
+        m_qpSystem->W = getW();
+        m_qpSystem->dFree = getDfree();
+    }
+
+
+    // Test that Q, assembled on its lower triangle and mirrored, is Wea^T*Wea + eps*weight*Waa
+    void symmetricQTest()
+    {
+        const double Wdata[4][4] = {{2., 1., 0.5, 0.},
+                                    {1., 3., 1., 0.5},
+                                    {0.5, 1., 2., 0.},
+                                    {0., 0.5, 0., 1.}};
+        setActuatorsAndEffectorsProblem(Wdata);
+        setEpsilon(1e-3);
+
+        buildQPMatrices();
+
+        const double Qe[2][2] = {{0.25, 0.5},
+                                 {0.5, 1.25}}; // Wea^T*Wea
+        double weight = 1.75/4.; // ||Q||/||Waa||
+        for(unsigned int k=0; k<2; k++)
+            for(unsigned int j=0; j<2; j++)
+            {
+                EXPECT_NEAR(m_qpSystem->Q[k][j], Qe[k][j] + 1e-3*weight*Wdata[k][j], 1e-12);
+                EXPECT_EQ(m_qpSystem->Q[k][j], m_qpSystem->Q[j][k]);
+            }
+        EXPECT_EQ(m_hessianType, qpOASES::HST_POSDEF);
+
+        // Without energy, qpOASES determines the type of the Hessian
+        setEpsilon(0.);
+        buildQPMatrices();
+        EXPECT_EQ(m_qpSystem->Q[0][1], 0.5);
+        EXPECT_EQ(m_hessianType, qpOASES::HST_UNKNOWN);
+
+        clearProblem();
+    }
+
+
+    // Test that Q is reused while W does not change, and rebuilt when it does
+    void hessianReuseTest()
+    {
+        double Wdata[4][4] = {{2., 1., 0.5, 0.},
+                              {1., 3., 1., 0.5},
+                              {0.5, 1., 2., 0.},
+                              {0., 0.5, 0., 1.}};
+        setEpsilon(1e-3);
+        setReuseHessian(true);
+
+        setActuatorsAndEffectorsProblem(Wdata);
+        buildQPMatrices();
+        vector<double> Q(m_qpSystem->Q.data(), m_qpSystem->Q.data()+4);
+        EXPECT_EQ(getNbHessianReuses(), 0u);
+
+        // Same compliance at the next step, only the effectors dfree changed
+        setActuatorsAndEffectorsProblem(Wdata);
+        dFree[2] = 1.;
+        dFree[3] = 0.;
+        buildQPMatrices();
+        EXPECT_EQ(getNbHessianReuses(), 1u);
+        EXPECT_EQ(vector<double>(m_qpSystem->Q.data(), m_qpSystem->Q.data()+4), Q);
+        EXPECT_EQ(m_qpSystem->c[0], 0.5);
+        EXPECT_EQ(m_qpSystem->c[1], 1.);
+        EXPECT_EQ(m_hessianType, qpOASES::HST_POSDEF);
+
+        // A change in W_energy only
+        Wdata[0][0] = 4.;
+        setActuatorsAndEffectorsProblem(Wdata);
+        buildQPMatrices();
+        EXPECT_EQ(getNbHessianReuses(), 1u);
+        EXPECT_NE(m_qpSystem->Q[0][0], Q[0]);
+
+        setReuseHessian(false);
+        setEpsilon(0.);
+        clearProblem();
+    }
+
+
+    // Test that Q = Wea^T*S*Wea and c = Wea^T*S*dfree_e with the weights S of the effectors
+    void effectorWeightsTest()
+    {
+        const double Wdata[4][4] = {{2., 1., 0.5, 0.},
+                                    {1., 3., 1., 0.5},
+                                    {0.5, 1., 2., 0.},
+                                    {0., 0.5, 0., 1.}};
+        sofa::core::sptr<LimitedCableActuator> effector = sofa::core::objectmodel::New<LimitedCableActuator>();
+        sofa::core::sptr<WeightedCableEffector> weightedEffector = sofa::core::objectmodel::New<WeightedCableEffector>();
+        weightedEffector->m_weight = 4.;
+
+        setEpsilon(0.);
+        setActuatorsAndEffectorsProblem(Wdata);
+        m_qpCLists->effectors = {effector.get(), weightedEffector.get()};
+        m_qpCLists->updateVariableRows();
+        dFree[2] = 1.;
+        dFree[3] = 2.;
+
+        // A diagonal weight on the second effector row
+        ASSERT_EQ(m_qpCLists->effectorWeightBlocks.size(), 1u);
+        EXPECT_EQ(m_qpCLists->effectorWeightBlocks[0].first, 1u);
+        buildQPMatrices();
+        EXPECT_NEAR(m_qpSystem->Q[0][0], 0.25, 1e-12);
+        EXPECT_NEAR(m_qpSystem->Q[0][1], 0.5, 1e-12);
+        EXPECT_NEAR(m_qpSystem->Q[1][1], 2., 1e-12);
+        EXPECT_NEAR(m_qpSystem->c[0], 0.5, 1e-12);
+        EXPECT_NEAR(m_qpSystem->c[1], 5., 1e-12);
+        EXPECT_NEAR(getEffectorsFreeObjective(), 17., 1e-12);
+
+        // A full block on the two effector rows, S = (2 1; 1 2)
+        m_qpCLists->effectorWeightBlocks = {{0, 2, 0}};
+        m_qpCLists->effectorWeights = {2., 1., 1., 2.};
+        buildQPMatrices();
+        EXPECT_NEAR(m_qpSystem->Q[0][0], 0.5, 1e-12);
+        EXPECT_NEAR(m_qpSystem->Q[0][1], 1.25, 1e-12);
+        EXPECT_NEAR(m_qpSystem->Q[1][0], 1.25, 1e-12);
+        EXPECT_NEAR(m_qpSystem->Q[1][1], 3.5, 1e-12);
+        EXPECT_NEAR(m_qpSystem->c[0], 2., 1e-12);
+        EXPECT_NEAR(m_qpSystem->c[1], 6.5, 1e-12);
+        EXPECT_NEAR(getEffectorsFreeObjective(), 14., 1e-12);
+
+        clearProblem();
+        EXPECT_TRUE(m_qpCLists->effectorWeightBlocks.empty());
+    }
+
+
+    // Test that the disabled actuators and effectors keep their rows, with no influence on the QP
+    void disabledConstraintsTest()
+    {
+        const double Wdata[4][4] = {{2., 1., 0.5, 0.},
+                                    {1., 3., 1., 0.5},
+                                    {0.5, 1., 2., 0.},
+                                    {0., 0.5, 0., 1.}};
+        // One-line components standing for the two effectors, only their number of lines is read
+        sofa::core::sptr<LimitedCableActuator> effectors[2] = {sofa::core::objectmodel::New<LimitedCableActuator>(),
+                                                               sofa::core::objectmodel::New<LimitedCableActuator>()};
+        setEpsilon(0.);
+        setActuatorsAndEffectorsProblem(Wdata);
+        m_qpCLists->effectors = {effectors[0].get(), effectors[1].get()};
+        m_qpCLists->disabledConstraints = {m_actuators[1].get(), effectors[1].get()};
+        m_qpCLists->updateVariableRows();
+        dFree[2] = 1.;
+        dFree[3] = 2.;
+
+        // Same layout, the variable of the disabled actuator is fixed to zero
+        ASSERT_EQ(m_qpCLists->variableRows.size(), 2u);
+        EXPECT_FALSE(m_qpCLists->variableRows[0].isDisabled);
+        EXPECT_TRUE(m_qpCLists->variableRows[1].isDisabled);
+        EXPECT_EQ(m_qpCLists->actuatorBounds.lambdaMin[0], -1e99);
+        EXPECT_EQ(m_qpCLists->actuatorBounds.lambdaMin[1], 0.);
+        EXPECT_EQ(m_qpCLists->actuatorBounds.lambdaMax[1], 0.);
+        EXPECT_EQ(m_qpCLists->actuatorBounds.deltaMax[1], 1e99);
+        EXPECT_EQ(m_qpCLists->disabledEffectorRows, vector<char>({false, true}));
+
+        // Only the first effector row is weighted: Q = We0^T*We0 and c = We0^T*dfree_e0
+        buildQPMatrices();
+        EXPECT_EQ(m_qpSystem->Q[0][0], 0.25);
+        EXPECT_EQ(m_qpSystem->Q[0][1], 0.5);
+        EXPECT_EQ(m_qpSystem->Q[1][1], 1.);
+        EXPECT_EQ(m_qpSystem->c[0], 0.5);
+        EXPECT_EQ(m_qpSystem->c[1], 1.);
+
+        // Enabled again, in the same layout
+        m_qpCLists->disabledConstraints.clear();
+        m_qpCLists->updateVariableRows();
+        EXPECT_FALSE(m_qpCLists->variableRows[1].isDisabled);
+        EXPECT_TRUE(m_qpCLists->disabledEffectorRows.empty());
+        EXPECT_EQ(m_qpCLists->actuatorBounds.lambdaMax[1], 1e99);
+        buildQPMatrices();
+        EXPECT_EQ(m_qpSystem->Q[1][1], 1.25);
+        EXPECT_EQ(m_qpSystem->c[0], 0.5);
+        EXPECT_EQ(m_qpSystem->c[1], 2.);
+
+        clearProblem();
+    }
+
+
+    // Test that the scratch of a step is kept in the workspace, and not allocated again at the next steps
+    void stepScratchReuseTest()
+    {
+        const double Wdata[4][4] = {{2., 1., 0.5, 0.},
+                                    {1., 3., 1., 0.5},
+                                    {0.5, 1., 2., 0.},
+                                    {0., 0.5, 0., 1.}};
+        setActuatorsAndEffectorsProblem(Wdata);
+
+        buildQPMatrices();
+        EXPECT_EQ(m_workspace.variableIds, vector<unsigned int>({0, 1}));
+        const unsigned int* variableIds = m_workspace.variableIds.data();
+
+        for(int i=0; i<10; i++)
+        {
+            setActuatorsAndEffectorsProblem(Wdata);
+            buildQPMatrices();
+            EXPECT_EQ(getDelta({1., 0.}, 2), Wdata[2][0] + dFree[2]);
+        }
+        EXPECT_EQ(m_workspace.variableIds.data(), variableIds);
+
+        clearProblem();
+    }
+
+
+    // Test that the recorded solution is reused while the rows, dfree, W, the limits and the parameters do not
+    // change
+    void changeDetectionTest()
+    {
+        const double Wdata[4][4] = {{2., 1., 0.5, 0.},
+                                    {1., 3., 1., 0.5},
+                                    {0.5, 1., 2., 0.},
+                                    {0., 0.5, 0., 1.}};
+        setDetached(true);
+        setActuatorsAndEffectorsProblem(Wdata);
+        dFree[2] = 1.;
+        dFree[3] = 2.;
+        m_qpSystem->lambda = {0.5, -1.};
+
+        QPChangeDetection detection;
+        detection.setTolerance(1e-9);
+        EXPECT_FALSE(detection.isUnchanged(this, 1));
+        detection.record(this, 3., 1);
+        EXPECT_TRUE(detection.isRecorded());
+
+        // Same problem at the next step
+        setActuatorsAndEffectorsProblem(Wdata);
+        dFree[2] = 1. + 1e-12;
+        dFree[3] = 2.;
+        ASSERT_TRUE(detection.isUnchanged(this, 1));
+        double objective = 0.;
+        int iterations = -1;
+        detection.reuse(this, objective, iterations);
+        EXPECT_EQ(objective, 3.);
+        EXPECT_EQ(iterations, 0);
+        EXPECT_EQ(getF()[0], 0.5);
+        EXPECT_EQ(getF()[1], -1.);
+        EXPECT_EQ(getF()[2], 0.);
+        EXPECT_NEAR(m_qpSystem->delta[2], 1. + 0.5*0.5 - 1., 1e-10);
+        EXPECT_EQ(detection.getNbSkippedSolves(), 1u);
+
+        // A parameter changed (e.g. epsilon)
+        EXPECT_FALSE(detection.isUnchanged(this, 2));
+
+        // A target moved
+        dFree[3] = 2.1;
+        EXPECT_FALSE(detection.isUnchanged(this, 1));
+
+        // A limit changed
+        dFree[3] = 2.;
+        m_actuators[0]->setForceLimits(0., 1.);
+        m_qpCLists->updateVariableRows();
+        EXPECT_FALSE(detection.isUnchanged(this, 1));
+
+        // A compliance changed
+        setActuatorsAndEffectorsProblem(Wdata);
+        dFree[2] = 1.;
+        dFree[3] = 2.;
+        W[0][1] = W[1][0] = 1.5;
+        EXPECT_FALSE(detection.isUnchanged(this, 1));
+
+        detection.clear();
+        EXPECT_FALSE(detection.isRecorded());
+        EXPECT_EQ(detection.getNbSkippedSolves(), 0u);
+        setDetached(false);
+        clearProblem();
+    }
+
+
+    // Test that the forward step keeps the given actuation, the objective being the one of the effectors deltas
+    void solveContactsOnlyTest()
+    {
+        const double Wdata[4][4] = {{2., 1., 0.5, 0.},
+                                    {1., 3., 1., 0.5},
+                                    {0.5, 1., 2., 0.},
+                                    {0., 0.5, 0., 1.}};
+        setDetached(true);
+        setActuatorsAndEffectorsProblem(Wdata);
+        dFree[2] = 1.;
+        dFree[3] = 2.;
+
+        double objective = 0.;
+        int iterations = -1;
+        ASSERT_TRUE(solveContactsOnly({0.5, -1.}, objective, iterations));
+        EXPECT_EQ(iterations, 0);
+        EXPECT_EQ(getF()[0], 0.5);
+        EXPECT_EQ(getF()[1], -1.);
+        EXPECT_NEAR(m_qpSystem->delta[2], 0.25, 1e-12);
+        EXPECT_NEAR(m_qpSystem->delta[3], 1.5, 1e-12);
+        EXPECT_NEAR(objective, 0.25*0.25 + 1.5*1.5, 1e-12);
+
+        // Missing actuation
+        EXPECT_FALSE(solveContactsOnly({0.5}, objective, iterations));
+
+        setDetached(false);
+        clearProblem();
+    }
+
+
+    // Test that without effectors, the actuators of imposed forces are solved forward, and the others by the QP
+    void forwardWithoutEffectorsTest()
+    {
+        const double Wdata[4][4] = {{2., 1., 0.5, 0.},
+                                    {1., 3., 1., 0.5},
+                                    {0.5, 1., 2., 0.},
+                                    {0., 0.5, 0., 1.}};
+        setDetached(true);
+        setForwardWithoutEffectors(true);
+        setActuatorsAndEffectorsProblem(Wdata);
+        m_actuators[0]->setForceLimits(1., 1.);
+        m_actuators[1]->setForceLimits(-2., -2.);
+        m_qpCLists->effectorRowIds.clear();
+        m_qpCLists->updateVariableRows();
+
+        vector<double> lambdas;
+        ASSERT_TRUE(getImposedActuation(lambdas));
+        EXPECT_EQ(lambdas, vector<double>({1., -2.}));
+
+        double objective = -1.;
+        int iterations = -1;
+        solve(objective, iterations);
+        EXPECT_EQ(getNbForwardSolves(), 1u);
+        EXPECT_EQ(getF()[0], 1.);
+        EXPECT_EQ(getF()[1], -2.);
+        EXPECT_EQ(objective, 0.);
+        EXPECT_EQ(iterations, 0);
+
+        // A force to find
+        m_actuators[1]->setForceLimits(-2., 2.);
+        m_qpCLists->updateVariableRows();
+        EXPECT_FALSE(getImposedActuation(lambdas));
+
+        // An effector to reach
+        m_actuators[1]->setForceLimits(-2., -2.);
+        m_qpCLists->effectorRowIds = {2, 3};
+        m_qpCLists->updateVariableRows();
+        EXPECT_FALSE(getImposedActuation(lambdas));
+
+        setForwardWithoutEffectors(false);
+        setDetached(false);
+        clearProblem();
+    }
+
+
+    // Test that a lower priority level only uses the actuation left free by the higher one
+    void prioritizedEffectorsTest()
+    {
+        const double Wdata[4][4] = {{2., 1., 0.5, 0.},
+                                    {1., 3., 1., 0.5},
+                                    {0.5, 1., 2., 0.},
+                                    {0., 0.5, 0., 1.}};
+        sofa::core::sptr<PrioritizedCableEffector> effectors[2] = {sofa::core::objectmodel::New<PrioritizedCableEffector>(),
+                                                                   sofa::core::objectmodel::New<PrioritizedCableEffector>()};
+        setDetached(true);
+        setEpsilon(0.);
+        setActuatorsAndEffectorsProblem(Wdata);
+        m_actuators[0]->setForceLimits(-1., 1.);
+        m_qpCLists->effectors = {effectors[0].get(), effectors[1].get()};
+        m_qpCLists->updateVariableRows();
+        EXPECT_TRUE(m_qpCLists->effectorRowLevels.empty());
+
+        // Level 0: 0.5 x1 + 2 = 0, then level 1: 0.5 x0 + x1 + 1 = 0 with x0 in [-1, 1]
+        effectors[0]->m_priority = 1;
+        m_qpCLists->updateVariableRows();
+        EXPECT_EQ(m_qpCLists->effectorRowLevels, vector<unsigned int>({1, 0}));
+        dFree[2] = 1.;
+        dFree[3] = 2.;
+        double objective = 0.;
+        int iterations = 0;
+        solve(objective, iterations);
+        EXPECT_EQ(getNbPriorityLevels(), 2u);
+        EXPECT_NEAR(getF()[1], -4., 1e-8);
+        EXPECT_NEAR(getF()[0], 1., 1e-8);
+        EXPECT_NEAR(m_qpSystem->delta[3], 0., 1e-8);
+        EXPECT_NEAR(m_qpSystem->delta[2], -2.5, 1e-8);
+        ASSERT_EQ(getPrioritizedProblem().getLevelDimensions().size(), 2u);
+        EXPECT_EQ(getPrioritizedProblem().getLevelDimensions()[1], 1u);
+
+        // Swapped, the second row is reached and the first one is minimized along the remaining direction
+        effectors[0]->m_priority = 0;
+        effectors[1]->m_priority = 1;
+        m_qpCLists->updateVariableRows();
+        solve(objective, iterations);
+        EXPECT_NEAR(m_qpSystem->delta[2], 0., 1e-8);
+        EXPECT_NEAR(getF()[0], 1., 1e-8);
+        EXPECT_NEAR(getF()[1], -1.5, 1e-8);
+
+        // Same level, the single QP
+        effectors[1]->m_priority = 0;
+        m_qpCLists->updateVariableRows();
+        EXPECT_TRUE(m_qpCLists->effectorRowLevels.empty());
+        solve(objective, iterations);
+        EXPECT_EQ(getNbPriorityLevels(), 0u);
+
+        setDetached(false);
+        clearProblem();
+    }
+
+    void batchedComplianceTest()
+    {
+        // Constraint correction of compliance 1 between all the rows, one call for the block
+        class UnitCompliance : public softrobotsinverse::behavior::BatchedCompliance
+        {
+        public:
+            bool addBatchedCompliance(const sofa::core::ConstraintParams*,
+                                      sofa::linearalgebra::BaseMatrix* W,
+                                      const sofa::type::vector<unsigned int>& rows) override
+            {
+                nbCalls++;
+                if (refuse)
+                    return false;
+                for (const unsigned int i : rows)
+                    for (const unsigned int j : rows)
+                        W->add(i, j, 1.);
+                return true;
+            }
+            bool refuse{false};
+            int nbCalls{0};
+        };
+
+        QPBatchedCompliance batchedCompliance;
+        const sofa::type::vector<bool> isSensorRow = {false, true, false};
+        batchedCompliance.setRows(3, &isSensorRow);
+        ASSERT_EQ(batchedCompliance.getRows().size(), 2u);
+        EXPECT_EQ(batchedCompliance.getRows()[0], 0u);
+        EXPECT_EQ(batchedCompliance.getRows()[1], 2u);
+
+        sofa::linearalgebra::FullMatrix<double> W(3, 3);
+        W.clear();
+        UnitCompliance cc;
+        const sofa::core::ConstraintParams cParams;
+        EXPECT_FALSE(batchedCompliance.add(nullptr, &cParams, &W));
+        ASSERT_TRUE(batchedCompliance.add(&cc, &cParams, &W));
+        EXPECT_EQ(cc.nbCalls, 1);
+        EXPECT_EQ(W.element(0, 0), 1.);
+        EXPECT_EQ(W.element(0, 2), 1.);
+        EXPECT_EQ(W.element(2, 0), 1.);
+        EXPECT_EQ(W.element(0, 1), 0.);
+        EXPECT_EQ(W.element(1, 1), 0.);
+
+        // Refused block, W is left to the row by row computation
+        cc.refuse = true;
+        EXPECT_FALSE(batchedCompliance.add(&cc, &cParams, &W));
+        EXPECT_EQ(W.element(0, 0), 1.);
+
+        batchedCompliance.setRows(3, nullptr);
+        EXPECT_EQ(batchedCompliance.getRows().size(), 3u);
+    }
+
+    void profileReportTest()
+    {
+        QPProfileReport report;
+        EXPECT_FALSE(report.isCapturing());
+        report.beginStep(0.);
+        EXPECT_FALSE(report.isStepOpen());
+
+        report.request(2);
+        ASSERT_TRUE(report.isCapturing());
+        report.beginStep(0.01);
+        report.addPhase("QPs", 1.5);
+        report.addPhase("QPs", 0.5);
+        report.getStep().dim = 2;
+        report.getStep().nbNonZeros = 3;
+        report.getStep().values["#Effectors:"] = 1;
+        report.getStep().pivotsPerIteration = {2, 1};
+        EXPECT_FALSE(report.endStep());
+        EXPECT_FALSE(report.endStep()); // no open step
+
+        // A step left open is replaced
+        report.beginStep(0.02);
+        report.addPhase("LCP", 1.);
+        report.beginStep(0.03);
+        EXPECT_TRUE(report.endStep());
+        EXPECT_FALSE(report.isCapturing());
+
+        ASSERT_EQ(report.getSteps().size(), 2u);
+        EXPECT_EQ(report.getSteps()[0].phases.at("QPs"), 2.);
+        EXPECT_EQ(report.getSteps()[1].time, 0.03);
+        EXPECT_TRUE(report.getSteps()[1].phases.empty());
+
+        const std::string filename = "QPInverseProblemImplTest_profile.json";
+        ASSERT_TRUE(report.write(filename));
+        std::ifstream file(filename);
+        const std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        EXPECT_NE(content.find("\"densityW\":0.75"), std::string::npos);
+        EXPECT_NE(content.find("\"phases\":{\"QPs\":2}"), std::string::npos);
+        EXPECT_NE(content.find("\"telemetry\":{\"#Effectors:\":1}"), std::string::npos);
+        EXPECT_NE(content.find("\"pivotsPerIteration\":[2,1]"), std::string::npos);
+        std::remove(filename.c_str());
+
+        report.clear();
+        EXPECT_TRUE(report.getSteps().empty());
+    }
+
+    // Test that Q and c accumulated by chunks of effector rows are the ones assembled from the whole
+    // block Wea, with a weight block across the end of a chunk and a disabled row, and that Wea only
+    // holds a chunk
+    void condensedEffectorsTest()
+    {
+        const unsigned int nbEffectors = 150;
+        const unsigned int dimW = 2 + nbEffectors;
+        for(sofa::core::sptr<LimitedCableActuator>& actuator : m_actuators)
+            if(!actuator)
+                actuator = sofa::core::objectmodel::New<LimitedCableActuator>();
+
+        setEpsilon(1e-3);
+        vector<double> Q, c;
+        for(const bool condensed : {false, true})
+        {
+            clear(dimW);
+            for(unsigned int i=0; i<dimW; i++)
+            {
+                for(unsigned int j=0; j<=i; j++)
+                    W[i][j] = W[j][i] = std::cos(0.1*(i+1)*(j+2));
+                W[i][i] += 4.;
+                dFree[i] = std::sin(0.3*i);
+            }
+
+            clearProblem();
+            m_qpCLists->actuators = {m_actuators[0].get(), m_actuators[1].get()};
+            m_qpCLists->actuatorRowIds = {0, 1};
+            m_qpCLists->effectorRowIds.resize(nbEffectors);
+            for(unsigned int i=0; i<nbEffectors; i++)
+                m_qpCLists->effectorRowIds[i] = 2 + i;
+            m_qpCLists->updateVariableRows();
+            m_qpCLists->effectorWeightBlocks = {{63, 2, 0}, {100, 1, 4}};
+            m_qpCLists->effectorWeights = {2., 1., 1., 2., 3.};
+            m_qpCLists->disabledEffectorRows.assign(nbEffectors, 0);
+            m_qpCLists->disabledEffectorRows[10] = 1;
+            m_qpSystem->dim = 2;
+            m_qpSystem->W = getW();
+            m_qpSystem->dFree = getDfree();
+
+            setCondensedEffectors(condensed);
+            EXPECT_EQ(isCondensingEffectors(), condensed);
+            buildQPMatrices();
+            if(!condensed)
+            {
+                EXPECT_EQ((unsigned int)m_Wea.rows(), nbEffectors);
+                Q.assign(m_qpSystem->Q.data(), m_qpSystem->Q.data()+4);
+                c.assign(m_qpSystem->c.data(), m_qpSystem->c.data()+2);
+                continue;
+            }
+
+            // The first chunk ends after the weight block of the rows 63 and 64
+            EXPECT_EQ(m_Wea.rows(), 65);
+            for(unsigned int k=0; k<4; k++)
+                EXPECT_NEAR(m_qpSystem->Q.data()[k], Q[k], 1e-9*std::abs(Q[k]));
+            for(unsigned int k=0; k<2; k++)
+                EXPECT_NEAR(m_qpSystem->c[k], c[k], 1e-9*std::abs(c[k]));
+        }
+
+        // The cached Hessian reads the whole block
+        setReuseHessian(true);
+        EXPECT_FALSE(isCondensingEffectors());
+        setReuseHessian(false);
+
+        setCondensedEffectors(false);
+        setEpsilon(0.);
+        clearProblem();
+    }
+
+
+    // Test that the sketched objective is only used with fewer sketch rows than effector rows, and that
+    // Q and c are then those of the sketch, the same from one step to the other
+    void effectorSketchTest()
+    {
+        const unsigned int nbEffectors = 150;
+        const unsigned int dimW = 2 + nbEffectors;
+        for(sofa::core::sptr<LimitedCableActuator>& actuator : m_actuators)
+            if(!actuator)
+                actuator = sofa::core::objectmodel::New<LimitedCableActuator>();
+
+        vector<double> Q, c;
+        for(const unsigned int size : {0u, 200u, 40u, 40u})
+        {
+            clear(dimW);
+            for(unsigned int i=0; i<dimW; i++)
+            {
+                for(unsigned int j=0; j<=i; j++)
+                    W[i][j] = W[j][i] = std::cos(0.1*(i+1)*(j+2));
+                W[i][i] += 4.;
+                dFree[i] = std::sin(0.3*i);
+            }
+
+            clearProblem();
+            m_qpCLists->actuators = {m_actuators[0].get(), m_actuators[1].get()};
+            m_qpCLists->actuatorRowIds = {0, 1};
+            m_qpCLists->effectorRowIds.resize(nbEffectors);
+            for(unsigned int i=0; i<nbEffectors; i++)
+                m_qpCLists->effectorRowIds[i] = 2 + i;
+            m_qpCLists->updateVariableRows();
+            m_qpCLists->disabledEffectorRows.assign(nbEffectors, 0);
+            m_qpCLists->disabledEffectorRows[10] = 1;
+            m_qpSystem->dim = 2;
+            m_qpSystem->W = getW();
+            m_qpSystem->dFree = getDfree();
+
+            setEffectorSketch(size);
+            EXPECT_EQ(isSketchingEffectors(), size==40u);
+            buildQPMatrices();
+            if(size != 40u)
+            {
+                // No sketch with as many rows as the effectors
+                if(!Q.empty())
+                    for(unsigned int k=0; k<4; k++)
+                        EXPECT_DOUBLE_EQ(m_qpSystem->Q.data()[k], Q[k]);
+                Q.assign(m_qpSystem->Q.data(), m_qpSystem->Q.data()+4);
+                c.assign(m_qpSystem->c.data(), m_qpSystem->c.data()+2);
+                continue;
+            }
+
+            ASSERT_EQ(m_sketchedWea.rows(), 40);
+            ASSERT_EQ(m_sketchedWea.cols(), 2);
+            const Eigen::MatrixXd sketchedQ = m_sketchedWea.transpose()*m_sketchedWea;
+            const Eigen::VectorXd sketchedC = m_sketchedWea.transpose()*m_sketchedDFree;
+            for(unsigned int i=0; i<2; i++)
+            {
+                EXPECT_NEAR(m_qpSystem->c[i], sketchedC(i), 1e-9*std::abs(sketchedC(i)));
+                for(unsigned int j=0; j<2; j++)
+                    EXPECT_NEAR(m_qpSystem->Q[i][j], sketchedQ(i, j), 1e-9*std::abs(sketchedQ(i, j)));
+            }
+            EXPECT_NE(m_qpSystem->Q[0][0], Q[0]);
+
+            // The same buckets and signs at the next step
+            if(c.size() == 4)
+            {
+                EXPECT_DOUBLE_EQ(m_qpSystem->c[0], c[2]);
+                EXPECT_DOUBLE_EQ(m_qpSystem->c[1], c[3]);
+            }
+            c.push_back(m_qpSystem->c[0]);
+            c.push_back(m_qpSystem->c[1]);
+        }
+        EXPECT_EQ(c.size(), 6u);
+
+        // The cached Hessian reads the whole block
+        setReuseHessian(true);
+        EXPECT_FALSE(isSketchingEffectors());
+        setReuseHessian(false);
+
+        setEffectorSketch(0);
+        EXPECT_EQ(m_sketchedWea.size(), 0);
+        clearProblem();
+    }
+
+
+    // Test that the unconstrained minimizer is the solution when it strictly satisfies the bounds and
+    // the constraints, and that qpOASES solves the QP otherwise
+    void interiorFastPathTest()
+    {
+        setBoundedProblem();
+        m_qpSystem->Q[0][1] = 0.5;
+        m_qpSystem->Q[1][0] = 0.5;
+        sofa::type::vector<double> row = {1., 1.};
+        m_qpSystem->A.push_back(row);
+        m_qpSystem->bu = {2.}; // inactive, x = (2/3, 2/3)
+
+        double objective, interiorObjective;
+        sofa::type::vector<double> result, interiorResult, dual;
+        solveInverseProblem(objective, result, dual);
+
+        setInteriorFastPath(true);
+        solveInverseProblem(interiorObjective, interiorResult, dual);
+        EXPECT_EQ(getNbInteriorSolves(), 1u);
+        ASSERT_EQ(interiorResult.size(), 2u);
+        for(unsigned int i=0; i<2; i++)
+            EXPECT_NEAR(interiorResult[i], result[i], 1e-10);
+        EXPECT_NEAR(interiorResult[0], 2./3., 1e-10);
+        EXPECT_NEAR(interiorObjective, objective, 1e-10);
+        ASSERT_EQ(dual.size(), 1u);
+        EXPECT_EQ(dual[0], 0.);
+
+        // The constraint is active at the unconstrained minimizer
+        m_qpSystem->bu = {1.};
+        solveInverseProblem(objective, result, dual);
+        EXPECT_EQ(getNbInteriorSolves(), 1u);
+        EXPECT_NEAR(result[0] + result[1], 1., 1e-10);
+
+        // The upper bound of x0 is active, x = (10, -6)
+        m_qpSystem->bu = {10.};
+        m_qpSystem->c = {-30., 1.};
+        solveInverseProblem(objective, result, dual);
+        EXPECT_EQ(getNbInteriorSolves(), 1u);
+        EXPECT_NEAR(result[0], 10., 1e-10);
+        EXPECT_NEAR(result[1], -6., 1e-10);
+
+        // Q semi-definite, no unique minimizer
+        m_qpSystem->Q.fill(1.);
+        m_qpSystem->c = {-1., -1.};
+        solveInverseProblem(objective, result, dual);
+        EXPECT_EQ(getNbInteriorSolves(), 1u);
+
+        setInteriorFastPath(false);
+    }
+
+
+    // Test that the messages of a key are rate limited without being formatted, that the count is reported
+    // with the next accepted one, and that the queue emits the pending messages when stopped
+    void messageQueueTest()
+    {
+        static int nbFormats = 0;
+        nbFormats = 0;
+        std::ostream& (*format)(std::ostream&) = [](std::ostream& out) -> std::ostream& {nbFormats++; return out;};
+
+        QPMessageQueue queue;
+        static const char* key = "test";
+        unsigned int nbSuppressed = 0;
+        EXPECT_TRUE(queue.accept(key, nbSuppressed)); // no rate limit by default
+        EXPECT_TRUE(queue.accept(key, nbSuppressed));
+
+        queue.setInterval(3600.);
+        for(int i=0; i<4; i++)
+            queue.info("QPMessageQueueTest", key) << format;
+        EXPECT_EQ(nbFormats, 1);
+        EXPECT_EQ(queue.getNbSuppressed(), 3u);
+
+        // Another key is not limited by the first one
+        static const char* otherKey = "other";
+        EXPECT_TRUE(queue.accept(otherKey, nbSuppressed));
+        EXPECT_FALSE(queue.accept(key, nbSuppressed));
+
+        // Past the interval, the messages counted since the last accepted one are reported
+        queue.setInterval(1e-9);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        EXPECT_TRUE(queue.accept(key, nbSuppressed));
+        EXPECT_EQ(nbSuppressed, 4u);
+
+        queue.setInterval(0.);
+        queue.start(1000);
+        EXPECT_TRUE(queue.isStarted());
+        for(int i=0; i<10; i++)
+            queue.info("QPMessageQueueTest", key) << format;
+        queue.stop();
+        EXPECT_FALSE(queue.isStarted());
+        EXPECT_EQ(nbFormats, 11);
+        EXPECT_EQ(queue.getNbDropped(), 0u);
+    }
+
+
+    // Test that an effector in its deadband is left out of Wea, with the same Q and c as when it is disabled,
+    // and that an effector out of its deadband stays
+    void effectorDeadbandTest()
+    {
+        const unsigned int nbEffectors = 12;
+        const unsigned int dimW = 2 + nbEffectors;
+        for(sofa::core::sptr<LimitedCableActuator>& actuator : m_actuators)
+            if(!actuator)
+                actuator = sofa::core::objectmodel::New<LimitedCableActuator>();
+
+        setEpsilon(1e-3);
+        vector<double> Q, c;
+        for(const bool condensed : {false, false, true})
+        {
+            clear(dimW);
+            for(unsigned int i=0; i<dimW; i++)
+            {
+                for(unsigned int j=0; j<=i; j++)
+                    W[i][j] = W[j][i] = std::cos(0.1*(i+1)*(j+2));
+                W[i][i] += 4.;
+                dFree[i] = std::sin(0.3*i) + 1.;
+            }
+            for(unsigned int i=2; i<5; i++)
+                dFree[i] = 1e-3; // the first effector is converged
+
+            clearProblem();
+            m_qpCLists->actuators = {m_actuators[0].get(), m_actuators[1].get()};
+            m_qpCLists->actuatorRowIds = {0, 1};
+            m_qpCLists->effectorRowIds.resize(nbEffectors);
+            for(unsigned int i=0; i<nbEffectors; i++)
+                m_qpCLists->effectorRowIds[i] = 2 + i;
+            m_qpCLists->updateVariableRows();
+            m_qpCLists->effectorWeightBlocks = {{6, 2, 0}};
+            m_qpCLists->effectorWeights = {2., 1., 1., 2.};
+            m_qpSystem->dim = 2;
+            m_qpSystem->W = getW();
+            m_qpSystem->dFree = getDfree();
+
+            setCondensedEffectors(condensed);
+            if(Q.empty())
+            {
+                // Reference: the first effector is disabled
+                m_qpCLists->disabledEffectorRows.assign(nbEffectors, 0);
+                for(unsigned int i=0; i<3; i++)
+                    m_qpCLists->disabledEffectorRows[i] = 1;
+                buildQPMatrices();
+                EXPECT_EQ(getNbDeadbandEffectors(), 0u);
+                Q.assign(m_qpSystem->Q.data(), m_qpSystem->Q.data()+4);
+                c.assign(m_qpSystem->c.data(), m_qpSystem->c.data()+2);
+                continue;
+            }
+
+            m_qpCLists->effectorDeadbands = {{0, 3, 0.01}, {3, 3, 0.01}};
+            buildQPMatrices();
+            EXPECT_EQ(getNbDeadbandEffectors(), 1u);
+            if(!condensed)
+                EXPECT_EQ((unsigned int)m_Wea.rows(), nbEffectors-3);
+            for(unsigned int k=0; k<4; k++)
+                EXPECT_NEAR(m_qpSystem->Q.data()[k], Q[k], 1e-9*std::abs(Q[k]));
+            for(unsigned int k=0; k<2; k++)
+                EXPECT_NEAR(m_qpSystem->c[k], c[k], 1e-9*std::abs(c[k]));
+        }
+
+        // Out of its deadband, the effector stays in the objective
+        clearProblem();
+        m_qpCLists->actuatorRowIds = {0, 1};
+        m_qpCLists->effectorRowIds = {2};
+        m_qpCLists->updateVariableRows();
+        m_qpCLists->effectorDeadbands = {{0, 1, 1e-4}};
+        m_qpSystem->dim = 2;
+        m_qpSystem->W = getW();
+        m_qpSystem->dFree = getDfree();
+        buildQPMatrices();
+        EXPECT_EQ(getNbDeadbandEffectors(), 0u);
+        EXPECT_EQ(m_Wea.rows(), 1);
+
+        setCondensedEffectors(false);
+        setEpsilon(0.);
+        clearProblem();
+    }
+
+
+    // Test that the tracker gives their ids back to the contacts of the previous step when their rows are
+    // reordered, new ids to the new contacts, and that the tracked contacts start from their previous forces
+    void contactTrackerTest()
+    {
+        const unsigned int dim = 6;
+        vector<vector<double>> data(dim, vector<double>(dim));
+        double* W[dim];
+        for(unsigned int i=0; i<dim; i++)
+        {
+            W[i] = data[i].data();
+            for(unsigned int j=0; j<dim; j++)
+                data[i][j] = std::cos(0.7*(i+1)*(j+1));
+        }
+
+        QPContactTracker tracker;
+        QPInverseProblem::QPConstraintLists lists;
+        lists.actuatorRowIds = {0, 1};
+        lists.contactRowIds = {2, 3, 4, 5};
+        lists.contactIds.assign(4, QPInverseProblem::QPContactId());
+        EXPECT_EQ(tracker.track(&lists, W, 1), 0u);
+        EXPECT_EQ(tracker.getNbNewContacts(), 4u);
+        vector<int> ids;
+        for(const QPInverseProblem::QPContactId& id : lists.contactIds)
+        {
+            EXPECT_GE(id.id, QPContactTracker::s_firstId);
+            ids.push_back(id.id);
+        }
+
+        // The contacts of the rows 2 and 5 swap
+        std::swap(data[2], data[5]);
+        for(unsigned int i=0; i<dim; i++)
+            std::swap(data[i][2], data[i][5]);
+        for(unsigned int i=0; i<dim; i++)
+            W[i] = data[i].data();
+        lists.contactIds.assign(4, QPInverseProblem::QPContactId());
+        EXPECT_EQ(tracker.track(&lists, W, 1), 4u);
+        EXPECT_EQ(tracker.getNbNewContacts(), 0u);
+        EXPECT_EQ(lists.contactIds[0].id, ids[3]);
+        EXPECT_EQ(lists.contactIds[1].id, ids[1]);
+        EXPECT_EQ(lists.contactIds[2].id, ids[2]);
+        EXPECT_EQ(lists.contactIds[3].id, ids[0]);
+
+        // A contact far from the previous ones is new, a contact with a persistent id is not tracked
+        data[3][0] += 10.;
+        data[3][1] += 10.;
+        data[3][3] += 10.;
+        lists.contactIds.assign(4, QPInverseProblem::QPContactId());
+        lists.contactIds[2].id = 7;
+        EXPECT_EQ(tracker.track(&lists, W, 1), 2u);
+        EXPECT_EQ(tracker.getNbNewContacts(), 1u);
+        EXPECT_EQ(lists.contactIds[0].id, ids[3]);
+        EXPECT_EQ(std::count(ids.begin(), ids.end(), lists.contactIds[1].id), 0);
+        EXPECT_EQ(lists.contactIds[2].id, 7);
+        EXPECT_EQ(lists.contactIds[3].id, ids[0]);
+
+        // The forces follow the contacts, a new contact starts from zero
+        clearProblem();
+        setTrackContacts(true);
+        m_qpCLists->actuatorRowIds = {0, 1};
+        m_qpCLists->contactRowIds = {2, 3, 4};
+        m_qpCLists->contactIds.assign(3, QPInverseProblem::QPContactId());
+        for(unsigned int k=0; k<3; k++)
+            m_qpCLists->contactIds[k].id = k+1;
+        m_qpSystem->lambda = {1., 2., 10., 20., 30.};
+        storeContactForces();
+
+        m_qpCLists->contactIds[0].id = 3;
+        m_qpCLists->contactIds[1].id = 1;
+        m_qpCLists->contactIds[2].id = 4;
+        sofa::linearalgebra::FullVector<double> x(3);
+        initContactForces(x, 2);
+        EXPECT_EQ(x[0], 30.);
+        EXPECT_EQ(x[1], 10.);
+        EXPECT_EQ(x[2], 0.);
+
+        setTrackContacts(false);
+        clearProblem();
+    }
+
+
+    // Test that the state of a static contact at the end of a step is given to the next one: the contact LCP,
+    // solved without actuation, releases the contact that the actuation pushes into, so that the first step
+    // needs a pivot and the second one, warm started, does not
+    void warmStartContactsTest()
+    {
+        typedef QPStandaloneProblem::RowType RowType;
+        QPStandaloneProblem problem;
+        QPInverseProblemImpl& impl = problem.getProblem();
+        impl.setEpsilon(0.);
+        impl.setWarmStartContacts(true);
+        problem.setRows({RowType::Effector, RowType::Actuator, RowType::Contact});
+        impl.getQPConstraintLists()->contactIds[0].id = 4; // persistent id, without component
+
+        Eigen::MatrixXd W(3, 3);
+        W << 1., 1., 0.,
+             1., 2., -1.,
+             0., -1., 2.;
+        Eigen::VectorXd dFree(3), lambda(3), delta(3);
+        dFree << -2., 0., 0.5;
+
+        int iterations[2];
+        unsigned int nbWarmStartedContacts[2];
+        for(int k=0; k<2; k++)
+        {
+            // The LCP of both steps is solved without actuation
+            std::fill(impl.getQPSystem()->lambda.begin(), impl.getQPSystem()->lambda.end(), 0.);
+            ASSERT_TRUE(problem.solve(W, dFree, lambda, delta));
+            iterations[k] = problem.getIterations();
+            nbWarmStartedContacts[k] = impl.getNbWarmStartedContacts();
+            EXPECT_NEAR(lambda[1], 2., 1e-8) << "step " << k;
+            EXPECT_NEAR(lambda[2], 0.75, 1e-8) << "step " << k;
+            EXPECT_NEAR(delta[0], 0., 1e-8) << "step " << k;
+            EXPECT_NEAR(delta[2], 0., 1e-8) << "step " << k;
+        }
+        EXPECT_EQ(nbWarmStartedContacts[0], 0u);
+        EXPECT_EQ(nbWarmStartedContacts[1], 1u);
+        EXPECT_GE(iterations[0], 2);
+        EXPECT_EQ(iterations[1], 1);
+
+        // A contact of another identity is not warm started
+        impl.getQPConstraintLists()->contactIds[0].id = 5;
+        std::fill(impl.getQPSystem()->lambda.begin(), impl.getQPSystem()->lambda.end(), 0.);
+        ASSERT_TRUE(problem.solve(W, dFree, lambda, delta));
+        EXPECT_EQ(impl.getNbWarmStartedContacts(), 0u);
+        EXPECT_EQ(problem.getIterations(), iterations[0]);
+    }
+
+
+    // Test that the storage policies give the same QP, with the buffers aligned on 64 bytes and the rows
+    // of W(x, x) padded, and that a buffer keeps its values across a change of policy
+    void storagePolicyTest()
+    {
+        QPAlignedBuffer<double> buffer;
+        const double values[3] = {1., 2., 3.};
+        buffer.append(values, values+3);
+        buffer.resize(5);
+        EXPECT_EQ(buffer[4], 0.);
+        buffer.setPolicy(QPStoragePolicy::Aligned);
+        EXPECT_EQ(reinterpret_cast<std::uintptr_t>(buffer.data()) % QPStorage::s_alignment, 0u);
+        EXPECT_EQ(buffer.size(), 5u);
+        EXPECT_EQ(buffer[2], 3.);
+        QPAlignedBuffer<double> copy(buffer);
+        EXPECT_EQ(copy.getPolicy(), QPStoragePolicy::Aligned);
+        EXPECT_EQ(copy[1], 2.);
+        EXPECT_EQ(QPStorage::getPaddedSize(13, sizeof(double), QPStoragePolicy::Aligned), 16u);
+        EXPECT_EQ(QPStorage::getPaddedSize(13, sizeof(float), QPStoragePolicy::Aligned), 16u);
+        EXPECT_EQ(QPStorage::getPaddedSize(13, sizeof(double), QPStoragePolicy::Default), 13u);
+
+        const unsigned int nbActuators = 2, nbEffectors = 4, nbContacts = 2;
+        const unsigned int dimW = nbActuators + nbEffectors + nbContacts;
+        const unsigned int dim = nbActuators + nbContacts;
+        for(sofa::core::sptr<LimitedCableActuator>& actuator : m_actuators)
+            if(!actuator)
+                actuator = sofa::core::objectmodel::New<LimitedCableActuator>();
+
+        vector<double> Q;
+        for(const std::string name : {"Default", "Aligned", "TransparentHugePages", "HugePages"})
+        {
+            clear(dimW);
+            for(unsigned int i=0; i<dimW; i++)
+            {
+                for(unsigned int j=0; j<=i; j++)
+                    W[i][j] = W[j][i] = std::cos(0.2*(i+1)*(j+1));
+                W[i][i] += 4.;
+                dFree[i] = std::sin(0.5*i);
+            }
+
+            clearProblem();
+            m_qpCLists->actuators = {m_actuators[0].get(), m_actuators[1].get()};
+            m_qpCLists->actuatorRowIds = {0, 1};
+            m_qpCLists->effectorRowIds = {2, 3, 4, 5};
+            m_qpCLists->contactRowIds = {6, 7};
+            m_qpCLists->updateVariableRows();
+            m_qpCParams->mu = 0.;
+            m_qpCParams->contactNbLines = 1;
+            m_qpCParams->nbContactPoints = nbContacts;
+            m_qpCParams->contactStates = {&m_qpCParams->activeContact, &m_qpCParams->inactiveContact};
+            m_qpSystem->dim = dim;
+            m_qpSystem->W = getW();
+            m_qpSystem->dFree = getDfree();
+
+            setStoragePolicy(name);
+            buildQPMatrices();
+            const QPPermutedCompliance& Wx = updatePermutedCompliance();
+            const std::uintptr_t alignment = (name == "Default")? 1 : QPStorage::s_alignment;
+            EXPECT_EQ(reinterpret_cast<std::uintptr_t>(m_qpSystem->Q.data()) % alignment, 0u);
+            EXPECT_EQ(Wx.getPitch(), (name == "Default")? dim : 8u);
+            for(unsigned int i=0; i<dim; i++)
+            {
+                EXPECT_EQ(reinterpret_cast<std::uintptr_t>(Wx[i]) % alignment, 0u);
+                for(unsigned int j=0; j<dim; j++)
+                    EXPECT_EQ(Wx[i][j], W[m_workspace.variableIds[i]][m_workspace.variableIds[j]]);
+            }
+
+            if(Q.empty())
+                Q.assign(m_qpSystem->Q.data(), m_qpSystem->Q.data()+dim*dim);
+            else
+                for(unsigned int k=0; k<dim*dim; k++)
+                    EXPECT_EQ(m_qpSystem->Q.data()[k], Q[k]);
+        }
+
+        setStoragePolicy("Default");
+        m_qpCParams->contactStates.clear();
+        m_qpCParams->nbContactPoints = 0;
+        clearProblem();
+    }
+
+
+    // Test that the counters of the qpOASES calls are collected per call, a hot start only adding its own
+    void qpOASESStatisticsTest()
+    {
+        m_qpOASESStatistics = QPOASESStatistics();
+
+        // min 1/2 |x|^2 - (1 3) x, subject to x2 <= 2
+        qpOASES::real_t Q[4] = {1., 0., 0., 1.};
+        qpOASES::real_t c[2] = {-1., -3.};
+        qpOASES::real_t l[2] = {-10., -10.};
+        qpOASES::real_t u[2] = {10., 2.};
+        qpOASES::real_t x[2];
+
+        qpOASES::QProblem problem(2, 0);
+        problem.setPrintLevel(qpOASES::PL_NONE);
+        int_t nWSR = 100;
+        ASSERT_EQ(initQProblem(problem, Q, c, l, u, nullptr, nullptr, nullptr, nWSR, nullptr), qpOASES::SUCCESSFUL_RETURN);
+        problem.getPrimalSolution(x);
+        EXPECT_NEAR(x[1], 2., 1e-10);
+        const QPOASESStatistics init = getQPOASESStatistics();
+        EXPECT_EQ(init.nbResolutions, 1u);
+        EXPECT_EQ(init.nbWorkingSetChanges, (unsigned int)nWSR);
+        EXPECT_GE(init.nbFactorizations, 1u);
+        EXPECT_GE(init.nbFactorizationUpdates, 1u); // x2 at its upper bound
+        EXPECT_EQ(init.nbIndefiniteFallbacks, 0u);
+
+        // The bound of x2 is released and the one of x1 reached, without new factorization
+        qpOASES::real_t c2[2] = {-20., 1.};
+        const QPOASESCounters start = getQPOASESCounters(problem);
+        nWSR = 100;
+        ASSERT_EQ(problem.hotstart(c2, l, u, nullptr, nullptr, nWSR), qpOASES::SUCCESSFUL_RETURN);
+        addQPOASESStatistics(problem, start, nWSR);
+        problem.getPrimalSolution(x);
+        EXPECT_NEAR(x[0], 10., 1e-10);
+        EXPECT_NEAR(x[1], -1., 1e-10);
+        const QPOASESStatistics& hotStart = getQPOASESStatistics();
+        EXPECT_EQ(hotStart.nbResolutions, 2u);
+        EXPECT_EQ(hotStart.nbWorkingSetChanges, init.nbWorkingSetChanges + (unsigned int)nWSR);
+        EXPECT_EQ(hotStart.nbFactorizations, init.nbFactorizations);
+        EXPECT_GE(hotStart.nbFactorizationUpdates, init.nbFactorizationUpdates + 2);
+        EXPECT_GE(hotStart.nbFactorizationUpdates - init.nbFactorizationUpdates, (unsigned int)nWSR);
+
+        // A new call to solve() starts from zero
+        resetResolutionState();
+        EXPECT_EQ(getQPOASESStatistics().nbResolutions, 0u);
+    }
+
+
+    // Test the choice of the method of each step from the features of the problem and the previous outcomes
+    void backendSelectorTest()
+    {
+        QPBackendSelector selector;
+        QPBackendSelector::Features features;
+        features.dim = 50;
+        features.nbConstraints = 50;
+
+        // The interior solution is cheap and tried first, the active set solves the problem when it fails
+        QPBackendSelector::Decision decision = selector.select(features);
+        EXPECT_EQ(decision.backend, QPBackendSelector::Interior);
+        EXPECT_EQ(decision.fallback, QPBackendSelector::ActiveSet);
+        EXPECT_TRUE(decision.hasChanged);
+        EXPECT_GT(decision.costs[QPBackendSelector::ActiveSet], decision.costs[QPBackendSelector::Interior]);
+        EXPECT_LT(decision.costs[QPBackendSelector::SmallKernel], 0.);
+        EXPECT_LT(decision.costs[QPBackendSelector::ADMM], 0.);
+        EXPECT_FALSE(selector.select(features).hasChanged);
+
+        // When it keeps failing, the active set is used directly, until the interior solution is tried again
+        int nbFailures = 0;
+        while(selector.select(features).backend == QPBackendSelector::Interior && nbFailures < 100)
+        {
+            selector.setOutcome(QPBackendSelector::Interior, false, 1);
+            nbFailures++;
+        }
+        EXPECT_GT(nbFailures, 1);
+        EXPECT_LT(nbFailures, 100);
+        EXPECT_EQ(selector.getDecision().backend, QPBackendSelector::ActiveSet);
+        EXPECT_TRUE(selector.getDecision().hasChanged);
+        int nbSteps = 0;
+        while(selector.select(features).backend != QPBackendSelector::Interior && nbSteps < 1000)
+            nbSteps++;
+        EXPECT_LT(nbSteps, 1000);
+
+        // Equality rows cannot be solved by the interior solution
+        selector.clear();
+        features.nbEqualities = 2;
+        features.isSmallProblem = true;
+        decision = selector.select(features);
+        EXPECT_LT(decision.costs[QPBackendSelector::Interior], 0.);
+        EXPECT_EQ(decision.backend, QPBackendSelector::SmallKernel);
+        EXPECT_EQ(decision.fallback, QPBackendSelector::ActiveSet);
+
+        // The cost model has two coefficients per method
+        EXPECT_FALSE(selector.setCostModel({1., 2.}));
+        sofa::type::vector<double> model(2*QPBackendSelector::NbBackends, 1.);
+        model[2*QPBackendSelector::ActiveSet] = 0.;
+        model[2*QPBackendSelector::ActiveSet+1] = 0.;
+        EXPECT_TRUE(selector.setCostModel(model));
+        EXPECT_EQ(selector.select(features).backend, QPBackendSelector::ActiveSet);
+        EXPECT_TRUE(selector.setCostModel({}));
+        EXPECT_EQ(selector.getCostModel()[2*QPBackendSelector::ActiveSet], 5.);
+
+        // In the adaptive mode, each resolution counts the method chosen, with the solution of qpOASES
+        setBoundedProblem();
+        m_qpSystem->Q[0][1] = 0.5;
+        m_qpSystem->Q[1][0] = 0.5;
+        double objective, adaptiveObjective;
+        sofa::type::vector<double> result, adaptiveResult, dual;
+        solveInverseProblem(objective, result, dual);
+
+        resetResolutionState();
+        setQPSolver("Adaptive");
+        solveInverseProblem(adaptiveObjective, adaptiveResult, dual);
+        unsigned int nbSelections = 0;
+        for(unsigned int b=0; b<QPBackendSelector::NbBackends; b++)
+            nbSelections += getNbBackendSelections(QPBackendSelector::Backend(b));
+        EXPECT_EQ(nbSelections, 1u);
+        ASSERT_EQ(adaptiveResult.size(), 2u);
+        for(unsigned int i=0; i<2; i++)
+            EXPECT_NEAR(adaptiveResult[i], result[i], 1e-8);
+        EXPECT_NEAR(adaptiveObjective, objective, 1e-8);
+        setQPSolver("qpOASES");
+    }
+
+
+    // Test that the first QP of the pivot loop is initialized from the solution of the contact problem,
+    // with the working set of the previous step when it has as many variables
+    void primalWarmStartTest()
+    {
+        const double Wdata[4][4] = {{2., 1., 0.5, 0.},
+                                    {1., 3., 1., 0.5},
+                                    {0.5, 1., 2., 0.},
+                                    {0., 0.5, 0., 1.}};
+        setActuatorsAndEffectorsProblem(Wdata);
+        m_qpCParams->constraintsId.clear();
+        setPrimalWarmStart(true);
+
+        // min 1/2 |x|^2 - (1 3) x, subject to x1 <= 2
+        qpOASES::real_t Q[4] = {1., 0., 0., 1.};
+        qpOASES::real_t c[2] = {-1., -3.};
+        qpOASES::real_t l[2] = {-10., -10.};
+        qpOASES::real_t u[2] = {10., 2.};
+        qpOASES::real_t x[2];
+
+        // The previous step had three variables, qpOASES guesses the working set from the guess
+        m_previousStepWorkingSet.bounds.assign(3, qpOASES::ST_INACTIVE);
+        m_pivotWorkingSet.clear();
+        m_pivotWorkingSet.enabled = true;
+        seedPivotWorkingSet({0.5, 2.});
+        EXPECT_TRUE(m_pivotWorkingSet.valid);
+        EXPECT_TRUE(m_pivotWorkingSet.bounds.empty());
+        EXPECT_TRUE(m_previousStepWorkingSet.bounds.empty());
+
+        qpOASES::QProblem problem(2, 0);
+        problem.setPrintLevel(qpOASES::PL_NONE);
+        int_t nWSR = 100;
+        ASSERT_TRUE(initWithPivotWorkingSet(problem, Q, c, l, u, nullptr, nullptr, nullptr, nWSR));
+        problem.getPrimalSolution(x);
+        EXPECT_NEAR(x[0], 1., 1e-10);
+        EXPECT_NEAR(x[1], 2., 1e-10);
+        EXPECT_EQ(getNbPrimalWarmStarts(), 1u);
+        EXPECT_EQ(getNbPivotWarmStarts(), 0u);
+
+        // Same number of variables, the working set of the previous step is used
+        m_previousStepWorkingSet.bounds = {qpOASES::ST_INACTIVE, qpOASES::ST_UPPER};
+        m_pivotWorkingSet.clear();
+        seedPivotWorkingSet({0., 0.});
+        ASSERT_EQ(m_pivotWorkingSet.bounds.size(), 2u);
+        EXPECT_EQ(m_pivotWorkingSet.bounds[1], qpOASES::ST_UPPER);
+
+        qpOASES::QProblem warmProblem(2, 0);
+        warmProblem.setPrintLevel(qpOASES::PL_NONE);
+        nWSR = 100;
+        ASSERT_TRUE(initWithPivotWorkingSet(warmProblem, Q, c, l, u, nullptr, nullptr, nullptr, nWSR));
+        warmProblem.getPrimalSolution(x);
+        EXPECT_NEAR(x[1], 2., 1e-10);
+        EXPECT_EQ(getNbPrimalWarmStarts(), 2u);
+
+        // A guess of another size is ignored
+        m_pivotWorkingSet.clear();
+        seedPivotWorkingSet({0., 0., 0.});
+        EXPECT_FALSE(m_pivotWorkingSet.valid);
+
+        m_previousStepWorkingSet.bounds = {qpOASES::ST_INACTIVE, qpOASES::ST_UPPER};
+        setPrimalWarmStart(false);
+        EXPECT_TRUE(m_previousStepWorkingSet.bounds.empty());
+        m_pivotWorkingSet.enabled = false;
+        clearProblem();
+    }
+
+
+    // Test that the rows of the pivot working set are found by variable id and rank, the missing ones
+    // being inactive
+    void pivotWorkingSetRowsTest()
+    {
+        QPPivotWorkingSet workingSet;
+        EXPECT_EQ(workingSet.getConstraintStatus(0, 0), qpOASES::ST_INACTIVE);
+
+        // Two rows on the variable 0, none on 1, one on 3, the negative ids are not stored
+        workingSet.appendConstraintStatus(-1, qpOASES::ST_UPPER);
+        workingSet.appendConstraintStatus(0, qpOASES::ST_LOWER);
+        workingSet.appendConstraintStatus(0, qpOASES::ST_UPPER);
+        workingSet.appendConstraintStatus(3, qpOASES::ST_LOWER);
+        EXPECT_EQ(workingSet.constraintOffsets, vector<unsigned int>({0, 2, 2, 2, 3}));
+        ASSERT_EQ(workingSet.constraints.size(), 3u);
+
+        EXPECT_EQ(workingSet.getConstraintStatus(0, 0), qpOASES::ST_LOWER);
+        EXPECT_EQ(workingSet.getConstraintStatus(0, 1), qpOASES::ST_UPPER);
+        EXPECT_EQ(workingSet.getConstraintStatus(0, 2), qpOASES::ST_INACTIVE);
+        EXPECT_EQ(workingSet.getConstraintStatus(1, 0), qpOASES::ST_INACTIVE);
+        EXPECT_EQ(workingSet.getConstraintStatus(3, 0), qpOASES::ST_LOWER);
+        EXPECT_EQ(workingSet.getConstraintStatus(4, 0), qpOASES::ST_INACTIVE);
+        EXPECT_EQ(workingSet.getConstraintStatus(-1, 0), qpOASES::ST_INACTIVE);
+
+        // The buffers are kept by clear()
+        const unsigned int* offsets = workingSet.constraintOffsets.data();
+        workingSet.clear();
+        EXPECT_EQ(workingSet.getConstraintStatus(0, 0), qpOASES::ST_INACTIVE);
+        workingSet.appendConstraintStatus(1, qpOASES::ST_UPPER);
+        EXPECT_EQ(workingSet.constraintOffsets.data(), offsets);
+        EXPECT_EQ(workingSet.getConstraintStatus(1, 0), qpOASES::ST_UPPER);
+    }
+
+
+    // Test that the approximations of the energy term only keep its diagonal, or its blocks of lines,
+    // with the same energy weight
+    void energyApproximationTest()
+    {
+        const double Wdata[4][4] = {{2., 1., 0.5, 0.},
+                                    {1., 3., 1., 0.5},
+                                    {0.5, 1., 2., 0.},
+                                    {0., 0.5, 0., 1.}};
+        const double weight = 1.75/4.; // ||Q||/||Waa||, see symmetricQTest()
+        setActuatorsAndEffectorsProblem(Wdata);
+        setEpsilon(1e-3);
+
+        setEnergyApproximation("Diagonal");
+        buildQPMatrices();
+        EXPECT_NEAR(m_qpSystem->Q[0][1], 0.5, 1e-12);
+        EXPECT_NEAR(m_qpSystem->Q[1][0], 0.5, 1e-12);
+        EXPECT_NEAR(m_qpSystem->Q[0][0], 0.25 + 1e-3*weight*2., 1e-12);
+        EXPECT_NEAR(m_qpSystem->Q[1][1], 1.25 + 1e-3*weight*3., 1e-12);
+
+        // Two actuators of one line each: the blocks are the diagonal
+        setEnergyApproximation("BlockDiagonal");
+        EXPECT_EQ(getEnergyBlockFirst(1), 1u);
+        buildQPMatrices();
+        EXPECT_NEAR(m_qpSystem->Q[0][1], 0.5, 1e-12);
+
+        // The two variables as the lines of one actuator
+        m_qpCLists->variableRows[1].line = 1;
+        EXPECT_EQ(getEnergyBlockFirst(1), 0u);
+        buildQPMatrices();
+        EXPECT_NEAR(m_qpSystem->Q[0][1], 0.5 + 1e-3*weight, 1e-12);
+
+        setEnergyApproximation("Full");
+        EXPECT_EQ(getEnergyBlockFirst(1), 0u);
+
+        setEpsilon(0.);
+        clearProblem();
+    }
+
+
+    // Test that W(x, x) is gathered in the order of the variables, and kept within a resolution only
+    void permutedComplianceTest()
+    {
+        const double Wdata[4][4] = {{2., 1., 0.5, 0.},
+                                    {1., 3., 1., 0.5},
+                                    {0.5, 1., 2., 0.},
+                                    {0., 0.5, 0., 1.}};
+        setActuatorsAndEffectorsProblem(Wdata);
+
+        // Actuators 3 and 0, then the contact 1
+        m_qpCLists->actuatorRowIds = {3, 0};
+        m_qpCLists->effectorRowIds = {2};
+        m_qpCLists->contactRowIds = {1};
+        m_qpSystem->dim = 3;
+        const unsigned int ids[3] = {3, 0, 1};
+        const QPPermutedCompliance& Wx = updatePermutedCompliance();
+        ASSERT_EQ(Wx.getDimension(), 3u);
+        for(unsigned int i=0; i<3; i++)
+            for(unsigned int j=0; j<3; j++)
+                EXPECT_EQ(Wx[i][j], Wdata[ids[i]][ids[j]]);
+
+        // Out of solve(), a change of W is read at the next call
+        W[0][1] = W[1][0] = 4.;
+        EXPECT_EQ(updatePermutedCompliance()[1][2], 4.);
+
+        // Within solve(), the block is gathered once
+        m_isPermutedComplianceKept = true;
+        W[0][1] = W[1][0] = 5.;
+        EXPECT_EQ(updatePermutedCompliance()[1][2], 4.);
+        m_permutedCompliance.invalidate();
+        EXPECT_EQ(updatePermutedCompliance()[1][2], 5.);
+        m_isPermutedComplianceKept = false;
+
+        computeContactDeltas({1., 2., 3.});
+        ASSERT_EQ(getContactDeltas().size(), 1u);
+        EXPECT_NEAR(getContactDeltas()[0], dFree[1] + 0.5*1. + 5.*2. + 3.*3., 1e-12);
+
+        // The float copy of the block gives the same projected Gauss-Seidel resolution as the double one
+        const QPPermutedCompliance& Wd = updatePermutedCompliance();
+        QPPermutedComplianceF Wf;
+        Wf.gather(m_qpSystem->W, m_workspace.variableIds, m_variableColumnBlocks);
+        ASSERT_EQ(Wf.getDimension(), 3u);
+        double M[3][3];
+        double* Mrows[3] = {M[0], M[1], M[2]};
+        for(unsigned int i=0; i<3; i++)
+            for(unsigned int j=0; j<3; j++)
+            {
+                M[i][j] = Wd[i][j];
+                EXPECT_EQ(Wf.getRows()[i][j], (float)Wd[i][j]);
+            }
+
+        LCPPGSSolver pgs;
+        pgs.setTolerance(1e-6);
+        double q[3] = {-1., 0.5, -2.};
+        double x[3] = {0., 0., 0.};
+        double xf[3] = {0., 0., 0.};
+        EXPECT_TRUE(pgs.solve(3, q, Mrows, x));
+        EXPECT_TRUE(pgs.solve(3, q, Wf.getRows(), xf));
+        for(unsigned int i=0; i<3; i++)
+            EXPECT_NEAR(xf[i], x[i], 1e-5);
+
+        clearProblem();
+    }
+
+
+    void structuredFactorizationTest()
+    {
+        // Three groups of two variables, only coupled through the last two (e.g. fingers and contacts)
+        const int n = 8;
+        Eigen::MatrixXd K = Eigen::MatrixXd::Zero(n, n);
+        for(int g=0; g<3; g++)
+        {
+            K(2*g, 2*g) = K(2*g+1, 2*g+1) = 4.;
+            K(2*g, 2*g+1) = K(2*g+1, 2*g) = 1.;
+            K(2*g, 6) = K(6, 2*g) = 0.5;
+            K(2*g+1, 7) = K(7, 2*g+1) = -0.5;
+        }
+        K(6, 6) = K(7, 7) = 3.;
+
+        Eigen::VectorXd b(n);
+        b << 1., -2., 3., 0.5, -1., 2., 0.25, -0.75;
+
+        QPBorderedFactorization factorization;
+        factorization.setBorderSize(2);
+        ASSERT_TRUE(factorization.compute(K));
+        EXPECT_TRUE(factorization.isStructured());
+        EXPECT_EQ(factorization.getNbBlocks(), 3u);
+        EXPECT_EQ(factorization.getBorderDimension(), 2u);
+        EXPECT_LT((K*factorization.solve(b) - b).lpNorm<Eigen::Infinity>(), 1e-12);
+
+        // Unconstrained QP of Hessian K: same solution with the factorization by blocks
+        const Eigen::VectorXd expected = -K.ldlt().solve(b);
+        ADMMSolverBackend admm;
+        admm.setStructuredFactorization(true, 2);
+        Eigen::VectorXd x(n), y(n);
+        qpOASES::real_t objective;
+        admm.solve(n, 0, K.data(), b.data(), nullptr, nullptr, nullptr, nullptr, nullptr, x.data(), y.data(), objective);
+        EXPECT_TRUE(admm.getStructuredFactorization().isStructured());
+        EXPECT_LT((x - expected).lpNorm<Eigen::Infinity>(), 1e-4);
+
+        // Groups coupled together: K is factorized as a whole
+        K(1, 2) = K(2, 1) = 0.1;
+        K(3, 4) = K(4, 3) = 0.1;
+        ASSERT_TRUE(factorization.compute(K));
+        EXPECT_FALSE(factorization.isStructured());
+        EXPECT_LT((K*factorization.solve(b) - b).lpNorm<Eigen::Infinity>(), 1e-12);
+    }
+
+
+    void adaptiveEpsilonTest()
+    {
+        QPAdaptiveEpsilon adaptive;
+        adaptive.setAdaptive(true, 1e2, 1e8);
+        adaptive.setRefreshPeriod(3);
+        EXPECT_TRUE(adaptive.isRefreshNeeded(2, 1., 1.));
+        adaptive.setWeight(0.5, 2, 1., 1.);
+        EXPECT_FALSE(adaptive.isRefreshNeeded(2, 1.5, 1.));
+        EXPECT_NEAR(adaptive.getWeight(1.5, 1.), 0.75, 1e-12);
+        EXPECT_TRUE(adaptive.isRefreshNeeded(2, 2.5, 1.)); // drift of the trace of Q
+        EXPECT_TRUE(adaptive.isRefreshNeeded(2, 1., 0.4)); // drift of the trace of W
+        EXPECT_TRUE(adaptive.isRefreshNeeded(3, 1., 1.));  // new dimension
+        EXPECT_FALSE(adaptive.isRefreshNeeded(2, 1., 1.));
+        adaptive.getWeight(1., 1.);
+        EXPECT_TRUE(adaptive.isRefreshNeeded(2, 1., 1.));  // refresh period
+
+        adaptive.updateScale(1e9);
+        EXPECT_EQ(adaptive.getScale(), 2.);
+        adaptive.updateScale(1e4);
+        EXPECT_EQ(adaptive.getScale(), 2.);
+        adaptive.addIndefiniteHessian();
+        EXPECT_EQ(adaptive.getScale(), 20.);
+        adaptive.setAdaptive(false, 1e2, 1e8);
+        EXPECT_EQ(adaptive.getScale(), 1.);
+
+        // Problem of energyApproximationTest, the diagonal of Q has a conditioning of about 5
+        const double Wdata[4][4] = {{2., 1., 0.5, 0.},
+                                    {1., 3., 1., 0.5},
+                                    {0.5, 1., 2., 0.},
+                                    {0., 0.5, 0., 1.}};
+        const double weight = 1.75/4.; // ||Q||/||Waa||, see symmetricQTest()
+        setActuatorsAndEffectorsProblem(Wdata);
+        setEpsilon(1e-3);
+
+        setAdaptiveEpsilon(true, 1., 1e8);
+        buildQPMatrices();
+        EXPECT_EQ(getNbEnergyNormRefreshes(), 1u);
+        EXPECT_NEAR(m_qpSystem->Q[0][0], 0.25 + 1e-3*weight*2., 1e-12);
+
+        // Same matrices: the weight is extrapolated from the traces, without the norms
+        buildQPMatrices();
+        EXPECT_EQ(getNbEnergyNormRefreshes(), 1u);
+        EXPECT_NEAR(m_qpSystem->Q[0][0], 0.25 + 1e-3*weight*2., 1e-12);
+        EXPECT_EQ(getEpsilonScale(), 1.);
+
+        // Below the target range, epsilon is halved at each step
+        setAdaptiveEpsilon(true, 1e2, 1e8);
+        buildQPMatrices();
+        EXPECT_EQ(getEpsilonScale(), 0.5);
+        buildQPMatrices();
+        EXPECT_NEAR(m_qpSystem->Q[0][0], 0.25 + 0.5e-3*weight*2., 1e-12);
+        EXPECT_EQ(getEpsilonScale(), 0.25);
+
+        // A QP solved again with an indefinite Hessian increases it
+        setRecovery(QPRecovery::IndefiniteHessian);
+        EXPECT_EQ(getEpsilonScale(), 2.5);
+        m_recovery = QPRecovery::None;
+
+        setAdaptiveEpsilon(false, 1e2, 1e8);
+        EXPECT_EQ(getEpsilonScale(), 1.);
+        setEpsilon(0.);
+        clearProblem();
+    }
+
+
+    void problemPoolTest()
+    {
+        QPProblemPool pool;
+        pool.setCapacity(1);
+        QPInverseProblemImpl* first = pool.acquire();
+        QPInverseProblemImpl* second = pool.acquire();
+        EXPECT_EQ(pool.getNbReuses(), 0u);
+
+        pool.release(first);
+        pool.release(second); // beyond the capacity, deleted
+        pool.release(nullptr);
+        EXPECT_EQ(pool.getNbProblems(), 1u);
+        EXPECT_EQ(pool.acquire(), first);
+        EXPECT_EQ(pool.getNbReuses(), 1u);
+        EXPECT_EQ(pool.getNbProblems(), 0u);
+
+        pool.release(first);
+        pool.clear();
+        EXPECT_EQ(pool.getNbProblems(), 0u);
+
+        // The state carried across the steps is cleared, as in a new problem
+        m_step = 3;
+        m_nbHotStartHits = 2;
+        m_pivotWorkingSet.valid = true;
+        m_activeBounds = {1, 0};
+        resetResolutionState();
+        EXPECT_EQ(m_step, 0);
+        EXPECT_EQ(getNbHotStartHits(), 0u);
+        EXPECT_FALSE(m_pivotWorkingSet.valid);
+        EXPECT_TRUE(m_activeBounds.empty());
+    }
+
+
+    // Test the fixed-size kernel against qpOASES, on a QP with active bounds, an active constraint and an
+    // equality, and that it fails on an infeasible problem or an indefinite Hessian
+    void smallProblemTest()
+    {
+        const int n = 3, m = 2;
+        qpOASES::real_t Q[n*n] = {4., 1., 0.,
+                                  1., 3., 0.5,
+                                  0., 0.5, 2.};
+        qpOASES::real_t c[n] = {-8., 3., -6.};
+        qpOASES::real_t l[n] = {0., 0., 0.};
+        qpOASES::real_t u[n] = {1.5, 10., 10.};
+        qpOASES::real_t A[m*n] = {1., 1., 1.,
+                                  1., -1., 0.};
+        qpOASES::real_t bl[m] = {-1e20, 1.};
+        qpOASES::real_t bu[m] = {2., 1.};
+
+        QPSmallProblem smallProblem;
+        qpOASES::real_t x[n], y[n+m], objective;
+        ASSERT_TRUE(smallProblem.solve(n, m, Q, c, A, l, u, bl, bu, x, y, objective, 100));
+
+        qpOASES::QProblem problem(n, m);
+        problem.setPrintLevel(qpOASES::PL_NONE);
+        qpOASES::int_t nWSR = 100;
+        ASSERT_EQ(problem.init(Q, c, A, l, u, bl, bu, nWSR), qpOASES::SUCCESSFUL_RETURN);
+        qpOASES::real_t expectedX[n], expectedY[n+m];
+        problem.getPrimalSolution(expectedX);
+        problem.getDualSolution(expectedY);
+        for(int i=0; i<n; i++)
+            EXPECT_NEAR(x[i], expectedX[i], 1e-10);
+        for(int i=0; i<n+m; i++)
+            EXPECT_NEAR(y[i], expectedY[i], 1e-9);
+        EXPECT_NEAR(objective, problem.getObjVal(), 1e-10);
+
+        // Unconstrained problem
+        ASSERT_TRUE(smallProblem.solve(n, 0, Q, c, nullptr, nullptr, nullptr, nullptr, nullptr, x, y, objective, 100));
+        EXPECT_EQ(smallProblem.getNbIterations(), 0);
+
+        // Infeasible: x0 - x1 = 1 with x0 <= 0.5 and x1 >= 0
+        qpOASES::real_t infeasibleU[n] = {0.5, 10., 10.};
+        EXPECT_FALSE(smallProblem.solve(n, m, Q, c, A, l, infeasibleU, bl, bu, x, y, objective, 100));
+
+        // Indefinite Hessian
+        Q[0] = -1.;
+        EXPECT_FALSE(smallProblem.solve(n, m, Q, c, A, l, u, bl, bu, x, y, objective, 100));
+
+        EXPECT_TRUE(QPSmallProblem::isSupported(16, 32));
+        EXPECT_FALSE(QPSmallProblem::isSupported(17, 0));
+        EXPECT_FALSE(QPSmallProblem::isSupported(4, 33));
+    }
+
+
+    // Test the boundaries of the contacts found in one pass, against the contact handlers
+    void contactStatesTest()
+    {
+        softrobotsinverse::solver::module::FrictionCone cone;
+        QPContactStates contactStates;
+        contactStates.setFriction(0.5, true, cone);
+        contactStates.getStates() = {QPContactStates::Inactive, QPContactStates::Stick,
+                                     QPContactStates::Stick, QPContactStates::Sliding, QPContactStates::Sliding};
+
+        // (lambda_n, lambda_t, lambda_o) and (delta_n, delta_t, delta_o) of each contact
+        const vector<double> lambda = {1., 0., 0.,      // inactive
+                                       1., 0.25, 0.25,  // stick, on the cone
+                                       0., 0.1, 0.,     // stick, no normal force
+                                       1., 0.5, 0.,     // sliding
+                                       1., 0.5, 0.};    // sliding, stopped
+        const vector<double> delta = {0., 0., 0.,
+                                      0., 0., 0.,
+                                      0., 0., 0.,
+                                      0., 0.1, 0.,
+                                      0., 0., 0.};
+
+        vector<int> candidates;
+        EXPECT_EQ(contactStates.findBoundaries(lambda.data(), delta.data(), candidates), 4u);
+        EXPECT_EQ(candidates, vector<int>({QPContactStates::s_normalCandidate, QPContactStates::s_slidingCandidates,
+                                           QPContactStates::s_normalCandidate, QPContactStates::s_noCandidate,
+                                           QPContactStates::s_slidingCandidates}));
+        EXPECT_EQ(contactStates.getNewState(0, lambda.data(), delta.data()), QPContactStates::Stick);
+        EXPECT_EQ(contactStates.getNewState(1, lambda.data(), delta.data()), QPContactStates::Sliding);
+        EXPECT_EQ(contactStates.getNewState(2, lambda.data(), delta.data()), QPContactStates::Inactive);
+        EXPECT_EQ(contactStates.getNewState(4, lambda.data(), delta.data()), QPContactStates::Stick);
+
+        // The handlers apply the same rules
+        softrobotsinverse::solver::module::InactiveContactHandler inactive;
+        softrobotsinverse::solver::module::StickContactHandler stick;
+        softrobotsinverse::solver::module::SlidingContactHandler sliding;
+        vector<softrobotsinverse::solver::module::ContactHandler*> handlers = {&inactive, &stick, &sliding};
+        for(auto* handler : handlers)
+        {
+            handler->setAllowSliding(true);
+            handler->setFrictionCone(cone);
+        }
+        int candidateId = -1;
+        EXPECT_TRUE(stick.hasReachedBoundary({1., 0.25, 0.25}, {0., 0., 0.}, 0.5, candidateId));
+        EXPECT_EQ(candidateId, QPContactStates::s_slidingCandidates);
+        EXPECT_EQ(stick.getNewContactHandler(handlers, {1., 0.25, 0.25}, {0., 0., 0.}, 0.5), &sliding);
+        EXPECT_EQ(sliding.getNewContactHandler(handlers, {0., 0., 0.}, {0., 0., 0.}, 0.5), &inactive);
+
+        // Frictionless contacts, one row each
+        contactStates.setFriction(0., false, cone);
+        contactStates.getStates() = {QPContactStates::Active, QPContactStates::Inactive, QPContactStates::Active};
+        const vector<double> lambdaN = {0., 0., 1.};
+        const vector<double> deltaN = {0., 0., 0.};
+        EXPECT_EQ(contactStates.findBoundaries(lambdaN.data(), deltaN.data(), candidates), 2u);
+        EXPECT_EQ(candidates[2], QPContactStates::s_noCandidate);
+        EXPECT_EQ(contactStates.getNewState(1, lambdaN.data(), deltaN.data()), QPContactStates::Active);
+    }
+
+
+    // Test that the contacts of a patch are refined only when one of them disagrees with the state of the patch
+    void contactPatchesTest()
+    {
+        clear(3);
+        W[0][0] = W[1][1] = W[2][2] = 1.;
+        W[0][1] = W[1][0] = 0.9;
+        dFree[0] = dFree[1] = dFree[2] = -1.;
+
+        QPInverseProblem::QPConstraintLists lists;
+        lists.contactRowIds = {0, 1, 2};
+
+        QPContactPatches patches;
+        ASSERT_EQ(patches.coarsen(&lists, getW(), getDfree(), 1), 1u);
+        EXPECT_EQ(patches.getNbPatches(), 1u);
+        EXPECT_EQ(lists.contactRowIds, vector<unsigned int>({0, 2}));
+
+        // The force of the patch closes both of its contacts
+        const double scaleSum = 1. + 1.8/1.81;
+        sofa::type::vector<double> x = {scaleSum/1.9, 1.};
+        patches.expand(&lists, x);
+        EXPECT_EQ(lists.contactRowIds, vector<unsigned int>({0, 1, 2}));
+        EXPECT_NEAR(x[0], 1./1.9, 1e-12);
+        EXPECT_NEAR(x[1], 1./1.9, 1e-12);
+        EXPECT_EQ(patches.findBoundaries(&lists, getW(), getDfree(), x, 0.), 0u);
+
+        // A separated patch whose contacts penetrate
+        x = {0., 0., 1.};
+        EXPECT_EQ(patches.findBoundaries(&lists, getW(), getDfree(), x, 0.), 1u);
+
+        // The second contact of the patch separates, its contacts are solved individually
+        dFree[1] = 0.5;
+        patches.coarsen(&lists, getW(), getDfree(), 1);
+        x = {scaleSum/1.9, 1.};
+        patches.expand(&lists, x);
+        EXPECT_EQ(patches.findBoundaries(&lists, getW(), getDfree(), x, 0.), 1u);
+        EXPECT_EQ(patches.getNbRefinedPatches(), 1u);
+        EXPECT_EQ(patches.refine(&lists, getW(), getDfree(), 1), 0u);
+        EXPECT_FALSE(patches.isReduced());
+        EXPECT_EQ(lists.contactRowIds, vector<unsigned int>({0, 1, 2}));
+    }
+
+
+    // Test that the force of a coupling contact converges to the multiplier of its non-penetration, and that
+    // the nodes of a channel read the entries of all of them
+    void consensusTest()
+    {
+        // delta = 2 f - 1 on a single node
+        QPConsensus consensus;
+        consensus.setTolerance(1e-10);
+        consensus.setNbIterations(100);
+        consensus.beginStep({7}, {2.});
+        sofa::type::vector<double> deltas(1);
+        do
+            deltas[0] = 2.*consensus.getForces()[0] - 1.;
+        while(consensus.update(deltas));
+        EXPECT_NEAR(consensus.getForces()[0], 0.5, 1e-9);
+        EXPECT_FALSE(consensus.hasTimedOut());
+
+        // The force of the previous step is kept, a separated contact has no force
+        consensus.beginStep({7, 8}, {2., 1.});
+        EXPECT_NEAR(consensus.getForces()[0], 0.5, 1e-9);
+        EXPECT_EQ(consensus.getForces()[1], 0.);
+        deltas = {0., 1.};
+        EXPECT_FALSE(consensus.update(deltas) && consensus.update(deltas) && consensus.update(deltas));
+        EXPECT_EQ(consensus.getForces()[1], 0.);
+
+#if defined(__unix__) || defined(__APPLE__)
+        QPConsensusChannel node0, node1;
+        EXPECT_FALSE(node0.open("softrobotsinverse_consensus_test", 2, 2, 4));
+        ASSERT_TRUE(node0.open("softrobotsinverse_consensus_test", 0, 2, 4));
+        ASSERT_TRUE(node1.open("/softrobotsinverse_consensus_test", 1, 2, 4));
+
+        sofa::type::vector<QPConsensusChannel::Entry> entries0(1), entries1(2), gathered;
+        entries0[0] = {1, 2., 1.};
+        entries1[0] = {1, 3., 0.5};
+        entries1[1] = {2, 1., 1.};
+        double change = 0.;
+        node0.publish(1, entries0, 0.5);
+        EXPECT_FALSE(node0.gather(1, 0., gathered, change));
+        node1.publish(1, entries1, 0.25);
+        ASSERT_TRUE(node0.gather(1, 0., gathered, change));
+        ASSERT_EQ(gathered.size(), 3u);
+        EXPECT_EQ(gathered[0].delta + gathered[1].delta, 5.);
+        EXPECT_EQ(gathered[2].key, 2u);
+        EXPECT_EQ(change, 0.5);
+
+        // The next exchange does not overwrite the current one
+        node0.publish(2, entries0, 0.);
+        ASSERT_TRUE(node1.gather(1, 0., gathered, change));
+        EXPECT_EQ(gathered.size(), 3u);
+        EXPECT_FALSE(node1.gather(2, 0., gathered, change));
+        node1.close();
+        node0.close();
+#endif
+    }
+
+
+    // Test the derivatives of the solution of a QP from its active set, against finite differences
+    void sensitivityTest()
+    {
+        const int n = 3, ASize = 1, AeqSize = 1, m = ASize + AeqSize;
+        double Q[n*n] = {4., 1., 0.,
+                         1., 3., 0.5,
+                         0., 0.5, 2.};
+        double c[n] = {-8., 3., -6.};
+        double l[n] = {0., 0., 0.};
+        double u[n] = {1.5, 10., 10.};
+        double A[m*n] = {1., 1., 1.,   // x0 + x1 + x2 <= 2
+                         1., -1., 0.}; // x0 - x1 = 0.5
+        double bl[m] = {-1e20, 0.5};
+        double bu[m] = {2., 0.5};
+
+        QPInverseProblem::QPSystem system;
+        system.dim = n;
+        system.Q.resize(n, n);
+        std::copy(Q, Q+n*n, system.Q.data());
+        system.A.resize(ASize, n);
+        std::copy(A, A+ASize*n, system.A.data());
+        system.Aeq.resize(AeqSize, n);
+        std::copy(A+ASize*n, A+m*n, system.Aeq.data());
+
+        auto solve = [&](double* x, double* y)
+        {
+            qpOASES::QProblem problem(n, m);
+            problem.setPrintLevel(qpOASES::PL_NONE);
+            qpOASES::int_t nWSR = 100;
+            ASSERT_EQ(problem.init(Q, c, A, l, u, bl, bu, nWSR), qpOASES::SUCCESSFUL_RETURN);
+            problem.getPrimalSolution(x);
+            if(y)
+                problem.getDualSolution(y);
+        };
+
+        double x[n], y[n+m];
+        solve(x, y);
+
+        QPSensitivity sensitivity;
+        ASSERT_TRUE(sensitivity.compute(system, y));
+        EXPECT_EQ(sensitivity.getNbActiveBounds(), 1u);
+        EXPECT_EQ(sensitivity.getNbActiveConstraints(), 2u);
+
+        // Finite differences of the solution, after shifting the data by h
+        const double h = 1e-6;
+        double xh[n];
+        auto expectColumn = [&](const QPSensitivity::RowMajorMatrixXd& derivatives, const int& column)
+        {
+            solve(xh, nullptr);
+            for(int k=0; k<n; k++)
+                EXPECT_NEAR(derivatives(k, column), (xh[k]-x[k])/h, 1e-5);
+        };
+
+        for(int j=0; j<n; j++)
+        {
+            c[j] += h;
+            expectColumn(sensitivity.getLinearTermSensitivity(), j);
+            c[j] -= h;
+        }
+
+        bu[0] += h;
+        expectColumn(sensitivity.getConstraintSensitivity(), 0);
+        bu[0] -= h;
+
+        bl[1] += h;
+        bu[1] += h;
+        expectColumn(sensitivity.getConstraintSensitivity(), 1);
+        bl[1] -= h;
+        bu[1] -= h;
+
+        // x1 is at its lower bound, the other variables are free
+        EXPECT_NEAR(x[1], 0., 1e-12);
+        l[1] += h;
+        expectColumn(sensitivity.getBoundSensitivity(), 1);
+        l[1] -= h;
+        for(int k=0; k<n; k++)
+        {
+            EXPECT_EQ(sensitivity.getBoundSensitivity()(k, 0), 0.);
+            EXPECT_EQ(sensitivity.getBoundSensitivity()(k, 2), 0.);
+        }
+
+        // Linearly dependent active rows
+        system.Aeq.resize(2, n);
+        std::copy(A+ASize*n, A+m*n, system.Aeq[1]);
+        double dependentDual[n+m+1] = {y[0], y[1], y[2], y[3], y[4], y[4]};
+        EXPECT_FALSE(sensitivity.compute(system, dependentDual));
+        EXPECT_FALSE(sensitivity.isValid());
+    }
+
+
+    void updateLambdaTest()
+    {
+        m_qpSystem->dim = 5;
+        std::vector<double> lambda = {1,2,3,4,5};
+        updateLambda(lambda);
+        EXPECT_EQ(lambda,m_qpSystem->lambda);
+    }
+
+};
+
+
+using ::testing::Types;
+typedef Types<Vec3Types> DataTypes;
+
+TYPED_TEST_SUITE(QPInverseProblemImplTest, DataTypes);
+
+TYPED_TEST(QPInverseProblemImplTest, isInTest) {
+    ASSERT_NO_THROW( this->isInTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, isCyclingOnPivotTest) {
+    ASSERT_NO_THROW( this->isCyclingOnPivotTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, isCyclingOnSequenceTest) {
+    ASSERT_NO_THROW( this->isCyclingOnSequenceTest1() );
+    ASSERT_NO_THROW( this->isCyclingOnSequenceTest2() );
+    ASSERT_NO_THROW( this->isCyclingOnSequenceTest3() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, leaveSequenceUnchangedTest) {
+    ASSERT_NO_THROW( this->leaveSequenceUnchangedTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, leaveCurrentSequenceUnchangedTest) {
+    ASSERT_NO_THROW( this->leaveCurrentSequenceUnchangedTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, pivotSequenceTest) {
+    ASSERT_NO_THROW( this->pivotSequenceTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, updateLambdaTest) {
+    ASSERT_NO_THROW( this->updateLambdaTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, workspaceAllocationTest) {
+    ASSERT_NO_THROW( this->workspaceAllocationTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, qpMatrixViewTest) {
+    ASSERT_NO_THROW( this->qpMatrixViewTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, boundedProblemTest) {
+    ASSERT_NO_THROW( this->boundedProblemTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, admmSolverTest) {
+    ASSERT_NO_THROW( this->admmSolverTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, contactFreeHotStartTest) {
+    ASSERT_NO_THROW( this->contactFreeHotStartTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, swapResolutionStateTest) {
+    ASSERT_NO_THROW( this->swapResolutionStateTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, timeBudgetTest) {
+    ASSERT_NO_THROW( this->timeBudgetTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, softRecoveryTest) {
+    ASSERT_NO_THROW( this->softRecoveryTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, lcpSolversTest) {
+    ASSERT_NO_THROW( this->lcpSolversTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, coloredNLCPTest) {
+    ASSERT_NO_THROW( this->coloredNLCPTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, nlcpReportTest) {
+    ASSERT_NO_THROW( this->nlcpReportTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, mixedPrecisionNLCPTest) {
+    ASSERT_NO_THROW( this->mixedPrecisionNLCPTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, sparseContactSolversTest) {
+    ASSERT_NO_THROW( this->sparseContactSolversTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, problemRecorderTest) {
+    ASSERT_NO_THROW( this->problemRecorderTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, resultLoggerTest) {
+    ASSERT_NO_THROW( this->resultLoggerTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, problemCaptureTest) {
+    ASSERT_NO_THROW( this->problemCaptureTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, clearBlocksTest) {
+    ASSERT_NO_THROW( this->clearBlocksTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, problemDecompositionTest) {
+    ASSERT_NO_THROW( this->problemDecompositionTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, batchSolverTest) {
+    ASSERT_NO_THROW( this->batchSolverTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, standaloneProblemTest) {
+    ASSERT_NO_THROW( this->standaloneProblemTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, horizonProblemTest) {
+    ASSERT_NO_THROW( this->horizonProblemTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, sparseQPTest) {
+    ASSERT_NO_THROW( this->sparseQPTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, hessianBackendTest) {
+    ASSERT_NO_THROW( this->hessianBackendTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, threadAffinityTest) {
+    ASSERT_NO_THROW( this->threadAffinityTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, concurrentInstancesTest) {
+    ASSERT_NO_THROW( this->concurrentInstancesTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, adaptiveLimitTest) {
+    ASSERT_NO_THROW( this->adaptiveLimitTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, contactReductionTest) {
+    ASSERT_NO_THROW( this->contactReductionTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, frictionConeTest) {
+    ASSERT_NO_THROW( this->frictionConeTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, constraintRowsReuseTest) {
+    ASSERT_NO_THROW( this->constraintRowsReuseTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, fusedConstraintMatricesTest) {
+    ASSERT_NO_THROW( this->fusedConstraintMatricesTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, contactModelTest) {
+    ASSERT_NO_THROW( this->contactModelTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, contactLimitsTest) {
+    ASSERT_NO_THROW( this->contactLimitsTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, blockPivotingTest) {
+    ASSERT_NO_THROW( this->blockPivotingTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, contactDeltasTest) {
+    ASSERT_NO_THROW( this->contactDeltasTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, presolveTest) {
+    ASSERT_NO_THROW( this->presolveTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, scalingTest) {
+    ASSERT_NO_THROW( this->scalingTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, equalityEliminationTest) {
+    ASSERT_NO_THROW( this->equalityEliminationTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, activeSetCacheTest) {
+    ASSERT_NO_THROW( this->activeSetCacheTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, parametricQPTest) {
+    ASSERT_NO_THROW( this->parametricQPTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, constraintViolationsTest) {
+    ASSERT_NO_THROW( this->constraintViolationsTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, exportDualsTest) {
+    ASSERT_NO_THROW( this->exportDualsTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, checkpointTest) {
+    ASSERT_NO_THROW( this->checkpointTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, perfCountersTest) {
+    ASSERT_NO_THROW( this->perfCountersTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, telemetryStreamTest) {
+    ASSERT_NO_THROW( this->telemetryStreamTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, rowBlocksTest) {
+    ASSERT_NO_THROW( this->rowBlocksTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, variableRowsTest) {
+    ASSERT_NO_THROW( this->variableRowsTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, symmetricQTest) {
+    ASSERT_NO_THROW( this->symmetricQTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, hessianReuseTest) {
+    ASSERT_NO_THROW( this->hessianReuseTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, effectorWeightsTest) {
+    ASSERT_NO_THROW( this->effectorWeightsTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, disabledConstraintsTest) {
+    ASSERT_NO_THROW( this->disabledConstraintsTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, stepScratchReuseTest) {
+    ASSERT_NO_THROW( this->stepScratchReuseTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, changeDetectionTest) {
+    ASSERT_NO_THROW( this->changeDetectionTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, solveContactsOnlyTest) {
+    ASSERT_NO_THROW( this->solveContactsOnlyTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, forwardWithoutEffectorsTest) {
+    ASSERT_NO_THROW( this->forwardWithoutEffectorsTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, prioritizedEffectorsTest) {
+    ASSERT_NO_THROW( this->prioritizedEffectorsTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, batchedComplianceTest) {
+    ASSERT_NO_THROW( this->batchedComplianceTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, profileReportTest) {
+    ASSERT_NO_THROW( this->profileReportTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, condensedEffectorsTest) {
+    ASSERT_NO_THROW( this->condensedEffectorsTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, primalWarmStartTest) {
+    ASSERT_NO_THROW( this->primalWarmStartTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, pivotWorkingSetRowsTest) {
+    ASSERT_NO_THROW( this->pivotWorkingSetRowsTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, energyApproximationTest) {
+    ASSERT_NO_THROW( this->energyApproximationTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, permutedComplianceTest) {
+    ASSERT_NO_THROW( this->permutedComplianceTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, structuredFactorizationTest) {
+    ASSERT_NO_THROW( this->structuredFactorizationTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, adaptiveEpsilonTest) {
+    ASSERT_NO_THROW( this->adaptiveEpsilonTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, problemPoolTest) {
+    ASSERT_NO_THROW( this->problemPoolTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, taskPoolTest) {
+    ASSERT_NO_THROW( this->taskPoolTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, smallProblemTest) {
+    ASSERT_NO_THROW( this->smallProblemTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, contactStatesTest) {
+    ASSERT_NO_THROW( this->contactStatesTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, contactPatchesTest) {
+    ASSERT_NO_THROW( this->contactPatchesTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, consensusTest) {
+    ASSERT_NO_THROW( this->consensusTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, sensitivityTest) {
+    ASSERT_NO_THROW( this->sensitivityTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, productionModeTest) {
+    ASSERT_NO_THROW( this->productionModeTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, speculativePivotsTest)
+{
+    ASSERT_NO_THROW( this->speculativePivotsTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, matrixFreeSolverTest)
+{
+    ASSERT_NO_THROW( this->matrixFreeSolverTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, lazyContactComplianceTest)
+{
+    ASSERT_NO_THROW( this->lazyContactComplianceTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, symmetricComplianceTest)
+{
+    ASSERT_NO_THROW( this->symmetricComplianceTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, nlcpContactBatchTest)
+{
+    ASSERT_NO_THROW( this->nlcpContactBatchTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, effectorSketchTest)
+{
+    ASSERT_NO_THROW( this->effectorSketchTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, interiorFastPathTest)
+{
+    ASSERT_NO_THROW( this->interiorFastPathTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, messageQueueTest)
+{
+    ASSERT_NO_THROW( this->messageQueueTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, effectorDeadbandTest)
+{
+    ASSERT_NO_THROW( this->effectorDeadbandTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, contactTrackerTest)
+{
+    ASSERT_NO_THROW( this->contactTrackerTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, warmStartContactsTest) {
+    ASSERT_NO_THROW( this->warmStartContactsTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, storagePolicyTest)
+{
+    ASSERT_NO_THROW( this->storagePolicyTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, qpOASESStatisticsTest)
+{
+    ASSERT_NO_THROW( this->qpOASESStatisticsTest() );
+}
+
+TYPED_TEST(QPInverseProblemImplTest, backendSelectorTest)
+{
+    ASSERT_NO_THROW( this->backendSelectorTest() );
 }
 
 
@@ -1,3 +1,11 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <sstream>
 #include <string>
 using std::string ;
 #include <sofa/testing/BaseTest.h>
@@ -5,6 +13,7 @@ using sofa::testing::BaseTest ;
 #include <sofa/helper/BackTrace.h>
 #include <sofa/helper/system/Locale.h>
 #include <sofa/component/statecontainer/MechanicalObject.h>
+#include <sofa/core/ObjectFactory.h>
 
 
 using sofa::helper::WriteAccessor ;
@@ -24,6 +33,8 @@ using sofa::component::statecontainer::MechanicalObject ;
 
 #include <SoftRobots.Inverse/component/solver/QPInverseProblemSolver.h>
 using softrobotsinverse::solver::QPInverseProblemSolver ;
+#include <SoftRobots.Inverse/component/constraint/MatrixFreeConstraintCorrection.h>
+using softrobotsinverse::constraint::MatrixFreeConstraintCorrection ;
 
 using sofa::type::vector;
 using std::fabs;
@@ -132,6 +143,986 @@ struct QPInverseProblemSolverTest : public BaseTest,
     }
 
 
+    // Animates the finger toward a fixed goal with the given solver data set, and returns the cable force
+    float getCableForce(const string& dataName, const string& value, const std::map<string, string>& otherData = {})
+    {
+        SetUp();
+
+        m_root->getObject("QPInverseProblemSolver")->findData(dataName)->read(value);
+        for(const auto& data : otherData)
+            m_root->getObject("QPInverseProblemSolver")->findData(data.first)->read(data.second);
+        sofa::simulation::node::initRoot(m_root.get());
+
+        m_root->getChild("goal")->getObject("goalMO")->findData("position")->read("-110 10 7.5");
+
+        int nbTimeStep = 10;
+        for(int i=0; i<nbTimeStep; i++)
+            sofa::simulation::node::animate(m_root.get());
+
+        string forceString = m_root->getChild("finger")->getChild("controlledPoints")->getObject("cable")->findData("force")->getValueString();
+        return stof(forceString.c_str());
+    }
+
+
+    // Test that the hot start mode gives the same result as the cold resolution
+    void hotStartTests()
+    {
+        helper::system::TemporaryLocale locale(LC_NUMERIC, "C");
+
+        float coldForce = getCableForce("hotStart", "false");
+        float hotForce = getCableForce("hotStart", "true");
+        EXPECT_NEAR(coldForce, hotForce, 1e-5);
+
+        QPInverseProblemSolver* solver = dynamic_cast<QPInverseProblemSolver*>(m_root->getObject("QPInverseProblemSolver"));
+        ASSERT_NE(solver, nullptr);
+        const auto& graph = solver->d_graph.getValue();
+        ASSERT_TRUE(graph.find("#HotStart hits:") != graph.end());
+        EXPECT_GT(graph.at("#HotStart hits:")[0], 0.);
+    }
+
+
+    // Test that skipping the unused blocks of W does not change the solution
+    void partialComplianceTests()
+    {
+        helper::system::TemporaryLocale locale(LC_NUMERIC, "C");
+
+        EXPECT_NEAR(getCableForce("partialCompliance", "false"), getCableForce("partialCompliance", "true"), 1e-5);
+    }
+
+
+    // Test that replaying the cached contributions to W gives the same solution, serial and concurrent
+    void cacheComplianceTests()
+    {
+        helper::system::TemporaryLocale locale(LC_NUMERIC, "C");
+
+        float force = getCableForce("cacheCompliance", "false");
+        EXPECT_NEAR(getCableForce("cacheCompliance", "true"), force, 1e-5);
+
+        EXPECT_NEAR(getCableForce("cacheCompliance", "true", {{"multithreading", "true"}}), force, 1e-5);
+    }
+
+
+    // Test that a reduced basis not matching the mechanical state is rejected, the full path giving the same solution
+    void reducedComplianceTests()
+    {
+        helper::system::TemporaryLocale locale(LC_NUMERIC, "C");
+
+        float force = getCableForce("reducedBasis", "");
+        EXPECT_NEAR(getCableForce("reducedBasis", "1 0 0", {{"reducedCompliance", "1"}}), force, 1e-5);
+    }
+
+
+    // Test that the contiguous results of the problem give the force and the displacement of the cable at its row
+    void resultBuffersTests()
+    {
+        helper::system::TemporaryLocale locale(LC_NUMERIC, "C");
+
+        float force = getCableForce("publishInfo", "false");
+        QPInverseProblemSolver* solver = dynamic_cast<QPInverseProblemSolver*>(m_root->getObject("QPInverseProblemSolver"));
+        ASSERT_NE(solver, nullptr);
+        softrobotsinverse::solver::module::QPInverseProblemImpl* problem = solver->getResultProblem();
+        ASSERT_NE(problem, nullptr);
+
+        const auto& rowComponents = problem->getRowComponents();
+        const auto& components = problem->getResultComponents();
+        ASSERT_EQ(rowComponents.size(), size_t(problem->getLambda().size()));
+        ASSERT_EQ(rowComponents.size(), size_t(problem->getDelta().size()));
+
+        int cableRow = -1;
+        for(unsigned int i=0; i<rowComponents.size(); i++)
+            if(rowComponents[i] >= 0 && components[rowComponents[i]]->getName() == "cable")
+                cableRow = i;
+        ASSERT_GE(cableRow, 0);
+
+        string displacementString = m_root->getChild("finger")->getChild("controlledPoints")->getObject("cable")->findData("displacement")->getValueString();
+        EXPECT_NEAR(problem->getLambda()[cableRow], force, 1e-5);
+        EXPECT_NEAR(problem->getDelta()[cableRow], stof(displacementString.c_str()), 1e-5);
+    }
+
+
+    // Test that storing the results concurrently gives the same results
+    void concurrentResultsTests()
+    {
+        helper::system::TemporaryLocale locale(LC_NUMERIC, "C");
+
+        float force = getCableForce("concurrentResults", "false");
+        EXPECT_NEAR(getCableForce("concurrentResults", "true", {{"multithreading", "true"}}), force, 1e-5);
+    }
+
+
+    // Test that the compliance table recorded by a run gives the same solution when the run is done again
+    // with the table, the first step (without previous actuation state) computing the compliance
+    void complianceTableTests()
+    {
+        helper::system::TemporaryLocale locale(LC_NUMERIC, "C");
+
+        const string filename = "QPInverseProblemSolverTest_complianceTable.txt";
+        std::remove(filename.c_str());
+        float force = getCableForce("recordComplianceTable", filename);
+        sofa::simulation::node::unload(m_root);
+
+        EXPECT_NEAR(getCableForce("complianceTable", filename), force, 1e-5);
+        QPInverseProblemSolver* solver = dynamic_cast<QPInverseProblemSolver*>(m_root->getObject("QPInverseProblemSolver"));
+        ASSERT_NE(solver, nullptr);
+        const softrobotsinverse::solver::module::QPTelemetry& telemetry = solver->getTelemetry();
+        EXPECT_GT(telemetry.get(telemetry.NbComplianceTableHits), 0.);
+        EXPECT_EQ(telemetry.get(telemetry.NbComplianceTableMisses), 1.);
+        std::remove(filename.c_str());
+    }
+
+
+    // Test that the compliance of the rest configuration written by a run gives the same solution when the
+    // run is done again with the file mapped, and that a file whose W was altered is ignored and written again
+    void restComplianceTests()
+    {
+        helper::system::TemporaryLocale locale(LC_NUMERIC, "C");
+        using softrobotsinverse::solver::module::QPMappedCompliance;
+
+        const string filename = "QPInverseProblemSolverTest_restCompliance.bin";
+        std::remove(filename.c_str());
+        float force = getCableForce("restComplianceFile", filename);
+        sofa::simulation::node::unload(m_root);
+        EXPECT_TRUE(std::ifstream(filename, std::ios::binary).is_open());
+
+        EXPECT_NEAR(getCableForce("restComplianceFile", filename), force, 1e-5);
+        sofa::simulation::node::unload(m_root);
+
+        QPMappedCompliance compliance;
+        ASSERT_TRUE(compliance.map(filename));
+        ASSERT_GT(compliance.getDim(), 0u);
+        compliance.unmap();
+
+        // Alters the last byte of W, the size of the file is unchanged
+        {
+            std::fstream file(filename, std::ios::binary | std::ios::in | std::ios::out);
+            file.seekg(-1, std::ios::end);
+            const char byte = char(file.get() ^ 0x01);
+            file.seekp(-1, std::ios::end);
+            file.put(byte);
+        }
+        EXPECT_FALSE(compliance.map(filename));
+
+        EXPECT_NEAR(getCableForce("restComplianceFile", filename), force, 1e-5);
+        EXPECT_TRUE(compliance.map(filename));
+        compliance.unmap();
+        std::remove(filename.c_str());
+    }
+
+
+    // Test that splicing the columns of the changed rows (the cable) into the cached W gives the same solution
+    void incrementalComplianceTests()
+    {
+        helper::system::TemporaryLocale locale(LC_NUMERIC, "C");
+
+        float force = getCableForce("incrementalCompliance", "false");
+        EXPECT_NEAR(getCableForce("incrementalCompliance", "true", {{"cacheCompliance", "true"}}), force, 1e-5);
+        EXPECT_NEAR(getCableForce("incrementalCompliance", "true", {{"cacheCompliance", "true"}, {"multithreading", "true"}}), force, 1e-5);
+    }
+
+
+    // Force of the cable at the goal of getCableForce, the correction of the finger being replaced by a
+    // MatrixFreeConstraintCorrection and the one of the goal (without constraint) removed
+    float getMatrixFreeCableForce(const string& matrixFree)
+    {
+        SetUp();
+
+        Node* goal = m_root->getChild("goal");
+        sofa::core::behavior::BaseConstraintCorrection::SPtr goalCorrection = goal->get<sofa::core::behavior::BaseConstraintCorrection>();
+        goal->removeObject(goalCorrection);
+        Node* finger = m_root->getChild("finger");
+        sofa::core::behavior::BaseConstraintCorrection::SPtr fingerCorrection = finger->get<sofa::core::behavior::BaseConstraintCorrection>();
+        finger->removeObject(fingerCorrection);
+        finger->addObject(New<MatrixFreeConstraintCorrection<Vec3Types> >());
+
+        m_root->getObject("QPInverseProblemSolver")->findData("matrixFree")->read(matrixFree);
+        sofa::simulation::node::initRoot(m_root.get());
+
+        m_root->getChild("goal")->getObject("goalMO")->findData("position")->read("-110 10 7.5");
+
+        int nbTimeStep = 10;
+        for(int i=0; i<nbTimeStep; i++)
+            sofa::simulation::node::animate(m_root.get());
+
+        string forceString = m_root->getChild("finger")->getChild("controlledPoints")->getObject("cable")->findData("force")->getValueString();
+        return stof(forceString.c_str());
+    }
+
+
+    // Test that MatrixFreeConstraintCorrection assembles the W of LinearSolverConstraintCorrection, and that
+    // the matrix-free resolution with its products J A^-1 J^T f gives the solution of the dense resolution
+    void matrixFreeTests()
+    {
+        helper::system::TemporaryLocale locale(LC_NUMERIC, "C");
+
+        float force = getCableForce("matrixFree", "false");
+        float denseForce = getMatrixFreeCableForce("false");
+        EXPECT_NEAR(denseForce, force, 1e-5);
+
+        QPInverseProblemSolver* solver = dynamic_cast<QPInverseProblemSolver*>(m_root->getObject("QPInverseProblemSolver"));
+        ASSERT_NE(solver, nullptr);
+        EXPECT_EQ(solver->getTelemetry().get(softrobotsinverse::solver::module::QPTelemetry::NbComplianceProducts), 0.);
+
+        float matrixFreeForce = getMatrixFreeCableForce("true");
+        EXPECT_NEAR(matrixFreeForce, denseForce, 1e-3*(1.+fabs(denseForce)));
+
+        solver = dynamic_cast<QPInverseProblemSolver*>(m_root->getObject("QPInverseProblemSolver"));
+        ASSERT_NE(solver, nullptr);
+        EXPECT_GT(solver->getTelemetry().get(softrobotsinverse::solver::module::QPTelemetry::NbComplianceProducts), 0.);
+    }
+
+
+    // Test that the compliance tasks, kept across the steps, give the W of the sequential build when the
+    // correction of the finger is skipped (its contribution spliced from the cache), then computed again (the
+    // time step changed), and when the set of constraint corrections changes at the same size of W (the
+    // correction of the goal is removed, and added back before the one of the finger)
+    void complianceTasksTests()
+    {
+        helper::system::TemporaryLocale locale(LC_NUMERIC, "C");
+
+        vector<vector<double>> W[2];
+        for(int k=0; k<2; k++)
+        {
+            SetUp();
+            QPInverseProblemSolver* solver = dynamic_cast<QPInverseProblemSolver*>(m_root->getObject("QPInverseProblemSolver"));
+            ASSERT_NE(solver, nullptr);
+            solver->findData("multithreading")->read((k==0)? "false" : "true");
+            solver->findData("cacheCompliance")->read("true");
+            solver->findData("incrementalCompliance")->read("true");
+            sofa::simulation::node::initRoot(m_root.get());
+
+            m_root->getChild("goal")->getObject("goalMO")->findData("position")->read("-110 10 7.5");
+
+            Node* goal = m_root->getChild("goal");
+            sofa::core::behavior::BaseConstraintCorrection::SPtr goalCorrection = goal->get<sofa::core::behavior::BaseConstraintCorrection>();
+            ASSERT_NE(goalCorrection, nullptr);
+
+            int nbTimeStep = 12;
+            for(int i=0; i<nbTimeStep; i++)
+            {
+                if(i==4)
+                {
+                    EXPECT_GT(solver->getComplianceCache().getNbSplices(), 0u);
+                    m_root->setDt(0.5);
+                }
+                if(i==6)
+                {
+                    goal->removeObject(goalCorrection);
+                    solver->init();
+                }
+                if(i==9)
+                {
+                    goal->addObject(goalCorrection);
+                    solver->init();
+                }
+                sofa::simulation::node::animate(m_root.get());
+
+                const softrobotsinverse::solver::module::QPInverseProblemImpl* problem = solver->getResultProblem();
+                W[k].emplace_back();
+                for(sofa::Index r=0; r<problem->W.rowSize(); r++)
+                    for(sofa::Index c=0; c<problem->W.colSize(); c++)
+                        W[k].back().push_back(problem->W.element(r, c));
+            }
+        }
+
+        ASSERT_EQ(W[0].size(), W[1].size());
+        for(unsigned int i=0; i<W[0].size(); i++)
+        {
+            ASSERT_EQ(W[1][i].size(), W[0][i].size()) << "at step " << i;
+            for(unsigned int j=0; j<W[0][i].size(); j++)
+                EXPECT_NEAR(W[1][i][j], W[0][i][j], 1e-9*(1.+fabs(W[0][i][j]))) << "at step " << i << ", entry " << j;
+        }
+    }
+
+
+    // Adds a sensor along the cable of the finger, before the init of the scene
+    void addCableSensor()
+    {
+        core::objectmodel::BaseObjectDescription desc("sensor", "CableSensor");
+        desc.setAttribute("indices", "1 2 3 4 5 6 7 8 9 10 11 12 13 14");
+        desc.setAttribute("pullPoint", "0.0 12.5 2.5");
+        EXPECT_NE(core::ObjectFactory::CreateObject(m_root->getChild("finger")->getChild("controlledPoints"), &desc), nullptr);
+    }
+
+
+    // Animates the finger with a sensor along the cable and the given solver data, and returns the lambda and
+    // dfree of each step, and the outputs of the components at the last one. The rows are gathered per
+    // component (in the order of getResultComponents()), so that the results do not depend on their numbering.
+    void getComponentResults(const std::map<string, string>& data, vector<vector<double>>& lambdas,
+                             vector<vector<double>>& dFrees, vector<double>& outputs)
+    {
+        SetUp();
+
+        for(const auto& d : data)
+            m_root->getObject("QPInverseProblemSolver")->findData(d.first)->read(d.second);
+        addCableSensor();
+        sofa::simulation::node::initRoot(m_root.get());
+        QPInverseProblemSolver* solver = dynamic_cast<QPInverseProblemSolver*>(m_root->getObject("QPInverseProblemSolver"));
+        ASSERT_NE(solver, nullptr);
+
+        m_root->getChild("goal")->getObject("goalMO")->findData("position")->read("-110 10 7.5");
+
+        lambdas.clear();
+        dFrees.clear();
+        int nbTimeStep = 10;
+        for(int i=0; i<nbTimeStep; i++)
+        {
+            sofa::simulation::node::animate(m_root.get());
+
+            softrobotsinverse::solver::module::QPInverseProblemImpl* problem = solver->getResultProblem();
+            const auto& rowComponents = problem->getRowComponents();
+            const unsigned int nbComponents = problem->getResultComponents().size();
+            lambdas.emplace_back();
+            dFrees.emplace_back();
+            for(unsigned int c=0; c<nbComponents; c++)
+                for(unsigned int j=0; j<rowComponents.size(); j++)
+                    if(rowComponents[j] == int(c))
+                    {
+                        lambdas.back().push_back(problem->getLambda()[j]);
+                        dFrees.back().push_back(problem->dFree[j]);
+                    }
+        }
+
+        Node* controlledPoints = m_root->getChild("finger")->getChild("controlledPoints");
+        outputs = {std::stod(controlledPoints->getObject("cable")->findData("force")->getValueString()),
+                   std::stod(controlledPoints->getObject("cable")->findData("displacement")->getValueString()),
+                   std::stod(controlledPoints->getObject("effector")->findData("delta")->getValueString()),
+                   std::stod(controlledPoints->getObject("sensor")->findData("displacement")->getValueString())};
+    }
+
+
+    void expectSameResults(const vector<vector<double>>& values, const vector<vector<double>>& expected)
+    {
+        ASSERT_EQ(values.size(), expected.size());
+        for(unsigned int i=0; i<values.size(); i++)
+        {
+            ASSERT_EQ(values[i].size(), expected[i].size()) << "at step " << i;
+            for(unsigned int j=0; j<values[i].size(); j++)
+                EXPECT_NEAR(values[i][j], expected[i][j], 1e-9*(1. + fabs(expected[i][j]))) << "at step " << i << ", row " << j;
+        }
+    }
+
+
+    // Animates the finger with a sensor along the cable, and returns the displacement it measures
+    float getSensorDisplacement(const string& dataName, const string& value, float& force,
+                                const std::map<string, string>& otherData = {})
+    {
+        SetUp();
+
+        m_root->getObject("QPInverseProblemSolver")->findData(dataName)->read(value);
+        for(const auto& data : otherData)
+            m_root->getObject("QPInverseProblemSolver")->findData(data.first)->read(data.second);
+        addCableSensor();
+        sofa::simulation::node::initRoot(m_root.get());
+
+        m_root->getChild("goal")->getObject("goalMO")->findData("position")->read("-110 10 7.5");
+
+        int nbTimeStep = 10;
+        for(int i=0; i<nbTimeStep; i++)
+            sofa::simulation::node::animate(m_root.get());
+
+        Node* controlledPoints = m_root->getChild("finger")->getChild("controlledPoints");
+        force = stof(controlledPoints->getObject("cable")->findData("force")->getValueString());
+        return stof(controlledPoints->getObject("sensor")->findData("displacement")->getValueString());
+    }
+
+
+    // Test that the sensors left out of the resolution do not change the solution, and measure the
+    // displacement of the cable from the corrected state
+    void lazySensorsTests()
+    {
+        helper::system::TemporaryLocale locale(LC_NUMERIC, "C");
+
+        float force = getCableForce("lazySensors", "false");
+        float eagerForce, lazyForce;
+        float eagerDisplacement = getSensorDisplacement("lazySensors", "false", eagerForce);
+        float lazyDisplacement = getSensorDisplacement("lazySensors", "true", lazyForce);
+        EXPECT_NEAR(eagerForce, force, 1e-5);
+        EXPECT_NEAR(lazyForce, force, 1e-5);
+
+        // The linearized delta and the violation at the corrected state only differ by the nonlinearity
+        const string cableDisplacement = m_root->getChild("finger")->getChild("controlledPoints")->getObject("cable")->findData("displacement")->getValueString();
+        EXPECT_NEAR(lazyDisplacement, stof(cableDisplacement), 1e-2);
+        EXPECT_NEAR(lazyDisplacement, eagerDisplacement, 1e-2);
+    }
+
+
+    // Test that the sensors taken out of the constraint problem measure the corrected state as the lazy ones,
+    // without changing the solution
+    void batchSensorsTests()
+    {
+        helper::system::TemporaryLocale locale(LC_NUMERIC, "C");
+
+        float lazyForce, batchForce, concurrentForce;
+        float lazyDisplacement = getSensorDisplacement("lazySensors", "true", lazyForce);
+        float batchDisplacement = getSensorDisplacement("batchSensors", "true", batchForce);
+        EXPECT_NEAR(batchForce, lazyForce, 1e-5);
+        EXPECT_NEAR(batchDisplacement, lazyDisplacement, 1e-5);
+
+        QPInverseProblemSolver* solver = dynamic_cast<QPInverseProblemSolver*>(m_root->getObject("QPInverseProblemSolver"));
+        ASSERT_NE(solver, nullptr);
+        EXPECT_EQ(solver->getConstraintProblem()->getDimension(), 1); // the cable only
+
+        float concurrentDisplacement = getSensorDisplacement("batchSensors", "true", concurrentForce, {{"multithreading", "true"}});
+        EXPECT_NEAR(concurrentForce, lazyForce, 1e-5);
+        EXPECT_NEAR(concurrentDisplacement, lazyDisplacement, 1e-5);
+    }
+
+
+    // Test that numbering the rows by type gives the results of the traversal order, the rows of each
+    // component being only permuted: same lambda, dfree and outputs, and first rows of the classification
+    // matching the rows of the components in the lists
+    void classContiguousRowsTests()
+    {
+        helper::system::TemporaryLocale locale(LC_NUMERIC, "C");
+
+        vector<vector<double>> lambdas[2], dFrees[2];
+        vector<double> outputs[2];
+        for(int k=0; k<2; k++)
+        {
+            getComponentResults({{"classContiguousRows", (k==0)? "false" : "true"}}, lambdas[k], dFrees[k], outputs[k]);
+
+            QPInverseProblemSolver* solver = dynamic_cast<QPInverseProblemSolver*>(m_root->getObject("QPInverseProblemSolver"));
+            ASSERT_NE(solver, nullptr);
+            const softrobotsinverse::solver::module::QPConstraintClassification& classification = solver->getConstraintClassification();
+            softrobotsinverse::solver::module::QPInverseProblemImpl* problem = solver->getResultProblem();
+            const auto& rowComponents = problem->getRowComponents();
+            const auto& components = problem->getResultComponents();
+
+            // Effector, cable and sensor in traversal order, the cable first by type
+            ASSERT_EQ(classification.getNbEntries(), 3u);
+            std::map<string, unsigned int> firstLines;
+            for(unsigned int i=0; i<classification.getNbEntries(); i++)
+            {
+                const auto& entry = classification.getEntry(i);
+                ASSERT_NE(entry.softRobotsConstraint, nullptr);
+                for(unsigned int j=0; j<entry.nbLines; j++)
+                {
+                    ASSERT_LT(entry.firstLine+j, rowComponents.size());
+                    ASSERT_GE(rowComponents[entry.firstLine+j], 0);
+                    EXPECT_EQ(components[rowComponents[entry.firstLine+j]], entry.softRobotsConstraint);
+                }
+                firstLines[entry.softRobotsConstraint->getName()] = entry.firstLine;
+            }
+            if(k==0)
+            {
+                EXPECT_LT(firstLines["effector"], firstLines["cable"]);
+                EXPECT_LT(firstLines["cable"], firstLines["sensor"]);
+            }
+            else
+            {
+                EXPECT_EQ(firstLines["cable"], 0u);
+                EXPECT_LT(firstLines["effector"], firstLines["sensor"]);
+            }
+        }
+
+        expectSameResults(lambdas[1], lambdas[0]);
+        expectSameResults(dFrees[1], dFrees[0]);
+        expectSameResults({outputs[1]}, {outputs[0]});
+    }
+
+
+    // Test that the violations computed in the visit building the rows give the dfree and lambda of the
+    // separate traversal. The first step grows the violation vector with the rows, the next ones reuse it.
+    // The lazy sensors are left out, their rows keep a zero violation, and the kept rows (reuseConstantRows)
+    // compute the violations from the classification.
+    void fuseConstraintViolationTests()
+    {
+        helper::system::TemporaryLocale locale(LC_NUMERIC, "C");
+
+        for(const string& lazySensors : {"false", "true"})
+            for(const string& reuseConstantRows : {"false", "true"})
+            {
+                vector<vector<double>> lambdas[2], dFrees[2];
+                vector<double> outputs[2];
+                for(int k=0; k<2; k++)
+                    getComponentResults({{"fuseConstraintViolation", (k==0)? "false" : "true"},
+                                         {"lazySensors", lazySensors},
+                                         {"reuseConstantRows", reuseConstantRows}}, lambdas[k], dFrees[k], outputs[k]);
+
+                SCOPED_TRACE("lazySensors " + lazySensors + ", reuseConstantRows " + reuseConstantRows);
+                expectSameResults(lambdas[1], lambdas[0]);
+                expectSameResults(dFrees[1], dFrees[0]);
+                if(lazySensors == "true")
+                    for(const vector<double>& dFree : dFrees[1])
+                    {
+                        ASSERT_FALSE(dFree.empty());
+                        EXPECT_EQ(dFree.back(), 0.); // the sensor, last of the result components
+                    }
+            }
+    }
+
+
+    // Test that the concurrent assembly of W gives the same solution as the serial one
+    void multithreadingTests()
+    {
+        helper::system::TemporaryLocale locale(LC_NUMERIC, "C");
+
+        EXPECT_NEAR(getCableForce("multithreading", "false"), getCableForce("multithreading", "true"), 1e-5);
+    }
+
+
+    // Test that the concurrent build of the constraint matrix gives the row ids and the Jacobians of the
+    // sequential build at each step. The first traversal is built sequentially, the rows of the next ones
+    // being predicted from it.
+    void parallelSetConstraintTests()
+    {
+        helper::system::TemporaryLocale locale(LC_NUMERIC, "C");
+
+        vector<string> rows[2];
+        for(int k=0; k<2; k++)
+        {
+            SetUp();
+            m_root->getObject("QPInverseProblemSolver")->findData("deterministic")->read("true");
+            m_root->getObject("QPInverseProblemSolver")->findData("multithreading")->read((k==0)? "false" : "true");
+            addCableSensor();
+            sofa::simulation::node::initRoot(m_root.get());
+            QPInverseProblemSolver* solver = dynamic_cast<QPInverseProblemSolver*>(m_root->getObject("QPInverseProblemSolver"));
+            ASSERT_NE(solver, nullptr);
+
+            m_root->getChild("goal")->getObject("goalMO")->findData("position")->read("-110 10 7.5");
+
+            Node* finger = m_root->getChild("finger");
+            int nbTimeStep = 10;
+            for(int i=0; i<nbTimeStep; i++)
+            {
+                sofa::simulation::node::animate(m_root.get());
+
+                const auto* lists = solver->getResultProblem()->getQPConstraintLists();
+                std::ostringstream stream;
+                stream << lists->actuatorRowIds << " | " << lists->effectorRowIds << " | " << lists->sensorRowIds << " | "
+                       << finger->getChild("controlledPoints")->getObject("actuatedPoints")->findData("constraint")->getValueString() << " | "
+                       << finger->getObject("tetras")->findData("constraint")->getValueString();
+                rows[k].push_back(stream.str());
+            }
+
+            const softrobotsinverse::solver::module::QPParallelSetConstraint& builder = solver->getParallelSetConstraint();
+            EXPECT_EQ(builder.getNbParallelBuilds(), (k==0)? 0u : nbTimeStep-1u);
+            EXPECT_EQ(builder.getNbRefusedBuilds(), (k==0)? 0u : 1u);
+        }
+
+        ASSERT_EQ(rows[0].size(), rows[1].size());
+        for(unsigned int i=0; i<rows[0].size(); i++)
+            EXPECT_EQ(rows[1][i], rows[0][i]) << "at step " << i;
+    }
+
+
+    // Test that the motion corrections of the goal and of the finger, integrated by different ODE solvers, are
+    // applied concurrently to exactly the states of the serial correction
+    void concurrentCorrectionTests()
+    {
+        helper::system::TemporaryLocale locale(LC_NUMERIC, "C");
+
+        vector<string> positions;
+        for(const string& multithreading : {"false", "true"})
+        {
+            getCableForce("deterministic", "true", {{"multithreading", multithreading}});
+            positions.push_back(m_root->getChild("finger")->getObject("tetras")->findData("position")->getValueString()
+                                + m_root->getChild("goal")->getObject("goalMO")->findData("position")->getValueString());
+        }
+        EXPECT_EQ(positions[0], positions[1]);
+    }
+
+
+    // Test that clearing only the states written by the constraints gives exactly the solution of the full clear,
+    // the goal, unconstrained, being left untouched
+    void clearConstrainedStatesTests()
+    {
+        helper::system::TemporaryLocale locale(LC_NUMERIC, "C");
+
+        vector<float> forces;
+        vector<string> positions;
+        for(const string& clearConstrainedStates : {"false", "true"})
+        {
+            forces.push_back(getCableForce("clearConstrainedStates", clearConstrainedStates));
+            positions.push_back(m_root->getChild("finger")->getObject("tetras")->findData("position")->getValueString()
+                                + m_root->getChild("goal")->getObject("goalMO")->findData("position")->getValueString());
+        }
+        EXPECT_EQ(forces[0], forces[1]);
+        EXPECT_EQ(positions[0], positions[1]);
+    }
+
+
+    // Test that skipping the effector, of zero lambda, when storing the lambdas gives exactly the same motion
+    void sparseLambdaStoreTests()
+    {
+        helper::system::TemporaryLocale locale(LC_NUMERIC, "C");
+
+        vector<float> forces;
+        vector<string> positions;
+        for(const string& sparseLambdaStore : {"false", "true"})
+        {
+            forces.push_back(getCableForce("sparseLambdaStore", sparseLambdaStore, {{"clearConstrainedStates", "true"}}));
+            positions.push_back(m_root->getChild("finger")->getObject("tetras")->findData("position")->getValueString());
+        }
+        EXPECT_EQ(forces[0], forces[1]);
+        EXPECT_EQ(positions[0], positions[1]);
+    }
+
+
+    // Test that skipping the correction of the goal, without force, gives exactly the same motion
+    void measurementOnlyRowsTests()
+    {
+        helper::system::TemporaryLocale locale(LC_NUMERIC, "C");
+
+        vector<float> forces;
+        vector<string> positions;
+        for(const string& measurementOnlyRows : {"false", "true"})
+        {
+            forces.push_back(getCableForce("measurementOnlyRows", measurementOnlyRows));
+            positions.push_back(m_root->getChild("finger")->getObject("tetras")->findData("position")->getValueString()
+                                + m_root->getChild("goal")->getObject("goalMO")->findData("position")->getValueString());
+        }
+        EXPECT_EQ(forces[0], forces[1]);
+        EXPECT_EQ(positions[0], positions[1]);
+    }
+
+
+    // Test that the finger, moving towards the goal, is solved at every step with solveOnChange, that with a
+    // tolerance larger than any change all the steps after the first reuse its solution, and that a change
+    // of a parameter of the resolution is not ignored
+    void solveOnChangeTests()
+    {
+        helper::system::TemporaryLocale locale(LC_NUMERIC, "C");
+
+        float force = getCableForce("solveOnChange", "false");
+        EXPECT_EQ(getCableForce("solveOnChange", "true"), force);
+        QPInverseProblemSolver* solver = dynamic_cast<QPInverseProblemSolver*>(m_root->getObject("QPInverseProblemSolver"));
+        ASSERT_NE(solver, nullptr);
+        EXPECT_EQ(solver->getTelemetry().get(solver->getTelemetry().NbSkippedSolves), 0.);
+
+        float firstForce = getCableForce("solveOnChange", "true", {{"solveOnChangeTolerance", "1e10"}});
+        solver = dynamic_cast<QPInverseProblemSolver*>(m_root->getObject("QPInverseProblemSolver"));
+        ASSERT_NE(solver, nullptr);
+        EXPECT_EQ(solver->getTelemetry().get(solver->getTelemetry().NbSkippedSolves), 9.);
+        EXPECT_NE(firstForce, force);
+
+        // The goal being held, a change of epsilon is a change of the problem: the step is solved again, and
+        // the next one reuses its solution
+        solver->findData("epsilon")->read("1.0");
+        sofa::simulation::node::animate(m_root.get());
+        EXPECT_EQ(solver->getTelemetry().get(solver->getTelemetry().NbSkippedSolves), 9.);
+        string forceString = m_root->getChild("finger")->getChild("controlledPoints")->getObject("cable")->findData("force")->getValueString();
+        EXPECT_NE(stof(forceString.c_str()), firstForce);
+
+        sofa::simulation::node::animate(m_root.get());
+        EXPECT_EQ(solver->getTelemetry().get(solver->getTelemetry().NbSkippedSolves), 10.);
+    }
+
+
+    // Test that with an inverse resolution every two steps, the other steps are forward and keep the actuation
+    void inverseSolvePeriodTests()
+    {
+        helper::system::TemporaryLocale locale(LC_NUMERIC, "C");
+
+        float force = getCableForce("inverseSolvePeriod", "2");
+        QPInverseProblemSolver* solver = dynamic_cast<QPInverseProblemSolver*>(m_root->getObject("QPInverseProblemSolver"));
+        ASSERT_NE(solver, nullptr);
+        const softrobotsinverse::solver::module::QPTelemetry& telemetry = solver->getTelemetry();
+        EXPECT_EQ(telemetry.get(telemetry.NbForwardSteps), 5.);
+
+        // The next step is inverse, the actuation follows the finger towards the goal
+        sofa::simulation::node::animate(m_root.get());
+        string forceString = m_root->getChild("finger")->getChild("controlledPoints")->getObject("cable")->findData("force")->getValueString();
+        EXPECT_NE(stof(forceString.c_str()), force);
+        EXPECT_EQ(telemetry.get(telemetry.NbForwardSteps), 5.);
+    }
+
+
+    // Test that the deterministic mode gives exactly the solution of the serial assembly
+    void deterministicTests()
+    {
+        helper::system::TemporaryLocale locale(LC_NUMERIC, "C");
+
+        float force = getCableForce("multithreading", "false");
+        EXPECT_EQ(getCableForce("deterministic", "true", {{"multithreading", "true"}}), force);
+        EXPECT_EQ(getCableForce("deterministic", "true", {{"multithreading", "true"}, {"cacheCompliance", "true"}}),
+                  getCableForce("cacheCompliance", "true"));
+    }
+
+
+    // Test that the timings of each phase are published, and that they do not change the solution
+    void timingsTests()
+    {
+        helper::system::TemporaryLocale locale(LC_NUMERIC, "C");
+
+        EXPECT_NEAR(getCableForce("computeTimings", "false"), getCableForce("computeTimings", "true"), 1e-5);
+
+        QPInverseProblemSolver* solver = dynamic_cast<QPInverseProblemSolver*>(m_root->getObject("QPInverseProblemSolver"));
+        ASSERT_NE(solver, nullptr);
+        const auto& timings = solver->d_timings.getValue();
+        for(const string phase : {"Accumulate constraint", "Compliance", "QP build", "QPs", "Correction", "Lambda store"})
+        {
+            ASSERT_TRUE(timings.find(phase) != timings.end()) << phase;
+            const auto& stats = timings.at(phase);
+            ASSERT_EQ(stats.size(), 3u);
+            EXPECT_GE(stats[0], 0.);
+            EXPECT_GE(stats[2], stats[0]);
+            EXPECT_GE(stats[2], stats[1]);
+        }
+    }
+
+
+    // Test that info is a view over the telemetry, and that the solution does not depend on it
+    void telemetryTests()
+    {
+        helper::system::TemporaryLocale locale(LC_NUMERIC, "C");
+
+        EXPECT_NEAR(getCableForce("publishInfo", "false"), getCableForce("publishInfo", "true"), 1e-5);
+
+        QPInverseProblemSolver* solver = dynamic_cast<QPInverseProblemSolver*>(m_root->getObject("QPInverseProblemSolver"));
+        ASSERT_NE(solver, nullptr);
+        const softrobotsinverse::solver::module::QPTelemetry& telemetry = solver->getTelemetry();
+        EXPECT_EQ(telemetry.get(telemetry.NbActuators), 1.);
+        ASSERT_GT(telemetry.getHistorySize(), 1u);
+        EXPECT_EQ(telemetry.getHistory(telemetry.NbActuators, 1), 1.);
+
+        const auto& graph = solver->d_graph.getValue();
+        ASSERT_TRUE(graph.find("#Actuators:") != graph.end());
+        EXPECT_EQ(graph.at("#Actuators:")[0], 1.);
+        ASSERT_TRUE(graph.find("Last Objective:") != graph.end());
+        EXPECT_EQ(graph.at("Last Objective:")[0], telemetry.get(telemetry.LastObjective));
+
+        getCableForce("publishInfo", "false");
+        solver = dynamic_cast<QPInverseProblemSolver*>(m_root->getObject("QPInverseProblemSolver"));
+        ASSERT_NE(solver, nullptr);
+        EXPECT_TRUE(solver->d_graph.getValue().empty());
+    }
+
+
+    // Test that the trace does not change the solution, and that it is written as a Chrome trace
+    void traceTests()
+    {
+        helper::system::TemporaryLocale locale(LC_NUMERIC, "C");
+
+        const string filename = "QPInverseProblemSolverTest_trace.json";
+        float force = getCableForce("traceFile", "");
+        QPInverseProblemSolver* solver = dynamic_cast<QPInverseProblemSolver*>(m_root->getObject("QPInverseProblemSolver"));
+        ASSERT_NE(solver, nullptr);
+        EXPECT_FALSE(solver->getTrace().isOpen());
+
+        EXPECT_NEAR(getCableForce("traceFile", filename), force, 1e-5);
+        solver = dynamic_cast<QPInverseProblemSolver*>(m_root->getObject("QPInverseProblemSolver"));
+        ASSERT_NE(solver, nullptr);
+        ASSERT_TRUE(solver->getTrace().isOpen());
+        EXPECT_GT(solver->getTrace().getNbEvents(), 0u);
+
+        // The trace is closed with the scene
+        sofa::simulation::node::unload(m_root);
+        std::ifstream file(filename);
+        ASSERT_TRUE(file.is_open());
+        const string trace((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        file.close();
+        std::remove(filename.c_str());
+
+        EXPECT_EQ(trace.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["), 0u);
+        EXPECT_NE(trace.find("\"name\":\"QP\""), string::npos);
+        EXPECT_NE(trace.find("\"nWSR\":"), string::npos);
+        EXPECT_NE(trace.find("\"name\":\"Compliance\""), string::npos);
+        EXPECT_EQ(trace.rfind("]}"), trace.size()-3);
+    }
+
+
+    // Test that the cost attribution does not change the solution, and that it reports each constraint component
+    void costAttributionTests()
+    {
+        helper::system::TemporaryLocale locale(LC_NUMERIC, "C");
+
+        EXPECT_NEAR(getCableForce("costAttribution", "true"), getCableForce("costAttribution", "false"), 1e-5);
+        QPInverseProblemSolver* solver = dynamic_cast<QPInverseProblemSolver*>(m_root->getObject("QPInverseProblemSolver"));
+        ASSERT_NE(solver, nullptr);
+        EXPECT_TRUE(solver->d_costs.getValue().empty());
+
+        getCableForce("costAttribution", "true");
+        solver = dynamic_cast<QPInverseProblemSolver*>(m_root->getObject("QPInverseProblemSolver"));
+        ASSERT_NE(solver, nullptr);
+        const auto& costs = solver->d_costs.getValue();
+        ASSERT_FALSE(costs.empty());
+
+        double nonZeroShare = 0.;
+        bool hasCable = false;
+        for(const auto& cost : costs)
+        {
+            ASSERT_EQ(cost.second.size(), 4u);
+            EXPECT_GT(cost.second[0], 0.);
+            for(unsigned int i=1; i<4; i++)
+            {
+                EXPECT_GE(cost.second[i], 0.);
+                EXPECT_LE(cost.second[i], 1.);
+            }
+            nonZeroShare += cost.second[1];
+            if(cost.first.size() >= 6 && cost.first.compare(cost.first.size()-6, 6, "/cable") == 0)
+            {
+                hasCable = true;
+                EXPECT_EQ(cost.second[0], 1.);
+            }
+        }
+        EXPECT_TRUE(hasCable);
+        EXPECT_NEAR(nonZeroShare, 1., 1e-10);
+    }
+
+
+    // Test that the lazy mode only allocates the problems needed by the locks, and reports their memory
+    void memoryUsageTests()
+    {
+        helper::system::TemporaryLocale locale(LC_NUMERIC, "C");
+
+        EXPECT_NEAR(getCableForce("lazyProblems", "true"), getCableForce("lazyProblems", "false"), 1e-5);
+        QPInverseProblemSolver* solver = dynamic_cast<QPInverseProblemSolver*>(m_root->getObject("QPInverseProblemSolver"));
+        ASSERT_NE(solver, nullptr);
+        EXPECT_EQ(solver->d_memoryUsage.getValue().size(), 3u);
+
+        getCableForce("lazyProblems", "true");
+        solver = dynamic_cast<QPInverseProblemSolver*>(m_root->getObject("QPInverseProblemSolver"));
+        ASSERT_NE(solver, nullptr);
+        {
+            const auto& memoryUsage = solver->d_memoryUsage.getValue();
+            ASSERT_EQ(memoryUsage.size(), 1u);
+            ASSERT_TRUE(memoryUsage.find("problem1") != memoryUsage.end());
+            const auto& usage = memoryUsage.at("problem1");
+            ASSERT_EQ(usage.size(), 4u);
+            EXPECT_GT(usage[0], 0.);
+            EXPECT_EQ(usage[3], usage[0] + usage[1] + usage[2]);
+        }
+
+        // A lock of the last problem allocates the second one
+        solver->lockConstraintProblem(solver, solver->getConstraintProblem());
+        sofa::simulation::node::animate(m_root.get());
+        const auto& memoryUsage = solver->d_memoryUsage.getValue();
+        EXPECT_EQ(memoryUsage.size(), 2u);
+        EXPECT_TRUE(memoryUsage.find("problem2") != memoryUsage.end());
+    }
+
+
+    // Test that the pipelined mode, whose correction is applied one step late, still drives the cable,
+    // and that overlapping the resolution with the next step does not make it depend on the thread timing
+    void pipelinedTests()
+    {
+        helper::system::TemporaryLocale locale(LC_NUMERIC, "C");
+
+        float force = getCableForce("pipelined", "true");
+        EXPECT_TRUE(std::isfinite(force));
+
+        QPInverseProblemSolver* solver = dynamic_cast<QPInverseProblemSolver*>(m_root->getObject("QPInverseProblemSolver"));
+        ASSERT_NE(solver, nullptr);
+        ASSERT_NE(solver->getResultProblem(), nullptr);
+
+        EXPECT_NEAR(getCableForce("pipelined", "true"), force, 1e-5);
+        EXPECT_NEAR(getCableForce("pipelined", "true", {{"multithreading", "true"}}), force, 1e-5);
+    }
+
+
+    // Duration in ms of a fixed computation, to normalize the solve times by the speed of the machine
+    double getReferenceTime() const
+    {
+        const unsigned int n = 200;
+        vector<double> M(n*n, 1e-3), x(n, 1.), y(n, 0.);
+        double best = 1e9;
+        for(unsigned int k=0; k<5; k++)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            for(unsigned int r=0; r<50; r++)
+                for(unsigned int i=0; i<n; i++)
+                {
+                    double sum = 0.;
+                    for(unsigned int j=0; j<n; j++)
+                        sum += M[i*n+j]*x[j];
+                    y[i] = sum;
+                    x[i] = 1. + 1e-6*sum;
+                }
+            best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+        return best;
+    }
+
+
+    // Performance gate: runs the finger toward a sequence of goals for a fixed number of steps, and compares
+    // the counts of the resolution (QP iterations, contact pivots, allocations when the allocation hook is
+    // preloaded) and the solve time normalized by getReferenceTime() with the baseline of scenes/Finger.baseline
+    // (lines "metric value tolerance", the tolerance relative to the value). Only the increases beyond the
+    // tolerance fail. The baseline is written instead when the environment variable
+    // SOFTROBOTSINVERSE_UPDATE_BASELINE is set. Without baseline the test is skipped, unless the environment
+    // variable SOFTROBOTSINVERSE_REQUIRE_BASELINE is set, as in the CI, then it fails. The CI writes the baseline
+    // and uploads it as an artifact when run with update_baseline.
+    void performanceTests()
+    {
+        helper::system::TemporaryLocale locale(LC_NUMERIC, "C");
+
+        SetUp();
+        m_root->getObject("QPInverseProblemSolver")->findData("computeTimings")->read("1");
+        m_root->getObject("QPInverseProblemSolver")->findData("computeCounters")->read("1");
+        sofa::simulation::node::initRoot(m_root.get());
+        QPInverseProblemSolver* solver = dynamic_cast<QPInverseProblemSolver*>(m_root->getObject("QPInverseProblemSolver"));
+        ASSERT_NE(solver, nullptr);
+        const softrobotsinverse::solver::module::QPTelemetry& telemetry = solver->getTelemetry();
+
+        std::map<string, double> metrics = {{"iterations", 0.}, {"pivots", 0.}, {"solveTime", 0.}};
+        bool hasAllocations = false;
+        for(const string goal : {"-110 7.5 7.5", "-110 10 7.5", "-110 -10 7.5", "-110 15 7.5"})
+        {
+            m_root->getChild("goal")->getObject("goalMO")->findData("position")->read(goal);
+            for(int i=0; i<10; i++)
+            {
+                sofa::simulation::node::animate(m_root.get());
+
+                metrics["iterations"] += telemetry.get(telemetry.LastIterations);
+                for(const SReal& nbPivots : telemetry.getSeries(telemetry.PivotsPerIteration))
+                    metrics["pivots"] += nbPivots;
+
+                const auto& timings = solver->d_timings.getValue();
+                if(timings.find("Solve") != timings.end())
+                    metrics["solveTime"] += timings.at("Solve")[0];
+
+                const auto& counters = solver->d_counters.getValue();
+                if(counters.find("Solve: allocations") != counters.end())
+                {
+                    metrics["allocations"] += counters.at("Solve: allocations")[0];
+                    hasAllocations = true;
+                }
+            }
+        }
+        metrics["solveTime"] /= getReferenceTime();
+        if(!hasAllocations)
+            metrics.erase("allocations");
+
+        const string fileName = string(SOFTROBOTSINVERSE_TEST_DIR) + "/component/solver/scenes/Finger.baseline";
+        if(std::getenv("SOFTROBOTSINVERSE_UPDATE_BASELINE"))
+        {
+            // The times are noisy, the counts should only change with the algorithms
+            std::ofstream file(fileName);
+            ASSERT_TRUE(file.is_open());
+            file << "# Baseline of QPInverseProblemSolverTest.performanceTests: metric value tolerance\n";
+            for(const auto& metric : metrics)
+                file << metric.first << " " << metric.second << " " << ((metric.first == "solveTime")? 2. : 0.25) << "\n";
+            return;
+        }
+
+        std::ifstream file(fileName);
+        if(!file.is_open())
+        {
+            if(std::getenv("SOFTROBOTSINVERSE_REQUIRE_BASELINE"))
+                FAIL() << "No baseline " << fileName << ", required by SOFTROBOTSINVERSE_REQUIRE_BASELINE.";
+            GTEST_SKIP() << "No baseline " << fileName << ", run the test with SOFTROBOTSINVERSE_UPDATE_BASELINE=1 to write it.";
+        }
+
+        string line;
+        while(std::getline(file, line))
+        {
+            if(line.empty() || line[0] == '#')
+                continue;
+            std::istringstream stream(line);
+            string name;
+            double value, tolerance;
+            if(!(stream >> name >> value >> tolerance) || metrics.find(name) == metrics.end())
+                continue;
+
+            // One more unit on the counts, so that a baseline of zero tolerates a single event
+            const double slack = (name == "solveTime")? 0. : 1.;
+            EXPECT_LE(metrics[name], value*(1. + tolerance) + slack)
+                    << name << " regressed: " << metrics[name] << " for a baseline of " << value;
+        }
+    }
+
+
     void regressionTests()
     {
         SetUp();
@@ -220,6 +1211,10 @@ TYPED_TEST(QPInverseProblemSolverTest, normalTests) {
     ASSERT_NO_THROW( this->normalTests() );
 }
 
+TYPED_TEST(QPInverseProblemSolverTest, performanceTests) {
+    ASSERT_NO_THROW( this->performanceTests() );
+}
+
 TYPED_TEST(QPInverseProblemSolverTest, regressionTests) {
     ASSERT_NO_THROW( this->regressionTests() );
 }
@@ -228,6 +1223,126 @@ TYPED_TEST(QPInverseProblemSolverTest, behaviorTests) {
     ASSERT_NO_THROW( this->behaviorTests() );
 }
 
+TYPED_TEST(QPInverseProblemSolverTest, hotStartTests) {
+    ASSERT_NO_THROW( this->hotStartTests() );
+}
+
+TYPED_TEST(QPInverseProblemSolverTest, partialComplianceTests) {
+    ASSERT_NO_THROW( this->partialComplianceTests() );
+}
+
+TYPED_TEST(QPInverseProblemSolverTest, reducedComplianceTests) {
+    ASSERT_NO_THROW( this->reducedComplianceTests() );
+}
+
+TYPED_TEST(QPInverseProblemSolverTest, resultBuffersTests) {
+    ASSERT_NO_THROW( this->resultBuffersTests() );
+}
+
+TYPED_TEST(QPInverseProblemSolverTest, concurrentResultsTests) {
+    ASSERT_NO_THROW( this->concurrentResultsTests() );
+}
+
+TYPED_TEST(QPInverseProblemSolverTest, complianceTableTests) {
+    ASSERT_NO_THROW( this->complianceTableTests() );
+}
+
+TYPED_TEST(QPInverseProblemSolverTest, restComplianceTests) {
+    ASSERT_NO_THROW( this->restComplianceTests() );
+}
+
+TYPED_TEST(QPInverseProblemSolverTest, cacheComplianceTests) {
+    ASSERT_NO_THROW( this->cacheComplianceTests() );
+}
+
+TYPED_TEST(QPInverseProblemSolverTest, complianceTasksTests) {
+    ASSERT_NO_THROW( this->complianceTasksTests() );
+}
+
+TYPED_TEST(QPInverseProblemSolverTest, incrementalComplianceTests) {
+    ASSERT_NO_THROW( this->incrementalComplianceTests() );
+}
+
+TYPED_TEST(QPInverseProblemSolverTest, matrixFreeTests) {
+    ASSERT_NO_THROW( this->matrixFreeTests() );
+}
+
+TYPED_TEST(QPInverseProblemSolverTest, lazySensorsTests) {
+    ASSERT_NO_THROW( this->lazySensorsTests() );
+}
+
+TYPED_TEST(QPInverseProblemSolverTest, batchSensorsTests) {
+    ASSERT_NO_THROW( this->batchSensorsTests() );
+}
+
+TYPED_TEST(QPInverseProblemSolverTest, multithreadingTests) {
+    ASSERT_NO_THROW( this->multithreadingTests() );
+}
+
+TYPED_TEST(QPInverseProblemSolverTest, classContiguousRowsTests) {
+    ASSERT_NO_THROW( this->classContiguousRowsTests() );
+}
+
+TYPED_TEST(QPInverseProblemSolverTest, fuseConstraintViolationTests) {
+    ASSERT_NO_THROW( this->fuseConstraintViolationTests() );
+}
+
+TYPED_TEST(QPInverseProblemSolverTest, parallelSetConstraintTests) {
+    ASSERT_NO_THROW( this->parallelSetConstraintTests() );
+}
+
+TYPED_TEST(QPInverseProblemSolverTest, concurrentCorrectionTests) {
+    ASSERT_NO_THROW( this->concurrentCorrectionTests() );
+}
+
+TYPED_TEST(QPInverseProblemSolverTest, clearConstrainedStatesTests) {
+    ASSERT_NO_THROW( this->clearConstrainedStatesTests() );
+}
+
+TYPED_TEST(QPInverseProblemSolverTest, sparseLambdaStoreTests) {
+    ASSERT_NO_THROW( this->sparseLambdaStoreTests() );
+}
+
+TYPED_TEST(QPInverseProblemSolverTest, measurementOnlyRowsTests) {
+    ASSERT_NO_THROW( this->measurementOnlyRowsTests() );
+}
+
+TYPED_TEST(QPInverseProblemSolverTest, solveOnChangeTests) {
+    ASSERT_NO_THROW( this->solveOnChangeTests() );
+}
+
+TYPED_TEST(QPInverseProblemSolverTest, inverseSolvePeriodTests) {
+    ASSERT_NO_THROW( this->inverseSolvePeriodTests() );
+}
+
+TYPED_TEST(QPInverseProblemSolverTest, deterministicTests) {
+    ASSERT_NO_THROW( this->deterministicTests() );
+}
+
+TYPED_TEST(QPInverseProblemSolverTest, timingsTests) {
+    ASSERT_NO_THROW( this->timingsTests() );
+}
+
+TYPED_TEST(QPInverseProblemSolverTest, telemetryTests) {
+    ASSERT_NO_THROW( this->telemetryTests() );
+}
+
+TYPED_TEST(QPInverseProblemSolverTest, traceTests) {
+    ASSERT_NO_THROW( this->traceTests() );
+}
+
+TYPED_TEST(QPInverseProblemSolverTest, costAttributionTests) {
+    ASSERT_NO_THROW( this->costAttributionTests() );
+}
+
+TYPED_TEST(QPInverseProblemSolverTest, memoryUsageTests) {
+    ASSERT_NO_THROW( this->memoryUsageTests() );
+}
+
+TYPED_TEST(QPInverseProblemSolverTest, pipelinedTests) {
+    ASSERT_NO_THROW( this->pipelinedTests() );
+}
+
 
 }
 
@@ -0,0 +1,116 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+
+/// Allocation hook counting the heap allocations of the process, for the data computeCounters of
+/// QPInverseProblemSolver (see QPPerfCounters). The library is preloaded in the process running the
+/// scene, e.g.
+///     LD_PRELOAD=libSoftRobots.Inverse_allochook.so runSofa scene.py
+/// It replaces the allocation functions of the C library, and so also counts the allocations of
+/// operator new, Eigen and qpOASES. The counters are relaxed atomics, and free is not replaced.
+/// Only available with the GNU C library, which gives the underlying functions (__libc_malloc...).
+
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__GLIBC__)
+
+extern "C"
+{
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t nb, size_t size);
+void* __libc_realloc(void* pointer, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+}
+
+namespace
+{
+std::atomic<uint64_t> s_nbAllocations{0};
+std::atomic<uint64_t> s_nbBytes{0};
+
+inline void count(const size_t& size)
+{
+    s_nbAllocations.fetch_add(1, std::memory_order_relaxed);
+    s_nbBytes.fetch_add(size, std::memory_order_relaxed);
+}
+}
+
+extern "C"
+{
+
+__attribute__((visibility("default")))
+void softrobotsinverse_getAllocationCounts(uint64_t* nbAllocations, uint64_t* nbBytes)
+{
+    *nbAllocations = s_nbAllocations.load(std::memory_order_relaxed);
+    *nbBytes = s_nbBytes.load(std::memory_order_relaxed);
+}
+
+void* malloc(size_t size)
+{
+    count(size);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t nb, size_t size)
+{
+    count(nb*size);
+    return __libc_calloc(nb, size);
+}
+
+void* realloc(void* pointer, size_t size)
+{
+    count(size);
+    return __libc_realloc(pointer, size);
+}
+
+void* memalign(size_t alignment, size_t size)
+{
+    count(size);
+    return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size)
+{
+    count(size);
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** pointer, size_t alignment, size_t size)
+{
+    if(alignment < sizeof(void*) || (alignment & (alignment-1)) != 0)
+        return EINVAL;
+    count(size);
+    *pointer = __libc_memalign(alignment, size);
+    return (*pointer || size == 0)? 0 : ENOMEM;
+}
+
+}
+
+#endif
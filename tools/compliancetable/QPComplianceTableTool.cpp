@@ -0,0 +1,131 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+
+/// Prepares a compliance table for QPInverseProblemSolver (see its data complianceTable): merges the
+/// samples recorded by one or more offline runs (data recordComplianceTable), removes the samples
+/// closer than a spacing to the ones already kept, prints the sampled range of each actuator, and
+/// writes the table.
+///
+/// Usage: SoftRobots.Inverse_compliancetable output input... [options]
+///     --spacing s         minimal distance between two samples, the forces of each actuator being
+///                         scaled by their sampled range (default 0, all the samples are kept)
+///     --quiet             only prints the summary
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include <SoftRobots.Inverse/component/solver/modules/QPComplianceTable.h>
+
+using softrobotsinverse::solver::module::QPComplianceTable;
+using sofa::type::vector;
+
+
+namespace
+{
+
+struct TableOptions
+{
+    std::string output;
+    vector<std::string> inputs;
+    double spacing{0.};
+    bool quiet{false};
+};
+
+
+void printUsage(const char* program)
+{
+    printf("Usage: %s output input... [--spacing s] [--quiet]\n", program);
+}
+
+
+bool parseOptions(int argc, char** argv, TableOptions& options)
+{
+    for(int i=1; i<argc; i++)
+    {
+        const std::string arg = argv[i];
+        const bool hasValue = (i+1 < argc);
+
+        if(arg == "--quiet")
+            options.quiet = true;
+        else if(arg == "--spacing" && hasValue)
+            options.spacing = std::atof(argv[++i]);
+        else if(arg.compare(0, 2, "--") == 0)
+            return false;
+        else if(options.output.empty())
+            options.output = arg;
+        else
+            options.inputs.push_back(arg);
+    }
+    return !options.output.empty() && !options.inputs.empty();
+}
+
+} // namespace
+
+
+int main(int argc, char** argv)
+{
+    TableOptions options;
+    if(!parseOptions(argc, argv, options))
+    {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    QPComplianceTable table;
+    for(const std::string& input : options.inputs)
+    {
+        const unsigned int nbSamples = table.getNbSamples();
+        if(!table.load(input))
+        {
+            fprintf(stderr, "Cannot read the compliance table %s, or its sizes do not match the previous ones\n", input.c_str());
+            return 1;
+        }
+        if(!options.quiet)
+            printf("%s: %u samples\n", input.c_str(), table.getNbSamples() - nbSamples);
+    }
+
+    const unsigned int nbRecordedSamples = table.getNbSamples();
+    if(options.spacing > 0.)
+        table.thin(options.spacing);
+
+    if(!options.quiet)
+        for(unsigned int k=0; k<table.getNbKeys(); k++)
+            printf("actuator %u: [%g, %g]\n", k, table.getMinKey()[k], table.getMaxKey()[k]);
+
+    if(!table.save(options.output))
+    {
+        fprintf(stderr, "Cannot write the compliance table %s\n", options.output.c_str());
+        return 1;
+    }
+
+    printf("%u samples kept out of %u, %u actuators, %u rows\n",
+           table.getNbSamples(), nbRecordedSamples, table.getNbKeys(), table.getDim());
+    return 0;
+}
@@ -0,0 +1,207 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+
+/// Replays a recording of QPInverseProblemSolver (see its data recordFile) without scene graph:
+/// the QP of each recorded step is solved again with the chosen options, and compared with the
+/// recorded solution.
+///
+/// Usage: SoftRobots.Inverse_replay recording [options]
+///     --qpSolver name     QP solver: qpOASES (default) or ADMM
+///     --hotStart          hot start the QP from the previous step
+///     --timeBudget ms     time budget of each step, 0 for no budget (default)
+///     --first i           first step to replay (default 0)
+///     --last i            last step to replay (default the last recorded step)
+///     --repeat n          number of resolutions of each step, the minimum time is reported (default 1)
+///     --tolerance t       exits with an error if the solution of a step differs by more than t
+///     --quiet             only prints the summary
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+
+#include <SoftRobots.Inverse/component/solver/modules/QPProblemRecorder.h>
+
+#include "QPReplayProblem.h"
+
+using softrobotsinverse::replay::QPReplayProblem;
+using softrobotsinverse::solver::module::QPProblemReader;
+using softrobotsinverse::solver::module::QPRecordedStep;
+using sofa::type::vector;
+
+
+namespace
+{
+
+struct ReplayOptions
+{
+    std::string filename;
+    std::string qpSolver{"qpOASES"};
+    bool hotStart{false};
+    double timeBudget{0.}; // in ms
+    unsigned int first{0};
+    unsigned int last{std::numeric_limits<unsigned int>::max()};
+    unsigned int repeat{1};
+    double tolerance{-1.};
+    bool quiet{false};
+};
+
+
+void printUsage(const char* program)
+{
+    printf("Usage: %s recording [--qpSolver qpOASES|ADMM] [--hotStart] [--timeBudget ms]\n"
+           "       [--first i] [--last i] [--repeat n] [--tolerance t] [--quiet]\n", program);
+}
+
+
+bool parseOptions(int argc, char** argv, ReplayOptions& options)
+{
+    for(int i=1; i<argc; i++)
+    {
+        const std::string arg = argv[i];
+        const bool hasValue = (i+1 < argc);
+
+        if(arg == "--hotStart")
+            options.hotStart = true;
+        else if(arg == "--quiet")
+            options.quiet = true;
+        else if(arg == "--qpSolver" && hasValue)
+            options.qpSolver = argv[++i];
+        else if(arg == "--timeBudget" && hasValue)
+            options.timeBudget = std::atof(argv[++i]);
+        else if(arg == "--first" && hasValue)
+            options.first = std::strtoul(argv[++i], nullptr, 10);
+        else if(arg == "--last" && hasValue)
+            options.last = std::strtoul(argv[++i], nullptr, 10);
+        else if(arg == "--repeat" && hasValue)
+            options.repeat = std::max(1ul, std::strtoul(argv[++i], nullptr, 10));
+        else if(arg == "--tolerance" && hasValue)
+            options.tolerance = std::atof(argv[++i]);
+        else if(arg.compare(0, 2, "--") != 0 && options.filename.empty())
+            options.filename = arg;
+        else
+            return false;
+    }
+    return !options.filename.empty();
+}
+
+} // namespace
+
+
+int main(int argc, char** argv)
+{
+    ReplayOptions options;
+    if(!parseOptions(argc, argv, options))
+    {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    QPProblemReader reader;
+    if(!reader.open(options.filename))
+    {
+        fprintf(stderr, "Cannot read the recording %s\n", options.filename.c_str());
+        return 2;
+    }
+
+    QPReplayProblem problem;
+    problem.setQPSolver(options.qpSolver);
+    problem.setHotStart(options.hotStart);
+    problem.setTimeBudget(options.timeBudget*1e-3);
+
+    const unsigned int nbSteps = reader.getNbSteps();
+    const unsigned int last = std::min(options.last, nbSteps? nbSteps-1 : 0u);
+
+    if(!options.quiet)
+        printf("step\ttime\tdim\tconstraints\tsolveTime(ms)\titerations\tobjective\tobjectiveDiff\tsolutionDiff\n");
+
+    QPRecordedStep step;
+    vector<double> previousResult, result;
+    double totalTime = 0., maxTime = 0., maxSolutionDiff = 0., maxObjectiveDiff = 0.;
+    unsigned int nbReplayed = 0, nbUnreadable = 0, nbOverTolerance = 0;
+
+    for(unsigned int i=options.first; i<=last && i<nbSteps; i++)
+    {
+        if(!reader.readStep(i, step))
+        {
+            nbUnreadable++;
+            continue;
+        }
+
+        problem.setStep(step);
+
+        double time = std::numeric_limits<double>::max();
+        double objective = 0.;
+        for(unsigned int k=0; k<options.repeat; k++)
+        {
+            result = previousResult;
+            const auto start = std::chrono::steady_clock::now();
+            problem.solveStep(result, objective);
+            const std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - start;
+            time = std::min(time, duration.count());
+        }
+        previousResult = result;
+
+        // Differences with the recorded resolution, the objective of the recorded solution is
+        // evaluated on the QP (the recorded objective also includes the constant effector terms)
+        double solutionDiff = (result.size() == step.result.size())? 0. : std::numeric_limits<double>::infinity();
+        for(unsigned int j=0; j<result.size() && j<step.result.size(); j++)
+            solutionDiff = std::max(solutionDiff, std::fabs(result[j] - step.result[j]));
+        const double objectiveDiff = objective - problem.getObjective(step.result);
+
+        if(options.tolerance >= 0. && !(solutionDiff <= options.tolerance))
+            nbOverTolerance++;
+
+        totalTime += time;
+        maxTime = std::max(maxTime, time);
+        maxSolutionDiff = std::max(maxSolutionDiff, solutionDiff);
+        maxObjectiveDiff = std::max(maxObjectiveDiff, std::fabs(objectiveDiff));
+        nbReplayed++;
+
+        if(!options.quiet)
+            printf("%lu\t%g\t%u\t%u\t%.4f\t%d\t%.10g\t%.3e\t%.3e\n", (unsigned long)step.step, step.time, step.dim,
+                   step.nbInequalities + step.nbEqualities, time, problem.getNbQPIterations(),
+                   objective, objectiveDiff, solutionDiff);
+    }
+
+    printf("# %u steps replayed with %s%s, %u unreadable\n", nbReplayed, options.qpSolver.c_str(),
+           options.hotStart? " (hot start)" : "", nbUnreadable);
+    printf("# solve time (ms): total %.4f, mean %.4f, max %.4f\n", totalTime,
+           nbReplayed? totalTime/nbReplayed : 0., maxTime);
+    printf("# max difference with the recording: solution %.3e, objective %.3e\n", maxSolutionDiff, maxObjectiveDiff);
+    if(options.timeBudget > 0.)
+        printf("# deadline hits: %u\n", problem.getNbDeadlineHits());
+    if(options.tolerance >= 0.)
+        printf("# steps over the tolerance %g: %u\n", options.tolerance, nbOverTolerance);
+
+    return (nbOverTolerance > 0 || nbUnreadable > 0)? 1 : 0;
+}
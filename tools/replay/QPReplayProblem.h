@@ -0,0 +1,149 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <SoftRobots.Inverse/component/solver/modules/QPInverseProblemImpl.h>
+#include <SoftRobots.Inverse/component/solver/modules/QPProblemRecorder.h>
+
+
+namespace softrobotsinverse::replay
+{
+
+using softrobotsinverse::solver::module::QPInverseProblemImpl;
+using softrobotsinverse::solver::module::QPRecordedStep;
+using sofa::type::vector;
+
+/// Gives access to the QP resolution of QPInverseProblemImpl, with the QP system of a recorded step
+class QPReplayProblem : public QPInverseProblemImpl
+{
+public:
+    void setStep(const QPRecordedStep& step)
+    {
+        const unsigned int dim = step.dim;
+        m_qpSystem->dim = dim;
+        m_qpSystem->hasBothSideInequalityConstraint = step.hasBothSideInequalityConstraint;
+
+        setMatrix(m_qpSystem->Q, step.Q, dim, dim);
+        setMatrix(m_qpSystem->A, step.A, step.nbInequalities, dim);
+        setMatrix(m_qpSystem->Aeq, step.Aeq, step.nbEqualities, dim);
+        m_qpSystem->c = step.c;
+        m_qpSystem->bl = step.bl;
+        m_qpSystem->bu = step.bu;
+        m_qpSystem->beq = step.beq;
+        m_qpSystem->l = step.l;
+        m_qpSystem->u = step.u;
+
+        m_qpCLists->actuatorRowIds = step.actuatorRowIds;
+        m_qpCLists->effectorRowIds = step.effectorRowIds;
+        m_qpCLists->sensorRowIds = step.sensorRowIds;
+        m_qpCLists->contactRowIds = step.contactRowIds;
+        m_qpCLists->equalityRowIds = step.equalityRowIds;
+
+        setTime(step.time);
+    }
+
+    /// Solves the QP of the current step, starting from the given previous result
+    void solveStep(vector<double>& result, double& objective)
+    {
+        m_solveStartTime = sofa::helper::system::thread::CTime::getTime();
+        m_deadlineHit = false;
+
+        vector<double> dual;
+        solveInverseProblem(objective, result, dual);
+        if(m_deadlineHit)
+            m_nbDeadlineHits++;
+    }
+
+    /// 1/2 x^T Q x + c^T x
+    double getObjective(const vector<double>& x) const
+    {
+        const unsigned int dim = m_qpSystem->dim;
+        if(x.size() != dim)
+            return std::numeric_limits<double>::quiet_NaN();
+
+        double objective = 0.;
+        for(unsigned int i=0; i<dim; i++)
+        {
+            double Qx = 0.;
+            for(unsigned int j=0; j<dim; j++)
+                Qx += m_qpSystem->Q[i][j]*x[j];
+            objective += 0.5*x[i]*Qx + m_qpSystem->c[i]*x[i];
+        }
+        return objective;
+    }
+
+    /// Largest violation of the bounds and constraints of the QP by x, infinite if x has not the size of the QP
+    double getViolation(const vector<double>& x) const
+    {
+        const unsigned int dim = m_qpSystem->dim;
+        if(x.size() != dim)
+            return std::numeric_limits<double>::infinity();
+
+        double violation = 0.;
+        for(unsigned int i=0; i<dim; i++)
+        {
+            if(i < m_qpSystem->l.size())
+                violation = std::max(violation, m_qpSystem->l[i] - x[i]);
+            if(i < m_qpSystem->u.size())
+                violation = std::max(violation, x[i] - m_qpSystem->u[i]);
+        }
+
+        auto product = [&x, dim](const double* row)
+        {
+            double value = 0.;
+            for(unsigned int j=0; j<dim; j++)
+                value += row[j]*x[j];
+            return value;
+        };
+        for(unsigned int i=0; i<m_qpSystem->A.size(); i++)
+        {
+            const double Ax = product(m_qpSystem->A[i]);
+            violation = std::max(violation, Ax - m_qpSystem->bu[i]);
+            if(m_qpSystem->hasBothSideInequalityConstraint)
+                violation = std::max(violation, m_qpSystem->bl[i] - Ax);
+        }
+        for(unsigned int i=0; i<m_qpSystem->Aeq.size(); i++)
+            violation = std::max(violation, std::fabs(product(m_qpSystem->Aeq[i]) - m_qpSystem->beq[i]));
+        return violation;
+    }
+
+protected:
+    static void setMatrix(QPMatrix& matrix, const vector<double>& values,
+                          const unsigned int& nbRows, const unsigned int& nbCols)
+    {
+        matrix.resize(nbRows, nbCols);
+        std::copy(values.begin(), values.begin() + std::min<size_t>(values.size(), nbRows*nbCols), matrix.data());
+    }
+};
+
+} // namespace
@@ -0,0 +1,337 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+*                       Plugin SoftRobots.Inverse                             *
+*                                                                             *
+* This plugin is distributed under the GNU AGPL v3 (Affero General            *
+* Public License) license.                                                    *
+*                                                                             *
+* Authors: Christian Duriez, Eulalie Coevoet, Yinoussa Adagolodjo             *
+*                                                                             *
+* (c) 2023 INRIA                                                              *
+*                                                                             *
+* Contact information: https://project.inria.fr/softrobot/contact/            *
+******************************************************************************/
+
+/// Tunes the options of QPInverseProblemSolver on a recording (see its data recordFile): the QPs of the
+/// recorded steps are solved again with candidate options, the time percentile chosen with --metric is
+/// minimized under a budget on the violation of the bounds and constraints of the solutions. The search is
+/// a coordinate descent from the default options: each option is changed in turn, and a change is kept when
+/// it lowers the metric by more than the minimal gain, until a pass keeps no change.
+/// The options found are printed as the attributes of the QPInverseProblemSolver of a scene.
+///
+/// Usage: SoftRobots.Inverse_tune recording [options]
+///     --metric p50|p99       percentile of the solve times to minimize (default p99)
+///     --violationBudget v    largest violation of the QP of a step by its solution (default 1e-6)
+///     --minGain g            relative gain of the metric for a change to be kept (default 0.02)
+///     --passes n             largest number of passes of the descent (default 3)
+///     --first i              first step to replay (default 0)
+///     --last i               last step to replay (default the last recorded step)
+///     --repeat n             number of resolutions of each step, the minimum time is kept (default 3)
+///     --output file          also writes the options found in the file
+///     --quiet                only prints the options found
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <string>
+
+#include <SoftRobots.Inverse/component/solver/modules/QPProblemRecorder.h>
+
+#include "QPReplayProblem.h"
+
+using softrobotsinverse::replay::QPReplayProblem;
+using softrobotsinverse::solver::module::QPProblemReader;
+using softrobotsinverse::solver::module::QPRecordedStep;
+using sofa::type::vector;
+
+
+namespace
+{
+
+/// Option of QPInverseProblemSolver that applies to the resolution of a recorded QP, with its candidate
+/// values as written in a scene, the first one being the default value of the data
+struct Option
+{
+    const char* name;
+    vector<std::string> values;
+    void (*apply)(QPReplayProblem& problem, const std::string& value);
+};
+
+bool isTrue(const std::string& value) {return value == "true";}
+
+const vector<Option>& getOptions()
+{
+    static const vector<Option> options = {
+        {"qpSolver", {"qpOASES", "ADMM"},
+         [](QPReplayProblem& problem, const std::string& value) {problem.setQPSolver(value);}},
+        {"hotStart", {"false", "true"},
+         [](QPReplayProblem& problem, const std::string& value) {problem.setHotStart(isTrue(value));}},
+        {"structuredFactorization", {"false", "true"},
+         [](QPReplayProblem& problem, const std::string& value) {problem.setStructuredFactorization(isTrue(value));}},
+        {"smallProblemKernel", {"false", "true"},
+         [](QPReplayProblem& problem, const std::string& value) {problem.setSmallProblemKernel(isTrue(value));}},
+        {"interiorFastPath", {"false", "true"},
+         [](QPReplayProblem& problem, const std::string& value) {problem.setInteriorFastPath(isTrue(value));}},
+        {"presolve", {"false", "true"},
+         [](QPReplayProblem& problem, const std::string& value) {problem.setPresolve(isTrue(value));}},
+        {"equalityElimination", {"false", "true"},
+         [](QPReplayProblem& problem, const std::string& value) {problem.setEqualityElimination(isTrue(value));}},
+        {"scaling", {"false", "true"},
+         [](QPReplayProblem& problem, const std::string& value) {problem.setScaling(isTrue(value), 10);}},
+        {"maxNbWorkingSetChanges", {"500", "100", "2000"},
+         [](QPReplayProblem& problem, const std::string& value) {problem.setMaxNbWorkingSetChanges(std::atoi(value.c_str()));}},
+    };
+    return options;
+}
+
+/// Index of the value of each option
+typedef vector<unsigned int> Candidate;
+
+struct Evaluation
+{
+    double p50{std::numeric_limits<double>::infinity()};
+    double p99{std::numeric_limits<double>::infinity()};
+    double violation{std::numeric_limits<double>::infinity()};
+};
+
+struct TuneOptions
+{
+    std::string filename;
+    std::string metric{"p99"};
+    double violationBudget{1e-6};
+    double minGain{0.02};
+    unsigned int passes{3};
+    unsigned int first{0};
+    unsigned int last{std::numeric_limits<unsigned int>::max()};
+    unsigned int repeat{3};
+    std::string output;
+    bool quiet{false};
+};
+
+
+void printUsage(const char* program)
+{
+    printf("Usage: %s recording [--metric p50|p99] [--violationBudget v] [--minGain g] [--passes n]\n"
+           "       [--first i] [--last i] [--repeat n] [--output file] [--quiet]\n", program);
+}
+
+
+bool parseOptions(int argc, char** argv, TuneOptions& options)
+{
+    for(int i=1; i<argc; i++)
+    {
+        const std::string arg = argv[i];
+        const bool hasValue = (i+1 < argc);
+
+        if(arg == "--quiet")
+            options.quiet = true;
+        else if(arg == "--metric" && hasValue)
+            options.metric = argv[++i];
+        else if(arg == "--violationBudget" && hasValue)
+            options.violationBudget = std::atof(argv[++i]);
+        else if(arg == "--minGain" && hasValue)
+            options.minGain = std::atof(argv[++i]);
+        else if(arg == "--passes" && hasValue)
+            options.passes = std::strtoul(argv[++i], nullptr, 10);
+        else if(arg == "--first" && hasValue)
+            options.first = std::strtoul(argv[++i], nullptr, 10);
+        else if(arg == "--last" && hasValue)
+            options.last = std::strtoul(argv[++i], nullptr, 10);
+        else if(arg == "--repeat" && hasValue)
+            options.repeat = std::max(1ul, std::strtoul(argv[++i], nullptr, 10));
+        else if(arg == "--output" && hasValue)
+            options.output = argv[++i];
+        else if(arg.compare(0, 2, "--") != 0 && options.filename.empty())
+            options.filename = arg;
+        else
+            return false;
+    }
+    return !options.filename.empty() && (options.metric == "p50" || options.metric == "p99");
+}
+
+
+double getPercentile(vector<double> values, const double& percentile)
+{
+    if(values.empty())
+        return std::numeric_limits<double>::infinity();
+    const size_t k = std::min(values.size() - 1, size_t(percentile*(values.size() - 1) + 0.5));
+    std::nth_element(values.begin(), values.begin() + k, values.end());
+    return values[k];
+}
+
+
+/// Solves the steps in order with the options of the candidate, from a new problem so that the hot start
+/// and the caches only come from the previous steps
+Evaluation evaluate(const vector<QPRecordedStep>& steps, const Candidate& candidate, const unsigned int& repeat)
+{
+    const vector<Option>& options = getOptions();
+    QPReplayProblem problem;
+    for(unsigned int k=0; k<options.size(); k++)
+        options[k].apply(problem, options[k].values[candidate[k]]);
+
+    Evaluation evaluation;
+    evaluation.violation = 0.;
+    vector<double> times, previousResult, result;
+    times.reserve(steps.size());
+    for(const QPRecordedStep& step : steps)
+    {
+        problem.setStep(step);
+
+        double time = std::numeric_limits<double>::max();
+        double objective = 0.;
+        for(unsigned int k=0; k<repeat; k++)
+        {
+            result = previousResult;
+            const auto start = std::chrono::steady_clock::now();
+            problem.solveStep(result, objective);
+            const std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - start;
+            time = std::min(time, duration.count());
+        }
+        previousResult = result;
+
+        times.push_back(time);
+        evaluation.violation = std::max(evaluation.violation, problem.getViolation(result));
+    }
+
+    evaluation.p50 = getPercentile(times, 0.5);
+    evaluation.p99 = getPercentile(times, 0.99);
+    return evaluation;
+}
+
+
+std::string getAttributes(const Candidate& candidate)
+{
+    const vector<Option>& options = getOptions();
+    std::string attributes;
+    for(unsigned int k=0; k<options.size(); k++)
+        attributes += std::string(k? " " : "") + options[k].name + "=\"" + options[k].values[candidate[k]] + "\"";
+    return attributes;
+}
+
+
+void printEvaluation(const char* label, const Candidate& candidate, const Evaluation& evaluation)
+{
+    printf("%s\tp50 %.4f\tp99 %.4f\tviolation %.3e\t%s\n", label, evaluation.p50, evaluation.p99,
+           evaluation.violation, getAttributes(candidate).c_str());
+}
+
+} // namespace
+
+
+int main(int argc, char** argv)
+{
+    TuneOptions options;
+    if(!parseOptions(argc, argv, options))
+    {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    QPProblemReader reader;
+    if(!reader.open(options.filename))
+    {
+        fprintf(stderr, "Cannot read the recording %s\n", options.filename.c_str());
+        return 2;
+    }
+
+    // The steps are read once, the evaluations only time the resolutions
+    const unsigned int nbSteps = reader.getNbSteps();
+    const unsigned int last = std::min(options.last, nbSteps? nbSteps-1 : 0u);
+    vector<QPRecordedStep> steps;
+    QPRecordedStep step;
+    for(unsigned int i=options.first; i<=last && i<nbSteps; i++)
+        if(reader.readStep(i, step))
+            steps.push_back(step);
+    if(steps.empty())
+    {
+        fprintf(stderr, "No step to replay in %s\n", options.filename.c_str());
+        return 2;
+    }
+
+    const bool isP50 = (options.metric == "p50");
+    auto getMetric = [isP50](const Evaluation& evaluation) {return isP50? evaluation.p50 : evaluation.p99;};
+    auto isFeasible = [&options](const Evaluation& evaluation) {return evaluation.violation <= options.violationBudget;};
+
+    const vector<Option>& solverOptions = getOptions();
+    Candidate best(solverOptions.size(), 0);
+    const Evaluation defaultEvaluation = evaluate(steps, best, options.repeat);
+    Evaluation bestEvaluation = defaultEvaluation;
+    if(!options.quiet)
+        printEvaluation("default", best, defaultEvaluation);
+    if(!isFeasible(defaultEvaluation))
+        fprintf(stderr, "The default options violate the budget %g (%.3e), the first options within it are kept\n",
+                options.violationBudget, defaultEvaluation.violation);
+
+    unsigned int nbEvaluations = 1;
+    for(unsigned int pass=0; pass<options.passes; pass++)
+    {
+        bool changed = false;
+        for(unsigned int k=0; k<solverOptions.size(); k++)
+            for(unsigned int v=0; v<solverOptions[k].values.size(); v++)
+            {
+                if(v == best[k])
+                    continue;
+
+                Candidate candidate = best;
+                candidate[k] = v;
+                const Evaluation evaluation = evaluate(steps, candidate, options.repeat);
+                nbEvaluations++;
+                if(!options.quiet)
+                    printEvaluation("trial", candidate, evaluation);
+
+                // A feasible candidate replaces an infeasible best, otherwise it has to be faster
+                const bool isBetter = isFeasible(evaluation)
+                        && (!isFeasible(bestEvaluation) || getMetric(evaluation) < (1. - options.minGain)*getMetric(bestEvaluation));
+                if(isBetter)
+                {
+                    best = candidate;
+                    bestEvaluation = evaluation;
+                    changed = true;
+                }
+            }
+        if(!changed)
+            break;
+    }
+
+    if(!options.quiet)
+    {
+        printf("# %lu steps, %u evaluations, metric %s, violation budget %g\n", (unsigned long)steps.size(),
+               nbEvaluations, options.metric.c_str(), options.violationBudget);
+        printf("# default: p50 %.4f ms, p99 %.4f ms; tuned: p50 %.4f ms, p99 %.4f ms, violation %.3e\n",
+               defaultEvaluation.p50, defaultEvaluation.p99, bestEvaluation.p50, bestEvaluation.p99,
+               bestEvaluation.violation);
+    }
+
+    const std::string parameters = "<QPInverseProblemSolver " + getAttributes(best) + "/>";
+    printf("%s\n", parameters.c_str());
+    if(!options.output.empty())
+    {
+        std::ofstream output(options.output);
+        output << parameters << std::endl;
+        if(!output)
+        {
+            fprintf(stderr, "Cannot write %s\n", options.output.c_str());
+            return 2;
+        }
+    }
+
+    return isFeasible(bestEvaluation)? 0 : 1;
+}